@@ -49,6 +49,7 @@
 
 #include "cmds.h"
 #include "tm.h"
+#include "pbs_idx.h"
 #include <signal.h>
 
 int *ev;
@@ -68,6 +69,21 @@ int fire_phasers = 0;
 int no_obit = 0;
 extern char *get_ecname(int rc);
 
+/*
+ * Fan-out mode (-f): one tm_spawn_multi() for every target, tm_spawn()
+ * only for the targets the local MOM could not start, and a summary of
+ * failures instead of one line per task.
+ */
+int fanout = 0;
+tm_event_t event_multi = TM_NULL_EVENT;
+tm_node_id *multi_nodes; /* target node of each task slot */
+void *spawn_idx;	 /* spawn event -> slot in events_spawn */
+void *obit_idx;		 /* obit event -> slot in events_obit */
+
+#define STATUS_BUCKETS 256
+int spawn_errs[STATUS_BUCKETS + 1]; /* failed spawns by tm_errno, last is "other" */
+int exit_errs[STATUS_BUCKETS + 1];  /* non-zero exits by status, last is "other" */
+
 /**
  * @brief
  *	signal handler function
@@ -83,6 +99,188 @@ bailout(int sig)
 	fire_phasers = sig;
 }
 
+/**
+ * @brief
+ *	find the task slot an event belongs to
+ *
+ * @param[in] idx - spawn_idx or obit_idx
+ * @param[in] base - events_spawn or events_obit
+ * @param[in] event - event returned by tm_poll
+ *
+ * @return	int
+ * @retval	slot number
+ * @retval	-1 if the event is not in idx
+ *
+ */
+static int
+event_slot(void *idx, tm_event_t *base, tm_event_t event)
+{
+	void *key = &event;
+	tm_event_t *slot;
+
+	if (pbs_idx_find(idx, &key, (void **) &slot, NULL) != PBS_IDX_RET_OK)
+		return -1;
+	pbs_idx_delete(idx, &event);
+	return (int) (slot - base);
+}
+
+/**
+ * @brief
+ *	count a failure for the fan-out summary
+ *
+ * @param[in,out] counts - spawn_errs or exit_errs
+ * @param[in] code - error or exit status
+ *
+ * @return - Void
+ *
+ */
+static void
+count_failure(int *counts, int code)
+{
+	if (code > 0 && code < STATUS_BUCKETS)
+		counts[code]++;
+	else
+		counts[STATUS_BUCKETS]++;
+}
+
+/**
+ * @brief
+ *	print the fan-out summary of failed spawns and non-zero exits
+ *
+ * @return - Void
+ *
+ */
+static void
+print_failures(void)
+{
+	int i;
+
+	for (i = 0; i <= STATUS_BUCKETS; i++) {
+		if (spawn_errs[i] == 0)
+			continue;
+		if (i < STATUS_BUCKETS)
+			fprintf(stderr, "%s: %d tasks failed to spawn, error %d\n",
+				id, spawn_errs[i], i);
+		else
+			fprintf(stderr, "%s: %d tasks failed to spawn, other errors\n",
+				id, spawn_errs[i]);
+	}
+	for (i = 0; i <= STATUS_BUCKETS; i++) {
+		if (exit_errs[i] == 0)
+			continue;
+		if (i < STATUS_BUCKETS)
+			printf("%s: %d tasks exit status %d\n", id, exit_errs[i], i);
+		else
+			printf("%s: %d tasks exit status out of range\n",
+			       id, exit_errs[i]);
+	}
+}
+
+/**
+ * @brief
+ *	spawn a task on one node and record its spawn event
+ *
+ * @param[in] argc - program argument count
+ * @param[in] argv - program arguments
+ * @param[in] c - task slot
+ * @param[in] nd - logical node index
+ * @param[in] node - node id
+ *
+ * @return	int
+ * @retval	1 - spawn request sent
+ * @retval	0 - spawn failed
+ *
+ */
+static int
+spawn_one(int argc, char **argv, int c, int nd, tm_node_id node)
+{
+	int rc;
+
+	if ((rc = tm_spawn(argc, argv, NULL, node, tid + c,
+			   events_spawn + c)) != TM_SUCCESS) {
+		fprintf(stderr, "%s: spawn failed on node %d err %s\n",
+			id, nd, get_ecname(rc));
+		return 0;
+	}
+	if (verbose)
+		printf("%s: spawned task 0x%08X on logical node %d event %d\n", id, c, nd, *(events_spawn + c));
+	pbs_idx_insert(spawn_idx, events_spawn + c, events_spawn + c);
+	return 1;
+}
+
+/**
+ * @brief
+ *	register for the obit of a task whose spawn was acknowledged
+ *
+ * @param[in] c - task slot
+ * @param[in,out] nobits - number of obits waited for
+ *
+ * @return - Void
+ *
+ */
+static void
+register_obit(int c, int *nobits)
+{
+	int rc;
+
+	rc = tm_obit(*(tid + c), ev + c, events_obit + c);
+	if (rc == TM_SUCCESS) {
+		if (*(events_obit + c) == TM_NULL_EVENT) {
+			if (verbose) {
+				fprintf(stderr, "task already dead\n");
+			}
+		} else if (*(events_obit + c) == TM_ERROR_EVENT) {
+			if (verbose) {
+				fprintf(stderr, "Error on Obit return\n");
+			}
+		} else {
+			pbs_idx_insert(obit_idx, events_obit + c, events_obit + c);
+			(*nobits)++;
+		}
+	} else if (verbose) {
+		fprintf(stderr, "%s: failed to register for task termination notice, task 0x%08X\n", id, c);
+	}
+}
+
+/**
+ * @brief
+ *	the tm_spawn_multi() of fan-out mode returned; register obits for
+ *	the tasks the local MOM started and spawn the rest one by one
+ *
+ * @param[in] argc - program argument count
+ * @param[in] argv - program arguments
+ * @param[in] start - logical node index of slot 0
+ * @param[in] ntasks - number of task slots
+ * @param[in] tm_errno - error of the multi spawn
+ * @param[in,out] nspawned - outstanding spawn replies
+ * @param[in,out] nobits - number of obits waited for
+ *
+ * @return - Void
+ *
+ */
+static void
+multi_spawned(int argc, char **argv, int start, int ntasks, int tm_errno,
+	      int *nspawned, int *nobits)
+{
+	int c;
+	int nlocal = 0;
+
+	for (c = 0; c < ntasks; c++) {
+		if (tm_errno == 0 && *(tid + c) != TM_NULL_TASK) {
+			nlocal++;
+			if (!no_obit)
+				register_obit(c, nobits);
+			continue;
+		}
+		*(tid + c) = TM_NULL_TASK;
+		*nspawned += spawn_one(argc, argv, c,
+				       (start + c) % numnodes, *(multi_nodes + c));
+	}
+	if (verbose)
+		printf("%s: %d tasks started by local MOM, %d spawned separately\n",
+		       id, nlocal, ntasks - nlocal);
+}
+
 /**
  * @brief
  *	wait_for_task - wait for all spawned tasks to
@@ -90,22 +288,25 @@ bailout(int sig)
  *	b. the task to terminate and return the obit with the exit status
  *
  * @param[in] first - first event index to consider
- * @param[in] nspawned - number of tasks spawned
+ * @param[in] nevents - number of task slots from first
+ * @param[in] nspawned - number of spawn replies outstanding
+ * @param[in] argc - program argument count, for fan-out fallback spawns
+ * @param[in] argv - program arguments, for fan-out fallback spawns
+ * @param[in] start - logical node index of slot 0
  *
  * @return - Void
  *
  */
 void
-wait_for_task(int first, int *nspawned)
+wait_for_task(int first, int nevents, int *nspawned, int argc, char **argv,
+	      int start)
 {
 	int c;
 	tm_event_t eventpolled;
-	int nevents;
 	int nobits = 0;
 	int rc;
 	int tm_errno;
 
-	nevents = *nspawned;
 	while (*nspawned || nobits) {
 		if (verbose) {
 			printf("pbsdsh: waiting on %d spawned and %d obits\n",
@@ -140,43 +341,35 @@ wait_for_task(int first, int *nspawned)
 			exit(2);
 		}
 
-		for (c = first; c < (first + nevents); ++c) {
-			if (eventpolled == *(events_spawn + c)) {
-				/* spawn event returned - register obit */
-				(*nspawned)--;
-				if (tm_errno) {
+		if (eventpolled == event_multi) {
+			/* fan-out spawn returned */
+			(*nspawned)--;
+			event_multi = TM_NULL_EVENT;
+			multi_spawned(argc, argv, start, nevents, tm_errno,
+				      nspawned, &nobits);
+		} else if ((c = event_slot(spawn_idx, events_spawn, eventpolled)) != -1) {
+			/* spawn event returned - register obit */
+			(*nspawned)--;
+			if (tm_errno) {
+				if (fanout)
+					count_failure(spawn_errs, tm_errno);
+				if (!fanout || verbose)
 					fprintf(stderr, "error %d on spawn\n",
 						tm_errno);
-					continue;
-				}
-				if (no_obit)
-					continue;
-
-				rc = tm_obit(*(tid + c), ev + c, events_obit + c);
-				if (rc == TM_SUCCESS) {
-					if (*(events_obit + c) == TM_NULL_EVENT) {
-						if (verbose) {
-							fprintf(stderr, "task already dead\n");
-						}
-					} else if (*(events_obit + c) == TM_ERROR_EVENT) {
-						if (verbose) {
-							fprintf(stderr, "Error on Obit return\n");
-						}
-					} else {
-						nobits++;
-					}
-				} else if (verbose) {
-					fprintf(stderr, "%s: failed to register for task termination notice, task 0x%08X\n", id, c);
-				}
-
-			} else if (eventpolled == *(events_obit + c)) {
-				/* obit event, task exited */
-				nobits--;
-				*(tid + c) = TM_NULL_TASK;
-				if (verbose || *(ev + c) != 0) {
-					printf("%s: task 0x%08X exit status %d\n",
-					       id, c, *(ev + c));
-				}
+				continue;
+			}
+			if (no_obit)
+				continue;
+			register_obit(c, &nobits);
+		} else if ((c = event_slot(obit_idx, events_obit, eventpolled)) != -1) {
+			/* obit event, task exited */
+			nobits--;
+			*(tid + c) = TM_NULL_TASK;
+			if (fanout && *(ev + c) != 0)
+				count_failure(exit_errs, *(ev + c));
+			if (verbose || (!fanout && *(ev + c) != 0)) {
+				printf("%s: task 0x%08X exit status %d\n",
+				       id, c, *(ev + c));
 			}
 		}
 	}
@@ -212,7 +405,7 @@ main(int argc, char *argv[], char *envp[])
 	if (initsocketlib())
 		return 1;
 
-	while ((c = getopt(argc, argv, "c:n:svo")) != EOF) {
+	while ((c = getopt(argc, argv, "c:n:fsvo")) != EOF) {
 		switch (c) {
 			case 'c':
 				ncopies = atoi(optarg);
@@ -235,16 +428,20 @@ main(int argc, char *argv[], char *envp[])
 			case 'o':
 				no_obit = 1;
 				break;
+			case 'f':
+				fanout = 1; /* batched spawn, summarized output */
+				break;
 			default:
 				err = 1;
 				break;
 		}
 	}
-	if (err || (onenode >= 0 && ncopies >= 0) || (argc == optind)) {
-		fprintf(stderr, "Usage: %s [-c copies][-s][-v][-o]"
+	if (err || (onenode >= 0 && ncopies >= 0) || (fanout && sync) ||
+	    (argc == optind)) {
+		fprintf(stderr, "Usage: %s [-c copies][-f|-s][-v][-o]"
 				" -- program [args...]\n",
 			argv[0]);
-		fprintf(stderr, "       %s [-n node_index][-s][-v][-o]"
+		fprintf(stderr, "       %s [-n node_index][-f|-s][-v][-o]"
 				" -- program [args...]\n",
 			argv[0]);
 		fprintf(stderr, "       %s --version\n", argv[0]);
@@ -253,6 +450,8 @@ main(int argc, char *argv[], char *envp[])
 		fprintf(stderr, "      -n node_index = run a copy "
 				"of \"program\" on the \"node_index\"-th node,\n");
 
+		fprintf(stderr, "      -f = spawn all tasks with one request "
+				"and summarize failures,\n");
 		fprintf(stderr, "      -s = forces synchronous execution,\n");
 		fprintf(stderr, "      -v = forces verbose output.\n");
 		fprintf(stderr, "      -o = no obits are waited for.\n");
@@ -337,6 +536,12 @@ main(int argc, char *argv[], char *envp[])
 		fprintf(stderr, "%s: out of memory\n", id);
 		return 1;
 	}
+	spawn_idx = pbs_idx_create(0, sizeof(tm_event_t));
+	obit_idx = pbs_idx_create(0, sizeof(tm_event_t));
+	if (spawn_idx == NULL || obit_idx == NULL) {
+		fprintf(stderr, "%s: out of memory\n", id);
+		return 1;
+	}
 	for (c = 0; c < max_events; c++) {
 		*(tid + c) = TM_NULL_TASK;
 		*(events_spawn + c) = TM_NULL_EVENT;
@@ -369,27 +574,51 @@ main(int argc, char *argv[], char *envp[])
 	sigprocmask(SIG_BLOCK, &allsigs, NULL);
 #endif
 
-	for (c = 0; c < (stop - start); ++c) {
-		nd = (start + c) % numnodes;
-		if ((rc = tm_spawn(argc - optind,
-				   argv + optind,
-				   NULL,
-				   *(nodelist + nd),
-				   tid + c,
-				   events_spawn + c)) != TM_SUCCESS) {
-			fprintf(stderr, "%s: spawn failed on node %d err %s\n",
-				id, nd, get_ecname(rc));
+	if (fanout && (stop - start) > 0) {
+		/*
+		 * Hand every target to the local MOM in one request; the
+		 * ones on other hosts come back as TM_NULL_TASK and are
+		 * spawned one by one when the reply arrives.
+		 */
+		multi_nodes = (tm_node_id *) calloc(stop - start, sizeof(tm_node_id));
+		if (multi_nodes == NULL) {
+			fprintf(stderr, "%s: out of memory\n", id);
+			return 1;
+		}
+		for (c = 0; c < (stop - start); ++c)
+			*(multi_nodes + c) = *(nodelist + ((start + c) % numnodes));
+		if ((rc = tm_spawn_multi(argc - optind, argv + optind, NULL,
+					 stop - start, multi_nodes, tid,
+					 &event_multi)) == TM_SUCCESS) {
+			nspawned = 1;
 		} else {
 			if (verbose)
-				printf("%s: spawned task 0x%08X on logical node %d event %d\n", id, c, nd, *(events_spawn + c));
-			++nspawned;
-			if (sync)
-				wait_for_task(c, &nspawned); /* one at a time */
+				printf("%s: tm_spawn_multi failed, err %s\n",
+				       id, get_ecname(rc));
+			event_multi = TM_NULL_EVENT;
+			for (c = 0; c < (stop - start); ++c)
+				*(tid + c) = TM_NULL_TASK;
+		}
+	}
+	if (event_multi == TM_NULL_EVENT) {
+		for (c = 0; c < (stop - start); ++c) {
+			nd = (start + c) % numnodes;
+			if (spawn_one(argc - optind, argv + optind, c, nd,
+				      *(nodelist + nd))) {
+				++nspawned;
+				if (sync) /* one at a time */
+					wait_for_task(c, 1, &nspawned,
+						      argc - optind, argv + optind,
+						      start);
+			}
 		}
 	}
 
-	if (sync == 0)
-		wait_for_task(0, &nspawned); /* wait for all to finish */
+	if (sync == 0) /* wait for all to finish */
+		wait_for_task(0, stop - start, &nspawned, argc - optind,
+			      argv + optind, start);
+	if (fanout)
+		print_failures();
 #ifdef WIN32
 	/*
 	 * On Windows, in case of interactive jobs - pbs_demux is writing on stdout and stderr
@@ -145,7 +145,62 @@ static char *output_format_names[] = {"default", "dsv", "json", NULL};
 static int output_format = FORMAT_DEFAULT;
 static int quiet = 0;
 static char *dsv_delim = "|";
-static json_data *json_nodes = NULL; /* json structure for nodes */
+static pbs_json_writer json_out; /* json output, written as it is produced */
+
+/* attributes needed to tell whether a vnode is marked (-d, -l) */
+static struct attrl mark_attribs[] = {
+	{&mark_attribs[1],
+	 ATTR_NODE_state,
+	 NULL,
+	 "",
+	 SET},
+	{NULL,
+	 ATTR_comment,
+	 NULL,
+	 "",
+	 SET}};
+
+/* attributes read by prt_node_summary(), in the order the server keeps them */
+static struct attrl summary_attribs[] = {
+	{&summary_attribs[1],
+	 ATTR_NODE_state,
+	 NULL,
+	 "",
+	 SET},
+	{&summary_attribs[2],
+	 ATTR_NODE_jobs,
+	 NULL,
+	 "",
+	 SET},
+	{&summary_attribs[3],
+	 ATTR_rescavail,
+	 NULL,
+	 "",
+	 SET},
+	{&summary_attribs[4],
+	 ATTR_rescassn,
+	 NULL,
+	 "",
+	 SET},
+	{&summary_attribs[5],
+	 ATTR_queue,
+	 NULL,
+	 "",
+	 SET},
+	{NULL,
+	 ATTR_comment,
+	 NULL,
+	 "",
+	 SET}};
+
+/* state of a streamed listing of all vnodes (-av) */
+struct vnode_stream {
+	char *vs_server; /* server name for the summary and the json prologue */
+	int vs_prt_summary;
+	int vs_job_summary;
+	int vs_long_summary;
+	int vs_count; /* vnodes printed so far */
+};
 
 /**
  * @brief
@@ -200,19 +255,15 @@ encode_to_json(struct batch_status *bstat)
 	char *pc;
 	char *pc1;
 	char *prev_jobid = "";
-	json_data *json_node;
 
-	if ((json_node = pbs_json_create_object()) == NULL)
+	if (pbs_json_write_begin_object(&json_out, bstat->name))
 		return 1;
-	pbs_json_insert_item(json_nodes, bstat->name, json_node);
 	for (pattr = bstat->attribs; pattr; pattr = pattr->next) {
 		if (strcmp(pattr->name, "resources_available") == 0) {
-			json_data *json_resc;
-			if ((json_resc = pbs_json_create_object()) == NULL)
+			if (pbs_json_write_begin_object(&json_out, pattr->name))
 				return 1;
-			pbs_json_insert_item(json_node, pattr->name, json_resc);
 			for (next = pattr; next;) {
-				if (pbs_json_insert_parsed(json_resc, next->resource, next->value, 0))
+				if (pbs_json_write_parsed(&json_out, next->resource, next->value, 0))
 					return 1;
 				if (next->next == NULL || strcmp(next->next->name, "resources_available")) {
 					pattr = next;
@@ -221,11 +272,11 @@ encode_to_json(struct batch_status *bstat)
 					next = next->next;
 				}
 			}
+			if (pbs_json_write_end(&json_out))
+				return 1;
 		} else if (strcmp(pattr->name, "resources_assigned") == 0) {
-			json_data *json_resc;
-			if ((json_resc = pbs_json_create_object()) == NULL)
+			if (pbs_json_write_begin_object(&json_out, pattr->name))
 				return 1;
-			pbs_json_insert_item(json_node, pattr->name, json_resc);
 			for (next = pattr; next;) {
 				str = next->value;
 				strtod(str, &pc);
@@ -236,7 +287,7 @@ encode_to_json(struct batch_status *bstat)
 						break;
 				}
 				/* Adding only non zero values.*/
-				if (pbs_json_insert_parsed(json_resc, next->resource, next->value, 1))
+				if (pbs_json_write_parsed(&json_out, next->resource, next->value, 1))
 					return 1;
 				if (next->next == NULL || strcmp(next->next->name, "resources_assigned")) {
 					pattr = next;
@@ -245,11 +296,11 @@ encode_to_json(struct batch_status *bstat)
 					next = next->next;
 				}
 			}
+			if (pbs_json_write_end(&json_out))
+				return 1;
 		} else if (strcmp(pattr->name, "jobs") == 0) {
-			json_data *json_jobs;
-			if ((json_jobs = pbs_json_create_array()) == NULL)
+			if (pbs_json_write_begin_array(&json_out, pattr->name))
 				return 1;
-			pbs_json_insert_item(json_node, pattr->name, json_jobs);
 			pc = pc1 = str = pattr->value;
 			while (*pc1) {
 				if (*pc1 != ' ')
@@ -262,17 +313,19 @@ encode_to_json(struct batch_status *bstat)
 				if (pc1)
 					*pc1 = '\0';
 				if (strcmp(pc, prev_jobid) != 0) {
-					if (pbs_json_insert_string(json_jobs, NULL, pc))
+					if (pbs_json_write_string(&json_out, NULL, pc))
 						return 1;
 				}
 				prev_jobid = pc;
 			}
+			if (pbs_json_write_end(&json_out))
+				return 1;
 		} else {
-			if(pbs_json_insert_parsed(json_node, pattr->name, pattr->value, 0))
+			if (pbs_json_write_parsed(&json_out, pattr->name, pattr->value, 0))
 				return 1;
 		}
 	}
-	return 0;
+	return pbs_json_write_end(&json_out);
 }
 
 /**
@@ -311,8 +364,6 @@ prt_node_summary(char *def_server, struct batch_status *bstatus, int job_summary
 	long int susp_jobs = 0;
 	long int value = 0;
 	static int done_headers = 0;
-	json_data *json_node;
-	json_data *json_jobs;
 
 	if (output_format == FORMAT_DEFAULT && !done_headers) {
 		if (job_summary) {
@@ -554,60 +605,62 @@ prt_node_summary(char *def_server, struct batch_status *bstatus, int job_summary
 				break;
 
 			case FORMAT_JSON:
-				if ((json_node = pbs_json_create_object()) == NULL)
+				if (pbs_json_write_begin_object(&json_out, name))
 					return 1;
-				pbs_json_insert_item(json_nodes, name, json_node);
-				if (pbs_json_insert_string(json_node, "State", state))
+				if (pbs_json_write_string(&json_out, "State", state))
 					return 1;
 				if (job_summary) {
-					if (pbs_json_insert_number(json_node, "Total Jobs", (double) njobs))
+					if (pbs_json_write_number(&json_out, "Total Jobs", (double) njobs))
 						return 1;
-					if (pbs_json_insert_number(json_node, "Running Jobs", (double) run_jobs))
+					if (pbs_json_write_number(&json_out, "Running Jobs", (double) run_jobs))
 						return 1;
-					if (pbs_json_insert_number(json_node, "Suspended Jobs", (double) susp_jobs))
+					if (pbs_json_write_number(&json_out, "Suspended Jobs", (double) susp_jobs))
 						return 1;
-					if (pbs_json_insert_string(json_node, "mem f/t", mem_info))
+					if (pbs_json_write_string(&json_out, "mem f/t", mem_info))
 						return 1;
-					if (pbs_json_insert_string(json_node, "ncpus f/t", ncpus_info))
+					if (pbs_json_write_string(&json_out, "ncpus f/t", ncpus_info))
 						return 1;
-					if (pbs_json_insert_string(json_node, "nmics f/t", nmic_info))
+					if (pbs_json_write_string(&json_out, "nmics f/t", nmic_info))
 						return 1;
-					if (pbs_json_insert_string(json_node, "ngpus f/t", ngpus_info))
+					if (pbs_json_write_string(&json_out, "ngpus f/t", ngpus_info))
 						return 1;
-					if ((json_jobs = pbs_json_create_array()) == NULL)
+					if (pbs_json_write_begin_array(&json_out, "jobs"))
 						return 1;
-					pbs_json_insert_item(json_node, "jobs", json_jobs);
 					if (strcmp(jobs, "--") != 0) {
 						pc = strtok(jobs, ",");
 						while (pc != NULL) {
-							if (pbs_json_insert_string(json_jobs, NULL, pc))
+							if (pbs_json_write_string(&json_out, NULL, pc))
 								return 1;
 							pc = strtok(NULL, ",");
 						}
 					}
+					if (pbs_json_write_end(&json_out))
+						return 1;
 				} else {
-					if (pbs_json_insert_string(json_node, "OS", os))
+					if (pbs_json_write_string(&json_out, "OS", os))
 						return 1;
-					if (pbs_json_insert_string(json_node, "hardware", hardware))
+					if (pbs_json_write_string(&json_out, "hardware", hardware))
 						return 1;
-					if (pbs_json_insert_string(json_node, "host", host))
+					if (pbs_json_write_string(&json_out, "host", host))
 						return 1;
-					if (pbs_json_insert_string(json_node, "queue", queue))
+					if (pbs_json_write_string(&json_out, "queue", queue))
 						return 1;
-					if (pbs_json_insert_string(json_node, "Memory", mem_info))
+					if (pbs_json_write_string(&json_out, "Memory", mem_info))
 						return 1;
 					value = atol(ncpus_info);
-					if (pbs_json_insert_number(json_node, "ncpus", (double) value))
+					if (pbs_json_write_number(&json_out, "ncpus", (double) value))
 						return 1;
 					value = atol(nmic_info);
-					if (pbs_json_insert_number(json_node, "nmics", (double) value))
+					if (pbs_json_write_number(&json_out, "nmics", (double) value))
 						return 1;
 					value = atol(ngpus_info);
-					if (pbs_json_insert_number(json_node, "ngpus", (double) value))
+					if (pbs_json_write_number(&json_out, "ngpus", (double) value))
 						return 1;
-					if (pbs_json_insert_string(json_node, "comment", comment))
+					if (pbs_json_write_string(&json_out, "comment", comment))
 						return 1;
 				}
+				if (pbs_json_write_end(&json_out))
+					return 1;
 				break;
 			case FORMAT_DEFAULT:
 				if (job_summary) {
@@ -873,6 +926,98 @@ marknode(int con, char *name,
 	return (rc);
 }
 
+/**
+ * @brief
+ *	print the opening of the json document, up to the object holding
+ *	the nodes, which are then written into json_out one by one
+ *
+ * @param[in] def_server - server name
+ *
+ * @retval Void
+ *
+ */
+static void
+prt_json_prologue(char *def_server)
+{
+	pbs_json_writer_init(&json_out, stdout);
+	if (pbs_json_write_begin_object(&json_out, NULL) ||
+	    pbs_json_write_number(&json_out, "timestamp", (double) time(0)) ||
+	    pbs_json_write_string(&json_out, "pbs_version", PBS_VERSION) ||
+	    pbs_json_write_string(&json_out, "pbs_server", def_server) ||
+	    pbs_json_write_begin_object(&json_out, "nodes")) {
+		fprintf(stderr, "pbsnodes: json error\n");
+		exit(1);
+	}
+}
+
+/**
+ * @brief
+ *	close the object holding the nodes and the json document
+ *
+ * @retval Void
+ *
+ */
+static void
+prt_json_epilogue(void)
+{
+	while (json_out.jw_depth > 0) {
+		if (pbs_json_write_end(&json_out)) {
+			fprintf(stderr, "json error\n");
+			break;
+		}
+	}
+}
+
+/**
+ * @brief
+ *	print the status of a node that could not be queried as a json entry
+ *
+ * @param[in] name - node name
+ * @param[in] errmsg - error message
+ *
+ * @retval Void
+ *
+ */
+static void
+prt_json_error(char *name, char *errmsg)
+{
+	if (pbs_json_write_begin_object(&json_out, name) ||
+	    pbs_json_write_string(&json_out, name, errmsg) ||
+	    pbs_json_write_end(&json_out)) {
+		fprintf(stderr, "pbsnodes: json error\n");
+		exit(1);
+	}
+}
+
+/**
+ * @brief
+ *	pbs_statvnode_stream() callback: print one vnode as soon as it is
+ *	decoded; in json format only that vnode's object is built and written
+ *
+ * @param[in] bstat - status of the vnode, freed here
+ * @param[in] arg - the struct vnode_stream of the listing
+ *
+ * @retval Void
+ *
+ */
+static void
+prt_stream_vnode(struct batch_status *bstat, void *arg)
+{
+	struct vnode_stream *vs = arg;
+
+	if (output_format == FORMAT_JSON && vs->vs_count == 0)
+		prt_json_prologue(vs->vs_server);
+	if (vs->vs_prt_summary) {
+		if (prt_node_summary(vs->vs_server, bstat, vs->vs_job_summary, vs->vs_long_summary)) {
+			fprintf(stderr, "pbsnodes: out of memory\n");
+			exit(1);
+		}
+	} else
+		prt_node(bstat);
+	vs->vs_count++;
+	pbs_statfree(bstat);
+}
+
 /**
  * @brief
  *	The main function in C - entry point
@@ -887,7 +1032,6 @@ marknode(int con, char *name,
 int
 main(int argc, char *argv[])
 {
-	time_t timenow;
 	struct attrl *pattr = NULL;
 	int con;
 	char *def_server = NULL;
@@ -909,7 +1053,9 @@ main(int argc, char *argv[])
 	int long_summary = 0;
 	int format = 0;
 	int prt_summary = 0;
-	json_data *json_root = NULL; /* root of json structure */
+	struct attrl *rattrs = NULL;
+	char *filter = NULL;
+	struct vnode_stream vstream;
 
 	/*test for real deal or just version and exit*/
 
@@ -1084,16 +1230,25 @@ main(int argc, char *argv[])
 	}
 
 	/* if do_vnodes is set, get status of all virtual nodes (vnodes) */
-	/* else if oper is ALL then get status of all hosts              */
+	/* else if oper is ALL then get status of all hosts; -av streams */
+	/* the vnodes below instead of holding all of them               */
 
-	if ((do_vnodes == 1) || (oper == ALL) ||
+	if (((oper == ALL) && !do_vnodes) ||
 	    (oper == DOWN) || (oper == LISTMRK) || (oper == LISTSPNV)) {
-		if (do_vnodes || oper == LISTSPNV)
-			bstat_head = pbs_statvnode(con, "", NULL, NULL);
-		else
+		if (do_vnodes || oper == LISTSPNV) {
+			/* hosts are built from all vnode attributes, vnodes need less */
+			if (oper == DOWN || oper == LISTMRK)
+				rattrs = mark_attribs;
+			else if (prt_summary)
+				rattrs = summary_attribs;
+			/* let the server pick the marked vnodes */
+			if (oper == LISTMRK)
+				filter = NODE_FILTER_STATE ND_down "," ND_offline;
+			bstat_head = pbs_statvnode(con, "", rattrs, filter);
+		} else
 			bstat_head = pbs_stathost(con, "", NULL, NULL);
 
-		if (bstat_head == NULL) {
+		if (bstat_head == NULL && !(filter != NULL && pbs_errno == PBSE_NONE)) {
 			if (pbs_errno) {
 				if (!quiet) {
 					if ((errmsg = pbs_geterrmsg(con)) != NULL)
@@ -1109,31 +1264,11 @@ main(int argc, char *argv[])
 			}
 		}
 	}
-	/* adding prologue to json output. */
-	if (output_format == FORMAT_JSON) {
-		timenow = time(0);
-		if ((json_root = pbs_json_create_object()) == NULL) {
-			fprintf(stderr, "pbsnodes: json error\n");
-			exit(1);
-		}
-		if (pbs_json_insert_number(json_root, "timestamp", (double) timenow)) {
-			fprintf(stderr, "pbsnodes: json error\n");
-			exit(1);
-		}
-		if (pbs_json_insert_string(json_root, "pbs_version", PBS_VERSION)) {
-			fprintf(stderr, "pbsnodes: json error\n");
-			exit(1);
-		}
-		if (pbs_json_insert_string(json_root, "pbs_server", def_server)) {
-			fprintf(stderr, "pbsnodes: json error\n");
-			exit(1);
-		}
-		if ((json_nodes = pbs_json_create_object()) == NULL) {
-			fprintf(stderr, "pbsnodes: json error\n");
-			exit(1);
-		}
-		pbs_json_insert_item(json_root, "nodes", json_nodes);
-	}
+	/* adding prologue to json output, a streamed listing writes its own */
+	/* the -av listing opens the document when its first vnode arrives */
+	if (output_format == FORMAT_JSON &&
+	    ((oper == ALL && !do_vnodes) || oper == LISTSP || oper == LISTSPNV))
+		prt_json_prologue(def_server);
 	switch (oper) {
 
 		case DOWN:
@@ -1218,6 +1353,31 @@ main(int argc, char *argv[])
 
 		case ALL:
 
+			if (do_vnodes) {
+				vstream.vs_server = def_server;
+				vstream.vs_prt_summary = prt_summary;
+				vstream.vs_job_summary = job_summary;
+				vstream.vs_long_summary = long_summary;
+				vstream.vs_count = 0;
+				if (pbs_statvnode_stream(con, "", prt_summary ? summary_attribs : NULL, NULL,
+							 prt_stream_vnode, &vstream)) {
+					if (!quiet) {
+						if ((errmsg = pbs_geterrmsg(con)) != NULL)
+							fprintf(stderr, "%s: %s\n", argv[0], errmsg);
+						else
+							fprintf(stderr, "%s: Error %d\n", argv[0], pbs_errno);
+					}
+					exit(1);
+				}
+				if (vstream.vs_count == 0) {
+					if (!quiet)
+						fprintf(stderr, "%s: No nodes found\n", argv[0]);
+					exit(0);
+				}
+				if (output_format == FORMAT_JSON)
+					prt_json_epilogue();
+				break;
+			}
 			if (prt_summary) {
 				if (prt_node_summary(def_server, bstat_head, job_summary, long_summary)) {
 					fprintf(stderr, "pbsnodes: out of memory\n");
@@ -1227,11 +1387,8 @@ main(int argc, char *argv[])
 				for (bstat = bstat_head; bstat; bstat = bstat->next)
 					prt_node(bstat);
 			}
-			if (output_format == FORMAT_JSON) {
-				if (pbs_json_print(json_root, stdout))
-					fprintf(stderr, "json error\n");
-				pbs_json_delete(json_root);
-			}
+			if (output_format == FORMAT_JSON)
+				prt_json_epilogue();
 			pbs_statfree(bstat_head);
 
 			break;
@@ -1260,18 +1417,9 @@ main(int argc, char *argv[])
 				if (!bstat) {
 					if (pbs_errno != 0) {
 
-						if (output_format == FORMAT_JSON) {
-							json_data *json_error;
-							if ((json_error = pbs_json_create_object()) == NULL) {
-								fprintf(stderr, "pbsnodes: json error\n");
-								exit(1);
-							}
-							pbs_json_insert_item(json_nodes, *pa, json_error);
-							if (pbs_json_insert_string(json_error, *pa, pbs_geterrmsg(con))) {
-								fprintf(stderr, "pbsnodes: json error\n");
-								exit(1);
-							}
-						} else {
+						if (output_format == FORMAT_JSON)
+							prt_json_error(*pa, pbs_geterrmsg(con));
+						else {
 							fprintf(stderr, "Node: %s,  Error: %s\n", *pa, pbs_geterrmsg(con));
 							rc = 1;
 						}
@@ -1288,11 +1436,8 @@ main(int argc, char *argv[])
 					pbs_statfree(bstat);
 				}
 			}
-			if (output_format == FORMAT_JSON) {
-				if (pbs_json_print(json_root, stdout))
-					fprintf(stderr, "json error\n");
-				pbs_json_delete(json_root);
-			}
+			if (output_format == FORMAT_JSON)
+				prt_json_epilogue();
 			if (do_vnodes) {
 				pbs_statfree(bstat_head);
 			}
@@ -1346,18 +1491,9 @@ main(int argc, char *argv[])
 				bstat = pbs_stathost(con, *pa, NULL, NULL);
 				if (!bstat) {
 					if (pbs_errno != 0) {
-						if (output_format == FORMAT_JSON) {
-							json_data *json_error;
-							if ((json_error = pbs_json_create_object()) == NULL) {
-								fprintf(stderr, "pbsnodes: json error\n");
-								exit(1);
-							}
-							pbs_json_insert_item(json_nodes, *pa, json_error);
-							if (pbs_json_insert_string(json_error, *pa, pbs_geterrmsg(con))) {
-								fprintf(stderr, "pbsnodes: json error\n");
-								exit(1);
-							}
-						} else {
+						if (output_format == FORMAT_JSON)
+							prt_json_error(*pa, pbs_geterrmsg(con));
+						else {
 							fprintf(stderr, "Node: %s,  Error: %s\n", *pa, pbs_geterrmsg(con));
 							rc = 1;
 						}
@@ -1366,11 +1502,8 @@ main(int argc, char *argv[])
 				}
 				pa++;
 			}
-			if (output_format == FORMAT_JSON) {
-				if (pbs_json_print(json_root, stdout))
-					fprintf(stderr, "json error\n");
-				pbs_json_delete(json_root);
-			}
+			if (output_format == FORMAT_JSON)
+				prt_json_epilogue();
 			pbs_statfree(bstat_head);
 			break;
 	}
@@ -60,6 +60,15 @@
 #include <pbs_version.h>
 #include "portability.h"
 
+/*
+ * Jobs of the same server after the first are altered with one modify job
+ * list request per ALTER_BATCH_SIZE jobs instead of one request each.
+ */
+#define ALTER_BATCH_SIZE 1000
+
+static int any_failed = 0;
+static struct attrl *attrib = NULL;
+
 /**
  * @brief
  * 	prints usage format for qalter command
@@ -165,15 +174,132 @@ handle_attribute_errors(int connect,
 	}
 }
 
+/**
+ * @brief
+ * 	alter one job with its own request, following it to the server
+ * 	it moved to if its server does not know it
+ *
+ * @param[in] job_id_out - job id as returned by get_server()
+ * @param[in] server - server of the job
+ *
+ * @return - Void
+ *
+ */
+static void
+alter_one(char *job_id_out, char *server)
+{
+	int connect;
+	int stat = 0;
+	int located = FALSE;
+	char server_out[MAXSERVERNAME];
+	char rmt_server[MAXSERVERNAME];
+	struct ecl_attribute_errors *err_list;
+
+	pbs_strncpy(server_out, server, sizeof(server_out));
+cnt:
+	connect = cnt2server(server_out);
+	if (connect <= 0) {
+		fprintf(stderr, "qalter: cannot connect to server %s (errno=%d)\n",
+			pbs_server, pbs_errno);
+		any_failed = pbs_errno;
+		return;
+	}
+
+	stat = pbs_alterjob(connect, job_id_out, attrib, NULL);
+	if (stat && (pbs_errno != PBSE_UNKJOBID)) {
+		if ((err_list = pbs_get_attributes_in_error(connect)))
+			handle_attribute_errors(connect, err_list, job_id_out);
+
+		prt_job_err("qalter", connect, job_id_out);
+		any_failed = pbs_errno;
+	} else if (stat && (pbs_errno == PBSE_UNKJOBID) && !located) {
+		located = TRUE;
+		if (locate_job(job_id_out, server_out, rmt_server)) {
+			pbs_disconnect(connect);
+			strcpy(server_out, rmt_server);
+			goto cnt;
+		}
+		prt_job_err("qalter", connect, job_id_out);
+		any_failed = pbs_errno;
+	}
+
+	pbs_disconnect(connect);
+}
+
+/**
+ * @brief
+ * 	alter a run of jobs of the same server
+ *
+ * @par
+ * 	The first job goes alone through alter_one(), so that a bad attribute
+ * 	is reported and ends qalter as before.  The others are sent in one
+ * 	modify job list request.  A job that fails in the list is retried
+ * 	through alter_one(), which finds where a job the server does not know
+ * 	went and reports any other failure with the server's own error text,
+ * 	as for a single job.  If the server cannot take the list at all every
+ * 	job is altered on its own.
+ *
+ * @param[in] server - server of the jobs
+ * @param[in] jobids - job ids as returned by get_server()
+ * @param[in] njobs - number of jobs
+ *
+ * @return - Void
+ *
+ */
+static void
+alter_batch(char *server, char **jobids, int njobs)
+{
+	int connect;
+	int i;
+	struct attrl **attribs;
+	struct batch_deljob_status *failed;
+	struct batch_deljob_status *p;
+
+	alter_one(jobids[0], server);
+	if (--njobs == 0)
+		return;
+	jobids++;
+
+	attribs = (struct attrl **) malloc(njobs * sizeof(struct attrl *));
+	if (attribs == NULL) {
+		for (i = 0; i < njobs; i++)
+			alter_one(jobids[i], server);
+		return;
+	}
+	for (i = 0; i < njobs; i++)
+		attribs[i] = attrib;
+
+	connect = cnt2server(server);
+	if (connect <= 0) {
+		fprintf(stderr, "qalter: cannot connect to server %s (errno=%d)\n",
+			pbs_server, pbs_errno);
+		any_failed = pbs_errno;
+		free(attribs);
+		return;
+	}
+	failed = pbs_alterjoblist(connect, jobids, attribs, njobs, NULL);
+	free(attribs);
+	if (failed == NULL && pbs_errno != PBSE_NONE) {
+		/* e.g. an older server, which does not know the list request */
+		pbs_disconnect(connect);
+		for (i = 0; i < njobs; i++)
+			alter_one(jobids[i], server);
+		return;
+	}
+	pbs_disconnect(connect);
+
+	for (p = failed; p != NULL; p = p->next)
+		alter_one(p->name, server);
+	pbs_delstatfree(failed);
+}
+
 int
 main(int argc, char **argv, char **envp) /* qalter */
 {
 	int c;
 	int errflg = 0;
-	int any_failed = 0;
 	char *pc;
 	int i;
-	struct attrl *attrib = NULL;
 	char *keyword;
 	char *valuewd;
 	char *erplace;
@@ -184,8 +310,9 @@ main(int argc, char **argv, char **envp) /* qalter */
 
 	char job_id_out[PBS_MAXCLTJOBID];
 	char server_out[MAXSERVERNAME];
-	char rmt_server[MAXSERVERNAME];
-	struct ecl_attribute_errors *err_list;
+	char batch_server[MAXSERVERNAME];
+	char **batch;
+	int nbatch = 0;
 
 #define GETOPT_ARGS "a:A:c:e:h:j:k:l:m:M:N:o:p:r:R:S:u:W:P:"
 
@@ -327,46 +454,41 @@ main(int argc, char **argv, char **envp) /* qalter */
 		exit(1);
 	}
 
-	for (; optind < argc; optind++) {
-		int connect;
-		int stat = 0;
-		int located = FALSE;
+	batch = (char **) malloc(ALTER_BATCH_SIZE * sizeof(char *));
+	if (batch == NULL) {
+		fprintf(stderr, "qalter: out of memory\n");
+		exit(2);
+	}
 
+	for (; optind < argc; optind++) {
 		pbs_strncpy(job_id, argv[optind], sizeof(job_id));
 		if (get_server(job_id, job_id_out, server_out)) {
 			fprintf(stderr, "qalter: illegally formed job identifier: %s\n", job_id);
 			any_failed = 1;
 			continue;
 		}
-	cnt:
-		connect = cnt2server(server_out);
-		if (connect <= 0) {
-			fprintf(stderr, "qalter: cannot connect to server %s (errno=%d)\n",
-				pbs_server, pbs_errno);
-			any_failed = pbs_errno;
-			continue;
-		}
 
-		stat = pbs_alterjob(connect, job_id_out, attrib, NULL);
-		if (stat && (pbs_errno != PBSE_UNKJOBID)) {
-			if ((err_list = pbs_get_attributes_in_error(connect)))
-				handle_attribute_errors(connect, err_list, job_id_out);
-
-			prt_job_err("qalter", connect, job_id_out);
-			any_failed = pbs_errno;
-		} else if (stat && (pbs_errno == PBSE_UNKJOBID) && !located) {
-			located = TRUE;
-			if (locate_job(job_id_out, server_out, rmt_server)) {
-				pbs_disconnect(connect);
-				strcpy(server_out, rmt_server);
-				goto cnt;
-			}
-			prt_job_err("qalter", connect, job_id_out);
-			any_failed = pbs_errno;
+		if (nbatch > 0 && (nbatch == ALTER_BATCH_SIZE ||
+				   strcmp(server_out, batch_server) != 0)) {
+			alter_batch(batch_server, batch, nbatch);
+			for (i = 0; i < nbatch; i++)
+				free(batch[i]);
+			nbatch = 0;
 		}
-
-		pbs_disconnect(connect);
+		if (nbatch == 0)
+			pbs_strncpy(batch_server, server_out, sizeof(batch_server));
+		if ((batch[nbatch] = strdup(job_id_out)) == NULL) {
+			fprintf(stderr, "qalter: out of memory\n");
+			exit(2);
+		}
+		nbatch++;
+	}
+	if (nbatch > 0) {
+		alter_batch(batch_server, batch, nbatch);
+		for (i = 0; i < nbatch; i++)
+			free(batch[i]);
 	}
+	free(batch);
 	CS_close_app();
 	exit(any_failed);
 }
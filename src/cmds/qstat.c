@@ -163,8 +163,8 @@ static char *delimiter = "\n";
 static char *prev_resc_name = NULL;
 static int first_stat = 1;
 static int conn;
-static json_data *json_root = NULL; /* root of json structure */
-static json_data *json_prev_resc = NULL;
+static pbs_json_writer json_out;  /* json output, written as it is produced */
+static int json_resc_open = 0;	  /* the object of a resource attribute is open in json_out */
 
 static struct attrl *display_attribs = &basic_attribs[0];
 
@@ -390,6 +390,21 @@ exit_qstat(char *msg)
 	exit(1);
 }
 
+/**
+ * @brief
+ *	close the json object of the resource attribute being printed, if any
+ */
+static void
+json_end_resc(void)
+{
+	if (json_resc_open) {
+		if (pbs_json_write_end(&json_out))
+			exit_qstat("json error");
+		json_resc_open = 0;
+	}
+	prev_resc_name = NULL;
+}
+
 /**
  * @brief
  *	print a attribute value string, formating to break at a comma if possible
@@ -401,7 +416,7 @@ exit_qstat(char *msg)
  *
  */
 void
-prt_attr(char *name, char *resource, char *value, int one_line, json_data * json_obj)
+prt_attr(char *name, char *resource, char *value, int one_line)
 {
 	int first = 1;
 	int len = 0;
@@ -411,16 +426,15 @@ prt_attr(char *name, char *resource, char *value, int one_line, json_data * json
 	char *val = NULL;
 	char *buf = NULL;
 	char *temp = NULL;
-	json_data *json_attr = NULL;
 
 	if (value == NULL)
 		return;
 	switch (output_format) {
 		case FORMAT_JSON:
 			if (strcmp(name, ATTR_v) == 0) {
-				if ((json_attr = pbs_json_create_object()) == NULL)
+				json_end_resc();
+				if (pbs_json_write_begin_object(&json_out, name))
 					exit_qstat("json error");
-				pbs_json_insert_item(json_obj, name, json_attr);
 				buf = strdup(value);
 				temp = buf;
 				if (buf == NULL)
@@ -442,31 +456,28 @@ prt_attr(char *name, char *resource, char *value, int one_line, json_data * json
 						*buf++ = *value++;
 					}
 					*buf = '\0';
-					if (pbs_json_insert_parsed(json_attr, key, val, 0))
+					if (pbs_json_write_parsed(&json_out, key, val, 0))
 						exit_qstat("json error");
 					if (*value != '\0')
 						value++;
 				}
 				free(temp);
+				if (pbs_json_write_end(&json_out))
+					exit_qstat("json error");
 			} else {
 				if (resource) {
-					if (prev_resc_name && strcmp(prev_resc_name, name) != 0) {
-						prev_resc_name = NULL;
-					}
 					if (prev_resc_name == NULL || strcmp(prev_resc_name, name) != 0) {
-						if ((json_prev_resc = pbs_json_create_object()) == NULL)
+						json_end_resc();
+						if (pbs_json_write_begin_object(&json_out, name))
 							exit_qstat("json error");
-						pbs_json_insert_item(json_obj, name, json_prev_resc);
+						json_resc_open = 1;
 						prev_resc_name = name;
 					}
-					if (pbs_json_insert_parsed(json_prev_resc, resource, value, 0))
+					if (pbs_json_write_parsed(&json_out, resource, value, 0))
 						exit_qstat("json error");
 				} else {
-					if (prev_resc_name) {
-						json_prev_resc = NULL;
-						prev_resc_name = NULL;
-					}
-					if (pbs_json_insert_parsed(json_obj, name, value, 0))
+					json_end_resc();
+					if (pbs_json_write_parsed(&json_out, name, value, 0))
 						exit_qstat("json error");
 				}
 			}
@@ -1314,8 +1325,6 @@ display_statjob(struct batch_status *status, struct batch_status *prtheader, int
 	char long_name[NAMEL + 1] = {'\0'};
 	char *cmdargs = NULL;
 	char *hpcbp_executable;
-	json_data *json_jobs = NULL;
-	json_data *json_job = NULL;
 
 	if (wide) {
 		sprintf(format, "%%-%ds %%-%ds %%-%ds  %%%ds %%%ds %%-%ds\n",
@@ -1358,9 +1367,8 @@ display_statjob(struct batch_status *status, struct batch_status *prtheader, int
 	}
 
 	if (output_format == FORMAT_JSON && first_stat) {
-		if ((json_jobs = pbs_json_create_object()) == NULL)
+		if (pbs_json_write_begin_object(&json_out, "Jobs"))
 			return 1;
-		pbs_json_insert_item(json_root, "Jobs", json_jobs);
 		first_stat = 0;
 	}
 	p = status;
@@ -1377,14 +1385,12 @@ display_statjob(struct batch_status *status, struct batch_status *prtheader, int
 		location = NULL;
 		hpcbp_executable = NULL;
 		prev_resc_name = NULL;
-		json_job = NULL;
 		if (full) {
 			if (output_format == FORMAT_DSV || output_format == FORMAT_DEFAULT)
 				printf("Job Id: %s%s", p->name, delimiter);
 			else if (output_format == FORMAT_JSON) {
-				if ((json_job = pbs_json_create_object()) == NULL)
+				if (pbs_json_write_begin_object(&json_out, p->name))
 					return 1;
-				pbs_json_insert_item(json_jobs, p->name, json_job);
 			}
 			a = p->attribs;
 			while (a != NULL) {
@@ -1413,19 +1419,19 @@ display_statjob(struct batch_status *status, struct batch_status *prtheader, int
 							 * Use a stack variable instead.
 							 */
 							char noval[] = "UNKNOWN";
-							prt_attr(a->name, a->resource, noval, alt_opt & ALT_DISPLAY_w, json_job);
+							prt_attr(a->name, a->resource, noval, alt_opt & ALT_DISPLAY_w);
 						} else {
 							char time_buffer[32];
 							pbs_strncpy(time_buffer, ctime(&epoch), sizeof(time_buffer));
 							time_buffer[strlen(time_buffer) - 1] = '\0';
-							prt_attr(a->name, a->resource, time_buffer, alt_opt & ALT_DISPLAY_w, json_job);
+							prt_attr(a->name, a->resource, time_buffer, alt_opt & ALT_DISPLAY_w);
 						}
 					} else if (strcmp(a->name, ATTR_resv_state) == 0) {
-						prt_attr(a->name, a->resource, cvtResvstate(a->value), alt_opt & ALT_DISPLAY_w, json_job);
+						prt_attr(a->name, a->resource, cvtResvstate(a->value), alt_opt & ALT_DISPLAY_w);
 					} else if (strcmp(a->name, ATTR_submit_arguments) == 0) {
 						if (decode_xml_arg_list_str((a->value), &cmdargs) == -1)
 							exit_qstat("out of memory");
-						prt_attr(a->name, a->resource, cmdargs, alt_opt & ALT_DISPLAY_w, json_job);
+						prt_attr(a->name, a->resource, cmdargs, alt_opt & ALT_DISPLAY_w);
 						free(cmdargs);
 					} else if (strcmp(a->name, ATTR_executable) == 0) {
 						/*
@@ -1439,10 +1445,10 @@ display_statjob(struct batch_status *status, struct batch_status *prtheader, int
 							exit_qstat("out of memory");
 						(void) sprintf(hpcbp_executable, "<%s>%s</%s>",
 							       HPCBP_EXEC_TAG, a->value, HPCBP_EXEC_TAG);
-						prt_attr(a->name, a->resource, hpcbp_executable, alt_opt & ALT_DISPLAY_w, json_job);
+						prt_attr(a->name, a->resource, hpcbp_executable, alt_opt & ALT_DISPLAY_w);
 						free(hpcbp_executable);
 					} else {
-						prt_attr(a->name, a->resource, a->value, alt_opt & ALT_DISPLAY_w, json_job);
+						prt_attr(a->name, a->resource, a->value, alt_opt & ALT_DISPLAY_w);
 					}
 				}
 				a = a->next;
@@ -1451,6 +1457,11 @@ display_statjob(struct batch_status *status, struct batch_status *prtheader, int
 			}
 			if (output_format == FORMAT_DEFAULT)
 				printf("%s", delimiter);
+			else if (output_format == FORMAT_JSON) {
+				json_end_resc();
+				if (pbs_json_write_end(&json_out))
+					return 1;
+			}
 		} else {
 			if (p->name != NULL) {
 				c = p->name;
@@ -1643,8 +1654,6 @@ display_statque(struct batch_status *status, int prtheader, int full, int alt_op
 	char ext[NUML + 1];
 	char *type;
 	char format[80];
-	json_data *json_queues = NULL;
-	json_data *json_queue = NULL;
 
 	sprintf(format, "%%-%ds %%%ds %%%ds %%%ds %%%ds %%%ds %%%ds %%%ds %%%ds %%%ds %%%ds %%-%ds\n",
 		NAMEL, NUML, NUML, 3, 3, NUML,
@@ -1656,9 +1665,8 @@ display_statque(struct batch_status *status, int prtheader, int full, int alt_op
 	}
 
 	if (output_format == FORMAT_JSON && first_stat) {
-		if ((json_queues = pbs_json_create_object()) == NULL)
+		if (pbs_json_write_begin_object(&json_out, "Queue"))
 			return 1;
-		pbs_json_insert_item(json_root, "Queue", json_queues);
 		first_stat = 0;
 	}
 	p = status;
@@ -1680,15 +1688,14 @@ display_statque(struct batch_status *status, int prtheader, int full, int alt_op
 			if (output_format == FORMAT_DSV || output_format == FORMAT_DEFAULT)
 				printf("Queue: %s%s", p->name, delimiter);
 			else if (output_format == FORMAT_JSON) {
-				if ((json_queue = pbs_json_create_object()) == NULL)
+				if (pbs_json_write_begin_object(&json_out, p->name))
 					return 1;
-				pbs_json_insert_item(json_queues, p->name, json_queue);
 			}
 			a = p->attribs;
 			while (a != NULL) {
 				if (a->name != NULL) {
 					prt_attr(a->name, a->resource, a->value,
-						 alt_opt & ALT_DISPLAY_w, json_queue);
+						 alt_opt & ALT_DISPLAY_w);
 				}
 				a = a->next;
 				if (a)
@@ -1696,6 +1703,11 @@ display_statque(struct batch_status *status, int prtheader, int full, int alt_op
 			}
 			if (output_format == FORMAT_DEFAULT)
 				printf("%s", delimiter);
+			else if (output_format == FORMAT_JSON) {
+				json_end_resc();
+				if (pbs_json_write_end(&json_out))
+					return 1;
+			}
 		} else {
 			if (p->name != NULL) {
 				l = strlen(p->name);
@@ -1792,8 +1804,6 @@ display_statserver(struct batch_status *status, int prtheader, int full, int alt
 	char ext[NUML + 1];
 	char *stats;
 	char format[80];
-	json_data *json_servers = NULL;
-	json_data *json_server = NULL;
 
 	sprintf(format, "%%-%ds %%%ds %%%ds %%%ds %%%ds %%%ds %%%ds %%%ds %%%ds %%-%ds\n",
 		NAMEL, NUML, NUML, NUML, NUML, NUML, NUML, NUML, NUML, STATUSL);
@@ -1804,9 +1814,8 @@ display_statserver(struct batch_status *status, int prtheader, int full, int alt
 	}
 
 	if (output_format == FORMAT_JSON && first_stat) {
-		if ((json_servers = pbs_json_create_object()) == NULL)
+		if (pbs_json_write_begin_object(&json_out, "Server"))
 			return 1;
-		pbs_json_insert_item(json_root, "Server", json_servers);
 		first_stat = 0;
 	}
 	p = status;
@@ -1825,19 +1834,23 @@ display_statserver(struct batch_status *status, int prtheader, int full, int alt
 			if (output_format == FORMAT_DSV || output_format == FORMAT_DEFAULT)
 				printf("Server: %s%s", p->name, delimiter);
 			else if (output_format == FORMAT_JSON) {
-				if ((json_server = pbs_json_create_object()) == NULL)
+				if (pbs_json_write_begin_object(&json_out, p->name))
 					return 1;
-				pbs_json_insert_item(json_servers, p->name, json_server);
 			}
 			a = p->attribs;
 			while (a != NULL) {
 				if (a->name != NULL) {
-					prt_attr(a->name, a->resource, a->value, alt_opt & ALT_DISPLAY_w, json_server);
+					prt_attr(a->name, a->resource, a->value, alt_opt & ALT_DISPLAY_w);
 				}
 				a = a->next;
 				if ((a || output_format == FORMAT_DEFAULT))
 					printf("%s", delimiter);
 			}
+			if (output_format == FORMAT_JSON) {
+				json_end_resc();
+				if (pbs_json_write_end(&json_out))
+					return 1;
+			}
 		} else {
 			if (p->name != NULL) {
 				l = strlen(p->name);
@@ -2311,6 +2324,76 @@ tcl_run(int f_opt)
 #endif /* localmod 071 */
 #endif /* TCL_QSTAT */
 
+/* size of the stdout buffer used when output is not a terminal */
+#define QSTAT_OUTBUF_SIZE (1024 * 1024)
+
+/**
+ * @brief
+ *	stat_snapshot - status of all objects of one kind of the default
+ *	server, read from the snapshot the server publishes when
+ *	PBS_STATUS_SNAPSHOT is set.
+ *
+ * @par
+ *	The snapshot is taken with manager privilege and its files are only
+ *	readable by root, so this only succeeds for root on the server host.
+ *	Anyone else, or a missing or unreadable snapshot, falls back to asking
+ *	the server.
+ *
+ * @param[in] obj_type - MGR_OBJ_QUEUE or MGR_OBJ_SERVER
+ * @param[in] server - server named on the command line, "" for the default
+ *
+ * @return	structure handle
+ * @retval	status of the objects	success
+ * @retval	NULL			no usable snapshot, ask the server
+ */
+static struct batch_status *
+stat_snapshot(int obj_type, char *server)
+{
+	struct batch_status *bs;
+
+	if (pbs_conf.pbs_status_snapshot == 0 || server[0] != '\0')
+		return NULL;
+
+	bs = pbs_statsnapshot(obj_type, NULL);
+	if (bs == NULL)
+		pbs_errno = PBSE_NONE;
+	return bs;
+}
+
+/* display state shared by the callbacks of one streamed job status */
+struct stream_display {
+	struct batch_status *sd_server; /* header to print before the first job */
+	int sd_alt_opt;
+	int sd_wide;
+	int sd_how_opt;
+	int sd_count; /* number of jobs displayed */
+};
+
+/**
+ * @brief
+ *	pbs_selstat_stream() callback: format one job (an array job with its
+ *	subjobs) as soon as it is decoded, so qstat never holds every job
+ *
+ * @param[in] bs - status of the job, freed here
+ * @param[in] arg - the struct stream_display of this query
+ *
+ * @return void
+ */
+static void
+display_stream_job(struct batch_status *bs, void *arg)
+{
+	struct stream_display *sd = arg;
+	struct batch_status *hdr;
+
+	hdr = (sd->sd_count == 0) ? sd->sd_server : NULL;
+	if ((sd->sd_alt_opt & ~ALT_DISPLAY_w) != 0)
+		altdsp_statjob(bs, hdr, sd->sd_alt_opt, sd->sd_wide, sd->sd_how_opt);
+	else if (display_statjob(bs, hdr, 0, sd->sd_how_opt, sd->sd_alt_opt, sd->sd_wide))
+		exit_qstat("out of memory");
+	sd->sd_count++;
+	pbs_statfree(bs);
+}
+
 int
 main(int argc, char **argv, char **envp) /* qstat */
 {
@@ -2356,6 +2439,9 @@ main(int argc, char **argv, char **envp) /* qstat */
 	struct batch_status *p_server = NULL;
 	struct attropl *p_atropl = 0;
 	struct attropl *new_atropl;
+	struct stream_display sdisp;
+	int stream_jobs;
+	static char outbuf[QSTAT_OUTBUF_SIZE];
 #ifdef NAS /* localmod 071 */
 	int tcl_opt;
 	struct batch_status *p_rsvstat;
@@ -2725,6 +2811,24 @@ qstat -B [-f] [-F format] [-D delim] [ server_name... ]\n";
 	if (def_server == NULL)
 		def_server = "";
 
+	/*
+	 * Listings of many jobs are written in large blocks rather than
+	 * BUFSIZ pieces when redirected to a file or a pipe.
+	 */
+	if (!isatty(fileno(stdout)))
+		(void) setvbuf(stdout, outbuf, _IOFBF, sizeof(outbuf));
+
+	/*
+	 * Summary displays format each job independently, so they are fed
+	 * from a streamed reply.  -f and -T need the whole list: the first
+	 * for tcl_stat() and the JSON document, the second to sort it.
+	 */
+#ifdef NAS /* localmod 071 */
+	stream_jobs = 0;
+#else
+	stream_jobs = (f_opt == 0) && (display_attribs != NULL) && !(alt_opt & ALT_DISPLAY_T);
+#endif /* localmod 071 */
+
 	/*perform needed security library initializations (including none)*/
 
 	if (CS_client_init() != CS_SUCCESS)
@@ -2741,13 +2845,14 @@ qstat -B [-f] [-F format] [-D delim] [ server_name... ]\n";
 		delimiter = "";
 		/* adding prologue to json output. */
 		timenow = time(0);
-		if ((json_root = pbs_json_create_object()) == NULL)
+		pbs_json_writer_init(&json_out, stdout);
+		if (pbs_json_write_begin_object(&json_out, NULL))
 			exit_qstat("json error");
-		if (pbs_json_insert_number(json_root, "timestamp", (double) timenow))
+		if (pbs_json_write_number(&json_out, "timestamp", (double) timenow))
 			exit_qstat("json error");
-		if (pbs_json_insert_string(json_root, "pbs_version", PBS_VERSION))
+		if (pbs_json_write_string(&json_out, "pbs_version", PBS_VERSION))
 			exit_qstat("json error");
-		if (pbs_json_insert_string(json_root, "pbs_server", def_server))
+		if (pbs_json_write_string(&json_out, "pbs_server", def_server))
 			exit_qstat("json error");
 	}
 
@@ -2932,13 +3037,23 @@ qstat -B [-f] [-F format] [-D delim] [ server_name... ]\n";
 					}
 				}
 
-				if ((stat_single_job == 1) || (new_atropl == 0)) {
+				sdisp.sd_count = 0;
+				p_status = NULL;
+				if (stream_jobs && (stat_single_job == 0) && (E_opt == 0)) {
+					/* no job ids: select the destination's jobs, whole or by criteria */
+					sdisp.sd_server = p_server;
+					sdisp.sd_alt_opt = alt_opt;
+					sdisp.sd_wide = wide;
+					sdisp.sd_how_opt = how_opt;
+					(void) pbs_selstat_stream(conn, new_atropl, display_attribs, extend,
+								  display_stream_job, &sdisp);
+				} else if ((stat_single_job == 1) || (new_atropl == 0)) {
 					if (E_opt == 1)
 						p_status = pbs_statjob(conn, query_job_list, display_attribs, extend);
 					else
 						p_status = pbs_statjob(conn, job_id_out, display_attribs, extend);
 				} else {
-					p_status = pbs_selstat(conn, new_atropl, NULL, extend);
+					p_status = pbs_selstat(conn, new_atropl, display_attribs, extend);
 				}
 
 				if (added_queue) {
@@ -2948,7 +3063,10 @@ qstat -B [-f] [-F format] [-D delim] [ server_name... ]\n";
 					new_atropl = p_atropl;
 					added_queue = 0;
 				}
-				if (p_status == NULL) {
+				if (sdisp.sd_count > 0) {
+					/* already displayed as it arrived */
+					p_header = FALSE;
+				} else if (p_status == NULL) {
 					if ((pbs_errno == PBSE_UNKJOBID) && !located) {
 						located = TRUE;
 						if (locate_job(job_id_out, server_out, rmt_server)) {
@@ -3073,19 +3191,25 @@ qstat -B [-f] [-F format] [-D delim] [ server_name... ]\n";
 						server_out[0] = '\0';
 				}
 			que_no_args:
-				conn = cnt2server(server_out);
-				if (conn <= 0) {
-					fprintf(stderr, "qstat: cannot connect to server %s (errno=%d)\n", def_server, pbs_errno);
+				conn = 0;
+				p_status = NULL;
+				if (queue_name_out == NULL || *queue_name_out == '\0')
+					p_status = stat_snapshot(MGR_OBJ_QUEUE, server_out);
+				if (p_status == NULL) {
+					conn = cnt2server(server_out);
+					if (conn <= 0) {
+						fprintf(stderr, "qstat: cannot connect to server %s (errno=%d)\n", def_server, pbs_errno);
 #ifdef NAS /* localmod 071 */
-					(void) tcl_stat(error, NULL, tcl_opt);
+						(void) tcl_stat(error, NULL, tcl_opt);
 #else
-					(void) tcl_stat(error, NULL, f_opt);
+						(void) tcl_stat(error, NULL, f_opt);
 #endif /* localmod 071 */
-					any_failed = conn;
-					break;
-				}
+						any_failed = conn;
+						break;
+					}
 
-				p_status = pbs_statque(conn, queue_name_out, NULL, NULL);
+					p_status = pbs_statque(conn, queue_name_out, NULL, NULL);
+				}
 				if (p_status == NULL) {
 					if (pbs_errno) {
 						errmsg = pbs_geterrmsg(conn);
@@ -3103,7 +3227,7 @@ qstat -B [-f] [-F format] [-D delim] [ server_name... ]\n";
 					}
 				} else {
 					if (alt_opt & ALT_DISPLAY_q) {
-						altdsp_statque(pbs_server, p_status, alt_opt);
+						altdsp_statque(conn > 0 ? pbs_server : def_server, p_status, alt_opt);
 #ifdef NAS /* localmod 071 */
 					} else if (tcl_stat("queue", p_status, tcl_opt)) {
 #else
@@ -3115,26 +3239,31 @@ qstat -B [-f] [-F format] [-D delim] [ server_name... ]\n";
 					p_header = FALSE;
 					pbs_statfree(p_status);
 				}
-				pbs_disconnect(conn);
+				if (conn > 0)
+					pbs_disconnect(conn);
 				break;
 
 			case SERVERS: /* get status of batch servers */
 				pbs_strncpy(server_out, operand, sizeof(server_out));
 			svr_no_args:
-				conn = cnt2server(server_out);
-				if (conn <= 0) {
-					fprintf(stderr, "qstat: cannot connect to server %s (errno=%d)\n",
-						def_server, pbs_errno);
+				conn = 0;
+				p_status = stat_snapshot(MGR_OBJ_SERVER, server_out);
+				if (p_status == NULL) {
+					conn = cnt2server(server_out);
+					if (conn <= 0) {
+						fprintf(stderr, "qstat: cannot connect to server %s (errno=%d)\n",
+							def_server, pbs_errno);
 #ifdef NAS /* localmod 071 */
-					(void) tcl_stat(error, NULL, tcl_opt);
+						(void) tcl_stat(error, NULL, tcl_opt);
 #else
-					(void) tcl_stat(error, NULL, f_opt);
+						(void) tcl_stat(error, NULL, f_opt);
 #endif /* localmod 071 */
-					any_failed = conn;
-					break;
-				}
+						any_failed = conn;
+						break;
+					}
 
-				p_status = pbs_statserver(conn, NULL, NULL);
+					p_status = pbs_statserver(conn, NULL, NULL);
+				}
 				if (p_status == NULL) {
 					if (pbs_errno) {
 						errmsg = pbs_geterrmsg(conn);
@@ -3161,7 +3290,8 @@ qstat -B [-f] [-F format] [-D delim] [ server_name... ]\n";
 					p_header = FALSE;
 					pbs_statfree(p_status);
 				}
-				pbs_disconnect(conn);
+				if (conn > 0)
+					pbs_disconnect(conn);
 				break;
 
 		} /* switch */
@@ -3170,9 +3300,13 @@ qstat -B [-f] [-F format] [-D delim] [ server_name... ]\n";
 			break;
 	}
 	if (output_format == FORMAT_JSON) {
-		if (pbs_json_print(json_root, stdout))
-			fprintf(stderr, "json error\n");
-		pbs_json_delete(json_root);
+		/* close "Jobs", "Queue" or "Server" and the document */
+		while (json_out.jw_depth > 0) {
+			if (pbs_json_write_end(&json_out)) {
+				fprintf(stderr, "json error\n");
+				break;
+			}
+		}
 	}
 #ifdef NAS /* localmod 071 */
 	tcl_run(tcl_opt);
@@ -56,6 +56,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <netdb.h>
+#include <poll.h>
 #include <signal.h>
 #include <termios.h>
 #include <assert.h>
@@ -79,6 +80,8 @@
 #define MAXPIPENAME sizeof(((struct sockaddr_un *) 0)->sun_path)
 #define QSUB_DMN_TIMEOUT_SHORT 5
 #define QSUB_DMN_TIMEOUT_LONG 60 /* timeout for qsub background process */
+#define QSUB_DMN_WORKERS 8	 /* max processes of the qsub daemon submitting at once */
+#define QSUB_DMN_BACKLOG 128	 /* foreground qsubs which can queue on the daemon socket */
 #define DMN_REFUSE_EXIT 7	 /* return code when daemon can't serve a job and exits */
 #define CMDLINE 3
 #define XAUTH_LEN 512		     /* Max size of buffer to store Xauth cookie length */
@@ -149,6 +152,9 @@ static char *X11_get_authstring(void);
 extern void set_attr_error_exit(struct attrl **attrib, char *attrib_name, char *attrib_value);
 static char *port_X11(void);
 static void daemon_stuff(void);
+static void daemon_serve(int bindfd, int primary);
+
+static int dmn_workers = 0; /* workers forked by the primary qsub daemon */
 
 /**
  * @brief
@@ -1482,64 +1488,116 @@ check_qsub_daemon(char *fname)
 
 /**
  * @brief
- *	The daemon_stuff Unix counterpart.
- *	It creates a unix domain socket server and starts listening on it.
- *	The umask is set to 077 so that the domain socket file is owned and
- *	accessible by the user executing qsub only. Once a client (foreground
+ *	Reap the workers of the primary qsub daemon which have exited.
+ *
+ */
+static void
+reap_workers(void)
+{
+	while (dmn_workers > 0 && waitpid(-1, NULL, WNOHANG) > 0)
+		dmn_workers--;
+}
+
+/**
+ * @brief
+ *	Fork another worker for the qsub daemon if foreground qsubs are waiting
+ *	on the daemon socket and there are less than QSUB_DMN_WORKERS processes.
+ *	The worker makes its own connection to pbs_server and serves the socket
+ *	alongside the primary daemon, so a burst of qsubs is submitted over
+ *	several connections at once instead of one after the other.
+ *	Processes are used rather than threads since a submission works on the
+ *	qsub globals and changes the current working directory.
+ *
+ * @param[in]	bindfd - the listening daemon socket
+ * @param[in]	sock   - the foreground connection the primary is serving
+ *
+ */
+static void
+spawn_worker(int bindfd, int sock)
+{
+	struct pollfd pfd;
+	pid_t pid;
+
+	reap_workers();
+	if (dmn_workers >= QSUB_DMN_WORKERS - 1)
+		return;
+
+	pfd.fd = bindfd;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	if (poll(&pfd, 1, 0) != 1)
+		return; /* no one else is waiting */
+
+	pid = fork();
+	if (pid == -1)
+		return;
+	if (pid > 0) {
+		dmn_workers++;
+		return;
+	}
+
+	/*
+	 * The inherited server connection belongs to the primary, leave it
+	 * open so the connection of the worker gets a descriptor of its own.
+	 */
+	close(sock);
+	dmn_workers = 0;
+
+	/* the request the primary is serving is not ours */
+	qsub_free_attrl(attrib);
+	attrib = NULL;
+	free(v_value);
+	v_value = NULL;
+	free(basic_envlist);
+	basic_envlist = NULL;
+	free(qsub_envlist);
+	qsub_envlist = NULL;
+
+	sd_svr = cnt2server_extend(server_out, QSUB_DAEMON);
+	if (sd_svr <= 0) {
+		log_syslog("Background qsub: worker failed to connect to server");
+		exit(1);
+	}
+	daemon_serve(bindfd, 0);
+}
+
+/**
+ * @brief
+ *	The request loop of a qsub daemon process.  Once a client (foreground
  *	qsub) connects, it receives all the data from the foreground qsub and
- *	executes do_submit, on the pre-established connection to pbs_server.
- *	The connection to server was estiblished by the caller of this function
- *	by calling do_connect().
- *	This function also does a "select" wait on input of data from foreground
+ *	executes do_submit, on the process' connection to pbs_server.
+ *	This function does a "select" wait on input of data from foreground
  *	qsub processes, and a close notification on the socket with pbs_server.
  *	The select breaks if foreground qsubs connect, the pbs_server dies, or
  *	the timeout of 1 minutes expires. For the latter two cases, this function
- *	does a silent exit of the background qsub daemon.
+ *	does a silent exit of the process.
+ *
+ *	Only the primary process (the one daemon_stuff() ran in) removes the
+ *	socket file and forks workers.
+ *
+ * @param[in]	bindfd  - the listening daemon socket
+ * @param[in]	primary - whether this is the primary daemon process
  *
  */
 static void
-daemon_stuff(void)
+daemon_serve(int bindfd, int primary)
 {
-	int sock, bindfd;
-	struct sockaddr_un s_un;
+	int sock;
 	struct sockaddr from;
 	socklen_t fromlen;
 	int rc;
+	int flags;
 	fd_set readset;
 	fd_set workset;
 	struct timeval timeout;
 	int n, maxfd;
-	mode_t cmask = 0077;
 	time_t connect_time = time(0);
 	sigset_t newsigmask, oldsigmask;
 	char *err_op = "";
 	char log_buf[LOG_BUF_SIZE];
 	int cred_timeout = 0;
 
-	/* set umask so socket file created is only accessible by same user */
-	umask(cmask);
-	sigemptyset(&newsigmask);
-	sigaddset(&newsigmask, SIGPIPE);
-	sigprocmask(SIG_BLOCK, &newsigmask, NULL);
-
-	/* start up a unix domain socket to listen */
-	if ((bindfd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1) {
-		err_op = "socket";
-		goto error;
-	}
-
-	s_un.sun_family = AF_UNIX;
-	snprintf(s_un.sun_path, sizeof(s_un.sun_path), "%s", fl);
-
-	if (bind(bindfd, (const struct sockaddr *) &s_un, sizeof(s_un)) == -1)
-		exit(1); /* dont go to error */
-
 	FD_ZERO(&readset);
-	if (listen(bindfd, 1) != 0) {
-		err_op = "listen";
-		goto error;
-	}
-
 	FD_SET(bindfd, &readset);
 	FD_SET(sd_svr, &readset);
 	maxfd = (bindfd > sd_svr) ? bindfd : sd_svr;
@@ -1570,7 +1628,8 @@ daemon_stuff(void)
 		 * Qsub then does a regular submit (new connection)
 		 */
 		if (cred_timeout == 0 && ((time(0) - connect_time) > (CREDENTIAL_LIFETIME - QSUB_DMN_TIMEOUT_LONG))) {
-			unlink(fl);
+			if (primary)
+				unlink(fl);
 			cred_timeout = 1;
 		}
 
@@ -1580,12 +1639,18 @@ daemon_stuff(void)
 				goto out;
 		}
 
-		/* accept the connection */
+		/* accept the connection, another process of the daemon may have beaten us to it */
+		if (!FD_ISSET(bindfd, &workset))
+			continue;
 		fromlen = sizeof(from);
 		if ((sock = accept(bindfd, &from, &fromlen)) == -1) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ECONNABORTED || errno == EINTR)
+				continue;
 			err_op = "accept";
 			goto error;
 		}
+		if ((flags = fcntl(sock, F_GETFL)) != -1)
+			(void) fcntl(sock, F_SETFL, flags & ~O_NONBLOCK);
 
 		if ((recv_attrl(&sock, &attrib) != 0) ||
 		    (recv_string(&sock, destination) != 0) ||
@@ -1624,6 +1689,10 @@ daemon_stuff(void)
 			goto error;
 		}
 
+		/* let a new worker take the qsubs queued up behind this one */
+		if (primary && cred_timeout == 0)
+			spawn_worker(bindfd, sock);
+
 		sigemptyset(&newsigmask);
 		sigaddset(&newsigmask, SIGXCPU);
 		sigaddset(&newsigmask, SIGXFSZ);
@@ -1674,10 +1743,71 @@ daemon_stuff(void)
 
 out:
 	close(bindfd);
-	if (cred_timeout != 1)
+	if (primary && cred_timeout != 1)
 		unlink(fl);
 	exit(0);
 
+error:
+	sprintf(log_buf, "Background qsub: Failed at %s, errno=%d", err_op, errno);
+	log_syslog(log_buf);
+	if (primary)
+		unlink(fl);
+	close(bindfd);
+	exit(1);
+}
+
+/**
+ * @brief
+ *	The daemon_stuff Unix counterpart.
+ *	It creates a unix domain socket server and starts listening on it.
+ *	The umask is set to 077 so that the domain socket file is owned and
+ *	accessible by the user executing qsub only.  The connection to server
+ *	was estiblished by the caller of this function by calling do_connect().
+ *	The requests are served by daemon_serve(), which forks more workers
+ *	when foreground qsubs queue up on the socket.
+ *
+ */
+static void
+daemon_stuff(void)
+{
+	int bindfd;
+	struct sockaddr_un s_un;
+	mode_t cmask = 0077;
+	sigset_t newsigmask;
+	char *err_op = "";
+	char log_buf[LOG_BUF_SIZE];
+
+	/* set umask so socket file created is only accessible by same user */
+	umask(cmask);
+	sigemptyset(&newsigmask);
+	sigaddset(&newsigmask, SIGPIPE);
+	sigprocmask(SIG_BLOCK, &newsigmask, NULL);
+
+	/* start up a unix domain socket to listen */
+	if ((bindfd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1) {
+		err_op = "socket";
+		goto error;
+	}
+
+	s_un.sun_family = AF_UNIX;
+	snprintf(s_un.sun_path, sizeof(s_un.sun_path), "%s", fl);
+
+	if (bind(bindfd, (const struct sockaddr *) &s_un, sizeof(s_un)) == -1)
+		exit(1); /* dont go to error */
+
+	if (listen(bindfd, QSUB_DMN_BACKLOG) != 0) {
+		err_op = "listen";
+		goto error;
+	}
+
+	/* the daemon processes all wait on the socket, the one to accept serves */
+	if (fcntl(bindfd, F_SETFL, fcntl(bindfd, F_GETFL) | O_NONBLOCK) == -1) {
+		err_op = "fcntl";
+		goto error;
+	}
+
+	daemon_serve(bindfd, 1);
+
 error:
 	sprintf(log_buf, "Background qsub: Failed at %s, errno=%d", err_op, errno);
 	log_syslog(log_buf);
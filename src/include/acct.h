@@ -85,6 +85,7 @@ extern "C" {
 
 extern int acct_open(char *filename);
 extern void acct_close(void);
+extern void acct_flush(void);
 extern void account_record(int acctype, const job *pjob, char *text);
 extern void write_account_record(int acctype, const char *jobid, char *text);
 
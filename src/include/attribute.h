@@ -300,6 +300,7 @@ struct array_strings {
 	int as_bufsize;	    /* size of buffer holding strings */
 	char *as_buf;	    /* address of buffer */
 	char *as_next;	    /* first available byte in buffer */
+	void *as_acl;	    /* lookup index built by acl_check() */
 	char *as_string[1]; /* first string pointer */
 };
 
@@ -324,6 +325,8 @@ svrattrl *dup_svrattrl(svrattrl *osvrat);
 extern void free_svrattrl(svrattrl *pal);
 extern void free_attrlist(pbs_list_head *attrhead);
 extern void free_svrcache(attribute *attr);
+extern long attr_mem_size(const attribute *pattr);
+extern long attr_cache_mem_size(const attribute *pattr);
 extern int attr_atomic_set(svrattrl *plist, attribute *old,
 			   attribute *nattr, void *adef_idx, attribute_def *pdef, int limit,
 			   int unkn, int privil, int *badattr);
@@ -473,6 +476,8 @@ extern char *return_internal_value(char *name, char *val);
 /* other associated funtions */
 
 extern int acl_check(attribute *, char *canidate, int type);
+extern void free_acl_index(struct array_strings *);
+extern void (*pfn_free_acl_index)(struct array_strings *);
 extern int check_duplicates(struct array_strings *strarr);
 
 extern char *arst_string(char *str, attribute *pattr);
@@ -481,6 +486,7 @@ extern int save_attr_fs(attribute_def *, attribute *, int);
 
 extern int encode_state(const attribute *, pbs_list_head *, char *,
 			char *, int, svrattrl **rtnl);
+extern int str_to_vnode_state(char *);
 extern int encode_props(const attribute *, pbs_list_head *, char *,
 			char *, int, svrattrl **rtnl);
 extern int encode_jobs(const attribute *, pbs_list_head *, char *,
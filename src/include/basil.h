@@ -830,6 +830,7 @@ typedef struct basil_node {
 	basil_node_socket_t *sockets;
 	basil_node_segment_t *segments;
 	basil_node_accelerator_t *accelerators;
+	unsigned long long hash; /* hash of the node's inventory XML, 0 if unknown */
 	struct basil_node *next;
 } basil_node_t;
 
@@ -180,6 +180,25 @@ struct rq_runjob {
 	unsigned long rq_resch;
 };
 
+/* RunJobList */
+struct rq_runjoblist {
+	int rq_count;
+	char **rq_jobslist;
+	char **rq_destinlist;
+};
+
+/* Subscribe */
+struct rq_subscribe {
+	int rq_objtype;			    /* MGR_OBJ_JOB or MGR_OBJ_NODE */
+	char rq_filter[PBS_MAXUSER + 1]; /* job owner, "" for all */
+};
+
+/* ModifyJobList_Async */
+struct rq_modifyjoblist {
+	int rq_count;
+	struct rq_manage *rq_mods; /* one Manage request per job */
+};
+
 /* JobObit */
 struct rq_jobobit {
 	struct job *rq_pjob;
@@ -205,6 +224,15 @@ struct rq_selstat {
 	pbs_list_head rq_rtnattr;
 };
 
+/* SelAct - the selection is shared with SelectJobs, so rq_sel must stay first */
+struct rq_selact {
+	struct rq_selstat rq_sel;
+	int rq_action;			/* SELACT_* */
+	pbs_list_head rq_args;		/* attributes of the action */
+	struct brp_select *rq_pending;	/* selected jobs not acted on yet */
+	int rq_acted;			/* jobs acted on so far */
+};
+
 /* TrackJob */
 struct rq_track {
 	int rq_hopcount;
@@ -302,6 +330,7 @@ struct batch_request {
 	int rq_orgconn;			   /* original socket if relayed to MOM */
 	int rq_extsz;			   /* size of "extension" data */
 	long rq_time;			   /* time batch request created */
+	unsigned long long rq_recv_us;	   /* pbs_metrics_now_us() when read from a client, 0 if not */
 	char rq_user[PBS_MAXUSER + 1];	   /* user name request is from */
 	char rq_host[PBS_MAXHOSTNAME + 1]; /* name of host sending request */
 	void *rq_extra;			   /* optional ptr to extra info */
@@ -338,8 +367,12 @@ struct batch_request {
 		char rq_rerun[PBS_MAXSVRJOBID + 1];
 		struct rq_rescq rq_rescq;
 		struct rq_runjob rq_run;
+		struct rq_runjoblist rq_runjoblist;
+		struct rq_subscribe rq_subscribe;
+		struct rq_modifyjoblist rq_modifyjoblist;
 		struct rq_jobobit rq_obit;
 		struct rq_selstat rq_select;
+		struct rq_selact rq_selact;
 		int rq_shutdown;
 		struct rq_signal rq_signal;
 		struct rq_status rq_status;
@@ -365,6 +398,7 @@ extern void reply_badattr_msg(int, int, svrattrl *, struct batch_request *, int)
 extern int reply_text(struct batch_request *, int, char *);
 extern int reply_send(struct batch_request *);
 extern int reply_send_status_part(struct batch_request *);
+extern int reply_send_delete_part(struct batch_request *);
 extern int reply_jobid(struct batch_request *, char *, int);
 extern int reply_jobid_msg(struct batch_request *, char *, int, int);
 extern void reply_free(struct batch_reply *);
@@ -392,7 +426,10 @@ extern void req_register(struct batch_request *);
 extern void req_releasejob(struct batch_request *);
 extern void req_rescq(struct batch_request *);
 extern void req_runjob(struct batch_request *);
+extern void req_runjoblist(struct batch_request *);
+extern void update_runjoblist_rply(struct batch_request *, char *, int);
 extern void req_selectjobs(struct batch_request *);
+extern void req_subscribe(struct batch_request *);
 extern void req_stat_que(struct batch_request *);
 extern void req_stat_svr(struct batch_request *);
 extern void req_stat_sched(struct batch_request *);
@@ -420,6 +457,9 @@ extern int decode_DIS_CopyHookFile(int, struct batch_request *);
 extern int decode_DIS_DelHookFile(int, struct batch_request *);
 extern int decode_DIS_Manage(int, struct batch_request *);
 extern int decode_DIS_DelJobList(int, struct batch_request *);
+extern int decode_DIS_RunJobList(int, struct batch_request *);
+extern int decode_DIS_Subscribe(int, struct batch_request *);
+extern int decode_DIS_ModifyJobList(int, struct batch_request *);
 extern int decode_DIS_MoveJob(int, struct batch_request *);
 extern int decode_DIS_MessageJob(int, struct batch_request *);
 extern int decode_DIS_ModifyResv(int, struct batch_request *);
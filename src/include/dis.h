@@ -236,6 +236,7 @@ int dis_puts(int, const char *, size_t);
 int dis_flush(int);
 void dis_setup_chan(int, pbs_tcp_chan_t *(*) (int) );
 void dis_destroy_chan(int);
+long dis_buf_mem(void);
 
 void transport_chan_set_ctx_status(int, int, int);
 int transport_chan_get_ctx_status(int, int);
@@ -115,6 +115,30 @@ typedef enum hook_user hook_user;
 #define MOM_EVENTS (HOOK_EVENT_EXECJOB_BEGIN | HOOK_EVENT_EXECJOB_PROLOGUE | HOOK_EVENT_EXECJOB_EPILOGUE | HOOK_EVENT_EXECJOB_END | HOOK_EVENT_EXECJOB_PRETERM | HOOK_EVENT_EXECHOST_PERIODIC | HOOK_EVENT_EXECJOB_LAUNCH | HOOK_EVENT_EXECHOST_STARTUP | HOOK_EVENT_EXECJOB_ATTACH | HOOK_EVENT_EXECJOB_RESIZE | HOOK_EVENT_EXECJOB_ABORT | HOOK_EVENT_EXECJOB_POSTSUSPEND | HOOK_EVENT_EXECJOB_PRERESUME)
 #define USER_MOM_EVENTS (HOOK_EVENT_EXECJOB_PROLOGUE | HOOK_EVENT_EXECJOB_EPILOGUE | HOOK_EVENT_EXECJOB_PRETERM)
 #define FAIL_ACTION_EVENTS (HOOK_EVENT_EXECJOB_BEGIN | HOOK_EVENT_EXECHOST_STARTUP | HOOK_EVENT_EXECJOB_PROLOGUE)
+
+/* per-event execution counters kept in memory for each hook */
+#define HOOK_PERF_NEVENTS 28  /* bits used by HOOK_EVENT_* */
+#define HOOK_PERF_NBUCKETS 16 /* bucket i counts runs under 2^i ms */
+
+enum hook_perf_outcome {
+	HOOK_PERF_ACCEPT,
+	HOOK_PERF_REJECT,
+	HOOK_PERF_ALARM,
+	HOOK_PERF_ERROR
+};
+
+typedef struct hook_perf_counters {
+	unsigned long runs;
+	unsigned long accepts;
+	unsigned long rejects; /* includes alarms */
+	unsigned long alarms;
+	unsigned long errors;
+	double total_secs;    /* wall time spent in the hook */
+	double max_secs;      /* longest single run */
+	double populate_secs; /* part of total_secs spent building event objects */
+	unsigned long hist[HOOK_PERF_NBUCKETS];
+} hook_perf_counters;
+
 struct hook {
 	char *hook_name;	  /* unique name of the hook */
 	hook_type type;		  /* site-defined or pbs builtin */
@@ -166,6 +190,7 @@ struct hook {
 	pbs_list_link hi_execjob_postsuspend_hooks;
 	pbs_list_link hi_execjob_preresume_hooks;
 	struct work_task *ptask; /* work task pointer, used in periodic hooks */
+	hook_perf_counters perf[HOOK_PERF_NEVENTS]; /* indexed by event bit */
 };
 
 typedef struct hook hook;
@@ -186,6 +211,17 @@ typedef struct hook hook;
 #define HOOK_BUF_SIZE 512
 #define HOOK_MSG_SIZE 3172
 
+/*
+ * Mom's hook server, "pbs_python --hook-server <fd>": keeps a started
+ * interpreter and forks a worker for each hook run Mom asks for over <fd>.
+ * A request is one record of NUL terminated strings: the working directory,
+ * the PBS_HOOK_CONFIG_FILE value ("" for none) and the pbs_python --hook
+ * command line; it carries a socket on which the server writes the worker's
+ * pid and then its wait status.
+ */
+#define HOOK_SERVER_MODE "--hook-server"
+#define HOOK_SERVER_MSG_SIZE (32 * 1024)
+
 /* parameters to import and export qmgr command */
 #define CONTENT_TYPE_PARAM "content-type"
 #define CONTENT_ENCODING_PARAM "content-encoding"
@@ -217,6 +253,7 @@ typedef struct hook hook;
 #define HOOKATT_FREQ "freq"
 #define HOOKATT_FAIL_ACTION "fail_action"
 #define HOOKATT_PENDING_DELETE "pending_delete"
+#define HOOKATT_PERF_STATS "perf_stats" /* read-only, only returned on request */
 
 #define HOOK_PBS_PREFIX "PBS" /* valid Hook name prefix for PBS hook */
 
@@ -414,6 +451,9 @@ extern int set_alarm(int sec, void (*)(void));
 
 extern void hook_perf_stat_start(char *label, char *action, int);
 extern void hook_perf_stat_stop(char *label, char *action, int);
+extern void hook_perf_record(hook *phook, unsigned int event, double elapsed,
+			     double populate, enum hook_perf_outcome outcome);
+extern char *hook_perf_as_json(hook *phook);
 #define HOOK_PERF_POPULATE "populate"
 #define HOOK_PERF_FUNC "hook_func"
 #define HOOK_PERF_RUN_CODE "run_code"
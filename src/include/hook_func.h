@@ -138,6 +138,7 @@ extern int recreate_request(struct batch_request *);
 
 /* Server periodic hook call-back */
 extern void run_periodic_hook(struct work_task *ptask);
+extern int run_resv_end_hooks_async(struct batch_request *preq);
 
 extern int get_server_hook_results(char *input_file, int *accept_flag, int *reject_flag,
 				   char *reject_msg, int reject_msg_size, job *pjob, hook *phook, hook_output_param_t *hook_output);
@@ -58,8 +58,12 @@ int __pbs_asyrunjob_ack(int c, const char *jobid, const char *location, const ch
 
 int __pbs_alterjob(int, const char *, struct attrl *, const char *);
 
+struct batch_deljob_status *__pbs_alterjoblist(int, char **, struct attrl **, int, const char *);
+
 int __pbs_asyalterjob(int, const char *, struct attrl *, const char *);
 
+int __pbs_asyalterjoblist(int, char **, struct attrl **, int, const char *);
+
 int __pbs_confirmresv(int, const char *, const char *, unsigned long, const char *);
 
 int __pbs_connect(const char *);
@@ -96,6 +100,8 @@ int __pbs_rlsjob(int, const char *, const char *, const char *);
 
 int __pbs_runjob(int, const char *, const char *, const char *);
 
+struct batch_deljob_status *__pbs_runjoblist(int, char **, char **, int, const char *);
+
 char **__pbs_selectjob(int, struct attropl *, const char *);
 
 int __pbs_sigjob(int, const char *, const char *, const char *);
@@ -110,6 +116,10 @@ struct batch_status *__pbs_statjob(int, const char *, struct attrl *, const char
 
 struct batch_status *__pbs_selstat(int, struct attropl *, struct attrl *, const char *);
 
+int __pbs_selstat_stream(int, struct attropl *, struct attrl *, const char *, pbs_status_cb, void *);
+
+int __pbs_selact(int, struct attropl *, int, struct attrl *, const char *, pbs_selact_cb, void *);
+
 struct batch_status *__pbs_statque(int, const char *, struct attrl *, const char *);
 
 struct batch_status *__pbs_statserver(int, struct attrl *, const char *);
@@ -122,6 +132,18 @@ struct batch_status *__pbs_statnode(int, const char *, struct attrl *, const cha
 
 struct batch_status *__pbs_statvnode(int, const char *, struct attrl *, const char *);
 
+int __pbs_statvnode_stream(int, const char *, struct attrl *, const char *, pbs_status_cb, void *);
+
+int __pbs_stat_submit(int, int, const char *, struct attrl *, const char *);
+
+struct batch_status *__pbs_stat_collect(int);
+
+struct batch_status *__pbs_statsnapshot(int, time_t *);
+
+int __pbs_subscribe(int, int, const char *);
+
+struct batch_status *__pbs_subscribe_next(int);
+
 struct batch_status *__pbs_statresv(int, const char *, struct attrl *, const char *);
 
 struct batch_status *__pbs_stathook(int, const char *, struct attrl *, const char *);
@@ -345,7 +345,9 @@ typedef struct ajinfo {
 	int tkm_flags;			  /* special flags for array job */
 	int tkm_subjsct[PBS_NUMJOBSTATE]; /* count of subjobs in various states */
 	int tkm_dsubjsct;		  /* count of deleted subjobs */
-	range *trm_quelist;		  /* pointer to range list */
+	range_set *trm_quelist;		  /* queued subjobs */
+	range_set *trm_failedlist;	  /* purged subjobs which failed */
+	range_set *trm_termlist;	  /* purged subjobs which were terminated */
 } ajinfo_t;
 
 /*
@@ -415,6 +417,24 @@ enum bg_hook_request {
 	BG_CHECKPOINT_ABORT
 };
 
+/* steps of a job start on mother superior, timed for ATTR_startup_latency */
+enum job_startup_step {
+	STARTUP_BEGIN,	  /* start_exec() */
+	STARTUP_JOINED,	  /* finish_exec(), the sisters have joined */
+	STARTUP_LAUNCHED, /* job starter reported the session */
+	STARTUP_NSTEPS
+};
+
+/* one point of a job's resource usage time series, see $job_sample_interval */
+#define JOB_SAMPLE_RING 64
+typedef struct job_sample {
+	time_t js_time;	      /* when mom_set_use() took the sample */
+	unsigned long js_cput; /* cput so far */
+	long js_cpupercent;    /* moving average cpu usage */
+	u_Long js_mem;	      /* resident memory, KB */
+	u_Long js_vmem;	      /* virtual memory, KB */
+} job_sample_t;
+
 struct job {
 
 	/*
@@ -431,6 +451,8 @@ struct job {
 	struct batch_request *ji_rerun_preq; /* outstanding rerun request */
 #ifdef PBS_MOM
 	void *ji_pending_ruu;			    /* pending last update */
+	pbs_list_head ji_ruu_sent;		    /* resources_used values last sent to server */
+	int ji_ruu_seq;				    /* sequence number of the last update, see RUU_SEQ_FULL */
 	struct batch_request *ji_preq;		    /* outstanding request */
 	struct grpcache *ji_grpcache;		    /* cache of user's groups */
 	enum PBS_Chkpt_By ji_chkpttype;		    /* checkpoint type  */
@@ -453,6 +475,13 @@ struct job {
 	time_t ji_walltime_stamp;		    /* time stamp for accumulating walltime */
 	struct work_task *ji_bg_hook_task;
 	struct work_task *ji_report_task;
+	struct work_task *ji_walltime_task;	    /* fires when walltime limit is reached */
+	double ji_startup[STARTUP_NSTEPS];	    /* when each job_startup_step was reached */
+	int ji_evscan;				    /* hosts below this have no events, see IM_ALL_OKAY */
+	job_sample_t *ji_samples;		    /* ring of JOB_SAMPLE_RING usage samples */
+	int ji_nsamples;			    /* samples taken, the next goes to ji_nsamples % JOB_SAMPLE_RING */
+	u_long ji_resc_sent_hash;		    /* hash of hook resources last sent to MS */
+	time_t ji_resc_sent_time;		    /* when they were last sent in a poll reply */
 #ifdef WIN32
 	HANDLE ji_momsubt;	 /* process HANDLE to mom subtask */
 #else				 /* not WIN32 */
@@ -493,6 +522,9 @@ struct job {
 	int ji_discarding;		   /* discarding job */
 	struct batch_request *ji_prunreq;  /* outstanding runjob request */
 	pbs_list_head ji_svrtask;	   /* links to svr work_task list */
+	pbs_list_link ji_dbsavelink;	   /* links to jobs with a deferred database save */
+	pbs_list_link ji_statelink;	   /* links to server's jobs in the same state */
+	int ji_hist_ix;			   /* slot in history expiry heap, -1 if none */
 	struct pbs_queue *ji_qhdr;	   /* current queue header */
 	struct resc_resv *ji_myResv;	   /* !=0 job belongs to a reservation, see also, attribute JOB_ATR_myResv */
 
@@ -526,6 +558,9 @@ struct job {
 	struct preempt_ordering *preempt_order;
 	int preempt_order_index;
 	struct work_task *ji_prov_startjob_task;
+	int ji_prov_done_idx; /* prov_vnode entries already seen done, see is_runnable() */
+	unsigned long ji_stat_digest; /* digest of the last mom status update applied, see stat_update() */
+	int ji_ruu_seq;		      /* sequence number of that update, see RUU_SEQ_FULL */
 
 #endif /* END SERVER ONLY */
 
@@ -815,6 +850,7 @@ task_find(job *pjob,
 #define JOB_TASKDIR_SUFFIX ".TK" /* job task directory */
 #define JOB_BAD_SUFFIX ".BD"	 /* save bad job file */
 #define JOB_DEL_SUFFIX ".RM"	 /* file pending to be removed */
+#define JOB_JOURNAL_FILE "journal.JL" /* mom job journal, see $job_journal */
 
 /*
  * Job states are defined by POSIX as:
@@ -997,6 +1033,7 @@ extern void issue_delete(job *);
 extern int job_abt(job *, char *);
 extern job *job_alloc(void);
 extern void job_free(job *);
+extern void job_compact_hist(job *);
 extern int modify_job_attr(job *, svrattrl *, int, int *);
 extern char *prefix_std_file(job *, int);
 extern void cat_default_std(job *, int, char *, char **);
@@ -1008,6 +1045,7 @@ extern int   site_check_user_map(job *, char *);
 extern int site_check_user_map(void *, int, char *);
 extern int site_allow_u(char *user, char *host);
 extern void svr_dequejob(job *);
+extern void svr_unlink_jobstate(job *);
 extern int svr_enquejob(job *, char *);
 extern void svr_evaljobstate(job *, char *, int *, int);
 extern int svr_setjobstate(job *, char, int);
@@ -1062,6 +1100,12 @@ attribute *get_jattr(const job *pjob, int attr_idx);
 
 extern job *job_recov_fs(char *);
 extern int job_save_fs(job *);
+extern int job_journal_open(void);
+extern int job_journal_active(void);
+extern int job_journal_recov(job ***);
+extern void job_journal_purge(job *);
+extern void job_journal_purge_id(char *);
+extern void job_journal_close(void);
 
 #define job_save job_save_fs
 #define job_recov job_recov_fs
@@ -1070,6 +1114,8 @@ extern int job_save_fs(job *);
 
 extern job *job_recov_db(char *, job *pjob);
 extern int job_save_db(job *);
+extern void job_save_db_flush(void);
+extern void job_delete_db(job *);
 
 #define job_save job_save_db
 #define job_recov job_recov_db
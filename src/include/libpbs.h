@@ -66,6 +66,10 @@ extern "C" {
 #define PBS_BATCH_PROT_TYPE 2
 #define PBS_BATCH_PROT_VER_OLD 1
 #define PBS_BATCH_PROT_VER 2
+
+/* status snapshot files written under server_priv, see PBS_STATUS_SNAPSHOT */
+#define PBS_SNAPSHOT_PREFIX "status_snapshot."
+#define PBS_SNAPSHOT_VERSION 1
 #define SCRIPT_CHUNK_Z (65536)
 #ifndef TRUE
 #define TRUE 1
@@ -124,6 +128,7 @@ typedef struct pbs_conn {
 	char *ch_errtxt;	  /* pointer to last server error text	*/
 	pthread_mutex_t ch_mutex; /* serialize connection between threads */
 	pbs_tcp_chan_t *ch_chan;  /* pointer tcp chan structure for this connection */
+	int ch_pending;		  /* submitted status requests not yet collected */
 } pbs_conn_t;
 
 int destroy_connection(int);
@@ -131,6 +136,7 @@ int set_conn_errtxt(int, const char *);
 char *get_conn_errtxt(int);
 int set_conn_errno(int, int);
 int get_conn_errno(int);
+int add_conn_pending(int, int);
 pbs_tcp_chan_t *get_conn_chan(int);
 int set_conn_chan(int, pbs_tcp_chan_t *);
 pthread_mutex_t *get_conn_mutex(int);
@@ -196,6 +202,8 @@ struct batch_reply {
 	int brp_count;
 	int brp_type;
 	struct batch_status *last;
+	pbs_status_cb brp_status_cb; /* if set, status objects go to it as they are decoded */
+	void *brp_status_arg;
 	union {
 		char brp_jid[PBS_MAXSVRJOBID + 1];
 		struct brp_select *brp_select;	/* select replies */
@@ -293,6 +301,13 @@ struct batch_reply {
 #define PBS_BATCH_RegisterSched 98
 #define PBS_BATCH_ModifyVnode 99
 #define PBS_BATCH_DeleteJobList 100
+#define PBS_BATCH_RunJobList 101
+#define PBS_BATCH_ModifyJobList_Async 102
+#define PBS_BATCH_Subscribe 103
+#define PBS_BATCH_ModifyJobList 104
+#define PBS_BATCH_SelAct 105
+
+#define PBS_MAX_RUNJOBLIST 10000 /* most jobs in one RunJobList request */
 
 #define PBS_BATCH_FileOpt_Default 0
 #define PBS_BATCH_FileOpt_OFlg 1
@@ -326,6 +341,7 @@ void advise(char *, ...);
 int PBSD_commit(int, char *, int, char **, char *);
 int PBSD_jcred(int, int, char *, int, int, char **);
 int PBSD_jscript(int, const char *, int, char **);
+int PBSD_jscript_commit(int, const char *, int *);
 int PBSD_jscript_direct(int, char *, int, char **);
 int PBSD_copyhookfile(int, char *, int, char **);
 int PBSD_delhookfile(int, char *, int, char **);
@@ -340,10 +356,12 @@ int PBSD_status_put(int, int, const char *, struct attrl *, const char *, int, c
 int PBSD_select_put(int, int, struct attropl *, struct attrl *, const char *);
 char **PBSD_select_get(int);
 struct batch_reply *PBSD_rdrpy(int);
+struct batch_reply *PBSD_rdrpy_stream(int, pbs_status_cb, void *);
 struct batch_reply *PBSD_rdrpy_sock(int, int *, int prot);
 void PBSD_FreeReply(struct batch_reply *);
 struct batch_status *PBSD_status(int, int, const char *, struct attrl *, const char *);
 struct batch_status *PBSD_status_get(int c);
+int PBSD_status_stream_get(int c, pbs_status_cb cb, void *arg);
 char *PBSD_queuejob(int, char *, const char *, struct attropl *, const char *, int, char **, int *);
 int decode_DIS_svrattrl(int, pbs_list_head *);
 int decode_DIS_attrl(int, struct attrl **);
@@ -372,6 +390,9 @@ int encode_DIS_attropl(int, struct attropl *);
 int encode_DIS_CopyHookFile(int, int, const char *, int, const char *);
 int encode_DIS_DelHookFile(int, const char *);
 int encode_DIS_JobsList(int, char **, int);
+int encode_DIS_RunJobList(int, char **, char **, int);
+int encode_DIS_ModifyJobList(int, char **, struct attropl **, int);
+int encode_DIS_Subscribe(int, int, const char *);
 char *PBSD_submit_resv(int, const char *, struct attropl *, const char *);
 int DIS_reply_read(int, struct batch_reply *, int);
 int tcp_pre_process(conn_t *);
@@ -382,6 +403,19 @@ int pbs_register_sched(const char *sched_id, int primary_conn_id, int secondary_
 char *PBS_get_server(const char *, char *, uint *);
 
 void pbs_statfree_single(struct batch_status *bsp);
+
+/*
+ * A batch_status decoded from a status reply is allocated as one block:
+ * this header, the batch_status, its attrl entries and then all of their
+ * strings.  The text member of such a batch_status is set to bs_arena_mark
+ * so pbs_statfree() knows to free it with a single free().
+ */
+struct bs_arena {
+	size_t ba_size;		   /* size of the whole block */
+	struct batch_status ba_bs; /* followed by the attrl entries and strings */
+};
+extern char bs_arena_mark[];
+int bs_arena_owns(struct batch_status *bsp, void *ptr);
 #ifdef __cplusplus
 }
 #endif
@@ -66,6 +66,8 @@ int char_in_set(char c, const char *tokset);
 /* string_token - strtok() without an an internal state pointer */
 char *string_token(char *str, const char *tokset, char **ret_str);
 int in_string_list(char *str, char sep, char *string_list);
+void *string_list_idx_create(char *string_list, char sep);
+int in_string_list_idx(char *str, void *list_idx);
 
 int copy_file_internal(char *src, char *dst);
 
@@ -143,6 +145,11 @@ int get_num_occurrences(char *rrule, time_t dtstart, char *tz);
  */
 time_t get_occurrence(char *, time_t, char *, int);
 
+/* Get a run of consecutive occurrences starting at index idx.  The
+ * occurrences of a rule and start time are expanded once and kept.
+ */
+int get_occurrences(char *rrule, time_t dtstart, char *tz, int idx, int num, time_t *occrs);
+
 /*
  * Check if a recurrence rule is valid and consistent.
  * The recurrence rule is verified against a start date and checks
@@ -252,6 +259,8 @@ lock_file(int fd, int op, char *filename, int lock_retry,
 /* RSHD/RCP related */
 /* Size of the buffer used in communication with rshd deamon */
 #define RCP_BUFFER_SIZE 65536
+/* Size of the chunks pbs_rcp moves file data in */
+#define RCP_XFER_SIZE (1024 * 1024)
 
 #define MAXBUFLEN 1024
 #define BUFFER_GROWTH_RATE 2
@@ -204,6 +204,44 @@ extern void log_supported_auth_methods(char **supported_auth_methods);
 
 #define PBSEVENT_MASK 0x01ff
 
+/*
+ * Binary log journal, see ../lib/Liblog/log_journal.c
+ *
+ * When enabled, every record written to a daemon log is also appended to
+ * "<logfile>.jnl" as a length prefixed binary record, so tools need not
+ * parse the text log.  All integers are big endian.
+ *
+ *	file	: LOG_JOURNAL_MAGIC (8 bytes), then records
+ *	record	: u32 length of the rest of the record
+ *		  u64 time, microseconds since the epoch
+ *		  u32 event type, u16 object class, u16 severity
+ *		  u32 object name length, u32 text length
+ *		  object name bytes, text bytes (not NUL terminated)
+ */
+#define LOG_JOURNAL_MAGIC "PBSJRNL1"
+#define LOG_JOURNAL_MAGIC_LEN 8
+#define LOG_JOURNAL_SUFFIX ".jnl"
+#define LOG_JOURNAL_HDR_LEN 28
+
+typedef struct log_journal_rec {
+	long long lj_time; /* microseconds since the epoch */
+	int lj_eventtype;
+	int lj_objclass;
+	int lj_sev;
+	char *lj_objname;
+	char *lj_text;
+} log_journal_rec;
+
+extern void set_log_journal(int enable);
+extern int log_journal_enabled(void);
+extern int log_journal_open(const char *logname);
+extern void log_journal_close(void);
+extern void log_journal_write(long long rtime, int eventtype, int objclass, int sev, const char *objname, const char *text);
+extern int log_journal_read_header(FILE *fp);
+extern int log_journal_read(FILE *fp, log_journal_rec *rec);
+extern void log_journal_free_rec(log_journal_rec *rec);
+extern const char *log_class_name(int objclass);
+
 #ifdef __cplusplus
 }
 #endif
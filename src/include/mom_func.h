@@ -220,7 +220,7 @@ extern void calc_cpupercent(job *, unsigned long, unsigned long, time_t);
 extern void dorestrict_user(void);
 extern int task_save(pbs_task *ptask);
 extern void send_join_job_restart(int, eventent *, int, job *, pbs_list_head *);
-extern int send_resc_used_to_ms(int stream, job *pjob);
+extern int send_resc_used_to_ms(int stream, job *pjob, int changed_only);
 extern int recv_resc_used_from_sister(int stream, job *pjob, int nodeidx);
 extern int is_comm_up(int);
 
@@ -327,6 +327,9 @@ extern char *NAS_tmpdirname(job *);
 #endif /* localmod 010 */
 extern char *jobdirname(char *, char *);
 extern void rmtmpdir(char *);
+#ifndef WIN32
+extern int cleanup_worker_send(char *);
+#endif
 extern int local_or_remote(char **);
 extern void add_bad_list(char **, char *, int);
 extern int is_child_path(char *, char *);
@@ -386,8 +389,16 @@ extern int init_x11_display(struct pfwdsock *, int, char *, char *, char *);
 extern int setcurrentworkdir(char *);
 extern int becomeuser(job *);
 extern int becomeuser_args(char *, uid_t, gid_t, gid_t);
+extern int nss_cache_ttl;
+extern struct passwd *getpwnam_cached(const char *);
+extern struct group *getgrnam_cached(const char *);
+extern int getgroups_cached(const char *, gid_t, gid_t **);
+extern void nss_cache_flush(void);
 extern void close_update_pipes(job *);
 extern void mom_set_use_all(void);
+extern int job_sample_interval;
+extern void job_sample(job *, unsigned long, long, u_Long, u_Long);
+extern void job_sample_summary(job *);
 void job_purge_mom(job *pjob);
 
 /* From popen.c */
@@ -400,6 +411,7 @@ extern void start_walltime(job *);
 extern void update_walltime(job *);
 extern void stop_walltime(job *);
 extern void recover_walltime(job *);
+extern void walltime_arm(job *);
 
 /* Define for max xauth data*/
 #define X_DISPLAY_LEN 512
@@ -58,6 +58,9 @@ extern "C" {
 
 #define HOOK_RUNNING_IN_BACKGROUND (3)
 
+/* seconds after which exechost_periodic hooks resend unchanged resources */
+#define PERIODIC_VNL_REFRESH 600
+
 /* used to send hook's job delete/requeue request to server */
 struct hook_job_action {
 	pbs_list_link hja_link;
@@ -201,6 +204,7 @@ extern void attach_hook_requestor_merge_vnl(hook *phook, void *pnv, job *pjob);
 extern void new_job_action_req(job *pjob, enum hook_user huser, int action);
 extern void send_hook_fail_action(hook *);
 extern void vna_list_free(pbs_list_head);
+extern void periodic_vnl_forget(void);
 extern void mom_hook_input_init(mom_hook_input_t *hook_input);
 extern void mom_hook_output_init(mom_hook_output_t *hook_output);
 extern void send_hook_fail_action(hook *);
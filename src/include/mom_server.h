@@ -97,8 +97,29 @@ struct resc_used_update {
 	} while (0)
 #endif
 
+/*
+ * IS_RESCUSED and IS_RESCUSED_FROM_HOOK updates have no exit status, so
+ * ru_status carries the sequence number of the update for the job, with
+ * RUU_SEQ_FULL set when the update holds all of resources_used rather than
+ * only the resources that changed since the previous one.  Zero, as sent
+ * by older Moms, is a full update without a sequence number.
+ */
+#define RUU_SEQ_FULL 0x40000000
+#define RUU_SEQ_MASK 0x3fffffff
+#define RUU_FULL_REFRESH 10 /* every n-th update of a job is a full one */
+
+/*
+ * Obits may be held for up to $obit_batch_delay seconds so that the obits
+ * of jobs ending close together go to the server in one IS_JOBOBIT message.
+ * The limit stays well below the 45 seconds after which Mom resends an obit
+ * the server has not acknowledged.
+ */
+#define MAX_OBIT_BATCH_DELAY 30
+extern int obit_batch_delay;
+
 extern int job_obit(ruu *, int);
 extern int enqueue_update_for_send(job *, int);
+extern void forget_sent_resc_used(void);
 extern void send_resc_used(int cmd, int count, ruu *rud);
 extern void send_pending_updates(void);
 extern char mom_short_name[];
@@ -181,6 +181,7 @@ struct pbs_db_job_info {
 	INTEGER ji_credtype;		      /* credential type */
 	BIGINT ji_qrank;		      /* sort key for db query */
 	pbs_db_attr_list_t db_attr_list;      /* list of attributes for database */
+	pbs_db_attr_list_t db_attr_dirty_list; /* names of changed attributes, replaced whole */
 };
 typedef struct pbs_db_job_info pbs_db_job_info_t;
 
@@ -256,6 +257,10 @@ typedef struct pbs_db_query_options pbs_db_query_options_t;
 #define PBS_DB_CONNECT_STATE_CONNECTED 3
 #define PBS_DB_CONNECT_STATE_FAILED 4
 
+/* Transaction end actions */
+#define PBS_DB_COMMIT 0
+#define PBS_DB_ROLLBACK 1
+
 /* Database states */
 #define PBS_DB_DOWN 1
 #define PBS_DB_STARTING 2
@@ -329,6 +334,62 @@ int pbs_db_connect(void **conn, char *host, int port, int timeout);
  */
 int pbs_db_disconnect(void *conn);
 
+/**
+ * @brief
+ *	Start a transaction, so that the following statements on the
+ *	connection are committed together by pbs_db_end_trx
+ *
+ * @param[in]	conn - Connected database handle
+ *
+ * @return      int
+ * @retval      -1  - Failure
+ * @retval       0  - success
+ *
+ */
+int pbs_db_begin_trx(void *conn);
+
+/**
+ * @brief
+ *	End a transaction started by pbs_db_begin_trx
+ *
+ * @param[in]	conn - Connected database handle
+ * @param[in]	commit - PBS_DB_COMMIT or PBS_DB_ROLLBACK
+ *
+ * @return      int
+ * @retval      -1  - Failure
+ * @retval       0  - success
+ *
+ */
+int pbs_db_end_trx(void *conn, int commit);
+
+/**
+ * @brief
+ *	Queue the following save and delete statements on the connection,
+ *	instead of waiting for each to finish, until pbs_db_end_pipeline
+ *
+ * @param[in]	conn - Connected database handle
+ *
+ * @return      int
+ * @retval      -1  - Failure or not supported, statements run one by one
+ * @retval       0  - success
+ *
+ */
+int pbs_db_begin_pipeline(void *conn);
+
+/**
+ * @brief
+ *	Send the statements queued since pbs_db_begin_pipeline and wait
+ *	for all of them
+ *
+ * @param[in]	conn - Connected database handle
+ *
+ * @return      int
+ * @retval      -1  - Failure of any queued statement
+ * @retval       0  - success
+ *
+ */
+int pbs_db_end_pipeline(void *conn);
+
 /**
  * @brief
  *	Insert a new object into the database
@@ -481,6 +542,30 @@ void pbs_db_get_errmsg(int err_code, char **err_msg);
  */
 int pbs_db_password(void *conn, char *userid, char *password, char *olduser);
 
+/* kinds of database calls whose latency is recorded, see pbs_db_latency */
+enum pbs_db_op {
+	PBS_DB_OP_SAVE,
+	PBS_DB_OP_LOAD,
+	PBS_DB_OP_DELETE,
+	PBS_DB_OP_SEARCH,
+	PBS_DB_OP_COMMIT,
+	PBS_DB_OP_PIPELINE, /* sending a pipeline of queued statements */
+	PBS_DB_NUM_OPS
+};
+
+struct pbs_hist; /* see pbs_metrics.h */
+
+/**
+ * @brief
+ *	Latency histogram of one kind of database call
+ *
+ * @param[in]	op - the kind of call, one of enum pbs_db_op
+ *
+ * @return	histogram of the calls made so far, NULL for a bad op
+ *
+ */
+const struct pbs_hist *pbs_db_latency(int op);
+
 #ifdef __cplusplus
 }
 #endif
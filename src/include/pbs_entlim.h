@@ -58,6 +58,21 @@ enum lim_keytypes {
 	LIM_OVERALL
 };
 
+/*
+ * Structured form of a limit key, used for lookups on hot paths instead of
+ * building and parsing key strings.  entity and resc are ids handed out by
+ * entlim_name_id(); resc is ENTLIM_NO_ID for a run (count) limit.  The key
+ * string form remains the one used to add records and to encode/decode the
+ * limit attributes.
+ */
+typedef struct entlim_key {
+	int kt;
+	int entity;
+	int resc;
+} entlim_key_t;
+
+#define ENTLIM_NO_ID 0
+
 #define PBS_GENERIC_ENTITY "PBS_GENERIC"
 #define PBS_ALL_ENTITY "PBS_ALL"
 #define ETLIM_INVALIDCHAR "/[]\";:|<>+,?*"
@@ -84,6 +99,9 @@ void *entlim_initialize_ctx(void);
 /* get data record from an entry based on a key string */
 void *entlim_get(const char *keystr, void *ctx);
 
+/* get data record from an entry based on a structured key */
+void *entlim_get_key(const entlim_key_t *key, void *ctx);
+
 /* add a record including key and data, based on a key string */
 int entlim_add(const char *entity, const void *recptr, void *ctx);
 
@@ -109,6 +127,8 @@ char *entlim_mk_runkey(enum lim_keytypes kt, const char *entity);
 char *entlim_mk_reskey(enum lim_keytypes kt, const char *entity, const char *resc);
 int entlim_resc_from_key(char *key, char *rtnresc, size_t ln);
 int entlim_entity_from_key(char *key, char *rtnname, size_t ln);
+int entlim_name_id(const char *name, int create);
+int entlim_mk_key(entlim_key_t *key, enum lim_keytypes kt, const char *entity, const char *resc);
 
 #ifdef __cplusplus
 }
@@ -47,6 +47,7 @@ extern "C" {
 
 #define PBS_IDX_DUPS_OK 0x01   /* duplicate key allowed in index */
 #define PBS_IDX_ICASE_CMP 0x02 /* set case-insensitive compare */
+#define PBS_IDX_ORDERED 0x04   /* iterate in key order (avl tree backed) */
 
 #define PBS_IDX_RET_OK 0    /* index op succeed */
 #define PBS_IDX_RET_FAIL -1 /* index op failed */
@@ -166,6 +167,45 @@ extern void pbs_idx_free_ctx(void *ctx);
  */
 extern bool pbs_idx_is_empty(void *idx);
 
+/**
+ * @brief
+ *	Create a read-only, case-insensitive index over a fixed set of keys
+ *
+ * @param[in] - keys  - array of keys, NULL entries are skipped
+ * @param[in] - nkeys - number of entries in keys
+ *
+ * @return void *
+ * @retval !NULL - success
+ * @retval NULL  - failure
+ *
+ */
+extern void *pbs_idx_create_fixed(char **keys, int nkeys);
+
+/**
+ * @brief
+ *	Find a key in an index made by pbs_idx_create_fixed()
+ *
+ * @param[in] - idx - pointer to index
+ * @param[in] - key - key to look for
+ *
+ * @return int
+ * @retval >=0 - position of the key in the keys array
+ * @retval -1  - not found
+ *
+ */
+extern int pbs_idx_find_fixed(void *idx, const char *key);
+
+/**
+ * @brief
+ *	destroy an index made by pbs_idx_create_fixed()
+ *
+ * @param[in] - idx - pointer to index
+ *
+ * @return void
+ *
+ */
+extern void pbs_idx_destroy_fixed(void *idx);
+
 #ifdef __cplusplus
 }
 #endif
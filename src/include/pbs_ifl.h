@@ -197,6 +197,7 @@ extern "C" {
 #define ATTR_cred_validity "credential_validity"
 #define ATTR_history_timestamp "history_timestamp"
 #define ATTR_create_resv_from_job "create_resv_from_job"
+#define ATTR_startup_latency "startup_latency"
 /* Added for finished jobs RFE */
 #define ATTR_stageout_status "Stageout_status"
 #define ATTR_exit_status "Exit_status"
@@ -305,6 +306,7 @@ extern "C" {
 #define ATTR_license_max "pbs_license_max"
 #define ATTR_license_linger "pbs_license_linger_time"
 #define ATTR_license_count "license_count"
+#define ATTR_server_metrics "server_metrics"
 #define ATTR_job_sort_formula "job_sort_formula"
 #define ATTR_EligibleTimeEnable "eligible_time_enable"
 #define ATTR_resv_retry_time "reserve_retry_time"
@@ -362,6 +364,8 @@ extern "C" {
 #define ATTR_sched_preempt_sort "preempt_sort"
 #define ATTR_sched_server_dyn_res_alarm "server_dyn_res_alarm"
 #define ATTR_job_run_wait "job_run_wait"
+#define ATTR_sched_cycle_stats "sched_cycle_stats"
+#define ATTR_sched_min_cycle_interval "min_cycle_interval"
 
 /* additional node "attributes" names */
 
@@ -515,6 +519,22 @@ enum batch_op { SET,
 #define SUPPRESS_EMAIL "suppress_email"
 #define DELETEHISTORY "deletehist"
 
+/* actions pbs_selact() may apply to the jobs it selects */
+#define SELACT_DELETE 1
+#define SELACT_HOLD 2
+#define SELACT_RELEASE 3
+#define SELACT_ALTER 4
+
+/*
+ * node filter terms pbs_statvnode() may pass to the server via its extend
+ * parameter, separated by white space: "state=down,offline" selects the
+ * vnodes in any of the listed states, "resources_available.<r>=<value>"
+ * those with that resource value and "partition=<p>" those in partition p
+ * ("partition=" those in no partition)
+ */
+#define NODE_FILTER_STATE "state="
+#define NODE_FILTER_PARTITION "partition="
+
 /*
  ** This structure is identical to attropl so they can be used
  ** interchangably.  The op field is not used.
@@ -548,6 +568,18 @@ struct batch_deljob_status {
 	int code;
 };
 
+/* called by the streaming status calls with each object as it is decoded
+ * (an array job comes with its subjobs).  The callback owns the list and
+ * frees it with pbs_statfree().
+ */
+typedef void (*pbs_status_cb)(struct batch_status *bs, void *arg);
+
+/* called by pbs_selact() with each progress reply: the number of jobs
+ * acted on so far and the jobs the action failed on since the previous
+ * call.  The list is freed by pbs_selact() once the callback returns.
+ */
+typedef void (*pbs_selact_cb)(int acted, struct batch_deljob_status *failed, void *arg);
+
 /* structure to hold an attribute that failed verification at ECL
  * and the associated errcode and errmsg
  */
@@ -625,6 +657,8 @@ DECLDIR int pbs_asyrunjob(int, char *, char *, char *);
 
 DECLDIR int pbs_alterjob(int, char *, struct attrl *, char *);
 
+DECLDIR struct batch_deljob_status *pbs_alterjoblist(int, char **, struct attrl **, int, char *);
+
 DECLDIR int pbs_connect(char *);
 
 DECLDIR int pbs_connect_extend(char *, char *);
@@ -659,6 +693,8 @@ DECLDIR int pbs_rlsjob(int, char *, char *, char *);
 
 DECLDIR int pbs_runjob(int, char *, char *, char *);
 
+DECLDIR struct batch_deljob_status *pbs_runjoblist(int, char **, char **, int, char *);
+
 DECLDIR char **pbs_selectjob(int, struct attropl *, char *);
 
 DECLDIR int pbs_sigjob(int, char *, char *, char *);
@@ -671,6 +707,10 @@ DECLDIR struct batch_status *pbs_statjob(int, char *, struct attrl *, char *);
 
 DECLDIR struct batch_status *pbs_selstat(int, struct attropl *, struct attrl *, char *);
 
+DECLDIR int pbs_selstat_stream(int, struct attropl *, struct attrl *, char *, pbs_status_cb, void *);
+
+DECLDIR int pbs_selact(int, struct attropl *, int, struct attrl *, char *, pbs_selact_cb, void *);
+
 DECLDIR struct batch_status *pbs_statque(int, char *, struct attrl *, char *);
 
 DECLDIR struct batch_status *pbs_statserver(int, struct attrl *, char *);
@@ -683,6 +723,18 @@ DECLDIR struct batch_status *pbs_statnode(int, char *, struct attrl *, char *);
 
 DECLDIR struct batch_status *pbs_statvnode(int, char *, struct attrl *, char *);
 
+DECLDIR int pbs_statvnode_stream(int, char *, struct attrl *, char *, pbs_status_cb, void *);
+
+DECLDIR int pbs_stat_submit(int, int, char *, struct attrl *, char *);
+
+DECLDIR struct batch_status *pbs_stat_collect(int);
+
+DECLDIR struct batch_status *pbs_statsnapshot(int, time_t *);
+
+DECLDIR int pbs_subscribe(int, int, char *);
+
+DECLDIR struct batch_status *pbs_subscribe_next(int);
+
 DECLDIR struct batch_status *pbs_statresv(int, char *, struct attrl *, char *);
 
 DECLDIR struct batch_status *pbs_stathook(int, char *, struct attrl *, char *);
@@ -721,8 +773,12 @@ extern int pbs_asyrunjob_ack(int, const char *, const char *, const char *);
 
 extern int pbs_alterjob(int, const char *, struct attrl *, const char *);
 
+extern struct batch_deljob_status *pbs_alterjoblist(int, char **, struct attrl **, int, const char *);
+
 extern int pbs_asyalterjob(int c, const char *jobid, struct attrl *attrib, const char *extend);
 
+extern int pbs_asyalterjoblist(int, char **, struct attrl **, int, const char *);
+
 extern int pbs_confirmresv(int, const char *, const char *, unsigned long, const char *);
 
 extern int pbs_connect(const char *);
@@ -761,6 +817,8 @@ extern int pbs_rlsjob(int, const char *, const char *, const char *);
 
 extern int pbs_runjob(int, const char *, const char *, const char *);
 
+extern struct batch_deljob_status *pbs_runjoblist(int, char **, char **, int, const char *);
+
 extern char **pbs_selectjob(int, struct attropl *, const char *);
 
 extern int pbs_sigjob(int, const char *, const char *, const char *);
@@ -775,6 +833,10 @@ extern struct batch_status *pbs_statjob(int, const char *, struct attrl *, const
 
 extern struct batch_status *pbs_selstat(int, struct attropl *, struct attrl *, const char *);
 
+extern int pbs_selstat_stream(int, struct attropl *, struct attrl *, const char *, pbs_status_cb, void *);
+
+extern int pbs_selact(int, struct attropl *, int, struct attrl *, const char *, pbs_selact_cb, void *);
+
 extern struct batch_status *pbs_statque(int, const char *, struct attrl *, const char *);
 
 extern struct batch_status *pbs_statserver(int, struct attrl *, const char *);
@@ -787,6 +849,18 @@ extern struct batch_status *pbs_statnode(int, const char *, struct attrl *, cons
 
 extern struct batch_status *pbs_statvnode(int, const char *, struct attrl *, const char *);
 
+extern int pbs_statvnode_stream(int, const char *, struct attrl *, const char *, pbs_status_cb, void *);
+
+extern int pbs_stat_submit(int, int, const char *, struct attrl *, const char *);
+
+extern struct batch_status *pbs_stat_collect(int);
+
+extern struct batch_status *pbs_statsnapshot(int, time_t *);
+
+extern int pbs_subscribe(int, int, const char *);
+
+extern struct batch_status *pbs_subscribe_next(int);
+
 extern struct batch_status *pbs_statresv(int, const char *, struct attrl *, const char *);
 
 extern struct batch_status *pbs_stathook(int, const char *, struct attrl *, const char *);
@@ -243,6 +243,18 @@ struct pbs_config
 	char *pbs_mom_node_name;	/* mom short name used for natural node, default NULL */
 	unsigned int pbs_log_highres_timestamp; /* high resolution logging */
 	unsigned int pbs_sched_threads;	/* number of threads for scheduler */
+	unsigned int pbs_status_snapshot; /* seconds between server status snapshots, 0 for none */
+	unsigned int pbs_log_journal;	/* also write a binary journal of log records */
+	unsigned int pbs_mail_digest;	/* seconds the server holds mail to combine it per recipient, 0 for none */
+	unsigned int pbs_job_file_tpp_max; /* MB of a job file the server sends to mom over TPP, 0 for the default */
+	unsigned int pbs_dns_cache_ttl;	/* seconds a resolved host name is cached, 0 for none */
+	unsigned int pbs_dns_cache_neg_ttl; /* seconds a failed host name lookup is cached, 0 for none */
+	unsigned int pbs_dns_cache_stale; /* seconds an expired entry is still used while it is refreshed */
+	char *pbs_dns_cache_seed;	/* file of static host addresses, in /etc/hosts format */
+	unsigned int pbs_server_metrics; /* seconds between server metrics dumps, 0 for none */
+	unsigned int pbs_metrics_export; /* seconds between metrics endpoint snapshots, 0 for none */
+	unsigned int pbs_hook_executor; /* run server periodic hooks in a long-lived pbs_python */
+	unsigned int pbs_secondary_prewarm; /* seconds between standby cache warming passes, 0 for none */
 	char *pbs_daemon_service_user; /* user the scheduler runs as */
 	char *pbs_daemon_service_auth_user; /* auth user the scheduler runs as */
 	char *pbs_privileged_auth_user; /* auth user with admin access */
@@ -311,6 +323,18 @@ extern struct pbs_config pbs_conf;
 #define PBS_CONF_MOM_NODE_NAME	"PBS_MOM_NODE_NAME"
 #define PBS_CONF_LOG_HIGHRES_TIMESTAMP	"PBS_LOG_HIGHRES_TIMESTAMP"
 #define PBS_CONF_SCHED_THREADS	"PBS_SCHED_THREADS"
+#define PBS_CONF_STATUS_SNAPSHOT	"PBS_STATUS_SNAPSHOT"
+#define PBS_CONF_LOG_JOURNAL	"PBS_LOG_JOURNAL"
+#define PBS_CONF_MAIL_DIGEST	"PBS_MAIL_DIGEST"
+#define PBS_CONF_JOB_FILE_TPP_MAX	"PBS_JOB_FILE_TPP_MAX"
+#define PBS_CONF_DNS_CACHE_TTL	"PBS_DNS_CACHE_TTL"
+#define PBS_CONF_DNS_CACHE_NEG_TTL	"PBS_DNS_CACHE_NEG_TTL"
+#define PBS_CONF_DNS_CACHE_STALE	"PBS_DNS_CACHE_STALE"
+#define PBS_CONF_DNS_CACHE_SEED	"PBS_DNS_CACHE_SEED"
+#define PBS_CONF_SERVER_METRICS	"PBS_SERVER_METRICS"
+#define PBS_CONF_METRICS_EXPORT	"PBS_METRICS_EXPORT"
+#define PBS_CONF_HOOK_EXECUTOR	"PBS_HOOK_EXECUTOR"
+#define PBS_CONF_SECONDARY_PREWARM	"PBS_SECONDARY_PREWARM"
 #define PBS_CONF_DAEMON_SERVICE_USER "PBS_DAEMON_SERVICE_USER"
 #define PBS_CONF_DAEMON_SERVICE_AUTH_USER "PBS_DAEMON_SERVICE_AUTH_USER"
 #define PBS_CONF_PRIVILEGED_AUTH_USER "PBS_PRIVILEGED_AUTH_USER" /* e.g.: used for gss/krb and krb host principal (host/<fqdn>@<REALM>) is expected */
@@ -546,12 +570,17 @@ extern struct batch_status *bs_isort(struct batch_status *bs,
 	int (*cmp_func)(struct batch_status*, struct batch_status *));
 extern struct batch_status *bs_find(struct batch_status *, const char *);
 extern void init_bstat(struct batch_status *);
+extern int set_bs_attr_value(struct batch_status *, struct attrl *, const char *);
+struct in_addr;
+extern int pbs_dns_lookup(const char *, struct in_addr **, int *);
 
 /* IFL function pointers */
 extern int (*pfn_pbs_asyrunjob)(int, const char *, const char *, const char *);
 extern int (*pfn_pbs_asyrunjob_ack)(int, const char *, const char *, const char *);
 extern int (*pfn_pbs_alterjob)(int, const char *, struct attrl *, const char *);
+extern struct batch_deljob_status *(*pfn_pbs_alterjoblist)(int, char **, struct attrl **, int, const char *);
 extern int (*pfn_pbs_asyalterjob)(int, const char *, struct attrl *, const char *);
+extern int (*pfn_pbs_asyalterjoblist)(int, char **, struct attrl **, int, const char *);
 extern int (*pfn_pbs_confirmresv)(int, const char *, const char *, unsigned long, const char *);
 extern int (*pfn_pbs_connect)(const char *);
 extern int (*pfn_pbs_connect_extend)(const char *, const char *);
@@ -570,6 +599,7 @@ extern int (*pfn_pbs_orderjob)(int, const char *, const char *, const char *);
 extern int (*pfn_pbs_rerunjob)(int, const char *, const char *);
 extern int (*pfn_pbs_rlsjob)(int, const char *, const char *, const char *);
 extern int (*pfn_pbs_runjob)(int, const char *, const char *, const char *);
+extern struct batch_deljob_status *(*pfn_pbs_runjoblist)(int, char **, char **, int, const char *);
 extern char **(*pfn_pbs_selectjob)(int, struct attropl *, const char *);
 extern int (*pfn_pbs_sigjob)(int, const char *, const char *, const char *);
 extern void (*pfn_pbs_statfree)(struct batch_status *);
@@ -577,12 +607,20 @@ extern void (*pfn_pbs_delstatfree)(struct batch_deljob_status *);
 extern struct batch_status *(*pfn_pbs_statrsc)(int, const char *, struct attrl *, const char *);
 extern struct batch_status *(*pfn_pbs_statjob)(int, const char *, struct attrl *, const char *);
 extern struct batch_status *(*pfn_pbs_selstat)(int, struct attropl *, struct attrl *, const char *);
+extern int (*pfn_pbs_selstat_stream)(int, struct attropl *, struct attrl *, const char *, pbs_status_cb, void *);
+extern int (*pfn_pbs_selact)(int, struct attropl *, int, struct attrl *, const char *, pbs_selact_cb, void *);
 extern struct batch_status *(*pfn_pbs_statque)(int, const char *, struct attrl *, const char *);
 extern struct batch_status *(*pfn_pbs_statserver)(int, struct attrl *, const char *);
 extern struct batch_status *(*pfn_pbs_statsched)(int, struct attrl *, const char *);
 extern struct batch_status *(*pfn_pbs_stathost)(int, const char *, struct attrl *, const char *);
 extern struct batch_status *(*pfn_pbs_statnode)(int, const char *, struct attrl *, const char *);
 extern struct batch_status *(*pfn_pbs_statvnode)(int, const char *, struct attrl *, const char *);
+extern int (*pfn_pbs_statvnode_stream)(int, const char *, struct attrl *, const char *, pbs_status_cb, void *);
+extern int (*pfn_pbs_stat_submit)(int, int, const char *, struct attrl *, const char *);
+extern struct batch_status *(*pfn_pbs_stat_collect)(int);
+extern struct batch_status *(*pfn_pbs_statsnapshot)(int, time_t *);
+extern int (*pfn_pbs_subscribe)(int, int, const char *);
+extern struct batch_status *(*pfn_pbs_subscribe_next)(int);
 extern struct batch_status *(*pfn_pbs_statresv)(int, const char *, struct attrl *, const char *);
 extern struct batch_status *(*pfn_pbs_stathook)(int, const char *, struct attrl *, const char *);
 extern struct ecl_attribute_errors * (*pfn_pbs_get_attributes_in_error)(int);
@@ -59,6 +59,60 @@ int pbs_json_insert_parsed(json_data *parent, char *key, char *value, int ignore
 int pbs_json_print(json_data *data, FILE *stream);
 void pbs_json_delete(json_data *data);
 
+#define PBS_JSON_MAX_DEPTH 64
+
+/*
+ * Streaming writer: values are printed as they are added, in the same
+ * layout as pbs_json_print(), without building a json_data tree first.
+ */
+typedef struct pbs_json_writer {
+	FILE *jw_stream;
+	int jw_depth;				    /* number of open objects and arrays */
+	char jw_type[PBS_JSON_MAX_DEPTH + 1];  /* '{' or '[' for each open level */
+	char jw_items[PBS_JSON_MAX_DEPTH + 1]; /* whether a level has members yet */
+} pbs_json_writer;
+
+void pbs_json_writer_init(pbs_json_writer *jw, FILE *stream);
+int pbs_json_write_begin_object(pbs_json_writer *jw, char *key);
+int pbs_json_write_begin_array(pbs_json_writer *jw, char *key);
+int pbs_json_write_end(pbs_json_writer *jw);
+int pbs_json_write_string(pbs_json_writer *jw, char *key, char *value);
+int pbs_json_write_number(pbs_json_writer *jw, char *key, double value);
+int pbs_json_write_parsed(pbs_json_writer *jw, char *key, char *value, int ignore_empty);
+
+/*
+ * Pull parser: returns the tokens of a json text one at a time, straight
+ * from the text, without allocating.
+ */
+enum pbs_json_token {
+	PBS_JSON_ERROR = -1,
+	PBS_JSON_DONE,
+	PBS_JSON_BEGIN_OBJECT,
+	PBS_JSON_END_OBJECT,
+	PBS_JSON_BEGIN_ARRAY,
+	PBS_JSON_END_ARRAY,
+	PBS_JSON_KEY,
+	PBS_JSON_STRING,
+	PBS_JSON_NUMBER,
+	PBS_JSON_TRUE,
+	PBS_JSON_FALSE,
+	PBS_JSON_NULL
+};
+
+typedef struct pbs_json_parser {
+	const char *jp_next;		      /* where the next token starts */
+	const char *jp_text;		      /* KEY, STRING: still escaped contents */
+	size_t jp_len;			      /* length of jp_text */
+	double jp_number;		      /* NUMBER: its value */
+	int jp_depth;			      /* number of open objects and arrays */
+	int jp_expect;			      /* what the grammar allows next */
+	char jp_stack[PBS_JSON_MAX_DEPTH + 1]; /* '{' or '[' for each open level */
+} pbs_json_parser;
+
+void pbs_json_parser_init(pbs_json_parser *jp, char *text);
+int pbs_json_next(pbs_json_parser *jp);
+int pbs_json_get_string(pbs_json_parser *jp, char *buf, size_t len);
+
 #ifdef __cplusplus
 }
 #endif
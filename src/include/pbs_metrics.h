@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+
+#ifndef _PBS_METRICS_H
+#define _PBS_METRICS_H
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <time.h>
+
+/*
+ * Latency histogram with power of two buckets in microseconds: bucket i
+ * counts samples of i significant bits, i.e. [2^(i-1), 2^i) us, bucket 0
+ * counts samples under a microsecond and the last bucket everything from
+ * about a minute up.  Adding a sample is a handful of instructions, so
+ * the histograms can be kept always on.
+ */
+#define PBS_HIST_NBUCKETS 28
+
+typedef struct pbs_hist {
+	unsigned long count;			 /* number of samples */
+	unsigned long long sum_us;		 /* sum of the samples */
+	unsigned long long max_us;		 /* largest sample */
+	unsigned long bucket[PBS_HIST_NBUCKETS]; /* samples per bucket */
+} pbs_hist_t;
+
+/**
+ * @brief
+ *	Read the monotonic clock in microseconds
+ */
+static inline unsigned long long
+pbs_metrics_now_us(void)
+{
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+		return 0;
+	return ((unsigned long long) ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000);
+}
+
+/**
+ * @brief
+ *	Add a sample to a histogram
+ *
+ * @param[in,out]	h	- the histogram
+ * @param[in]		us	- the sample in microseconds
+ */
+static inline void
+pbs_hist_add(pbs_hist_t *h, unsigned long long us)
+{
+	int i;
+
+	i = (us == 0) ? 0 : 64 - __builtin_clzll(us);
+	if (i >= PBS_HIST_NBUCKETS)
+		i = PBS_HIST_NBUCKETS - 1;
+	h->bucket[i]++;
+	h->count++;
+	h->sum_us += us;
+	if (us > h->max_us)
+		h->max_us = us;
+}
+
+/**
+ * @brief
+ *	Add the time since 'start' (from pbs_metrics_now_us()) to a histogram
+ */
+static inline void
+pbs_hist_since(pbs_hist_t *h, unsigned long long start)
+{
+	unsigned long long now = pbs_metrics_now_us();
+
+	pbs_hist_add(h, (now > start) ? now - start : 0);
+}
+
+extern unsigned long long pbs_hist_quantile(const pbs_hist_t *h, double q);
+extern void pbs_hist_merge(pbs_hist_t *to, const pbs_hist_t *from);
+extern int pbs_hist_print_json(FILE *fp, const pbs_hist_t *h);
+extern int pbs_hist_summary(char *buf, size_t len, const pbs_hist_t *h);
+extern int pbs_hist_print_prom(FILE *fp, const char *name, const char *labels, const pbs_hist_t *h);
+
+/* read-only metrics endpoint served by a thread from published snapshots */
+extern int pbs_metrics_export_start(const char *path);
+extern void pbs_metrics_export_publish(char *text);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* _PBS_METRICS_H */
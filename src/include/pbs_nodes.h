@@ -241,6 +241,7 @@ struct pbsnode {
 	int nd_arr_index;	/* index of myself in the svr node array, only in mem, not db */
 	char *nd_hostname;	/* ptr to hostname */
 	struct pbssubn *nd_psn; /* ptr to list of virt cpus */
+	struct pbssubn *nd_psn_next; /* virt cpus before it are in use, only while recovering jobs */
 	struct resvinfo *nd_resvp;
 	long nd_nsn;			 /* number of VPs  */
 	long nd_nsnfree;		 /* number of VPs free */
@@ -84,6 +84,12 @@ extern "C" {
  */
 
 #define PBS_PYTHON_PROGRAM "pbs_python"
+
+/*
+ * A script assigning a callable to this global is persistent: its globals
+ * are kept after the first run and later runs only call the handler.
+ */
+#define PBS_PYTHON_HOOK_HANDLER "pbs_hook_handler"
 struct python_interpreter_data {
 	int data_initialized;			   /* data initialized */
 	int interp_started;			   /* status flag*/
@@ -103,6 +109,10 @@ struct python_script {
 	void *global_dict;    /* this is the globals() dictionary
 					      * type is PyObject *
 					      */
+	void *py_handler;     /* handler of a persistent script, see
+					      * PBS_PYTHON_HOOK_HANDLER
+					      * type is PyObject *
+					      */
 	struct stat cur_sbuf; /* last modification time */
 };
 
@@ -429,6 +439,7 @@ extern void pbs_python_clear_attributes();
 #define EVENT_VNODELIST_OBJECT EVENT_OBJECT ".vnode_list"
 #define EVENT_VNODELIST_FAIL_OBJECT EVENT_OBJECT ".vnode_list_fail"
 #define EVENT_JOBLIST_OBJECT EVENT_OBJECT ".job_list"
+#define EVENT_RESVLIST_OBJECT EVENT_OBJECT ".resv_list"
 #define EVENT_AOE_OBJECT EVENT_OBJECT ".aoe"
 #define EVENT_ACCEPT_OBJECT EVENT_OBJECT ".accept"
 #define EVENT_REJECT_OBJECT EVENT_OBJECT ".reject"
@@ -93,6 +93,9 @@ typedef struct pbs_sched {
 	char sc_name[PBS_MAXSCHEDNAME + 1];			      /* name of sched this sched */
 	struct preempt_ordering preempt_order[PREEMPT_ORDER_MAX + 1]; /* preempt order for this sched */
 	int sc_cycle_started;					      /* indicates whether sched cycle is started or not, 0 - not started, 1 - started */
+	time_t sc_cycle_start;					      /* time the last cycle was started */
+	time_t sc_cycle_end;					      /* time the last cycle ended */
+	int sc_triggers;					      /* triggers coalesced into the next cycle */
 	attribute sch_attr[SCHED_ATR_LAST];			      /* sched object's attributes  */
 	short newobj;						      /* is this new sched obj? */
 } pbs_sched;
@@ -108,6 +111,7 @@ extern int validate_job_formula(attribute *pattr, void *pobject, int actmode);
 extern pbs_sched *find_sched_from_partition(char *partition);
 extern int recv_sched_cycle_end(int sock);
 extern void handle_deferred_cycle_close();
+extern time_t sched_cycle_allowed_at(pbs_sched *psched);
 
 attribute *get_sched_attr(const pbs_sched *psched, int attr_idx);
 char *get_sched_attr_str(const pbs_sched *psched, int attr_idx);
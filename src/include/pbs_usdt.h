@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+
+#ifndef _PBS_USDT_H
+#define _PBS_USDT_H
+
+/*
+ * User level statically defined tracing (USDT) probes for SystemTap,
+ * bpftrace and perf, provider "pbs".  When <sys/sdt.h> is available each
+ * probe compiles to a single nop plus an ELF note, so they are always
+ * built in and cost nothing until a tracer attaches; otherwise they
+ * compile away, still evaluating their arguments so that variables kept
+ * only for a probe do not draw unused warnings.  Arguments must therefore
+ * be free of side effects.  A double underscore in a probe name shows up as a dash,
+ * e.g. PBS_PROBE1(job__eval__start, ...) is usdt:pbs:job-eval-start.
+ *
+ * Probes pair up as <what>__start/<what>__done so that latencies can be
+ * taken with a simple bpftrace script, e.g.
+ *
+ *	bpftrace -e 'usdt:pbs_server:pbs:dispatch__start { @s[tid] = nsecs; }
+ *		usdt:pbs_server:pbs:dispatch__done /@s[tid]/ {
+ *			@us[arg0] = hist((nsecs - @s[tid]) / 1000); delete(@s[tid]); }'
+ */
+#ifdef HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+#define PBS_PROBE(name) DTRACE_PROBE(pbs, name)
+#define PBS_PROBE1(name, a1) DTRACE_PROBE1(pbs, name, a1)
+#define PBS_PROBE2(name, a1, a2) DTRACE_PROBE2(pbs, name, a1, a2)
+#define PBS_PROBE3(name, a1, a2, a3) DTRACE_PROBE3(pbs, name, a1, a2, a3)
+#define PBS_PROBE4(name, a1, a2, a3, a4) DTRACE_PROBE4(pbs, name, a1, a2, a3, a4)
+#else
+#define PBS_PROBE(name) \
+	do {            \
+	} while (0)
+#define PBS_PROBE1(name, a1) \
+	do {                 \
+		(void) (a1); \
+	} while (0)
+#define PBS_PROBE2(name, a1, a2) \
+	do {                     \
+		(void) (a1);     \
+		(void) (a2);     \
+	} while (0)
+#define PBS_PROBE3(name, a1, a2, a3) \
+	do {                         \
+		(void) (a1);         \
+		(void) (a2);         \
+		(void) (a3);         \
+	} while (0)
+#define PBS_PROBE4(name, a1, a2, a3, a4) \
+	do {                             \
+		(void) (a1);             \
+		(void) (a2);             \
+		(void) (a3);             \
+		(void) (a4);             \
+	} while (0)
+#endif
+
+#endif /* _PBS_USDT_H */
@@ -45,7 +45,7 @@ extern "C" {
 
 /*Defines used by port_forwarding.c*/
 /* Max size of buffer to store data*/
-#define PF_BUF_SIZE 8192
+#define PF_BUF_SIZE 65536
 
 /* Limits the number of simultaneous X applications that a single job
  can run in the background to 24 . 1 socket fd is used for storing
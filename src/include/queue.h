@@ -85,6 +85,7 @@ struct pbs_queue {
 
 	int qu_numjobs;			 /* current numb jobs in queue */
 	int qu_njstate[PBS_NUMJOBSTATE]; /* # of jobs per state */
+	time_t qu_route_next;		 /* route queue: no job can be routed before, 0 to look now */
 
 	/* the queue attributes */
 
@@ -65,6 +65,25 @@ typedef struct range {
 
 #define INIT_RANGE_ARR_SIZE 2048
 
+/*
+ * A set of indices drawn from a fixed x-y:z domain (e.g. the subjob indices
+ * of one array job).  Membership is kept as one bit per domain index so
+ * add/remove/contains are O(1) regardless of how fragmented the set is; the
+ * string form is rebuilt from the bitmap runs only when it is asked for
+ * after a change.
+ */
+typedef struct range_set {
+	int start;	     /* first index of the domain */
+	int end;	     /* last index of the domain */
+	int step;	     /* stride between domain indices */
+	int nslots;	     /* number of indices in the domain */
+	int count;	     /* number of indices in the set */
+	unsigned long *bits; /* one bit per domain index */
+	char *str;	     /* cached string form of the set */
+	int str_size;	     /* allocated size of str */
+	int str_stale;	     /* str no longer matches bits */
+} range_set;
+
 /*
  *	new_range - allocate and initialize a range structure
  */
@@ -154,6 +173,51 @@ char *range_to_str(range *r);
 
 range * range_join(range *r1, range *r2);
 
+/*
+ *	new_range_set - allocate an empty set over the domain start-end:step
+ */
+range_set *new_range_set(int start, int end, int step);
+
+/*
+ *	free_range_set - free a range set
+ */
+void free_range_set(range_set *rs);
+
+/*
+ *	range_set_fill - add every index of the domain to the set
+ */
+void range_set_fill(range_set *rs);
+
+/*
+ *	range_set_add_list - add every value of a range list to the set
+ */
+int range_set_add_list(range_set *rs, range *r);
+
+/*
+ *	range_set_contains - find if a set contains a value
+ */
+int range_set_contains(range_set *rs, int val);
+
+/*
+ *	range_set_add_value - add a value to a set
+ */
+int range_set_add_value(range_set *rs, int val);
+
+/*
+ *	range_set_remove_value - remove a value from a set
+ */
+int range_set_remove_value(range_set *rs, int val);
+
+/*
+ *	range_set_count - number of values in a set
+ */
+int range_set_count(range_set *rs);
+
+/*
+ * Return a string representation of a range set, in range_to_str() form
+ */
+char *range_set_to_str(range_set *rs);
+
 #ifdef __cplusplus
 }
 #endif
@@ -47,6 +47,7 @@ extern "C" {
  * misc server function prototypes
  */
 
+#include <stdio.h>
 #include "net_connect.h"
 #include "pbs_db.h"
 #include "reservation.h"
@@ -136,6 +137,16 @@ extern int compare_obj_hash(void *, int, void *);
 extern void panic_stop_db();
 extern void free_db_attr_list(pbs_db_attr_list_t *);
 extern bool delete_pending_arrayjobs(struct batch_request *);
+extern void svr_metrics_request(int, unsigned long long);
+extern void svr_metrics_request_done(int, unsigned long long);
+extern void svr_metrics_is(int, unsigned long long);
+extern void svr_metrics_loop(unsigned long long);
+extern void svr_metrics_tasks(unsigned long long);
+extern void update_server_metrics(void);
+extern void svr_mem_summary(char *, size_t);
+extern void svr_mem_print_json(FILE *);
+extern void svr_mem_print_prom(FILE *);
+extern int server_memory_dump(void);
 
 #ifdef _PROVISION_H
 extern int find_prov_vnode_list(job *, exec_vnode_listtype *, char **);
@@ -181,6 +192,8 @@ extern job *create_subjob(job *, char *, int *);
 extern job *find_arrayparent(char *);
 extern job *get_subjob_and_state(job *, int, char *, int *);
 extern void update_sj_parent(job *, job *, char *, char, char);
+extern void record_sj_final(job *, job *);
+extern void free_ajinfo(ajinfo_t *);
 extern void update_subjob_state_ct(job *);
 extern char *subst_array_index(job *, char *);
 #ifndef PBS_MOM
@@ -220,6 +233,11 @@ extern int recreate_exec_vnode(job *, char *, char *, char *, int);
 extern int send_job_exec_update_to_mom(job *, char *, int, struct batch_request *);
 extern int free_sister_vnodes(job *, char *, char *, char *, int, struct batch_request *);
 extern void indirect_target_check(struct work_task *);
+extern void status_snapshot(struct work_task *);
+extern void server_metrics_dump(struct work_task *);
+extern void server_metrics_export(struct work_task *);
+extern void subscribe_notify_job(job *);
+extern void subscribe_notify_node(struct pbsnode *);
 extern void primary_handshake(struct work_task *);
 extern void secondary_handshake(struct work_task *);
 #endif /* _WORK_TASK_H */
@@ -247,6 +265,7 @@ extern void req_messagejob(struct batch_request *);
 extern void req_py_spawn(struct batch_request *);
 extern void req_relnodesjob(struct batch_request *);
 extern void req_modifyjob(struct batch_request *);
+extern void req_modifyjoblist(struct batch_request *);
 extern void req_modifyReservation(struct batch_request *);
 extern void req_orderjob(struct batch_request *);
 extern void req_rescreserve(struct batch_request *);
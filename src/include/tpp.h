@@ -130,6 +130,8 @@ extern int tpp_close(int);
 extern int tpp_eom(int);
 extern int tpp_bind(unsigned int);
 extern int tpp_poll(void);
+extern int tpp_app_backlog(void);
+extern int tpp_transport_backlog(void);
 extern void tpp_terminate(void);
 extern void tpp_shutdown(void);
 extern struct sockaddr_in *tpp_getaddr(int);
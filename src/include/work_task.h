@@ -70,6 +70,8 @@ enum work_type {
 	                        */
 };
 
+struct pbs_hist; /* see pbs_metrics.h */
+
 enum wtask_delete_option {
 	DELETE_ONE,
 	DELETE_ALL
@@ -79,6 +81,7 @@ struct work_task {
 	pbs_list_link wt_linkevent;	     /* link to event type work list */
 	pbs_list_link wt_linkobj;	     /* link to others of same object */
 	pbs_list_link wt_linkobj2;	     /* link to another set of similarity */
+	pbs_list_link wt_linkparm;	     /* link to tasks hashed on the same wt_parm1 */
 	long wt_event;			     /* event id: time, pid, socket, ... */
 	char *wt_event2;		     /* if replies on the same handle, then additional distinction */
 	enum work_type wt_type;		     /* type of event */
@@ -88,6 +91,7 @@ struct work_task {
 	void *wt_parm3;			     /* used to store reply for deferred cmds TPP */
 	int wt_aux;			     /* optional info: e.g. child status */
 	int wt_aux2;			     /* optional info 2: e.g. *real* child pid (windows), tpp msgid etc */
+	enum work_type wt_list;		     /* task list kind it was put on, WORK_Deferred_Other is task_list_event */
 };
 
 extern struct work_task *set_task(enum work_type, long event, void (*func)(), void *param);
@@ -99,6 +103,8 @@ extern void delete_task_by_parm1_func(void *parm1, void (*func)(struct work_task
 extern int has_task_by_parm1(void *parm1);
 extern time_t default_next_task(void);
 extern struct work_task *find_work_task(enum work_type, void *, void *);
+extern long work_task_backlog(void);
+extern const struct pbs_hist *work_task_lag(void);
 
 #ifdef __cplusplus
 }
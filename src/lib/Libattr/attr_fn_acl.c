@@ -41,6 +41,7 @@
 
 #include <assert.h>
 #include <ctype.h>
+#include <limits.h>
 #include <memory.h>
 #ifndef NDEBUG
 #include <stdio.h>
@@ -55,6 +56,7 @@
 #include "list_link.h"
 #include "attribute.h"
 #include "pbs_error.h"
+#include "pbs_idx.h"
 
 /**
  * @file	attr_fn_acl.c
@@ -179,6 +181,310 @@ set_hostacl(attribute *attr, attribute *new, enum batch_op op)
 	return (set_allacl(attr, new, op, host_order));
 }
 
+/*
+ * Lists with at least this many entries get a lookup index the first time
+ * they are checked, shorter ones are searched in order.
+ */
+#define ACL_INDEX_MIN 16
+
+/**
+ * @brief
+ *	Lookup index over the entries of an ACL.  acl_check() returns the
+ *	verdict of the first entry which matches, so every key maps to the
+ *	position (+ 1) of the first entry it came from.
+ */
+struct acl_index {
+	int ai_type;	 /* ACL_* type the index was built for */
+	void *ai_exact;	 /* entries matched in full */
+	void *ai_wild;	 /* host wildcards "*suffix", keyed by the suffix */
+	int *ai_other;	 /* positions of entries only the match function can check */
+	int ai_nother;	 /* number of entries in ai_other */
+	int ai_default;	 /* value set by the last "+" or "-" entry, -1 if none */
+};
+
+/**
+ * @brief
+ *	free_acl_index - free the lookup index of an ACL.  Called whenever
+ *	the list changes, the index is rebuilt by the next acl_check().
+ *
+ * @param[in] pas - the ACL's array of strings
+ *
+ * @return void
+ */
+void
+free_acl_index(struct array_strings *pas)
+{
+	struct acl_index *ai;
+
+	if (pas == NULL || (ai = pas->as_acl) == NULL)
+		return;
+	if (ai->ai_exact != NULL)
+		pbs_idx_destroy(ai->ai_exact);
+	if (ai->ai_wild != NULL)
+		pbs_idx_destroy(ai->ai_wild);
+	free(ai->ai_other);
+	free(ai);
+	pas->as_acl = NULL;
+}
+
+/**
+ * @brief
+ *	lower case the host part of a key, host names compare without case
+ *
+ * @param[in,out] key - key to change
+ * @param[in] type - type of acl
+ *
+ * @return void
+ */
+static void
+acl_key_lower(char *key, int type)
+{
+	if (type == ACL_User) {
+		if ((key = strchr(key, '@')) == NULL)
+			return;
+	} else if (type != ACL_Host)
+		return;
+	for (; *key != '\0'; key++)
+		*key = tolower((int) *key);
+}
+
+/**
+ * @brief
+ *	add one entry to the index, an earlier entry with the same key wins
+ *
+ * @param[in] idx - pbs_idx to add to
+ * @param[in] key - key of the entry, changed in place
+ * @param[in] type - type of acl
+ * @param[in] pos - position of the entry in the list
+ *
+ * @return int
+ * @retval 0	success
+ * @retval -1	out of memory
+ */
+static int
+acl_index_add(void *idx, char *key, int type, int pos)
+{
+	void *data = NULL;
+	void *k = key;
+
+	acl_key_lower(key, type);
+	if (pbs_idx_find(idx, &k, &data, NULL) == PBS_IDX_RET_OK)
+		return 0;
+	if (pbs_idx_insert(idx, key, (void *) (long) (pos + 1)) != PBS_IDX_RET_OK)
+		return -1;
+	return 0;
+}
+
+/**
+ * @brief
+ *	build the lookup index of an ACL.
+ *	Host entries are exact names or "*" followed by a suffix.  User
+ *	entries are a user name, optionally followed by "@" and a host
+ *	entry.  Group entries are group names.  Anything which does not fit
+ *	these forms is left to the match function.
+ *
+ * @param[in] pas - the ACL's array of strings
+ * @param[in] type - type of acl
+ *
+ * @return struct acl_index *
+ * @retval NULL	out of memory
+ */
+static struct acl_index *
+acl_index_build(struct array_strings *pas, int type)
+{
+	struct acl_index *ai;
+	char *key;
+	char *at;
+	char *pstr;
+	int rc;
+	int i;
+
+	if ((ai = calloc(1, sizeof(struct acl_index))) == NULL)
+		return NULL;
+	pfn_free_acl_index = free_acl_index; /* so attr_fn_arst.c can drop it */
+	ai->ai_type = type;
+	ai->ai_default = -1;
+	ai->ai_exact = pbs_idx_create(0, 0);
+	ai->ai_wild = pbs_idx_create(0, 0);
+	ai->ai_other = malloc(pas->as_usedptr * sizeof(int));
+	if (ai->ai_exact == NULL || ai->ai_wild == NULL || ai->ai_other == NULL)
+		goto err;
+
+	for (i = 0; i < pas->as_usedptr; i++) {
+		pstr = pas->as_string[i];
+		if ((*pstr == '+') || (*pstr == '-')) {
+			if (*(pstr + 1) == '\0') {
+				ai->ai_default = (*pstr == '+');
+				continue;
+			}
+			pstr++;
+		}
+		if (*pstr == '\0')
+			continue; /* never matches a name */
+
+		if ((key = strdup(pstr)) == NULL)
+			goto err;
+		at = strchr(key, '@');
+		rc = 0;
+		if (type == ACL_Host && *key == '*')
+			rc = acl_index_add(ai->ai_wild, key + 1, type, i);
+		else if (type == ACL_User && at != NULL && *(at + 1) == '*' && at != key) {
+			/* key the wildcard by "user@suffix" */
+			memmove(at + 1, at + 2, strlen(at + 2) + 1);
+			rc = acl_index_add(ai->ai_wild, key, type, i);
+		} else if (type != ACL_User || at != key)
+			rc = acl_index_add(ai->ai_exact, key, type, i);
+		else
+			ai->ai_other[ai->ai_nother++] = i;
+		free(key);
+		if (rc != 0)
+			goto err;
+	}
+	return ai;
+
+err:
+	pas->as_acl = ai;
+	free_acl_index(pas);
+	return NULL;
+}
+
+/**
+ * @brief
+ *	find the first entry matching a key
+ *
+ * @param[in] idx - pbs_idx to search
+ * @param[in] key - key to look for
+ * @param[in,out] best - position of the first match so far
+ *
+ * @return void
+ */
+static void
+acl_index_find(void *idx, char *key, int *best)
+{
+	void *data = NULL;
+	void *k = key;
+
+	if (pbs_idx_find(idx, &k, &data, NULL) == PBS_IDX_RET_OK && (long) data - 1 < *best)
+		*best = (int) ((long) data - 1);
+}
+
+/**
+ * @brief
+ *	find the first entry of a host or user acl which wildcards the host
+ *	in key.  A "*" stands for at least one character, so every proper
+ *	suffix of the host is a candidate.
+ *
+ * @param[in] ai - the index
+ * @param[in] key - lower cased name, user@host for a user acl
+ * @param[in] host - the host part of key
+ * @param[in,out] best - position of the first match so far
+ *
+ * @return void
+ */
+static void
+acl_index_find_wild(struct acl_index *ai, char *key, char *host, int *best)
+{
+	char buf[PBS_MAXUSER + PBS_MAXHOSTNAME + 2];
+	size_t ulen = host - key;
+	char *suffix;
+
+	memcpy(buf, key, ulen);
+	for (suffix = host + 1; suffix <= host + strlen(host); suffix++) {
+		strcpy(buf + ulen, suffix);
+		acl_index_find(ai->ai_wild, buf, best);
+	}
+}
+
+/**
+ * @brief
+ *	acl_index_check - acl_check() for long lists, using the list's index
+ *
+ * @param[in] pas - the ACL's array of strings
+ * @param[in] name - acl name to be checked
+ * @param[in] type - type of acl
+ * @param[in] default_rtn - value returned if no entry matches
+ * @param[in] match_func - match function of the acl type
+ *
+ * @return	int
+ * @retval	1	if access allowed
+ * @retval	0	if not allowed
+ * @retval	-1	if the index can't answer, search the list instead
+ */
+static int
+acl_index_check(struct array_strings *pas, char *name, int type, int default_rtn,
+		int (*match_func)(const char *name, const char *master))
+{
+	char key[PBS_MAXUSER + PBS_MAXHOSTNAME + 2];
+	struct acl_index *ai = pas->as_acl;
+	char *host = key;
+	int best = INT_MAX;
+	int i;
+
+	if (*name == '\0' || strlen(name) >= sizeof(key))
+		return -1;
+	strcpy(key, name);
+
+	if (ai != NULL && ai->ai_type != type)
+		free_acl_index(pas);
+	if (pas->as_acl == NULL && (pas->as_acl = acl_index_build(pas, type)) == NULL)
+		return -1;
+	ai = pas->as_acl;
+
+	if (type == ACL_User) {
+		if ((host = strchr(key, '@')) != NULL) {
+			if (*(host + 1) == '\0')
+				return -1;
+			acl_key_lower(key, type);
+			acl_index_find(ai->ai_exact, key, &best);
+			acl_index_find_wild(ai, key, host + 1, &best);
+			*host = '\0'; /* entries without a host match any host */
+		}
+		acl_index_find(ai->ai_exact, key, &best);
+	} else if (type == ACL_Host) {
+		acl_key_lower(key, type);
+		acl_index_find(ai->ai_exact, key, &best);
+		acl_index_find_wild(ai, key, key, &best);
+	} else if (type == ACL_Group) {
+#ifdef WIN32
+		acl_index_find(ai->ai_exact, key, &best);
+#else
+		struct passwd *pw;
+		struct group *gr;
+		gid_t *groups = NULL;
+		int ng = 0;
+
+		/* look the user's groups up once rather than once per entry */
+		if ((pw = getpwnam(name)) != NULL) {
+			if (getgrouplist(name, pw->pw_gid, NULL, &ng) < 0) {
+				if ((groups = (gid_t *) malloc(ng * sizeof(gid_t))) == NULL)
+					return -1;
+				getgrouplist(name, pw->pw_gid, groups, &ng);
+			}
+			for (i = 0; i < ng; i++)
+				if ((gr = getgrgid(groups[i])) != NULL)
+					acl_index_find(ai->ai_exact, gr->gr_name, &best);
+			free(groups);
+		}
+#endif
+	} else
+		acl_index_find(ai->ai_exact, key, &best);
+
+	for (i = 0; i < ai->ai_nother && ai->ai_other[i] < best; i++) {
+		char *pstr = pas->as_string[ai->ai_other[i]];
+
+		if ((*pstr == '+') || (*pstr == '-'))
+			pstr++;
+		if (!match_func(name, pstr)) {
+			best = ai->ai_other[i];
+			break;
+		}
+	}
+
+	if (best == INT_MAX)
+		return (ai->ai_default != -1 ? ai->ai_default : default_rtn);
+	return (*pas->as_string[best] == '-' ? 0 : 1);
+}
+
 /**
  * @brief
  * 	acl_check - check a name:
@@ -187,7 +493,8 @@ set_hostacl(attribute *attr, attribute *new, enum batch_op op)
  *		full_host_name
  *	against the entries in an access control list.
  *	Match is done by calling the approprate comparison function
- *	with the name and each string from the list in turn.
+ *	with the name and each string from the list in turn.  Long host,
+ *	user and group lists are looked up in an index instead.
  *
  * @param[in] pattr - pointer to attribute list
  * @param[in] name - acl name to be checked
@@ -251,6 +558,13 @@ acl_check(attribute *pattr, char *name, int type)
 #endif
 	}
 
+	if ((pas->as_usedptr >= ACL_INDEX_MIN) &&
+	    ((type == ACL_Host) || (type == ACL_User) || (type == ACL_Group))) {
+		i = acl_index_check(pas, name, type, default_rtn, match_func);
+		if (i != -1)
+			return (i);
+	}
+
 	for (i = 0; i < pas->as_usedptr; i++) {
 		pstr = pas->as_string[i];
 		if ((*pstr == '+') || (*pstr == '-')) {
@@ -372,8 +686,10 @@ set_allacl(attribute *attr, attribute *new, enum batch_op op, int (*order_func)(
 		pas->as_bufsize = 0;
 		pas->as_buf = NULL;
 		pas->as_next = NULL;
+		pas->as_acl = NULL;
 		attr->at_val.at_arst = pas;
-	}
+	} else
+		free_acl_index(pas);
 
 	/*
 	 * At this point we know we have a array_strings struct initialized
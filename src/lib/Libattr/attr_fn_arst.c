@@ -81,6 +81,28 @@
  * 	struct
  */
 
+/*
+ * Frees the ACL lookup index of a list, see attr_fn_acl.c.  The ACL code
+ * sets it when it builds an index, so programs that never check ACLs do not
+ * need to link it in.
+ */
+void (*pfn_free_acl_index)(struct array_strings *) = NULL;
+
+/**
+ * @brief
+ *	drop the ACL lookup index of a list about to change or be freed
+ *
+ * @param[in] pas - the list
+ *
+ * @return void
+ */
+static void
+arst_free_acl_index(struct array_strings *pas)
+{
+	if (pas->as_acl != NULL && pfn_free_acl_index != NULL)
+		pfn_free_acl_index(pas);
+}
+
 /**
  * @brief
  *	decode a comma string into an attribute of type ATR_TYPE_ARST
@@ -145,6 +167,7 @@ decode_arst_direct(attribute *patr, char *val)
 	/* number of slots (sub strings) */
 	stp->as_npointers = ns;
 	stp->as_usedptr = 0;
+	stp->as_acl = NULL;
 	/* for the strings themselves */
 	stp->as_buf = pbuf;
 	stp->as_next = pbuf;
@@ -381,6 +404,8 @@ set_arst(attribute *attr, attribute *new, enum batch_op op)
 	xpasx = new->at_val.at_arst;
 	if (!xpasx)
 		return (PBSE_INTERNAL);
+	if (pas)
+		arst_free_acl_index(pas);
 
 	if (!pas) {
 
@@ -398,6 +423,7 @@ set_arst(attribute *attr, attribute *new, enum batch_op op)
 		pas->as_bufsize = 0;
 		pas->as_buf = NULL;
 		pas->as_next = NULL;
+		pas->as_acl = NULL;
 		attr->at_val.at_arst = pas;
 	}
 	if ((op == INCR) && !pas->as_buf)
@@ -573,6 +599,7 @@ void
 free_arst(attribute *attr)
 {
 	if ((attr->at_flags & ATR_VFLAG_SET) && (attr->at_val.at_arst)) {
+		arst_free_acl_index(attr->at_val.at_arst);
 		(void) free(attr->at_val.at_arst->as_buf);
 		(void) free((char *) attr->at_val.at_arst);
 	}
@@ -806,6 +833,7 @@ decode_arst_direct_bs(attribute *patr, char *val)
 	/* number of slots (sub strings) */
 	stp->as_npointers = ns;
 	stp->as_usedptr = 0;
+	stp->as_acl = NULL;
 	/* for the strings themselves */
 	stp->as_buf = pbuf;
 	stp->as_next = pbuf;
@@ -1072,6 +1100,8 @@ set_arst_uniq(attribute *attr, attribute *new, enum batch_op op)
 		pas = NULL;	 /* just freed what it was point to */
 		op = INCR;
 	}
+	if (pas)
+		arst_free_acl_index(pas);
 
 	if (!pas) {
 
@@ -1089,6 +1119,7 @@ set_arst_uniq(attribute *attr, attribute *new, enum batch_op op)
 		pas->as_bufsize = 0;
 		pas->as_buf = NULL;
 		pas->as_next = NULL;
+		pas->as_acl = NULL;
 		attr->at_val.at_arst = pas;
 	}
 
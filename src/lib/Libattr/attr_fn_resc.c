@@ -94,6 +94,10 @@ int comp_resc_lt; /* count of resources compared < */
 int comp_resc_nc; /* count of resources not compared  */
 void *resc_attrdef_idx = NULL;
 
+/* fixed key index over the built-in resources passed to cr_rescdef_idx() */
+static void *resc_builtin_idx = NULL;
+static resource_def *resc_builtin_def = NULL;
+
 /**
  * @brief
  * 	decode_resc - decode a "attribute name/resource name/value" triplet into
@@ -267,6 +271,44 @@ encode_resc(const attribute *attr, pbs_list_head *phead, char *atname, char *rsn
 	return (grandtotal);
 }
 
+/**
+ * @brief
+ * 	find_resc_entry_from - find a resource entry in a resource list,
+ *	resuming the walk at a caller held cursor.
+ *
+ *	add_resource_entry() keeps every resource list sorted by resource
+ *	name (case insensitive), so when a caller looks up the entries of one
+ *	sorted list in another, each lookup can start where the previous one
+ *	stopped and the whole pass costs one walk of each list instead of one
+ *	walk of "pattr" per entry.
+ *
+ * @param[in]     pattr  - pointer to the attribute whose list is searched
+ * @param[in]     rscdf  - definition of the resource to find
+ * @param[in,out] cursor - where to start, NULL for the head of the list;
+ *			   updated to the first entry not sorting before rscdf
+ *
+ * @return	resource *
+ * @retval	pointer to the matching entry
+ * @retval	NULL if rscdf is not in the list
+ *
+ */
+static resource *
+find_resc_entry_from(const attribute *pattr, resource_def *rscdf, resource **cursor)
+{
+	resource *pr;
+
+	if (*cursor != NULL)
+		pr = *cursor;
+	else
+		pr = (resource *) GET_NEXT(pattr->at_val.at_list);
+	while ((pr != NULL) && (strcasecmp(pr->rs_defin->rs_name, rscdf->rs_name) < 0))
+		pr = (resource *) GET_NEXT(pr->rs_link);
+	*cursor = pr;
+	if ((pr != NULL) && (pr->rs_defin == rscdf))
+		return (pr);
+	return (NULL);
+}
+
 /**
  * @brief
  * 	set_resc - set value of attribute of type ATR_TYPE_RESR to another
@@ -294,6 +336,7 @@ set_resc(attribute *old, attribute *new, enum batch_op op)
 	enum batch_op local_op;
 	resource *newresc;
 	resource *oldresc;
+	resource *cursor = NULL;
 	int rc;
 
 	assert(old && new);
@@ -305,7 +348,7 @@ set_resc(attribute *old, attribute *new, enum batch_op op)
 
 		/* search for old that has same definition as new */
 
-		oldresc = find_resc_entry(old, newresc->rs_defin);
+		oldresc = find_resc_entry_from(old, newresc->rs_defin, &cursor);
 		if (oldresc == NULL) {
 			/* add new resource to list */
 			oldresc = add_resource_entry(old, newresc->rs_defin);
@@ -313,6 +356,7 @@ set_resc(attribute *old, attribute *new, enum batch_op op)
 				log_err(-1, "set_resc", "Unable to malloc space");
 				return (PBSE_SYSTEM);
 			}
+			cursor = oldresc;
 		}
 
 		/*
@@ -381,6 +425,7 @@ comp_resc(attribute *attr, attribute *with)
 {
 	resource *atresc;
 	resource *wiresc;
+	resource *cursor = NULL;
 	int rc;
 
 	comp_resc_gt = 0;
@@ -394,7 +439,7 @@ comp_resc(attribute *attr, attribute *with)
 	wiresc = (resource *) GET_NEXT(with->at_val.at_list);
 	while (wiresc != NULL) {
 		if (wiresc->rs_value.at_flags & ATR_VFLAG_SET) {
-			atresc = find_resc_entry(attr, wiresc->rs_defin);
+			atresc = find_resc_entry_from(attr, wiresc->rs_defin, &cursor);
 			if (atresc != NULL) {
 				if (atresc->rs_value.at_flags & ATR_VFLAG_SET) {
 					if ((rc = atresc->rs_defin->rs_comp(&atresc->rs_value, &wiresc->rs_value)) > 0)
@@ -466,6 +511,7 @@ int
 cr_rescdef_idx(resource_def *resc_def, int limit)
 {
 	int i;
+	char **names;
 
 	if (!resc_def)
 		return -1;
@@ -473,15 +519,30 @@ cr_rescdef_idx(resource_def *resc_def, int limit)
 	/* create the attribute index */
 	if ((resc_attrdef_idx = pbs_idx_create(PBS_IDX_ICASE_CMP, 0)) == NULL)
 		return -1;
+	if ((names = malloc((limit + 1) * sizeof(char *))) == NULL)
+		return -1;
 
 	/* add all attributes to the tree with key as the attr name */
 	for (i = 0; i < limit; i++) {
-		if (strcmp(resc_def->rs_name, RESC_NOOP_DEF) != 0) {
-			if (pbs_idx_insert(resc_attrdef_idx, resc_def->rs_name, resc_def) != PBS_IDX_RET_OK)
+		names[i] = NULL;
+		if (strcmp(resc_def[i].rs_name, RESC_NOOP_DEF) != 0) {
+			if (pbs_idx_insert(resc_attrdef_idx, resc_def[i].rs_name, &resc_def[i]) != PBS_IDX_RET_OK) {
+				free(names);
 				return -1;
+			}
+			names[i] = resc_def[i].rs_name;
 		}
-		resc_def++;
 	}
+
+	/*
+	 * The built-in resources are also put in a fixed key index for a
+	 * faster lookup, the tree stays for the custom resources that are
+	 * added and deleted at run time.
+	 */
+	pbs_idx_destroy_fixed(resc_builtin_idx);
+	resc_builtin_idx = pbs_idx_create_fixed(names, limit);
+	resc_builtin_def = resc_def;
+	free(names);
 	return 0;
 }
 
@@ -501,6 +562,11 @@ resource_def *
 find_resc_def(resource_def *resc_def, char *name)
 {
 	resource_def *found_def = NULL, *def = NULL;
+	int i;
+
+	if (resc_builtin_idx != NULL && resc_def == resc_builtin_def &&
+	    (i = pbs_idx_find_fixed(resc_builtin_idx, name)) >= 0)
+		return &resc_def[i];
 
 	if (pbs_idx_find(resc_attrdef_idx, (void **) &name, (void **) &found_def, NULL) == PBS_IDX_RET_OK)
 		def = &resc_def[found_def - resc_def];
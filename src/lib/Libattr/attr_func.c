@@ -55,6 +55,7 @@
 #include "pbs_idx.h"
 #include "pbs_entlim.h"
 #include "job.h"
+#include "resource.h"
 
 /**
  *
@@ -94,6 +95,9 @@ clear_attr(attribute *pattr, attribute_def *pdef)
  * @brief
  * 	Create the search index for the provided attribute def array
  *
+ *	The names of a def array never change, so the index is a fixed key
+ *	(perfect hash) index rather than a tree.
+ *
  * @param[in] attr_def - ptr to attribute definitions
  * @param[in] limit - limit on size of def array
  *
@@ -106,22 +110,24 @@ void *
 cr_attrdef_idx(attribute_def *adef, int limit)
 {
 	int i;
+	char **names;
 	void *attrdef_idx = NULL;
 
 	if (!adef)
 		return NULL;
 
-	/* create the attribute index */
-	if ((attrdef_idx = pbs_idx_create(PBS_IDX_ICASE_CMP, 0)) == NULL)
+	if ((names = malloc((limit + 1) * sizeof(char *))) == NULL)
 		return NULL;
-
-	/* add all attributes to the tree with key as the attr name */
 	for (i = 0; i < limit; i++) {
-		if (pbs_idx_insert(attrdef_idx, adef->at_name, adef) != PBS_IDX_RET_OK)
+		if (adef[i].at_name == NULL) {
+			free(names);
 			return NULL;
-
-		adef++;
+		}
+		names[i] = adef[i].at_name;
 	}
+
+	attrdef_idx = pbs_idx_create_fixed(names, limit);
+	free(names);
 	return attrdef_idx;
 }
 
@@ -144,13 +150,7 @@ cr_attrdef_idx(attribute_def *adef, int limit)
 int
 find_attr(void *attrdef_idx, attribute_def *attr_def, char *name)
 {
-	int index = -1;
-	attribute_def *found_def = NULL;
-
-	if (pbs_idx_find(attrdef_idx, (void **) &name, (void **) &found_def, NULL) == PBS_IDX_RET_OK)
-		index = (found_def - attr_def);
-
-	return index;
+	return pbs_idx_find_fixed(attrdef_idx, name);
 }
 
 /**
@@ -192,6 +192,77 @@ free_svrcache(attribute *attr)
 	attr->at_priv_encoded = NULL;
 }
 
+/**
+ * @brief
+ * 	attr_mem_size - estimate the heap memory held by the value of an
+ * 	attribute, not counting the attribute structure itself
+ *
+ * @param[in]	pattr	- the attribute
+ *
+ * @return	long
+ * @retval	bytes held by strings, string arrays and resource lists; 0
+ *		for an unset attribute or a type holding no heap memory
+ */
+long
+attr_mem_size(const attribute *pattr)
+{
+	struct array_strings *arst;
+	resource *presc;
+	long size = 0;
+
+	if (!(pattr->at_flags & ATR_VFLAG_SET))
+		return 0;
+
+	switch (pattr->at_type) {
+		case ATR_TYPE_STR:
+			if (pattr->at_val.at_str)
+				size = strlen(pattr->at_val.at_str) + 1;
+			break;
+
+		case ATR_TYPE_ARST:
+		case ATR_TYPE_ACL:
+			if ((arst = pattr->at_val.at_arst) != NULL)
+				size = sizeof(struct array_strings) +
+				       (arst->as_npointers - 1) * sizeof(char *) +
+				       arst->as_bufsize;
+			break;
+
+		case ATR_TYPE_RESC:
+			for (presc = (resource *) GET_NEXT(pattr->at_val.at_list); presc;
+			     presc = (resource *) GET_NEXT(presc->rs_link))
+				size += sizeof(resource) + attr_mem_size(&presc->rs_value);
+			break;
+
+		default:
+			break;
+	}
+	return size;
+}
+
+/**
+ * @brief
+ * 	attr_cache_mem_size - the memory held by the cached encoded forms
+ * 	of an attribute, see free_svrcache()
+ *
+ * @param[in]	pattr	- the attribute
+ *
+ * @return	long
+ */
+long
+attr_cache_mem_size(const attribute *pattr)
+{
+	svrattrl *pal;
+	long size = 0;
+
+	for (pal = pattr->at_user_encoded; pal; pal = pal->al_sister)
+		size += pal->al_tsize;
+	if (pattr->at_priv_encoded != pattr->at_user_encoded) {
+		for (pal = pattr->at_priv_encoded; pal; pal = pal->al_sister)
+			size += pal->al_tsize;
+	}
+	return size;
+}
+
 /**
  * @brief
  *	free_null - A free routine for attributes which do not
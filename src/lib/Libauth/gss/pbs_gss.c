@@ -65,6 +65,8 @@ static pthread_once_t gss_init_lock_once = PTHREAD_ONCE_INIT;
 static char gss_log_buffer[LOG_BUF_SIZE];
 static void (*logger)(int type, int objclass, int severity, const char *objname, const char *text);
 #define DEFAULT_CREDENTIAL_LIFETIME 7200
+/* service client credentials are dropped this long before they expire */
+#define CLIENT_CREDENTIAL_MARGIN 300
 
 #define __GSS_LOGGER(e, c, s, m)                                          \
 	do {                                                              \
@@ -676,6 +678,8 @@ pbs_gss_establish_context(pbs_gss_extra_t *gss_extra, void *data_in, size_t len_
 	time_t now = time((time_t *) NULL);
 	static time_t lastcredstime = 0;
 	static time_t credlifetime = 0;
+	static gss_cred_id_t svc_client_creds = GSS_C_NO_CREDENTIAL;
+	static time_t svc_client_creds_expiry = 0;
 	OM_uint32 lifetime;
 	OM_uint32 gss_flags;
 	OM_uint32 ret_flags;
@@ -708,6 +712,31 @@ pbs_gss_establish_context(pbs_gss_extra_t *gss_extra, void *data_in, size_t len_
 	switch (gss_extra->role) {
 
 		case AUTH_CLIENT:
+			gss_flags = GSS_C_MUTUAL_FLAG | GSS_C_DELEG_FLAG | GSS_C_INTEG_FLAG | GSS_C_CONF_FLAG;
+			oid = PBS_GSS_MECH_OID;
+
+			/*
+			 * daemon to daemon connections all use the PBS service
+			 * credentials, so keep them between connections rather than
+			 * going to the keytab and ccache for each (re)connect
+			 */
+			if (gss_extra->conn_type == AUTH_SERVICE_CONN && svc_client_creds != GSS_C_NO_CREDENTIAL) {
+				int first_step = (gss_context == GSS_C_NO_CONTEXT);
+
+				if (now < svc_client_creds_expiry) {
+					ret = pbs_gss_client_establish_context(service_name, svc_client_creds, oid, gss_flags, &gss_context, &ret_flags, data_in, len_in, data_out, len_out);
+					if (ret == PBS_GSS_OK || ret == PBS_GSS_CONTINUE_NEEDED)
+						break;
+				}
+				/* expired or no longer accepted, get fresh ones */
+				(void) gss_release_cred(&min_stat, &svc_client_creds);
+				svc_client_creds = GSS_C_NO_CREDENTIAL;
+				if (!first_step) {
+					ret = PBS_GSS_ERR_CONTEXT_INIT;
+					break;
+				}
+			}
+
 			if (pbs_gss_oidset_mech(&oidset) != PBS_GSS_OK)
 				return PBS_GSS_ERR_OID;
 
@@ -738,14 +767,22 @@ pbs_gss_establish_context(pbs_gss_extra_t *gss_extra, void *data_in, size_t len_
 				return PBS_GSS_ERR_ACQUIRE_CREDS;
 			}
 
-			gss_flags = GSS_C_MUTUAL_FLAG | GSS_C_DELEG_FLAG | GSS_C_INTEG_FLAG | GSS_C_CONF_FLAG;
-			oid = PBS_GSS_MECH_OID;
-
 			ret = pbs_gss_client_establish_context(service_name, creds, oid, gss_flags, &gss_context, &ret_flags, data_in, len_in, data_out, len_out);
 
 			if (ccache_from_keytab || gss_extra->conn_type == AUTH_SERVICE_CONN)
 				unsetenv("KRB5CCNAME");
 
+			if (gss_extra->conn_type == AUTH_SERVICE_CONN && creds != GSS_C_NO_CREDENTIAL &&
+			    (ret == PBS_GSS_OK || ret == PBS_GSS_CONTINUE_NEEDED) &&
+			    gss_inquire_cred(&min_stat, creds, NULL, &lifetime, NULL, NULL) == GSS_S_COMPLETE &&
+			    lifetime > CLIENT_CREDENTIAL_MARGIN) {
+				if (lifetime == GSS_C_INDEFINITE || lifetime > DEFAULT_CREDENTIAL_LIFETIME)
+					lifetime = DEFAULT_CREDENTIAL_LIFETIME;
+				svc_client_creds = creds;
+				svc_client_creds_expiry = now + lifetime - CLIENT_CREDENTIAL_MARGIN;
+				creds = GSS_C_NO_CREDENTIAL;
+			}
+
 			if (creds != GSS_C_NO_CREDENTIAL) {
 				maj_stat = gss_release_cred(&min_stat, &creds);
 				if (maj_stat != GSS_S_COMPLETE) {
@@ -51,7 +51,44 @@
 
 /**
  * @brief
- *	bs_isort - insertion sort for batch_status structures
+ *	bs_merge - merge two sorted batch_status lists into one sorted list
+ *
+ * @param[in] a - first sorted list, its entries win ties
+ * @param[in] b - second sorted list
+ * @param[in] cmp_func - compare function to compare two batch_status
+ *
+ * @return 	structure handle
+ * @retval	head of merged batch status list
+ *
+ */
+static struct batch_status *
+bs_merge(struct batch_status *a, struct batch_status *b,
+	 int (*cmp_func)(struct batch_status *, struct batch_status *))
+{
+	struct batch_status head;
+	struct batch_status *tail = &head;
+
+	while (a != NULL && b != NULL) {
+		if (cmp_func(a, b) <= 0) {
+			tail->next = a;
+			a = a->next;
+		} else {
+			tail->next = b;
+			b = b->next;
+		}
+		tail = tail->next;
+	}
+	tail->next = (a != NULL) ? a : b;
+	return head.next;
+}
+
+/**
+ * @brief
+ *	bs_isort - sort batch_status structures
+ *
+ *	Despite the name this is a bottom-up merge sort, so sorting the
+ *	subjobs of a large array job is O(n log n) instead of O(n^2).
+ *	Equal entries keep their original order.
  *
  * @param[in] bs - batch_status linked list
  * @param[in] cmp_func - compare function to compare two batch_status
@@ -65,38 +102,31 @@ struct batch_status *
 bs_isort(struct batch_status *bs,
 	 int (*cmp_func)(struct batch_status *, struct batch_status *))
 {
-	struct batch_status *new_head = NULL; /* new list head */
-	struct batch_status *cur_old;	      /*where we are in the old list*/
-	struct batch_status *cur_new;	      /* where we are in the new list */
-	struct batch_status *prev_new = NULL;
-	struct batch_status *tmp; /* tmp ptr to hold next */
+	/* bin[i] is either empty or a sorted run of 2^i entries */
+	struct batch_status *bin[64];
+	struct batch_status *run;
+	int nbins = 0;
+	int i;
 
-	cur_old = bs;
-	new_head = NULL;
-
-	while (cur_old != NULL) {
-		tmp = cur_old->next;
-
-		if (new_head == NULL) {
-			cur_old->next = NULL;
-			new_head = cur_old;
-		} else {
-			/* find where our node goes in the new list */
-			for (cur_new = new_head, prev_new = NULL;
-			     cur_new != NULL && cmp_func(cur_new, cur_old) <= 0;
-			     prev_new = cur_new, cur_new = cur_new->next)
-				;
-			if (prev_new == NULL) {
-				cur_old->next = new_head;
-				new_head = cur_old;
-			} else {
-				cur_old->next = cur_new;
-				prev_new->next = cur_old;
-			}
+	while (bs != NULL) {
+		run = bs;
+		bs = bs->next;
+		run->next = NULL;
+		for (i = 0; i < nbins && bin[i] != NULL; i++) {
+			run = bs_merge(bin[i], run, cmp_func);
+			bin[i] = NULL;
 		}
-		cur_old = tmp;
+		if (i == nbins)
+			nbins++;
+		bin[i] = run;
+	}
+
+	run = NULL;
+	for (i = 0; i < nbins; i++) {
+		if (bin[i] != NULL)
+			run = bs_merge(bin[i], run, cmp_func);
 	}
-	return new_head;
+	return run;
 }
 
 /**
@@ -238,13 +238,19 @@ dbarray_to_attrlist(char *raw_array, pbs_db_attr_list_t *attr_list)
  * @retval	-1 - On Error
  * @retval	 length of array - On Success
  *
+ * @note
+ *	Key arrays and key/value arrays are built in two different buffers,
+ *	so one of each can be passed to the same statement.
+ *
  */
 int
 attrlist_to_dbarray_ex(char **raw_array, pbs_db_attr_list_t *attr_list, int keys_only)
 {
 	/* use static variables to improve performance by not allocating memory for each object save */
-	static struct pg_array *array = NULL, *tmp;
-	static int len = sizeof(struct pg_array) + DBARRAY_BUF_LEN;
+	static struct pg_array *arrays[2] = {NULL, NULL};
+	static int lens[2] = {sizeof(struct pg_array) + DBARRAY_BUF_LEN, sizeof(struct pg_array) + DBARRAY_BUF_LEN};
+	struct pg_array *array, *tmp;
+	int len;
 	struct str_data *val = NULL;
 	svrattrl *pal;
 	char *p;
@@ -252,11 +258,14 @@ attrlist_to_dbarray_ex(char **raw_array, pbs_db_attr_list_t *attr_list, int keys
 	/* (len_field * 2) + PBS_MAXATTRNAME + PBS_MAXATTRRESC + max 3 digits flags +  2 dots + 1 null terminator */
 	static int fixed_part_req = (sizeof(int32_t) * 2) + PBS_MAXATTRNAME + PBS_MAXATTRRESC + 3 + 2 + 1;
 
-	if (!array) {
-		array = malloc(len);
-		if (!array)
+	keys_only = (keys_only != 0);
+	len = lens[keys_only];
+	if (!arrays[keys_only]) {
+		arrays[keys_only] = malloc(len);
+		if (!arrays[keys_only])
 			return -1;
 	}
+	array = arrays[keys_only];
 
 	array->ndim = htonl(1);
 	array->off = 0;
@@ -281,6 +290,8 @@ attrlist_to_dbarray_ex(char **raw_array, pbs_db_attr_list_t *attr_list, int keys
 
 			val = (struct str_data *) ((char *) val + ((char *) tmp - (char *) array)); /* move val since array moved */
 			array = tmp;
+			arrays[keys_only] = array;
+			lens[keys_only] = len;
 		}
 		p = pbs_strcpy(val->str, pal->al_atopl.name);
 		if (pal->al_atopl.resource && pal->al_atopl.resource[0] != '\0') {
@@ -60,6 +60,7 @@
 #include "ticket.h"
 #include "log.h"
 #include "server_limits.h"
+#include "pbs_metrics.h"
 
 #define IPV4_STR_LEN 15
 
@@ -68,6 +69,7 @@ pg_conn_data_t *conn_data = NULL;
 pg_conn_trx_t *conn_trx = NULL;
 static char pg_ctl[MAXPATHLEN + 1] = "";
 static char *pg_user = NULL;
+static pbs_hist_t db_latency[PBS_DB_NUM_OPS]; /* latency of database calls by kind */
 
 static int is_conn_error(void *conn, int *failcode);
 static char *get_dataservice_password(char *user, char *errmsg, int len);
@@ -227,6 +229,7 @@ pbs_db_search(void *conn, pbs_db_obj_info_t *obj, pbs_db_query_options_t *opts,
 	int totcount;
 	int refreshed;
 	int rc;
+	unsigned long long start = pbs_metrics_now_us();
 
 	st = db_initialize_state(conn, query_cb);
 	if (!st)
@@ -246,6 +249,7 @@ pbs_db_search(void *conn, pbs_db_obj_info_t *obj, pbs_db_query_options_t *opts,
 	}
 
 	db_destroy_state(st);
+	pbs_hist_since(&db_latency[PBS_DB_OP_SEARCH], start);
 	return totcount;
 }
 
@@ -297,7 +301,12 @@ db_cursor_next(void *conn, void *st, pbs_db_obj_info_t *obj)
 int
 pbs_db_delete_obj(void *conn, pbs_db_obj_info_t *obj)
 {
-	return (db_fn_arr[obj->pbs_db_obj_type].pbs_db_delete_obj(conn, obj));
+	unsigned long long start = pbs_metrics_now_us();
+	int rc;
+
+	rc = db_fn_arr[obj->pbs_db_obj_type].pbs_db_delete_obj(conn, obj);
+	pbs_hist_since(&db_latency[PBS_DB_OP_DELETE], start);
+	return rc;
 }
 
 /**
@@ -318,7 +327,12 @@ pbs_db_delete_obj(void *conn, pbs_db_obj_info_t *obj)
 int
 pbs_db_load_obj(void *conn, pbs_db_obj_info_t *obj)
 {
-	return (db_fn_arr[obj->pbs_db_obj_type].pbs_db_load_obj(conn, obj));
+	unsigned long long start = pbs_metrics_now_us();
+	int rc;
+
+	rc = db_fn_arr[obj->pbs_db_obj_type].pbs_db_load_obj(conn, obj);
+	pbs_hist_since(&db_latency[PBS_DB_OP_LOAD], start);
+	return rc;
 }
 
 /**
@@ -888,7 +902,170 @@ pbs_db_disconnect(void *conn)
 int
 pbs_db_save_obj(void *conn, pbs_db_obj_info_t *obj, int savetype)
 {
-	return (db_fn_arr[obj->pbs_db_obj_type].pbs_db_save_obj(conn, obj, savetype));
+	unsigned long long start = pbs_metrics_now_us();
+	int rc;
+
+	rc = db_fn_arr[obj->pbs_db_obj_type].pbs_db_save_obj(conn, obj, savetype);
+	pbs_hist_since(&db_latency[PBS_DB_OP_SAVE], start);
+	return rc;
+}
+
+/**
+ * @brief
+ *	Start a transaction on the connection
+ *
+ * @param[in]	conn - Connected database handle
+ *
+ * @return      Error code
+ * @retval	-1  - Failure
+ * @retval	 0  - Success
+ *
+ */
+int
+pbs_db_begin_trx(void *conn)
+{
+	if (db_execute_str(conn, "BEGIN") == -1)
+		return -1;
+	return 0;
+}
+
+/**
+ * @brief
+ *	Commit or rollback the transaction started on the connection
+ *
+ * @param[in]	conn - Connected database handle
+ * @param[in]	commit - PBS_DB_COMMIT or PBS_DB_ROLLBACK
+ *
+ * @return      Error code
+ * @retval	-1  - Failure
+ * @retval	 0  - Success
+ *
+ */
+int
+pbs_db_end_trx(void *conn, int commit)
+{
+	unsigned long long start = pbs_metrics_now_us();
+	int rc;
+
+	rc = db_execute_str(conn, (commit == PBS_DB_COMMIT) ? "COMMIT" : "ROLLBACK");
+	pbs_hist_since(&db_latency[PBS_DB_OP_COMMIT], start);
+	if (rc == -1)
+		return -1;
+	return 0;
+}
+
+/**
+ * @brief
+ *	Latency histogram of one kind of database call
+ *
+ * @param[in]	op - the kind of call, one of enum pbs_db_op
+ *
+ * @return	histogram of the calls made so far, NULL for a bad op
+ *
+ */
+const struct pbs_hist *
+pbs_db_latency(int op)
+{
+	if (op < 0 || op >= PBS_DB_NUM_OPS)
+		return NULL;
+	return &db_latency[op];
+}
+
+/**
+ * @brief
+ *	Put the connection in pipeline mode, so that the DML statements run
+ *	by db_cmd() are only queued, and go to the server together when the
+ *	pipeline is ended by pbs_db_end_pipeline()
+ *
+ * @param[in]	conn - Connected database handle
+ *
+ * @return      Error code
+ * @retval	-1  - Failure, or libpq without pipeline support; statements
+ *		      then simply run one by one
+ * @retval	 0  - Success
+ *
+ */
+int
+pbs_db_begin_pipeline(void *conn)
+{
+#ifdef LIBPQ_HAS_PIPELINING
+	if (conn_trx->conn_pipeline)
+		return -1;
+	if (PQenterPipelineMode((PGconn *) conn) != 1) {
+		db_set_error(conn, &errmsg_cache, "Entering pipeline mode", "", "");
+		return -1;
+	}
+	conn_trx->conn_pipeline = 1;
+	conn_trx->conn_pipe_pending = 0;
+	return 0;
+#else
+	return -1;
+#endif
+}
+
+/**
+ * @brief
+ *	Send the statements queued since pbs_db_begin_pipeline() and collect
+ *	their results, then leave pipeline mode
+ *
+ * @par
+ *	Once a statement fails, the server skips the rest of the pipeline,
+ *	so the caller should treat a failure as failure of all of them.
+ *
+ * @param[in]	conn - Connected database handle
+ *
+ * @return      Error code
+ * @retval	-1  - Failure of at least one statement
+ * @retval	 0  - Success
+ *
+ */
+int
+pbs_db_end_pipeline(void *conn)
+{
+#ifdef LIBPQ_HAS_PIPELINING
+	PGresult *res;
+	int rc = 0;
+	unsigned long long start = pbs_metrics_now_us();
+
+	if (!conn_trx->conn_pipeline)
+		return -1;
+
+	if (PQpipelineSync((PGconn *) conn) != 1) {
+		db_set_error(conn, &errmsg_cache, "Pipeline sync", "", "");
+		rc = -1;
+	}
+
+	for (; conn_trx->conn_pipe_pending > 0; conn_trx->conn_pipe_pending--) {
+		/* each statement's result is followed by a NULL */
+		while ((res = PQgetResult((PGconn *) conn)) != NULL) {
+			if (rc == 0 && PQresultStatus(res) != PGRES_COMMAND_OK) {
+				char *sql_error = PQresultErrorField(res, PG_DIAG_SQLSTATE);
+				db_set_error(conn, &errmsg_cache, "Execution of pipelined statement", "", sql_error);
+				rc = -1;
+			}
+			PQclear(res);
+		}
+	}
+
+	/* and finally the result of the sync itself */
+	while ((res = PQgetResult((PGconn *) conn)) != NULL) {
+		ExecStatusType st = PQresultStatus(res);
+
+		PQclear(res);
+		if (st == PGRES_PIPELINE_SYNC)
+			break;
+	}
+
+	conn_trx->conn_pipeline = 0;
+	if (PQexitPipelineMode((PGconn *) conn) != 1) {
+		db_set_error(conn, &errmsg_cache, "Leaving pipeline mode", "", "");
+		rc = -1;
+	}
+	pbs_hist_since(&db_latency[PBS_DB_OP_PIPELINE], start);
+	return rc;
+#else
+	return -1;
+#endif
 }
 
 /**
@@ -997,6 +1174,9 @@ db_prepare_stmt(void *conn, char *stmt, char *sql, int num_vars)
  * @retval	 0 - Success and > 0 rows were affected
  * @retval	 1 - Execution succeeded but statement did not affect any rows
  *
+ * @note
+ *	In pipeline mode the statement is only queued and 0 is returned,
+ *	its outcome is reported by pbs_db_end_pipeline().
  *
  */
 int
@@ -1005,6 +1185,21 @@ db_cmd(void *conn, char *stmt, int num_vars)
 	PGresult *res;
 	char *rows_affected = NULL;
 
+#ifdef LIBPQ_HAS_PIPELINING
+	if (conn_trx->conn_pipeline) {
+		/* the parameters are copied to the send buffer right here */
+		if (PQsendQueryPrepared((PGconn *) conn, stmt, num_vars,
+					conn_data->paramValues,
+					conn_data->paramLengths,
+					conn_data->paramFormats, 0) != 1) {
+			db_set_error(conn, &errmsg_cache, "Queueing of Prepared statement", stmt, "");
+			return -1;
+		}
+		conn_trx->conn_pipe_pending++;
+		return 0;
+	}
+#endif
+
 	res = PQexecPrepared((PGconn *) conn, stmt, num_vars,
 			     conn_data->paramValues,
 			     conn_data->paramLengths,
@@ -1049,6 +1244,12 @@ int
 db_query(void *conn, char *stmt, int num_vars, PGresult **res)
 {
 	int conn_result_format = 1;
+
+	if (conn_trx->conn_pipeline) {
+		/* a query needs its rows now, it cannot wait for the pipeline */
+		*res = NULL;
+		return -1;
+	}
 	*res = PQexecPrepared((PGconn *) conn, stmt, num_vars,
 			      conn_data->paramValues, conn_data->paramLengths,
 			      conn_data->paramFormats, conn_result_format);
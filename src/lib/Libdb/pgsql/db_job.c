@@ -47,6 +47,17 @@
 #include "pbs_db.h"
 #include "db_postgres.h"
 
+/*
+ * New value of the attributes column: the keys of every attribute named in
+ * the "names" array are dropped, whatever their resource part, before the
+ * "attrs" key/value array is merged in.  So an attribute that was unset, or
+ * lost some of its resources, since the last save does not linger.
+ */
+#define JOB_ATTRS_REPLACE(attrs, names)                                   \
+	"(attributes - array(select k from skeys(attributes) k "          \
+	"where split_part(k, '.', 1) = any(" names "::text[]))) || hstore(" \
+	attrs "::text[])"
+
 /**
  * @brief
  *	Prepare all the job related sqls. Typically called after connect
@@ -107,16 +118,16 @@ db_prepare_job_sqls(void *conn)
 					   "ji_credtype = $15,"
 					   "ji_qrank = $16,"
 					   "ji_savetm = localtimestamp,"
-					   "attributes = attributes || hstore($17::text[]) "
+					   "attributes = " JOB_ATTRS_REPLACE("$17", "$18") " "
 					   "where ji_jobid = $1");
-	if (db_prepare_stmt(conn, STMT_UPDATE_JOB, conn_sql, 17) != 0)
+	if (db_prepare_stmt(conn, STMT_UPDATE_JOB, conn_sql, 18) != 0)
 		return -1;
 
 	snprintf(conn_sql, MAX_SQL_LENGTH, "update pbs.job set "
 					   "ji_savetm = localtimestamp,"
-					   "attributes = attributes || hstore($2::text[]) "
+					   "attributes = " JOB_ATTRS_REPLACE("$2", "$3") " "
 					   "where ji_jobid = $1");
-	if (db_prepare_stmt(conn, STMT_UPDATE_JOB_ATTRSONLY, conn_sql, 2) != 0)
+	if (db_prepare_stmt(conn, STMT_UPDATE_JOB_ATTRSONLY, conn_sql, 3) != 0)
 		return -1;
 
 	snprintf(conn_sql, MAX_SQL_LENGTH, "update pbs.job set "
@@ -175,11 +186,33 @@ db_prepare_job_sqls(void *conn)
 	 * string using 'escape' syntax. Refer to the following postgres link
 	 * for details:
 	 * http://www.postgresql.org/docs/8.3/static/functions-string.html
+	 *
+	 * Scripts are stored once in pbs.job_scr_body under the md5 of their
+	 * content and pbs.job_scr refers to them.  If the body is already there
+	 * (same hash and same content) its reference count is bumped, if the
+	 * hash is not known yet a body is added.  Should a body with the same
+	 * hash but different content exist, the script is kept in the job's own
+	 * pbs.job_scr row instead.  This is a single statement so it can be
+	 * pipelined like every other save.
 	 */
-	snprintf(conn_sql, MAX_SQL_LENGTH, "insert into "
-					   "pbs.job_scr (ji_jobid, script) "
-					   "values "
-					   "($1, encode($2, 'escape'))");
+	snprintf(conn_sql, MAX_SQL_LENGTH, "with s as ("
+					   "select encode($2::bytea, 'escape') as script, md5($2::bytea) as hash), "
+					   "u as ("
+					   "update pbs.job_scr_body b set scr_refs = b.scr_refs + 1 from s "
+					   "where b.scr_hash = s.hash and b.script = s.script "
+					   "returning b.scr_hash), "
+					   "i as ("
+					   "insert into pbs.job_scr_body (scr_hash, script, scr_refs) "
+					   "select s.hash, s.script, 1 from s "
+					   "where not exists (select 1 from pbs.job_scr_body b where b.scr_hash = s.hash) "
+					   "returning scr_hash) "
+					   "insert into "
+					   "pbs.job_scr (ji_jobid, scr_hash, script) "
+					   "select $1::text, h.scr_hash, NULL::text from "
+					   "(select scr_hash from u union all select scr_hash from i) h "
+					   "union all "
+					   "select $1::text, NULL::text, s.script from s "
+					   "where not exists (select 1 from u) and not exists (select 1 from i)");
 	if (db_prepare_stmt(conn, STMT_INSERT_JOBSCR, conn_sql, 2) != 0)
 		return -1;
 
@@ -191,9 +224,10 @@ db_prepare_job_sqls(void *conn)
 	 * Refer to the following postgres link for details:
 	 * http://www.postgresql.org/docs/8.3/static/functions-string.html
 	 */
-	snprintf(conn_sql, MAX_SQL_LENGTH, "select decode(script, 'escape')::bytea as script "
-					   "from pbs.job_scr "
-					   "where ji_jobid = $1");
+	snprintf(conn_sql, MAX_SQL_LENGTH, "select decode(coalesce(s.script, b.script), 'escape')::bytea as script "
+					   "from pbs.job_scr s "
+					   "left join pbs.job_scr_body b on b.scr_hash = s.scr_hash "
+					   "where s.ji_jobid = $1");
 	if (db_prepare_stmt(conn, STMT_SELECT_JOBSCR, conn_sql, 1) != 0)
 		return -1;
 
@@ -247,10 +281,18 @@ db_prepare_job_sqls(void *conn)
 	if (db_prepare_stmt(conn, STMT_DELETE_JOB, conn_sql, 1) != 0)
 		return -1;
 
-	snprintf(conn_sql, MAX_SQL_LENGTH, "delete from pbs.job_scr where ji_jobid = $1");
+	snprintf(conn_sql, MAX_SQL_LENGTH, "with d as ("
+					   "delete from pbs.job_scr where ji_jobid = $1 returning scr_hash) "
+					   "update pbs.job_scr_body b set scr_refs = b.scr_refs - 1 "
+					   "from d where b.scr_hash = d.scr_hash");
 	if (db_prepare_stmt(conn, STMT_DELETE_JOBSCR, conn_sql, 1) != 0)
 		return -1;
 
+	/* a separate statement, the update above is not visible within it */
+	snprintf(conn_sql, MAX_SQL_LENGTH, "delete from pbs.job_scr_body where scr_refs <= 0");
+	if (db_prepare_stmt(conn, STMT_DELETE_JOBSCR_BODY, conn_sql, 0) != 0)
+		return -1;
+
 	return 0;
 }
 
@@ -380,27 +422,40 @@ pbs_db_save_job(void *conn, pbs_db_obj_info_t *obj, int savetype)
 		params = 16;
 	}
 
-	if ((pjob->db_attr_list.attr_count > 0) || (savetype & OBJ_SAVE_NEW)) {
+	if ((pjob->db_attr_list.attr_count > 0) || (pjob->db_attr_dirty_list.attr_count > 0) ||
+	    (savetype & OBJ_SAVE_NEW)) {
 		int len = 0;
+		int keys_len = 0;
+		char *raw_keys = NULL;
+
 		/* convert attributes to postgres raw array format */
 
 		if ((len = attrlist_to_dbarray(&raw_array, &pjob->db_attr_list)) <= 0)
 			return -1;
 
-		if (savetype & OBJ_SAVE_QS) {
+		if (savetype & OBJ_SAVE_NEW) {
 			SET_PARAM_BIN(conn_data, raw_array, len, 16);
 			params = 17;
-			stmt = STMT_UPDATE_JOB;
+			stmt = STMT_INSERT_JOB;
 		} else {
-			SET_PARAM_BIN(conn_data, raw_array, len, 1);
-			params = 2;
-			stmt = STMT_UPDATE_JOB_ATTRSONLY;
+			/* names of the changed attributes, whose old keys are dropped first */
+			if ((keys_len = attrlist_to_dbarray_ex(&raw_keys, &pjob->db_attr_dirty_list, 1)) <= 0)
+				return -1;
+
+			if (savetype & OBJ_SAVE_QS) {
+				SET_PARAM_BIN(conn_data, raw_array, len, 16);
+				SET_PARAM_BIN(conn_data, raw_keys, keys_len, 17);
+				params = 18;
+				stmt = STMT_UPDATE_JOB;
+			} else {
+				SET_PARAM_BIN(conn_data, raw_array, len, 1);
+				SET_PARAM_BIN(conn_data, raw_keys, keys_len, 2);
+				params = 3;
+				stmt = STMT_UPDATE_JOB_ATTRSONLY;
+			}
 		}
 	}
 
-	if (savetype & OBJ_SAVE_NEW)
-		stmt = STMT_INSERT_JOB;
-
 	if (stmt)
 		rc = db_cmd(conn, stmt, params);
 
@@ -535,6 +590,9 @@ pbs_db_delete_job(void *conn, pbs_db_obj_info_t *obj)
 	if (db_cmd(conn, STMT_DELETE_JOBSCR, 1) == -1)
 		goto err;
 
+	if (db_cmd(conn, STMT_DELETE_JOBSCR_BODY, 0) == -1)
+		goto err;
+
 	return rc;
 err:
 	return -1;
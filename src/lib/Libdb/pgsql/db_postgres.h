@@ -95,6 +95,7 @@ extern "C" {
 #define STMT_INSERT_JOBSCR "insert_jobscr"
 #define STMT_SELECT_JOBSCR "select_jobscr"
 #define STMT_DELETE_JOBSCR "delete_jobscr"
+#define STMT_DELETE_JOBSCR_BODY "delete_jobscr_body"
 
 /* reservation statement names */
 #define STMT_INSERT_RESV "insert_resv"
@@ -189,6 +190,8 @@ struct pg_conn_trx {
 	int conn_trx_nest;     /* incr/decr with each begin/end trx */
 	int conn_trx_rollback; /* rollback flag in case of nested trx */
 	int conn_trx_async;    /* 1 - async, 0 - sync, one-shot reset */
+	int conn_pipeline;     /* 1 - db_cmd() only queues statements */
+	int conn_pipe_pending; /* queued statements with results to collect */
 };
 typedef struct pg_conn_trx pg_conn_trx_t;
 
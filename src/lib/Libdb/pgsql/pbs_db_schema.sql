@@ -56,7 +56,7 @@ CREATE TABLE pbs.info (
     pbs_schema_version TEXT    NOT NULL
 );
 
-INSERT INTO pbs.info values('1.5.0'); /* schema version */
+INSERT INTO pbs.info values('1.6.0'); /* schema version */
 
 ---------------------- SERVER ------------------------------
 
@@ -188,12 +188,26 @@ ON pbs.job
 
 
 /*
- * Table pbs.job_scr holds the job script
+ * Table pbs.job_scr holds the job script, by reference to pbs.job_scr_body
+ * through scr_hash, or in script if its hash is taken by another script
  */
 CREATE TABLE pbs.job_scr (
     ji_jobid    TEXT       NOT NULL,
+    scr_hash    TEXT,
     script      TEXT
 );
 CREATE INDEX job_scr_idx ON pbs.job_scr (ji_jobid);
 
+/*
+ * Table pbs.job_scr_body holds each distinct job script once, with the
+ * number of jobs referring to it
+ */
+CREATE TABLE pbs.job_scr_body (
+    scr_hash    TEXT       NOT NULL,
+    script      TEXT       NOT NULL,
+    scr_refs    INTEGER    NOT NULL,
+    CONSTRAINT job_scr_body_pk PRIMARY KEY (scr_hash)
+);
+CREATE INDEX job_scr_body_unref_idx ON pbs.job_scr_body (scr_refs) WHERE scr_refs <= 0;
+
 ---------------------- END OF SCHEMA -----------------------
@@ -40,6 +40,7 @@
 #include <arpa/inet.h>
 #include <assert.h>
 #include <errno.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include "auth.h"
 #include "dis.h"
@@ -53,6 +54,24 @@
 static pbs_dis_buf_t *dis_get_readbuf(int);
 static pbs_dis_buf_t *dis_get_writebuf(int);
 static int dis_resize_buf(pbs_dis_buf_t *, size_t);
+static void dis_pool_get_buf(pbs_dis_buf_t *);
+static void dis_pool_put_buf(pbs_dis_buf_t *);
+
+/*
+ * Small pool of channel buffers, so that short lived connections (the
+ * common case for the server) reuse buffers instead of allocating two
+ * fresh ones each. Only buffers that did not grow past
+ * DIS_BUF_POOL_MAXSZ are kept, so a huge reply does not stay pinned.
+ */
+#define DIS_BUF_POOL_MAX 32
+#define DIS_BUF_POOL_MAXSZ (8 * PBS_DIS_BUFSZ)
+static struct {
+	char *data;
+	size_t size;
+} dis_buf_pool[DIS_BUF_POOL_MAX];
+static int dis_buf_pool_cnt = 0;
+static pthread_mutex_t dis_buf_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static long dis_buf_bytes = 0; /* storage held by channel buffers and the pool */
 static int transport_chan_is_encrypted(int);
 
 /**
@@ -422,6 +441,7 @@ __recv_pkt(int fd, int *type, pbs_dis_buf_t *tp)
 			return -1;
 
 		free(tp->tdis_data);
+		__sync_fetch_and_add(&dis_buf_bytes, (long) datasz - (long) tp->tdis_bufsize);
 		tp->tdis_data = data;
 		tp->tdis_bufsize = datasz;
 	}
@@ -551,18 +571,105 @@ dis_resize_buf(pbs_dis_buf_t *tp, size_t needed)
 {
 	if ((tp->tdis_len + needed) >= tp->tdis_bufsize) {
 		int offset = tp->tdis_len > 0 ? (tp->tdis_pos - tp->tdis_data) : 0;
-		char *tmpcp = (char *) realloc(tp->tdis_data, tp->tdis_bufsize + needed + PBS_DIS_BUFSZ);
+		size_t newsize = tp->tdis_bufsize + needed + PBS_DIS_BUFSZ;
+		char *tmpcp;
+
+		/* grow geometrically, so encoding a large reply is not quadratic */
+		if (newsize < 2 * tp->tdis_bufsize)
+			newsize = 2 * tp->tdis_bufsize;
+		tmpcp = (char *) realloc(tp->tdis_data, newsize);
 		if (tmpcp == NULL) {
 			return -1; /* realloc failed */
 		} else {
+			__sync_fetch_and_add(&dis_buf_bytes, (long) (newsize - tp->tdis_bufsize));
 			tp->tdis_data = tmpcp;
-			tp->tdis_bufsize = tp->tdis_bufsize + needed + PBS_DIS_BUFSZ;
+			tp->tdis_bufsize = newsize;
 			tp->tdis_pos = tp->tdis_data + offset;
 		}
 	}
 	return 0;
 }
 
+/**
+ * @brief
+ * 	dis_pool_get_buf - give an empty dis buffer its initial storage,
+ * 	from the buffer pool if possible
+ *
+ * @param[in] tp - dis buffer without storage
+ *
+ * @return void
+ *
+ * @par MT-safe: Yes
+ *
+ */
+static void
+dis_pool_get_buf(pbs_dis_buf_t *tp)
+{
+	pthread_mutex_lock(&dis_buf_pool_lock);
+	if (dis_buf_pool_cnt > 0) {
+		dis_buf_pool_cnt--;
+		tp->tdis_data = dis_buf_pool[dis_buf_pool_cnt].data;
+		tp->tdis_bufsize = dis_buf_pool[dis_buf_pool_cnt].size;
+	}
+	pthread_mutex_unlock(&dis_buf_pool_lock);
+
+	if (tp->tdis_data == NULL)
+		dis_resize_buf(tp, PBS_DIS_BUFSZ);
+}
+
+/**
+ * @brief
+ * 	dis_pool_put_buf - release the storage of a dis buffer, keeping it
+ * 	in the buffer pool if there is room and it is not too large
+ *
+ * @param[in] tp - dis buffer to release
+ *
+ * @return void
+ *
+ * @par MT-safe: Yes
+ *
+ */
+static void
+dis_pool_put_buf(pbs_dis_buf_t *tp)
+{
+	if (tp->tdis_data == NULL)
+		return;
+
+	if (tp->tdis_bufsize <= DIS_BUF_POOL_MAXSZ) {
+		pthread_mutex_lock(&dis_buf_pool_lock);
+		if (dis_buf_pool_cnt < DIS_BUF_POOL_MAX) {
+			dis_buf_pool[dis_buf_pool_cnt].data = tp->tdis_data;
+			dis_buf_pool[dis_buf_pool_cnt].size = tp->tdis_bufsize;
+			dis_buf_pool_cnt++;
+			tp->tdis_data = NULL;
+		}
+		pthread_mutex_unlock(&dis_buf_pool_lock);
+	}
+
+	if (tp->tdis_data != NULL) {
+		free(tp->tdis_data);
+		__sync_fetch_and_sub(&dis_buf_bytes, (long) tp->tdis_bufsize);
+	}
+	tp->tdis_data = NULL;
+	tp->tdis_bufsize = 0;
+}
+
+/**
+ * @brief
+ * 	dis_buf_mem - bytes of storage held by the dis channel buffers,
+ * 	including the buffers kept in the pool
+ *
+ * @return long
+ *
+ * @par MT-safe: Yes
+ *
+ */
+long
+dis_buf_mem(void)
+{
+	return __sync_fetch_and_add(&dis_buf_bytes, 0);
+}
+
 /**
  * @brief
  * 	dis_clear_buf - reset dis buffer to empty by updating its counter
@@ -848,14 +955,8 @@ dis_destroy_chan(int fd)
 			chan->auths[FOR_ENCRYPT].def = NULL;
 			chan->auths[FOR_ENCRYPT].ctx_status = AUTH_STATUS_UNKNOWN;
 		}
-		if (chan->readbuf.tdis_data) {
-			free(chan->readbuf.tdis_data);
-			chan->readbuf.tdis_data = NULL;
-		}
-		if (chan->writebuf.tdis_data) {
-			free(chan->writebuf.tdis_data);
-			chan->writebuf.tdis_data = NULL;
-		}
+		dis_pool_put_buf(&chan->readbuf);
+		dis_pool_put_buf(&chan->writebuf);
 		free(chan);
 		transport_set_chan(fd, NULL);
 	}
@@ -890,8 +991,8 @@ dis_setup_chan(int fd, pbs_tcp_chan_t *(*inner_transport_get_chan)(int) )
 			return;
 		chan = (pbs_tcp_chan_t *) calloc(1, sizeof(pbs_tcp_chan_t));
 		assert(chan != NULL);
-		dis_resize_buf(&(chan->readbuf), PBS_DIS_BUFSZ);
-		dis_resize_buf(&(chan->writebuf), PBS_DIS_BUFSZ);
+		dis_pool_get_buf(&(chan->readbuf));
+		dis_pool_get_buf(&(chan->writebuf));
 		rc = transport_set_chan(fd, chan);
 		assert(rc == 0);
 	}
@@ -82,6 +82,7 @@
 static int
 disrd_(int stream, unsigned count, unsigned *ndigs, unsigned *nskips, double *dval, int recursv)
 {
+	char *disbuf = dis_buffer;
 	int c;
 	int negate;
 	unsigned unum;
@@ -148,13 +149,13 @@ disrd_(int stream, unsigned count, unsigned *ndigs, unsigned *nskips, double *dv
 			if (count > 1) {
 				if (count > dis_umaxd)
 					break;
-				if (dis_gets(stream, dis_buffer + 1, count - 1) !=
+				if (dis_gets(stream, disbuf + 1, count - 1) !=
 				    count - 1)
 					return (DIS_EOD);
-				cp = dis_buffer;
+				cp = disbuf;
 				if (count == dis_umaxd) {
 					*cp = c;
-					if (memcmp(dis_buffer, dis_umax, dis_umaxd) > 0)
+					if (memcmp(disbuf, dis_umax, dis_umaxd) > 0)
 						break;
 				}
 				while (--count) {
@@ -63,6 +63,7 @@
 int
 disrl_(int stream, dis_long_double_t *ldval, unsigned *ndigs, unsigned *nskips, unsigned sigd, unsigned count, int recursv)
 {
+	char *disbuf = dis_buffer;
 	int c;
 	int negate;
 	unsigned unum;
@@ -132,13 +133,13 @@ disrl_(int stream, dis_long_double_t *ldval, unsigned *ndigs, unsigned *nskips,
 			if (count > 1) {
 				if (count > dis_umaxd)
 					break;
-				if (dis_gets(stream, dis_buffer + 1, count - 1) !=
+				if (dis_gets(stream, disbuf + 1, count - 1) !=
 				    count - 1)
 					return (DIS_EOD);
-				cp = dis_buffer;
+				cp = disbuf;
 				if (count == dis_umaxd) {
 					*cp = c;
-					if (memcmp(dis_buffer, dis_umax, dis_umaxd) > 0)
+					if (memcmp(disbuf, dis_umax, dis_umaxd) > 0)
 						break;
 				}
 				while (--count) {
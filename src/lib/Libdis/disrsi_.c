@@ -63,6 +63,7 @@
 int
 disrsi_(int stream, int *negate, unsigned *value, unsigned count, int recursv)
 {
+	char *disbuf = dis_buffer;
 	int c;
 	unsigned locval;
 	unsigned ndigs;
@@ -82,13 +83,13 @@ disrsi_(int stream, int *negate, unsigned *value, unsigned count, int recursv)
 			*negate = c == '-';
 			if (count > dis_umaxd)
 				goto overflow;
-			if (dis_gets(stream, dis_buffer, count) != count)
+			if (dis_gets(stream, disbuf, count) != count)
 				return (DIS_EOD);
 			if (count == dis_umaxd) {
-				if (memcmp(dis_buffer, dis_umax, dis_umaxd) > 0)
+				if (memcmp(disbuf, dis_umax, dis_umaxd) > 0)
 					goto overflow;
 			}
-			cp = dis_buffer;
+			cp = disbuf;
 			locval = 0;
 			do {
 				if ((c = *cp++) < '0' || c > '9')
@@ -112,13 +113,13 @@ disrsi_(int stream, int *negate, unsigned *value, unsigned count, int recursv)
 			if (count > 1) {
 				if (count > dis_umaxd)
 					break;
-				if (dis_gets(stream, dis_buffer + 1, count - 1) !=
+				if (dis_gets(stream, disbuf + 1, count - 1) !=
 				    count - 1)
 					return (DIS_EOD);
-				cp = dis_buffer;
+				cp = disbuf;
 				if (count == dis_umaxd) {
 					*cp = c;
-					if (memcmp(dis_buffer, dis_umax, dis_umaxd) > 0)
+					if (memcmp(disbuf, dis_umax, dis_umaxd) > 0)
 						break;
 				}
 				while (--count) {
@@ -65,6 +65,7 @@ extern unsigned ulmaxdigs;
 int
 disrsl_(int stream, int *negate, unsigned long *value, unsigned long count, int recursv)
 {
+	char *disbuf = dis_buffer;
 	int c;
 	unsigned long locval;
 	unsigned long ndigs;
@@ -84,13 +85,13 @@ disrsl_(int stream, int *negate, unsigned long *value, unsigned long count, int
 			if (count > ulmaxdigs)
 				goto overflow;
 			*negate = c == '-';
-			if (dis_gets(stream, dis_buffer, count) != count)
+			if (dis_gets(stream, disbuf, count) != count)
 				return (DIS_EOD);
 			if (count == ulmaxdigs) {
-				if (memcmp(dis_buffer, ulmax, ulmaxdigs) > 0)
+				if (memcmp(disbuf, ulmax, ulmaxdigs) > 0)
 					goto overflow;
 			}
-			cp = dis_buffer;
+			cp = disbuf;
 			locval = 0;
 			do {
 				if ((c = *cp++) < '0' || c > '9')
@@ -114,13 +115,13 @@ disrsl_(int stream, int *negate, unsigned long *value, unsigned long count, int
 			if (count > 1) {
 				if (count > ulmaxdigs)
 					break;
-				if (dis_gets(stream, dis_buffer + 1, count - 1) !=
+				if (dis_gets(stream, disbuf + 1, count - 1) !=
 				    count - 1)
 					return (DIS_EOD);
-				cp = dis_buffer;
+				cp = disbuf;
 				if (count == ulmaxdigs) {
 					*cp = c;
-					if (memcmp(dis_buffer, ulmax, ulmaxdigs) > 0)
+					if (memcmp(disbuf, ulmax, ulmaxdigs) > 0)
 						break;
 				}
 				while (--count) {
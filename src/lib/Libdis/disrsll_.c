@@ -81,6 +81,7 @@ init_ulmax()
 int
 disrsll_(int stream, int *negate, u_Long *value, unsigned long count, int recursv)
 {
+	char *disbuf = dis_buffer;
 	int c;
 	u_Long locval;
 	unsigned long ndigs;
@@ -101,13 +102,13 @@ disrsll_(int stream, int *negate, u_Long *value, unsigned long count, int recurs
 			*negate = (c == '-');
 			if (count > ulmaxdigs)
 				goto overflow;
-			if (dis_gets(stream, dis_buffer, count) != count)
+			if (dis_gets(stream, disbuf, count) != count)
 				return (DIS_EOD);
 			if (count == ulmaxdigs) {
-				if (memcmp(dis_buffer, ulmax, ulmaxdigs) > 0)
+				if (memcmp(disbuf, ulmax, ulmaxdigs) > 0)
 					goto overflow;
 			}
-			cp = dis_buffer;
+			cp = disbuf;
 			locval = 0;
 			do {
 				if ((c = *cp++) < '0' || c > '9')
@@ -131,13 +132,13 @@ disrsll_(int stream, int *negate, u_Long *value, unsigned long count, int recurs
 			if (count > 1) {
 				if (count > ulmaxdigs)
 					break;
-				if (dis_gets(stream, dis_buffer + 1, count - 1) !=
+				if (dis_gets(stream, disbuf + 1, count - 1) !=
 				    count - 1)
 					return (DIS_EOD);
-				cp = dis_buffer;
+				cp = disbuf;
 				if (count == ulmaxdigs) {
 					*cp = c;
-					if (memcmp(dis_buffer, ulmax, ulmaxdigs) > 0)
+					if (memcmp(disbuf, ulmax, ulmaxdigs) > 0)
 						break;
 				}
 				while (--count) {
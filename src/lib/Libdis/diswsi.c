@@ -88,6 +88,7 @@
 int
 diswsi(int stream, int value)
 {
+	char *disbuf = dis_buffer;
 	int retval;
 	unsigned ndigs;
 	unsigned uval;
@@ -103,12 +104,12 @@ diswsi(int stream, int value)
 		uval = value;
 		c = '+';
 	}
-	cp = discui_(&dis_buffer[DIS_BUFSIZ], uval, &ndigs);
+	cp = discui_(&disbuf[DIS_BUFSIZ], uval, &ndigs);
 	*--cp = c;
 	while (ndigs > 1)
 		cp = discui_(cp, ndigs, &ndigs);
 	retval = dis_puts(stream, cp,
-			  (size_t) (&dis_buffer[DIS_BUFSIZ] - cp)) < 0
+			  (size_t) (&disbuf[DIS_BUFSIZ] - cp)) < 0
 			 ? DIS_PROTO
 			 : DIS_SUCCESS;
 	return retval;
@@ -88,6 +88,7 @@
 int
 diswsl(int stream, long value)
 {
+	char *disbuf = dis_buffer;
 	int retval;
 	unsigned ndigs;
 	unsigned long ulval;
@@ -103,12 +104,12 @@ diswsl(int stream, long value)
 		ulval = value;
 		c = '+';
 	}
-	cp = discul_(&dis_buffer[DIS_BUFSIZ], ulval, &ndigs);
+	cp = discul_(&disbuf[DIS_BUFSIZ], ulval, &ndigs);
 	*--cp = c;
 	while (ndigs > 1)
 		cp = discui_(cp, ndigs, &ndigs);
 	retval = dis_puts(stream, cp,
-			  (size_t) (&dis_buffer[DIS_BUFSIZ] - cp)) < 0
+			  (size_t) (&disbuf[DIS_BUFSIZ] - cp)) < 0
 			 ? DIS_PROTO
 			 : DIS_SUCCESS;
 	return retval;
@@ -64,16 +64,17 @@
 int
 diswui_(int stream, unsigned value)
 {
+	char *disbuf = dis_buffer;
 	unsigned ndigs;
 	char *cp;
 
 	assert(stream >= 0);
 
-	cp = discui_(&dis_buffer[DIS_BUFSIZ], value, &ndigs);
+	cp = discui_(&disbuf[DIS_BUFSIZ], value, &ndigs);
 	*--cp = '+';
 	while (ndigs > 1)
 		cp = discui_(cp, ndigs, &ndigs);
-	if (dis_puts(stream, cp, (size_t) (&dis_buffer[DIS_BUFSIZ] - cp)) < 0)
+	if (dis_puts(stream, cp, (size_t) (&disbuf[DIS_BUFSIZ] - cp)) < 0)
 		return (DIS_PROTO);
 	return (DIS_SUCCESS);
 }
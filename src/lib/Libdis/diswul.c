@@ -88,17 +88,18 @@
 int
 diswul(int stream, unsigned long value)
 {
+	char *disbuf = dis_buffer;
 	int retval;
 	unsigned ndigs;
 	char *cp;
 
 	assert(stream >= 0);
-	cp = discul_(&dis_buffer[DIS_BUFSIZ], value, &ndigs);
+	cp = discul_(&disbuf[DIS_BUFSIZ], value, &ndigs);
 	*--cp = '+';
 	while (ndigs > 1)
 		cp = discui_(cp, ndigs, &ndigs);
 	retval = dis_puts(stream, cp,
-			  (size_t) (&dis_buffer[DIS_BUFSIZ] - cp)) < 0
+			  (size_t) (&disbuf[DIS_BUFSIZ] - cp)) < 0
 			 ? DIS_PROTO
 			 : DIS_SUCCESS;
 	return retval;
@@ -52,6 +52,8 @@
 #include <sys/types.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <pthread.h>
 
 #include "pbs_ifl.h"
 #include "pbs_ecl.h"
@@ -68,6 +70,21 @@
 static enum batch_op seljobs_opstring_enums[] = {EQ, NE, GE, GT, LE, LT};
 static int size_seljobs = sizeof(seljobs_opstring_enums) / sizeof(enum batch_op);
 
+/*
+ * Name sorted index over one of the ecl definition tables, so that looking
+ * up an attribute or resource is a binary search rather than a strncasecmp
+ * walk of the whole table for every attribute in every IFL call.
+ */
+typedef struct ecl_def_index {
+	ecl_attribute_def *def_table; /* the table this index covers */
+	int def_size;		      /* entries in def_table */
+	ecl_attribute_def **sorted;   /* NULL if the index could not be built */
+} ecl_def_index;
+
+static ecl_def_index ecl_def_indexes[8];
+static int ecl_def_index_count = 0;
+static pthread_once_t ecl_def_index_once = PTHREAD_ONCE_INIT;
+
 /* static function declarations */
 static int
 __pbs_verify_attributes(int connect, int batch_request,
@@ -79,6 +96,8 @@ static struct ecl_attribute_def *ecl_findattr(int, struct attropl *);
 static struct ecl_attribute_def *ecl_find_attr_in_def(
 	struct ecl_attribute_def *, char *, int);
 static int get_attr_type(struct ecl_attribute_def attr_def);
+static ecl_attribute_def *ecl_index_lookup(ecl_attribute_def *, int,
+					   char *, size_t);
 
 /* default function pointer assignments */
 int (*pfn_pbs_verify_attributes)(int connect, int batch_request,
@@ -542,6 +561,143 @@ verify_attributes(int batch_request, int parent_object, int cmd,
 	return failure_count;
 }
 
+/**
+ * @brief
+ *	qsort comparator ordering ecl definitions by name, case insensitive.
+ *	Equal names keep their table order so the first definition wins,
+ *	exactly as with a linear walk.
+ */
+static int
+ecl_def_cmp(const void *a, const void *b)
+{
+	const ecl_attribute_def *da = *(ecl_attribute_def *const *) a;
+	const ecl_attribute_def *db = *(ecl_attribute_def *const *) b;
+	int rc;
+
+	rc = strcasecmp(da->at_name, db->at_name);
+	if (rc == 0)
+		rc = (da < db) ? -1 : (da > db);
+	return rc;
+}
+
+/**
+ * @brief
+ *	Build the sorted name index for one definition table.
+ *
+ * @param[in]	table	-	the definition table
+ * @param[in]	size	-	number of entries in the table
+ *
+ * @par MT-safe: No - called only from ecl_def_index_init
+ */
+static void
+ecl_def_index_add(ecl_attribute_def *table, int size)
+{
+	ecl_def_index *idx;
+	int i;
+
+	if (ecl_def_index_count >= (int) (sizeof(ecl_def_indexes) / sizeof(ecl_def_indexes[0])))
+		return;
+	idx = &ecl_def_indexes[ecl_def_index_count++];
+	idx->def_table = table;
+	idx->def_size = size;
+	idx->sorted = NULL;
+
+	if (size <= 0)
+		return;
+	if ((idx->sorted = malloc(size * sizeof(ecl_attribute_def *))) == NULL)
+		return; /* lookups fall back to walking the table */
+	for (i = 0; i < size; i++)
+		idx->sorted[i] = &table[i];
+	qsort(idx->sorted, size, sizeof(ecl_attribute_def *), ecl_def_cmp);
+}
+
+/**
+ * @brief
+ *	Build the name indexes for all the ecl definition tables, run once
+ *	per process through pthread_once.
+ */
+static void
+ecl_def_index_init(void)
+{
+	ecl_def_index_add(ecl_job_attr_def, ecl_job_attr_size);
+	ecl_def_index_add(ecl_svr_attr_def, ecl_svr_attr_size);
+	ecl_def_index_add(ecl_sched_attr_def, ecl_sched_attr_size);
+	ecl_def_index_add(ecl_que_attr_def, ecl_que_attr_size);
+	ecl_def_index_add(ecl_node_attr_def, ecl_node_attr_size);
+	ecl_def_index_add(ecl_resv_attr_def, ecl_resv_attr_size);
+	ecl_def_index_add(ecl_svr_resc_def, ecl_svr_resc_size);
+}
+
+/**
+ * @brief
+ *	Find the definition whose name is exactly the first keylen characters
+ *	of name, ignoring case.
+ *
+ * @par Functionality:
+ *	Uses the sorted index of the table when one exists, otherwise walks the
+ *	table. Either way, the first matching entry in table order is returned.
+ *
+ * @param[in]	table	-	definition table to search
+ * @param[in]	limit	-	number of entries in table
+ * @param[in]	name	-	name to look for
+ * @param[in]	keylen	-	number of characters of name to match
+ *
+ * @return	ecl_attribute_def *
+ * @retval	the matching definition
+ * @retval	NULL if there is none
+ *
+ * @par MT-safe: Yes
+ */
+static ecl_attribute_def *
+ecl_index_lookup(ecl_attribute_def *table, int limit, char *name, size_t keylen)
+{
+	ecl_def_index *idx = NULL;
+	int lo;
+	int hi;
+	int i;
+
+	(void) pthread_once(&ecl_def_index_once, ecl_def_index_init);
+
+	for (i = 0; i < ecl_def_index_count; i++) {
+		if (ecl_def_indexes[i].def_table == table &&
+		    ecl_def_indexes[i].def_size == limit) {
+			idx = &ecl_def_indexes[i];
+			break;
+		}
+	}
+
+	if (idx == NULL || idx->sorted == NULL) {
+		for (i = 0; i < limit; i++) {
+			if (strncasecmp(name, table[i].at_name, keylen) == 0 &&
+			    table[i].at_name[keylen] == '\0')
+				return &table[i];
+		}
+		return NULL;
+	}
+
+	/* lower bound: first sorted entry not less than the key */
+	lo = 0;
+	hi = idx->def_size;
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+		char *at_name = idx->sorted[mid]->at_name;
+		int rc = strncasecmp(name, at_name, keylen);
+
+		/* a key that is a proper prefix of at_name sorts before it */
+		if (rc == 0 && at_name[keylen] != '\0')
+			rc = -1;
+		if (rc > 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo < idx->def_size &&
+	    strncasecmp(name, idx->sorted[lo]->at_name, keylen) == 0 &&
+	    idx->sorted[lo]->at_name[keylen] == '\0')
+		return idx->sorted[lo];
+	return NULL;
+}
+
 /**
  * @brief
  *	Name: ecl_findattr
@@ -620,21 +776,14 @@ ecl_find_attr_in_def(
 	struct ecl_attribute_def *attr_def,
 	char *name, int limit)
 {
-	int index;
+	size_t keylen;
 
-	if (attr_def) {
-		for (index = 0; index < limit; index++) {
-			char *pc = NULL;
+	if (attr_def == NULL)
+		return NULL;
 
-			if (strncasecmp(name, attr_def[index].at_name,
-					strlen(attr_def[index].at_name)) == 0) {
-				pc = name + strlen(attr_def[index].at_name);
-				if ((*pc == '\0') || (*pc == '.') || (*pc == ','))
-					return &(attr_def[index]);
-			}
-		}
-	}
-	return NULL;
+	/* only the part before any ".resource" or ",..." names the attribute */
+	keylen = strcspn(name, ".,");
+	return (ecl_index_lookup(attr_def, limit, name, keylen));
 }
 
 /**
@@ -689,12 +838,7 @@ get_attr_type(struct ecl_attribute_def attr_def)
 struct ecl_attribute_def *
 ecl_find_resc_def(struct ecl_attribute_def *rscdf, char *name, int limit)
 {
-	while (limit--) {
-		if (strcasecmp(rscdf->at_name, name) == 0)
-			return (rscdf);
-		rscdf++;
-	}
-	return NULL;
+	return (ecl_index_lookup(rscdf, limit, name, strlen(name)));
 }
 
 /**
@@ -144,6 +144,193 @@ decode_DIS_CopyHookFile(int sock, struct batch_request *preq)
 	return rc;
 }
 
+/**
+ * @brief
+ *	-decode a Run Job List Batch Request
+ *
+ * @par	Functionality:
+ *	This function is used to decode the request to run a list of jobs,
+ *	each one on its own execvnode.
+ *
+ *      The batch_request structure must already exist (be allocated by the
+ *      caller.   It is assumed that the header fields (protocol type,
+ *      protocol version, request type, and user name) have already be decoded.
+ *
+ * @par	Data items are:\n
+ *		unsigned int	count\n
+ *		string		job id\n
+ *		string		destination (repeated with job id count times)
+ *
+ * @param[in] sock - socket descriptor
+ * @param[out] preq - pointer to batch_request structure
+ *
+ * @return      int
+ * @retval      DIS_SUCCESS(0)  success
+ * @retval      error code      error
+ *
+ */
+
+int
+decode_DIS_RunJobList(int sock, struct batch_request *preq)
+{
+	int rc;
+	int count;
+	int i;
+	char **jobs;
+	char **destins;
+
+	preq->rq_ind.rq_runjoblist.rq_count = 0;
+	preq->rq_ind.rq_runjoblist.rq_jobslist = NULL;
+	preq->rq_ind.rq_runjoblist.rq_destinlist = NULL;
+
+	count = disrui(sock, &rc);
+	if (rc)
+		return rc;
+	if ((count < 0) || (count > PBS_MAX_RUNJOBLIST))
+		return DIS_PROTO;
+
+	jobs = calloc(count + 1, sizeof(char *));
+	destins = calloc(count + 1, sizeof(char *));
+	if (jobs == NULL || destins == NULL) {
+		free(jobs);
+		free(destins);
+		return DIS_NOMALLOC;
+	}
+
+	for (i = 0; i < count; i++) {
+		jobs[i] = disrst(sock, &rc);
+		if (rc == 0)
+			destins[i] = disrst(sock, &rc);
+		if (rc)
+			break;
+	}
+
+	if (rc) {
+		for (i = 0; i < count; i++) {
+			free(jobs[i]);
+			free(destins[i]);
+		}
+		free(jobs);
+		free(destins);
+		return rc;
+	}
+
+	preq->rq_ind.rq_runjoblist.rq_count = count;
+	preq->rq_ind.rq_runjoblist.rq_jobslist = jobs;
+	preq->rq_ind.rq_runjoblist.rq_destinlist = destins;
+
+	return rc;
+}
+
+/**
+ * @brief
+ *	Decode a Subscribe request.
+ *
+ *      The batch_request structure must already exist (be allocated by the
+ *      caller.   It is assumed that the header fields (protocol type,
+ *      protocol version, request type, and user name) have already be decoded.
+ *
+ * @par	Data items are:\n
+ *		unsigned int	object type\n
+ *		string		filter
+ *
+ * @param[in] sock - socket descriptor
+ * @param[out] preq - pointer to batch_request structure
+ *
+ * @return      int
+ * @retval      DIS_SUCCESS(0)  success
+ * @retval      error code      error
+ *
+ */
+int
+decode_DIS_Subscribe(int sock, struct batch_request *preq)
+{
+	int rc;
+
+	preq->rq_ind.rq_subscribe.rq_objtype = disrui(sock, &rc);
+	if (rc)
+		return rc;
+
+	return (disrfst(sock, sizeof(preq->rq_ind.rq_subscribe.rq_filter),
+			preq->rq_ind.rq_subscribe.rq_filter));
+}
+
+/**
+ * @brief
+ *	-decode a Modify Job List Batch Request
+ *
+ * @par	Functionality:
+ *	This function is used to decode the async request to set attributes
+ *	on a list of jobs, each job with its own attribute list.
+ *
+ *      The batch_request structure must already exist (be allocated by the
+ *      caller.   It is assumed that the header fields (protocol type,
+ *      protocol version, request type, and user name) have already be decoded.
+ *
+ * @par	Data items are:\n
+ *		unsigned int	count\n
+ *		followed by count Manage requests, see decode_DIS_Manage()
+ *
+ * @param[in] sock - socket descriptor
+ * @param[out] preq - pointer to batch_request structure
+ *
+ * @return      int
+ * @retval      DIS_SUCCESS(0)  success
+ * @retval      error code      error
+ *
+ */
+
+int
+decode_DIS_ModifyJobList(int sock, struct batch_request *preq)
+{
+	int rc;
+	int count;
+	int i;
+	struct rq_manage *mods;
+
+	preq->rq_ind.rq_modifyjoblist.rq_count = 0;
+	preq->rq_ind.rq_modifyjoblist.rq_mods = NULL;
+
+	count = disrui(sock, &rc);
+	if (rc)
+		return rc;
+	if (count < 0)
+		return DIS_PROTO;
+
+	mods = calloc(count + 1, sizeof(struct rq_manage));
+	if (mods == NULL)
+		return DIS_NOMALLOC;
+	for (i = 0; i < count; i++)
+		CLEAR_HEAD(mods[i].rq_attr);
+
+	for (i = 0; i < count; i++) {
+		mods[i].rq_cmd = disrui(sock, &rc);
+		if (rc)
+			break;
+		mods[i].rq_objtype = disrui(sock, &rc);
+		if (rc)
+			break;
+		rc = disrfst(sock, PBS_MAXSVRJOBID + 1, mods[i].rq_objname);
+		if (rc)
+			break;
+		rc = decode_DIS_svrattrl(sock, &mods[i].rq_attr);
+		if (rc)
+			break;
+	}
+
+	if (rc) {
+		for (i = 0; i < count; i++)
+			free_attrlist(&mods[i].rq_attr);
+		free(mods);
+		return rc;
+	}
+
+	preq->rq_ind.rq_modifyjoblist.rq_count = count;
+	preq->rq_ind.rq_modifyjoblist.rq_mods = mods;
+
+	return rc;
+}
+
 /**
  * @brief
  *	decode a Job Credential batch request
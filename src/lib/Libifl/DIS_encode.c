@@ -78,6 +78,64 @@ encode_DIS_JobsList(int sock, char **jobs_list, int numofjobs)
 	return rc;
 }
 
+/**
+ * @brief encode the Run Job List request for sending to the server.
+ *
+ * @par	Data items are:\n
+ *		unsigned int	count\n
+ *		string		job id\n
+ *		string		location (repeated with job id count times)
+ *
+ * @param[in] sock - socket descriptor for the connection.
+ * @param[in] jobs_list - list of job ids.
+ * @param[in] locations - execvnode to run each job of jobs_list on.
+ * @param[in] numofjobs - number of entries in jobs_list and locations.
+ *
+ * @return - error code while writing data to the socket.
+ */
+int
+encode_DIS_RunJobList(int sock, char **jobs_list, char **locations, int numofjobs)
+{
+	int i;
+	int rc;
+
+	if ((rc = diswui(sock, numofjobs)) != 0)
+		return rc;
+
+	for (i = 0; i < numofjobs; i++) {
+		if ((rc = diswst(sock, jobs_list[i])) != 0)
+			return rc;
+		if ((rc = diswst(sock, locations[i] ? locations[i] : "")) != 0)
+			return rc;
+	}
+
+	return rc;
+}
+
+/**
+ * @brief encode the Subscribe request for sending to the server.
+ *
+ * @par	Data items are:\n
+ *		unsigned int	object type\n
+ *		string		filter
+ *
+ * @param[in] sock - socket descriptor for the connection.
+ * @param[in] obj_type - MGR_OBJ_JOB or MGR_OBJ_NODE.
+ * @param[in] filter - job owner to limit the events to, "" for all.
+ *
+ * @return - error code while writing data to the socket.
+ */
+int
+encode_DIS_Subscribe(int sock, int obj_type, const char *filter)
+{
+	int rc;
+
+	if ((rc = diswui(sock, obj_type)) != 0)
+		return rc;
+
+	return (diswst(sock, filter ? filter : ""));
+}
+
 /**
  *
  * @brief
@@ -431,6 +489,36 @@ encode_DIS_Manage(int sock, int command, int objtype, const char *objname, struc
 	return (encode_DIS_attropl(sock, aoplp));
 }
 
+/**
+ * @brief encode the Modify Job List request for sending to the server.
+ *
+ * @par	Data items are:\n
+ *		unsigned int	count\n
+ *		followed by count Manage requests setting the attributes of a job
+ *
+ * @param[in] sock - socket descriptor for the connection.
+ * @param[in] jobids - list of job ids.
+ * @param[in] aoplps - attributes to set on each job of jobids.
+ * @param[in] numofjobs - number of entries in jobids and aoplps.
+ *
+ * @return - error code while writing data to the socket.
+ */
+int
+encode_DIS_ModifyJobList(int sock, char **jobids, struct attropl **aoplps, int numofjobs)
+{
+	int i;
+	int rc;
+
+	if ((rc = diswui(sock, numofjobs)) != 0)
+		return rc;
+
+	for (i = 0; i < numofjobs; i++)
+		if ((rc = encode_DIS_Manage(sock, MGR_CMD_SET, MGR_OBJ_JOB, jobids[i], aoplps[i])) != 0)
+			return rc;
+
+	return rc;
+}
+
 /**
  * @brief encode the Modify Reservation request for sending to the server.
  *
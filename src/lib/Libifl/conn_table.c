@@ -133,6 +133,7 @@ add_connection(int fd)
 			free(connection[fd]->ch_errtxt);
 		connection[fd]->ch_errtxt = NULL;
 		connection[fd]->ch_errno = 0;
+		connection[fd]->ch_pending = 0;
 	}
 
 	return 0;
@@ -414,6 +415,46 @@ get_conn_errno(int fd)
 	return err;
 }
 
+/**
+ * @brief
+ * 	add_conn_pending - adjust the count of submitted but not yet
+ * 	collected status requests on connection synchronously
+ *
+ * @param[in] fd - socket number
+ * @param[in] delta - amount to add, negative to take
+ *
+ * @return int
+ * @retval >= 0 - new count
+ * @retval -1 - error, or count would go below zero (count unchanged)
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: Yes
+ */
+int
+add_conn_pending(int fd, int delta)
+{
+	pbs_conn_t *p = NULL;
+	int pending = -1;
+
+	if (INVALID_SOCK(fd))
+		return -1;
+
+	LOCK_TABLE(-1);
+	p = get_connection(fd);
+	if (p == NULL) {
+		UNLOCK_TABLE(-1);
+		return -1;
+	}
+	if (p->ch_pending + delta >= 0) {
+		p->ch_pending += delta;
+		pending = p->ch_pending;
+	}
+	UNLOCK_TABLE(-1);
+	return pending;
+}
+
 /**
  * @brief
  * 	set_conn_chan - set connection tcp chan synchronously
@@ -55,15 +55,81 @@
 
 #include <sys/types.h>
 #include <stdlib.h>
+#include <string.h>
 #include "attribute.h"
 #include "range.h"
 #include "libpbs.h"
 #include "job.h"
 #include "dis.h"
 
+/**
+ * @brief	Make sure an arena being decoded has room for len more bytes
+ *
+ * @param[in,out] pbuf - arena, may be moved
+ * @param[in,out] cap - allocated size of the arena
+ * @param[in] used - bytes of the arena in use
+ * @param[in] len - bytes needed
+ *
+ * @return int
+ * @retval 0 - success
+ * @retval -1 - out of memory
+ */
+static int
+arena_reserve(char **pbuf, size_t *cap, size_t used, size_t len)
+{
+	size_t newcap;
+	char *newbuf;
+
+	if (used + len <= *cap)
+		return 0;
+	newcap = *cap * 2;
+	if (newcap < used + len)
+		newcap = used + len;
+	newbuf = realloc(*pbuf, newcap);
+	if (newbuf == NULL)
+		return -1;
+	*pbuf = newbuf;
+	*cap = newcap;
+	return 0;
+}
+
+/**
+ * @brief	Read one string of an attribute into the arena
+ *
+ * @param[in] sock - socket from which status to be read
+ * @param[in] buf - arena
+ * @param[in,out] used - bytes of the arena in use, the string is put here
+ * @param[in,out] left - bytes left of the size the attribute announced
+ *
+ * @return int
+ * @retval DIS_SUCCESS - success
+ * @retval !DIS_SUCCESS - failure
+ */
+static int
+arena_read_str(int sock, char *buf, size_t *used, size_t *left)
+{
+	size_t len;
+	int rc;
+
+	if (*left == 0)
+		return DIS_PROTO;
+	if ((rc = disrfst(sock, *left - 1, buf + *used)) != DIS_SUCCESS)
+		return rc;
+	len = strlen(buf + *used) + 1;
+	*used += len;
+	*left -= len;
+	return DIS_SUCCESS;
+}
+
 /**
  * @brief	Read one batch status from given socket
  *
+ * 	The batch status, its attrl entries and their strings are decoded into
+ * 	a single allocation (see struct bs_arena) instead of one allocation per
+ * 	string, so that a large status reply costs a few mallocs per object and
+ * 	pbs_statfree() a single free().  While decoding, the arena may move, so
+ * 	the string pointers hold offsets into it until the end.
+ *
  * @param[in]  sock - socket from which status to be read
  * @param[out] objtype - type of batch status
  * @param[out] rc - error code if any failure in read
@@ -75,7 +141,18 @@
 static struct batch_status *
 read_batch_status(int sock, int *objtype, int *rc)
 {
+	struct bs_arena *arena;
 	struct batch_status *pstcmd;
+	struct attrl *pat;
+	char *buf = NULL;
+	char *nbuf;
+	char *name;
+	size_t cap;
+	size_t used;
+	size_t left;
+	size_t nameoff;
+	unsigned int numpat;
+	unsigned int i;
 
 	if (rc == NULL || objtype == NULL) {
 		if (rc)
@@ -83,23 +160,84 @@ read_batch_status(int sock, int *objtype, int *rc)
 		return NULL;
 	}
 
-	pstcmd = (struct batch_status *) malloc(sizeof(struct batch_status));
-	if (pstcmd == NULL) {
-		*rc = DIS_NOMALLOC;
+	*objtype = disrui(sock, rc);
+	if (*rc)
+		return NULL;
+	name = disrst(sock, rc);
+	if (*rc)
+		return NULL;
+	numpat = disrui(sock, rc);
+	if (*rc) {
+		free(name);
 		return NULL;
 	}
-	init_bstat(pstcmd);
 
-	*objtype = disrui(sock, rc);
-	if (*rc == DIS_SUCCESS)
-		pstcmd->name = disrst(sock, rc);
+	/* header and attrl entries, then the strings, guessing at their size */
+	used = sizeof(struct bs_arena) + numpat * sizeof(struct attrl);
+	cap = used + strlen(name) + 1 + numpat * 64;
+	if ((buf = malloc(cap)) == NULL) {
+		free(name);
+		*rc = DIS_NOMALLOC;
+		return NULL;
+	}
+	nameoff = used;
+	strcpy(buf + used, name);
+	used += strlen(name) + 1;
+	free(name);
+
+	for (i = 0; i < numpat; i++) {
+		left = disrui(sock, rc);
+		if (*rc)
+			break;
+		if (arena_reserve(&buf, &cap, used, left) != 0) {
+			*rc = DIS_NOMALLOC;
+			break;
+		}
+		pat = (struct attrl *) (buf + sizeof(struct bs_arena)) + i;
+		pat->resource = NULL;
+		pat->name = (char *) used;
+		if ((*rc = arena_read_str(sock, buf, &used, &left)) != DIS_SUCCESS)
+			break;
+		if (disrui(sock, rc)) {
+			if (*rc)
+				break;
+			pat->resource = (char *) used;
+			if ((*rc = arena_read_str(sock, buf, &used, &left)) != DIS_SUCCESS)
+				break;
+		} else if (*rc)
+			break;
+		pat->value = (char *) used;
+		if ((*rc = arena_read_str(sock, buf, &used, &left)) != DIS_SUCCESS)
+			break;
+		pat->op = (enum batch_op) disrui(sock, rc);
+		if (*rc)
+			break;
+	}
 	if (*rc) {
-		pbs_statfree(pstcmd);
+		free(buf);
 		return NULL;
 	}
-	*rc = decode_DIS_attrl(sock, &pstcmd->attribs);
-	if (*rc)
-		pbs_statfree(pstcmd);
+
+	/* the arena does not move any more, turn the offsets into pointers */
+	if (used < cap && (nbuf = realloc(buf, used)) != NULL)
+		buf = nbuf;
+	arena = (struct bs_arena *) buf;
+	arena->ba_size = used;
+	pstcmd = &arena->ba_bs;
+	pstcmd->next = NULL;
+	pstcmd->name = buf + nameoff;
+	pstcmd->text = bs_arena_mark;
+	pstcmd->attribs = NULL;
+	pat = (struct attrl *) (buf + sizeof(struct bs_arena));
+	for (i = 0; i < numpat; i++, pat++) {
+		pat->name = buf + (size_t) pat->name;
+		if (pat->resource)
+			pat->resource = buf + (size_t) pat->resource;
+		pat->value = buf + (size_t) pat->value;
+		pat->next = (i + 1 < numpat) ? pat + 1 : NULL;
+	}
+	if (numpat > 0)
+		pstcmd->attribs = (struct attrl *) (buf + sizeof(struct bs_arena));
 	return pstcmd;
 }
 
@@ -257,6 +395,29 @@ cmp_sj_name(struct batch_status *a, struct batch_status *b)
 	return 0;
 }
 
+/**
+ * @brief	add status objects to a reply, or hand them to the reply's
+ *		status callback if it has one
+ *
+ * @param[in,out] reply - the reply being decoded
+ * @param[in,out] pstcx - where the next object goes in the reply's list
+ * @param[in] first - first object to add
+ * @param[in] last - last object in the list starting at first
+ *
+ * @return void
+ */
+static void
+add_status(struct batch_reply *reply, struct batch_status ***pstcx,
+	   struct batch_status *first, struct batch_status *last)
+{
+	if (reply->brp_status_cb != NULL) {
+		reply->brp_status_cb(first, reply->brp_status_arg);
+		return;
+	}
+	**pstcx = first;
+	*pstcx = &last->next;
+}
+
 /**
  * @brief-
  *	decode a Batch Protocol Reply Structure for a Command
@@ -391,8 +552,7 @@ again:
 						pstcmd_ja->next = bs_isort(pstcmd_ja->next, cmp_sj_name);
 						for (pstcmd_last = pstcmd_ja; pstcmd_last->next; pstcmd_last = pstcmd_last->next)
 							;
-						*pstcx = pstcmd_ja;
-						pstcx = &pstcmd_last->next;
+						add_status(reply, &pstcx, pstcmd_ja, pstcmd_last);
 						pstcmd_ja = NULL;
 					}
 					if (expand_remaining_subjob(pstcmd, &reply->brp_count) != 0) {
@@ -410,27 +570,26 @@ again:
 						pstcmd_ja->next = bs_isort(pstcmd_ja->next, cmp_sj_name);
 						for (pstcmd_last = pstcmd_ja; pstcmd_last->next; pstcmd_last = pstcmd_last->next)
 							;
-						*pstcx = pstcmd_ja;
-						pstcx = &pstcmd_last->next;
+						add_status(reply, &pstcx, pstcmd_ja, pstcmd_last);
 						pstcmd_ja = NULL;
 					}
-					*pstcx = pstcmd;
-					pstcx = &pstcmd->next;
+					add_status(reply, &pstcx, pstcmd, pstcmd);
 				}
 			}
+			/* the subjobs of the last array job may continue in the next part */
+			if (reply->brp_is_part)
+				goto again;
+
 			if (pstcmd_ja != NULL) {
 				pstcmd_ja->next = bs_isort(pstcmd_ja->next, cmp_sj_name);
 				for (pstcmd_last = pstcmd_ja; pstcmd_last->next; pstcmd_last = pstcmd_last->next)
 					;
-				*pstcx = pstcmd_ja;
-				pstcx = &pstcmd_last->next;
+				add_status(reply, &pstcx, pstcmd_ja, pstcmd_last);
 				pstcmd = pstcmd_last;
 			}
 
 			if (reply->brp_un.brp_statc)
 				reply->last = pstcmd;
-			if (reply->brp_is_part)
-				goto again;
 			break;
 
 		case BATCH_REPLY_CHOICE_Delete:
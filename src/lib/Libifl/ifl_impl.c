@@ -112,6 +112,26 @@ pbs_alterjob(int c, const char *jobid, struct attrl *attrib, const char *extend)
 	return (*pfn_pbs_alterjob)(c, jobid, attrib, extend);
 }
 
+/**
+ * @brief
+ *	-Pass-through call to send ModifyJobList request
+ *
+ * @param[in] c - connection handle
+ * @param[in] jobids - array of job identifiers
+ * @param[in] attribs - attributes to set on each job of jobids
+ * @param[in] numjobs - number of jobs
+ * @param[in] extend - extend string for encoding req
+ *
+ * @return	struct batch_deljob_status *
+ * @retval	list of jobs which could not be modified
+ *
+ */
+struct batch_deljob_status *
+pbs_alterjoblist(int c, char **jobids, struct attrl **attribs, int numjobs, const char *extend)
+{
+	return (*pfn_pbs_alterjoblist)(c, jobids, attribs, numjobs, extend);
+}
+
 /**
  * @brief
  *	-Pass-through call to send alter Job request
@@ -133,6 +153,27 @@ pbs_asyalterjob(int c, const char *jobid, struct attrl *attrib, const char *exte
 	return (*pfn_pbs_asyalterjob)(c, jobid, attrib, extend);
 }
 
+/**
+ * @brief
+ *	-Pass-through call to send async ModifyJobList request
+ *
+ * @param[in] c - connection handle
+ * @param[in] jobids - array of job identifiers
+ * @param[in] attribs - attributes to set on each job of jobids
+ * @param[in] numjobs - number of jobs
+ * @param[in] extend - extend string for encoding req
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	!0	error
+ *
+ */
+int
+pbs_asyalterjoblist(int c, char **jobids, struct attrl **attribs, int numjobs, const char *extend)
+{
+	return (*pfn_pbs_asyalterjoblist)(c, jobids, attribs, numjobs, extend);
+}
+
 /**
  * @brief
  * 	-pbs_confirmresv - this function is for exclusive use by the Scheduler
@@ -515,6 +556,26 @@ pbs_runjob(int c, const char *jobid, const char *location, const char *extend)
 	return (*pfn_pbs_runjob)(c, jobid, location, extend);
 }
 
+/**
+ * @brief
+ *	-Pass-through call to send RunJobList request
+ *
+ * @param[in] c - communication handle
+ * @param[in] jobids - array of job identifiers
+ * @param[in] locations - execvnode for each job in jobids
+ * @param[in] numjobs - number of jobs
+ * @param[in] extend - extend string to encode req
+ *
+ * @return	struct batch_deljob_status *
+ * @retval	list of jobs which could not be run
+ *
+ */
+struct batch_deljob_status *
+pbs_runjoblist(int c, char **jobids, char **locations, int numjobs, const char *extend)
+{
+	return (*pfn_pbs_runjoblist)(c, jobids, locations, numjobs, extend);
+}
+
 /**
  * @brief
  *	-Pass-through call to send SelectJob request
@@ -645,6 +706,53 @@ pbs_selstat(int c, struct attropl *attrib, struct attrl *rattrib, const char *ex
 	return (*pfn_pbs_selstat)(c, attrib, rattrib, extend);
 }
 
+/**
+ * @brief
+ *	-Pass-through call to SelectJob request which hands each job to
+ *	a callback as it is decoded
+ *
+ * @param[in] c - communication handle
+ * @param[in] attrib - pointer to attropl structure(selection criteria)
+ * @param[in] rattrib - list of attributes to return
+ * @param[in] extend - extend string to encode req
+ * @param[in] cb - called with each job
+ * @param[in] arg - passed to cb
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	!0	error (pbs_errno)
+ *
+ */
+int
+pbs_selstat_stream(int c, struct attropl *attrib, struct attrl *rattrib, const char *extend, pbs_status_cb cb, void *arg)
+{
+	return (*pfn_pbs_selstat_stream)(c, attrib, rattrib, extend, cb, arg);
+}
+
+/**
+ * @brief
+ *	-Pass-through call to Select Action request which applies an action
+ *	to every job meeting the selection criteria
+ *
+ * @param[in] c - communication handle
+ * @param[in] attrib - pointer to attropl structure(selection criteria)
+ * @param[in] action - SELACT_DELETE, SELACT_HOLD, SELACT_RELEASE or SELACT_ALTER
+ * @param[in] args - attributes of the action
+ * @param[in] extend - extend string to encode req
+ * @param[in] cb - called with each progress reply
+ * @param[in] arg - passed to cb
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	!0	error (pbs_errno)
+ *
+ */
+int
+pbs_selact(int c, struct attropl *attrib, int action, struct attrl *args, const char *extend, pbs_selact_cb cb, void *arg)
+{
+	return (*pfn_pbs_selact)(c, attrib, action, args, extend, cb, arg);
+}
+
 /**
  * @brief
  *	-Pass-through call to get status of a queue.
@@ -764,6 +872,121 @@ pbs_statvnode(int c, const char *id, struct attrl *attrib, const char *extend)
 	return (*pfn_pbs_statvnode)(c, id, attrib, extend);
 }
 
+/**
+ * @brief
+ * 	-Pass-through call to get information about virtual nodes (vnodes)
+ *	which hands each vnode to a callback as it is decoded
+ *
+ * @param[in] c - communication handle
+ * @param[in] id - object id
+ * @param[in] attrib - pointer to attribute list
+ * @param[in] extend - extend string for encoding req
+ * @param[in] cb - called with each vnode
+ * @param[in] arg - passed to cb
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	!0	error (pbs_errno)
+ *
+ */
+int
+pbs_statvnode_stream(int c, const char *id, struct attrl *attrib, const char *extend, pbs_status_cb cb, void *arg)
+{
+	return (*pfn_pbs_statvnode_stream)(c, id, attrib, extend, cb, arg);
+}
+
+/**
+ * @brief
+ *	-Pass-through call to send a status request without waiting for its reply.
+ *
+ * @param[in] c - communication handle
+ * @param[in] obj_type - MGR_OBJ_* type of the object(s) to status
+ * @param[in] id - object id
+ * @param[in] attrib - pointer to attribute list
+ * @param[in] extend - extend string for encoding req
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	!0	error (pbs_errno)
+ *
+ */
+int
+pbs_stat_submit(int c, int obj_type, const char *id, struct attrl *attrib, const char *extend)
+{
+	return (*pfn_pbs_stat_submit)(c, obj_type, id, attrib, extend);
+}
+
+/**
+ * @brief
+ *	-Pass-through call to read the reply of the oldest pbs_stat_submit() request.
+ *
+ * @param[in] c - communication handle
+ *
+ * @return	structure handle
+ * @retval	pointer to batch_status struct		success
+ * @retval	NULL					error or nothing to report
+ *
+ */
+struct batch_status *
+pbs_stat_collect(int c)
+{
+	return (*pfn_pbs_stat_collect)(c);
+}
+
+/**
+ * @brief
+ *	-Pass-through call to read the server's latest status snapshot.
+ *
+ * @param[in] obj_type - MGR_OBJ_JOB, MGR_OBJ_QUEUE, MGR_OBJ_SERVER or MGR_OBJ_NODE
+ * @param[out] stamp - time the snapshot was taken
+ *
+ * @return	structure handle
+ * @retval	pointer to batch_status struct		success
+ * @retval	NULL					error or nothing to report
+ *
+ */
+struct batch_status *
+pbs_statsnapshot(int obj_type, time_t *stamp)
+{
+	return (*pfn_pbs_statsnapshot)(obj_type, stamp);
+}
+
+/**
+ * @brief
+ *	-Pass-through call to subscribe to job or vnode state changes.
+ *
+ * @param[in] c - communication handle
+ * @param[in] obj_type - MGR_OBJ_JOB or MGR_OBJ_NODE
+ * @param[in] filter - job owner to report, NULL or "" for all
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	!0	error (pbs_errno)
+ *
+ */
+int
+pbs_subscribe(int c, int obj_type, const char *filter)
+{
+	return (*pfn_pbs_subscribe)(c, obj_type, filter);
+}
+
+/**
+ * @brief
+ *	-Pass-through call to read the next batch of subscribed state changes.
+ *
+ * @param[in] c - communication handle
+ *
+ * @return	structure handle
+ * @retval	pointer to batch_status struct		success
+ * @retval	NULL					error
+ *
+ */
+struct batch_status *
+pbs_subscribe_next(int c)
+{
+	return (*pfn_pbs_subscribe_next)(c);
+}
+
 /**
  * @brief
  *	-Pass-through call to get the status of a reservation.
@@ -45,7 +45,9 @@
 int (*pfn_pbs_asyrunjob)(int, const char *, const char *, const char *) = __pbs_asyrunjob;
 int (*pfn_pbs_asyrunjob_ack)(int, const char *, const char *, const char *) = __pbs_asyrunjob_ack;
 int (*pfn_pbs_alterjob)(int, const char *, struct attrl *, const char *) = __pbs_alterjob;
+struct batch_deljob_status *(*pfn_pbs_alterjoblist)(int, char **, struct attrl **, int, const char *) = __pbs_alterjoblist;
 int (*pfn_pbs_asyalterjob)(int, const char *, struct attrl *, const char *) = __pbs_asyalterjob;
+int (*pfn_pbs_asyalterjoblist)(int, char **, struct attrl **, int, const char *) = __pbs_asyalterjoblist;
 int (*pfn_pbs_confirmresv)(int, const char *, const char *, unsigned long, const char *) = __pbs_confirmresv;
 int (*pfn_pbs_connect)(const char *) = __pbs_connect;
 int (*pfn_pbs_connect_extend)(const char *, const char *) = __pbs_connect_extend;
@@ -64,6 +66,7 @@ int (*pfn_pbs_orderjob)(int, const char *, const char *, const char *) = __pbs_o
 int (*pfn_pbs_rerunjob)(int, const char *, const char *) = __pbs_rerunjob;
 int (*pfn_pbs_rlsjob)(int, const char *, const char *, const char *) = __pbs_rlsjob;
 int (*pfn_pbs_runjob)(int, const char *, const char *, const char *) = __pbs_runjob;
+struct batch_deljob_status *(*pfn_pbs_runjoblist)(int, char **, char **, int, const char *) = __pbs_runjoblist;
 char **(*pfn_pbs_selectjob)(int, struct attropl *, const char *) = __pbs_selectjob;
 int (*pfn_pbs_sigjob)(int, const char *, const char *, const char *) = __pbs_sigjob;
 void (*pfn_pbs_statfree)(struct batch_status *) = __pbs_statfree;
@@ -71,12 +74,20 @@ void (*pfn_pbs_delstatfree)(struct batch_deljob_status *) = __pbs_delstatfree;
 struct batch_status *(*pfn_pbs_statrsc)(int, const char *, struct attrl *, const char *) = __pbs_statrsc;
 struct batch_status *(*pfn_pbs_statjob)(int, const char *, struct attrl *, const char *) = __pbs_statjob;
 struct batch_status *(*pfn_pbs_selstat)(int, struct attropl *, struct attrl *, const char *) = __pbs_selstat;
+int (*pfn_pbs_selstat_stream)(int, struct attropl *, struct attrl *, const char *, pbs_status_cb, void *) = __pbs_selstat_stream;
+int (*pfn_pbs_selact)(int, struct attropl *, int, struct attrl *, const char *, pbs_selact_cb, void *) = __pbs_selact;
 struct batch_status *(*pfn_pbs_statque)(int, const char *, struct attrl *, const char *) = __pbs_statque;
 struct batch_status *(*pfn_pbs_statserver)(int, struct attrl *, const char *) = __pbs_statserver;
 struct batch_status *(*pfn_pbs_statsched)(int, struct attrl *, const char *) = __pbs_statsched;
 struct batch_status *(*pfn_pbs_stathost)(int, const char *, struct attrl *, const char *) = __pbs_stathost;
 struct batch_status *(*pfn_pbs_statnode)(int, const char *, struct attrl *, const char *) = __pbs_statnode;
 struct batch_status *(*pfn_pbs_statvnode)(int, const char *, struct attrl *, const char *) = __pbs_statvnode;
+int (*pfn_pbs_statvnode_stream)(int, const char *, struct attrl *, const char *, pbs_status_cb, void *) = __pbs_statvnode_stream;
+int (*pfn_pbs_stat_submit)(int, int, const char *, struct attrl *, const char *) = __pbs_stat_submit;
+struct batch_status *(*pfn_pbs_stat_collect)(int) = __pbs_stat_collect;
+struct batch_status *(*pfn_pbs_statsnapshot)(int, time_t *) = __pbs_statsnapshot;
+int (*pfn_pbs_subscribe)(int, int, const char *) = __pbs_subscribe;
+struct batch_status *(*pfn_pbs_subscribe_next)(int) = __pbs_subscribe_next;
 struct batch_status *(*pfn_pbs_statresv)(int, const char *, struct attrl *, const char *) = __pbs_statresv;
 struct batch_status *(*pfn_pbs_stathook)(int, const char *, struct attrl *, const char *) = __pbs_stathook;
 struct ecl_attribute_errors *(*pfn_pbs_get_attributes_in_error)(int) = __pbs_get_attributes_in_error;
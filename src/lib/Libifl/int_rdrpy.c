@@ -65,14 +65,17 @@
  * @param[in] sock - The socket fd to read from
  * @param[out] rc  - Return DIS error code
  * @param[in] prot - protocol type
+ * @param[in] cb - if not NULL, status objects are passed to it as they
+ *		   are decoded instead of being put in the reply
+ * @param[in] arg - passed to cb
  *
  * @return Batch reply structure
  * @retval  !NULL - Success
  * @retval   NULL - Failure
  *
  */
-struct batch_reply *
-PBSD_rdrpy_sock(int sock, int *rc, int prot)
+static struct batch_reply *
+read_reply(int sock, int *rc, int prot, pbs_status_cb cb, void *arg)
 {
 	struct batch_reply *reply;
 	time_t old_timeout;
@@ -83,6 +86,8 @@ PBSD_rdrpy_sock(int sock, int *rc, int prot)
 		pbs_errno = PBSE_SYSTEM;
 		return NULL;
 	}
+	reply->brp_status_cb = cb;
+	reply->brp_status_arg = arg;
 
 	if (prot == PROT_TCP) {
 		DIS_tcp_funcs();
@@ -106,6 +111,24 @@ PBSD_rdrpy_sock(int sock, int *rc, int prot)
 	return reply;
 }
 
+/**
+ * @brief read a batch reply from the given socket
+ *
+ * @param[in] sock - The socket fd to read from
+ * @param[out] rc  - Return DIS error code
+ * @param[in] prot - protocol type
+ *
+ * @return Batch reply structure
+ * @retval  !NULL - Success
+ * @retval   NULL - Failure
+ *
+ */
+struct batch_reply *
+PBSD_rdrpy_sock(int sock, int *rc, int prot)
+{
+	return read_reply(sock, rc, prot, NULL, NULL);
+}
+
 /**
  * @brief read a batch reply from the given connection index
  *
@@ -117,6 +140,25 @@ PBSD_rdrpy_sock(int sock, int *rc, int prot)
  */
 struct batch_reply *
 PBSD_rdrpy(int c)
+{
+	return PBSD_rdrpy_stream(c, NULL, NULL);
+}
+
+/**
+ * @brief read a batch reply from the given connection index, handing the
+ *	  objects of a status reply to a callback as they are decoded so the
+ *	  whole list never has to be held in memory
+ *
+ * @param[in] c - The connection index to read from
+ * @param[in] cb - called with each status object, NULL to put them in the reply
+ * @param[in] arg - passed to cb
+ *
+ * @return Batch reply structure
+ * @retval  !NULL - Success
+ * @retval   NULL - Failure
+ */
+struct batch_reply *
+PBSD_rdrpy_stream(int c, pbs_status_cb cb, void *arg)
 {
 	int rc;
 	struct batch_reply *reply;
@@ -128,7 +170,7 @@ PBSD_rdrpy(int c)
 		return NULL;
 	}
 	/* PBSD_rdrpy() only handles TCP, hence passing PROT_TCP as prot */
-	reply = PBSD_rdrpy_sock(c, &rc, PROT_TCP);
+	reply = read_reply(c, &rc, PROT_TCP, cb, arg);
 	if (reply == NULL) {
 		if (set_conn_errno(c, PBSE_PROTOCOL) != 0) {
 			pbs_errno = PBSE_SYSTEM;
@@ -128,3 +128,37 @@ end:
 	PBSD_FreeReply(reply);
 	return rbsp;
 }
+
+/**
+ * @brief
+ *	Read a status reply, handing each status object to a callback as it is
+ *	decoded instead of building the whole list first
+ *
+ * @param[in] c - connection socket
+ * @param[in] cb - called with each object (see pbs_status_cb)
+ * @param[in] arg - passed to cb
+ *
+ * @return int
+ * @retval 0	success
+ * @retval !0	error (pbs_errno)
+ */
+int
+PBSD_status_stream_get(int c, pbs_status_cb cb, void *arg)
+{
+	struct batch_reply *reply;
+
+	reply = PBSD_rdrpy_stream(c, cb, arg);
+	if (reply == NULL) {
+		if (pbs_errno == PBSE_NONE)
+			pbs_errno = PBSE_PROTOCOL;
+	} else if (reply->brp_choice != BATCH_REPLY_CHOICE_NULL &&
+		   reply->brp_choice != BATCH_REPLY_CHOICE_Text &&
+		   reply->brp_choice != BATCH_REPLY_CHOICE_Status) {
+		if (pbs_errno == PBSE_NONE)
+			pbs_errno = PBSE_PROTOCOL;
+	}
+
+	PBSD_FreeReply(reply);
+	return pbs_errno;
+}
+
@@ -47,6 +47,7 @@
 #include <stdio.h>
 #include <fcntl.h>
 #include <stdint.h>
+#include <sys/stat.h>
 
 #include "portability.h"
 #include "libpbs.h"
@@ -245,6 +246,8 @@ PBSD_commit(int c, char *jobid, int prot, char **msgid, char *extend)
  * @param[in] which - standard file type (enum)
  * @param[in] prot - PROT_TCP or PROT_TPP
  * @param[in] msgid - message id
+ * @param[in] extend - extend field, comma separated key value pair
+ * @param[out] commit_done - if not NULL, set to 1 if the server committed the job
  *
  * @return      int
  * @retval      0               success
@@ -252,11 +255,14 @@ PBSD_commit(int c, char *jobid, int prot, char **msgid, char *extend)
  *
  */
 static int
-PBSD_scbuf(int c, int reqtype, int seq, char *buf, int len, char *jobid, enum job_file which, int prot, char **msgid)
+PBSD_scbuf(int c, int reqtype, int seq, char *buf, int len, char *jobid, enum job_file which, int prot, char **msgid, const char *extend, int *commit_done)
 {
 	struct batch_reply *reply;
 	int rc;
 
+	if (commit_done)
+		*commit_done = 0;
+
 	if (prot == PROT_TCP) {
 		DIS_tcp_funcs();
 	} else {
@@ -269,7 +275,7 @@ PBSD_scbuf(int c, int reqtype, int seq, char *buf, int len, char *jobid, enum jo
 
 	if ((rc = encode_DIS_ReqHdr(c, reqtype, pbs_current_user)) ||
 	    (rc = encode_DIS_JobFile(c, seq, buf, len, jobid, which)) ||
-	    (rc = encode_DIS_ReqExtend(c, NULL))) {
+	    (rc = encode_DIS_ReqExtend(c, extend))) {
 		if (prot == PROT_TCP) {
 			if (set_conn_errtxt(c, dis_emsg[rc]) != 0) {
 				return (pbs_errno = PBSE_SYSTEM);
@@ -293,6 +299,9 @@ PBSD_scbuf(int c, int reqtype, int seq, char *buf, int len, char *jobid, enum jo
 
 	reply = PBSD_rdrpy(c);
 
+	if (commit_done && reply && (reply->brp_choice == BATCH_REPLY_CHOICE_Commit))
+		*commit_done = 1;
+
 	PBSD_FreeReply(reply);
 
 	return get_conn_errno(c);
@@ -331,7 +340,7 @@ PBSD_jscript(int c, const char *script_file, int prot, char **msgid)
 	i = 0;
 	cc = read(fd, s_buf, SCRIPT_CHUNK_Z);
 	while ((cc > 0) &&
-	       ((rc = PBSD_scbuf(c, PBS_BATCH_jobscript, i, s_buf, cc, NULL, JScript, prot, msgid)) == 0)) {
+	       ((rc = PBSD_scbuf(c, PBS_BATCH_jobscript, i, s_buf, cc, NULL, JScript, prot, msgid, NULL, NULL)) == 0)) {
 		i++;
 		cc = read(fd, s_buf, SCRIPT_CHUNK_Z);
 	}
@@ -346,6 +355,63 @@ PBSD_jscript(int c, const char *script_file, int prot, char **msgid)
 	return get_conn_errno(c);
 }
 
+/**
+ * @brief
+ *	-Send the job script to the server over TCP and ask it to commit
+ *	the job along with the last chunk, saving the separate Commit
+ *	round trip.  A server which does not support this acknowledges
+ *	the chunk as usual, in which case commit_done is left at 0 and
+ *	the caller must still send the Commit request.
+ *
+ * @param[in] c - connection handle
+ * @param[in] script_file - job file
+ * @param[out] commit_done - set to 1 if the server committed the job
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	failure
+ *
+ */
+
+int
+PBSD_jscript_commit(int c, const char *script_file, int *commit_done)
+{
+	int i;
+	int fd;
+	int cc;
+	off_t left;
+	struct stat sb;
+	char s_buf[SCRIPT_CHUNK_Z];
+	int rc = 0;
+
+	*commit_done = 0;
+	if ((fd = open(script_file, O_RDONLY, 0)) < 0) {
+		return (-1);
+	}
+	if (fstat(fd, &sb) == -1) {
+		close(fd);
+		return (-1);
+	}
+	left = sb.st_size;
+	i = 0;
+	cc = read(fd, s_buf, SCRIPT_CHUNK_Z);
+	while (cc > 0) {
+		left -= cc;
+		rc = PBSD_scbuf(c, PBS_BATCH_jobscript, i, s_buf, cc, NULL, JScript, PROT_TCP, NULL,
+				(left <= 0) ? EXTEND_OPT_IMPLICIT_COMMIT : NULL, commit_done);
+		if ((rc != 0) || *commit_done)
+			break;
+		i++;
+		cc = read(fd, s_buf, SCRIPT_CHUNK_Z);
+	}
+
+	close(fd);
+	if (cc < 0) /* read failed */
+		return (-1);
+
+	return get_conn_errno(c);
+}
+
 /**
  * @brief
  *	job file function for moving file between server/mom
@@ -377,7 +443,7 @@ PBSD_jscript_direct(int c, char *script, int prot, char **msgid)
 	len = strlen(script);
 	do {
 		tosend = (len > SCRIPT_CHUNK_Z) ? SCRIPT_CHUNK_Z : len;
-		rc = PBSD_scbuf(c, PBS_BATCH_jobscript, i, p, tosend, NULL, JScript, prot, msgid);
+		rc = PBSD_scbuf(c, PBS_BATCH_jobscript, i, p, tosend, NULL, JScript, prot, msgid, NULL, NULL);
 		i++;
 		p += tosend;
 		len -= tosend;
@@ -425,7 +491,7 @@ PBSD_jobfile(int c, int req_type, char *path, char *jobid, enum job_file which,
 	i = 0;
 	cc = read(fd, s_buf, SCRIPT_CHUNK_Z);
 	while ((cc > 0) &&
-	       ((rc = PBSD_scbuf(c, req_type, i, s_buf, cc, jobid, which, prot, msgid)) == 0)) {
+	       ((rc = PBSD_scbuf(c, req_type, i, s_buf, cc, jobid, which, prot, msgid, NULL, NULL)) == 0)) {
 		i++;
 		cc = read(fd, s_buf, SCRIPT_CHUNK_Z);
 	}
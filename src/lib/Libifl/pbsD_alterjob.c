@@ -49,6 +49,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "libpbs.h"
+#include "dis.h"
+#include "pbs_ecl.h"
 
 /**
  * @brief	Convenience function to create attropl list from attrl (shallow copy)
@@ -193,3 +195,156 @@ __pbs_asyalterjob(int c, const char *jobid, struct attrl *attrib, const char *ex
 
 	return i;
 }
+
+/**
+ * @brief
+ *	-encode and send a modify job list request, and read its reply
+ *	unless it is the async form
+ *
+ * @param[in] c - communication handle
+ * @param[in] type - PBS_BATCH_ModifyJobList or PBS_BATCH_ModifyJobList_Async
+ * @param[in] jobids - array of job identifiers
+ * @param[in] attribs - attributes to set on each job of jobids
+ * @param[in] numjobs - number of entries in jobids and attribs
+ * @param[in] extend - extend string for encoding req
+ * @param[out] failed - jobs the server could not modify, NULL for async
+ *
+ * @return      int
+ * @retval      0       success
+ * @retval      !0      error
+ *
+ */
+static int
+alterjoblist_put(int c, int type, char **jobids, struct attrl **attribs, int numjobs,
+		 const char *extend, struct batch_deljob_status **failed)
+{
+	struct attropl **attrib_opls;
+	struct batch_reply *reply;
+	int i;
+	int rc = 0;
+
+	if ((jobids == NULL) || (attribs == NULL) || (numjobs <= 0))
+		return (pbs_errno = PBSE_IVALREQ);
+
+	attrib_opls = calloc(numjobs, sizeof(struct attropl *));
+	if (attrib_opls == NULL)
+		return (pbs_errno = PBSE_SYSTEM);
+	for (i = 0; i < numjobs; i++) {
+		if ((jobids[i] == NULL) || (*jobids[i] == '\0')) {
+			rc = pbs_errno = PBSE_IVALREQ;
+			goto done;
+		}
+		if (attribs[i] != NULL && (attrib_opls[i] = attrl_to_attropl(attribs[i])) == NULL) {
+			rc = pbs_errno;
+			goto done;
+		}
+	}
+
+	/* initialize the thread context data, if not initialized */
+	if (pbs_client_thread_init_thread_context() != 0) {
+		rc = pbs_errno;
+		goto done;
+	}
+
+	/* lock pthread mutex here for this connection */
+	/* blocking call, waits for mutex release */
+	if (pbs_client_thread_lock_connection(c) != 0) {
+		rc = pbs_errno;
+		goto done;
+	}
+
+	DIS_tcp_funcs();
+
+	if ((rc = encode_DIS_ReqHdr(c, type, pbs_current_user)) ||
+	    (rc = encode_DIS_ModifyJobList(c, jobids, attrib_opls, numjobs)) ||
+	    (rc = encode_DIS_ReqExtend(c, extend))) {
+		if (set_conn_errtxt(c, dis_emsg[rc]) != 0)
+			rc = pbs_errno = PBSE_SYSTEM;
+		else
+			rc = pbs_errno = PBSE_PROTOCOL;
+	} else if (dis_flush(c))
+		rc = pbs_errno = PBSE_PROTOCOL;
+	else if (failed != NULL) {
+		pbs_errno = PBSE_NONE;
+		reply = PBSD_rdrpy(c);
+		if (reply == NULL) {
+			if (pbs_errno == PBSE_NONE)
+				pbs_errno = PBSE_PROTOCOL;
+		} else if (reply->brp_choice != BATCH_REPLY_CHOICE_NULL &&
+			   reply->brp_choice != BATCH_REPLY_CHOICE_Text &&
+			   reply->brp_choice != BATCH_REPLY_CHOICE_Delete) {
+			pbs_errno = PBSE_PROTOCOL;
+		} else if (reply->brp_choice == BATCH_REPLY_CHOICE_Delete) {
+			*failed = reply->brp_un.brp_deletejoblist.brp_delstatc;
+			reply->brp_un.brp_deletejoblist.brp_delstatc = NULL;
+		}
+		PBSD_FreeReply(reply);
+		rc = pbs_errno;
+	}
+
+	/* unlock the thread lock and update the thread context data */
+	if (pbs_client_thread_unlock_connection(c) != 0 && rc == 0)
+		rc = pbs_errno;
+
+done:
+	for (i = 0; i < numjobs; i++)
+		__free_attropl(attrib_opls[i]);
+	free(attrib_opls);
+
+	return rc;
+}
+
+/**
+ * @brief
+ *	-send a single async modify request for many jobs
+ *	Each job gets its own attribute list, the server applies them as if
+ *	each was sent with pbs_asyalterjob().  No reply is read.
+ *
+ * @param[in] c - communication handle
+ * @param[in] jobids - array of job identifiers
+ * @param[in] attribs - attributes to set on each job of jobids
+ * @param[in] numjobs - number of entries in jobids and attribs
+ * @param[in] extend - extend string for encoding req
+ *
+ * @return      int
+ * @retval      0       success
+ * @retval      !0      error
+ *
+ */
+int
+__pbs_asyalterjoblist(int c, char **jobids, struct attrl **attribs, int numjobs, const char *extend)
+{
+	return alterjoblist_put(c, PBS_BATCH_ModifyJobList_Async, jobids, attribs,
+				numjobs, extend, NULL);
+}
+
+/**
+ * @brief
+ *	-send a single modify request for many jobs and wait for its reply
+ *	Each job gets its own attribute list, the server applies them as if
+ *	each was sent with pbs_alterjob().
+ *
+ * @param[in] c - communication handle
+ * @param[in] jobids - array of job identifiers
+ * @param[in] attribs - attributes to set on each job of jobids
+ * @param[in] numjobs - number of entries in jobids and attribs
+ * @param[in] extend - extend string for encoding req
+ *
+ * @return	struct batch_deljob_status *
+ * @retval	list of jobs which could not be modified along with the error code of each
+ * @retval	NULL if every job was modified or on error (pbs_errno is set)
+ *
+ */
+struct batch_deljob_status *
+__pbs_alterjoblist(int c, char **jobids, struct attrl **attribs, int numjobs, const char *extend)
+{
+	struct batch_deljob_status *failed = NULL;
+
+	pbs_errno = PBSE_NONE;
+	if (alterjoblist_put(c, PBS_BATCH_ModifyJobList, jobids, attribs,
+			     numjobs, extend, &failed) != 0) {
+		pbs_delstatfree(failed);
+		return NULL;
+	}
+	return failed;
+}
@@ -185,3 +185,89 @@ __pbs_runjob(int c, const char *jobid, const char *location, const char *extend)
 {
 	return __runjob_inner(c, jobid, location, extend, PBS_BATCH_RunJob);
 }
+
+/**
+ * @brief
+ *	-send a single run job list batch request for many jobs
+ *	Each job is run by the server as if it were sent with pbs_asyrunjob_ack(),
+ *	but all of them share one request and one reply.
+ *
+ * @param[in] c - connection handle
+ * @param[in] jobids - array of job identifiers
+ * @param[in] locations - string of vnodes/resources to be allocated to each job of jobids
+ * @param[in] numjobs - number of entries in jobids and locations, an empty
+ *			list only checks that the server knows the request
+ * @param[in] extend - extend string for encoding req
+ *
+ * @return	struct batch_deljob_status *
+ * @retval	list of jobs which could not be run along with the error code of each
+ * @retval	NULL if every job was run or on error (pbs_errno is set)
+ *
+ */
+struct batch_deljob_status *
+__pbs_runjoblist(int c, char **jobids, char **locations, int numjobs, const char *extend)
+{
+	int rc = 0;
+	struct batch_reply *reply = NULL;
+	struct batch_deljob_status *ret = NULL;
+
+	pbs_errno = PBSE_NONE;
+	if ((numjobs < 0) || (numjobs > PBS_MAX_RUNJOBLIST) ||
+	    ((numjobs > 0) && ((jobids == NULL) || (locations == NULL)))) {
+		pbs_errno = PBSE_IVALREQ;
+		return NULL;
+	}
+
+	/* initialize the thread context data, if not already initialized */
+	if (pbs_client_thread_init_thread_context() != 0)
+		return NULL;
+
+	/* lock pthread mutex here for this connection */
+	/* blocking call, waits for mutex release */
+	if (pbs_client_thread_lock_connection(c) != 0)
+		return NULL;
+
+	/* setup DIS support routines for following DIS calls */
+
+	DIS_tcp_funcs();
+
+	if ((rc = encode_DIS_ReqHdr(c, PBS_BATCH_RunJobList, pbs_current_user)) ||
+	    (rc = encode_DIS_RunJobList(c, jobids, locations, numjobs)) ||
+	    (rc = encode_DIS_ReqExtend(c, extend))) {
+		if (set_conn_errtxt(c, dis_emsg[rc]) != 0)
+			pbs_errno = PBSE_SYSTEM;
+		else
+			pbs_errno = PBSE_PROTOCOL;
+
+		pbs_client_thread_unlock_connection(c);
+		return NULL;
+	}
+
+	if (dis_flush(c)) {
+		pbs_errno = PBSE_PROTOCOL;
+		pbs_client_thread_unlock_connection(c);
+		return NULL;
+	}
+
+	reply = PBSD_rdrpy(c);
+	if (reply == NULL) {
+		if (pbs_errno == PBSE_NONE)
+			pbs_errno = PBSE_PROTOCOL;
+	} else if (reply->brp_choice != BATCH_REPLY_CHOICE_NULL &&
+		   reply->brp_choice != BATCH_REPLY_CHOICE_Text &&
+		   reply->brp_choice != BATCH_REPLY_CHOICE_Delete) {
+		pbs_errno = PBSE_PROTOCOL;
+	} else if (reply->brp_choice == BATCH_REPLY_CHOICE_Delete) {
+		ret = reply->brp_un.brp_deletejoblist.brp_delstatc;
+		reply->brp_un.brp_deletejoblist.brp_delstatc = NULL;
+	}
+	PBSD_FreeReply(reply);
+
+	/* unlock the thread lock and update the thread context data */
+	if (pbs_client_thread_unlock_connection(c) != 0) {
+		pbs_delstatfree(ret);
+		return NULL;
+	}
+
+	return ret;
+}
@@ -40,9 +40,11 @@
 /**
  * @file	pbsD_selectj.c
  * @brief
- *	This file contines two main library entries:
+ *	This file contines the main library entries:
  *		pbs_selectjob()
  *		pbs_selstat()
+ *		pbs_selstat_stream()
+ *		pbs_selact()
  *
  *
  *	pbs_selectjob() - the SelectJob request
@@ -150,6 +152,147 @@ __pbs_selstat(int c, struct attropl *attrib, struct attrl *rattrib, const char *
 	return ret;
 }
 
+/**
+ * @brief
+ * 	-pbs_selstat_stream() - Selectable status which hands each job to a
+ *	callback as the reply is read, so the caller never holds the whole list
+ *
+ * @param[in] c - communication handle
+ * @param[in] attrib - pointer to attropl structure(selection criteria)
+ * @param[in] rattrib - list of attributes to return
+ * @param[in] extend - extend string to encode req
+ * @param[in] cb - called with each job (an array job with its subjobs),
+ *		   owns the batch_status it is given
+ * @param[in] arg - passed to cb
+ *
+ * @return      int
+ * @retval      0	success
+ * @retval      !0	error (pbs_errno)
+ *
+ */
+int
+__pbs_selstat_stream(int c, struct attropl *attrib, struct attrl *rattrib, const char *extend, pbs_status_cb cb, void *arg)
+{
+	int rc;
+
+	/* initialize the thread context data, if not already initialized */
+	if (pbs_client_thread_init_thread_context() != 0)
+		return pbs_errno;
+
+	/* first verify the attributes, if verification is enabled */
+	if (pbs_verify_attributes(c, PBS_BATCH_SelectJobs, MGR_OBJ_JOB,
+				  MGR_CMD_NONE, attrib))
+		return pbs_errno;
+
+	/* lock pthread mutex here for this connection */
+	/* blocking call, waits for mutex release */
+	if (pbs_client_thread_lock_connection(c) != 0)
+		return pbs_errno;
+
+	rc = PBSD_select_put(c, PBS_BATCH_SelStat, attrib, rattrib, extend);
+	if (rc == 0)
+		rc = PBSD_status_stream_get(c, cb, arg);
+
+	/* unlock the thread lock and update the thread context data */
+	if (pbs_client_thread_unlock_connection(c) != 0)
+		return pbs_errno;
+
+	return rc;
+}
+
+/**
+ * @brief
+ * 	-pbs_selact() - apply an action to every job that meets the selection
+ *	criteria.  The server selects and acts on the jobs itself, a slice at
+ *	a time, and sends a partial reply after each slice so a large
+ *	selection does not need one request per job.
+ *
+ * @param[in] c - communication handle
+ * @param[in] attrib - pointer to attropl structure(selection criteria)
+ * @param[in] action - SELACT_DELETE, SELACT_HOLD, SELACT_RELEASE or SELACT_ALTER
+ * @param[in] args - attributes of the action: the hold types for hold and
+ *		     release, the attributes to set for alter
+ * @param[in] extend - extend string to encode req, also passed to the
+ *		       action (e.g. "force" for delete)
+ * @param[in] cb - if not NULL, called with each progress reply
+ * @param[in] arg - passed to cb
+ *
+ * @return      int
+ * @retval      0	the request completed, failed jobs went to cb
+ * @retval      !0	error (pbs_errno)
+ *
+ */
+int
+__pbs_selact(int c, struct attropl *attrib, int action, struct attrl *args, const char *extend, pbs_selact_cb cb, void *arg)
+{
+	int rc;
+	int part;
+	struct batch_reply *reply;
+
+	/* initialize the thread context data, if not already initialized */
+	if (pbs_client_thread_init_thread_context() != 0)
+		return pbs_errno;
+
+	/* first verify the attributes, if verification is enabled */
+	if (pbs_verify_attributes(c, PBS_BATCH_SelectJobs, MGR_OBJ_JOB,
+				  MGR_CMD_NONE, attrib))
+		return pbs_errno;
+
+	/* lock pthread mutex here for this connection */
+	/* blocking call, waits for mutex release */
+	if (pbs_client_thread_lock_connection(c) != 0)
+		return pbs_errno;
+
+	DIS_tcp_funcs();
+
+	if ((rc = encode_DIS_ReqHdr(c, PBS_BATCH_SelAct, pbs_current_user)) ||
+	    (rc = diswui(c, action)) ||
+	    (rc = encode_DIS_attropl(c, attrib)) ||
+	    (rc = encode_DIS_attrl(c, args)) ||
+	    (rc = encode_DIS_ReqExtend(c, extend))) {
+		if (set_conn_errtxt(c, dis_emsg[rc]) != 0)
+			pbs_errno = PBSE_SYSTEM;
+		else
+			pbs_errno = PBSE_PROTOCOL;
+		(void) pbs_client_thread_unlock_connection(c);
+		return pbs_errno;
+	}
+	if (dis_flush(c)) {
+		pbs_errno = PBSE_PROTOCOL;
+		(void) pbs_client_thread_unlock_connection(c);
+		return pbs_errno;
+	}
+
+	/* read the progress replies up to the final one */
+	do {
+		reply = PBSD_rdrpy(c);
+		if (reply == NULL) {
+			if (pbs_errno == PBSE_NONE)
+				pbs_errno = PBSE_PROTOCOL;
+			break;
+		}
+		if (reply->brp_choice != BATCH_REPLY_CHOICE_NULL &&
+		    reply->brp_choice != BATCH_REPLY_CHOICE_Text &&
+		    reply->brp_choice != BATCH_REPLY_CHOICE_Delete) {
+			pbs_errno = PBSE_PROTOCOL;
+			PBSD_FreeReply(reply);
+			break;
+		}
+		part = reply->brp_is_part;
+		if (cb != NULL && pbs_errno == PBSE_NONE &&
+		    reply->brp_choice == BATCH_REPLY_CHOICE_Delete)
+			cb(reply->brp_auxcode, reply->brp_un.brp_deletejoblist.brp_delstatc, arg);
+		PBSD_FreeReply(reply);
+	} while (part && pbs_errno == PBSE_NONE);
+	rc = pbs_errno;
+
+	/* unlock the thread lock and update the thread context data */
+	if (pbs_client_thread_unlock_connection(c) != 0)
+		return pbs_errno;
+
+	return rc;
+}
+
 /**
  * @brief
  *	-encode and puts selectjob request  data
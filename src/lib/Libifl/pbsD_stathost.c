@@ -811,16 +811,27 @@ build_return_status(struct batch_status *bstatus,
 
 				/* single vnode host - use the real one */
 
-				/* prevent double free: copy name, move attribs */
+				/*
+				 * copy name and attribs, the vnode's may be part of
+				 * the block its status was decoded into
+				 */
 				if ((npbs->name = strdup((phost_list + i)->hl_node->name)) == NULL) {
 					free(npbs);
 					pbs_errno = PBSE_SYSTEM;
 					return NULL;
 				}
-				npbs->attribs = (phost_list + i)->hl_node->attribs;
-				(phost_list + i)->hl_node->attribs = NULL;
-				if ((phost_list + i)->hl_node->text)
+				npbs->attribs = NULL;
+				if ((phost_list + i)->hl_node->attribs != NULL &&
+				    (npbs->attribs = dup_attrl_list((phost_list + i)->hl_node->attribs)) == NULL) {
+					free(npbs->name);
+					free(npbs);
+					pbs_errno = PBSE_SYSTEM;
+					return NULL;
+				}
+				if ((phost_list + i)->hl_node->text &&
+				    (phost_list + i)->hl_node->text != bs_arena_mark)
 					if ((npbs->text = strdup((phost_list + i)->hl_node->text)) == NULL) {
+						free_attrl_list(npbs->attribs);
 						free(npbs->name);
 						free(npbs);
 						pbs_errno = PBSE_SYSTEM;
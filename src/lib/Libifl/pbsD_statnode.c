@@ -110,3 +110,52 @@ __pbs_statvnode(int c, const char *id, struct attrl *attrib, const char *extend)
 
 	return ret;
 }
+
+/**
+ * @brief
+ * 	-__pbs_statvnode_stream() - returns information about virtual nodes
+ *	(vnodes) one at a time through a callback as the reply is read
+ *
+ * @param[in] c - communication handle
+ * @param[in] id - object id
+ * @param[in] attrib - pointer to attribute list
+ * @param[in] extend - extend string for encoding req
+ * @param[in] cb - called with each vnode, owns the batch_status it is given
+ * @param[in] arg - passed to cb
+ *
+ * @return	int
+ * @retval	0	Success
+ * @retval	!0	error (pbs_errno)
+ *
+ */
+int
+__pbs_statvnode_stream(int c, const char *id, struct attrl *attrib, const char *extend, pbs_status_cb cb, void *arg)
+{
+	int rc;
+
+	/* initialize the thread context data, if not already initialized */
+	if (pbs_client_thread_init_thread_context() != 0)
+		return pbs_errno;
+
+	/* first verify the attributes, if verification is enabled */
+	rc = pbs_verify_attributes(c, PBS_BATCH_StatusNode, MGR_OBJ_NODE,
+				   MGR_CMD_NONE, (struct attropl *) attrib);
+	if (rc)
+		return pbs_errno;
+
+	if (pbs_client_thread_lock_connection(c) != 0)
+		return pbs_errno;
+
+	if (id == NULL)
+		id = "";
+	rc = PBSD_status_put(c, PBS_BATCH_StatusNode, id, attrib, extend, PROT_TCP, NULL);
+	if (rc == 0)
+		rc = PBSD_status_stream_get(c, cb, arg);
+
+	/* unlock the thread lock and update the thread context data */
+	if (pbs_client_thread_unlock_connection(c) != 0)
+		return pbs_errno;
+
+	return rc;
+}
+
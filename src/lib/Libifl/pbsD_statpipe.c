@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file	pbsD_statpipe.c
+ *
+ * @brief
+ *	Pipelined status requests: send many status requests on one connection
+ *	back to back, then read the replies, instead of paying a round trip per
+ *	request.
+ *
+ *	The server answers status requests as soon as it reads them, so their
+ *	replies come back in the order the requests were sent.  That is not
+ *	true of requests the server relays to MoM, and a reply carries nothing
+ *	to match it with its request, so only status requests are pipelined.
+ *	While status requests are pending on a connection, no other request
+ *	may be sent on it.
+ */
+
+#include <pbs_config.h> /* the master config generated by configure */
+
+#include "libpbs.h"
+#include "pbs_ecl.h"
+
+/**
+ * @brief
+ *	-Send a status request without waiting for its reply.  The reply is
+ *	read later with pbs_stat_collect().
+ *
+ * @param[in] c - communication handle
+ * @param[in] obj_type - MGR_OBJ_JOB, MGR_OBJ_QUEUE, MGR_OBJ_SERVER,
+ *			 MGR_OBJ_SCHED, MGR_OBJ_NODE (vnodes) or MGR_OBJ_RESV
+ * @param[in] id - object id
+ * @param[in] attrib - pointer to attribute list
+ * @param[in] extend - extend string for req
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	!0	error (pbs_errno)
+ *
+ */
+int
+__pbs_stat_submit(int c, int obj_type, const char *id, struct attrl *attrib, const char *extend)
+{
+	int function;
+	int rc;
+
+	switch (obj_type) {
+		case MGR_OBJ_JOB:
+			function = PBS_BATCH_StatusJob;
+			break;
+		case MGR_OBJ_QUEUE:
+			function = PBS_BATCH_StatusQue;
+			break;
+		case MGR_OBJ_SERVER:
+			function = PBS_BATCH_StatusSvr;
+			break;
+		case MGR_OBJ_SCHED:
+			function = PBS_BATCH_StatusSched;
+			break;
+		case MGR_OBJ_NODE:
+			function = PBS_BATCH_StatusNode;
+			break;
+		case MGR_OBJ_RESV:
+			function = PBS_BATCH_StatusResv;
+			break;
+		default:
+			return (pbs_errno = PBSE_IVALREQ);
+	}
+
+	/* initialize the thread context data, if not already initialized */
+	if (pbs_client_thread_init_thread_context() != 0)
+		return pbs_errno;
+
+	/* first verify the attributes, if verification is enabled */
+	if (pbs_verify_attributes(c, function, obj_type, MGR_CMD_NONE,
+				  (struct attropl *) attrib))
+		return pbs_errno;
+
+	if (pbs_client_thread_lock_connection(c) != 0)
+		return pbs_errno;
+
+	if (id == NULL)
+		id = "";
+	rc = PBSD_status_put(c, function, id, attrib, extend, PROT_TCP, NULL);
+	if (rc == 0 && add_conn_pending(c, 1) < 0)
+		rc = pbs_errno = PBSE_SYSTEM;
+
+	/* unlock the thread lock and update the thread context data */
+	if (pbs_client_thread_unlock_connection(c) != 0)
+		return pbs_errno;
+
+	return rc;
+}
+
+/**
+ * @brief
+ *	-Read the reply of the oldest status request sent with
+ *	pbs_stat_submit() on this connection.
+ *
+ * @param[in] c - communication handle
+ *
+ * @return	structure handle
+ * @retval	pointer to batch_status struct		success
+ * @retval	NULL					error (pbs_errno set, PBSE_IVALREQ
+ *							if nothing is pending) or
+ *							nothing to report
+ *
+ */
+struct batch_status *
+__pbs_stat_collect(int c)
+{
+	struct batch_status *ret = NULL;
+
+	/* initialize the thread context data, if not already initialized */
+	if (pbs_client_thread_init_thread_context() != 0)
+		return NULL;
+
+	if (pbs_client_thread_lock_connection(c) != 0)
+		return NULL;
+
+	if (add_conn_pending(c, -1) < 0) {
+		pbs_errno = PBSE_IVALREQ;
+		(void) pbs_client_thread_unlock_connection(c);
+		return NULL;
+	}
+
+	DIS_tcp_funcs();
+	ret = PBSD_status_get(c);
+
+	/* unlock the thread lock and update the thread context data */
+	if (pbs_client_thread_unlock_connection(c) != 0) {
+		pbs_statfree(ret);
+		return NULL;
+	}
+
+	return ret;
+}
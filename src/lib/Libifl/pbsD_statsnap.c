@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file	pbsD_statsnap.c
+ *
+ * @brief
+ *	Read the status snapshots the server publishes under server_priv when
+ *	PBS_STATUS_SNAPSHOT is set.  A local client that can put up with data a
+ *	few seconds old can read them instead of sending a status request and
+ *	taking the server's time to answer it.
+ */
+
+#include <pbs_config.h> /* the master config generated by configure */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "libpbs.h"
+#include "dis.h"
+#include "pbs_internal.h"
+
+/**
+ * @brief
+ *	-Read the latest status snapshot of all objects of one kind.
+ *
+ * @param[in] obj_type - MGR_OBJ_JOB, MGR_OBJ_QUEUE, MGR_OBJ_SERVER or
+ *			 MGR_OBJ_NODE (vnodes)
+ * @param[out] stamp - if not NULL, set to the time the snapshot was taken
+ *
+ * @return	structure handle
+ * @retval	pointer to batch_status struct		success
+ * @retval	NULL					error or nothing to report,
+ *							PBSE_NOSUP if there is no snapshot
+ *
+ */
+struct batch_status *
+__pbs_statsnapshot(int obj_type, time_t *stamp)
+{
+	char path[MAXPATHLEN + 1];
+	char *suffix;
+	struct batch_status *ret = NULL;
+	unsigned int version;
+	unsigned long when;
+	int rc;
+	int fd;
+
+	switch (obj_type) {
+		case MGR_OBJ_JOB:
+			suffix = "job";
+			break;
+		case MGR_OBJ_QUEUE:
+			suffix = "queue";
+			break;
+		case MGR_OBJ_SERVER:
+			suffix = "server";
+			break;
+		case MGR_OBJ_NODE:
+			suffix = "node";
+			break;
+		default:
+			pbs_errno = PBSE_IVALREQ;
+			return NULL;
+	}
+
+	/* initialize the thread context data, if not already initialized */
+	if (pbs_client_thread_init_thread_context() != 0)
+		return NULL;
+
+	if (pbs_loadconf(0) == 0) {
+		pbs_errno = PBSE_SYSTEM;
+		return NULL;
+	}
+
+	snprintf(path, sizeof(path), "%s/server_priv/%s%s",
+		 pbs_conf.pbs_home_path, PBS_SNAPSHOT_PREFIX, suffix);
+	if ((fd = open(path, O_RDONLY)) == -1) {
+		if (errno == ENOENT)
+			pbs_errno = PBSE_NOSUP;
+		else if (errno == EACCES)
+			pbs_errno = PBSE_PERM;
+		else
+			pbs_errno = PBSE_SYSTEM;
+		return NULL;
+	}
+
+	/* the snapshot is a DIS stream, the same as a reply read off a socket */
+	DIS_tcp_funcs();
+	version = disrui(fd, &rc);
+	if (rc == DIS_SUCCESS && version != PBS_SNAPSHOT_VERSION)
+		rc = DIS_PROTO;
+	if (rc == DIS_SUCCESS)
+		when = disrul(fd, &rc);
+	if (rc != DIS_SUCCESS) {
+		pbs_errno = PBSE_PROTOCOL;
+	} else {
+		dis_reset_buf(fd, DIS_READ_BUF);
+		if (stamp != NULL)
+			*stamp = (time_t) when;
+		ret = PBSD_status_get(fd);
+	}
+
+	dis_destroy_chan(fd);
+	destroy_connection(fd);
+	(void) close(fd);
+	return ret;
+}
@@ -222,7 +222,16 @@ __pbs_submit(int c, struct attropl *attrib, const char *script, const char *dest
 
 	/* send script across */
 	if ((script != NULL) && (*script != '\0')) {
-		if ((rc = PBSD_jscript(c, script, 0, NULL)) != 0) {
+		if (!cred_info || (cred_info->cred_len <= 0)) {
+			/* no cred, the last script chunk also asks for the commit */
+			if ((rc = PBSD_jscript_commit(c, script, &commit_done)) != 0) {
+				/* keep the server's error, it may come from the commit */
+				pbs_errno = (rc == -1) ? PBSE_BADSCRIPT : rc;
+				goto error;
+			}
+			if (commit_done)
+				goto done;
+		} else if ((rc = PBSD_jscript(c, script, 0, NULL)) != 0) {
 			if (rc == PBSE_JOBSCRIPTMAXSIZE)
 				pbs_errno = rc;
 			else
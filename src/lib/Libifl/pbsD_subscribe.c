@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file	pbsD_subscribe.c
+ *
+ * @brief
+ *	Subscribe to job or vnode state changes instead of polling status.
+ *
+ *	Once subscribed, the server pushes a status reply on the connection
+ *	each time subscribed objects change state.  The reply holds only the
+ *	changed objects: job_state and substate for jobs, state for vnodes.
+ *	Read them with pbs_subscribe_next().  The connection should be kept
+ *	for the subscription, since a pushed reply could be mistaken for the
+ *	reply to any other request sent on it.  The server does not wait for a
+ *	subscriber: one that lets its events pile up until the server cannot
+ *	write to it has its connection closed.
+ */
+
+#include <pbs_config.h> /* the master config generated by configure */
+
+#include "libpbs.h"
+#include "dis.h"
+
+/**
+ * @brief
+ *	-Subscribe to state changes of jobs or vnodes.
+ *
+ * @param[in] c - communication handle
+ * @param[in] obj_type - MGR_OBJ_JOB or MGR_OBJ_NODE
+ * @param[in] filter - for jobs, the owner whose jobs to report, NULL or ""
+ *		       for all jobs the user may see; ignored for vnodes
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	!0	error (pbs_errno)
+ *
+ */
+int
+__pbs_subscribe(int c, int obj_type, const char *filter)
+{
+	int rc;
+	struct batch_reply *reply;
+
+	if (obj_type != MGR_OBJ_JOB && obj_type != MGR_OBJ_NODE)
+		return (pbs_errno = PBSE_IVALREQ);
+
+	/* initialize the thread context data, if not already initialized */
+	if (pbs_client_thread_init_thread_context() != 0)
+		return pbs_errno;
+
+	/* lock pthread mutex here for this connection */
+	/* blocking call, waits for mutex release */
+	if (pbs_client_thread_lock_connection(c) != 0)
+		return pbs_errno;
+
+	/* setup DIS support routines for following DIS calls */
+
+	DIS_tcp_funcs();
+
+	if ((rc = encode_DIS_ReqHdr(c, PBS_BATCH_Subscribe, pbs_current_user)) ||
+	    (rc = encode_DIS_Subscribe(c, obj_type, filter)) ||
+	    (rc = encode_DIS_ReqExtend(c, NULL))) {
+		if (set_conn_errtxt(c, dis_emsg[rc]) != 0)
+			pbs_errno = PBSE_SYSTEM;
+		else
+			pbs_errno = PBSE_PROTOCOL;
+		(void) pbs_client_thread_unlock_connection(c);
+		return pbs_errno;
+	}
+
+	if (dis_flush(c)) {
+		pbs_errno = PBSE_PROTOCOL;
+		(void) pbs_client_thread_unlock_connection(c);
+		return pbs_errno;
+	}
+
+	reply = PBSD_rdrpy(c);
+	PBSD_FreeReply(reply);
+	rc = get_conn_errno(c);
+
+	/* unlock the thread lock and update the thread context data */
+	if (pbs_client_thread_unlock_connection(c) != 0)
+		return pbs_errno;
+
+	return rc;
+}
+
+/**
+ * @brief
+ *	-Wait for the next batch of state changes pushed by the server after
+ *	pbs_subscribe().  Each batch_status names a changed object and holds
+ *	its new state.  The connection's socket may be polled for input to
+ *	avoid blocking here.
+ *
+ * @param[in] c - communication handle
+ *
+ * @return	structure handle
+ * @retval	pointer to batch_status struct		success
+ * @retval	NULL					error (pbs_errno set)
+ *
+ */
+struct batch_status *
+__pbs_subscribe_next(int c)
+{
+	struct batch_status *ret = NULL;
+
+	/* initialize the thread context data, if not already initialized */
+	if (pbs_client_thread_init_thread_context() != 0)
+		return NULL;
+
+	if (pbs_client_thread_lock_connection(c) != 0)
+		return NULL;
+
+	DIS_tcp_funcs();
+	ret = PBSD_status_get(c);
+
+	/* unlock the thread lock and update the thread context data */
+	if (pbs_client_thread_unlock_connection(c) != 0) {
+		pbs_statfree(ret);
+		return NULL;
+	}
+
+	return ret;
+}
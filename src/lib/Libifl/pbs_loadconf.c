@@ -127,6 +127,18 @@ struct pbs_config pbs_conf = {
 	NULL,			    /* mom short name override */
 	0,			    /* high resolution timestamp logging */
 	0,			    /* number of scheduler threads */
+	0,			    /* no status snapshots */
+	0,			    /* no binary log journal */
+	0,			    /* no mail digests */
+	0,			    /* default job file size sent over TPP */
+	0,			    /* no dns cache */
+	0,			    /* no negative dns cache */
+	0,			    /* no stale dns cache entries */
+	NULL,			    /* no dns cache seed file */
+	0,			    /* no server metrics dumps */
+	0,			    /* no metrics endpoint */
+	0,			    /* periodic hooks run in a forked server */
+	0,			    /* no standby cache warming */
 	NULL,			    /* default scheduler user */
 	NULL,			    /* default scheduler auth user */
 	NULL,			    /* privileged auth user */
@@ -522,6 +534,42 @@ __pbs_loadconf(int reload)
 			} else if (!strcmp(conf_name, PBS_CONF_SCHED_THREADS)) {
 				if (sscanf(conf_value, "%u", &uvalue) == 1)
 					pbs_conf.pbs_sched_threads = uvalue;
+			} else if (!strcmp(conf_name, PBS_CONF_STATUS_SNAPSHOT)) {
+				if (sscanf(conf_value, "%u", &uvalue) == 1)
+					pbs_conf.pbs_status_snapshot = uvalue;
+			} else if (!strcmp(conf_name, PBS_CONF_LOG_JOURNAL)) {
+				if (sscanf(conf_value, "%u", &uvalue) == 1)
+					pbs_conf.pbs_log_journal = ((uvalue > 0) ? 1 : 0);
+			} else if (!strcmp(conf_name, PBS_CONF_MAIL_DIGEST)) {
+				if (sscanf(conf_value, "%u", &uvalue) == 1)
+					pbs_conf.pbs_mail_digest = uvalue;
+			} else if (!strcmp(conf_name, PBS_CONF_JOB_FILE_TPP_MAX)) {
+				if (sscanf(conf_value, "%u", &uvalue) == 1)
+					pbs_conf.pbs_job_file_tpp_max = uvalue;
+			} else if (!strcmp(conf_name, PBS_CONF_DNS_CACHE_TTL)) {
+				if (sscanf(conf_value, "%u", &uvalue) == 1)
+					pbs_conf.pbs_dns_cache_ttl = uvalue;
+			} else if (!strcmp(conf_name, PBS_CONF_DNS_CACHE_NEG_TTL)) {
+				if (sscanf(conf_value, "%u", &uvalue) == 1)
+					pbs_conf.pbs_dns_cache_neg_ttl = uvalue;
+			} else if (!strcmp(conf_name, PBS_CONF_DNS_CACHE_STALE)) {
+				if (sscanf(conf_value, "%u", &uvalue) == 1)
+					pbs_conf.pbs_dns_cache_stale = uvalue;
+			} else if (!strcmp(conf_name, PBS_CONF_DNS_CACHE_SEED)) {
+				free(pbs_conf.pbs_dns_cache_seed);
+				pbs_conf.pbs_dns_cache_seed = strdup(conf_value);
+			} else if (!strcmp(conf_name, PBS_CONF_SERVER_METRICS)) {
+				if (sscanf(conf_value, "%u", &uvalue) == 1)
+					pbs_conf.pbs_server_metrics = uvalue;
+			} else if (!strcmp(conf_name, PBS_CONF_METRICS_EXPORT)) {
+				if (sscanf(conf_value, "%u", &uvalue) == 1)
+					pbs_conf.pbs_metrics_export = uvalue;
+			} else if (!strcmp(conf_name, PBS_CONF_HOOK_EXECUTOR)) {
+				if (sscanf(conf_value, "%u", &uvalue) == 1)
+					pbs_conf.pbs_hook_executor = ((uvalue > 0) ? 1 : 0);
+			} else if (!strcmp(conf_name, PBS_CONF_SECONDARY_PREWARM)) {
+				if (sscanf(conf_value, "%u", &uvalue) == 1)
+					pbs_conf.pbs_secondary_prewarm = uvalue;
 			}
 #ifdef WIN32
 			else if (!strcmp(conf_name, PBS_CONF_REMOTE_VIEWER)) {
@@ -769,6 +817,54 @@ __pbs_loadconf(int reload)
 		if (sscanf(gvalue, "%u", &uvalue) == 1)
 			pbs_conf.pbs_sched_threads = uvalue;
 	}
+	if ((gvalue = getenv(PBS_CONF_STATUS_SNAPSHOT)) != NULL) {
+		if (sscanf(gvalue, "%u", &uvalue) == 1)
+			pbs_conf.pbs_status_snapshot = uvalue;
+	}
+	if ((gvalue = getenv(PBS_CONF_LOG_JOURNAL)) != NULL) {
+		if (sscanf(gvalue, "%u", &uvalue) == 1)
+			pbs_conf.pbs_log_journal = ((uvalue > 0) ? 1 : 0);
+	}
+	if ((gvalue = getenv(PBS_CONF_MAIL_DIGEST)) != NULL) {
+		if (sscanf(gvalue, "%u", &uvalue) == 1)
+			pbs_conf.pbs_mail_digest = uvalue;
+	}
+	if ((gvalue = getenv(PBS_CONF_JOB_FILE_TPP_MAX)) != NULL) {
+		if (sscanf(gvalue, "%u", &uvalue) == 1)
+			pbs_conf.pbs_job_file_tpp_max = uvalue;
+	}
+	if ((gvalue = getenv(PBS_CONF_DNS_CACHE_TTL)) != NULL) {
+		if (sscanf(gvalue, "%u", &uvalue) == 1)
+			pbs_conf.pbs_dns_cache_ttl = uvalue;
+	}
+	if ((gvalue = getenv(PBS_CONF_DNS_CACHE_NEG_TTL)) != NULL) {
+		if (sscanf(gvalue, "%u", &uvalue) == 1)
+			pbs_conf.pbs_dns_cache_neg_ttl = uvalue;
+	}
+	if ((gvalue = getenv(PBS_CONF_DNS_CACHE_STALE)) != NULL) {
+		if (sscanf(gvalue, "%u", &uvalue) == 1)
+			pbs_conf.pbs_dns_cache_stale = uvalue;
+	}
+	if ((gvalue = getenv(PBS_CONF_DNS_CACHE_SEED)) != NULL) {
+		free(pbs_conf.pbs_dns_cache_seed);
+		pbs_conf.pbs_dns_cache_seed = strdup(gvalue);
+	}
+	if ((gvalue = getenv(PBS_CONF_SERVER_METRICS)) != NULL) {
+		if (sscanf(gvalue, "%u", &uvalue) == 1)
+			pbs_conf.pbs_server_metrics = uvalue;
+	}
+	if ((gvalue = getenv(PBS_CONF_METRICS_EXPORT)) != NULL) {
+		if (sscanf(gvalue, "%u", &uvalue) == 1)
+			pbs_conf.pbs_metrics_export = uvalue;
+	}
+	if ((gvalue = getenv(PBS_CONF_HOOK_EXECUTOR)) != NULL) {
+		if (sscanf(gvalue, "%u", &uvalue) == 1)
+			pbs_conf.pbs_hook_executor = ((uvalue > 0) ? 1 : 0);
+	}
+	if ((gvalue = getenv(PBS_CONF_SECONDARY_PREWARM)) != NULL) {
+		if (sscanf(gvalue, "%u", &uvalue) == 1)
+			pbs_conf.pbs_secondary_prewarm = uvalue;
+	}
 
 	if ((gvalue = getenv(PBS_CONF_DAEMON_SERVICE_USER)) != NULL) {
 		free(pbs_conf.pbs_daemon_service_user);
@@ -45,10 +45,40 @@
 
 #include <pbs_config.h> /* the master config generated by configure */
 
+#include <stddef.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include "libpbs.h"
 
+/* text of a batch_status decoded into a single block, see struct bs_arena */
+char bs_arena_mark[] = "";
+
+/**
+ * @brief
+ *	-Tell whether memory is part of the block a batch_status was decoded
+ *	into.
+ *
+ * @param[in] bsp - batch_status
+ * @param[in] ptr - memory to check
+ *
+ * @return	int
+ * @retval	1	ptr lies in the block of bsp
+ * @retval	0	it does not, or bsp was not decoded into a block
+ *
+ */
+int
+bs_arena_owns(struct batch_status *bsp, void *ptr)
+{
+	char *base;
+
+	if (bsp == NULL || bsp->text != bs_arena_mark || ptr == NULL)
+		return 0;
+	base = (char *) bsp - offsetof(struct bs_arena, ba_bs);
+	return ((char *) ptr >= base &&
+		(char *) ptr < base + ((struct bs_arena *) base)->ba_size);
+}
+
 /**
  * @brief
  *	-The function that deallocates a "batch_status" structure
@@ -80,7 +110,28 @@ void
 pbs_statfree_single(struct batch_status *bsp)
 {
 	struct attrl *atnxt;
-	if (bsp != NULL) {
+
+	if (bsp != NULL && bsp->text == bs_arena_mark) {
+		/*
+		 * decoded into one block, only free what the caller
+		 * has put in since
+		 */
+		if (!bs_arena_owns(bsp, bsp->name))
+			free(bsp->name);
+		while (bsp->attribs != NULL) {
+			atnxt = bsp->attribs->next;
+			if (!bs_arena_owns(bsp, bsp->attribs->name))
+				free(bsp->attribs->name);
+			if (!bs_arena_owns(bsp, bsp->attribs->resource))
+				free(bsp->attribs->resource);
+			if (!bs_arena_owns(bsp, bsp->attribs->value))
+				free(bsp->attribs->value);
+			if (!bs_arena_owns(bsp, bsp->attribs))
+				free(bsp->attribs);
+			bsp->attribs = atnxt;
+		}
+		free((char *) bsp - offsetof(struct bs_arena, ba_bs));
+	} else if (bsp != NULL) {
 		free(bsp->name);
 		free(bsp->text);
 		while (bsp->attribs != NULL) {
@@ -97,3 +148,31 @@ pbs_statfree_single(struct batch_status *bsp)
 		free(bsp);
 	}
 }
+
+/**
+ * @brief
+ *	-Replace the value of an attribute of a batch_status.  Use this rather
+ *	than freeing the value directly, since the value may be part of the
+ *	block the batch_status was decoded into.
+ *
+ * @param[in] bsp - batch_status holding pattr
+ * @param[in] pattr - attribute to change
+ * @param[in] value - new value
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	out of memory, the value is left as it was
+ *
+ */
+int
+set_bs_attr_value(struct batch_status *bsp, struct attrl *pattr, const char *value)
+{
+	char *nv;
+
+	if ((nv = strdup(value)) == NULL)
+		return -1;
+	if (!bs_arena_owns(bsp, pattr->value))
+		free(pattr->value);
+	pattr->value = nv;
+	return 0;
+}
@@ -109,7 +109,7 @@ static char *localhost = LOCALHOST_SHORTNAME;
  **	are recorded and as information is received from MOM's, the
  **	event is updated and marked so tm_poll() can return it to the user.
  */
-#define EVENT_HASH 128
+#define EVENT_HASH 1024 /* pbsdsh -f keeps an event per node outstanding */
 
 /*
  * a bit of code to map a tm_ error number to the symbol
@@ -211,6 +211,7 @@ del_event(event_info *ep)
 		case TM_TASKS:
 		case TM_GETINFO:
 		case TM_RESOURCES:
+		case TM_SPAWN_MULTI:
 			free(ep->e_info);
 			break;
 
@@ -298,7 +299,7 @@ add_event(tm_event_t event, tm_node_id node, int type, void *info)
  **	can be resolved into real tasks on real nodes.
  **	We will use a hash table.
  */
-#define TASK_HASH 256
+#define TASK_HASH 1024
 typedef struct task_info {
 	char *t_jobid;		  /* jobid */
 	tm_task_id t_task;	  /* task id */
@@ -841,6 +842,100 @@ tm_spawn(int argc, char **argv, char **envp,
 	return TM_SUCCESS;
 }
 
+struct spawnhold {
+	tm_task_id *list;
+	tm_node_id *nodes;
+	int size;
+};
+
+/**
+ * @brief
+ *	-Starts <count> copies of <argv>[0] with environment <envp>, one
+ *	on each of the job relative nodes in <where>, with a single
+ *	request.  All the nodes must be managed by the local MOM.
+ *
+ * @param[in] argc - argument count
+ * @param[in] argv - argument list
+ * @param[in] envp - environment variable list
+ * @param[in] count - number of tasks to start
+ * @param[in] where - job relative node for each task
+ * @param[out] tids - task id for each task, TM_NULL_TASK if it failed
+ * @param[out] event - event info
+ *
+ * @return	int
+ * @retval	TM_SUCCESS	success
+ * @retval	TM_ER*		error
+ *
+ */
+int
+tm_spawn_multi(int argc, char **argv, char **envp, int count,
+	       tm_node_id *where, tm_task_id *tids, tm_event_t *event)
+{
+	struct spawnhold *shold;
+	char *cp;
+	int i;
+
+	if (!init_done)
+		return TM_BADINIT;
+	if (count <= 0 || where == NULL || tids == NULL)
+		return TM_EBADENVIRONMENT;
+	if (argc <= 0 || argv == NULL || argv[0] == NULL || *argv[0] == '\0')
+		return TM_ENOTFOUND;
+
+	*event = new_event();
+	if (startcom(TM_SPAWN_MULTI, *event) != DIS_SUCCESS)
+		return TM_ENOTCONNECTED;
+
+	if (diswsi(local_conn, where[0]) != DIS_SUCCESS) /* send first node */
+		return TM_ENOTCONNECTED;
+
+	if (diswsi(local_conn, count) != DIS_SUCCESS) /* send count */
+		return TM_ENOTCONNECTED;
+
+	for (i = 0; i < count; i++) {
+		if (diswsi(local_conn, where[i]) != DIS_SUCCESS)
+			return TM_ENOTCONNECTED;
+	}
+
+	if (diswsi(local_conn, argc) != DIS_SUCCESS) /* send argc */
+		return TM_ENOTCONNECTED;
+
+	for (i = 0; i < argc; i++) {
+		cp = argv[i];
+		if (diswcs(local_conn, cp, strlen(cp)) != DIS_SUCCESS)
+			return TM_ENOTCONNECTED;
+	}
+
+	if (envp != NULL) {
+		for (i = 0; (cp = envp[i]) != NULL; i++) {
+#if defined(PBS_SECURITY) && (PBS_SECURITY == KRB5)
+			/* never send KRB5CCNAME; it would rewrite the value on target host */
+			if (strncmp(envp[i], "KRB5CCNAME", strlen("KRB5CCNAME")) == 0)
+				continue;
+#endif
+			if (diswcs(local_conn, cp, strlen(cp)) != DIS_SUCCESS)
+				return TM_ENOTCONNECTED;
+		}
+	}
+	if (diswcs(local_conn, "", 0) != DIS_SUCCESS)
+		return TM_ENOTCONNECTED;
+	dis_flush(local_conn);
+
+	/* one allocation so del_event() can free it in one go */
+	shold = (struct spawnhold *) malloc(sizeof(struct spawnhold) +
+					    count * sizeof(tm_node_id));
+	assert(shold != NULL);
+	shold->list = tids;
+	shold->nodes = (tm_node_id *) (shold + 1);
+	shold->size = count;
+	for (i = 0; i < count; i++) {
+		shold->nodes[i] = where[i];
+		tids[i] = TM_NULL_TASK;
+	}
+	add_event(*event, where[0], TM_SPAWN_MULTI, (void *) shold);
+	return TM_SUCCESS;
+}
+
 /**
  * @brief
  *	-Sends a <sig> signal to all the process groups in the task
@@ -1328,6 +1423,7 @@ tm_poll(tm_event_t poll_event, tm_event_t *result_event, int wait, int *tm_errno
 	struct taskhold *thold;
 	struct infohold *ihold;
 	struct reschold *rhold;
+	struct spawnhold *shold;
 
 	if (!init_done)
 		return TM_BADINIT;
@@ -1508,6 +1604,20 @@ tm_poll(tm_event_t poll_event, tm_event_t *result_event, int wait, int *tm_errno
 			*tidp = new_task(tm_jobid, ep->e_node, tid);
 			break;
 
+		case TM_SPAWN_MULTI:
+			shold = (struct spawnhold *) ep->e_info;
+			for (i = 0; i < shold->size; i++) {
+				tid = disrui(local_conn, &ret);
+				if (ret != DIS_SUCCESS) {
+					DBPRT(("%s: SPAWN_MULTI failed tid %d\n", __func__, i))
+					goto err;
+				}
+				if (tid != TM_NULL_TASK)
+					tid = new_task(tm_jobid, shold->nodes[i], tid);
+				shold->list[i] = tid;
+			}
+			break;
+
 		case TM_SIGNAL:
 			break;
 
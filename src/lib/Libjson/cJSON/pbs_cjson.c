@@ -39,6 +39,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <cjson/cJSON.h>
 #include "pbs_json.h"
 
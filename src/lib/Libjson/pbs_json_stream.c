@@ -0,0 +1,792 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file	pbs_json_stream.c
+ *
+ * @brief
+ *	Streaming json writer and pull parser.  Neither allocates: the writer
+ *	prints each value as it is given, the parser hands out tokens pointing
+ *	into the text being parsed.  The writer prints in the layout of
+ *	pbs_json_print(), so output does not change when a command switches
+ *	from building a json_data tree to streaming.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <float.h>
+#include "pbs_json.h"
+
+/* what the parser accepts next */
+#define JSON_EXPECT_VALUE 0
+#define JSON_EXPECT_VALUE_OR_END 1 /* just after '[' */
+#define JSON_EXPECT_KEY_OR_END 2   /* just after '{' */
+#define JSON_EXPECT_MORE_OR_END 3  /* ',' or the end of the open level */
+#define JSON_EXPECT_DONE 4	   /* the whole value has been read */
+#define JSON_EXPECT_ERROR 5
+
+/**
+ * @brief
+ *	read four hex digits
+ *
+ * @param[in] p - text
+ * @param[out] val - value of the digits
+ *
+ * @return int
+ * @retval 0 - success
+ * @retval 1 - not four hex digits
+ */
+static int
+json_hex4(const char *p, unsigned long *val)
+{
+	int i;
+
+	*val = 0;
+	for (i = 0; i < 4; i++) {
+		*val <<= 4;
+		if (p[i] >= '0' && p[i] <= '9')
+			*val |= p[i] - '0';
+		else if (p[i] >= 'a' && p[i] <= 'f')
+			*val |= p[i] - 'a' + 10;
+		else if (p[i] >= 'A' && p[i] <= 'F')
+			*val |= p[i] - 'A' + 10;
+		else
+			return 1;
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *	decode one character of the still escaped contents of a json string
+ *
+ * @param[in,out] pp - position in the contents, moved past the character
+ * @param[out] out - at least 4 bytes, receives the character as utf-8
+ *
+ * @return int
+ * @retval >0 - number of bytes put in out
+ * @retval -1 - end of text or invalid escape
+ */
+static int
+json_decode_char(const char **pp, char *out)
+{
+	const char *p = *pp;
+	unsigned long cp;
+	unsigned long lo;
+
+	if (*p == '\0')
+		return -1;
+	if (*p != '\\') {
+		out[0] = *p;
+		*pp = p + 1;
+		return 1;
+	}
+	p++;
+	switch (*p) {
+		case 'b':
+			out[0] = '\b';
+			break;
+		case 'f':
+			out[0] = '\f';
+			break;
+		case 'n':
+			out[0] = '\n';
+			break;
+		case 'r':
+			out[0] = '\r';
+			break;
+		case 't':
+			out[0] = '\t';
+			break;
+		case '"':
+		case '\\':
+		case '/':
+			out[0] = *p;
+			break;
+		case 'u':
+			if (json_hex4(p + 1, &cp))
+				return -1;
+			p += 4;
+			if (cp >= 0xDC00 && cp <= 0xDFFF)
+				return -1;
+			if (cp >= 0xD800 && cp <= 0xDBFF) {
+				/* utf-16 surrogate pair */
+				if (p[1] != '\\' || p[2] != 'u' || json_hex4(p + 3, &lo) ||
+				    lo < 0xDC00 || lo > 0xDFFF)
+					return -1;
+				cp = 0x10000 + (((cp & 0x3FF) << 10) | (lo & 0x3FF));
+				p += 6;
+			}
+			*pp = p + 1;
+			if (cp < 0x80) {
+				out[0] = cp;
+				return 1;
+			}
+			if (cp < 0x800) {
+				out[0] = 0xC0 | (cp >> 6);
+				out[1] = 0x80 | (cp & 0x3F);
+				return 2;
+			}
+			if (cp < 0x10000) {
+				out[0] = 0xE0 | (cp >> 12);
+				out[1] = 0x80 | ((cp >> 6) & 0x3F);
+				out[2] = 0x80 | (cp & 0x3F);
+				return 3;
+			}
+			out[0] = 0xF0 | (cp >> 18);
+			out[1] = 0x80 | ((cp >> 12) & 0x3F);
+			out[2] = 0x80 | ((cp >> 6) & 0x3F);
+			out[3] = 0x80 | (cp & 0x3F);
+			return 4;
+		default:
+			return -1;
+	}
+	*pp = p + 1;
+	return 1;
+}
+
+/**
+ * @brief
+ *	print a string with the escapes used by pbs_json_print()
+ *
+ * @param[in] fp - output
+ * @param[in] s - string
+ * @param[in] len - length of s
+ * @param[in] escaped - s is the still escaped contents of a parsed string
+ */
+static void
+json_put_string(FILE *fp, const char *s, size_t len, int escaped)
+{
+	const char *end = s + len;
+	char buf[4];
+	unsigned char c;
+	int n;
+	int i;
+
+	fputc('"', fp);
+	while (s < end) {
+		if (escaped) {
+			if ((n = json_decode_char(&s, buf)) < 0)
+				break;
+		} else {
+			buf[0] = *s++;
+			n = 1;
+		}
+		for (i = 0; i < n; i++) {
+			c = buf[i];
+			switch (c) {
+				case '"':
+					fputs("\\\"", fp);
+					break;
+				case '\\':
+					fputs("\\\\", fp);
+					break;
+				case '\b':
+					fputs("\\b", fp);
+					break;
+				case '\f':
+					fputs("\\f", fp);
+					break;
+				case '\n':
+					fputs("\\n", fp);
+					break;
+				case '\r':
+					fputs("\\r", fp);
+					break;
+				case '\t':
+					fputs("\\t", fp);
+					break;
+				default:
+					if (c < 32)
+						fprintf(fp, "\\u%04x", c);
+					else
+						fputc(c, fp);
+			}
+		}
+	}
+	fputc('"', fp);
+}
+
+/**
+ * @brief
+ *	print a number the way pbs_json_print() does: integers without a
+ *	fraction, others with the fewest digits that read back the same
+ *
+ * @param[in] fp - output
+ * @param[in] d - number
+ */
+static void
+json_put_number(FILE *fp, double d)
+{
+	char buf[32];
+	double test;
+	double diff;
+	double max;
+	int i;
+
+	if (d != d || d > DBL_MAX || d < -DBL_MAX) {
+		fputs("null", fp);
+		return;
+	}
+	if (d >= INT_MAX)
+		i = INT_MAX;
+	else if (d <= INT_MIN)
+		i = INT_MIN;
+	else
+		i = (int) d;
+	if (d == (double) i) {
+		fprintf(fp, "%d", i);
+		return;
+	}
+	snprintf(buf, sizeof(buf), "%1.15g", d);
+	if (sscanf(buf, "%lg", &test) == 1) {
+		diff = test > d ? test - d : d - test;
+		max = test < 0 ? -test : test;
+		if (max < (d < 0 ? -d : d))
+			max = d < 0 ? -d : d;
+		if (diff <= max * DBL_EPSILON) {
+			fputs(buf, fp);
+			return;
+		}
+	}
+	fprintf(fp, "%1.17g", d);
+}
+
+/**
+ * @brief
+ *	print what goes before a value: the separator from the previous
+ *	member, the indentation and, in an object, the member name
+ *
+ * @param[in] jw - writer
+ * @param[in] key - member name, ignored in arrays
+ * @param[in] keylen - length of key
+ * @param[in] escaped - key is the still escaped contents of a parsed string
+ *
+ * @return int
+ * @retval 0 - success
+ * @retval 1 - a complete value was already written
+ */
+static int
+json_put_item(pbs_json_writer *jw, const char *key, size_t keylen, int escaped)
+{
+	FILE *fp = jw->jw_stream;
+	int i;
+
+	if (jw->jw_depth == 0) {
+		if (jw->jw_items[0])
+			return 1;
+	} else if (jw->jw_type[jw->jw_depth] == '[') {
+		if (jw->jw_items[jw->jw_depth])
+			fputs(", ", fp);
+	} else {
+		fputs(jw->jw_items[jw->jw_depth] ? ",\n" : "\n", fp);
+		for (i = 0; i < jw->jw_depth; i++)
+			fputc('\t', fp);
+		json_put_string(fp, key, keylen, escaped);
+		fputs(":\t", fp);
+	}
+	jw->jw_items[jw->jw_depth] = 1;
+	return 0;
+}
+
+/**
+ * @brief
+ *	open an object or array
+ *
+ * @param[in] jw - writer
+ * @param[in] key - member name, ignored in arrays
+ * @param[in] keylen - length of key
+ * @param[in] escaped - key is the still escaped contents of a parsed string
+ * @param[in] type - '{' or '['
+ *
+ * @return int
+ * @retval 0 - success
+ * @retval 1 - failure
+ */
+static int
+json_begin(pbs_json_writer *jw, const char *key, size_t keylen, int escaped, char type)
+{
+	if (jw->jw_depth >= PBS_JSON_MAX_DEPTH)
+		return 1;
+	if (json_put_item(jw, key, keylen, escaped))
+		return 1;
+	fputc(type, jw->jw_stream);
+	jw->jw_depth++;
+	jw->jw_type[jw->jw_depth] = type;
+	jw->jw_items[jw->jw_depth] = 0;
+	return 0;
+}
+
+/**
+ * @brief
+ *	set up a writer
+ *
+ * @param[out] jw - writer
+ * @param[in] stream - output
+ */
+void
+pbs_json_writer_init(pbs_json_writer *jw, FILE *stream)
+{
+	memset(jw, 0, sizeof(*jw));
+	jw->jw_stream = stream;
+}
+
+/**
+ * @brief
+ *	open an object, members written up to the matching
+ *	pbs_json_write_end() go into it
+ *
+ * @param[in] jw - writer
+ * @param[in] key - key for object structure, ignored for arrays
+ *
+ * @return - Error code
+ * @retval   1 - Failure
+ * @retval   0 - Success
+ *
+ */
+int
+pbs_json_write_begin_object(pbs_json_writer *jw, char *key)
+{
+	return json_begin(jw, key ? key : "", key ? strlen(key) : 0, 0, '{');
+}
+
+/**
+ * @brief
+ *	open an array, values written up to the matching
+ *	pbs_json_write_end() go into it
+ *
+ * @param[in] jw - writer
+ * @param[in] key - key for object structure, ignored for arrays
+ *
+ * @return - Error code
+ * @retval   1 - Failure
+ * @retval   0 - Success
+ *
+ */
+int
+pbs_json_write_begin_array(pbs_json_writer *jw, char *key)
+{
+	return json_begin(jw, key ? key : "", key ? strlen(key) : 0, 0, '[');
+}
+
+/**
+ * @brief
+ *	close the innermost open object or array; closing the outermost one
+ *	ends the line, like pbs_json_print()
+ *
+ * @param[in] jw - writer
+ *
+ * @return - Error code
+ * @retval   1 - Failure
+ * @retval   0 - Success
+ *
+ */
+int
+pbs_json_write_end(pbs_json_writer *jw)
+{
+	int i;
+
+	if (jw->jw_depth == 0)
+		return 1;
+	if (jw->jw_type[jw->jw_depth] == '{') {
+		fputc('\n', jw->jw_stream);
+		for (i = 1; i < jw->jw_depth; i++)
+			fputc('\t', jw->jw_stream);
+		fputc('}', jw->jw_stream);
+	} else
+		fputc(']', jw->jw_stream);
+	jw->jw_depth--;
+	if (jw->jw_depth == 0)
+		fputc('\n', jw->jw_stream);
+	return ferror(jw->jw_stream) ? 1 : 0;
+}
+
+/**
+ * @brief
+ *	write a string
+ *
+ * @param[in] jw - writer
+ * @param[in] key - key for object structure, ignored for arrays
+ * @param[in] value - string
+ *
+ * @return - Error code
+ * @retval   1 - Failure
+ * @retval   0 - Success
+ *
+ */
+int
+pbs_json_write_string(pbs_json_writer *jw, char *key, char *value)
+{
+	if (value == NULL)
+		return 1;
+	if (json_put_item(jw, key ? key : "", key ? strlen(key) : 0, 0))
+		return 1;
+	json_put_string(jw->jw_stream, value, strlen(value), 0);
+	return ferror(jw->jw_stream) ? 1 : 0;
+}
+
+/**
+ * @brief
+ *	write a number
+ *
+ * @param[in] jw - writer
+ * @param[in] key - key for object structure, ignored for arrays
+ * @param[in] value - number
+ *
+ * @return - Error code
+ * @retval   1 - Failure
+ * @retval   0 - Success
+ *
+ */
+int
+pbs_json_write_number(pbs_json_writer *jw, char *key, double value)
+{
+	if (json_put_item(jw, key ? key : "", key ? strlen(key) : 0, 0))
+		return 1;
+	json_put_number(jw->jw_stream, value);
+	return ferror(jw->jw_stream) ? 1 : 0;
+}
+
+/**
+ * @brief
+ *	write value as the json it holds, or as a string if it is not json;
+ *	the streaming counterpart of pbs_json_insert_parsed()
+ *
+ * @param[in] jw - writer
+ * @param[in] key - key for object structure, ignored for arrays
+ * @param[in] value - string for parsing
+ * @param[in] ignore_empty - do not write empty values (like 0 or "")
+ *
+ * @return - Error code
+ * @retval   1 - Failure
+ * @retval   0 - Success
+ *
+ * @note
+ *	value is parsed twice, once to check that all of it is json before
+ *	anything is written, then to write it.
+ */
+int
+pbs_json_write_parsed(pbs_json_writer *jw, char *key, char *value, int ignore_empty)
+{
+	pbs_json_parser jp;
+	const char *name;
+	const char *s;
+	size_t namelen;
+	int escaped;
+	int empty = 0;
+	int tok;
+	int rc;
+	char c[4];
+
+	if (value == NULL)
+		return ignore_empty ? 0 : 1;
+
+	pbs_json_parser_init(&jp, value);
+	tok = pbs_json_next(&jp);
+	if (tok == PBS_JSON_NUMBER)
+		empty = (jp.jp_number == 0);
+	else if (tok == PBS_JSON_STRING) {
+		s = jp.jp_text;
+		empty = (jp.jp_len > 0 && json_decode_char(&s, c) > 0 && c[0] == '0');
+	}
+	while (tok != PBS_JSON_DONE && tok != PBS_JSON_ERROR)
+		tok = pbs_json_next(&jp);
+	if (tok == PBS_JSON_ERROR) {
+		if (ignore_empty && value[0] == '0')
+			return 0;
+		return pbs_json_write_string(jw, key, value);
+	}
+	if (ignore_empty && empty)
+		return 0;
+
+	pbs_json_parser_init(&jp, value);
+	name = key ? key : "";
+	namelen = strlen(name);
+	escaped = 0;
+	while ((tok = pbs_json_next(&jp)) != PBS_JSON_DONE) {
+		switch (tok) {
+			case PBS_JSON_KEY:
+				name = jp.jp_text;
+				namelen = jp.jp_len;
+				escaped = 1;
+				continue;
+			case PBS_JSON_BEGIN_OBJECT:
+				rc = json_begin(jw, name, namelen, escaped, '{');
+				break;
+			case PBS_JSON_BEGIN_ARRAY:
+				rc = json_begin(jw, name, namelen, escaped, '[');
+				break;
+			case PBS_JSON_END_OBJECT:
+			case PBS_JSON_END_ARRAY:
+				rc = pbs_json_write_end(jw);
+				break;
+			case PBS_JSON_STRING:
+				if ((rc = json_put_item(jw, name, namelen, escaped)) == 0)
+					json_put_string(jw->jw_stream, jp.jp_text, jp.jp_len, 1);
+				break;
+			case PBS_JSON_NUMBER:
+				if ((rc = json_put_item(jw, name, namelen, escaped)) == 0)
+					json_put_number(jw->jw_stream, jp.jp_number);
+				break;
+			case PBS_JSON_TRUE:
+			case PBS_JSON_FALSE:
+			case PBS_JSON_NULL:
+				if ((rc = json_put_item(jw, name, namelen, escaped)) == 0)
+					fputs(tok == PBS_JSON_TRUE ? "true" : tok == PBS_JSON_FALSE ? "false" : "null", jw->jw_stream);
+				break;
+			default:
+				rc = 1;
+		}
+		if (rc)
+			return 1;
+	}
+	return ferror(jw->jw_stream) ? 1 : 0;
+}
+
+/**
+ * @brief
+ *	set up a parser over text
+ *
+ * @param[out] jp - parser
+ * @param[in] text - json text, must stay in place while it is parsed
+ */
+void
+pbs_json_parser_init(pbs_json_parser *jp, char *text)
+{
+	memset(jp, 0, sizeof(*jp));
+	jp->jp_next = text;
+	jp->jp_expect = (text == NULL) ? JSON_EXPECT_ERROR : JSON_EXPECT_VALUE;
+}
+
+/**
+ * @brief
+ *	skip whitespace; like cJSON, any control character counts as one
+ */
+static const char *
+json_skip_ws(const char *p)
+{
+	while (*p != '\0' && (unsigned char) *p <= ' ')
+		p++;
+	return p;
+}
+
+/**
+ * @brief
+ *	scan a string starting at its opening quote
+ *
+ * @param[in,out] jp - parser, receives the contents in jp_text and jp_len
+ * @param[in,out] pp - position, moved past the closing quote
+ *
+ * @return int
+ * @retval 0 - success
+ * @retval 1 - unterminated string or invalid escape
+ */
+static int
+json_scan_string(pbs_json_parser *jp, const char **pp)
+{
+	const char *p = *pp + 1;
+	char buf[4];
+
+	jp->jp_text = p;
+	while (*p != '"') {
+		if (json_decode_char(&p, buf) < 0)
+			return 1;
+	}
+	jp->jp_len = p - jp->jp_text;
+	*pp = p + 1;
+	return 0;
+}
+
+/**
+ * @brief
+ *	return the next token of the text
+ *
+ * @param[in,out] jp - parser
+ *
+ * @return int
+ * @retval PBS_JSON_DONE - the text held one complete value and nothing else
+ * @retval PBS_JSON_ERROR - the text is not json, or nests deeper than
+ *			    PBS_JSON_MAX_DEPTH; returned from then on
+ * @retval others - the token, for KEY and STRING see jp_text and jp_len,
+ *		    for NUMBER jp_number
+ */
+int
+pbs_json_next(pbs_json_parser *jp)
+{
+	const char *p;
+	char open;
+	char buf[64];
+	char *end;
+	int tok;
+	int i;
+
+	if (jp->jp_expect == JSON_EXPECT_ERROR)
+		return PBS_JSON_ERROR;
+	p = json_skip_ws(jp->jp_next);
+	open = jp->jp_stack[jp->jp_depth];
+
+	switch (jp->jp_expect) {
+		case JSON_EXPECT_DONE:
+			if (*p != '\0')
+				goto err;
+			jp->jp_next = p;
+			return PBS_JSON_DONE;
+
+		case JSON_EXPECT_MORE_OR_END:
+		case JSON_EXPECT_KEY_OR_END:
+		case JSON_EXPECT_VALUE_OR_END:
+			if (*p == (open == '{' ? '}' : ']')) {
+				jp->jp_depth--;
+				jp->jp_expect = jp->jp_depth ? JSON_EXPECT_MORE_OR_END : JSON_EXPECT_DONE;
+				jp->jp_next = p + 1;
+				return open == '{' ? PBS_JSON_END_OBJECT : PBS_JSON_END_ARRAY;
+			}
+			if (jp->jp_expect == JSON_EXPECT_MORE_OR_END) {
+				if (*p != ',')
+					goto err;
+				p = json_skip_ws(p + 1);
+			}
+			if (open == '{') {
+				/* a member name and its colon */
+				if (*p != '"' || json_scan_string(jp, &p))
+					goto err;
+				p = json_skip_ws(p);
+				if (*p != ':')
+					goto err;
+				jp->jp_next = p + 1;
+				jp->jp_expect = JSON_EXPECT_VALUE;
+				return PBS_JSON_KEY;
+			}
+			break;
+	}
+
+	switch (*p) {
+		case '{':
+		case '[':
+			if (jp->jp_depth >= PBS_JSON_MAX_DEPTH)
+				goto err;
+			jp->jp_stack[++jp->jp_depth] = *p;
+			jp->jp_expect = (*p == '{') ? JSON_EXPECT_KEY_OR_END : JSON_EXPECT_VALUE_OR_END;
+			jp->jp_next = p + 1;
+			return (*p == '{') ? PBS_JSON_BEGIN_OBJECT : PBS_JSON_BEGIN_ARRAY;
+		case '"':
+			if (json_scan_string(jp, &p))
+				goto err;
+			tok = PBS_JSON_STRING;
+			break;
+		case 't':
+			if (strncmp(p, "true", 4) != 0)
+				goto err;
+			p += 4;
+			tok = PBS_JSON_TRUE;
+			break;
+		case 'f':
+			if (strncmp(p, "false", 5) != 0)
+				goto err;
+			p += 5;
+			tok = PBS_JSON_FALSE;
+			break;
+		case 'n':
+			if (strncmp(p, "null", 4) != 0)
+				goto err;
+			p += 4;
+			tok = PBS_JSON_NULL;
+			break;
+		default:
+			if (*p != '-' && (*p < '0' || *p > '9'))
+				goto err;
+			for (i = 0; i < (int) sizeof(buf) - 1 && p[i] != '\0' && strchr("0123456789+-eE.", p[i]) != NULL; i++)
+				buf[i] = p[i];
+			buf[i] = '\0';
+			jp->jp_number = strtod(buf, &end);
+			if (end == buf)
+				goto err;
+			jp->jp_text = p;
+			jp->jp_len = end - buf;
+			p += end - buf;
+			tok = PBS_JSON_NUMBER;
+	}
+	jp->jp_expect = jp->jp_depth ? JSON_EXPECT_MORE_OR_END : JSON_EXPECT_DONE;
+	jp->jp_next = p;
+	return tok;
+
+err:
+	jp->jp_expect = JSON_EXPECT_ERROR;
+	return PBS_JSON_ERROR;
+}
+
+/**
+ * @brief
+ *	copy the unescaped contents of the current KEY or STRING token
+ *
+ * @param[in] jp - parser
+ * @param[out] buf - receives the contents, null terminated
+ * @param[in] len - size of buf
+ *
+ * @return - Error code
+ * @retval   1 - Failure, buf is too small
+ * @retval   0 - Success
+ *
+ */
+int
+pbs_json_get_string(pbs_json_parser *jp, char *buf, size_t len)
+{
+	const char *p = jp->jp_text;
+	const char *end = p + jp->jp_len;
+	char c[4];
+	size_t used = 0;
+	int n;
+
+	if (len == 0)
+		return 1;
+	while (p < end) {
+		if ((n = json_decode_char(&p, c)) < 0)
+			break;
+		if (used + n >= len) {
+			buf[used] = '\0';
+			return 1;
+		}
+		memcpy(buf + used, c, n);
+		used += n;
+	}
+	buf[used] = '\0';
+	return 0;
+}
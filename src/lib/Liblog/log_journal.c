@@ -0,0 +1,375 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file	log_journal.c
+ * @brief
+ * log_journal.c - binary journal of log records.
+ *
+ *	When PBS_LOG_JOURNAL is set, each record written to a daemon log is
+ *	also appended, with its fields kept apart, to "<logfile>.jnl".  The
+ *	format is described with LOG_JOURNAL_MAGIC in log.h.  The journal
+ *	follows the text log: it is opened, switched and closed with it.
+ *
+ * @par Functions included are:
+ *	set_log_journal()
+ *	log_journal_enabled()
+ *	log_journal_open()
+ *	log_journal_close()
+ *	log_journal_write()
+ *	log_journal_read_header()
+ *	log_journal_read()
+ *	log_journal_free_rec()
+ */
+
+#include <pbs_config.h> /* the master config generated by configure */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "log.h"
+
+static int journal_enabled = 0;
+static int journal_fd = -1;
+
+static void
+put_u16(unsigned char *p, uint16_t v)
+{
+	p[0] = (v >> 8) & 0xff;
+	p[1] = v & 0xff;
+}
+
+static void
+put_u32(unsigned char *p, uint32_t v)
+{
+	p[0] = (v >> 24) & 0xff;
+	p[1] = (v >> 16) & 0xff;
+	p[2] = (v >> 8) & 0xff;
+	p[3] = v & 0xff;
+}
+
+static void
+put_u64(unsigned char *p, uint64_t v)
+{
+	put_u32(p, (uint32_t) (v >> 32));
+	put_u32(p + 4, (uint32_t) v);
+}
+
+static uint16_t
+get_u16(const unsigned char *p)
+{
+	return (uint16_t) ((p[0] << 8) | p[1]);
+}
+
+static uint32_t
+get_u32(const unsigned char *p)
+{
+	return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) |
+	       ((uint32_t) p[2] << 8) | (uint32_t) p[3];
+}
+
+static uint64_t
+get_u64(const unsigned char *p)
+{
+	return ((uint64_t) get_u32(p) << 32) | get_u32(p + 4);
+}
+
+/**
+ * @brief
+ * 	set_log_journal - turn the binary journal on or off for the log files
+ *	opened from now on
+ *
+ * @param[in] enable - non-zero to write a journal next to each log file
+ */
+void
+set_log_journal(int enable)
+{
+	journal_enabled = enable;
+}
+
+/**
+ * @brief
+ * 	log_journal_enabled - is the binary journal turned on
+ *
+ * @return int
+ * @retval 1 - journal is on
+ * @retval 0 - journal is off
+ */
+int
+log_journal_enabled(void)
+{
+	return (journal_enabled != 0);
+}
+
+/**
+ * @brief
+ * 	log_journal_open - open the journal belonging to a log file
+ *
+ * @par
+ *	Opens "<logname>.jnl" for append, writing the magic string first if
+ *	the journal is new.  Any journal already open is closed.  Called with
+ *	the log mutex held, or before there are other threads.
+ *
+ * @param[in] logname - absolute path of the text log file
+ *
+ * @return int
+ * @retval 0	journal opened, or journal not enabled
+ * @retval -1	journal could not be opened
+ */
+int
+log_journal_open(const char *logname)
+{
+	char path[_POSIX_PATH_MAX];
+	struct stat sb;
+	int fd;
+
+	log_journal_close();
+	if (!journal_enabled)
+		return 0;
+
+	if (snprintf(path, sizeof(path), "%s%s", logname, LOG_JOURNAL_SUFFIX) >= (int) sizeof(path))
+		return -1;
+
+#ifdef WIN32
+	fd = open(path, O_CREAT | O_WRONLY | O_APPEND | O_BINARY, S_IREAD | S_IWRITE);
+#elif defined(O_LARGEFILE)
+	fd = open(path, O_CREAT | O_WRONLY | O_APPEND | O_LARGEFILE, 0644);
+#else
+	fd = open(path, O_CREAT | O_WRONLY | O_APPEND, 0644);
+#endif
+	if (fd < 0)
+		return -1;
+
+	if (fd < 3) {
+		int nfd = fcntl(fd, F_DUPFD, 3);
+
+		(void) close(fd);
+		if (nfd < 0)
+			return -1;
+		fd = nfd;
+	}
+
+	if (fstat(fd, &sb) == -1 ||
+	    (sb.st_size == 0 && write(fd, LOG_JOURNAL_MAGIC, LOG_JOURNAL_MAGIC_LEN) != LOG_JOURNAL_MAGIC_LEN)) {
+		(void) close(fd);
+		return -1;
+	}
+
+	journal_fd = fd;
+	return 0;
+}
+
+/**
+ * @brief
+ * 	log_journal_close - close the journal, if open
+ */
+void
+log_journal_close(void)
+{
+	if (journal_fd != -1) {
+		(void) close(journal_fd);
+		journal_fd = -1;
+	}
+}
+
+/**
+ * @brief
+ * 	log_journal_write - append one record to the journal
+ *
+ * @par
+ *	The record is built in full and written with a single write() so a
+ *	reader never sees a record of another writer interleaved with it.
+ *	Called with the log mutex held.
+ *
+ * @param[in] rtime - time of the record, microseconds since the epoch
+ * @param[in] eventtype - event type
+ * @param[in] objclass - event object class
+ * @param[in] sev - severity
+ * @param[in] objname - object name
+ * @param[in] text - log message
+ */
+void
+log_journal_write(long long rtime, int eventtype, int objclass, int sev, const char *objname, const char *text)
+{
+	unsigned char sbuf[LOG_BUF_SIZE + 512];
+	unsigned char *buf = sbuf;
+	size_t nlen;
+	size_t tlen;
+	size_t total;
+
+	if (journal_fd == -1)
+		return;
+
+	nlen = strlen(objname);
+	tlen = strlen(text);
+	total = LOG_JOURNAL_HDR_LEN + nlen + tlen;
+	if (total > UINT32_MAX)
+		return;
+	if (total > sizeof(sbuf)) {
+		if ((buf = malloc(total)) == NULL)
+			return;
+	}
+
+	put_u32(buf, (uint32_t) (total - 4));
+	put_u64(buf + 4, (uint64_t) rtime);
+	put_u32(buf + 12, (uint32_t) (eventtype & ~PBSEVENT_FORCE));
+	put_u16(buf + 16, (uint16_t) objclass);
+	put_u16(buf + 18, (uint16_t) sev);
+	put_u32(buf + 20, (uint32_t) nlen);
+	put_u32(buf + 24, (uint32_t) tlen);
+	memcpy(buf + LOG_JOURNAL_HDR_LEN, objname, nlen);
+	memcpy(buf + LOG_JOURNAL_HDR_LEN + nlen, text, tlen);
+
+	/* a journal that cannot be written must not disturb the text log */
+	if (write(journal_fd, buf, total) != (ssize_t) total)
+		log_journal_close();
+
+	if (buf != sbuf)
+		free(buf);
+}
+
+/**
+ * @brief
+ * 	log_journal_read_header - check that a stream is a log journal
+ *
+ * @param[in] fp - stream positioned at the start of the journal
+ *
+ * @return int
+ * @retval 0	the stream starts with LOG_JOURNAL_MAGIC
+ * @retval -1	it does not
+ */
+int
+log_journal_read_header(FILE *fp)
+{
+	char magic[LOG_JOURNAL_MAGIC_LEN];
+
+	if (fread(magic, 1, LOG_JOURNAL_MAGIC_LEN, fp) != LOG_JOURNAL_MAGIC_LEN)
+		return -1;
+	if (memcmp(magic, LOG_JOURNAL_MAGIC, LOG_JOURNAL_MAGIC_LEN) != 0)
+		return -1;
+	return 0;
+}
+
+/**
+ * @brief
+ * 	log_journal_read - read the next record of a journal
+ *
+ * @param[in] fp - journal stream, past its header
+ * @param[out] rec - the record; free its strings with log_journal_free_rec()
+ *
+ * @return int
+ * @retval 1	a record was read
+ * @retval 0	end of the journal
+ * @retval -1	malformed or truncated record, or out of memory
+ */
+int
+log_journal_read(FILE *fp, log_journal_rec *rec)
+{
+	unsigned char lenbuf[4];
+	unsigned char *buf;
+	size_t got;
+	uint32_t len;
+	uint32_t nlen;
+	uint32_t tlen;
+
+	memset(rec, 0, sizeof(*rec));
+
+	got = fread(lenbuf, 1, sizeof(lenbuf), fp);
+	if (got == 0 && feof(fp))
+		return 0;
+	if (got != sizeof(lenbuf))
+		return -1;
+	len = get_u32(lenbuf);
+	if (len < LOG_JOURNAL_HDR_LEN - 4)
+		return -1;
+
+	if ((buf = malloc(len)) == NULL)
+		return -1;
+	if (fread(buf, 1, len, fp) != len)
+		goto err;
+
+	/* offsets below are relative to the end of the length word */
+	nlen = get_u32(buf + 16);
+	tlen = get_u32(buf + 20);
+	if ((uint64_t) nlen + tlen != len - (LOG_JOURNAL_HDR_LEN - 4))
+		goto err;
+
+	rec->lj_time = (long long) get_u64(buf);
+	rec->lj_eventtype = (int) get_u32(buf + 8);
+	rec->lj_objclass = get_u16(buf + 12);
+	rec->lj_sev = get_u16(buf + 14);
+	if ((rec->lj_objname = malloc(nlen + 1)) == NULL ||
+	    (rec->lj_text = malloc(tlen + 1)) == NULL)
+		goto err;
+	memcpy(rec->lj_objname, buf + LOG_JOURNAL_HDR_LEN - 4, nlen);
+	rec->lj_objname[nlen] = '\0';
+	memcpy(rec->lj_text, buf + LOG_JOURNAL_HDR_LEN - 4 + nlen, tlen);
+	rec->lj_text[tlen] = '\0';
+
+	free(buf);
+	return 1;
+
+err:
+	free(buf);
+	log_journal_free_rec(rec);
+	return -1;
+}
+
+/**
+ * @brief
+ * 	log_journal_free_rec - free the strings of a record from log_journal_read()
+ *
+ * @param[in] rec - the record
+ */
+void
+log_journal_free_rec(log_journal_rec *rec)
+{
+	free(rec->lj_objname);
+	free(rec->lj_text);
+	rec->lj_objname = NULL;
+	rec->lj_text = NULL;
+}
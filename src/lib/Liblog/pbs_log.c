@@ -92,6 +92,7 @@ static pthread_mutex_t log_write_mutex;
 typedef struct {
 	struct tm ptm;
 	char microsec_buf[8];
+	long long usec; /* microseconds since the epoch, for the journal */
 } ms_time; /* microsecond time stamp */
 
 char *msg_daemonname;
@@ -137,6 +138,7 @@ static int log_mutex_lock();
 static int log_mutex_unlock();
 static void get_timestamp(ms_time *mst);
 static void log_record_inner(int eventtype, int objclass, int sev, const char *objname, const char *text, ms_time *mst);
+static int log_format_record(char *buf, size_t bufsz, int eventtype, int objclass, const char *objname, const char *text, ms_time *mst);
 static void log_console_error(char *);
 
 void
@@ -625,6 +627,9 @@ log_open_main(char *filename, char *directory, int silent)
 #endif
 		log_opened = 1; /* note that file is open */
 
+		if (log_journal_enabled() && log_journal_open(filename) != 0)
+			log_console_error("PBS cannot open its log journal");
+
 		if (!silent) {
 			ms_time mst;
 			get_timestamp(&mst);
@@ -927,8 +932,10 @@ get_timestamp(ms_time *mst)
 	struct tm ltm;
 #endif
 	/* if gettimeofday() fails, log messages will be printed at the epoch */
+	mst->usec = 0;
 	if (gettimeofday(&tp, NULL) != -1) {
 		now = tp.tv_sec;
+		mst->usec = (long long) tp.tv_sec * 1000000 + tp.tv_usec;
 		if (pbs_log_highres_timestamp)
 			snprintf(mst->microsec_buf, sizeof(mst->microsec_buf), ".%06ld", (long) tp.tv_usec);
 		else
@@ -989,6 +996,9 @@ void
 log_record(int eventtype, int objclass, int sev, const char *objname, const char *text)
 {
 	ms_time mst;
+	char linebuf[LOG_BUF_SIZE + 256];
+	char *line = NULL;
+	int len = -1;
 #ifndef WIN32
 	char slogbuf[LOG_BUF_SIZE];
 	sigset_t block_mask;
@@ -1012,10 +1022,22 @@ log_record(int eventtype, int objclass, int sev, const char *objname, const char
 	if ((text == NULL) || (objname == NULL))
 		goto sigunblock;
 
+	/*
+	 * Build the line before taking the mutex so that threads logging at
+	 * the same time only serialize on the write itself.
+	 */
+	get_timestamp(&mst);
+	if (locallog != 0 || syslogfac == 0) {
+		len = log_format_record(linebuf, sizeof(linebuf), eventtype, objclass, objname, text, &mst);
+		if (len >= (int) sizeof(linebuf)) {
+			if ((line = malloc(len + 1)) != NULL)
+				(void) log_format_record(line, len + 1, eventtype, objclass, objname, text, &mst);
+		} else if (len >= 0)
+			line = linebuf;
+	}
+
 	/* lock the file mutex */
 	if (log_mutex_lock() == 0) {
-		get_timestamp(&mst);
-
 		/* Do we need to switch the log? */
 		if (log_auto_switch && (mst.ptm.tm_yday != log_open_day)) {
 			log_close(1);
@@ -1027,12 +1049,20 @@ log_record(int eventtype, int objclass, int sev, const char *objname, const char
 			}
 		}
 
-		/* call the inner routine which does not lock */
-		log_record_inner(eventtype, objclass, sev, objname, text, &mst);
+		if (line != NULL) {
+			if (fwrite(line, 1, len, logfile) != (size_t) len)
+				log_console_error("PBS cannot write to its log");
+			log_journal_write(mst.usec, eventtype, objclass, sev, objname, text);
+		} else if (len >= 0) {
+			/* could not build the line, let the inner routine format it */
+			log_record_inner(eventtype, objclass, sev, objname, text, &mst);
+		}
 		log_mutex_unlock();
 	}
 
 sigunblock:
+	if ((line != NULL) && (line != linebuf))
+		free(line);
 #ifndef WIN32
 	sigprocmask(SIG_SETMASK, &old_mask, NULL);
 #else
@@ -1069,12 +1099,58 @@ log_record_inner(int eventtype, int objclass, int sev, const char *objname, cons
 			     eventtype & ~PBSEVENT_FORCE, msg_daemonname,
 			     class_names[objclass], objname, text);
 
-		(void) fflush(logfile);
+		/* the stream is line buffered (unbuffered on Windows), so */
+		/* the record has already been written out at this point  */
 		if (rc < 0)
 			log_console_error("PBS cannot write to its log");
+		log_journal_write(mst->usec, eventtype, objclass, sev, objname, text);
 	}
 }
 
+/**
+ * @brief
+ * 	Format a log line exactly as log_record_inner() writes it.
+ *	Needs no lock, so log_record() calls it before taking the log mutex.
+ *
+ * @param[out] buf - buffer to format into
+ * @param[in] bufsz - size of buf
+ * @param[in] eventtype - event type
+ * @param[in] objclass - event object class
+ * @param[in] objname - object name stating log msg related to which object
+ * @param[in] text - log msg to be logged
+ * @param[in] mst - the ms_time format timestamp
+ *
+ * @return	int
+ * @retval	length of the full line, as returned by snprintf()
+ */
+static int
+log_format_record(char *buf, size_t bufsz, int eventtype, int objclass, const char *objname, const char *text, ms_time *mst)
+{
+	return snprintf(buf, bufsz,
+			"%02d/%02d/%04d %02d:%02d:%02d%s;%04x;%s;%s;%s;%s\n",
+			mst->ptm.tm_mon + 1, mst->ptm.tm_mday, mst->ptm.tm_year + 1900,
+			mst->ptm.tm_hour, mst->ptm.tm_min, mst->ptm.tm_sec, mst->microsec_buf,
+			eventtype & ~PBSEVENT_FORCE, msg_daemonname,
+			class_names[objclass], objname, text);
+}
+
+/**
+ * @brief
+ * 	log_class_name - the name used in the logs for an event object class
+ *
+ * @param[in] objclass - PBS_EVENTCLASS_* value
+ *
+ * @return	const char *
+ * @retval	the class name, "n/a" for an unknown class
+ */
+const char *
+log_class_name(int objclass)
+{
+	if (objclass < 0 || objclass >= (int) (sizeof(class_names) / sizeof(class_names[0])))
+		return class_names[0];
+	return class_names[objclass];
+}
+
 /**
  * @brief
  * 	log_close - close the current open log file
@@ -1095,6 +1171,7 @@ log_close(int msg)
 			log_record_inner(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, LOG_INFO, "Log", "Log closed", &mst);
 		}
 		(void) fclose(logfile);
+		log_journal_close();
 		log_opened = 0;
 	}
 #if SYSLOG
@@ -0,0 +1,425 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+#include <pbs_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include "pbs_internal.h"
+#include "pbs_idx.h"
+
+/**
+ * @file	dns_cache.c
+ * @brief
+ *	In-process cache of host name to IPv4 address lookups.
+ *
+ *	get_hostaddr(), comp_svraddr(), get_host_ips() and TPP's
+ *	tpp_sock_resolve_host() resolve names through pbs_dns_lookup(), so a
+ *	slow or unreachable resolver is consulted at most once per
+ *	PBS_DNS_CACHE_TTL for each name instead of on every node hello,
+ *	reservation confirmation or job send.
+ *
+ *	An entry older than its ttl but within PBS_DNS_CACHE_STALE more
+ *	seconds is still returned while a detached thread looks the name up
+ *	again; if that lookup fails the old addresses are kept.  Failed
+ *	lookups are remembered for PBS_DNS_CACHE_NEG_TTL seconds.  Names listed
+ *	in the PBS_DNS_CACHE_SEED file (in /etc/hosts format) never expire and
+ *	are never sent to the resolver.
+ *
+ *	With none of these set every call goes straight to getaddrinfo().
+ */
+
+typedef struct dns_cache_ent {
+	int rc;			/* getaddrinfo() result, 0 or EAI_* */
+	int naddrs;		/* number of entries in addrs */
+	struct in_addr *addrs;	/* IPv4 addresses in resolver order */
+	time_t expires;		/* when the entry goes stale, 0 for never */
+	time_t retry;		/* no refresh before this time */
+	int refreshing;		/* a refresh thread is running */
+} dns_cache_ent_t;
+
+static pthread_mutex_t dns_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t dns_cache_once = PTHREAD_ONCE_INIT;
+static void *dns_cache_idx = NULL;
+
+/**
+ * @brief
+ *	pthread_atfork() handlers so a child never inherits the cache mutex
+ *	held by another thread of its parent.
+ */
+static void
+dns_cache_atfork_lock(void)
+{
+	pthread_mutex_lock(&dns_cache_mutex);
+}
+
+static void
+dns_cache_atfork_unlock(void)
+{
+	pthread_mutex_unlock(&dns_cache_mutex);
+}
+
+/**
+ * @brief
+ *	Resolve host with getaddrinfo() and return its IPv4 addresses.
+ *
+ * @param[in]	host	- name to resolve
+ * @param[out]	addrs	- malloc'ed array of addresses, NULL if none
+ * @param[out]	naddrs	- number of addresses in addrs
+ *
+ * @return	int
+ * @retval	0	- resolved, possibly to no IPv4 address at all
+ * @retval	EAI_*	- getaddrinfo() failure
+ */
+static int
+dns_resolve(const char *host, struct in_addr **addrs, int *naddrs)
+{
+	struct addrinfo hints;
+	struct addrinfo *pai;
+	struct addrinfo *aip;
+	struct in_addr *list;
+	int n;
+	int rc;
+
+	*addrs = NULL;
+	*naddrs = 0;
+
+	/*
+	 * AF_UNSPEC and not AF_INET so that IPv6 addresses are not mapped
+	 * to IPv4 ones, see get_hostaddr()
+	 */
+	memset(&hints, 0, sizeof(struct addrinfo));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+	if ((rc = getaddrinfo(host, NULL, &hints, &pai)) != 0)
+		return rc;
+
+	for (n = 0, aip = pai; aip != NULL; aip = aip->ai_next) {
+		if (aip->ai_family == AF_INET)
+			n++;
+	}
+	if (n > 0) {
+		if ((list = malloc(n * sizeof(struct in_addr))) == NULL) {
+			freeaddrinfo(pai);
+			return EAI_MEMORY;
+		}
+		for (n = 0, aip = pai; aip != NULL; aip = aip->ai_next) {
+			if (aip->ai_family == AF_INET)
+				list[n++] = ((struct sockaddr_in *) aip->ai_addr)->sin_addr;
+		}
+		*addrs = list;
+		*naddrs = n;
+	}
+	freeaddrinfo(pai);
+	return 0;
+}
+
+/**
+ * @brief
+ *	Return the cache entry for host, creating an empty one if asked to.
+ *	Called with dns_cache_mutex held.
+ *
+ * @param[in]	host	- name to look for
+ * @param[in]	create	- create a missing entry
+ *
+ * @return	dns_cache_ent_t *
+ * @retval	NULL	- no such entry or out of memory
+ */
+static dns_cache_ent_t *
+dns_cache_find(const char *host, int create)
+{
+	dns_cache_ent_t *ent = NULL;
+	void *key = (void *) host;
+
+	if (dns_cache_idx == NULL)
+		return NULL;
+	if (pbs_idx_find(dns_cache_idx, &key, (void **) &ent, NULL) == PBS_IDX_RET_OK)
+		return ent;
+	if (!create)
+		return NULL;
+	if ((ent = calloc(1, sizeof(dns_cache_ent_t))) == NULL)
+		return NULL;
+	if (pbs_idx_insert(dns_cache_idx, (void *) host, ent) != PBS_IDX_RET_OK) {
+		free(ent);
+		return NULL;
+	}
+	return ent;
+}
+
+/**
+ * @brief
+ *	Load the PBS_DNS_CACHE_SEED file.  Each line holds an IPv4 address
+ *	followed by the names it belongs to, as in /etc/hosts.  Lines with
+ *	other addresses and everything after a '#' are ignored.
+ *
+ * @param[in]	file	- path of the seed file
+ */
+static void
+dns_cache_seed(const char *file)
+{
+	FILE *fp;
+	char line[1024];
+	char *p;
+	char *name;
+	char *last;
+	struct in_addr addr;
+	struct in_addr *tmp;
+	dns_cache_ent_t *ent;
+
+	if ((fp = fopen(file, "r")) == NULL)
+		return;
+
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if ((p = strchr(line, '#')) != NULL)
+			*p = '\0';
+		if ((p = strtok_r(line, " \t\r\n", &last)) == NULL)
+			continue;
+		if (inet_pton(AF_INET, p, &addr) != 1)
+			continue;
+		while ((name = strtok_r(NULL, " \t\r\n", &last)) != NULL) {
+			if ((ent = dns_cache_find(name, 1)) == NULL)
+				break;
+			tmp = realloc(ent->addrs, (ent->naddrs + 1) * sizeof(struct in_addr));
+			if (tmp == NULL) {
+				/* leave no empty entry behind, it would never expire */
+				if (ent->naddrs == 0) {
+					pbs_idx_delete(dns_cache_idx, name);
+					free(ent);
+				}
+				break;
+			}
+			ent->addrs = tmp;
+			ent->addrs[ent->naddrs++] = addr;
+			ent->rc = 0;
+			ent->expires = 0;
+		}
+	}
+	fclose(fp);
+}
+
+/**
+ * @brief
+ *	One time setup of the cache: the index, fork handlers and seed file.
+ */
+static void
+dns_cache_init(void)
+{
+	if ((dns_cache_idx = pbs_idx_create(PBS_IDX_ICASE_CMP, 0)) == NULL)
+		return;
+	pthread_atfork(dns_cache_atfork_lock, dns_cache_atfork_unlock, dns_cache_atfork_unlock);
+	if (pbs_conf.pbs_dns_cache_seed != NULL)
+		dns_cache_seed(pbs_conf.pbs_dns_cache_seed);
+}
+
+/**
+ * @brief
+ *	Store the result of a lookup in ent.  Called with dns_cache_mutex
+ *	held.  A failure does not replace addresses that are still within
+ *	their stale period; it only delays the next attempt.
+ *
+ * @param[in]	ent	- entry to update
+ * @param[in]	rc	- dns_resolve() result
+ * @param[in]	addrs	- addresses found, ownership passes to the cache
+ * @param[in]	naddrs	- number of addresses
+ */
+static void
+dns_cache_store(dns_cache_ent_t *ent, int rc, struct in_addr *addrs, int naddrs)
+{
+	time_t now = time(NULL);
+
+	if (rc != 0 && ent->rc == 0 && ent->addrs != NULL &&
+	    now < ent->expires + (time_t) pbs_conf.pbs_dns_cache_stale) {
+		ent->retry = now + pbs_conf.pbs_dns_cache_neg_ttl;
+		return;
+	}
+	free(ent->addrs);
+	ent->rc = rc;
+	ent->addrs = addrs;
+	ent->naddrs = naddrs;
+	ent->expires = now + (rc == 0 ? pbs_conf.pbs_dns_cache_ttl : pbs_conf.pbs_dns_cache_neg_ttl);
+	ent->retry = ent->expires;
+}
+
+/**
+ * @brief
+ *	Detached thread which refreshes one stale cache entry.
+ *
+ * @param[in]	arg	- malloc'ed copy of the host name
+ *
+ * @return	void *
+ */
+static void *
+dns_cache_refresh(void *arg)
+{
+	char *host = arg;
+	struct in_addr *addrs;
+	int naddrs;
+	int rc;
+	dns_cache_ent_t *ent;
+
+	rc = dns_resolve(host, &addrs, &naddrs);
+
+	pthread_mutex_lock(&dns_cache_mutex);
+	if ((ent = dns_cache_find(host, 0)) != NULL) {
+		dns_cache_store(ent, rc, addrs, naddrs);
+		ent->refreshing = 0;
+	} else
+		free(addrs);
+	pthread_mutex_unlock(&dns_cache_mutex);
+
+	free(host);
+	return NULL;
+}
+
+/**
+ * @brief
+ *	Copy the addresses of ent for the caller.  Called with
+ *	dns_cache_mutex held.
+ *
+ * @return	int
+ * @retval	the rc of the entry, or EAI_MEMORY
+ */
+static int
+dns_cache_copy(dns_cache_ent_t *ent, struct in_addr **addrs, int *naddrs)
+{
+	*addrs = NULL;
+	*naddrs = 0;
+	if (ent->rc != 0)
+		return ent->rc;
+	if (ent->naddrs > 0) {
+		if ((*addrs = malloc(ent->naddrs * sizeof(struct in_addr))) == NULL)
+			return EAI_MEMORY;
+		memcpy(*addrs, ent->addrs, ent->naddrs * sizeof(struct in_addr));
+		*naddrs = ent->naddrs;
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *	Resolve a host name to its IPv4 addresses, through the cache when
+ *	one is configured.
+ *
+ * @param[in]	host	- name to resolve
+ * @param[out]	addrs	- malloc'ed array of addresses in resolver order,
+ *			  NULL if there are none; the caller frees it
+ * @param[out]	naddrs	- number of addresses in addrs
+ *
+ * @return	int
+ * @retval	0	- success, naddrs may still be 0 if the host has no
+ *			  IPv4 address
+ * @retval	EAI_*	- the getaddrinfo() error for this host
+ *
+ * @par MT-safe: Yes
+ */
+int
+pbs_dns_lookup(const char *host, struct in_addr **addrs, int *naddrs)
+{
+	dns_cache_ent_t *ent;
+	struct in_addr *list;
+	time_t now;
+	int n;
+	int rc;
+
+	*addrs = NULL;
+	*naddrs = 0;
+	if (host == NULL || *host == '\0')
+		return EAI_NONAME;
+
+	if (pbs_conf.pbs_dns_cache_ttl == 0 && pbs_conf.pbs_dns_cache_neg_ttl == 0 &&
+	    pbs_conf.pbs_dns_cache_seed == NULL)
+		return dns_resolve(host, addrs, naddrs);
+
+	pthread_once(&dns_cache_once, dns_cache_init);
+
+	pthread_mutex_lock(&dns_cache_mutex);
+	now = time(NULL);
+	if ((ent = dns_cache_find(host, 0)) != NULL) {
+		if (ent->expires == 0 || now < ent->expires) {
+			rc = dns_cache_copy(ent, addrs, naddrs);
+			pthread_mutex_unlock(&dns_cache_mutex);
+			return rc;
+		}
+		if (ent->rc == 0 && now < ent->expires + (time_t) pbs_conf.pbs_dns_cache_stale) {
+			if (!ent->refreshing && now >= ent->retry) {
+				pthread_t tid;
+				pthread_attr_t attr;
+				char *arg;
+
+				if ((arg = strdup(host)) != NULL && pthread_attr_init(&attr) == 0) {
+					pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+					if (pthread_create(&tid, &attr, dns_cache_refresh, arg) == 0)
+						ent->refreshing = 1;
+					else
+						free(arg);
+					pthread_attr_destroy(&attr);
+				} else
+					free(arg);
+			}
+			rc = dns_cache_copy(ent, addrs, naddrs);
+			pthread_mutex_unlock(&dns_cache_mutex);
+			return rc;
+		}
+	}
+	pthread_mutex_unlock(&dns_cache_mutex);
+
+	/* no usable entry, look the name up without holding the lock */
+	rc = dns_resolve(host, &list, &n);
+
+	pthread_mutex_lock(&dns_cache_mutex);
+	if ((ent = dns_cache_find(host, 1)) != NULL) {
+		dns_cache_store(ent, rc, list, n);
+		rc = dns_cache_copy(ent, addrs, naddrs);
+	} else {
+		*addrs = list;
+		*naddrs = n;
+	}
+	pthread_mutex_unlock(&dns_cache_mutex);
+	return rc;
+}
@@ -42,6 +42,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netdb.h>
+#include <stdlib.h>
 #include <netinet/in.h>
 #include <memory.h>
 #include <arpa/inet.h>
@@ -84,9 +85,8 @@ extern int h_errno;
 pbs_net_t
 get_hostaddr(char *hostname)
 {
-	struct addrinfo *aip, *pai;
-	struct addrinfo hints;
-	struct sockaddr_in *inp;
+	struct in_addr *addrs;
+	int naddrs;
 	int err;
 	pbs_net_t res;
 
@@ -95,40 +95,20 @@ get_hostaddr(char *hostname)
 		return ((pbs_net_t) 0);
 	}
 
-	memset(&hints, 0, sizeof(struct addrinfo));
-	/*
-	 *      Why do we use AF_UNSPEC rather than AF_INET?  Some
-	 *      implementations of getaddrinfo() will take an IPv6
-	 *      address and map it to an IPv4 one if we ask for AF_INET
-	 *      only.  We don't want that - we want only the addresses
-	 *      that are genuinely, natively, IPv4 so we start with
-	 *      AF_UNSPEC and filter ai_family below.
-	 */
-	hints.ai_family = AF_UNSPEC;
-	hints.ai_socktype = SOCK_STREAM;
-	hints.ai_protocol = IPPROTO_TCP;
-	if ((err = getaddrinfo(hostname, NULL, &hints, &pai)) != 0) {
+	if ((err = pbs_dns_lookup(hostname, &addrs, &naddrs)) != 0) {
 		if (err == EAI_AGAIN)
 			pbs_errno = PBS_NET_RC_RETRY;
 		else
 			pbs_errno = PBS_NET_RC_FATAL;
 		return ((pbs_net_t) 0);
 	}
-	for (aip = pai; aip != NULL; aip = aip->ai_next) {
-		/* skip non-IPv4 addresses */
-		if (aip->ai_family == AF_INET) {
-			inp = (struct sockaddr_in *) aip->ai_addr;
-			break;
-		}
-	}
-	if (aip == NULL) {
+	if (naddrs == 0) {
 		/* treat no IPv4 addresses as fatal getaddrinfo() failure */
 		pbs_errno = PBS_NET_RC_FATAL;
-		freeaddrinfo(pai);
 		return ((pbs_net_t) 0);
 	}
-	res = ntohl(inp->sin_addr.s_addr);
-	freeaddrinfo(pai);
+	res = ntohl(addrs[0].s_addr);
+	free(addrs);
 	return (res);
 }
 
@@ -197,9 +177,9 @@ compare_short_hostname(char *shost, char *lhost)
 int
 comp_svraddr(pbs_net_t svr_addr, char *hostname, pbs_net_t *addr)
 {
-	struct addrinfo *aip, *pai;
-	struct addrinfo hints;
-	struct sockaddr_in *inp;
+	struct in_addr *addrs;
+	int naddrs;
+	int i;
 	pbs_net_t res;
 
 	if ((hostname == NULL) || (*hostname == '\0')) {
@@ -208,27 +188,20 @@ comp_svraddr(pbs_net_t svr_addr, char *hostname, pbs_net_t *addr)
 	if (addr)
 		*addr = 0;
 
-	memset(&hints, 0, sizeof(struct addrinfo));
-	hints.ai_family = AF_UNSPEC;
-	hints.ai_socktype = SOCK_STREAM;
-	hints.ai_protocol = IPPROTO_TCP;
-	if (getaddrinfo(hostname, NULL, &hints, &pai) != 0) {
+	if (pbs_dns_lookup(hostname, &addrs, &naddrs) != 0) {
 		pbs_errno = PBSE_BADHOST;
 		return (2);
 	}
-	for (aip = pai; aip != NULL; aip = aip->ai_next) {
-		if (aip->ai_family == AF_INET) {
-			inp = (struct sockaddr_in *) aip->ai_addr;
-			res = ntohl(inp->sin_addr.s_addr);
-			if (addr && *addr == 0)
-				*addr = res;
-			if (res == svr_addr) {
-				freeaddrinfo(pai);
-				return 0;
-			}
+	for (i = 0; i < naddrs; i++) {
+		res = ntohl(addrs[i].s_addr);
+		if (addr && *addr == 0)
+			*addr = res;
+		if (res == svr_addr) {
+			free(addrs);
+			return 0;
 		}
 	}
 	/* no match found */
-	freeaddrinfo(pai);
+	free(addrs);
 	return (1);
 }
@@ -491,8 +491,10 @@ free_if_info(struct log_net_info *ni)
 static char *
 get_host_ips(char *host, char *msg_buf, size_t msg_buf_len)
 {
-	struct addrinfo *aip, *pai;
-	struct addrinfo hints;
+	struct in_addr *addrs;
+	struct sockaddr_in sa;
+	int naddrs;
+	int i;
 	int rc = 0;
 	char buf[NETADDR_BUF] = {'\0'};
 	int count = 0;
@@ -502,52 +504,47 @@ get_host_ips(char *host, char *msg_buf, size_t msg_buf_len)
 
 	errno = 0;
 
-	memset(&hints, 0, sizeof(struct addrinfo));
-	hints.ai_family = AF_INET;
-	hints.ai_socktype = SOCK_STREAM;
-	hints.ai_protocol = IPPROTO_TCP;
-
-	if ((rc = getaddrinfo(host, NULL, &hints, &pai)) != 0) {
+	if ((rc = pbs_dns_lookup(host, &addrs, &naddrs)) != 0) {
 		snprintf(msg_buf, msg_buf_len, "Error %d resolving %s\n", rc, host);
 		return NULL;
 	}
 
 	len = 0;
 	count = 0;
-	for (aip = pai; aip != NULL; aip = aip->ai_next) {
-		if (aip->ai_family == AF_INET) { /* for now only count IPv4 addresses */
-			char *p;
-			struct sockaddr_in *sa = (struct sockaddr_in *) aip->ai_addr;
-			if (ntohl(sa->sin_addr.s_addr) >> 24 == IN_LOOPBACKNET)
-				continue;
-			sprintf(buf, "%s", netaddr(sa));
-			if (!strcmp(buf, "unknown"))
-				continue;
-			if ((p = strchr(buf, ':')))
-				*p = '\0';
-
-			hlen = strlen(buf);
-			tmp = realloc(nodenames, len + hlen + 2); /* 2 for comma and null char */
-			if (!tmp) {
-				strncpy(msg_buf, "Out of memory", msg_buf_len);
-				free(nodenames);
-				nodenames = NULL;
-				break;
-			}
-			nodenames = tmp;
+	memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	for (i = 0; i < naddrs; i++) {
+		char *p;
+		sa.sin_addr = addrs[i];
+		if (ntohl(sa.sin_addr.s_addr) >> 24 == IN_LOOPBACKNET)
+			continue;
+		sprintf(buf, "%s", netaddr(&sa));
+		if (!strcmp(buf, "unknown"))
+			continue;
+		if ((p = strchr(buf, ':')))
+			*p = '\0';
 
-			if (len == 0)
-				strcpy(nodenames, buf);
-			else {
-				strcat(nodenames, ",");
-				strcat(nodenames, buf);
-			}
-			len += hlen + 2;
-			count++;
+		hlen = strlen(buf);
+		tmp = realloc(nodenames, len + hlen + 2); /* 2 for comma and null char */
+		if (!tmp) {
+			strncpy(msg_buf, "Out of memory", msg_buf_len);
+			free(nodenames);
+			nodenames = NULL;
+			break;
 		}
+		nodenames = tmp;
+
+		if (len == 0)
+			strcpy(nodenames, buf);
+		else {
+			strcat(nodenames, ",");
+			strcat(nodenames, buf);
+		}
+		len += hlen + 2;
+		count++;
 	}
 
-	freeaddrinfo(pai);
+	free(addrs);
 
 	if (count == 0) {
 		snprintf(msg_buf, msg_buf_len, "Could not find any usable IP address for host %s", host);
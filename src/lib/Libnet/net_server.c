@@ -84,6 +84,7 @@
  */
 
 static conn_t **svr_conn;	  /* list of pointers to connections indexed by the socket fd. List is dynamically allocated */
+#define WAIT_REQUEST_RECHECK_USEC 10000 /* min interval between signal/priority re-checks in one wait_request batch */
 #define CONNS_ARRAY_INCREMENT 100 /* Increases this many more connection pointers when dynamically allocating memory for svr_conn */
 static int conns_array_size = 0;  /* Size of the svr_conn list, initialized to 0 */
 pbs_list_head svr_allconns;	  /* head of the linked list of active connections */
@@ -511,6 +512,53 @@ process_socket(int sock)
 	return 0;
 }
 
+/**
+ * @brief
+ *	Process whatever is ready on the priority sockets (scheduler and TPP
+ *	connections), without waiting
+ *
+ * @param[in] priority_context - context of the priority socket connections
+ *
+ * @return int
+ * @retval 1 - some priority socket was processed
+ * @retval 0 - nothing processed
+ */
+static int
+process_priority_sockets(void *priority_context)
+{
+	em_event_t *pevents;
+#ifndef WIN32
+	sigset_t emptyset;
+#endif
+	int pnfds;
+	int em_pfd;
+	int processed = 0;
+	int i;
+
+	if (priority_context == NULL)
+		return 0;
+
+#ifndef WIN32
+	/* wait after unblocking signals in an atomic call */
+	sigemptyset(&emptyset);
+	pnfds = tpp_em_pwait(priority_context, &pevents, 0, &emptyset);
+#else
+	pnfds = tpp_em_wait(priority_context, &pevents, 0);
+#endif /* WIN32 */
+	for (i = 0; i < pnfds; i++) {
+		em_pfd = EM_GET_FD(pevents, i);
+		log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SERVER,
+			  LOG_DEBUG, __func__, "processing priority socket");
+		if (process_socket(em_pfd) == -1) {
+			log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_SERVER,
+				  LOG_DEBUG, __func__, "process priority socket failed");
+		} else {
+			processed = 1;
+		}
+	}
+	return processed;
+}
+
 /**
  * @brief
  *	Waits for events on a set of sockets and calls processing function
@@ -540,13 +588,11 @@ int
 wait_request(float waittime, void *priority_context)
 {
 	int nfds;
-	int pnfds;
 	int i;
 	em_event_t *events;
 	int err;
 	int prio_sock_processed;
 	int em_fd;
-	int em_pfd;
 	int timeout = (int) (waittime * 1000); /* milli seconds */
 					       /* Platform specific declarations */
 
@@ -571,48 +617,41 @@ wait_request(float waittime, void *priority_context)
 			return (-1);
 		}
 	} else {
-		prio_sock_processed = 0;
-		if (priority_context) {
-			em_event_t *pevents;
-			timeout = 0;
-#ifndef WIN32
-			/* wait after unblocking signals in an atomic call */
-			sigemptyset(&emptyset);
-			pnfds = tpp_em_pwait(priority_context, &pevents, timeout, &emptyset);
-			err = errno;
-#else
-			pnfds = tpp_em_wait(priority_context, &pevents, timeout);
-			err = errno;
-#endif /* WIN32 */
-			for (i = 0; i < pnfds; i++) {
-				em_pfd = EM_GET_FD(pevents, i);
-				log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SERVER,
-					  LOG_DEBUG, __func__, "processing priority socket");
-				if (process_socket(em_pfd) == -1) {
-					log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_SERVER,
-						  LOG_DEBUG, __func__, "process priority socket failed");
-				} else {
-					prio_sock_processed = 1;
-				}
-			}
-		}
+		struct timeval last_check;
+		struct timeval now;
+
+		prio_sock_processed = process_priority_sockets(priority_context);
+		gettimeofday(&last_check, NULL);
 
 		for (i = 0; i < nfds; i++) {
 			em_fd = EM_GET_FD(events, i);
+
+			/*
+			 * Looking for pending signals and ready priority sockets costs a
+			 * syscall each, so between sockets only do it once a batch of
+			 * requests has taken a while, e.g. after a large status.
+			 */
+			gettimeofday(&now, NULL);
+			if (i > 0 && ((now.tv_sec - last_check.tv_sec) * 1000000 + (now.tv_usec - last_check.tv_usec)) >= WAIT_REQUEST_RECHECK_USEC) {
+				last_check = now;
 #ifndef WIN32
-			/* If there is any of the following signals pending, allow a small window to handle the signal */
-			if (sigpending(&pendingsigs) == 0) {
-				if (sigismember(&pendingsigs, SIGCHLD) || sigismember(&pendingsigs, SIGHUP) || sigismember(&pendingsigs, SIGINT) || sigismember(&pendingsigs, SIGTERM)) {
+				/* If there is any of the following signals pending, allow a small window to handle the signal */
+				if (sigpending(&pendingsigs) == 0) {
+					if (sigismember(&pendingsigs, SIGCHLD) || sigismember(&pendingsigs, SIGHUP) || sigismember(&pendingsigs, SIGINT) || sigismember(&pendingsigs, SIGTERM)) {
 
-					if (sigprocmask(SIG_UNBLOCK, &allsigs, NULL) == -1)
-						log_err(errno, __func__, "sigprocmask(UNBLOCK)");
-					if (sigprocmask(SIG_BLOCK, &allsigs, NULL) == -1)
-						log_err(errno, __func__, "sigprocmask(BLOCK)");
+						if (sigprocmask(SIG_UNBLOCK, &allsigs, NULL) == -1)
+							log_err(errno, __func__, "sigprocmask(UNBLOCK)");
+						if (sigprocmask(SIG_BLOCK, &allsigs, NULL) == -1)
+							log_err(errno, __func__, "sigprocmask(BLOCK)");
 
-					return (0);
+						return (0);
+					}
 				}
-			}
 #endif
+				/* see to the priority sockets again before the next */
+				if (process_priority_sockets(priority_context))
+					prio_sock_processed = 1;
+			}
 			if (prio_sock_processed) {
 				int idx = conn_find_actual_index(em_fd);
 				if (idx < 0)
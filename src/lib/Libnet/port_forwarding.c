@@ -75,6 +75,53 @@ int x11_reader_go = 1;
 
 extern int set_nodelay(int fd);
 
+/**
+ * @brief
+ *	Write out as much of the data buffered by the peer of socks[n]
+ *	as the socket of socks[n] takes without blocking.
+ *
+ * @param socks[in] - the port forwarding socket table
+ * @param n[in] - index of the socket to write to
+ * @param logfunc[in] - Function pointer for log function
+ *
+ * @return void
+ */
+static void
+pf_write(struct pfwdsock *socks, int n, void (*logfunc)(char *))
+{
+	int rc;
+	int peer = (socks + n)->peer;
+	char err_msg[LOG_BUF_SIZE];
+
+	if (!(socks + n)->active ||
+	    (socks + peer)->bufavail == (socks + peer)->bufwritten)
+		return;
+
+	rc = write(
+		(socks + n)->sock,
+		(socks + peer)->buff + (socks + peer)->bufwritten,
+		(socks + peer)->bufavail - (socks + peer)->bufwritten);
+
+	if (rc == -1) {
+		if ((errno == EWOULDBLOCK) || (errno == EAGAIN) || (errno == EINTR) || (errno == EINPROGRESS)) {
+			return;
+		}
+		shutdown((socks + n)->sock, SHUT_RDWR);
+		close((socks + n)->sock);
+		(socks + n)->active = 0;
+		snprintf(err_msg, sizeof(err_msg),
+			 "closing the socket %d after write failure, errno=%d",
+			 (socks + n)->sock, errno);
+		PF_LOGGER(logfunc, err_msg);
+	} else if (rc == 0) {
+		shutdown((socks + n)->sock, SHUT_RDWR);
+		close((socks + n)->sock);
+		(socks + n)->active = 0;
+	} else {
+		(socks + peer)->bufwritten += rc;
+	}
+}
+
 /**
  * @brief
  *      This function provides the port forwarding feature for forwarding the
@@ -296,40 +343,29 @@ port_forwarder(
 						(socks + n)->active = 0;
 					} else {
 						(socks + n)->bufavail += rc;
+						/*
+						 * Forward right away instead of waiting
+						 * for the next select() to report the
+						 * peer writable, most of the time it is.
+						 */
+						pf_write(socks, (socks + n)->peer, logfunc);
 					}
 				}
 			} /* END if rfdset */
-			if (FD_ISSET((socks + n)->sock, &wfdset)) {
-				int peer = (socks + n)->peer;
-
-				rc = write(
-					(socks + n)->sock,
-					(socks + peer)->buff + (socks + peer)->bufwritten,
-					(socks + peer)->bufavail - (socks + peer)->bufwritten);
-
-				if (rc == -1) {
-					if ((errno == EWOULDBLOCK) || (errno == EAGAIN) || (errno == EINTR) || (errno == EINPROGRESS)) {
-						continue;
-					}
-					shutdown((socks + n)->sock, SHUT_RDWR);
-					close((socks + n)->sock);
-					(socks + n)->active = 0;
-					snprintf(err_msg, sizeof(err_msg),
-						 "closing the socket %d after write failure, errno=%d",
-						 (socks + n)->sock, errno);
-					PF_LOGGER(logfunc, err_msg);
-				} else if (rc == 0) {
-					shutdown((socks + n)->sock, SHUT_RDWR);
-					close((socks + n)->sock);
-					(socks + n)->active = 0;
-				} else {
-					(socks + peer)->bufwritten += rc;
-				}
-			} /* END if wfdset */
+			if (FD_ISSET((socks + n)->sock, &wfdset))
+				pf_write(socks, n, logfunc);
 			if (!(socks + n)->listening) {
 				int peer = (socks + n)->peer;
 				if ((socks + peer)->bufavail == (socks + peer)->bufwritten) {
 					(socks + peer)->bufavail = (socks + peer)->bufwritten = 0;
+				} else if ((socks + peer)->bufavail == PF_BUF_SIZE &&
+					   (socks + peer)->bufwritten > 0) {
+					/* full but partly sent, make room to keep reading */
+					memmove((socks + peer)->buff,
+						(socks + peer)->buff + (socks + peer)->bufwritten,
+						PF_BUF_SIZE - (socks + peer)->bufwritten);
+					(socks + peer)->bufavail -= (socks + peer)->bufwritten;
+					(socks + peer)->bufwritten = 0;
 				}
 				if (!(socks + peer)->active && ((socks + peer)->bufwritten == (socks + peer)->bufavail)) {
 					shutdown((socks + n)->sock, SHUT_RDWR);
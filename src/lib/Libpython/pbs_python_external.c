@@ -454,11 +454,21 @@ pbs_python_ext_quick_shutdown_interpreter(void)
 #endif /* PYTHON */
 }
 
+/**
+ * @brief
+ * 	Free the globals() dictionary of a script after a run.
+ *
+ * @note
+ *	The dictionary of a persistent script (one which set
+ *	PBS_PYTHON_HOOK_HANDLER) is kept for its next run.
+ */
 void
 pbs_python_ext_free_global_dict(
 	struct python_script *py_script)
 {
 #ifdef PYTHON /* --- BEGIN PYTHON BLOCK --- */
+	if (py_script->py_handler)
+		return;
 	if (py_script->global_dict) {
 		PyDict_Clear((PyObject *) py_script->global_dict); /* clear k,v */
 		Py_CLEAR(py_script->global_dict);
@@ -486,6 +496,9 @@ pbs_python_ext_free_python_script(
 		if (py_script->path)
 			free(py_script->path);
 		pbs_python_ext_free_code_obj(py_script);
+#ifdef PYTHON
+		Py_CLEAR(py_script->py_handler);
+#endif
 		pbs_python_ext_free_global_dict(py_script);
 	}
 	return;
@@ -689,11 +702,11 @@ pbs_python_check_and_compile_script(struct python_interpreter_data *interp_data,
 	}
 
 	/* set dict to null during compilation, clearing previous global/local */
-	/* dictionary to prevent leaks.                                        */
-	if (py_script->global_dict) {
-		PyDict_Clear((PyObject *) py_script->global_dict);
-		Py_CLEAR(py_script->global_dict);
-	}
+	/* dictionary to prevent leaks, a persistent script keeps it until    */
+	/* it is recompiled.                                                   */
+	if (recompile)
+		Py_CLEAR(py_script->py_handler);
+	pbs_python_ext_free_global_dict(py_script);
 
 	return 0;
 #else  /* !PYTHON */
@@ -705,6 +718,12 @@ pbs_python_check_and_compile_script(struct python_interpreter_data *interp_data,
  * @brief
  *	runs python script in namespace.
  *
+ * @par
+ *	If the script assigns a callable to PBS_PYTHON_HOOK_HANDLER, the
+ *	handler is called after the script body and the script's globals
+ *	are kept, so later runs only call the handler until the script is
+ *	recompiled.
+ *
  * @param[in] interp_data - pointer to interpreter data
  * @param[in] py_script - pointer to python script info
  * @param[out] exit_code - exit code
@@ -757,6 +776,8 @@ pbs_python_run_code_in_namespace(struct python_interpreter_data *interp_data,
 				(void) memcpy(&(py_script->cur_sbuf), &nbuf,
 					      sizeof(py_script->cur_sbuf));
 				Py_CLEAR(py_script->py_code_obj); /* we are rebuilding */
+				Py_CLEAR(py_script->py_handler);
+				pbs_python_ext_free_global_dict(py_script);
 			}
 		}
 	} while (0);
@@ -782,25 +803,46 @@ pbs_python_run_code_in_namespace(struct python_interpreter_data *interp_data,
 		}
 	}
 
-	/* make new namespace dictionary, NOTE new reference */
+	orig_pid = getpid();
 
-	if (!(pdict = (PyObject *) pbs_python_ext_namespace_init(interp_data))) {
-		log_err(-1, __func__, "while calling pbs_python_ext_namespace_init");
-		return -1;
-	}
-	if ((pbs_python_setup_namespace_dict(pdict) == -1)) {
-		Py_CLEAR(pdict);
-		return -1;
-	}
+	if (py_script->py_handler && py_script->global_dict) {
+		/* persistent script, its setup is already done */
+		PyErr_Clear(); /* clear any exceptions before starting code */
+		retval = PyObject_CallObject((PyObject *) py_script->py_handler, NULL);
+	} else {
+		Py_CLEAR(py_script->py_handler);
+		pbs_python_ext_free_global_dict(py_script);
 
-	py_script->global_dict = pdict;
+		/* make new namespace dictionary, NOTE new reference */
 
-	orig_pid = getpid();
+		if (!(pdict = (PyObject *) pbs_python_ext_namespace_init(interp_data))) {
+			log_err(-1, __func__, "while calling pbs_python_ext_namespace_init");
+			return -1;
+		}
+		if ((pbs_python_setup_namespace_dict(pdict) == -1)) {
+			Py_CLEAR(pdict);
+			return -1;
+		}
+
+		py_script->global_dict = pdict;
+
+		PyErr_Clear(); /* clear any exceptions before starting code */
+		/* precompile strings of code to bytecode objects */
+		retval = PyEval_EvalCode((PyObject *) py_script->py_code_obj,
+					 pdict, pdict);
+
+		/* script ran its setup and registered a handler, call it for this event */
+		if ((orig_pid == getpid()) && !PyErr_Occurred()) {
+			PyObject *handler = PyDict_GetItemString(pdict, PBS_PYTHON_HOOK_HANDLER);
 
-	PyErr_Clear(); /* clear any exceptions before starting code */
-	/* precompile strings of code to bytecode objects */
-	retval = PyEval_EvalCode((PyObject *) py_script->py_code_obj,
-				 pdict, pdict);
+			if (handler && PyCallable_Check(handler)) {
+				Py_INCREF(handler);
+				py_script->py_handler = handler;
+				Py_XDECREF(retval);
+				retval = PyObject_CallObject(handler, NULL);
+			}
+		}
+	}
 
 	/* check for a fork of the hook, terminate fork immediately */
 	if (orig_pid != getpid())
@@ -197,6 +197,9 @@ typedef struct _pbs_iter_item {
 	PyObject *py_iter; /* *the* iterator */
 	void *data;	   /* arbitrary pbs data */
 	int data_index;	   /* index of data to some table */
+	char *filter_state; /* job states to return, NULL for all */
+	char *filter_owner; /* job owner to return, NULL for all */
+	char *attr_mask;    /* attributes to populate, NULL for all */
 	pbs_list_link all_iters;
 } pbs_iter_item;
 
@@ -1967,6 +1970,8 @@ py_resource_string_value(pbs_resource_value *resc_val)
  * @param[in] attr_data_array - array of actual attribute names/resources/values
  * @param[in] attr_def_array - array of attribute definitions (ex. job_attr_def)
  * @param[in] attr_def_array_size - size of attr_def_array.
+ * @param[in] attr_mask - if not NULL, only the attributes whose entry is
+ *			  non-zero are populated
  * @param[in]	perf_label - passed on to hook_perf_stat* call.
  * @param[in]	perf_action - passed on to hook_perf_stat* call.
  *
@@ -1990,7 +1995,8 @@ pbs_python_populate_attributes_to_python_class(PyObject *py_instance,
 					       PyObject **attr_py_array,
 					       attribute *attr_data_array,
 					       attribute_def *attr_def_array,
-					       int attr_def_array_size, char *perf_label, char *perf_action)
+					       int attr_def_array_size, char *attr_mask,
+					       char *perf_label, char *perf_action)
 {
 	int i = 0;	   /* index */
 	int encode_rv = 0; /* at_encode functions return value */
@@ -2011,6 +2017,13 @@ pbs_python_populate_attributes_to_python_class(PyObject *py_instance,
 		attr_p = attr_data_array + i;
 		attr_def_p = attr_def_array + i;
 
+		/* most attributes of an object are unset, skip the encode */
+		if (!is_attr_set(attr_p))
+			continue;
+
+		if ((attr_mask != NULL) && !attr_mask[i])
+			continue;
+
 		memset(&pheadp, 0, sizeof(pheadp));
 		CLEAR_HEAD(pheadp);
 
@@ -3303,7 +3316,7 @@ _pps_helper_get_queue(pbs_queue *pque, const char *que_name, char *perf_label)
 								py_que_attr_types,
 								que->qu_attr,
 								que_attr_def,
-								QA_ATR_LAST, perf_label, perf_action);
+								QA_ATR_LAST, NULL, perf_label, perf_action);
 	if (tmp_rc == -1) {
 		log_err(PBSE_INTERNAL, __func__,
 			"partially populated python queue object");
@@ -3448,7 +3461,7 @@ _pps_helper_get_server(char *perf_label)
 								py_svr_attr_types,
 								server.sv_attr,
 								svr_attr_def,
-								SVR_ATR_LAST, perf_label, perf_action);
+								SVR_ATR_LAST, NULL, perf_label, perf_action);
 
 	if (tmp_rc == -1) {
 		log_err(PBSE_INTERNAL, __func__,
@@ -3489,6 +3502,9 @@ ERROR_EXIT:
  * @param[in] pjob_o - job info
  * @param[in] jobid - job identifier
  * @param[in] qname - queuename
+ * @param[in] attr_mask - attributes to populate (see
+ *			  pbs_python_populate_attributes_to_python_class()),
+ *			  NULL for all
  * @param[in]	perf_label - data passed on to hook_perf_stat* call
  *
  * @return	PyObject*
@@ -3497,7 +3513,7 @@ ERROR_EXIT:
  *
  */
 static PyObject *
-_pps_helper_get_job(job *pjob_o, const char *jobid, const char *qname, char *perf_label)
+_pps_helper_get_job(job *pjob_o, const char *jobid, const char *qname, char *attr_mask, char *perf_label)
 {
 	PyObject *py_job_class = NULL;
 	PyObject *py_job = NULL;
@@ -3575,7 +3591,7 @@ _pps_helper_get_job(job *pjob_o, const char *jobid, const char *qname, char *per
 								py_job_attr_types,
 								pjob->ji_wattr,
 								job_attr_def,
-								JOB_ATR_LAST, perf_label, perf_action);
+								JOB_ATR_LAST, attr_mask, perf_label, perf_action);
 
 	if (tmp_rc == -1) {
 		log_err(PBSE_INTERNAL, __func__,
@@ -3724,7 +3740,7 @@ _pps_helper_get_resv(resc_resv *presv_o, const char *resvid, char *perf_label)
 								py_resv_attr_types,
 								presv->ri_wattr,
 								resv_attr_def,
-								RESV_ATR_LAST, perf_label, perf_action);
+								RESV_ATR_LAST, NULL, perf_label, perf_action);
 
 	if (tmp_rc == -1) {
 		log_err(PBSE_INTERNAL, __func__,
@@ -3782,13 +3798,14 @@ GR_ERROR_EXIT:
  *				  populate a Python vnode object.
  * @param[in]	vname		- name of a vnode to obtain "struct pbsnode *"
  *				  content to populate a Python vnode object.
+ * @param[in]	attr_mask	- attributes to populate, NULL for all.
  * @param[in]	perf_label	- passed on to hook_perf_stat* call.
  *
  * @return      PyObject *	- the Python vnode object corresponding to
  *				  'pvnode_o' or 'vname'.
  */
 static PyObject *
-_pps_helper_get_vnode(struct pbsnode *pvnode_o, const char *vname, char *perf_label)
+_pps_helper_get_vnode(struct pbsnode *pvnode_o, const char *vname, char *attr_mask, char *perf_label)
 {
 	PyObject *py_vnode_class = NULL;
 	PyObject *py_vnode = NULL;
@@ -3848,7 +3865,7 @@ _pps_helper_get_vnode(struct pbsnode *pvnode_o, const char *vname, char *perf_la
 								py_vnode_attr_types,
 								pvnode->nd_attr,
 								node_attr_def,
-								ND_ATR_LAST, perf_label, perf_action);
+								ND_ATR_LAST, attr_mask, perf_label, perf_action);
 
 	if (tmp_rc == -1) {
 		log_err(PBSE_INTERNAL, __func__,
@@ -5027,6 +5044,9 @@ pbs_python_clear_attributes()
 			Py_CLEAR(iter_entry->py_iter);
 
 		delete_link(&iter_entry->all_iters);
+		free(iter_entry->filter_state);
+		free(iter_entry->filter_owner);
+		free(iter_entry->attr_mask);
 		free(iter_entry);
 		iter_entry = nxp_iter_entry;
 	}
@@ -5345,7 +5365,7 @@ _pbs_python_event_set(unsigned int hook_event, char *req_user, char *req_host,
 				hook_set_mode = C_MODE;	      /* ensure still in C mode */
 			}
 		} else {
-			py_job = _pps_helper_get_job(NULL, rqj->rq_jid, NULL, perf_label);
+			py_job = _pps_helper_get_job(NULL, rqj->rq_jid, NULL, NULL, perf_label);
 		}
 		/* NEW - we own ref */
 
@@ -5614,7 +5634,7 @@ _pbs_python_event_set(unsigned int hook_event, char *req_user, char *req_host,
 			}
 		} else {
 			/* we own this reference */
-			py_job_o = _pps_helper_get_job(NULL, rqj->rq_objname, NULL, perf_label);
+			py_job_o = _pps_helper_get_job(NULL, rqj->rq_objname, NULL, NULL, perf_label);
 		}
 
 		if (!py_job_o || (py_job_o == Py_None)) {
@@ -5682,7 +5702,7 @@ _pbs_python_event_set(unsigned int hook_event, char *req_user, char *req_host,
 				hook_set_mode = C_MODE;	      /* ensure still in C mode */
 			}
 		} else {
-			py_job = _pps_helper_get_job(NULL, rqj->rq_jid, NULL, perf_label);
+			py_job = _pps_helper_get_job(NULL, rqj->rq_jid, NULL, NULL, perf_label);
 			/* NEW - we own ref */
 		}
 
@@ -5833,7 +5853,7 @@ _pbs_python_event_set(unsigned int hook_event, char *req_user, char *req_host,
 				hook_set_mode = C_MODE;	      /* ensure still in C mode */
 			}
 		} else {
-			py_job = _pps_helper_get_job(NULL, rqj->rq_jid, NULL, perf_label);
+			py_job = _pps_helper_get_job(NULL, rqj->rq_jid, NULL, NULL, perf_label);
 		}
 		/* NEW - we own ref */
 
@@ -5920,7 +5940,7 @@ _pbs_python_event_set(unsigned int hook_event, char *req_user, char *req_host,
 				hook_set_mode = C_MODE;	      /* ensure still in C mode */
 			}
 		} else {
-			py_job = _pps_helper_get_job(NULL, rqj->rq_pjob->ji_qs.ji_jobid, NULL, perf_label);
+			py_job = _pps_helper_get_job(NULL, rqj->rq_pjob->ji_qs.ji_jobid, NULL, NULL, perf_label);
 			/* NEW - we own ref */
 		}
 
@@ -6003,7 +6023,7 @@ _pbs_python_event_set(unsigned int hook_event, char *req_user, char *req_host,
 					    Py_None);
 
 		/* Retrieve the vnode_o data */
-		py_vnode_o = _pps_helper_get_vnode(vnode_o, NULL, HOOK_PERF_POPULATE_VNODE_O);
+		py_vnode_o = _pps_helper_get_vnode(vnode_o, NULL, NULL, HOOK_PERF_POPULATE_VNODE_O);
 		if (py_vnode_o == NULL) {
 			log_err(PBSE_INTERNAL, __func__, "failed to create a python vnode_o object");
 			goto event_set_exit;
@@ -6017,7 +6037,7 @@ _pbs_python_event_set(unsigned int hook_event, char *req_user, char *req_host,
 		}
 
 		/* Retrieve the vnode data */
-		py_vnode = _pps_helper_get_vnode(vnode, NULL, HOOK_PERF_POPULATE_VNODE);
+		py_vnode = _pps_helper_get_vnode(vnode, NULL, NULL, HOOK_PERF_POPULATE_VNODE);
 		if (py_vnode == NULL) {
 			log_err(PBSE_INTERNAL, __func__, "failed to create a python vnode object");
 			goto event_set_exit;
@@ -7526,7 +7546,7 @@ pbsv1mod_meth_get_job(PyObject *self, PyObject *args, PyObject *kwds)
 	}
 
 	hook_set_mode = C_MODE;
-	py_job = _pps_helper_get_job(NULL, jname, qname, HOOK_PERF_FUNC);
+	py_job = _pps_helper_get_job(NULL, jname, qname, NULL, HOOK_PERF_FUNC);
 	hook_set_mode = PY_MODE;
 
 	if (py_job != NULL)
@@ -7631,7 +7651,7 @@ pbsv1mod_meth_get_vnode(PyObject *self, PyObject *args, PyObject *kwds)
 	}
 
 	hook_set_mode = C_MODE;
-	py_vnode = _pps_helper_get_vnode(NULL, vname, HOOK_PERF_FUNC);
+	py_vnode = _pps_helper_get_vnode(NULL, vname, NULL, HOOK_PERF_FUNC);
 	hook_set_mode = PY_MODE;
 
 	if (py_vnode != NULL)
@@ -9069,8 +9089,141 @@ getval_exit:
 	return (strval);
 }
 
+/**
+ * @brief
+ *	Check a job against the state and owner filters of a server
+ *	jobs() iterator.
+ *
+ * @param[in]	iter_entry - the iterator
+ * @param[in]	pjob - the job to check
+ *
+ * @return	int
+ * @retval	1	- job should be returned by the iterator
+ * @retval	0	- job is filtered out
+ */
+static int
+iter_job_match(pbs_iter_item *iter_entry, job *pjob)
+{
+	char *owner;
+	size_t len;
+
+	if (iter_entry->filter_state != NULL) {
+		char state = get_job_state(pjob);
+
+		if ((state == '\0') || (strchr(iter_entry->filter_state, state) == NULL))
+			return 0;
+	}
+
+	if (iter_entry->filter_owner != NULL) {
+		/* Job_Owner is <user>@<host>, match on the <user> part */
+		owner = get_jattr_str(pjob, JOB_ATR_job_owner);
+		if (owner == NULL)
+			return 0;
+		len = strlen(iter_entry->filter_owner);
+		if ((strncmp(owner, iter_entry->filter_owner, len) != 0) ||
+		    ((owner[len] != '@') && (owner[len] != '\0')))
+			return 0;
+	}
+
+	return 1;
+}
+
+/**
+ * @brief
+ *	Advance a jobs() iterator cursor from 'pjob' to the first job that
+ *	passes the iterator's filters.
+ *
+ * @param[in]	iter_entry - the iterator
+ * @param[in]	pjob - first candidate job
+ * @param[in]	by_queue - walk the queue's job list rather than the
+ *			   server's
+ *
+ * @return	job *
+ * @retval	the next matching job, NULL if there are no more
+ */
+static job *
+iter_next_job(pbs_iter_item *iter_entry, job *pjob, int by_queue)
+{
+	while ((pjob != NULL) && !iter_job_match(iter_entry, pjob)) {
+		if (by_queue)
+			pjob = (job *) GET_NEXT(pjob->ji_jobque);
+		else
+			pjob = (job *) GET_NEXT(pjob->ji_alljobs);
+	}
+	return pjob;
+}
+
+/**
+ * @brief
+ *	Build the attribute projection mask of an iterator from the
+ *	Python list of attribute names given to it.
+ *
+ * @param[in]	py_attrs - a sequence of attribute names, or a single name
+ * @param[in]	attr_idx - attribute name index (e.g. job_attr_idx)
+ * @param[in]	attr_def - attribute definitions (e.g. job_attr_def)
+ * @param[in]	attr_size - number of entries in 'attr_def'
+ * @param[out]	mask - malloced array of 'attr_size' flags, or NULL if no
+ *		       projection was asked for
+ *
+ * @return	int
+ * @retval	0	- success
+ * @retval	-1	- failure, with a Python exception set
+ */
+static int
+iter_attr_mask(PyObject *py_attrs, void *attr_idx, attribute_def *attr_def,
+	       int attr_size, char **mask)
+{
+	PyObject *py_seq;
+	PyObject *py_item;
+	const char *name;
+	Py_ssize_t i;
+	int idx;
+
+	*mask = NULL;
+	if ((py_attrs == NULL) || (py_attrs == Py_None))
+		return 0;
+
+	if (PyUnicode_Check(py_attrs))
+		py_seq = PyTuple_Pack(1, py_attrs); /* NEW ref */
+	else
+		py_seq = PySequence_Fast(py_attrs, "attrs must be a list of attribute names"); /* NEW ref */
+	if (py_seq == NULL)
+		return -1;
+
+	*mask = calloc(attr_size, sizeof(char));
+	if (*mask == NULL) {
+		Py_DECREF(py_seq);
+		PyErr_SetString(PyExc_AssertionError, "failed to malloc memory");
+		return -1;
+	}
+
+	for (i = 0; i < PySequence_Fast_GET_SIZE(py_seq); i++) {
+		py_item = PySequence_Fast_GET_ITEM(py_seq, i); /* borrowed */
+		name = PyUnicode_Check(py_item) ? PyUnicode_AsUTF8(py_item) : NULL;
+		if (name == NULL) {
+			PyErr_SetString(PyExc_ValueError, "attrs must be a list of attribute names");
+			goto err;
+		}
+		idx = find_attr(attr_idx, attr_def, (char *) name);
+		if (idx < 0) {
+			snprintf(log_buffer, LOG_BUF_SIZE, "unknown attribute %s", name);
+			PyErr_SetString(PyExc_ValueError, log_buffer);
+			goto err;
+		}
+		(*mask)[idx] = 1;
+	}
+	Py_DECREF(py_seq);
+	return 0;
+
+err:
+	Py_DECREF(py_seq);
+	free(*mask);
+	*mask = NULL;
+	return -1;
+}
+
 const char pbsv1mod_meth_iter_nextfunc_doc[] =
-	"iter_nextfunc(meth_mode, obj_name, filter1, filter2)\n\
+	"iter_nextfunc(meth_mode, obj_name, filter1, filter2[, filter_state, filter_owner, attrs])\n\
 \n\
    meth_mode:	can be 1 if called from __init__() or 0 if from next()\n\
 		method of a pbs_iter type.\n\
@@ -9083,6 +9236,15 @@ const char pbsv1mod_meth_iter_nextfunc_doc[] =
 		being referenced. For example, this can be set to\n\
 		some <queue_name>, to have the iterator represents\n\
 		a list of jobs on <queue_name>@<server_name>\n\
+   filter_state: for \"jobs\", only return jobs in one of these states\n\
+		(e.g. \"QH\").\n\
+   filter_owner: for \"jobs\", only return jobs owned by this user.\n\
+   attrs:	for \"jobs\" and \"vnodes\", a list of attribute names;\n\
+		only these are populated in the returned objects.\n\
+   The optional arguments are only looked at on __init__.\n\
+\n\
+   Objects are produced one at a time as next() is called, so breaking\n\
+   out of the loop early does not pay for the rest of the list.\n\
 \n\
    Returns the next PBS object in Python form to evaluate within a looping\n\
    construct. The idea is on a iterator instantiation, the following gets\n\
@@ -9104,10 +9266,10 @@ pbsv1mod_meth_iter_nextfunc(PyObject *self, PyObject *args, PyObject *kwds)
 {
 #ifdef NAS /* localmod 014 */
 	static char *kwlist[] = {"iter_obj", "meth_mode", "obj_name", "filter1", "filter2", "ignore_fin", "filter_user",
-				 NULL};
+				 "filter_state", "filter_owner", "attrs", NULL};
 #else
 	static char *kwlist[] = {"iter_obj", "meth_mode", "obj_name", "filter1", "filter2",
-				 NULL};
+				 "filter_state", "filter_owner", "attrs", NULL};
 #endif /* localmod 014 */
 	int meth_mode;
 	char *obj_name = NULL;
@@ -9117,6 +9279,11 @@ pbsv1mod_meth_iter_nextfunc(PyObject *self, PyObject *args, PyObject *kwds)
 	int ignore_fin;
 	char *filter_user = NULL;
 #endif /* localmod 014 */
+	char *filter_state = NULL;
+	char *filter_owner = NULL;
+	PyObject *py_attrs = NULL;
+	char *attr_mask = NULL;
+	int by_queue = 0;
 	pbs_iter_item *iter_entry = NULL;
 	pbs_queue *pque = NULL;
 	PyObject *py_object = NULL;
@@ -9125,7 +9292,7 @@ pbsv1mod_meth_iter_nextfunc(PyObject *self, PyObject *args, PyObject *kwds)
 
 #ifdef NAS /* localmod 014 */
 	if (!PyArg_ParseTupleAndKeywords(args, kwds,
-					 "Oisssis:iter_nextfunc",
+					 "Oisssis|zzO:iter_nextfunc",
 					 kwlist,
 					 &py_self,
 					 &meth_mode,
@@ -9133,16 +9300,22 @@ pbsv1mod_meth_iter_nextfunc(PyObject *self, PyObject *args, PyObject *kwds)
 					 &filter1,
 					 &filter2,
 					 &ignore_fin,
-					 &filter_user)) {
+					 &filter_user,
+					 &filter_state,
+					 &filter_owner,
+					 &py_attrs)) {
 #else
 	if (!PyArg_ParseTupleAndKeywords(args, kwds,
-					 "Oisss:iter_nextfunc",
+					 "Oisss|zzO:iter_nextfunc",
 					 kwlist,
 					 &py_self,
 					 &meth_mode,
 					 &obj_name,
 					 &filter1,
-					 &filter2)) {
+					 &filter2,
+					 &filter_state,
+					 &filter_owner,
+					 &py_attrs)) {
 #endif /* localmod 014 */
 		return NULL;
 	}
@@ -9166,16 +9339,32 @@ pbsv1mod_meth_iter_nextfunc(PyObject *self, PyObject *args, PyObject *kwds)
 				return NULL;
 			}
 
+			if (strcmp(obj_name, ITER_JOBS) == 0) {
+				if (iter_attr_mask(py_attrs, job_attr_idx, job_attr_def,
+						   JOB_ATR_LAST, &attr_mask) != 0)
+					return NULL;
+			} else if (strcmp(obj_name, ITER_VNODES) == 0) {
+				if (iter_attr_mask(py_attrs, node_attr_idx, node_attr_def,
+						   ND_ATR_LAST, &attr_mask) != 0)
+					return NULL;
+			}
+
 			iter_entry = (pbs_iter_item *) malloc(sizeof(pbs_iter_item));
 			if (iter_entry == NULL) {
 				log_err(errno, __func__, "no memory");
 				PyErr_SetString(PyExc_AssertionError,
 						"failed to malloc memory");
+				free(attr_mask);
 				return NULL;
 			}
 			(void) memset((char *) iter_entry, (int) 0,
 				      (size_t) sizeof(pbs_iter_item));
 			CLEAR_LINK(iter_entry->all_iters);
+			iter_entry->attr_mask = attr_mask;
+			if ((filter_state != NULL) && (filter_state[0] != '\0'))
+				iter_entry->filter_state = strdup(filter_state);
+			if ((filter_owner != NULL) && (filter_owner[0] != '\0'))
+				iter_entry->filter_owner = strdup(filter_owner);
 
 			iter_entry->py_iter = py_self;
 			Py_INCREF(py_self);
@@ -9211,6 +9400,7 @@ pbsv1mod_meth_iter_nextfunc(PyObject *self, PyObject *args, PyObject *kwds)
 						return NULL;
 					}
 					iter_entry->data = (job *) GET_NEXT(pque->qu_jobs);
+					by_queue = 1;
 
 				} else { /* get jobs from server */
 					iter_entry->data = (job *) GET_NEXT(svr_alljobs);
@@ -9228,6 +9418,8 @@ pbsv1mod_meth_iter_nextfunc(PyObject *self, PyObject *args, PyObject *kwds)
 					iter_entry->data = njob;
 #endif /* localmod 014 */
 				}
+				iter_entry->data = iter_next_job(iter_entry,
+								 (job *) iter_entry->data, by_queue);
 			} else if (strcmp(obj_name, ITER_RESERVATIONS) == 0) {
 				if ((filter1 != NULL) && (filter1[0] != '\0') &&
 				    (strcmp(filter1, server_name) != 0)) {
@@ -9291,7 +9483,7 @@ pbsv1mod_meth_iter_nextfunc(PyObject *self, PyObject *args, PyObject *kwds)
 				iter_entry->data = (pbs_queue *) GET_NEXT(
 					((pbs_queue *) iter_entry->data)->qu_link);
 			} else if (strcmp(obj_name, ITER_JOBS) == 0) {
-				py_object = _pps_helper_get_job((job *) iter_entry->data, NULL, NULL, HOOK_PERF_FUNC);
+				py_object = _pps_helper_get_job((job *) iter_entry->data, NULL, NULL, iter_entry->attr_mask, HOOK_PERF_FUNC);
 
 #ifdef NAS /* localmod 014 */
 				if (!ignore_fin &&
@@ -9308,6 +9500,7 @@ pbsv1mod_meth_iter_nextfunc(PyObject *self, PyObject *args, PyObject *kwds)
 					/* (i.e. use ji_jobque here)        */
 					iter_entry->data = (job *) GET_NEXT(
 						((job *) iter_entry->data)->ji_jobque);
+					by_queue = 1;
 				} else {
 					iter_entry->data = (job *) GET_NEXT(
 						((job *) iter_entry->data)->ji_alljobs);
@@ -9324,9 +9517,11 @@ pbsv1mod_meth_iter_nextfunc(PyObject *self, PyObject *args, PyObject *kwds)
 					iter_entry->data = njob;
 #endif /* localmod 014 */
 				}
+				iter_entry->data = iter_next_job(iter_entry,
+								 (job *) iter_entry->data, by_queue);
 			} else if (strcmp(obj_name, ITER_VNODES) == 0) {
 
-				py_object = _pps_helper_get_vnode((struct pbsnode *) iter_entry->data, NULL, HOOK_PERF_FUNC);
+				py_object = _pps_helper_get_vnode((struct pbsnode *) iter_entry->data, NULL, iter_entry->attr_mask, HOOK_PERF_FUNC);
 
 				iter_entry->data = NULL;
 				vi = iter_entry->data_index + 1;
@@ -170,6 +170,8 @@ typedef struct {
 	void (*close_func)(int); /* close function to be called when this stream is closed */
 
 	tpp_que_elem_t *timeout_node; /* pointer to myself in the timeout streams queue */
+
+	unsigned short compr_skip; /* sends left to skip compression for, APP thread only */
 } stream_t;
 
 /*
@@ -538,6 +540,24 @@ static int
 connect_router(tpp_router_t *r)
 {
 	tpp_context_t *ctx;
+	int delay = r->delay;
+	static unsigned int seed = 0;
+
+	/*
+	 * spread retries out by up to another retry interval, so that the
+	 * leaves which lost a pbs_comm at the same moment (eg, it restarted)
+	 * do not all reconnect and send their joins in the same second
+	 */
+	if (delay > 0) {
+		if (seed == 0) {
+			char *p;
+
+			seed = (unsigned int) time(0) ^ (unsigned int) getpid();
+			for (p = tpp_conf->node_name; p && *p; p++)
+				seed = seed * 31 + (unsigned char) *p;
+		}
+		delay += rand_r(&seed) % (delay + 1);
+	}
 
 	/* since we connected we should add a context */
 	if ((ctx = (tpp_context_t *) malloc(sizeof(tpp_context_t))) == NULL) {
@@ -548,7 +568,7 @@ connect_router(tpp_router_t *r)
 	ctx->type = TPP_ROUTER_NODE;
 
 	/* initiate connections to the tpp router (single for now) */
-	if (tpp_transport_connect(r->router_name, r->delay, ctx, &(r->conn_fd)) == -1) {
+	if (tpp_transport_connect(r->router_name, delay, ctx, &(r->conn_fd)) == -1) {
 		tpp_log(LOG_ERR, NULL, "Connection to pbs_comm %s failed", r->router_name);
 		return -1;
 	}
@@ -607,7 +627,8 @@ tpp_init(struct tpp_config *cnf)
 	tpp_init_rwlock(&strmarray_lock);
 	tpp_init_lock(&strm_action_queue_lock);
 
-	if (tpp_mbox_init(&app_mbox, "app_mbox", TPP_MAX_MBOX_SIZE) != 0) {
+	/* not limited, refusing data already read off the network would only lose it */
+	if (tpp_mbox_init(&app_mbox, "app_mbox", -1) != 0) {
 		tpp_log(LOG_CRIT, __func__, "Failed to create application mbox");
 		return -1;
 	}
@@ -893,7 +914,8 @@ get_active_router()
  * @param[in] len - Length of the data block to be sent
  *
  * @return  Error code
- * @retval  -1 - Failure
+ * @retval  -1 - Failure, errno ENOBUFS if only because too much data is
+ *		 already queued to send, the stream is then not closed
  * @retval   >=0 - Success - amount of data sent
  *
  * @par Side Effects:
@@ -918,13 +940,29 @@ tpp_send(int sd, void *data, int len)
 		return -1;
 	}
 
+	data_dup = NULL;
 	if ((tpp_conf->compress == 1) && (len > TPP_COMPR_SIZE)) {
-		data_dup = tpp_deflate(data, len, &to_send); /* creates a copy */
-		if (data_dup == NULL) {
-			tpp_log(LOG_CRIT, __func__, "tpp deflate failed");
-			return -1;
+		if (strm->compr_skip > 0)
+			strm->compr_skip--;
+		else {
+			data_dup = tpp_deflate(data, len, &to_send); /* creates a copy */
+			if (data_dup == NULL) {
+				tpp_log(LOG_CRIT, __func__, "tpp deflate failed");
+				return -1;
+			}
+			/*
+			 * the receiver tells compressed data apart by its length, and
+			 * data from this stream that did not shrink enough is unlikely
+			 * to do better next time, so send it as is and back off
+			 */
+			if (to_send >= len - len / TPP_COMPR_MIN_GAIN) {
+				free(data_dup);
+				data_dup = NULL;
+				strm->compr_skip = TPP_COMPR_BACKOFF;
+			}
 		}
-	} else {
+	}
+	if (data_dup == NULL) {
 		data_dup = malloc(len);
 		if (!data_dup) {
 			tpp_log(errno, __func__, "Failed to duplicate data");
@@ -967,10 +1005,12 @@ tpp_send(int sd, void *data, int len)
 	if (rc == 0)
 		return len; /* all given data sent, so return len */
 
-	if (rc == -2)
-		tpp_log(LOG_CRIT, __func__, "mbox full, returning error to App!");
-	else if (rc == -1)
-		tpp_log(LOG_ERR, __func__, "Failed to send to router");
+	if (rc == -2) {
+		/* backpressure, the stream stays usable for the App to try again */
+		errno = ENOBUFS;
+		return -1;
+	}
+	tpp_log(LOG_ERR, __func__, "Failed to send to router");
 
 	send_app_strm_close(strm, TPP_CMD_NET_CLOSE, 0);
 	return rc;
@@ -1001,6 +1041,28 @@ tpp_poll(void)
 	return -2;
 }
 
+/**
+ * @brief
+ *	Bytes of messages and notifications the IO threads have passed to
+ *	the APP that it has not read yet
+ *
+ * @return - size of the backlog in bytes
+ *
+ * @par MT-safe: Yes
+ *
+ */
+int
+tpp_app_backlog(void)
+{
+	int backlog;
+
+	tpp_lock(&app_mbox.mbox_mutex);
+	backlog = app_mbox.mbox_size;
+	tpp_unlock(&app_mbox.mbox_mutex);
+
+	return backlog;
+}
+
 /**
  * @brief
  *	Function to recv/read data from a tpp stream
@@ -1820,8 +1882,8 @@ tpp_mcast_notify_members(int mtfd, int cmd)
  *                       len is the total length of the data
  *
  * @return  Error code
- * @retval  -1 - Failure
- * @retval  -2 - transport buffers full
+ * @retval  -1 - Failure, errno ENOBUFS if only because too much data is
+ *		 already queued to send, the member streams are then not closed
  * @retval   >=0 - Success - amount of data sent
  *
  * @par Side Effects:
@@ -1942,6 +2004,11 @@ tpp_mcast_send(int mtfd, void *data, unsigned int to_send, unsigned int len)
 	if (rc == 0)
 		return len; /* all given data sent, so return len */
 
+	if (rc == -2) {
+		/* backpressure, minfo_buf went with the refused packet, members stay open */
+		errno = ENOBUFS;
+		return -1;
+	}
 	tpp_log(LOG_ERR, __func__, "Failed to send to router"); /* fall through */
 
 err:
@@ -934,6 +934,8 @@ tpp_mbox_init(tpp_mbox_t *mbox, char *name, int size)
 	snprintf(mbox->mbox_name, sizeof(mbox->mbox_name), "%s", name);
 	mbox->mbox_size = 0;
 	mbox->max_size = size;
+	mbox->mbox_signalled = 0;
+	mbox->mbox_prio_tail = NULL;
 
 #ifdef HAVE_SYS_EVENTFD_H
 	if ((mbox->mbox_eventfd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) == -1) {
@@ -1084,11 +1086,14 @@ tpp_mbox_read(tpp_mbox_t *mbox, unsigned int *tfd, int *cmdval, void **data)
 	tpp_lock(&mbox->mbox_mutex);
 
 	/* read the data from the mbox cmd queue head */
+	if (TPP_QUE_HEAD(&mbox->mbox_queue) == mbox->mbox_prio_tail)
+		mbox->mbox_prio_tail = NULL;
 	cmd = (tpp_cmd_t *) tpp_deque(&mbox->mbox_queue);
 
 	/* if no more data, clear all notifications */
 	if (cmd == NULL) {
 		mbox->mbox_size = 0;
+		mbox->mbox_signalled = 0;
 #ifdef HAVE_SYS_EVENTFD_H
 		if (read(mbox->mbox_eventfd, &u, sizeof(uint64_t)) == -1)
 			;
@@ -1152,6 +1157,8 @@ tpp_mbox_clear(tpp_mbox_t *mbox, tpp_que_elem_t **n, unsigned int tfd, short *cm
 	while ((*n = TPP_QUE_NEXT(&mbox->mbox_queue, *n))) {
 		cmd = TPP_QUE_DATA(*n);
 		if (cmd && cmd->tfd == tfd) {
+			if (*n == mbox->mbox_prio_tail)
+				mbox->mbox_prio_tail = (*n)->prev;
 			*n = tpp_que_del_elem(&mbox->mbox_queue, *n);
 			if (cmdval)
 				*cmdval = cmd->cmdval;
@@ -1178,9 +1185,12 @@ tpp_mbox_clear(tpp_mbox_t *mbox, tpp_que_elem_t **n, unsigned int tfd, short *cm
  * @param[in] - tfd    - The Virtual file descriptor
  * @param[in] - data   - Any data pointer associated, if any (or NULL)
  * @param[in] - sz     - size of the data
+ * @param[in] - urgent - queue ahead of the non urgent commands, regardless
+ *			 of the size limit of the mbox
  *
  * @return Error code
  * @retval -1 Failure
+ * @retval -2 mbox is full (errno ENOBUFS)
  * @retval  0 Success
  *
  * @par Side Effects:
@@ -1189,11 +1199,13 @@ tpp_mbox_clear(tpp_mbox_t *mbox, tpp_que_elem_t **n, unsigned int tfd, short *cm
  * @par MT-safe: Yes
  *
  */
-int
-tpp_mbox_post(tpp_mbox_t *mbox, unsigned int tfd, char cmdval, void *data, int sz)
+static int
+mbox_post(tpp_mbox_t *mbox, unsigned int tfd, char cmdval, void *data, int sz, int urgent)
 {
 	tpp_cmd_t *cmd;
+	tpp_que_elem_t *n;
 	ssize_t s;
+	int signalled;
 #ifdef HAVE_SYS_EVENTFD_H
 	uint64_t u;
 #else
@@ -1214,7 +1226,25 @@ tpp_mbox_post(tpp_mbox_t *mbox, unsigned int tfd, char cmdval, void *data, int s
 	/* add the cmd to the threads queue */
 	tpp_lock(&mbox->mbox_mutex);
 
-	if (tpp_enque(&mbox->mbox_queue, cmd) == NULL) {
+	if (urgent) {
+		/* behind the urgent cmds already queued, ahead of the others */
+		if (mbox->mbox_prio_tail)
+			n = tpp_que_ins_elem(&mbox->mbox_queue, mbox->mbox_prio_tail, cmd, 0);
+		else if (TPP_QUE_HEAD(&mbox->mbox_queue))
+			n = tpp_que_ins_elem(&mbox->mbox_queue, TPP_QUE_HEAD(&mbox->mbox_queue), cmd, 1);
+		else
+			n = tpp_enque(&mbox->mbox_queue, cmd);
+		if (n)
+			mbox->mbox_prio_tail = n;
+	} else if ((mbox->max_size > 0) && (sz > 0) && (mbox->mbox_size + sz > mbox->max_size)) {
+		tpp_unlock(&mbox->mbox_mutex);
+		free(cmd);
+		errno = ENOBUFS;
+		return -2;
+	} else
+		n = tpp_enque(&mbox->mbox_queue, cmd);
+
+	if (n == NULL) {
 		tpp_unlock(&mbox->mbox_mutex);
 		free(cmd);
 		tpp_log(LOG_CRIT, __func__, "Out of memory in em_mbox_post for mbox=%s", mbox->mbox_name);
@@ -1224,8 +1254,19 @@ tpp_mbox_post(tpp_mbox_t *mbox, unsigned int tfd, char cmdval, void *data, int s
 	/* add to the size to global size during enque */
 	mbox->mbox_size += sz;
 
+	/*
+	 * The notification stays readable until the consumer finds the queue
+	 * empty (see tpp_mbox_read), so only the first post after that needs
+	 * to signal; later posts are picked up by the same wakeup.
+	 */
+	signalled = mbox->mbox_signalled;
+	mbox->mbox_signalled = 1;
+
 	tpp_unlock(&mbox->mbox_mutex);
 
+	if (signalled)
+		return 0;
+
 	while (1) {
 		/* send a notification to the thread */
 #ifdef HAVE_SYS_EVENTFD_H
@@ -1245,9 +1286,61 @@ tpp_mbox_post(tpp_mbox_t *mbox, unsigned int tfd, char cmdval, void *data, int s
 				break;
 			} else if (errno != EINTR) {
 				tpp_log(LOG_CRIT, __func__, "mbox post failed for mbox=%s, errno=%d", mbox->mbox_name, errno);
+				tpp_lock(&mbox->mbox_mutex);
+				mbox->mbox_signalled = 0;
+				tpp_unlock(&mbox->mbox_mutex);
 				return -1;
 			}
 		}
 	}
 	return 0;
 }
+
+/**
+ * @brief
+ *	Send a command to the threads msg queue, behind those already there
+ *
+ * @param[in] - mbox   - The mbox to post to
+ * @param[in] - cmdval - The command or operation
+ * @param[in] - tfd    - The Virtual file descriptor
+ * @param[in] - data   - Any data pointer associated, if any (or NULL)
+ * @param[in] - sz     - size of the data
+ *
+ * @return Error code
+ * @retval -1 Failure
+ * @retval -2 data would take the mbox past its size limit (errno ENOBUFS)
+ * @retval  0 Success
+ *
+ * @par MT-safe: Yes
+ *
+ */
+int
+tpp_mbox_post(tpp_mbox_t *mbox, unsigned int tfd, char cmdval, void *data, int sz)
+{
+	return mbox_post(mbox, tfd, cmdval, data, sz, 0);
+}
+
+/**
+ * @brief
+ *	Send a command to the threads msg queue ahead of the non urgent
+ *	commands, and whatever the size limit of the mbox.  Urgent commands
+ *	keep their order among themselves.
+ *
+ * @param[in] - mbox   - The mbox to post to
+ * @param[in] - cmdval - The command or operation
+ * @param[in] - tfd    - The Virtual file descriptor
+ * @param[in] - data   - Any data pointer associated, if any (or NULL)
+ * @param[in] - sz     - size of the data
+ *
+ * @return Error code
+ * @retval -1 Failure
+ * @retval  0 Success
+ *
+ * @par MT-safe: Yes
+ *
+ */
+int
+tpp_mbox_post_urgent(tpp_mbox_t *mbox, unsigned int tfd, char cmdval, void *data, int sz)
+{
+	return mbox_post(mbox, tfd, cmdval, data, sz, 1);
+}
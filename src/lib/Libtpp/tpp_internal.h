@@ -56,6 +56,7 @@ extern "C" {
 #include "tpp.h"
 
 #ifndef WIN32
+#include <sys/uio.h>
 
 #define tpp_pipe_cr(a) pipe(a)
 #define tpp_pipe_read(a, b, c) read(a, b, c)
@@ -69,6 +70,7 @@ extern "C" {
 #define tpp_sock_connect(a, b, c) connect(a, b, c)
 #define tpp_sock_recv(a, b, c, d) recv(a, b, c, d)
 #define tpp_sock_send(a, b, c, d) send(a, b, c, d)
+#define tpp_sock_sendv(a, b, c) writev(a, b, c)
 #define tpp_sock_select(a, b, c, d, e) select(a, b, c, d, e)
 #define tpp_sock_close(a) close(a)
 #define tpp_sock_getsockopt(a, b, c, d, e) getsockopt(a, b, c, d, e)
@@ -134,11 +136,22 @@ typedef struct {
 	char family; /* Ipv4 or IPV6 etc */
 } tpp_addr_t;
 
+/*
+ * Reference counted, immutable data buffer that can be shared by the
+ * chunks of several packets (eg, a payload forwarded to many destinations)
+ */
+typedef struct {
+	pthread_mutex_t ref_lock; /* protects ref_count */
+	int ref_count;		  /* number of chunks referring to this buffer */
+	char data[1];		  /* the actual data, allocated along with this structure */
+} tpp_shared_data_t;
+
 typedef struct {
 	pbs_list_link chunk_link;
-	char *data; /* pointer to the data buffer */
-	size_t len; /* length of the data buffer */
-	char *pos;  /* current position - till which data is consumed */
+	char *data;		   /* pointer to the data buffer */
+	size_t len;		   /* length of the data buffer */
+	char *pos;		   /* current position - till which data is consumed */
+	tpp_shared_data_t *shared; /* shared buffer data points into, NULL if data is owned */
 } tpp_chunk_t;
 
 /*
@@ -257,7 +270,14 @@ typedef struct {
 #define TPP_SLOT_BUSY 1
 #define TPP_SLOT_DELETED 2
 
-#define TPP_MAX_MBOX_SIZE 640000
+/*
+ * Budgets for data queued to be sent out, past which sends are refused
+ * with -2 (ENOBUFS) instead of buffering for a slow or unreachable peer.
+ * Control packets (joins, leaves, ctl msgs) are exempt and go ahead of
+ * queued data.
+ */
+#define TPP_CONN_BUF_LIMIT (64 * 1024 * 1024)	      /* per physical connection, default */
+#define TPP_TOTAL_BUF_LIMIT (1024L * 1024 * 1024) /* over all physical connections */
 
 /* tpp internal message header types */
 enum TPP_MSG_TYPES {
@@ -286,6 +306,8 @@ enum TPP_MSG_TYPES {
 #define TPP_MIN_WAIT 2
 #define TPP_SEND_SIZE 8192
 #define TPP_COMPR_SIZE 8192
+#define TPP_COMPR_MIN_GAIN 8 /* compressed data must save at least 1/8th of the size */
+#define TPP_COMPR_BACKOFF 16 /* sends to skip compression for after it did not pay off */
 
 /* tpp cmds used internally by the layer to notify messages between threads */
 #define TPP_CMD_SEND 1
@@ -393,6 +415,8 @@ typedef struct {
 	tpp_que_t mbox_queue;
 	int max_size;
 	int mbox_size;
+	int mbox_signalled;		/* notification fd already armed, consumer has not drained yet */
+	tpp_que_elem_t *mbox_prio_tail; /* last urgent cmd, urgent cmds are queued ahead of the rest */
 #ifdef HAVE_SYS_EVENTFD_H
 	int mbox_eventfd;
 #else
@@ -412,6 +436,8 @@ typedef struct {
 typedef struct {
 	void *td;
 	char tppstaticbuf[TPP_GEN_BUF_SZ];
+	char *encbuf;	   /* scratch for flattening a packet to encrypt */
+	size_t encbuf_sz;  /* allocated size of encbuf */
 } tpp_tls_t;
 
 typedef struct {
@@ -446,6 +472,9 @@ tpp_tls_t *tpp_get_tls(void);
 char *mk_hostname(char *, int);
 struct sockaddr_in *tpp_localaddr(int);
 tpp_packet_t *tpp_bld_pkt(tpp_packet_t *, void *, int, int, void **);
+tpp_shared_data_t *tpp_shared_data_alloc(void *, int);
+void tpp_shared_data_release(tpp_shared_data_t *);
+tpp_packet_t *tpp_bld_pkt_shared(tpp_packet_t *, tpp_shared_data_t *, int);
 
 void tpp_router_terminate(void);
 void tpp_free_tls(void);
@@ -603,6 +632,7 @@ int tpp_mbox_monitor(void *, tpp_mbox_t *);
 int tpp_mbox_read(tpp_mbox_t *, unsigned int *, int *, void **);
 int tpp_mbox_clear(tpp_mbox_t *, tpp_que_elem_t **, unsigned int, short *, void **);
 int tpp_mbox_post(tpp_mbox_t *, unsigned int, char, void *, int);
+int tpp_mbox_post_urgent(tpp_mbox_t *, unsigned int, char, void *, int);
 int tpp_mbox_getfd(tpp_mbox_t *);
 
 extern int tpp_going_down;
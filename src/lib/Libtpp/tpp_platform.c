@@ -721,19 +721,14 @@ tpp_sock_resolve_host(char *host, int *count)
 {
 	tpp_addr_t *ips = NULL;
 	void *tmp;
-	int i, j;
-	struct addrinfo *aip, *pai;
-	struct addrinfo hints;
+	struct in_addr *addrs;
+	int naddrs;
+	int i, j, k;
 	int rc = 0;
 
 	errno = 0;
 	*count = 0;
 
-	memset(&hints, 0, sizeof(struct addrinfo));
-	hints.ai_family = AF_INET;
-	hints.ai_socktype = SOCK_STREAM;
-	hints.ai_protocol = IPPROTO_TCP;
-
 #ifndef WIN32
 	/* 
 	 * introducing a new mutex to prevent child process from 
@@ -741,7 +736,7 @@ tpp_sock_resolve_host(char *host, int *count)
 	 */
 	tpp_lock(&tpp_nslookup_mutex);
 #endif
-	rc = getaddrinfo(host, NULL, &hints, &pai);
+	rc = pbs_dns_lookup(host, &addrs, &naddrs);
 	/* unlock nslookup mutex */
 #ifndef WIN32
 	tpp_unlock(&tpp_nslookup_mutex);
@@ -751,54 +746,37 @@ tpp_sock_resolve_host(char *host, int *count)
 		return NULL;
 	}
 
-	*count = 0;
-	for (aip = pai; aip != NULL; aip = aip->ai_next) {
-		if (aip->ai_family == AF_INET) { /* for now only count IPv4 addresses */
-			(*count)++;
-		}
-	}
-
-	if (*count == 0) {
+	if (naddrs == 0) {
 		tpp_log(LOG_CRIT, NULL, "Could not find any usable IP address for host %s", host);
 		return NULL;
 	}
 
-	ips = calloc(*count, sizeof(tpp_addr_t));
+	ips = calloc(naddrs, sizeof(tpp_addr_t));
 	if (!ips) {
-		*count = 0;
+		free(addrs);
 		return NULL;
 	}
 
 	i = 0;
-	for (aip = pai; aip != NULL; aip = aip->ai_next) {
-		/* skip non-IPv4 addresses */
-		/*if (aip->ai_family == AF_INET || aip->ai_family == AF_INET6) {*/
-		if (aip->ai_family == AF_INET) { /* for now only work with IPv4 */
-			if (aip->ai_family == AF_INET) {
-				struct sockaddr_in *sa = (struct sockaddr_in *) aip->ai_addr;
-				if (ntohl(sa->sin_addr.s_addr) >> 24 == IN_LOOPBACKNET)
-					continue;
-				memcpy(&ips[i].ip, &sa->sin_addr, sizeof(sa->sin_addr));
-			} else if (aip->ai_family == AF_INET6) {
-				struct sockaddr_in6 *sa6 = (struct sockaddr_in6 *) aip->ai_addr;
-				memcpy(&ips[i].ip, &sa6->sin6_addr, sizeof(sa6->sin6_addr));
-			}
-			ips[i].family = (aip->ai_family == AF_INET6) ? TPP_ADDR_FAMILY_IPV6 : TPP_ADDR_FAMILY_IPV4;
-			ips[i].port = 0;
-
-			for (j = 0; j < i; j++) {
-				/* check for duplicate ip addresses dont add if duplicate */
-				if (memcmp(&ips[j].ip, &ips[i].ip, sizeof(ips[j].ip)) == 0) {
-					break;
-				}
-			}
-			if (j == i) {
-				/* did not find duplicate so use this slot */
-				i++;
+	for (k = 0; k < naddrs; k++) { /* for now only work with IPv4 */
+		if (ntohl(addrs[k].s_addr) >> 24 == IN_LOOPBACKNET)
+			continue;
+		memcpy(&ips[i].ip, &addrs[k], sizeof(addrs[k]));
+		ips[i].family = TPP_ADDR_FAMILY_IPV4;
+		ips[i].port = 0;
+
+		for (j = 0; j < i; j++) {
+			/* check for duplicate ip addresses dont add if duplicate */
+			if (memcmp(&ips[j].ip, &ips[i].ip, sizeof(ips[j].ip)) == 0) {
+				break;
 			}
 		}
+		if (j == i) {
+			/* did not find duplicate so use this slot */
+			i++;
+		}
 	}
-	freeaddrinfo(pai);
+	free(addrs);
 
 	if (i == 0) {
 		free(ips);
@@ -806,7 +784,7 @@ tpp_sock_resolve_host(char *host, int *count)
 		return NULL;
 	}
 
-	if (i < *count) {
+	if (i < naddrs) {
 		/* try to resize the buffer, don't bother if resize failed */
 		tmp = realloc(ips, i * sizeof(tpp_addr_t));
 		if (tmp)
@@ -85,7 +85,18 @@
 
 struct tpp_config *tpp_conf; /* copy of the global tpp_config */
 
-pthread_rwlock_t router_lock; /* rw lock for router avl trees, searches over avl should be thread safe now */
+/*
+ * The router and leaf indices are protected by a striped rw lock. A reader
+ * takes the one stripe its destination address hashes to (or the first one,
+ * if it is not looking up a particular leaf), a writer takes all of them.
+ * Threads routing packets to different leaves thus do not bounce a single
+ * lock between them, while joins and leaves stay exclusive.
+ */
+#define ROUTER_LOCK_STRIPES 16
+static union {
+	pthread_rwlock_t lock;
+	char pad[128]; /* keep each stripe on its own cache lines */
+} router_lock[ROUTER_LOCK_STRIPES];
 pthread_mutex_t lj_lock;
 
 /* index of routers connected to this router */
@@ -116,6 +127,60 @@ static int router_post_connect_handler(int tfd, void *data, void *c, void *extra
 /* structure identifying this router */
 static tpp_router_t *this_router = NULL;
 
+/**
+ * @brief
+ *	Find the router lock stripe covering the given address
+ *
+ * @param[in] addr - address looked up, NULL for the first stripe
+ *
+ * @return stripe index
+ *
+ */
+static int
+router_lock_stripe(tpp_addr_t *addr)
+{
+	unsigned int h;
+
+	if (addr == NULL)
+		return 0;
+	h = (unsigned int) (addr->ip[0] ^ addr->ip[1] ^ addr->ip[2] ^ addr->ip[3]);
+	h ^= (unsigned short) addr->port;
+	h ^= h >> 16;
+	h ^= h >> 8;
+	return h % ROUTER_LOCK_STRIPES;
+}
+
+static void
+router_read_lock(tpp_addr_t *addr)
+{
+	tpp_read_lock(&router_lock[router_lock_stripe(addr)].lock);
+}
+
+static void
+router_read_unlock(tpp_addr_t *addr)
+{
+	tpp_unlock_rwlock(&router_lock[router_lock_stripe(addr)].lock);
+}
+
+/* stripes are always taken in order, so writers cannot deadlock each other */
+static void
+router_write_lock(void)
+{
+	int i;
+
+	for (i = 0; i < ROUTER_LOCK_STRIPES; i++)
+		tpp_write_lock(&router_lock[i].lock);
+}
+
+static void
+router_write_unlock(void)
+{
+	int i;
+
+	for (i = ROUTER_LOCK_STRIPES - 1; i >= 0; i--)
+		tpp_unlock_rwlock(&router_lock[i].lock);
+}
+
 static tpp_router_t *
 alloc_router(char *name, tpp_addr_t *address)
 {
@@ -204,8 +269,8 @@ log_noroute(tpp_addr_t *src_host, tpp_addr_t *dest_host, int src_sd, char *msg)
  * @retval  0 - Success
  *
  * @par Side Effects:
- *	This routine expects to be called with the "router_lock" and
- *	will unlock the router_lock before exiting.
+ *	This routine expects to be called with the router lock held
+ *	(see router_read_lock), the caller releases it.
  *
  * @par MT-safe: Yes
  *
@@ -471,7 +536,7 @@ router_send_ctl_join(int tfd, void *data, void *c)
 
 		rc = tpp_transport_vsend(r->conn_fd, pkt);
 		if (rc == 0) {
-			tpp_read_lock(&router_lock);
+			router_read_lock(NULL);
 
 			r->state = TPP_ROUTER_STATE_CONNECTED;
 
@@ -479,7 +544,7 @@ router_send_ctl_join(int tfd, void *data, void *c)
 
 			rc = send_leaves_to_router(this_router, r);
 
-			tpp_unlock_rwlock(&router_lock);
+			router_read_unlock(NULL);
 		} else {
 			tpp_log(LOG_CRIT, __func__, "Failed to send JOIN packet/send leaves to pbs_comm %s", this_router->router_name);
 			tpp_transport_close(r->conn_fd);
@@ -659,31 +724,31 @@ router_close_handler_inner(int tfd, int error, void *c, int hop)
 			 * broadcast leave pkt to other routers,
 			 * except from where it came from
 			 */
-			tpp_read_lock(&router_lock);
+			router_read_lock(NULL);
 			broadcast_to_my_routers(chunks, 2, tfd);
-			tpp_unlock_rwlock(&router_lock);
+			router_read_unlock(NULL);
 
 			tpp_log(LOG_CRIT, NULL, "tfd=%d, Connection from leaf %s down", tfd, tpp_netaddr(&l->leaf_addrs[0]));
 		}
 
-		tpp_write_lock(&router_lock);
+		router_write_lock();
 
 		if ((r = del_router_from_leaf(l, tfd)) == NULL) {
 			tpp_log(LOG_CRIT, __func__, "tfd=%d, Failed to clear pbs_comm from leaf %s's list", tfd, tpp_netaddr(&l->leaf_addrs[0]));
-			tpp_unlock_rwlock(&router_lock);
+			router_write_unlock();
 			return -1;
 		}
 
 		/* we had only the first address record stored in the my_leaves tree */
 		if (pbs_idx_delete(r->my_leaves_idx, &l->leaf_addrs[0]) != PBS_IDX_RET_OK) {
 			tpp_log(LOG_CRIT, __func__, "tfd=%d, Failed to delete address from my_leaves %s", tfd, tpp_netaddr(&l->leaf_addrs[0]));
-			tpp_unlock_rwlock(&router_lock);
+			router_write_unlock();
 			return -1;
 		}
 
 		if (l->num_routers > 0) {
 			TPP_DBPRT("tfd=%d, Other pbs_comms for leaf %s present", tfd, tpp_netaddr(&l->leaf_addrs[0]));
-			tpp_unlock_rwlock(&router_lock);
+			router_write_unlock();
 			return 0;
 		}
 
@@ -693,7 +758,7 @@ router_close_handler_inner(int tfd, int error, void *c, int hop)
 		for (i = 0; i < l->num_addrs; i++) {
 			if (pbs_idx_delete(cluster_leaves_idx, &l->leaf_addrs[i]) != PBS_IDX_RET_OK) {
 				tpp_log(LOG_CRIT, __func__, "tfd=%d, Failed to delete address %s from cluster leaves", tfd, tpp_netaddr(&l->leaf_addrs[i]));
-				tpp_unlock_rwlock(&router_lock);
+				router_write_unlock();
 				return -1;
 			}
 		}
@@ -711,7 +776,7 @@ router_close_handler_inner(int tfd, int error, void *c, int hop)
 
 		free_leaf(l);
 
-		tpp_unlock_rwlock(&router_lock);
+		router_write_unlock();
 
 		return 0;
 
@@ -729,7 +794,7 @@ router_close_handler_inner(int tfd, int error, void *c, int hop)
 			/* do any logging or leaf processing only if it was connected earlier */
 			tpp_log(LOG_CRIT, NULL, "tfd=%d, Connection %s pbs_comm %s down", tfd, (r->initiator == 1) ? "to" : "from", r->router_name);
 
-			tpp_write_lock(&router_lock);
+			router_write_lock();
 			TPP_QUE_CLEAR(&deleted_leaves);
 
 			while (pbs_idx_find(r->my_leaves_idx, NULL, (void **) &l, &idx_ctx) == PBS_IDX_RET_OK) {
@@ -743,7 +808,7 @@ router_close_handler_inner(int tfd, int error, void *c, int hop)
 						TPP_DBPRT("All routers to leaf %s down, deleting leaf", tpp_netaddr(&l->leaf_addrs[0]));
 
 						if (tpp_enque(&deleted_leaves, l) == NULL) {
-							tpp_unlock_rwlock(&router_lock);
+							router_write_unlock();
 							tpp_log(LOG_CRIT, __func__, "Out of memory enqueuing deleted leaves");
 							return -1;
 						}
@@ -765,7 +830,7 @@ router_close_handler_inner(int tfd, int error, void *c, int hop)
 				for (i = 0; i < l->num_addrs; i++) {
 					if (pbs_idx_delete(cluster_leaves_idx, &l->leaf_addrs[i]) != PBS_IDX_RET_OK) {
 						tpp_log(LOG_CRIT, __func__, "tfd=%d, Failed to delete address %s", tfd, tpp_netaddr(&l->leaf_addrs[i]));
-						tpp_unlock_rwlock(&router_lock);
+						router_write_unlock();
 
 						return -1;
 					}
@@ -784,7 +849,7 @@ router_close_handler_inner(int tfd, int error, void *c, int hop)
 				if (r->my_leaves_idx == NULL) {
 					tpp_log(LOG_CRIT, __func__, "Failed to create index for my leaves");
 					free_router(r);
-					tpp_unlock_rwlock(&router_lock);
+					router_write_unlock();
 					return -1;
 				}
 			}
@@ -815,7 +880,7 @@ router_close_handler_inner(int tfd, int error, void *c, int hop)
 				free_leaf(l);
 			}
 
-			tpp_unlock_rwlock(&router_lock);
+			router_write_unlock();
 		}
 
 		if (r->initiator == 1) {
@@ -856,7 +921,7 @@ router_close_handler_inner(int tfd, int error, void *c, int hop)
 			 * remove this router from our list of registered routers
 			 * ie, remove from routers_idx tree
 			 **/
-			tpp_write_lock(&router_lock);
+			router_write_lock();
 
 			pbs_idx_delete(routers_idx, &r->router_addr);
 			/*
@@ -865,7 +930,7 @@ router_close_handler_inner(int tfd, int error, void *c, int hop)
 			 */
 			free_router(r);
 
-			tpp_unlock_rwlock(&router_lock);
+			router_write_unlock();
 		}
 
 		return 0;
@@ -980,9 +1045,9 @@ router_timer_handler(time_t now)
 		chunks[0].len = len;
 
 		/* broadcast to self connected leaves asking for notification */
-		tpp_read_lock(&router_lock);
+		router_read_lock(NULL);
 		broadcast_to_my_leaves(chunks, 1, -1, 1);
-		tpp_unlock_rwlock(&router_lock);
+		router_read_unlock(NULL);
 	}
 
 	return ret;
@@ -1264,7 +1329,7 @@ again:
 
 				TPP_DBPRT("Recvd TPP_CTL_JOIN from pbs_comm node %s, len=%d", tpp_netaddr(&connected_host), len);
 
-				tpp_write_lock(&router_lock);
+				router_write_lock();
 
 				/* find associated router */
 				pbs_idx_find(routers_idx, &pconn_host, (void **) &r, NULL);
@@ -1277,13 +1342,13 @@ again:
 									"another connect arrived, dropping existing connection %d",
 							tfd, r->router_name, r->conn_fd);
 						tpp_transport_close(r->conn_fd);
-						tpp_unlock_rwlock(&router_lock);
+						router_write_unlock();
 						return -1;
 					}
 				} else {
 					r = alloc_router(strdup(tpp_netaddr(&connected_host)), &connected_host);
 					if (!r) {
-						tpp_unlock_rwlock(&router_lock);
+						router_write_unlock();
 						return -1;
 					}
 				}
@@ -1296,7 +1361,7 @@ again:
 				if (ctx == NULL) {
 					if ((ctx = (tpp_context_t *) malloc(sizeof(tpp_context_t))) == NULL) {
 						tpp_log(LOG_CRIT, __func__, "Out of memory allocating tpp context");
-						tpp_unlock_rwlock(&router_lock);
+						router_write_unlock();
 						return -1;
 					}
 				}
@@ -1312,7 +1377,7 @@ again:
 				/* now send new router info about all leaves I have */
 				send_leaves_to_router(this_router, r);
 
-				tpp_unlock_rwlock(&router_lock);
+				router_write_unlock();
 				return 0;
 
 			} else if (node_type == TPP_LEAF_NODE || node_type == TPP_LEAF_NODE_LISTEN) {
@@ -1333,7 +1398,7 @@ again:
 				}
 				addrs = (tpp_addr_t *) (((char *) dhdr) + sizeof(tpp_join_pkt_hdr_t));
 
-				tpp_write_lock(&router_lock);
+				router_write_lock();
 
 				if (ctx == NULL || ctx->ptr == NULL) {
 					/* router is myself */
@@ -1349,7 +1414,7 @@ again:
 
 						strcpy(rname, tpp_netaddr(&connected_host));
 						tpp_log(LOG_CRIT, NULL, "tfd=%d, Failed to find pbs_comm %s in join for leaf %s", tfd, rname, tpp_netaddr(&addrs[0]));
-						tpp_unlock_rwlock(&router_lock);
+						router_write_unlock();
 						return -1;
 					}
 				}
@@ -1367,7 +1432,7 @@ again:
 					if (!l || !l->leaf_addrs) {
 						free_leaf(l);
 						tpp_log(LOG_CRIT, __func__, "Out of memory allocating leaf");
-						tpp_unlock_rwlock(&router_lock);
+						router_write_unlock();
 						return -1;
 					}
 
@@ -1392,7 +1457,7 @@ again:
 									"another leaf connect arrived, dropping existing connection %d",
 							tfd, tpp_netaddr(&l->leaf_addrs[0]), l->conn_fd);
 						tpp_transport_close(l->conn_fd);
-						tpp_unlock_rwlock(&router_lock);
+						router_write_unlock();
 						return -1;
 					}
 					l->conn_fd = tfd;
@@ -1406,7 +1471,7 @@ again:
 					if (ctx == NULL) {
 						if ((ctx = (tpp_context_t *) malloc(sizeof(tpp_context_t))) == NULL) {
 							tpp_log(LOG_CRIT, __func__, "Out of memory allocating tpp context");
-							tpp_unlock_rwlock(&router_lock);
+							router_write_unlock();
 							return -1;
 						}
 					}
@@ -1424,13 +1489,13 @@ again:
 				i = add_route_to_leaf(l, r, index);
 				if (i == -1) {
 					tpp_log(LOG_CRIT, NULL, "tfd=%d, Leaf %s exists!", tfd, tpp_netaddr(&l->leaf_addrs[0]));
-					tpp_unlock_rwlock(&router_lock);
+					router_write_unlock();
 					return 0;
 				}
 
 				if (pbs_idx_insert(r->my_leaves_idx, &l->leaf_addrs[0], l) != PBS_IDX_RET_OK) {
 					tpp_log(LOG_CRIT, __func__, "tfd=%d, Failed to add address %s to index of my leaves", tfd, tpp_netaddr(&l->leaf_addrs[0]));
-					tpp_unlock_rwlock(&router_lock);
+					router_write_unlock();
 					return -1;
 				}
 
@@ -1464,7 +1529,7 @@ again:
 					if (fatal > 0 || l->num_addrs == 0) {
 						tpp_log(LOG_CRIT, NULL, "tfd=%d, Leaf %s had %s problem adding addresses, rejecting connection",
 							tfd, tpp_netaddr(&l->leaf_addrs[0]), (fatal > 0) ? "fatal" : "all duplicates");
-						tpp_unlock_rwlock(&router_lock);
+						router_write_unlock();
 						return -1;
 					}
 				}
@@ -1473,7 +1538,7 @@ again:
 					if (l->leaf_type == TPP_LEAF_NODE_LISTEN) {
 						if (pbs_idx_insert(my_leaves_notify_idx, &l->leaf_addrs[0], l) != PBS_IDX_RET_OK) {
 							tpp_log(LOG_CRIT, __func__, "tfd=%d, Failed to add address %s to notify-leaves index", tfd, tpp_netaddr(&l->leaf_addrs[0]));
-							tpp_unlock_rwlock(&router_lock);
+							router_write_unlock();
 							return -1;
 						}
 					}
@@ -1510,7 +1575,7 @@ again:
 					broadcast_to_my_routers(chunks, 1, tfd);
 				}
 
-				tpp_unlock_rwlock(&router_lock);
+				router_write_unlock();
 				return 0;
 			}
 			return 0;
@@ -1541,17 +1606,17 @@ again:
 				tpp_leaf_t *l = NULL;
 				tpp_addr_t *src_addr = (tpp_addr_t *) (((char *) dhdr) + sizeof(tpp_leave_pkt_hdr_t));
 
-				tpp_write_lock(&router_lock);
+				router_write_lock();
 
 				/* find the leaf context to pass to close handler */
 				pbs_idx_find(cluster_leaves_idx, (void **) &src_addr, (void **) &l, NULL);
 				if (!l) {
 					TPP_DBPRT("No leaf %s found", tpp_netaddr(src_addr));
-					tpp_unlock_rwlock(&router_lock);
+					router_write_unlock();
 					return 0;
 				}
 
-				tpp_unlock_rwlock(&router_lock);
+				router_write_unlock();
 
 				if ((ctx = (tpp_context_t *) malloc(sizeof(tpp_context_t))) == NULL) {
 					tpp_log(LOG_CRIT, __func__, "Out of memory allocating tpp context");
@@ -1592,6 +1657,7 @@ again:
 			void *info_start = (char *) dhdr + sizeof(tpp_mcast_pkt_hdr_t);
 			unsigned int payload_len;
 			void *payload;
+			tpp_shared_data_t *shared_payload = NULL; /* payload shared by all forwarded packets */
 			unsigned int cmprsd_len = ntohl(mhdr->info_cmprsd_len);
 			unsigned int num_streams = ntohl(mhdr->num_streams);
 			unsigned int info_len = ntohl(mhdr->info_len);
@@ -1641,10 +1707,10 @@ again:
 
 				TPP_DBPRT("MCAST data on fd=%u", src_sd);
 
-				tpp_read_lock(&router_lock);
+				router_read_lock(dest_host);
 				pbs_idx_find(cluster_leaves_idx, (void **) &dest_host, (void **) &l, NULL);
 				if (l == NULL) {
-					tpp_unlock_rwlock(&router_lock);
+					router_read_unlock(dest_host);
 					snprintf(msg, sizeof(msg), "pbs_comm:%s: Dest not found at pbs_comm", tpp_netaddr(&this_router->router_addr));
 					log_noroute(src_host, dest_host, src_sd, msg);
 					tpp_send_ctl_msg(tfd, TPP_MSG_NOROUTE, src_host, dest_host, src_sd, 0, msg);
@@ -1653,7 +1719,7 @@ again:
 
 				/* find a router that is still connected */
 				target_router = get_preferred_router(l, this_router, &target_fd);
-				tpp_unlock_rwlock(&router_lock);
+				router_read_unlock(dest_host);
 
 				if (target_router == NULL) {
 					snprintf(msg, sizeof(msg), "pbs_comm:%s: No target pbs_comm found", tpp_netaddr(&this_router->router_addr));
@@ -1680,14 +1746,23 @@ again:
 					memcpy(&shdr->src_addr, &mhdr->src_addr, sizeof(tpp_addr_t));
 					memcpy(&shdr->dest_addr, &minfo->dest_addr, sizeof(tpp_addr_t));
 
-					if (!tpp_bld_pkt(pkt, payload, payload_len, 1, NULL)) {
+					if (shared_payload == NULL && (shared_payload = tpp_shared_data_alloc(payload, payload_len)) == NULL) {
+						tpp_free_pkt(pkt);
+						goto mcast_err;
+					}
+					if (!tpp_bld_pkt_shared(pkt, shared_payload, payload_len)) {
 						tpp_log(LOG_CRIT, __func__, "Failed to build packet");
 						goto mcast_err;
 					}
 
 					TPP_DBPRT("Send mcast indiv packet to %s", tpp_netaddr(&shdr->dest_addr));
 
-					if (tpp_transport_vsend(target_fd, pkt) != 0) {
+					if ((rc = tpp_transport_vsend(target_fd, pkt)) == -2) {
+						/* too much queued for this member, push back on its stream only */
+						snprintf(msg, sizeof(msg), "pbs_comm:%s: Send buffers to dest full", tpp_netaddr(&this_router->router_addr));
+						log_noroute(src_host, dest_host, src_sd, msg);
+						tpp_send_ctl_msg(tfd, TPP_MSG_NOROUTE, src_host, dest_host, src_sd, 0, msg);
+					} else if (rc != 0) {
 						tpp_log(LOG_ERR, __func__, "Failed to send mcast indiv pkt");
 						tpp_transport_close(target_fd);
 						goto mcast_err;
@@ -1794,8 +1869,13 @@ again:
 						tpp_log(LOG_CRIT, __func__, "Failed to build packet");
 						goto mcast_err;
 					}
+					rlist[k].minfo_buf = NULL; /* owned by the packet from here on */
 
-					if (!tpp_bld_pkt(pkt, payload, payload_len, 1, NULL)) {
+					if (shared_payload == NULL && (shared_payload = tpp_shared_data_alloc(payload, payload_len)) == NULL) {
+						tpp_free_pkt(pkt);
+						goto mcast_err;
+					}
+					if (!tpp_bld_pkt_shared(pkt, shared_payload, payload_len)) {
 						tpp_log(LOG_CRIT, __func__, "Failed to build packet");
 						goto mcast_err;
 					}
@@ -1809,7 +1889,18 @@ again:
 			if (cmprsd_len > 0)
 				free(minfo_base);
 
-			free(rlist); /* minfo_buf which was allocated will be freed when sent */
+			/* drop our reference, packets still queued hold their own */
+			tpp_shared_data_release(shared_payload);
+
+			/* release the member lists of target comms we did not get to send to */
+			for (k = 0; k < csize; k++) {
+				if (rlist[k].cmpr_ctx != NULL) {
+					unsigned int t_minfo_len;
+					free(tpp_multi_deflate_done(rlist[k].cmpr_ctx, &t_minfo_len));
+				}
+				free(rlist[k].minfo_buf);
+			}
+			free(rlist); /* minfo_buf which was sent is freed along with its packet */
 
 			tpp_log(LOG_INFO, NULL, "mcast done");
 
@@ -1827,11 +1918,11 @@ again:
 			dest_host = &dhdr->dest_addr;
 			src_sd = ntohl(dhdr->src_sd);
 
-			tpp_read_lock(&router_lock);
+			router_read_lock(dest_host);
 
 			pbs_idx_find(cluster_leaves_idx, (void **) &dest_host, (void **) &l, NULL);
 			if (l == NULL) {
-				tpp_unlock_rwlock(&router_lock);
+				router_read_unlock(dest_host);
 				snprintf(msg, sizeof(msg), "tfd=%d, pbs_comm:%s: Dest not found", tfd, tpp_netaddr(&this_router->router_addr));
 				log_noroute(src_host, dest_host, src_sd, msg);
 				tpp_send_ctl_msg(tfd, TPP_MSG_NOROUTE, src_host, dest_host, src_sd, 0, msg);
@@ -1840,7 +1931,7 @@ again:
 
 			/* find a router that is still connected */
 			target_router = get_preferred_router(l, this_router, &target_fd);
-			tpp_unlock_rwlock(&router_lock);
+			router_read_unlock(dest_host);
 
 			if (target_router == NULL) {
 				snprintf(msg, sizeof(msg), "tfd=%d, pbs_comm:%s: No target pbs_comm found", tfd, tpp_netaddr(&this_router->router_addr));
@@ -1859,9 +1950,15 @@ again:
 			if (rc == -1) {
 				tpp_log(LOG_ERR, __func__, "Failed to send TPP_DATA/TPP_CLOSE_STRM");
 				tpp_transport_close(target_fd);
+			} else if (rc == -2) {
+				/* too much queued for the target, push back on the sender's stream */
+				snprintf(msg, sizeof(msg), "tfd=%d, pbs_comm:%s: Send buffers to dest full", tfd, tpp_netaddr(&this_router->router_addr));
+				log_noroute(src_host, dest_host, src_sd, msg);
+				tpp_send_ctl_msg(tfd, TPP_MSG_NOROUTE, src_host, dest_host, src_sd, 0, msg);
+				rc = 0;
 			}
 
-			return rc; /* 0 - success, -1 failed, -2 app mbox full */
+			return rc; /* 0 - success, -1 failed */
 		} break;	   /* TPP_DATA, TPP_CLOSE_STRM */
 
 		case TPP_CTL_MSG: {
@@ -1880,17 +1977,17 @@ again:
 					tfd, lbuf, ntohl(ehdr->src_sd), tpp_netaddr(&ehdr->src_addr), msg);
 
 				/* find the fd to forward to via the associated router */
-				tpp_read_lock(&router_lock);
+				router_read_lock(dest_host);
 
 				pbs_idx_find(cluster_leaves_idx, (void **) &dest_host, (void **) &l, NULL);
 				if (l == NULL) {
-					tpp_unlock_rwlock(&router_lock);
+					router_read_unlock(dest_host);
 					return 0;
 				}
 				/* find a router that is still connected */
 				target_router = get_preferred_router(l, this_router, &target_fd);
 
-				tpp_unlock_rwlock(&router_lock);
+				router_read_unlock(dest_host);
 				if (target_router == NULL) {
 					tpp_log(LOG_WARNING, NULL, "tfd=%d, No connections to send TPP_CTL_NOROUTE", tfd);
 					return 0;
@@ -2146,7 +2243,8 @@ tpp_init_router(struct tpp_config *cnf)
 	}
 
 	tpp_init_lock(&lj_lock);
-	tpp_init_rwlock(&router_lock);
+	for (j = 0; j < ROUTER_LOCK_STRIPES; j++)
+		tpp_init_rwlock(&router_lock[j].lock);
 
 	routers_idx = pbs_idx_create(0, sizeof(tpp_addr_t));
 	if (routers_idx == NULL) {
@@ -2180,20 +2278,20 @@ tpp_init_router(struct tpp_config *cnf)
 
 	/* initiate connections to sister routers */
 	j = 0;
-	tpp_write_lock(&router_lock);
+	router_write_lock();
 	while (tpp_conf->routers && tpp_conf->routers[j]) {
 		/* add to connection table */
 
 		r = alloc_router(tpp_conf->routers[j], NULL);
 		if (!r) {
-			tpp_unlock_rwlock(&router_lock);
+			router_write_unlock();
 			return -1; /* error already logged */
 		}
 		r->initiator = 1;
 
 		/* since we connected we should add a context */
 		if ((ctx = (tpp_context_t *) malloc(sizeof(tpp_context_t))) == NULL) {
-			tpp_unlock_rwlock(&router_lock);
+			router_write_unlock();
 			tpp_log(LOG_CRIT, __func__, "Out of memory allocating tpp context");
 			return -1;
 		}
@@ -2203,13 +2301,13 @@ tpp_init_router(struct tpp_config *cnf)
 		tpp_log(LOG_INFO, NULL, "Connecting to pbs_comm %s", tpp_conf->routers[j]);
 
 		if (tpp_transport_connect(tpp_conf->routers[j], 0, ctx, &r->conn_fd) == -1) {
-			tpp_unlock_rwlock(&router_lock);
+			router_write_unlock();
 			return -1;
 		}
 
 		j++;
 	}
-	tpp_unlock_rwlock(&router_lock);
+	router_write_unlock();
 
 	sleep(1);
 	return 0;
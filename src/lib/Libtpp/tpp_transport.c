@@ -74,6 +74,7 @@
 #include "pbs_idx.h"
 #include "tpp_internal.h"
 #include "auth.h"
+#include "pbs_usdt.h"
 
 #define TPP_CONN_DISCONNECTED 1 /* Channel is disconnected */
 #define TPP_CONN_INITIATING 2	/* Channel is initiating */
@@ -87,6 +88,29 @@ int tpp_going_down = 0;
  * specific periods of time
  */
 #define TPP_CONN_CONNECT_DELAY 1
+
+#define TPP_SEND_IOV_MAX 64 /* chunks of a packet handed to one writev */
+
+#define TPP_STATS_LOG_PERIOD 300 /* seconds between logging thread statistics */
+#define TPP_STATS_NBUCKETS 8	 /* event batch time buckets: <1ms, <2ms, <4ms ... >=64ms */
+
+/*
+ * Load counters of an IO thread, over the current logging period.
+ * Only updated by the owning thread.
+ */
+typedef struct {
+	time_t start;		     /* start of the current period */
+	unsigned long pkts_sent;     /* packets completely sent */
+	unsigned long bytes_sent;    /* bytes in those packets */
+	unsigned long pkts_recvd;    /* packets received and handed to the upper layer */
+	unsigned long bytes_recvd;   /* bytes in those packets */
+	unsigned long cmds;	     /* commands read from the thread mbox */
+	unsigned long deferred;	     /* deferred events queued */
+	unsigned long batches;	     /* wakeups with events to process */
+	unsigned long max_batch_usec; /* longest time spent processing a wakeup */
+	unsigned long batch_hist[TPP_STATS_NBUCKETS];
+} tpp_thrd_stats_t;
+
 typedef struct {
 	int tfd;	  /* on which physical connection */
 	char cmdval;	  /* cmd type */
@@ -146,6 +170,7 @@ typedef struct {
 	tpp_que_t def_act_que; /* The deferred action queue on this thread */
 	tpp_mbox_t mbox;       /* message box for this thread */
 	tpp_tls_t *tpp_tls;    /* tls data related to tpp work */
+	tpp_thrd_stats_t stats; /* load counters of this thread */
 } thrd_data_t;
 
 #ifdef NAS /* localmod 149 */
@@ -159,6 +184,9 @@ static int max_con = MAX_CON;	/* nfiles */
 
 static struct tpp_config *tpp_conf; /* store a pointer to the tpp_config supplied */
 
+static long send_backlog = 0;		/* bytes of data queued to send on all connections */
+static pthread_mutex_t send_backlog_lock; /* protects send_backlog */
+
 /*
  * Save the connection related parameters here, so we don't have to parse
  * each time.
@@ -247,6 +275,7 @@ enque_deferred_event(thrd_data_t *td, int tfd, int cmd, int delay)
 	conn_ev->tfd = tfd;
 	conn_ev->cmdval = cmd;
 	conn_ev->conn_time = time(0) + delay;
+	td->stats.deferred++;
 
 	n = NULL;
 	while ((n = TPP_QUE_NEXT(&td->def_act_que, n))) {
@@ -270,6 +299,72 @@ enque_deferred_event(thrd_data_t *td, int tfd, int cmd, int delay)
 	}
 }
 
+/**
+ * @brief
+ *	Account the time an IO thread spent processing one wakeup
+ *
+ * @param[in] td    - The thread data for the controlling thread
+ * @param[in] start - Time the processing started
+ *
+ * @par MT-safe: No
+ *
+ */
+static void
+account_thrd_batch(thrd_data_t *td, struct timeval *start)
+{
+	struct timeval end;
+	unsigned long usec;
+	int i;
+
+	gettimeofday(&end, NULL);
+	usec = (end.tv_sec - start->tv_sec) * 1000000 + (end.tv_usec - start->tv_usec);
+
+	td->stats.batches++;
+	if (usec > td->stats.max_batch_usec)
+		td->stats.max_batch_usec = usec;
+	for (i = 0; i < TPP_STATS_NBUCKETS - 1 && usec >= (1000UL << i); i++)
+		;
+	td->stats.batch_hist[i]++;
+}
+
+/**
+ * @brief
+ *	Log the load counters of an IO thread once every TPP_STATS_LOG_PERIOD
+ *	and start a new period
+ *
+ * @param[in] td  - The thread data for the controlling thread
+ * @param[in] now - Current time
+ *
+ * @par MT-safe: No
+ *
+ */
+static void
+log_thrd_stats(thrd_data_t *td, time_t now)
+{
+	tpp_thrd_stats_t *st = &td->stats;
+	int backlog;
+
+	if (st->start == 0)
+		st->start = now;
+	if (now - st->start < TPP_STATS_LOG_PERIOD)
+		return;
+
+	tpp_lock(&td->mbox.mbox_mutex);
+	backlog = td->mbox.mbox_size;
+	tpp_unlock(&td->mbox.mbox_mutex);
+
+	tpp_log(LOG_INFO, __func__,
+		"last %ld secs: sent %lu pkts %lu bytes, recvd %lu pkts %lu bytes, cmds=%lu, deferred=%lu, mbox backlog=%d, "
+		"wakeups=%lu, max time=%lu usec, <1ms=%lu <2ms=%lu <4ms=%lu <8ms=%lu <16ms=%lu <32ms=%lu <64ms=%lu >=64ms=%lu",
+		(long) (now - st->start), st->pkts_sent, st->bytes_sent, st->pkts_recvd, st->bytes_recvd,
+		st->cmds, st->deferred, backlog, st->batches, st->max_batch_usec,
+		st->batch_hist[0], st->batch_hist[1], st->batch_hist[2], st->batch_hist[3],
+		st->batch_hist[4], st->batch_hist[5], st->batch_hist[6], st->batch_hist[7]);
+
+	memset(st, 0, sizeof(tpp_thrd_stats_t));
+	st->start = now;
+}
+
 /**
  * @brief
  *	Trigger deferred action for those whose time has been reached
@@ -346,6 +441,28 @@ tpp_transport_get_thrd_context(int tfd)
 	return td;
 }
 
+/**
+ * @brief
+ *	Bytes of packets queued on all the physical connections that are
+ *	waiting to be sent out
+ *
+ * @return - size of the backlog in bytes
+ *
+ * @par MT-safe: Yes
+ *
+ */
+int
+tpp_transport_backlog(void)
+{
+	long backlog;
+
+	tpp_lock(&send_backlog_lock);
+	backlog = send_backlog;
+	tpp_unlock(&send_backlog_lock);
+
+	return (int) backlog;
+}
+
 /**
  * @brief
  *	Function called by upper layers to get the "user data/context" that
@@ -505,6 +622,9 @@ tpp_transport_init(struct tpp_config *conf)
 	if (tpp_init_rwlock(&cons_array_lock))
 		return -1;
 
+	if (tpp_init_lock(&send_backlog_lock))
+		return -1;
+
 #ifndef WIN32
 	/* for unix, set a pthread_atfork handler */
 	if (pthread_atfork(tpp_nslookup_atfork_prepare, tpp_nslookup_atfork_parent, tpp_nslookup_atfork_child) != 0) {
@@ -719,7 +839,8 @@ alloc_conn(int tfd)
 	conn->extra = NULL;
 
 	snprintf(mbox_name, sizeof(mbox_name), "Conn_%d", conn->sock_fd);
-	if (tpp_mbox_init(&conn->send_mbox, mbox_name, TPP_MAX_MBOX_SIZE) != 0) {
+	if (tpp_mbox_init(&conn->send_mbox, mbox_name,
+			  (tpp_conf->buf_limit_per_conn > 0) ? tpp_conf->buf_limit_per_conn : TPP_CONN_BUF_LIMIT) != 0) {
 		free(conn);
 		tpp_log(LOG_CRIT, __func__, "tpp_mbox_init() error, errno=%d", errno);
 		return NULL;
@@ -921,6 +1042,48 @@ get_transport_atomic(int tfd, int *slot_state)
 	return conn;
 }
 
+/**
+ * @brief
+ *	Account data being queued to, or taken off, the send mboxes
+ *
+ * @param[in] sz - bytes added, negative if removed
+ *
+ * @par MT-safe: Yes
+ *
+ */
+static void
+account_send_backlog(long sz)
+{
+	tpp_lock(&send_backlog_lock);
+	send_backlog += sz;
+	tpp_unlock(&send_backlog_lock);
+}
+
+/**
+ * @brief
+ *	Whether a packet is a control packet, which is to be sent ahead of
+ *	queued data and is not held to the send budgets, so that joins,
+ *	leaves and ctl msgs are never stuck behind bulk data to a slow peer
+ *
+ * @param[in] pkt - The packet, its header complete
+ *
+ * @return int
+ * @retval 1 - control packet
+ * @retval 0 - data packet
+ *
+ * @par MT-safe: Yes
+ *
+ */
+static int
+is_ctl_pkt(tpp_packet_t *pkt)
+{
+	tpp_chunk_t *first_chunk = GET_NEXT(pkt->chunks);
+	/* every packet header type has the type right after ntotlen */
+	unsigned char type = ((unsigned char *) first_chunk->data)[sizeof(int)];
+
+	return ((type == TPP_CTL_JOIN) || (type == TPP_CTL_LEAVE) || (type == TPP_CTL_MSG) || (type == TPP_AUTH_CTX));
+}
+
 /**
  * @brief
  *	Lock the strmarray lock and send post data on the
@@ -928,12 +1091,18 @@ get_transport_atomic(int tfd, int *slot_state)
  *	and the posting of data into the manager thread's mbox
  *	are done as an atomic operation, i.e., under the cons_array_lock.
  *
+ * @par
+ *	Data to send is refused once the connection has TPP_CONN_BUF_LIMIT
+ *	(or the configured buf_limit_per_conn) bytes queued, or all the
+ *	connections together TPP_TOTAL_BUF_LIMIT; control packets are not.
+ *
  * @param[in] tfd - The file descriptor of the connection
  * @param[in] cmd - The cmd to post if conn is up
  * @param[in] pkt - Data associated with the command
  *
  * @return  Error code
  * @retval  -1 - Failure (slot free, or bad tfd)
+ * @retval  -2 - send budget exhausted (errno ENOBUFS)
  * @retval   0 - Success
  *
  * @par Side Effects:
@@ -964,9 +1133,20 @@ tpp_post_cmd(int tfd, char cmd, tpp_packet_t *pkt)
 	if (cmd == TPP_CMD_SEND) {
 		/* data associated that needs to be sent out, put directly into target mbox */
 		/* write to worker threads send pipe */
-		rc = tpp_mbox_post(&conn->send_mbox, tfd, cmd, (void *) pkt, pkt->totlen);
+		if (is_ctl_pkt(pkt))
+			rc = tpp_mbox_post_urgent(&conn->send_mbox, tfd, cmd, (void *) pkt, pkt->totlen);
+		else {
+			tpp_lock(&send_backlog_lock);
+			rc = (send_backlog + pkt->totlen > TPP_TOTAL_BUF_LIMIT) ? -2 : 0;
+			tpp_unlock(&send_backlog_lock);
+			if (rc == 0)
+				rc = tpp_mbox_post(&conn->send_mbox, tfd, cmd, (void *) pkt, pkt->totlen);
+			else
+				errno = ENOBUFS;
+		}
 		if (rc != 0)
 			return rc;
+		account_send_backlog(pkt->totlen);
 	}
 
 	/* write to worker threads send pipe, to wakeup thread */
@@ -1056,8 +1236,10 @@ tpp_transport_vsend(int tfd, tpp_packet_t *pkt)
 		if (rc == -1)
 			tpp_log(LOG_CRIT, __func__, "Error writing to thread cmd mbox");
 		else if (rc == -2)
-			tpp_log(LOG_CRIT, __func__, "thread cmd mbox is full");
+			tpp_log(LOG_WARNING, __func__, "tfd=%d, send buffers full, refused packet of %d bytes", tfd, (int) pkt->totlen);
 		tpp_free_pkt(pkt);
+		if (rc == -2)
+			errno = ENOBUFS;
 	}
 	return rc;
 }
@@ -1309,6 +1491,8 @@ handle_cmd(thrd_data_t *td, int tfd, int cmd, void *data)
 	conn_event_t *conn_ev;
 	int num_cons = 0;
 
+	td->stats.cmds++;
+
 	conn = get_transport_atomic(tfd, &slot_state);
 
 	if (conn && (conn->td != td))
@@ -1453,6 +1637,7 @@ work(void *v)
 	int new_connection = 0;
 	int timeout, timeout2;
 	time_t now;
+	struct timeval batch_start;
 	tpp_tls_t *ptr;
 #ifndef WIN32
 	int rc;
@@ -1500,6 +1685,8 @@ work(void *v)
 		while (1) {
 			now = time(0);
 
+			log_thrd_stats(td, now);
+
 			/* trigger all delayed events, and return the wait time till the next one to trigger */
 			timeout = trigger_deferred_events(td, now);
 			if (the_timer_handler) {
@@ -1528,6 +1715,7 @@ work(void *v)
 				break;
 		} /* loop around em_wait */
 
+		gettimeofday(&batch_start, NULL);
 		new_connection = 0;
 
 		/* check once more if cmd_pipe has any more data */
@@ -1619,6 +1807,8 @@ work(void *v)
 			}
 		}
 
+		account_thrd_batch(td, &batch_start);
+
 		if (new_connection == 1) {
 			pbs_socklen_t addrlen = sizeof(clientaddr);
 			if ((newfd = tpp_sock_accept(td->listen_fd, (struct sockaddr *) &clientaddr, &addrlen)) == -1) {
@@ -1888,6 +2078,9 @@ add_pkt(phy_conn_t *conn)
 		}
 		if (avl_len == pkt_len) {
 			/* we got a full packet */
+			conn->td->stats.pkts_recvd++;
+			conn->td->stats.bytes_recvd += pkt_len;
+			PBS_PROBE2(tpp__pkt__in, conn->sock_fd, pkt_len);
 			if (the_pkt_handler) {
 				if (the_pkt_handler(conn->sock_fd, conn->scratch.data, pkt_len, conn->ctx, conn->extra) != 0) {
 					/* upper layer rejected data, disconnect */
@@ -1948,6 +2141,7 @@ send_data(phy_conn_t *conn)
 				return;
 			}
 			pkt = conn->curr_send_pkt;
+			account_send_backlog(-((long) pkt->totlen));
 		}
 		p = pkt->curr_chunk;
 
@@ -1958,6 +2152,60 @@ send_data(phy_conn_t *conn)
 			}
 		}
 
+#ifndef WIN32
+		if (p && (rc == 0)) {
+			struct iovec iov[TPP_SEND_IOV_MAX];
+			tpp_chunk_t *q;
+			int niov = 0;
+
+			/* hand all the unsent chunks of this packet to one writev */
+			for (q = p; q && (niov < TPP_SEND_IOV_MAX); q = GET_NEXT(q->chunk_link)) {
+				tosend = q->len - (q->pos - q->data);
+				if (tosend == 0)
+					continue;
+				iov[niov].iov_base = q->pos;
+				iov[niov].iov_len = tosend;
+				niov++;
+			}
+
+			rc = 0;
+			if (niov > 0)
+				rc = tpp_sock_sendv(conn->sock_fd, iov, niov);
+			if (rc < 0) {
+				if (errno == EWOULDBLOCK || errno == EAGAIN) {
+					/* set this socket in POLLOUT */
+					conn->ev_mask |= EM_OUT;
+					TPP_DBPRT("EWOULDBLOCK, added EM_OUT to ev_mask, now=%x", conn->ev_mask);
+					if (tpp_em_mod_fd(conn->td->em_context, conn->sock_fd, conn->ev_mask) == -1) {
+						tpp_log(LOG_ERR, __func__, "Multiplexing failed");
+						return;
+					}
+				} else {
+					handle_disconnect(conn);
+					return;
+				}
+			} else {
+				TPP_DBPRT("tfd=%d, chunks=%d, sent=%d bytes", conn->sock_fd, niov, rc);
+				/* move past what went out, a partial write resumes next time round */
+				for (;;) {
+					tosend = p->len - (p->pos - p->data);
+					if (tosend > (size_t) rc) {
+						p->pos += rc;
+						break;
+					}
+					p->pos += tosend;
+					rc -= tosend;
+					p = GET_NEXT(p->chunk_link);
+					if (p == NULL) {
+						curr_pkt_done = 1;
+						break;
+					}
+					pkt->curr_chunk = p;
+				}
+			}
+		} else
+			curr_pkt_done = 1;
+#else
 		if (p && (rc == 0)) {
 			tosend = p->len - (p->pos - p->data);
 			while (tosend > 0) {
@@ -1991,12 +2239,16 @@ send_data(phy_conn_t *conn)
 			}
 		} else
 			curr_pkt_done = 1;
+#endif
 
 		if (pkt && curr_pkt_done) {
 			/*
 			* all data in this packet has been sent or done with.
 			* delete this node and get next node in queue
 			*/
+			conn->td->stats.pkts_sent++;
+			conn->td->stats.bytes_sent += pkt->totlen;
+			PBS_PROBE2(tpp__pkt__out, conn->sock_fd, pkt->totlen);
 			tpp_free_pkt(pkt);
 			conn->curr_send_pkt = NULL;
 		}
@@ -2032,8 +2284,10 @@ free_phy_conn(phy_conn_t *conn)
 	}
 
 	while (tpp_mbox_clear(&conn->send_mbox, &n, conn->sock_fd, &cmd, (void **) &pkt) == 0) {
-		if (cmd == TPP_CMD_SEND)
+		if (cmd == TPP_CMD_SEND) {
+			account_send_backlog(-((long) pkt->totlen));
 			tpp_free_pkt(pkt);
+		}
 	}
 
 	tpp_mbox_destroy(&conn->send_mbox);
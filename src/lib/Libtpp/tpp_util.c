@@ -347,6 +347,7 @@ set_tpp_config(struct pbs_config *pbs_conf, struct tpp_config *tpp_conf, char *n
 	tpp_conf->node_name = formatted_names;
 	tpp_conf->node_type = TPP_LEAF_NODE;
 	tpp_conf->numthreads = 1;
+	tpp_conf->buf_limit_per_conn = TPP_CONN_BUF_LIMIT;
 
 	tpp_conf->auth_config = make_auth_config(pbs_conf->auth_method,
 						 pbs_conf->encrypt_method,
@@ -696,6 +697,7 @@ tpp_bld_pkt(tpp_packet_t *pkt, void *data, int len, int dup, void **dup_data)
 	chunk->data = d;
 	chunk->pos = chunk->data;
 	chunk->len = len;
+	chunk->shared = NULL;
 	CLEAR_LINK(chunk->chunk_link);
 
 	/* add chunk to packet */
@@ -720,6 +722,99 @@ tpp_bld_pkt(tpp_packet_t *pkt, void *data, int len, int dup, void **dup_data)
 	return pkt;
 }
 
+/**
+ * @brief
+ *	Allocate a reference counted data buffer that can be added to
+ *	several packets without copying, via tpp_bld_pkt_shared.
+ *
+ * @param[in] - data - data to copy into the shared buffer
+ * @param[in] - len  - length of data
+ *
+ * @return Shared buffer, with one reference held by the caller
+ * @retval NULL - Failure (Out of memory)
+ *
+ * @par MT-safe: Yes
+ *
+ */
+tpp_shared_data_t *
+tpp_shared_data_alloc(void *data, int len)
+{
+	tpp_shared_data_t *sd;
+
+	if ((sd = malloc(sizeof(tpp_shared_data_t) + len)) == NULL) {
+		tpp_log(LOG_CRIT, __func__, "Out of memory allocating shared data");
+		return NULL;
+	}
+	if (tpp_init_lock(&sd->ref_lock)) {
+		free(sd);
+		return NULL;
+	}
+	sd->ref_count = 1;
+	if (data)
+		memcpy(sd->data, data, len);
+	return sd;
+}
+
+/**
+ * @brief
+ *	Drop a reference to a shared data buffer, freeing it when the last
+ *	reference goes away.
+ *
+ * @param[in] - sd - shared buffer (NULL is ignored)
+ *
+ * @par MT-safe: Yes
+ *
+ */
+void
+tpp_shared_data_release(tpp_shared_data_t *sd)
+{
+	int refs;
+
+	if (sd == NULL)
+		return;
+
+	tpp_lock(&sd->ref_lock);
+	refs = --sd->ref_count;
+	tpp_unlock(&sd->ref_lock);
+
+	if (refs <= 0) {
+		tpp_destroy_lock(&sd->ref_lock);
+		free(sd);
+	}
+}
+
+/**
+ * @brief
+ *	Add a chunk referring to a shared data buffer to a packet, taking a
+ *	reference on the buffer instead of copying the data.
+ *
+ * @param[in] - pkt - Pointer to packet to add chunk, or create new packet if NULL
+ * @param[in] - sd  - shared data buffer
+ * @param[in] - len - length of data in the shared buffer
+ *
+ * @return Packet the chunk was added to
+ * @retval NULL - Failure (Out of memory), pkt is freed
+ *
+ * @par MT-safe: Yes
+ *
+ */
+tpp_packet_t *
+tpp_bld_pkt_shared(tpp_packet_t *pkt, tpp_shared_data_t *sd, int len)
+{
+	tpp_chunk_t *chunk;
+
+	if ((pkt = tpp_bld_pkt(pkt, sd->data, len, 0, NULL)) == NULL)
+		return NULL;
+
+	chunk = GET_PRIOR(pkt->chunks);
+	tpp_lock(&sd->ref_lock);
+	sd->ref_count++;
+	tpp_unlock(&sd->ref_lock);
+	chunk->shared = sd;
+
+	return pkt;
+}
+
 /**
  * @brief
  *	Free a chunk
@@ -737,7 +832,10 @@ tpp_free_chunk(tpp_chunk_t *chunk)
 {
 	if (chunk) {
 		delete_link(&chunk->chunk_link);
-		free(chunk->data);
+		if (chunk->shared)
+			tpp_shared_data_release(chunk->shared);
+		else
+			free(chunk->data);
 		free(chunk);
 	}
 }
@@ -1615,7 +1713,7 @@ tpp_get_tls()
 
 #ifdef PBS_COMPRESSION_ENABLED
 
-#define COMPR_LEVEL Z_DEFAULT_COMPRESSION
+#define COMPR_LEVEL Z_BEST_SPEED
 
 struct def_ctx {
 	z_stream cmpr_strm;
@@ -1801,7 +1899,7 @@ tpp_deflate(void *inbuf, unsigned int inlen, unsigned int *outlen)
 	strm.zalloc = Z_NULL;
 	strm.zfree = Z_NULL;
 	strm.opaque = Z_NULL;
-	ret = deflateInit(&strm, Z_DEFAULT_COMPRESSION);
+	ret = deflateInit(&strm, COMPR_LEVEL);
 	if (ret != Z_OK) {
 		tpp_log(LOG_CRIT, __func__, "Compression failed");
 		return NULL;
@@ -2382,18 +2480,27 @@ tpp_encrypt_pkt(conn_auth_t *authdata, tpp_packet_t *pkt)
 	tpp_chunk_t *chunk, *next;
 	tpp_auth_pkt_hdr_t *data = (tpp_auth_pkt_hdr_t *) (((tpp_chunk_t *) (GET_NEXT(pkt->chunks)))->data);
 	unsigned char type = data->type;
-	void *buf = NULL;
+	tpp_tls_t *ptr;
 	char *p;
 
 	if (type == TPP_AUTH_CTX && data->for_encrypt == FOR_ENCRYPT)
 		return 0;
 
-	buf = malloc(totlen);
-	if (buf == NULL) {
-		tpp_log(LOG_CRIT, __func__, "Failed to allocated buffer for encrypting pkt data");
+	/* flatten the packet into a per-thread buffer, reused across packets */
+	if ((ptr = tpp_get_tls()) == NULL) {
+		tpp_log(LOG_CRIT, __func__, "Failed to get TLS for encrypting pkt data");
 		return -1;
 	}
-	p = (char *) buf;
+	if (ptr->encbuf_sz < (size_t) totlen) {
+		p = realloc(ptr->encbuf, totlen);
+		if (p == NULL) {
+			tpp_log(LOG_CRIT, __func__, "Failed to allocated buffer for encrypting pkt data");
+			return -1;
+		}
+		ptr->encbuf = p;
+		ptr->encbuf_sz = totlen;
+	}
+	p = ptr->encbuf;
 	chunk = GET_NEXT(pkt->chunks);
 	while (chunk) {
 		memcpy(p, chunk->data, chunk->len);
@@ -2406,18 +2513,15 @@ tpp_encrypt_pkt(conn_auth_t *authdata, tpp_packet_t *pkt)
 	CLEAR_HEAD(pkt->chunks);
 	pkt->curr_chunk = NULL;
 
-	if (authdata->encryptdef->encrypt_data(authdata->encryptctx, buf, totlen, &data_out, &len_out) != 0) {
+	if (authdata->encryptdef->encrypt_data(authdata->encryptctx, ptr->encbuf, totlen, &data_out, &len_out) != 0) {
 		tpp_log(LOG_CRIT, __func__, "Failed to encrypt pkt data");
-		free(buf);
 		return -1;
 	}
 
 	if (totlen > 0 && len_out <= 0) {
 		tpp_log(LOG_CRIT, __func__, "invalid encrypted data len: %d, pktlen: %d", (int) len_out, totlen);
-		free(buf);
 		return -1;
 	}
-	free(buf);
 	if (!tpp_bld_pkt(pkt, NULL, sizeof(tpp_encrypt_hdr_t), 1, (void **) &ehdr)) {
 		tpp_log(LOG_CRIT, __func__, "Failed to add encrypt pkt header into pkt");
 		free(data_out);
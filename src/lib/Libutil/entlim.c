@@ -41,14 +41,141 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
 #include "pbs_entlim.h"
 
 /* entlim iteration context structure, opaque to caller */
 typedef struct _entlim_ctx {
-	void *idx;
+	void *idx;	/* records by key string, ordered for encode */
+	void *kidx;	/* the same records by entlim_key_t */
 	void *idx_ctx;
 } entlim_ctx;
 
+/*
+ * Entity and resource names appearing in any limit are given a small
+ * integer id, process wide, so that structured keys are fixed size.
+ * Ids are never reused or released; the set of names is bounded by the
+ * limits configured.
+ */
+static void *entlim_names = NULL;
+static int entlim_last_id = ENTLIM_NO_ID;
+static pthread_mutex_t entlim_names_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief
+ * 	entlim_name_id - return the id of an entity or resource name
+ *
+ * @param[in] name - the name
+ * @param[in] create - assign an id if the name does not have one yet
+ *
+ * @return	int
+ * @retval	>0		id of the name
+ * @retval	ENTLIM_NO_ID	name has no id (or create failed), so no
+ *				limit can exist for it
+ */
+int
+entlim_name_id(const char *name, int create)
+{
+	void *data;
+	int id = ENTLIM_NO_ID;
+
+	if (name == NULL)
+		return ENTLIM_NO_ID;
+
+	pthread_mutex_lock(&entlim_names_mutex);
+	if (entlim_names == NULL && create)
+		entlim_names = pbs_idx_create(0, 0);
+	if (entlim_names != NULL) {
+		if (pbs_idx_find(entlim_names, (void **) &name, &data, NULL) == PBS_IDX_RET_OK)
+			id = (int) (intptr_t) data;
+		else if (create) {
+			data = (void *) (intptr_t) (entlim_last_id + 1);
+			if (pbs_idx_insert(entlim_names, (void *) name, data) == PBS_IDX_RET_OK)
+				id = ++entlim_last_id;
+		}
+	}
+	pthread_mutex_unlock(&entlim_names_mutex);
+
+	return id;
+}
+
+/**
+ * @brief
+ * 	entlim_mk_key - fill in a structured key for an entity limit
+ *
+ * @param[out] key - key to fill in
+ * @param[in] kt - enum for key token
+ * @param[in] entity - entity name
+ * @param[in] resc - resource name, NULL for a run (count) limit
+ *
+ * @return	int
+ * @retval	0	key made
+ * @retval	-1	a name has never appeared in any limit, so there can
+ *			be no record for the key
+ */
+int
+entlim_mk_key(entlim_key_t *key, enum lim_keytypes kt, const char *entity, const char *resc)
+{
+	key->kt = kt;
+	key->resc = ENTLIM_NO_ID;
+	if ((key->entity = entlim_name_id(entity, 0)) == ENTLIM_NO_ID)
+		return -1;
+	if (resc != NULL && (key->resc = entlim_name_id(resc, 0)) == ENTLIM_NO_ID)
+		return -1;
+	return 0;
+}
+
+/**
+ * @brief
+ * 	entlim_key_from_str - build the structured key matching a key string,
+ *	assigning ids to names not seen before
+ *
+ * @param[in] keystr - key string, see entlim_mk_keystr()
+ * @param[out] key - key to fill in
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	malformed key string or no memory
+ */
+static int
+entlim_key_from_str(const char *keystr, entlim_key_t *key)
+{
+	char *ent;
+	char *pc;
+
+	switch (*keystr) {
+		case 'u':
+			key->kt = LIM_USER;
+			break;
+		case 'g':
+			key->kt = LIM_GROUP;
+			break;
+		case 'p':
+			key->kt = LIM_PROJECT;
+			break;
+		case 'o':
+			key->kt = LIM_OVERALL;
+			break;
+		default:
+			return -1;
+	}
+	if (keystr[1] != ':' || (ent = strdup(keystr + 2)) == NULL)
+		return -1;
+
+	key->resc = ENTLIM_NO_ID;
+	if ((pc = strchr(ent, ';')) != NULL) {
+		*pc++ = '\0';
+		key->resc = entlim_name_id(pc, 1);
+	}
+	key->entity = entlim_name_id(ent, 1);
+	free(ent);
+
+	if (key->entity == ENTLIM_NO_ID || (pc != NULL && key->resc == ENTLIM_NO_ID))
+		return -1;
+	return 0;
+}
+
 /**
  * @brief
  * 	entlim_initialize_ctx - initialize the data context structure
@@ -60,11 +187,18 @@ entlim_initialize_ctx(void)
 	if (pctx == NULL)
 		return NULL;
 	pctx->idx_ctx = NULL;
-	pctx->idx = pbs_idx_create(0, 0);
+	/* limits are walked, and so encoded, in key order */
+	pctx->idx = pbs_idx_create(PBS_IDX_ORDERED, 0);
 	if (pctx->idx == NULL) {
 		free(pctx);
 		return NULL;
 	}
+	pctx->kidx = pbs_idx_create(0, sizeof(entlim_key_t));
+	if (pctx->kidx == NULL) {
+		pbs_idx_destroy(pctx->idx);
+		free(pctx);
+		return NULL;
+	}
 	return (void *) pctx;
 }
 
@@ -91,6 +225,28 @@ entlim_get(const char *keystr, void *ctx)
 	return NULL;
 }
 
+/**
+ * @brief
+ * 	entlim_get_key - get record for a structured key, without building
+ *	or parsing a key string
+ *
+ * @param[in] key - key made by entlim_mk_key()
+ * @param[in] ctx - pointer to context
+ *
+ * @return	void *
+ * @retval	record		success
+ * @retval	NULL		no such record
+ */
+void *
+entlim_get_key(const entlim_key_t *key, void *ctx)
+{
+	void *rtn;
+
+	if (pbs_idx_find(((entlim_ctx *) ctx)->kidx, (void **) &key, &rtn, NULL) == PBS_IDX_RET_OK)
+		return rtn;
+	return NULL;
+}
+
 /**
  * @brief
  * 	entlim_add - add a record with a key based on the key-string
@@ -106,9 +262,18 @@ entlim_get(const char *keystr, void *ctx)
 int
 entlim_add(const char *keystr, const void *recptr, void *ctx)
 {
-	if (pbs_idx_insert(((entlim_ctx *) ctx)->idx, (void *) keystr, (void *) recptr) == PBS_IDX_RET_OK)
-		return 0;
-	return -1;
+	entlim_ctx *pctx = (entlim_ctx *) ctx;
+	entlim_key_t key;
+
+	if (entlim_key_from_str(keystr, &key) != 0)
+		return -1;
+	if (pbs_idx_insert(pctx->idx, (void *) keystr, (void *) recptr) != PBS_IDX_RET_OK)
+		return -1;
+	if (pbs_idx_insert(pctx->kidx, &key, (void *) recptr) != PBS_IDX_RET_OK) {
+		pbs_idx_delete(pctx->idx, (void *) keystr);
+		return -1;
+	}
+	return 0;
 }
 
 /**
@@ -132,14 +297,16 @@ entlim_replace(const char *keystr, void *recptr, void *ctx, void fr_leaf(void *)
 {
 	void *olddata;
 	entlim_ctx *pctx = (entlim_ctx *) ctx;
+	entlim_key_t key;
 
-	if (pbs_idx_insert(pctx->idx, (void *) keystr, recptr) == PBS_IDX_RET_OK)
+	if (entlim_add(keystr, recptr, ctx) == 0)
 		return 0;
-	else {
+	else if (entlim_key_from_str(keystr, &key) == 0) {
 		if (pbs_idx_find(pctx->idx, (void **) &keystr, &olddata, NULL) == PBS_IDX_RET_OK) {
 			if (pbs_idx_delete(pctx->idx, (void *) keystr) == PBS_IDX_RET_OK) {
+				pbs_idx_delete(pctx->kidx, &key);
 				fr_leaf(olddata);
-				if (pbs_idx_insert(pctx->idx, (void *) keystr, recptr) == PBS_IDX_RET_OK)
+				if (entlim_add(keystr, recptr, ctx) == 0)
 					return 0;
 			}
 		}
@@ -165,9 +332,13 @@ int
 entlim_delete(const char *keystr, void *ctx, void free_leaf(void *))
 {
 	void *prec;
+	entlim_ctx *pctx = (entlim_ctx *) ctx;
+	entlim_key_t key;
 
-	if (pbs_idx_find(((entlim_ctx *) ctx)->idx, (void **) &keystr, &prec, NULL) == PBS_IDX_RET_OK) {
-		if (pbs_idx_delete(((entlim_ctx *) ctx)->idx, (void *) keystr) == PBS_IDX_RET_OK) {
+	if (pbs_idx_find(pctx->idx, (void **) &keystr, &prec, NULL) == PBS_IDX_RET_OK) {
+		if (pbs_idx_delete(pctx->idx, (void *) keystr) == PBS_IDX_RET_OK) {
+			if (entlim_key_from_str(keystr, &key) == 0)
+				pbs_idx_delete(pctx->kidx, &key);
 			free_leaf(prec);
 			return 0;
 		}
@@ -245,6 +416,7 @@ entlim_free_ctx(void *ctx, void free_leaf(void *))
 	}
 	pbs_idx_free_ctx(pctx->idx_ctx);
 	pbs_idx_destroy(pctx->idx);
+	pbs_idx_destroy(pctx->kidx);
 	free(pctx);
 	return 0;
 }
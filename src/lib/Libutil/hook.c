@@ -4467,3 +4467,161 @@ hook_perf_stat_stop(char *label, char *action, int print_end_msg)
 
 	log_event(PBSEVENT_DEBUG4, PBS_EVENTCLASS_HOOK, LOG_INFO, "hook_perf_stat", log_buffer);
 }
+
+/**
+ * @brief
+ *	Account one run of 'phook' for 'event' in the hook's in-memory
+ *	performance counters.
+ *
+ * @param[in]	phook - hook that ran
+ * @param[in]	event - the HOOK_EVENT_* being processed
+ * @param[in]	elapsed - wall time of the run, in seconds
+ * @param[in]	populate - part of 'elapsed' spent building event objects
+ * @param[in]	outcome - how the run ended; HOOK_PERF_ALARM also counts
+ *			  as a reject
+ *
+ * @return void
+ */
+void
+hook_perf_record(hook *phook, unsigned int event, double elapsed,
+		 double populate, enum hook_perf_outcome outcome)
+{
+	hook_perf_counters *pc;
+	int i;
+	double ms;
+
+	if (phook == NULL || event == 0)
+		return;
+
+	for (i = 0; i < HOOK_PERF_NEVENTS; i++) {
+		if (event & (1U << i))
+			break;
+	}
+	if (i == HOOK_PERF_NEVENTS)
+		return;
+	pc = &phook->perf[i];
+
+	if (elapsed < 0)
+		elapsed = 0;
+	pc->runs++;
+	pc->total_secs += elapsed;
+	pc->populate_secs += populate;
+	if (elapsed > pc->max_secs)
+		pc->max_secs = elapsed;
+
+	switch (outcome) {
+		case HOOK_PERF_ACCEPT:
+			pc->accepts++;
+			break;
+		case HOOK_PERF_ALARM:
+			pc->alarms++;
+			pc->rejects++;
+			break;
+		case HOOK_PERF_REJECT:
+			pc->rejects++;
+			break;
+		default:
+			pc->errors++;
+	}
+
+	ms = elapsed * 1000;
+	for (i = 0; i < HOOK_PERF_NBUCKETS - 1; i++) {
+		if (ms < (double) (1UL << i))
+			break;
+	}
+	pc->hist[i]++;
+}
+
+/**
+ * @brief
+ *	Return the upper bound, in seconds, of the histogram bucket that
+ *	holds the 'pct' percentile run.  The last bucket is open ended so
+ *	the largest run seen is reported for it.
+ */
+static double
+hook_perf_percentile(hook_perf_counters *pc, double pct)
+{
+	unsigned long want;
+	unsigned long seen = 0;
+	double bound;
+	int i;
+
+	want = (unsigned long) (pc->runs * pct + 0.999999);
+	if (want == 0)
+		want = 1;
+	for (i = 0; i < HOOK_PERF_NBUCKETS - 1; i++) {
+		seen += pc->hist[i];
+		if (seen >= want)
+			break;
+	}
+	if (i == HOOK_PERF_NBUCKETS - 1)
+		return (pc->max_secs);
+	bound = (double) (1UL << i) / 1000;
+	return (bound < pc->max_secs ? bound : pc->max_secs);
+}
+
+/**
+ * @brief
+ *	Dump the performance counters of 'phook' as a JSON object keyed
+ *	by event name.  Events that never ran are left out.
+ *
+ * @param[in]	phook - hook to report on
+ *
+ * @return char *
+ * @retval	malloc'ed JSON string, caller must free
+ * @retval	NULL on allocation failure
+ */
+char *
+hook_perf_as_json(hook *phook)
+{
+	char *buf = NULL;
+	int bufsz = 0;
+	char *ent;
+	int i;
+	int j;
+	int n = 0;
+
+	if (pbs_strcat(&buf, &bufsz, "{") == NULL)
+		return (NULL);
+
+	for (i = 0; i < HOOK_PERF_NEVENTS; i++) {
+		hook_perf_counters *pc = &phook->perf[i];
+		char hist[HOOK_PERF_NBUCKETS * 12 + 3];
+		int len = 0;
+
+		if (pc->runs == 0)
+			continue;
+
+		hist[len++] = '[';
+		for (j = 0; j < HOOK_PERF_NBUCKETS; j++)
+			len += snprintf(hist + len, sizeof(hist) - len, "%s%lu",
+					j ? "," : "", pc->hist[j]);
+		snprintf(hist + len, sizeof(hist) - len, "]");
+
+		if (pbs_asprintf(&ent, "%s\"%s\":{\"runs\":%lu,\"accepts\":%lu,\"rejects\":%lu,"
+				       "\"alarms\":%lu,\"errors\":%lu,\"total_secs\":%.6f,"
+				       "\"populate_secs\":%.6f,\"p50_secs\":%.6f,\"p99_secs\":%.6f,"
+				       "\"max_secs\":%.6f,\"hist_ms_pow2\":%s}",
+				 n ? "," : "", hook_event_as_string(1U << i),
+				 pc->runs, pc->accepts, pc->rejects, pc->alarms, pc->errors,
+				 pc->total_secs, pc->populate_secs,
+				 hook_perf_percentile(pc, 0.50), hook_perf_percentile(pc, 0.99),
+				 pc->max_secs, hist) == -1) {
+			free(buf);
+			return (NULL);
+		}
+		if (pbs_strcat(&buf, &bufsz, ent) == NULL) {
+			free(ent);
+			free(buf);
+			return (NULL);
+		}
+		free(ent);
+		n++;
+	}
+
+	if (pbs_strcat(&buf, &bufsz, "}") == NULL) {
+		free(buf);
+		return (NULL);
+	}
+	return (buf);
+}
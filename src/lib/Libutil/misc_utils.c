@@ -80,6 +80,9 @@
 #include <pbs_share.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
 #include <pwd.h>
 #include <assert.h>
 #include <netinet/in.h>
@@ -1147,6 +1150,77 @@ in_string_list(char *str, char sep, char *string_list)
 	return (found_match);
 }
 
+/**
+ * @brief
+ *	Build an index of the entries of a 'sep'-separated 'string_list',
+ *	tokenized the same way as in_string_list(), for callers that need
+ *	to look up many strings in one long list.
+ *
+ * @param[in]	string_list - the list to index
+ * @param[in]	sep	- the separator character in 'string_list'
+ *
+ * @return void *
+ * @retval	index to pass to in_string_list_idx() and free with
+ *		pbs_idx_destroy()
+ * @retval	NULL	- on error
+ */
+void *
+string_list_idx_create(char *string_list, char sep)
+{
+	void *idx;
+	char *p2;
+	char *p;
+	char *ptoken;
+
+	if ((idx = pbs_idx_create(0, 0)) == NULL)
+		return NULL;
+	if (string_list == NULL)
+		return idx;
+
+	if ((p2 = strdup(string_list)) == NULL) {
+		pbs_idx_destroy(idx);
+		return NULL;
+	}
+
+	p = p2;
+	while (*p != '\0') {
+		while ((*p != '\0') && ((*p == sep) || (*p == ' ')))
+			p++;
+		if (*p == '\0')
+			break;
+		ptoken = p;
+		while ((*p != '\0') && (*p != sep) && (*p != ' '))
+			p++;
+		if (*p != '\0')
+			*p++ = '\0';
+		/* a duplicate entry fails to insert, which is fine */
+		(void) pbs_idx_insert(idx, ptoken, idx);
+	}
+	free(p2);
+	return idx;
+}
+
+/**
+ * @brief
+ *	in_string_list() against an index made by string_list_idx_create().
+ *
+ * @param[in]	str	- the string to look for
+ * @param[in]	list_idx - the index of the list
+ *
+ * @return int
+ * @retval	1	- if 'str' is found in the list
+ * @retval	0	- if 'str' not found
+ */
+int
+in_string_list_idx(char *str, void *list_idx)
+{
+	void *data;
+
+	if ((str == NULL) || (str[0] == '\0') || (list_idx == NULL))
+		return 0;
+	return (pbs_idx_find(list_idx, (void **) &str, &data, NULL) == PBS_IDX_RET_OK);
+}
+
 /**
  *
  *	@brief break apart a delimited string into an array of strings
@@ -2694,6 +2768,121 @@ read_attr(int fd, char **errbuf)
 	return pal;
 }
 
+/**
+ * @brief
+ * 		add an attribute read from a job file to the head of the list
+ *		built by read_all_attrs_from_jbfile()
+ *
+ * @param[in,out] ppal	-	head of the list
+ * @param[in]	pali	-	the attribute read
+ * @param[out]	state	-	return pointer to state value
+ * @param[out]	substate -	return pointer for substate value
+ */
+static void
+link_jbfile_attr(svrattrl **ppal, svrattrl *pali, char **state, char **substate)
+{
+	if (*ppal == NULL) {
+		(&pali->al_link)->ll_struct = (void *) (&pali->al_link);
+		(&pali->al_link)->ll_next = NULL;
+		(&pali->al_link)->ll_prior = NULL;
+	} else {
+		pbs_list_link *head = &(*ppal)->al_link;
+		pbs_list_link *newp = &pali->al_link;
+		newp->ll_prior = NULL;
+		newp->ll_next = head;
+		newp->ll_struct = pali;
+	}
+	*ppal = pali;
+
+	/* Check if the attribute read is state/substate and store it separately */
+	if (state && strcmp(pali->al_name, ATTR_state) == 0)
+		*state = pali->al_value;
+	else if (substate && strcmp(pali->al_name, ATTR_substate) == 0)
+		*substate = pali->al_value;
+}
+
+#ifdef HAVE_MMAP
+/**
+ * @brief
+ * 		read all job attributes from a job file through a read only mapping
+ *
+ * @par
+ *		Parses the attribute records in memory instead of issuing two
+ *		read() calls for each one, then leaves the file offset just past
+ *		the end of attributes marker, as the read() based loop does.
+ *
+ * @param[in]	fd	-	fd of job file, positioned at the first attribute
+ * @param[out]	ppal	-	list of attributes read
+ * @param[out]	state	-	return pointer to state value
+ * @param[out]	substate -	return pointer for substate value
+ * @param[out]	errbuf	-	buffer to return messages for any errors
+ *
+ * @return	int
+ * @retval	0	: file parsed (*ppal may still be partial on error, see errbuf)
+ * @retval	-1	: file could not be mapped, caller should read it instead
+ */
+static int
+read_all_attrs_mapped(int fd, svrattrl **ppal, char **state, char **substate, char **errbuf)
+{
+	struct stat sb;
+	off_t pos;
+	char *map;
+	size_t off;
+	svrattrl tempal;
+	svrattrl *pali;
+
+	if ((pos = lseek(fd, 0, SEEK_CUR)) == (off_t) -1 || fstat(fd, &sb) == -1 ||
+	    !S_ISREG(sb.st_mode) || sb.st_size <= pos)
+		return -1;
+	map = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (map == MAP_FAILED)
+		return -1;
+
+	off = pos;
+	while (1) {
+		if (sb.st_size - off < sizeof(tempal)) {
+			if (errbuf != NULL)
+				sprintf(*errbuf, "bad read of attribute");
+			break;
+		}
+		memcpy(&tempal, map + off, sizeof(tempal));
+		if (tempal.al_tsize == ENDATTRIBUTES) {
+			off += sizeof(tempal);
+			break;
+		}
+		if (tempal.al_tsize < (int) sizeof(svrattrl) ||
+		    (size_t) tempal.al_tsize > sb.st_size - off) {
+			if (errbuf != NULL)
+				sprintf(*errbuf, "short read of attribute");
+			break;
+		}
+		if ((pali = (svrattrl *) malloc(tempal.al_tsize)) == NULL) {
+			if (errbuf != NULL)
+				sprintf(*errbuf, "malloc failed");
+			break;
+		}
+		memcpy(pali, map + off, tempal.al_tsize);
+		off += tempal.al_tsize;
+
+		pali->al_name = (char *) pali + sizeof(svrattrl);
+		if (pali->al_rescln)
+			pali->al_resc = pali->al_name + pali->al_nameln;
+		else
+			pali->al_resc = NULL;
+		if (pali->al_valln)
+			pali->al_value = pali->al_name + pali->al_nameln + pali->al_rescln;
+		else
+			pali->al_value = NULL;
+
+		link_jbfile_attr(ppal, pali, state, substate);
+	}
+
+	(void) munmap(map, sb.st_size);
+	(void) lseek(fd, (off_t) off, SEEK_SET);
+	return 0;
+}
+#endif
+
 /**
  * @brief	Read all job attribute values from a job file
  *
@@ -2712,26 +2901,13 @@ read_all_attrs_from_jbfile(int fd, char **state, char **substate, char **errbuf)
 	svrattrl *pal = NULL;
 	svrattrl *pali = NULL;
 
-	while ((pali = read_attr(fd, errbuf)) != NULL) {
-		if (pal == NULL) {
-			pal = pali;
-			(&pal->al_link)->ll_struct = (void *) (&pal->al_link);
-			(&pal->al_link)->ll_next = NULL;
-			(&pal->al_link)->ll_prior = NULL;
-		} else {
-			pbs_list_link *head = &pal->al_link;
-			pbs_list_link *newp = &pali->al_link;
-			newp->ll_prior = NULL;
-			newp->ll_next = head;
-			newp->ll_struct = pali;
-			pal = pali;
-		}
-		/* Check if the attribute read is state/substate and store it separately */
-		if (state && strcmp(pali->al_name, ATTR_state) == 0)
-			*state = pali->al_value;
-		else if (substate && strcmp(pali->al_name, ATTR_substate) == 0)
-			*substate = pali->al_value;
-	}
+#ifdef HAVE_MMAP
+	if (read_all_attrs_mapped(fd, &pal, state, substate, errbuf) == 0)
+		return pal;
+#endif
+
+	while ((pali = read_attr(fd, errbuf)) != NULL)
+		link_jbfile_attr(&pal, pali, state, substate);
 
 	return pal;
 }
@@ -45,6 +45,7 @@
 #include <memory.h>
 #include <string.h>
 #include <stdlib.h>
+#include <pthread.h>
 
 #include <openssl/evp.h>
 #include <openssl/aes.h>
@@ -58,18 +59,125 @@
 extern unsigned char pbs_aes_key[];
 extern unsigned char pbs_aes_iv[];
 
-#if OPENSSL_VERSION_NUMBER < 0x10100000L
-#define CIPHER_CONTEXT_INIT(v) EVP_CIPHER_CTX_init(v)
-#define CIPHER_CONTEXT_CLEAN(v) EVP_CIPHER_CTX_cleanup(v)
-#else
-#define CIPHER_CONTEXT_INIT(v)    \
-	v = EVP_CIPHER_CTX_new(); \
-	if (!v)                   \
-	return -1
-#define CIPHER_CONTEXT_CLEAN(v)    \
-	EVP_CIPHER_CTX_cleanup(v); \
-	EVP_CIPHER_CTX_free(v)
-#endif
+#define AES_CTX_ENCRYPT 1
+#define AES_CTX_DECRYPT 0
+
+/*
+ * Cipher contexts are kept per thread, one for each direction, together
+ * with the key they were last set up with.  Reusing a context with the
+ * same key only resets the IV, so the key schedule is not expanded again
+ * and no context is allocated per call.
+ */
+typedef struct aes_tls {
+	EVP_CIPHER_CTX *ctx[2];		    /* indexed by AES_CTX_ENCRYPT/DECRYPT */
+	unsigned char key[2][EVP_MAX_KEY_LENGTH]; /* key each ctx holds */
+	int keyed[2];			    /* ctx holds key[] */
+} aes_tls_t;
+
+static pthread_once_t aes_tls_once = PTHREAD_ONCE_INIT;
+static pthread_key_t aes_tls_key;
+static int aes_tls_ready = 0;
+
+/**
+ * @brief
+ *	Free a thread's cipher contexts when the thread exits.
+ *
+ * @param[in]	p - the thread's aes_tls_t
+ */
+static void
+aes_tls_free(void *p)
+{
+	aes_tls_t *tls = p;
+
+	EVP_CIPHER_CTX_free(tls->ctx[AES_CTX_ENCRYPT]);
+	EVP_CIPHER_CTX_free(tls->ctx[AES_CTX_DECRYPT]);
+	free(tls);
+}
+
+static void
+aes_tls_init(void)
+{
+	aes_tls_ready = (pthread_key_create(&aes_tls_key, aes_tls_free) == 0);
+}
+
+/**
+ * @brief
+ *	Get a cipher context set up for AES-256-CBC with the given key and iv,
+ *	reusing the calling thread's context when it can.
+ *
+ * @param[in]	enc - AES_CTX_ENCRYPT or AES_CTX_DECRYPT
+ * @param[in]	aes_key - the key
+ * @param[in]	aes_iv - the iv
+ * @param[out]	tls - the thread's contexts, or NULL if the returned context
+ *		      is not cached and must be released with aes_put_ctx()
+ *
+ * @return	EVP_CIPHER_CTX *
+ * @retval	NULL - failure
+ */
+static EVP_CIPHER_CTX *
+aes_get_ctx(int enc, const unsigned char *aes_key, const unsigned char *aes_iv, aes_tls_t **tls)
+{
+	const EVP_CIPHER *cipher = EVP_aes_256_cbc();
+	int keylen = EVP_CIPHER_key_length(cipher);
+	EVP_CIPHER_CTX *ctx;
+	aes_tls_t *t = NULL;
+
+	pthread_once(&aes_tls_once, aes_tls_init);
+	if (aes_tls_ready && (t = pthread_getspecific(aes_tls_key)) == NULL) {
+		if ((t = calloc(1, sizeof(aes_tls_t))) != NULL && pthread_setspecific(aes_tls_key, t) != 0) {
+			free(t);
+			t = NULL;
+		}
+	}
+
+	*tls = t;
+	if (t == NULL) {
+		if ((ctx = EVP_CIPHER_CTX_new()) == NULL)
+			return NULL;
+		if (EVP_CipherInit_ex(ctx, cipher, NULL, aes_key, aes_iv, enc) == 0) {
+			EVP_CIPHER_CTX_free(ctx);
+			return NULL;
+		}
+		return ctx;
+	}
+
+	if (t->ctx[enc] == NULL && (t->ctx[enc] = EVP_CIPHER_CTX_new()) == NULL)
+		return NULL;
+	ctx = t->ctx[enc];
+
+	if (t->keyed[enc] && memcmp(t->key[enc], aes_key, keylen) == 0) {
+		/* same key, only restart the chaining from the iv */
+		if (EVP_CipherInit_ex(ctx, NULL, NULL, NULL, aes_iv, enc) != 0)
+			return ctx;
+	}
+
+	t->keyed[enc] = 0;
+	if (EVP_CipherInit_ex(ctx, cipher, NULL, aes_key, aes_iv, enc) == 0)
+		return NULL;
+	memcpy(t->key[enc], aes_key, keylen);
+	t->keyed[enc] = 1;
+
+	return ctx;
+}
+
+/**
+ * @brief
+ *	Release a context from aes_get_ctx().  A cached context whose
+ *	operation failed is made to take the full key setup next time.
+ *
+ * @param[in]	ctx - the context
+ * @param[in]	tls - as returned by aes_get_ctx()
+ * @param[in]	enc - AES_CTX_ENCRYPT or AES_CTX_DECRYPT
+ * @param[in]	ok - whether the operation succeeded
+ */
+static void
+aes_put_ctx(EVP_CIPHER_CTX *ctx, aes_tls_t *tls, int enc, int ok)
+{
+	if (tls == NULL)
+		EVP_CIPHER_CTX_free(ctx);
+	else if (!ok)
+		tls->keyed[enc] = 0;
+}
 
 /**
  * @brief
@@ -92,43 +200,34 @@ pbs_encrypt_pwd(char *uncrypted, int *credtype, char **crypted, size_t *outlen,
 	int plen, len2 = 0;
 	unsigned char *cblk;
 	size_t len = strlen(uncrypted) + 1;
+	EVP_CIPHER_CTX *ctx;
+	aes_tls_t *tls;
 
-#if OPENSSL_VERSION_NUMBER < 0x10100000L
-	EVP_CIPHER_CTX real_ctx;
-	EVP_CIPHER_CTX *ctx = &real_ctx;
-#else
-	EVP_CIPHER_CTX *ctx = NULL;
-#endif
-
-	CIPHER_CONTEXT_INIT(ctx);
-
-	if (EVP_EncryptInit_ex(ctx, EVP_aes_256_cbc(), NULL, (const unsigned char *) aes_key, (const unsigned char *) aes_iv) == 0) {
-		CIPHER_CONTEXT_CLEAN(ctx);
+	if ((ctx = aes_get_ctx(AES_CTX_ENCRYPT, aes_key, aes_iv, &tls)) == NULL)
 		return -1;
-	}
 
 	plen = len + EVP_CIPHER_CTX_block_size(ctx) + 1;
 	cblk = malloc(plen);
 	if (!cblk) {
-		CIPHER_CONTEXT_CLEAN(ctx);
+		aes_put_ctx(ctx, tls, AES_CTX_ENCRYPT, 1);
 		return -1;
 	}
 
 	if (EVP_EncryptUpdate(ctx, cblk, &plen, (unsigned char *) uncrypted, len) == 0) {
-		CIPHER_CONTEXT_CLEAN(ctx);
+		aes_put_ctx(ctx, tls, AES_CTX_ENCRYPT, 0);
 		free(cblk);
 		cblk = NULL;
 		return -1;
 	}
 
 	if (EVP_EncryptFinal_ex(ctx, cblk + plen, &len2) == 0) {
-		CIPHER_CONTEXT_CLEAN(ctx);
+		aes_put_ctx(ctx, tls, AES_CTX_ENCRYPT, 0);
 		free(cblk);
 		cblk = NULL;
 		return -1;
 	}
 
-	CIPHER_CONTEXT_CLEAN(ctx);
+	aes_put_ctx(ctx, tls, AES_CTX_ENCRYPT, 1);
 
 	*crypted = (char *) cblk;
 	*outlen = plen + len2;
@@ -157,42 +256,33 @@ pbs_decrypt_pwd(char *crypted, int credtype, size_t len, char **uncrypted, const
 {
 	unsigned char *cblk;
 	int plen, len2 = 0;
+	EVP_CIPHER_CTX *ctx;
+	aes_tls_t *tls;
 
-#if OPENSSL_VERSION_NUMBER < 0x10100000L
-	EVP_CIPHER_CTX real_ctx;
-	EVP_CIPHER_CTX *ctx = &real_ctx;
-#else
-	EVP_CIPHER_CTX *ctx = NULL;
-#endif
-
-	CIPHER_CONTEXT_INIT(ctx);
-
-	if (EVP_DecryptInit_ex(ctx, EVP_aes_256_cbc(), NULL, (const unsigned char *) aes_key, (const unsigned char *) aes_iv) == 0) {
-		CIPHER_CONTEXT_CLEAN(ctx);
+	if ((ctx = aes_get_ctx(AES_CTX_DECRYPT, aes_key, aes_iv, &tls)) == NULL)
 		return -1;
-	}
 
 	cblk = malloc(len + EVP_CIPHER_CTX_block_size(ctx) + 1);
 	if (!cblk) {
-		CIPHER_CONTEXT_CLEAN(ctx);
+		aes_put_ctx(ctx, tls, AES_CTX_DECRYPT, 1);
 		return -1;
 	}
 
 	if (EVP_DecryptUpdate(ctx, cblk, &plen, (unsigned char *) crypted, len) == 0) {
-		CIPHER_CONTEXT_CLEAN(ctx);
+		aes_put_ctx(ctx, tls, AES_CTX_DECRYPT, 0);
 		free(cblk);
 		cblk = NULL;
 		return -1;
 	}
 
 	if (EVP_DecryptFinal_ex(ctx, cblk + plen, &len2) == 0) {
-		CIPHER_CONTEXT_CLEAN(ctx);
+		aes_put_ctx(ctx, tls, AES_CTX_DECRYPT, 0);
 		free(cblk);
 		cblk = NULL;
 		return -1;
 	}
 
-	CIPHER_CONTEXT_CLEAN(ctx);
+	aes_put_ctx(ctx, tls, AES_CTX_DECRYPT, 1);
 
 	*uncrypted = (char *) cblk;
 	(*uncrypted)[plen + len2] = '\0';
@@ -65,11 +65,195 @@
 
 #include "pbs_error.h"
 #ifdef LIBICAL
+#include <pthread.h>
 #include <libical/ical.h>
+#include "pbs_idx.h"
 #endif
 
 #define DATE_LIMIT (3 * (60 * 60 * 24 * 365)) /* Limit to 3 years from now */
 
+#ifdef LIBICAL
+#define OCCR_CACHE_MAX 4096 /* most recurrence expansions kept at once */
+
+/*
+ * The occurrences of one recurrence rule from one start time, expanded as
+ * far as callers have asked for.  times[i] is occurrence i + 1 in UTC, so
+ * the array is sorted and an occurrence is found by index or by time
+ * without walking the rule again.
+ */
+typedef struct occr_expansion {
+	char *key;				/* rrule, tz and dtstart */
+	struct icalrecur_iterator_impl *itr;	/* NULL once the rule has ended */
+	icaltimezone *localzone;		/* zone the rule is walked in */
+	time_t *times;				/* occurrences found so far */
+	int ntimes;				/* entries used in times */
+	int size;				/* entries allocated in times */
+	unsigned long used;			/* occr_clock when last used */
+} occr_expansion_t;
+
+static void *occr_idx = NULL;
+static int occr_nexp = 0;
+static unsigned long occr_clock = 0;
+static pthread_mutex_t occr_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief
+ * 	Free an occurrence expansion.
+ *
+ * @param[in] oe - expansion to free
+ */
+static void
+occr_free(occr_expansion_t *oe)
+{
+	if (oe->itr != NULL)
+		icalrecur_iterator_free((icalrecur_iterator *) oe->itr);
+	free(oe->times);
+	free(oe->key);
+	free(oe);
+}
+
+/**
+ * @brief
+ * 	Drop the expansion used least recently to make room for a new one.
+ */
+static void
+occr_evict(void)
+{
+	void *ctx = NULL;
+	occr_expansion_t *oe;
+	occr_expansion_t *lru = NULL;
+
+	while (pbs_idx_find(occr_idx, NULL, (void **) &oe, &ctx) == PBS_IDX_RET_OK) {
+		if (lru == NULL || oe->used < lru->used)
+			lru = oe;
+	}
+	pbs_idx_free_ctx(ctx);
+	if (lru == NULL)
+		return;
+	pbs_idx_delete(occr_idx, lru->key);
+	occr_free(lru);
+	occr_nexp--;
+}
+
+/**
+ * @brief
+ * 	Find the expansion of a recurrence rule from a start time, creating
+ * 	it if this rule and start time were not seen before.
+ * 	Called with occr_mutex held.
+ *
+ * @param[in] rrule - The recurrence rule
+ * @param[in] dtstart - The start time of the first occurrence
+ * @param[in] tz - The timezone associated to the recurrence rule
+ *
+ * @return	occr_expansion_t *
+ * @retval	NULL	- unknown timezone or out of memory
+ */
+static occr_expansion_t *
+occr_find(char *rrule, time_t dtstart, char *tz)
+{
+	struct icalrecurrencetype rt;
+	struct icaltimetype start;
+	occr_expansion_t *oe = NULL;
+	char *key;
+	void *k;
+	size_t len;
+
+	len = strlen(rrule) + strlen(tz) + 32;
+	if ((key = malloc(len)) == NULL)
+		return NULL;
+	snprintf(key, len, "%s\n%s\n%ld", rrule, tz, (long) dtstart);
+
+	if (occr_idx == NULL && (occr_idx = pbs_idx_create(0, 0)) == NULL) {
+		free(key);
+		return NULL;
+	}
+	k = key;
+	if (pbs_idx_find(occr_idx, &k, (void **) &oe, NULL) == PBS_IDX_RET_OK) {
+		free(key);
+		oe->used = ++occr_clock;
+		return oe;
+	}
+
+	if ((oe = calloc(1, sizeof(occr_expansion_t))) == NULL) {
+		free(key);
+		return NULL;
+	}
+	oe->key = key;
+
+	icalerror_clear_errno();
+
+	icalerror_set_error_state(ICAL_PARSE_ERROR, ICAL_ERROR_NONFATAL);
+#ifdef LIBICAL_API2
+	icalerror_set_errors_are_fatal(0);
+#else
+	icalerror_errors_are_fatal = 0;
+#endif
+	if ((oe->localzone = icaltimezone_get_builtin_timezone(tz)) == NULL) {
+		occr_free(oe);
+		return NULL;
+	}
+
+	rt = icalrecurrencetype_from_string(rrule);
+
+	start = icaltime_from_timet_with_zone(dtstart, 0, NULL);
+	icaltimezone_convert_time(&start, icaltimezone_get_utc_timezone(), oe->localzone);
+
+	oe->itr = (struct icalrecur_iterator_impl *) icalrecur_iterator_new(rt, start);
+
+	if (occr_nexp >= OCCR_CACHE_MAX)
+		occr_evict();
+	if (pbs_idx_insert(occr_idx, oe->key, oe) != PBS_IDX_RET_OK) {
+		occr_free(oe);
+		return NULL;
+	}
+	occr_nexp++;
+	oe->used = ++occr_clock;
+	return oe;
+}
+
+/**
+ * @brief
+ * 	Walk the recurrence rule further until the expansion holds at least
+ * 	num occurrences, or one at or after limit, or the rule has ended.
+ * 	Called with occr_mutex held.
+ *
+ * @param[in] oe - The expansion to extend
+ * @param[in] num - The number of occurrences wanted, 0 to go by limit only
+ * @param[in] limit - The time to expand up to, 0 to go by num only
+ */
+static void
+occr_extend(occr_expansion_t *oe, int num, time_t limit)
+{
+	icaltimezone *utczone = icaltimezone_get_utc_timezone();
+	struct icaltimetype next;
+	time_t *tmp;
+	int size;
+
+	while (oe->itr != NULL) {
+		if (num > 0 && oe->ntimes >= num)
+			break;
+		if (limit > 0 && oe->ntimes > 0 && oe->times[oe->ntimes - 1] >= limit)
+			break;
+
+		next = icalrecur_iterator_next((icalrecur_iterator *) oe->itr);
+		if (icaltime_is_null_time(next)) {
+			icalrecur_iterator_free((icalrecur_iterator *) oe->itr);
+			oe->itr = NULL;
+			break;
+		}
+		if (oe->ntimes == oe->size) {
+			size = oe->size ? oe->size * 2 : 64;
+			if ((tmp = realloc(oe->times, size * sizeof(time_t))) == NULL)
+				break;
+			oe->times = tmp;
+			oe->size = size;
+		}
+		icaltimezone_convert_time(&next, oe->localzone, utczone);
+		oe->times[oe->ntimes++] = icaltime_as_timet(next);
+	}
+}
+#endif
+
 /**
  * @brief
  * 	Returns the number of occurrences defined by a recurrence rule.
@@ -93,55 +277,37 @@ get_num_occurrences(char *rrule, time_t dtstart, char *tz)
 {
 
 #ifdef LIBICAL
-	struct icalrecurrencetype rt;
-	struct icaltimetype start;
-	icaltimezone *localzone;
-	struct icaltimetype next;
-	struct icalrecur_iterator_impl *itr;
-	time_t now;
+	occr_expansion_t *oe;
 	time_t date_limit;
-	int num_resv = 0;
+	int lo, hi, mid;
 
 	/* if any of the argument is NULL, we are dealing with
 	 * advance reservation, so return 1 occurrence */
 	if (rrule == NULL || tz == NULL)
 		return 1;
 
-	icalerror_clear_errno();
-
-	icalerror_set_error_state(ICAL_PARSE_ERROR, ICAL_ERROR_NONFATAL);
-#ifdef LIBICAL_API2
-	icalerror_set_errors_are_fatal(0);
-#else
-	icalerror_errors_are_fatal = 0;
-#endif
-	localzone = icaltimezone_get_builtin_timezone(tz);
+	date_limit = time(NULL) + DATE_LIMIT;
 
-	if (localzone == NULL)
+	pthread_mutex_lock(&occr_mutex);
+	if ((oe = occr_find(rrule, dtstart, tz)) == NULL) {
+		pthread_mutex_unlock(&occr_mutex);
 		return 0;
-
-	now = time(NULL);
-	date_limit = now + DATE_LIMIT;
-
-	rt = icalrecurrencetype_from_string(rrule);
-
-	start = icaltime_from_timet_with_zone(dtstart, 0, NULL);
-	icaltimezone_convert_time(&start, icaltimezone_get_utc_timezone(), localzone);
-
-	itr = (struct icalrecur_iterator_impl *) icalrecur_iterator_new(rt, start);
-
-	next = icalrecur_iterator_next(itr);
-
-	/* Compute the total number of occurrences.
-	 * Breaks out if the total number of allowed occurrences is exceeded */
-	while (!icaltime_is_null_time(next) &&
-	       (icaltime_as_timet(next) < date_limit)) {
-		num_resv++;
-		next = icalrecur_iterator_next(itr);
 	}
-	icalrecur_iterator_free(itr);
+	occr_extend(oe, 0, date_limit);
+
+	/* count the occurrences before the limit */
+	lo = 0;
+	hi = oe->ntimes;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (oe->times[mid] < date_limit)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	pthread_mutex_unlock(&occr_mutex);
 
-	return num_resv;
+	return lo;
 #else
 
 	if (rrule == NULL)
@@ -157,9 +323,8 @@ get_num_occurrences(char *rrule, time_t dtstart, char *tz)
  * 	index, and start time. This function assumes that the
  * 	time dtsart passed in is the one to start the occurrence from.
  *
- * @par	NOTE: This function should be made reentrant such that
- * 	it can be looped over without having to loop over every occurrence
- * 	over and over again.
+ * @par	NOTE: The occurrences of a rule and start time are kept once
+ * 	found, so calling this for consecutive indexes is cheap.
  *
  * @param[in] rrule - The recurrence rule as defined by the user
  * @param[in] dtstart - The start time from which to start
@@ -174,57 +339,69 @@ get_num_occurrences(char *rrule, time_t dtstart, char *tz)
 time_t
 get_occurrence(char *rrule, time_t dtstart, char *tz, int idx)
 {
-#ifdef LIBICAL
-	struct icalrecurrencetype rt;
-	struct icaltimetype start;
-	icaltimezone *localzone;
-	struct icaltimetype next;
-	struct icalrecur_iterator_impl *itr;
-	int i;
 	time_t next_occr = dtstart;
 
-	if (rrule == NULL)
-		return dtstart;
-
-	if (tz == NULL)
-		return -1;
+	get_occurrences(rrule, dtstart, tz, idx, 1, &next_occr);
 
-	icalerror_clear_errno();
-
-	icalerror_set_error_state(ICAL_PARSE_ERROR, ICAL_ERROR_NONFATAL);
-#ifdef LIBICAL_API2
-	icalerror_set_errors_are_fatal(0);
-#else
-	icalerror_errors_are_fatal = 0;
-#endif
-	localzone = icaltimezone_get_builtin_timezone(tz);
-
-	if (localzone == NULL)
-		return -1;
-
-	rt = icalrecurrencetype_from_string(rrule);
+	return next_occr;
+}
 
-	start = icaltime_from_timet_with_zone(dtstart, 0, NULL);
-	icaltimezone_convert_time(&start, icaltimezone_get_utc_timezone(), localzone);
-	next = start;
+/**
+ * @brief
+ * 	Get a run of consecutive occurrences as defined by the given recurrence
+ * 	rule and start time.  occrs[i] is set to what get_occurrence() returns
+ * 	for index idx + i.
+ *
+ * @param[in] rrule - The recurrence rule as defined by the user
+ * @param[in] dtstart - The start time from which to start
+ * @param[in] tz - The timezone associated to the recurrence rule
+ * @param[in] idx - The index of the first occurrence to return
+ * @param[in] num - The number of occurrences to return
+ * @param[out] occrs - array of at least num entries to fill in
+ *
+ * @return	int
+ * @retval	num
+ *
+ */
+int
+get_occurrences(char *rrule, time_t dtstart, char *tz, int idx, int num, time_t *occrs)
+{
+	int i;
+#ifdef LIBICAL
+	occr_expansion_t *oe;
+	int n;
 
-	itr = (struct icalrecur_iterator_impl *) icalrecur_iterator_new(rt, start);
-	/* Skip as many occurrences as specified by idx */
-	for (i = 0; i < idx && !icaltime_is_null_time(next); i++)
-		next = icalrecur_iterator_next(itr);
-
-	if (!icaltime_is_null_time(next)) {
-		icaltimezone_convert_time(&next, localzone,
-					  icaltimezone_get_utc_timezone());
-		next_occr = icaltime_as_timet(next);
-	} else
-		next_occr = -1; /* If reached end of possible date-time return -1 */
-	icalrecur_iterator_free(itr);
+	if (rrule == NULL) {
+		for (i = 0; i < num; i++)
+			occrs[i] = dtstart;
+		return num;
+	}
 
-	return next_occr;
+	pthread_mutex_lock(&occr_mutex);
+	if (tz == NULL || (oe = occr_find(rrule, dtstart, tz)) == NULL) {
+		pthread_mutex_unlock(&occr_mutex);
+		for (i = 0; i < num; i++)
+			occrs[i] = -1;
+		return num;
+	}
+	occr_extend(oe, idx + num - 1, 0);
+
+	/* index 0 is dtstart itself, index n > 0 the n-th occurrence of the rule */
+	for (i = 0; i < num; i++) {
+		n = idx + i;
+		if (n <= 0)
+			occrs[i] = dtstart;
+		else if (n <= oe->ntimes)
+			occrs[i] = oe->times[n - 1];
+		else
+			occrs[i] = -1; /* If reached end of possible date-time return -1 */
+	}
+	pthread_mutex_unlock(&occr_mutex);
 #else
-	return dtstart;
+	for (i = 0; i < num; i++)
+		occrs[i] = dtstart;
 #endif
+	return num;
 }
 
 /**
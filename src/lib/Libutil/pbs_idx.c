@@ -41,21 +41,421 @@
 
 #include "pbs_idx.h"
 #include "avltree.h"
+#include <ctype.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+
+/*
+ * Two kinds of index sit behind the pbs_idx_* calls below.  By default an
+ * index is an open addressing hash table: entries are kept in an array in
+ * insertion order, and the table only holds positions in that array, so a
+ * lookup is one hash and a short linear probe over a flat array.  An index
+ * created with PBS_IDX_ORDERED is an avl tree instead, for the few callers
+ * which need to walk the keys in sorted order.
+ *
+ * Lookups and iteration never modify a hash index, which lets several
+ * threads walk one index under a shared lock without per thread state.
+ */
+#define IDX_TYPE_HASH 1 /* open addressing hash index */
+#define IDX_TYPE_AVL 2	/* avl tree index, iterated in key order */
+
+#define IDX_SLOT_EMPTY -1   /* slot never used since last rebuild */
+#define IDX_SLOT_DELETED -2 /* slot of a deleted entry */
+#define IDX_INIT_SIZE 16    /* initial number of entries */
+
+/* an entry of a hash index */
+typedef struct _idx_entry {
+	void *key;	   /* private copy of key, NULL once deleted */
+	void *data;	   /* data of entry */
+	unsigned int hash; /* hash of key */
+	unsigned long seq; /* insertion sequence number */
+} idx_entry;
+
+/* hash index structure, opaque to application */
+typedef struct _hash_idx {
+	int type;	    /* IDX_TYPE_HASH */
+	int flags;	    /* index flags */
+	int keylen;	    /* length of key, 0 for strings */
+	idx_entry *ents;    /* entries, in insertion order */
+	int nents;	    /* number of entries used, including deleted */
+	int ndel;	    /* number of deleted entries */
+	int size;	    /* number of entries allocated */
+	int *slot;	    /* position in ents of each slot */
+	unsigned int nslot; /* number of slots, a power of 2 */
+	unsigned long seq;  /* sequence number for next entry */
+	unsigned long gen;  /* bumped each time entries or slots move */
+} hash_idx;
+
+/* avl index structure, opaque to application */
+typedef struct _avl_idx {
+	int type;	   /* IDX_TYPE_AVL */
+	AVL_IX_DESC desc; /* the avl tree */
+} avl_idx;
 
 /* iteration context structure, opaque to application */
 typedef struct _iter_ctx {
-	AVL_IX_DESC *idx; /* pointer to idx */
-	AVL_IX_REC *pkey; /* pointer to key used while iteration */
+	void *idx;	   /* pointer to idx */
+	AVL_IX_REC *pkey;  /* pointer to key used while iteration of avl index */
+	int bykey;	   /* hash index: only walking duplicates of one key */
+	int pos;	   /* hash index: slot if bykey, else position in ents */
+	unsigned long seq; /* hash index: sequence number of current entry */
+	unsigned long gen; /* hash index: gen of index when pos was set */
+	void *key;	   /* hash index: copy of key of current entry */
+	size_t keysz;	   /* hash index: size of key buffer */
 } iter_ctx;
 
+#define IDX_TYPE(idx) (*((int *) (idx)))
+
+/**
+ * @brief
+ *	hash a key of a hash index (FNV-1a)
+ *
+ * @param[in] - h   - pointer to index
+ * @param[in] - key - key to hash
+ *
+ * @return unsigned int
+ *
+ */
+static unsigned int
+hash_idx_hash(hash_idx *h, const void *key)
+{
+	const unsigned char *p = key;
+	unsigned int hv = 2166136261U;
+	int i;
+
+	if (h->keylen) {
+		for (i = 0; i < h->keylen; i++)
+			hv = (hv ^ p[i]) * 16777619U;
+	} else if (h->flags & PBS_IDX_ICASE_CMP) {
+		for (; *p; p++)
+			hv = (hv ^ (unsigned char) tolower(*p)) * 16777619U;
+	} else {
+		for (; *p; p++)
+			hv = (hv ^ *p) * 16777619U;
+	}
+	return hv;
+}
+
+/**
+ * @brief
+ *	compare two keys of a hash index
+ *
+ * @param[in] - h  - pointer to index
+ * @param[in] - k1 - first key
+ * @param[in] - k2 - second key
+ *
+ * @return int
+ * @retval 0  - keys match
+ * @retval !0 - keys differ
+ *
+ */
+static int
+hash_idx_keycmp(hash_idx *h, const void *k1, const void *k2)
+{
+	if (h->keylen)
+		return memcmp(k1, k2, h->keylen);
+	if (h->flags & PBS_IDX_ICASE_CMP)
+		return strcasecmp(k1, k2);
+	return strcmp(k1, k2);
+}
+
+/**
+ * @brief
+ *	find the next slot holding an entry with the given key
+ *
+ * @param[in] - h    - pointer to index
+ * @param[in] - key  - key to look for
+ * @param[in] - hv   - hash of key
+ * @param[in] - from - slot to start probing at
+ *
+ * @return int
+ * @retval >=0 - slot of matching entry
+ * @retval -1  - no more matching entries
+ *
+ */
+static int
+hash_idx_probe(hash_idx *h, const void *key, unsigned int hv, unsigned int from)
+{
+	unsigned int mask = h->nslot - 1;
+	unsigned int s;
+	idx_entry *e;
+
+	for (s = from & mask; h->slot[s] != IDX_SLOT_EMPTY; s = (s + 1) & mask) {
+		if (h->slot[s] == IDX_SLOT_DELETED)
+			continue;
+		e = &h->ents[h->slot[s]];
+		if (e->hash == hv && hash_idx_keycmp(h, e->key, key) == 0)
+			return (int) s;
+	}
+	return -1;
+}
+
+/**
+ * @brief
+ *	put entry at given position in the first free slot of its probe chain
+ *
+ * @note
+ *	Deleted slots are never reused, so along any probe chain the entries
+ *	of one key sit in insertion order.  Iteration over duplicates relies
+ *	on this to resume after the slots were rebuilt.
+ *
+ * @param[in] - h   - pointer to index
+ * @param[in] - pos - position of entry in ents
+ *
+ * @return void
+ *
+ */
+static void
+hash_idx_place(hash_idx *h, int pos)
+{
+	unsigned int mask = h->nslot - 1;
+	unsigned int s;
+
+	for (s = h->ents[pos].hash & mask; h->slot[s] != IDX_SLOT_EMPTY; s = (s + 1) & mask)
+		;
+	h->slot[s] = pos;
+}
+
+/**
+ * @brief
+ *	rebuild the slots of a hash index, after dropping deleted entries
+ *	if there are any
+ *
+ * @param[in] - h     - pointer to index
+ * @param[in] - nslot - number of slots to use, a power of 2
+ *
+ * @return int
+ * @retval PBS_IDX_RET_OK   - success
+ * @retval PBS_IDX_RET_FAIL - failure
+ *
+ */
+static int
+hash_idx_rebuild(hash_idx *h, unsigned int nslot)
+{
+	int *slot;
+	unsigned int s;
+	int i, j;
+
+	if ((slot = malloc(nslot * sizeof(int))) == NULL)
+		return PBS_IDX_RET_FAIL;
+	for (s = 0; s < nslot; s++)
+		slot[s] = IDX_SLOT_EMPTY;
+	free(h->slot);
+	h->slot = slot;
+	h->nslot = nslot;
+
+	if (h->ndel) {
+		for (i = 0, j = 0; i < h->nents; i++) {
+			if (h->ents[i].key != NULL)
+				h->ents[j++] = h->ents[i];
+		}
+		h->nents = j;
+		h->ndel = 0;
+	}
+	for (i = 0; i < h->nents; i++)
+		hash_idx_place(h, i);
+	h->gen++;
+	return PBS_IDX_RET_OK;
+}
+
+/**
+ * @brief
+ *	make room in a hash index for one more entry
+ *
+ * @param[in] - h - pointer to index
+ *
+ * @return int
+ * @retval PBS_IDX_RET_OK   - success
+ * @retval PBS_IDX_RET_FAIL - failure
+ *
+ */
+static int
+hash_idx_grow(hash_idx *h)
+{
+	idx_entry *ents;
+	unsigned int nslot;
+	int size;
+
+	if (h->nents < h->size)
+		return PBS_IDX_RET_OK;
+
+	/* mostly deleted entries, squeeze them out instead of growing */
+	if (h->size > 0 && h->ndel >= h->size / 2)
+		return hash_idx_rebuild(h, h->nslot);
+
+	size = h->size ? h->size * 2 : IDX_INIT_SIZE;
+	if ((ents = realloc(h->ents, size * sizeof(idx_entry))) == NULL)
+		return PBS_IDX_RET_FAIL;
+	h->ents = ents;
+
+	/* keep the table at most half full, counting deleted slots */
+	for (nslot = h->nslot ? h->nslot : 2; nslot < 2 * (unsigned int) size; nslot <<= 1)
+		;
+	if (hash_idx_rebuild(h, nslot) != PBS_IDX_RET_OK)
+		return PBS_IDX_RET_FAIL;
+	h->size = size;
+	return PBS_IDX_RET_OK;
+}
+
+/**
+ * @brief
+ *	delete the entry in given slot of a hash index
+ *
+ * @param[in] - h - pointer to index
+ * @param[in] - s - slot of entry
+ *
+ * @return void
+ *
+ */
+static void
+hash_idx_remove(hash_idx *h, int s)
+{
+	idx_entry *e = &h->ents[h->slot[s]];
+
+	free(e->key);
+	e->key = NULL;
+	e->data = NULL;
+	h->slot[s] = IDX_SLOT_DELETED;
+	if (++h->ndel == h->nents)
+		(void) hash_idx_rebuild(h, h->nslot);
+}
+
+/**
+ * @brief
+ *	find the first entry at or after given position which is not deleted
+ *
+ * @param[in] - h   - pointer to index
+ * @param[in] - pos - position in ents to start at
+ *
+ * @return int
+ * @retval >=0 - position of entry
+ * @retval -1  - no more entries
+ *
+ */
+static int
+hash_idx_live(hash_idx *h, int pos)
+{
+	for (; pos < h->nents; pos++) {
+		if (h->ents[pos].key != NULL)
+			return pos;
+	}
+	return -1;
+}
+
+/**
+ * @brief
+ *	find the first entry with sequence number at or above seq
+ *
+ * @param[in] - h   - pointer to index
+ * @param[in] - seq - sequence number
+ *
+ * @return int
+ * @retval position in ents, h->nents if there is none
+ *
+ */
+static int
+hash_idx_seek(hash_idx *h, unsigned long seq)
+{
+	int lo = 0;
+	int hi = h->nents;
+	int mid;
+
+	/* ents stay sorted by sequence number, they are only ever appended */
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (h->ents[mid].seq < seq)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/**
+ * @brief
+ *	make given entry the current entry of an iteration context
+ *
+ * @param[in] - h    - pointer to index
+ * @param[in] - pctx - pointer to context
+ * @param[in] - e    - entry
+ *
+ * @return int
+ * @retval PBS_IDX_RET_OK   - success
+ * @retval PBS_IDX_RET_FAIL - failure
+ *
+ */
+static int
+hash_idx_setctx(hash_idx *h, iter_ctx *pctx, idx_entry *e)
+{
+	size_t sz = h->keylen ? (size_t) h->keylen : strlen(e->key) + 1;
+
+	if (sz > pctx->keysz) {
+		void *key = realloc(pctx->key, sz);
+
+		if (key == NULL)
+			return PBS_IDX_RET_FAIL;
+		pctx->key = key;
+		pctx->keysz = sz;
+	}
+	memcpy(pctx->key, e->key, sz);
+	pctx->seq = e->seq;
+	pctx->gen = h->gen;
+	return PBS_IDX_RET_OK;
+}
+
+/**
+ * @brief
+ *	move an iteration context of a hash index to its next entry
+ *
+ * @param[in] - h    - pointer to index
+ * @param[in] - pctx - pointer to context
+ *
+ * @return idx_entry *
+ * @retval !NULL - next entry
+ * @retval NULL  - no more entries
+ *
+ */
+static idx_entry *
+hash_idx_next(hash_idx *h, iter_ctx *pctx)
+{
+	unsigned int hv;
+	int s;
+	int pos;
+
+	if (pctx->bykey) {
+		hv = hash_idx_hash(h, pctx->key);
+		if (pctx->gen == h->gen) {
+			s = hash_idx_probe(h, pctx->key, hv, pctx->pos + 1);
+		} else {
+			/* slots moved, walk the chain again past the current entry */
+			s = hash_idx_probe(h, pctx->key, hv, hv);
+			while (s >= 0 && h->ents[h->slot[s]].seq <= pctx->seq)
+				s = hash_idx_probe(h, pctx->key, hv, s + 1);
+		}
+		if (s < 0)
+			return NULL;
+		pctx->pos = s;
+		return &h->ents[h->slot[s]];
+	}
+
+	if (pctx->gen == h->gen)
+		pos = pctx->pos + 1;
+	else
+		pos = hash_idx_seek(h, pctx->seq + 1);
+	if ((pos = hash_idx_live(h, pos)) < 0)
+		return NULL;
+	pctx->pos = pos;
+	return &h->ents[pos];
+}
+
 /**
  * @brief
  *	Create an empty index
  *
- * @param[in] - flags  - index flags like duplicates allowed, or case insensitive compare
+ * @param[in] - flags  - index flags like duplicates allowed, case insensitive
+ *			 compare, or ordered iteration
  * @param[in] - keylen - length of key in index (can be 0 for default size)
  *
  * @return void *
@@ -66,18 +466,30 @@ typedef struct _iter_ctx {
 void *
 pbs_idx_create(int flags, int keylen)
 {
-	void *idx = NULL;
+	avl_idx *aidx;
+	hash_idx *h;
 
-	idx = malloc(sizeof(AVL_IX_DESC));
-	if (idx == NULL)
+	if (keylen < 0)
 		return NULL;
 
-	if (avl_create_index(idx, flags, keylen)) {
-		free(idx);
-		return NULL;
+	if (flags & PBS_IDX_ORDERED) {
+		aidx = malloc(sizeof(avl_idx));
+		if (aidx == NULL)
+			return NULL;
+		aidx->type = IDX_TYPE_AVL;
+		if (avl_create_index(&aidx->desc, flags & (PBS_IDX_DUPS_OK | PBS_IDX_ICASE_CMP), keylen)) {
+			free(aidx);
+			return NULL;
+		}
+		return aidx;
 	}
 
-	return idx;
+	if ((h = calloc(1, sizeof(hash_idx))) == NULL)
+		return NULL;
+	h->type = IDX_TYPE_HASH;
+	h->flags = flags;
+	h->keylen = keylen;
+	return h;
 }
 
 /**
@@ -92,11 +504,21 @@ pbs_idx_create(int flags, int keylen)
 void
 pbs_idx_destroy(void *idx)
 {
-	if (idx != NULL) {
-		avl_destroy_index(idx);
-		free(idx);
-		idx = NULL;
+	hash_idx *h = (hash_idx *) idx;
+	int i;
+
+	if (idx == NULL)
+		return;
+
+	if (IDX_TYPE(idx) == IDX_TYPE_AVL) {
+		avl_destroy_index(&((avl_idx *) idx)->desc);
+	} else {
+		for (i = 0; i < h->nents; i++)
+			free(h->ents[i].key);
+		free(h->ents);
+		free(h->slot);
 	}
+	free(idx);
 }
 
 /**
@@ -116,20 +538,51 @@ int
 pbs_idx_insert(void *idx, void *key, void *data)
 {
 	AVL_IX_REC *pkey;
+	hash_idx *h = (hash_idx *) idx;
+	idx_entry *e;
+	unsigned int hv;
+	int s;
 
 	if (idx == NULL || key == NULL)
 		return PBS_IDX_RET_FAIL;
 
-	pkey = avlkey_create(idx, key);
-	if (pkey == NULL)
-		return PBS_IDX_RET_FAIL;
+	if (IDX_TYPE(idx) == IDX_TYPE_AVL) {
+		pkey = avlkey_create(&((avl_idx *) idx)->desc, key);
+		if (pkey == NULL)
+			return PBS_IDX_RET_FAIL;
 
-	pkey->recptr = data;
-	if (avl_add_key(pkey, idx) != AVL_IX_OK) {
+		pkey->recptr = data;
+		if (avl_add_key(pkey, &((avl_idx *) idx)->desc) != AVL_IX_OK) {
+			free(pkey);
+			return PBS_IDX_RET_FAIL;
+		}
 		free(pkey);
-		return PBS_IDX_RET_FAIL;
+		return PBS_IDX_RET_OK;
+	}
+
+	/* without dups a key may be there once, with dups a key and data pair */
+	hv = hash_idx_hash(h, key);
+	if (h->nslot > 0) {
+		for (s = hash_idx_probe(h, key, hv, hv); s >= 0; s = hash_idx_probe(h, key, hv, s + 1)) {
+			if (!(h->flags & PBS_IDX_DUPS_OK) || h->ents[h->slot[s]].data == data)
+				return PBS_IDX_RET_FAIL;
+		}
 	}
-	free(pkey);
+
+	if (hash_idx_grow(h) != PBS_IDX_RET_OK)
+		return PBS_IDX_RET_FAIL;
+
+	e = &h->ents[h->nents];
+	if (h->keylen) {
+		if ((e->key = malloc(h->keylen)) == NULL)
+			return PBS_IDX_RET_FAIL;
+		memcpy(e->key, key, h->keylen);
+	} else if ((e->key = strdup(key)) == NULL)
+		return PBS_IDX_RET_FAIL;
+	e->data = data;
+	e->hash = hv;
+	e->seq = h->seq++;
+	hash_idx_place(h, h->nents++);
 	return PBS_IDX_RET_OK;
 }
 
@@ -149,17 +602,29 @@ int
 pbs_idx_delete(void *idx, void *key)
 {
 	AVL_IX_REC *pkey;
+	hash_idx *h = (hash_idx *) idx;
+	int s;
 
 	if (idx == NULL || key == NULL)
 		return PBS_IDX_RET_FAIL;
 
-	pkey = avlkey_create(idx, key);
-	if (pkey == NULL)
-		return PBS_IDX_RET_FAIL;
+	if (IDX_TYPE(idx) == IDX_TYPE_AVL) {
+		pkey = avlkey_create(&((avl_idx *) idx)->desc, key);
+		if (pkey == NULL)
+			return PBS_IDX_RET_FAIL;
+
+		pkey->recptr = NULL;
+		avl_delete_key(pkey, &((avl_idx *) idx)->desc);
+		free(pkey);
+		return PBS_IDX_RET_OK;
+	}
 
-	pkey->recptr = NULL;
-	avl_delete_key(pkey, idx);
-	free(pkey);
+	if (h->nslot > 0) {
+		unsigned int hv = hash_idx_hash(h, key);
+
+		if ((s = hash_idx_probe(h, key, hv, hv)) >= 0)
+			hash_idx_remove(h, s);
+	}
 	return PBS_IDX_RET_OK;
 }
 
@@ -179,47 +644,53 @@ int
 pbs_idx_delete_byctx(void *ctx)
 {
 	iter_ctx *pctx = (iter_ctx *) ctx;
+	hash_idx *h;
+	unsigned int mask;
+	unsigned int s;
+	int pos;
 
-	if (pctx == NULL || pctx->idx == NULL || pctx->pkey == NULL)
+	if (pctx == NULL || pctx->idx == NULL)
 		return PBS_IDX_RET_FAIL;
 
-	avl_delete_key(pctx->pkey, pctx->idx);
+	if (IDX_TYPE(pctx->idx) == IDX_TYPE_AVL) {
+		if (pctx->pkey == NULL)
+			return PBS_IDX_RET_FAIL;
+		avl_delete_key(pctx->pkey, &((avl_idx *) pctx->idx)->desc);
+		return PBS_IDX_RET_OK;
+	}
+
+	h = (hash_idx *) pctx->idx;
+	if (pctx->bykey && pctx->gen == h->gen)
+		pos = h->slot[pctx->pos];
+	else if (!pctx->bykey && pctx->gen == h->gen)
+		pos = pctx->pos;
+	else
+		pos = hash_idx_seek(h, pctx->seq);
+	if (pos < 0 || pos >= h->nents || h->ents[pos].seq != pctx->seq || h->ents[pos].key == NULL)
+		return PBS_IDX_RET_FAIL;
+
+	mask = h->nslot - 1;
+	for (s = h->ents[pos].hash & mask; h->slot[s] != pos; s = (s + 1) & mask)
+		;
+	hash_idx_remove(h, (int) s);
 	return PBS_IDX_RET_OK;
 }
 
 /**
  * @brief
- *	find or iterate entry in index
+ *	find or iterate entry in an avl index
  *
- * @param[in]     - idx  - pointer to index
- * @param[in/out] - key  - key of the entry
- *                         if *key is NULL then this routine will
- *                         return the first entry in index
- * @param[in/out] - data - data of the entry
- * @param[in/out] - ctx  - context to be set for iteration
- *                         can be NULL, if caller doesn't want
- *                         iteration context
- *                         if *ctx is not NULL, then this routine
- *                         will return next entry in index
- *
- * @return int
- * @retval PBS_IDX_RET_OK   - success
- * @retval PBS_IDX_RET_FAIL - failure
- *
- * @note
- * 	ctx should be free'd after use, using pbs_idx_free_ctx()
+ * @see pbs_idx_find
  *
  */
-int
-pbs_idx_find(void *idx, void **key, void **data, void **ctx)
+static int
+avl_idx_find(avl_idx *aidx, void **key, void **data, void **ctx)
 {
+	AVL_IX_DESC *idx = &aidx->desc;
 	iter_ctx *pctx;
 	AVL_IX_REC *pkey;
 	int rc = AVL_IX_FAIL;
 
-	if (idx == NULL || data == NULL)
-		return PBS_IDX_RET_FAIL;
-
 	if (ctx != NULL && *ctx != NULL) {
 		pctx = (iter_ctx *) *ctx;
 
@@ -227,10 +698,10 @@ pbs_idx_find(void *idx, void **key, void **data, void **ctx)
 		if (key)
 			*key = NULL;
 
-		if (pctx->idx != idx || pctx->pkey == NULL)
+		if (pctx->idx != aidx || pctx->pkey == NULL)
 			return PBS_IDX_RET_FAIL;
 
-		if (avl_next_key(pctx->pkey, pctx->idx) != AVL_IX_OK)
+		if (avl_next_key(pctx->pkey, idx) != AVL_IX_OK)
 			return PBS_IDX_RET_FAIL;
 
 		*data = pctx->pkey->recptr;
@@ -256,12 +727,12 @@ pbs_idx_find(void *idx, void **key, void **data, void **ctx)
 			if (key != NULL && *key == NULL)
 				*key = &pkey->key;
 			if (ctx != NULL) {
-				pctx = (iter_ctx *) malloc(sizeof(iter_ctx));
+				pctx = (iter_ctx *) calloc(1, sizeof(iter_ctx));
 				if (pctx == NULL) {
 					free(pkey);
 					return PBS_IDX_RET_FAIL;
 				}
-				pctx->idx = idx;
+				pctx->idx = aidx;
 				pctx->pkey = pkey;
 				*ctx = (void *) pctx;
 
@@ -274,6 +745,107 @@ pbs_idx_find(void *idx, void **key, void **data, void **ctx)
 	return rc == AVL_IX_OK ? PBS_IDX_RET_OK : PBS_IDX_RET_FAIL;
 }
 
+/**
+ * @brief
+ *	find or iterate entry in index
+ *
+ * @param[in]     - idx  - pointer to index
+ * @param[in/out] - key  - key of the entry
+ *                         if *key is NULL then this routine will
+ *                         return the first entry in index
+ * @param[in/out] - data - data of the entry
+ * @param[in/out] - ctx  - context to be set for iteration
+ *                         can be NULL, if caller doesn't want
+ *                         iteration context
+ *                         if *ctx is not NULL, then this routine
+ *                         will return next entry in index
+ *
+ * @return int
+ * @retval PBS_IDX_RET_OK   - success
+ * @retval PBS_IDX_RET_FAIL - failure
+ *
+ * @note
+ * 	ctx should be free'd after use, using pbs_idx_free_ctx()
+ *
+ * @note
+ *	Unless the index was created with PBS_IDX_ORDERED, a walk started
+ *	without a key returns entries in insertion order, and a walk started
+ *	at a key only returns the entries with that key.
+ *
+ */
+int
+pbs_idx_find(void *idx, void **key, void **data, void **ctx)
+{
+	hash_idx *h = (hash_idx *) idx;
+	iter_ctx *pctx;
+	idx_entry *e = NULL;
+	unsigned int hv = 0;
+	int s = -1;
+	int pos = -1;
+
+	if (idx == NULL || data == NULL)
+		return PBS_IDX_RET_FAIL;
+
+	if (IDX_TYPE(idx) == IDX_TYPE_AVL)
+		return avl_idx_find((avl_idx *) idx, key, data, ctx);
+
+	*data = NULL;
+	if (ctx != NULL && *ctx != NULL) {
+		pctx = (iter_ctx *) *ctx;
+
+		if (key)
+			*key = NULL;
+
+		if (pctx->idx != idx || pctx->key == NULL)
+			return PBS_IDX_RET_FAIL;
+
+		if ((e = hash_idx_next(h, pctx)) == NULL)
+			return PBS_IDX_RET_FAIL;
+
+		if (hash_idx_setctx(h, pctx, e) != PBS_IDX_RET_OK)
+			return PBS_IDX_RET_FAIL;
+		*data = e->data;
+		if (key)
+			*key = pctx->key;
+
+		return PBS_IDX_RET_OK;
+	}
+
+	if (h->nslot == 0)
+		return PBS_IDX_RET_FAIL;
+
+	if (key != NULL && *key != NULL) {
+		hv = hash_idx_hash(h, *key);
+		if ((s = hash_idx_probe(h, *key, hv, hv)) < 0)
+			return PBS_IDX_RET_FAIL;
+		e = &h->ents[h->slot[s]];
+	} else {
+		if ((pos = hash_idx_live(h, 0)) < 0)
+			return PBS_IDX_RET_FAIL;
+		e = &h->ents[pos];
+	}
+
+	if (ctx != NULL) {
+		pctx = (iter_ctx *) calloc(1, sizeof(iter_ctx));
+		if (pctx == NULL)
+			return PBS_IDX_RET_FAIL;
+		pctx->idx = idx;
+		pctx->bykey = (s >= 0);
+		pctx->pos = (s >= 0) ? s : pos;
+		if (hash_idx_setctx(h, pctx, e) != PBS_IDX_RET_OK) {
+			free(pctx);
+			return PBS_IDX_RET_FAIL;
+		}
+		*ctx = (void *) pctx;
+		if (key != NULL && *key == NULL)
+			*key = pctx->key;
+	} else if (key != NULL && *key == NULL)
+		*key = e->key;
+
+	*data = e->data;
+	return PBS_IDX_RET_OK;
+}
+
 /**
  * @brief
  *	free given iteration context
@@ -289,6 +861,7 @@ pbs_idx_free_ctx(void *ctx)
 	if (ctx != NULL) {
 		iter_ctx *pctx = (iter_ctx *) ctx;
 		free(pctx->pkey);
+		free(pctx->key);
 		free(ctx);
 		ctx = NULL;
 	}
@@ -297,7 +870,7 @@ pbs_idx_free_ctx(void *ctx)
 /**
  * @brief check whether idx is empty and has no key associated with it
  * 
- * @param[in] idx - pointer to avl index
+ * @param[in] idx - pointer to index
  * 
  * @return bool
  * @retval 1 - idx is empty
@@ -306,11 +879,213 @@ pbs_idx_free_ctx(void *ctx)
 bool
 pbs_idx_is_empty(void *idx)
 {
-	void *idx_ctx = NULL;
 	char **data = NULL;
 
-	if (pbs_idx_find(idx, NULL, (void **) &data, &idx_ctx) == PBS_IDX_RET_OK)
+	if (idx != NULL && IDX_TYPE(idx) == IDX_TYPE_HASH)
+		return (((hash_idx *) idx)->nents == ((hash_idx *) idx)->ndel);
+
+	if (pbs_idx_find(idx, NULL, (void **) &data, NULL) == PBS_IDX_RET_OK)
 		return 0;
 
 	return 1;
 }
+
+/*
+ * Fixed key index
+ *
+ * A case-insensitive perfect hash over a set of keys known up front, such
+ * as the names in an attribute or resource definition table.  Keys are
+ * spread over buckets by a first hash, and each bucket gets the seed of a
+ * second hash that puts all its keys in free slots ("hash and displace").
+ * A lookup is then two hashes and one string compare, with no allocation.
+ */
+typedef struct _fixed_idx {
+	char **keys;	       /* the keys, by position */
+	unsigned int nbucket;  /* number of buckets, a power of 2 */
+	unsigned int nslot;    /* number of slots, a power of 2 */
+	unsigned int *disp;    /* second hash seed for each bucket */
+	int *slot;	       /* key position in each slot, -1 if empty */
+} fixed_idx;
+
+#define FIXED_IDX_BASE 2166136261U /* FNV-1a offset basis, bucket hash seed */
+#define FIXED_IDX_MAXTRY 100000	   /* seeds tried before giving up on a bucket */
+
+/**
+ * @brief
+ *	case-insensitive FNV-1a hash of a key
+ *
+ * @param[in] - key  - key to hash
+ * @param[in] - seed - starting value
+ *
+ * @return unsigned int
+ *
+ */
+static unsigned int
+fixed_idx_hash(const char *key, unsigned int seed)
+{
+	unsigned int h = seed;
+
+	for (; *key; key++)
+		h = (h ^ (unsigned char) tolower((unsigned char) *key)) * 16777619U;
+	return h;
+}
+
+/**
+ * @brief
+ *	Create a fixed key index over the given keys
+ *
+ * @param[in] - keys  - array of keys, NULL entries are skipped.  The key
+ *			strings are not copied and must outlive the index.
+ * @param[in] - nkeys - number of entries in keys
+ *
+ * @return void *
+ * @retval !NULL - success
+ * @retval NULL  - failure, including keys that differ only in case
+ *
+ */
+void *
+pbs_idx_create_fixed(char **keys, int nkeys)
+{
+	fixed_idx *fidx;
+	unsigned int *bucket = NULL;
+	unsigned int *bsize = NULL;
+	unsigned int *tryslot = NULL;
+	unsigned int maxsize = 0;
+	unsigned int b, d, size, n;
+	int i, j;
+
+	if (keys == NULL || nkeys < 0)
+		return NULL;
+
+	if ((fidx = calloc(1, sizeof(fixed_idx))) == NULL)
+		return NULL;
+	fidx->nbucket = 1;
+	while (fidx->nbucket * 2 < (unsigned int) nkeys)
+		fidx->nbucket <<= 1;
+	fidx->nslot = 2;
+	while (fidx->nslot < 2 * (unsigned int) nkeys)
+		fidx->nslot <<= 1;
+
+	fidx->keys = malloc((nkeys + 1) * sizeof(char *));
+	fidx->disp = calloc(fidx->nbucket, sizeof(unsigned int));
+	fidx->slot = malloc(fidx->nslot * sizeof(int));
+	bucket = malloc((nkeys + 1) * sizeof(unsigned int));
+	bsize = calloc(fidx->nbucket, sizeof(unsigned int));
+	tryslot = malloc((nkeys + 1) * sizeof(unsigned int));
+	if (fidx->keys == NULL || fidx->disp == NULL || fidx->slot == NULL ||
+	    bucket == NULL || bsize == NULL || tryslot == NULL)
+		goto err;
+
+	for (i = 0; i < nkeys; i++)
+		fidx->keys[i] = keys[i];
+	for (n = 0; n < fidx->nslot; n++)
+		fidx->slot[n] = -1;
+	for (i = 0; i < nkeys; i++) {
+		if (keys[i] == NULL)
+			continue;
+		bucket[i] = fixed_idx_hash(keys[i], FIXED_IDX_BASE) & (fidx->nbucket - 1);
+		if (++bsize[bucket[i]] > maxsize)
+			maxsize = bsize[bucket[i]];
+	}
+
+	/* place the fullest buckets first, while most slots are free */
+	for (size = maxsize; size > 0; size--) {
+		for (b = 0; b < fidx->nbucket; b++) {
+			if (bsize[b] != size)
+				continue;
+			for (d = 1; d <= FIXED_IDX_MAXTRY; d++) {
+				unsigned int seed = FIXED_IDX_BASE ^ (d * 0x9e3779b9U);
+
+				for (n = 0, i = 0; i < nkeys && n < size; i++) {
+					if (keys[i] == NULL || bucket[i] != b)
+						continue;
+					tryslot[n] = fixed_idx_hash(keys[i], seed) & (fidx->nslot - 1);
+					if (fidx->slot[tryslot[n]] != -1)
+						break;
+					for (j = 0; j < (int) n; j++) {
+						if (tryslot[j] == tryslot[n])
+							break;
+					}
+					if (j < (int) n)
+						break;
+					n++;
+				}
+				if (n == size)
+					break;
+			}
+			if (d > FIXED_IDX_MAXTRY)
+				goto err;
+			fidx->disp[b] = d;
+			for (n = 0, i = 0; i < nkeys && n < size; i++) {
+				if (keys[i] == NULL || bucket[i] != b)
+					continue;
+				fidx->slot[tryslot[n++]] = i;
+			}
+		}
+	}
+
+	free(bucket);
+	free(bsize);
+	free(tryslot);
+	return fidx;
+
+err:
+	free(bucket);
+	free(bsize);
+	free(tryslot);
+	pbs_idx_destroy_fixed(fidx);
+	return NULL;
+}
+
+/**
+ * @brief
+ *	Find a key in a fixed key index
+ *
+ * @param[in] - idx - pointer to index from pbs_idx_create_fixed()
+ * @param[in] - key - key to look for, compared without case
+ *
+ * @return int
+ * @retval >=0 - position of the key in the array the index was built from
+ * @retval -1  - not found
+ *
+ */
+int
+pbs_idx_find_fixed(void *idx, const char *key)
+{
+	fixed_idx *fidx = (fixed_idx *) idx;
+	unsigned int b;
+	int i;
+
+	if (fidx == NULL || key == NULL)
+		return -1;
+
+	b = fixed_idx_hash(key, FIXED_IDX_BASE) & (fidx->nbucket - 1);
+	if (fidx->disp[b] == 0)
+		return -1;
+	i = fidx->slot[fixed_idx_hash(key, FIXED_IDX_BASE ^ (fidx->disp[b] * 0x9e3779b9U)) & (fidx->nslot - 1)];
+	if (i < 0 || strcasecmp(fidx->keys[i], key) != 0)
+		return -1;
+	return i;
+}
+
+/**
+ * @brief
+ *	destroy a fixed key index
+ *
+ * @param[in] - idx - pointer to index
+ *
+ * @return void
+ *
+ */
+void
+pbs_idx_destroy_fixed(void *idx)
+{
+	fixed_idx *fidx = (fixed_idx *) idx;
+
+	if (fidx == NULL)
+		return;
+	free(fidx->keys);
+	free(fidx->disp);
+	free(fidx->slot);
+	free(fidx);
+}
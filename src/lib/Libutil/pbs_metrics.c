@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+
+/**
+ * @file	pbs_metrics.c
+ *
+ * @brief
+ *	Reporting helpers for the latency histograms of pbs_metrics.h
+ */
+#include <pbs_config.h> /* the master config generated by configure */
+
+#include <stdio.h>
+#include <string.h>
+#include "pbs_metrics.h"
+
+/**
+ * @brief
+ *	Upper bound of a histogram bucket in microseconds
+ */
+static unsigned long long
+bucket_limit(int i)
+{
+	return (i == 0) ? 0 : (1ULL << i) - 1;
+}
+
+/**
+ * @brief
+ *	Estimate a quantile of a histogram
+ *
+ * @param[in]	h	- the histogram
+ * @param[in]	q	- the quantile, 0.0 to 1.0
+ *
+ * @return	unsigned long long
+ * @retval	upper bound of the bucket holding the quantile, capped at the
+ *		largest sample, in microseconds; 0 for an empty histogram
+ */
+unsigned long long
+pbs_hist_quantile(const pbs_hist_t *h, double q)
+{
+	unsigned long want;
+	unsigned long seen = 0;
+	int i;
+
+	if (h->count == 0)
+		return 0;
+	want = (unsigned long) (q * h->count + 0.5);
+	if (want == 0)
+		want = 1;
+	for (i = 0; i < PBS_HIST_NBUCKETS; i++) {
+		seen += h->bucket[i];
+		if (seen >= want)
+			break;
+	}
+	if (i == PBS_HIST_NBUCKETS || bucket_limit(i) > h->max_us)
+		return h->max_us;
+	return bucket_limit(i);
+}
+
+/**
+ * @brief
+ *	Add the samples of one histogram to another
+ *
+ * @param[in,out]	to	- histogram added to
+ * @param[in]		from	- histogram added
+ */
+void
+pbs_hist_merge(pbs_hist_t *to, const pbs_hist_t *from)
+{
+	int i;
+
+	for (i = 0; i < PBS_HIST_NBUCKETS; i++)
+		to->bucket[i] += from->bucket[i];
+	to->count += from->count;
+	to->sum_us += from->sum_us;
+	if (from->max_us > to->max_us)
+		to->max_us = from->max_us;
+}
+
+/**
+ * @brief
+ *	Write a histogram as a JSON object, the non-empty buckets keyed by
+ *	their upper bound in microseconds
+ *
+ * @param[in]	fp	- stream to write to
+ * @param[in]	h	- the histogram
+ *
+ * @return	int
+ * @retval	0	- success
+ * @retval	-1	- write error
+ */
+int
+pbs_hist_print_json(FILE *fp, const pbs_hist_t *h)
+{
+	int i;
+	int first = 1;
+
+	fprintf(fp, "{\"count\": %lu, \"sum_us\": %llu, \"max_us\": %llu, "
+		    "\"p50_us\": %llu, \"p99_us\": %llu, \"buckets\": {",
+		h->count, h->sum_us, h->max_us,
+		pbs_hist_quantile(h, 0.5), pbs_hist_quantile(h, 0.99));
+	for (i = 0; i < PBS_HIST_NBUCKETS; i++) {
+		if (h->bucket[i] == 0)
+			continue;
+		if (i == PBS_HIST_NBUCKETS - 1)
+			fprintf(fp, "%s\"inf\": %lu", first ? "" : ", ", h->bucket[i]);
+		else
+			fprintf(fp, "%s\"%llu\": %lu", first ? "" : ", ", bucket_limit(i), h->bucket[i]);
+		first = 0;
+	}
+	fprintf(fp, "}}");
+	return ferror(fp) ? -1 : 0;
+}
+
+/**
+ * @brief
+ *	Format a one line summary of a histogram:
+ *	"<count>/<mean>/<p50>/<p99>/<max>", times in microseconds
+ *
+ * @param[out]	buf	- buffer to format into
+ * @param[in]	len	- size of buf
+ * @param[in]	h	- the histogram
+ *
+ * @return	int
+ * @retval	number of characters formatted, as snprintf()
+ */
+int
+pbs_hist_summary(char *buf, size_t len, const pbs_hist_t *h)
+{
+	return snprintf(buf, len, "%lu/%llu/%llu/%llu/%llu", h->count,
+			h->count ? h->sum_us / h->count : 0,
+			pbs_hist_quantile(h, 0.5), pbs_hist_quantile(h, 0.99), h->max_us);
+}
+
+/**
+ * @brief
+ *	Write a histogram in the Prometheus text exposition format, as
+ *	cumulative "<name>_bucket" lines with the bucket bounds in seconds,
+ *	followed by "<name>_sum" and "<name>_count"
+ *
+ * @param[in]	fp	- stream to write to
+ * @param[in]	name	- metric name
+ * @param[in]	labels	- extra labels, e.g. "type=\"42\"", or NULL
+ * @param[in]	h	- the histogram
+ *
+ * @return	int
+ * @retval	0	- success
+ * @retval	-1	- write error
+ */
+int
+pbs_hist_print_prom(FILE *fp, const char *name, const char *labels, const pbs_hist_t *h)
+{
+	unsigned long cum = 0;
+	const char *sep = (labels && *labels) ? "," : "";
+	int i;
+
+	if (labels == NULL)
+		labels = "";
+	for (i = 0; i < PBS_HIST_NBUCKETS - 1; i++) {
+		cum += h->bucket[i];
+		fprintf(fp, "%s_bucket{%s%sle=\"%g\"} %lu\n", name, labels, sep,
+			bucket_limit(i) / 1e6, cum);
+	}
+	fprintf(fp, "%s_bucket{%s%sle=\"+Inf\"} %lu\n", name, labels, sep, h->count);
+	if (*labels) {
+		fprintf(fp, "%s_sum{%s} %g\n", name, labels, h->sum_us / 1e6);
+		fprintf(fp, "%s_count{%s} %lu\n", name, labels, h->count);
+	} else {
+		fprintf(fp, "%s_sum %g\n", name, h->sum_us / 1e6);
+		fprintf(fp, "%s_count %lu\n", name, h->count);
+	}
+	return ferror(fp) ? -1 : 0;
+}
@@ -0,0 +1,258 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+
+/**
+ * @file	pbs_metrics_export.c
+ *
+ * @brief
+ *	Optional read-only metrics endpoint for the daemons.
+ *
+ * @par
+ *	A daemon builds a text snapshot of its metrics on its own main thread
+ *	and hands it to pbs_metrics_export_publish().  A single thread started
+ *	by pbs_metrics_export_start() accepts connections on a Unix domain
+ *	socket and writes the last published snapshot to each client.  The
+ *	thread never touches daemon state, so a slow or stuck client can not
+ *	stall the daemon.  A request starting with "GET" gets an HTTP/1.0
+ *	response so the endpoint can be scraped with
+ *	"curl --unix-socket <path> http://localhost/metrics".
+ */
+#include <pbs_config.h> /* the master config generated by configure */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "pbs_metrics.h"
+
+static pthread_mutex_t export_lock = PTHREAD_MUTEX_INITIALIZER;
+static char *export_text = NULL; /* last published snapshot */
+static int export_sock = -1;
+
+/**
+ * @brief
+ *	Write a buffer fully to a socket
+ *
+ * @return	int
+ * @retval	0	- success
+ * @retval	-1	- failure or timeout
+ */
+static int
+export_write(int fd, const char *buf, size_t len)
+{
+	ssize_t n;
+
+	while (len > 0) {
+		n = write(fd, buf, len);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		buf += n;
+		len -= n;
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *	Answer one client with a copy of the current snapshot
+ *
+ * @param[in]	fd	- the accepted connection
+ */
+static void
+export_serve(int fd)
+{
+	struct pollfd pfd;
+	struct timeval tv = {5, 0};
+	char req[256];
+	char hdr[128];
+	ssize_t n = 0;
+	char *text;
+	size_t len;
+
+	(void) setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+	/* a plain client may connect and just read, give it a moment to talk */
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	if (poll(&pfd, 1, 100) == 1)
+		n = read(fd, req, sizeof(req) - 1);
+	if (n < 0)
+		n = 0;
+	req[n] = '\0';
+
+	pthread_mutex_lock(&export_lock);
+	text = strdup(export_text ? export_text : "");
+	pthread_mutex_unlock(&export_lock);
+	if (text == NULL)
+		return;
+	len = strlen(text);
+
+	if (strncmp(req, "GET", 3) == 0) {
+		snprintf(hdr, sizeof(hdr), "HTTP/1.0 200 OK\r\n"
+					   "Content-Type: text/plain; version=0.0.4\r\n"
+					   "Content-Length: %lu\r\n\r\n",
+			 (unsigned long) len);
+		if (export_write(fd, hdr, strlen(hdr)) != 0) {
+			free(text);
+			return;
+		}
+	}
+	(void) export_write(fd, text, len);
+	free(text);
+}
+
+/**
+ * @brief
+ *	Body of the export thread, serves clients one at a time
+ */
+static void *
+export_thread(void *arg)
+{
+	int fd;
+
+	for (;;) {
+		fd = accept(export_sock, NULL, NULL);
+		if (fd < 0) {
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			sleep(1);
+			continue;
+		}
+		export_serve(fd);
+		close(fd);
+	}
+	return NULL;
+}
+
+/**
+ * @brief
+ *	Create the metrics socket and start the thread serving it
+ *
+ * @param[in]	path	- path of the Unix domain socket, an existing
+ *			  socket at the path is replaced
+ *
+ * @return	int
+ * @retval	0	- success
+ * @retval	-1	- failure, errno is set
+ */
+int
+pbs_metrics_export_start(const char *path)
+{
+	struct sockaddr_un addr;
+	pthread_t tid;
+	pthread_attr_t attr;
+	sigset_t all;
+	sigset_t old;
+	int rc;
+	int sock;
+
+	if (export_sock != -1)
+		return 0;
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+
+	sock = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (sock < 0)
+		return -1;
+	(void) fcntl(sock, F_SETFD, FD_CLOEXEC);
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+	(void) unlink(path);
+	if (bind(sock, (struct sockaddr *) &addr, sizeof(addr)) != 0 ||
+	    chmod(path, 0660) != 0 || listen(sock, 16) != 0) {
+		rc = errno;
+		close(sock);
+		errno = rc;
+		return -1;
+	}
+	export_sock = sock;
+
+	/* the daemon's signals must be delivered to its main thread only */
+	sigfillset(&all);
+	pthread_sigmask(SIG_SETMASK, &all, &old);
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	rc = pthread_create(&tid, &attr, export_thread, NULL);
+	pthread_attr_destroy(&attr);
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+	if (rc != 0) {
+		close(sock);
+		(void) unlink(path);
+		export_sock = -1;
+		errno = rc;
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *	Replace the snapshot served by the export thread
+ *
+ * @param[in]	text	- malloc'ed snapshot, ownership passes to this
+ *			  function; NULL serves an empty snapshot
+ */
+void
+pbs_metrics_export_publish(char *text)
+{
+	char *old;
+
+	pthread_mutex_lock(&export_lock);
+	old = export_text;
+	export_text = text;
+	pthread_mutex_unlock(&export_lock);
+	free(old);
+}
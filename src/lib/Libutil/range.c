@@ -41,6 +41,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <limits.h>
 #include <errno.h>
 #include <string.h>
 #include <log.h>
@@ -811,3 +812,332 @@ range_join(range *r1_in, range *r2_in)
 	free_range_list(r2);
 	return r3;
 }
+
+#define RS_WORD_BITS (sizeof(unsigned long) * CHAR_BIT)
+#define RS_NWORDS(n) (((n) + RS_WORD_BITS - 1) / RS_WORD_BITS)
+#define RS_WORD(s) ((s) / RS_WORD_BITS)
+#define RS_MASK(s) (1UL << ((s) % RS_WORD_BITS))
+
+/**
+ * @brief
+ *		new_range_set - allocate an empty set over the domain start-end:step
+ *
+ * @param[in]	start	-	first index of the domain
+ * @param[in]	end	-	last index of the domain
+ * @param[in]	step	-	stride between domain indices
+ *
+ * @return	newly allocated range set
+ * @retval	NULL	: on error
+ *
+ */
+range_set *
+new_range_set(int start, int end, int step)
+{
+	range_set *rs;
+
+	if (step < 1 || end < start)
+		return NULL;
+
+	if ((rs = malloc(sizeof(range_set))) == NULL) {
+		log_err(errno, __func__, RANGE_MEM_ERR_MSG);
+		return NULL;
+	}
+
+	rs->start = start;
+	rs->step = step;
+	rs->nslots = (end - start) / step + 1;
+	rs->end = start + (rs->nslots - 1) * step;
+	rs->count = 0;
+	rs->str = NULL;
+	rs->str_size = 0;
+	rs->str_stale = 1;
+	if ((rs->bits = calloc(RS_NWORDS(rs->nslots), sizeof(unsigned long))) == NULL) {
+		log_err(errno, __func__, RANGE_MEM_ERR_MSG);
+		free(rs);
+		return NULL;
+	}
+
+	return rs;
+}
+
+/**
+ * @brief
+ *		free_range_set - free a range set
+ *
+ * @param[in,out]	rs	-	range set to be freed, may be NULL
+ *
+ * @return	nothing
+ *
+ */
+void
+free_range_set(range_set *rs)
+{
+	if (rs == NULL)
+		return;
+
+	free(rs->bits);
+	free(rs->str);
+	free(rs);
+}
+
+/**
+ * @brief
+ *		range_set_slot - map a value to its bit in the set
+ *
+ * @return	int
+ * @retval	bit number of val
+ * @retval	-1	: val is not in the domain of the set
+ *
+ */
+static int
+range_set_slot(range_set *rs, int val)
+{
+	if (val < rs->start || val > rs->end)
+		return -1;
+	if ((val - rs->start) % rs->step != 0)
+		return -1;
+
+	return (val - rs->start) / rs->step;
+}
+
+/**
+ * @brief
+ *		range_set_fill - add every index of the domain to the set
+ *
+ * @param[in,out]	rs	-	range set
+ *
+ * @return	nothing
+ *
+ */
+void
+range_set_fill(range_set *rs)
+{
+	size_t nwords;
+
+	if (rs == NULL)
+		return;
+
+	nwords = RS_NWORDS(rs->nslots);
+	memset(rs->bits, 0xff, nwords * sizeof(unsigned long));
+	if (rs->nslots % RS_WORD_BITS)
+		rs->bits[nwords - 1] = RS_MASK(rs->nslots) - 1;
+	rs->count = rs->nslots;
+	rs->str_stale = 1;
+}
+
+/**
+ * @brief
+ *		range_set_add_list - add every value of a range list to the set
+ *
+ * @param[in,out]	rs	-	range set
+ * @param[in]	r	-	range list to add
+ *
+ * @return	int
+ * @retval	number of values of r which fell outside the domain of rs
+ *
+ */
+int
+range_set_add_list(range_set *rs, range *r)
+{
+	int val;
+	int outside = 0;
+
+	if (rs == NULL)
+		return 0;
+
+	for (val = range_next_value(r, -1); val >= 0; val = range_next_value(r, val))
+		if (range_set_slot(rs, val) == -1)
+			outside++;
+		else
+			range_set_add_value(rs, val);
+
+	return outside;
+}
+
+/**
+ * @brief
+ *		range_set_contains - find if a set contains a value
+ *
+ * @param[in]	rs	-	range set
+ * @param[in]	val	-	value to look for
+ *
+ * @return	int
+ * @retval	1	: val is in the set
+ * @retval	0	: val is not in the set
+ *
+ */
+int
+range_set_contains(range_set *rs, int val)
+{
+	int slot;
+
+	if (rs == NULL || (slot = range_set_slot(rs, val)) == -1)
+		return 0;
+
+	return (rs->bits[RS_WORD(slot)] & RS_MASK(slot)) != 0;
+}
+
+/**
+ * @brief
+ *		range_set_add_value - add a value to a set
+ *
+ * @param[in,out]	rs	-	range set
+ * @param[in]	val	-	value to add
+ *
+ * @return	int
+ * @retval	1	: if successfully added value
+ * @retval	0	: if val is already in the set or outside its domain
+ *
+ */
+int
+range_set_add_value(range_set *rs, int val)
+{
+	int slot;
+
+	if (rs == NULL || (slot = range_set_slot(rs, val)) == -1)
+		return 0;
+	if (rs->bits[RS_WORD(slot)] & RS_MASK(slot))
+		return 0;
+
+	rs->bits[RS_WORD(slot)] |= RS_MASK(slot);
+	rs->count++;
+	rs->str_stale = 1;
+	return 1;
+}
+
+/**
+ * @brief
+ *		range_set_remove_value - remove a value from a set
+ *
+ * @param[in,out]	rs	-	range set
+ * @param[in]	val	-	value to remove
+ *
+ * @return	int
+ * @retval	1	: on success
+ * @retval	0	: if val was not in the set
+ *
+ */
+int
+range_set_remove_value(range_set *rs, int val)
+{
+	int slot;
+
+	if (rs == NULL || (slot = range_set_slot(rs, val)) == -1)
+		return 0;
+	if (!(rs->bits[RS_WORD(slot)] & RS_MASK(slot)))
+		return 0;
+
+	rs->bits[RS_WORD(slot)] &= ~RS_MASK(slot);
+	rs->count--;
+	rs->str_stale = 1;
+	return 1;
+}
+
+/**
+ * @brief
+ *		range_set_count - number of values in a set
+ *
+ * @param[in]	rs	-	range set
+ *
+ * @return	int
+ * @retval	number of values in the set
+ *
+ */
+int
+range_set_count(range_set *rs)
+{
+	if (rs == NULL)
+		return 0;
+
+	return rs->count;
+}
+
+/**
+ * @brief
+ *		range_set_next_slot - find the next bit at or after slot whose
+ *		value is 'set', skipping whole words which hold no such bit
+ *
+ * @return	int
+ * @retval	bit number found
+ * @retval	nslots	: no such bit
+ *
+ */
+static int
+range_set_next_slot(range_set *rs, int slot, int set)
+{
+	unsigned long w;
+
+	while (slot < rs->nslots) {
+		w = rs->bits[RS_WORD(slot)];
+		if (!set)
+			w = ~w;
+		w &= ~(RS_MASK(slot) - 1);
+		if (w == 0) {
+			slot = (RS_WORD(slot) + 1) * RS_WORD_BITS;
+			continue;
+		}
+		while (!(w & RS_MASK(slot)))
+			slot++;
+		break;
+	}
+
+	return slot < rs->nslots ? slot : rs->nslots;
+}
+
+/**
+ * @brief
+ * 		Returns a string representation of a range set, in the same form
+ *		range_to_str() gives for the equivalent range list.  The string is
+ *		cached in the set and only rebuilt after the set has changed.
+ *
+ * @param[in]	rs	-	The range set for which a string representation is expected
+ *
+ * @return	a string representation of the set, owned by the set
+ * @retval	""	: if the set is empty or on any malloc error
+ *
+ */
+char *
+range_set_to_str(range_set *rs)
+{
+	char numbuf[128];
+	int len = 0;
+	int n;
+	int first;
+	int last;
+	char *tmp;
+
+	if (rs == NULL || rs->count == 0)
+		return "";
+	if (!rs->str_stale)
+		return rs->str;
+
+	for (first = range_set_next_slot(rs, 0, 1); first < rs->nslots;
+	     first = range_set_next_slot(rs, last + 1, 1)) {
+		last = range_set_next_slot(rs, first, 0) - 1;
+
+		if (last > first && rs->step > 1)
+			n = sprintf(numbuf, "%s%d-%d:%d", len ? "," : "",
+				    rs->start + first * rs->step, rs->start + last * rs->step, rs->step);
+		else if (last > first)
+			n = sprintf(numbuf, "%s%d-%d", len ? "," : "",
+				    rs->start + first * rs->step, rs->start + last * rs->step);
+		else
+			n = sprintf(numbuf, "%s%d", len ? "," : "", rs->start + first * rs->step);
+
+		if (len + n >= rs->str_size) {
+			int size = rs->str_size ? rs->str_size * 2 : INIT_RANGE_ARR_SIZE;
+
+			if ((tmp = realloc(rs->str, size)) == NULL) {
+				log_err(errno, __func__, RANGE_MEM_ERR_MSG);
+				return "";
+			}
+			rs->str = tmp;
+			rs->str_size = size;
+		}
+		memcpy(rs->str + len, numbuf, n + 1);
+		len += n;
+	}
+	rs->str_stale = 0;
+
+	return rs->str;
+}
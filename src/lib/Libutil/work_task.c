@@ -41,6 +41,13 @@
  * @file	work_task.c
  * @brief
  * work_task.c - contains functions to deal with the server's task list
+ *
+ * Timed tasks sit on a timer wheel with one slot per second for the next
+ * TASK_WHEEL_SZ seconds; tasks further out wait on task_list_timed and are
+ * moved onto the wheel as each turn of it begins.  If the clock steps back
+ * the wheel is wound back with it.  Tasks with a wt_parm1
+ * are also hashed on it, so lookups and deletions by object only look at
+ * the tasks of that object.
  */
 #include <pbs_config.h> /* the master config generated by configure */
 
@@ -53,16 +60,107 @@
 #include "server_limits.h"
 #include "list_link.h"
 #include "work_task.h"
+#include "pbs_metrics.h"
+
+#define TASK_WHEEL_SZ 1024     /* seconds covered by the timer wheel */
+#define TASK_PARM_BUCKETS 4096 /* hash buckets of tasks by wt_parm1 */
+#define TASK_PARM_HASH(p) ((((unsigned long) (p)) >> 4) % TASK_PARM_BUCKETS)
 
 /* Global Data Items: */
 
 extern pbs_list_head task_list_immed;	   /* list of tasks that can execute now */
 extern pbs_list_head task_list_interleave; /* list of tasks that can execute after interleaving other tasks */
-extern pbs_list_head task_list_timed;	   /* list of tasks that have set start times */
+extern pbs_list_head task_list_timed;	   /* list of timed tasks beyond the reach of the wheel */
 extern pbs_list_head task_list_event;	   /* list of tasks responding to an event */
 extern int svr_delay_entry;
 extern time_t time_now;
 
+static pbs_list_head task_wheel[TASK_WHEEL_SZ];	      /* timed tasks, one slot per second */
+static pbs_list_head task_list_timed_due;	      /* timed tasks whose time has been reached */
+static pbs_list_head task_parm_idx[TASK_PARM_BUCKETS]; /* tasks hashed by wt_parm1 */
+static time_t task_wheel_time;			      /* second the wheel has been run up to */
+static int task_lists_inited = 0;
+static long task_count = 0;			      /* tasks set and not yet dispatched or deleted */
+static pbs_hist_t task_lag;			      /* how late timed tasks were dispatched */
+
+static void rewind_task_wheel(void);
+
+/**
+ * @brief
+ * 	Set up the timer wheel and the wt_parm1 hash on first use
+ */
+static void
+init_task_lists(void)
+{
+	int i;
+
+	if (task_lists_inited)
+		return;
+	for (i = 0; i < TASK_WHEEL_SZ; i++)
+		CLEAR_HEAD(task_wheel[i]);
+	for (i = 0; i < TASK_PARM_BUCKETS; i++)
+		CLEAR_HEAD(task_parm_idx[i]);
+	CLEAR_HEAD(task_list_timed_due);
+	task_wheel_time = time(NULL);
+	task_lists_inited = 1;
+}
+
+/**
+ * @brief
+ * 	Put a timed task on the wheel slot for its time, on the due list if
+ *	that time has already been reached, or on task_list_timed if it is
+ *	beyond the reach of the wheel.
+ *
+ * @param[in]	ptask	- the timed task, not on any task list
+ */
+static void
+link_timed_task(struct work_task *ptask)
+{
+	long when;
+
+	if (time_now < task_wheel_time)
+		rewind_task_wheel();
+	when = ptask->wt_event;
+	if (when <= task_wheel_time)
+		append_link(&task_list_timed_due, &ptask->wt_linkevent, ptask);
+	else if (when - task_wheel_time < TASK_WHEEL_SZ)
+		append_link(&task_wheel[when % TASK_WHEEL_SZ], &ptask->wt_linkevent, ptask);
+	else
+		append_link(&task_list_timed, &ptask->wt_linkevent, ptask);
+}
+
+/**
+ * @brief
+ * 	The clock has stepped back behind the wheel: wind the wheel back to
+ *	time_now and place its tasks, and those due but not yet run, again
+ *	from there, so that none runs before its time.  Tasks on
+ *	task_list_timed are even further out and stay where they are.
+ */
+static void
+rewind_task_wheel(void)
+{
+	pbs_list_head moved;
+	struct work_task *ptask;
+	int i;
+
+	CLEAR_HEAD(moved);
+	for (i = 0; i < TASK_WHEEL_SZ; i++) {
+		while ((ptask = (struct work_task *) GET_NEXT(task_wheel[i])) != NULL) {
+			delete_link(&ptask->wt_linkevent);
+			append_link(&moved, &ptask->wt_linkevent, ptask);
+		}
+	}
+	while ((ptask = (struct work_task *) GET_NEXT(task_list_timed_due)) != NULL) {
+		delete_link(&ptask->wt_linkevent);
+		append_link(&moved, &ptask->wt_linkevent, ptask);
+	}
+	task_wheel_time = time_now;
+	while ((ptask = (struct work_task *) GET_NEXT(moved)) != NULL) {
+		delete_link(&ptask->wt_linkevent);
+		link_timed_task(ptask);
+	}
+}
+
 /**
  *
  * @brief
@@ -85,7 +183,8 @@ struct work_task *
 set_task(enum work_type type, long event_id, void (*func)(struct work_task *), void *parm)
 {
 	struct work_task *pnew;
-	struct work_task *pold;
+
+	init_task_lists();
 
 	pnew = (struct work_task *) malloc(sizeof(struct work_task));
 	if (pnew == NULL)
@@ -93,6 +192,7 @@ set_task(enum work_type type, long event_id, void (*func)(struct work_task *), v
 	CLEAR_LINK(pnew->wt_linkevent);
 	CLEAR_LINK(pnew->wt_linkobj);
 	CLEAR_LINK(pnew->wt_linkobj2);
+	CLEAR_LINK(pnew->wt_linkparm);
 	pnew->wt_event = event_id;
 	pnew->wt_event2 = NULL;
 	pnew->wt_type = type;
@@ -103,24 +203,22 @@ set_task(enum work_type type, long event_id, void (*func)(struct work_task *), v
 	pnew->wt_aux = 0;
 	pnew->wt_aux2 = 0;
 
-	if (type == WORK_Immed)
+	if (type == WORK_Immed) {
+		pnew->wt_list = WORK_Immed;
 		append_link(&task_list_immed, &pnew->wt_linkevent, pnew);
-	else if (type == WORK_Interleave)
+	} else if (type == WORK_Interleave) {
+		pnew->wt_list = WORK_Interleave;
 		append_link(&task_list_interleave, &pnew->wt_linkevent, pnew);
-	else if (type == WORK_Timed) {
-		pold = (struct work_task *) GET_NEXT(task_list_timed);
-		while (pold) {
-			if (pold->wt_event > pnew->wt_event)
-				break;
-			pold = (struct work_task *) GET_NEXT(pold->wt_linkevent);
-		}
-		if (pold)
-			insert_link(&pold->wt_linkevent, &pnew->wt_linkevent, pnew,
-				    LINK_INSET_BEFORE);
-		else
-			append_link(&task_list_timed, &pnew->wt_linkevent, pnew);
-	} else
+	} else if (type == WORK_Timed) {
+		pnew->wt_list = WORK_Timed;
+		link_timed_task(pnew);
+	} else {
+		pnew->wt_list = WORK_Deferred_Other;
 		append_link(&task_list_event, &pnew->wt_linkevent, pnew);
+	}
+	if (parm != NULL)
+		append_link(&task_parm_idx[TASK_PARM_HASH(parm)], &pnew->wt_linkparm, pnew);
+	task_count++;
 	return (pnew);
 }
 
@@ -139,25 +237,26 @@ set_task(enum work_type type, long event_id, void (*func)(struct work_task *), v
 int
 convert_work_task(struct work_task *ptask, enum work_type wtype)
 {
-	pbs_list_head *list;
-
 	if (!ptask)
 		return -1;
 
+	init_task_lists();
+	delete_link(&ptask->wt_linkevent);
+
 	switch (wtype) {
 		case WORK_Immed:
-			list = &task_list_immed;
+			ptask->wt_list = WORK_Immed;
+			append_link(&task_list_immed, &ptask->wt_linkevent, ptask);
 			break;
 		case WORK_Timed:
-			list = &task_list_timed;
+			ptask->wt_list = WORK_Timed;
+			link_timed_task(ptask);
 			break;
 		default:
-			list = &task_list_event;
+			ptask->wt_list = WORK_Deferred_Other;
+			append_link(&task_list_event, &ptask->wt_linkevent, ptask);
 	}
 
-	delete_link(&ptask->wt_linkevent);
-	append_link(list, &ptask->wt_linkevent, ptask);
-
 	return 0;
 }
 
@@ -180,6 +279,8 @@ dispatch_task(struct work_task *ptask)
 	delete_link(&ptask->wt_linkevent);
 	delete_link(&ptask->wt_linkobj);
 	delete_link(&ptask->wt_linkobj2);
+	delete_link(&ptask->wt_linkparm);
+	task_count--;
 	if (ptask->wt_func)
 		ptask->wt_func(ptask); /* dispatch process function */
 	(void) free(ptask);
@@ -199,9 +300,47 @@ delete_task(struct work_task *ptask)
 	delete_link(&ptask->wt_linkobj);
 	delete_link(&ptask->wt_linkobj2);
 	delete_link(&ptask->wt_linkevent);
+	delete_link(&ptask->wt_linkparm);
+	task_count--;
 	(void) free(ptask);
 }
 
+/**
+ * @brief
+ * 	Dispatch a timed task, recording how far past its time it ran
+ *
+ * @param[in]	ptask	- the timed task
+ */
+static void
+dispatch_timed_task(struct work_task *ptask)
+{
+	long late = time_now - ptask->wt_event;
+
+	pbs_hist_add(&task_lag, (late > 0) ? (unsigned long long) late * 1000000ULL : 0);
+	dispatch_task(ptask);
+}
+
+/**
+ * @brief
+ * 	Number of work tasks of any kind waiting to be dispatched
+ */
+long
+work_task_backlog(void)
+{
+	return task_count;
+}
+
+/**
+ * @brief
+ * 	Histogram of how late timed tasks were dispatched, in whole seconds
+ *	as timed tasks are only run once a second
+ */
+const struct pbs_hist *
+work_task_lag(void)
+{
+	return &task_lag;
+}
+
 /**
  * @brief
  *	Check if some task in the specified task list
@@ -217,12 +356,12 @@ delete_task(struct work_task *ptask)
  * @retval	NULL otherwise
  */
 static struct work_task *
-find_worktask_by_parm_func(pbs_list_head task_list, void *parm1, void *func)
+find_worktask_by_parm_func(pbs_list_head *task_list, void *parm1, void *func)
 {
 	struct work_task *ptask;
 	struct work_task *ptask_next;
 
-	for (ptask = GET_NEXT(task_list); ptask; ptask = ptask_next) {
+	for (ptask = GET_NEXT(*task_list); ptask; ptask = ptask_next) {
 		ptask_next = GET_NEXT(ptask->wt_linkevent);
 
 		if (parm1 && (ptask->wt_parm1 != parm1))
@@ -236,6 +375,59 @@ find_worktask_by_parm_func(pbs_list_head task_list, void *parm1, void *func)
 	return NULL;
 }
 
+/**
+ * @brief
+ *	Find a task on one kind of task list with a wt_parm1 matching 'parm1'
+ *	and wt_func matching 'func'.  With a 'parm1', only the tasks hashed
+ *	on it are looked at, otherwise the whole list is searched.
+ *
+ * @param[in]	list	- WORK_Immed, WORK_Timed or WORK_Deferred_Other for
+ *			  task_list_event
+ * @param[in]	parm1	- parameter being matched. NULL to ignore this field.
+ * @param[in]	func	- function being matched. NULL to ignore this field.
+ *
+ * @return work task
+ * @retval	!NULL if 'parm1' and 'func' was matched
+ * @retval	NULL otherwise
+ */
+static struct work_task *
+find_task_on_list(enum work_type list, void *parm1, void *func)
+{
+	struct work_task *ptask;
+	int i;
+
+	if (parm1 != NULL) {
+		for (ptask = GET_NEXT(task_parm_idx[TASK_PARM_HASH(parm1)]); ptask;
+		     ptask = GET_NEXT(ptask->wt_linkparm)) {
+			if ((ptask->wt_parm1 != parm1) || (ptask->wt_list != list))
+				continue;
+			if (func && (ptask->wt_func != func))
+				continue;
+			/* skip tasks the caller took off the task lists */
+			if (ptask->wt_linkevent.ll_next == &ptask->wt_linkevent)
+				continue;
+			return ptask;
+		}
+		return NULL;
+	}
+
+	switch (list) {
+		case WORK_Immed:
+			return find_worktask_by_parm_func(&task_list_immed, NULL, func);
+		case WORK_Timed:
+			if ((ptask = find_worktask_by_parm_func(&task_list_timed_due, NULL, func)) != NULL)
+				return ptask;
+			for (i = 1; i <= TASK_WHEEL_SZ; i++) {
+				ptask = find_worktask_by_parm_func(&task_wheel[(task_wheel_time + i) % TASK_WHEEL_SZ], NULL, func);
+				if (ptask)
+					return ptask;
+			}
+			return find_worktask_by_parm_func(&task_list_timed, NULL, func);
+		default:
+			return find_worktask_by_parm_func(&task_list_event, NULL, func);
+	}
+}
+
 /**
  * @brief
  *	Check if some task in in any of the task lists (task_list_event,
@@ -256,20 +448,22 @@ find_work_task(enum work_type wtype, void *parm1, void *func)
 {
 	struct work_task *ptask;
 
+	init_task_lists();
+
 	if (wtype == -1 || wtype == WORK_Immed) {
-		ptask = find_worktask_by_parm_func(task_list_immed, parm1, func);
+		ptask = find_task_on_list(WORK_Immed, parm1, func);
 		if (ptask)
 			return ptask;
 	}
 
 	if (wtype == -1 || wtype == WORK_Timed) {
-		ptask = find_worktask_by_parm_func(task_list_timed, parm1, func);
+		ptask = find_task_on_list(WORK_Timed, parm1, func);
 		if (ptask)
 			return ptask;
 	}
 
 	if (wtype == -1 || (wtype != WORK_Timed && wtype != WORK_Immed)) {
-		ptask = find_worktask_by_parm_func(task_list_event, parm1, func);
+		ptask = find_task_on_list(WORK_Deferred_Other, parm1, func);
 		if (ptask)
 			return ptask;
 	}
@@ -296,22 +490,16 @@ void
 delete_task_by_parm1_func(void *parm1, void (*func)(struct work_task *), enum wtask_delete_option option)
 {
 	struct work_task *ptask;
-	struct work_task *ptask_next;
-	pbs_list_head task_lists[] = {task_list_event, task_list_timed, task_list_immed};
+	enum work_type task_lists[] = {WORK_Deferred_Other, WORK_Timed, WORK_Immed};
 	int i;
 
 	if (parm1 == NULL && func == NULL)
 		return;
 
-	for (i = 0; i < 3; i++) {
-		for (ptask = (struct work_task *) GET_NEXT(task_lists[i]); ptask; ptask = ptask_next) {
-			ptask_next = (struct work_task *) GET_NEXT(ptask->wt_linkevent);
-
-			if ((parm1 != NULL) && (ptask->wt_parm1 != parm1))
-				continue;
-			if ((func != NULL) && (ptask->wt_func != func))
-				continue;
+	init_task_lists();
 
+	for (i = 0; i < 3; i++) {
+		while ((ptask = find_task_on_list(task_lists[i], parm1, func)) != NULL) {
 			delete_task(ptask);
 			if (option == DELETE_ONE)
 				return;
@@ -363,6 +551,8 @@ default_next_task(void)
 	struct work_task *nxt;
 	struct work_task *ptask;
 	struct work_task *last_interleave_task;
+	pbs_list_head *slot;
+	int i;
 	/*
 	 * tilwhen is the basic "idle" time if there is nothing pending sooner
 	 * for the Server (timed-events, call scheduler, IO)
@@ -400,13 +590,44 @@ default_next_task(void)
 		tilwhen = 0;
 	}
 
-	while ((ptask = (struct work_task *) GET_NEXT(task_list_timed)) != NULL) {
-		if ((delay = ptask->wt_event - time_now) > 0) {
-			if (tilwhen > delay)
+	init_task_lists();
+
+	if (time_now < task_wheel_time)
+		rewind_task_wheel();
+
+	/* run the wheel up to the current time, a second at a time */
+	while (task_wheel_time < time_now) {
+		task_wheel_time++;
+		if ((task_wheel_time % TASK_WHEEL_SZ) == 0) {
+			/* a new turn of the wheel, bring on the tasks now in its reach */
+			ptask = (struct work_task *) GET_NEXT(task_list_timed);
+			while (ptask) {
+				nxt = (struct work_task *) GET_NEXT(ptask->wt_linkevent);
+				if (ptask->wt_event < task_wheel_time) {
+					delete_link(&ptask->wt_linkevent);
+					link_timed_task(ptask);
+				} else if (ptask->wt_event - task_wheel_time < TASK_WHEEL_SZ) {
+					/* includes this very second, run below */
+					delete_link(&ptask->wt_linkevent);
+					append_link(&task_wheel[ptask->wt_event % TASK_WHEEL_SZ], &ptask->wt_linkevent, ptask);
+				}
+				ptask = nxt;
+			}
+		}
+		slot = &task_wheel[task_wheel_time % TASK_WHEEL_SZ];
+		while ((ptask = (struct work_task *) GET_NEXT(*slot)) != NULL)
+			dispatch_timed_task(ptask); /* will delete link */
+	}
+
+	/* tasks set for a time already passed, including by the ones above */
+	while ((ptask = (struct work_task *) GET_NEXT(task_list_timed_due)) != NULL)
+		dispatch_timed_task(ptask);
+
+	for (i = 1; i < TASK_WHEEL_SZ && (delay = task_wheel_time + i - time_now) < tilwhen; i++) {
+		if (GET_NEXT(task_wheel[(task_wheel_time + i) % TASK_WHEEL_SZ])) {
+			if (delay > 0)
 				tilwhen = delay;
 			break;
-		} else {
-			dispatch_task(ptask); /* will delete link */
 		}
 	}
 
@@ -629,11 +629,13 @@ class _queue():
             return _pbs_v1.get_job(jobid, self.name)
     #: m(job)
 
-    def jobs(self):
+    def jobs(self, state=None, owner=None, attrs=None):
         """
             Returns an iterator that loops over the list of jobs on this queue.
+            See _server.jobs() for the meaning of the optional arguments.
         """
-        return pbs_iter("jobs", "",  self.name, self._connect_server)
+        return pbs_iter("jobs", "",  self.name, self._connect_server,
+                        state, owner, attrs)
     #: m(jobs)
 
 #: C(_queue)
@@ -769,22 +771,36 @@ class _server():
                             ignore_fin, username)
         #: m(jobs_nas)
     else:
-        def jobs(self):
+        def jobs(self, queue=None, state=None, owner=None, attrs=None):
             """
             Returns an iterator that loops over the list of jobs
-            on this server.
+            on this server. Jobs are looked up one at a time as the
+            loop advances, and can be filtered by the server before
+            any Python object is built for them:
+            - queue returns jobs from that queue
+            - state returns jobs in one of the given states, e.g. "Q"
+              or "QH"
+            - owner returns jobs owned by that user
+            - attrs, a list of attribute names, populates only those
+              attributes in each job returned
             """
 
-            return pbs_iter("jobs", "",  "", self._connect_server)
+            if queue is None:
+                queue = ""
+            return pbs_iter("jobs", "",  queue, self._connect_server,
+                            state, owner, attrs)
         #: m(jobs)
 
-    def vnodes(self):
+    def vnodes(self, attrs=None):
         """
         Returns an iterator that loops over the list of vnodes
         on this server.
+        If attrs, a list of attribute names, is given only those
+        attributes are populated in each vnode returned.
         """
 
-        return pbs_iter("vnodes", "",  "", self._connect_server)
+        return pbs_iter("vnodes", "",  "", self._connect_server,
+                        pbs_attrs=attrs)
     #: m(vnodes)
 
     def queues(self):
@@ -1064,7 +1080,11 @@ class pbs_iter():
                     self.ignore_fin, self.filter_user)
     else:
         def __init__(self, pbs_obj_name, pbs_filter1,
-                     pbs_filter2, connect_server=None):
+                     pbs_filter2, connect_server=None, pbs_state=None,
+                     pbs_owner=None, pbs_attrs=None):
+
+            self.filter_state = pbs_state
+            self.filter_owner = pbs_owner
 
             self._caller = _pbs_v1.get_python_daemon_name()
             if self._caller == "pbs_python":
@@ -1124,7 +1144,25 @@ class pbs_iter():
                 self.filter2 = pbs_filter2
                 # argument 1 below tells C function we're inside __init__
                 _pbs_v1.iter_nextfunc(
-                    self, 1, pbs_obj_name, pbs_filter1, pbs_filter2)
+                    self, 1, pbs_obj_name, pbs_filter1, pbs_filter2,
+                    filter_state=pbs_state, filter_owner=pbs_owner,
+                    attrs=pbs_attrs)
+
+    def _stat_match(self, b):
+        """
+        pbs_python mode: check a job's batch status against the state
+        and owner filters of the iterator.
+        """
+        a = b.attribs
+        while(a):
+            if self.filter_state and a.name == ATTR_state:
+                if a.value not in self.filter_state:
+                    return False
+            elif self.filter_owner and a.name == ATTR_owner:
+                if a.value.split("@")[0] != self.filter_owner:
+                    return False
+            a = a.next
+        return True
 
     def __iter__(self):
         return self
@@ -1311,6 +1349,14 @@ class pbs_iter():
                 b = self.bs
                 job = None
 
+                if(self.type == "jobs"):
+                    while b and not self._stat_match(b):
+                        b = b.next
+                    if not b:
+                        pbs_disconnect(self.con)
+                        self.con = -1
+                        raise StopIteration
+
                 _pbs_v1.set_c_mode()
 
                 server_data_fp = get_server_data_fp()
@@ -97,6 +97,9 @@
 #include <string.h>
 #include <string.h>
 #include <unistd.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
 
 #include "pathnames.h"
 #include "extern.h"
@@ -158,6 +161,9 @@ int response(void);
 void rsource(char *, pbs_stat_struct *);
 void sink(int, char *[]);
 void source(int, char *[]);
+#if defined(__linux__) && !defined(CRYPT)
+static off_t_pbs send_file_data(int, off_t_pbs);
+#endif
 void tolocal(int, char *[]);
 void toremote(char *, int, char *[]);
 void usage(void);
@@ -756,7 +762,7 @@ source(int argc, char *argv[])
 #endif
 		if (response() < 0)
 			goto next;
-		if ((bp = allocbuf(&buffer, fd, RCP_BUFFER_SIZE)) == NULL) {
+		if ((bp = allocbuf(&buffer, fd, RCP_XFER_SIZE)) == NULL) {
 		next:
 			if (fd > 0)
 				(void) close(fd);
@@ -765,7 +771,11 @@ source(int argc, char *argv[])
 
 		/* Keep writing after an error so that we stay sync'd up. */
 		haderr = 0;
-		for (i = 0; i < stb.st_size; i += bp->cnt) {
+		i = 0;
+#if defined(__linux__) && !defined(CRYPT)
+		i = send_file_data(fd, stb.st_size);
+#endif
+		for (; i < stb.st_size; i += bp->cnt) {
 			amt = bp->cnt;
 			if (i + amt > stb.st_size)
 				amt = (int) (stb.st_size - i);
@@ -832,6 +842,41 @@ source(int argc, char *argv[])
 	}
 }
 
+#if defined(__linux__) && !defined(CRYPT)
+/**
+ * @brief
+ *	Send the data of an open file to the remote end with sendfile(),
+ *	so it goes from the page cache to the socket without being copied
+ *	through a user buffer.
+ *
+ * @param[in]	fd - the file, positioned at its start
+ * @param[in]	size - number of bytes to send
+ *
+ * @return off_t_pbs
+ * @retval	number of bytes sent, the file offset is left just past them.
+ *		When that is less than 'size', because sendfile() can not be
+ *		used on this pair of descriptors or failed, the caller sends
+ *		the rest through its buffer, which also reports any error.
+ */
+static off_t_pbs
+send_file_data(int fd, off_t_pbs size)
+{
+	off_t_pbs sent = 0;
+	ssize_t n;
+
+	while (sent < size) {
+		n = sendfile(rem, fd, NULL, (size - sent > RCP_XFER_SIZE) ? RCP_XFER_SIZE : (size_t) (size - sent));
+		if (n > 0)
+			sent += n;
+		else if ((n == -1) && (errno == EINTR))
+			continue;
+		else
+			break;
+	}
+	return (sent);
+}
+#endif
+
 /**
  *
  *  @brief Send directory information to remote host.
@@ -1182,15 +1227,15 @@ sink(int argc, char *argv[])
 		if (write(rem, "", 1) == -1) 
 			errx(-1, __func__, "write failed. ERR : %s",strerror(errno));
 #endif
-		if ((bp = allocbuf(&buffer, ofd, RCP_BUFFER_SIZE)) == NULL) {
+		if ((bp = allocbuf(&buffer, ofd, RCP_XFER_SIZE)) == NULL) {
 			(void) close(ofd);
 			continue;
 		}
 		cp = bp->buf;
 		wrerr = NO;
 		count = 0;
-		for (i = 0; i < size; i += RCP_BUFFER_SIZE) {
-			amt = RCP_BUFFER_SIZE;
+		for (i = 0; i < size; i += RCP_XFER_SIZE) {
+			amt = RCP_XFER_SIZE;
 			if (i + amt > size)
 				amt = (int) (size - i);
 			count += amt;
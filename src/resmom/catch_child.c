@@ -391,6 +391,7 @@ send_obit(job *pjob, int exval)
 	if (enqueue_update_for_send(pjob, IS_JOBOBIT) != 0)
 		log_joberr(PBSE_SYSTEM, __func__, "Failed to enque job obit", pjob->ji_qs.ji_jobid);
 	log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB, LOG_DEBUG, pjob->ji_qs.ji_jobid, "Obit sent");
+	job_sample_summary(pjob);
 }
 
 /**
@@ -682,7 +683,7 @@ scan_for_exiting(void)
 					      resc_used(pjob, "mem", getsize));
 				(void) diswul(stream,
 					      resc_used(pjob, "cpupercent", gettime));
-				(void) send_resc_used_to_ms(stream, pjob);
+				(void) send_resc_used_to_ms(stream, pjob, 0);
 				(void) dis_flush(stream);
 				pjob->ji_obit = TM_NULL_EVENT;
 			}
@@ -923,6 +924,212 @@ err:
 	return;
 }
 
+/**
+ * @brief
+ *	Take a job recovered from disk at mom start back into service:
+ *	index it, recover its tasks and abort, requeue or keep it running
+ *	as init_abort_jobs() explains.
+ *
+ * @param[in]	pj - the recovered job
+ * @param[in]	recover - recovering mode of MoM
+ * @param[in]	multinode_jobs - list of recovered multinode jobs to add to
+ *
+ * @return void
+ */
+static void
+init_recovered_job(job *pj, int recover, pbs_list_head *multinode_jobs)
+{
+	int sisters;
+	char path[MAXPATHLEN + 1];
+	char oldp[MAXPATHLEN + 1];
+	struct stat statbuf;
+	extern char *path_checkpoint;
+
+	/* To get homedir info */
+	pj->ji_grpcache = NULL;
+	check_pwd(pj);
+	if (pbs_idx_insert(jobs_idx, pj->ji_qs.ji_jobid, pj) != PBS_IDX_RET_OK) {
+		log_joberr(PBSE_INTERNAL, __func__, "Failed to add job in index during recovery", pj->ji_qs.ji_jobid);
+		job_free(pj);
+		return;
+	}
+	append_link(&svr_alljobs, &pj->ji_alljobs, pj);
+	job_nodes(pj);
+	task_recov(pj);
+
+	/*
+	 ** Check to see if a checkpoint.old dir exists.
+	 ** If so, remove the regular checkpoint dir
+	 ** and rename the old to the regular name.
+	 */
+	pbs_strncpy(path, path_checkpoint, sizeof(path));
+	if (*pj->ji_qs.ji_fileprefix != '\0')
+		strcat(path, pj->ji_qs.ji_fileprefix);
+	else
+		strcat(path, pj->ji_qs.ji_jobid);
+	strcat(path, JOB_CKPT_SUFFIX);
+	strcpy(oldp, path);
+	strcat(oldp, ".old");
+
+	if (stat(oldp, &statbuf) == 0) {
+		(void) remtree(path);
+		if (rename(oldp, path) == -1)
+			(void) remtree(oldp);
+	}
+
+	/*
+	 ** Check to see if I am Mother Superior.  The
+	 ** JOB_SVFLG_HERE flag is overloaded for MOM
+	 ** for this purpose.
+	 */
+	if ((pj->ji_qs.ji_svrflags & JOB_SVFLG_HERE) == 0) {
+		/* I am sister, junk the job files */
+		if (recover != 2) {
+			mom_deljob(pj);
+			return;
+		}
+	}
+
+	sisters = pj->ji_numnodes - 1;
+	if (sisters > 0) {
+		pj->ji_resources = (noderes *) calloc(sisters,
+						      sizeof(noderes));
+		if (pj->ji_resources == NULL) {
+			log_err(ENOMEM, "init_abort_jobs", "out of memory");
+			return;
+		}
+		pj->ji_numrescs = sisters;
+	}
+
+	/*
+	 **	If mom went down during file stage ops,
+	 **	the substate should be EXITED.  Set it
+	 **	back to OBIT so the server can verify that
+	 **	it still has the job or not.
+	 */
+	if (check_job_substate(pj, JOB_SUBSTATE_EXITED)) {
+		/*
+		 ** We don't want to change the state if the
+		 ** job is checkpointed.
+		 */
+		if ((pj->ji_qs.ji_svrflags &
+		     (JOB_SVFLG_CHKPT |
+		      JOB_SVFLG_ChkptMig)) == 0) {
+			set_job_substate(pj, JOB_SUBSTATE_OBIT);
+			job_save(pj);
+		}
+	} else if (check_job_substate(pj, JOB_SUBSTATE_TERM)) {
+		/*
+		 * Mom went down while terminate action script was
+		 * running, don't know if it finished or not;  force
+		 * Mom to send/resend OBIT and lets end it
+		 */
+		if (recover)
+			(void) kill_job(pj, SIGKILL);
+		set_job_substate(pj, JOB_SUBSTATE_OBIT);
+		job_save(pj);
+	} else if ((recover != 2) &&
+		   ((check_job_substate(pj, JOB_SUBSTATE_RUNNING)) ||
+		    (check_job_substate(pj, JOB_SUBSTATE_SUSPEND)) ||
+		    (check_job_substate(pj, JOB_SUBSTATE_KILLSIS)) ||
+		    (check_job_substate(pj, JOB_SUBSTATE_RUNEPILOG)) ||
+		    (check_job_substate(pj, JOB_SUBSTATE_EXITING)))) {
+
+		if (recover)
+			(void) kill_job(pj, SIGKILL);
+
+		/* set exit status to:
+		 *   JOB_EXEC_INITABT - init abort and no chkpnt
+		 *   JOB_EXEC_INITRST - init and chkpt, no mig
+		 *   JOB_EXEC_INITRMG - init and chkpt, migrate
+		 * to indicate recovery abort
+		 */
+		if (pj->ji_qs.ji_svrflags &
+		    (JOB_SVFLG_CHKPT |
+		     JOB_SVFLG_ChkptMig)) {
+#if PBS_CHKPT_MIGRATE
+			pj->ji_qs.ji_un.ji_momt.ji_exitstat =
+				JOB_EXEC_INITRMG;
+#else
+			pj->ji_qs.ji_un.ji_momt.ji_exitstat =
+				JOB_EXEC_INITRST;
+#endif
+		} else {
+			pj->ji_qs.ji_un.ji_momt.ji_exitstat =
+				JOB_EXEC_INITABT;
+		}
+
+		/*
+		 ** I am MS, send a DELETE_JOB request to any
+		 ** sisters that happen to still be alive.
+		 */
+		if (sisters > 0) {
+			(void) send_sisters(pj, IM_DELETE_JOB, NULL);
+		}
+		set_job_substate(pj, JOB_SUBSTATE_EXITING);
+		job_save(pj);
+		exiting_tasks = 1;
+	} else if (recover == 2) {
+		pbs_task *ptask;
+
+		for (ptask = (pbs_task *) GET_NEXT(pj->ji_tasks);
+		     ptask != NULL;
+		     ptask = (pbs_task *) GET_NEXT(ptask->ti_jobtask)) {
+			ptask->ti_flags |= TI_FLAGS_ORPHAN;
+		}
+
+		if (check_job_substate(pj, JOB_SUBSTATE_RUNNING)) {
+			recover_walltime(pj);
+			start_walltime(pj);
+		}
+
+		if (mom_do_poll(pj))
+			append_link(&mom_polljobs, &pj->ji_jobque, pj);
+
+		if (sisters > 0)
+			append_link(multinode_jobs, &pj->ji_multinodejobs, pj);
+
+		if (pj->ji_qs.ji_svrflags & JOB_SVFLG_HERE) {
+			/* I am MS */
+			pj->ji_stdout = pj->ji_ports[0] = pj->ji_extended.ji_ext.ji_stdout;
+			pj->ji_stderr = pj->ji_ports[1] = pj->ji_extended.ji_ext.ji_stdout;
+		}
+	}
+}
+
+/**
+ * @brief
+ *	Recover the jobs kept in the job journal.  If the journal is no longer
+ *	in use, the jobs are saved to their own files and the journal removed.
+ *
+ * @param[in]	recover - recovering mode of MoM
+ * @param[in]	multinode_jobs - list of recovered multinode jobs to add to
+ *
+ * @return void
+ */
+static void
+init_journal_jobs(int recover, pbs_list_head *multinode_jobs)
+{
+	int i;
+	int njobs;
+	job **jobs;
+
+	njobs = job_journal_recov(&jobs);
+	for (i = 0; i < njobs; i++) {
+		if (find_job(jobs[i]->ji_qs.ji_jobid) != NULL) {
+			/* its own file is newer */
+			job_journal_purge(jobs[i]);
+			job_free(jobs[i]);
+			continue;
+		}
+		if (!job_journal_active())
+			(void) job_save(jobs[i]);
+		init_recovered_job(jobs[i], recover, multinode_jobs);
+	}
+	free(jobs);
+	job_journal_close();
+}
+
 /**
  * @brief
  *	On mom initialization, recover all running jobs.
@@ -950,21 +1157,26 @@ void
 init_abort_jobs(int recover, pbs_list_head *multinode_jobs)
 {
 	DIR *dir;
-	int i, sisters;
+	int i;
 	struct dirent *pdirent;
 	job *pj = NULL;
 	char *job_suffix = JOB_FILE_SUFFIX;
 	int job_suf_len = strlen(job_suffix);
 	char *psuffix;
 	char path[MAXPATHLEN + 1];
-	char oldp[MAXPATHLEN + 1];
 	char rcperr[] = "rcperr.";
-	struct stat statbuf;
-	extern char *path_checkpoint;
 	extern char *path_spool;
 
 	CLEAR_HEAD((*multinode_jobs));
 
+	/*
+	 * Jobs are recovered from both the job journal and their own files,
+	 * the copy in the form jobs are now saved in first.
+	 */
+	(void) job_journal_open();
+	if (job_journal_active())
+		init_journal_jobs(recover, multinode_jobs);
+
 	dir = opendir(path_jobs);
 	if (dir == NULL) {
 		log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_SERVER, LOG_ALERT,
@@ -989,156 +1201,21 @@ init_abort_jobs(int recover, pbs_list_head *multinode_jobs)
 			continue;
 		}
 
-		/* To get homedir info */
-		pj->ji_grpcache = NULL;
-		check_pwd(pj);
-		if (pbs_idx_insert(jobs_idx, pj->ji_qs.ji_jobid, pj) != PBS_IDX_RET_OK) {
-			log_joberr(PBSE_INTERNAL, __func__, "Failed to add job in index during recovery", pj->ji_qs.ji_jobid);
+		if (find_job(pj->ji_qs.ji_jobid) != NULL) {
+			/* already recovered from the job journal, which is newer */
+			(void) strcpy(path, path_jobs);
+			(void) strcat(path, pdirent->d_name);
+			(void) unlink(path);
 			job_free(pj);
 			continue;
 		}
-		append_link(&svr_alljobs, &pj->ji_alljobs, pj);
-		job_nodes(pj);
-		task_recov(pj);
-
-		/*
-		 ** Check to see if a checkpoint.old dir exists.
-		 ** If so, remove the regular checkpoint dir
-		 ** and rename the old to the regular name.
-		 */
-		pbs_strncpy(path, path_checkpoint, sizeof(path));
-		if (*pj->ji_qs.ji_fileprefix != '\0')
-			strcat(path, pj->ji_qs.ji_fileprefix);
-		else
-			strcat(path, pj->ji_qs.ji_jobid);
-		strcat(path, JOB_CKPT_SUFFIX);
-		strcpy(oldp, path);
-		strcat(oldp, ".old");
-
-		if (stat(oldp, &statbuf) == 0) {
-			(void) remtree(path);
-			if (rename(oldp, path) == -1)
-				(void) remtree(oldp);
-		}
-
-		/*
-		 ** Check to see if I am Mother Superior.  The
-		 ** JOB_SVFLG_HERE flag is overloaded for MOM
-		 ** for this purpose.
-		 */
-		if ((pj->ji_qs.ji_svrflags & JOB_SVFLG_HERE) == 0) {
-			/* I am sister, junk the job files */
-			if (recover != 2) {
-				mom_deljob(pj);
-				continue;
-			}
-		}
-
-		sisters = pj->ji_numnodes - 1;
-		if (sisters > 0) {
-			pj->ji_resources = (noderes *) calloc(sisters,
-							      sizeof(noderes));
-			if (pj->ji_resources == NULL) {
-				log_err(ENOMEM, "init_abort_jobs", "out of memory");
-				continue;
-			}
-			pj->ji_numrescs = sisters;
-		}
-
-		/*
-		 **	If mom went down during file stage ops,
-		 **	the substate should be EXITED.  Set it
-		 **	back to OBIT so the server can verify that
-		 **	it still has the job or not.
-		 */
-		if (check_job_substate(pj, JOB_SUBSTATE_EXITED)) {
-			/*
-			 ** We don't want to change the state if the
-			 ** job is checkpointed.
-			 */
-			if ((pj->ji_qs.ji_svrflags &
-			     (JOB_SVFLG_CHKPT |
-			      JOB_SVFLG_ChkptMig)) == 0) {
-				set_job_substate(pj, JOB_SUBSTATE_OBIT);
-				job_save(pj);
-			}
-		} else if (check_job_substate(pj, JOB_SUBSTATE_TERM)) {
-			/*
-			 * Mom went down while terminate action script was
-			 * running, don't know if it finished or not;  force
-			 * Mom to send/resend OBIT and lets end it
-			 */
-			if (recover)
-				(void) kill_job(pj, SIGKILL);
-			set_job_substate(pj, JOB_SUBSTATE_OBIT);
-			job_save(pj);
-		} else if ((recover != 2) &&
-			   ((check_job_substate(pj, JOB_SUBSTATE_RUNNING)) ||
-			    (check_job_substate(pj, JOB_SUBSTATE_SUSPEND)) ||
-			    (check_job_substate(pj, JOB_SUBSTATE_KILLSIS)) ||
-			    (check_job_substate(pj, JOB_SUBSTATE_RUNEPILOG)) ||
-			    (check_job_substate(pj, JOB_SUBSTATE_EXITING)))) {
-
-			if (recover)
-				(void) kill_job(pj, SIGKILL);
-
-			/* set exit status to:
-			 *   JOB_EXEC_INITABT - init abort and no chkpnt
-			 *   JOB_EXEC_INITRST - init and chkpt, no mig
-			 *   JOB_EXEC_INITRMG - init and chkpt, migrate
-			 * to indicate recovery abort
-			 */
-			if (pj->ji_qs.ji_svrflags &
-			    (JOB_SVFLG_CHKPT |
-			     JOB_SVFLG_ChkptMig)) {
-#if PBS_CHKPT_MIGRATE
-				pj->ji_qs.ji_un.ji_momt.ji_exitstat =
-					JOB_EXEC_INITRMG;
-#else
-				pj->ji_qs.ji_un.ji_momt.ji_exitstat =
-					JOB_EXEC_INITRST;
-#endif
-			} else {
-				pj->ji_qs.ji_un.ji_momt.ji_exitstat =
-					JOB_EXEC_INITABT;
-			}
-
-			/*
-			 ** I am MS, send a DELETE_JOB request to any
-			 ** sisters that happen to still be alive.
-			 */
-			if (sisters > 0) {
-				(void) send_sisters(pj, IM_DELETE_JOB, NULL);
-			}
-			set_job_substate(pj, JOB_SUBSTATE_EXITING);
-			job_save(pj);
-			exiting_tasks = 1;
-		} else if (recover == 2) {
-			pbs_task *ptask;
-
-			for (ptask = (pbs_task *) GET_NEXT(pj->ji_tasks);
-			     ptask != NULL;
-			     ptask = (pbs_task *) GET_NEXT(ptask->ti_jobtask)) {
-				ptask->ti_flags |= TI_FLAGS_ORPHAN;
-			}
-
-			if (check_job_substate(pj, JOB_SUBSTATE_RUNNING)) {
-				recover_walltime(pj);
-				start_walltime(pj);
-			}
-
-			if (mom_do_poll(pj))
-				append_link(&mom_polljobs, &pj->ji_jobque, pj);
-
-			if (sisters > 0)
-				append_link(multinode_jobs, &pj->ji_multinodejobs, pj);
-
-			if (pj->ji_qs.ji_svrflags & JOB_SVFLG_HERE) {
-				/* I am MS */
-				pj->ji_stdout = pj->ji_ports[0] = pj->ji_extended.ji_ext.ji_stdout;
-				pj->ji_stderr = pj->ji_ports[1] = pj->ji_extended.ji_ext.ji_stdout;
-			}
+		if (job_journal_active() && (job_save(pj) == 0)) {
+			/* moved into the job journal */
+			(void) strcpy(path, path_jobs);
+			(void) strcat(path, pdirent->d_name);
+			(void) unlink(path);
 		}
+		init_recovered_job(pj, recover, multinode_jobs);
 	}
 	if (errno != 0 && errno != ENOENT) {
 		log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_SERVER, LOG_ALERT,
@@ -1147,6 +1224,8 @@ init_abort_jobs(int recover, pbs_list_head *multinode_jobs)
 		exit(1);
 	}
 	(void) closedir(dir);
+	if (!job_journal_active())
+		init_journal_jobs(recover, multinode_jobs);
 
 	/*
 	 ** Go through spool dir and remove files that match
@@ -1384,6 +1463,9 @@ del_job_resc(job *pjob)
 			       pbs_conf.pbs_home_path, pjob->ji_qs.ji_jobid);
 #endif
 		(void) unlink(file);
+		/* and its compact hostlist form, if $nodefile_hostlist wrote one */
+		(void) strcat(file, ".hostlist");
+		(void) unlink(file);
 	}
 
 	/* TMPDIR removed in job_purge so files are available for staging */
@@ -1610,6 +1692,88 @@ mom_set_use_all(void)
 	}
 }
 
+/**
+ * @brief
+ *	Add a point to the job's usage time series.  Called by mom_set_use()
+ *	with the values it has just computed, so the series costs no extra
+ *	scan of the job's processes.  At most one point is kept per
+ *	$job_sample_interval seconds and the oldest is overwritten once
+ *	JOB_SAMPLE_RING points are held.
+ *
+ * @param[in]	pjob - job sampled
+ * @param[in]	cput - cput used so far
+ * @param[in]	cpupercent - current cpupercent
+ * @param[in]	mem - resident memory in KB, 0 if not known
+ * @param[in]	vmem - virtual memory in KB, 0 if not known
+ *
+ * @return	void
+ */
+void
+job_sample(job *pjob, unsigned long cput, long cpupercent, u_Long mem, u_Long vmem)
+{
+	job_sample_t *js;
+
+	if (job_sample_interval <= 0)
+		return;
+	if (pjob->ji_samples == NULL) {
+		pjob->ji_samples = calloc(JOB_SAMPLE_RING, sizeof(job_sample_t));
+		if (pjob->ji_samples == NULL) {
+			log_err(errno, __func__, "no memory");
+			return;
+		}
+	} else {
+		js = &pjob->ji_samples[(pjob->ji_nsamples - 1) % JOB_SAMPLE_RING];
+		if (time_now - js->js_time < job_sample_interval)
+			return;
+	}
+	js = &pjob->ji_samples[pjob->ji_nsamples % JOB_SAMPLE_RING];
+	js->js_time = time_now;
+	js->js_cput = cput;
+	js->js_cpupercent = cpupercent;
+	js->js_mem = mem;
+	js->js_vmem = vmem;
+	pjob->ji_nsamples++;
+}
+
+/**
+ * @brief
+ *	Log a summary of the samples still held for a job as it ends.
+ *
+ * @param[in]	pjob - job ending
+ *
+ * @return	void
+ */
+void
+job_sample_summary(job *pjob)
+{
+	job_sample_t *js;
+	job_sample_t *oldest;
+	int n;
+	int i;
+	long sum_cpupct = 0;
+	long max_cpupct = 0;
+	u_Long max_mem = 0;
+	u_Long max_vmem = 0;
+
+	if (pjob->ji_samples == NULL || pjob->ji_nsamples == 0)
+		return;
+	n = MIN(pjob->ji_nsamples, JOB_SAMPLE_RING);
+	for (i = 0; i < n; i++) {
+		js = &pjob->ji_samples[i];
+		sum_cpupct += js->js_cpupercent;
+		max_cpupct = MAX(max_cpupct, js->js_cpupercent);
+		max_mem = MAX(max_mem, js->js_mem);
+		max_vmem = MAX(max_vmem, js->js_vmem);
+	}
+	js = &pjob->ji_samples[(pjob->ji_nsamples - 1) % JOB_SAMPLE_RING];
+	oldest = &pjob->ji_samples[pjob->ji_nsamples % n]; /* 0 until the ring wraps */
+	log_eventf(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, LOG_INFO, pjob->ji_qs.ji_jobid,
+		   "usage samples=%d span=%lds cpupercent avg=%ld max=%ld mem max=%llukb vmem max=%llukb",
+		   n, (long) (js->js_time - oldest->js_time),
+		   sum_cpupct / n, max_cpupct, (unsigned long long) max_mem,
+		   (unsigned long long) max_vmem);
+}
+
 /**
  * @brief	Wrapper function to job purge
  *
@@ -44,11 +44,17 @@
  *	job_recov_fs.c - This file contains the functions to record a job
  *	data struture to disk and to recover it from disk by Mom
  *
- *	The data is recorded in a file whose name is the job_id.
+ *	The data is recorded in a file whose name is the job_id, or with
+ *	the mom config $job_journal set, appended to a journal shared by
+ *	all jobs of this mom.
  *
  *	The following public functions are provided:
  *		job_save_fs() -		save the disk image
  *		job_recov_fs() -		recover (read) job from disk
+ *		job_journal_open() -	load the journal index at mom start
+ *		job_journal_recov() -	recover the jobs held in the journal
+ *		job_journal_purge() -	record that a job is gone
+ *		job_journal_close() -	drop the journal after leaving it
  */
 
 #include <pbs_config.h> /* the master config generated by configure */
@@ -79,23 +85,71 @@
 #include "svrfunc.h"
 #include <memory.h>
 #include "libutil.h"
+#include "pbs_idx.h"
 
 #define MAX_SAVE_TRIES 3
 
+/*
+ * The job journal is a sequence of records, each a jnl_hdr followed by
+ * jh_len bytes:
+ *	JNL_FULL  - job structure, extended area and the saved attributes,
+ *		    as in a .JB file
+ *	JNL_QUICK - job structure and extended area only, as a quick save
+ *		    overwrites them in a .JB file
+ *	JNL_PURGE - no data, the job is gone
+ * Only the last full record of a job and a quick record after it matter;
+ * once the journal has grown to twice its size after the last compaction
+ * those are copied to a new journal which replaces it.
+ */
+#define JNL_MAGIC 0x4a4e4c31			 /* "JNL1" */
+#define JNL_COMPACT_MIN ((off_t) 4 * 1024 * 1024) /* never compact a smaller journal */
+#define JNL_COPY_BUFSZ (64 * 1024)
+
+enum jnl_type {
+	JNL_FULL = 1,
+	JNL_QUICK,
+	JNL_PURGE
+};
+
+struct jnl_hdr {
+	int jh_magic;
+	int jh_type; /* enum jnl_type */
+	long jh_len; /* bytes of data following the header */
+	char jh_jobid[PBS_MAXSVRJOBID + 1];
+};
+
+/* where the live records of a job are in the journal */
+struct jnl_job {
+	char jj_jobid[PBS_MAXSVRJOBID + 1];
+	off_t jj_full;	  /* offset of the last full record */
+	off_t jj_fulllen; /* its length, header included */
+	off_t jj_quick;	  /* offset of a later quick record, or -1 */
+	off_t jj_nfull;	  /* jj_full in the journal being compacted */
+	off_t jj_nquick;  /* jj_quick in the journal being compacted */
+};
+
 /* global data items */
 
 extern char *path_jobs;
 extern time_t time_now;
 extern char pbs_recov_filename[];
+extern int job_journal;
 
 /* data global only to this file */
 
 static const size_t fixedsize = sizeof(struct jobfix);
 static const size_t extndsize = sizeof(union jobextend);
+static const size_t quicksize = sizeof(struct jnl_hdr) + sizeof(struct jobfix) + sizeof(union jobextend);
+
+static char jnl_path[MAXPATHLEN + 1]; /* path of the job journal */
+static int jnl_fd = -1;		      /* journal being appended to, -1 if none */
+static off_t jnl_size;		      /* end of the last good record */
+static off_t jnl_base;		      /* jnl_size after the last compaction */
+static void *jnl_idx;		      /* struct jnl_job entries by job id */
 
 /**
  * @brief
- *		Saves (or updates) a job structure image on disk
+ *		Saves (or updates) a job structure image in the job's own file
  *
  *		Save does either - a quick update for state changes only,
  *			 - a full update for an existing file, or
@@ -113,6 +167,7 @@ static const size_t extndsize = sizeof(union jobextend);
  *		the file.
  *
  * @param[in]	pjob - Pointer to the job structure to save
+ * @param[in]	quick - no attribute changed, a quick update will do
  *
  * @return      Error code
  * @retval	 0  - Success
@@ -120,8 +175,8 @@ static const size_t extndsize = sizeof(union jobextend);
  *
  */
 
-int
-job_save_fs(job *pjob)
+static int
+job_save_file(job *pjob, int quick)
 {
 	int fds;
 	int i;
@@ -131,7 +186,6 @@ job_save_fs(job *pjob)
 	int openflags;
 	int redo;
 	int pmode;
-	int quick = 1;
 
 #ifdef WIN32
 	pmode = _S_IWRITE | _S_IREAD;
@@ -147,26 +201,19 @@ job_save_fs(job *pjob)
 	(void) strcpy(namebuf2, namebuf1); /* setup for later */
 	(void) strcat(namebuf1, JOB_FILE_SUFFIX);
 
-	if (pjob->ji_qs.ji_jsversion != JSVERSION) {
-		/* version of job structure changed, force full write */
-		pjob->ji_qs.ji_jsversion = JSVERSION;
-		quick = 0;
-	}
-
-	for (i = 0; i < JOB_ATR_LAST; i++) {
-		if ((get_jattr(pjob, i))->at_flags & ATR_VFLAG_MODIFY) {
-			quick = 0;
-			break;
-		}
-	}
-
 	if (quick) {
 		openflags = O_WRONLY;
 		fds = open(namebuf1, openflags, pmode);
-		if (fds < 0) {
+		if ((fds < 0) && (errno == ENOENT)) {
+			/* no file yet, e.g. the job came from the journal */
+			quick = 0;
+		} else if (fds < 0) {
 			log_errf(errno, __func__, "Failed to open %s file", namebuf1);
 			return (-1);
 		}
+	}
+
+	if (quick) {
 #ifdef WIN32
 		secure_file(namebuf1, "Administrators",
 			    READS_MASK | WRITES_MASK | STANDARD_RIGHTS_REQUIRED);
@@ -187,9 +234,6 @@ job_save_fs(job *pjob)
 		}
 
 	} else {
-		/* an attribute changed,  update mtime */
-		set_jattr_l_slim(pjob, JOB_ATR_mtime, time_now, SET);
-
 		/*
 		 * write the whole structure to the file.
 		 * For a update, this is done to a new file to protect the
@@ -273,6 +317,611 @@ job_save_fs(job *pjob)
 	return (0);
 }
 
+/**
+ * @brief
+ *	Find the journal index entry of a job.
+ *
+ * @param[in]	jobid - the job id
+ *
+ * @return struct jnl_job *
+ * @retval	the entry
+ * @retval	NULL - the journal holds nothing for the job
+ */
+static struct jnl_job *
+jnl_find(char *jobid)
+{
+	struct jnl_job *jj = NULL;
+	void *key = jobid;
+
+	if ((jnl_idx == NULL) ||
+	    (pbs_idx_find(jnl_idx, &key, (void **) &jj, NULL) != PBS_IDX_RET_OK))
+		return (NULL);
+	return (jj);
+}
+
+/**
+ * @brief
+ *	Find or add the journal index entry of a job.
+ *
+ * @param[in]	jobid - the job id
+ *
+ * @return struct jnl_job *
+ * @retval	the entry, new ones have no records
+ * @retval	NULL - out of memory
+ */
+static struct jnl_job *
+jnl_add(char *jobid)
+{
+	struct jnl_job *jj;
+
+	if ((jj = jnl_find(jobid)) != NULL)
+		return (jj);
+	if ((jj = calloc(1, sizeof(struct jnl_job))) == NULL)
+		return (NULL);
+	pbs_strncpy(jj->jj_jobid, jobid, sizeof(jj->jj_jobid));
+	jj->jj_full = -1;
+	jj->jj_quick = -1;
+	if (pbs_idx_insert(jnl_idx, jj->jj_jobid, jj) != PBS_IDX_RET_OK) {
+		free(jj);
+		return (NULL);
+	}
+	return (jj);
+}
+
+/**
+ * @brief
+ *	Drop the journal index entry of a job.
+ *
+ * @param[in]	jj - the entry
+ *
+ * @return void
+ */
+static void
+jnl_forget(struct jnl_job *jj)
+{
+	(void) pbs_idx_delete(jnl_idx, jj->jj_jobid);
+	free(jj);
+}
+
+/**
+ * @brief
+ *	Copy 'len' bytes at offset 'off' of 'rfd' to the end of 'wfd'.
+ *
+ * @param[in]	rfd - descriptor to copy from
+ * @param[in]	off - where the data starts in 'rfd'
+ * @param[in]	len - amount of data
+ * @param[in]	wfd - descriptor to write to
+ *
+ * @return int
+ * @retval  0	success
+ * @retval -1	failure
+ */
+static int
+jnl_copy(int rfd, off_t off, off_t len, int wfd)
+{
+	static char buf[JNL_COPY_BUFSZ];
+	ssize_t n;
+
+	while (len > 0) {
+		n = pread(rfd, buf, (len > JNL_COPY_BUFSZ) ? JNL_COPY_BUFSZ : (size_t) len, off);
+		if (n <= 0) {
+			if ((n == -1) && (errno == EINTR))
+				continue;
+			if (n == 0)
+				errno = EIO;
+			return (-1);
+		}
+		if (write(wfd, buf, n) != n)
+			return (-1);
+		off += n;
+		len -= n;
+	}
+	return (0);
+}
+
+/**
+ * @brief
+ *	Compact the job journal: copy the live records of every job to a new
+ *	journal and put it in place of the old one.
+ *
+ * @return int
+ * @retval  0	success
+ * @retval -1	failure, the old journal is kept
+ */
+static int
+jnl_compact(void)
+{
+	char newpath[MAXPATHLEN + 1];
+	int nfd;
+	int rfd;
+	int rc = -1;
+	off_t noff = 0;
+	void *ctx = NULL;
+	struct jnl_job *jj;
+
+	if (snprintf(newpath, sizeof(newpath), "%s.new", jnl_path) >= (int) sizeof(newpath)) {
+		log_err(ENAMETOOLONG, __func__, jnl_path);
+		return (-1);
+	}
+	if ((nfd = open(newpath, O_WRONLY | O_CREAT | O_TRUNC, 0600)) == -1) {
+		log_errf(errno, __func__, "cannot create %s", newpath);
+		return (-1);
+	}
+	if ((rfd = open(jnl_path, O_RDONLY)) == -1) {
+		log_errf(errno, __func__, "cannot open %s", jnl_path);
+		(void) close(nfd);
+		(void) unlink(newpath);
+		return (-1);
+	}
+
+	while (pbs_idx_find(jnl_idx, NULL, (void **) &jj, &ctx) == PBS_IDX_RET_OK) {
+		if (jnl_copy(rfd, jj->jj_full, jj->jj_fulllen, nfd) != 0)
+			goto compact_end;
+		jj->jj_nfull = noff;
+		noff += jj->jj_fulllen;
+		jj->jj_nquick = -1;
+		if (jj->jj_quick != -1) {
+			if (jnl_copy(rfd, jj->jj_quick, quicksize, nfd) != 0)
+				goto compact_end;
+			jj->jj_nquick = noff;
+			noff += quicksize;
+		}
+	}
+	pbs_idx_free_ctx(ctx);
+	ctx = NULL;
+
+	rc = close(nfd);
+	nfd = -1;
+	if ((rc != 0) || ((rc = rename(newpath, jnl_path)) != 0))
+		goto compact_end;
+
+	/* the new journal is in place, switch the index over to it */
+	while (pbs_idx_find(jnl_idx, NULL, (void **) &jj, &ctx) == PBS_IDX_RET_OK) {
+		jj->jj_full = jj->jj_nfull;
+		jj->jj_quick = jj->jj_nquick;
+	}
+	if (jnl_fd != -1)
+		(void) close(jnl_fd);
+	if ((jnl_fd = open(jnl_path, O_WRONLY, 0600)) == -1)
+		/* jobs are saved to their own files from now on, both are read at start */
+		log_errf(errno, __func__, "cannot reopen %s, saving jobs to files", jnl_path);
+	log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_SERVER, LOG_DEBUG, __func__,
+		   "job journal compacted from %ld to %ld bytes", (long) jnl_size, (long) noff);
+	jnl_size = jnl_base = noff;
+
+compact_end:
+	if (ctx != NULL)
+		pbs_idx_free_ctx(ctx);
+	if (rc != 0) {
+		log_errf(errno, __func__, "cannot compact %s", jnl_path);
+		(void) unlink(newpath);
+	}
+	if (nfd != -1)
+		(void) close(nfd);
+	(void) close(rfd);
+	return (rc);
+}
+
+/**
+ * @brief
+ *	Append a record for a job to the job journal.
+ *
+ * @param[in]	pjob - the job
+ * @param[in]	quick - the attributes did not change, a quick record will do
+ *
+ * @return int
+ * @retval  0	success
+ * @retval -1	failure, nothing is appended
+ */
+static int
+job_save_jnl(job *pjob, int quick)
+{
+	struct jnl_hdr hdr;
+	struct jnl_job *jj;
+	off_t start = jnl_size;
+	off_t end;
+
+	/* a quick record needs a full one to go on */
+	if (((jj = jnl_find(pjob->ji_qs.ji_jobid)) == NULL) && ((jj = jnl_add(pjob->ji_qs.ji_jobid)) == NULL)) {
+		log_err(ENOMEM, __func__, "out of memory");
+		return (-1);
+	}
+	if (jj->jj_full == -1)
+		quick = 0;
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.jh_magic = JNL_MAGIC;
+	hdr.jh_type = quick ? JNL_QUICK : JNL_FULL;
+	hdr.jh_len = quick ? (long) (fixedsize + extndsize) : 0;
+	pbs_strncpy(hdr.jh_jobid, pjob->ji_qs.ji_jobid, sizeof(hdr.jh_jobid));
+
+	if (lseek(jnl_fd, start, SEEK_SET) == -1)
+		goto save_err;
+	save_setup(jnl_fd);
+	if ((save_struct((char *) &hdr, sizeof(hdr)) != 0) ||
+	    (save_struct((char *) &pjob->ji_qs, fixedsize) != 0) ||
+	    (save_struct((char *) &pjob->ji_extended, extndsize) != 0) ||
+	    (!quick && (save_attr_fs(job_attr_def, pjob->ji_wattr, (int) JOB_ATR_LAST) != 0))) {
+		(void) save_flush();
+		goto save_err;
+	}
+	if ((save_flush() != 0) || ((end = lseek(jnl_fd, 0, SEEK_CUR)) == -1))
+		goto save_err;
+
+	if (!quick) {
+		/* the length goes in last, a record cut short by a crash has none */
+		hdr.jh_len = (long) (end - start - sizeof(hdr));
+		if (pwrite(jnl_fd, &hdr, sizeof(hdr), start) != sizeof(hdr))
+			goto save_err;
+		jj->jj_full = start;
+		jj->jj_fulllen = end - start;
+		jj->jj_quick = -1;
+	} else
+		jj->jj_quick = start;
+	jnl_size = end;
+
+	if ((jnl_size > JNL_COMPACT_MIN) && (jnl_size > 2 * jnl_base))
+		(void) jnl_compact();
+	return (0);
+
+save_err:
+	log_errf(errno, __func__, "error writing %s for job %s", jnl_path, pjob->ji_qs.ji_jobid);
+	if (jj->jj_full == -1)
+		jnl_forget(jj);
+	(void) ftruncate(jnl_fd, start);
+	return (-1);
+}
+
+/**
+ * @brief
+ *		Saves (or updates) a job structure image on disk, in the job
+ *		journal when it is in use, else in the job's own file.
+ *
+ * @param[in]	pjob - Pointer to the job structure to save
+ *
+ * @return      Error code
+ * @retval	 0  - Success
+ * @retval	-1  - Failure
+ *
+ */
+
+int
+job_save_fs(job *pjob)
+{
+	int i;
+	int quick = 1;
+
+	if (pjob->ji_qs.ji_jsversion != JSVERSION) {
+		/* version of job structure changed, force full write */
+		pjob->ji_qs.ji_jsversion = JSVERSION;
+		quick = 0;
+	}
+
+	for (i = 0; i < JOB_ATR_LAST; i++) {
+		if ((get_jattr(pjob, i))->at_flags & ATR_VFLAG_MODIFY) {
+			quick = 0;
+			break;
+		}
+	}
+
+	/* an attribute changed,  update mtime */
+	if (!quick)
+		set_jattr_l_slim(pjob, JOB_ATR_mtime, time_now, SET);
+
+	if (jnl_fd != -1)
+		return (job_save_jnl(pjob, quick));
+	return (job_save_file(pjob, quick));
+}
+
+/**
+ * @brief
+ *	Check that a journal record header is sound.
+ *
+ * @param[in]	hdr - the header
+ * @param[in]	off - where it is in the journal
+ * @param[in]	size - size of the journal
+ *
+ * @return int
+ * @retval 1	good header
+ * @retval 0	bad or cut short record, the journal ends before it
+ */
+static int
+jnl_hdr_ok(struct jnl_hdr *hdr, off_t off, off_t size)
+{
+	if ((hdr->jh_magic != JNL_MAGIC) || (hdr->jh_len < 0) ||
+	    (memchr(hdr->jh_jobid, '\0', sizeof(hdr->jh_jobid)) == NULL) ||
+	    (off + (off_t) sizeof(*hdr) + hdr->jh_len > size))
+		return (0);
+	switch (hdr->jh_type) {
+		case JNL_FULL:
+			return (hdr->jh_len > (long) (fixedsize + extndsize));
+		case JNL_QUICK:
+			return (hdr->jh_len == (long) (fixedsize + extndsize));
+		case JNL_PURGE:
+			return (hdr->jh_len == 0);
+	}
+	return (0);
+}
+
+/**
+ * @brief
+ *	Load the index of the job journal at mom start and, if $job_journal
+ *	is set, open the journal to append to.
+ *
+ * @par Functionality:
+ *	The journal is read once from start to end, noting for every job
+ *	where its last full record and a quick record after it are; jobs
+ *	with a purge record are dropped.  The journal ends at the first bad
+ *	record, which is what a crash in the middle of an append leaves.
+ *
+ * @return int
+ * @retval  0	success
+ * @retval -1	failure, jobs are saved to their own files
+ */
+int
+job_journal_open(void)
+{
+	int fd;
+	off_t off = 0;
+	struct stat sb;
+	struct jnl_hdr hdr;
+	struct jnl_job *jj;
+
+	snprintf(jnl_path, sizeof(jnl_path), "%s%s", path_jobs, JOB_JOURNAL_FILE);
+	if ((jnl_idx == NULL) && ((jnl_idx = pbs_idx_create(0, 0)) == NULL)) {
+		log_err(ENOMEM, __func__, "cannot create job journal index");
+		return (-1);
+	}
+
+	if ((fd = open(jnl_path, O_RDONLY)) != -1) {
+		if (fstat(fd, &sb) == -1)
+			sb.st_size = 0;
+		while ((off + (off_t) sizeof(hdr) <= sb.st_size) &&
+		       (pread(fd, &hdr, sizeof(hdr), off) == sizeof(hdr)) &&
+		       jnl_hdr_ok(&hdr, off, sb.st_size)) {
+			jj = jnl_find(hdr.jh_jobid);
+			if (hdr.jh_type == JNL_PURGE) {
+				if (jj != NULL)
+					jnl_forget(jj);
+			} else if (hdr.jh_type == JNL_QUICK) {
+				if (jj != NULL)
+					jj->jj_quick = off;
+			} else if ((jj != NULL) || ((jj = jnl_add(hdr.jh_jobid)) != NULL)) {
+				jj->jj_full = off;
+				jj->jj_fulllen = (off_t) sizeof(hdr) + hdr.jh_len;
+				jj->jj_quick = -1;
+			} else {
+				log_err(ENOMEM, __func__, "out of memory");
+				(void) close(fd);
+				return (-1);
+			}
+			off += (off_t) sizeof(hdr) + hdr.jh_len;
+		}
+		if (off < sb.st_size)
+			log_eventf(PBSEVENT_ERROR, PBS_EVENTCLASS_SERVER, LOG_WARNING, __func__,
+				   "%s: ignoring %ld bytes after offset %ld",
+				   jnl_path, (long) (sb.st_size - off), (long) off);
+		(void) close(fd);
+	} else if (errno != ENOENT)
+		log_errf(errno, __func__, "cannot open %s", jnl_path);
+
+	jnl_size = jnl_base = off;
+	if (!job_journal)
+		return (0);
+
+	if ((jnl_fd = open(jnl_path, O_WRONLY | O_CREAT, 0600)) == -1) {
+		log_errf(errno, __func__, "cannot open %s, saving jobs to files", jnl_path);
+		return (-1);
+	}
+	/* drop whatever a crash left after the last good record */
+	if (ftruncate(jnl_fd, jnl_size) == -1)
+		log_errf(errno, __func__, "cannot truncate %s", jnl_path);
+	if (jnl_size > JNL_COMPACT_MIN)
+		(void) jnl_compact();
+	return (0);
+}
+
+/**
+ * @brief
+ *	Tell whether jobs are being saved to the job journal.
+ *
+ * @return int
+ * @retval 1	jobs are saved to the journal
+ * @retval 0	jobs are saved to their own files
+ */
+int
+job_journal_active(void)
+{
+	return (jnl_fd != -1);
+}
+
+/**
+ * @brief
+ *	Read one job from its journal records.
+ *
+ * @param[in]	fd - the journal, open for reading
+ * @param[in]	jj - index entry of the job
+ *
+ * @return job *
+ * @retval	the job
+ * @retval	NULL - the records could not be read
+ */
+static job *
+jnl_recov_job(int fd, struct jnl_job *jj)
+{
+	job *pj;
+
+	if ((pj = job_alloc()) == NULL)
+		return (NULL);
+
+	errno = -1;
+	if ((lseek(fd, jj->jj_full + (off_t) sizeof(struct jnl_hdr), SEEK_SET) == -1) ||
+	    (read(fd, (char *) &pj->ji_qs, fixedsize) != (int) fixedsize) ||
+	    (strcmp(pj->ji_qs.ji_jobid, jj->jj_jobid) != 0) ||
+	    (pj->ji_qs.ji_jsversion < JSVERSION_18) ||
+	    (read(fd, (char *) &pj->ji_extended, extndsize) != (int) extndsize)) {
+		log_joberr(errno, __func__, "error reading job structure from journal", jj->jj_jobid);
+		free(pj);
+		return (NULL);
+	}
+	if (recov_attr_fs(fd, pj, job_attr_idx, job_attr_def, pj->ji_wattr, (int) JOB_ATR_LAST,
+			  (int) JOB_ATR_UNKN) != 0) {
+		log_joberr(errno, __func__, "error reading attributes from journal", jj->jj_jobid);
+		job_free(pj);
+		return (NULL);
+	}
+	if ((jj->jj_quick != -1) &&
+	    ((pread(fd, (char *) &pj->ji_qs, fixedsize, jj->jj_quick + (off_t) sizeof(struct jnl_hdr)) != (int) fixedsize) ||
+	     (pread(fd, (char *) &pj->ji_extended, extndsize,
+		    jj->jj_quick + (off_t) (sizeof(struct jnl_hdr) + fixedsize)) != (int) extndsize))) {
+		log_joberr(errno, __func__, "error reading job structure from journal", jj->jj_jobid);
+		job_free(pj);
+		return (NULL);
+	}
+	return (pj);
+}
+
+/**
+ * @brief
+ *	Recover the jobs held in the job journal.
+ *
+ * @param[out]	pjobs - set to a malloc-ed array of the recovered jobs,
+ *			the caller frees it
+ *
+ * @return int
+ * @retval	number of jobs in *pjobs
+ *
+ * @par Side Effects:
+ *	Jobs that can not be read are dropped from the journal.
+ */
+int
+job_journal_recov(job ***pjobs)
+{
+	int fd;
+	int i;
+	int n = 0;
+	int njobs = 0;
+	void *ctx = NULL;
+	struct jnl_job *jj;
+	struct jnl_job **jjs = NULL;
+	struct jnl_job **tmp;
+	job **jobs;
+
+	*pjobs = NULL;
+	if (jnl_idx == NULL)
+		return (0);
+
+	/* take the entries out of the index first, bad ones get dropped from it */
+	while (pbs_idx_find(jnl_idx, NULL, (void **) &jj, &ctx) == PBS_IDX_RET_OK) {
+		if ((n % 64) == 0) {
+			if ((tmp = realloc(jjs, (n + 64) * sizeof(*jjs))) == NULL)
+				break;
+			jjs = tmp;
+		}
+		jjs[n++] = jj;
+	}
+	pbs_idx_free_ctx(ctx);
+	if (n == 0) {
+		free(jjs);
+		return (0);
+	}
+	if ((jobs = calloc(n, sizeof(job *))) == NULL) {
+		log_err(ENOMEM, __func__, "out of memory");
+		free(jjs);
+		return (0);
+	}
+	if ((fd = open(jnl_path, O_RDONLY)) == -1) {
+		log_errf(errno, __func__, "cannot recover jobs from %s", jnl_path);
+		free(jobs);
+		free(jjs);
+		return (0);
+	}
+
+	pbs_strncpy(pbs_recov_filename, jnl_path, MAXPATHLEN);
+	for (i = 0; i < n; i++) {
+		if ((jobs[njobs] = jnl_recov_job(fd, jjs[i])) != NULL)
+			njobs++;
+		else if (jnl_fd != -1)
+			job_journal_purge_id(jjs[i]->jj_jobid);
+		else
+			jnl_forget(jjs[i]);
+	}
+	(void) close(fd);
+	free(jjs);
+	*pjobs = jobs;
+	return (njobs);
+}
+
+/**
+ * @brief
+ *	Record in the job journal that a job is gone.
+ *
+ * @param[in]	jobid - id of the job
+ *
+ * @return void
+ */
+void
+job_journal_purge_id(char *jobid)
+{
+	struct jnl_hdr hdr;
+	struct jnl_job *jj;
+
+	if ((jj = jnl_find(jobid)) == NULL)
+		return;
+	if (jnl_fd != -1) {
+		memset(&hdr, 0, sizeof(hdr));
+		hdr.jh_magic = JNL_MAGIC;
+		hdr.jh_type = JNL_PURGE;
+		pbs_strncpy(hdr.jh_jobid, jobid, sizeof(hdr.jh_jobid));
+		if (pwrite(jnl_fd, &hdr, sizeof(hdr), jnl_size) == sizeof(hdr))
+			jnl_size += sizeof(hdr);
+		else {
+			/* the job comes back on restart unless a compaction drops it first */
+			log_errf(errno, __func__, "error writing %s for job %s", jnl_path, jobid);
+			(void) ftruncate(jnl_fd, jnl_size);
+		}
+	}
+	jnl_forget(jj);
+}
+
+/**
+ * @brief
+ *	Record in the job journal that a job is gone.
+ *
+ * @param[in]	pjob - the job
+ *
+ * @return void
+ */
+void
+job_journal_purge(job *pjob)
+{
+	job_journal_purge_id(pjob->ji_qs.ji_jobid);
+}
+
+/**
+ * @brief
+ *	Remove the job journal once the jobs in it have been saved to their
+ *	own files, when $job_journal has been turned off.
+ *
+ * @return void
+ */
+void
+job_journal_close(void)
+{
+	void *ctx = NULL;
+	struct jnl_job *jj;
+
+	if ((jnl_fd != -1) || (jnl_idx == NULL))
+		return;
+	while (pbs_idx_find(jnl_idx, NULL, (void **) &jj, &ctx) == PBS_IDX_RET_OK)
+		free(jj);
+	pbs_idx_free_ctx(ctx);
+	pbs_idx_destroy(jnl_idx);
+	jnl_idx = NULL;
+	if ((unlink(jnl_path) == -1) && (errno != ENOENT))
+		log_errf(errno, __func__, "cannot remove %s", jnl_path);
+}
+
 /**
  * @brief
  *		recover (read in) a job from its save file
@@ -190,6 +190,7 @@ typedef struct inventory_data {
 	basil_label_t *label;
 	basil_rsvn_t *reservation;
 	basil_node_computeunit_t *cu;
+	XML_Index node_offset;	/* stream offset of the current <Node> */
 	int role_int;
 	int role_batch;
 	int role_unknown;
@@ -324,6 +325,26 @@ static const char *pbs_supported_basil_versions[] __attribute__((unused)) = {
 
 static int first_compute_node = 1;
 
+/**
+ * The vnodes inventory_to_vnodes() built for one compute node, kept so
+ * that the next inventory can reuse them when the node's XML, its place
+ * in the inventory and the vnode naming are all unchanged.
+ */
+typedef struct alps_node_cache {
+	unsigned long long hash;    /* basil_node_t hash the vnodes came from */
+	long order;		    /* PBScrayorder the vnodes were given */
+	int per_numa;		    /* vnode_per_numa_node when they were built */
+	char name[VNODE_NAME_LEN];  /* last vnode name for the node */
+	vnl_t *vnl;		    /* the vnodes themselves */
+} alps_node_cache_t;
+
+/**
+ * alps_node_cache_t entries indexed by Cray node id, and the mpp_host
+ * their vnode names were made with.
+ */
+static void *alps_node_cache;
+static char alps_node_cache_host[BASIL_STRING_LONG];
+
 /**
  * String to use for mpp_host in vnode names when basil11orig
  * is true.
@@ -1663,6 +1684,7 @@ node_start(ud_t *d, const XML_Char *el, const XML_Char **atts)
 		brp->data.query.data.inventory.nodes = node;
 	}
 	d->current.node = node;
+	d->current.node_offset = XML_GetCurrentByteIndex(parser);
 	/*
 	 * Work through the attribute pairs updating the name pointer and
 	 * value pointer with each loop. The somewhat complex loop control
@@ -3632,6 +3654,48 @@ default_element_end(ud_t *d, const XML_Char *el)
 	return;
 }
 
+/**
+ * @brief
+ * 	Special method registered to handle the end of the node element.
+ * 	The raw XML of the node, which the parser was fed out of
+ * 	alps_client_out, is hashed so inventory_to_vnodes() can tell
+ * 	which nodes changed since the last inventory.
+ *
+ * The standard Expat end handler function prototype is used.
+ *
+ * @param d pointer to user data structure
+ * @param[in] el name of end element
+ *
+ * @return Void
+ *
+ */
+static void
+node_end(ud_t *d, const XML_Char *el)
+{
+	basil_node_t *node = d->current.node;
+	XML_Index end;
+	unsigned long long h;
+	unsigned char *p;
+	unsigned char *e;
+
+	if (strcmp(el, handler[d->stack[d->depth]].element) != 0) {
+		parse_err_illegal_end(d, el);
+		return;
+	}
+	if (node == NULL || alps_client_out == NULL)
+		return;
+	end = XML_GetCurrentByteIndex(parser);
+	if (end <= d->current.node_offset)
+		return;
+
+	/* FNV-1a over the bytes from <Node> up to </Node> */
+	p = (unsigned char *) alps_client_out + sizeof(NODE_TOPOLOGY_TYPE_CRAY) - 1 + d->current.node_offset;
+	e = p + (end - d->current.node_offset);
+	for (h = 14695981039346656037ULL; p < e; p++)
+		h = (h ^ *p) * 1099511628211ULL;
+	node->hash = h ? h : 1;
+}
+
 /**
  * @brief
  * 	Special method registered to handle the end of the inventory element.
@@ -4149,6 +4213,30 @@ bad_vnl:
 	abort();
 }
 
+/**
+ * @brief
+ * 	Free an index of alps_node_cache_t entries and the entries in it.
+ *
+ * @param[in] idx	index to free, may be NULL
+ *
+ * @return Void
+ */
+static void
+alps_node_cache_free(void *idx)
+{
+	void *ctx = NULL;
+	alps_node_cache_t *ent;
+
+	if (idx == NULL)
+		return;
+	while (pbs_idx_find(idx, NULL, (void **) &ent, &ctx) == PBS_IDX_RET_OK) {
+		vnl_free(ent->vnl);
+		free(ent);
+	}
+	pbs_idx_free_ctx(ctx);
+	pbs_idx_destroy(idx);
+}
+
 /**
  * @brief
  * 	After the Cray inventory XML response is parsed, use the resulting structures
@@ -4184,6 +4272,11 @@ inventory_to_vnodes(basil_response_t *brp)
 	basil_node_t *node = NULL;
 	basil_response_query_inventory_t *inv = NULL;
 	hwloc_topology_t topology;
+	void *old_cache = NULL;
+	alps_node_cache_t *ent;
+	void *key;
+	int changed = 0;
+	int total = 0;
 
 	if (!brp)
 		return -1;
@@ -4305,8 +4398,20 @@ inventory_to_vnodes(basil_response_t *brp)
 	if (basil_1_7_supported)
 		arr_nodes = process_nodelist_KNL(knl_node_list, &node_count);
 	/*
-	 * now create the compute nodes
+	 * now create the compute nodes, reusing the vnodes of those whose
+	 * inventory did not change; entries left in old_cache afterwards
+	 * belong to nodes that are gone and are freed
 	 */
+	old_cache = alps_node_cache;
+	if ((alps_node_cache = pbs_idx_create(0, sizeof(long))) == NULL) {
+		log_err(errno, __func__, "pbs_idx_create failed!");
+		goto bad_vnl;
+	}
+	if (strcmp(alps_node_cache_host, mpphost) != 0) {
+		alps_node_cache_free(old_cache);
+		old_cache = NULL;
+		pbs_strncpy(alps_node_cache_host, mpphost, sizeof(alps_node_cache_host));
+	}
 	inv = &brp->data.query.data.inventory;
 	for (order = 1, node = inv->nodes; node; node = node->next, order++) {
 		char *arch;
@@ -4372,32 +4477,74 @@ inventory_to_vnodes(basil_response_t *brp)
 			log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_NODE,
 				  LOG_DEBUG, __func__, log_buffer);
 		}
-		seg_num = 0;
-		cpu_ct = 0;
-		mem_ct = 0;
-
-		inventory_loop_on_segments(node, nv, arch, &seg_num, order, name, &cpu_ct, &mem_ct);
-
-		if (!vnode_per_numa_node) {
-			/* Since we're creating one vnode that combines
-			 * the info for all the numa nodes,
-			 * we've now cycled through all the numa nodes, so
-			 * we need to set the total number of cpus and total
-			 * memory before moving on to the next node
-			 */
-			attr = "resources_available.ncpus";
-			sprintf(utilBuffer, "%d", cpu_ct);
-			if (vn_addvnr(nv, name, attr, utilBuffer,
-				      0, 0, NULL) == -1)
+		total++;
+		ent = NULL;
+		key = &node->node_id;
+		if (old_cache != NULL &&
+		    pbs_idx_find(old_cache, &key, (void **) &ent, NULL) == PBS_IDX_RET_OK)
+			pbs_idx_delete(old_cache, &node->node_id);
+
+		if (ent != NULL && node->hash != 0 && ent->hash == node->hash &&
+		    ent->order == order && ent->per_numa == vnode_per_numa_node) {
+			pbs_strncpy(name, ent->name, VNODE_NAME_LEN);
+		} else {
+			if (ent == NULL) {
+				if ((ent = calloc(1, sizeof(alps_node_cache_t))) == NULL)
+					goto bad_vnl;
+			} else {
+				vnl_free(ent->vnl);
+				ent->vnl = NULL;
+			}
+			if (vnl_alloc(&ent->vnl) == NULL)
 				goto bad_vnl;
+			ent->vnl->vnl_modtime = 0;
+			ent->hash = node->hash;
+			ent->order = order;
+			ent->per_numa = vnode_per_numa_node;
+			changed++;
+
+			seg_num = 0;
+			cpu_ct = 0;
+			mem_ct = 0;
+
+			inventory_loop_on_segments(node, ent->vnl, arch, &seg_num, order, name, &cpu_ct, &mem_ct);
+
+			if (!vnode_per_numa_node) {
+				/* Since we're creating one vnode that combines
+				 * the info for all the numa nodes,
+				 * we've now cycled through all the numa nodes, so
+				 * we need to set the total number of cpus and total
+				 * memory before moving on to the next node
+				 */
+				attr = "resources_available.ncpus";
+				sprintf(utilBuffer, "%d", cpu_ct);
+				if (vn_addvnr(ent->vnl, name, attr, utilBuffer,
+					      0, 0, NULL) == -1)
+					goto bad_vnl;
 
-			attr = "resources_available.mem";
-			snprintf(utilBuffer, sizeof(utilBuffer), "%lukb", mem_ct);
-			if (vn_addvnr(nv, name, attr, utilBuffer,
-				      0, 0, NULL) == -1)
-				goto bad_vnl;
+				attr = "resources_available.mem";
+				snprintf(utilBuffer, sizeof(utilBuffer), "%lukb", mem_ct);
+				if (vn_addvnr(ent->vnl, name, attr, utilBuffer,
+					      0, 0, NULL) == -1)
+					goto bad_vnl;
+			}
+			pbs_strncpy(ent->name, name, VNODE_NAME_LEN);
+		}
+
+		if (vn_merge(nv, ent->vnl, NULL) == NULL)
+			goto bad_vnl;
+		if (pbs_idx_insert(alps_node_cache, &node->node_id, ent) != PBS_IDX_RET_OK) {
+			/* a node id seen twice, keep only the first */
+			vnl_free(ent->vnl);
+			free(ent);
 		}
 	}
+	alps_node_cache_free(old_cache);
+	old_cache = NULL;
+
+	snprintf(log_buffer, sizeof(log_buffer), "%d of %d compute nodes changed", changed, total);
+	log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_NODE, LOG_DEBUG,
+		  __func__, log_buffer);
 	internal_state_update = UPDATE_MOM_STATE;
 
 	/* merge any existing vnodes into the new set */
@@ -7506,7 +7653,7 @@ static element_handler_t handler[] =
 	{
 		BASIL_ELM_NODE,
 		node_start,
-		default_element_end,
+		node_end,
 		disallow_char_data
 	},
 	{
@@ -67,7 +67,11 @@
 #include <sys/resource.h>
 #include <sys/utsname.h>
 #include <sys/wait.h>
+#include <sys/socket.h>
 #include <signal.h>
+#include <linux/netlink.h>
+#include <linux/connector.h>
+#include <linux/cn_proc.h>
 
 #include "mom_mach.h"
 #include "pbs_error.h"
@@ -86,6 +90,9 @@
 #include "pbs_ifl.h"
 #include "placementsets.h"
 #include "mom_vnode.h"
+#include "net_connect.h"
+#include "pbs_idx.h"
+#include "pbs_usdt.h"
 
 /**
  * @file
@@ -133,6 +140,41 @@ proc_stat_t *proc_info = NULL;
 int nproc = 0;
 int max_proc = 0;
 
+/*
+ * The previous sample, in /proc order.  Processes outside of any job
+ * session cannot join one, so while the set of job sessions is unchanged
+ * their entries are carried over instead of reading /proc/<pid>/stat again.
+ */
+static proc_stat_t *proc_prev = NULL;
+static int nproc_prev = 0;
+static int max_proc_prev = 0;
+static int proc_prev_sorted = 0; /* proc_prev is ordered by pid */
+
+static pid_t *job_sids = NULL; /* sessions of the job tasks, sorted */
+static int njob_sids = 0;
+
+/* where the cgroups hook creates job cgroups, with its default cgroup_prefix */
+#define CGROUP_MOUNT "/sys/fs/cgroup"
+#define CGROUP_JOBS_DIR "pbs_jobs.service/jobid"
+
+/*
+ * With $proc_connector set, the processes forked by mom and all of their
+ * descendants are followed through the kernel proc connector, so that the
+ * processes of a session can be found without reading /proc.
+ */
+typedef struct pconn_proc {
+	pid_t pc_pid;
+	pid_t pc_ppid;
+	pid_t pc_sid; /* -1 until known */
+} pconn_proc;
+
+static int pconn_fd = -1;	/* proc connector socket */
+static pid_t pconn_owner = 0;	/* pid of the mom that opened it */
+static int pconn_valid = 0;	/* pconn_idx is complete, no events lost */
+static void *pconn_idx = NULL;	/* pid -> pconn_proc */
+
+extern int proc_connector;
+
 extern char *ret_string;
 extern char extra_parm[];
 extern char no_parm[];
@@ -140,6 +182,7 @@ extern int exiting_tasks;
 extern vnl_t *vnlp;
 
 extern time_t time_now;
+extern pbs_list_head svr_alljobs;
 
 /*
  ** external functions and data
@@ -471,6 +514,221 @@ injob(job *pjob, pid_t sid)
 	return FALSE;
 }
 
+/**
+ * @brief
+ * 	Read a value from a cgroup accounting file.
+ *
+ * @param[in] path - the file
+ * @param[in] key - name of the "key value" line to read, NULL for a file
+ *		    holding one number
+ * @param[out] val - the value
+ *
+ * @return	int
+ * @retval	0	Success
+ * @retval	-1	no such file or value
+ *
+ */
+static int
+read_cgroup_value(char *path, char *key, unsigned long long *val)
+{
+	FILE *fp;
+	char line[256];
+	size_t klen = 0;
+	int rc = -1;
+
+	if ((fp = fopen(path, "r")) == NULL)
+		return -1;
+	if (key != NULL)
+		klen = strlen(key);
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if ((key == NULL) || ((strncmp(line, key, klen) == 0) && (line[klen] == ' '))) {
+			if (sscanf(line + klen, "%llu", val) == 1)
+				rc = 0;
+			break;
+		}
+	}
+	fclose(fp);
+	return rc;
+}
+
+/**
+ * @brief
+ * 	Tell whether cgroups are mounted as the unified (v2) hierarchy.
+ *
+ * @return	int
+ * @retval	1	cgroup v2
+ * @retval	0	cgroup v1 or none
+ *
+ */
+static int
+cgroup_unified(void)
+{
+	static int unified = -1;
+	struct stat sb;
+
+	if (unified == -1)
+		unified = (stat(CGROUP_MOUNT "/cgroup.controllers", &sb) == 0);
+	return unified;
+}
+
+/**
+ * @brief
+ * 	Get the cpu time charged to the cgroup the cgroups hook created for
+ *	the job, which includes the processes that have exited.
+ *
+ * @param[in] pjob - job pointer
+ * @param[out] cput - cpu time in seconds
+ *
+ * @return	int
+ * @retval	0	Success
+ * @retval	-1	the job has no cgroup
+ *
+ */
+static int
+job_cgroup_cput(job *pjob, unsigned long *cput)
+{
+	char path[MAXPATHLEN + 1];
+	unsigned long long val;
+
+	if (cgroup_unified()) {
+		snprintf(path, sizeof(path), "%s/%s/%s/cpu.stat",
+			 CGROUP_MOUNT, CGROUP_JOBS_DIR, pjob->ji_qs.ji_jobid);
+		if (read_cgroup_value(path, "usage_usec", &val) != 0)
+			return -1;
+		*cput = (unsigned long) (val / 1000000);
+	} else {
+		snprintf(path, sizeof(path), "%s/cpuacct/%s/%s/cpuacct.usage",
+			 CGROUP_MOUNT, CGROUP_JOBS_DIR, pjob->ji_qs.ji_jobid);
+		if (read_cgroup_value(path, NULL, &val) != 0)
+			return -1;
+		*cput = (unsigned long) (val / 1000000000);
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ * 	Get the memory used by the job's cgroup, its peak when the kernel
+ *	keeps one.
+ *
+ * @param[in] pjob - job pointer
+ * @param[out] mem - memory in bytes
+ *
+ * @return	int
+ * @retval	0	Success
+ * @retval	-1	the job has no cgroup
+ *
+ */
+static int
+job_cgroup_mem(job *pjob, unsigned long *mem)
+{
+	char path[MAXPATHLEN + 1];
+	unsigned long long val;
+	char *dir;
+	char *files[2];
+	int i;
+
+	if (cgroup_unified()) {
+		dir = "";
+		files[0] = "memory.peak";
+		files[1] = "memory.current";
+	} else {
+		dir = "memory/";
+		files[0] = "memory.max_usage_in_bytes";
+		files[1] = "memory.usage_in_bytes";
+	}
+	for (i = 0; i < 2; i++) {
+		snprintf(path, sizeof(path), "%s/%s%s/%s/%s", CGROUP_MOUNT, dir,
+			 CGROUP_JOBS_DIR, pjob->ji_qs.ji_jobid, files[i]);
+		if (read_cgroup_value(path, NULL, &val) == 0) {
+			*mem = (unsigned long) val;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+static int
+cmp_sid(const void *a, const void *b)
+{
+	pid_t s1 = *(const pid_t *) a;
+	pid_t s2 = *(const pid_t *) b;
+
+	return ((s1 < s2) ? -1 : (s1 > s2));
+}
+
+/**
+ * @brief
+ * 	Collect the sessions of all live job tasks into job_sids[].
+ *
+ * @return	int
+ * @retval	1	the set is the same as at the previous call
+ * @retval	0	it changed (or could not be built)
+ *
+ */
+static int
+collect_job_sessions(void)
+{
+	pid_t *sids = NULL;
+	pid_t *hold;
+	int nsids = 0;
+	int max_sids = 0;
+	int same;
+	job *pjob;
+	task *ptask;
+
+	for (pjob = (job *) GET_NEXT(svr_alljobs); pjob; pjob = (job *) GET_NEXT(pjob->ji_alljobs)) {
+		for (ptask = (task *) GET_NEXT(pjob->ji_tasks); ptask;
+		     ptask = (task *) GET_NEXT(ptask->ti_jobtask)) {
+			if (ptask->ti_qs.ti_sid <= 1)
+				continue;
+			if (nsids == max_sids) {
+				hold = realloc(sids, (max_sids + TBL_INC) * sizeof(pid_t));
+				if (hold == NULL) {
+					log_err(errno, __func__, "realloc");
+					free(sids);
+					free(job_sids);
+					job_sids = NULL;
+					njob_sids = 0;
+					return 0;
+				}
+				sids = hold;
+				max_sids += TBL_INC;
+			}
+			sids[nsids++] = ptask->ti_qs.ti_sid;
+		}
+	}
+	if (nsids > 1)
+		qsort(sids, nsids, sizeof(pid_t), cmp_sid);
+
+	same = (nsids == njob_sids) &&
+	       ((nsids == 0) || (memcmp(sids, job_sids, nsids * sizeof(pid_t)) == 0));
+	free(job_sids);
+	job_sids = sids;
+	njob_sids = nsids;
+	return same;
+}
+
+/**
+ * @brief
+ * 	Tell whether a session is that of a job task, per the last
+ *	collect_job_sessions().
+ *
+ * @param[in] sid - session id
+ *
+ * @return	int
+ * @retval	TRUE	it is
+ * @retval	FALSE	it is not
+ *
+ */
+static int
+is_job_session(pid_t sid)
+{
+	if (njob_sids == 0)
+		return FALSE;
+	return (bsearch(&sid, job_sids, njob_sids, sizeof(pid_t), cmp_sid) != NULL);
+}
+
 /**
  * @brief
  * 	Internal session cpu time decoding routine.
@@ -882,6 +1140,309 @@ mom_do_poll(job *pjob)
 	return (FALSE);
 }
 
+/**
+ * @brief
+ * 	Tell whether the proc connector map can be used by this process.
+ *	A child of mom inherits the socket but must not read from it.
+ *
+ * @return	int
+ * @retval	TRUE	the socket is open and belongs to this process
+ * @retval	FALSE	otherwise
+ *
+ */
+static int
+pconn_active(void)
+{
+	return ((pconn_fd != -1) && (pconn_owner == getpid()));
+}
+
+/**
+ * @brief
+ * 	Record a process in the proc connector map, or update its entry.
+ *
+ * @param[in] pid - the process
+ * @param[in] ppid - its parent
+ * @param[in] sid - its session, -1 if not known yet
+ *
+ * @return	Void
+ *
+ */
+static void
+pconn_add(pid_t pid, pid_t ppid, pid_t sid)
+{
+	pconn_proc *pp = NULL;
+	void *key = &pid;
+
+	if (pbs_idx_find(pconn_idx, &key, (void **) &pp, NULL) == PBS_IDX_RET_OK) {
+		pp->pc_ppid = ppid;
+		pp->pc_sid = sid;
+		return;
+	}
+	if ((pp = (pconn_proc *) malloc(sizeof(pconn_proc))) == NULL) {
+		log_err(errno, __func__, "malloc");
+		pconn_valid = 0;
+		return;
+	}
+	pp->pc_pid = pid;
+	pp->pc_ppid = ppid;
+	pp->pc_sid = sid;
+	if (pbs_idx_insert(pconn_idx, &pp->pc_pid, pp) != PBS_IDX_RET_OK) {
+		free(pp);
+		pconn_valid = 0;
+	}
+}
+
+/**
+ * @brief
+ * 	Empty the proc connector map.
+ *
+ * @return	Void
+ *
+ */
+static void
+pconn_forget_all(void)
+{
+	pconn_proc *pp = NULL;
+	void *ctx = NULL;
+
+	if (pconn_idx == NULL)
+		return;
+	while (pbs_idx_find(pconn_idx, NULL, (void **) &pp, &ctx) == PBS_IDX_RET_OK)
+		free(pp);
+	pbs_idx_free_ctx(ctx);
+	pbs_idx_destroy(pconn_idx);
+	pconn_idx = pbs_idx_create(0, sizeof(pid_t));
+	pconn_valid = 0;
+}
+
+/**
+ * @brief
+ * 	Apply one proc connector event to the map.
+ *	Thread events are ignored, only thread group leaders are kept.
+ *
+ * @param[in] ev - the event
+ *
+ * @return	Void
+ *
+ */
+static void
+pconn_event(struct proc_event *ev)
+{
+	pconn_proc *pp = NULL;
+	pid_t pid;
+	void *key = &pid;
+
+	switch (ev->what) {
+		case PROC_EVENT_FORK:
+			if (ev->event_data.fork.child_pid != ev->event_data.fork.child_tgid)
+				break;
+			pid = ev->event_data.fork.parent_tgid;
+			if (pid == mom_pid)
+				pconn_add(ev->event_data.fork.child_tgid, pid, -1);
+			else if (pbs_idx_find(pconn_idx, &key, (void **) &pp, NULL) == PBS_IDX_RET_OK)
+				pconn_add(ev->event_data.fork.child_tgid, pid, pp->pc_sid);
+			break;
+
+		case PROC_EVENT_SID:
+			pid = ev->event_data.sid.process_tgid;
+			if (pbs_idx_find(pconn_idx, &key, (void **) &pp, NULL) == PBS_IDX_RET_OK)
+				pp->pc_sid = pid;
+			break;
+
+		case PROC_EVENT_EXIT:
+			if (ev->event_data.exit.process_pid != ev->event_data.exit.process_tgid)
+				break;
+			pid = ev->event_data.exit.process_tgid;
+			if (pbs_idx_find(pconn_idx, &key, (void **) &pp, NULL) == PBS_IDX_RET_OK) {
+				(void) pbs_idx_delete(pconn_idx, &pid);
+				free(pp);
+			}
+			break;
+
+		default:
+			break;
+	}
+}
+
+/**
+ * @brief
+ * 	Read the pending proc connector events.
+ *	Called from the connection table when the socket is readable, and
+ *	before the map is used.  When the kernel reports that events were
+ *	dropped, the map is emptied until the next sample reseeds it.
+ *
+ * @param[in] fd - the proc connector socket
+ *
+ * @return	Void
+ *
+ */
+static void
+pconn_read(int fd)
+{
+	long buf[8192 / sizeof(long)];
+	struct sockaddr_nl from;
+	socklen_t fromlen;
+	struct nlmsghdr *nlh;
+	struct cn_msg *cn;
+	ssize_t len;
+
+	if (!pconn_active())
+		return;
+
+	for (;;) {
+		fromlen = sizeof(from);
+		len = recvfrom(fd, buf, sizeof(buf), MSG_DONTWAIT,
+			       (struct sockaddr *) &from, &fromlen);
+		if (len == -1) {
+			if (errno == EINTR)
+				continue;
+			if (errno == ENOBUFS) {
+				log_event(PBSEVENT_DEBUG, 0, LOG_DEBUG, __func__,
+					  "proc connector events lost, reading /proc until resync");
+				pconn_forget_all();
+				continue;
+			}
+			if (errno != EAGAIN && errno != EWOULDBLOCK)
+				log_err(errno, __func__, "recvfrom");
+			return;
+		}
+		if (len == 0)
+			return;
+		if (from.nl_pid != 0 || !pconn_valid)
+			continue; /* not from the kernel, or out of sync */
+
+		for (nlh = (struct nlmsghdr *) buf; NLMSG_OK(nlh, (size_t) len);
+		     nlh = NLMSG_NEXT(nlh, len)) {
+			if (nlh->nlmsg_type == NLMSG_NOOP)
+				continue;
+			if (nlh->nlmsg_type == NLMSG_ERROR || nlh->nlmsg_type == NLMSG_OVERRUN) {
+				pconn_forget_all();
+				break;
+			}
+			cn = (struct cn_msg *) NLMSG_DATA(nlh);
+			if (cn->id.idx == CN_IDX_PROC && cn->id.val == CN_VAL_PROC)
+				pconn_event((struct proc_event *) cn->data);
+			if (nlh->nlmsg_type == NLMSG_DONE)
+				break;
+		}
+	}
+}
+
+/**
+ * @brief
+ * 	Subscribe to the kernel proc connector.
+ *	Failure is not fatal, mom then keeps reading /proc.
+ *
+ * @return	Void
+ *
+ */
+static void
+pconn_open(void)
+{
+	struct sockaddr_nl addr;
+	long buf[(NLMSG_SPACE(sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op)) + sizeof(long) - 1) / sizeof(long)];
+	struct nlmsghdr *nlh;
+	struct cn_msg *cn;
+	enum proc_cn_mcast_op op = PROC_CN_MCAST_LISTEN;
+	conn_t *conn;
+	int fd;
+
+	fd = socket(PF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+	if (fd == -1) {
+		log_err(errno, __func__, "proc connector socket");
+		return;
+	}
+	memset(&addr, 0, sizeof(addr));
+	addr.nl_family = AF_NETLINK;
+	addr.nl_groups = CN_IDX_PROC;
+	if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) == -1) {
+		log_err(errno, __func__, "proc connector bind");
+		(void) close(fd);
+		return;
+	}
+
+	memset(buf, 0, sizeof(buf));
+	nlh = (struct nlmsghdr *) buf;
+	nlh->nlmsg_len = NLMSG_LENGTH(sizeof(struct cn_msg) + sizeof(op));
+	nlh->nlmsg_type = NLMSG_DONE;
+	nlh->nlmsg_pid = getpid();
+	cn = (struct cn_msg *) NLMSG_DATA(nlh);
+	cn->id.idx = CN_IDX_PROC;
+	cn->id.val = CN_VAL_PROC;
+	cn->len = sizeof(op);
+	memcpy(cn->data, &op, sizeof(op));
+	if (send(fd, nlh, nlh->nlmsg_len, 0) == -1) {
+		log_err(errno, __func__, "proc connector subscribe");
+		(void) close(fd);
+		return;
+	}
+
+	if ((pconn_idx = pbs_idx_create(0, sizeof(pid_t))) == NULL) {
+		log_err(-1, __func__, "pbs_idx_create");
+		(void) close(fd);
+		return;
+	}
+	if ((conn = add_conn(fd, ChildPipe, (pbs_net_t) 0, 0, NULL, pconn_read)) == NULL) {
+		log_err(-1, __func__, "proc connector, connection table is full");
+		pbs_idx_destroy(pconn_idx);
+		pconn_idx = NULL;
+		(void) close(fd);
+		return;
+	}
+	conn->cn_authen |= PBS_NET_CONN_AUTHENTICATED | PBS_NET_CONN_NOTIMEOUT;
+	pconn_fd = fd;
+	pconn_owner = getpid();
+	pconn_valid = 0;
+	log_event(PBSEVENT_SYSTEM, 0, LOG_INFO, __func__,
+		  "following job processes through the proc connector");
+}
+
+/**
+ * @brief
+ * 	Unsubscribe from the proc connector and drop the map.
+ *
+ * @return	Void
+ *
+ */
+static void
+pconn_close(void)
+{
+	if (!pconn_active())
+		return;
+	pconn_forget_all();
+	pbs_idx_destroy(pconn_idx);
+	pconn_idx = NULL;
+	close_conn(pconn_fd);
+	pconn_fd = -1;
+}
+
+/**
+ * @brief
+ * 	Fill the empty proc connector map from the sample just taken:
+ *	the processes in job sessions and the children of mom.  Events read
+ *	from now on keep it current.
+ *
+ * @return	Void
+ *
+ */
+static void
+pconn_seed(void)
+{
+	int i;
+
+	if (pconn_idx == NULL && (pconn_idx = pbs_idx_create(0, sizeof(pid_t))) == NULL)
+		return;
+	pconn_valid = 1;
+	for (i = 0; i < nproc && pconn_valid; i++) {
+		if (PBS_PROC_PID(i) <= 1)
+			continue;
+		if (proc_info[i].injob || (PBS_PROC_PPID(i) == mom_pid))
+			pconn_add(PBS_PROC_PID(i), PBS_PROC_PPID(i), PBS_PROC_SID(i));
+	}
+	if (!pconn_valid)
+		pconn_forget_all();
+}
+
 /**
  * @brief
  * 	Setup for polling.
@@ -904,20 +1465,51 @@ mom_open_poll(void)
 	}
 	max_proc = TBL_INC;
 
+	if (proc_connector)
+		pconn_open();
+
 	return (PBSE_NONE);
 }
 
 /**
  * @brief
- * 	Declare start of polling loop.
+ * 	Make room for one more entry in proc_info[].
+ *
+ * @return	Void
+ *
+ */
+static void
+proc_info_grow(void)
+{
+	void *hold;
+
+	DBPRT(("%s: alloc more proc table space %d\n", __func__, nproc))
+	max_proc += TBL_INC;
+	hold = realloc((void *) proc_info,
+		       max_proc * sizeof(proc_stat_t));
+	assert(hold != NULL);
+	proc_info = (proc_stat_t *) hold;
+}
+
+/**
+ * @brief
+ * 	Sample the process table into proc_info[].
+ *
+ *	Unless all is set, a process seen in the previous sample outside of
+ *	any job session is carried over from that sample without reading its
+ *	stat file again, as long as the job sessions are the same and its
+ *	/proc entry has not been replaced (pid reuse).  Its times and sizes are
+ *	then stale, which does not matter for job accounting.
+ *
+ * @param[in] all - read every process, for queries about any pid or session
  *
  * @return	int
  * @retval	PBSE_INTERNAL	Dir pdir in NULL
  * @retval	PBSE_NONE	Success
  *
  */
-int
-mom_get_sample(void)
+static int
+get_sample(int all)
 {
 	struct dirent *dent = NULL;
 	FILE *fd = NULL;
@@ -934,6 +1526,13 @@ mom_get_sample(void)
 	int nskipped = 0;
 	extern time_t time_last_sample;
 	char *stat_str = NULL;
+	proc_stat_t *hold;
+	int use_prev;
+	int sorted = 1;
+	int cur = 0;
+	int tmp;
+	pid_t pid;
+	pid_t lastpid = 0;
 
 	/* There are no job tasks created in mock run mode, so no need to walk the proc table */
 	if (mock_run)
@@ -943,6 +1542,29 @@ mom_get_sample(void)
 	if (pdir == NULL)
 		return PBSE_INTERNAL;
 
+	use_prev = collect_job_sessions() && proc_prev_sorted && !all;
+
+	/* drop stale events, the map is reseeded from this sample */
+	if (pconn_active() && !pconn_valid)
+		pconn_read(pconn_fd);
+
+	/* the current sample becomes the previous one */
+	hold = proc_prev;
+	proc_prev = proc_info;
+	proc_info = hold;
+	nproc_prev = nproc;
+	tmp = max_proc_prev;
+	max_proc_prev = max_proc;
+	max_proc = tmp;
+	if (proc_info == NULL || max_proc == 0) {
+		proc_info = (proc_stat_t *) malloc(sizeof(proc_stat_t) * TBL_INC);
+		if (proc_info == NULL) {
+			log_err(errno, __func__, "malloc");
+			return PBSE_SYSTEM;
+		}
+		max_proc = TBL_INC;
+	}
+
 	rewinddir(pdir);
 	nproc = 0;
 	fd = NULL;
@@ -972,6 +1594,29 @@ mom_get_sample(void)
 			nskipped++;
 			continue;
 		}
+
+		if (!nomem) {
+			pid = (pid_t) atoi(dent->d_name);
+			if (pid < lastpid)
+				sorted = 0;
+			lastpid = pid;
+			if (use_prev && sorted) {
+				while ((cur < nproc_prev) && (proc_prev[cur].pid < pid))
+					cur++;
+				if ((cur < nproc_prev) && (proc_prev[cur].pid == pid) &&
+				    !proc_prev[cur].injob &&
+				    (proc_prev[cur].ino == sbuf.st_ino) &&
+				    (proc_prev[cur].uid == sbuf.st_uid)) {
+					proc_info[nproc] = proc_prev[cur];
+					ncached++;
+					if (++nproc == max_proc)
+						proc_info_grow();
+					continue;
+				}
+			}
+		} else
+			sorted = 0;
+
 		snprintf(procname, sizeof(procname), "/proc/%s/stat", dent->d_name);
 
 		if ((fd = fopen(procname, "r")) == NULL) {
@@ -1021,6 +1666,8 @@ mom_get_sample(void)
 			continue;
 		}
 		ps->uid = sb.st_uid;
+		ps->ino = sbuf.st_ino;
+		ps->injob = is_job_session(ps->session);
 		fclose(fd);
 
 		/*
@@ -1040,19 +1687,15 @@ mom_get_sample(void)
 		ps->stime = JTOS(ps->stime);
 		ps->cutime = JTOS(ps->cutime);
 		ps->cstime = JTOS(ps->cstime);
-		if (++nproc == max_proc) {
-			void *hold;
-			DBPRT(("%s: alloc more proc table space %d\n", __func__, nproc))
-			max_proc += TBL_INC;
-			hold = realloc((void *) proc_info,
-				       max_proc * sizeof(proc_stat_t));
-			assert(hold != NULL);
-			proc_info = (proc_stat_t *) hold;
-		}
+		if (++nproc == max_proc)
+			proc_info_grow();
 	}
 	if (errno != 0 && errno != ENOENT)
 		log_err(errno, __func__, "readdir");
+	proc_prev_sorted = sorted;
 	sampletime_ceil = time_last_sample;
+	if (pconn_active() && !pconn_valid)
+		pconn_seed();
 	sprintf(log_buffer,
 		"nprocs:  %d, cantstat:  %d, nomem:  %d, skipped:  %d, "
 		"cached:  %d",
@@ -1062,6 +1705,26 @@ mom_get_sample(void)
 	return (PBSE_NONE);
 }
 
+/**
+ * @brief
+ * 	Declare start of polling loop.
+ *
+ * @return	int
+ * @retval	PBSE_INTERNAL	Dir pdir in NULL
+ * @retval	PBSE_NONE	Success
+ *
+ */
+int
+mom_get_sample(void)
+{
+	int rc;
+
+	PBS_PROBE(get__sample__start);
+	rc = get_sample(0);
+	PBS_PROBE1(get__sample__done, rc);
+	return (rc);
+}
+
 /**
  * @brief
  * 	Update the resources used.<attributes> of a job.
@@ -1089,7 +1752,11 @@ mom_set_use(job *pjob)
 	resource_def *rd;
 	u_Long *lp_sz, lnum_sz;
 	unsigned long *lp, lnum, oldcput;
+	unsigned long cgval;
 	long ncpus_req;
+	long cpupct = 0;
+	u_Long mem_kb = 0;
+	u_Long vmem_kb = 0;
 
 	assert(pjob != NULL);
 	at = get_jattr(pjob, JOB_ATR_resc_used);
@@ -1134,7 +1801,9 @@ mom_set_use(job *pjob)
 	}
 	lp = (unsigned long *) &pres->rs_value.at_val.at_long;
 	oldcput = *lp;
-	lnum = cput_sum(pjob);
+	lnum = cput_sum(pjob); /* also notices tasks that are gone */
+	if (job_cgroup_cput(pjob, &cgval) == 0)
+		lnum = MAX(lnum, (unsigned long) ((double) cgval * cputfactor));
 	lnum = MAX(*lp, lnum);
 	if ((pres->rs_value.at_flags & ATR_VFLAG_HOOK) == 0) {
 		/* don't conflict with hook setting a value */
@@ -1154,6 +1823,7 @@ mom_set_use(job *pjob)
 		/* percentage */
 		calc_cpupercent(pjob, oldcput, lnum, sampletime_ceil);
 	}
+	cpupct = pres->rs_value.at_val.at_long;
 	pjob->ji_sampletim = sampletime_floor;
 
 	rd = &svr_resc_def[RESC_VMEM];
@@ -1168,6 +1838,7 @@ mom_set_use(job *pjob)
 		lp_sz = &pres->rs_value.at_val.at_size.atsv_num;
 		lnum_sz = (mem_sum(pjob) + 1023) >> 10; /* as KB */
 		*lp_sz = MAX(*lp_sz, lnum_sz);
+		vmem_kb = lnum_sz;
 	}
 
 	/* update walltime usage */
@@ -1183,13 +1854,87 @@ mom_set_use(job *pjob)
 		pres->rs_value.at_val.at_size.atsv_units = ATR_SV_BYTESZ;
 	} else if ((pres->rs_value.at_flags & ATR_VFLAG_HOOK) == 0) {
 		lp_sz = &pres->rs_value.at_val.at_size.atsv_num;
-		lnum_sz = (resi_sum(pjob) + 1023) >> 10; /* as KB */
+		if (job_cgroup_mem(pjob, &cgval) != 0)
+			cgval = resi_sum(pjob);
+		lnum_sz = (cgval + 1023) >> 10; /* as KB */
 		*lp_sz = MAX(*lp_sz, lnum_sz);
+		mem_kb = lnum_sz;
 	}
 
+	job_sample(pjob, lnum, cpupct, mem_kb, vmem_kb);
+
 	return (PBSE_NONE);
 }
 
+/**
+ * @brief
+ * 	Append a process to Proc_lnks[], with no links yet.
+ *
+ * @param[in]	ct:	number of entries in use
+ * @param[in]	pid:	the process
+ * @param[in]	ppid:	its parent
+ *
+ * @return	int
+ * @retval	number of entries in use
+ *
+ */
+static int
+ptree_add(int ct, pid_t pid, pid_t ppid)
+{
+	if (Proc_lnks == NULL) {
+		Proc_lnks = (pbs_plinks *) malloc(TBL_INC * sizeof(pbs_plinks));
+		assert(Proc_lnks != NULL);
+		myproc_max = TBL_INC;
+	}
+
+	Proc_lnks[ct].pl_pid = pid;
+	Proc_lnks[ct].pl_ppid = ppid;
+	Proc_lnks[ct].pl_parent = -1;
+	Proc_lnks[ct].pl_sib = -1;
+	Proc_lnks[ct].pl_child = -1;
+	Proc_lnks[ct].pl_done = 0;
+	if (++ct == myproc_max) {
+		void *hold;
+
+		myproc_max += TBL_INC;
+		hold = realloc((void *) Proc_lnks,
+			       myproc_max * sizeof(pbs_plinks));
+		assert(hold != NULL);
+		Proc_lnks = (pbs_plinks *) hold;
+	}
+	return (ct);
+}
+
+/**
+ * @brief
+ * 	Link the first ct entries of Proc_lnks[] into a tree.
+ *
+ * @param[in]	ct:	number of entries in use
+ *
+ * @return	Void
+ *
+ */
+static void
+ptree_link(int ct)
+{
+	int i, j;
+
+	for (i = 0; i < ct; i++) {
+		/*
+		 * Find all the children for this process, establish links.
+		 */
+		for (j = 0; j < ct; j++) {
+			if (j == i)
+				continue;
+			if (Proc_lnks[j].pl_ppid == Proc_lnks[i].pl_pid) {
+				Proc_lnks[j].pl_parent = i;
+				Proc_lnks[j].pl_sib = Proc_lnks[i].pl_child;
+				Proc_lnks[i].pl_child = j;
+			}
+		}
+	}
+}
+
 /**
  * @brief
  * 	bld_ptree - establish links (parent, child, and sibling) for processes
@@ -1210,13 +1955,7 @@ int
 bld_ptree(pid_t sid)
 {
 	int myproc_ct; /* count of processes in a session */
-	int i, j;
-
-	if (Proc_lnks == NULL) {
-		Proc_lnks = (pbs_plinks *) malloc(TBL_INC * sizeof(pbs_plinks));
-		assert(Proc_lnks != NULL);
-		myproc_max = TBL_INC;
-	}
+	int i;
 
 	/*
 	 * Build links for processes in the session in question.
@@ -1227,42 +1966,48 @@ bld_ptree(pid_t sid)
 	for (i = 0; i < nproc; i++) {
 		if (PBS_PROC_PID(i) <= 1)
 			continue;
-		if ((int) PBS_PROC_SID(i) == sid) {
-			Proc_lnks[myproc_ct].pl_pid = PBS_PROC_PID(i);
-			Proc_lnks[myproc_ct].pl_ppid = PBS_PROC_PPID(i);
-			Proc_lnks[myproc_ct].pl_parent = -1;
-			Proc_lnks[myproc_ct].pl_sib = -1;
-			Proc_lnks[myproc_ct].pl_child = -1;
-			Proc_lnks[myproc_ct].pl_done = 0;
-			if (++myproc_ct == myproc_max) {
-				void *hold;
-
-				myproc_max += TBL_INC;
-				hold = realloc((void *) Proc_lnks,
-					       myproc_max * sizeof(pbs_plinks));
-				assert(hold != NULL);
-				Proc_lnks = (pbs_plinks *) hold;
-			}
-		}
+		if ((int) PBS_PROC_SID(i) == sid)
+			myproc_ct = ptree_add(myproc_ct, PBS_PROC_PID(i), PBS_PROC_PPID(i));
 	}
 
-	/* Now build the tree for those processes */
+	ptree_link(myproc_ct);
+	return (myproc_ct); /* number of processes in session */
+}
 
-	for (i = 0; i < myproc_ct; i++) {
-		/*
-		 * Find all the children for this process, establish links.
-		 */
-		for (j = 0; j < myproc_ct; j++) {
-			if (j == i)
-				continue;
-			if (Proc_lnks[j].pl_ppid == Proc_lnks[i].pl_pid) {
-				Proc_lnks[j].pl_parent = i;
-				Proc_lnks[j].pl_sib = Proc_lnks[i].pl_child;
-				Proc_lnks[i].pl_child = j;
-			}
-		}
+/**
+ * @brief
+ * 	Establish the Proc_lnks[] links for a session, like bld_ptree(),
+ *	taking its processes from the proc connector map when that is
+ *	current and from a new sample of /proc otherwise.
+ *
+ * @param[in]	sid:	session id
+ *
+ * @return	int
+ * @retval	number of processes in session
+ *
+ */
+int
+bld_session_ptree(pid_t sid)
+{
+	pconn_proc *pp = NULL;
+	void *ctx = NULL;
+	int ct = 0;
+
+	if (pconn_active())
+		pconn_read(pconn_fd);
+	if (!pconn_active() || !pconn_valid) {
+		(void) mom_get_sample();
+		return (bld_ptree(sid));
 	}
-	return (myproc_ct); /* number of processes in session */
+
+	while (pbs_idx_find(pconn_idx, NULL, (void **) &pp, &ctx) == PBS_IDX_RET_OK) {
+		if (pp->pc_sid == sid && pp->pc_pid > 1)
+			ct = ptree_add(ct, pp->pc_pid, pp->pc_ppid);
+	}
+	pbs_idx_free_ctx(ctx);
+
+	ptree_link(ct);
+	return (ct);
 }
 
 /**
@@ -1342,9 +2087,8 @@ kill_session(pid_t sesid, int sig, int dir)
 	if (sesid <= 1)
 		return 0;
 
-	(void) mom_get_sample();
-	ct = bld_ptree(sesid);
-	DBPRT(("%s: bld_ptree %d\n", __func__, ct))
+	ct = bld_session_ptree(sesid);
+	DBPRT(("%s: bld_session_ptree %d\n", __func__, ct))
 
 	/*
 	 ** Find index into the Proc_lnks table for the session lead.
@@ -1399,6 +2143,7 @@ mom_close_poll(void)
 		proc_info = NULL;
 		max_proc = 0;
 	}
+	pconn_close();
 
 	return (PBSE_NONE);
 }
@@ -1451,7 +2196,7 @@ getprocs(void)
 	if (lastproc == reqnum) /* don't need new proc table */
 		return 1;
 
-	if (mom_get_sample() != PBSE_NONE)
+	if (get_sample(1) != PBSE_NONE)
 		return 0;
 
 	lastproc = reqnum;
@@ -1520,7 +2265,7 @@ cput_proc(pid_t pid)
 	double cputime;
 	proc_stat_t *ps = NULL;
 
-	mom_get_sample();
+	(void) get_sample(1);
 	for (i = 0; i < nproc; i++) {
 		ps = &proc_info[i];
 		if (ps->pid == pid)
@@ -1599,7 +2344,7 @@ mem_job(pid_t sid)
 
 	memsize = 0;
 
-	mom_get_sample();
+	(void) get_sample(1);
 	for (i = 0; i < nproc; i++) {
 
 		ps = &proc_info[i];
@@ -1635,7 +2380,7 @@ mem_proc(pid_t pid)
 	int i;
 	proc_stat_t *ps = NULL;
 
-	mom_get_sample();
+	(void) get_sample(1);
 	for (i = 0; i < nproc; i++) {
 		ps = &proc_info[i];
 		if (ps->pid == pid)
@@ -1713,7 +2458,7 @@ resi_job(pid_t jobid)
 	proc_stat_t *ps;
 
 	resisize = 0;
-	mom_get_sample();
+	(void) get_sample(1);
 
 	for (i = 0; i < nproc; i++) {
 
@@ -1752,7 +2497,7 @@ resi_proc(pid_t pid)
 	int i;
 	proc_stat_t *ps = NULL;
 
-	mom_get_sample();
+	(void) get_sample(1);
 	for (i = 0; i < nproc; i++) {
 		ps = &proc_info[i];
 		if (ps->pid == pid)
@@ -1843,7 +2588,7 @@ sessions(struct rm_attribute *attrib)
 		return NULL;
 	}
 
-	mom_get_sample();
+	(void) get_sample(1);
 
 	/*
 	 ** Search for members of session
@@ -1958,7 +2703,7 @@ pids(struct rm_attribute *attrib)
 		return NULL;
 	}
 
-	mom_get_sample();
+	(void) get_sample(1);
 
 	/*
 	 ** Search for members of session
@@ -2018,7 +2763,7 @@ nusers(struct rm_attribute *attrib)
 		return NULL;
 	}
 
-	mom_get_sample();
+	(void) get_sample(1);
 	for (i = 0; i < nproc; i++) {
 		ps = &proc_info[i];
 
@@ -2836,7 +3581,7 @@ walltime(struct rm_attribute *attrib)
 		rm_errno = RM_ERR_SYSTEM;
 		return NULL;
 	}
-	mom_get_sample();
+	(void) get_sample(1);
 
 	start = now;
 	for (i = 0; i < nproc; i++) {
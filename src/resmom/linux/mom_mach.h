@@ -86,6 +86,7 @@ typedef struct pbs_plinks { /* struct to link processes */
 extern unsigned long totalmem;
 extern int kill_session(pid_t pid, int sig, int dir);
 extern int bld_ptree(pid_t sid);
+extern int bld_session_ptree(pid_t sid);
 
 /* struct startjob_rtn = used to pass error/session/other info 	*/
 /* 			child back to parent			*/
@@ -158,6 +159,8 @@ typedef struct proc_stat {
 	unsigned long flags;	    /* the flags of the process */
 	unsigned long uid;	    /* uid of the process owner */
 	char comm[COMSIZE]; /* command name */
+	ino_t ino;	    /* inode of /proc/<pid>, tells a reused pid apart */
+	int injob;	    /* in the session of a job task when sampled */
 } proc_stat_t;
 
 typedef struct proc_map {
@@ -746,8 +746,7 @@ scan_for_terminated(void)
 		if (pjob->ji_qs.ji_svrflags & JOB_SVFLG_TERMJOB) {
 			int n;
 
-			(void) mom_get_sample();
-			n = bld_ptree(ptask->ti_qs.ti_sid);
+			n = bld_session_ptree(ptask->ti_qs.ti_sid);
 			if (n > 0) {
 				ptask->ti_flags |= TI_FLAGS_ORPHAN;
 				DBPRT(("%s: task %8.8X still has %d active procs\n", __func__,
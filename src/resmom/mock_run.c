@@ -44,6 +44,7 @@
 #include <assert.h>
 #include <time.h>
 #include <errno.h>
+#include <string.h>
 
 #include "attribute.h"
 #include "batch_request.h"
@@ -54,6 +55,7 @@
 #include "pbs_error.h"
 #include "resource.h"
 #include "mom_server.h"
+#include "placementsets.h"
 
 #if defined(PBS_SECURITY) && (PBS_SECURITY == KRB5)
 #include "renew_creds.h"
@@ -64,6 +66,11 @@ extern time_t time_resc_updated;
 extern int min_check_poll;
 extern int next_sample_time;
 
+/* vnodes a mock run mom reports besides its natural vnode, see $mock_vnodes */
+static int mock_nvnodes = 0;
+static long mock_vnode_ncpus = 0;
+static char mock_vnode_mem[32] = "0kb";
+
 void
 mock_run_finish_exec(job *pjob)
 {
@@ -231,9 +238,102 @@ mock_run_mom_set_use(job *pjob)
 	/* update walltime usage */
 	update_walltime(pjob);
 
+	/* a mock job keeps all of its cpus busy for its whole run */
+	pres_req = find_resc_entry(at, rd[0]);
+	pres = find_resc_entry(at, &svr_resc_def[RESC_WALLTIME]);
+	if (pres_req != NULL && pres != NULL) {
+		long ncpus = pres_req->rs_value.at_val.at_long;
+		resource *pcput = find_resc_entry(at, rd[2]);
+		resource *pcpupct = find_resc_entry(at, rd[3]);
+
+		if (pcput != NULL)
+			pcput->rs_value.at_val.at_long = pres->rs_value.at_val.at_long * ncpus;
+		if (pcpupct != NULL)
+			pcpupct->rs_value.at_val.at_long = ncpus * 100;
+	}
+
 	return (PBSE_NONE);
 }
 
+/**
+ * @brief
+ * 	Set the vnodes a mock run mom reports, from the value of the
+ * 	$mock_vnodes config option: "<count> <ncpus> <mem>"
+ *
+ * @param[in]	value - the option value, NULL to report no extra vnodes
+ *
+ * @return int
+ * @retval 0	success
+ * @retval -1	malformed value
+ */
+int
+mock_run_set_vnodes(char *value)
+{
+	int count;
+	long ncpus;
+	char mem[sizeof(mock_vnode_mem)];
+
+	if (value == NULL) {
+		mock_nvnodes = 0;
+		return 0;
+	}
+	if (sscanf(value, "%d %ld %31s", &count, &ncpus, mem) != 3 ||
+	    count < 0 || ncpus < 0)
+		return -1;
+
+	mock_nvnodes = count;
+	mock_vnode_ncpus = ncpus;
+	strcpy(mock_vnode_mem, mem);
+	return 0;
+}
+
+/**
+ * @brief
+ * 	Add the vnodes set by $mock_vnodes to the vnode list of the mom.
+ * 	They are named <mom name>[<n>]; the natural vnode is left without
+ * 	cpus or memory so jobs only land on the mock vnodes, as on a real
+ * 	multi-vnode host.
+ *
+ * @param[in,out]	vnlpp - the mom's vnode list, allocated if NULL
+ *
+ * @return int
+ * @retval 0	success
+ * @retval -1	failure
+ */
+int
+mock_run_add_vnodes(vnl_t **vnlpp)
+{
+	char name[PBS_MAXHOSTNAME + 16];
+	char ncpus[32];
+	int i;
+
+	if (mock_nvnodes == 0)
+		return 0;
+
+	if (*vnlpp == NULL && vnl_alloc(vnlpp) == NULL) {
+		log_err(errno, __func__, "vnl_alloc failed");
+		return -1;
+	}
+
+	if (vn_addvnr(*vnlpp, mom_short_name, "resources_available.ncpus", "0", 0, 0, NULL) == -1 ||
+	    vn_addvnr(*vnlpp, mom_short_name, "resources_available.mem", "0kb", 0, 0, NULL) == -1)
+		return -1;
+
+	snprintf(ncpus, sizeof(ncpus), "%ld", mock_vnode_ncpus);
+	for (i = 0; i < mock_nvnodes; i++) {
+		snprintf(name, sizeof(name), "%s[%d]", mom_short_name, i);
+		if (vn_addvnr(*vnlpp, name, "resources_available.ncpus", ncpus, 0, 0, NULL) == -1 ||
+		    vn_addvnr(*vnlpp, name, "resources_available.mem", mock_vnode_mem, 0, 0, NULL) == -1)
+			return -1;
+	}
+	(*vnlpp)->vnl_modtime = time(NULL);
+
+	log_eventf(PBSEVENT_SYSTEM, PBS_EVENTCLASS_NODE, LOG_INFO, __func__,
+		   "mock run reports %d vnodes with ncpus=%ld mem=%s",
+		   mock_nvnodes, mock_vnode_ncpus, mock_vnode_mem);
+	return 0;
+}
+
 /**
  * @brief	job_purge for mock run mode
  *
@@ -262,6 +362,7 @@ mock_run_job_purge(job *pjob)
 
 	/* delete job file */
 	del_job_related_file(pjob, JOB_FILE_SUFFIX);
+	job_journal_purge(pjob);
 
 	del_chkpt_files(pjob);
 
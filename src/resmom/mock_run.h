@@ -47,6 +47,7 @@ extern "C" {
 
 #include "work_task.h"
 #include "job.h"
+#include "placementsets.h"
 
 void mock_run_finish_exec(job *pjob);
 
@@ -58,6 +59,10 @@ int mock_run_mom_set_use(job *pjob);
 
 void mock_run_job_purge(job *pjob);
 
+int mock_run_set_vnodes(char *value);
+
+int mock_run_add_vnodes(vnl_t **vnlpp);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1760,9 +1760,16 @@ find_node(job *pjob, int stream, tm_node_id vnodeid)
 	struct sockaddr_in *node_addr;
 	struct sockaddr_in *stream_addr;
 
-	for (vp = pjob->ji_vnods, i = 0; i < pjob->ji_numvnod; vp++, i++) {
-		if (vp->vn_node == vnodeid)
-			break;
+	/* vnode ids are normally their index, try that before searching */
+	if ((vnodeid >= 0) && (vnodeid < pjob->ji_numvnod) &&
+	    (pjob->ji_vnods[vnodeid].vn_node == vnodeid)) {
+		i = vnodeid;
+		vp = &pjob->ji_vnods[i];
+	} else {
+		for (vp = pjob->ji_vnods, i = 0; i < pjob->ji_numvnod; vp++, i++) {
+			if (vp->vn_node == vnodeid)
+				break;
+		}
 	}
 	if (i == pjob->ji_numvnod) {
 		sprintf(log_buffer, "node %d not found", vnodeid);
@@ -2681,6 +2688,12 @@ static char bail_format[] = "dis read failed: %s";
 		goto err;                                  \
 	}
 
+/*
+ * A poll reply repeats hook set resources that did not change at least
+ * this often (seconds), in case the MS lost what it had.
+ */
+#define RESC_USED_REFRESH 600
+
 /**
  * @brief
  *	Send resources_used values to the MS via
@@ -2688,14 +2701,17 @@ static char bail_format[] = "dis read failed: %s";
  *
  * @param[in] stream - descriptor pathway to MS.
  * @param[in] pjob - poineter to owning job structure
+ * @param[in] changed_only - if set, send nothing when the values are
+ *			     the ones sent last time.  The MS keeps what it
+ *			     has when a reply carries no resources.
  *
  * @return  error code
- * @retval -1     error
+ * @retval -1     error or nothing sent
  * @retval  0     Success
  *
  */
 int
-send_resc_used_to_ms(int stream, job *pjob)
+send_resc_used_to_ms(int stream, job *pjob, int changed_only)
 {
 	extern int resc_access_perm;
 	attribute *at;
@@ -2751,6 +2767,27 @@ send_resc_used_to_ms(int stream, job *pjob)
 		return (-1);
 	}
 
+	if (changed_only) {
+		u_long hash = 5381;
+		char *p;
+
+		for (pal = psatl; pal != NULL; pal = (svrattrl *) GET_NEXT(pal->al_link)) {
+			for (p = pal->al_resc; p && *p; p++)
+				hash = hash * 33 + (unsigned char) *p;
+			hash = hash * 33 + '=';
+			for (p = pal->al_value; p && *p; p++)
+				hash = hash * 33 + (unsigned char) *p;
+			hash = hash * 33 + ',';
+		}
+		if ((hash == pjob->ji_resc_sent_hash) &&
+		    (time_now - pjob->ji_resc_sent_time < RESC_USED_REFRESH)) {
+			free_attrlist(&send_head);
+			return (-1);
+		}
+		pjob->ji_resc_sent_hash = hash;
+		pjob->ji_resc_sent_time = time_now;
+	}
+
 	ret = encode_DIS_svrattrl(stream, psatl);
 	free_attrlist(&send_head);
 	if (ret != DIS_SUCCESS)
@@ -4151,7 +4188,7 @@ join_err:
 				break;
 			ret = diswul(stream, resc_used(pjob, "cpupercent", gettime));
 
-			send_resc_used_to_ms(stream, pjob);
+			send_resc_used_to_ms(stream, pjob, 1);
 			break;
 
 #ifdef PMIX
@@ -4472,12 +4509,28 @@ join_err:
 							goto err;
 					}
 
-					for (i=0; i<pjob->ji_numnodes; i++) {
+					/*
+					 * Events are only taken off the hosts while the
+					 * sisters join, so resume the search where the
+					 * last one stopped, and check all hosts again
+					 * before deciding that none is left.
+					 */
+					for (i = pjob->ji_evscan; i < pjob->ji_numnodes; i++) {
 						hnodent *xp = &pjob->ji_hosts[i];
 						if ((ep = (eventent *)GET_NEXT(xp->hn_events))
 							!= NULL)
 							break;
 					}
+					pjob->ji_evscan = i;
+					if (ep == NULL) {
+						for (i = 0; i < pjob->ji_numnodes; i++) {
+							hnodent *xp = &pjob->ji_hosts[i];
+							if ((ep = (eventent *)GET_NEXT(xp->hn_events))
+								!= NULL)
+								break;
+						}
+						pjob->ji_evscan = (ep == NULL) ? 0 : i;
+					}
 
 					if (do_tolerate_node_failures(pjob) &&
 					    (nodeidx > 0) && (nodeidx < pjob->ji_numnodes)) {
@@ -5566,6 +5619,148 @@ cleanup:
 
 #define TASK_FDMAX 10
 
+/**
+ * @brief
+ *	Read the argument and environment arrays of a TM spawn request.
+ *
+ *	read (
+ *		argc		int;
+ *		arg 0		string;
+ *		...
+ *		arg argc-1	string;
+ *		env 0		string;
+ *		...
+ *		env m		string;
+ *	)
+ *
+ * @param[in]	fd - the stream to read from
+ * @param[out]	pargc - argument count
+ * @param[out]	pargv - NULL terminated argument array
+ * @param[out]	penvp - NULL terminated environment array
+ * @param[out]	pempty - set to 1 if an argument is the empty string
+ *
+ * @return int
+ * @retval DIS_SUCCESS	both arrays were read, caller frees them
+ * @retval other	DIS error, nothing is returned to free
+ *
+ */
+static int
+tm_spawn_args(int fd, int *pargc, char ***pargv, char ***penvp, int *pempty)
+{
+	int ret;
+	int i;
+	int argc;
+	int numele;
+	char **argv;
+	char **envp;
+
+	*pargv = NULL;
+	*penvp = NULL;
+	argc = disrui(fd, &ret);
+	if (ret != DIS_SUCCESS)
+		return ret;
+	argv = (char **) calloc(argc + 1, sizeof(char *));
+	assert(argv);
+	for (i = 0; i < argc; i++) {
+		argv[i] = disrst(fd, &ret);
+		if (ret != DIS_SUCCESS) {
+			argv[i] = NULL;
+			arrayfree(argv);
+			return ret;
+		}
+		if (strlen(argv[i]) == 0)
+			*pempty = 1; /* arguments contains empty string, Used if spawn on another MOM*/
+	}
+	argv[i] = NULL;
+
+	numele = 3;
+	envp = (char **) calloc(numele, sizeof(char *));
+	assert(envp);
+	for (i = 0;; i++) {
+		char *env;
+
+		env = disrst(fd, &ret);
+		if (ret != DIS_SUCCESS && ret != DIS_EOD) {
+			arrayfree(argv);
+			envp[i] = NULL;
+			arrayfree(envp);
+			return ret;
+		}
+		if (env == NULL)
+			break;
+		if (*env == '\0') {
+			free(env);
+			break;
+		}
+		/*
+		 **	Need to remember extra slot for NULL
+		 **	at the end.  Thanks to Pete Wyckoff
+		 **	for finding this.
+		 */
+		if (i == numele - 1) {
+			numele *= 2;
+			envp = (char **) realloc(envp,
+						 numele * sizeof(char *));
+			assert(envp);
+		}
+		envp[i] = env;
+	}
+	envp[i] = NULL;
+
+	*pargc = argc;
+	*pargv = argv;
+	*penvp = envp;
+	return DIS_SUCCESS;
+}
+
+/**
+ * @brief
+ *	Create and start a task of a job on this node on behalf of a
+ *	TM spawn request.
+ *
+ * @param[in]	pjob - job the task belongs to
+ * @param[in]	parentjob - job id of the requesting task
+ * @param[in]	parentnode - vnode of the requesting task
+ * @param[in]	parenttask - the requesting task
+ * @param[in]	vnode - vnode the new task runs on
+ * @param[in]	argv - program and arguments
+ * @param[in]	envp - environment
+ * @param[out]	pptask - the new task, if one was created
+ *
+ * @return int
+ * @retval TM_OKAY	task started
+ * @retval TM_ESYSTEM	task was created but failed to start
+ * @retval TM_ERROR	task could not be created
+ *
+ */
+static int
+tm_spawn_here(job *pjob, char *parentjob, tm_node_id parentnode,
+	      tm_task_id parenttask, tm_node_id vnode,
+	      char **argv, char **envp, pbs_task **pptask)
+{
+	pbs_task *ptask;
+	int ret;
+
+	*pptask = NULL;
+	if ((ptask = momtask_create(pjob)) == NULL)
+		return TM_ERROR;
+	*pptask = ptask;
+	strcpy(ptask->ti_qs.ti_parentjobid, parentjob);
+	ptask->ti_qs.ti_parentnode = parentnode;
+	ptask->ti_qs.ti_myvnode = vnode;
+	ptask->ti_qs.ti_parenttask = parenttask;
+	if (task_save(ptask) == -1)
+		return TM_ERROR;
+	ret = start_process(ptask, argv, envp, false);
+	if (ret == PBSE_NONE)
+		return TM_OKAY;
+	if (ret == PBSE_SYSTEM) {
+		ptask->ti_qs.ti_status = TI_STATE_EXITED;
+		return TM_ESYSTEM;
+	}
+	return TM_ERROR;
+}
+
 /**
  *
  * @brief
@@ -5608,7 +5803,7 @@ tm_request(int fd, int version)
 	pbs_task *ptask = NULL;
 	vmpiprocs *pnode;
 	hnodent *phost;
-	int i, event, numele;
+	int i, event;
 	size_t len;
 	long ipadd;
 	char **argv, **envp;
@@ -6219,57 +6414,10 @@ tm_request(int fd, int version)
 			 */
 			DBPRT(("%s: SPAWN %s on node %d\n",
 			       __func__, jobid, tvnodeid))
-			argc = disrui(fd, &ret);
+			ret = tm_spawn_args(fd, &argc, &argv, &envp,
+					    &found_empty_string);
 			if (ret != DIS_SUCCESS)
 				goto done;
-			argv = (char **) calloc(argc + 1, sizeof(char *));
-			assert(argv);
-			for (i = 0; i < argc; i++) {
-				argv[i] = disrst(fd, &ret);
-				if (ret != DIS_SUCCESS) {
-					argv[i] = NULL;
-					arrayfree(argv);
-					goto done;
-				}
-				if (strlen(argv[i]) == 0)
-					found_empty_string = 1; /* arguments contains empty string, Used if spawn on another MOM*/
-			}
-			argv[i] = NULL;
-
-			numele = 3;
-			envp = (char **) calloc(numele, sizeof(char *));
-			assert(envp);
-			for (i = 0;; i++) {
-				char *env;
-
-				env = disrst(fd, &ret);
-				if (ret != DIS_SUCCESS && ret != DIS_EOD) {
-					arrayfree(argv);
-					envp[i] = NULL;
-					arrayfree(envp);
-					goto done;
-				}
-				if (env == NULL)
-					break;
-				if (*env == '\0') {
-					free(env);
-					break;
-				}
-				/*
-				 **	Need to remember extra slot for NULL
-				 **	at the end.  Thanks to Pete Wyckoff
-				 **	for finding this.
-				 */
-				if (i == numele - 1) {
-					numele *= 2;
-					envp = (char **) realloc(envp,
-								 numele * sizeof(char *));
-					assert(envp);
-				}
-				envp[i] = env;
-			}
-			envp[i] = NULL;
-			ret = DIS_SUCCESS;
 
 			if (prev_error) {
 				arrayfree(argv);
@@ -6284,23 +6432,8 @@ tm_request(int fd, int version)
 #ifdef PMIX
 				pbs_pmix_register_client(pjob, tvnodeid, &envp);
 #endif
-				i = TM_ERROR;
-				ptask = momtask_create(pjob);
-				if (ptask != NULL) {
-					strcpy(ptask->ti_qs.ti_parentjobid, jobid);
-					ptask->ti_qs.ti_parentnode = myvnodeid;
-					ptask->ti_qs.ti_myvnode = tvnodeid;
-					ptask->ti_qs.ti_parenttask = fromtask;
-					if (task_save(ptask) != -1) {
-						ret = start_process(ptask, argv, envp, false);
-						if (ret == PBSE_NONE) {
-							i = TM_OKAY;
-						} else if (ret == PBSE_SYSTEM) {
-							i = TM_ESYSTEM;
-							ptask->ti_qs.ti_status = TI_STATE_EXITED;
-						}
-					}
-				}
+				i = tm_spawn_here(pjob, jobid, myvnodeid, fromtask,
+						  tvnodeid, argv, envp, &ptask);
 				arrayfree(argv);
 				arrayfree(envp);
 				ret = tm_reply(fd, version, i, event);
@@ -6391,6 +6524,102 @@ tm_request(int fd, int version)
 
 			break;
 
+		case TM_SPAWN_MULTI:
+			/*
+			 ** Spawn the same program as several tasks on
+			 ** vnodes of this host with one request.  The
+			 ** node read above is the first of the list.
+			 **
+			 **	read (
+			 **		count		int;
+			 **		node 0		int;
+			 **		...
+			 **		node count-1	int;
+			 **		argc, argv and envp as for TM_SPAWN
+			 **	)
+			 **
+			 ** The reply holds one task id per node, or
+			 ** TM_NULL_TASK where the spawn failed or the
+			 ** node is not one of mine.
+			 */
+			vnodenum = disrsi(fd, &ret);
+			BAIL("SPAWN_MULTI count")
+			if (vnodenum <= 0) {
+				sprintf(log_buffer, "bad SPAWN_MULTI count %d", vnodenum);
+				goto err;
+			}
+			DBPRT(("%s: SPAWN_MULTI %s %d tasks\n",
+			       __func__, jobid, vnodenum))
+			{
+				tm_node_id *where;
+				tm_task_id *tids;
+				int j;
+				int nforeign = 0;
+
+				where = (tm_node_id *) calloc(vnodenum, sizeof(tm_node_id));
+				tids = (tm_task_id *) calloc(vnodenum, sizeof(tm_task_id));
+				assert(where != NULL && tids != NULL);
+				for (j = 0; j < vnodenum; j++) {
+					where[j] = disrsi(fd, &ret);
+					if (ret != DIS_SUCCESS)
+						break;
+				}
+				if (ret == DIS_SUCCESS)
+					ret = tm_spawn_args(fd, &argc, &argv, &envp,
+							    &found_empty_string);
+				if (ret != DIS_SUCCESS || prev_error) {
+					if (ret == DIS_SUCCESS) {
+						arrayfree(argv);
+						arrayfree(envp);
+					}
+					free(where);
+					free(tids);
+					goto done;
+				}
+
+				for (j = 0; j < vnodenum; j++) {
+					char **tenvp = envp;
+
+					tids[j] = TM_NULL_TASK;
+					for (i = 0; i < pjob->ji_numvnod; i++) {
+						if (pjob->ji_vnods[i].vn_node == where[j])
+							break;
+					}
+					if (i == pjob->ji_numvnod ||
+					    pjob->ji_nodeid != pjob->ji_vnods[i].vn_host->hn_node) {
+						/* logged once below, fan-out launchers send every node */
+						nforeign++;
+						continue;
+					}
+#ifdef PMIX
+					/* PMIx adds per rank variables, give each task its own copy */
+					if ((tenvp = dup_string_arr(envp)) == NULL)
+						continue;
+					pbs_pmix_register_client(pjob, where[j], &tenvp);
+#endif
+					if (tm_spawn_here(pjob, jobid, myvnodeid, fromtask,
+							  where[j], argv, tenvp, &ptask) == TM_OKAY)
+						tids[j] = ptask->ti_qs.ti_task;
+#ifdef PMIX
+					arrayfree(tenvp);
+#endif
+				}
+				arrayfree(argv);
+				arrayfree(envp);
+				if (nforeign > 0)
+					log_eventf(PBSEVENT_JOB, PBS_EVENTCLASS_JOB,
+						   LOG_NOTICE, jobid,
+						   "SPAWN_MULTI %d of %d nodes not on this host",
+						   nforeign, vnodenum);
+
+				ret = tm_reply(fd, version, TM_OKAY, event);
+				for (j = 0; j < vnodenum && ret == DIS_SUCCESS; j++)
+					ret = diswui(fd, tids[j]);
+				free(where);
+				free(tids);
+			}
+			break;
+
 		case TM_SIGNAL:
 			/*
 			 ** Send a signal to the specified task.
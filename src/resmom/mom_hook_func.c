@@ -48,6 +48,13 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
+#ifndef WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#ifdef HAVE_MEMFD_CREATE
+#include <sys/mman.h>
+#endif
+#endif
 #include <ctype.h>
 #include <errno.h>
 #include <assert.h>
@@ -95,6 +102,11 @@
 
 /* Global Data items */
 static int run_exit = 0; /* run exit of child */
+#ifndef WIN32
+static int hook_server_fd = -1; /* Mom's end of the hook server socket */
+#endif
+static vnl_t *periodic_vnl_sent = NULL;	 /* resources last sent by exechost_periodic hooks */
+static time_t periodic_vnl_sent_since = 0; /* when periodic_vnl_sent was started */
 
 extern int exiting_tasks;
 extern int resc_access_perm;
@@ -127,6 +139,8 @@ extern pbs_list_head task_list_event;
 extern pbs_list_head svr_alljobs;
 
 extern char *msg_err_malloc;
+extern int hook_prefork;
+extern pid_t mom_pid;
 
 extern time_t time_now;
 
@@ -664,6 +678,307 @@ mom_process_hooks_params_t
 	return new_php;
 }
 
+#ifndef WIN32
+/**
+ * @brief
+ *	Close Mom's end of the hook server socket.  The hook server exits
+ *	once its running hooks are done, and is reaped like any other child.
+ */
+static void
+stop_hook_server(void)
+{
+	if (hook_server_fd != -1) {
+		close(hook_server_fd);
+		hook_server_fd = -1;
+		log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_HOOK, LOG_INFO, __func__, "hook server stopped");
+	}
+}
+
+/**
+ * @brief
+ *	Start "pbs_python --hook-server", which keeps a started interpreter
+ *	and forks a process for each hook run Mom passes it.
+ *
+ * @param[in]	pypath - path of pbs_python
+ * @param[in]	rescdef - resourcedef file to load, or NULL
+ *
+ * @return void
+ */
+static void
+start_hook_server(char *pypath, char *rescdef)
+{
+	int sv[2];
+	pid_t pid;
+	char fdstr[32];
+	char *arg[6];
+
+	if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) == -1) {
+		log_err(errno, __func__, "socketpair");
+		return;
+	}
+	pid = fork();
+	if (pid == -1) {
+		log_err(errno, __func__, "fork failed");
+		close(sv[0]);
+		close(sv[1]);
+		return;
+	}
+	if (pid == 0) {
+		tpp_terminate();
+		net_close(-1);
+		setsid();
+		close(sv[0]);
+
+		if (chdir(path_hooks_workdir) != 0)
+			log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_HOOK, LOG_WARNING, __func__, "unable to go to hooks tmp directory");
+		if (pbs_conf.pbs_conf_file != NULL)
+			(void) setenv("PBS_CONF_FILE", pbs_conf.pbs_conf_file, 1);
+		(void) unsetenv(PBS_HOOK_CONFIG_FILE);
+
+		snprintf(fdstr, sizeof(fdstr), "%d", sv[1]);
+		arg[0] = pypath;
+		arg[1] = HOOK_SERVER_MODE;
+		arg[2] = fdstr;
+		if (rescdef != NULL) {
+			arg[3] = "-r";
+			arg[4] = rescdef;
+			arg[5] = NULL;
+		} else
+			arg[3] = NULL;
+		execve(pypath, arg, environ);
+		log_err(errno, __func__, "execv of hook server");
+		exit(1);
+	}
+	close(sv[1]);
+	(void) fcntl(sv[0], F_SETFD, FD_CLOEXEC);
+	hook_server_fd = sv[0];
+	log_eventf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_HOOK, LOG_INFO, __func__, "hook server started, pid %d", pid);
+}
+
+/**
+ * @brief
+ *	Check whether a hook about to be run can be handed to the hook
+ *	server, (re)starting the server as needed.
+ *
+ * @par
+ *	Only the main Mom process uses the hook server, and only for hooks
+ *	that run as root.  The server is restarted when it has gone away or
+ *	when the resourcedef file it loaded has changed.
+ *
+ * @param[in]	pypath - path of pbs_python
+ *
+ * @return int
+ * @retval 1	use the hook server
+ * @retval 0	run pbs_python directly
+ */
+static int
+hook_server_ready(char *pypath)
+{
+	static struct stat loaded_rescdef;
+	struct stat sbuf;
+	struct pollfd pfd;
+	char rescdef[MAXPATHLEN + 1];
+
+	if (getpid() != mom_pid)
+		return 0;
+	if (!hook_prefork) {
+		stop_hook_server();
+		return 0;
+	}
+
+	snprintf(rescdef, sizeof(rescdef), "%s%s", path_hooks, PBS_RESCDEF);
+	if (stat(rescdef, &sbuf) != 0)
+		memset(&sbuf, 0, sizeof(sbuf));
+
+	if (hook_server_fd != -1) {
+		pfd.fd = hook_server_fd;
+		pfd.events = 0;
+		pfd.revents = 0;
+		if ((poll(&pfd, 1, 0) > 0) && (pfd.revents & (POLLHUP | POLLERR | POLLNVAL)))
+			stop_hook_server();
+		else if ((sbuf.st_ino != loaded_rescdef.st_ino) ||
+			 (sbuf.st_size != loaded_rescdef.st_size) ||
+			 (sbuf.st_mtime != loaded_rescdef.st_mtime))
+			stop_hook_server();
+	}
+	if (hook_server_fd == -1) {
+		start_hook_server(pypath, (sbuf.st_ino != 0) ? rescdef : NULL);
+		loaded_rescdef = sbuf;
+	}
+	return (hook_server_fd != -1);
+}
+
+/**
+ * @brief
+ *	Read exactly 'len' bytes from the hook server reply socket 'fd'.
+ *
+ * @return ssize_t
+ * @retval	number of bytes read, less than 'len' on EOF or error
+ */
+static ssize_t
+hook_server_read(int fd, void *buf, size_t len)
+{
+	size_t got = 0;
+	ssize_t n;
+
+	while (got < len) {
+		n = read(fd, (char *) buf + got, len - got);
+		if (n == -1 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			break;
+		got += n;
+	}
+	return (got);
+}
+
+/**
+ * @brief
+ *	Open an anonymous in-memory file for the input of a hook, so that
+ *	pbs_python reads it through /dev/fd/<n> instead of from a file left
+ *	behind in the hooks work directory.
+ *
+ * @param[out]	path - set to the path pbs_python is to open for its input
+ * @param[in]	len - size of 'path'
+ * @param[out]	pfd - set to the descriptor, kept open across execve()
+ *
+ * @return FILE *
+ * @retval	stream to write the hook input to
+ * @retval	NULL, no in-memory file available: use a hook input file
+ */
+static FILE *
+hook_input_memfile(char *path, size_t len, int *pfd)
+{
+#ifdef HAVE_MEMFD_CREATE
+	FILE *fp;
+	int fd;
+	int fd2;
+
+	if ((fd = memfd_create("hook_input", 0)) == -1)
+		return NULL;
+	/* the stream gets its own descriptor, fclose() leaves 'fd' open */
+	if (((fd2 = dup(fd)) == -1) || ((fp = fdopen(fd2, "w")) == NULL)) {
+		if (fd2 != -1)
+			close(fd2);
+		close(fd);
+		return NULL;
+	}
+	snprintf(path, len, "/dev/fd/%d", fd);
+	*pfd = fd;
+	return fp;
+#else
+	return NULL;
+#endif
+}
+
+/**
+ * @brief
+ *	Called in the child forked to run a hook, in place of executing
+ *	pbs_python: have the hook server run the hook command line 'arg'
+ *	in the current directory and environment, and wait for it.
+ *
+ * @par
+ *	If this process is killed, e.g. on hook alarm, the hook server
+ *	kills the process running the hook.
+ *
+ * @par
+ *	An in-memory hook input 'infd' is passed along with the reply socket,
+ *	the hook server then points the -i argument at its own copy.
+ *
+ * @param[in]	arg - the pbs_python --hook command line
+ * @param[in]	infd - descriptor of the in-memory hook input, or -1
+ *
+ * @return int
+ * @retval >=0	exit value of the hook run
+ * @retval -1	the hook server did not take the request, run pbs_python
+ */
+static int
+run_hook_in_server(char **arg, int infd)
+{
+	char msg[HOOK_SERVER_MSG_SIZE];
+	char cwd[MAXPATHLEN + 1];
+	union {
+		struct cmsghdr cm;
+		char buf[CMSG_SPACE(2 * sizeof(int))];
+	} cbuf;
+	int fds[2];
+	int nfds = 1;
+	struct msghdr mh;
+	struct iovec iov;
+	struct cmsghdr *cm;
+	char *cfg;
+	size_t len = 0;
+	size_t l;
+	int sv[2];
+	int i;
+	pid_t pid;
+	int status;
+
+	if (getcwd(cwd, sizeof(cwd)) == NULL)
+		return -1;
+	if ((cfg = getenv(PBS_HOOK_CONFIG_FILE)) == NULL)
+		cfg = "";
+
+	for (i = -2; (i < 0) || (arg[i] != NULL); i++) {
+		char *str = (i == -2) ? cwd : ((i == -1) ? cfg : arg[i]);
+
+		l = strlen(str) + 1;
+		if (len + l > sizeof(msg))
+			return -1;
+		memcpy(msg + len, str, l);
+		len += l;
+	}
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1)
+		return -1;
+
+	memset(&mh, 0, sizeof(mh));
+	memset(&cbuf, 0, sizeof(cbuf));
+	iov.iov_base = msg;
+	iov.iov_len = len;
+	mh.msg_iov = &iov;
+	mh.msg_iovlen = 1;
+	fds[0] = sv[1];
+	if (infd != -1)
+		fds[nfds++] = infd;
+	mh.msg_control = cbuf.buf;
+	mh.msg_controllen = CMSG_SPACE(nfds * sizeof(int));
+	cm = CMSG_FIRSTHDR(&mh);
+	cm->cmsg_level = SOL_SOCKET;
+	cm->cmsg_type = SCM_RIGHTS;
+	cm->cmsg_len = CMSG_LEN(nfds * sizeof(int));
+	memcpy(CMSG_DATA(cm), fds, nfds * sizeof(int));
+
+	if (sendmsg(hook_server_fd, &mh, MSG_NOSIGNAL) != (ssize_t) len) {
+		close(sv[0]);
+		close(sv[1]);
+		return -1;
+	}
+	close(sv[1]);
+	close(hook_server_fd);
+
+	/* no pid back means the hook was not started */
+	if (hook_server_read(sv[0], &pid, sizeof(pid)) != sizeof(pid)) {
+		close(sv[0]);
+		return -1;
+	}
+	log_eventf(PBSEVENT_DEBUG3, PBS_EVENTCLASS_HOOK, LOG_INFO, __func__,
+		   "hook run by hook server in pid=%d", pid);
+	if (hook_server_read(sv[0], &status, sizeof(status)) != sizeof(status))
+		return 255;
+	close(sv[0]);
+
+	if (WIFEXITED(status))
+		return (WEXITSTATUS(status));
+	if (WIFSIGNALED(status)) {
+		/* end the same way, for the waiting Mom to see */
+		(void) signal(WTERMSIG(status), SIG_DFL);
+		kill(getpid(), WTERMSIG(status));
+	}
+	return 255;
+}
+#endif /* !WIN32 */
+
 /**
  * @brief
  *	Runs the hook 'phook' in a child process in response to 'event_type'
@@ -703,6 +1018,7 @@ run_hook(hook *phook, unsigned int event_type, mom_hook_input_t *hook_input,
 {
 
 	FILE *fp = NULL;
+	int infd = -1;
 	char in_data[LOG_BUF_SIZE + 1];
 	char hook_inputfile[MAXPATHLEN + 1];
 	char hook_outputfile[MAXPATHLEN + 1];
@@ -751,6 +1067,9 @@ run_hook(hook *phook, unsigned int event_type, mom_hook_input_t *hook_input,
 	int keeping = 0;
 	char *std_file = NULL;
 	reliable_job_node *rjn;
+#ifndef WIN32
+	int use_hook_server = 0;
+#endif
 
 	if ((phook == NULL) || (req_user == NULL) || (req_host == NULL)) {
 		log_err(-1, __func__, "Bad input received!");
@@ -819,6 +1138,11 @@ run_hook(hook *phook, unsigned int event_type, mom_hook_input_t *hook_input,
 	if ((phook->user == HOOK_PBSUSER) && (event_type & USER_MOM_EVENTS))
 		runas_jobuser = 1;
 
+#ifndef WIN32
+	if (!runas_jobuser)
+		use_hook_server = hook_server_ready(pypath);
+#endif
+
 	child = fork();
 	if (child > 0) { /* parent */
 
@@ -1036,7 +1360,12 @@ run_hook(hook *phook, unsigned int event_type, mom_hook_input_t *hook_input,
 
 			log_file[0] = '\0';
 
-			if ((fp = fopen(hook_inputfile, "w")) == NULL) {
+#ifndef WIN32
+			/* keep the input file around only for hook debugging */
+			if (!child && !phook->debug)
+				fp = hook_input_memfile(hook_inputfile, sizeof(hook_inputfile), &infd);
+#endif
+			if ((fp == NULL) && ((fp = fopen(hook_inputfile, "w")) == NULL)) {
 				log_errf(errno, __func__, "open of input file %s failed!", hook_inputfile);
 				goto run_hook_exit;
 			}
@@ -1289,6 +1618,15 @@ run_hook(hook *phook, unsigned int event_type, mom_hook_input_t *hook_input,
 			}
 		}
 
+		if (use_hook_server && !child) {
+			int rc;
+
+			if ((rc = run_hook_in_server(arg, infd)) >= 0)
+				exit(rc);
+			log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_HOOK, LOG_WARNING, phook->hook_name,
+				  "hook server did not take the hook, running pbs_python");
+		}
+
 #ifdef __SANITIZE_ADDRESS__
 		/*
 		 * Ignore ASAN link order for pbs_python because Python bin
@@ -2671,6 +3009,87 @@ new_job_action_req(job *pjob, enum hook_user huser, int action)
 	send_hook_job_action(phja);
 }
 
+/**
+ * @brief
+ *	Forget the resource values exechost_periodic hooks last sent, so
+ *	that the next periodic run reports all of them to the server again.
+ *	Called when the server (re)connects, since it may have lost them.
+ *
+ * @return void
+ */
+void
+periodic_vnl_forget(void)
+{
+	vnl_free(periodic_vnl_sent);
+	periodic_vnl_sent = NULL;
+}
+
+/**
+ * @brief
+ *	Drop the resources_available values of an exechost_periodic hook's
+ *	vnode changes that match what was last sent to the server, and remember
+ *	the ones that remain.  Other vnode attributes (state, comment, the hook
+ *	requestor and hook actions) are always kept.  The remembered values
+ *	are discarded every PERIODIC_VNL_REFRESH seconds so that a value changed
+ *	behind mom's back is eventually restored.
+ *
+ * @param[in,out] vnl - vnode changes from one periodic hook run
+ *
+ * @return int
+ * @retval	number of attributes left to send, not counting the requestor
+ */
+static int
+prune_periodic_vnl(vnl_t *vnl)
+{
+	static size_t rlen = sizeof(ATTR_rescavail) - 1;
+	unsigned long i;
+	unsigned long j;
+	unsigned long k;
+	int kept = 0;
+	int untracked = 0;
+	char *old;
+
+	if ((periodic_vnl_sent != NULL) &&
+	    (time_now - periodic_vnl_sent_since >= PERIODIC_VNL_REFRESH))
+		periodic_vnl_forget();
+	if (periodic_vnl_sent == NULL) {
+		if (vnl_alloc(&periodic_vnl_sent) == NULL)
+			return (-1);
+		periodic_vnl_sent_since = time_now;
+	}
+
+	for (i = 0; i < vnl->vnl_used; i++) {
+		vnal_t *vnal = VNL_NODENUM(vnl, i);
+
+		for (j = 0, k = 0; j < vnal->vnal_used; j++) {
+			vna_t *vna = VNAL_NODENUM(vnal, j);
+
+			if ((strncmp(vna->vna_name, ATTR_rescavail, rlen) == 0) &&
+			    (vna->vna_name[rlen] == '.')) {
+				old = vn_exist(periodic_vnl_sent, vnal->vnal_id, vna->vna_name);
+				if ((old != NULL) && (strcmp(old, vna->vna_val) == 0)) {
+					free(vna->vna_name);
+					free(vna->vna_val);
+					continue;
+				}
+				if (vn_addvnr(periodic_vnl_sent, vnal->vnal_id, vna->vna_name,
+					      vna->vna_val, vna->vna_type, vna->vna_flag, NULL) == -1)
+					untracked = 1;
+			}
+			if (strcmp(vna->vna_name, VNATTR_HOOK_REQUESTOR) != 0)
+				kept++;
+			if (k != j)
+				*VNAL_NODENUM(vnal, k) = *vna;
+			k++;
+		}
+		vnal->vnal_used = k;
+	}
+	/* a value that could not be remembered must not be skipped later */
+	if (untracked)
+		periodic_vnl_forget();
+	return (kept);
+}
+
 /**
  * @brief
  *	This function runs after the task that runs a single periodic hook
@@ -2769,8 +3188,19 @@ post_periodic_hook(struct work_task *pwt)
 			(void) unlink(hook_outfile); /* remove file */
 
 		if ((struct hook_vnl_action *) GET_NEXT(vnl_changes) != NULL) {
+			struct hook_vnl_action *pvna;
+
+			/* there are vnode hook updates, only send */
+			/* the resources that changed since last time */
+			for (pvna = GET_NEXT(vnl_changes); pvna;
+			     pvna = GET_NEXT(pvna->hva_link)) {
+				if ((pvna->hva_vnl != NULL) &&
+				    (prune_periodic_vnl(pvna->hva_vnl) == 0)) {
+					vnl_free(pvna->hva_vnl);
+					pvna->hva_vnl = NULL;
+				}
+			}
 
-			/* there are vnode hook updates */
 			/* Push hook changes to server */
 
 			hook_requests_to_server(&vnl_changes);
@@ -115,8 +115,10 @@
 #include "hook.h"
 #include "mom_hook_func.h"
 #include "work_task.h"
+#include "pbs_metrics.h"
 #include "pbs_share.h"
 #include "mom_server.h"
+#include "mock_run.h"
 #if MOM_ALPS
 #include "mom_mach.h"
 #endif /* MOM_ALPS */
@@ -252,6 +254,12 @@ pbs_list_head svr_alljobs; /* all jobs under MOM's control */
 time_t time_last_sample = 0;
 extern time_t time_now;
 time_t time_resc_updated = 0;
+#ifndef WIN32
+#define MOM_METRICS_SOCK "metrics.sock"
+static pbs_hist_t mom_sample_hist; /* time in mom_get_sample() */
+static pbs_hist_t mom_pass_hist;   /* time of a whole sampling pass */
+static time_t mom_next_export = 0; /* when to refresh the metrics snapshot */
+#endif
 extern pbs_list_head svr_requests;
 struct var_table vtable; /* see start_exec.c */
 
@@ -284,10 +292,18 @@ int attach_allow = TRUE;
 extern double wallfactor;
 int suspend_signal;
 int resume_signal;
+int proc_connector; /* follow job processes through the proc connector */
 int cycle_harvester = 0;	/* MOM configured for cycle harvesting */
 int restrict_user = 0;		/* kill non PBS user procs */
 int restrict_user_maxsys = 999; /* largest system user id */
 int gen_nodefile_on_sister_mom = TRUE;
+int nodefile_hostlist = FALSE; /* also write PBS_NODEFILE in hostlist range form */
+int job_journal = FALSE;       /* save jobs to one journal instead of a file each */
+int obit_batch_delay = 0;      /* seconds obits are held to go out together */
+int hook_prefork = FALSE;      /* run root hooks through a warm pbs_python */
+int cleanup_worker = FALSE;    /* remove job directories in one long-lived process */
+int job_sample_interval = 0;   /* seconds between kept job usage samples, 0 keeps none */
+int nss_cache_ttl = 0;	       /* seconds user and group lookups are cached, 0 for none */
 int vnode_additive = 1;
 momvmap_t **mommap_array = NULL;
 int mommap_array_size = 0;
@@ -468,6 +484,7 @@ static handler_ret_t set_kbd_idle(char *);
 static handler_ret_t set_max_check_poll(char *);
 static handler_ret_t set_min_check_poll(char *);
 static handler_ret_t set_momname(char *);
+static handler_ret_t set_proc_connector(char *);
 static handler_ret_t set_momport(char *);
 #ifdef WIN32
 static handler_ret_t set_nrun_factor(char *);
@@ -478,6 +495,14 @@ static handler_ret_t set_restrict_user(char *);
 static handler_ret_t set_restrict_user_maxsys(char *);
 static handler_ret_t set_restrict_user_exceptions(char *);
 static handler_ret_t set_gen_nodefile_on_sister_mom(char *);
+static handler_ret_t set_nodefile_hostlist(char *);
+static handler_ret_t set_job_journal(char *);
+static handler_ret_t set_obit_batch_delay(char *);
+static handler_ret_t set_hook_prefork(char *);
+static handler_ret_t set_cleanup_worker(char *);
+static handler_ret_t set_job_sample_interval(char *);
+static handler_ret_t set_nss_cache_ttl(char *);
+static handler_ret_t set_mock_vnodes(char *);
 static handler_ret_t set_suspend_signal(char *);
 static handler_ret_t set_tmpdir(char *);
 static handler_ret_t set_vnode_additive(char *);
@@ -531,11 +556,13 @@ static struct specials {
 	{"max_load", setmaxload},
 	{"max_poll_downtime", set_max_poll_downtime},
 	{"min_check_poll", set_min_check_poll},
+	{"mock_vnodes", set_mock_vnodes},
 	{"momname", set_momname},
 #ifdef WIN32
 	{"nrun_factor", set_nrun_factor},
 #endif
 	{"port", set_momport},
+	{"proc_connector", set_proc_connector},
 	{"prologalarm", prologalarm},
 	{"sister_join_job_alarm", set_joinjob_alarm},
 	{"job_launch_delay", set_job_launch_delay},
@@ -546,6 +573,13 @@ static struct specials {
 	{"restrict_user_maxsysid", set_restrict_user_maxsys},
 	{"restricted", restricted},
 	{"gen_nodefile_on_sister_mom", set_gen_nodefile_on_sister_mom},
+	{"nodefile_hostlist", set_nodefile_hostlist},
+	{"job_journal", set_job_journal},
+	{"obit_batch_delay", set_obit_batch_delay},
+	{"hook_prefork", set_hook_prefork},
+	{"cleanup_worker", set_cleanup_worker},
+	{"job_sample_interval", set_job_sample_interval},
+	{"nss_cache_ttl", set_nss_cache_ttl},
 #ifdef NAS /* localmod 015 */
 	/*
 	 * spool size limit
@@ -640,6 +674,7 @@ extern eventent *event_dup(eventent *ep, job *pjob, hnodent *pnode);
 /* Local private functions */
 static char *mk_dirs(char *);
 static void check_busy(double);
+struct rm_attribute *momgetattr(char *);
 
 /**
  * @brief
@@ -740,6 +775,57 @@ validuser(struct rm_attribute *attrib)
 	}
 }
 
+/**
+ * @brief
+ *	returns the usage samples held for a job, oldest first, as
+ *	space separated "time,cput,cpupercent,memkb,vmemkb" entries
+ *
+ * @param[in] attrib - pointer to rm_attribute structure, job=<jobid>
+ *
+ * @return	string
+ * @retval	samples	Success
+ * @retval	NULL	Failure
+ *
+ */
+static char *
+jobsamples(struct rm_attribute *attrib)
+{
+	job *pjob;
+	job_sample_t *js;
+	char *spot;
+	int i;
+	int n;
+
+	if (attrib == NULL || attrib->a_value == NULL) {
+		log_err(-1, __func__, no_parm);
+		rm_errno = RM_ERR_NOPARAM;
+		return NULL;
+	}
+	if (strcmp(attrib->a_qualifier, "job") != 0 || momgetattr(NULL)) {
+		log_err(-1, __func__, extra_parm);
+		rm_errno = RM_ERR_BADPARAM;
+		return NULL;
+	}
+	if ((pjob = find_job(attrib->a_value)) == NULL) {
+		rm_errno = RM_ERR_EXIST;
+		return NULL;
+	}
+
+	spot = ret_string;
+	*spot = '\0';
+	n = MIN(pjob->ji_nsamples, JOB_SAMPLE_RING);
+	for (i = pjob->ji_nsamples - n; i < pjob->ji_nsamples; i++) {
+		js = &pjob->ji_samples[i % JOB_SAMPLE_RING];
+		checkret(&spot, 128);
+		spot += sprintf(spot, "%s%ld,%lu,%ld,%llu,%llu",
+				(spot == ret_string) ? "" : " ", (long) js->js_time,
+				js->js_cput, js->js_cpupercent,
+				(unsigned long long) js->js_mem,
+				(unsigned long long) js->js_vmem);
+	}
+	return ret_string;
+}
+
 /**
  * @brief
  *	returns the current load average on node
@@ -834,6 +920,7 @@ struct config common_config[] = {
 	{"arch", {arch}},
 	{"uname", {requname}},
 	{"validuser", {validuser}},
+	{"jobsamples", {jobsamples}},
 	{"reslist", {reslist}},
 	{NULL, {nullproc}}};
 
@@ -2322,6 +2409,11 @@ do_mom_action_script(int ae,	      /* index into action table */
 		/* PBS_NODEFILE */
 		sprintf(buf, "%s/aux/%s", pbs_conf.pbs_home_path, pjob->ji_qs.ji_jobid);
 		bld_env_variables(&vtable, variables_else[11], buf);
+		if (nodefile_hostlist) {
+			/* PBS_NODEFILE_HOSTLIST */
+			strcat(buf, ".hostlist");
+			bld_env_variables(&vtable, variables_else[16], buf);
+		}
 		/* PBS_SID */
 		sprintf(buf, "%d", ptask->ti_qs.ti_sid);
 		bld_env_variables(&vtable, "PBS_SID", buf);
@@ -3408,6 +3500,26 @@ set_restrict_user(char *value)
 	return (set_boolean(__func__, value, &restrict_user));
 }
 
+/**
+ * @brief
+ *      sets value for proc_connector, whether the processes of jobs are
+ *      followed through the kernel proc connector instead of /proc scans.
+ *      Takes effect when MoM starts.
+ *
+ * @param[in] value - value for proc_connector
+ *
+ * @return      handler_ret_t
+ * @retval      HANDLER_SUCCESS         success
+ * @retval      HANDLER_FAIL            Failure
+ *
+ */
+
+static handler_ret_t
+set_proc_connector(char *value)
+{
+	return (set_boolean(__func__, value, &proc_connector));
+}
+
 /**
  * @brief
  *      sets value for restrict maxsys user
@@ -3514,6 +3626,186 @@ set_gen_nodefile_on_sister_mom(char *value)
 	return (set_boolean(__func__, value, &gen_nodefile_on_sister_mom));
 }
 
+/**
+ * @brief
+ *      sets value for nodefile_hostlist, whether a compact hostlist
+ *      range form of PBS_NODEFILE is written next to it
+ *
+ * @param[in] value - value for nodefile_hostlist
+ *
+ * @return      handler_ret_t
+ * @retval      HANDLER_SUCCESS         success
+ * @retval      HANDLER_FAIL            Failure
+ *
+ */
+
+static handler_ret_t
+set_nodefile_hostlist(char *value)
+{
+	return (set_boolean(__func__, value, &nodefile_hostlist));
+}
+
+/**
+ * @brief
+ *      sets value for job_journal, whether jobs are saved to one append-only
+ *      journal instead of a file each.  Only read when MoM starts.
+ *
+ * @param[in] value - value for job_journal
+ *
+ * @return      handler_ret_t
+ * @retval      HANDLER_SUCCESS         success
+ * @retval      HANDLER_FAIL            Failure
+ *
+ */
+
+static handler_ret_t
+set_job_journal(char *value)
+{
+	return (set_boolean(__func__, value, &job_journal));
+}
+
+/**
+ * @brief
+ *	Handler function for the $obit_batch_delay config option, the number
+ *	of seconds a job obit may be held so that the obits of jobs ending
+ *	close together reach the server in one message.
+ *
+ * @param[in]	value - the input given in config file.
+ *
+ * @return handler_ret_t
+ * @retval HANDLER_SUCCESS
+ * @retval HANDLER_FAIL
+ */
+static handler_ret_t
+set_obit_batch_delay(char *value)
+{
+	long i;
+	char *endp;
+
+	log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, LOG_NOTICE,
+		  "obit_batch_delay", value);
+	i = strtol(value, &endp, 10);
+	if ((*endp != '\0') || (i < 0) || (i > MAX_OBIT_BATCH_DELAY))
+		return HANDLER_FAIL; /* error */
+	obit_batch_delay = (int) i;
+	return HANDLER_SUCCESS;
+}
+
+/**
+ * @brief
+ *      sets value for hook_prefork, whether hooks that run as root are
+ *      handed to a pbs_python hook server that keeps its interpreter started
+ *
+ * @param[in] value - value for hook_prefork
+ *
+ * @return      handler_ret_t
+ * @retval      HANDLER_SUCCESS         success
+ * @retval      HANDLER_FAIL            Failure
+ *
+ */
+
+static handler_ret_t
+set_hook_prefork(char *value)
+{
+	return (set_boolean(__func__, value, &hook_prefork));
+}
+
+/**
+ * @brief
+ *      sets value for cleanup_worker, whether the task and tmp directories
+ *      of finished jobs are removed by one long-lived low priority process
+ *      instead of a process forked for each job
+ *
+ * @param[in] value - value for cleanup_worker
+ *
+ * @return      handler_ret_t
+ * @retval      HANDLER_SUCCESS         success
+ * @retval      HANDLER_FAIL            Failure
+ *
+ */
+
+static handler_ret_t
+set_cleanup_worker(char *value)
+{
+	return (set_boolean(__func__, value, &cleanup_worker));
+}
+
+/**
+ * @brief
+ *	Handler function for the $job_sample_interval config option, the
+ *	number of seconds between the usage samples kept for each job.
+ *
+ * @param[in]	value - the input given in config file.
+ *
+ * @return handler_ret_t
+ * @retval HANDLER_SUCCESS
+ * @retval HANDLER_FAIL
+ */
+static handler_ret_t
+set_job_sample_interval(char *value)
+{
+	long i;
+	char *endp;
+
+	log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, LOG_NOTICE,
+		  "job_sample_interval", value);
+	i = strtol(value, &endp, 10);
+	if ((*endp != '\0') || (i < 0) || (i > INT_MAX))
+		return HANDLER_FAIL; /* error */
+	job_sample_interval = (int) i;
+	return HANDLER_SUCCESS;
+}
+
+/**
+ * @brief
+ *	Handler function for the $mock_vnodes config option,
+ *	"<count> <ncpus> <mem>": the vnodes a mom started with -m reports
+ *	besides its natural vnode, so that a few hosts can emulate a large
+ *	cluster.
+ *
+ * @param[in]	value - the input given in config file.
+ *
+ * @return handler_ret_t
+ * @retval HANDLER_SUCCESS
+ * @retval HANDLER_FAIL
+ */
+static handler_ret_t
+set_mock_vnodes(char *value)
+{
+	log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, LOG_NOTICE,
+		  "mock_vnodes", value);
+	if (mock_run_set_vnodes(value) != 0)
+		return HANDLER_FAIL;
+	return HANDLER_SUCCESS;
+}
+
+/**
+ * @brief
+ *	Handler function for the $nss_cache_ttl config option, the number of
+ *	seconds mom keeps the user and group lookups made to start jobs and
+ *	stage files.
+ *
+ * @param[in]	value - the input given in config file.
+ *
+ * @return handler_ret_t
+ * @retval HANDLER_SUCCESS
+ * @retval HANDLER_FAIL
+ */
+static handler_ret_t
+set_nss_cache_ttl(char *value)
+{
+	long i;
+	char *endp;
+
+	log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, LOG_NOTICE,
+		  "nss_cache_ttl", value);
+	i = strtol(value, &endp, 10);
+	if ((*endp != '\0') || (i < 0) || (i > INT_MAX))
+		return HANDLER_FAIL; /* error */
+	nss_cache_ttl = (int) i;
+	return HANDLER_SUCCESS;
+}
+
 /**
  * @brief
  *	Set the configuration flag that defines whether to get rid of
@@ -3968,6 +4260,7 @@ read_config(char *file)
 	average_cpufactor = 1.025;
 	average_trialperiod = 120;
 	complex_mem_calc = 0;
+	(void) mock_run_set_vnodes(NULL);
 	cpuburst = 0;
 	cpuaverage = 0;
 	cputfactor = 1.0;
@@ -3995,6 +4288,7 @@ read_config(char *file)
 	max_check_poll = MAX_CHECK_POLL_TIME;
 	min_check_poll = MIN_CHECK_POLL_TIME;
 	vnode_additive = 1; /* keep vnodes on HUP */
+	proc_connector = FALSE;
 	joinjob_alarm_time = -1;
 	job_launch_delay = -1;
 #ifdef NAS	       /* localmod 015 */
@@ -4015,6 +4309,14 @@ read_config(char *file)
 	restrict_user = 0;
 	restrict_user_maxsys = 999;
 	gen_nodefile_on_sister_mom = TRUE;
+	nodefile_hostlist = FALSE;
+	job_journal = FALSE;
+	obit_batch_delay = 0;
+	hook_prefork = FALSE;
+	cleanup_worker = FALSE;
+	job_sample_interval = 0;
+	nss_cache_ttl = 0;
+	nss_cache_flush();
 	for (j = 0; j < NUM_RESTRICT_USER_EXEMPT_UIDS; j++)
 		if (restrict_user_exempt_uids[j] != 0)
 			restrict_user_exempt_uids[j] = 0;
@@ -4063,6 +4365,10 @@ read_config(char *file)
 
 	addconfig_ret = do_addconfigs();
 
+	/* vnodes a mock run mom pretends to have */
+	if (mock_run && mock_run_add_vnodes(&vnlp) != 0)
+		return 1;
+
 	/* check for any bad combinations */
 	if (min_check_poll > max_check_poll) {
 		sprintf(log_buffer, "min_check_poll(%u) > max_check_poll(%u)",
@@ -6826,6 +7132,72 @@ resume_multinode(job *pjob)
 	}
 }
 
+#ifndef WIN32
+/**
+ * @brief
+ *	mom_metrics_publish - hand a snapshot of the job counts, sampling
+ *	times and TPP backlogs to the thread serving MOM_METRICS_SOCK.
+ *	The first call starts that thread.
+ *
+ * @return void
+ */
+static void
+mom_metrics_publish(void)
+{
+	static int started = 0;
+	int nstate[128] = {0};
+	char *text = NULL;
+	size_t len = 0;
+	job *pjob;
+	FILE *fp;
+	int i;
+
+	if (!started) {
+		if (pbs_metrics_export_start(MOM_METRICS_SOCK) != 0) {
+			log_err(errno, __func__, "unable to serve " MOM_METRICS_SOCK);
+			return;
+		}
+		started = 1;
+	}
+
+	for (pjob = (job *) GET_NEXT(svr_alljobs); pjob != NULL;
+	     pjob = (job *) GET_NEXT(pjob->ji_alljobs))
+		nstate[get_job_state(pjob) & 0x7f]++;
+
+	if ((fp = open_memstream(&text, &len)) == NULL) {
+		log_err(errno, __func__, "open_memstream");
+		return;
+	}
+
+	fprintf(fp, "# TYPE pbs_mom_jobs gauge\n");
+	for (i = 'A'; i <= 'Z'; i++) {
+		if (nstate[i])
+			fprintf(fp, "pbs_mom_jobs{state=\"%c\"} %d\n", i, nstate[i]);
+	}
+	fprintf(fp, "# TYPE pbs_mom_last_sample_time gauge\n"
+		    "pbs_mom_last_sample_time %ld\n",
+		(long) time_last_sample);
+	fprintf(fp, "# TYPE pbs_mom_tpp_app_backlog_bytes gauge\n"
+		    "pbs_mom_tpp_app_backlog_bytes %d\n",
+		tpp_app_backlog());
+	fprintf(fp, "# TYPE pbs_mom_tpp_send_backlog_bytes gauge\n"
+		    "pbs_mom_tpp_send_backlog_bytes %d\n",
+		tpp_transport_backlog());
+	fprintf(fp, "# TYPE pbs_mom_sample_seconds histogram\n");
+	pbs_hist_print_prom(fp, "pbs_mom_sample_seconds", NULL, &mom_sample_hist);
+	fprintf(fp, "# TYPE pbs_mom_sample_pass_seconds histogram\n");
+	pbs_hist_print_prom(fp, "pbs_mom_sample_pass_seconds", NULL, &mom_pass_hist);
+
+	if (ferror(fp)) {
+		fclose(fp);
+		free(text);
+		return;
+	}
+	fclose(fp);
+	pbs_metrics_export_publish(text);
+}
+#endif
+
 #ifdef WIN32
 /**
  * @brief
@@ -6853,6 +7225,9 @@ main(int argc, char *argv[])
 	int tppfd; /* fd for rm and im comm */
 	double myla;
 	time_t time_next_hello = 0;
+#ifndef WIN32
+	unsigned long long pass_start; /* start of a sampling pass */
+#endif
 	job *nxpjob;
 	job *pjob;
 	extern time_t wait_time;
@@ -7015,6 +7390,7 @@ main(int argc, char *argv[])
 	set_log_conf(pbs_conf.pbs_leaf_name, pbs_conf.pbs_mom_node_name,
 		     pbs_conf.locallog, pbs_conf.syslogfac,
 		     pbs_conf.syslogsvr, pbs_conf.pbs_log_highres_timestamp);
+	set_log_journal(pbs_conf.pbs_log_journal);
 #endif
 	pbsgroup = getgid();
 
@@ -8364,6 +8740,12 @@ main(int argc, char *argv[])
 #endif
 
 		time_now = time(NULL);
+#ifndef WIN32
+		if (pbs_conf.pbs_metrics_export > 0 && time_now >= mom_next_export) {
+			mom_metrics_publish();
+			mom_next_export = time_now + pbs_conf.pbs_metrics_export;
+		}
+#endif
 		if (server_stream == -1) {
 			if (time_now > time_next_hello) {
 				send_hellosvr(server_stream);
@@ -8596,9 +8978,15 @@ main(int argc, char *argv[])
 
 		/* there are jobs so update status	 */
 		/* if we just got a sample, don't bother */
+#ifndef WIN32
+		pass_start = pbs_metrics_now_us();
+#endif
 		if (time_now > time_last_sample) {
 			if (mom_get_sample() != PBSE_NONE)
 				continue;
+#ifndef WIN32
+			pbs_hist_since(&mom_sample_hist, pass_start);
+#endif
 		}
 
 		time_resc_updated = time_now;
@@ -8644,7 +9032,13 @@ main(int argc, char *argv[])
 				continue;
 
 			/* update information for my tasks */
-			(void) mom_set_use(pjob);
+			if (mock_run)
+				(void) mock_run_mom_set_use(pjob);
+			else
+				(void) mom_set_use(pjob);
+
+			/* move the walltime deadline with the latest usage */
+			walltime_arm(pjob);
 
 			/* see if need to check point any job */
 			if (pjob->ji_chkpttype == PBS_CHECKPOINT_CPUT) {
@@ -8692,6 +9086,9 @@ main(int argc, char *argv[])
 			/* send updated resource usage info to server */
 			update_jobs_status();
 		}
+#ifndef WIN32
+		pbs_hist_since(&mom_pass_hist, pass_start);
+#endif
 #ifdef NAS /* localmod 153 */
 		int rc_qflag = access(quiesce_mom_flag_file, F_OK);
 
@@ -8840,6 +9237,7 @@ main(int argc, char *argv[])
 	if (exiting_tasks)
 		scan_for_exiting();
 	(void) mom_close_poll();
+	obit_batch_delay = 0; /* do not hold back obits on the way out */
 	send_pending_updates();
 
 	net_close(-1); /* close all network connections */
@@ -9520,50 +9918,35 @@ check_busy(double mla)
 	}
 }
 
+#ifndef WIN32
 /**
- * @fn mom_topology
  * @brief
- *	compute and export platform-dependent topology information
- *
- * @return	void
- *
- * @par MT-Safe:	no
- * @par Side Effects:
- *	None
- *
- * @par Note:	nominally, we use the Open-MPI hardware locality (a.k.a. hwloc)
- *		functions to export the topology information that it generates,
- *		but the case for the Cray is different.
- *
- *		Also note that whenever we want the topology node attribute to
- *		contain a different type of information, this function will need
- *		to change.
- *
- *		On Windows we use native Windows API's to discover the topology
+ *	run hwloc discovery in a child process and collect its XML export
  *
- * @see	dep_topology()
+ * @param[out]	xmlbufp - malloc'd, NUL-terminated XML on success
+ * @param[out]	xmllenp - length of the XML
  *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	failure
  */
-void
-mom_topology(void)
+static int
+topology_discover(char **xmlbufp, int *xmllenp)
 {
-	extern char mom_short_name[];
-	extern callfunc_t vn_callback;
 	int ret = -1;
 	char *xmlbuf = NULL;
 	int xmllen = 0;
-	vnl_t *vtp = NULL;
-	char *topology_type;
 	int fd[2];
 	int pid;
+	int got;
+	ssize_t nread;
 
-#ifndef WIN32
 	if (pipe(fd) == -1) 
 		log_errf(-1, __func__, "pipe API failed. ERR : %s", strerror(errno));
 
 	if ((pid = fork()) == -1) {
 		log_err(PBSE_SYSTEM, __func__, "fork failed");
-		return;
+		return (-1);
 	}
 
 	if (pid == 0) {
@@ -9616,16 +9999,223 @@ mom_topology(void)
 			log_errf(-1, __func__, "read failed. ERR : %s", strerror(errno));			
 		if ((xmlbuf = malloc(xmllen + 1)) == NULL) {
 			log_err(PBSE_SYSTEM, __func__, "malloc failed");
-			return;
+			close(fd[0]);
+			waitpid(pid, NULL, 0);
+			return (-1);
 		}
 		xmlbuf[xmllen] = '\0';
-		if (read(fd[0], xmlbuf, xmllen) == -1) 
-			log_errf(-1, __func__, "read failed. ERR : %s", strerror(errno));
+		/* a large export arrives in several pipe-sized pieces */
+		for (got = 0; got < xmllen; got += nread) {
+			if ((nread = read(fd[0], xmlbuf + got, xmllen - got)) <= 0) {
+				log_errf(-1, __func__, "read failed. ERR : %s", strerror(errno));
+				ret = -1;
+				break;
+			}
+		}
 
 		close(fd[0]);
 
 		waitpid(pid, NULL, 0);
 	}
+	if (ret < 0) {
+		free(xmlbuf);
+		return (-1);
+	}
+	*xmlbufp = xmlbuf;
+	*xmllenp = xmllen;
+	return (0);
+}
+
+/**
+ * @brief
+ *	describe the hardware and boot instance the hwloc topology came from
+ *
+ * @par
+ *	The topology cannot change without a reboot short of CPU or memory
+ *	hotplug, so the kernel boot id plus the configured CPU and page
+ *	counts are enough to tell when a cached export is stale.
+ *
+ * @param[out]	buf - fingerprint string
+ * @param[in]	len - size of buf
+ *
+ * @return	int
+ * @retval	0	fingerprint built
+ * @retval	-1	no boot id available, do not cache
+ */
+static int
+topology_fingerprint(char *buf, size_t len)
+{
+	FILE *fp;
+	char boot_id[64];
+	char *nl;
+
+	if ((fp = fopen("/proc/sys/kernel/random/boot_id", "r")) == NULL)
+		return (-1);
+	if (fgets(boot_id, sizeof(boot_id), fp) == NULL) {
+		fclose(fp);
+		return (-1);
+	}
+	fclose(fp);
+	if ((nl = strchr(boot_id, '\n')) != NULL)
+		*nl = '\0';
+	snprintf(buf, len, "hwloc=%x boot=%s cpus=%ld pages=%ld",
+		 (unsigned int) HWLOC_API_VERSION, boot_id,
+		 sysconf(_SC_NPROCESSORS_CONF), sysconf(_SC_PHYS_PAGES));
+	return (0);
+}
+
+/**
+ * @brief
+ *	read the topology export saved by an earlier mom on this boot
+ *
+ * @par
+ *	The cache is mom_priv/topology.cache: one fingerprint line, one
+ *	length line, then the XML itself.
+ *
+ * @param[in]	fingerprint - current hardware fingerprint
+ * @param[out]	xmlbufp - malloc'd, NUL-terminated XML on success
+ * @param[out]	xmllenp - length of the XML
+ *
+ * @return	int
+ * @retval	0	cache hit
+ * @retval	-1	missing, stale or unreadable cache
+ */
+static int
+topology_cache_load(char *fingerprint, char **xmlbufp, int *xmllenp)
+{
+	char path[MAXPATHLEN + 1];
+	char line[256];
+	FILE *fp;
+	char *xmlbuf;
+	int xmllen;
+
+	if ((snprintf(path, sizeof(path), "%s/topology.cache", mom_home) >= (int) sizeof(path)) ||
+	    ((fp = fopen(path, "r")) == NULL))
+		return (-1);
+	if ((fgets(line, sizeof(line), fp) == NULL) ||
+	    (strncmp(line, fingerprint, strlen(fingerprint)) != 0) ||
+	    (line[strlen(fingerprint)] != '\n') ||
+	    (fgets(line, sizeof(line), fp) == NULL) ||
+	    ((xmllen = atoi(line)) <= 0) ||
+	    ((xmlbuf = malloc(xmllen + 1)) == NULL)) {
+		fclose(fp);
+		return (-1);
+	}
+	if (fread(xmlbuf, 1, xmllen, fp) != (size_t) xmllen) {
+		free(xmlbuf);
+		fclose(fp);
+		return (-1);
+	}
+	fclose(fp);
+	xmlbuf[xmllen] = '\0';
+	*xmlbufp = xmlbuf;
+	*xmllenp = xmllen;
+	return (0);
+}
+
+/**
+ * @brief
+ *	save a fresh topology export for the next mom started on this boot
+ *
+ * @param[in]	fingerprint - current hardware fingerprint
+ * @param[in]	xmlbuf - XML export
+ * @param[in]	xmllen - length of the XML
+ *
+ * @return	void
+ */
+static void
+topology_cache_save(char *fingerprint, char *xmlbuf, int xmllen)
+{
+	char path[MAXPATHLEN + 1];
+	char tmppath[MAXPATHLEN + 1];
+	FILE *fp;
+	int bad;
+
+	if ((snprintf(path, sizeof(path), "%s/topology.cache", mom_home) >= (int) sizeof(path)) ||
+	    (snprintf(tmppath, sizeof(tmppath), "%s.new", path) >= (int) sizeof(tmppath))) {
+		log_err(ENAMETOOLONG, __func__, path);
+		return;
+	}
+	if ((fp = fopen(tmppath, "w")) == NULL) {
+		log_errf(errno, __func__, "cannot create %s", tmppath);
+		return;
+	}
+	bad = (fprintf(fp, "%s\n%d\n", fingerprint, xmllen) < 0) ||
+	      (fwrite(xmlbuf, 1, xmllen, fp) != (size_t) xmllen);
+	if ((fclose(fp) != 0) || bad || (rename(tmppath, path) == -1)) {
+		log_errf(errno, __func__, "cannot write %s", path);
+		(void) unlink(tmppath);
+	}
+}
+
+/**
+ * @brief
+ *	get the hwloc XML export, from the cache when the hardware is known
+ *
+ * @param[out]	xmlbufp - malloc'd, NUL-terminated XML on success
+ * @param[out]	xmllenp - length of the XML
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	failure
+ */
+static int
+topology_load(char **xmlbufp, int *xmllenp)
+{
+	char fingerprint[256];
+	int cacheable;
+
+	cacheable = (topology_fingerprint(fingerprint, sizeof(fingerprint)) == 0);
+	if (cacheable && (topology_cache_load(fingerprint, xmlbufp, xmllenp) == 0)) {
+		log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_NODE, LOG_DEBUG,
+			  __func__, "topology read from cache");
+		return (0);
+	}
+	if (topology_discover(xmlbufp, xmllenp) != 0)
+		return (-1);
+	if (cacheable)
+		topology_cache_save(fingerprint, *xmlbufp, *xmllenp);
+	return (0);
+}
+#endif /* !WIN32 */
+
+/**
+ * @fn mom_topology
+ * @brief
+ *	compute and export platform-dependent topology information
+ *
+ * @return	void
+ *
+ * @par MT-Safe:	no
+ * @par Side Effects:
+ *	None
+ *
+ * @par Note:	nominally, we use the Open-MPI hardware locality (a.k.a. hwloc)
+ *		functions to export the topology information that it generates,
+ *		but the case for the Cray is different.
+ *
+ *		Also note that whenever we want the topology node attribute to
+ *		contain a different type of information, this function will need
+ *		to change.
+ *
+ *		On Windows we use native Windows API's to discover the topology
+ *
+ * @see	dep_topology()
+ *
+ */
+void
+mom_topology(void)
+{
+	extern char mom_short_name[];
+	extern callfunc_t vn_callback;
+	int ret = -1;
+	char *xmlbuf = NULL;
+	int xmllen = 0;
+	vnl_t *vtp = NULL;
+	char *topology_type;
+
+#ifndef WIN32
+	ret = topology_load(&xmlbuf, &xmllen);
 	if (ret < 0) {
 		/* on any failure above, issue log message */
 		log_err(PBSE_SYSTEM, __func__, "topology init/load/export failed");
@@ -446,15 +446,21 @@ pbs_pmix_fence_nb(
 		log_err(-1, __func__, log_buffer);
 		return PMIX_ERROR;
 	}
-	for (i = 0; i < nproc; i++) {
-		log_eventf(PBSEVENT_DEBUG3, 0, LOG_DEBUG, __func__,
-			   "proc[%d].nspace = %s", i, proc[i].nspace);
-		log_eventf(PBSEVENT_DEBUG3, 0, LOG_DEBUG, __func__,
-			   "proc[%d].rank = %u", i, (unsigned int) proc[i].rank);
-	}
-	for (i = 0; i < ninfo; i++) {
-		log_eventf(PBSEVENT_DEBUG3, 0, LOG_DEBUG, __func__,
-			   "info[%d].key = %s", i, info[i].key);
+	/*
+	 * A fence over a large job lists every participating rank, so
+	 * only walk the arrays when the entries will actually be logged.
+	 */
+	if (will_log_event(PBSEVENT_DEBUG3)) {
+		for (i = 0; i < nproc; i++) {
+			log_eventf(PBSEVENT_DEBUG3, 0, LOG_DEBUG, __func__,
+				   "proc[%d].nspace = %s", i, proc[i].nspace);
+			log_eventf(PBSEVENT_DEBUG3, 0, LOG_DEBUG, __func__,
+				   "proc[%d].rank = %u", i, (unsigned int) proc[i].rank);
+		}
+		for (i = 0; i < ninfo; i++) {
+			log_eventf(PBSEVENT_DEBUG3, 0, LOG_DEBUG, __func__,
+				   "info[%d].key = %s", i, info[i].key);
+		}
 	}
 	log_eventf(PBSEVENT_DEBUG3, 0, LOG_DEBUG, __func__,
 		   "There are %lu data entries", ndata);
@@ -691,6 +691,9 @@ is_request(int stream, int version)
 
 			time_delta_hellosvr(MOM_DELTA_RESET);
 
+			/* the server may have missed updates, resend everything */
+			forget_sent_resc_used();
+
 			need_inv = disrsi(stream, &ret);
 			if (ret != DIS_SUCCESS)
 				goto err;
@@ -727,6 +730,8 @@ is_request(int stream, int version)
 			/* send any unacknowledged hook job and vnl action requests */
 			send_hook_job_action(NULL);
 			hook_requests_to_server(&svr_hook_vnl_actions);
+			/* the server may not have what periodic hooks last sent */
+			periodic_vnl_forget();
 
 			/* send any vnode changes made by */
 			/* exechost_startup hook */
@@ -52,8 +52,10 @@
 #include "mom_server.h"
 #include "hook.h"
 #include "tpp.h"
+#include "pbs_json.h"
 
 extern pbs_list_head mom_pending_ruu;
+extern pbs_list_head svr_alljobs;
 extern int resc_access_perm;
 extern int server_stream;
 extern time_t time_now;
@@ -63,6 +65,7 @@ static ruu *get_job_update(job *pjob);
 static PyObject *json_loads(char *value, char *msg, size_t msg_len);
 static char *json_dumps(PyObject *py_val, char *msg, size_t msg_len);
 static void encode_used(job *pjob, pbs_list_head *phead);
+static void delta_resc_used(job *pjob, ruu *prused, int full);
 
 static PyObject *py_json_name = NULL;
 static PyObject *py_json_module = NULL;
@@ -355,6 +358,7 @@ encode_used(job *pjob, pbs_list_head *phead)
 		char emsg[HOOK_BUF_SIZE];
 		attribute tmpatr = {0};
 		attribute tmpatr3 = {0};
+		pbs_json_parser jp;
 
 		rd = rs->rs_defin;
 		if ((rd->rs_flags & resc_access_perm) == 0)
@@ -628,7 +632,12 @@ encode_used(job *pjob, pbs_list_head *phead)
 				 */
 
 				sval = val.at_val.at_str;
-				if ((py_jvalue = json_loads(sval, emsg, HOOK_BUF_SIZE - 1)) != NULL) {
+				/* only an object can load as a dictionary, so
+				 * plain strings never go through python
+				 */
+				pbs_json_parser_init(&jp, sval);
+				if (pbs_json_next(&jp) == PBS_JSON_BEGIN_OBJECT &&
+				    (py_jvalue = json_loads(sval, emsg, HOOK_BUF_SIZE - 1)) != NULL) {
 					dumps = json_dumps(py_jvalue, emsg, HOOK_BUF_SIZE - 1);
 					if (dumps == NULL)
 						Py_CLEAR(py_jvalue);
@@ -694,6 +703,7 @@ get_job_update(job *pjob)
 		JOB_ATR_runcount,
 		JOB_ATR_exec_vnode,
 		JOB_ATR_SchedSelect,
+		JOB_ATR_startup_latency,
 		JOB_ATR_LAST};
 	ruu *prused;
 	int i;
@@ -764,6 +774,86 @@ get_job_update(job *pjob)
 	return prused;
 }
 
+/**
+ * @brief
+ * 	Reduce the resources_used entries of an update to those that changed
+ * 	since the last update of the job, and number the update.
+ *
+ * @par
+ * 	The values sent are remembered in pjob->ji_ruu_sent.  An entry also
+ * 	stays when it is in the pending update this one replaces, which was
+ * 	never sent.  Every RUU_FULL_REFRESH-th update is a full one anyway.
+ *
+ * @param[in] pjob   - pointer to job
+ * @param[in] prused - the update, as built by get_job_update()
+ * @param[in] full   - keep all entries
+ *
+ * @return void
+ *
+ */
+static void
+delta_resc_used(job *pjob, ruu *prused, int full)
+{
+	ruu *pending = (ruu *) pjob->ji_pending_ruu;
+	svrattrl *pal;
+	svrattrl *next;
+	svrattrl *psent;
+	int seq;
+
+	if (pending != NULL && pending->ru_cmd != IS_JOBOBIT && (pending->ru_status & RUU_SEQ_MASK) != 0) {
+		/* takes the place of the pending update in the sequence */
+		seq = pending->ru_status & RUU_SEQ_MASK;
+		full |= (pending->ru_status & RUU_SEQ_FULL) != 0;
+	} else {
+		seq = (pjob->ji_ruu_seq % RUU_SEQ_MASK) + 1;
+		pjob->ji_ruu_seq = seq;
+	}
+	if ((seq % RUU_FULL_REFRESH) == 0)
+		full = 1;
+
+	for (pal = (svrattrl *) GET_NEXT(prused->ru_attr); pal != NULL; pal = next) {
+		next = (svrattrl *) GET_NEXT(pal->al_link);
+		if (pal->al_resc == NULL || pal->al_value == NULL ||
+		    (strcmp(pal->al_name, ATTR_used) != 0 && strcmp(pal->al_name, ATTR_used_update) != 0))
+			continue;
+
+		psent = find_svrattrl_list_entry(&pjob->ji_ruu_sent, pal->al_name, pal->al_resc);
+		if (psent != NULL && strcmp(psent->al_value, pal->al_value) == 0) {
+			if (!full && (pending == NULL ||
+				      find_svrattrl_list_entry(&pending->ru_attr, pal->al_name, pal->al_resc) == NULL)) {
+				delete_link(&pal->al_link);
+				free(pal);
+			}
+			continue;
+		}
+		if (psent != NULL) {
+			delete_link(&psent->al_link);
+			free(psent);
+		}
+		(void) add_to_svrattrl_list(&pjob->ji_ruu_sent, pal->al_name, pal->al_resc,
+					    pal->al_value, pal->al_flags, NULL);
+	}
+
+	prused->ru_status = seq | (full ? RUU_SEQ_FULL : 0);
+}
+
+/**
+ * @brief
+ * 	Forget the resources_used values sent for all jobs, so that the next
+ * 	update of each job is a full one, as after the server (re)connects.
+ *
+ * @return void
+ *
+ */
+void
+forget_sent_resc_used(void)
+{
+	job *pjob;
+
+	for (pjob = (job *) GET_NEXT(svr_alljobs); pjob != NULL; pjob = (job *) GET_NEXT(pjob->ji_alljobs))
+		free_attrlist(&pjob->ji_ruu_sent);
+}
+
 /**
  * @brief
  * 	generate resc used update for given job and put it in queue
@@ -785,6 +875,10 @@ enqueue_update_for_send(job *pjob, int cmd)
 	if (prused == NULL)
 		return 1; /* get_job_update has done error logging */
 
+	/* obits and hook updates stay complete, periodic ones carry changes only */
+	if (cmd != IS_JOBOBIT)
+		delta_resc_used(pjob, prused, cmd != IS_RESCUSED);
+
 	if ((pjob->ji_qs.ji_svrflags & JOB_SVFLG_HERE) == 0) {
 		/* If sister node of job, send update right away */
 		send_resc_used(cmd, 1, prused);
@@ -814,6 +908,8 @@ enqueue_update_for_send(job *pjob, int cmd)
  * 	if cmd of update is not IS_OBIT then check time of creatation
  * 	of update and based on that decide whether to send that update
  * 	or delay it for rescused_send_delay
+ * 	obits all go out together once the oldest of them has been held
+ * 	for obit_batch_delay seconds
  *
  * @param[out] r_cnt    - number of updates in prused bundle
  * @param[out] prused   - bundle of IS_RESCUSED updates
@@ -831,6 +927,7 @@ bundle_ruu(int *r_cnt, ruu **prused, int *rh_cnt, ruu **prhused, int *obits_cnt,
 	static int rescused_send_delay = 2;
 	ruu *cur;
 	ruu *next;
+	int obits_due = 0;
 
 	*r_cnt = 0;
 	*prused = NULL;
@@ -846,6 +943,8 @@ bundle_ruu(int *r_cnt, ruu **prused, int *rh_cnt, ruu **prhused, int *obits_cnt,
 			cur->ru_next = *obits;
 			*obits = cur;
 			(*obits_cnt)++;
+			if (time_now >= (cur->ru_created_at + obit_batch_delay))
+				obits_due = 1;
 		} else if (time_now >= (cur->ru_created_at + rescused_send_delay)) {
 			if (cur->ru_cmd == IS_RESCUSED) {
 				cur->ru_next = *prused;
@@ -859,6 +958,12 @@ bundle_ruu(int *r_cnt, ruu **prused, int *rh_cnt, ruu **prhused, int *obits_cnt,
 		}
 		cur = next;
 	}
+
+	if (!obits_due) {
+		/* held obits stay on mom_pending_ruu for a later pass */
+		*obits_cnt = 0;
+		*obits = NULL;
+	}
 }
 
 /**
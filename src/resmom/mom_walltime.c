@@ -42,6 +42,7 @@
 #include "job.h"
 #include "pbs_assert.h"
 #include "resource.h"
+#include "work_task.h"
 #include <stdlib.h>
 #include <sys/types.h>
 #include <time.h>
@@ -49,6 +50,108 @@
 time_t time_now = 0;
 double wallfactor = 1.00;
 
+extern time_t time_resc_updated;
+
+/**
+ * @brief
+ *
+ *		walltime_deadline() is the work task run when a job reaches
+ *		its walltime limit.  It brings the next resource check in the
+ *		main loop forward to now so the job is killed without waiting
+ *		for the rest of the check_poll interval.
+ *
+ * @param[in] 	ptask	    - work task, wt_parm1 is the job
+ *
+ * @return	void
+ *
+ * @par MT-safe: No
+ */
+static void
+walltime_deadline(struct work_task *ptask)
+{
+	job *pjob = (job *) ptask->wt_parm1;
+
+	pjob->ji_walltime_task = NULL;
+	time_resc_updated = 0;
+}
+
+/**
+ * @brief
+ *
+ *		walltime_disarm() cancels a pending walltime deadline of a job.
+ *
+ * @param[in] 	pjob	    - pointer to the job
+ *
+ * @return	void
+ *
+ * @par MT-safe: No
+ */
+static void
+walltime_disarm(job *pjob)
+{
+	if (pjob->ji_walltime_task != NULL) {
+		delete_task(pjob->ji_walltime_task);
+		pjob->ji_walltime_task = NULL;
+	}
+}
+
+/**
+ * @brief
+ *
+ *		walltime_arm() sets a timed work task for the moment the job
+ *		will go over its walltime limit at the current wallfactor.
+ *		Only Mother Superior checks walltime, and a job that is not
+ *		accumulating walltime has no deadline.
+ *
+ * @param[in] 	pjob	    - pointer to the job
+ *
+ * @return	void
+ *
+ * @par MT-safe: No
+ */
+void
+walltime_arm(job *pjob)
+{
+	resource_def *walltime_def;
+	resource *limit;
+	resource *used;
+	long left;
+	time_t when;
+
+	if (NULL == pjob)
+		return;
+	if (((pjob->ji_qs.ji_svrflags & JOB_SVFLG_HERE) == 0) ||
+	    (0 == pjob->ji_walltime_stamp) || (wallfactor <= 0.0)) {
+		walltime_disarm(pjob);
+		return;
+	}
+
+	walltime_def = &svr_resc_def[RESC_WALLTIME];
+	limit = find_resc_entry(get_jattr(pjob, JOB_ATR_resource), walltime_def);
+	if ((NULL == limit) || !is_attr_set(&limit->rs_value)) {
+		walltime_disarm(pjob);
+		return;
+	}
+	used = find_resc_entry(get_jattr(pjob, JOB_ATR_resc_used), walltime_def);
+
+	left = limit->rs_value.at_val.at_long;
+	if ((NULL != used) && is_attr_set(&used->rs_value))
+		left -= used->rs_value.at_val.at_long;
+	left -= (long) ((time_now - pjob->ji_walltime_stamp) * wallfactor);
+
+	/* the limit check wants used > limit, so land just past it */
+	when = time_now + 1;
+	if (left > 0)
+		when += (time_t) (left / wallfactor);
+
+	if (pjob->ji_walltime_task != NULL) {
+		if (pjob->ji_walltime_task->wt_event == when)
+			return;
+		delete_task(pjob->ji_walltime_task);
+	}
+	pjob->ji_walltime_task = set_task(WORK_Timed, when, walltime_deadline, pjob);
+}
+
 /**
  * @brief
  *
@@ -73,6 +176,7 @@ start_walltime(job *pjob)
 		time_now = time(NULL);
 
 	pjob->ji_walltime_stamp = time_now;
+	walltime_arm(pjob);
 }
 
 /**
@@ -146,6 +250,7 @@ stop_walltime(job *pjob)
 	/* update walltime and stop accumulating */
 	update_walltime(pjob);
 	pjob->ji_walltime_stamp = 0;
+	walltime_disarm(pjob);
 }
 
 /**
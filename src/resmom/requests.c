@@ -387,7 +387,7 @@ fork_to_user(struct batch_request *preq, job *pjob)
 		/* Account ID used to be set her for Cray via acctid(). */
 	} else {
 		/* Need to look up the uid, gid, and home directory */
-		if ((pwdp = getpwnam(rqcpf->rq_user)) == NULL)
+		if ((pwdp = getpwnam_cached(rqcpf->rq_user)) == NULL)
 			frk_err(PBSE_BADUSER, preq); /* no return */
 		useruid = pwdp->pw_uid;
 		user_rgid = pwdp->pw_gid;
@@ -395,7 +395,7 @@ fork_to_user(struct batch_request *preq, job *pjob)
 		if (rqcpf->rq_group[0] == '\0')
 			usergid = pwdp->pw_gid; /* default to login group */
 		else {
-			if ((grpp = getgrnam(rqcpf->rq_group)) == NULL)
+			if ((grpp = getgrnam_cached(rqcpf->rq_group)) == NULL)
 				frk_err(PBSE_BADUSER, preq); /* no return */
 			usergid = grpp->gr_gid;
 		}
@@ -3121,7 +3121,7 @@ req_cpyfile(struct batch_request *preq)
 	stage_inout.sandbox_private = (rqcpf->rq_dir & STAGE_JOBDIR) ? TRUE : FALSE;
 
 	/* Call getpwnam for user info */
-	pwdp = getpwnam(rqcpf->rq_user);
+	pwdp = getpwnam_cached(rqcpf->rq_user);
 	if (pwdp != NULL) {
 		pbs_jobdir = jobdirname(rqcpf->rq_jobid, pwdp->pw_dir);
 	} else {
@@ -3142,7 +3142,7 @@ req_cpyfile(struct batch_request *preq)
 		if (rqcpf->rq_group[0] == '\0') {
 			usergid = pwdp->pw_gid; /* default to login group */
 		} else {
-			if ((grpp = getgrnam(rqcpf->rq_group)) == NULL) {
+			if ((grpp = getgrnam_cached(rqcpf->rq_group)) == NULL) {
 				req_reject(PBSE_BADUSER, 0, preq);
 				return;
 			}
@@ -51,6 +51,9 @@
 #include <time.h>
 #include <sys/wait.h>
 #include <dirent.h>
+#ifndef WIN32
+#include <unistd.h>
+#endif
 #include "tpp.h"
 #include "pbs_ifl.h"
 #include "list_link.h"
@@ -82,6 +85,9 @@ extern char mom_host[PBS_MAXHOSTNAME + 1]; /* MoM host name */
 int stage_file(int, int, char *, struct rqfpair *, int, cpy_files *, char *, char *);
 static int sys_copy(int, int, char *, char *, struct rqfpair *, int, char *, char *);
 
+/* size of the buffer used by copy_local_file() when the kernel can not copy */
+#define LOCAL_COPY_BUFSZ (256 * 1024)
+
 /**
  * A path in windows is not case sensitive so do a define
  * to do the right compare.
@@ -1438,6 +1444,115 @@ is_pbs_rcp_path(void)
  *		"pair->fp_local" is the local destination path in both cases
  *
  */
+#ifndef WIN32
+/**
+ * @brief
+ *	Copy a local regular file without running cp.
+ *
+ * @par Functionality:
+ *	Staging many small files on the local or a shared file system used to
+ *	cost a fork and exec of cp for each of them.  Regular files are now
+ *	copied here, with copy_file_range() so the kernel or the file server
+ *	moves the data where it can, else through a read/write loop.  Like
+ *	"cp -p" the mode and times of the source are kept and a destination
+ *	directory gets the file under its own name.  Anything else, such as
+ *	a directory or symbolic link, is left to cp.
+ *
+ * @param[in]	src - the source path
+ * @param[in]	dst - the destination path, a file or a directory
+ *
+ * @return int
+ * @retval  0	the file was copied
+ * @retval -1	the file was not copied, the caller should fall back to cp
+ */
+static int
+copy_local_file(char *src, char *dst)
+{
+	int sfd = -1;
+	int dfd = -1;
+	int rc = -1;
+	ssize_t n = -1;
+	char *buf = NULL;
+	char *slash;
+	struct stat ssb;
+	struct stat dsb;
+	struct timespec times[2];
+	char target[MAXPATHLEN + 1];
+
+	if ((lstat(src, &ssb) == -1) || !S_ISREG(ssb.st_mode))
+		return (-1);
+
+	pbs_strncpy(target, dst, sizeof(target));
+	if (stat(dst, &dsb) == -1)
+		dsb.st_ino = 0;
+	else if (S_ISDIR(dsb.st_mode)) {
+		slash = strrchr(src, '/');
+		if (strlen(dst) + strlen(slash ? slash : src) + 2 > sizeof(target))
+			return (-1);
+		strcat(target, "/");
+		strcat(target, slash ? slash + 1 : src);
+		if (stat(target, &dsb) == -1)
+			dsb.st_ino = 0;
+	}
+	/* copying a file onto itself is an error cp reports, leave it to cp */
+	if ((dsb.st_ino == ssb.st_ino) && (dsb.st_dev == ssb.st_dev))
+		return (-1);
+
+	if ((sfd = open(src, O_RDONLY)) == -1)
+		return (-1);
+	if ((dfd = open(target, O_WRONLY | O_CREAT | O_TRUNC, ssb.st_mode & 0777)) == -1)
+		goto local_copy_end;
+
+#ifdef HAVE_COPY_FILE_RANGE
+	while ((n = copy_file_range(sfd, NULL, dfd, NULL, LOCAL_COPY_BUFSZ * 64, 0)) > 0)
+		;
+	if ((n == -1) && (errno != EXDEV) && (errno != ENOSYS) &&
+	    (errno != EINVAL) && (errno != EOPNOTSUPP))
+		goto local_copy_end;
+#endif
+	if (n != 0) {
+		/* no copy_file_range() for these files, copy what is left by hand */
+		if ((buf = malloc(LOCAL_COPY_BUFSZ)) == NULL)
+			goto local_copy_end;
+		while ((n = read(sfd, buf, LOCAL_COPY_BUFSZ)) > 0) {
+			char *p = buf;
+
+			while (n > 0) {
+				ssize_t w = write(dfd, p, n);
+
+				if (w == -1) {
+					if (errno == EINTR)
+						continue;
+					goto local_copy_end;
+				}
+				p += w;
+				n -= w;
+			}
+		}
+		if (n == -1)
+			goto local_copy_end;
+	}
+
+	times[0] = ssb.st_atim;
+	times[1] = ssb.st_mtim;
+	if ((fchmod(dfd, ssb.st_mode & 07777) == -1) || (futimens(dfd, times) == -1))
+		goto local_copy_end;
+	if (close(dfd) == 0)
+		rc = 0;
+	dfd = -1;
+
+local_copy_end:
+	if (rc != 0)
+		log_errf(errno, __func__, "copy of %s to %s failed, retrying with %s",
+			 src, target, pbs_conf.cp_path);
+	free(buf);
+	if (dfd != -1)
+		(void) close(dfd);
+	(void) close(sfd);
+	return (rc);
+}
+#endif
+
 static int
 sys_copy(int dir, int rmtflg, char *owner, char *src, struct rqfpair *pair, int conn, char *prmt, char *jobid)
 {
@@ -1619,6 +1734,11 @@ sys_copy(int dir, int rmtflg, char *owner, char *src, struct rqfpair *pair, int
 	}
 
 #ifndef WIN32
+	/* a local regular file needs no cp */
+	if ((rmtflg == 0) && (strcmp(ag3, "/dev/null") != 0) &&
+	    (copy_local_file(ag2, ag3) == 0))
+		return (0);
+
 	for (loop = 1; loop < 5; ++loop) {
 		original = 0;
 		if (rmtflg == 0) { /* local copy */
@@ -60,6 +60,9 @@
 #include <sys/resource.h>
 #include <sys/socket.h>
 #include <sys/wait.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 #include <netinet/in.h>
 #include <fcntl.h>
 
@@ -126,6 +129,10 @@ extern time_t time_resc_updated;
 extern char *path_hooks_workdir;
 extern long joinjob_alarm_time;
 extern long job_launch_delay;
+extern int cleanup_worker;
+extern pid_t mom_pid;
+extern char *log_file;
+extern char *path_log;
 int mom_reader_go; /* see catchinter() & mom_writer() */
 
 extern int x11_reader_go;
@@ -154,6 +161,7 @@ static pid_t writerpid; /* writer side of interactive job */
 static pid_t shellpid;	/* shell part of interactive job  */
 static size_t cred_len;
 static char *cred_buf;
+static int cleanup_worker_fd = -1; /* write end of the pipe to the cleanup worker */
 
 char *variables_else[] = {/* variables to add, value computed */
 			  "HOME",
@@ -171,13 +179,33 @@ char *variables_else[] = {/* variables to add, value computed */
 			  "OMP_NUM_THREADS",
 			  "PBS_ACCOUNT",
 			  "PBS_ARRAY_INDEX",
-			  "PBS_ARRAY_ID"};
+			  "PBS_ARRAY_ID",
+			  "PBS_NODEFILE_HOSTLIST"};
 
 static int num_var_else = sizeof(variables_else) / sizeof(char *);
 static void catchinter(int);
 
 extern int is_direct_write(job *, enum job_file, char *, int *);
 static int direct_write_possible = 1;
+extern int nodefile_hostlist;
+
+/* stdio buffer used while writing PBS_NODEFILE */
+#define NODEFILE_BUFSZ (64 * 1024)
+
+/*
+ * A run of hosts for the compact hostlist, i.e. hosts which share a name
+ * prefix, have consecutive numeric suffixes of the same width and hold the
+ * same number of nodefile entries each: "node[001-400]:64".
+ */
+struct hostlist_run {
+	const char *hr_name; /* name of the first host in the run */
+	size_t hr_nlen;	     /* length of hr_name */
+	size_t hr_plen;	     /* length of the prefix before the numeric suffix */
+	size_t hr_dlen;	     /* width of the numeric suffix, 0 if none */
+	long hr_first;	     /* numeric suffix of the first host */
+	long hr_last;	     /* numeric suffix of the last host */
+	int hr_count;	     /* nodefile entries per host */
+};
 
 void
 starter_return(int upfds, int downfds, int code,
@@ -255,6 +283,246 @@ no_hang(int sig)
 		  "alarm timed-out connect to qsub");
 }
 
+/*
+ * NSS lookup cache, see $nss_cache_ttl.  Users and groups are looked up in
+ * the parent mom, so forked job starters and stagers inherit the answers.
+ * A user entry also keeps the supplementary group list initgroups() would
+ * have built for the last gid asked for in getgroups_cached().
+ */
+typedef struct nss_ent {
+	struct nss_ent *ne_next;
+	time_t ne_time;	    /* when the entry was looked up */
+	int ne_isgroup;	    /* ne_gr is valid, else ne_pw */
+	struct passwd ne_pw;
+	struct group ne_gr;
+	gid_t ne_gid;	    /* gid ne_groups was built for */
+	int ne_ngroups;	    /* entries in ne_groups, -1 if not built */
+	gid_t *ne_groups;
+} nss_ent_t;
+
+static nss_ent_t *nss_cache = NULL;
+
+/**
+ * @brief
+ *	free one NSS cache entry
+ *
+ * @param[in] ne - entry to free
+ *
+ * @return void
+ */
+static void
+nss_ent_free(nss_ent_t *ne)
+{
+	char **pmem;
+
+	if (ne->ne_isgroup) {
+		free(ne->ne_gr.gr_name);
+		free(ne->ne_gr.gr_passwd);
+		if (ne->ne_gr.gr_mem != NULL) {
+			for (pmem = ne->ne_gr.gr_mem; *pmem; pmem++)
+				free(*pmem);
+			free(ne->ne_gr.gr_mem);
+		}
+	} else {
+		free(ne->ne_pw.pw_name);
+		free(ne->ne_pw.pw_passwd);
+		free(ne->ne_pw.pw_gecos);
+		free(ne->ne_pw.pw_dir);
+		free(ne->ne_pw.pw_shell);
+	}
+	free(ne->ne_groups);
+	free(ne);
+}
+
+/**
+ * @brief
+ *	drop every cached NSS lookup, done whenever mom rereads its config
+ *
+ * @return void
+ */
+void
+nss_cache_flush(void)
+{
+	nss_ent_t *ne;
+
+	while ((ne = nss_cache) != NULL) {
+		nss_cache = ne->ne_next;
+		nss_ent_free(ne);
+	}
+}
+
+/**
+ * @brief
+ *	find a current cache entry, dropping any expired ones on the way
+ *
+ * @param[in] name - user or group name
+ * @param[in] isgroup - look for a group rather than a user
+ *
+ * @return nss_ent_t *
+ * @retval NULL - not cached
+ */
+static nss_ent_t *
+nss_ent_find(const char *name, int isgroup)
+{
+	nss_ent_t **pne = &nss_cache;
+	nss_ent_t *ne;
+	char *ename;
+
+	while ((ne = *pne) != NULL) {
+		if (time_now - ne->ne_time >= nss_cache_ttl) {
+			*pne = ne->ne_next;
+			nss_ent_free(ne);
+			continue;
+		}
+		ename = ne->ne_isgroup ? ne->ne_gr.gr_name : ne->ne_pw.pw_name;
+		if ((ne->ne_isgroup == isgroup) && (strcmp(ename, name) == 0))
+			return ne;
+		pne = &ne->ne_next;
+	}
+	return NULL;
+}
+
+/**
+ * @brief
+ *	getpwnam() answered from the NSS cache when $nss_cache_ttl is set
+ *
+ * @param[in] name - user name
+ *
+ * @return struct passwd *
+ * @retval NULL - no such user
+ *
+ * @par Note:	like getpwnam(), the entry may be overwritten by a later call
+ */
+struct passwd *
+getpwnam_cached(const char *name)
+{
+	struct passwd *pwdp;
+	nss_ent_t *ne;
+
+	if (nss_cache_ttl <= 0)
+		return getpwnam(name);
+	if ((ne = nss_ent_find(name, 0)) != NULL)
+		return &ne->ne_pw;
+	if ((pwdp = getpwnam(name)) == NULL)
+		return NULL;
+	if ((ne = calloc(1, sizeof(nss_ent_t))) == NULL)
+		return pwdp;
+	ne->ne_pw = *pwdp;
+	ne->ne_pw.pw_name = strdup(pwdp->pw_name);
+	ne->ne_pw.pw_passwd = strdup(pwdp->pw_passwd ? pwdp->pw_passwd : "");
+	ne->ne_pw.pw_gecos = strdup(pwdp->pw_gecos ? pwdp->pw_gecos : "");
+	ne->ne_pw.pw_dir = strdup(pwdp->pw_dir);
+	ne->ne_pw.pw_shell = strdup(pwdp->pw_shell ? pwdp->pw_shell : "");
+	ne->ne_ngroups = -1;
+	if (!ne->ne_pw.pw_name || !ne->ne_pw.pw_passwd || !ne->ne_pw.pw_gecos ||
+	    !ne->ne_pw.pw_dir || !ne->ne_pw.pw_shell) {
+		nss_ent_free(ne);
+		return pwdp;
+	}
+	ne->ne_time = time_now;
+	ne->ne_next = nss_cache;
+	nss_cache = ne;
+	return &ne->ne_pw;
+}
+
+/**
+ * @brief
+ *	getgrnam() answered from the NSS cache when $nss_cache_ttl is set
+ *
+ * @param[in] name - group name
+ *
+ * @return struct group *
+ * @retval NULL - no such group
+ *
+ * @par Note:	like getgrnam(), the entry may be overwritten by a later call
+ */
+struct group *
+getgrnam_cached(const char *name)
+{
+	struct group *grpp;
+	nss_ent_t *ne;
+	int n;
+	int i;
+
+	if (nss_cache_ttl <= 0)
+		return getgrnam(name);
+	if ((ne = nss_ent_find(name, 1)) != NULL)
+		return &ne->ne_gr;
+	if ((grpp = getgrnam(name)) == NULL)
+		return NULL;
+	if ((ne = calloc(1, sizeof(nss_ent_t))) == NULL)
+		return grpp;
+	ne->ne_isgroup = 1;
+	ne->ne_ngroups = -1;
+	ne->ne_gr.gr_gid = grpp->gr_gid;
+	ne->ne_gr.gr_name = strdup(grpp->gr_name);
+	ne->ne_gr.gr_passwd = strdup(grpp->gr_passwd ? grpp->gr_passwd : "");
+	for (n = 0; grpp->gr_mem && grpp->gr_mem[n]; n++)
+		;
+	ne->ne_gr.gr_mem = calloc(n + 1, sizeof(char *));
+	if (!ne->ne_gr.gr_name || !ne->ne_gr.gr_passwd || !ne->ne_gr.gr_mem) {
+		nss_ent_free(ne);
+		return grpp;
+	}
+	for (i = 0; i < n; i++) {
+		if ((ne->ne_gr.gr_mem[i] = strdup(grpp->gr_mem[i])) == NULL) {
+			nss_ent_free(ne);
+			return grpp;
+		}
+	}
+	ne->ne_time = time_now;
+	ne->ne_next = nss_cache;
+	nss_cache = ne;
+	return &ne->ne_gr;
+}
+
+/**
+ * @brief
+ *	the supplementary group list initgroups(user, gid) would set, kept
+ *	in the user's NSS cache entry
+ *
+ * @param[in] user - user name
+ * @param[in] gid - group to include in the list
+ * @param[out] groups - the cached list, not to be freed by the caller
+ *
+ * @return int
+ * @retval >=0 - number of groups in *groups
+ * @retval -1 - not cached, use initgroups()
+ */
+int
+getgroups_cached(const char *user, gid_t gid, gid_t **groups)
+{
+	nss_ent_t *ne;
+	gid_t *list;
+	int n = 64;
+	int tried;
+
+	if (nss_cache_ttl <= 0)
+		return -1;
+	if ((getpwnam_cached(user) == NULL) || ((ne = nss_ent_find(user, 0)) == NULL))
+		return -1;
+	if ((ne->ne_ngroups >= 0) && (ne->ne_gid == gid)) {
+		*groups = ne->ne_groups;
+		return ne->ne_ngroups;
+	}
+	for (;;) {
+		if ((list = malloc(n * sizeof(gid_t))) == NULL)
+			return -1;
+		tried = n;
+		if (getgrouplist(user, gid, list, &n) != -1)
+			break;
+		free(list);
+		if (n <= tried)
+			n = tried * 2; /* not told how many are needed */
+	}
+	free(ne->ne_groups);
+	ne->ne_groups = list;
+	ne->ne_ngroups = n;
+	ne->ne_gid = gid;
+	*groups = list;
+	return n;
+}
+
 /**
  * @brief
  *	validate credentials of user for job.
@@ -273,8 +541,9 @@ check_pwd(job *pjob)
 	struct group *grpp;
 	struct stat sb;
 	attribute *jb_group;
+	gid_t *cached_groups;
 
-	pwdp = getpwnam(get_jattr_str(pjob, JOB_ATR_euser));
+	pwdp = getpwnam_cached(get_jattr_str(pjob, JOB_ATR_euser));
 	if (pwdp == NULL) {
 		(void) sprintf(log_buffer, "No Password Entry for User %s",
 			       get_jattr_str(pjob, JOB_ATR_euser));
@@ -310,7 +579,7 @@ check_pwd(job *pjob)
 
 		/* execution group specified - not defaulting to login group */
 
-		grpp = getgrnam(get_jattr_str(pjob, JOB_ATR_egroup));
+		grpp = getgrnam_cached(get_jattr_str(pjob, JOB_ATR_egroup));
 		if (grpp == NULL) {
 			(void) sprintf(log_buffer, "No Group Entry for Group %s",
 				       get_jattr_str(pjob, JOB_ATR_egroup));
@@ -336,6 +605,9 @@ check_pwd(job *pjob)
 		pjob->ji_grpcache->gc_gid = pwdp->pw_gid;
 	}
 
+	/* look up the group list here so the job's children inherit it */
+	(void) getgroups_cached(pwdp->pw_name, pjob->ji_grpcache->gc_gid, &cached_groups);
+
 	/* perform site specific check on validatity of account */
 	if (site_mom_chkuser(pjob))
 		return NULL;
@@ -419,6 +691,60 @@ readpipe(int pfd, void *vptr, size_t nbytes)
 	return (nbytes - nleft);
 }
 
+/**
+ * @brief
+ *	Note the time a step of the job start was reached on mother superior.
+ *
+ * @param[in]	pjob - pointer to job structure
+ * @param[in]	step - the step
+ *
+ * @return	None
+ *
+ */
+static void
+startup_step(job *pjob, enum job_startup_step step)
+{
+	struct timeval tv;
+
+	(void) gettimeofday(&tv, NULL);
+	pjob->ji_startup[step] = tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/**
+ * @brief
+ *	Set ATTR_startup_latency from the steps of the job start, for the
+ *	update to the server that reports the session, which puts it in the
+ *	end of job accounting record.
+ *
+ * @par
+ *	join is the time until the sisters joined, launch the time from there
+ *	until the job starter reported the session (prologue and launch hooks,
+ *	remote prologue hooks, setting up the user environment).
+ *
+ * @param[in]	pjob - pointer to job structure
+ *
+ * @return	None
+ *
+ */
+static void
+set_startup_latency(job *pjob)
+{
+	char buf[80];
+	double *ts = pjob->ji_startup;
+
+	if (ts[STARTUP_BEGIN] == 0 || ts[STARTUP_JOINED] == 0)
+		return; /* not started by this mom, e.g. recovered */
+
+	startup_step(pjob, STARTUP_LAUNCHED);
+	snprintf(buf, sizeof(buf), "join:%.3f,launch:%.3f,total:%.3f",
+		 ts[STARTUP_JOINED] - ts[STARTUP_BEGIN],
+		 ts[STARTUP_LAUNCHED] - ts[STARTUP_JOINED],
+		 ts[STARTUP_LAUNCHED] - ts[STARTUP_BEGIN]);
+	set_jattr_str_slim(pjob, JOB_ATR_startup_latency, buf, NULL);
+	(get_jattr(pjob, JOB_ATR_startup_latency))->at_flags |= ATR_VFLAG_MODIFY;
+	log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB, LOG_DEBUG, pjob->ji_qs.ji_jobid, buf);
+}
+
 /**
  * @brief
  *	exec_bail - called when the start of a job fails to clean up
@@ -1045,11 +1371,136 @@ mkjobdir(char *jobid, char *jobdir, uid_t uid, gid_t gid)
 	return 0;
 }
 
+/**
+ * @brief
+ *	Main loop of the cleanup worker.  Directories to remove come from
+ *	Mom as NUL terminated path names; whatever is queued when the worker
+ *	wakes up is removed as one batch, oldest first.  The worker exits
+ *	once Mom closes her end of the pipe or goes away.
+ *
+ * @param[in]	rfd - read end of the pipe from Mom
+ *
+ * @return	does not return
+ */
+static void
+cleanup_worker_main(int rfd)
+{
+	char buf[8 * PIPE_BUF];
+	size_t len = 0;
+	ssize_t n;
+	char *p;
+	char *end;
+
+	signal(SIGTERM, SIG_DFL);
+	signal(SIGINT, SIG_DFL);
+	signal(SIGHUP, SIG_IGN);
+	signal(SIGCHLD, SIG_DFL);
+	signal(SIGPIPE, SIG_IGN);
+
+	/* stay out of the way of the jobs being started */
+	(void) setpriority(PRIO_PROCESS, 0, 10);
+#if defined(__linux__) && defined(SYS_ioprio_set)
+	/* IOPRIO_WHO_PROCESS, best-effort class, lowest level */
+	(void) syscall(SYS_ioprio_set, 1, 0, (2 << 13) | 7);
+#endif
+
+	for (;;) {
+		n = read(rfd, buf + len, sizeof(buf) - len);
+		if (n == -1 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			break;
+		len += n;
+
+		for (p = buf, end = buf + len; (p < end) && (memchr(p, '\0', end - p) != NULL); p += strlen(p) + 1)
+			(void) remtree(p);
+		len = end - p;
+		memmove(buf, p, len);
+
+		if (getppid() == 1)
+			break;
+	}
+	exit(0);
+}
+
+/**
+ * @brief
+ *	Hand a directory to the cleanup worker to remove, starting the
+ *	worker if it is not running.  Path names are at most PIPE_BUF long
+ *	so each one is written whole or not at all.
+ *
+ * @param[in]	path - directory to remove, already renamed out of the
+ *		       way of a new job by the caller
+ *
+ * @return	int
+ * @retval	0  : the worker took the directory
+ * @retval	-1 : it did not, remove it some other way
+ */
+int
+cleanup_worker_send(char *path)
+{
+	size_t len = strlen(path) + 1;
+	int pfds[2];
+	pid_t pid;
+	int retry;
+
+	if (!cleanup_worker || (getpid() != mom_pid) || (len > PIPE_BUF)) {
+		if (cleanup_worker_fd != -1) {
+			(void) close(cleanup_worker_fd);
+			cleanup_worker_fd = -1;
+		}
+		return -1;
+	}
+
+	for (retry = 0; retry < 2; retry++) {
+		if (cleanup_worker_fd == -1) {
+			if (pipe(pfds) == -1) {
+				log_err(errno, __func__, "pipe");
+				return -1;
+			}
+			pid = fork();
+			if (pid == -1) {
+				log_err(errno, __func__, "fork");
+				(void) close(pfds[0]);
+				(void) close(pfds[1]);
+				return -1;
+			}
+			if (pid == 0) {
+				long fd;
+
+				/* a long-lived copy of Mom must not hold the job pipes open */
+				tpp_terminate();
+				log_close(0);
+				fd = sysconf(_SC_OPEN_MAX);
+				while (--fd > 2)
+					if (fd != pfds[0])
+						(void) close(fd);
+				(void) log_open(log_file, path_log);
+				cleanup_worker_main(pfds[0]);
+			}
+			(void) close(pfds[0]);
+			(void) fcntl(pfds[1], F_SETFD, FD_CLOEXEC);
+			(void) fcntl(pfds[1], F_SETFL, O_NONBLOCK);
+			cleanup_worker_fd = pfds[1];
+			log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_SERVER, LOG_DEBUG, __func__,
+				   "started cleanup worker, pid %d", (int) pid);
+		}
+		if (write(cleanup_worker_fd, path, len) == (ssize_t) len)
+			return 0;
+		if (errno != EPIPE)
+			return -1; /* the worker is behind */
+		/* the worker went away, start another one */
+		(void) close(cleanup_worker_fd);
+		cleanup_worker_fd = -1;
+	}
+	return -1;
+}
+
 /**
  * @brief
  * 	rmtmpdir - remove the temporary directory
- *	This may take awhile so the task is forked and execed to another
- *	process.
+ *	This may take awhile so it is handed to the cleanup worker, or
+ *	the task is forked and execed to another process.
  *
  * @param[in] jobid - job id
  *
@@ -1086,7 +1537,8 @@ rmtmpdir(char *jobid)
 		log_joberr(errno, __func__, msgbuf, jobid);
 		free(msgbuf);
 		newdir = tmpdir;
-	}
+	} else if (cleanup_worker_send(newdir) == 0)
+		return;
 
 	/* fork and exec the cleantmp process */
 	pid = fork();
@@ -1149,6 +1601,8 @@ int
 becomeuser_args(char *eusrname, uid_t euid, gid_t egid, gid_t rgid)
 {
 	gid_t *grplist = NULL;
+	gid_t *cached;
+	int numcached;
 	static int maxgroups = 0;
 
 #if defined(PBS_SECURITY) && (PBS_SECURITY == KRB5)
@@ -1162,7 +1616,9 @@ becomeuser_args(char *eusrname, uid_t euid, gid_t egid, gid_t rgid)
 	if (maxgroups == 0)
 		maxgroups = (int) sysconf(_SC_NGROUPS_MAX);
 
-	if (initgroups(eusrname, egid) != -1) {
+	if ((numcached = getgroups_cached(eusrname, egid, &cached)) > maxgroups)
+		numcached = -1;
+	if ((numcached >= 0) || (initgroups(eusrname, egid) != -1)) {
 		int numsup;
 		int i;
 
@@ -1171,7 +1627,11 @@ becomeuser_args(char *eusrname, uid_t euid, gid_t egid, gid_t rgid)
 		if (grplist == NULL)
 			return -1;
 		/* get the current list of groups */
-		numsup = getgroups(maxgroups, grplist);
+		if (numcached >= 0) {
+			memcpy(grplist, cached, numcached * sizeof(gid_t));
+			numsup = numcached;
+		} else
+			numsup = getgroups(maxgroups, grplist);
 		for (i = 0; i < numsup; ++i) {
 			if (grplist[i] == rgid)
 				break;
@@ -1817,6 +2277,7 @@ record_finish_exec(int sd)
 	(get_jattr(pjob, JOB_ATR_jobdir))->at_flags |= ATR_VFLAG_MODIFY;
 	(get_jattr(pjob, JOB_ATR_altid2))->at_flags |= ATR_VFLAG_MODIFY;
 	(get_jattr(pjob, JOB_ATR_acct_id))->at_flags |= ATR_VFLAG_MODIFY;
+	set_startup_latency(pjob);
 
 	enqueue_update_for_send(pjob, IS_RESCUSED);
 	next_sample_time = min_check_poll;
@@ -1825,6 +2286,190 @@ record_finish_exec(int sd)
 	return;
 }
 
+/**
+ * @brief
+ *	Start a new compact hostlist run with the host 'name'.
+ *
+ * @param[out]	run - the run to start
+ * @param[in]	name - host name, need not be null terminated
+ * @param[in]	len - length of 'name'
+ * @param[in]	count - number of nodefile entries for the host
+ *
+ * @return void
+ */
+static void
+hostlist_run_start(struct hostlist_run *run, const char *name, size_t len, int count)
+{
+	size_t i;
+
+	run->hr_name = name;
+	run->hr_nlen = len;
+	run->hr_count = count;
+	for (i = len; (i > 0) && isdigit((int) name[i - 1]); i--)
+		;
+	/* keep the suffix small enough to fit in a long */
+	if (len - i > 9)
+		i = len - 9;
+	run->hr_plen = i;
+	run->hr_dlen = len - i;
+	run->hr_first = 0;
+	for (; i < len; i++)
+		run->hr_first = run->hr_first * 10 + (name[i] - '0');
+	run->hr_last = run->hr_first;
+}
+
+/**
+ * @brief
+ *	Try to extend a compact hostlist run with the host 'name'.
+ *
+ * @param[in,out] run - the current run
+ * @param[in]	name - host name, need not be null terminated
+ * @param[in]	len - length of 'name'
+ * @param[in]	count - number of nodefile entries for the host
+ *
+ * @return int
+ * @retval 1	'name' is the next host of the run, the run was extended
+ * @retval 0	'name' does not belong to the run
+ */
+static int
+hostlist_run_extend(struct hostlist_run *run, const char *name, size_t len, int count)
+{
+	size_t i;
+	long num = 0;
+
+	if ((run->hr_dlen == 0) || (count != run->hr_count) || (len != run->hr_nlen))
+		return (0);
+	if (strncmp(name, run->hr_name, run->hr_plen) != 0)
+		return (0);
+	for (i = run->hr_plen; i < len; i++) {
+		if (!isdigit((int) name[i]))
+			return (0);
+		num = num * 10 + (name[i] - '0');
+	}
+	if (num != run->hr_last + 1)
+		return (0);
+	run->hr_last = num;
+	return (1);
+}
+
+/**
+ * @brief
+ *	Write a compact hostlist run as "name:count" for a single host or
+ *	"prefix[first-last]:count" for a range of hosts.
+ *
+ * @param[in]	fp - file to write to
+ * @param[in]	run - the run to write
+ * @param[in]	sep - separator to put in front of the run, or NULL
+ *
+ * @return void
+ */
+static void
+hostlist_run_write(FILE *fp, struct hostlist_run *run, const char *sep)
+{
+	if (sep != NULL)
+		(void) fputs(sep, fp);
+	if (run->hr_first == run->hr_last)
+		fprintf(fp, "%.*s:%d", (int) run->hr_nlen, run->hr_name, run->hr_count);
+	else
+		fprintf(fp, "%.*s[%0*ld-%0*ld]:%d", (int) run->hr_plen, run->hr_name,
+			(int) run->hr_dlen, run->hr_first,
+			(int) run->hr_dlen, run->hr_last, run->hr_count);
+}
+
+/**
+ * @brief
+ *	Write the compact form of PBS_NODEFILE to "<nodefile>.hostlist".
+ *
+ * @par Functionality:
+ *	Reads the nodefile just written and collapses consecutive repeated
+ *	entries into "host:count" and consecutive, equally weighted hosts
+ *	with numeric suffixes into ranges, all on one comma separated line,
+ *	e.g. "node[001-400]:64,login1:1".  The order of the nodefile is kept,
+ *	so the ranks a launcher places from either file are the same.
+ *
+ * @param[in]	pjob - the job
+ * @param[in]	nodefile - path of the job's PBS_NODEFILE
+ *
+ * @return int
+ * @retval  0	success
+ * @retval -1	failure, the hostlist file is not left behind
+ */
+static int
+generate_pbs_hostlist(job *pjob, char *nodefile)
+{
+	FILE *fp;
+	int j;
+	int count = 0;
+	int have_run = 0;
+	int nwritten = 0;
+	const char *name = NULL;
+	size_t len = 0;
+	struct hostlist_run run;
+	char hostlist[MAXPATHLEN + 1];
+
+	if (snprintf(hostlist, sizeof(hostlist), "%s.hostlist", nodefile) >= (int) sizeof(hostlist)) {
+		log_err(ENAMETOOLONG, __func__, nodefile);
+		return (-1);
+	}
+	if ((fp = fopen(hostlist, "w")) == NULL) {
+		log_errf(errno, __func__, "cannot open %s", hostlist);
+		return (-1);
+	}
+	if (fchmod(fileno(fp), 0644) == -1) {
+		log_errf(errno, __func__, "cannot chmod %s", hostlist);
+		fclose(fp);
+		(void) unlink(hostlist);
+		return (-1);
+	}
+	(void) setvbuf(fp, NULL, _IOFBF, NODEFILE_BUFSZ);
+
+	for (j = 0; j <= pjob->ji_numvnod; j++) {
+		const char *next = NULL;
+		size_t nlen = 0;
+
+		if (j < pjob->ji_numvnod) {
+			if ((next = pjob->ji_vnods[j].vn_hname) == NULL) {
+				char *pdot;
+
+				next = pjob->ji_vnods[j].vn_host->hn_host;
+				if ((pdot = strchr(next, '.')) != NULL)
+					nlen = (size_t) (pdot - next);
+				else
+					nlen = strlen(next);
+			} else
+				nlen = strlen(next);
+			if ((name != NULL) && (nlen == len) && (strncmp(next, name, len) == 0)) {
+				count++;
+				continue;
+			}
+		}
+
+		/* the host changed, fold the previous one into the current run */
+		if (name != NULL) {
+			if (!have_run) {
+				hostlist_run_start(&run, name, len, count);
+				have_run = 1;
+			} else if (!hostlist_run_extend(&run, name, len, count)) {
+				hostlist_run_write(fp, &run, nwritten++ ? "," : NULL);
+				hostlist_run_start(&run, name, len, count);
+			}
+		}
+		name = next;
+		len = nlen;
+		count = 1;
+	}
+	if (have_run)
+		hostlist_run_write(fp, &run, nwritten ? "," : NULL);
+	(void) putc('\n', fp);
+
+	if (ferror(fp) || (fclose(fp) != 0)) {
+		log_errf(errno, __func__, "cannot write %s", hostlist);
+		(void) unlink(hostlist);
+		return (-1);
+	}
+	return (0);
+}
+
 /**
  * @brief
  *	Regenerate the PBS_NODEFILE of a job based on internal
@@ -1852,6 +2497,8 @@ generate_pbs_nodefile(job *pjob, char *nodefile, int nodefile_sz,
 	FILE *nhow;
 	int j, vnodenum;
 	char pbs_nodefile[MAXPATHLEN + 1];
+	const char *name = NULL;
+	size_t len = 0;
 
 	if (pjob == NULL) {
 		snprintf(err_msg, err_msg_sz, "bad pjob param");
@@ -1886,24 +2533,44 @@ generate_pbs_nodefile(job *pjob, char *nodefile, int nodefile_sz,
 		return (-1);
 	}
 
-	/* write each node name out once per vnod and entry */
+	/*
+	 * Write each node name out once per vnod and entry.  Consecutive
+	 * entries usually name the same host, so the short name length is
+	 * only worked out when the host changes and the whole file goes out
+	 * through one large stdio buffer.
+	 */
+	(void) setvbuf(nhow, NULL, _IOFBF, NODEFILE_BUFSZ);
 	vnodenum = pjob->ji_numvnod;
 	for (j = 0; j < vnodenum; j++) {
 		if (pjob->ji_vnods[j].vn_hname == NULL) {
-			size_t len;
-			char *pdot;
+			if (pjob->ji_vnods[j].vn_host->hn_host != name) {
+				char *pdot;
 
-			/* we want to write just the short name of the host */
-			if ((pdot = strchr(pjob->ji_vnods[j].vn_host->hn_host, '.')) != NULL)
-				len = (size_t) (pdot - pjob->ji_vnods[j].vn_host->hn_host);
-			else
-				len = strlen(pjob->ji_vnods[j].vn_host->hn_host);
-			fprintf(nhow, "%.*s\n", (int) len,
-				pjob->ji_vnods[j].vn_host->hn_host);
-		} else
-			fprintf(nhow, "%s\n", pjob->ji_vnods[j].vn_hname);
+				/* we want to write just the short name of the host */
+				name = pjob->ji_vnods[j].vn_host->hn_host;
+				if ((pdot = strchr(name, '.')) != NULL)
+					len = (size_t) (pdot - name);
+				else
+					len = strlen(name);
+			}
+		} else if (pjob->ji_vnods[j].vn_hname != name) {
+			name = pjob->ji_vnods[j].vn_hname;
+			len = strlen(name);
+		}
+		(void) fwrite(name, 1, len, nhow);
+		(void) putc('\n', nhow);
 	}
-	fclose(nhow);
+	if (ferror(nhow) || (fclose(nhow) != 0)) {
+		if ((err_msg != NULL) && (err_msg_sz > 0)) {
+			snprintf(err_msg, err_msg_sz, "cannot write %s",
+				 pbs_nodefile);
+		}
+		(void) unlink(pbs_nodefile);
+		return (-1);
+	}
+
+	if (nodefile_hostlist)
+		(void) generate_pbs_hostlist(pjob, pbs_nodefile);
 
 	if ((nodefile != NULL) && (nodefile_sz > 0))
 		pbs_strncpy(nodefile, pbs_nodefile, nodefile_sz);
@@ -2834,6 +3501,7 @@ finish_exec(job *pjob)
 	vnl_t *vnl_good = NULL;
 
 	ptc = -1; /* No current master pty */
+	startup_step(pjob, STARTUP_JOINED);
 
 	memset(&sjr, 0, sizeof(sjr));
 	if (is_jattr_set(pjob, JOB_ATR_nodemux))
@@ -3543,9 +4211,14 @@ finish_exec(job *pjob)
 
 	/* PBS_NODEFILE */
 
-	if (generate_pbs_nodefile(pjob, buf, sizeof(buf) - 1, log_buffer, LOG_BUF_SIZE - 1) == 0)
+	if (generate_pbs_nodefile(pjob, buf, sizeof(buf) - 1, log_buffer, LOG_BUF_SIZE - 1) == 0) {
 		bld_env_variables(&(pjob->ji_env), variables_else[11], buf);
-	else {
+		if (nodefile_hostlist) {
+			/* PBS_NODEFILE_HOSTLIST */
+			strncat(buf, ".hostlist", sizeof(buf) - strlen(buf) - 1);
+			bld_env_variables(&(pjob->ji_env), variables_else[16], buf);
+		}
+	} else {
 		log_err(errno, __func__, log_buffer);
 		starter_return(upfds, downfds, JOB_EXEC_FAIL1, &sjr);
 	}
@@ -6002,6 +6675,9 @@ start_exec(job *pjob)
 		exec_bail(pjob, JOB_EXEC_RETRY, NULL);
 		return;
 	}
+	startup_step(pjob, STARTUP_BEGIN);
+	pjob->ji_startup[STARTUP_JOINED] = 0;
+	pjob->ji_evscan = 0;
 
 	/*
 	 * Ensure we have a cookie for the job. The cookie consists of a
@@ -57,6 +57,25 @@
 #include "check.h"
 #include <log.h>
 #include "pbs_internal.h"
+#include "cycle_stats.h"
+
+#include <string>
+#include <unordered_map>
+
+/* the resources and name of a bucket for one node configuration */
+struct bucket_tmpl {
+	schd_resource *res_spec; /* resources that describe the bucket, nothing assigned */
+	char *sig;		 /* resource signature of res_spec */
+};
+
+#define BUCKET_TMPL_CACHE_MAX 20000 /* node configurations remembered */
+
+/* bucket templates of the node configurations seen in this and earlier
+ * cycles, by node signature (node_info::nodesig).  The templates depend on
+ * the resources checked, so they are made from bucket_tmpl_defs only.
+ */
+static std::unordered_map<std::string, bucket_tmpl> bucket_tmpl_cache;
+static std::unordered_set<resdef *> bucket_tmpl_defs;
 
 /* bucket_bitpool constructor */
 bucket_bitpool *
@@ -202,6 +221,7 @@ dup_node_bucket(node_bucket *onb, server_info *nsinfo)
 
 	pbs_bitmap_assign(nnb->bkt_nodes, onb->bkt_nodes);
 	nnb->res_spec = dup_resource_list(onb->res_spec);
+	index_resource_list(nnb->res_spec);
 	if (nnb->res_spec == NULL) {
 		free_node_bucket(nnb);
 		return NULL;
@@ -345,25 +365,21 @@ find_node_bucket_ind(node_bucket **buckets, schd_resource *rl, queue_info *qinfo
 }
 
 /**
- * @brief create a name for a node bucket based on resource names, priority, and queue
+ * @brief add the priority and queue of a node bucket to its resource signature
+ *	  to make the bucket's name
+ *
+ * @param[in] name - resource signature of the bucket, taken over (freed on error)
+ * @param[in] nb - the node bucket
  *
  * @return char *
  * @retval name of bucket
  * @retval NULL - error
  */
-char *
-create_node_bucket_name(status *policy, node_bucket *nb)
+static char *
+add_node_bucket_name_suffix(char *name, node_bucket *nb)
 {
-	char *name;
 	int len;
 
-	if (policy == NULL || nb == NULL)
-		return NULL;
-
-	name = create_resource_signature(nb->res_spec, policy->resdef_to_check_no_hostvnode, ADD_ALL_BOOL);
-	if (name == NULL)
-		return NULL;
-
 	len = strlen(name);
 
 	if (nb->priority != 0) {
@@ -393,8 +409,104 @@ create_node_bucket_name(status *policy, node_bucket *nb)
 	return name;
 }
 
+/**
+ * @brief create a name for a node bucket based on resource names, priority, and queue
+ *
+ * @return char *
+ * @retval name of bucket
+ * @retval NULL - error
+ */
+char *
+create_node_bucket_name(status *policy, node_bucket *nb)
+{
+	char *name;
+
+	if (policy == NULL || nb == NULL)
+		return NULL;
+
+	name = create_resource_signature(nb->res_spec, policy->resdef_to_check_no_hostvnode, ADD_ALL_BOOL);
+	if (name == NULL)
+		return NULL;
+
+	return add_node_bucket_name_suffix(name, nb);
+}
+
+/* free the bucket templates of all node configurations */
+static void
+free_bucket_tmpls()
+{
+	for (auto &bt : bucket_tmpl_cache) {
+		free_resource_list(bt.second.res_spec);
+		free(bt.second.sig);
+	}
+	bucket_tmpl_cache.clear();
+}
+
+/**
+ * @brief forget the bucket templates of all node configurations.  Called when
+ *	  the resource definitions change since the templates point at them.
+ *
+ * @return void
+ */
+void
+clear_node_bucket_cache()
+{
+	free_bucket_tmpls();
+	bucket_tmpl_defs.clear();
+}
+
+/**
+ * @brief find the bucket template of a node's configuration, making it if
+ *	  the configuration has not been seen before
+ *
+ * @param[in] policy - policy info
+ * @param[in] sig - the node's signature
+ * @param[in] ninfo - the node
+ *
+ * @return bucket_tmpl *
+ * @retval the template
+ * @retval NULL on error
+ */
+static bucket_tmpl *
+find_alloc_bucket_tmpl(status *policy, const char *sig, node_info *ninfo)
+{
+	bucket_tmpl bt;
+	schd_resource *cur_res;
+
+	auto it = bucket_tmpl_cache.find(sig);
+	if (it != bucket_tmpl_cache.end())
+		return &it->second;
+
+	if (bucket_tmpl_cache.size() >= BUCKET_TMPL_CACHE_MAX)
+		free_bucket_tmpls();
+
+	bt.res_spec = dup_selective_resource_list(ninfo->res, policy->resdef_to_check_no_hostvnode,
+						  (ADD_UNSET_BOOLS_FALSE | ADD_ALL_BOOL));
+	if (bt.res_spec == NULL)
+		return NULL;
+
+	for (cur_res = bt.res_spec; cur_res != NULL; cur_res = cur_res->next)
+		if (cur_res->type.is_consumable)
+			cur_res->assigned = 0;
+
+	bt.sig = create_resource_signature(bt.res_spec, policy->resdef_to_check_no_hostvnode, ADD_ALL_BOOL);
+	if (bt.sig == NULL) {
+		free_resource_list(bt.res_spec);
+		return NULL;
+	}
+
+	return &bucket_tmpl_cache.emplace(sig, bt).first->second;
+}
+
 /**
  * @brief create node buckets from an array of nodes
+ *
+ * @par Nodes are grouped by their signature (node_info::nodesig), queue and
+ *	priority with a hash lookup.  The resources and name of a bucket come
+ *	from the template of its node configuration, which is kept across cycles
+ *	so a configuration seen before does not have its resources picked out
+ *	and signed again for every bucket array it is in.
+ *
  * @param[in] policy - policy info
  * @param[in] nodes - the nodes to create buckets from
  * @param[in] queues - the queues the nodes may be associated with.  May be NULL
@@ -408,15 +520,23 @@ create_node_bucket_name(status *policy, node_bucket *nb)
 node_bucket **
 create_node_buckets(status *policy, node_info **nodes, std::vector<queue_info *> &queues, unsigned int flags)
 {
+	phase_timer timer(PHASE_BUCKETS);
 	int i;
 	int j = 0;
 	node_bucket **buckets = NULL;
 	node_bucket **tmp;
 	int node_ct;
+	std::unordered_map<std::string, std::vector<int>> sig_bkts; /* node signature to its buckets */
 
 	if (policy == NULL || nodes == NULL || queues.empty())
 		return NULL;
 
+	/* the templates are only good for the resources they were made from */
+	if (bucket_tmpl_defs != policy->resdef_to_check_no_hostvnode) {
+		free_bucket_tmpls();
+		bucket_tmpl_defs = policy->resdef_to_check_no_hostvnode;
+	}
+
 	node_ct = count_array(nodes);
 
 	buckets = static_cast<node_bucket **>(calloc((node_ct + 1), sizeof(node_bucket *)));
@@ -427,9 +547,10 @@ create_node_buckets(status *policy, node_info **nodes, std::vector<queue_info *>
 
 	for (i = 0; i < node_ct; i++) {
 		node_bucket *nb = NULL;
-		int bkt_ind;
+		int bkt_ind = -1;
 		queue_info *qinfo = NULL;
 		int node_ind = nodes[i]->node_ind;
+		char *sig;
 
 		if (nodes[i]->is_down || nodes[i]->is_offline || node_ind == -1 || nodes[i]->lic_lock == 0)
 			continue;
@@ -437,7 +558,24 @@ create_node_buckets(status *policy, node_info **nodes, std::vector<queue_info *>
 		if (!nodes[i]->queue_name.empty())
 			qinfo = find_queue_info(queues, nodes[i]->queue_name);
 
-		bkt_ind = find_node_bucket_ind(buckets, nodes[i]->res, qinfo, nodes[i]->priority);
+		if (nodes[i]->nodesig == NULL) {
+			nodes[i]->nodesig = create_resource_signature(nodes[i]->res, policy->resdef_to_check_no_hostvnode, ADD_ALL_BOOL);
+			if (nodes[i]->nodesig == NULL) {
+				free_node_bucket_array(buckets);
+				return NULL;
+			}
+		}
+		sig = nodes[i]->nodesig;
+
+		auto sb = sig_bkts.find(sig);
+		if (sb != sig_bkts.end()) {
+			for (auto k : sb->second) {
+				if (buckets[k]->queue == qinfo && buckets[k]->priority == nodes[i]->priority) {
+					bkt_ind = k;
+					break;
+				}
+			}
+		}
 		if (flags & UPDATE_BUCKET_IND) {
 			if (bkt_ind == -1)
 				nodes[i]->bucket_ind = j;
@@ -448,7 +586,14 @@ create_node_buckets(status *policy, node_info **nodes, std::vector<queue_info *>
 			nb = buckets[bkt_ind];
 
 		if (nb == NULL) { /* no bucket found, need to add one*/
-			schd_resource *cur_res;
+			bucket_tmpl *bt;
+
+			bt = find_alloc_bucket_tmpl(policy, sig, nodes[i]);
+			if (bt == NULL) {
+				free_node_bucket_array(buckets);
+				return NULL;
+			}
+
 			buckets[j] = new_node_bucket(1);
 
 			if (buckets[j] == NULL) {
@@ -456,34 +601,33 @@ create_node_buckets(status *policy, node_info **nodes, std::vector<queue_info *>
 				return NULL;
 			}
 
-			buckets[j]->res_spec = dup_selective_resource_list(nodes[i]->res, policy->resdef_to_check_no_hostvnode,
-									   (ADD_UNSET_BOOLS_FALSE | ADD_ALL_BOOL));
+			buckets[j]->res_spec = dup_resource_list(bt->res_spec);
 
 			if (buckets[j]->res_spec == NULL) {
 				free_node_bucket_array(buckets);
 				return NULL;
 			}
+			index_resource_list(buckets[j]->res_spec);
 
 			if (qinfo != NULL)
 				buckets[j]->queue = qinfo;
 
 			buckets[j]->priority = nodes[i]->priority;
 
-			for (cur_res = buckets[j]->res_spec; cur_res != NULL; cur_res = cur_res->next)
-				if (cur_res->type.is_consumable)
-					cur_res->assigned = 0;
-
 			buckets[j]->busy_later_pool->truth_ct = 0;
 			buckets[j]->free_pool->truth_ct = 0;
 			buckets[j]->busy_pool->truth_ct = 0;
 
 			buckets[j]->total = 0;
 
-			buckets[j]->name = create_node_bucket_name(policy, buckets[j]);
+			buckets[j]->name = string_dup(bt->sig);
+			if (buckets[j]->name != NULL)
+				buckets[j]->name = add_node_bucket_name_suffix(buckets[j]->name, buckets[j]);
 			if (buckets[j]->name == NULL) {
 				free_node_bucket_array(buckets);
 				return NULL;
 			}
+			sig_bkts[sig].push_back(j);
 			if (!(flags & NO_PRINT_BUCKETS))
 				log_eventf(PBSEVENT_DEBUG3, PBS_EVENTCLASS_NODE, LOG_DEBUG, __func__, "Created node bucket %s", buckets[j]->name);
 
@@ -642,6 +786,7 @@ bucket_match(chunk_map **cmap, resource_resv *resresv, schd_error *err)
 	int j;
 	int k;
 	static pbs_bitmap *zeromap = NULL;
+	static thread_local pbs_bitmap *taken = NULL; /* free nodes taken from a bucket */
 	server_info *sinfo;
 
 	if (cmap == NULL || resresv == NULL || resresv->select == NULL)
@@ -652,6 +797,11 @@ bucket_match(chunk_map **cmap, resource_resv *resresv, schd_error *err)
 		if (zeromap == NULL)
 			return 0;
 	}
+	if (taken == NULL) {
+		taken = pbs_bitmap_alloc(NULL, 1);
+		if (taken == NULL)
+			return 0;
+	}
 
 	sinfo = resresv->server;
 
@@ -695,23 +845,44 @@ bucket_match(chunk_map **cmap, resource_resv *resresv, schd_error *err)
 				}
 			}
 
-			for (k = pbs_bitmap_first_on_bit(bkt->free_pool->working);
-			     num_chunks_needed > chunks_added && k >= 0;
-			     k = pbs_bitmap_next_on_bit(bkt->free_pool->working, k)) {
-				clear_schd_error(err);
-				if (resresv->aoename != NULL) {
+			/* Free nodes don't need to be checked one by one unless we're
+			 * provisioning.  Take as many as we need off the front of the pool.
+			 */
+			if (resresv->aoename == NULL) {
+				if (num_chunks_needed > chunks_added) {
+					int chunk_count = cmap[i]->bkt_cnts[j]->chunk_count;
+					long num_nodes = (num_chunks_needed - chunks_added + chunk_count - 1) / chunk_count;
+
+					num_nodes = pbs_bitmap_first_n_on_bits(bkt->free_pool->working, num_nodes, taken);
+					if (num_nodes < 0)
+						return 0;
+					if (num_nodes > 0) {
+						clear_schd_error(err);
+						pbs_bitmap_andnot(bkt->free_pool->working, taken);
+						bkt->free_pool->working_ct -= num_nodes;
+						pbs_bitmap_or(bkt->busy_pool->working, taken);
+						bkt->busy_pool->working_ct += num_nodes;
+						pbs_bitmap_or(cmap[i]->node_bits, taken);
+						chunks_added += num_nodes * chunk_count;
+					}
+				}
+			} else {
+				for (k = pbs_bitmap_first_on_bit(bkt->free_pool->working);
+				     num_chunks_needed > chunks_added && k >= 0;
+				     k = pbs_bitmap_next_on_bit(bkt->free_pool->working, k)) {
+					clear_schd_error(err);
 					if (sinfo->unordered_nodes[k]->current_aoe == NULL ||
 					    strcmp(sinfo->unordered_nodes[k]->current_aoe, resresv->aoename) != 0)
 						if (is_provisionable(sinfo->unordered_nodes[k], resresv, err) == NOT_PROVISIONABLE) {
 							continue;
 						}
+					pbs_bitmap_bit_off(bkt->free_pool->working, k);
+					bkt->free_pool->working_ct--;
+					pbs_bitmap_bit_on(bkt->busy_pool->working, k);
+					bkt->busy_pool->working_ct++;
+					pbs_bitmap_bit_on(cmap[i]->node_bits, k);
+					chunks_added += cmap[i]->bkt_cnts[j]->chunk_count;
 				}
-				pbs_bitmap_bit_off(bkt->free_pool->working, k);
-				bkt->free_pool->working_ct--;
-				pbs_bitmap_bit_on(bkt->busy_pool->working, k);
-				bkt->busy_pool->working_ct++;
-				pbs_bitmap_bit_on(cmap[i]->node_bits, k);
-				chunks_added += cmap[i]->bkt_cnts[j]->chunk_count;
 			}
 
 			if (chunks_added > 0)
@@ -902,11 +1073,17 @@ job_should_use_buckets(resource_resv *resresv)
 			return 0;
 	}
 
-	/* Only excl jobs use buckets */
-	if (resresv->place_spec->share)
-		return 0;
-	if (!resresv->place_spec->excl)
-		return 0;
+	/* Buckets only hand out whole free nodes, so only jobs which are
+	 * exclusive on the nodes use them.  A job is exclusive if it asks to be
+	 * or if the sharing of every node makes it so.
+	 */
+	if (!resresv->place_spec->excl) {
+		if (resresv->place_spec->share) {
+			if (!resresv->server->nodes_force_excl)
+				return 0;
+		} else if (!resresv->server->nodes_dflt_excl)
+			return 0;
+	}
 
 	/* place=pack jobs do not use buckets */
 	if (resresv->place_spec->pack)
@@ -63,6 +63,9 @@ node_bucket **create_node_buckets(status *policy, node_info **nodes, std::vector
 /* Create a name for the node bucket based on resources, queue, and priority */
 char *create_node_bucket_name(status *policy, node_bucket *nb);
 
+/* forget the bucket templates kept across cycles */
+void clear_node_bucket_cache();
+
 /* match job's request to buckets and allocate */
 int bucket_match(chunk_map **cmap, resource_resv *resresv, schd_error *err);
 /* convert chunk_map->node_bits into nspec array */
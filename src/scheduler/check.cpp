@@ -87,6 +87,7 @@
 #include "dedtime.h"
 #include "node_info.h"
 #include "fifo.h"
+#include "job_trace.h"
 #include "resource_resv.h"
 #ifdef NAS
 #include "site_code.h"
@@ -818,7 +819,29 @@ is_ok_to_run(status *policy, server_info *sinfo,
 			if (resresv->job == NULL || resresv->job->priority != NAS_HWY101)
 #endif /* localmod 032 */
 				if (resresv->is_job) {
-					if ((rc = static_cast<sched_error_code>(check_limits(sinfo, qinfo, resresv, err, flags | CHECK_LIMIT)))) {
+					resresv_set *ec = NULL;
+					schd_error *verdict = NULL;
+
+					/* the limits verdict of the job's class may be cached from an earlier check */
+					if (sinfo->equiv_classes != NULL && resresv->ec_index != UNSPECIFIED &&
+					    !(flags & (IGNORE_EQUIV_CLASS | RETURN_ALL_ERR))) {
+						ec = sinfo->equiv_classes[resresv->ec_index];
+						verdict = find_ec_verdict(sinfo, ec);
+					}
+					{
+						trace_span span("check_limits", verdict != NULL ? "class verdict" : NULL);
+
+						if (verdict != NULL) {
+							copy_schd_error(err, verdict);
+							rc = err->error_code;
+						} else {
+							rc = static_cast<sched_error_code>(check_limits(sinfo, qinfo, resresv, err, flags | CHECK_LIMIT));
+							if (rc != SE_NONE && rc != SCHD_ERROR && ec != NULL)
+								add_ec_verdict(sinfo, ec, err);
+						}
+						span.set_result(rc);
+					}
+					if (rc != SE_NONE) {
 
 						add_err(&prev_err, err);
 						if (rc == SCHD_ERROR)
@@ -1527,6 +1550,7 @@ std::vector<nspec *>
 check_nodes(status *policy, server_info *sinfo, queue_info *qinfo, resource_resv *resresv, unsigned int flags, schd_error *err)
 {
 	std::vector<nspec *> ns_arr;
+	trace_span span("check_nodes", (flags & USE_BUCKETS) ? "buckets" : "normal");
 
 	if (sinfo->pset_metadata_stale)
 		update_all_nodepart(policy, sinfo, (flags & NO_ALLPART));
@@ -1536,6 +1560,7 @@ check_nodes(status *policy, server_info *sinfo, queue_info *qinfo, resource_resv
 	else
 		ns_arr = check_normal_node_path(policy, sinfo, qinfo, resresv, flags, err);
 
+	span.set_result(err->error_code);
 	return ns_arr;
 }
 
@@ -1842,12 +1867,12 @@ check_prime_boundary(status *policy, resource_resv *resresv, struct schd_error *
  *
  * @return	schd_resource * (set to False)
  *
- * @par MT-safe: No
+ * @par MT-safe: Yes
  */
 schd_resource *
 false_res()
 {
-	static schd_resource *res = NULL;
+	static thread_local schd_resource *res = NULL;
 
 	if (res == NULL) {
 		res = new_resource();
@@ -1874,12 +1899,12 @@ false_res()
  * @return	schd_resource *
  * @retval	NULL	: fail
  *
- * @par MT-safe: No
+ * @par MT-safe: Yes
  */
 schd_resource *
 unset_str_res()
 {
-	static schd_resource *res = NULL;
+	static thread_local schd_resource *res = NULL;
 
 	if (res == NULL) {
 		res = new_resource();
@@ -1916,7 +1941,7 @@ unset_str_res()
 schd_resource *
 zero_res()
 {
-	static schd_resource *res = NULL;
+	static thread_local schd_resource *res = NULL;
 
 	if (res == NULL) {
 		res = new_resource();
@@ -1942,13 +1967,13 @@ zero_res()
  * @param[out] **spec output select specification
  * @param[out] **pl  output placement specification
  *
- * @par MT-Safe: No
+ * @par MT-Safe: Yes
  * @return void
  */
 void
 get_resresv_spec(resource_resv *resresv, selspec **spec, place **pl)
 {
-	static place place_spec;
+	static thread_local place place_spec;
 	if (resresv->is_job && resresv->job != NULL) {
 		if (resresv->execselect != NULL) {
 			*spec = resresv->execselect;
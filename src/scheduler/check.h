@@ -115,6 +115,17 @@ long long
 check_avail_resources(schd_resource *reslist, resource_req *reqlist,
 		      unsigned int flags, enum sched_error_code fail_code, schd_error *perr);
 
+/*
+ *	find_check_resource - find the resource to match a resource_req against
+ *			      (honoring indirect resources and UNSET_RES_ZERO)
+ */
+schd_resource *find_check_resource(schd_resource *reslist, resource_req *resreq, unsigned int flags);
+
+/*
+ *	match_resource - do resource matching between a resource_req and a schd_resource
+ */
+int match_resource(schd_resource *res, resource_req *resreq, unsigned int flags, enum sched_error_code fail_code, schd_error *err);
+
 /*
  *	dynamic_avail - find out how much of a resource is available on a
  */
@@ -57,10 +57,24 @@
 #define HOLIDAYS_FILE "holidays"
 #define RESGROUP_FILE "resource_group"
 #define DEDTIME_FILE "dedicated_time"
+#define CYCLE_STATS_FILE "cycle_stats"
+#define JOB_TRACE_FILE "job_trace.json"
+#define CYCLE_CAPTURE_FILE "cycle_capture"
+#define CYCLE_CAPTURE_TOUCH CYCLE_CAPTURE_FILE ".touch"
+#define QJOB_CACHE_FILE "queued_job_cache"
+#define QJOB_CACHE_MAGIC "PBS_SCHED_QJOB_CACHE"
+#define QJOB_CACHE_VERSION 1
+#define QJOB_CACHE_PERIOD 300
+
+/* size at which CYCLE_STATS_FILE is moved aside to CYCLE_STATS_FILE.old */
+#define CYCLE_STATS_MAX_SIZE (64 * 1024 * 1024)
+
+/* size at which JOB_TRACE_FILE is moved aside to JOB_TRACE_FILE.old */
+#define JOB_TRACE_MAX_SIZE (64 * 1024 * 1024)
 
 /* usage file "magic number" - needs to be 8 chars */
 #define USAGE_MAGIC "PBS_MAG!"
-#define USAGE_VERSION 2
+#define USAGE_VERSION 3
 #define USAGE_NAME_MAX 50
 
 #define UNKNOWN_GROUP_NAME "unknown"
@@ -133,6 +147,7 @@
 #define PARSE_NODE_SORT_KEY "node_sort_key"
 #define PARSE_SORT_NODES "sort_nodes"
 #define PARSE_SERVER_DYN_RES "server_dyn_res"
+#define PARSE_SERVER_DYN_RES_CACHE_TTL "server_dyn_res_cache_ttl"
 #define PARSE_PEER_QUEUE "peer_queue"
 #define PARSE_PEER_TRANSLATION "peer_translation"
 #define PARSE_NODE_GROUP_KEY "node_group_key"
@@ -140,6 +155,14 @@
 #define PARSE_STRICT_ORDERING "strict_ordering"
 #define PARSE_RES_UNSET_INFINITE "resource_unset_infinite"
 #define PARSE_SELECT_PROVISION "provision_policy"
+#define PARSE_INCR_JOB_QUERY "incremental_job_query"
+#define PARSE_PARALLEL_PSET_EVAL "parallel_placement_set_eval"
+#define PARSE_CYCLE_STATS "cycle_stats"
+#define PARSE_JOB_TRACE_SAMPLE "job_trace_sample"
+#define PARSE_JOB_TRACE_JOBS "job_trace_jobs"
+#define PARSE_FAST_PATH_JOBS "fast_path_jobs"
+#define PARSE_FAST_PATH_FULL_INTERVAL "fast_path_full_interval"
+#define PARSE_PEER_QUEUE_MAX_JOBS "peer_queue_max_jobs"
 
 #ifdef NAS
 /* localmod 034 */
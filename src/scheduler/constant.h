@@ -169,7 +169,10 @@ enum thread_task_type {
 	TS_FREE_ND_INFO,
 	TS_DUP_RESRESV,
 	TS_QUERY_JOB_INFO,
-	TS_FREE_RESRESV
+	TS_FREE_RESRESV,
+	TS_EVAL_NODEPART,
+	TS_DUP_RESV_OCCR,
+	TS_FREE_SERVER
 };
 
 /* return codes for is_ok_to_run_* functions
@@ -588,6 +591,12 @@ enum runjob_mode {
 	RJ_EXECJOB_HOOK
 };
 
+/* most async run requests sent to the server in one run job list */
+#define RUNJOB_BATCH_SIZE 64
+
+/* most jobs whose attribute updates are sent in one modify job list */
+#define ATTR_UPDATE_BATCH_SIZE 1024
+
 enum preempt_sort_vals {
 	PS_MIN_T_SINCE_START,
 	PS_PREEMPT_PRIORITY,
@@ -0,0 +1,432 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file    cycle_stats.cpp
+ *
+ * @brief
+ * 		cycle_stats.cpp - This file contains functions to time the phases
+ *		of a scheduling cycle and to count the jobs the cycle looked at.
+ *
+ *		When the cycle_stats sched_config option is set, each cycle is
+ *		written as one line of JSON to CYCLE_STATS_FILE in sched_priv and
+ *		to the scheduler's sched_cycle_stats attribute.  Phases can nest
+ *		(e.g. query_nodes is part of query_server), so times are inclusive.
+ *
+ *		Memory is reported too: the RSS at the start and end of the cycle,
+ *		the peak RSS during the cycle, and the heap in use at the start
+ *		and end of the cycle.  Each phase gets the net heap growth over its
+ *		timers, taken from mallinfo2() when a timer starts and stops.  The
+ *		heap is that of the whole process, so it includes allocations of
+ *		worker threads made while a phase runs.  The heap values are -1
+ *		where mallinfo2() is not available.
+ *
+ * Functions included are:
+ * 	phase_timer::start()
+ * 	phase_timer::stop()
+ * 	cycle_stats_begin()
+ * 	cycle_stats_job_considered()
+ * 	cycle_stats_job_run()
+ * 	cycle_stats_job_skipped()
+ * 	cycle_stats_end()
+ * 	cycle_stats_last()
+ *
+ */
+
+#include <pbs_config.h>
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#ifdef HAVE_MALLINFO2
+#include <malloc.h>
+#endif
+
+#include <atomic>
+#include <map>
+#include <string>
+
+#include <pbs_ifl.h>
+#include <log.h>
+
+#include "config.h"
+#include "constant.h"
+#include "cycle_stats.h"
+#include "data_types.h"
+#include "globals.h"
+
+/* names of the phases in the JSON output, indexed by enum cycle_phase */
+static const char *phase_names[PHASE_HIGH] = {
+	"query_server",
+	"query_nodes",
+	"query_jobs",
+	"buckets",
+	"placement_sets",
+	"sort",
+	"is_ok_to_run",
+	"calendar",
+	"preemption",
+	"run_job",
+	"attr_updates",
+	"dup_server"};
+
+struct phase_stat {
+	double wall;	  /* wall clock seconds */
+	double cpu;	  /* cpu seconds of the whole process (all threads) */
+	long calls;	  /* times the phase was entered */
+	long heap_growth; /* net bytes of heap the process took */
+	int depth;	  /* timers of this phase currently in scope */
+};
+
+std::atomic<bool> cycle_stats_on(false);
+
+static struct {
+	struct timespec wall_start;
+	struct timespec cpu_start;
+	time_t start_time;
+	long rss_start;		/* kB */
+	long heap_start;	/* bytes */
+	phase_stat phases[PHASE_HIGH];
+	long considered;
+	long run;
+	long skipped;
+	std::map<int, long> skipped_by_reason;
+} cstats;
+
+/* the JSON of the last cycle */
+static std::string last_json;
+
+/* the thread the cycle runs on.  Only it is timed, the stats are not locked */
+static pthread_t stats_thread;
+
+/**
+ * @brief	seconds between two timespecs
+ */
+static double
+ts_diff(const struct timespec &start, const struct timespec &end)
+{
+	return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+/**
+ * @brief	bytes of heap the process has in use, both in the arenas
+ *		and in chunks mmap()ed on their own
+ *
+ * @return	long
+ * @retval	bytes in use
+ * @retval	-1 if mallinfo2() is not available
+ */
+static long
+heap_in_use()
+{
+#ifdef HAVE_MALLINFO2
+	struct mallinfo2 mi = mallinfo2();
+
+	return static_cast<long>(mi.uordblks + mi.hblkhd);
+#else
+	return -1;
+#endif
+}
+
+/**
+ * @brief	read the current and peak resident set size of the scheduler
+ *
+ * @param[out]	rss	-	current RSS in kB
+ * @param[out]	hwm	-	peak RSS in kB (since the last reset_peak_rss())
+ *
+ * @return	void
+ */
+static void
+read_rss(long *rss, long *hwm)
+{
+	char line[256];
+	FILE *fp;
+
+	*rss = -1;
+	*hwm = -1;
+	if ((fp = fopen("/proc/self/status", "r")) == NULL)
+		return;
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if (strncmp(line, "VmRSS:", 6) == 0)
+			*rss = strtol(line + 6, NULL, 10);
+		else if (strncmp(line, "VmHWM:", 6) == 0)
+			*hwm = strtol(line + 6, NULL, 10);
+	}
+	fclose(fp);
+}
+
+/**
+ * @brief	reset the peak RSS of the process to its current RSS so the
+ *		peak read at the end of the cycle is the peak of the cycle
+ *
+ * @return	bool
+ * @retval	true	- reset
+ * @retval	false	- not supported, the peak is that of the process' life
+ */
+static bool
+reset_peak_rss()
+{
+	FILE *fp;
+	bool ret;
+
+	if ((fp = fopen("/proc/self/clear_refs", "w")) == NULL)
+		return false;
+	ret = fputs("5", fp) >= 0;
+	if (fclose(fp) != 0)
+		ret = false;
+	return ret;
+}
+
+/**
+ * @brief	start timing a phase unless a timer of the same phase already is
+ *		or we are on a worker thread
+ */
+void
+phase_timer::start()
+{
+	if (!pthread_equal(pthread_self(), stats_thread))
+		return;
+	entered = true;
+	outer = cstats.phases[phase].depth++ == 0;
+	if (!outer)
+		return;
+	clock_gettime(CLOCK_MONOTONIC, &wall_start);
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_start);
+	heap_start = heap_in_use();
+}
+
+/**
+ * @brief	add the time since start() to the phase
+ */
+void
+phase_timer::stop()
+{
+	struct timespec wall_end;
+	struct timespec cpu_end;
+	auto &ps = cstats.phases[phase];
+
+	ps.depth--;
+	if (!outer)
+		return;
+	clock_gettime(CLOCK_MONOTONIC, &wall_end);
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_end);
+	ps.wall += ts_diff(wall_start, wall_end);
+	ps.cpu += ts_diff(cpu_start, cpu_end);
+	if (heap_start >= 0)
+		ps.heap_growth += heap_in_use() - heap_start;
+	else
+		ps.heap_growth = -1;
+	ps.calls++;
+}
+
+/**
+ * @brief	reset the stats and start collecting them for a new cycle if
+ *		the cycle_stats option is set
+ *
+ * @return	void
+ */
+void
+cycle_stats_begin()
+{
+	long hwm;
+
+	if (!conf.cycle_stats)
+		return;
+
+	for (auto &ps : cstats.phases)
+		ps = phase_stat();
+	cstats.considered = 0;
+	cstats.run = 0;
+	cstats.skipped = 0;
+	cstats.skipped_by_reason.clear();
+	cstats.start_time = time(NULL);
+	stats_thread = pthread_self();
+	if (!reset_peak_rss())
+		log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__,
+			  "Can not reset the peak RSS, peak_rss is that of the whole process");
+	read_rss(&cstats.rss_start, &hwm);
+	cstats.heap_start = heap_in_use();
+	clock_gettime(CLOCK_MONOTONIC, &cstats.wall_start);
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cstats.cpu_start);
+	cycle_stats_on = true;
+}
+
+/**
+ * @brief	count a job considered by the main loop
+ */
+void
+cycle_stats_job_considered()
+{
+	if (cycle_stats_on)
+		cstats.considered++;
+}
+
+/**
+ * @brief	count a job run by the main loop
+ */
+void
+cycle_stats_job_run()
+{
+	if (cycle_stats_on)
+		cstats.run++;
+}
+
+/**
+ * @brief	count a job which could not run
+ *
+ * @param[in]	code	-	the reason the job could not run
+ */
+void
+cycle_stats_job_skipped(enum sched_error_code code)
+{
+	if (cycle_stats_on) {
+		cstats.skipped++;
+		cstats.skipped_by_reason[code]++;
+	}
+}
+
+/**
+ * @brief	append a printf style string to a std::string
+ */
+static void
+json_appendf(std::string &str, const char *fmt, ...)
+{
+	char buf[256];
+	va_list ap;
+
+	va_start(ap, fmt);
+	vsnprintf(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+	str += buf;
+}
+
+/**
+ * @brief	write the stats of the cycle out and stop collecting
+ *
+ * @par	The JSON object has the cycle's start time, its total wall and cpu
+ *	seconds, the wall/cpu seconds and number of calls of each phase, and
+ *	the number of jobs considered, run and skipped.  Skipped jobs are
+ *	also counted by sched_error_code (see constant.h).  The memory object
+ *	has the RSS at the start and end and the peak RSS of the cycle in kB,
+ *	and the heap in use at the start and end of the cycle in bytes.  Each
+ *	phase has the net heap growth over its timers in bytes.  RSS values are
+ *	-1 where /proc is not available, heap values where mallinfo2() is not.
+ *
+ * @param[in]	pbs_sd	-	connection to the server to set the attribute on
+ *				(SIMULATE_SD to only write the file)
+ *
+ * @return	void
+ */
+void
+cycle_stats_end(int pbs_sd)
+{
+	struct timespec wall_end;
+	struct timespec cpu_end;
+	std::string &json = last_json;
+	struct stat sb;
+	FILE *fp;
+	bool first = true;
+	long rss_end;
+	long rss_peak;
+
+	if (!cycle_stats_on)
+		return;
+	cycle_stats_on = false;
+
+	clock_gettime(CLOCK_MONOTONIC, &wall_end);
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_end);
+	read_rss(&rss_end, &rss_peak);
+
+	json.clear();
+	json_appendf(json, "{\"start\":%ld,\"wall\":%.6f,\"cpu\":%.6f,",
+		     static_cast<long>(cstats.start_time),
+		     ts_diff(cstats.wall_start, wall_end), ts_diff(cstats.cpu_start, cpu_end));
+	json_appendf(json, "\"memory\":{\"rss_start\":%ld,\"rss_end\":%ld,\"peak_rss\":%ld,\"heap_start\":%ld,\"heap_end\":%ld},\"phases\":{",
+		     cstats.rss_start, rss_end, rss_peak, cstats.heap_start, heap_in_use());
+	for (int i = 0; i < PHASE_HIGH; i++) {
+		const auto &ps = cstats.phases[i];
+		json_appendf(json, "%s\"%s\":{\"wall\":%.6f,\"cpu\":%.6f,\"calls\":%ld,\"heap_growth\":%ld}",
+			     i == 0 ? "" : ",", phase_names[i], ps.wall, ps.cpu, ps.calls, ps.heap_growth);
+	}
+	json_appendf(json, "},\"jobs\":{\"considered\":%ld,\"run\":%ld,\"skipped\":%ld,\"skipped_by_reason\":{",
+		     cstats.considered, cstats.run, cstats.skipped);
+	for (const auto &sr : cstats.skipped_by_reason) {
+		json_appendf(json, "%s\"%d\":%ld", first ? "" : ",", sr.first, sr.second);
+		first = false;
+	}
+	json += "}}}";
+
+	/* keep the file from growing without bound */
+	if (stat(CYCLE_STATS_FILE, &sb) == 0 && sb.st_size >= CYCLE_STATS_MAX_SIZE)
+		rename(CYCLE_STATS_FILE, CYCLE_STATS_FILE ".old");
+
+	if ((fp = fopen(CYCLE_STATS_FILE, "a")) != NULL) {
+		fprintf(fp, "%s\n", json.c_str());
+		fclose(fp);
+	} else
+		log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__,
+			   "Can not open %s to write the cycle stats", CYCLE_STATS_FILE);
+
+	if (pbs_sd >= 0) {
+		struct attropl attr = {0};
+
+		attr.name = const_cast<char *>(ATTR_sched_cycle_stats);
+		attr.value = const_cast<char *>(json.c_str());
+		attr.op = SET;
+		if (pbs_manager(pbs_sd, MGR_CMD_SET, MGR_OBJ_SCHED, const_cast<char *>(sc_name), &attr, NULL) != 0)
+			log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__,
+				   "Failed to set %s on the server", ATTR_sched_cycle_stats);
+	}
+}
+
+/**
+ * @brief	the stats of the last cycle which collected them
+ *
+ * @return	const std::string &
+ * @retval	the JSON written by cycle_stats_end(), empty if none was
+ */
+const std::string &
+cycle_stats_last()
+{
+	return last_json;
+}
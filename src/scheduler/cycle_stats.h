@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+#ifndef _CYCLE_STATS_H
+#define _CYCLE_STATS_H
+
+#include <time.h>
+
+#include <atomic>
+#include <string>
+
+#include "constant.h"
+
+/* the parts of a cycle which are timed.  Keep in sync with phase_names[] */
+enum cycle_phase {
+	PHASE_QUERY_SERVER,
+	PHASE_QUERY_NODES,
+	PHASE_QUERY_JOBS,
+	PHASE_BUCKETS,
+	PHASE_PLACEMENT_SETS,
+	PHASE_SORT,
+	PHASE_IS_OK_TO_RUN,
+	PHASE_CALENDAR,
+	PHASE_PREEMPTION,
+	PHASE_RUN_JOB,
+	PHASE_ATTR_UPDATES,
+	PHASE_DUP_SERVER,
+	PHASE_HIGH
+};
+
+/* are we collecting stats for the current cycle? */
+extern std::atomic<bool> cycle_stats_on;
+
+/*
+ *	phase_timer - adds the wall and cpu time and the heap growth of the
+ *		      process while it is in scope to a cycle phase.
+ *		      Does nothing when stats are not being collected.
+ *		      A timer nested in a timer of the same phase is not counted.
+ */
+class phase_timer
+{
+	enum cycle_phase phase;
+	bool entered;	/* start() was called */
+	bool outer;	/* not nested in a timer of the same phase */
+	struct timespec wall_start;
+	struct timespec cpu_start;
+	long heap_start;
+	void start();
+	void stop();
+
+public:
+	explicit phase_timer(enum cycle_phase p) : phase(p), entered(false), outer(false)
+	{
+		if (cycle_stats_on)
+			start();
+	}
+	~phase_timer()
+	{
+		if (entered)
+			stop();
+	}
+	phase_timer(const phase_timer &) = delete;
+	phase_timer &operator=(const phase_timer &) = delete;
+};
+
+/*
+ *	cycle_stats_begin - start collecting stats for a cycle if cycle_stats is set
+ */
+void cycle_stats_begin();
+
+/*
+ *	cycle_stats_job_considered - count a job the main loop looked at
+ */
+void cycle_stats_job_considered();
+
+/*
+ *	cycle_stats_job_run - count a job the main loop ran
+ */
+void cycle_stats_job_run();
+
+/*
+ *	cycle_stats_job_skipped - count a job which could not run and why
+ */
+void cycle_stats_job_skipped(enum sched_error_code code);
+
+/*
+ *	cycle_stats_end - write the stats of the cycle to CYCLE_STATS_FILE and
+ *			  to the scheduler's sched_cycle_stats attribute
+ */
+void cycle_stats_end(int pbs_sd);
+
+/*
+ *	cycle_stats_last - the JSON of the last cycle stats were collected for
+ */
+const std::string &cycle_stats_last();
+
+#endif /* _CYCLE_STATS_H */
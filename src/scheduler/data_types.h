@@ -53,11 +53,15 @@
 #ifndef	_DATA_TYPES_H
 #define	_DATA_TYPES_H
 
+#include <atomic>
+#include <map>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include <stdint.h>
 #include <time.h>
 #include <pbs_ifl.h>
 #include <libutil.h>
@@ -136,6 +140,9 @@ typedef struct th_data_free_ninfo th_data_free_ninfo;
 typedef struct th_data_dup_resresv th_data_dup_resresv;
 typedef struct th_data_query_jinfo th_data_query_jinfo;
 typedef struct th_data_free_resresv th_data_free_resresv;
+typedef struct th_data_eval_nodepart th_data_eval_nodepart;
+typedef struct th_data_dup_resv_occr th_data_dup_resv_occr;
+typedef struct resv_occurrence resv_occurrence;
 
 using counts_umap = std::unordered_map<std::string, counts *>;
 #ifdef NAS
@@ -172,6 +179,7 @@ struct th_task_info
 	int task_id;							/* task id, should be set by main thread */
 	enum thread_task_type task_type;		/* task type */
 	void *thread_data;					/* data for the worker thread to execute the task */
+	std::atomic<int> *pending;				/* tasks left in this task's batch, set by queue_tasks() */
 };
 
 struct th_data_nd_eligible
@@ -198,6 +206,7 @@ struct th_data_dup_nd_info
 struct th_data_query_ninfo
 {
 	bool error:1;
+	bool free_statuses:1;	/* the chunk owns nodes and frees them when done */
 	struct batch_status *nodes;
 	server_info *sinfo;
 	node_info **oarr;
@@ -226,6 +235,7 @@ struct th_data_dup_resresv
 struct th_data_query_jinfo
 {
 	bool error:1;
+	bool free_statuses:1;	/* the chunk owns jobs and frees them when done */
 	struct batch_status *jobs;
 	server_info *sinfo;
 	queue_info *qinfo;
@@ -243,6 +253,43 @@ struct th_data_free_resresv
 	int eidx;
 };
 
+struct th_data_eval_nodepart
+{
+	bool can_fit:1;				/* resresv fits the placement set's meta data */
+	bool can_fit_total:1;			/* resresv fits the placement set's total resources */
+	bool rc:1;				/* placement was found in the placement set */
+	status *policy;
+	selspec *spec;
+	place *pl;
+	node_partition *np;
+	resource_resv *resresv;
+	unsigned int flags;			/* flags for resresv_can_fit_nodepart() */
+	unsigned int pass_flags;		/* flags for eval_placement() */
+	std::vector<nspec *> *nspec_arr;	/* the node solution */
+	schd_error *err;
+	schd_error *total_err;			/* err after the COMPARE_TOTAL check */
+};
+
+/* an occurrence of a standing reservation still to be cloned from its parent */
+struct resv_occurrence
+{
+	resource_resv *parent;			/* the standing reservation */
+	char *execvnode;			/* the occurrence's execvnode, NULL if none */
+	time_t start;				/* start time of the occurrence */
+	int occr_idx;				/* index of the occurrence in the reservation */
+	int slot;				/* index of the occurrence in the reservation array */
+};
+
+struct th_data_dup_resv_occr
+{
+	bool error:1;
+	resv_occurrence *occrs;
+	resource_resv **resresv_arr;		/* array the clones are stored into */
+	server_info *sinfo;
+	int sidx;
+	int eidx;
+};
+
 struct schd_error
 {
 	enum sched_error_code error_code;	/* scheduler error code (see constant.h) */
@@ -299,6 +346,7 @@ class selspec
 	int total_cpus;			/* # of cpus requested in this select spec */
 	std::unordered_set<resdef *> defs;			/* the resources requested by this select spec*/
 	chunk **chunks;
+	std::atomic<int> refs;		/* owners sharing this spec, see share_selspec() */
 	selspec();
 	selspec(const selspec&);
 	selspec& operator=(const selspec&);
@@ -346,6 +394,7 @@ struct status
 	/* not really policy... but kinda just left over here */
 	time_t current_time;			/* current time in the cycle */
 	time_t cycle_start;			/* cycle start in real time */
+	bool fast_cycle;			/* only look at the first conf.fast_path_jobs jobs */
 
 	unsigned int order;			/* used to assign a ordering to objs */
 	int preempt_attempts;			/* number of jobs attempted to preempt */
@@ -395,6 +444,8 @@ class server_info
 	bool node_group_enable:1;	/* is node grouping enabled */
 	bool has_nodes_assoc_queue:1; /* nodes are associates with queues */
 	bool has_multi_vnode:1;	/* server has at least one multi-vnoded MOM  */
+	bool nodes_dflt_excl:1;	/* every node makes a job exclusive unless it asks to share */
+	bool nodes_force_excl:1;	/* every node makes every job exclusive */
 	bool has_runjob_hook:1;	/* server has at least 1 runjob hook enabled */
 	bool eligible_time_enable:1;/* controls if we accrue eligible_time  */
 	bool provision_enable:1;	/* controls if provisioning occurs */
@@ -405,6 +456,7 @@ class server_info
 	std::string name;		/* name of server */
 	struct schd_resource *res;	/* list of resources */
 	void *liminfo;			/* limit storage information */
+	std::size_t limits_gen;		/* hash of the hard limits and the running jobs counted against them */
 	int num_nodes;			/* number of nodes associated with the server */
 	int num_resvs;			/* number of reservations on the server */
 	int num_preempted;		/* number of jobs currently preempted */
@@ -468,6 +520,8 @@ class server_info
 	resresv_set **equiv_classes;
 	node_bucket **buckets;		/* node bucket array */
 	node_info **unordered_nodes;
+	/* node name -> node_ind, shared read-only by all copies of the universe */
+	std::shared_ptr<const std::unordered_map<std::string, int>> node_name_ind;
 	std::unordered_map<std::string, node_partition *> svr_to_psets;
 #ifdef NAS
 	/* localmod 034 */
@@ -863,6 +917,11 @@ struct schd_resource
 
 	resdef *def;			/* resource definition */
 
+	/* only set on the head of a list indexed by index_resource_list() */
+	schd_resource **def_index;	/* resources of the list by resdef index */
+	int def_index_size;		/* size of def_index */
+	schd_resource *def_index_tail;	/* last resource in the list when it was indexed */
+
 	struct schd_resource *next;	/* next resource in list */
 };
 
@@ -883,7 +942,8 @@ class resdef
 	const std::string name;	/* name of resource */
 	resource_type type;	/* resource type */
 	unsigned int flags;	/* resource flags (see pbs_ifl.h) */
-	resdef(char *rname, unsigned int rflags, resource_type rtype) : name(rname), type(rtype), flags(rflags) {}
+	int index;		/* dense id of the resource among all resdefs */
+	resdef(char *rname, unsigned int rflags, resource_type rtype, int rindex) : name(rname), type(rtype), flags(rflags), index(rindex) {}
 };
 
 class prev_job_info
@@ -959,6 +1019,10 @@ class group_info
 	group_info *parent;			/* parent node */
 	group_info *sibling;			/* sibling node */
 	group_info *child;			/* child node */
+
+	/* only set on the root of a tree */
+	std::atomic<int> tree_refs;		/* fairshare_heads sharing the tree, see share_fairshare_tree(); atomic since worker threads free sim universes */
+	std::unordered_map<std::string, group_info *> *name_index;	/* the tree's nodes by name */
 	explicit group_info(const std::string& gname);
 	group_info(group_info&);
 	group_info &operator=(const group_info &);
@@ -981,12 +1045,14 @@ struct resresv_set
 	place *place_spec;		/* place spec of set */
 	resource_req *req;		/* ATTR_L (qsub -l) resources of set.  Only contains resources on the resources line */
 	queue_info *qinfo;		/* The queue the resresv is in if the queue has nodes associated */
+	char *verdict_key;		/* key of the set's cached limit verdict, see find_ec_verdict() */
 };
 
 struct node_partition
 {
 	bool ok_break:1;	/* OK to break up chunks on this node part */
 	bool excl:1;		/* partition should be allocated exclusively */
+	bool resort:1;		/* sort keys changed since its array was last sorted */
 	char *name;		/* res_name=res_val */
 	/* name of resource and value which define the node partition */
 	resdef *def;
@@ -1046,6 +1112,19 @@ struct group_node_usage_v2
 	usage_t usage;
 };
 
+/* Usage file version 3 is laid out so it can be mapped into memory.
+ * After the group_node_header comes a group_node_usage_v3_head, then a
+ * table of num_entities names of USAGE_NAME_MAX bytes each, padded up to
+ * the alignment of usage_t, and then an array of num_entities usages.
+ * The usage of the entity at index i of the name table is at index i of
+ * the usage array, so it can be read or updated in place.
+ */
+struct group_node_usage_v3_head
+{
+	time_t last_decay;	/* last time the usage was decayed */
+	int64_t num_entities;	/* number of entries in the name table and usage array */
+};
+
 struct usage_info
 {
 	char *name;			/* name of the user */
@@ -1121,6 +1200,9 @@ class nspec
 	nspec();
 	nspec(const nspec &, node_info **, selspec *);
 	~nspec();
+	/* nspecs are allocated from a mem_pool */
+	static void *operator new(size_t size);
+	static void operator delete(void *ptr);
 	/* We need to have the copy constructor dup everything inside the nspec
 	 * We can't have the default copy constructor copy everything, because
 	 * we'd end up with a pointer to the same resreq
@@ -1166,6 +1248,9 @@ struct config
 	bool node_sort_unused:1;	/* node sorting by unused/assigned is used */
 	bool resv_conf_ignore:1;	/* if we want to ignore dedicated time when confirming reservations.  Move to enum if ever expanded */
 	bool allow_aoe_calendar:1;	/* allow jobs requesting aoe in calendar*/
+	bool incr_job_query:1;		/* only query queued jobs changed since last cycle */
+	bool parallel_pset_eval:1;	/* evaluate placement sets on the worker threads */
+	bool cycle_stats:1;		/* time the phases of each cycle */
 #ifdef NAS /* localmod 034 */
 	bool prime_sto:1;	/* shares_track_only--no enforce shares */
 	bool non_prime_sto:1;
@@ -1188,6 +1273,10 @@ struct config
 	int unknown_shares;			/* unknown group shares */
 	int max_preempt_attempts;		/* max num of preempt attempts per cyc*/
 	int max_jobs_to_check;			/* max number of jobs to check in cyc*/
+	int job_trace_sample;			/* trace every Nth job considered */
+	int fast_path_jobs;			/* jobs to check in a cycle after a submit or job end */
+	time_t fast_path_full_interval;		/* time between full cycles when using the fast path */
+	int peer_queue_max_jobs;		/* queued jobs to pull from each peer queue per cycle */
 	std::string ded_prefix;			/* prefix to dedicated queues */
 	std::string pt_prefix;			/* prefix to primetime queues */
 	std::string npt_prefix;			/* prefix to non primetime queues */
@@ -1197,10 +1286,12 @@ struct config
 	std::unordered_set<std::string> res_to_check;		/* the resources schedule on */
 	std::unordered_set<resdef *> resdef_to_check;		/* the res to schedule on in def form */
 	std::unordered_set<std::string> ignore_res;		/* resources - unset implies infinite */
+	std::unordered_set<std::string> job_trace_jobs;		/* jobs to always trace */
 	/* order to preempt jobs */
 	std::vector<sort_info> prime_node_sort;	/* node sorting primetime */
 	std::vector<sort_info> non_prime_node_sort;	/* node sorting non primetime */
 	std::vector<dyn_res> dynamic_res; /* for server_dyn_res */
+	time_t dyn_res_cache_ttl;		/* reuse server_dyn_res output this long */
 	std::vector<peer_queue> peer_queues;/* peer local -> remote queue map */
 #ifdef NAS
 	/* localmod 034 */
@@ -1232,6 +1323,9 @@ struct event_list
 	timed_event *next_event;	/* the next event to be performed */
 	timed_event *first_run_event;	/* The first run event in the calendar */
 	time_t *current_time;		/* [reference] current time in the calendar */
+	/* indexes over events: time_index is kept in calendar order */
+	std::multimap<time_t, timed_event *> time_index;
+	std::unordered_multimap<std::string, timed_event *> name_index;
 };
 
 struct timed_event
@@ -59,13 +59,22 @@
  * 	compare_path()
  * 	print_fairshare()
  * 	write_usage()
- * 	rec_write_usage()
+ * 	usage_v3_usages_offset()
+ * 	usage_v3_size()
+ * 	write_usage_in_place()
+ * 	rec_collect_usage()
  * 	read_usage()
+ * 	load_entity_usage()
  * 	read_usage_v1()
  * 	read_usage_v2()
+ * 	read_usage_v3()
  * 	over_fs_usage()
  * 	dup_fairshare_tree()
  * 	free_fairshare_tree()
+ * 	share_fairshare_tree()
+ * 	release_fairshare_tree()
+ * 	unshare_fairshare_tree()
+ * 	index_fairshare_root()
  * 	reset_temp_usage()
  *
  */
@@ -75,6 +84,10 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include <log.h>
 
@@ -90,12 +103,15 @@
 #include "fifo.h"
 #include "resource_resv.h"
 #include "resource.h"
+#include "server_info.h"
 #ifdef NAS /* localmod 041 */
 #include "sort.h"
 #endif
 
 extern time_t last_decay;
 
+static void index_fairshare_root(group_info *root);
+
 /**
  * @brief
  *		add_child - add a group_info to the resource group tree
@@ -115,6 +131,8 @@ add_child(group_info *ginfo, group_info *parent)
 		ginfo->parent = parent;
 		ginfo->resgroup = parent->cresgroup;
 		ginfo->gpath = create_group_path(ginfo);
+		if (ginfo->gpath[0]->name_index != NULL)
+			ginfo->gpath[0]->name_index->emplace(ginfo->name, ginfo);
 	}
 }
 
@@ -141,7 +159,8 @@ add_unknown(group_info *ginfo, group_info *root)
 /**
  * @brief
  *		find_group_info - recursive function to find a group_info in the
- *			  resgroup tree
+ *			  resgroup tree.  The root of a tree has an index of the
+ *			  tree by name, which is used instead of the recursion.
  *
  * @param[in]	name	-	name of the ginfo to find
  * @param[in]	root	-	the root of the current sub-tree
@@ -156,6 +175,13 @@ find_group_info(const std::string &name, group_info *root)
 	if (root == NULL || name == root->name)
 		return root;
 
+	if (root->name_index != NULL) {
+		auto it = root->name_index->find(name);
+		if (it == root->name_index->end())
+			return NULL;
+		return it->second;
+	}
+
 	ginfo = find_group_info(name, root->sibling);
 	if (ginfo == NULL)
 		ginfo = find_group_info(name, root->child);
@@ -320,6 +346,7 @@ preload_tree()
 		return 0;
 
 	root = new group_info(FAIRSHARE_ROOT_NAME);
+	index_fairshare_root(root);
 
 	head->root = root;
 
@@ -430,6 +457,8 @@ update_usage_on_run(resource_resv *resresv)
 
 	u = formula_evaluate(conf.fairshare_res.c_str(), resresv, resresv->resreq);
 	if (resresv->job->ginfo != NULL) {
+		unshare_fairshare_tree(resresv->server);
+
 		for (auto &g : resresv->job->ginfo->gpath)
 			g->temp_usage += u;
 	} else
@@ -511,6 +540,107 @@ compare_path(std::vector<group_info *> &gp1, std::vector<group_info *> &gp2)
 	return rc;
 }
 
+/**
+ * @brief
+ *		offset of the usage array in a version 3 usage file
+ *
+ * @param[in]	num_entities	-	number of entities in the file
+ *
+ * @return	size_t
+ */
+static size_t
+usage_v3_usages_offset(size_t num_entities)
+{
+	size_t off;
+
+	off = sizeof(struct group_node_header) + sizeof(struct group_node_usage_v3_head) +
+	      num_entities * USAGE_NAME_MAX;
+
+	/* align the usage array so it can be used where it is mapped */
+	return (off + sizeof(usage_t) - 1) / sizeof(usage_t) * sizeof(usage_t);
+}
+
+/**
+ * @brief
+ *		size of a version 3 usage file
+ *
+ * @param[in]	num_entities	-	number of entities in the file
+ *
+ * @return	size_t
+ */
+static size_t
+usage_v3_size(size_t num_entities)
+{
+	return usage_v3_usages_offset(num_entities) + num_entities * sizeof(usage_t);
+}
+
+/**
+ * @brief
+ *		update the usage file in place if it is a version 3 file with
+ *		the same entities in it.  This avoids rewriting the name table
+ *		when only the usage has changed (e.g., on decay).
+ *
+ * @param[in]	filename	-	usage file
+ * @param[in]	fhead	-	fairshare tree to write
+ * @param[in]	entities	-	the entities to write, see rec_collect_usage()
+ *
+ * @return	int
+ * @retval	1	: the file was updated
+ * @retval	0	: the file needs to be rewritten
+ */
+static int
+write_usage_in_place(const char *filename, fairshare_head *fhead, const std::vector<group_info *> &entities)
+{
+	struct group_node_header head;
+	struct group_node_usage_v3_head v3head;
+	struct stat sb;
+	size_t size;
+	char *map;
+	char *names;
+	char name[USAGE_NAME_MAX];
+	int match = 1;
+	int fd;
+
+	size = usage_v3_size(entities.size());
+
+	if ((fd = open(filename, O_RDWR)) < 0)
+		return 0;
+	if (fstat(fd, &sb) < 0 || static_cast<size_t>(sb.st_size) != size) {
+		close(fd);
+		return 0;
+	}
+	map = static_cast<char *>(mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+	close(fd);
+	if (map == MAP_FAILED)
+		return 0;
+
+	memcpy(&head, map, sizeof(head));
+	memcpy(&v3head, map + sizeof(head), sizeof(v3head));
+	if (strncmp(head.tag, USAGE_MAGIC, sizeof(head.tag)) != 0 || head.version != 3 ||
+	    v3head.num_entities != static_cast<int64_t>(entities.size()))
+		match = 0;
+
+	names = map + sizeof(head) + sizeof(v3head);
+	for (size_t i = 0; match && i < entities.size(); i++) {
+		memset(name, 0, sizeof(name));
+		snprintf(name, sizeof(name), "%s", entities[i]->name.c_str());
+		if (memcmp(name, names + i * USAGE_NAME_MAX, USAGE_NAME_MAX) != 0)
+			match = 0;
+	}
+
+	if (match) {
+		char *usages = map + usage_v3_usages_offset(entities.size());
+
+		v3head.last_decay = fhead->last_decay;
+		memcpy(map + sizeof(head), &v3head, sizeof(v3head));
+		for (size_t i = 0; i < entities.size(); i++)
+			memcpy(usages + i * sizeof(usage_t), &entities[i]->usage, sizeof(usage_t));
+	}
+
+	munmap(map, size);
+	return match;
+}
+
 /**
  * @brief
  *		write_usage - write the usage information to the usage file
@@ -527,6 +657,10 @@ write_usage(const char *filename, fairshare_head *fhead)
 {
 	FILE *fp; /* file pointer to usage file */
 	struct group_node_header head;
+	struct group_node_usage_v3_head v3head;
+	std::vector<group_info *> entities;
+	char name[USAGE_NAME_MAX];
+	size_t off;
 
 	if (fhead == NULL)
 		return 0;
@@ -534,18 +668,23 @@ write_usage(const char *filename, fairshare_head *fhead)
 	if (filename == NULL)
 		filename = USAGE_FILE;
 
+	rec_collect_usage(fhead->root, entities);
+
+	if (write_usage_in_place(filename, fhead, entities))
+		return 1;
+
 	if ((fp = fopen(filename, "wb")) == NULL) {
 		sprintf(log_buffer, "Error opening file %s", filename);
 		log_err(errno, "write_usage", log_buffer);
 		return 0;
 	}
 
-	/* version 2:
+	/* version 3:
 	 * header
-	 * last_decay
-	 * group_node_usage_v2
-	 * group_node_usage_v2
-	 * ...
+	 * group_node_usage_v3_head
+	 * name table
+	 * padding
+	 * usage array
 	 */
 
 	memset(&head, 0, sizeof(struct group_node_header));
@@ -553,29 +692,43 @@ write_usage(const char *filename, fairshare_head *fhead)
 	pbs_strncpy(head.tag, USAGE_MAGIC, sizeof(head.tag));
 	head.version = USAGE_VERSION;
 	fwrite(&head, sizeof(struct group_node_header), 1, fp);
-	fwrite(&fhead->last_decay, sizeof(time_t), 1, fp);
 
-	rec_write_usage(fhead->root, fp);
+	memset(&v3head, 0, sizeof(struct group_node_usage_v3_head));
+	v3head.last_decay = fhead->last_decay;
+	v3head.num_entities = entities.size();
+	fwrite(&v3head, sizeof(struct group_node_usage_v3_head), 1, fp);
+
+	for (auto ginfo : entities) {
+		memset(name, 0, sizeof(name));
+		snprintf(name, sizeof(name), "%s", ginfo->name.c_str());
+		fwrite(name, sizeof(name), 1, fp);
+	}
+
+	off = sizeof(head) + sizeof(v3head) + entities.size() * USAGE_NAME_MAX;
+	for (; off < usage_v3_usages_offset(entities.size()); off++)
+		fputc('\0', fp);
+
+	for (auto ginfo : entities)
+		fwrite(&ginfo->usage, sizeof(usage_t), 1, fp);
+
 	fclose(fp);
 	return 1;
 }
 
 /**
  * @brief
- *		rec_write_usage - recursive helper function which will write out all
- *			  the group_info structs of the resgroup tree
+ *		rec_collect_usage - recursive helper function which collects the
+ *			  group_info structs of the resgroup tree to write out
  *
  * @param[in]	root	-	the root of the current subtree
- * @param[in]	fp	-	the file to write the ginfo out to
+ * @param[out]	entities	-	the group_infos to write out
  *
  * @return nothing
  *
  */
 void
-rec_write_usage(group_info *root, FILE *fp)
+rec_collect_usage(group_info *root, std::vector<group_info *> &entities)
 {
-	struct group_node_usage_v2 grp; /* used to write out usage info */
-
 	if (root == NULL)
 		return;
 
@@ -583,16 +736,11 @@ rec_write_usage(group_info *root, FILE *fp)
 	 * usage defaults to 1 so don't bother writing those out either
 	 * It is possible that the unknown group is empty.  Don't want to write it out
 	 */
-	if (root->usage != 1 && root->child == NULL && root->name != UNKNOWN_GROUP_NAME) {
-		memset(&grp, 0, sizeof(struct group_node_usage_v2));
-		snprintf(grp.name, sizeof(grp.name), "%s", root->name.c_str());
-		grp.usage = root->usage;
+	if (root->usage != 1 && root->child == NULL && root->name != UNKNOWN_GROUP_NAME)
+		entities.push_back(root);
 
-		fwrite(&grp, sizeof(struct group_node_usage_v2), 1, fp);
-	}
-
-	rec_write_usage(root->sibling, fp);
-	rec_write_usage(root->child, fp);
+	rec_collect_usage(root->sibling, entities);
+	rec_collect_usage(root->child, entities);
 }
 
 /**
@@ -632,7 +780,10 @@ read_usage(const char *filename, int flags, fairshare_head *fhead)
 		if (!strcmp(head.tag, USAGE_MAGIC)) { /* this is a header */
 			int error = 0;
 
-			if (head.version == 2) {
+			if (head.version == 3) {
+				if (!read_usage_v3(fp, flags, fhead))
+					error = 1;
+			} else if (head.version == 2) {
 				if (fread(&last, sizeof(time_t), 1, fp) != 0) {
 					/* 946713600 = 1/1/2000 00:00 - before usage version 2 existed */
 					if (last == 0 || last > 946713600)
@@ -658,6 +809,52 @@ read_usage(const char *filename, int flags, fairshare_head *fhead)
 	fclose(fp);
 }
 
+/**
+ * @brief
+ * 		load the usage of one entity read from a usage file into the
+ *		fairshare tree
+ *
+ * @param[in]	root	-	root of the fairshare tree
+ * @param[in]	flags	-	FS_TRIM to not add entities which are not already in the tree
+ * @param[in]	name	-	name of the entity
+ * @param[in]	usage	-	usage of the entity
+ *
+ * @return	void
+ */
+static void
+load_entity_usage(group_info *root, int flags, char *name, usage_t usage)
+{
+	group_info *ginfo;
+
+	if (usage < 0 || !is_valid_pbs_name(name, USAGE_NAME_MAX)) {
+		log_event(PBSEVENT_SCHED, PBS_EVENTCLASS_FILE, LOG_WARNING,
+			  "fairshare usage", "Invalid entity");
+		return;
+	}
+
+	/* if we're trimming the tree, don't add any new nodes which are not
+	 * already in the resource_group file
+	 */
+	if (flags & FS_TRIM)
+		ginfo = find_group_info(name, root);
+	else
+		ginfo = find_alloc_ginfo(name, root);
+
+	if (ginfo != NULL) {
+		ginfo->usage = usage;
+		ginfo->temp_usage = usage;
+		if (ginfo->child == NULL) {
+			/* add usage down the path from the root to our parent */
+			for (auto &g : ginfo->gpath) {
+				if (g == ginfo)
+					break;
+				g->usage += usage;
+				g->temp_usage += usage;
+			}
+		}
+	}
+}
+
 /**
  * @brief
  * 		read version 1 usage file
@@ -674,31 +871,12 @@ int
 read_usage_v1(FILE *fp, group_info *root)
 {
 	struct group_node_usage_v1 grp;
-	group_info *ginfo;
 
 	if (fp == NULL)
 		return 0;
 	memset(&grp, 0, sizeof(struct group_node_usage_v1));
-	while (fread(&grp, sizeof(struct group_node_usage_v1), 1, fp)) {
-		if (grp.usage >= 0 && is_valid_pbs_name(grp.name, USAGE_NAME_MAX)) {
-			ginfo = find_alloc_ginfo(grp.name, root);
-			if (ginfo != NULL) {
-				ginfo->usage = grp.usage;
-				ginfo->temp_usage = grp.usage;
-				if (ginfo->child == NULL) {
-					/* add usage down the path from the root to our parent */
-					for (auto &g : ginfo->gpath) {
-						if (g == ginfo)
-							break;
-						g->usage += grp.usage;
-						g->temp_usage += grp.usage;
-					}
-				}
-			}
-		} else
-			log_event(PBSEVENT_SCHED, PBS_EVENTCLASS_FILE, LOG_WARNING,
-				  "fairshare usage", "Invalid entity");
-	}
+	while (fread(&grp, sizeof(struct group_node_usage_v1), 1, fp))
+		load_entity_usage(root, NO_FLAGS, grp.name, grp.usage);
 
 	return 1;
 }
@@ -719,40 +897,73 @@ int
 read_usage_v2(FILE *fp, int flags, group_info *root)
 {
 	struct group_node_usage_v2 grp;
-	group_info *ginfo;
 
 	if (fp == NULL)
 		return 0;
 
 	memset(&grp, 0, sizeof(struct group_node_usage_v2));
-	while (fread(&grp, sizeof(struct group_node_usage_v2), 1, fp)) {
-		if (grp.usage >= 0 && is_valid_pbs_name(grp.name, USAGE_NAME_MAX)) {
-			/* if we're trimming the tree, don't add any new nodes which are not
-			 * already in the resource_group file
-			 */
-			if (flags & FS_TRIM)
-				ginfo = find_group_info(grp.name, root);
-			else
-				ginfo = find_alloc_ginfo(grp.name, root);
-
-			if (ginfo != NULL) {
-				ginfo->usage = grp.usage;
-				ginfo->temp_usage = grp.usage;
-				if (ginfo->child == NULL) {
-					/* add usage down the path from the root to our parent */
-					for (auto &g : ginfo->gpath) {
-						if (g == ginfo)
-							break;
-						g->usage += grp.usage;
-						g->temp_usage += grp.usage;
-					}
-				}
-			}
-		} else
-			log_event(PBSEVENT_SCHED, PBS_EVENTCLASS_FILE, LOG_WARNING,
-				  "fairshare usage", "Invalid entity");
+	while (fread(&grp, sizeof(struct group_node_usage_v2), 1, fp))
+		load_entity_usage(root, flags, grp.name, grp.usage);
+
+	return 1;
+}
+
+/**
+ * @brief
+ * 		read version 3 usage file.  The file is mapped into memory
+ *		rather than read record by record.
+ *
+ * @param[in]	fp	- the file pointer to the open file
+ * @param[in]	flags	- flags to check whether to trim or not.
+ * @param[in]	fhead	- the fairshare tree
+ *
+ *	@retval 1 success
+ *	@retval 0 failure (the file is not a valid version 3 file)
+ *
+ */
+int
+read_usage_v3(FILE *fp, int flags, fairshare_head *fhead)
+{
+	struct group_node_usage_v3_head v3head;
+	struct stat sb;
+	size_t size;
+	char *map;
+	char name[USAGE_NAME_MAX + 1];
+	usage_t usage;
+
+	if (fp == NULL || fhead == NULL)
+		return 0;
+
+	if (fstat(fileno(fp), &sb) < 0)
+		return 0;
+	size = sb.st_size;
+	if (size < sizeof(struct group_node_header) + sizeof(v3head))
+		return 0;
+
+	map = static_cast<char *>(mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileno(fp), 0));
+	if (map == MAP_FAILED)
+		return 0;
+
+	memcpy(&v3head, map + sizeof(struct group_node_header), sizeof(v3head));
+	if (v3head.num_entities < 0 ||
+	    static_cast<uint64_t>(v3head.num_entities) > size / USAGE_NAME_MAX ||
+	    usage_v3_size(v3head.num_entities) != size) {
+		munmap(map, size);
+		return 0;
+	}
+
+	fhead->last_decay = v3head.last_decay;
+
+	auto names = map + sizeof(struct group_node_header) + sizeof(v3head);
+	auto usages = map + usage_v3_usages_offset(v3head.num_entities);
+	name[USAGE_NAME_MAX] = '\0';
+	for (int64_t i = 0; i < v3head.num_entities; i++) {
+		memcpy(name, names + i * USAGE_NAME_MAX, USAGE_NAME_MAX);
+		memcpy(&usage, usages + i * sizeof(usage_t), sizeof(usage_t));
+		load_entity_usage(fhead->root, flags, name, usage);
 	}
 
+	munmap(map, size);
 	return 1;
 }
 
@@ -820,6 +1031,8 @@ group_info::group_info(const std::string &gname) : name(gname)
 	parent = NULL;
 	sibling = NULL;
 	child = NULL;
+	tree_refs = 0;
+	name_index = NULL;
 }
 
 group_info::group_info(group_info &oginfo) : name(oginfo.name)
@@ -835,6 +1048,8 @@ group_info::group_info(group_info &oginfo) : name(oginfo.name)
 	sibling = NULL;
 	child = NULL;
 	parent = NULL;
+	tree_refs = 0;
+	name_index = NULL;
 }
 
 group_info &
@@ -851,6 +1066,8 @@ group_info::operator=(const group_info &oginfo)
 	sibling = NULL;
 	child = NULL;
 	parent = NULL;
+	tree_refs = 0;
+	name_index = NULL;
 
 	return *this;
 }
@@ -876,7 +1093,10 @@ dup_fairshare_tree(group_info *root, group_info *nparent)
 	if (nroot == NULL)
 		return NULL;
 
-	add_child(nroot, nparent);
+	if (nparent == NULL)
+		index_fairshare_root(nroot);
+	else
+		add_child(nroot, nparent);
 
 	nroot->sibling = dup_fairshare_tree(root->sibling, nparent);
 	nroot->child = dup_fairshare_tree(root->child, nroot);
@@ -898,9 +1118,106 @@ free_fairshare_tree(group_info *root)
 
 	free_fairshare_tree(root->sibling);
 	free_fairshare_tree(root->child);
+	delete root->name_index;
 	delete root;
 }
 
+/**
+ * @brief
+ *		share_fairshare_tree - take another reference on a fairshare tree.
+ *		Used when duplicating the universe so the copy and the original
+ *		can use the same tree.  A shared tree must be treated as
+ *		read-only.  To change it, call unshare_fairshare_tree() first.
+ *
+ * @param[in]	root	-	root of the tree to share
+ *
+ * @return	group_info *
+ * @retval	root	: the same tree
+ * @retval	NULL	: if root is NULL
+ */
+group_info *
+share_fairshare_tree(group_info *root)
+{
+	if (root != NULL)
+		root->tree_refs++;
+	return root;
+}
+
+/**
+ * @brief
+ *		release_fairshare_tree - drop a reference on a fairshare tree.
+ *		The tree is freed once its last reference is dropped.
+ *
+ * @param[in]	root	-	root of the tree to release
+ *
+ * @return	void
+ */
+void
+release_fairshare_tree(group_info *root)
+{
+	if (root == NULL)
+		return;
+
+	if (--root->tree_refs <= 0)
+		free_fairshare_tree(root);
+}
+
+/**
+ * @brief
+ *		unshare_fairshare_tree - give a server its own copy of its fairshare
+ *		tree if the tree is shared with other servers.  The fairshare
+ *		nodes of the server's jobs are moved over to the copy.
+ *
+ * @param[in,out]	sinfo	-	the server whose tree is about to change
+ *
+ * @return	void
+ */
+void
+unshare_fairshare_tree(server_info *sinfo)
+{
+	group_info *oroot;
+	group_info *nroot;
+
+	if (sinfo == NULL || sinfo->fstree == NULL)
+		return;
+
+	oroot = sinfo->fstree->root;
+	if (oroot == NULL || oroot->tree_refs <= 1)
+		return;
+
+	nroot = dup_fairshare_tree(oroot, NULL);
+	if (nroot == NULL)
+		return;
+
+	if (sinfo->all_resresv != NULL) {
+		for (int i = 0; sinfo->all_resresv[i] != NULL; i++) {
+			auto job = sinfo->all_resresv[i]->job;
+			if (sinfo->all_resresv[i]->is_job && job != NULL && job->ginfo != NULL)
+				job->ginfo = find_group_info(job->ginfo->name, nroot);
+		}
+	}
+
+	sinfo->fstree->root = nroot;
+	release_fairshare_tree(oroot);
+}
+
+/**
+ * @brief
+ *		index_fairshare_root - make a group_info the root of a tree with a
+ *		name index.  Nodes added under it with add_child() are indexed.
+ *
+ * @param[in,out]	root	-	the new root
+ *
+ * @return	void
+ */
+static void
+index_fairshare_root(group_info *root)
+{
+	root->tree_refs = 1;
+	root->name_index = new std::unordered_map<std::string, group_info *>;
+	root->name_index->emplace(root->name, root);
+}
+
 /**
  * @brief
  * 		constructor for fairshare head
@@ -914,7 +1231,8 @@ fairshare_head::fairshare_head()
 
 /**
  * @brief
- *		copy constructor for fairshare_head
+ *		copy constructor for fairshare_head.  The copy shares the tree
+ *		of the original until one of them changes it.
  *
  * @param[in]	ofhead	-	fairshare_head to dup
  *
@@ -924,7 +1242,7 @@ fairshare_head::fairshare_head()
 fairshare_head::fairshare_head(fairshare_head &ofhead)
 {
 	last_decay = ofhead.last_decay;
-	root = dup_fairshare_tree(ofhead.root, NULL);
+	root = share_fairshare_tree(ofhead.root);
 }
 
 /**
@@ -933,9 +1251,11 @@ fairshare_head::fairshare_head(fairshare_head &ofhead)
 fairshare_head &
 fairshare_head::operator=(fairshare_head &ofhead)
 {
-	free_fairshare_tree(root);
+	if (root != ofhead.root) {
+		release_fairshare_tree(root);
+		root = share_fairshare_tree(ofhead.root);
+	}
 	last_decay = ofhead.last_decay;
-	root = dup_fairshare_tree(ofhead.root, NULL);
 	return *this;
 }
 
@@ -947,7 +1267,7 @@ fairshare_head::operator=(fairshare_head &ofhead)
  */
 fairshare_head::~fairshare_head()
 {
-	free_fairshare_tree(root);
+	release_fairshare_tree(root);
 }
 
 /**
@@ -122,10 +122,10 @@ void decay_fairshare_tree(group_info *root);
 int write_usage(const char *filename, fairshare_head *fhead);
 
 /*
- *      rec_write_usage - recursive helper function which will write out all
- *                        the group_info structs of the resgroup tree
+ *      rec_collect_usage - recursive helper function which collects the
+ *                          group_info structs of the resgroup tree to write out
  */
-void rec_write_usage(group_info *root, FILE *fp);
+void rec_collect_usage(group_info *root, std::vector<group_info *> &entities);
 
 /*
  *      read_usage - read the usage information and load it into the
@@ -143,6 +143,11 @@ int read_usage_v1(FILE *fp, group_info *root);
  */
 int read_usage_v2(FILE *fp, int flags, group_info *root);
 
+/*
+ *      read_usage_v3 - read version 3 usage file
+ */
+int read_usage_v3(FILE *fp, int flags, fairshare_head *fhead);
+
 /*
  *      create_group_path - create a path from the root to the leaf of the tree
  */
@@ -177,6 +182,15 @@ group_info *dup_fairshare_tree(group_info *root, group_info *nparent);
  */
 void free_fairshare_tree(group_info *root);
 
+/* take another reference on a fairshare tree */
+group_info *share_fairshare_tree(group_info *root);
+
+/* drop a reference on a fairshare tree, freeing it with the last one */
+void release_fairshare_tree(group_info *root);
+
+/* give a server its own copy of a shared fairshare tree before changing it */
+void unshare_fairshare_tree(server_info *sinfo);
+
 /*
  *
  *	add_unknown - add a ginfo to the "unknown" group
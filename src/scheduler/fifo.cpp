@@ -51,16 +51,19 @@
 #endif
 
 #include <algorithm>
+#include <deque>
 
 #include "buckets.h"
 #include "check.h"
 #include "config.h"
 #include "constant.h"
+#include "cycle_stats.h"
 #include "dedtime.h"
 #include "fairshare.h"
 #include "fifo.h"
 #include "globals.h"
 #include "job_info.h"
+#include "job_trace.h"
 #include "libpbs.h"
 #include "limits_if.h"
 #include "misc.h"
@@ -71,11 +74,13 @@
 #include "pbs_internal.h"
 #include "pbs_python.h"
 #include "pbs_share.h"
+#include "pbs_usdt.h"
 #include "pbs_version.h"
 #include "prev_job_info.h"
 #include "prime.h"
 #include "queue_info.h"
 #include "range.h"
+#include "replay.h"
 #include "resource.h"
 #include "resource_resv.h"
 #include "resv_info.h"
@@ -102,6 +107,17 @@
 #include "site_code.h"
 #endif
 
+/* the universe of the last cycle being freed, see end_cycle_tasks() */
+static th_task_info teardown_task;
+static std::atomic<int> teardown_pending(0);
+
+/* the universes add_job_to_calendar() simulated in, being freed */
+static std::deque<th_task_info> sim_teardown_tasks;
+static std::atomic<int> sim_teardown_pending(0);
+
+/* time the last cycle which looked at all the jobs started */
+static time_t last_full_cycle = 0;
+
 /**
  * @brief
  * 		initialize conf struct and parse conf files
@@ -466,6 +482,11 @@ init_scheduling_cycle(status *policy, int pbs_sd, server_info *sinfo)
 int
 schedule(int sd, const sched_cmd *cmd)
 {
+	/* nothing may change the global state the last universe points at
+	 * until it has been freed
+	 */
+	wait_cycle_teardown();
+
 	switch (cmd->cmd) {
 		case SCH_SCHEDULE_NULL:
 		case SCH_RULESET:
@@ -509,6 +530,8 @@ schedule(int sd, const sched_cmd *cmd)
 				return 0;
 			break;
 		case SCH_QUIT:
+			if (conf.incr_job_query)
+				checkpoint_queued_job_cache(true);
 #ifdef PYTHON
 			Py_Finalize();
 #endif
@@ -564,6 +587,31 @@ intermediate_schedule(int sd, const sched_cmd *cmd)
 	return 0;
 }
 
+/**
+ * @brief
+ *		can a cycle take the fast path: a job was submitted or ended and
+ *		only the first fast_path_jobs jobs need to be looked at to start
+ *		whatever fits in its place.  A full cycle is still run at least
+ *		every fast_path_full_interval seconds.
+ *
+ * @param[in]	cmd	-	the command which started the cycle
+ * @param[in]	now	-	the time the cycle is started
+ *
+ * @return	bool
+ */
+static bool
+is_fast_cycle(const sched_cmd *cmd, time_t now)
+{
+	if (conf.fast_path_jobs <= 0 || cmd->jid != NULL)
+		return false;
+	if (cmd->cmd != SCH_SCHEDULE_NEW && cmd->cmd != SCH_SCHEDULE_TERM)
+		return false;
+	if (last_full_cycle == 0 || now - last_full_cycle >= conf.fast_path_full_interval)
+		return false;
+
+	return true;
+}
+
 /**
  * @brief
  *		scheduling_cycle - the controling function of the scheduling cycle
@@ -589,13 +637,23 @@ scheduling_cycle(int sd, const sched_cmd *cmd)
 	log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_REQUEST, LOG_DEBUG,
 		  "", "Starting Scheduling Cycle");
 
+	cycle_stats_begin();
+
 	/* Decide whether we need to send "can't run" type updates this cycle */
 	if (time(NULL) - last_attr_updates >= sc_attrs.attr_update_period)
 		send_job_attr_updates = 1;
 	else
 		send_job_attr_updates = 0;
 
-	update_cycle_status(cstat, 0);
+	update_cycle_status(cstat, replay_time());
+	capture_check_start(cstat.current_time);
+
+	cstat.fast_cycle = is_fast_cycle(cmd, cstat.cycle_start);
+	if (cstat.fast_cycle)
+		log_eventf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_SERVER, LOG_DEBUG, __func__,
+			   "Fast path cycle: considering at most %d jobs", conf.fast_path_jobs);
+	else if (cmd->jid == NULL)
+		last_full_cycle = cstat.cycle_start;
 
 #ifdef NAS /* localmod 030 */
 	do_soft_cycle_interrupt = 0;
@@ -664,6 +722,9 @@ scheduling_cycle(int sd, const sched_cmd *cmd)
 	if (error == 0)
 		rc = main_sched_loop(policy, sd, sinfo, &err);
 
+	/* send the async run requests still queued by the run loop */
+	flush_run_jobs(sd);
+
 	if (cmd->jid != NULL) {
 		int def_rc = -1;
 		int i;
@@ -736,6 +797,9 @@ get_high_prio_cmd(int *is_conn_lost, sched_cmd *high_prior_cmd)
 	sched_cmd cmd;
 	int rc;
 
+	if (clust_secondary_sock < 0)
+		return 0;
+
 	rc = get_sched_cmd_noblk(clust_secondary_sock, &cmd);
 	if (rc == -2) {
 		*is_conn_lost = 1;
@@ -798,12 +862,18 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 	std::vector<nspec *> ns_arr; /* node solution for job */
 	int i;
 	int sort_again = DONT_SORT_JOBS;
+	int max_jobs_to_check;	     /* max number of jobs to check this cycle */
 	schd_error *err;
 	schd_error *chk_lim_err;
 
 	if (policy == NULL || sinfo == NULL || rerr == NULL)
 		return -1;
 
+	max_jobs_to_check = conf.max_jobs_to_check;
+	if (policy->fast_cycle &&
+	    (max_jobs_to_check == SCHD_INFINITY || conf.fast_path_jobs < max_jobs_to_check))
+		max_jobs_to_check = conf.fast_path_jobs;
+
 	time(&cycle_start_time);
 	/* calculate the time which we've been in the cycle too long */
 	cycle_end_time = cycle_start_time + sc_attrs.sched_cycle_length;
@@ -848,22 +918,34 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 
 		log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_JOB, LOG_DEBUG,
 			  njob->name, "Considering job to run");
+		cycle_stats_job_considered();
+		PBS_PROBE1(job__eval__start, njob->name.c_str());
 
 		should_use_buckets = job_should_use_buckets(njob);
 		if (should_use_buckets)
 			flags = USE_BUCKETS;
+		job_trace_job_begin(njob, should_use_buckets);
 
-		if (njob->is_shrink_to_fit) {
-			/* Pass the suitable heuristic for shrinking */
-			ns_arr = is_ok_to_run_STF(policy, sinfo, qinfo, njob, flags, err, shrink_job_algorithm);
-		} else
-			ns_arr = is_ok_to_run(policy, sinfo, qinfo, njob, flags, err);
+		{
+			phase_timer timer(PHASE_IS_OK_TO_RUN);
+			trace_span span("is_ok_to_run");
+
+			if (njob->is_shrink_to_fit) {
+				/* Pass the suitable heuristic for shrinking */
+				ns_arr = is_ok_to_run_STF(policy, sinfo, qinfo, njob, flags, err, shrink_job_algorithm);
+			} else
+				ns_arr = is_ok_to_run(policy, sinfo, qinfo, njob, flags, err);
+			span.set_result(err->error_code);
+		}
+		PBS_PROBE3(is__ok__to__run, njob->name.c_str(), !ns_arr.empty(), err->error_code);
 
 		if (err->status_code == NEVER_RUN)
 			njob->can_never_run = 1;
 
 		if (!ns_arr.empty()) { /* success! */
 			if (rc != SCHD_ERROR) {
+				trace_span span("run_job");
+
 				if (run_update_job(policy, sd, sinfo, qinfo, njob, ns_arr, RURR_ADD_END_EVENT, err)) {
 					rc = SUCCESS;
 					if (sinfo->has_soft_limit || qinfo->has_soft_limit)
@@ -880,6 +962,9 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 			} else
 				free_nspecs(ns_arr);
 		} else if (policy->preempting && in_runnable_state(njob) && (!njob->can_never_run)) {
+			phase_timer timer(PHASE_PREEMPTION);
+			trace_span span("preemption");
+
 			if (find_and_preempt_jobs(policy, sd, njob, sinfo, err) > 0) {
 				rc = SUCCESS;
 				sort_again = MUST_RESORT_JOBS;
@@ -887,6 +972,9 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 				sort_again = SORTED;
 		}
 
+		if (rc == SUCCESS)
+			cycle_stats_job_run();
+
 #ifdef NAS /* localmod 034 */
 		if (rc == SUCCESS && !site_is_queue_topjob_set_aside(njob)) {
 			site_bump_topjobs(njob);
@@ -909,7 +997,14 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 #else
 			if (should_backfill_with_job(policy, sinfo, njob, num_topjobs) != 0) {
 #endif
-				auto cal_rc = add_job_to_calendar(sd, policy, sinfo, njob, should_use_buckets);
+				int cal_rc;
+				{
+					phase_timer timer(PHASE_CALENDAR);
+					trace_span span("calendar");
+
+					cal_rc = add_job_to_calendar(sd, policy, sinfo, njob, should_use_buckets);
+					span.set_result(cal_rc);
+				}
 
 				if (cal_rc > 0) { /* Success! */
 #ifdef NAS					  /* localmod 034 */
@@ -979,6 +1074,7 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 		}
 
 		if ((rc != SUCCESS) && (err->error_code != 0)) {
+			cycle_stats_job_skipped(err->error_code);
 			translate_fail_code(err, comment, log_msg);
 			if (comment[0] != '\0' &&
 			    (!njob->job->is_array || !njob->job->is_begin))
@@ -1019,6 +1115,9 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 			}
 		}
 
+		job_trace_job_end(rc, err);
+		PBS_PROBE2(job__eval__done, njob->name.c_str(), rc);
+
 		time(&cur_time);
 		if (cur_time >= cycle_end_time) {
 			end_cycle = 1;
@@ -1026,7 +1125,7 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 				   "Leaving the scheduling cycle: Cycle duration of %ld seconds has exceeded %s of %ld seconds",
 				   (long) (cur_time - cycle_start_time), ATTR_sched_cycle_len, sc_attrs.sched_cycle_length);
 		}
-		if (conf.max_jobs_to_check != SCHD_INFINITY && (i + 1) >= conf.max_jobs_to_check) {
+		if (max_jobs_to_check != SCHD_INFINITY && (i + 1) >= max_jobs_to_check) {
 			/* i begins with 0, hence i + 1 */
 			end_cycle = 1;
 			log_eventf(PBSEVENT_SCHED, PBS_EVENTCLASS_JOB, LOG_INFO, "",
@@ -1082,14 +1181,31 @@ end_cycle_tasks(server_info *sinfo)
 	if (sinfo != NULL && sinfo->policy->fair_share)
 		create_prev_job_info(sinfo->running_jobs);
 
+	/* the top job simulations are done with by now */
+	wait_tasks(&sim_teardown_pending);
+	sim_teardown_tasks.clear();
+
 	/* we copied in the global fairshare into sinfo at the start of the cycle,
 	 * we don't want to free it now, or we'd lose all fairshare data
 	 */
 	if (sinfo != NULL) {
 		sinfo->fstree = NULL;
-		delete sinfo; /* free server and queues and jobs */
+#ifdef NAS /* localmod 034 */
+		delete sinfo; /* the site code frees global share data */
+#else
+		/* free server and queues and jobs on a worker thread while the
+		 * updates are sent and we wait for the next cycle
+		 */
+		teardown_task.task_id = 0;
+		teardown_task.task_type = TS_FREE_SERVER;
+		teardown_task.thread_data = sinfo;
+		queue_tasks(&teardown_task, 1, &teardown_pending);
+#endif
 	}
 
+	/* send the job updates collected during the cycle in one go */
+	flush_pending_requests(clust_primary_sock);
+
 	/* close any open connections to peers */
 	for (auto &pq : conf.peer_queues) {
 		if (pq.peer_sd >= 0) {
@@ -1106,10 +1222,32 @@ end_cycle_tasks(server_info *sinfo)
 		cmp_aoename = NULL;
 	}
 
+	capture_end();
+	cycle_stats_end(clust_primary_sock);
+	job_trace_cycle_end();
+
+	/* keep the queued job cache for a warm restart */
+	if (conf.incr_job_query && !replay_active())
+		checkpoint_queued_job_cache(false);
+
 	log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_REQUEST, LOG_DEBUG,
 		  "", "Leaving Scheduling Cycle");
 }
 
+/**
+ * @brief
+ *		wait for the universe handed to a worker thread by end_cycle_tasks()
+ *		to be freed.  The calling thread helps free it if no worker has
+ *		got to it yet.
+ *
+ * @return void
+ */
+void
+wait_cycle_teardown(void)
+{
+	wait_tasks(&teardown_pending);
+}
+
 /**
  * @brief
  *		update_job_can_not_run - do post job 'can't run' processing
@@ -1265,6 +1403,8 @@ run_job(status *policy, int pbs_sd, resource_resv *rr, std::vector<nspec *> &ns_
 	if (!pbsrc) {
 		auto execvnode = create_execvnode(ns_arr);
 
+		PBS_PROBE2(run__job__start, rr->name.c_str(), execvnode);
+
 #ifdef NAS /* localmod 031 */
 		/* debug dpr - Log vnodes assigned to job */
 		time_t tm = time(NULL);
@@ -1296,6 +1436,8 @@ run_job(status *policy, int pbs_sd, resource_resv *rr, std::vector<nspec *> &ns_
 			pbsrc = send_run_job(pbs_sd, rr->server->has_runjob_hook, rr->name, execvnode);
 	}
 
+	PBS_PROBE2(run__job__done, rr->name.c_str(), pbsrc);
+
 #ifdef NAS_CLUSTER /* localmod 125 */
 	ret = translate_runjob_return_code(pbsrc, rr);
 #else
@@ -1663,6 +1805,32 @@ should_backfill_with_job(status *policy, server_info *sinfo, resource_resv *resr
 	return 0;
 }
 
+/**
+ * @brief
+ *		free a universe a top job's start time was simulated in.  It is a
+ *		full copy of the cycle's universe, so it is handed to a worker
+ *		thread and the main loop goes on to the next job right away.
+ *		end_cycle_tasks() waits for them to be freed.
+ *
+ * @param[in]	nsinfo	-	the simulated universe
+ *
+ * @return void
+ */
+static void
+free_sim_universe(server_info *nsinfo)
+{
+#ifdef NAS /* localmod 034 */
+	delete nsinfo;
+#else
+	sim_teardown_tasks.emplace_back();
+	th_task_info &task = sim_teardown_tasks.back();
+	task.task_id = sim_teardown_tasks.size() - 1;
+	task.task_type = TS_FREE_SERVER;
+	task.thread_data = nsinfo;
+	queue_tasks(&task, 1, &sim_teardown_pending);
+#endif
+}
+
 /**
  * @brief
  * 		Find the start time of the top job and init
@@ -1706,7 +1874,7 @@ add_job_to_calendar(int pbs_sd, status *policy, server_info *sinfo,
 		 * Note: We only ever look from now into the future
 		 */
 		auto nexte = get_next_event(sinfo->calendar);
-		if (find_timed_event(nexte, topjob->name, IGNORE_DISABLED_EVENTS, TIMED_NOEVENT, 0) != NULL)
+		if (find_timed_event(sinfo->calendar, nexte, topjob->name, IGNORE_DISABLED_EVENTS, TIMED_NOEVENT, 0) != NULL)
 			return 1;
 	}
 	try {
@@ -1774,7 +1942,7 @@ add_job_to_calendar(int pbs_sd, status *policy, server_info *sinfo,
 					create_node_array_from_nspec(bjob->nspec_arr);
 				selectspec = create_select_from_nspec(bjob->nspec_arr);
 				if (!selectspec.empty()) {
-					delete bjob->execselect;
+					free_selspec(bjob->execselect);
 					bjob->execselect = parse_selspec(selectspec);
 				}
 			} else {
@@ -1851,10 +2019,10 @@ add_job_to_calendar(int pbs_sd, status *policy, server_info *sinfo,
 	} else if (start_time == 0) {
 		log_event(PBSEVENT_SCHED, PBS_EVENTCLASS_JOB, LOG_WARNING, topjob->name,
 			  "Error in calculation of start time of top job");
-		delete nsinfo;
+		free_sim_universe(nsinfo);
 		return 0;
 	}
-	delete nsinfo;
+	free_sim_universe(nsinfo);
 
 	return 1;
 }
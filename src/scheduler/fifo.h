@@ -178,6 +178,11 @@ int update_job_can_not_run(int pbs_sd, resource_resv *job, schd_error *err);
  */
 void end_cycle_tasks(server_info *sinfo);
 
+/*
+ *	wait_cycle_teardown - wait for the universe of the last cycle to be freed
+ */
+void wait_cycle_teardown(void);
+
 /*
  *	add_job_to_calendar - find the most top job and init all the
  *		correct variables in sinfo to correctly backfill around it
@@ -243,6 +248,15 @@ int validate_running_user(char *exename);
 
 int send_run_job(int virtual_sd, int has_runjob_hook, const std::string &jobid, char *execvnode);
 
+/* send the run requests queued by send_run_job() as one run job list */
+int flush_run_jobs(int virtual_sd);
+
+/* send the attribute updates queued by send_attr_updates() as one modify job list */
+int flush_attr_updates(int virtual_sd);
+
+/* send all queued run requests and attribute updates */
+int flush_pending_requests(int virtual_sd);
+
 struct batch_status *send_statsched(int virtual_fd, struct attrl *attrib, char *extend);
 
 #endif /* _FIFO_H */
@@ -0,0 +1,735 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file    formula.cpp
+ *
+ * @brief
+ * 		formula.cpp - This file contains functions to compile math formulas
+ *		(job_sort_formula and the fairshare resource) into an expression
+ *		tree which can be evaluated without the python interpreter.
+ *
+ *		The compiler understands numbers, consumable resources, the
+ *		formula keywords, the + - * / // % ** operators, parentheses and
+ *		the min(), max() and abs() functions.  Anything else is left to
+ *		python.  Evaluation follows python's float semantics.  Any case
+ *		where python would raise an exception is also left to python so
+ *		the error is reported the same way.
+ *
+ * Functions included are:
+ * 	find_compiled_formula()
+ * 	eval_compiled_formula()
+ * 	clear_formula_cache()
+ *
+ */
+
+#include <pbs_config.h>
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "data_types.h"
+#include "formula.h"
+#include "globals.h"
+#include "resource_resv.h"
+
+/* max number of compiled formulas to keep around */
+#define FORMULA_CACHE_MAX 16
+
+enum formula_op {
+	FE_NUM,
+	FE_RES,
+	FE_ELIGIBLE_TIME,
+	FE_QUEUE_PRIO,
+	FE_JOB_PRIO,
+	FE_FSPERC,
+	FE_TREE_USAGE,
+	FE_FSFACTOR,
+	FE_ACCRUE_TYPE,
+	FE_NEG,
+	FE_POS,
+	FE_ADD,
+	FE_SUB,
+	FE_MUL,
+	FE_DIV,
+	FE_FLOORDIV,
+	FE_MOD,
+	FE_POW,
+	FE_MIN,
+	FE_MAX,
+	FE_ABS
+};
+
+class formula_expr
+{
+	public:
+	enum formula_op op;
+	double num;			/* value of FE_NUM */
+	resdef *def;			/* resource of FE_RES */
+	std::vector<formula_expr *> args; /* operands */
+
+	explicit formula_expr(enum formula_op o) : op(o), num(0), def(NULL) {}
+	~formula_expr()
+	{
+		for (auto a : args)
+			delete a;
+	}
+	formula_expr(const formula_expr &) = delete;
+	formula_expr &operator=(const formula_expr &) = delete;
+};
+
+/* the special case keywords which are not resources */
+static const struct {
+	const char *name;
+	enum formula_op op;
+} formula_keywords[] = {
+	{FORMULA_ELIGIBLE_TIME, FE_ELIGIBLE_TIME},
+	{FORMULA_QUEUE_PRIO, FE_QUEUE_PRIO},
+	{FORMULA_JOB_PRIO, FE_JOB_PRIO},
+	{FORMULA_FSPERC, FE_FSPERC},
+	{FORMULA_FSPERC_DEP, FE_FSPERC},
+	{FORMULA_TREE_USAGE, FE_TREE_USAGE},
+	{FORMULA_FSFACTOR, FE_FSFACTOR},
+	{FORMULA_ACCRUE_TYPE, FE_ACCRUE_TYPE},
+};
+
+/* python keywords: a formula using one of these is left to python */
+static const char *python_keywords[] = {
+	"False", "None", "True", "and", "as", "assert", "async", "await",
+	"break", "class", "continue", "def", "del", "elif", "else", "except",
+	"finally", "for", "from", "global", "if", "import", "in", "is",
+	"lambda", "nonlocal", "not", "or", "pass", "raise", "return", "try",
+	"while", "with", "yield", NULL};
+
+/* formula string -> compiled formula.  NULL if the formula can't be compiled */
+static std::unordered_map<std::string, formula_expr *> formula_cache;
+
+/*
+ * recursive descent parser following python's grammar for the
+ * subset of expressions we understand.  All parse functions return
+ * NULL if the formula can't be compiled.
+ */
+class formula_parser
+{
+	public:
+	explicit formula_parser(const char *str) : p(str) {}
+	formula_expr *parse();
+
+	private:
+	const char *p;
+
+	void skip_space()
+	{
+		while (*p == ' ' || *p == '\t')
+			p++;
+	}
+	formula_expr *parse_expr();
+	formula_expr *parse_term();
+	formula_expr *parse_factor();
+	formula_expr *parse_power();
+	formula_expr *parse_atom();
+	formula_expr *parse_number();
+	formula_expr *parse_name();
+};
+
+/**
+ * @brief
+ *		create an operator node and take ownership of its operands
+ *
+ * @param[in]	op	-	the operator
+ * @param[in]	left	-	first operand
+ * @param[in]	right	-	second operand (NULL for unary operators)
+ *
+ * @return	formula_expr *
+ * @retval	new node
+ * @retval	NULL	: if an operand is NULL
+ */
+static formula_expr *
+new_op_expr(enum formula_op op, formula_expr *left, formula_expr *right)
+{
+	formula_expr *e;
+
+	if (left == NULL || (right == NULL && op != FE_NEG && op != FE_POS && op != FE_ABS)) {
+		delete left;
+		delete right;
+		return NULL;
+	}
+
+	e = new formula_expr(op);
+	e->args.push_back(left);
+	if (right != NULL)
+		e->args.push_back(right);
+	return e;
+}
+
+formula_expr *
+formula_parser::parse()
+{
+	formula_expr *e;
+
+	e = parse_expr();
+	if (e == NULL)
+		return NULL;
+	skip_space();
+	if (*p != '\0') {
+		delete e;
+		return NULL;
+	}
+	return e;
+}
+
+/* expr := term (('+' | '-') term)* */
+formula_expr *
+formula_parser::parse_expr()
+{
+	formula_expr *e;
+
+	e = parse_term();
+	while (e != NULL) {
+		skip_space();
+		if (*p == '+') {
+			p++;
+			e = new_op_expr(FE_ADD, e, parse_term());
+		} else if (*p == '-') {
+			p++;
+			e = new_op_expr(FE_SUB, e, parse_term());
+		} else
+			break;
+	}
+	return e;
+}
+
+/* term := factor (('*' | '/' | '//' | '%') factor)* */
+formula_expr *
+formula_parser::parse_term()
+{
+	formula_expr *e;
+
+	e = parse_factor();
+	while (e != NULL) {
+		enum formula_op op;
+
+		skip_space();
+		if (*p == '*' && p[1] != '*') {
+			op = FE_MUL;
+			p++;
+		} else if (*p == '/' && p[1] == '/') {
+			op = FE_FLOORDIV;
+			p += 2;
+		} else if (*p == '/') {
+			op = FE_DIV;
+			p++;
+		} else if (*p == '%') {
+			op = FE_MOD;
+			p++;
+		} else
+			break;
+		/* augmented assignment and the like */
+		if (*p == '=') {
+			delete e;
+			return NULL;
+		}
+		e = new_op_expr(op, e, parse_factor());
+	}
+	return e;
+}
+
+/* factor := ('+' | '-') factor | power */
+formula_expr *
+formula_parser::parse_factor()
+{
+	skip_space();
+	if (*p == '-') {
+		p++;
+		return new_op_expr(FE_NEG, parse_factor(), NULL);
+	} else if (*p == '+') {
+		p++;
+		return new_op_expr(FE_POS, parse_factor(), NULL);
+	}
+	return parse_power();
+}
+
+/* power := atom ['**' factor] */
+formula_expr *
+formula_parser::parse_power()
+{
+	formula_expr *e;
+
+	e = parse_atom();
+	if (e == NULL)
+		return NULL;
+	skip_space();
+	if (p[0] == '*' && p[1] == '*') {
+		p += 2;
+		return new_op_expr(FE_POW, e, parse_factor());
+	}
+	return e;
+}
+
+/* atom := number | name | name '(' args ')' | '(' expr ')' */
+formula_expr *
+formula_parser::parse_atom()
+{
+	formula_expr *e;
+
+	skip_space();
+	if (*p == '(') {
+		p++;
+		e = parse_expr();
+		if (e == NULL)
+			return NULL;
+		skip_space();
+		if (*p != ')') {
+			delete e;
+			return NULL;
+		}
+		p++;
+		return e;
+	}
+	if (isdigit(*p) || (*p == '.' && isdigit(p[1])))
+		return parse_number();
+	if (isalpha(*p) || *p == '_')
+		return parse_name();
+
+	return NULL;
+}
+
+/**
+ * @brief
+ *		parse a python decimal integer or float literal
+ *
+ * @return	formula_expr *
+ * @retval	FE_NUM node
+ * @retval	NULL	: if the literal is something we don't handle
+ *			  (hex, underscores, imaginary, leading zeros...)
+ */
+formula_expr *
+formula_parser::parse_number()
+{
+	const char *start = p;
+	formula_expr *e;
+	bool is_int = true;
+	char *endp;
+	double val;
+
+	while (isdigit(*p))
+		p++;
+	if (*p == '.') {
+		is_int = false;
+		p++;
+		while (isdigit(*p))
+			p++;
+	}
+	if (*p == 'e' || *p == 'E') {
+		const char *exp = p + 1;
+
+		if (*exp == '+' || *exp == '-')
+			exp++;
+		if (!isdigit(*exp))
+			return NULL;
+		is_int = false;
+		p = exp;
+		while (isdigit(*p))
+			p++;
+	}
+	if (isalnum(*p) || *p == '_' || *p == '.')
+		return NULL;
+	/* python 3 doesn't allow leading zeros on decimal integers */
+	if (is_int && start[0] == '0' && p - start > 1)
+		return NULL;
+
+	val = strtod(start, &endp);
+	if (endp != p || !isfinite(val))
+		return NULL;
+
+	e = new formula_expr(FE_NUM);
+	e->num = val;
+	return e;
+}
+
+/**
+ * @brief
+ *		parse a name: a formula keyword, a consumable resource or a
+ *		call to min(), max() or abs().  Formula keywords take precedence
+ *		over resources of the same name, like they do in python's
+ *		globals dictionary.
+ *
+ * @return	formula_expr *
+ * @retval	new node
+ * @retval	NULL	: if the name is something we don't handle
+ */
+formula_expr *
+formula_parser::parse_name()
+{
+	const char *start = p;
+	std::string name;
+	resdef *def = NULL;
+	formula_expr *e;
+	int i;
+
+	while (isalnum(*p) || *p == '_')
+		p++;
+	name.assign(start, p - start);
+
+	for (i = 0; python_keywords[i] != NULL; i++)
+		if (name == python_keywords[i])
+			return NULL;
+
+	for (const auto &kw : formula_keywords)
+		if (name == kw.name)
+			return new formula_expr(kw.op);
+
+	for (const auto &cr : consres) {
+		if (cr->name == name) {
+			def = cr;
+			break;
+		}
+	}
+
+	skip_space();
+	if (*p == '(') {
+		enum formula_op op;
+
+		/* calling a resource value is an error in python */
+		if (def != NULL)
+			return NULL;
+		if (name == "min")
+			op = FE_MIN;
+		else if (name == "max")
+			op = FE_MAX;
+		else if (name == "abs")
+			op = FE_ABS;
+		else
+			return NULL;
+		p++;
+
+		e = new formula_expr(op);
+		while (1) {
+			formula_expr *arg;
+
+			arg = parse_expr();
+			if (arg == NULL) {
+				delete e;
+				return NULL;
+			}
+			e->args.push_back(arg);
+			skip_space();
+			if (*p == ',')
+				p++;
+			else if (*p == ')') {
+				p++;
+				break;
+			} else {
+				delete e;
+				return NULL;
+			}
+		}
+		/* abs() takes one argument and min()/max() need at least two numbers */
+		if ((op == FE_ABS && e->args.size() != 1) || (op != FE_ABS && e->args.size() < 2)) {
+			delete e;
+			return NULL;
+		}
+		return e;
+	}
+
+	if (def == NULL)
+		return NULL;
+
+	e = new formula_expr(FE_RES);
+	e->def = def;
+	return e;
+}
+
+/**
+ * @brief
+ *		return the value python would see for a number which was
+ *		printed into the python globals dictionary with 'digits'
+ *		digits after the decimal point
+ *
+ * @param[in]	val	-	the value
+ * @param[in]	digits	-	number of digits after the decimal point
+ *
+ * @return	double
+ */
+static double
+python_value(double val, int digits)
+{
+	char buf[512];
+
+	if (val == floor(val) && fabs(val) < 1e15)
+		return val;
+	snprintf(buf, sizeof(buf), "%.*f", digits, val);
+	return strtod(buf, NULL);
+}
+
+/**
+ * @brief
+ *		evaluate one node of a compiled formula
+ *
+ * @param[in]	e	-	node to evaluate
+ * @param[in]	resresv	-	job for special case key words
+ * @param[in]	resreq	-	resources to use when evaluating
+ * @param[out]	val	-	the value of the node
+ *
+ * @return	bool
+ * @retval	true	: *val was set
+ * @retval	false	: python would raise an exception here
+ */
+static bool
+eval_formula_node(const formula_expr *e, resource_resv *resresv, resource_req *resreq, double *val)
+{
+	double a = 0;
+	double b = 0;
+	job_info *job = resresv->job;
+
+	switch (e->op) {
+		case FE_NUM:
+			*val = e->num;
+			return true;
+		case FE_RES: {
+			auto req = find_resource_req(resreq, e->def);
+			if (req == NULL)
+				*val = 0;
+			else
+				*val = python_value(req->amount, float_digits(req->amount, FLOAT_NUM_DIGITS));
+			return true;
+		}
+		case FE_ELIGIBLE_TIME:
+			*val = job->eligible_time;
+			return true;
+		case FE_QUEUE_PRIO:
+			if (job->queue == NULL)
+				return false;
+			*val = job->queue->priority;
+			return true;
+		case FE_JOB_PRIO:
+			*val = job->priority;
+			return true;
+		case FE_ACCRUE_TYPE:
+			*val = job->accrue_type;
+			return true;
+		case FE_FSPERC:
+		case FE_TREE_USAGE:
+		case FE_FSFACTOR:
+			if (job->ginfo == NULL)
+				return false;
+			if (e->op == FE_FSPERC)
+				a = job->ginfo->tree_percentage;
+			else if (e->op == FE_TREE_USAGE)
+				a = job->ginfo->usage_factor;
+			else if (job->ginfo->tree_percentage != 0)
+				a = pow(2, -(job->ginfo->usage_factor / job->ginfo->tree_percentage));
+			*val = python_value(a, 6);
+			return true;
+		case FE_MIN:
+		case FE_MAX:
+			if (!eval_formula_node(e->args[0], resresv, resreq, &a))
+				return false;
+			for (size_t i = 1; i < e->args.size(); i++) {
+				if (!eval_formula_node(e->args[i], resresv, resreq, &b))
+					return false;
+				if ((e->op == FE_MIN && b < a) || (e->op == FE_MAX && b > a))
+					a = b;
+			}
+			*val = a;
+			return true;
+		default:
+			break;
+	}
+
+	/* unary and binary operators */
+	if (!eval_formula_node(e->args[0], resresv, resreq, &a))
+		return false;
+	if (e->args.size() > 1 && !eval_formula_node(e->args[1], resresv, resreq, &b))
+		return false;
+
+	switch (e->op) {
+		case FE_NEG:
+			*val = -a;
+			break;
+		case FE_POS:
+			*val = a;
+			break;
+		case FE_ABS:
+			*val = fabs(a);
+			break;
+		case FE_ADD:
+			*val = a + b;
+			break;
+		case FE_SUB:
+			*val = a - b;
+			break;
+		case FE_MUL:
+			*val = a * b;
+			break;
+		case FE_DIV:
+			if (b == 0)
+				return false;
+			*val = a / b;
+			break;
+		case FE_MOD:
+		case FE_FLOORDIV: {
+			/* python's float divmod */
+			double mod;
+			double div;
+
+			if (b == 0)
+				return false;
+			mod = fmod(a, b);
+			div = (a - mod) / b;
+			if (mod != 0) {
+				if ((b < 0) != (mod < 0)) {
+					mod += b;
+					div -= 1.0;
+				}
+			} else
+				mod = copysign(0.0, b);
+			if (e->op == FE_MOD) {
+				*val = mod;
+				break;
+			}
+			if (div != 0) {
+				double floordiv = floor(div);
+				if (div - floordiv > 0.5)
+					floordiv += 1.0;
+				*val = floordiv;
+			} else
+				*val = copysign(0.0, a / b);
+			break;
+		}
+		case FE_POW:
+			/* zero to a negative power and complex results raise in python */
+			if (a == 0 && b < 0)
+				return false;
+			if (a < 0 && b != floor(b))
+				return false;
+			*val = pow(a, b);
+			/* so does overflow */
+			if (!isfinite(*val) && isfinite(a) && isfinite(b))
+				return false;
+			break;
+		default:
+			return false;
+	}
+	return true;
+}
+
+/**
+ * @brief
+ *		return the compiled form of a formula.  A formula is compiled
+ *		the first time it is seen and kept until the resource
+ *		definitions change.
+ *
+ * @param[in]	formula	-	formula to compile
+ *
+ * @return	const formula_expr *
+ * @retval	compiled formula
+ * @retval	NULL	: if the formula needs python to be evaluated
+ */
+const formula_expr *
+find_compiled_formula(const char *formula)
+{
+	formula_expr *fexpr;
+
+	if (formula == NULL)
+		return NULL;
+
+	auto f = formula_cache.find(formula);
+	if (f != formula_cache.end())
+		return f->second;
+
+	if (formula_cache.size() >= FORMULA_CACHE_MAX)
+		clear_formula_cache();
+
+	formula_parser parser(formula);
+	fexpr = parser.parse();
+	formula_cache[formula] = fexpr;
+
+	return fexpr;
+}
+
+/**
+ * @brief
+ *		evaluate a compiled formula for a job
+ *
+ * @param[in]	fexpr	-	compiled formula
+ * @param[in]	resresv	-	job for special case key words
+ * @param[in]	resreq	-	resources to use when evaluating
+ * @param[out]	ans	-	evaluated formula answer
+ *
+ * @return	bool
+ * @retval	true	: *ans was set
+ * @retval	false	: python is needed to evaluate the formula for this job
+ */
+bool
+eval_compiled_formula(const formula_expr *fexpr, resource_resv *resresv, resource_req *resreq, sch_resource_t *ans)
+{
+	double val;
+
+	if (fexpr == NULL || resresv == NULL || resresv->job == NULL || ans == NULL)
+		return false;
+
+	if (!eval_formula_node(fexpr, resresv, resreq, &val))
+		return false;
+
+	*ans = val;
+	return true;
+}
+
+/**
+ * @brief
+ *		forget all compiled formulas.  Called when the resource
+ *		definitions change since compiled formulas point at them.
+ *
+ * @return	void
+ */
+void
+clear_formula_cache()
+{
+	for (auto &f : formula_cache)
+		delete f.second;
+	formula_cache.clear();
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+#ifndef _FORMULA_H
+#define _FORMULA_H
+
+#include "data_types.h"
+
+/*
+ *	formula_expr - a math formula compiled into an expression tree
+ *		       so it can be evaluated without the python interpreter
+ */
+class formula_expr;
+
+/*
+ *	find_compiled_formula - return the compiled form of a formula, compiling
+ *				it the first time it is seen
+ *
+ *	return NULL if the formula uses constructs which can not be compiled
+ */
+const formula_expr *find_compiled_formula(const char *formula);
+
+/*
+ *	eval_compiled_formula - evaluate a compiled formula for a job
+ *
+ *	return true if *ans was set
+ *	return false if python is needed to evaluate the formula for this job
+ */
+bool eval_compiled_formula(const formula_expr *fexpr, resource_resv *resresv, resource_req *resreq, sch_resource_t *ans);
+
+/*
+ *	clear_formula_cache - forget all compiled formulas
+ */
+void clear_formula_cache();
+
+#endif /* _FORMULA_H */
@@ -44,6 +44,9 @@
  * 		job_info.c - This file contains functions related to job_info structure.
  *
  * Functions included are:
+ * 	clear_queued_job_cache()
+ * 	checkpoint_queued_job_cache()
+ * 	restore_queued_job_cache()
  * 	query_jobs()
  * 	query_job()
  * 	new_job_info()
@@ -99,6 +102,12 @@
 #include <unistd.h>
 #include <sys/types.h>
 #include <math.h>
+#include <atomic>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include <pbs_ifl.h>
 #include <log.h>
 #include <libutil.h>
@@ -126,6 +135,9 @@
 #include "attribute.h"
 #include "multi_threading.h"
 #include "libpbs.h"
+#include "formula.h"
+#include "cycle_stats.h"
+#include "replay.h"
 
 #ifdef NAS
 #include "site_code.h"
@@ -463,14 +475,14 @@ query_jobs_chunk(th_data_query_jinfo *data)
 	if (err == NULL) {
 		log_err(errno, __func__, MEM_ERR_MSG);
 		data->error = 1;
-		return;
+		goto cleanup;
 	}
 
 	resresv_arr = static_cast<resource_resv **>(malloc(sizeof(resource_resv *) * (num_jobs_chunk + 1)));
 	if (resresv_arr == NULL) {
 		log_err(errno, __func__, MEM_ERR_MSG);
 		data->error = 1;
-		return;
+		goto cleanup;
 	}
 	resresv_arr[0] = NULL;
 
@@ -483,9 +495,8 @@ query_jobs_chunk(th_data_query_jinfo *data)
 
 		if ((resresv = query_job(pbs_sd, cur_job, sinfo, qinfo, err)) == NULL) {
 			data->error = 1;
-			free_schd_error(err);
 			free_resource_resv_array(resresv_arr);
-			return;
+			goto cleanup;
 		}
 
 		/* do a validity check to see if the job is sane.  If we're peering and
@@ -546,7 +557,12 @@ query_jobs_chunk(th_data_query_jinfo *data)
 	resresv_arr[jidx] = NULL;
 	data->oarr = resresv_arr;
 
+cleanup:
 	free_schd_error(err);
+	if (data->free_statuses) {
+		pbs_statfree(jobs);
+		data->jobs = NULL;
+	}
 }
 
 /**
@@ -575,6 +591,7 @@ alloc_tdata_jquery(status *policy, int pbs_sd, struct batch_status *jobs, queue_
 		return NULL;
 	}
 	tdata->error = 0;
+	tdata->free_statuses = 0;
 	tdata->jobs = jobs;
 	tdata->oarr = NULL; /* Will be filled by the thread routine */
 	tdata->sinfo = qinfo->server;
@@ -587,6 +604,789 @@ alloc_tdata_jquery(status *policy, int pbs_sd, struct batch_status *jobs, queue_
 	return tdata;
 }
 
+/* status of a queued job kept across cycles for incremental_job_query */
+struct cached_job_status {
+	struct batch_status *bs; /* the job's status as last returned by the server */
+	time_t fetched;		 /* time the status was fetched */
+	time_t eligible_time;	 /* eligible_time at the time of the fetch */
+};
+
+/* per queue cache of queued job statuses */
+struct queued_job_cache {
+	std::unordered_map<std::string, cached_job_status> jobs;
+	long mtime_mark; /* highest job mtime seen so far (server clock) */
+	queued_job_cache() : mtime_mark(0) {}
+};
+
+static std::unordered_map<std::string, queued_job_cache> qjob_cache;
+
+/**
+ * @brief	find the value of an attribute in a batch_status
+ *
+ * @param[in]	bs - batch_status to search
+ * @param[in]	name - name of the attribute
+ *
+ * @return	struct attrl *
+ * @retval	the attribute
+ * @retval	NULL if not found
+ */
+static struct attrl *
+find_bs_attr(struct batch_status *bs, const char *name)
+{
+	for (auto attrp = bs->attribs; attrp != NULL; attrp = attrp->next)
+		if (!strcmp(attrp->name, name))
+			return attrp;
+
+	return NULL;
+}
+
+/**
+ * @brief	free the cached statuses of one queue
+ *
+ * @param[in]	qc - the queue's cache
+ *
+ * @return	void
+ */
+static void
+free_queued_job_cache(queued_job_cache &qc)
+{
+	for (auto &cj : qc.jobs) {
+		cj.second.bs->next = NULL;
+		pbs_statfree(cj.second.bs);
+	}
+	qc.jobs.clear();
+	qc.mtime_mark = 0;
+}
+
+/**
+ * @brief	drop all cached queued job statuses
+ *
+ * @return	void
+ */
+void
+clear_queued_job_cache()
+{
+	for (auto &qc : qjob_cache)
+		free_queued_job_cache(qc.second);
+	qjob_cache.clear();
+}
+
+/**
+ * @brief	save the queued job cache to QJOB_CACHE_FILE so a restarted
+ *		scheduler does not need to query every queued job again.
+ *		The cache is written at most every QJOB_CACHE_PERIOD seconds.
+ *
+ * @param[in]	force - write the cache even if the period has not passed
+ *
+ * @return	void
+ */
+void
+checkpoint_queued_job_cache(bool force)
+{
+	static time_t last_checkpoint = 0;
+	std::vector<std::pair<std::string, struct batch_status *>> records;
+	std::vector<std::string> texts;
+	struct batch_status *meta = NULL;
+	struct batch_status **mtail = &meta;
+	time_t now = time(NULL);
+
+	if (!force && now - last_checkpoint < QJOB_CACHE_PERIOD)
+		return;
+	last_checkpoint = now;
+
+	if (qjob_cache.empty()) {
+		unlink(QJOB_CACHE_FILE);
+		return;
+	}
+
+	/* the first meta object names the server, the rest hold each queue's mtime mark */
+	texts.reserve(qjob_cache.size() + 1);
+	texts.push_back("");
+	for (auto &qc : qjob_cache)
+		texts.push_back(std::to_string(qc.second.mtime_mark));
+
+	auto add_meta = [&mtail](const char *name, std::string &text) {
+		auto bs = static_cast<struct batch_status *>(calloc(1, sizeof(struct batch_status)));
+		if (bs == NULL)
+			return false;
+		bs->name = const_cast<char *>(name);
+		bs->text = const_cast<char *>(text.c_str());
+		*mtail = bs;
+		mtail = &bs->next;
+		return true;
+	};
+
+	bool ok = add_meta(pbs_conf.pbs_server_name != NULL ? pbs_conf.pbs_server_name : "", texts[0]);
+	size_t i = 1;
+	for (auto &qc : qjob_cache)
+		ok = ok && add_meta(qc.first.c_str(), texts[i++]);
+
+	if (ok) {
+		std::vector<char *> saved_text;
+
+		records.emplace_back("meta", meta);
+		/* borrow the cached statuses, their text holds when they were fetched */
+		for (auto &qc : qjob_cache) {
+			struct batch_status *head = NULL;
+
+			for (auto &cj : qc.second.jobs) {
+				char buf[64];
+
+				snprintf(buf, sizeof(buf), "%ld %ld", (long) cj.second.fetched, (long) cj.second.eligible_time);
+				saved_text.push_back(cj.second.bs->text);
+				cj.second.bs->text = strdup(buf);
+				cj.second.bs->next = head;
+				head = cj.second.bs;
+			}
+			records.emplace_back("jobs " + qc.first, head);
+		}
+
+		write_status_file(QJOB_CACHE_FILE, QJOB_CACHE_MAGIC, QJOB_CACHE_VERSION, records);
+
+		i = 0;
+		for (auto &qc : qjob_cache)
+			for (auto &cj : qc.second.jobs) {
+				free(cj.second.bs->text);
+				cj.second.bs->text = saved_text[i++];
+				cj.second.bs->next = NULL;
+			}
+	}
+
+	while (meta != NULL) {
+		auto next = meta->next;
+		free(meta);
+		meta = next;
+	}
+}
+
+/**
+ * @brief	load the queued job cache saved by checkpoint_queued_job_cache().
+ *		A cache saved for another server is ignored.  The restored
+ *		statuses are only reused if the server does not report a newer
+ *		mtime for the job, just like a cache kept in memory.
+ *
+ * @return	void
+ */
+void
+restore_queued_job_cache()
+{
+	std::vector<std::pair<std::string, struct batch_status *>> records;
+	size_t njobs = 0;
+
+	clear_queued_job_cache();
+
+	if (read_status_file(QJOB_CACHE_FILE, QJOB_CACHE_MAGIC, QJOB_CACHE_VERSION, records) != 0)
+		return;
+
+	if (records.empty() || records[0].first != "meta" || records[0].second == NULL ||
+	    strcmp(records[0].second->name, pbs_conf.pbs_server_name != NULL ? pbs_conf.pbs_server_name : "") != 0) {
+		log_event(PBSEVENT_SCHED, PBS_EVENTCLASS_FILE, LOG_NOTICE, QJOB_CACHE_FILE,
+			  "Queued job cache is for another server, ignoring it");
+		for (auto &r : records)
+			pbs_statfree(r.second);
+		return;
+	}
+
+	for (auto bs = records[0].second->next; bs != NULL; bs = bs->next)
+		qjob_cache[bs->name].mtime_mark = strtol(bs->text != NULL ? bs->text : "0", NULL, 10);
+
+	for (size_t i = 1; i < records.size(); i++) {
+		struct batch_status *bs;
+		struct batch_status *next;
+		std::string queue_name;
+
+		if (records[i].first.compare(0, 5, "jobs ") == 0)
+			queue_name = records[i].first.substr(5);
+		auto qc = qjob_cache.find(queue_name);
+
+		for (bs = records[i].second; bs != NULL; bs = next) {
+			cached_job_status cj;
+			char *endp = NULL;
+
+			next = bs->next;
+			bs->next = NULL;
+			if (qc == qjob_cache.end() || bs->text == NULL) {
+				pbs_statfree(bs);
+				continue;
+			}
+			cj.bs = bs;
+			cj.fetched = (time_t) strtol(bs->text, &endp, 10);
+			cj.eligible_time = (time_t) strtol(endp, NULL, 10);
+			free(bs->text);
+			bs->text = NULL;
+			qc->second.jobs[bs->name] = cj;
+			njobs++;
+		}
+	}
+	pbs_statfree(records[0].second);
+
+	log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_FILE, LOG_DEBUG, QJOB_CACHE_FILE,
+		   "Restored %lu cached queued jobs", static_cast<unsigned long>(njobs));
+}
+
+/**
+ * @brief	take ownership of a freshly queried queued job status
+ *
+ * @param[in]	qc - the queue's cache
+ * @param[in]	bs - status of the job
+ * @param[in]	now - time the status was fetched
+ *
+ * @return	void
+ */
+static void
+cache_queued_job(queued_job_cache &qc, struct batch_status *bs, time_t now)
+{
+	cached_job_status cj;
+	struct attrl *attrp;
+
+	cj.bs = bs;
+	cj.fetched = now;
+	cj.eligible_time = 0;
+	if ((attrp = find_bs_attr(bs, ATTR_eligible_time)) != NULL)
+		cj.eligible_time = (time_t) res_to_num(attrp->value, NULL);
+	if ((attrp = find_bs_attr(bs, ATTR_mtime)) != NULL) {
+		long mtime = strtol(attrp->value, NULL, 10);
+		if (mtime > qc.mtime_mark)
+			qc.mtime_mark = mtime;
+	}
+
+	auto it = qc.jobs.find(bs->name);
+	if (it != qc.jobs.end()) {
+		it->second.bs->next = NULL;
+		pbs_statfree(it->second.bs);
+		it->second = cj;
+	} else
+		qc.jobs.emplace(bs->name, cj);
+}
+
+/**
+ * @brief	bring a cached job status up to date before it is reused.
+ *		The server accrues eligible_time on the fly when it statuses
+ *		a job, so we need to do the same for a status we did not refetch.
+ *
+ * @param[in]	cj - the cached job status
+ * @param[in]	now - the current time
+ *
+ * @return	void
+ */
+static void
+refresh_cached_job(cached_job_status &cj, time_t now)
+{
+	struct attrl *accrue;
+	struct attrl *elig;
+	char buf[32];
+
+	if ((accrue = find_bs_attr(cj.bs, ATTR_accrue_type)) == NULL ||
+	    strtol(accrue->value, NULL, 10) != JOB_ELIGIBLE)
+		return;
+
+	if ((elig = find_bs_attr(cj.bs, ATTR_eligible_time)) == NULL)
+		return;
+
+	snprintf(buf, sizeof(buf), "%ld", (long) (cj.eligible_time + (now - cj.fetched)));
+	(void) set_bs_attr_value(cj.bs, elig, buf);
+}
+
+/**
+ * @brief	query the jobs of a queue using the queued job cache.
+ *		Jobs which are not queued and queued job arrays are always
+ *		queried in full.  Of the remaining queued jobs, only the ones
+ *		whose mtime moved past the highest mtime we saw before are
+ *		queried.  The rest are served from the previous cycle's status.
+ *
+ * @par	If we find a queued job we know nothing about, (e.g., its mtime
+ *	is older than our mark) we throw the queue's cache away and query
+ *	all queued jobs of the queue again.
+ *
+ * @param[in]	pbs_sd - connection to the server
+ * @param[in]	queue_name - name of the queue
+ * @param[in]	attrib - attributes to query
+ * @param[out]	err - set to 1 on error
+ *
+ * @return	struct batch_status *
+ * @retval	list of jobs in the queue.  Free with release_job_statuses()
+ * @retval	NULL if the queue has no jobs or on error
+ */
+static struct batch_status *
+query_jobs_incr(int pbs_sd, const std::string &queue_name, struct attrl *attrib, int *err)
+{
+	struct attropl opl_state = {NULL, const_cast<char *>(ATTR_state), NULL, const_cast<char *>("Q"), NE};
+	struct attropl opl_queue = {&opl_state, const_cast<char *>(ATTR_q), NULL, const_cast<char *>(queue_name.c_str()), EQ};
+	struct attropl opl_extra = {NULL, NULL, NULL, NULL, EQ};
+	struct batch_status *head = NULL;
+	struct batch_status *tail = NULL;
+	struct batch_status *bs;
+	struct batch_status *next;
+	char mark[32];
+	auto &qc = qjob_cache[queue_name];
+	time_t now = time(NULL);
+
+	*err = 0;
+
+	/* jobs in any state other than queued are always queried in full */
+	struct batch_status *others = send_selstat(pbs_sd, &opl_queue, attrib, const_cast<char *>("S"));
+	if (others == NULL && pbs_errno > 0) {
+		*err = 1;
+		return NULL;
+	}
+
+	/* queued job arrays change as their subjobs run, query them in full too */
+	opl_state.op = EQ;
+	opl_state.next = &opl_extra;
+	opl_extra.name = const_cast<char *>(ATTR_array);
+	opl_extra.value = const_cast<char *>("True");
+	opl_extra.op = EQ;
+	struct batch_status *arrays = send_selstat(pbs_sd, &opl_queue, attrib, const_cast<char *>("S"));
+	if (arrays == NULL && pbs_errno > 0) {
+		pbs_statfree(others);
+		*err = 1;
+		return NULL;
+	}
+
+	/* the list of queued jobs tells us the order and which cached jobs left */
+	opl_state.next = NULL;
+	char **ids = send_selectjob(pbs_sd, &opl_queue, NULL);
+	if (ids == NULL && pbs_errno > 0) {
+		pbs_statfree(others);
+		pbs_statfree(arrays);
+		*err = 1;
+		return NULL;
+	}
+
+	for (int pass = 0; pass < 2; pass++) {
+		std::unordered_map<std::string, struct batch_status *> fresh;
+		std::unordered_set<std::string> queued;
+		bool full = pass != 0 || qc.jobs.empty();
+		bool miss = false;
+
+		/* the first pass queries what changed, the second everything */
+		if (!full) {
+			snprintf(mark, sizeof(mark), "%ld", qc.mtime_mark);
+			opl_state.next = &opl_extra;
+			opl_extra.name = const_cast<char *>(ATTR_mtime);
+			opl_extra.value = mark;
+			opl_extra.op = GE;
+		} else {
+			free_queued_job_cache(qc);
+			opl_state.next = NULL;
+		}
+
+		struct batch_status *changed = send_selstat(pbs_sd, &opl_queue, attrib, const_cast<char *>("S"));
+		if (changed == NULL && pbs_errno > 0) {
+			*err = 1;
+			break;
+		}
+
+		for (bs = changed; bs != NULL; bs = next) {
+			next = bs->next;
+			bs->next = NULL;
+			if (strchr(bs->name, '[') != NULL)
+				pbs_statfree(bs); /* arrays were queried separately */
+			else {
+				cache_queued_job(qc, bs, now);
+				fresh[bs->name] = bs;
+			}
+		}
+
+		for (int i = 0; ids != NULL && ids[i] != NULL; i++) {
+			if (strchr(ids[i], '[') != NULL)
+				continue;
+			queued.insert(ids[i]);
+			if (fresh.find(ids[i]) != fresh.end())
+				continue;
+			auto it = qc.jobs.find(ids[i]);
+			if (it == qc.jobs.end()) {
+				/* after a full query, the job simply left the queue */
+				if (full)
+					continue;
+				miss = true;
+				break;
+			}
+			refresh_cached_job(it->second, now);
+		}
+
+		if (miss) {
+			log_eventf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_QUEUE, LOG_DEBUG, queue_name,
+				   "Queued job cache out of date, querying all queued jobs");
+			continue;
+		}
+
+		/* forget the jobs which are no longer queued in this queue */
+		for (auto it = qc.jobs.begin(); it != qc.jobs.end();) {
+			if (queued.find(it->first) == queued.end()) {
+				it->second.bs->next = NULL;
+				pbs_statfree(it->second.bs);
+				it = qc.jobs.erase(it);
+			} else
+				it++;
+		}
+
+		/* link the queued jobs in the order the server returned them */
+		for (int i = 0; ids != NULL && ids[i] != NULL; i++) {
+			auto it = qc.jobs.find(ids[i]);
+			if (it == qc.jobs.end())
+				continue;
+			bs = it->second.bs;
+			bs->next = NULL;
+			if (tail == NULL)
+				head = bs;
+			else
+				tail->next = bs;
+			tail = bs;
+		}
+		break;
+	}
+	free(ids);
+
+	if (*err) {
+		pbs_statfree(others);
+		pbs_statfree(arrays);
+		return NULL;
+	}
+
+	/* others and arrays are ours to free, the rest belongs to the cache */
+	if (arrays != NULL) {
+		for (bs = arrays; bs->next != NULL; bs = bs->next)
+			;
+		bs->next = head;
+		head = arrays;
+	}
+	if (others != NULL) {
+		for (bs = others; bs->next != NULL; bs = bs->next)
+			;
+		bs->next = head;
+		head = others;
+	}
+
+	return head;
+}
+
+/**
+ * @brief	query the queued jobs of a peer queue using the queued job cache.
+ *		Only the first conf.peer_queue_max_jobs queued jobs (in the peer
+ *		server's order) are candidates to be pulled this cycle.  Candidates
+ *		the cache knows and which did not change since the last cycle are
+ *		served from the cache, the rest are statused in one request.
+ *
+ * @param[in]	pbs_sd - connection to the peer server
+ * @param[in]	queue_name - name of the queue on the peer server
+ * @param[in]	cache_name - name of the queue's entry in the queued job cache
+ * @param[in]	attrib - attributes to query
+ * @param[out]	err - set to 1 on error
+ *
+ * @return	struct batch_status *
+ * @retval	list of candidate jobs.  Free with release_job_statuses()
+ * @retval	NULL if the queue has no queued jobs or on error
+ */
+static struct batch_status *
+query_peer_jobs_incr(int pbs_sd, const std::string &queue_name, const std::string &cache_name, struct attrl *attrib, int *err)
+{
+	struct attropl opl_extra = {NULL, NULL, NULL, NULL, EQ};
+	struct attropl opl_array = {NULL, const_cast<char *>(ATTR_array), NULL, const_cast<char *>("True"), NE};
+	struct attropl opl_state = {&opl_array, const_cast<char *>(ATTR_state), NULL, const_cast<char *>("Q"), EQ};
+	struct attropl opl_queue = {&opl_state, const_cast<char *>(ATTR_q), NULL, const_cast<char *>(queue_name.c_str()), EQ};
+	std::unordered_set<std::string> wanted;
+	std::vector<std::string> order;
+	std::string missing;
+	struct batch_status *head = NULL;
+	struct batch_status *tail = NULL;
+	struct batch_status *bs;
+	struct batch_status *next;
+	char mark[32];
+	auto &qc = qjob_cache[cache_name];
+	time_t now = time(NULL);
+
+	*err = 0;
+
+	char **ids = send_selectjob(pbs_sd, &opl_queue, NULL);
+	if (ids == NULL) {
+		if (pbs_errno > 0)
+			*err = 1;
+		free_queued_job_cache(qc);
+		return NULL;
+	}
+
+	for (int i = 0; ids[i] != NULL; i++) {
+		if (conf.peer_queue_max_jobs > 0 && i >= conf.peer_queue_max_jobs)
+			break;
+		wanted.insert(ids[i]);
+		order.push_back(ids[i]);
+	}
+	free(ids);
+
+	/* refetch the cached candidates which changed since the last cycle */
+	if (!qc.jobs.empty()) {
+		snprintf(mark, sizeof(mark), "%ld", qc.mtime_mark);
+		opl_array.next = &opl_extra;
+		opl_extra.name = const_cast<char *>(ATTR_mtime);
+		opl_extra.value = mark;
+		opl_extra.op = GE;
+
+		struct batch_status *changed = send_selstat(pbs_sd, &opl_queue, attrib, const_cast<char *>("S"));
+		if (changed == NULL && pbs_errno > 0) {
+			*err = 1;
+			return NULL;
+		}
+		for (bs = changed; bs != NULL; bs = next) {
+			next = bs->next;
+			bs->next = NULL;
+			if (wanted.find(bs->name) != wanted.end())
+				cache_queued_job(qc, bs, now);
+			else
+				pbs_statfree(bs);
+		}
+	}
+
+	/* forget the jobs which are no longer candidates */
+	for (auto it = qc.jobs.begin(); it != qc.jobs.end();) {
+		if (wanted.find(it->first) == wanted.end()) {
+			it->second.bs->next = NULL;
+			pbs_statfree(it->second.bs);
+			it = qc.jobs.erase(it);
+		} else
+			it++;
+	}
+
+	/* status the candidates we know nothing about in a single request */
+	for (auto &id : order) {
+		auto it = qc.jobs.find(id);
+		if (it != qc.jobs.end()) {
+			refresh_cached_job(it->second, now);
+			continue;
+		}
+		if (!missing.empty())
+			missing += ",";
+		missing += id;
+	}
+	if (!missing.empty()) {
+		/* a job which left the queue meanwhile fails the whole request, it is retried next cycle */
+		struct batch_status *fetched = send_statjob(pbs_sd, const_cast<char *>(missing.c_str()), attrib, NULL);
+		for (bs = fetched; bs != NULL; bs = next) {
+			next = bs->next;
+			bs->next = NULL;
+			cache_queued_job(qc, bs, now);
+		}
+	}
+
+	/* link the candidates in the order the peer server returned them */
+	for (auto &id : order) {
+		auto it = qc.jobs.find(id);
+		if (it == qc.jobs.end())
+			continue;
+		bs = it->second.bs;
+		bs->next = NULL;
+		if (tail == NULL)
+			head = bs;
+		else
+			tail->next = bs;
+		tail = bs;
+	}
+
+	return head;
+}
+
+/**
+ * @brief	free a list of jobs returned by query_jobs_incr(),
+ *		query_peer_jobs_incr() or send_selstat()
+ *		Statuses owned by the queued job cache are unlinked but not freed.
+ *
+ * @param[in]	queue_name - name of the queue's entry in the queued job cache
+ * @param[in]	jobs - list of jobs
+ *
+ * @return	void
+ */
+static void
+release_job_statuses(const std::string &queue_name, struct batch_status *jobs)
+{
+	struct batch_status *next;
+
+	auto qc = qjob_cache.find(queue_name);
+	if (qc == qjob_cache.end()) {
+		pbs_statfree(jobs);
+		return;
+	}
+
+	for (auto bs = jobs; bs != NULL; bs = next) {
+		next = bs->next;
+		bs->next = NULL;
+		auto it = qc->second.jobs.find(bs->name);
+		if (it == qc->second.jobs.end() || it->second.bs != bs)
+			pbs_statfree(bs);
+	}
+}
+
+/* state of query_jobs() while the jobs stream in from the server */
+struct job_stream {
+	status *policy;
+	int pbs_sd;
+	queue_info *qinfo;
+	int chunk_size;
+	struct batch_status *head; /* jobs not handed to a task yet */
+	struct batch_status *tail;
+	int count; /* number of jobs in head */
+	bool error;
+	std::deque<th_task_info> tasks;
+	std::atomic<int> pending;
+
+	job_stream(status *pol, int sd, queue_info *qi) : policy(pol), pbs_sd(sd), qinfo(qi),
+							  chunk_size(mt_chunk_size(0)), head(NULL), tail(NULL),
+							  count(0), error(false), pending(0) {}
+};
+
+/**
+ * @brief	hand the jobs collected so far to a worker thread, which frees
+ *		them once it has made resource_resv objects out of them
+ *
+ * @param[in,out]	js	-	the job stream
+ *
+ * @return	void
+ */
+static void
+queue_job_chunk(job_stream *js)
+{
+	th_data_query_jinfo *tdata;
+
+	if (js->head == NULL)
+		return;
+
+	tdata = alloc_tdata_jquery(js->policy, js->pbs_sd, js->head, js->qinfo, 0, js->count - 1);
+	if (tdata == NULL) {
+		pbs_statfree(js->head);
+		js->error = true;
+	} else {
+		tdata->free_statuses = 1;
+		js->tasks.emplace_back();
+		th_task_info &task = js->tasks.back();
+		task.task_id = js->tasks.size() - 1;
+		task.task_type = TS_QUERY_JOB_INFO;
+		task.thread_data = (void *) tdata;
+		queue_tasks(&task, 1, &js->pending);
+	}
+
+	js->head = NULL;
+	js->tail = NULL;
+	js->count = 0;
+}
+
+/**
+ * @brief	pbs_status_cb for query_jobs().  Collects the jobs into chunks
+ *		and queues a chunk for the worker threads once it is full.
+ *
+ * @param[in]	bs	-	the job (or an array job and its subjobs)
+ * @param[in]	arg	-	the job_stream
+ *
+ * @return	void
+ */
+static void
+stream_job(struct batch_status *bs, void *arg)
+{
+	job_stream *js = static_cast<job_stream *>(arg);
+
+	if (js->error) {
+		pbs_statfree(bs);
+		return;
+	}
+
+	if (js->head == NULL)
+		js->head = bs;
+	else
+		js->tail->next = bs;
+	for (js->tail = bs, js->count++; js->tail->next != NULL; js->tail = js->tail->next)
+		js->count++;
+
+	if (js->count >= js->chunk_size)
+		queue_job_chunk(js);
+}
+
+/**
+ * @brief	query the jobs of a queue with pbs_selstat_stream().  The jobs
+ *		are turned into resource_resv objects by the worker threads a
+ *		chunk at a time while the rest are still being read, and their
+ *		batch_status is freed as soon as the chunk is done.
+ *
+ * @param[in]	policy	-	policy info
+ * @param[in]	pbs_sd	-	connection to pbs_server
+ * @param[in]	qinfo	-	queue to get jobs from
+ * @param[in]	pjobs	-	possible job array to add too
+ * @param[in]	opl	-	selection criteria
+ * @param[in]	attrib	-	attributes to query
+ *
+ * @return	resource_resv **
+ * @retval	pjobs with the queue's jobs added
+ * @retval	pjobs if the query failed
+ * @retval	NULL on error
+ */
+static resource_resv **
+query_jobs_stream(status *policy, int pbs_sd, queue_info *qinfo, resource_resv **pjobs,
+		  struct attropl *opl, struct attrl *attrib)
+{
+	job_stream js(policy, pbs_sd, qinfo);
+	resource_resv **resresv_arr = NULL;
+	th_data_query_jinfo *tdata;
+	int num_new_jobs = 0;
+	int num_prev_jobs;
+	int jidx;
+	int rc;
+
+	rc = send_selstat_stream(pbs_sd, opl, attrib, const_cast<char *>("S"), stream_job, &js);
+	if (rc == 0)
+		queue_job_chunk(&js);
+	else {
+		const char *errmsg = pbs_geterrmsg(pbs_sd);
+		if (errmsg == NULL)
+			errmsg = "";
+		log_eventf(PBSEVENT_SCHED, PBS_EVENTCLASS_JOB, LOG_NOTICE, "job_info",
+			   "pbs_selstat failed: %s (%d)", errmsg, rc);
+		pbs_statfree(js.head);
+		js.head = NULL;
+	}
+	wait_tasks(&js.pending);
+
+	for (auto &task : js.tasks) {
+		tdata = static_cast<th_data_query_jinfo *>(task.thread_data);
+		if (tdata->error)
+			js.error = true;
+		else
+			num_new_jobs += count_array(tdata->oarr);
+	}
+
+	num_prev_jobs = count_array(pjobs);
+	if (rc == 0 && !js.error && num_new_jobs > 0) {
+		/* allocate enough space for all the jobs and the NULL sentinal */
+		resresv_arr = static_cast<resource_resv **>(realloc(pjobs, sizeof(resource_resv *) * (num_prev_jobs + num_new_jobs + 1)));
+		if (resresv_arr == NULL) {
+			log_err(errno, __func__, MEM_ERR_MSG);
+			js.error = true;
+		}
+	}
+
+	/* Assemble job info objects from the chunks into the resresv_arr */
+	jidx = num_prev_jobs;
+	for (auto &task : js.tasks) {
+		tdata = static_cast<th_data_query_jinfo *>(task.thread_data);
+		if (tdata->oarr != NULL) {
+			if (resresv_arr == NULL)
+				free_resource_resv_array(tdata->oarr);
+			else {
+				for (int j = 0; tdata->oarr[j] != NULL; j++)
+					resresv_arr[jidx++] = tdata->oarr[j];
+				free(tdata->oarr);
+			}
+		}
+		free(tdata);
+	}
+
+	if (js.error) {
+		free_resource_resv_array(resresv_arr != NULL ? resresv_arr : pjobs);
+		return NULL;
+	}
+	if (resresv_arr == NULL)
+		return pjobs;
+
+	resresv_arr[jidx] = NULL;
+	return resresv_arr;
+}
+
 /**
  * @brief
  * 		create an array of jobs in a specified queue
@@ -601,13 +1401,15 @@ alloc_tdata_jquery(status *policy, int pbs_sd, struct batch_status *jobs, queue_
  * @param[in]	qinfo	-	queue to get jobs from
  * @param[in]	pjobs   -	possible job array to add too
  * @param[in]	queue_name	-	the name of the queue to query (local/remote)
+ * @param[in]	peer	-	the peer queue being queried, NULL for a local queue
  *
  * @return	pointer to the head of a list of jobs
  * @par MT-safe: No
  */
 resource_resv **
-query_jobs(status *policy, int pbs_sd, queue_info *qinfo, resource_resv **pjobs, const std::string &queue_name)
+query_jobs(status *policy, int pbs_sd, queue_info *qinfo, resource_resv **pjobs, const std::string &queue_name, const peer_queue *peer)
 {
+	phase_timer timer(PHASE_QUERY_JOBS);
 	/* pbs_selstat() takes a linked list of attropl structs which tell it
 	 * what information about what jobs to return.  We want all jobs which are
 	 * in a specified queue
@@ -635,9 +1437,8 @@ query_jobs(status *policy, int pbs_sd, queue_info *qinfo, resource_resv **pjobs,
 	/* for multi-threading */
 	int jidx;
 	th_data_query_jinfo *tdata = NULL;
-	th_task_info *task = NULL;
-	resource_resv ***jinfo_arrs_tasks;
-	int tid;
+	th_task_info *tasks = NULL;
+	int chunk_size;
 
 	if (policy == NULL || qinfo == NULL || queue_name.empty())
 		return pjobs;
@@ -684,6 +1485,7 @@ query_jobs(status *policy, int pbs_sd, queue_info *qinfo, resource_resv **pjobs,
 			ATTR_depend,
 			ATTR_A,
 			ATTR_max_run_subjobs,
+			ATTR_mtime,
 			NULL};
 
 		for (int i = 0; jobattrs[i] != NULL; i++) {
@@ -697,8 +1499,43 @@ query_jobs(status *policy, int pbs_sd, queue_info *qinfo, resource_resv **pjobs,
 		}
 	}
 
+	/* peer queues are cached under queue@server, local queue names can't contain '@' */
+	const std::string cache_name = peer != NULL ? peer->remote_queue + "@" + peer->remote_server : queue_name;
+
+	if (!conf.incr_job_query && peer == NULL) {
+		auto qc = qjob_cache.find(queue_name);
+		if (qc != qjob_cache.end()) {
+			free_queued_job_cache(qc->second);
+			qjob_cache.erase(qc);
+		}
+	}
+
+	/* a replayed or captured cycle and the incremental query need the whole list */
+	if (!replay_active() && peer == NULL && !conf.incr_job_query && !capture_active())
+		return query_jobs_stream(policy, pbs_sd, qinfo, pjobs, &opl, attrib);
+
 	/* get jobs from PBS server */
-	if ((jobs = send_selstat(pbs_sd, &opl, attrib, const_cast<char *>("S"))) == NULL) {
+	if (replay_active()) {
+		if ((jobs = replay_next(REPLAY_JOBS + queue_name)) == NULL)
+			return pjobs;
+	} else if (peer != NULL || conf.incr_job_query) {
+		int err;
+
+		if (peer != NULL)
+			jobs = query_peer_jobs_incr(pbs_sd, queue_name, cache_name, attrib, &err);
+		else
+			jobs = query_jobs_incr(pbs_sd, queue_name, attrib, &err);
+		if (jobs == NULL) {
+			if (err) {
+				const char *errmsg = pbs_geterrmsg(pbs_sd);
+				if (errmsg == NULL)
+					errmsg = "";
+				log_eventf(PBSEVENT_SCHED, PBS_EVENTCLASS_JOB, LOG_NOTICE, "job_info",
+					   "pbs_selstat failed: %s (%d)", errmsg, pbs_errno);
+			}
+			return pjobs;
+		}
+	} else if ((jobs = send_selstat(pbs_sd, &opl, attrib, const_cast<char *>("S"))) == NULL) {
 		if (pbs_errno > 0) {
 			const char *errmsg = pbs_geterrmsg(pbs_sd);
 			if (errmsg == NULL)
@@ -709,6 +1546,9 @@ query_jobs(status *policy, int pbs_sd, queue_info *qinfo, resource_resv **pjobs,
 		return pjobs;
 	}
 
+	if (!qinfo->is_peer_queue)
+		capture_record(REPLAY_JOBS + queue_name, jobs);
+
 	/* count the number of new jobs */
 	cur_job = jobs;
 	while (cur_job != NULL) {
@@ -726,25 +1566,25 @@ query_jobs(status *policy, int pbs_sd, queue_info *qinfo, resource_resv **pjobs,
 
 	if (resresv_arr == NULL) {
 		log_err(errno, __func__, MEM_ERR_MSG);
-		pbs_statfree(jobs);
+		release_job_statuses(cache_name, jobs);
 		return NULL;
 	}
 	resresv_arr[num_prev_jobs] = NULL;
 
-	tid = *((int *) pthread_getspecific(th_id_key));
-	if (tid != 0 || num_threads <= 1) {
-		/* don't use multi-threading if I am a worker thread or num_threads is 1 */
+	chunk_size = mt_chunk_size(num_new_jobs);
+	if (num_threads <= 1 || num_new_jobs <= chunk_size) {
+		/* don't use multi-threading if num_threads is 1 or there is only one chunk */
 		tdata = alloc_tdata_jquery(policy, pbs_sd, jobs, qinfo, 0, num_new_jobs - 1);
 		if (tdata == NULL) {
 			free_resource_resv_array(resresv_arr);
-			pbs_statfree(jobs);
+			release_job_statuses(cache_name, jobs);
 			return NULL;
 		}
 		query_jobs_chunk(tdata);
 
 		if (tdata->error || tdata->oarr == NULL) {
 			free_resource_resv_array(resresv_arr);
-			pbs_statfree(jobs);
+			release_job_statuses(cache_name, jobs);
 			free(tdata->oarr);
 			free(tdata);
 			return NULL;
@@ -758,12 +1598,16 @@ query_jobs(status *policy, int pbs_sd, queue_info *qinfo, resource_resv **pjobs,
 		free(tdata);
 		resresv_arr[jidx] = NULL;
 	} else {
-		int chunk_size = num_new_jobs / num_threads;
 		int th_err = 0;
 		int num_tasks = 0;
 
-		chunk_size = (chunk_size > MT_CHUNK_SIZE_MIN) ? chunk_size : MT_CHUNK_SIZE_MIN;
-		chunk_size = (chunk_size < MT_CHUNK_SIZE_MAX) ? chunk_size : MT_CHUNK_SIZE_MAX;
+		tasks = static_cast<th_task_info *>(calloc(num_new_jobs / chunk_size + 1, sizeof(th_task_info)));
+		if (tasks == NULL) {
+			log_err(errno, __func__, MEM_ERR_MSG);
+			free_resource_resv_array(resresv_arr);
+			release_job_statuses(cache_name, jobs);
+			return NULL;
+		}
 		for (int j = 0; num_new_jobs > 0;
 		     num_tasks++, j += chunk_size, num_new_jobs -= chunk_size) {
 			tdata = alloc_tdata_jquery(policy, pbs_sd, jobs, qinfo, j, j + chunk_size - 1);
@@ -771,65 +1615,38 @@ query_jobs(status *policy, int pbs_sd, queue_info *qinfo, resource_resv **pjobs,
 				th_err = 1;
 				break;
 			}
-			task = static_cast<th_task_info *>(malloc(sizeof(th_task_info)));
-			if (task == NULL) {
-				free(tdata);
-				log_err(errno, __func__, MEM_ERR_MSG);
-				th_err = 1;
-				break;
-			}
-			task->task_id = num_tasks;
-			task->task_type = TS_QUERY_JOB_INFO;
-			task->thread_data = (void *) tdata;
-
-			pthread_mutex_lock(&work_lock);
-			ds_enqueue(work_queue, (void *) task);
-			pthread_cond_signal(&work_cond);
-			pthread_mutex_unlock(&work_lock);
-		}
-		jinfo_arrs_tasks = static_cast<resource_resv ***>(malloc(num_tasks * sizeof(resource_resv **)));
-		if (jinfo_arrs_tasks == NULL) {
-			log_err(errno, __func__, MEM_ERR_MSG);
-			th_err = 1;
-		}
-		/* Get results from worker threads */
-		for (int i = 0; i < num_tasks;) {
-			pthread_mutex_lock(&result_lock);
-			while (ds_queue_is_empty(result_queue))
-				pthread_cond_wait(&result_cond, &result_lock);
-			while (!ds_queue_is_empty(result_queue)) {
-				task = static_cast<th_task_info *>(ds_dequeue(result_queue));
-				tdata = static_cast<th_data_query_jinfo *>(task->thread_data);
-				if (tdata->error)
-					th_err = 1;
-				jinfo_arrs_tasks[task->task_id] = tdata->oarr;
-				free(tdata);
-				free(task);
-				i++;
-			}
-			pthread_mutex_unlock(&result_lock);
-		}
-		if (th_err) {
-			pbs_statfree(jobs);
-			free_resource_resv_array(resresv_arr);
-			free(jinfo_arrs_tasks);
-			return NULL;
+			tasks[num_tasks].task_id = num_tasks;
+			tasks[num_tasks].task_type = TS_QUERY_JOB_INFO;
+			tasks[num_tasks].thread_data = (void *) tdata;
 		}
+
+		run_tasks(tasks, num_tasks);
+
 		/* Assemble job info objects from various threads into the resresv_arr */
 		jidx = num_prev_jobs;
 		for (int i = 0; i < num_tasks; i++) {
-			if (jinfo_arrs_tasks[i] != NULL) {
-				for (int j = 0; jinfo_arrs_tasks[i][j] != NULL; j++) {
-					resresv_arr[jidx++] = jinfo_arrs_tasks[i][j];
+			tdata = static_cast<th_data_query_jinfo *>(tasks[i].thread_data);
+			if (tdata->error)
+				th_err = 1;
+			if (tdata->oarr != NULL) {
+				for (int j = 0; tdata->oarr[j] != NULL; j++) {
+					resresv_arr[jidx++] = tdata->oarr[j];
 				}
-				free(jinfo_arrs_tasks[i]);
+				free(tdata->oarr);
 			}
+			free(tdata);
 		}
 		resresv_arr[jidx] = NULL;
-		free(jinfo_arrs_tasks);
+		free(tasks);
+
+		if (th_err) {
+			release_job_statuses(cache_name, jobs);
+			free_resource_resv_array(resresv_arr);
+			return NULL;
+		}
 	}
 
-	pbs_statfree(jobs);
+	release_job_statuses(cache_name, jobs);
 
 	return resresv_arr;
 }
@@ -976,7 +1793,7 @@ query_job(int pbs_sd, struct batch_status *job, server_info *sinfo, queue_info *
 			resresv->job->schedsel = string_dup(attrp->value);
 #endif /* localmod 031 */
 
-			resresv->select = parse_selspec(attrp->value);
+			resresv->select = find_selspec(attrp->value);
 #ifdef NAS /* localmod 031 */
 		}
 #endif /* localmod 031 */
@@ -1040,7 +1857,7 @@ query_job(int pbs_sd, struct batch_status *job, server_info *sinfo, queue_info *
 				}
 #endif
 				if (!strcmp(attrp->resource, "place")) {
-					resresv->place_spec = parse_placespec(attrp->value);
+					resresv->place_spec = find_placespec(attrp->value);
 					if (resresv->place_spec == NULL) {
 						set_schd_error_codes(err, NEVER_RUN, ERR_SPECIAL);
 						set_schd_error_arg(err, SPECMSG, "invalid placement spec");
@@ -1156,7 +1973,7 @@ query_job(int pbs_sd, struct batch_status *job, server_info *sinfo, queue_info *
 		selectspec = create_select_from_nspec(resresv->nspec_arr);
 
 	if (!selectspec.empty())
-		resresv->execselect = parse_selspec(selectspec);
+		resresv->execselect = find_selspec(selectspec);
 
 	set_job_times(pbs_sd, resresv, sinfo->server_time);
 
@@ -2023,6 +2840,7 @@ new_resresv_set(void)
 	rset->req = NULL;
 	rset->select_spec = NULL;
 	rset->qinfo = NULL;
+	rset->verdict_key = NULL;
 
 	return rset;
 }
@@ -2039,9 +2857,10 @@ free_resresv_set(resresv_set *rset)
 	free(rset->user);
 	free(rset->group);
 	free(rset->project);
-	delete rset->select_spec;
+	free_selspec(rset->select_spec);
 	free_place(rset->place_spec);
 	free_resource_req_list(rset->req);
+	free(rset->verdict_key);
 	free(rset);
 }
 /**
@@ -2099,7 +2918,7 @@ dup_resresv_set(resresv_set *oset, server_info *nsinfo)
 		free_resresv_set(rset);
 		return NULL;
 	}
-	rset->select_spec = new selspec(*oset->select_spec);
+	rset->select_spec = share_selspec(oset->select_spec);
 	if (rset->select_spec == NULL) {
 		free_resresv_set(rset);
 		return NULL;
@@ -2116,6 +2935,11 @@ dup_resresv_set(resresv_set *oset, server_info *nsinfo)
 	}
 	if (oset->qinfo != NULL)
 		rset->qinfo = find_queue_info(nsinfo->queues, oset->qinfo->name);
+	rset->verdict_key = string_dup(oset->verdict_key);
+	if (oset->verdict_key != NULL && rset->verdict_key == NULL) {
+		free_resresv_set(rset);
+		return NULL;
+	}
 
 	return rset;
 }
@@ -2295,6 +3119,62 @@ create_resresv_sets_resdef(status *policy)
 	return defs;
 }
 
+/**
+ * @brief create the key of a resresv_set's cached limit verdict.  The key
+ *	is made of the set's components, so sets that compare equal in
+ *	find_resresv_set() have the same key from cycle to cycle.
+ *
+ * @param[in] rset - the resresv_set
+ *
+ * @return char *
+ * @retval the key (to be freed by the caller)
+ * @retval NULL on error
+ */
+static char *
+create_resresv_set_verdict_key(resresv_set *rset)
+{
+	std::string key;
+
+	if (rset == NULL || rset->select_spec == NULL || rset->place_spec == NULL)
+		return NULL;
+
+	/* the entity fields are optional, so tell a missing one from an empty one */
+	key = rset->qinfo != NULL ? "q=" + rset->qinfo->name : "q";
+	key += rset->user != NULL ? std::string("|u=") + rset->user : std::string("|u");
+	key += rset->group != NULL ? std::string("|g=") + rset->group : std::string("|g");
+	key += rset->project != NULL ? std::string("|p=") + rset->project : std::string("|p");
+
+	key += "|s=";
+	for (int i = 0; rset->select_spec->chunks != NULL && rset->select_spec->chunks[i] != NULL; i++) {
+		key += std::to_string(rset->select_spec->chunks[i]->num_chunks) + ":";
+		key += rset->select_spec->chunks[i]->str_chunk;
+		key += "+";
+	}
+
+	auto pl = rset->place_spec;
+	key += "|l=";
+	key += pl->free ? 'f' : '-';
+	key += pl->pack ? 'p' : '-';
+	key += pl->scatter ? 's' : '-';
+	key += pl->vscatter ? 'v' : '-';
+	key += pl->excl ? 'e' : '-';
+	key += pl->exclhost ? 'h' : '-';
+	key += pl->share ? 'S' : '-';
+	if (pl->group != NULL)
+		key += pl->group;
+
+	key += "|r=";
+	for (auto req = rset->req; req != NULL; req = req->next) {
+		key += req->name;
+		key += "=";
+		if (req->res_str != NULL)
+			key += req->res_str;
+		key += ",";
+	}
+
+	return string_dup(key.c_str());
+}
+
 /**
  * @brief create a resresv_set based on a resource_resv
  *
@@ -2329,7 +3209,7 @@ create_resresv_set_by_resresv(status *policy, server_info *sinfo, resource_resv
 	if (resresv_set_use_proj(sinfo, rset->qinfo))
 		rset->project = string_dup(resresv->project.c_str());
 
-	rset->select_spec = new selspec(*resresv_set_which_selspec(resresv));
+	rset->select_spec = share_selspec(resresv_set_which_selspec(resresv));
 	if (rset->select_spec == NULL) {
 		free_resresv_set(rset);
 		return NULL;
@@ -2342,6 +3222,9 @@ create_resresv_set_by_resresv(status *policy, server_info *sinfo, resource_resv
 	/* rset->req may be NULL if the intersection of resresv->resreq and policy->equiv_class_resdef is the NULL set */
 	rset->req = dup_selective_resource_req_list(resresv->resreq, policy->equiv_class_resdef);
 
+	/* a set without a key is simply never looked up in the verdict cache */
+	rset->verdict_key = create_resresv_set_verdict_key(rset);
+
 	return rset;
 }
 
@@ -2500,6 +3383,108 @@ create_resresv_sets(status *policy, server_info *sinfo)
 	return rsets;
 }
 
+/*
+ * limit verdicts of equivalence classes, kept across cycles.  Keyed by
+ * resresv_set::verdict_key, the value is the verdict's generation and error.
+ */
+static std::unordered_map<std::string, std::pair<std::size_t, schd_error *>> ec_verdicts;
+
+/**
+ * @brief can the limit verdict cache be used for a server?
+ *	The verdict of check_limits() only depends on the limits generation
+ *	of the server while there are no run events in its calendar.  When
+ *	there are, the verdict also depends on a job's walltime and when
+ *	the run events happen.  A qrun overrides the limits altogether.
+ *
+ * @param[in] sinfo - the server
+ *
+ * @return int
+ * @retval 1 the cache can be used
+ * @retval 0 it can not
+ */
+static int
+can_use_ec_verdicts(server_info *sinfo)
+{
+	if (sinfo == NULL || sinfo->qrun_job != NULL)
+		return 0;
+
+	if (sinfo->calendar != NULL && sinfo->calendar->first_run_event != NULL)
+		return 0;
+
+	return 1;
+}
+
+/**
+ * @brief find the cached limit verdict of an equivalence class
+ *
+ * @param[in] sinfo - the server the class's jobs would run on
+ * @param[in] rset - the equivalence class
+ *
+ * @return schd_error *
+ * @retval the reason the class exceeds a hard limit (do not free)
+ * @retval NULL no verdict is cached for the current limits generation
+ */
+schd_error *
+find_ec_verdict(server_info *sinfo, resresv_set *rset)
+{
+	if (rset == NULL || rset->verdict_key == NULL || !can_use_ec_verdicts(sinfo))
+		return NULL;
+
+	auto it = ec_verdicts.find(rset->verdict_key);
+	if (it == ec_verdicts.end() || it->second.first != sinfo->limits_gen)
+		return NULL;
+
+	return it->second.second;
+}
+
+/**
+ * @brief cache the limit verdict of an equivalence class for the current
+ *	limits generation of a server
+ *
+ * @param[in] sinfo - the server the class's jobs would run on
+ * @param[in] rset - the equivalence class
+ * @param[in] err - the reason the class exceeds a hard limit (copied)
+ *
+ * @return void
+ */
+void
+add_ec_verdict(server_info *sinfo, resresv_set *rset, schd_error *err)
+{
+	schd_error *verdict;
+
+	if (rset == NULL || rset->verdict_key == NULL || err == NULL || !can_use_ec_verdicts(sinfo))
+		return;
+
+	verdict = dup_schd_error(err);
+	if (verdict == NULL)
+		return;
+
+	auto &entry = ec_verdicts[rset->verdict_key];
+	free_schd_error(entry.second);
+	entry.first = sinfo->limits_gen;
+	entry.second = verdict;
+}
+
+/**
+ * @brief drop the cached limit verdicts that are not of the current
+ *	limits generation of a server.  Called once the server is queried.
+ *
+ * @param[in] sinfo - the newly queried server
+ *
+ * @return void
+ */
+void
+prune_ec_verdicts(server_info *sinfo)
+{
+	for (auto it = ec_verdicts.begin(); it != ec_verdicts.end();) {
+		if (sinfo == NULL || it->second.first != sinfo->limits_gen) {
+			free_schd_error(it->second.second);
+			it = ec_verdicts.erase(it);
+		} else
+			++it;
+	}
+}
+
 /**
  * @brief
  * 		job_info copy constructor
@@ -2921,6 +3906,194 @@ find_and_preempt_jobs(status *policy, int pbs_sd, resource_resv *hjob, server_in
 	return rc;
 }
 
+/**
+ * @brief
+ *		check the job level criteria for a running job to be a
+ *		preemption candidate for a high priority job.  Nothing checked
+ *		here changes while preemption is being simulated.
+ *
+ * @param[in] hjob - the high priority job to preempt for
+ * @param[in] rjob - the running job to check
+ * @param[in] fail_list - list of jobs which previously failed to be preempted
+ *
+ * @return bool
+ * @retval true rjob may be preempted for hjob
+ * @retval false rjob can not be preempted for hjob
+ */
+static bool
+is_preempt_candidate(resource_resv *hjob, resource_resv *rjob, int *fail_list)
+{
+	int j;
+	struct preempt_ordering *po;
+
+	if (rjob->job == NULL || rjob->ninfo_arr == NULL)
+		return false; /* we have problems... */
+
+	/* Only running jobs have resources allocated to them.
+	 * They are only eligible to preempt.
+	 */
+	if (!rjob->job->is_running)
+		return false;
+
+	if (rjob->job->is_provisioning)
+		return false; /* provisioning job cannot be preempted */
+
+	if (rjob->job->can_not_preempt || rjob->job->preempt >= hjob->job->preempt)
+		return false;
+
+	for (j = 0; fail_list[j] != 0; j++) {
+		if (fail_list[j] == rjob->rank)
+			return false;
+	}
+
+	/* get the preemption order to be used for this job */
+	po = schd_get_preempt_order(rjob);
+
+	/* check whether chosen order is enabled for this job */
+	for (j = 0; j < PREEMPT_METHOD_HIGH; j++) {
+		if (po->order[j] == PREEMPT_METHOD_SUSPEND &&
+		    rjob->job->can_suspend)
+			break; /* suspension is always allowed */
+
+		if (po->order[j] == PREEMPT_METHOD_CHECKPOINT &&
+		    rjob->job->can_checkpoint)
+			break; /* choose if checkpoint is allowed */
+
+		if (po->order[j] == PREEMPT_METHOD_REQUEUE &&
+		    rjob->job->can_requeue)
+			break; /* choose if requeue is allowed */
+		if (po->order[j] == PREEMPT_METHOD_DELETE)
+			break;
+	}
+	if (j == PREEMPT_METHOD_HIGH) /* no preemption method good */
+		return false;
+
+	for (j = 0; rjob->ninfo_arr[j] != NULL; j++) {
+		if (rjob->ninfo_arr[j]->is_down || rjob->ninfo_arr[j]->is_offline)
+			return false;
+	}
+
+	/* if the high priority job is suspended then make sure we only
+	 * select jobs from the node the job is currently suspended on
+	 */
+	if (hjob->ninfo_arr != NULL) {
+		for (j = 0; hjob->ninfo_arr[j] != NULL; j++) {
+			if (find_node_by_rank(rjob->ninfo_arr, hjob->ninfo_arr[j]->rank) != NULL)
+				break;
+		}
+
+		/* if we made all the way through the list, then rjob has no useful
+		 * nodes for us to use... don't select it, unless it's not node resources we're after
+		 */
+		if (hjob->ninfo_arr[j] == NULL)
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief
+ *		check if a node could ever satisfy a chunk of a high priority job.
+ *		The check is against the node's total resources, so the answer
+ *		does not change while preemption is being simulated.
+ *
+ * @param[in] policy - policy info
+ * @param[in] hjob - the high priority job to preempt for
+ * @param[in] node - the node to check
+ * @param[in] err - scratch error structure
+ *
+ * @return bool
+ * @retval true node can satisfy at least one chunk of hjob
+ * @retval false node is of no use to hjob
+ */
+static bool
+is_preempt_node_useful(status *policy, resource_resv *hjob, node_info *node, schd_error *err)
+{
+	bool only_check_noncons = false;
+
+	if (node->is_multivnoded) {
+		/* unsafe to consider vnodes from multivnoded hosts "no good" when "not enough" of some consumable
+		 * resource can be found in the vnode, since rest may be provided by other vnodes on the same host
+		 * restrict check on these vnodes to check only against non consumable resources
+		 */
+		if (policy->resdef_to_check_noncons.empty()) {
+			for (const auto &rtc : policy->resdef_to_check) {
+				if (rtc->type.is_non_consumable)
+					policy->resdef_to_check_noncons.insert(rtc);
+			}
+		}
+		only_check_noncons = true;
+	}
+	for (int k = 0; hjob->select->chunks[k] != NULL; k++) {
+		long num_chunks_returned = 0;
+		unsigned int flags = COMPARE_TOTAL | CHECK_ALL_BOOLS | UNSET_RES_ZERO;
+		/* if only non consumables are checked, infinite number of chunks can be satisfied,
+		 * and SCHD_INFINITY is negative, so don't be tempted to check on positive value
+		 */
+		clear_schd_error(err);
+		if (only_check_noncons) {
+			if (!policy->resdef_to_check_noncons.empty())
+				num_chunks_returned = check_avail_resources(node->res, hjob->select->chunks[k]->req,
+									    flags, policy->resdef_to_check_noncons, INSUFFICIENT_RESOURCE, err);
+			else
+				num_chunks_returned = SCHD_INFINITY;
+		} else
+			num_chunks_returned = check_avail_resources(node->res, hjob->select->chunks[k]->req,
+								    flags, INSUFFICIENT_RESOURCE, err);
+
+		if ((num_chunks_returned > 0) || (num_chunks_returned == SCHD_INFINITY))
+			return true;
+	}
+	return false;
+}
+
+/**
+ * @brief
+ *		check if a running job holds any node a high priority job could use.
+ *		Answers are remembered per node in node_useful so each node is
+ *		only checked once per high priority job.
+ *
+ * @param[in] policy - policy info
+ * @param[in] hjob - the high priority job to preempt for
+ * @param[in] rjob - the running job to check
+ * @param[in,out] node_useful - per node_ind cache: -1 unknown, 0 no, 1 yes
+ *
+ * @return int
+ * @retval 1 rjob is on a node hjob could use
+ * @retval 0 rjob is on no node hjob could use
+ * @retval -1 error
+ */
+static int
+preempt_job_has_useful_node(status *policy, resource_resv *hjob, resource_resv *rjob,
+			    std::vector<signed char> &node_useful)
+{
+	schd_error *err = NULL;
+	int rc = 0;
+
+	for (int j = 0; rjob->ninfo_arr[j] != NULL && rc == 0; j++) {
+		node_info *node = rjob->ninfo_arr[j];
+		int ind = node->node_ind;
+		bool cached = ind >= 0 && static_cast<size_t>(ind) < node_useful.size();
+
+		if (cached && node_useful[ind] != -1) {
+			rc = node_useful[ind];
+			continue;
+		}
+		if (err == NULL) {
+			err = new_schd_error();
+			if (err == NULL)
+				return -1;
+		}
+		rc = is_preempt_node_useful(policy, hjob, node, err) ? 1 : 0;
+		if (cached)
+			node_useful[ind] = rc;
+	}
+	free_schd_error(err);
+
+	return rc;
+}
+
 /**
  * @brief
  * 		find jobs to preempt in order to run a high priority job.
@@ -3018,6 +4191,22 @@ find_jobs_to_preempt(status *policy, resource_resv *hjob, server_info *sinfo, in
 	log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB, LOG_DEBUG, hjob->name,
 		  "Employing preemption to try and run high priority job.");
 
+	/* Before paying for a simulated universe, make sure some running job
+	 * could be preempted for hjob at all.  Whether a node is of use to hjob
+	 * is checked against its totals, so the answers carry over to the
+	 * duplicated universe where node indices are the same.
+	 */
+	std::vector<signed char> node_useful(sinfo->num_nodes, -1);
+	for (i = 0; sinfo->running_jobs[i] != NULL; i++) {
+		if (is_preempt_candidate(hjob, sinfo->running_jobs[i], fail_list) &&
+		    preempt_job_has_useful_node(policy, hjob, sinfo->running_jobs[i], node_useful) != 0)
+			break;
+	}
+	if (sinfo->running_jobs[i] == NULL) {
+		log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB, LOG_INFO, hjob->name, "Found no preemptable candidates");
+		return NULL;
+	}
+
 	/* Let's get all the reasons the job won't run now.
 	 * This will help us find the set of jobs to preempt
 	 */
@@ -3156,7 +4345,7 @@ find_jobs_to_preempt(status *policy, resource_resv *hjob, server_info *sinfo, in
 	}
 
 	skipto = 0;
-	while ((indexfound = select_index_to_preempt(npolicy, nhjob, rjobs_subset, skipto, err, fail_list)) != NO_JOB_FOUND) {
+	while ((indexfound = select_index_to_preempt(npolicy, nhjob, rjobs_subset, skipto, err, fail_list, node_useful)) != NO_JOB_FOUND) {
 		struct preempt_ordering *po;
 		int dont_preempt_job = 0;
 		int ind = 0;
@@ -3368,6 +4557,8 @@ cleanup:
  * @param[in] err    - reason the high prio job isn't running
  * @param[in] fail_list - list of jobs to skip. They previously failed to be preempted.
  *			  Do not select them again.
+ * @param[in,out] node_useful - per node_ind cache of whether a node can be
+ *				used by hjob.  Entries are -1 if not yet known.
  *
  * @return long
  * @retval index of the job to preempt
@@ -3377,11 +4568,9 @@ cleanup:
 long
 select_index_to_preempt(status *policy, resource_resv *hjob,
 			resource_resv **rjobs, long skipto, schd_error *err,
-			int *fail_list)
+			int *fail_list, std::vector<signed char> &node_useful)
 {
-	int i, j, k;
-	int good = 1; /* good boolean: Is job eligible to be preempted */
-	struct preempt_ordering *po;
+	int i;
 
 	if (err == NULL || hjob == NULL || hjob->job == NULL ||
 	    rjobs == NULL || rjobs[0] == NULL)
@@ -3391,160 +4580,20 @@ select_index_to_preempt(status *policy, resource_resv *hjob,
 	if (hjob->job->is_running && hjob->ninfo_arr == NULL)
 		return NO_JOB_FOUND;
 
-	/* if we find a good job, we'll break out at the bottom
-	 * we can't break out up here since i will be incremented by this point
-	 * and we'll be returning the job AFTER the one we want too
-	 */
 	for (i = skipto; rjobs[i] != NULL; i++) {
-		/* Does the running job have any resource we need? */
-		int node_good = 1;
-
-		/* lets be optimistic.. we'll start off assuming this is a good candidate */
-		good = 1;
-
-		/* if hjob hit a hard limit, check if candidate job has requested that resource
-		 * if reason is different then set flag as if resource was found
-		 */
-
-		if (rjobs[i]->job == NULL || rjobs[i]->ninfo_arr == NULL)
-			continue; /* we have problems... */
-
-		if (!rjobs[i]->job->is_running)
-			/* Only running jobs have resources allocated to them.
-			 * They are only eligible to preempt.
-			 */
-			good = 0;
-
-		if (rjobs[i]->job->is_provisioning)
-			good = 0; /* provisioning job cannot be preempted */
-
-		if (good) {
-			if (rjobs[i]->job->can_not_preempt ||
-			    rjobs[i]->job->preempt >= hjob->job->preempt)
-				good = 0;
-		}
-
-		if (good) {
-			for (j = 0; fail_list[j] != 0; j++) {
-				if (fail_list[j] == rjobs[i]->rank) {
-					good = 0;
-					break;
-				}
-			}
-		}
-
-		if (good) {
-			/* get the preemption order to be used for this job */
-			po = schd_get_preempt_order(rjobs[i]);
-
-			/* check whether chosen order is enabled for this job */
-			for (j = 0; j < PREEMPT_METHOD_HIGH; j++) {
-				if (po->order[j] == PREEMPT_METHOD_SUSPEND &&
-				    rjobs[i]->job->can_suspend)
-					break; /* suspension is always allowed */
-
-				if (po->order[j] == PREEMPT_METHOD_CHECKPOINT &&
-				    rjobs[i]->job->can_checkpoint)
-					break; /* choose if checkpoint is allowed */
-
-				if (po->order[j] == PREEMPT_METHOD_REQUEUE &&
-				    rjobs[i]->job->can_requeue)
-					break; /* choose if requeue is allowed */
-				if (po->order[j] == PREEMPT_METHOD_DELETE)
-					break;
-			}
-			if (j == PREEMPT_METHOD_HIGH) /* no preemption method good */
-				good = 0;
-		}
-
-		if (good) {
-			for (j = 0; good && rjobs[i]->ninfo_arr[j] != NULL; j++) {
-				if (rjobs[i]->ninfo_arr[j]->is_down || rjobs[i]->ninfo_arr[j]->is_offline)
-					good = 0;
-			}
-		}
-
-		/* if the high priority job is suspended then make sure we only
-		 * select jobs from the node the job is currently suspended on
-		 */
-
-		if (good) {
-			if (hjob->ninfo_arr != NULL) {
-				for (j = 0; hjob->ninfo_arr[j] != NULL; j++) {
-					if (find_node_by_rank(rjobs[i]->ninfo_arr,
-							      hjob->ninfo_arr[j]->rank) != NULL)
-						break;
-				}
-
-				/* if we made all the way through the list, then rjobs[i] has no useful
-				 * nodes for us to use... don't select it, unless it's not node resources we're after
-				 */
-
-				if (hjob->ninfo_arr[j] == NULL)
-					good = 0;
-			}
-		}
-		if (good) {
-			schd_error *err;
-			node_good = 0;
-
-			err = new_schd_error();
-			if (err == NULL)
-				return NO_JOB_FOUND;
-
-			for (j = 0; rjobs[i]->ninfo_arr[j] != NULL && !node_good; j++) {
-				node_info *node = rjobs[i]->ninfo_arr[j];
-				bool only_check_noncons = false;
-
-				if (node->is_multivnoded) {
-					/* unsafe to consider vnodes from multivnoded hosts "no good" when "not enough" of some consumable
-					 * resource can be found in the vnode, since rest may be provided by other vnodes on the same host
-					 * restrict check on these vnodes to check only against non consumable resources
-					 */
-					if (policy->resdef_to_check_noncons.empty()) {
-						for (const auto &rtc : policy->resdef_to_check) {
-							if (rtc->type.is_non_consumable)
-								policy->resdef_to_check_noncons.insert(rtc);
-						}
-					}
-					only_check_noncons = true;
-				}
-				for (k = 0; hjob->select->chunks[k] != NULL; k++) {
-					long num_chunks_returned = 0;
-					unsigned int flags = COMPARE_TOTAL | CHECK_ALL_BOOLS | UNSET_RES_ZERO;
-					/* if only non consumables are checked, infinite number of chunks can be satisfied,
-					 * and SCHD_INFINITY is negative, so don't be tempted to check on positive value
-					 */
-					clear_schd_error(err);
-					if (only_check_noncons) {
-						if (!policy->resdef_to_check_noncons.empty())
-							num_chunks_returned = check_avail_resources(node->res, hjob->select->chunks[k]->req,
-												    flags, policy->resdef_to_check_noncons, INSUFFICIENT_RESOURCE, err);
-						else
-							num_chunks_returned = SCHD_INFINITY;
-					} else
-						num_chunks_returned = check_avail_resources(node->res, hjob->select->chunks[k]->req,
-											    flags, INSUFFICIENT_RESOURCE, err);
-
-					if ((num_chunks_returned > 0) || (num_chunks_returned == SCHD_INFINITY)) {
-						node_good = 1;
-						break;
-					}
-				}
-			}
-			free_schd_error(err);
-		}
+		int rc;
 
-		if (node_good == 0)
-			good = 0;
+		if (!is_preempt_candidate(hjob, rjobs[i], fail_list))
+			continue;
 
-		if (good)
-			break;
+		/* Does the running job have any resource we need? */
+		rc = preempt_job_has_useful_node(policy, hjob, rjobs[i], node_useful);
+		if (rc == -1)
+			return NO_JOB_FOUND;
+		if (rc == 1)
+			return i;
 	}
 
-	if (good && rjobs[i] != NULL)
-		return i;
-
 	return NO_JOB_FOUND;
 }
 
@@ -3955,8 +5004,7 @@ queue_subjob(resource_resv *array, server_info *sinfo,
 
 /**
  * @brief
- * 		evaluate a math formula for jobs based on their resources
- *		NOTE: currently done through embedded python interpreter
+ * 		evaluate a math formula for jobs through the embedded python interpreter
  *
  * @param[in]	formula	-	formula to evaluate
  * @param[in]	resresv	-	job for special case key words
@@ -3967,8 +5015,8 @@ queue_subjob(resource_resv *array, server_info *sinfo,
  */
 
 #ifdef PYTHON
-sch_resource_t
-formula_evaluate(const char *formula, resource_resv *resresv, resource_req *resreq)
+static sch_resource_t
+formula_evaluate_python(const char *formula, resource_resv *resresv, resource_req *resreq)
 {
 	char buf[1024];
 	char *globals;
@@ -4080,13 +5128,42 @@ formula_evaluate(const char *formula, resource_resv *resresv, resource_req *resr
 	return ans;
 }
 #else
-sch_resource_t
-formula_evaluate(char *formula, resource_resv *resresv, resource_req *resreq)
+static sch_resource_t
+formula_evaluate_python(const char *formula, resource_resv *resresv, resource_req *resreq)
 {
 	return 0;
 }
 #endif
 
+/**
+ * @brief
+ * 		evaluate a math formula for jobs based on their resources
+ *		The formula is compiled once and evaluated natively.  The
+ *		embedded python interpreter is only used for formulas (or
+ *		values) the compiler can't handle.
+ *
+ * @param[in]	formula	-	formula to evaluate
+ * @param[in]	resresv	-	job for special case key words
+ * @param[in]	resreq	-	resources to use when evaluating
+ *
+ * @return	evaluated formula answer or 0 on exception
+ *
+ */
+sch_resource_t
+formula_evaluate(const char *formula, resource_resv *resresv, resource_req *resreq)
+{
+	sch_resource_t ans = 0;
+
+	if (formula == NULL || resresv == NULL ||
+	    resresv->job == NULL)
+		return 0;
+
+	if (eval_compiled_formula(find_compiled_formula(formula), resresv, resreq, &ans))
+		return ans;
+
+	return formula_evaluate_python(formula, resresv, resreq);
+}
+
 /**
  * @brief
  * 		Set the job accrue type to eligible time.
@@ -4614,7 +5691,7 @@ create_res_released(status *policy, resource_resv *pjob)
 		pjob->job->resreq_rel = create_resreq_rel_list(policy, pjob);
 	}
 	selectspec = create_select_from_nspec(pjob->job->resreleased);
-	delete pjob->execselect;
+	free_selspec(pjob->execselect);
 	pjob->execselect = parse_selspec(selectspec);
 	return;
 }
@@ -54,7 +54,7 @@ resource_resv *query_job(int pbs_sd, struct batch_status *job, server_info *sinf
 void query_jobs_chunk(th_data_query_jinfo *data);
 
 /* create an array of jobs for a particular queue */
-resource_resv **query_jobs(status *policy, int pbs_sd, queue_info *qinfo, resource_resv **pjobs, const std::string &queue_name);
+resource_resv **query_jobs(status *policy, int pbs_sd, queue_info *qinfo, resource_resv **pjobs, const std::string &queue_name, const peer_queue *peer);
 
 /*
  *	new_job_info  - allocate and initialize new job_info structure
@@ -94,6 +94,21 @@ int send_sigjob(int virtual_sd, resource_resv *resresv, const char *signal, char
 
 struct batch_status *send_selstat(int virtual_fd, struct attropl *attrib, struct attrl *rattrib, char *extend);
 
+int send_selstat_stream(int virtual_fd, struct attropl *attrib, struct attrl *rattrib, char *extend, pbs_status_cb cb, void *arg);
+
+char **send_selectjob(int virtual_fd, struct attropl *attrib, char *extend);
+
+struct batch_status *send_statjob(int virtual_fd, char *id, struct attrl *attrib, char *extend);
+
+/* drop the queued job status cache used by incremental_job_query */
+void clear_queued_job_cache();
+
+/* save the queued job cache to disk (at most every QJOB_CACHE_PERIOD unless forced) */
+void checkpoint_queued_job_cache(bool force);
+
+/* load the queued job cache saved by checkpoint_queued_job_cache() */
+void restore_queued_job_cache();
+
 /*
  *
  *      unset_job_attr - unset job attributes on the server
@@ -167,7 +182,7 @@ find_jobs_to_preempt(status *policy, resource_resv *hjob,
 long
 select_index_to_preempt(status *policy, resource_resv *hjob,
 			resource_resv **rjobs, long skipto, schd_error *err,
-			int *fail_list);
+			int *fail_list, std::vector<signed char> &node_useful);
 
 /*
  *      preempt_level - take a preemption priority and return a preemption
@@ -244,7 +259,8 @@ queue_subjob(resource_resv *array, server_info *sinfo,
 	     queue_info *qinfo);
 /*
  *	formula_evaluate - evaluate a math formula for jobs based on their resources
- *		NOTE: currently done through embedded python interpreter
+ *		NOTE: falls back to the embedded python interpreter for formulas
+ *		      which can't be compiled
  */
 
 sch_resource_t formula_evaluate(const char *formula, resource_resv *resresv, resource_req *resreq);
@@ -358,6 +374,15 @@ std::unordered_set<resdef *> create_resresv_sets_resdef(status *policy);
 
 /* Create an array of resresv_sets based on sinfo*/
 resresv_set **create_resresv_sets(status *policy, server_info *sinfo);
+
+/* find the cached limit verdict of an equivalence class */
+schd_error *find_ec_verdict(server_info *sinfo, resresv_set *rset);
+
+/* cache the limit verdict of an equivalence class */
+void add_ec_verdict(server_info *sinfo, resresv_set *rset, schd_error *err);
+
+/* drop cached limit verdicts that are not of the server's limits generation */
+void prune_ec_verdicts(server_info *sinfo);
 /*
  * This function creates a string and update resources_released job
  *  attribute.
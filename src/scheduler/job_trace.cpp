@@ -0,0 +1,294 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file    job_trace.cpp
+ *
+ * @brief
+ * 		job_trace.cpp - This file contains functions to trace the path
+ *		of sampled jobs through the main scheduling loop.
+ *
+ *		When the job_trace_sample or job_trace_jobs sched_config options
+ *		are set, every Nth job considered, or the listed jobs, have each
+ *		step of their evaluation timed in microseconds: is_ok_to_run,
+ *		check_limits, check_nodes (bucket or normal node path), each
+ *		placement set tried, the calendar, preemption and the run request.
+ *		The steps are written to JOB_TRACE_FILE in sched_priv in the
+ *		Trace Event Format, which chrome://tracing and Perfetto load
+ *		directly.  Untraced jobs pay one flag check per step.
+ *
+ * Functions included are:
+ * 	trace_span::begin()
+ * 	trace_span::end()
+ * 	job_trace_job_begin()
+ * 	job_trace_job_end()
+ * 	job_trace_cycle_end()
+ *
+ */
+
+#include <pbs_config.h>
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+#include <log.h>
+
+#include "config.h"
+#include "constant.h"
+#include "data_types.h"
+#include "globals.h"
+#include "job_trace.h"
+
+bool job_trace_on = false;
+
+static struct {
+	std::string name;	/* job being traced */
+	long long start;	/* when its evaluation started, usec */
+	bool use_buckets;	/* took the node bucket path */
+	long considered;	/* jobs considered, for sampling */
+} jtrace;
+
+/* events of the cycle not yet written out.  Spans may end on worker threads */
+static std::string trace_buf;
+static std::mutex trace_lock;
+
+/* small thread ids for the trace viewer, the main loop's thread is 1 */
+static std::atomic<int> next_tid(1);
+static thread_local int trace_tid = 0;
+
+/**
+ * @brief	wall clock time in microseconds
+ */
+static long long
+now_usec()
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return static_cast<long long>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+/**
+ * @brief	append a string to a std::string as a JSON string
+ */
+static void
+json_append_str(std::string &str, const char *s)
+{
+	str += '"';
+	for (; *s != '\0'; s++) {
+		if (*s == '"' || *s == '\\')
+			str += '\\';
+		if (static_cast<unsigned char>(*s) >= ' ')
+			str += *s;
+	}
+	str += '"';
+}
+
+/**
+ * @brief	append a printf style string to a std::string
+ */
+static void
+json_appendf(std::string &str, const char *fmt, ...)
+{
+	char buf[256];
+	va_list ap;
+
+	va_start(ap, fmt);
+	vsnprintf(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+	str += buf;
+}
+
+/**
+ * @brief	add one complete ("X") event to the trace buffer
+ *
+ * @param[in]	name	-	name of the step
+ * @param[in]	cat	-	category: "job" for the whole evaluation, else "step"
+ * @param[in]	start	-	start time in usec
+ * @param[in]	args	-	extra JSON members for the event's args
+ */
+static void
+add_event(const char *name, const char *cat, long long start, const std::string &args)
+{
+	std::string ev;
+
+	if (trace_tid == 0)
+		trace_tid = next_tid++;
+
+	ev = "{\"name\":";
+	json_append_str(ev, name);
+	json_appendf(ev, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":%d,\"tid\":%d,\"args\":{\"job\":",
+		     cat, start, now_usec() - start, static_cast<int>(getpid()), trace_tid);
+	json_append_str(ev, jtrace.name.c_str());
+	ev += args;
+	ev += "}},\n";
+
+	std::lock_guard<std::mutex> lk(trace_lock);
+	trace_buf += ev;
+}
+
+/**
+ * @brief	start timing a step of the traced job
+ */
+void
+trace_span::begin()
+{
+	entered = true;
+	start = now_usec();
+}
+
+/**
+ * @brief	add the step to the trace
+ */
+void
+trace_span::end()
+{
+	std::string args;
+
+	if (detail != NULL) {
+		args += ",\"detail\":";
+		json_append_str(args, detail);
+	}
+	if (has_result)
+		json_appendf(args, ",\"result\":%d", result);
+	add_event(name, "step", start, args);
+}
+
+/**
+ * @brief	decide whether to trace a job the main loop is about to
+ *		evaluate, and if so start its trace
+ *
+ * @param[in]	resresv	-	the job
+ * @param[in]	use_buckets	-	the job will take the node bucket path
+ *
+ * @return	void
+ */
+void
+job_trace_job_begin(resource_resv *resresv, bool use_buckets)
+{
+	bool sampled = false;
+
+	job_trace_on = false;
+	if (conf.job_trace_sample <= 0 && conf.job_trace_jobs.empty())
+		return;
+
+	jtrace.considered++;
+	if (conf.job_trace_sample > 0 && jtrace.considered % conf.job_trace_sample == 0)
+		sampled = true;
+	else if (conf.job_trace_jobs.find(resresv->name) != conf.job_trace_jobs.end())
+		sampled = true;
+	if (!sampled)
+		return;
+
+	if (trace_tid == 0)
+		trace_tid = next_tid++;
+	jtrace.name = resresv->name;
+	jtrace.use_buckets = use_buckets;
+	jtrace.start = now_usec();
+	job_trace_on = true;
+}
+
+/**
+ * @brief	finish the trace of the current job with its outcome
+ *
+ * @param[in]	rc	-	SUCCESS if the job ran, else the main loop's rc
+ * @param[in]	err	-	why the job could not run
+ *
+ * @return	void
+ */
+void
+job_trace_job_end(int rc, schd_error *err)
+{
+	std::string args;
+
+	if (!job_trace_on)
+		return;
+	job_trace_on = false;
+
+	json_appendf(args, ",\"rc\":%d,\"path\":\"%s\"", rc, jtrace.use_buckets ? "buckets" : "normal");
+	if (err != NULL && err->error_code != SUCCESS)
+		json_appendf(args, ",\"status\":%d,\"error_code\":%d", err->status_code, err->error_code);
+	add_event(jtrace.name.c_str(), "job", jtrace.start, args);
+}
+
+/**
+ * @brief	append the traces of the cycle to JOB_TRACE_FILE
+ *
+ * @par	The file is in the JSON array form of the Trace Event Format, which
+ *	allows the closing ']' to be left off, so cycles are simply appended.
+ *	It is moved aside to JOB_TRACE_FILE.old once it reaches
+ *	JOB_TRACE_MAX_SIZE.
+ *
+ * @return	void
+ */
+void
+job_trace_cycle_end()
+{
+	struct stat sb;
+	FILE *fp;
+	bool fresh;
+
+	job_trace_on = false;
+	if (trace_buf.empty())
+		return;
+
+	if (stat(JOB_TRACE_FILE, &sb) == 0 && sb.st_size >= JOB_TRACE_MAX_SIZE)
+		rename(JOB_TRACE_FILE, JOB_TRACE_FILE ".old");
+	fresh = stat(JOB_TRACE_FILE, &sb) != 0 || sb.st_size == 0;
+
+	if ((fp = fopen(JOB_TRACE_FILE, "a")) != NULL) {
+		if (fresh)
+			fputs("[\n", fp);
+		fputs(trace_buf.c_str(), fp);
+		fclose(fp);
+	} else
+		log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__,
+			   "Can not open %s to write the job trace", JOB_TRACE_FILE);
+	trace_buf.clear();
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+#ifndef _JOB_TRACE_H
+#define _JOB_TRACE_H
+
+#include "data_types.h"
+
+/* is the job the main loop is looking at being traced? */
+extern bool job_trace_on;
+
+/*
+ *	trace_span - records the time it is in scope as one step of the
+ *		     traced job's path through the scheduler.  Does nothing
+ *		     when the job is not being traced.
+ */
+class trace_span
+{
+	const char *name;
+	const char *detail; /* e.g. the placement set, must outlive the span */
+	long long start;
+	int result;
+	bool entered;
+	bool has_result;
+	void begin();
+	void end();
+
+public:
+	explicit trace_span(const char *n, const char *d = NULL) : name(n), detail(d), start(0), result(0), entered(false), has_result(false)
+	{
+		if (job_trace_on)
+			begin();
+	}
+	~trace_span()
+	{
+		if (entered)
+			end();
+	}
+	/* record the outcome of the step, e.g. a sched_error_code */
+	void set_result(int r)
+	{
+		result = r;
+		has_result = true;
+	}
+	trace_span(const trace_span &) = delete;
+	trace_span &operator=(const trace_span &) = delete;
+};
+
+/*
+ *	job_trace_job_begin - start tracing a job if it is sampled
+ *			      (see job_trace_sample and job_trace_jobs)
+ */
+void job_trace_job_begin(resource_resv *resresv, bool use_buckets);
+
+/*
+ *	job_trace_job_end - finish the trace of the current job
+ */
+void job_trace_job_end(int rc, schd_error *err);
+
+/*
+ *	job_trace_cycle_end - append the traces of the cycle to JOB_TRACE_FILE
+ */
+void job_trace_cycle_end();
+
+#endif /* _JOB_TRACE_H */
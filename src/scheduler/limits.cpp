@@ -53,6 +53,8 @@
  * 	lim_setlimits()
  * 	has_hardlimits()
  * 	has_softlimits()
+ * 	lim_hash_hardlimits()
+ * 	lim_hash_running()
  * 	check_limits()
  * 	check_soft_limits()
  * 	check_server_max_user_run()
@@ -89,9 +91,10 @@
  * 	lim_setoldlimits()
  * 	lim_dup_ctx()
  * 	is_hardlimit()
- * 	lim_gengroupreskey()
- * 	lim_genprojectreskey()
- * 	lim_genuserreskey()
+ * 	lim_remember_limres()
+ * 	lim_get_generic()
+ * 	lim_get_entity()
+ * 	lim_mk_value()
  * 	lim_callback()
  * 	lim_get()
  * 	schderr_args_q()
@@ -116,6 +119,10 @@
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
+#include <stddef.h>
+#include <functional>
+#include <string>
+#include <vector>
 #include "pbs_config.h"
 #include "pbs_ifl.h"
 #include "data_types.h"
@@ -369,9 +376,10 @@ static int
 lim_callback(void *, enum lim_keytypes, char *, char *,
 	     char *, char *);
 static void *lim_dup_ctx(void *);
-static char *lim_gengroupreskey(const char *);
-static char *lim_genprojectreskey(const char *);
-static char *lim_genuserreskey(const char *);
+static void lim_remember_limres(const char *);
+static sch_resource_t lim_get_generic(enum lim_keytypes, schd_resource *, void *);
+static sch_resource_t lim_get_entity(enum lim_keytypes, const char *, const char *, void *);
+static struct lim_value *lim_mk_value(const char *);
 static void schderr_args_q(const std::string &, const char *, schd_error *);
 static void schderr_args_q(const std::string &, const std::string &, schd_error *);
 static void schderr_args_q_res(const std::string &, const char *, char *, schd_error *);
@@ -379,7 +387,7 @@ static void schderr_args_q_res(const std::string &, const std::string &, char *,
 static void schderr_args_server(const char *, schd_error *);
 static void schderr_args_server(const std::string &, schd_error *);
 static void schderr_args_server_res(std::string &, const char *, schd_error *);
-static sch_resource_t lim_get(const char *, void *);
+static sch_resource_t lim_get(const entlim_key_t *, void *);
 static int lim_setoldlimits(const struct attrl *, void *);
 static int lim_setreslimits(const struct attrl *, void *);
 static int lim_setrunlimits(const struct attrl *, void *);
@@ -421,6 +429,22 @@ struct limit_info {
  *		issue.
  */
 static schd_resource *limres; /* list of resources that have limits */
+
+/* entlim name ids of the resources in limres, by resdef index */
+static std::vector<int> limres_ids;
+
+/**
+ * @struct	lim_value
+ * @brief
+ * 		a limit value as stored in a limit storage context.  The value is
+ * 		converted to a number once, when the limit is set, rather than
+ * 		each time it is fetched.  It is allocated as one block so the
+ * 		contexts can still be freed with free().
+ */
+struct lim_value {
+	sch_resource_t num; /* the value converted by res_to_num() */
+	char str[1];	    /* the value as the limit was set */
+};
 /**
  * @brief
  * 		We currently store both resource and run limits in a
@@ -690,6 +714,76 @@ has_hardlimits(void *p)
 
 	return (0);
 }
+/**
+ * @brief
+ * 		hash the hard limits of a limit info structure.  The limit
+ * 		contexts are walked in key order, so equal limits hash equally.
+ *
+ * @param[in]	p	-	limit info structure to hash
+ *
+ * @return	std::size_t
+ * @retval	hash of the hard limit keys and values
+ * @retval	0	: no limit info or no hard limits
+ */
+std::size_t
+lim_hash_hardlimits(void *p)
+{
+	struct limit_info *lip = static_cast<limit_info *>(p);
+	std::hash<std::string> hash_str;
+	std::size_t h = 0;
+	char *k = NULL;
+	struct lim_value *v;
+
+	if (lip == NULL)
+		return 0;
+
+	while ((v = static_cast<lim_value *>(entlim_get_next(LI2RESCTX(lip), (void **) &k))) != NULL)
+		h = (h * 31 + hash_str(k)) * 31 + hash_str(v->str);
+
+	/* run limits are stored in the same context */
+	if (LI2RUNCTX(lip) == LI2RESCTX(lip))
+		return h;
+
+	k = NULL;
+	while ((v = static_cast<lim_value *>(entlim_get_next(LI2RUNCTX(lip), (void **) &k))) != NULL)
+		h = (h * 31 + hash_str(k)) * 31 + hash_str(v->str);
+
+	return h;
+}
+
+/**
+ * @brief
+ * 		hash the contribution of a running job to the limit counts.
+ * 		The hashes of all running jobs are summed by the caller, so the
+ * 		sum can be updated as jobs start and end.
+ *
+ * @param[in]	rr	-	the running job
+ *
+ * @return	std::size_t
+ * @retval	hash of the job's name, queue, user, group, project and resreq
+ */
+std::size_t
+lim_hash_running(resource_resv *rr)
+{
+	std::hash<std::string> hash_str;
+	std::hash<sch_resource_t> hash_num;
+	std::size_t h;
+
+	if (rr == NULL)
+		return 0;
+
+	h = hash_str(rr->name);
+	if (rr->job != NULL && rr->job->queue != NULL)
+		h = h * 31 + hash_str(rr->job->queue->name);
+	h = h * 31 + hash_str(rr->user);
+	h = h * 31 + hash_str(rr->group);
+	h = h * 31 + hash_str(rr->project);
+	for (auto req = rr->resreq; req != NULL; req = req->next)
+		h = (h * 31 + hash_str(req->name)) * 31 + hash_num(req->amount);
+
+	return h;
+}
+
 /**
  * @brief
  * 		check whether the limit info structure has at least one soft resource limit,
@@ -1142,7 +1236,6 @@ static int
 check_server_max_user_run(server_info *si, queue_info *qi, resource_resv *rr,
 			  limcounts *sc, limcounts *qc, schd_error *err)
 {
-	char *key;
 	std::string user;
 	int used;
 	int max_user_run, max_genuser_run;
@@ -1157,15 +1250,9 @@ check_server_max_user_run(server_info *si, queue_info *qi, resource_resv *rr,
 
 	auto &cts = sc->user;
 
-	if ((key = entlim_mk_runkey(LIM_USER, user.c_str())) == NULL)
-		return (SCHD_ERROR);
-	max_user_run = (int) lim_get(key, LI2RUNCTX(si->liminfo));
-	free(key);
+	max_user_run = (int) lim_get_entity(LIM_USER, user.c_str(), NULL, LI2RUNCTX(si->liminfo));
 
-	if ((key = entlim_mk_runkey(LIM_USER, genparam)) == NULL)
-		return (SCHD_ERROR);
-	max_genuser_run = (int) lim_get(key, LI2RUNCTX(si->liminfo));
-	free(key);
+	max_genuser_run = (int) lim_get_generic(LIM_USER, NULL, LI2RUNCTX(si->liminfo));
 
 	if ((max_user_run == SCHD_INFINITY) &&
 	    (max_genuser_run == SCHD_INFINITY))
@@ -1212,7 +1299,6 @@ static int
 check_server_max_group_run(server_info *si, queue_info *qi, resource_resv *rr,
 			   limcounts *sc, limcounts *qc, schd_error *err)
 {
-	char *key;
 	std::string group;
 	int used;
 	int max_group_run, max_gengroup_run;
@@ -1227,15 +1313,9 @@ check_server_max_group_run(server_info *si, queue_info *qi, resource_resv *rr,
 
 	auto &cts = sc->group;
 
-	if ((key = entlim_mk_runkey(LIM_GROUP, group.c_str())) == NULL)
-		return (SCHD_ERROR);
-	max_group_run = (int) lim_get(key, LI2RUNCTX(si->liminfo));
-	free(key);
+	max_group_run = (int) lim_get_entity(LIM_GROUP, group.c_str(), NULL, LI2RUNCTX(si->liminfo));
 
-	if ((key = entlim_mk_runkey(LIM_GROUP, genparam)) == NULL)
-		return (SCHD_ERROR);
-	max_gengroup_run = (int) lim_get(key, LI2RUNCTX(si->liminfo));
-	free(key);
+	max_gengroup_run = (int) lim_get_generic(LIM_GROUP, NULL, LI2RUNCTX(si->liminfo));
 
 	if ((max_group_run == SCHD_INFINITY) &&
 	    (max_gengroup_run == SCHD_INFINITY))
@@ -1392,7 +1472,6 @@ static int
 check_queue_max_user_run(server_info *si, queue_info *qi, resource_resv *rr,
 			 limcounts *sc, limcounts *qc, schd_error *err)
 {
-	char *key;
 	std::string user;
 	int used;
 	int max_user_run, max_genuser_run;
@@ -1407,15 +1486,9 @@ check_queue_max_user_run(server_info *si, queue_info *qi, resource_resv *rr,
 
 	auto &cts = qc->user;
 
-	if ((key = entlim_mk_runkey(LIM_USER, user.c_str())) == NULL)
-		return (SCHD_ERROR);
-	max_user_run = (int) lim_get(key, LI2RUNCTX(qi->liminfo));
-	free(key);
+	max_user_run = (int) lim_get_entity(LIM_USER, user.c_str(), NULL, LI2RUNCTX(qi->liminfo));
 
-	if ((key = entlim_mk_runkey(LIM_USER, genparam)) == NULL)
-		return (SCHD_ERROR);
-	max_genuser_run = (int) lim_get(key, LI2RUNCTX(qi->liminfo));
-	free(key);
+	max_genuser_run = (int) lim_get_generic(LIM_USER, NULL, LI2RUNCTX(qi->liminfo));
 
 	if ((max_user_run == SCHD_INFINITY) &&
 	    (max_genuser_run == SCHD_INFINITY))
@@ -1462,7 +1535,6 @@ static int
 check_queue_max_group_run(server_info *si, queue_info *qi, resource_resv *rr,
 			  limcounts *sc, limcounts *qc, schd_error *err)
 {
-	char *key;
 	std::string group;
 	int used;
 	int max_group_run, max_gengroup_run;
@@ -1477,15 +1549,9 @@ check_queue_max_group_run(server_info *si, queue_info *qi, resource_resv *rr,
 
 	auto &cts = qc->group;
 
-	if ((key = entlim_mk_runkey(LIM_GROUP, group.c_str())) == NULL)
-		return (SCHD_ERROR);
-	max_group_run = (int) lim_get(key, LI2RUNCTX(qi->liminfo));
-	free(key);
+	max_group_run = (int) lim_get_entity(LIM_GROUP, group.c_str(), NULL, LI2RUNCTX(qi->liminfo));
 
-	if ((key = entlim_mk_runkey(LIM_GROUP, genparam)) == NULL)
-		return (SCHD_ERROR);
-	max_gengroup_run = (int) lim_get(key, LI2RUNCTX(qi->liminfo));
-	free(key);
+	max_gengroup_run = (int) lim_get_generic(LIM_GROUP, NULL, LI2RUNCTX(qi->liminfo));
 
 	if ((max_group_run == SCHD_INFINITY) &&
 	    (max_gengroup_run == SCHD_INFINITY))
@@ -1645,7 +1711,6 @@ static int
 check_queue_max_res(server_info *si, queue_info *qi, resource_resv *rr,
 		    limcounts *sc, limcounts *qc, schd_error *err)
 {
-	char *reskey;
 	sch_resource_t max_res;
 	sch_resource_t used;
 	schd_resource *res;
@@ -1669,11 +1734,7 @@ check_queue_max_res(server_info *si, queue_info *qi, resource_resv *rr,
 		if ((req = find_resource_req(rr->resreq, res->def)) == NULL)
 			continue;
 
-		if ((reskey = entlim_mk_reskey(LIM_OVERALL, allparam,
-					       res->name)) == NULL)
-			return (SCHD_ERROR);
-		max_res = lim_get(reskey, LI2RESCTX(qi->liminfo));
-		free(reskey);
+		max_res = lim_get_generic(LIM_OVERALL, res, LI2RESCTX(qi->liminfo));
 
 		if (max_res == SCHD_INFINITY)
 			continue;
@@ -1718,7 +1779,6 @@ static int
 check_server_max_res(server_info *si, queue_info *qi, resource_resv *rr,
 		     limcounts *sc, limcounts *qc, schd_error *err)
 {
-	char *reskey;
 	sch_resource_t max_res;
 	sch_resource_t used;
 	schd_resource *res;
@@ -1743,11 +1803,7 @@ check_server_max_res(server_info *si, queue_info *qi, resource_resv *rr,
 		if ((req = find_resource_req(rr->resreq, res->def)) == NULL)
 			continue;
 
-		if ((reskey = entlim_mk_reskey(LIM_OVERALL, allparam,
-					       res->name)) == NULL)
-			return (SCHD_ERROR);
-		max_res = lim_get(reskey, LI2RESCTX(si->liminfo));
-		free(reskey);
+		max_res = lim_get_generic(LIM_OVERALL, res, LI2RESCTX(si->liminfo));
 
 		if (max_res == SCHD_INFINITY)
 			continue;
@@ -1792,7 +1848,6 @@ check_server_max_run(server_info *si, queue_info *qi, resource_resv *rr,
 		     limcounts *sc, limcounts *qc, schd_error *err)
 {
 	int max_running;
-	char *key;
 	int running;
 
 	if (si == NULL)
@@ -1803,10 +1858,7 @@ check_server_max_run(server_info *si, queue_info *qi, resource_resv *rr,
 
 	auto &cts = sc->all;
 
-	if ((key = entlim_mk_runkey(LIM_OVERALL, allparam)) == NULL)
-		return (SCHD_ERROR);
-	max_running = (int) lim_get(key, LI2RUNCTX(si->liminfo));
-	free(key);
+	max_running = (int) lim_get_generic(LIM_OVERALL, NULL, LI2RUNCTX(si->liminfo));
 
 	running = find_counts_elm(cts, PBS_ALL_ENTITY, NULL, NULL, NULL);
 
@@ -1843,7 +1895,6 @@ check_queue_max_run(server_info *si, queue_info *qi, resource_resv *rr,
 		    limcounts *sc, limcounts *qc, schd_error *err)
 {
 	int max_running;
-	char *key;
 	int running;
 
 	if (qi == NULL)
@@ -1854,11 +1905,7 @@ check_queue_max_run(server_info *si, queue_info *qi, resource_resv *rr,
 
 	auto &cts = qc->all;
 
-	if ((key = entlim_mk_runkey(LIM_OVERALL, allparam)) == NULL)
-		return (SCHD_ERROR);
-
-	max_running = (int) lim_get(key, LI2RUNCTX(qi->liminfo));
-	free(key);
+	max_running = (int) lim_get_generic(LIM_OVERALL, NULL, LI2RUNCTX(qi->liminfo));
 
 	running = find_counts_elm(cts, PBS_ALL_ENTITY, NULL, NULL, NULL);
 
@@ -1891,7 +1938,6 @@ static int
 check_queue_max_run_soft(server_info *si, queue_info *qi, resource_resv *rr)
 {
 	int max_running;
-	char *key;
 	counts *cnt = NULL;
 	int used = 0;
 
@@ -1901,10 +1947,7 @@ check_queue_max_run_soft(server_info *si, queue_info *qi, resource_resv *rr)
 	if (!qi->has_all_limit)
 		return (0);
 
-	if ((key = entlim_mk_runkey(LIM_OVERALL, allparam)) == NULL)
-		return (PREEMPT_TO_BIT(PREEMPT_ERR));
-	max_running = (int) lim_get(key, LI2RUNCTXSOFT(qi->liminfo));
-	free(key);
+	max_running = (int) lim_get_generic(LIM_OVERALL, NULL, LI2RUNCTXSOFT(qi->liminfo));
 
 	/* at this point, we know a limit is set for PBS_ALL*/
 	used = find_counts_elm(qi->alljobcounts, PBS_ALL_ENTITY, NULL, &cnt, NULL);
@@ -1938,7 +1981,6 @@ check_queue_max_run_soft(server_info *si, queue_info *qi, resource_resv *rr)
 static int
 check_queue_max_user_run_soft(server_info *si, queue_info *qi, resource_resv *rr)
 {
-	char *key;
 	std::string user;
 	int used;
 	int max_user_run_soft, max_genuser_run_soft;
@@ -1952,15 +1994,9 @@ check_queue_max_user_run_soft(server_info *si, queue_info *qi, resource_resv *rr
 
 	user = rr->user;
 
-	if ((key = entlim_mk_runkey(LIM_USER, user.c_str())) == NULL)
-		return (PREEMPT_TO_BIT(PREEMPT_ERR));
-	max_user_run_soft = (int) lim_get(key, LI2RUNCTXSOFT(qi->liminfo));
-	free(key);
+	max_user_run_soft = (int) lim_get_entity(LIM_USER, user.c_str(), NULL, LI2RUNCTXSOFT(qi->liminfo));
 
-	if ((key = entlim_mk_runkey(LIM_USER, genparam)) == NULL)
-		return (PREEMPT_TO_BIT(PREEMPT_ERR));
-	max_genuser_run_soft = (int) lim_get(key, LI2RUNCTXSOFT(qi->liminfo));
-	free(key);
+	max_genuser_run_soft = (int) lim_get_generic(LIM_USER, NULL, LI2RUNCTXSOFT(qi->liminfo));
 
 	if ((max_user_run_soft == SCHD_INFINITY) &&
 	    (max_genuser_run_soft == SCHD_INFINITY))
@@ -2014,7 +2050,6 @@ static int
 check_queue_max_group_run_soft(server_info *si, queue_info *qi,
 			       resource_resv *rr)
 {
-	char *key;
 	std::string group;
 	int used;
 	int max_group_run_soft, max_gengroup_run_soft;
@@ -2028,15 +2063,9 @@ check_queue_max_group_run_soft(server_info *si, queue_info *qi,
 
 	group = rr->group;
 
-	if ((key = entlim_mk_runkey(LIM_GROUP, group.c_str())) == NULL)
-		return (PREEMPT_TO_BIT(PREEMPT_ERR));
-	max_group_run_soft = (int) lim_get(key, LI2RUNCTXSOFT(qi->liminfo));
-	free(key);
+	max_group_run_soft = (int) lim_get_entity(LIM_GROUP, group.c_str(), NULL, LI2RUNCTXSOFT(qi->liminfo));
 
-	if ((key = entlim_mk_runkey(LIM_GROUP, genparam)) == NULL)
-		return (PREEMPT_TO_BIT(PREEMPT_ERR));
-	max_gengroup_run_soft = (int) lim_get(key, LI2RUNCTXSOFT(qi->liminfo));
-	free(key);
+	max_gengroup_run_soft = (int) lim_get_generic(LIM_GROUP, NULL, LI2RUNCTXSOFT(qi->liminfo));
 
 	if ((max_group_run_soft == SCHD_INFINITY) &&
 	    (max_gengroup_run_soft == SCHD_INFINITY))
@@ -2147,7 +2176,6 @@ static int
 check_server_max_run_soft(server_info *si, queue_info *qi, resource_resv *rr)
 {
 	int max_running;
-	char *key;
 	counts *cnt = NULL;
 	int used = 0;
 
@@ -2157,10 +2185,7 @@ check_server_max_run_soft(server_info *si, queue_info *qi, resource_resv *rr)
 	if (!si->has_all_limit)
 		return (0);
 
-	if ((key = entlim_mk_runkey(LIM_OVERALL, allparam)) == NULL)
-		return (PREEMPT_TO_BIT(PREEMPT_ERR));
-	max_running = (int) lim_get(key, LI2RUNCTXSOFT(si->liminfo));
-	free(key);
+	max_running = (int) lim_get_generic(LIM_OVERALL, NULL, LI2RUNCTXSOFT(si->liminfo));
 
 	/* at this point, we know a limit is set for PBS_ALL*/
 	used = find_counts_elm(si->alljobcounts, PBS_ALL_ENTITY, NULL, &cnt, NULL);
@@ -2195,7 +2220,6 @@ static int
 check_server_max_user_run_soft(server_info *si, queue_info *qi,
 			       resource_resv *rr)
 {
-	char *key;
 	std::string user;
 	int used;
 	int max_user_run_soft, max_genuser_run_soft;
@@ -2209,15 +2233,9 @@ check_server_max_user_run_soft(server_info *si, queue_info *qi,
 
 	user = rr->user;
 
-	if ((key = entlim_mk_runkey(LIM_USER, user.c_str())) == NULL)
-		return (PREEMPT_TO_BIT(PREEMPT_ERR));
-	max_user_run_soft = (int) lim_get(key, LI2RUNCTXSOFT(si->liminfo));
-	free(key);
+	max_user_run_soft = (int) lim_get_entity(LIM_USER, user.c_str(), NULL, LI2RUNCTXSOFT(si->liminfo));
 
-	if ((key = entlim_mk_runkey(LIM_USER, genparam)) == NULL)
-		return (PREEMPT_TO_BIT(PREEMPT_ERR));
-	max_genuser_run_soft = (int) lim_get(key, LI2RUNCTXSOFT(si->liminfo));
-	free(key);
+	max_genuser_run_soft = (int) lim_get_generic(LIM_USER, NULL, LI2RUNCTXSOFT(si->liminfo));
 
 	if ((max_user_run_soft == SCHD_INFINITY) &&
 	    (max_genuser_run_soft == SCHD_INFINITY))
@@ -2270,7 +2288,6 @@ static int
 check_server_max_group_run_soft(server_info *si, queue_info *qi,
 				resource_resv *rr)
 {
-	char *key;
 	std::string group;
 	int used;
 	int max_group_run_soft, max_gengroup_run_soft;
@@ -2284,15 +2301,9 @@ check_server_max_group_run_soft(server_info *si, queue_info *qi,
 
 	group = rr->group;
 
-	if ((key = entlim_mk_runkey(LIM_GROUP, group.c_str())) == NULL)
-		return (PREEMPT_TO_BIT(PREEMPT_ERR));
-	max_group_run_soft = (int) lim_get(key, LI2RUNCTXSOFT(si->liminfo));
-	free(key);
+	max_group_run_soft = (int) lim_get_entity(LIM_GROUP, group.c_str(), NULL, LI2RUNCTXSOFT(si->liminfo));
 
-	if ((key = entlim_mk_runkey(LIM_GROUP, genparam)) == NULL)
-		return (PREEMPT_TO_BIT(PREEMPT_ERR));
-	max_gengroup_run_soft = (int) lim_get(key, LI2RUNCTXSOFT(si->liminfo));
-	free(key);
+	max_gengroup_run_soft = (int) lim_get_generic(LIM_GROUP, NULL, LI2RUNCTXSOFT(si->liminfo));
 
 	if ((max_group_run_soft == SCHD_INFINITY) &&
 	    (max_gengroup_run_soft == SCHD_INFINITY))
@@ -2404,7 +2415,6 @@ check_server_max_group_res_soft(server_info *si, queue_info *qi,
 static int
 check_server_max_res_soft(server_info *si, queue_info *qi, resource_resv *rr)
 {
-	char *reskey;
 	sch_resource_t max_res_soft;
 	sch_resource_t used;
 	schd_resource *res;
@@ -2423,11 +2433,7 @@ check_server_max_res_soft(server_info *si, queue_info *qi, resource_resv *rr)
 		if (find_resource_req(rr->resreq, res->def) == NULL)
 			continue;
 
-		if ((reskey = entlim_mk_reskey(LIM_OVERALL, allparam,
-					       res->name)) == NULL)
-			return (PREEMPT_TO_BIT(PREEMPT_ERR));
-		max_res_soft = lim_get(reskey, LI2RESCTXSOFT(si->liminfo));
-		free(reskey);
+		max_res_soft = lim_get_generic(LIM_OVERALL, res, LI2RESCTXSOFT(si->liminfo));
 
 		if (max_res_soft == SCHD_INFINITY)
 			continue;
@@ -2473,7 +2479,6 @@ check_server_max_res_soft(server_info *si, queue_info *qi, resource_resv *rr)
 static int
 check_queue_max_res_soft(server_info *si, queue_info *qi, resource_resv *rr)
 {
-	char *reskey;
 	sch_resource_t max_res_soft;
 	sch_resource_t used;
 	schd_resource *res;
@@ -2492,11 +2497,7 @@ check_queue_max_res_soft(server_info *si, queue_info *qi, resource_resv *rr)
 		if (find_resource_req(rr->resreq, res->def) == NULL)
 			continue;
 
-		if ((reskey = entlim_mk_reskey(LIM_OVERALL, allparam,
-					       res->name)) == NULL)
-			return (PREEMPT_TO_BIT(PREEMPT_ERR));
-		max_res_soft = lim_get(reskey, LI2RESCTXSOFT(qi->liminfo));
-		free(reskey);
+		max_res_soft = lim_get_generic(LIM_OVERALL, res, LI2RESCTXSOFT(qi->liminfo));
 
 		if (max_res_soft == SCHD_INFINITY)
 			continue;
@@ -2544,8 +2545,6 @@ static int
 check_max_group_res(resource_resv *rr, counts_umap &cts_list,
 		    resdef **rdef, void *limitctx)
 {
-	char *groupreskey;
-	char *gengroupreskey;
 	std::string group;
 	schd_resource *res;
 	sch_resource_t max_group_res;
@@ -2565,17 +2564,10 @@ check_max_group_res(resource_resv *rr, counts_umap &cts_list,
 			continue;
 
 		/* individual group limit check */
-		if ((groupreskey = entlim_mk_reskey(LIM_GROUP, group.c_str(),
-						    res->name)) == NULL)
-			return (-1);
-		max_group_res = lim_get(groupreskey, limitctx);
-		free(groupreskey);
+		max_group_res = lim_get_entity(LIM_GROUP, group.c_str(), res->name, limitctx);
 
 		/* generic group limit check */
-		if ((gengroupreskey = lim_gengroupreskey(res->name)) == NULL)
-			return (-1);
-		max_gengroup_res = lim_get(gengroupreskey, limitctx);
-		free(gengroupreskey);
+		max_gengroup_res = lim_get_generic(LIM_GROUP, res, limitctx);
 
 		if ((max_group_res == SCHD_INFINITY) &&
 		    (max_gengroup_res == SCHD_INFINITY))
@@ -2622,8 +2614,6 @@ check_max_group_res(resource_resv *rr, counts_umap &cts_list,
 static int
 check_max_group_res_soft(resource_resv *rr, counts_umap &cts_list, void *limitctx, int preempt_bit)
 {
-	char *groupreskey;
-	char *gengroupreskey;
 	std::string group;
 	schd_resource *res;
 	sch_resource_t max_group_res_soft;
@@ -2645,17 +2635,10 @@ check_max_group_res_soft(resource_resv *rr, counts_umap &cts_list, void *limitct
 			continue;
 
 		/* individual group limit check */
-		if ((groupreskey = entlim_mk_reskey(LIM_GROUP, group.c_str(),
-						    res->name)) == NULL)
-			return (-1);
-		max_group_res_soft = lim_get(groupreskey, limitctx);
-		free(groupreskey);
+		max_group_res_soft = lim_get_entity(LIM_GROUP, group.c_str(), res->name, limitctx);
 
 		/* generic group limit check */
-		if ((gengroupreskey = lim_gengroupreskey(res->name)) == NULL)
-			return (-1);
-		max_gengroup_res_soft = lim_get(gengroupreskey, limitctx);
-		free(gengroupreskey);
+		max_gengroup_res_soft = lim_get_generic(LIM_GROUP, res, limitctx);
 
 		if ((max_group_res_soft == SCHD_INFINITY) &&
 		    (max_gengroup_res_soft == SCHD_INFINITY))
@@ -2712,8 +2695,6 @@ static int
 check_max_user_res(resource_resv *rr, counts_umap &cts_list, resdef **rdef,
 		   void *limitctx)
 {
-	char *userreskey;
-	char *genuserreskey;
 	std::string user;
 	schd_resource *res;
 	sch_resource_t max_user_res;
@@ -2734,17 +2715,10 @@ check_max_user_res(resource_resv *rr, counts_umap &cts_list, resdef **rdef,
 			continue;
 
 		/* individual user limit check */
-		if ((userreskey = entlim_mk_reskey(LIM_USER, user.c_str(),
-						   res->name)) == NULL)
-			return (-1);
-		max_user_res = lim_get(userreskey, limitctx);
-		free(userreskey);
+		max_user_res = lim_get_entity(LIM_USER, user.c_str(), res->name, limitctx);
 
 		/* generic user limit check */
-		if ((genuserreskey = lim_genuserreskey(res->name)) == NULL)
-			return (-1);
-		max_genuser_res = lim_get(genuserreskey, limitctx);
-		free(genuserreskey);
+		max_genuser_res = lim_get_generic(LIM_USER, res, limitctx);
 
 		if ((max_user_res == SCHD_INFINITY) &&
 		    (max_genuser_res == SCHD_INFINITY))
@@ -2793,8 +2767,6 @@ static int
 check_max_user_res_soft(resource_resv **rr_arr, resource_resv *rr,
 			counts_umap &cts_list, void *limitctx, int preempt_bit)
 {
-	char *userreskey;
-	char *genuserreskey;
 	std::string user;
 	schd_resource *res;
 	sch_resource_t max_user_res_soft;
@@ -2816,17 +2788,10 @@ check_max_user_res_soft(resource_resv **rr_arr, resource_resv *rr,
 			continue;
 
 		/* individual user limit check */
-		if ((userreskey = entlim_mk_reskey(LIM_USER, user.c_str(),
-						   res->name)) == NULL)
-			return (-1);
-		max_user_res_soft = lim_get(userreskey, limitctx);
-		free(userreskey);
+		max_user_res_soft = lim_get_entity(LIM_USER, user.c_str(), res->name, limitctx);
 
 		/* generic user limit check */
-		if ((genuserreskey = lim_genuserreskey(res->name)) == NULL)
-			return (-1);
-		max_genuser_res_soft = lim_get(genuserreskey, limitctx);
-		free(genuserreskey);
+		max_genuser_res_soft = lim_get_generic(LIM_USER, res, limitctx);
 
 		if ((max_user_res_soft == SCHD_INFINITY) &&
 		    (max_genuser_res_soft == SCHD_INFINITY))
@@ -2883,12 +2848,8 @@ check_max_user_res_soft(resource_resv **rr_arr, resource_resv *rr,
 static int
 lim_setreslimits(const struct attrl *a, void *ctx)
 {
-	schd_resource *r;
-
 	/* remember resources that appear in a limit */
-	r = find_alloc_resource_by_str(limres, a->resource);
-	if (limres == NULL)
-		limres = r;
+	lim_remember_limres(a->resource);
 
 	if (entlim_parse(a->value, a->resource, ctx, lim_callback) == 0)
 		return (0);
@@ -2911,6 +2872,7 @@ clear_limres(void)
 {
 	free_resource_list(limres);
 	limres = NULL;
+	limres_ids.clear();
 }
 
 /**
@@ -2999,12 +2961,8 @@ lim_setoldlimits(const struct attrl *a, void *ctx)
 			/* e is PBS_GENERIC_ENTITY or PBS_ALL_ENTITY */
 			e = p + 2;
 			if (avalue->lim_isreslim) {
-				schd_resource *r;
-
 				/* remember resources that appear in a limit */
-				r = find_alloc_resource_by_str(limres, a->resource);
-				if (limres == NULL)
-					limres = r;
+				lim_remember_limres(a->resource);
 
 				return (lim_callback(LI2RESCTXSOFT(ctx),
 						     kt, const_cast<char *>(avalue->lim_param),
@@ -3036,12 +2994,8 @@ lim_setoldlimits(const struct attrl *a, void *ctx)
 			/* e is PBS_GENERIC_ENTITY or PBS_ALL_ENTITY */
 			e = p + 2;
 			if (avalue->lim_isreslim) {
-				schd_resource *r;
-
 				/* remember resources that appear in a limit */
-				r = find_alloc_resource_by_str(limres, a->resource);
-				if (limres == NULL)
-					limres = r;
+				lim_remember_limres(a->resource);
 
 				return (lim_callback(LI2RESCTX(ctx),
 						     kt, const_cast<char *>(avalue->lim_param),
@@ -3074,17 +3028,17 @@ lim_dup_ctx(void *ctx)
 {
 	void *newctx;
 	char *key = NULL;
-	char *value = NULL;
+	struct lim_value *value = NULL;
 
 	if ((newctx = entlim_initialize_ctx()) == NULL) {
 		log_err(errno, __func__, "malloc failed");
 		return (NULL);
 	}
 
-	while ((value = static_cast<char *>(entlim_get_next(ctx, (void **) &key))) != NULL) {
-		const char *newval;
-		if ((newval = strdup(value)) == NULL) {
-			log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_SCHED, LOG_ERR, __func__, "strdup value failed");
+	while ((value = static_cast<lim_value *>(entlim_get_next(ctx, (void **) &key))) != NULL) {
+		struct lim_value *newval;
+		if ((newval = lim_mk_value(value->str)) == NULL) {
+			log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_SCHED, LOG_ERR, __func__, "malloc value failed");
 			(void) entlim_free_ctx(newctx, free);
 			return NULL;
 		} else if (entlim_add(key, newval, newctx) != 0) {
@@ -3130,50 +3084,111 @@ is_hardlimit(const struct attrl *a)
 
 /**
  * @brief
- *		lim_gengroupreskey	special-purpose shortcut function to construct a
- *				generic group resource key
+ *		lim_remember_limres	remember a resource that appears in a limit
+ *				and the entlim id of its name
  *
- * @param[in]	res	-	the resource
+ * @param[in]	resource	-	name of the resource
  *
- * @return	a resource limit key if successful
- * @retval	NULL	: if not
+ * @return	void
  */
-static char *
-lim_gengroupreskey(const char *res)
+static void
+lim_remember_limres(const char *resource)
 {
-	return (entlim_mk_reskey(LIM_GROUP, genparam, res));
+	schd_resource *r;
+
+	r = find_alloc_resource_by_str(limres, resource);
+	if (limres == NULL)
+		limres = r;
+
+	if (r == NULL || r->def == NULL)
+		return;
+
+	if (r->def->index >= static_cast<int>(limres_ids.size()))
+		limres_ids.resize(r->def->index + 1, ENTLIM_NO_ID);
+	if (limres_ids[r->def->index] == ENTLIM_NO_ID)
+		limres_ids[r->def->index] = entlim_name_id(r->name, 1);
+}
+
+/**
+ * @brief
+ *		lim_get_generic	fetch a generic (or overall for LIM_OVERALL) limit
+ *				value using the ids remembered when the limits were set
+ *
+ * @param[in]	kt	-	the key type
+ * @param[in]	res	-	the limit resource or NULL for a run limit
+ * @param[in]	ctx	-	the limit storage context
+ *
+ * @return	sch_resource_t
+ * @retval	the value of the limit
+ * @retval	SCHD_INFINITY if no such limit exists in the named context
+ */
+static sch_resource_t
+lim_get_generic(enum lim_keytypes kt, schd_resource *res, void *ctx)
+{
+	static const int genid = entlim_name_id(genparam, 1);
+	static const int allid = entlim_name_id(allparam, 1);
+	entlim_key_t key;
+
+	key.kt = kt;
+	key.entity = kt == LIM_OVERALL ? allid : genid;
+	key.resc = ENTLIM_NO_ID;
+	if (res != NULL) {
+		if (res->def != NULL && res->def->index < static_cast<int>(limres_ids.size()))
+			key.resc = limres_ids[res->def->index];
+		if (key.resc == ENTLIM_NO_ID && (key.resc = entlim_name_id(res->name, 0)) == ENTLIM_NO_ID)
+			return (SCHD_INFINITY);
+	}
+
+	return (lim_get(&key, ctx));
 }
 
 /**
  * @brief
- *		lim_genprojectreskey	special-purpose shortcut function to construct a
- *				generic project resource key
+ *		lim_get_entity	fetch a limit value for a named entity.  The lookup
+ *				uses a structured key, no key string is built.
  *
- * @param[in]	res	-	the resource
+ * @param[in]	kt	-	the key type
+ * @param[in]	entity	-	the entity name
+ * @param[in]	res	-	the limit resource or NULL for a run limit
+ * @param[in]	ctx	-	the limit storage context
  *
- * @return	a resource limit key if successful
- * @retval	NULL	: if not
+ * @return	sch_resource_t
+ * @retval	the value of the limit
+ * @retval	SCHD_INFINITY if no such limit exists in the named context
  */
-static char *
-lim_genprojectreskey(const char *res)
+static sch_resource_t
+lim_get_entity(enum lim_keytypes kt, const char *entity, const char *res, void *ctx)
 {
-	return (entlim_mk_reskey(LIM_PROJECT, genparam, res));
+	entlim_key_t key;
+
+	if (entlim_mk_key(&key, kt, entity, res) != 0)
+		return (SCHD_INFINITY);
+
+	return (lim_get(&key, ctx));
 }
 
 /**
  * @brief
- *		lim_genuserreskey	special-purpose shortcut function to construct a
- *				generic user resource key
+ *		lim_mk_value	make the stored form of a limit value
  *
- * @param[in]	res	-	the resource
+ * @param[in]	val	-	the value of the limit
  *
- * @return	a resource limit key on success
- * @retval	NULL	: on failure
+ * @return	struct lim_value *
+ * @retval	NULL	: on malloc failure
  */
-static char *
-lim_genuserreskey(const char *res)
+static struct lim_value *
+lim_mk_value(const char *val)
 {
-	return (entlim_mk_reskey(LIM_USER, genparam, res));
+	struct lim_value *v;
+	size_t len = strlen(val);
+
+	if ((v = static_cast<lim_value *>(malloc(offsetof(struct lim_value, str) + len + 1))) == NULL)
+		return NULL;
+
+	v->num = res_to_num(val, NULL);
+	memcpy(v->str, val, len + 1);
+
+	return v;
 }
 
 /**
@@ -3196,7 +3211,7 @@ lim_callback(void *ctx, enum lim_keytypes kt, char *param, char *namestring,
 	     char *res, char *val)
 {
 	char *key = NULL;
-	char *v = NULL;
+	struct lim_value *v = NULL;
 
 	if (res != NULL)
 		key = entlim_mk_reskey(kt, namestring, res);
@@ -3208,9 +3223,9 @@ lim_callback(void *ctx, enum lim_keytypes kt, char *param, char *namestring,
 		return (-1);
 	}
 
-	if ((v = strdup(val)) == NULL) {
+	if ((v = lim_mk_value(val)) == NULL) {
 		log_eventf(PBSEVENT_SCHED, PBS_EVENTCLASS_SCHED, LOG_ERR, __func__,
-			   "strdup %s %s %s failed", key, res, val);
+			   "malloc %s %s %s failed", key, res, val);
 		free(key);
 		return (-1);
 	}
@@ -3237,7 +3252,7 @@ lim_callback(void *ctx, enum lim_keytypes kt, char *param, char *namestring,
  * @brief
  *		lim_get	fetch a limit value
  *
- * @param[in]	param	-	the requested limit
+ * @param[in]	key	-	the requested limit
  * @param[in]	ctx	-	the limit storage context
  *
  * @return	sch_resource_t
@@ -3245,16 +3260,13 @@ lim_callback(void *ctx, enum lim_keytypes kt, char *param, char *namestring,
  * @retval	SCHD_INFINITY if no such limit exists in the named context
  */
 static sch_resource_t
-lim_get(const char *param, void *ctx)
+lim_get(const entlim_key_t *key, void *ctx)
 {
-	char *retptr;
+	struct lim_value *retptr;
 
-	retptr = static_cast<char *>(entlim_get(param, ctx));
+	retptr = static_cast<lim_value *>(entlim_get_key(key, ctx));
 	if (retptr != NULL) {
-		sch_resource_t v;
-
-		v = res_to_num(retptr, NULL);
-		return (v);
+		return (retptr->num);
 	} else {
 		return (SCHD_INFINITY);
 	}
@@ -3369,8 +3381,6 @@ static int
 check_max_project_res(resource_resv *rr, counts_umap &cts_list,
 		      resdef **rdef, void *limitctx)
 {
-	char *projectreskey;
-	char *genprojectreskey;
 	schd_resource *res;
 	std::string project;
 	sch_resource_t max_project_res;
@@ -3389,17 +3399,10 @@ check_max_project_res(resource_resv *rr, counts_umap &cts_list,
 			continue;
 
 		/* individual project limit check */
-		if ((projectreskey = entlim_mk_reskey(LIM_PROJECT,
-						      project.c_str(), res->name)) == NULL)
-			return (-1);
-		max_project_res = lim_get(projectreskey, limitctx);
-		free(projectreskey);
+		max_project_res = lim_get_entity(LIM_PROJECT, project.c_str(), res->name, limitctx);
 
 		/* generic project limit check */
-		if ((genprojectreskey = lim_genprojectreskey(res->name)) == NULL)
-			return (-1);
-		max_genproject_res = lim_get(genprojectreskey, limitctx);
-		free(genprojectreskey);
+		max_genproject_res = lim_get_generic(LIM_PROJECT, res, limitctx);
 
 		if ((max_project_res == SCHD_INFINITY) &&
 		    (max_genproject_res == SCHD_INFINITY))
@@ -3446,8 +3449,6 @@ check_max_project_res(resource_resv *rr, counts_umap &cts_list,
 static int
 check_max_project_res_soft(resource_resv *rr, counts_umap &cts_list, void *limitctx, int preempt_bit)
 {
-	char *projectreskey;
-	char *genprojectreskey;
 	std::string project;
 	schd_resource *res;
 	sch_resource_t max_project_res_soft;
@@ -3468,17 +3469,10 @@ check_max_project_res_soft(resource_resv *rr, counts_umap &cts_list, void *limit
 			continue;
 
 		/* individual project limit check */
-		if ((projectreskey = entlim_mk_reskey(LIM_PROJECT, project.c_str(),
-						      res->name)) == NULL)
-			return (-1);
-		max_project_res_soft = lim_get(projectreskey, limitctx);
-		free(projectreskey);
+		max_project_res_soft = lim_get_entity(LIM_PROJECT, project.c_str(), res->name, limitctx);
 
 		/* generic project limit check */
-		if ((genprojectreskey = lim_genprojectreskey(res->name)) == NULL)
-			return (-1);
-		max_genproject_res_soft = lim_get(genprojectreskey, limitctx);
-		free(genprojectreskey);
+		max_genproject_res_soft = lim_get_generic(LIM_PROJECT, res, limitctx);
 
 		if ((max_project_res_soft == SCHD_INFINITY) &&
 		    (max_genproject_res_soft == SCHD_INFINITY))
@@ -3594,7 +3588,6 @@ static int
 check_server_max_project_run_soft(server_info *si, queue_info *qi,
 				  resource_resv *rr)
 {
-	char *key;
 	std::string project;
 	int used;
 	int max_project_run_soft, max_genproject_run_soft;
@@ -3610,15 +3603,9 @@ check_server_max_project_run_soft(server_info *si, queue_info *qi,
 		return (0);
 
 	project = rr->project;
-	if ((key = entlim_mk_runkey(LIM_PROJECT, project.c_str())) == NULL)
-		return (PREEMPT_TO_BIT(PREEMPT_ERR));
-	max_project_run_soft = (int) lim_get(key, LI2RUNCTXSOFT(si->liminfo));
-	free(key);
+	max_project_run_soft = (int) lim_get_entity(LIM_PROJECT, project.c_str(), NULL, LI2RUNCTXSOFT(si->liminfo));
 
-	if ((key = entlim_mk_runkey(LIM_PROJECT, genparam)) == NULL)
-		return (PREEMPT_TO_BIT(PREEMPT_ERR));
-	max_genproject_run_soft = (int) lim_get(key, LI2RUNCTXSOFT(si->liminfo));
-	free(key);
+	max_genproject_run_soft = (int) lim_get_generic(LIM_PROJECT, NULL, LI2RUNCTXSOFT(si->liminfo));
 
 	if ((max_project_run_soft == SCHD_INFINITY) &&
 	    (max_genproject_run_soft == SCHD_INFINITY))
@@ -3759,7 +3746,6 @@ static int
 check_queue_max_project_run_soft(server_info *si, queue_info *qi,
 				 resource_resv *rr)
 {
-	char *key;
 	std::string project;
 	int used;
 	int max_project_run_soft, max_genproject_run_soft;
@@ -3775,15 +3761,9 @@ check_queue_max_project_run_soft(server_info *si, queue_info *qi,
 		return (0);
 
 	project = rr->project;
-	if ((key = entlim_mk_runkey(LIM_PROJECT, project.c_str())) == NULL)
-		return (PREEMPT_TO_BIT(PREEMPT_ERR));
-	max_project_run_soft = (int) lim_get(key, LI2RUNCTXSOFT(qi->liminfo));
-	free(key);
+	max_project_run_soft = (int) lim_get_entity(LIM_PROJECT, project.c_str(), NULL, LI2RUNCTXSOFT(qi->liminfo));
 
-	if ((key = entlim_mk_runkey(LIM_PROJECT, genparam)) == NULL)
-		return (PREEMPT_TO_BIT(PREEMPT_ERR));
-	max_genproject_run_soft = (int) lim_get(key, LI2RUNCTXSOFT(qi->liminfo));
-	free(key);
+	max_genproject_run_soft = (int) lim_get_generic(LIM_PROJECT, NULL, LI2RUNCTXSOFT(qi->liminfo));
 
 	if ((max_project_run_soft == SCHD_INFINITY) &&
 	    (max_genproject_run_soft == SCHD_INFINITY))
@@ -3869,7 +3849,6 @@ static int
 check_server_max_project_run(server_info *si, queue_info *qi, resource_resv *rr,
 			     limcounts *sc, limcounts *qc, schd_error *err)
 {
-	char *key;
 	std::string project;
 	int used;
 	int max_project_run, max_genproject_run;
@@ -3886,15 +3865,9 @@ check_server_max_project_run(server_info *si, queue_info *qi, resource_resv *rr,
 		return (0);
 
 	project = rr->project;
-	if ((key = entlim_mk_runkey(LIM_PROJECT, project.c_str())) == NULL)
-		return (SCHD_ERROR);
-	max_project_run = (int) lim_get(key, LI2RUNCTX(si->liminfo));
-	free(key);
+	max_project_run = (int) lim_get_entity(LIM_PROJECT, project.c_str(), NULL, LI2RUNCTX(si->liminfo));
 
-	if ((key = entlim_mk_runkey(LIM_PROJECT, genparam)) == NULL)
-		return (SCHD_ERROR);
-	max_genproject_run = (int) lim_get(key, LI2RUNCTX(si->liminfo));
-	free(key);
+	max_genproject_run = (int) lim_get_generic(LIM_PROJECT, NULL, LI2RUNCTX(si->liminfo));
 
 	if ((max_project_run == SCHD_INFINITY) &&
 	    (max_genproject_run == SCHD_INFINITY))
@@ -3943,7 +3916,6 @@ static int
 check_queue_max_project_run(server_info *si, queue_info *qi, resource_resv *rr,
 			    limcounts *sc, limcounts *qc, schd_error *err)
 {
-	char *key;
 	std::string project;
 	int used;
 	int max_project_run, max_genproject_run;
@@ -3960,15 +3932,9 @@ check_queue_max_project_run(server_info *si, queue_info *qi, resource_resv *rr,
 	if (!qi->has_proj_limit)
 		return (0);
 
-	if ((key = entlim_mk_runkey(LIM_PROJECT, project.c_str())) == NULL)
-		return (SCHD_ERROR);
-	max_project_run = (int) lim_get(key, LI2RUNCTX(qi->liminfo));
-	free(key);
+	max_project_run = (int) lim_get_entity(LIM_PROJECT, project.c_str(), NULL, LI2RUNCTX(qi->liminfo));
 
-	if ((key = entlim_mk_runkey(LIM_PROJECT, genparam)) == NULL)
-		return (SCHD_ERROR);
-	max_genproject_run = (int) lim_get(key, LI2RUNCTX(qi->liminfo));
-	free(key);
+	max_genproject_run = (int) lim_get_generic(LIM_PROJECT, NULL, LI2RUNCTX(qi->liminfo));
 
 	if ((max_project_run == SCHD_INFINITY) &&
 	    (max_genproject_run == SCHD_INFINITY))
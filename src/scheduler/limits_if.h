@@ -87,6 +87,28 @@ void lim_free_liminfo(void *);
  */
 int has_hardlimits(void *);
 
+/**	@fn std::size_t lim_hash_hardlimits(void *p)
+ *	@brief	hash the hard limits held in a limit storage
+ *
+ *	@param p	the limit storage to hash
+ *
+ *	@return	hash of the hard limit keys and values (0 if none are set)
+ *
+ *	@par MT-safe:	No
+ */
+std::size_t lim_hash_hardlimits(void *);
+
+/**	@fn std::size_t lim_hash_running(resource_resv *rr)
+ *	@brief	hash what a running job adds to the limit counts
+ *
+ *	@param rr	the running job
+ *
+ *	@return	hash of the job's name, queue, entities and requested amounts
+ *
+ *	@par MT-safe:	Yes
+ */
+std::size_t lim_hash_running(resource_resv *);
+
 /**	@fn int has_softlimits(void *p)
  *	@brief	are any soft limits set?
  *
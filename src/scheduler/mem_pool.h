@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+#ifndef _MEM_POOL_H
+#define _MEM_POOL_H
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ *	mem_pool - a pool allocator for small fixed size scheduler objects
+ *		   (resource_req, schd_resource, nspec).  Millions of these are
+ *		   allocated and freed every cycle.  The pool carves them out of
+ *		   large slabs so objects allocated together sit next to each
+ *		   other in memory, and recycles freed objects through free lists
+ *		   instead of going back to malloc.
+ *
+ *		   Every thread keeps a private free list so the worker threads
+ *		   don't contend on a lock.  Objects are moved between the
+ *		   private lists and a shared list in batches.  This keeps a
+ *		   thread which only frees (e.g., the main thread tearing down a
+ *		   universe the workers built) from hoarding objects.
+ *
+ *		   Slabs are never given back to the system.  The pool grows to
+ *		   the largest number of objects alive at once and stays there.
+ *
+ *		   alloc() returns zeroed memory like calloc() does.
+ */
+template <typename T>
+class mem_pool
+{
+	union slot {
+		slot *next;
+		alignas(T) unsigned char obj[sizeof(T)];
+	};
+
+	/* number of objects in a slab and in a batch moved to/from the shared list */
+	static const int slab_objs = 1024;
+	static const int batch_objs = 256;
+
+	static thread_local slot *local_head;
+	static thread_local int local_count;
+
+	static pthread_mutex_t shared_lock;
+	static slot *shared_head;
+
+	/**
+	 * refill the local free list from the shared list or a new slab
+	 */
+	static bool refill()
+	{
+		slot *s;
+		int i;
+
+		pthread_mutex_lock(&shared_lock);
+		if (shared_head != NULL) {
+			local_head = shared_head;
+			for (s = shared_head, i = 1; s->next != NULL && i < batch_objs; s = s->next, i++)
+				;
+			shared_head = s->next;
+			s->next = NULL;
+			local_count = i;
+			pthread_mutex_unlock(&shared_lock);
+			return true;
+		}
+		pthread_mutex_unlock(&shared_lock);
+
+		s = static_cast<slot *>(malloc(sizeof(slot) * slab_objs));
+		if (s == NULL)
+			return false;
+		for (i = 0; i < slab_objs - 1; i++)
+			s[i].next = &s[i + 1];
+		s[slab_objs - 1].next = NULL;
+		local_head = s;
+		local_count = slab_objs;
+		return true;
+	}
+
+	/**
+	 * give a batch of the local free list back to the shared list
+	 */
+	static void drain()
+	{
+		slot *first = local_head;
+		slot *last = local_head;
+		int i;
+
+		for (i = 1; i < batch_objs; i++)
+			last = last->next;
+		local_head = last->next;
+		local_count -= batch_objs;
+
+		pthread_mutex_lock(&shared_lock);
+		last->next = shared_head;
+		shared_head = first;
+		pthread_mutex_unlock(&shared_lock);
+	}
+
+	public:
+	/**
+	 * allocate a zeroed object from the pool
+	 *
+	 * @return	T *
+	 * @retval	the object
+	 * @retval	NULL	: on malloc failure
+	 */
+	static T *alloc()
+	{
+		slot *s;
+
+		if (local_head == NULL && !refill())
+			return NULL;
+
+		s = local_head;
+		local_head = s->next;
+		local_count--;
+		memset(static_cast<void *>(s), 0, sizeof(slot));
+		return reinterpret_cast<T *>(s->obj);
+	}
+
+	/**
+	 * return an object to the pool
+	 */
+	static void release(T *obj)
+	{
+		slot *s = reinterpret_cast<slot *>(obj);
+
+		if (obj == NULL)
+			return;
+
+		s->next = local_head;
+		local_head = s;
+		if (++local_count > slab_objs + batch_objs)
+			drain();
+	}
+};
+
+template <typename T>
+thread_local typename mem_pool<T>::slot *mem_pool<T>::local_head = NULL;
+template <typename T>
+thread_local int mem_pool<T>::local_count = 0;
+template <typename T>
+pthread_mutex_t mem_pool<T>::shared_lock = PTHREAD_MUTEX_INITIALIZER;
+template <typename T>
+typename mem_pool<T>::slot *mem_pool<T>::shared_head = NULL;
+
+#endif /* _MEM_POOL_H */
@@ -1270,7 +1270,7 @@ add_err(schd_error **prev_err, schd_error *err)
  * @retval	the resource in string format (in internal static string)
  * @retval	"" on error
  *
- * @par	MT-Safe: No
+ * @par	MT-Safe: Yes
  *
  * @note
  * 		This function can not be used more than once in a printf() type func
@@ -1280,8 +1280,8 @@ add_err(schd_error **prev_err, schd_error *err)
 char *
 res_to_str(void *p, enum resource_fields fld)
 {
-	static char *resbuf = NULL;
-	static int resbuf_size = 1024;
+	static thread_local char *resbuf = NULL;
+	static thread_local int resbuf_size = 1024;
 
 	if (resbuf == NULL) {
 		if ((resbuf = static_cast<char *>(malloc(resbuf_size))) == NULL)
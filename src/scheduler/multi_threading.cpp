@@ -37,6 +37,31 @@
  * subject to Altair's trademark licensing policies.
  */
 
+/**
+ * @file    multi_threading.cpp
+ *
+ * @brief
+ * 		multi_threading.cpp - The scheduler's worker thread pool.
+ *
+ *		Every thread (the main thread is thread 0) owns a deque of tasks.
+ *		A thread queues the tasks it creates on its own deque and takes
+ *		work from the back of it.  Idle threads steal from the front of
+ *		the other threads' deques.  A thread waiting for its tasks to
+ *		finish runs tasks itself while it waits.  This means workers can
+ *		fan out work of their own (nested parallelism) without
+ *		deadlocking the pool.
+ *
+ * Functions included are:
+ * 	kill_threads()
+ * 	init_multi_threading()
+ * 	worker()
+ * 	mt_chunk_size()
+ * 	queue_tasks()
+ * 	wait_tasks()
+ * 	run_tasks()
+ *
+ */
+
 #include <pbs_config.h>
 
 #include <stdio.h>
@@ -46,6 +71,9 @@
 #include <errno.h>
 #include <signal.h>
 
+#include <atomic>
+#include <deque>
+
 #include "log.h"
 #include "pbs_idx.h"
 
@@ -57,8 +85,22 @@
 #include "queue.h"
 #include "fifo.h"
 #include "resource_resv.h"
+#include "job_info.h"
+#include "resv_info.h"
 #include "multi_threading.h"
 
+/* per-thread task deque */
+struct th_deque {
+	pthread_mutex_t lock;
+	std::deque<th_task_info *> tasks;
+};
+
+/* one deque per thread, index 0 is the main thread */
+static th_deque *deques = NULL;
+
+/* number of tasks sitting in the deques.  Workers sleep when this is 0 */
+static std::atomic<int> tasks_queued(0);
+
 /**
  * @brief	create the thread id key & set it for the main thread
  *
@@ -82,6 +124,26 @@ create_id_key(void)
 	pthread_setspecific(th_id_key, (void *) mainid);
 }
 
+/**
+ * @brief	free the task deques
+ *
+ * @param	void
+ *
+ * @return	void
+ */
+static void
+free_deques(void)
+{
+	if (deques == NULL)
+		return;
+
+	for (int i = 0; i <= num_threads; i++)
+		pthread_mutex_destroy(&deques[i].lock);
+	delete[] deques;
+	deques = NULL;
+	tasks_queued = 0;
+}
+
 /**
  * @brief	convenience function to kill worker threads
  *
@@ -112,12 +174,9 @@ kill_threads(void)
 	pthread_cond_destroy(&result_cond);
 	pthread_mutex_destroy(&general_lock);
 	free(threads);
-	free_ds_queue(work_queue);
-	free_ds_queue(result_queue);
+	free_deques();
 	threads = NULL;
 	num_threads = 0;
-	work_queue = NULL;
-	result_queue = NULL;
 }
 
 /**
@@ -184,19 +243,18 @@ init_multi_threading(int nthreads)
 		return 0;
 	}
 
-	/* Create task and result queues */
-	work_queue = new_ds_queue();
-	if (work_queue == NULL) {
-		free(threads);
-		return 0;
-	}
-	result_queue = new_ds_queue();
-	if (result_queue == NULL) {
+	/* Create the task deques, one per worker plus one for the main thread */
+	try {
+		deques = new th_deque[num_threads + 1];
+	} catch (std::bad_alloc &e) {
+		log_err(errno, __func__, MEM_ERR_MSG);
 		free(threads);
-		free_ds_queue(work_queue);
-		work_queue = NULL;
+		threads = NULL;
 		return 0;
 	}
+	for (i = 0; i <= num_threads; i++)
+		pthread_mutex_init(&deques[i].lock, NULL);
+	tasks_queued = 0;
 
 	pthread_once(&key_once, create_id_key);
 	for (i = 0; i < num_threads; i++) {
@@ -205,10 +263,8 @@ init_multi_threading(int nthreads)
 		thid = static_cast<int *>(malloc(sizeof(int)));
 		if (thid == NULL) {
 			free(threads);
-			free_ds_queue(work_queue);
-			free_ds_queue(result_queue);
-			work_queue = NULL;
-			result_queue = NULL;
+			free_deques();
+			threads = NULL;
 			log_err(errno, __func__, MEM_ERR_MSG);
 			return 0;
 		}
@@ -219,6 +275,125 @@ init_multi_threading(int nthreads)
 	return 1;
 }
 
+/**
+ * @brief	find a task to run.  Take the newest task from our own deque,
+ *		or steal the oldest task from another thread's deque.
+ *
+ * @param[in]	ntid - thread id of the calling thread
+ *
+ * @return	th_task_info *
+ * @retval	task to run
+ * @retval	NULL if there is no work
+ */
+static th_task_info *
+get_task(int ntid)
+{
+	th_task_info *task = NULL;
+	th_deque *dq;
+
+	dq = &deques[ntid];
+	pthread_mutex_lock(&dq->lock);
+	if (!dq->tasks.empty()) {
+		task = dq->tasks.back();
+		dq->tasks.pop_back();
+	}
+	pthread_mutex_unlock(&dq->lock);
+
+	for (int i = 1; task == NULL && i <= num_threads; i++) {
+		dq = &deques[(ntid + i) % (num_threads + 1)];
+		pthread_mutex_lock(&dq->lock);
+		if (!dq->tasks.empty()) {
+			task = dq->tasks.front();
+			dq->tasks.pop_front();
+		}
+		pthread_mutex_unlock(&dq->lock);
+	}
+
+	if (task != NULL)
+		tasks_queued--;
+
+	return task;
+}
+
+/**
+ * @brief	run a task and mark it done
+ *
+ * @param[in]	task - the task to run
+ * @param[in]	ntid - thread id of the calling thread
+ *
+ * @return void
+ */
+static void
+run_task(th_task_info *task, int ntid)
+{
+	char buf[1024];
+
+	switch (task->task_type) {
+		case TS_IS_ND_ELIGIBLE:
+			snprintf(buf, sizeof(buf), "Thread %d calling check_node_eligibility_chunk()", ntid);
+			log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__, buf);
+			check_node_eligibility_chunk(static_cast<th_data_nd_eligible *>(task->thread_data));
+			break;
+		case TS_DUP_ND_INFO:
+			snprintf(buf, sizeof(buf), "Thread %d calling dup_node_info_chunk()", ntid);
+			log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__, buf);
+			dup_node_info_chunk(static_cast<th_data_dup_nd_info *>(task->thread_data));
+			break;
+		case TS_QUERY_ND_INFO:
+			snprintf(buf, sizeof(buf), "Thread %d calling query_node_info_chunk()", ntid);
+			log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__, buf);
+			query_node_info_chunk(static_cast<th_data_query_ninfo *>(task->thread_data));
+			break;
+		case TS_FREE_ND_INFO:
+			snprintf(buf, sizeof(buf), "Thread %d calling free_node_info_chunk()", ntid);
+			log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__, buf);
+			free_node_info_chunk(static_cast<th_data_free_ninfo *>(task->thread_data));
+			break;
+		case TS_DUP_RESRESV:
+			snprintf(buf, sizeof(buf), "Thread %d calling dup_resource_resv_array_chunk()", ntid);
+			log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__, buf);
+			dup_resource_resv_array_chunk(static_cast<th_data_dup_resresv *>(task->thread_data));
+			break;
+		case TS_QUERY_JOB_INFO:
+			snprintf(buf, sizeof(buf), "Thread %d calling query_jobs_chunk()", ntid);
+			log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__, buf);
+			query_jobs_chunk(static_cast<th_data_query_jinfo *>(task->thread_data));
+			break;
+		case TS_FREE_RESRESV:
+			snprintf(buf, sizeof(buf), "Thread %d calling free_resource_resv_array_chunk()", ntid);
+			log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__, buf);
+			free_resource_resv_array_chunk(static_cast<th_data_free_resresv *>(task->thread_data));
+			break;
+		case TS_EVAL_NODEPART:
+			snprintf(buf, sizeof(buf), "Thread %d calling eval_nodepart_chunk()", ntid);
+			log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__, buf);
+			eval_nodepart_chunk(static_cast<th_data_eval_nodepart *>(task->thread_data));
+			break;
+		case TS_DUP_RESV_OCCR:
+			snprintf(buf, sizeof(buf), "Thread %d calling dup_resv_occurrences_chunk()", ntid);
+			log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__, buf);
+			dup_resv_occurrences_chunk(static_cast<th_data_dup_resv_occr *>(task->thread_data));
+			break;
+		case TS_FREE_SERVER:
+			snprintf(buf, sizeof(buf), "Thread %d freeing the server universe", ntid);
+			log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__, buf);
+			delete static_cast<server_info *>(task->thread_data);
+			break;
+		default:
+			log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_SCHED, LOG_ERR, __func__,
+				  "Invalid task type passed to worker thread");
+	}
+
+	/* The last task of a batch wakes up whoever is waiting on it.  Once the
+	 * count hits 0 the batch may be freed, so don't touch the task after this.
+	 */
+	if (--(*task->pending) == 0) {
+		pthread_mutex_lock(&result_lock);
+		pthread_cond_broadcast(&result_cond);
+		pthread_mutex_unlock(&result_lock);
+	}
+}
+
 /**
  * @brief	Main pthread routine for worker threads
  *
@@ -232,7 +407,6 @@ worker(void *tid)
 	th_task_info *work = NULL;
 	sigset_t set;
 	int ntid;
-	char buf[1024];
 
 	pthread_setspecific(th_id_key, tid);
 	ntid = *(int *) tid;
@@ -248,80 +422,154 @@ worker(void *tid)
 	}
 
 	while (!threads_die) {
-		/* Get the next work task from work queue */
-		pthread_mutex_lock(&work_lock);
-		while (ds_queue_is_empty(work_queue) && !threads_die) {
-			pthread_cond_wait(&work_cond, &work_lock);
-		}
-		work = static_cast<th_task_info *>(ds_dequeue(work_queue));
-		pthread_mutex_unlock(&work_lock);
-
-		/* find out what task we need to do */
-		if (work != NULL) {
-			switch (work->task_type) {
-				case TS_IS_ND_ELIGIBLE:
-					snprintf(buf, sizeof(buf), "Thread %d calling check_node_eligibility_chunk()", ntid);
-					log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__, buf);
-					check_node_eligibility_chunk(static_cast<th_data_nd_eligible *>(work->thread_data));
-					break;
-				case TS_DUP_ND_INFO:
-					snprintf(buf, sizeof(buf), "Thread %d calling dup_node_info_chunk()", ntid);
-					log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__, buf);
-					dup_node_info_chunk(static_cast<th_data_dup_nd_info *>(work->thread_data));
-					break;
-				case TS_QUERY_ND_INFO:
-					snprintf(buf, sizeof(buf), "Thread %d calling query_node_info_chunk()", ntid);
-					log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__, buf);
-					query_node_info_chunk(static_cast<th_data_query_ninfo *>(work->thread_data));
-					break;
-				case TS_FREE_ND_INFO:
-					snprintf(buf, sizeof(buf), "Thread %d calling free_node_info_chunk()", ntid);
-					log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__, buf);
-					free_node_info_chunk(static_cast<th_data_free_ninfo *>(work->thread_data));
-					break;
-				case TS_DUP_RESRESV:
-					snprintf(buf, sizeof(buf), "Thread %d calling dup_resource_resv_array_chunk()", ntid);
-					log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__, buf);
-					dup_resource_resv_array_chunk(static_cast<th_data_dup_resresv *>(work->thread_data));
-					break;
-				case TS_QUERY_JOB_INFO:
-					snprintf(buf, sizeof(buf), "Thread %d calling query_jobs_chunk()", ntid);
-					log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__, buf);
-					query_jobs_chunk(static_cast<th_data_query_jinfo *>(work->thread_data));
-					break;
-				case TS_FREE_RESRESV:
-					snprintf(buf, sizeof(buf), "Thread %d calling free_resource_resv_array_chunk()", ntid);
-					log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__, buf);
-					free_resource_resv_array_chunk(static_cast<th_data_free_resresv *>(work->thread_data));
-					break;
-				default:
-					log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_SCHED, LOG_ERR, __func__,
-						  "Invalid task type passed to worker thread");
-			}
-
-			/* Post results */
-			pthread_mutex_lock(&result_lock);
-			ds_enqueue(result_queue, (void *) work);
-			pthread_cond_signal(&result_cond);
-			pthread_mutex_unlock(&result_lock);
+		work = get_task(ntid);
+		if (work == NULL) {
+			/* Nothing to do, sleep until somebody queues work */
+			pthread_mutex_lock(&work_lock);
+			while (tasks_queued <= 0 && !threads_die)
+				pthread_cond_wait(&work_cond, &work_lock);
+			pthread_mutex_unlock(&work_lock);
+			continue;
 		}
+		run_task(work, ntid);
 	}
 
 	pthread_exit(NULL);
 }
 
 /**
- * @brief	Convenience function to queue up work for worker threads
+ * @brief	Pick a chunk size to split num_items into for the worker threads.
+ *		We make several chunks per thread so threads which get cheap
+ *		chunks can steal from threads which got expensive ones.
  *
- * @param[in]	task - the task to queue up
+ * @param[in]	num_items - number of items to process
+ *
+ * @return int
+ * @retval chunk size
+ */
+int
+mt_chunk_size(int num_items)
+{
+	int chunk_size;
+
+	chunk_size = num_items / (num_threads * MT_CHUNKS_PER_THREAD);
+	chunk_size = (chunk_size > MT_CHUNK_SIZE_MIN) ? chunk_size : MT_CHUNK_SIZE_MIN;
+	chunk_size = (chunk_size < MT_CHUNK_SIZE_MAX) ? chunk_size : MT_CHUNK_SIZE_MAX;
+
+	return chunk_size;
+}
+
+/**
+ * @brief	Queue tasks on the calling thread's deque for the worker threads
+ *		to pick up.  The tasks are counted in pending, which drops back
+ *		as they finish.  With no worker threads the tasks are run
+ *		before returning.
+ *
+ * @param[in,out]	tasks - array of tasks to queue
+ * @param[in]	num_tasks - number of tasks in the array
+ * @param[in,out]	pending - count of unfinished tasks - see wait_tasks()
  *
  * @return void
  */
 void
-queue_work_for_threads(th_task_info *task)
+queue_tasks(th_task_info *tasks, int num_tasks, std::atomic<int> *pending)
 {
+	th_deque *dq;
+	int ntid;
+
+	if (tasks == NULL || num_tasks <= 0 || pending == NULL)
+		return;
+
+	ntid = *((int *) pthread_getspecific(th_id_key));
+
+	*pending += num_tasks;
+	for (int i = 0; i < num_tasks; i++)
+		tasks[i].pending = pending;
+
+	if (num_threads <= 1 || deques == NULL) {
+		for (int i = 0; i < num_tasks; i++)
+			run_task(&tasks[i], ntid);
+		return;
+	}
+
+	/* Queue them in reverse so we pop them back in order */
+	dq = &deques[ntid];
+	pthread_mutex_lock(&dq->lock);
+	for (int i = num_tasks - 1; i >= 0; i--)
+		dq->tasks.push_back(&tasks[i]);
+	pthread_mutex_unlock(&dq->lock);
+
+	tasks_queued += num_tasks;
 	pthread_mutex_lock(&work_lock);
-	ds_enqueue(work_queue, (void *) task);
-	pthread_cond_signal(&work_cond);
+	pthread_cond_broadcast(&work_cond);
 	pthread_mutex_unlock(&work_lock);
 }
+
+/**
+ * @brief	Wait for the tasks counted in pending to finish.  The calling
+ *		thread runs tasks while it waits.
+ *
+ * @param[in]	pending - count of unfinished tasks from queue_tasks()
+ *
+ * @return void
+ */
+void
+wait_tasks(std::atomic<int> *pending)
+{
+	th_task_info *task;
+	int ntid;
+
+	if (pending == NULL || deques == NULL)
+		return;
+
+	ntid = *((int *) pthread_getspecific(th_id_key));
+
+	while (*pending > 0) {
+		task = get_task(ntid);
+		if (task != NULL) {
+			run_task(task, ntid);
+			continue;
+		}
+		/* Everything left is running on other threads */
+		pthread_mutex_lock(&result_lock);
+		if (*pending > 0)
+			pthread_cond_wait(&result_cond, &result_lock);
+		pthread_mutex_unlock(&result_lock);
+	}
+}
+
+/**
+ * @brief	Run a batch of tasks on the worker threads and wait for all of
+ *		them to finish.  The calling thread runs tasks while it waits.
+ *		This may be called from a worker thread.
+ *
+ * @param[in,out]	tasks - array of tasks to run
+ * @param[in]	num_tasks - number of tasks in the array
+ *
+ * @return void
+ */
+void
+run_tasks(th_task_info *tasks, int num_tasks)
+{
+	std::atomic<int> pending(0);
+	int ntid;
+
+	if (tasks == NULL || num_tasks <= 0)
+		return;
+
+	if (num_threads <= 1 || deques == NULL) {
+		queue_tasks(tasks, num_tasks, &pending);
+		return;
+	}
+
+	ntid = *((int *) pthread_getspecific(th_id_key));
+
+	/* Queue all but the first task and run that one ourselves */
+	pending = 1;
+	tasks[0].pending = &pending;
+	queue_tasks(&tasks[1], num_tasks - 1, &pending);
+
+	run_task(&tasks[0], ntid);
+
+	wait_tasks(&pending);
+}
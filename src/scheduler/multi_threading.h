@@ -42,12 +42,17 @@
 
 #include "data_types.h"
 
-#define MT_CHUNK_SIZE_MIN 1024
+#define MT_CHUNK_SIZE_MIN 256
 #define MT_CHUNK_SIZE_MAX 8192
+/* chunks to make per thread so idle threads have work to steal */
+#define MT_CHUNKS_PER_THREAD 4
 
 int init_multi_threading(int nthreads);
 void kill_threads(void);
 void *worker(void *);
-void queue_work_for_threads(th_task_info *task);
+int mt_chunk_size(int num_items);
+void queue_tasks(th_task_info *tasks, int num_tasks, std::atomic<int> *pending);
+void wait_tasks(std::atomic<int> *pending);
+void run_tasks(th_task_info *tasks, int num_tasks);
 
 #endif /* SRC_SCHEDULER_MULTI_THREADING_H_ */
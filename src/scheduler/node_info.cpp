@@ -52,6 +52,7 @@
  * 	add_node_state()
  * 	node_filter()
  * 	find_node_info()
+ * 	find_node_by_name()
  * 	find_node_by_host()
  * 	dup_nodes()
  * 	dup_node_info()
@@ -66,6 +67,9 @@
  * 	free_nspecs()
  * 	find_nspec()
  * 	find_nspec_by_rank()
+ * 	eval_nodepart_chunk()
+ * 	can_eval_nodeparts_parallel()
+ * 	eval_nodeparts_parallel()
  * 	eval_selspec()
  * 	eval_placement()
  * 	eval_complex_selspec()
@@ -76,6 +80,9 @@
  * 	check_resources_for_node()
  * 	parse_placespec()
  * 	parse_selspec()
+ * 	find_selspec()
+ * 	find_placespec()
+ * 	clear_spec_cache()
  * 	create_execvnode()
  * 	parse_execvnode()
  * 	node_state_to_str()
@@ -105,7 +112,11 @@
  *
  */
 
+#include <atomic>
+#include <deque>
+#include <new>
 #include <unordered_map>
+#include <unordered_set>
 
 #include <pbs_config.h>
 
@@ -117,6 +128,7 @@
 #include <sys/types.h>
 #include <errno.h>
 #include <math.h>
+#include <pthread.h>
 #include <errno.h>
 #include <time.h>
 #include <pbs_ifl.h>
@@ -129,6 +141,7 @@
 #include "server_info.h"
 #include "job_info.h"
 #include "misc.h"
+#include "mem_pool.h"
 #include "globals.h"
 #include "check.h"
 #include "constant.h"
@@ -144,6 +157,8 @@
 #include "pbs_bitmap.h"
 #include "pbs_license.h"
 #include "multi_threading.h"
+#include "cycle_stats.h"
+#include "job_trace.h"
 #ifdef NAS
 #include "site_code.h"
 #endif
@@ -174,30 +189,37 @@ query_node_info_chunk(th_data_query_ninfo *data)
 	if ((ninfo_arr = static_cast<node_info **>(malloc((num_nodes_chunk + 1) * sizeof(node_info *)))) == NULL) {
 		log_err(errno, __func__, MEM_ERR_MSG);
 		data->error = 1;
-		return;
-	}
-	ninfo_arr[0] = NULL;
+	} else {
+		ninfo_arr[0] = NULL;
 
-	/* Move to the linked list item corresponding to the 'start' index */
-	for (cur_node = nodes, i = 0; i < start && cur_node != NULL; cur_node = cur_node->next, i++)
-		;
+		/* Move to the linked list item corresponding to the 'start' index */
+		for (cur_node = nodes, i = 0; i < start && cur_node != NULL; cur_node = cur_node->next, i++)
+			;
 
-	for (i = start, nidx = 0; i <= end && cur_node != NULL; cur_node = cur_node->next, i++) {
-		/* get node info from the batch_status */
-		if ((ninfo = query_node_info(cur_node, sinfo)) == NULL) {
-			free_nodes(ninfo_arr);
-			data->error = 1;
-			return;
+		for (i = start, nidx = 0; i <= end && cur_node != NULL; cur_node = cur_node->next, i++) {
+			/* get node info from the batch_status */
+			if ((ninfo = query_node_info(cur_node, sinfo)) == NULL) {
+				data->error = 1;
+				break;
+			}
+
+			if (node_in_partition(ninfo, sc_attrs.partition)) {
+				ninfo_arr[nidx++] = ninfo;
+			} else
+				delete ninfo;
 		}
+		ninfo_arr[nidx] = NULL;
 
-		if (node_in_partition(ninfo, sc_attrs.partition)) {
-			ninfo_arr[nidx++] = ninfo;
-		} else
-			delete ninfo;
+		if (data->error)
+			free_nodes(ninfo_arr);
+		else
+			data->oarr = ninfo_arr;
 	}
-	ninfo_arr[nidx] = NULL;
 
-	data->oarr = ninfo_arr;
+	if (data->free_statuses) {
+		pbs_statfree(nodes);
+		data->nodes = NULL;
+	}
 }
 
 /**
@@ -223,6 +245,7 @@ alloc_tdata_nd_query(struct batch_status *nodes, server_info *sinfo, int sidx, i
 		return NULL;
 	}
 	tdata->error = 0;
+	tdata->free_statuses = 0;
 	tdata->nodes = nodes;
 	tdata->oarr = NULL; /* Will be filled by the thread routine */
 	tdata->sinfo = sinfo;
@@ -232,6 +255,86 @@ alloc_tdata_nd_query(struct batch_status *nodes, server_info *sinfo, int sidx, i
 	return tdata;
 }
 
+/* state of query_nodes() while the nodes stream in from the server */
+struct node_stream {
+	server_info *sinfo;
+	int chunk_size;
+	struct batch_status *head; /* nodes not handed to a task yet */
+	struct batch_status *tail;
+	int count; /* number of nodes in head */
+	bool error;
+	std::deque<th_task_info> tasks;
+	std::atomic<int> pending;
+
+	node_stream(server_info *si) : sinfo(si), chunk_size(mt_chunk_size(0)), head(NULL), tail(NULL),
+				       count(0), error(false), pending(0) {}
+};
+
+/**
+ * @brief	hand the nodes collected so far to a worker thread, which
+ *		frees them once it has made node_info objects out of them
+ *
+ * @param[in,out]	ns	-	the node stream
+ *
+ * @return	void
+ */
+static void
+queue_node_chunk(node_stream *ns)
+{
+	th_data_query_ninfo *tdata;
+
+	if (ns->head == NULL)
+		return;
+
+	tdata = alloc_tdata_nd_query(ns->head, ns->sinfo, 0, ns->count - 1);
+	if (tdata == NULL) {
+		pbs_statfree(ns->head);
+		ns->error = true;
+	} else {
+		tdata->free_statuses = 1;
+		ns->tasks.emplace_back();
+		th_task_info &task = ns->tasks.back();
+		task.task_id = ns->tasks.size() - 1;
+		task.task_type = TS_QUERY_ND_INFO;
+		task.thread_data = (void *) tdata;
+		queue_tasks(&task, 1, &ns->pending);
+	}
+
+	ns->head = NULL;
+	ns->tail = NULL;
+	ns->count = 0;
+}
+
+/**
+ * @brief	pbs_status_cb for query_nodes().  Collects the nodes into
+ *		chunks and queues a chunk for the worker threads once it is full.
+ *
+ * @param[in]	bs	-	the node(s) read from the server
+ * @param[in]	arg	-	the node_stream
+ *
+ * @return	void
+ */
+static void
+stream_node(struct batch_status *bs, void *arg)
+{
+	node_stream *ns = static_cast<node_stream *>(arg);
+
+	if (ns->error) {
+		pbs_statfree(bs);
+		return;
+	}
+
+	if (ns->head == NULL)
+		ns->head = bs;
+	else
+		ns->tail->next = bs;
+	for (ns->tail = bs, ns->count++; ns->tail->next != NULL; ns->tail = ns->tail->next)
+		ns->count++;
+
+	if (ns->count >= ns->chunk_size)
+		queue_node_chunk(ns);
+}
+
 /**
  * @brief
  *      query_nodes - query all the nodes associated with a server
@@ -245,16 +348,14 @@ alloc_tdata_nd_query(struct batch_status *nodes, server_info *sinfo, int sidx, i
 node_info **
 query_nodes(int pbs_sd, server_info *sinfo)
 {
-	struct batch_status *nodes;    /* nodes returned from the server */
-	struct batch_status *cur_node; /* used to cycle through nodes */
-	node_info **ninfo_arr;	       /* array of nodes for scheduler's use */
-	int num_nodes = 0;	       /* the number of nodes */
+	phase_timer timer(PHASE_QUERY_NODES);
+	node_info **ninfo_arr = NULL; /* array of nodes for scheduler's use */
+	int num_nodes = 0;	      /* the number of nodes */
 	int nidx = 0;
 	static struct attrl *attrib = NULL;
 	th_data_query_ninfo *tdata = NULL;
-	th_task_info *task = NULL;
-	node_info ***ninfo_arrs_tasks = NULL;
-	int tid;
+	node_stream ns(sinfo);
+	int rc;
 
 	if (attrib == NULL) {
 		const char *nodeattrs[] = {
@@ -296,114 +397,68 @@ query_nodes(int pbs_sd, server_info *sinfo)
 		}
 	}
 
-	/* get nodes from PBS server */
-	if ((nodes = send_statvnode(pbs_sd, NULL, attrib, NULL)) == NULL) {
+	/* only ask for the nodes in our partitions (the default scheduler's are
+	 * those in none).  Nodes are still checked with node_in_partition() in
+	 * case the server does not know the filter.
+	 */
+	std::string filter = NODE_FILTER_PARTITION;
+	if (!dflt_sched && sc_attrs.partition != NULL)
+		filter += sc_attrs.partition;
+
+	/* get nodes from PBS server.  They are turned into node_info objects
+	 * by the worker threads a chunk at a time while the rest are read
+	 */
+	rc = send_statvnode_stream(pbs_sd, NULL, attrib, const_cast<char *>(filter.c_str()), stream_node, &ns);
+	if (rc == 0)
+		queue_node_chunk(&ns);
+	else {
 		auto err = pbs_geterrmsg(pbs_sd);
 		log_eventf(PBSEVENT_SCHED, PBS_EVENTCLASS_NODE, LOG_INFO, "", "Error getting nodes: %s", err);
-		return NULL;
+		pbs_statfree(ns.head);
+		ns.head = NULL;
+		ns.error = true;
 	}
+	wait_tasks(&ns.pending);
 
-	cur_node = nodes;
-	while (cur_node != NULL) {
-		num_nodes++;
-		cur_node = cur_node->next;
+	for (auto &task : ns.tasks) {
+		tdata = static_cast<th_data_query_ninfo *>(task.thread_data);
+		if (tdata->error)
+			ns.error = true;
+		else
+			num_nodes += count_array(tdata->oarr);
 	}
 
-	tid = *((int *) pthread_getspecific(th_id_key));
-	if (tid != 0 || num_threads <= 1) {
-		/* don't use multi-threading if I am a worker thread or num_threads is 1 */
-		tdata = alloc_tdata_nd_query(nodes, sinfo, 0, num_nodes - 1);
-		if (tdata == NULL) {
-			pbs_statfree(nodes);
-			return NULL;
-		}
-		query_node_info_chunk(tdata);
-		ninfo_arr = tdata->oarr;
-		free(tdata);
-
-		for (nidx = 0; ninfo_arr[nidx] != NULL; nidx++)
-			ninfo_arr[nidx]->rank = get_sched_rank();
-
-		ninfo_arr[nidx] = NULL;
-	} else {
-		int chunk_size = num_nodes / num_threads;
-		int th_err = 0;
-		int j;
-		int num_tasks;
-		if ((ninfo_arr = static_cast<node_info **>(malloc((num_nodes + 1) * sizeof(node_info *)))) == NULL) {
+	if (!ns.error) {
+		if ((ninfo_arr = static_cast<node_info **>(malloc((num_nodes + 1) * sizeof(node_info *)))) == NULL)
 			log_err(errno, __func__, MEM_ERR_MSG);
-			pbs_statfree(nodes);
-			return NULL;
-		}
-		ninfo_arr[0] = NULL;
-		chunk_size = (chunk_size > MT_CHUNK_SIZE_MIN) ? chunk_size : MT_CHUNK_SIZE_MIN;
-		for (j = 0, num_tasks = 0; num_nodes > 0;
-		     j += chunk_size, num_tasks++, num_nodes -= chunk_size) {
-			tdata = alloc_tdata_nd_query(nodes, sinfo, j, j + chunk_size - 1);
-			if (tdata == NULL) {
-				th_err = 1;
-				break;
-			}
-			task = static_cast<th_task_info *>(malloc(sizeof(th_task_info)));
-			if (task == NULL) {
-				free(tdata);
-				log_err(errno, __func__, MEM_ERR_MSG);
-				th_err = 1;
-				break;
-			}
-			task->task_id = num_tasks;
-			task->task_type = TS_QUERY_ND_INFO;
-			task->thread_data = (void *) tdata;
+	}
 
-			queue_work_for_threads(task);
-		}
-		ninfo_arrs_tasks = static_cast<node_info ***>(malloc(num_tasks * sizeof(node_info **)));
-		if (ninfo_arrs_tasks == NULL) {
-			log_err(errno, __func__, MEM_ERR_MSG);
-			th_err = 1;
-		}
-		/* Get results from worker threads */
-		for (int i = 0; i < num_tasks;) {
-			pthread_mutex_lock(&result_lock);
-			while (ds_queue_is_empty(result_queue))
-				pthread_cond_wait(&result_cond, &result_lock);
-			while (!ds_queue_is_empty(result_queue)) {
-				task = static_cast<th_task_info *>(ds_dequeue(result_queue));
-				tdata = static_cast<th_data_query_ninfo *>(task->thread_data);
-				if (tdata->error)
-					th_err = 1;
-				ninfo_arrs_tasks[task->task_id] = tdata->oarr;
-				free(tdata);
-				free(task);
-				i++;
-			}
-			pthread_mutex_unlock(&result_lock);
-		}
-		if (th_err) {
-			pbs_statfree(nodes);
-			free_nodes(ninfo_arr);
-			return NULL;
-		}
-		/* Assemble node info objects from various threads into the ninfo_arr */
-		for (int i = 0; i < num_tasks; i++) {
-			if (ninfo_arrs_tasks[i] != NULL) {
+	/* Assemble node info objects from the chunks into the ninfo_arr */
+	for (auto &task : ns.tasks) {
+		tdata = static_cast<th_data_query_ninfo *>(task.thread_data);
+		if (tdata->oarr != NULL) {
+			if (ninfo_arr == NULL)
+				free_nodes(tdata->oarr);
+			else {
 				node_info *ninfo;
 
-				for (int j = 0; (ninfo = ninfo_arrs_tasks[i][j]) != NULL; j++) {
+				for (int j = 0; (ninfo = tdata->oarr[j]) != NULL; j++) {
 					ninfo->rank = get_sched_rank();
 					ninfo_arr[nidx++] = ninfo;
 				}
-				free(ninfo_arrs_tasks[i]);
+				free(tdata->oarr);
 			}
 		}
-		ninfo_arr[nidx] = NULL;
-		free(ninfo_arrs_tasks);
+		free(tdata);
 	}
 
+	if (ninfo_arr == NULL)
+		return NULL;
+	ninfo_arr[nidx] = NULL;
+
 	if (nidx == 0) {
 		log_event(PBSEVENT_SCHED, PBS_EVENTCLASS_SERVER, LOG_INFO, __func__,
 			  "No nodes found in partitions serviced by scheduler");
-		pbs_statfree(nodes);
 		free(ninfo_arr);
 		return NULL;
 	}
@@ -413,7 +468,6 @@ query_nodes(int pbs_sd, server_info *sinfo)
 #endif /* localmod 062 */
 	resolve_indirect_resources(ninfo_arr);
 	sinfo->num_nodes = nidx;
-	pbs_statfree(nodes);
 	return ninfo_arr;
 }
 
@@ -581,6 +635,8 @@ query_node_info(struct batch_status *node, server_info *sinfo)
 		}
 		attrp = attrp->next;
 	}
+	index_resource_list(ninfo->res);
+
 	if (check_expiry) {
 		if (time(NULL) < expiry)
 			ninfo->lic_lock = 1;
@@ -739,19 +795,19 @@ free_nodes(node_info **ninfo_arr)
 	int i;
 	int chunk_size;
 	th_data_free_ninfo *tdata = NULL;
-	th_task_info *task = NULL;
+	th_task_info *tasks = NULL;
 	int num_tasks;
 	int num_nodes;
-	int tid;
 
 	if (ninfo_arr == NULL)
 		return;
 
 	num_nodes = count_array(ninfo_arr);
+	chunk_size = mt_chunk_size(num_nodes);
 
-	tid = *((int *) pthread_getspecific(th_id_key));
-	if (tid != 0 || num_threads <= 1) {
-		/* don't use multi-threading if I am a worker thread or num_threads is 1 */
+	if (num_threads <= 1 || num_nodes <= chunk_size ||
+	    (tasks = static_cast<th_task_info *>(calloc(num_nodes / chunk_size + 1, sizeof(th_task_info)))) == NULL) {
+		/* don't use multi-threading if num_threads is 1 or there is only one chunk */
 		tdata = alloc_tdata_free_nodes(ninfo_arr, 0, num_nodes - 1);
 		if (tdata == NULL)
 			return;
@@ -761,40 +817,21 @@ free_nodes(node_info **ninfo_arr)
 		free(ninfo_arr);
 		return;
 	}
-	chunk_size = num_nodes / num_threads;
-	chunk_size = (chunk_size > MT_CHUNK_SIZE_MIN) ? chunk_size : MT_CHUNK_SIZE_MIN;
 	for (i = 0, num_tasks = 0; num_nodes > 0;
 	     num_tasks++, i += chunk_size, num_nodes -= chunk_size) {
 		tdata = alloc_tdata_free_nodes(ninfo_arr, i, i + chunk_size - 1);
 		if (tdata == NULL)
 			break;
 
-		task = static_cast<th_task_info *>(malloc(sizeof(th_task_info)));
-		if (task == NULL) {
-			free(tdata);
-			log_err(errno, __func__, MEM_ERR_MSG);
-			break;
-		}
-		task->task_type = TS_FREE_ND_INFO;
-		task->thread_data = (void *) tdata;
-
-		queue_work_for_threads(task);
+		tasks[num_tasks].task_type = TS_FREE_ND_INFO;
+		tasks[num_tasks].thread_data = (void *) tdata;
 	}
 
-	/* Get results from worker threads */
-	for (i = 0; i < num_tasks;) {
-		pthread_mutex_lock(&result_lock);
-		while (ds_queue_is_empty(result_queue))
-			pthread_cond_wait(&result_cond, &result_lock);
-		while (!ds_queue_is_empty(result_queue)) {
-			task = static_cast<th_task_info *>(ds_dequeue(result_queue));
-			tdata = static_cast<th_data_free_ninfo *>(task->thread_data);
-			free(tdata);
-			free(task);
-			i++;
-		}
-		pthread_mutex_unlock(&result_lock);
-	}
+	run_tasks(tasks, num_tasks);
+
+	for (i = 0; i < num_tasks; i++)
+		free(tasks[i].thread_data);
+	free(tasks);
 	free(ninfo_arr);
 }
 
@@ -1078,6 +1115,41 @@ find_node_info(node_info **ninfo_arr, const std::string &nodename)
 	return ninfo_arr[i];
 }
 
+/**
+ * @brief find a server node by name using the server's node name index
+ *
+ * @param[in] sinfo - server whose nodes to search
+ * @param[in] nodename - name of node to search for
+ *
+ * @return node_info *
+ * @retval found node
+ * @retval NULL if not found or on error
+ */
+node_info *
+find_node_by_name(server_info *sinfo, const std::string &nodename)
+{
+	if (sinfo == NULL)
+		return NULL;
+
+	if (sinfo->node_name_ind != NULL) {
+		auto it = sinfo->node_name_ind->find(nodename);
+		node_info *ninfo = NULL;
+
+		if (it == sinfo->node_name_ind->end())
+			return NULL;
+
+		if (sinfo->unordered_nodes != NULL)
+			ninfo = sinfo->unordered_nodes[it->second];
+		else if (sinfo->nodes != NULL && it->second < sinfo->num_nodes)
+			ninfo = sinfo->nodes[it->second];
+
+		if (ninfo != NULL && ninfo->node_ind == it->second && ninfo->name == nodename)
+			return ninfo;
+	}
+
+	return find_node_info(sinfo->nodes, nodename);
+}
+
 /**
  * @brief
  *		find_node_by_host - find a node by its host resource rather then
@@ -1202,9 +1274,9 @@ dup_nodes(node_info **onodes, server_info *nsinfo, unsigned int flags)
 	schd_resource *tres = NULL;
 	node_info *ninfo = NULL;
 	th_data_dup_nd_info *tdata = NULL;
-	th_task_info *task = NULL;
+	th_task_info *tasks = NULL;
 	int th_err = 0;
-	int tid;
+	int chunk_size;
 
 	if (onodes == NULL || nsinfo == NULL)
 		return NULL;
@@ -1216,9 +1288,9 @@ dup_nodes(node_info **onodes, server_info *nsinfo, unsigned int flags)
 		return NULL;
 	}
 
-	tid = *((int *) pthread_getspecific(th_id_key));
-	if (tid != 0 || num_threads <= 1) {
-		/* don't use multi-threading if I am a worker thread or num_threads is 1 */
+	chunk_size = mt_chunk_size(num_nodes);
+	if (num_threads <= 1 || num_nodes <= chunk_size) {
+		/* don't use multi-threading if num_threads is 1 or there is only one chunk */
 		tdata = alloc_tdata_dup_nodes(flags, nsinfo, onodes, nnodes, 0, num_nodes - 1);
 		if (tdata == NULL) {
 			free_nodes(nnodes);
@@ -1232,8 +1304,13 @@ dup_nodes(node_info **onodes, server_info *nsinfo, unsigned int flags)
 	} else { /* We are multithreading */
 		int j;
 		int num_tasks;
-		int chunk_size = num_nodes / num_threads;
-		chunk_size = (chunk_size > MT_CHUNK_SIZE_MIN) ? chunk_size : MT_CHUNK_SIZE_MIN;
+
+		tasks = static_cast<th_task_info *>(calloc(num_nodes / chunk_size + 1, sizeof(th_task_info)));
+		if (tasks == NULL) {
+			log_err(errno, __func__, MEM_ERR_MSG);
+			free(nnodes);
+			return NULL;
+		}
 		for (j = 0, num_tasks = 0; thread_node_ct_left > 0;
 		     num_tasks++, j += chunk_size, thread_node_ct_left -= chunk_size) {
 			tdata = alloc_tdata_dup_nodes(flags, nsinfo, onodes, nnodes, j, j + chunk_size - 1);
@@ -1241,35 +1318,19 @@ dup_nodes(node_info **onodes, server_info *nsinfo, unsigned int flags)
 				th_err = 1;
 				break;
 			}
-			task = static_cast<th_task_info *>(malloc(sizeof(th_task_info)));
-			if (task == NULL) {
-				free(tdata);
-				th_err = 1;
-				log_err(errno, __func__, MEM_ERR_MSG);
-				break;
-			}
-			task->task_type = TS_DUP_ND_INFO;
-			task->thread_data = (void *) tdata;
-
-			queue_work_for_threads(task);
+			tasks[num_tasks].task_type = TS_DUP_ND_INFO;
+			tasks[num_tasks].thread_data = (void *) tdata;
 		}
 
-		/* Get results from worker threads */
-		for (int i = 0; i < num_tasks;) {
-			pthread_mutex_lock(&result_lock);
-			while (ds_queue_is_empty(result_queue))
-				pthread_cond_wait(&result_cond, &result_lock);
-			while (!ds_queue_is_empty(result_queue)) {
-				task = static_cast<th_task_info *>(ds_dequeue(result_queue));
-				tdata = static_cast<th_data_dup_nd_info *>(task->thread_data);
-				if (tdata->error)
-					th_err = 1;
-				free(tdata);
-				free(task);
-				i++;
-			}
-			pthread_mutex_unlock(&result_lock);
+		run_tasks(tasks, num_tasks);
+
+		for (int i = 0; i < num_tasks; i++) {
+			tdata = static_cast<th_data_dup_nd_info *>(tasks[i].thread_data);
+			if (tdata->error)
+				th_err = 1;
+			free(tdata);
 		}
+		free(tasks);
 	}
 
 	if (th_err) {
@@ -1399,6 +1460,7 @@ dup_node_info(node_info *onode, server_info *nsinfo, unsigned int flags)
 		nnode->res = dup_ind_resource_list(onode->res);
 	else
 		nnode->res = dup_resource_list(onode->res);
+	index_resource_list(nnode->res);
 
 	nnode->max_running = onode->max_running;
 	nnode->max_user_run = onode->max_user_run;
@@ -1546,10 +1608,16 @@ collect_jobs_on_nodes(node_info **ninfo_arr, resource_resv **resresv_arr, int si
 	resource_resv **susp_jobs = NULL; /* list of suspended jobs */
 	node_info *node;		  /* used to store pointer of node in ninfo_arr */
 	resource_resv **temp_ninfo_arr = NULL;
+	std::unordered_map<std::string, resource_resv *> resresv_by_name;
 
 	if (ninfo_arr == NULL || ninfo_arr[0] == NULL)
 		return 0;
 
+	/* nodes report their jobs by name: hash the jobs once rather than scanning per reported job */
+	resresv_by_name.reserve(size);
+	for (int i = 0; resresv_arr != NULL && i < size && resresv_arr[i] != NULL; i++)
+		resresv_by_name.emplace(resresv_arr[i]->name, resresv_arr[i]);
+
 	for (int i = 0; ninfo_arr[i] != NULL; i++) {
 		if ((ninfo_arr[i]->job_arr = static_cast<resource_resv **>(malloc((size + 1) * sizeof(resource_resv *)))) == NULL) {
 			log_err(errno, __func__, MEM_ERR_MSG);
@@ -1579,7 +1647,8 @@ collect_jobs_on_nodes(node_info **ninfo_arr, resource_resv **resresv_arr, int si
 				if (ptr != NULL)
 					*ptr = '\0';
 
-				job = find_resource_resv(resresv_arr, ninfo_arr[i]->jobs[j]);
+				auto rit = resresv_by_name.find(ninfo_arr[i]->jobs[j]);
+				job = rit != resresv_by_name.end() ? rit->second : NULL;
 				if ((job != NULL) && (!job->nspec_arr.empty())) {
 					/* if a distributed job has more then one instance on this node
 					 * it'll show up more then once.  If this is the case, we only
@@ -1634,16 +1703,24 @@ collect_jobs_on_nodes(node_info **ninfo_arr, resource_resv **resresv_arr, int si
 	if (susp_jobs == NULL)
 		return 0;
 
-	for (int i = 0; susp_jobs[i] != NULL; i++) {
-		if (susp_jobs[i]->ninfo_arr != NULL) {
-			for (int j = 0; susp_jobs[i]->ninfo_arr[j] != NULL; j++) {
-				/* resresv->ninfo_arr is merely a new list with pointers to server nodes.
-				 * resresv->resv->resv_nodes is a new list with pointers to resv nodes
-				 */
-				node = find_node_info(ninfo_arr,
-						      susp_jobs[i]->ninfo_arr[j]->name);
-				if (node != NULL)
-					node->num_susp_jobs++;
+	if (susp_jobs[0] != NULL) {
+		std::unordered_map<std::string, node_info *> node_by_name;
+
+		for (int i = 0; ninfo_arr[i] != NULL; i++)
+			node_by_name.emplace(ninfo_arr[i]->name, ninfo_arr[i]);
+
+		for (int i = 0; susp_jobs[i] != NULL; i++) {
+			if (susp_jobs[i]->ninfo_arr != NULL) {
+				for (int j = 0; susp_jobs[i]->ninfo_arr[j] != NULL; j++) {
+					/* resresv->ninfo_arr is merely a new list with pointers to server nodes.
+					 * resresv->resv->resv_nodes is a new list with pointers to resv nodes
+					 */
+					auto nit = node_by_name.find(susp_jobs[i]->ninfo_arr[j]->name);
+					if (nit != node_by_name.end()) {
+						node = nit->second;
+						node->num_susp_jobs++;
+					}
+				}
 			}
 		}
 	}
@@ -1929,6 +2006,23 @@ nspec::~nspec()
 	free_resource_req_list(resreq);
 }
 
+void *
+nspec::operator new(size_t size)
+{
+	void *ptr;
+
+	ptr = mem_pool<nspec>::alloc();
+	if (ptr == NULL)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+void
+nspec::operator delete(void *ptr)
+{
+	mem_pool<nspec>::release(static_cast<nspec *>(ptr));
+}
+
 // copy constructor
 nspec::nspec(const nspec &ons, node_info **ninfo_arr, selspec *sel)
 {
@@ -2027,6 +2121,214 @@ find_nspec_by_rank(std::vector<nspec *> &nspec_arr, int rank)
 	return NULL;
 }
 
+/**
+ * @brief
+ *		evaluate one placement set for eval_selspec().  This does the
+ *		same checks the serial loop in eval_selspec() does, but keeps
+ *		its results in data so they can be combined in placement set order.
+ *
+ * @param[in,out]	data	-	the placement set to evaluate and its results
+ *
+ * @return void
+ */
+void
+eval_nodepart_chunk(th_data_eval_nodepart *data)
+{
+	node_partition *np = data->np;
+	resource_resv *resresv = data->resresv;
+	unsigned int pass_flags = data->pass_flags;
+	char reason[MAX_LOG_SIZE] = {0};
+
+	data->can_fit = 0;
+	data->can_fit_total = 0;
+	data->rc = 0;
+
+	if (resresv_can_fit_nodepart(data->policy, np, resresv, data->flags, data->err)) {
+		data->can_fit = 1;
+		log_eventf(PBSEVENT_DEBUG3, PBS_EVENTCLASS_JOB, LOG_DEBUG, resresv->name,
+			   "Evaluating placement set: %s", np->name);
+		if (np->ok_break)
+			pass_flags |= EVAL_OKBREAK;
+
+		if (np->excl)
+			pass_flags |= EVAL_EXCLSET;
+
+		data->rc = eval_placement(data->policy, data->spec, np->ninfo_arr, data->pl,
+					  resresv, pass_flags, *data->nspec_arr, data->err);
+		if (!data->rc)
+			free_nspecs(*data->nspec_arr);
+	} else {
+		translate_fail_code(data->err, NULL, reason);
+		log_eventf(PBSEVENT_DEBUG3, PBS_EVENTCLASS_JOB, LOG_DEBUG, resresv->name,
+			   "Placement set %s is too small: %s", np->name, reason);
+		set_schd_error_codes(data->err, NOT_RUN, SET_TOO_SMALL);
+		set_schd_error_arg(data->err, ARG1, "Placement");
+#ifdef NAS /* localmod 031 */
+		set_schd_error_arg(data->err, ARG2, "for resource model");
+#else
+		set_schd_error_arg(data->err, ARG2, np->name);
+#endif /* localmod 031 */
+	}
+
+	/* We don't know if an earlier placement set will fit the request in
+	 * total, so always do the check.  It is done on a copy of err since
+	 * the serial loop only does it if no earlier set fit in total.
+	 */
+	if (!data->rc) {
+		data->total_err = dup_schd_error(data->err);
+		if (data->total_err != NULL &&
+		    resresv_can_fit_nodepart(data->policy, np, resresv, data->flags | COMPARE_TOTAL, data->total_err))
+			data->can_fit_total = 1;
+	}
+}
+
+/**
+ * @brief
+ *		check if the placement sets can be evaluated in parallel.
+ *		Node searching keeps its state in the nodes (nscr), so no node can
+ *		be in more than one placement set.  If a node is marked as not to be
+ *		used for multi-node jobs, eval_complex_selspec() changes the resresv
+ *		for everyone evaluating it, so we can't do those in parallel either.
+ *
+ * @param[in]	nodepart	-	the placement sets
+ * @param[in]	resresv	-	the resresv being evaluated
+ *
+ * @return bool
+ * @retval true	: the placement sets can be evaluated in parallel
+ * @retval false	: they have to be evaluated serially
+ */
+static bool
+can_eval_nodeparts_parallel(node_partition **nodepart, resource_resv *resresv)
+{
+	server_info *sinfo = resresv->server;
+
+	if (num_threads <= 1 || sinfo == NULL || nodepart[0] == NULL || nodepart[1] == NULL)
+		return false;
+
+	std::vector<bool> seen(sinfo->num_nodes, false);
+
+	for (int i = 0; nodepart[i] != NULL; i++) {
+		for (int j = 0; nodepart[i]->ninfo_arr[j] != NULL; j++) {
+			node_info *node = nodepart[i]->ninfo_arr[j];
+
+			if (node->no_multinode_jobs)
+				return false;
+			if (node->node_ind < 0 || node->node_ind >= sinfo->num_nodes)
+				return false;
+			if (seen[node->node_ind])
+				return false;
+			seen[node->node_ind] = true;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief
+ *		evaluate all the placement sets on the worker threads and return
+ *		the first one that fits in placement set order.  The results are
+ *		the same as the serial loop in eval_selspec() would find.
+ *
+ * @param[in]	policy	-	policy info
+ * @param[in]	spec	-	the select spec
+ * @param[in]	pl	-	the placement spec
+ * @param[in]	nodepart	-	the placement sets
+ * @param[in]	resresv	-	the resource resv the spec is from
+ * @param[in]	flags	-	flags for resresv_can_fit_nodepart()
+ * @param[in]	pass_flags	-	flags for eval_placement() for the first set
+ * @param[out]	nspec_arr	-	the node solution
+ * @param[out]	err	-	error structure to return error information
+ * @param[in,out]	failerr	-	first error encountered
+ * @param[out]	can_fit	-	set if the request fits any set in total
+ *
+ * @return bool
+ * @retval true	: a placement set fits the request
+ * @retval false	: no placement set fits the request
+ */
+static bool
+eval_nodeparts_parallel(status *policy, selspec *spec, place *pl, node_partition **nodepart,
+			resource_resv *resresv, unsigned int flags, unsigned int pass_flags,
+			std::vector<nspec *> &nspec_arr, schd_error *err, schd_error *failerr, int *can_fit)
+{
+	int num_parts;
+	th_task_info *tasks;
+	th_data_eval_nodepart *tdata;
+	bool rc = false;
+
+	num_parts = count_array(nodepart);
+	std::vector<std::vector<nspec *>> solutions(num_parts);
+
+	tasks = static_cast<th_task_info *>(calloc(num_parts, sizeof(th_task_info)));
+	tdata = static_cast<th_data_eval_nodepart *>(calloc(num_parts, sizeof(th_data_eval_nodepart)));
+	if (tasks == NULL || tdata == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		free(tasks);
+		free(tdata);
+		set_schd_error_codes(err, NOT_RUN, SCHD_ERROR);
+		return false;
+	}
+
+	for (int i = 0; i < num_parts; i++) {
+		tdata[i].policy = policy;
+		tdata[i].spec = spec;
+		tdata[i].pl = pl;
+		tdata[i].np = nodepart[i];
+		tdata[i].resresv = resresv;
+		tdata[i].flags = flags;
+		/* the serial loop only passes the caller's flags to the first set */
+		tdata[i].pass_flags = (i == 0) ? pass_flags : NO_FLAGS;
+		tdata[i].nspec_arr = &solutions[i];
+		tdata[i].err = new_schd_error();
+		if (tdata[i].err == NULL) {
+			for (int j = 0; j < i; j++)
+				free_schd_error(tdata[j].err);
+			free(tasks);
+			free(tdata);
+			set_schd_error_codes(err, NOT_RUN, SCHD_ERROR);
+			return false;
+		}
+		tasks[i].task_type = TS_EVAL_NODEPART;
+		tasks[i].thread_data = (void *) &tdata[i];
+	}
+
+	run_tasks(tasks, num_parts);
+
+	for (int i = 0; i < num_parts && !rc; i++) {
+		th_data_eval_nodepart *td = &tdata[i];
+
+		if (td->rc) {
+			if (resresv->nodepart_name != NULL)
+				free(resresv->nodepart_name);
+			resresv->nodepart_name = string_dup(nodepart[i]->name);
+			*can_fit = 1;
+			nspec_arr.swap(solutions[i]);
+			if (nodepart[i]->excl)
+				alloc_rest_nodepart(nspec_arr, nodepart[i]->ninfo_arr);
+			move_schd_error(err, td->err);
+			rc = true;
+		} else {
+			if (failerr->status_code == SCHD_UNKWN)
+				copy_schd_error(failerr, td->err);
+			if (!*can_fit && td->total_err != NULL) {
+				*can_fit = td->can_fit_total;
+				move_schd_error(err, td->total_err);
+			} else
+				move_schd_error(err, td->err);
+		}
+	}
+
+	for (int i = 0; i < num_parts; i++) {
+		free_nspecs(solutions[i]);
+		free_schd_error(tdata[i].err);
+		free_schd_error(tdata[i].total_err);
+	}
+	free(tasks);
+	free(tdata);
+
+	return rc;
+}
+
 /**
  *	@brief
  *		eval a select spec to see if it is satisfiable
@@ -2060,7 +2362,8 @@ eval_selspec(status *policy, selspec *spec, place *placespec,
 	int pass_flags = NO_FLAGS;
 	char reason[MAX_LOG_SIZE] = {0};
 	int i = 0;
-	static struct schd_error *failerr = NULL;
+	bool parallel = false; /* placement sets are evaluated on the worker threads */
+	static thread_local struct schd_error *failerr = NULL;
 
 	if (spec == NULL || ninfo_arr == NULL || resresv == NULL || placespec == NULL)
 		return false;
@@ -2120,7 +2423,17 @@ eval_selspec(status *policy, selspec *spec, place *placespec,
 
 	/* Otherwise we're node grouping... */
 
-	for (i = 0; nodepart[i] != NULL && rc == 0; i++) {
+	parallel = conf.parallel_pset_eval && can_eval_nodeparts_parallel(nodepart, resresv);
+	if (parallel) {
+		trace_span span("placement_sets", "parallel");
+
+		rc = eval_nodeparts_parallel(policy, spec, pl, nodepart, resresv, flags,
+					     pass_flags, nspec_arr, err, failerr, &can_fit);
+		pass_flags = NO_FLAGS;
+		span.set_result(rc);
+	}
+
+	for (i = 0; !parallel && nodepart[i] != NULL && rc == 0; i++) {
 		clear_schd_error(err);
 		if (resresv_can_fit_nodepart(policy, nodepart[i], resresv, flags, err)) {
 			log_eventf(PBSEVENT_DEBUG3, PBS_EVENTCLASS_JOB, LOG_DEBUG, resresv->name,
@@ -2131,8 +2444,13 @@ eval_selspec(status *policy, selspec *spec, place *placespec,
 			if (nodepart[i]->excl)
 				pass_flags |= EVAL_EXCLSET;
 
-			rc = eval_placement(policy, spec, nodepart[i]->ninfo_arr, pl,
-					    resresv, pass_flags, nspec_arr, err);
+			{
+				trace_span span("placement_set", nodepart[i]->name);
+
+				rc = eval_placement(policy, spec, nodepart[i]->ninfo_arr, pl,
+						    resresv, pass_flags, nspec_arr, err);
+				span.set_result(rc);
+			}
 			if (rc) {
 				if (resresv->nodepart_name != NULL)
 					free(resresv->nodepart_name);
@@ -2225,7 +2543,7 @@ eval_placement(status *policy, selspec *spec, node_info **ninfo_arr, place *pl,
 	schd_resource *res = NULL;
 	selspec *dselspec = NULL;
 	node_info **nptr = NULL;
-	static schd_error *failerr = NULL;
+	static thread_local schd_error *failerr = NULL;
 
 	if (spec == NULL || ninfo_arr == NULL || pl == NULL || resresv == NULL)
 		return 0;
@@ -2271,7 +2589,10 @@ eval_placement(status *policy, selspec *spec, node_info **ninfo_arr, place *pl,
 
 	if (hostsets == NULL) {
 		std::vector<std::string> host_arr{"host"};
+		/* placement sets may be evaluated in parallel (see eval_selspec()) */
+		pthread_mutex_lock(&general_lock);
 		npc = find_alloc_np_cache(policy, resresv->server->npc_arr, host_arr, nptr, NULL);
+		pthread_mutex_unlock(&general_lock);
 		if (npc != NULL)
 			hostsets = npc->nodepart;
 	}
@@ -2662,7 +2983,7 @@ eval_complex_selspec(status *policy, selspec *spec, node_info **ninfo_arr, place
 				 */
 				if (conf.provision_policy != AVOID_PROVISION &&
 				    !cstat.node_sort->empty() && conf.node_sort_unused)
-					qsort(nodes, tot_nodes, sizeof(node_info *), multi_node_sort);
+					resort_array(nodes, tot_nodes, multi_node_sort);
 			}
 			chunks_needed--;
 			nsa.insert(nsa.end(), ns_chunk.begin(), ns_chunk.end());
@@ -2698,6 +3019,106 @@ eval_complex_selspec(status *policy, selspec *spec, node_info **ninfo_arr, place
 	return eval_complex_selspec(policy, spec, ninfo_arr, pl, resresv, flags, nspec_arr, err);
 }
 
+/* number of vnodes whose consumables eval_simple_selspec() checks at once */
+#define CONS_BLOCK_SIZE 64
+
+/* consumables of a block of vnodes, checked against a chunk request in one go */
+struct cons_block {
+	int start;  /* index of the first vnode of the block */
+	int nnodes; /* number of vnodes in the block */
+	/* first consumable the vnode doesn't have enough of now or NULL if it fits */
+	resource_req *failreq[CONS_BLOCK_SIZE];
+};
+
+/**
+ * @brief
+ * 		check the consumable resources of the next block of vnodes
+ *		against one chunk.  The amount each vnode has free is gathered
+ *		into a column per requested resource so the comparison is one
+ *		tight loop over the block instead of a resource list walk per
+ *		vnode per resource.
+ *
+ * @par NOTE:
+ *		This mirrors the check check_resources_for_node() makes before
+ *		it looks at the calendar, so a vnode this rejects will be
+ *		rejected there too.  A vnode that passes might still not fit.
+ *
+ * @param[in]	specreq_cons	-	consumable resources requested by the chunk
+ * @param[in]	ninfo_arr	-	the array of nodes
+ * @param[in]	start	-	index of first vnode of the block
+ * @param[out]	blk	-	the checked block
+ *
+ * @return	void
+ */
+static void
+check_cons_block(resource_req *specreq_cons, node_info **ninfo_arr, int start, cons_block *blk)
+{
+	sch_resource_t avail[CONS_BLOCK_SIZE];
+	unsigned char fits[CONS_BLOCK_SIZE];
+	int n;
+
+	for (n = 0; n < CONS_BLOCK_SIZE && ninfo_arr[start + n] != NULL; n++)
+		blk->failreq[n] = NULL;
+
+	blk->start = start;
+	blk->nnodes = n;
+
+	for (resource_req *req = specreq_cons; req != NULL; req = req->next) {
+		auto amount = req->amount;
+
+		if (amount == 0)
+			continue;
+
+		for (int j = 0; j < n; j++) {
+			node_info *node = ninfo_arr[start + j];
+
+			avail[j] = amount;
+			/* nodes we won't look at or already know don't fit */
+			if (node->nscr || !node->lic_lock || blk->failreq[j] != NULL)
+				continue;
+
+			auto res = find_check_resource(node->res, req, UNSET_RES_ZERO);
+			if (res != NULL && res->type.is_consumable) {
+				auto a = dynamic_avail(res);
+				/* like check_avail_resources() w/ UNSET_RES_ZERO, unset is none */
+				avail[j] = (a == SCHD_INFINITY_RES) ? 0 : a;
+			}
+		}
+
+		for (int j = 0; j < n; j++)
+			fits[j] = avail[j] >= amount;
+
+		for (int j = 0; j < n; j++)
+			if (!fits[j] && blk->failreq[j] == NULL)
+				blk->failreq[j] = req;
+	}
+}
+
+/**
+ * @brief
+ * 		set the error check_resources_for_node() would have set for
+ *		a vnode check_cons_block() found doesn't fit
+ *
+ * @param[in]	node	-	the vnode
+ * @param[in]	failreq	-	first requested resource the vnode doesn't have enough of
+ * @param[in]	full	-	fill in the error message arguments as well
+ * @param[out]	err	-	error structure
+ *
+ * @return	void
+ */
+static void
+set_cons_block_err(node_info *node, resource_req *failreq, bool full, schd_error *err)
+{
+	if (full) {
+		auto res = find_check_resource(node->res, failreq, UNSET_RES_ZERO);
+		if (res != NULL && match_resource(res, failreq, CHECK_ALL_BOOLS | UNSET_RES_ZERO,
+						  INSUFFICIENT_RESOURCE, err) == 0)
+			return;
+	}
+	set_schd_error_codes(err, NOT_RUN, INSUFFICIENT_RESOURCE);
+	err->rdef = failreq->def;
+}
+
 /**
  * @brief
  * 		eval a non-plused select spec for satisfiability
@@ -2739,13 +3160,20 @@ eval_simple_selspec(status *policy, chunk *chk, node_info **pninfo_arr,
 
 	node_info **ninfo_arr = NULL;
 
-	static schd_error *failerr = NULL;
+	static thread_local schd_error *failerr = NULL;
 
 	resource_req *aoereq = NULL;
 	nspec *ns = NULL;
 
 	std::vector<nspec *> nsa;
 
+	cons_block consblk;	 /* consumables of the vnodes being looked at */
+	bool use_consblk;	 /* check consumables a block of vnodes at a time */
+	bool log_vnodes;	 /* we log why each vnode is ineligible */
+	int last_vnode = -1;	 /* last vnode looked at */
+	int last_shortcut = -1;	 /* last vnode rejected on the block check alone */
+	resource_req *shortcut_req = NULL; /* what last_shortcut was short of */
+
 	if (chk == NULL || pninfo_arr == NULL || resresv == NULL || pl == NULL)
 		return false;
 
@@ -2828,20 +3256,45 @@ eval_simple_selspec(status *policy, chunk *chk, node_info **pninfo_arr,
 
 	ns = new nspec();
 
+	/* When the chunk has to fit on one vnode, a vnode which doesn't have
+	 * enough consumables now won't fit no matter what else we check.  We find
+	 * those vnodes a block at a time and skip straight to rejecting them.
+	 * The full reason is still worked out for the vnodes whose error can be
+	 * seen: the first one to fail, the last one looked at and all of them
+	 * when we log each vnode.
+	 */
+	use_consblk = specreq_cons != NULL && !(flags & EVAL_OKBREAK);
+	log_vnodes = will_log_event(PBSEVENT_DEBUG3);
+	consblk.start = 0;
+	consblk.nnodes = 0;
+
 	for (i = 0; ninfo_arr[i] != NULL && chunks_found == 0; i++) {
 		if (ninfo_arr[i]->nscr)
 			continue;
 
+		last_vnode = i;
 		allocated = false;
 		clear_schd_error(err);
 		if (ninfo_arr[i]->lic_lock) {
+			resource_req *consfail = NULL;
+
+			if (use_consblk) {
+				if (i >= consblk.start + consblk.nnodes)
+					check_cons_block(specreq_cons, ninfo_arr, i, &consblk);
+				consfail = consblk.failreq[i - consblk.start];
+			}
 
 			if (need_new_nspec) {
 				need_new_nspec = false;
 				ns = new nspec();
 			}
 
-			if (is_vnode_eligible_chunk(specreq_noncons, ninfo_arr[i], resresv, err)) {
+			if (consfail != NULL && failerr->status_code != SCHD_UNKWN && !log_vnodes) {
+				set_cons_block_err(ninfo_arr[i], consfail, false, err);
+				ninfo_arr[i]->nscr |= NSCR_VISITED;
+				last_shortcut = i;
+				shortcut_req = consfail;
+			} else if (is_vnode_eligible_chunk(specreq_noncons, ninfo_arr[i], resresv, err)) {
 				if (specreq_cons != NULL)
 					allocated = resources_avail_on_vnode(specreq_cons, ninfo_arr[i],
 									     pl, resresv, flags, ns, err);
@@ -2935,6 +3388,22 @@ eval_simple_selspec(status *policy, chunk *chk, node_info **pninfo_arr,
 		}
 	}
 
+	/* The error returned is the one of the last vnode we looked at.  If we
+	 * took the shortcut for it, redo its checks to get the full reason.
+	 */
+	if (chunks_found == 0 && last_vnode != -1 && last_vnode == last_shortcut) {
+		node_info *node = ninfo_arr[last_vnode];
+
+		clear_schd_error(err);
+		if (is_vnode_eligible_chunk(specreq_noncons, node, resresv, err))
+			set_cons_block_err(node, shortcut_req, true, err);
+		if (node->nodesig_ind >= 0)
+			check_avail_resources(node->res, chk->req,
+					      COMPARE_TOTAL | UNSET_RES_ZERO | CHECK_ALL_BOOLS,
+					      policy->resdef_to_check_no_hostvnode,
+					      INSUFFICIENT_RESOURCE, err);
+	}
+
 	if (specreq_cons != NULL)
 		free_resource_req_list(specreq_cons);
 	if (specreq_noncons != NULL)
@@ -3802,6 +4271,142 @@ parse_selspec(const std::string &sspec)
 	return spec;
 }
 
+/* max number of parsed select and place specs to keep around */
+#define SPEC_CACHE_MAX 4096
+
+/*
+ * spec string -> parsed spec.  Jobs mostly share a handful of select and
+ * place specs (array subjobs, templated workflows), so each distinct spec
+ * is parsed once.  The select specs hold a reference of their own and are
+ * shared read-only with the jobs.  Filled by the query_jobs() threads.
+ */
+static std::unordered_map<std::string, selspec *> selspec_cache;
+static std::unordered_map<std::string, place *> placespec_cache;
+static pthread_mutex_t spec_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief
+ *		find_selspec - return the parsed form of a select spec.  A select
+ *		spec is parsed the first time it is seen and is then shared by all
+ *		jobs with the same spec.  The returned select spec must be treated
+ *		as read-only and released with free_selspec().
+ *
+ * @param[in]	sspec	-	the select spec to parse
+ *
+ * @return	selspec *
+ * @retval	shared select spec
+ * @retval	NULL	: on error or invalid spec
+ *
+ * @par MT-safe: Yes
+ */
+selspec *
+find_selspec(const std::string &sspec)
+{
+	selspec *spec;
+
+	pthread_mutex_lock(&spec_cache_lock);
+	auto f = selspec_cache.find(sspec);
+	if (f != selspec_cache.end()) {
+		spec = share_selspec(f->second);
+		pthread_mutex_unlock(&spec_cache_lock);
+		return spec;
+	}
+	pthread_mutex_unlock(&spec_cache_lock);
+
+	spec = parse_selspec(sspec);
+	if (spec == NULL)
+		return NULL;
+
+	pthread_mutex_lock(&spec_cache_lock);
+	if (selspec_cache.size() >= SPEC_CACHE_MAX) {
+		for (auto &s : selspec_cache)
+			free_selspec(s.second);
+		selspec_cache.clear();
+	}
+	auto ins = selspec_cache.emplace(sspec, spec);
+	if (ins.second)
+		share_selspec(spec);
+	else {
+		/* another thread parsed the same spec first, use that one */
+		free_selspec(spec);
+		spec = share_selspec(ins.first->second);
+	}
+	pthread_mutex_unlock(&spec_cache_lock);
+
+	return spec;
+}
+
+/**
+ * @brief
+ *		find_placespec - return a place structure for a placement spec.
+ *		Each distinct placement spec is parsed once, a copy of the parsed
+ *		form is returned.
+ *
+ * @param[in]	place_str	-	placespec as a string
+ *
+ * @return	newly allocated place
+ * @retval	NULL	: invalid placement spec
+ *
+ * @par MT-safe: Yes
+ */
+place *
+find_placespec(char *place_str)
+{
+	place *pl;
+
+	if (place_str == NULL)
+		return NULL;
+
+	pthread_mutex_lock(&spec_cache_lock);
+	auto f = placespec_cache.find(place_str);
+	if (f != placespec_cache.end()) {
+		pl = dup_place(f->second);
+		pthread_mutex_unlock(&spec_cache_lock);
+		return pl;
+	}
+	pthread_mutex_unlock(&spec_cache_lock);
+
+	pl = parse_placespec(place_str);
+	if (pl == NULL)
+		return NULL;
+
+	pthread_mutex_lock(&spec_cache_lock);
+	if (placespec_cache.size() >= SPEC_CACHE_MAX) {
+		for (auto &p : placespec_cache)
+			free_place(p.second);
+		placespec_cache.clear();
+	}
+	if (placespec_cache.find(place_str) == placespec_cache.end()) {
+		place *cpl = dup_place(pl);
+		if (cpl != NULL)
+			placespec_cache[place_str] = cpl;
+	}
+	pthread_mutex_unlock(&spec_cache_lock);
+
+	return pl;
+}
+
+/**
+ * @brief
+ *		clear_spec_cache - forget all parsed select and place specs.
+ *		Called when the resource definitions change since parsed select
+ *		specs point at them.  Jobs keep their own references.
+ *
+ * @return	void
+ */
+void
+clear_spec_cache()
+{
+	pthread_mutex_lock(&spec_cache_lock);
+	for (auto &s : selspec_cache)
+		free_selspec(s.second);
+	selspec_cache.clear();
+	for (auto &p : placespec_cache)
+		free_place(p.second);
+	placespec_cache.clear();
+	pthread_mutex_unlock(&spec_cache_lock);
+}
+
 /**
  *	@brief compare two chunks for equality
  *	@param[in] c1 - first chunk
@@ -4032,7 +4637,7 @@ parse_execvnode(char *execvnode, server_info *sinfo, selspec *sel)
 	for (i = 0; i < num_chunk && !invalid && simplespec != NULL; i++) {
 		auto ns = new nspec();
 		nspec_arr.push_back(ns);
-		ninfo = find_node_info(sinfo->nodes, node_name);
+		ninfo = find_node_by_name(sinfo, node_name);
 		if (ninfo != NULL) {
 			ns->ninfo = ninfo;
 			for (j = 0; j < num_el; j++) {
@@ -4276,13 +4881,13 @@ create_node_array_from_nspec(std::vector<nspec *> &nspec_arr)
  *
  * @par MT-safe:	No
  *
- * @par MT-safe: No
+ * @par MT-safe: Yes
  */
 node_info **
 reorder_nodes(node_info **nodes, resource_resv *resresv)
 {
-	static node_info **node_array = NULL;
-	static int node_array_size = 0;
+	static thread_local node_info **node_array = NULL;
+	static thread_local int node_array_size = 0;
 	node_info **nptr = NULL;
 	node_info **tmparr = NULL;
 	schd_resource *hostres = NULL;
@@ -4546,7 +5151,7 @@ int
 can_fit_on_vnode(resource_req *req, node_info **ninfo_arr)
 {
 	int i;
-	static schd_error *dumperr = NULL;
+	static thread_local schd_error *dumperr = NULL;
 
 	if (req == NULL || ninfo_arr == NULL)
 		return 0;
@@ -4761,8 +5366,7 @@ node_up_event(node_info *node, void *arg)
 	sinfo = node->server;
 	if (sinfo->node_group_enable && !sinfo->node_group_key.empty()) {
 		node_partition_update_array(sinfo->policy, sinfo->nodepart);
-		qsort(sinfo->nodepart, sinfo->num_parts,
-		      sizeof(node_partition *), cmp_placement_sets);
+		sort_nodepart_array(sinfo->nodepart, sinfo->num_parts);
 	}
 	update_all_nodepart(sinfo->policy, sinfo, NO_ALLPART);
 
@@ -4809,8 +5413,7 @@ node_down_event(node_info *node, void *arg)
 
 	if (sinfo->node_group_enable && !sinfo->node_group_key.empty()) {
 		node_partition_update_array(sinfo->policy, sinfo->nodepart);
-		qsort(sinfo->nodepart, sinfo->num_parts,
-		      sizeof(node_partition *), cmp_placement_sets);
+		sort_nodepart_array(sinfo->nodepart, sinfo->num_parts);
 	}
 	update_all_nodepart(sinfo->policy, sinfo, NO_ALLPART);
 
@@ -4833,12 +5436,17 @@ create_node_array_from_str(node_info **nodes, char **strnodes)
 	int i, j;
 	node_info **ninfo_arr;
 	int cnt;
+	std::unordered_map<std::string, node_info *> node_by_name;
+	std::unordered_set<node_info *> added;
 
 	if (nodes == NULL || strnodes == NULL)
 		return NULL;
 
 	cnt = count_array(strnodes);
 
+	for (i = 0; nodes[i] != NULL; i++)
+		node_by_name.emplace(nodes[i]->name, nodes[i]);
+
 	if ((ninfo_arr = static_cast<node_info **>(malloc((cnt + 1) * sizeof(node_info *)))) == NULL) {
 		log_err(errno, __func__, MEM_ERR_MSG);
 		return NULL;
@@ -4846,14 +5454,14 @@ create_node_array_from_str(node_info **nodes, char **strnodes)
 	ninfo_arr[0] = NULL;
 
 	for (i = 0, j = 0; strnodes[i] != NULL; i++) {
-		if (find_node_info(ninfo_arr, strnodes[i]) == NULL) {
-			ninfo_arr[j] = find_node_info(nodes, strnodes[i]);
-			if (ninfo_arr[j] != NULL) {
-				j++;
-				ninfo_arr[j] = NULL;
-			} else
-				log_eventf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_NODE, LOG_DEBUG, __func__,
-					   "Node %s not found in list.", strnodes[i]);
+		auto it = node_by_name.find(strnodes[i]);
+		if (it == node_by_name.end())
+			log_eventf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_NODE, LOG_DEBUG, __func__,
+				   "Node %s not found in list.", strnodes[i]);
+		else if (added.insert(it->second).second) {
+			ninfo_arr[j] = it->second;
+			j++;
+			ninfo_arr[j] = NULL;
 		}
 	}
 
@@ -5208,18 +5816,18 @@ void
 check_node_array_eligibility(node_info **ninfo_arr, resource_resv *resresv, place *pl, schd_error *err)
 {
 	th_data_nd_eligible *tdata = NULL;
-	th_task_info *task = NULL;
-	int tid;
+	th_task_info *tasks = NULL;
 	int num_nodes;
+	int chunk_size;
 
 	if (ninfo_arr == NULL || resresv == NULL || pl == NULL || err == NULL)
 		return;
 
 	num_nodes = count_array(ninfo_arr);
+	chunk_size = mt_chunk_size(num_nodes);
 
-	tid = *((int *) pthread_getspecific(th_id_key));
-	if (tid != 0 || num_threads <= 1) {
-		/* don't use multi-threading if I am a worker thread or num_threads is 1 */
+	if (num_threads <= 1 || num_nodes <= chunk_size) {
+		/* don't use multi-threading if num_threads is 1 or there is only one chunk */
 		tdata = alloc_tdata_nd_eligible(pl, resresv, ninfo_arr, 0, num_nodes - 1);
 		if (tdata == NULL)
 			return;
@@ -5230,44 +5838,34 @@ check_node_array_eligibility(node_info **ninfo_arr, resource_resv *resresv, plac
 	} else { /* We are multithreading */
 		int j;
 		int num_tasks;
-		int chunk_size = num_nodes / num_threads;
-		chunk_size = (chunk_size > MT_CHUNK_SIZE_MIN) ? chunk_size : MT_CHUNK_SIZE_MIN;
+
+		tasks = static_cast<th_task_info *>(calloc(num_nodes / chunk_size + 1, sizeof(th_task_info)));
+		if (tasks == NULL) {
+			log_err(errno, __func__, MEM_ERR_MSG);
+			return;
+		}
 		for (j = 0, num_tasks = 0; num_nodes > 0;
 		     num_tasks++, j += chunk_size, num_nodes -= chunk_size) {
 			tdata = alloc_tdata_nd_eligible(pl, resresv, ninfo_arr, j, j + chunk_size - 1);
 			if (tdata == NULL)
 				break;
 
-			task = static_cast<th_task_info *>(malloc(sizeof(th_task_info)));
-			if (task == NULL) {
-				free(tdata);
-				log_err(errno, __func__, MEM_ERR_MSG);
-				break;
-			}
-			task->task_type = TS_IS_ND_ELIGIBLE;
-			task->thread_data = (void *) tdata;
-
-			queue_work_for_threads(task);
+			tasks[num_tasks].task_type = TS_IS_ND_ELIGIBLE;
+			tasks[num_tasks].thread_data = (void *) tdata;
 		}
 
-		/* Get results from worker threads */
-		for (int i = 0; i < num_tasks;) {
-			pthread_mutex_lock(&result_lock);
-			while (ds_queue_is_empty(result_queue))
-				pthread_cond_wait(&result_cond, &result_lock);
-			while (!ds_queue_is_empty(result_queue)) {
-				task = static_cast<th_task_info *>(ds_dequeue(result_queue));
-				tdata = static_cast<th_data_nd_eligible *>(task->thread_data);
-				if (err->status_code == SCHD_UNKWN && tdata->err->status_code != SCHD_UNKWN)
-					copy_schd_error(err, tdata->err);
-
-				free_schd_error(tdata->err);
-				free(tdata);
-				free(task);
-				i++;
-			}
-			pthread_mutex_unlock(&result_lock);
+		run_tasks(tasks, num_tasks);
+
+		/* Collect the results in chunk order */
+		for (int i = 0; i < num_tasks; i++) {
+			tdata = static_cast<th_data_nd_eligible *>(tasks[i].thread_data);
+			if (err->status_code == SCHD_UNKWN && tdata->err->status_code != SCHD_UNKWN)
+				copy_schd_error(err, tdata->err);
+
+			free_schd_error(tdata->err);
+			free(tdata);
 		}
+		free(tasks);
 	}
 }
 
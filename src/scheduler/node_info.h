@@ -99,6 +99,11 @@ int is_node_timeshared(node_info *node, void *arg);
  */
 node_info *find_node_info(node_info **ninfo_arr, const std::string &nodename);
 
+/*
+ *      find_node_by_name - find a server node by name using the node name index
+ */
+node_info *find_node_by_name(server_info *sinfo, const std::string &nodename);
+
 /*
  *      dup_node_info - duplicate a node by creating a new one and coping all
  *                      the data into the new
@@ -260,6 +265,20 @@ int compare_place(place *pl1, place *pl2);
  */
 selspec *parse_selspec(const std::string &sspec);
 
+/*
+ *	find_selspec - return a shared, read-only parsed select spec
+ *		       release with free_selspec()
+ */
+selspec *find_selspec(const std::string &sspec);
+
+/*
+ *	find_placespec - return a copy of a cached parsed placement spec
+ */
+place *find_placespec(char *place_str);
+
+/* forget all cached select and place specs */
+void clear_spec_cache();
+
 /* compare two selspecs to see if they are equal*/
 int compare_selspec(selspec *s1, selspec *s2);
 
@@ -540,6 +559,12 @@ void set_current_eoe(node_info *node, char *eoe);
 void
 check_node_eligibility_chunk(th_data_nd_eligible *data);
 
+/*
+ * Evaluate a single placement set for eval_selspec() on a worker thread
+ */
+void
+eval_nodepart_chunk(th_data_eval_nodepart *data);
+
 /* check nodes for eligibility and mark them ineligible if not */
 void check_node_array_eligibility(node_info **ninfo_arr, resource_resv *resresv, place *pl, schd_error *err);
 
@@ -553,6 +578,8 @@ int add_node_events(timed_event *te, void *arg1, void *arg2);
 
 struct batch_status *send_statvnode(int virtual_fd, char *id, struct attrl *attrib, char *extend);
 
+int send_statvnode_stream(int virtual_fd, char *id, struct attrl *attrib, char *extend, pbs_status_cb cb, void *arg);
+
 /*
  * Find a node by its hostname
  */
@@ -59,6 +59,9 @@
  * 	resresv_can_fit_nodepart()
  * 	create_specific_nodepart()
  * 	create_placement_sets()
+ * 	sort_nodepart_array()
+ * 	sort_all_nodepart()
+ * 	update_all_nodepart()
  *
  */
 #include <pbs_config.h>
@@ -88,6 +91,9 @@
 #include "globals.h"
 #include "sort.h"
 #include "buckets.h"
+#include "cycle_stats.h"
+#include <algorithm>
+#include <unordered_map>
 #include <vector>
 
 /**
@@ -110,6 +116,7 @@ new_node_partition()
 
 	np->ok_break = false;
 	np->excl = false;
+	np->resort = true;
 	np->name = NULL;
 	np->def = NULL;
 	np->res_val = NULL;
@@ -253,9 +260,11 @@ dup_node_partition(node_partition *onp, server_info *nsinfo)
 
 	nnp->ok_break = onp->ok_break;
 	nnp->excl = onp->excl;
+	nnp->resort = onp->resort;
 	nnp->tot_nodes = onp->tot_nodes;
 	nnp->free_nodes = onp->free_nodes;
 	nnp->res = dup_resource_list(onp->res);
+	index_resource_list(nnp->res);
 	nnp->ninfo_arr = copy_node_ptr_array(onp->ninfo_arr, nsinfo->nodes);
 
 	nnp->bkts = dup_node_bucket_array(onp->bkts, nsinfo);
@@ -352,15 +361,11 @@ find_node_partition_by_rank(node_partition **np_arr, int rank)
 /**
  * @brief
  * 		break apart nodes into partitions
- *		A possible side-effect of this function when multiple identical
- *		resources are defined on an attribute, is that the node
- *		partitions accounting for this node may count this node in the
- *		total count of "free_nodes" for that partition (if the node was
- *		free in the first place). Due to this, incorrect accounting,
- *		the metadata of the node partition may cause eval_selspec to
- *		descend into the node matching code instead of bailing out right
- *		away due to the fact that the node partition has insufficient
- *		resources.
+ *		This is done in one pass over the nodes.  Partitions are looked up
+ *		by name in a hash so the cost doesn't grow with the number of
+ *		partitions.  The partitions are created in the order their resource
+ *		values are first seen, and the nodes in each partition are in the
+ *		same order as in the nodes array.
  *
  * @param[in]	policy	-	policy info
  * @param[in]	nodes	-	the nodes which to create partitions from
@@ -379,15 +384,13 @@ node_partition **
 create_node_partitions(status *policy, node_info **nodes, const std::vector<std::string> &resnames, unsigned int flags, int *num_parts)
 {
 	node_partition **np_arr;
-	node_partition *np;
 	node_partition **tmp_arr;
 	int np_arr_size = 0;
-	static schd_resource *res;
+	schd_resource *res;
+	schd_resource *tmpres;
 
 	int num_nodes;
 
-	schd_resource *tmpres;
-
 	int val_i;  /* index of placement set resource value */
 	int node_i; /* index into nodes array */
 	int np_i;   /* index into node partition array we are creating */
@@ -395,6 +398,8 @@ create_node_partitions(status *policy, node_info **nodes, const std::vector<std:
 	static schd_resource *unset_res = NULL;
 
 	std::vector<queue_info *> queues;
+	std::unordered_map<std::string, int> np_index; /* partition name to index into np_arr */
+	std::vector<std::vector<int>> members;	       /* indices into nodes of each partition */
 
 	if (nodes == NULL || resnames.empty())
 		return NULL;
@@ -433,129 +438,119 @@ create_node_partitions(status *policy, node_info **nodes, const std::vector<std:
 				}
 				res = unset_res;
 			}
-			if (res != NULL) {
-				/* Incase of indirect resource, point it to the right place */
-				if (res->indirect_res != NULL)
-					res = res->indirect_res;
-				for (val_i = 0; res->str_avail[val_i] != NULL; val_i++) {
-					std::string str = res_i + "=" + res->str_avail[val_i];
-					/* If we find the partition, we've already created it - add the node
-					 * to the existing partition.  If we don't find it, we create it.
-					 */
-					np = find_node_partition(np_arr, str);
-					if (np == NULL) {
-						if (np_i >= np_arr_size) {
-							tmp_arr = static_cast<node_partition **>(realloc(np_arr,
-													 (np_arr_size * 2 + 1) * sizeof(node_partition *)));
-							if (tmp_arr == NULL) {
-								log_err(errno, __func__, MEM_ERR_MSG);
-								free_node_partition_array(np_arr);
-								return NULL;
-							}
-							np_arr = tmp_arr;
-							np_arr_size *= 2;
-						}
+			if (res == NULL)
+				/* we ignore nodes without the node partition resource set
+				 * unless the NP_CREATE_REST flag is set
+				 */
+				continue;
 
-						np_arr[np_i] = new_node_partition();
-						if (np_arr[np_i] != NULL) {
-							np_arr[np_i]->name = string_dup(str.c_str());
-							np_arr[np_i]->def = def;
-							np_arr[np_i]->res_val = string_dup(res->str_avail[val_i]);
-							np_arr[np_i]->tot_nodes = 1;
-							if (nodes[node_i]->is_free)
-								np_arr[np_i]->free_nodes = 1;
-							np_arr[np_i]->rank = get_sched_rank();
-
-							if (np_arr[np_i]->res_val == NULL) {
-								np_arr[np_i + 1] = NULL;
-								free_node_partition_array(np_arr);
-								return NULL;
-							}
-
-							np_i++;
-							np_arr[np_i] = NULL;
-						} else {
+			/* Incase of indirect resource, point it to the right place */
+			if (res->indirect_res != NULL)
+				res = res->indirect_res;
+			for (val_i = 0; res->str_avail[val_i] != NULL; val_i++) {
+				std::string str = res_i + "=" + res->str_avail[val_i];
+				/* If we find the partition, we've already created it - add the node
+				 * to the existing partition.  If we don't find it, we create it.
+				 */
+				auto it = np_index.find(str);
+				if (it == np_index.end()) {
+					if (np_i >= np_arr_size) {
+						tmp_arr = static_cast<node_partition **>(realloc(np_arr,
+												 (np_arr_size * 2 + 1) * sizeof(node_partition *)));
+						if (tmp_arr == NULL) {
+							log_err(errno, __func__, MEM_ERR_MSG);
 							free_node_partition_array(np_arr);
 							return NULL;
 						}
-					} else {
-						np->tot_nodes++;
-						if (nodes[node_i]->is_free)
-							np->free_nodes++;
+						np_arr = tmp_arr;
+						np_arr_size *= 2;
 					}
+
+					np_arr[np_i] = new_node_partition();
+					if (np_arr[np_i] == NULL) {
+						free_node_partition_array(np_arr);
+						return NULL;
+					}
+					np_arr[np_i]->name = string_dup(str.c_str());
+					np_arr[np_i]->def = def;
+					np_arr[np_i]->res_val = string_dup(res->str_avail[val_i]);
+					np_arr[np_i]->rank = get_sched_rank();
+					np_arr[np_i + 1] = NULL;
+
+					if (np_arr[np_i]->name == NULL || np_arr[np_i]->res_val == NULL) {
+						free_node_partition_array(np_arr);
+						return NULL;
+					}
+
+					it = np_index.emplace(str, np_i).first;
+					members.emplace_back();
+					np_i++;
 				}
+				/* a node can have the same value more than once */
+				auto &mem = members[it->second];
+				if (mem.empty() || mem.back() != node_i)
+					mem.push_back(node_i);
 			}
-			/* else we ignore nodes without the node partition resource set
-			 * unless the NP_CREATE_REST flag is set
-			 */
 		}
 	}
 
-	/* now that we have a list of node partitions and number of nodes in each
+	/* now that we have a list of node partitions and the nodes in each
 	 * lets allocate a node array and fill it
 	 */
 
 	for (np_i = 0; np_arr[np_i] != NULL; np_i++) {
-		int i = 0;
-		np_arr[np_i]->ok_break = 1;
+		node_partition *np = np_arr[np_i];
+		auto &mem = members[np_i];
 		schd_resource *hostres = NULL;
 
-		np_arr[np_i]->ninfo_arr =
-			static_cast<node_info **>(malloc((np_arr[np_i]->tot_nodes + 1) * sizeof(node_info *)));
+		/* multiple resource names with the same value land in the same
+		 * partition.  Keep the nodes in node array order.
+		 */
+		if (resnames.size() > 1) {
+			std::sort(mem.begin(), mem.end());
+			mem.erase(std::unique(mem.begin(), mem.end()), mem.end());
+		}
+
+		np->ok_break = 1;
+		np->tot_nodes = mem.size();
+		np->ninfo_arr = static_cast<node_info **>(malloc((np->tot_nodes + 1) * sizeof(node_info *)));
 
-		if (np_arr[np_i]->ninfo_arr == NULL) {
+		if (np->ninfo_arr == NULL) {
+			log_err(errno, __func__, MEM_ERR_MSG);
 			free_node_partition_array(np_arr);
 			return NULL;
 		}
 
-		np_arr[np_i]->ninfo_arr[0] = NULL;
-
-		for (node_i = 0; nodes[node_i] != NULL && i < np_arr[np_i]->tot_nodes; node_i++) {
-			if (nodes[node_i]->is_stale)
-				continue;
-
-			res = find_resource(nodes[node_i]->res, np_arr[np_i]->def);
-			if (res == NULL && (flags & NP_CREATE_REST)) {
-				set_resource(unset_res, "\"\"", RF_AVAIL);
-				res = unset_res;
-			}
-			if (res != NULL) {
-				/* Incase of indirect resource, point it to the right place */
-				if (res->indirect_res != NULL)
-					res = res->indirect_res;
-				if (compare_res_to_str(res, np_arr[np_i]->res_val, CMP_CASE)) {
-					if (np_arr[np_i]->ok_break) {
-						tmpres = find_resource(nodes[node_i]->res, allres["host"]);
-						if (tmpres != NULL) {
-							if (hostres == NULL)
-								hostres = tmpres;
-							else {
-								if (!compare_res_to_str(hostres, tmpres->str_avail[0], CMP_CASELESS))
-									np_arr[np_i]->ok_break = 0;
-							}
-						}
+		for (int i = 0; i < np->tot_nodes; i++) {
+			node_info *ninfo = nodes[mem[i]];
+
+			if (np->ok_break) {
+				tmpres = find_resource(ninfo->res, allres["host"]);
+				if (tmpres != NULL) {
+					if (hostres == NULL)
+						hostres = tmpres;
+					else {
+						if (!compare_res_to_str(hostres, tmpres->str_avail[0], CMP_CASELESS))
+							np->ok_break = 0;
 					}
-					if (!(NP_NO_ADD_NP_ARR & flags)) {
-						tmp_arr = static_cast<node_partition **>(add_ptr_to_array(nodes[node_i]->np_arr, np_arr[np_i]));
-						if (tmp_arr == NULL) {
-							free_node_partition_array(np_arr);
-							return NULL;
-						}
-						nodes[node_i]->np_arr = tmp_arr;
-					}
-
-					np_arr[np_i]->ninfo_arr[i] = nodes[node_i];
-					i++;
-					np_arr[np_i]->ninfo_arr[i] = NULL;
 				}
 			}
+			if (!(NP_NO_ADD_NP_ARR & flags)) {
+				tmp_arr = static_cast<node_partition **>(add_ptr_to_array(ninfo->np_arr, np));
+				if (tmp_arr == NULL) {
+					np->ninfo_arr[i] = NULL;
+					free_node_partition_array(np_arr);
+					return NULL;
+				}
+				ninfo->np_arr = tmp_arr;
+			}
+
+			np->ninfo_arr[i] = ninfo;
 		}
-		/* if multiple resource values are present, tot_nodes may be incorrect.
-		 * recalculating tot_nodes for each node partition.
-		 */
-		np_arr[np_i]->tot_nodes = count_array(np_arr[np_i]->ninfo_arr);
-		np_arr[np_i]->bkts = create_node_buckets(policy, np_arr[np_i]->ninfo_arr, queues, NO_PRINT_BUCKETS);
-		node_partition_update(policy, np_arr[np_i]);
+		np->ninfo_arr[np->tot_nodes] = NULL;
+
+		np->bkts = create_node_buckets(policy, np->ninfo_arr, queues, NO_PRINT_BUCKETS);
+		node_partition_update(policy, np);
 	}
 
 	*num_parts = np_i;
@@ -563,7 +558,8 @@ create_node_partitions(status *policy, node_info **nodes, const std::vector<std:
 }
 
 /**
- * @brief update the node buckets associated with a node
+ * @brief update the node buckets associated with a node.  A node is in at
+ *	  most one bucket of an array.
  *
  *  @param[in] bkts - the buckets to update
  *  @param[in] ninfo - the node of the job/resv
@@ -606,6 +602,7 @@ update_buckets_for_node(node_bucket **bkts, node_info *ninfo)
 					bkts[i]->free_pool->truth_ct++;
 				}
 			}
+			break;
 		}
 	}
 }
@@ -665,6 +662,27 @@ node_partition_update_array(status *policy, node_partition **nodepart)
 	return rc;
 }
 
+/**
+ * @brief
+ * 		fill in the values cmp_placement_sets() sorts a node partition by
+ *
+ * @param[in]	np	-	the node partition
+ * @param[out]	keys	-	the sort keys
+ *
+ * @return void
+ */
+static void
+nodepart_sort_keys(node_partition *np, sch_resource_t keys[NP_SORT_KEYS])
+{
+	schd_resource *ncpus = find_resource(np->res, allres["ncpus"]);
+	schd_resource *mem = find_resource(np->res, allres["mem"]);
+
+	keys[0] = ncpus != NULL ? ncpus->avail : 0;
+	keys[1] = ncpus != NULL ? ncpus->assigned : 0;
+	keys[2] = mem != NULL ? mem->avail : 0;
+	keys[3] = mem != NULL ? mem->assigned : 0;
+}
+
 /**
  * @brief
  * 		update the meta data about a node partition
@@ -686,12 +704,15 @@ node_partition_update(status *policy, node_partition *np)
 	int rc = 1;
 	schd_resource *res;
 	unsigned int arl_flags = USE_RESOURCE_LIST | ADD_ALL_BOOL;
+	sch_resource_t old_keys[NP_SORT_KEYS] = {0};
+	sch_resource_t new_keys[NP_SORT_KEYS] = {0};
 
 	if (np == NULL)
 		return 0;
 
 	/* if res is not NULL, we are updating.  Clear the meta data for the update*/
 	if (np->res != NULL) {
+		nodepart_sort_keys(np, old_keys);
 		arl_flags |= NO_UPDATE_NON_CONSUMABLE;
 		for (res = np->res; res != NULL; res = res->next) {
 			if (res->type.is_consumable) {
@@ -719,11 +740,19 @@ node_partition_update(status *policy, node_partition *np)
 			break;
 		}
 	}
+	index_resource_list(np->res);
+
+	if (!(arl_flags & NO_UPDATE_NON_CONSUMABLE))
+		np->resort = true;
+	else {
+		nodepart_sort_keys(np, new_keys);
+		if (memcmp(old_keys, new_keys, sizeof(old_keys)))
+			np->resort = true;
+	}
 
 	if (!policy->node_sort->empty() && conf.node_sort_unused) {
 		/* Resort the nodes in the partition so that selection works correctly. */
-		qsort(np->ninfo_arr, np->tot_nodes, sizeof(node_info *),
-		      multi_node_sort);
+		resort_array(np->ninfo_arr, np->tot_nodes, multi_node_sort);
 	}
 
 	return rc;
@@ -1104,6 +1133,7 @@ create_specific_nodepart(status *policy, const char *name, node_info **nodes, in
 bool
 create_placement_sets(status *policy, server_info *sinfo)
 {
+	phase_timer timer(PHASE_PLACEMENT_SETS);
 	bool is_success = true;
 
 	sinfo->allpart = create_specific_nodepart(policy, "all", sinfo->unassoc_nodes, NO_FLAGS);
@@ -1143,8 +1173,7 @@ create_placement_sets(status *policy, server_info *sinfo)
 							 &sinfo->num_parts);
 
 		if (sinfo->nodepart != NULL) {
-			qsort(sinfo->nodepart, sinfo->num_parts,
-			      sizeof(node_partition *), cmp_placement_sets);
+			sort_nodepart_array(sinfo->nodepart, sinfo->num_parts);
 		} else {
 			log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_SERVER, LOG_DEBUG, "",
 				  "Failed to create node partitions for server");
@@ -1175,8 +1204,7 @@ create_placement_sets(status *policy, server_info *sinfo)
 								 ngkey, sc_attrs.only_explicit_psets ? NP_NONE : NP_CREATE_REST,
 								 &(qinfo->num_parts));
 			if (qinfo->nodepart != NULL) {
-				qsort(qinfo->nodepart, qinfo->num_parts,
-				      sizeof(node_partition *), cmp_placement_sets);
+				sort_nodepart_array(qinfo->nodepart, qinfo->num_parts);
 			} else {
 				log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_QUEUE, LOG_DEBUG, qinfo->name,
 					  "Failed to create node partitions for queue.");
@@ -1187,6 +1215,61 @@ create_placement_sets(status *policy, server_info *sinfo)
 	return is_success;
 }
 
+/**
+ * @brief
+ *		sort an array of placement sets with cmp_placement_sets().
+ *		Only the placement sets whose sort keys changed since the array was
+ *		last sorted are moved.  The rest are still in order, so the moved ones
+ *		are sorted on their own and merged back in.  The result is the same as
+ *		a stable sort of the whole array.
+ *
+ * @param[in,out]	np_arr	-	the placement sets to sort
+ * @param[in]	num_parts	-	number of placement sets in np_arr
+ *
+ * @return void
+ */
+void
+sort_nodepart_array(node_partition **np_arr, int num_parts)
+{
+	/* a placement set and its position in the array before sorting */
+	typedef std::pair<node_partition *, int> np_pos;
+	std::vector<np_pos> clean;
+	std::vector<np_pos> dirty;
+
+	if (np_arr == NULL || num_parts <= 0)
+		return;
+
+	for (int i = 0; i < num_parts; i++) {
+		if (np_arr[i]->resort)
+			dirty.emplace_back(np_arr[i], i);
+		else
+			clean.emplace_back(np_arr[i], i);
+		np_arr[i]->resort = false;
+	}
+
+	if (dirty.empty())
+		return;
+
+	auto cmp = [](const np_pos &p1, const np_pos &p2) {
+		int rc = cmp_placement_sets(&p1.first, &p2.first);
+		if (rc != 0)
+			return rc < 0;
+		return p1.second < p2.second;
+	};
+
+	std::sort(dirty.begin(), dirty.end(), cmp);
+
+	int i = 0;
+	auto c = clean.begin();
+	auto d = dirty.begin();
+	while (c != clean.end() || d != dirty.end()) {
+		if (d == dirty.end() || (c != clean.end() && !cmp(*d, *c)))
+			np_arr[i++] = (c++)->first;
+		else
+			np_arr[i++] = (d++)->first;
+	}
+}
+
 /**
  * @brief sort all placement sets (server's psets, queue's psets, and hostsets)
  * @param[in] policy - policy info
@@ -1200,18 +1283,16 @@ sort_all_nodepart(status *policy, server_info *sinfo)
 		return;
 
 	if (sinfo->node_group_enable && !sinfo->node_group_key.empty())
-		qsort(sinfo->nodepart, sinfo->num_parts,
-		      sizeof(node_partition *), cmp_placement_sets);
+		sort_nodepart_array(sinfo->nodepart, sinfo->num_parts);
 
 	for (auto qinfo : sinfo->queues) {
 
 		if (sinfo->node_group_enable && !qinfo->node_group_key.empty())
-			qsort(qinfo->nodepart, qinfo->num_parts,
-			      sizeof(node_partition *), cmp_placement_sets);
+			sort_nodepart_array(qinfo->nodepart, qinfo->num_parts);
 	}
 	if (!policy->node_sort->empty() && conf.node_sort_unused && sinfo->hostsets != NULL) {
 		/* Resort the nodes in host sets to correctly reflect unused resources */
-		qsort(sinfo->hostsets, sinfo->num_hostsets, sizeof(node_partition *), multi_nodepart_sort);
+		resort_array(sinfo->hostsets, sinfo->num_hostsets, multi_nodepart_sort);
 	}
 }
 
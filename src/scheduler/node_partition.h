@@ -156,6 +156,16 @@ int node_partition_update_array(status *policy, node_partition **nodepart);
  */
 int node_partition_update(status *policy, node_partition *np);
 
+/* number of values cmp_placement_sets() sorts a node partition by */
+#define NP_SORT_KEYS 4
+
+/*
+ *	sort_nodepart_array - sort an array of placement sets with
+ *			      cmp_placement_sets(), only moving the ones whose
+ *			      sort keys changed since it was last sorted
+ */
+void sort_nodepart_array(node_partition **np_arr, int num_parts);
+
 /*
  *	free_np_cache_array - destructor for array
  */
@@ -100,6 +100,9 @@ config::config() : fairshare_res("cput"), fairshare_ent("euser")
 	node_sort_unused = 0;
 	resv_conf_ignore = 0;
 	allow_aoe_calendar = 0;
+	incr_job_query = 0;
+	parallel_pset_eval = 0;
+	cycle_stats = 0;
 #ifdef NAS /* localmod 034 */
 	prime_sto = 0;
 	non_prime_sto = 0;
@@ -110,6 +113,7 @@ config::config() : fairshare_res("cput"), fairshare_ent("euser")
 	prime_spill = 0;
 	nonprime_spill = 0;
 	decay_time = 86400;
+	dyn_res_cache_ttl = 0;
 	ignore_res.insert("mpiprocs");
 	ignore_res.insert("ompthreads");
 	memset(prime, 0, sizeof(prime));
@@ -117,6 +121,10 @@ config::config() : fairshare_res("cput"), fairshare_ent("euser")
 	unknown_shares = 0;		      /* unknown group shares */
 	max_preempt_attempts = SCHD_INFINITY; /* max num of preempt attempts per cyc*/
 	max_jobs_to_check = SCHD_INFINITY;    /* max number of jobs to check in cyc*/
+	job_trace_sample = 0;		      /* trace every Nth job considered */
+	fast_path_jobs = 0;		      /* fast path cycles are off */
+	fast_path_full_interval = 60;	      /* full cycle at least every minute */
+	peer_queue_max_jobs = 0;	      /* consider every queued peer job */
 	fairshare_decay_factor = .5;	      /* decay factor used when decaying fairshare tree */
 #ifdef NAS
 	/* localmod 034 */
@@ -284,6 +292,40 @@ parse_config(const char *fname)
 					tmpconf.enforce_no_shares = num ? 1 : 0;
 				else if (!strcmp(config_name, PARSE_ALLOW_AOE_CALENDAR))
 					tmpconf.allow_aoe_calendar = 1;
+				else if (!strcmp(config_name, PARSE_INCR_JOB_QUERY))
+					tmpconf.incr_job_query = num ? 1 : 0;
+				else if (!strcmp(config_name, PARSE_PARALLEL_PSET_EVAL))
+					tmpconf.parallel_pset_eval = num ? 1 : 0;
+				else if (!strcmp(config_name, PARSE_CYCLE_STATS))
+					tmpconf.cycle_stats = num ? 1 : 0;
+				else if (!strcmp(config_name, PARSE_JOB_TRACE_SAMPLE)) {
+					if (num < 0) {
+						error = true;
+						sprintf(errbuf, "%s must be a number of jobs", PARSE_JOB_TRACE_SAMPLE);
+					} else
+						tmpconf.job_trace_sample = num;
+				}
+				else if (!strcmp(config_name, PARSE_FAST_PATH_JOBS)) {
+					if (num < 0) {
+						error = true;
+						sprintf(errbuf, "%s must be a number of jobs", PARSE_FAST_PATH_JOBS);
+					} else
+						tmpconf.fast_path_jobs = num;
+				}
+				else if (!strcmp(config_name, PARSE_FAST_PATH_FULL_INTERVAL)) {
+					if (num < 0) {
+						error = true;
+						sprintf(errbuf, "%s must be a number of seconds", PARSE_FAST_PATH_FULL_INTERVAL);
+					} else
+						tmpconf.fast_path_full_interval = num;
+				}
+				else if (!strcmp(config_name, PARSE_PEER_QUEUE_MAX_JOBS)) {
+					if (num < 0) {
+						error = true;
+						sprintf(errbuf, "%s must be a number of jobs", PARSE_PEER_QUEUE_MAX_JOBS);
+					} else
+						tmpconf.peer_queue_max_jobs = num;
+				}
 				else if (!strcmp(config_name, PARSE_PRIME_SPILL)) {
 					if (prime == PRIME || prime == PT_ALL)
 						tmpconf.prime_spill = res_to_num(config_value, &type);
@@ -307,6 +349,12 @@ parse_config(const char *fname)
 						snprintf(errbuf, sizeof(errbuf), "Invalid time %s", config_value);
 						error = true;
 					}
+				} else if (!strcmp(config_name, PARSE_SERVER_DYN_RES_CACHE_TTL)) {
+					tmpconf.dyn_res_cache_ttl = res_to_num(config_value, &type);
+					if ((!type.is_time && !type.is_num) || tmpconf.dyn_res_cache_ttl < 0) {
+						snprintf(errbuf, sizeof(errbuf), "Invalid time %s", config_value);
+						error = true;
+					}
 				} else if (!strcmp(config_name, PARSE_UNKNOWN_SHARES))
 					tmpconf.unknown_shares = num;
 				else if (!strcmp(config_name, PARSE_FAIRSHARE_DECAY_FACTOR)) {
@@ -353,6 +401,13 @@ parse_config(const char *fname)
 						tmpconf.ignore_res.insert(strarr[i]);
 					free_string_array(strarr);
 
+				} else if (!strcmp(config_name, PARSE_JOB_TRACE_JOBS)) {
+					char **strarr;
+
+					strarr = break_comma_list(config_value);
+					for (int i = 0; strarr[i] != NULL; i++)
+						tmpconf.job_trace_jobs.insert(strarr[i]);
+					free_string_array(strarr);
 				} else if (!strcmp(config_name, PARSE_RESV_CONFIRM_IGNORE)) {
 					if (!strcmp(config_value, "dedicated_time"))
 						tmpconf.resv_conf_ignore = 1;
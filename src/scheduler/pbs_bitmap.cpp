@@ -43,6 +43,36 @@
 #include "pbs_bitmap.h"
 
 #define BYTES_TO_BITS(x) ((x) *8)
+#define BITS_PER_LONG BYTES_TO_BITS(sizeof(unsigned long))
+
+/*
+ * Word level helpers.  With gcc/clang these compile down to single
+ * instructions (tzcnt/popcnt where the target has them).
+ */
+#if defined(__GNUC__)
+#define LONG_CTZ(w) __builtin_ctzl(w)
+#define LONG_POPCOUNT(w) __builtin_popcountl(w)
+#else
+static inline int
+LONG_CTZ(unsigned long w)
+{
+	int i;
+
+	for (i = 0; !(w & 1UL); i++)
+		w >>= 1;
+	return i;
+}
+
+static inline int
+LONG_POPCOUNT(unsigned long w)
+{
+	int i;
+
+	for (i = 0; w != 0; i++)
+		w &= w - 1;
+	return i;
+}
+#endif
 
 /**
  * @brief allocate space for a pbs_bitmap (and possibly the bitmap itself)
@@ -212,8 +242,7 @@ int
 pbs_bitmap_next_on_bit(pbs_bitmap *pbm, unsigned long start_bit)
 {
 	unsigned long long_ind;
-	long bit;
-	size_t i;
+	unsigned long w;
 
 	if (pbm == NULL)
 		return -1;
@@ -221,36 +250,20 @@ pbs_bitmap_next_on_bit(pbs_bitmap *pbm, unsigned long start_bit)
 	if (start_bit >= pbm->num_bits)
 		return -1;
 
-	long_ind = start_bit / BYTES_TO_BITS(sizeof(unsigned long));
-	bit = start_bit % BYTES_TO_BITS(sizeof(unsigned long));
-
-	/* special case - look at first long that contains start_bit */
-	if (pbm->bits[long_ind] != 0) {
-		for (i = bit + 1; i < BYTES_TO_BITS(sizeof(unsigned long)); i++) {
-			if (pbm->bits[long_ind] & (1UL << i)) {
-				return (long_ind * BYTES_TO_BITS(sizeof(unsigned long)) + i);
-			}
-		}
-
-		/* didn't find an on bit after start_bit_index in the long that contained start_bit */
-		if (long_ind < pbm->num_longs) {
-			long_ind++;
-		}
-	}
+	long_ind = start_bit / BITS_PER_LONG;
 
-	for (; long_ind < pbm->num_longs && pbm->bits[long_ind] == 0; long_ind++)
-		;
-
-	if (long_ind == pbm->num_longs)
-		return -1;
+	/* special case - look at first long that contains start_bit.
+	 * Mask off start_bit and everything below it.
+	 */
+	w = pbm->bits[long_ind] & ~(~0UL >> (BITS_PER_LONG - 1 - start_bit % BITS_PER_LONG));
 
-	for (i = 0; i < BYTES_TO_BITS(sizeof(unsigned long)); i++) {
-		if (pbm->bits[long_ind] & (1UL << i)) {
-			return (long_ind * BYTES_TO_BITS(sizeof(unsigned long)) + i);
-		}
+	while (w == 0) {
+		if (++long_ind >= pbm->num_longs)
+			return -1;
+		w = pbm->bits[long_ind];
 	}
 
-	return -1;
+	return long_ind * BITS_PER_LONG + LONG_CTZ(w);
 }
 
 /**
@@ -330,3 +343,158 @@ pbs_bitmap_is_equal(pbs_bitmap *L, pbs_bitmap *R)
 
 	return 1;
 }
+
+/**
+ * @brief pbs_bitmap version of L &= R
+ * @param L - bitmap lvalue
+ * @param R - bitmap rvalue
+ * @return int
+ * @retval 1 success
+ * @retval 0 failure
+ */
+int
+pbs_bitmap_and(pbs_bitmap *L, pbs_bitmap *R)
+{
+	unsigned long i;
+	unsigned long n;
+
+	if (L == NULL || R == NULL)
+		return 0;
+
+	n = (L->num_longs < R->num_longs) ? L->num_longs : R->num_longs;
+	for (i = 0; i < n; i++)
+		L->bits[i] &= R->bits[i];
+	/* bits past the end of R are off */
+	for (; i < L->num_longs; i++)
+		L->bits[i] = 0;
+
+	return 1;
+}
+
+/**
+ * @brief pbs_bitmap version of L |= R
+ * @param L - bitmap lvalue
+ * @param R - bitmap rvalue
+ * @return int
+ * @retval 1 success
+ * @retval 0 failure
+ */
+int
+pbs_bitmap_or(pbs_bitmap *L, pbs_bitmap *R)
+{
+	unsigned long i;
+
+	if (L == NULL || R == NULL)
+		return 0;
+
+	/* See pbs_bitmap_assign() on why we allocate R's full num_longs */
+	if (R->num_longs > L->num_longs) {
+		unsigned long num_bits = L->num_bits;
+
+		if (pbs_bitmap_alloc(L, BYTES_TO_BITS(R->num_longs * sizeof(unsigned long))) == NULL)
+			return 0;
+		L->num_bits = num_bits;
+	}
+	if (R->num_bits > L->num_bits)
+		L->num_bits = R->num_bits;
+
+	for (i = 0; i < R->num_longs; i++)
+		L->bits[i] |= R->bits[i];
+
+	return 1;
+}
+
+/**
+ * @brief pbs_bitmap version of L &= ~R
+ * @param L - bitmap lvalue
+ * @param R - bitmap rvalue
+ * @return int
+ * @retval 1 success
+ * @retval 0 failure
+ */
+int
+pbs_bitmap_andnot(pbs_bitmap *L, pbs_bitmap *R)
+{
+	unsigned long i;
+	unsigned long n;
+
+	if (L == NULL || R == NULL)
+		return 0;
+
+	n = (L->num_longs < R->num_longs) ? L->num_longs : R->num_longs;
+	for (i = 0; i < n; i++)
+		L->bits[i] &= ~R->bits[i];
+
+	return 1;
+}
+
+/**
+ * @brief count the number of on bits in a bitmap
+ * @param pbm - the bitmap
+ * @return unsigned long
+ * @retval number of on bits
+ */
+unsigned long
+pbs_bitmap_count(pbs_bitmap *pbm)
+{
+	unsigned long i;
+	unsigned long cnt = 0;
+
+	if (pbm == NULL)
+		return 0;
+
+	for (i = 0; i < pbm->num_longs; i++)
+		cnt += LONG_POPCOUNT(pbm->bits[i]);
+
+	return cnt;
+}
+
+/**
+ * @brief set out to the first n on bits of a bitmap
+ * @param pbm - the bitmap
+ * @param n - number of on bits to find
+ * @param out - the first n on bits of pbm.  Its other bits are turned off.
+ * @return long
+ * @retval number of on bits set in out (less than n if pbm doesn't have n)
+ * @retval -1 on error
+ */
+long
+pbs_bitmap_first_n_on_bits(pbs_bitmap *pbm, unsigned long n, pbs_bitmap *out)
+{
+	unsigned long i;
+	unsigned long cnt = 0;
+
+	if (pbm == NULL || out == NULL)
+		return -1;
+
+	if (out->num_longs < pbm->num_longs)
+		if (pbs_bitmap_alloc(out, pbm->num_longs * BITS_PER_LONG) == NULL)
+			return -1;
+	if (out->num_bits < pbm->num_bits)
+		out->num_bits = pbm->num_bits;
+
+	for (i = 0; i < pbm->num_longs && cnt < n; i++) {
+		unsigned long w = pbm->bits[i];
+		unsigned long pc = LONG_POPCOUNT(w);
+
+		if (cnt + pc > n) {
+			unsigned long keep = 0;
+
+			/* only take the lowest n - cnt bits of this long */
+			for (; cnt < n; cnt++) {
+				unsigned long low = w & (~w + 1);
+				keep |= low;
+				w ^= low;
+			}
+			out->bits[i] = keep;
+		} else {
+			out->bits[i] = w;
+			cnt += pc;
+		}
+	}
+	/* everything after the n'th on bit is off */
+	for (; i < out->num_longs; i++)
+		out->bits[i] = 0;
+
+	return cnt;
+}
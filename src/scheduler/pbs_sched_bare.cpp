@@ -161,6 +161,7 @@ scheduling_cycle_bare(int sd, const sched_cmd *cmd)
 	}
 
 	main_sched_loop_bare(sd, sinfo);
+	flush_run_jobs(sd);
 
 	end_cycle_tasks(sinfo);
 
@@ -182,6 +183,8 @@ scheduling_cycle_bare(int sd, const sched_cmd *cmd)
 static int
 schedule_bare(int sd, const sched_cmd *cmd)
 {
+	wait_cycle_teardown();
+
 	switch (cmd->cmd) {
 		case SCH_SCHEDULE_NULL:
 		case SCH_RULESET:
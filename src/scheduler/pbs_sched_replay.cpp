@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file    pbs_sched_replay.cpp
+ *
+ * @brief
+ *	pbs_sched_replay - run a captured scheduling cycle (see replay.cpp)
+ *	without a server, to time the scheduler on a real workload.
+ *
+ *	usage: pbs_sched_replay [-n iterations] [-t threads[,threads...]] [-d work_dir] capture_file
+ *
+ *	The cycle is run the given number of times for each thread count.  The
+ *	captured sched_priv files are written into work_dir (default: the
+ *	current directory), which is also where the log is written.  The stats
+ *	of each cycle (see cycle_stats.cpp) are printed to stdout as one line
+ *	of JSON and a summary of the wall times is printed to stderr.
+ *
+ *	Peer queues are not replayed and nothing is sent to a server: run
+ *	requests and attribute updates are dropped and preemption fails.
+ */
+#include <pbs_config.h> /* the master config generated by configure */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "cycle_stats.h"
+#include "data_types.h"
+#include "fifo.h"
+#include "globals.h"
+#include "libpbs.h"
+#include "log.h"
+#include "replay.h"
+#include "resource.h"
+
+static const char *usage = "[-n iterations] [-t threads[,threads...]] [-d work_dir] capture_file";
+
+/**
+ * @brief	parse a comma separated list of thread counts
+ *
+ * @return	bool
+ * @retval	true	success
+ * @retval	false	a count is not a positive number
+ */
+static bool
+parse_threads(const char *str, std::vector<int> &threads)
+{
+	const char *p = str;
+	char *endp;
+
+	threads.clear();
+	while (*p != '\0') {
+		long n = strtol(p, &endp, 10);
+
+		if (endp == p || n < 1 || (*endp != ',' && *endp != '\0'))
+			return false;
+		threads.push_back(static_cast<int>(n));
+		p = *endp == ',' ? endp + 1 : endp;
+	}
+	return !threads.empty();
+}
+
+/**
+ * @brief	run the captured cycle once
+ *
+ * @param[in]	sd	-	the connection handed to the cycle
+ * @param[in]	nthreads	-	number of worker threads, < 1 for number of cores
+ *
+ * @return	double
+ * @retval	wall seconds of the cycle
+ * @retval	-1 on error
+ */
+static double
+replay_cycle(int sd, int nthreads)
+{
+	struct timespec start;
+	struct timespec end;
+	sched_cmd cmd;
+
+	if (replay_rewind() != 0)
+		return -1;
+
+	if (schedinit(nthreads) != 0)
+		return -1;
+
+	/* peer servers are not part of the capture */
+	conf.peer_queues.clear();
+	conf.cycle_stats = 1;
+
+	update_resource_defs(sd);
+	if (!set_validate_sched_attrs(sd))
+		return -1;
+
+	/* every iteration has to start from the same state */
+	last_running.clear();
+
+	cmd.cmd = SCH_SCHEDULE_NEW;
+	cmd.jid = NULL;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	scheduling_cycle(sd, &cmd);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	/* the universe is freed behind the cycle, as it is in pbs_sched */
+	wait_cycle_teardown();
+
+	printf("%s\n", cycle_stats_last().c_str());
+	fflush(stdout);
+
+	return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+int
+main(int argc, char *argv[])
+{
+	int c;
+	int errflg = 0;
+	int iterations = 1;
+	std::vector<int> threads = {-1};
+	const char *work_dir = NULL;
+	char cwd[MAXPATHLEN + 1];
+	char *endp;
+	int sd;
+
+	if (set_msgdaemonname(const_cast<char *>("pbs_sched_replay"))) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+
+	while ((c = getopt(argc, argv, "n:t:d:")) != EOF) {
+		switch (c) {
+			case 'n':
+				iterations = strtol(optarg, &endp, 10);
+				if (*endp != '\0' || iterations < 1) {
+					fprintf(stderr, "%s: bad number of iterations\n", optarg);
+					errflg = 1;
+				}
+				break;
+			case 't':
+				if (!parse_threads(optarg, threads)) {
+					fprintf(stderr, "%s: bad num threads value\n", optarg);
+					errflg = 1;
+				}
+				break;
+			case 'd':
+				work_dir = optarg;
+				break;
+			default:
+				errflg = 1;
+				break;
+		}
+	}
+	if (errflg || optind != argc - 1) {
+		fprintf(stderr, "usage: %s %s\n", argv[0], usage);
+		return 1;
+	}
+
+	/* only needed for PBS_EXEC (e.g., the zoneinfo directory) */
+	pbs_loadconf(0);
+	if (pbs_client_thread_init_thread_context() != 0) {
+		fprintf(stderr, "%s: Unable to initialize thread context\n", argv[0]);
+		return 1;
+	}
+
+	if (work_dir != NULL && chdir(work_dir) == -1) {
+		perror(work_dir);
+		return 1;
+	}
+	if (getcwd(cwd, sizeof(cwd)) == NULL) {
+		perror("getcwd");
+		return 1;
+	}
+	if (log_open(NULL, cwd) == -1) {
+		fprintf(stderr, "%s: logfile could not be opened\n", argv[0]);
+		return 1;
+	}
+
+	if (replay_load(argv[optind]) != 0) {
+		fprintf(stderr, "%s: can not load the capture, see the log in %s\n", argv[0], cwd);
+		return 1;
+	}
+	sc_name = replay_sched_name();
+	dflt_sched = replay_dflt_sched();
+
+	/* nothing is sent to the server, the handle only has to be a valid fd */
+	if ((sd = open("/dev/null", O_RDWR)) == -1) {
+		perror("/dev/null");
+		return 1;
+	}
+
+	for (auto nthreads : threads) {
+		double min = 0;
+		double max = 0;
+		double total = 0;
+
+		for (int i = 0; i < iterations; i++) {
+			double wall = replay_cycle(sd, nthreads);
+
+			if (wall < 0) {
+				fprintf(stderr, "%s: the cycle could not be run, see the log in %s\n", argv[0], cwd);
+				return 1;
+			}
+			if (i == 0 || wall < min)
+				min = wall;
+			if (wall > max)
+				max = wall;
+			total += wall;
+		}
+		fprintf(stderr, "threads %d: %d cycles, wall min %.6f avg %.6f max %.6f\n",
+			num_threads, iterations, min, total / iterations, max);
+	}
+
+	close(sd);
+	log_close(1);
+
+	return 0;
+}
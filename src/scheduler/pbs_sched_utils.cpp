@@ -76,6 +76,7 @@
 #include "config.h"
 #include "fifo.h"
 #include "globals.h"
+#include "job_info.h"
 #include "libpbs.h"
 #include "libsec.h"
 #include "list_link.h"
@@ -86,6 +87,7 @@
 #include "pbs_ecl.h"
 #include "pbs_error.h"
 #include "pbs_ifl.h"
+#include "pbs_metrics.h"
 #include "pbs_share.h"
 #include "pbs_version.h"
 #include "portability.h"
@@ -124,10 +126,18 @@ extern char *msg_startup1;
 
 pthread_mutex_t cleanup_lock;
 
+#define SCHED_METRICS_SOCK "metrics.sock"
+
+/* time spent on each scheduling command, served on SCHED_METRICS_SOCK */
+static pbs_hist_t sched_cmd_hist[SCH_CMD_HIGH];
+static time_t sched_last_cycle;			/* start of the last command */
+static unsigned long long sched_last_cycle_us; /* duration of the last command */
+
 static void reconnect_server(void);
 void sched_svr_init(void);
 void open_server_conns();
 static int schedule_wrapper(sched_cmd *cmd, int opt_no_restart);
+static void sched_metrics_publish(void);
 void close_server_conns(void);
 
 typedef int (*schedule_func)(int, const sched_cmd *);
@@ -815,6 +825,7 @@ sched_main(int argc, char *argv[], schedule_func sched_ptr)
 	set_log_conf(pbs_conf.pbs_leaf_name, pbs_conf.pbs_mom_node_name,
 		     pbs_conf.locallog, pbs_conf.syslogfac,
 		     pbs_conf.syslogsvr, pbs_conf.pbs_log_highres_timestamp);
+	set_log_journal(pbs_conf.pbs_log_journal);
 
 	nthreads = pbs_conf.pbs_sched_threads;
 
@@ -1096,6 +1107,10 @@ sched_main(int argc, char *argv[], schedule_func sched_ptr)
 	if (sigprocmask(SIG_SETMASK, &oldsigs, NULL) == -1)
 		log_err(errno, __func__, "sigprocmask(SIG_SETMASK)");
 
+	/* pick up the queued job cache the last instance left behind */
+	if (conf.incr_job_query)
+		restore_queued_job_cache();
+
 	/* Initialize cleanup lock */
 	if (init_mutex_attr_recursive(&attr) != 0)
 		die(0);
@@ -1104,6 +1119,13 @@ sched_main(int argc, char *argv[], schedule_func sched_ptr)
 
 	open_server_conns();
 
+	if (pbs_conf.pbs_metrics_export > 0) {
+		if (pbs_metrics_export_start(SCHED_METRICS_SOCK) == 0)
+			sched_metrics_publish();
+		else
+			log_err(errno, __func__, "unable to serve " SCHED_METRICS_SOCK);
+	}
+
 	for (go = 1; go;) {
 		int i;
 
@@ -1167,6 +1189,7 @@ static int
 schedule_wrapper(sched_cmd *cmd, int opt_no_restart)
 {
 	time_t now;
+	unsigned long long start;
 
 	if (sigprocmask(SIG_BLOCK, &allsigs, &oldsigs) == -1)
 		log_err(errno, __func__, "sigprocmask(SIG_BLOCK)");
@@ -1183,13 +1206,66 @@ schedule_wrapper(sched_cmd *cmd, int opt_no_restart)
 	}
 #endif
 
+	start = pbs_metrics_now_us();
 	if (schedule_ptr(clust_primary_sock, cmd)) /* magic happens here */
 		return 1;
 	else
 		send_cycle_end();
 
+	sched_last_cycle = now;
+	sched_last_cycle_us = pbs_metrics_now_us() - start;
+	if (cmd->cmd >= 0 && cmd->cmd < SCH_CMD_HIGH)
+		pbs_hist_add(&sched_cmd_hist[cmd->cmd], sched_last_cycle_us);
+	if (pbs_conf.pbs_metrics_export > 0)
+		sched_metrics_publish();
+
 	if (sigprocmask(SIG_SETMASK, &oldsigs, NULL) == -1)
 		log_err(errno, __func__, "sigprocmask(SIG_SETMASK)");
 
 	return 0;
 }
+
+/**
+ * @brief
+ *	sched_metrics_publish - hand a snapshot of the scheduling command
+ *	times to the thread serving SCHED_METRICS_SOCK.  Called after every
+ *	command, so the snapshot is never older than the last cycle.
+ *
+ * @return void
+ */
+static void
+sched_metrics_publish(void)
+{
+	char *text = NULL;
+	size_t len = 0;
+	char labels[32];
+	FILE *fp;
+	int i;
+
+	if ((fp = open_memstream(&text, &len)) == NULL) {
+		log_err(errno, __func__, "open_memstream");
+		return;
+	}
+
+	fprintf(fp, "# TYPE pbs_sched_last_cycle_start_time gauge\n"
+		    "pbs_sched_last_cycle_start_time %ld\n",
+		(long) sched_last_cycle);
+	fprintf(fp, "# TYPE pbs_sched_last_cycle_seconds gauge\n"
+		    "pbs_sched_last_cycle_seconds %g\n",
+		sched_last_cycle_us / 1e6);
+	fprintf(fp, "# TYPE pbs_sched_cycle_seconds histogram\n");
+	for (i = 0; i < SCH_CMD_HIGH; i++) {
+		if (sched_cmd_hist[i].count == 0)
+			continue;
+		snprintf(labels, sizeof(labels), "cmd=\"%d\"", i);
+		pbs_hist_print_prom(fp, "pbs_sched_cycle_seconds", labels, &sched_cmd_hist[i]);
+	}
+
+	if (ferror(fp)) {
+		fclose(fp);
+		free(text);
+		return;
+	}
+	fclose(fp);
+	pbs_metrics_export_publish(text);
+}
@@ -175,7 +175,7 @@ query_queues(status *policy, int pbs_sd, server_info *sinfo)
 
 			if (ret != QUEUE_NOT_EXEC) {
 				/* get all the jobs which reside in the queue */
-				qinfo->jobs = query_jobs(policy, pbs_sd, qinfo, NULL, qinfo->name);
+				qinfo->jobs = query_jobs(policy, pbs_sd, qinfo, NULL, qinfo->name, NULL);
 
 				if (qinfo->is_ded_queue)
 					sinfo->has_ded_queue = true;
@@ -203,7 +203,7 @@ query_queues(status *policy, int pbs_sd, server_info *sinfo)
 							pq.peer_sd = peer_sd;
 							qinfo->is_peer_queue = 1;
 							/* get peered jobs */
-							qinfo->jobs = query_jobs(policy, peer_sd, qinfo, qinfo->jobs, pq.remote_queue);
+							qinfo->jobs = query_jobs(policy, peer_sd, qinfo, qinfo->jobs, pq.remote_queue, &pq);
 						}
 					}
 				}
@@ -0,0 +1,823 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file    replay.cpp
+ *
+ * @brief
+ * 		replay.cpp - This file contains functions to capture the input of
+ *		a scheduling cycle to a file and to replay it without a server.
+ *
+ *		Touching CYCLE_CAPTURE_TOUCH in sched_priv makes the next cycle
+ *		write everything it gets from the server (the server, vnode,
+ *		queue, job, reservation, scheduler and resource definition
+ *		statuses) and the sched_priv configuration files to
+ *		CYCLE_CAPTURE_FILE.  pbs_sched_replay reads that file back and runs
+ *		the cycle against it, answering the server queries in the order
+ *		they were made.  Requests the cycle sends to the server are dropped.
+ *
+ *		The file is text.  Strings are written as <length>:<bytes>, with
+ *		a length of -1 for a NULL string:
+ *			PBS_SCHED_CAPTURE <version>
+ *			T <cycle time>
+ *			S <default scheduler> <scheduler name>
+ *			F <file name> <file contents>		(per sched_priv file)
+ *			R <key> <number of objects>		(per query result)
+ *			O <name> <text> <number of attributes>	(per object)
+ *			A <name> <resource> <value> <op>	(per attribute)
+ *			E
+ *
+ * Functions included are:
+ * 	capture_check_start()
+ * 	capture_end()
+ * 	capture_record()
+ * 	capture_active()
+ * 	replay_active()
+ * 	replay_load()
+ * 	replay_rewind()
+ * 	replay_next()
+ * 	replay_time()
+ * 	replay_sched_name()
+ * 	replay_dflt_sched()
+ * 	write_status_file()
+ * 	read_status_file()
+ *
+ */
+
+#include <pbs_config.h>
+
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <attribute.h>
+#include <log.h>
+#include <pbs_error.h>
+#include <pbs_ifl.h>
+#include <pbs_share.h>
+
+#include "config.h"
+#include "globals.h"
+#include "replay.h"
+
+#define CAPTURE_MAGIC "PBS_SCHED_CAPTURE"
+#define CAPTURE_VERSION 1
+
+/* the sched_priv files which are part of a capture */
+static const char *capture_files[] = {
+	CONFIG_FILE,
+	HOLIDAYS_FILE,
+	RESGROUP_FILE,
+	DEDTIME_FILE,
+	USAGE_FILE,
+	FORMULA_FILENAME,
+	NULL};
+
+/* the capture being written, NULL if the cycle is not being captured */
+static FILE *capture_fp = NULL;
+
+/* scheduler and resource definition statuses are not queried every cycle,
+ * so the latest ones are kept to be written at the start of a capture
+ */
+static std::string last_statsched;
+static std::string last_statrsc;
+
+/* the capture being replayed */
+static struct {
+	bool active = false;
+	std::string buf; /* contents of the capture file */
+	time_t cycle_time = 0;
+	std::string sched_name;
+	bool dflt_sched = true;
+	std::vector<std::pair<std::string, std::string>> files;
+	std::unordered_map<std::string, std::vector<size_t>> records; /* offset of each result by key */
+	std::unordered_map<std::string, size_t> cursor;		      /* next result to hand out by key */
+} rp;
+
+/**
+ * @brief	append a string in <length>:<bytes> form
+ */
+static void
+put_str(std::string &out, const char *str)
+{
+	if (str == NULL)
+		out += "-1:";
+	else {
+		out += std::to_string(strlen(str));
+		out += ':';
+		out += str;
+	}
+}
+
+/**
+ * @brief	append a string which may hold NUL bytes in <length>:<bytes> form
+ */
+static void
+put_str(std::string &out, const std::string &str)
+{
+	out += std::to_string(str.size());
+	out += ':';
+	out += str;
+}
+
+/**
+ * @brief	append a query result to out
+ *
+ * @param[out]	out	-	string to append to
+ * @param[in]	key	-	what the result is for (e.g., REPLAY_STATVNODE)
+ * @param[in]	bs	-	the result
+ *
+ * @return	void
+ */
+static void
+put_record(std::string &out, const std::string &key, struct batch_status *bs)
+{
+	int count = 0;
+
+	for (auto b = bs; b != NULL; b = b->next)
+		count++;
+
+	out += "R ";
+	put_str(out, key.c_str());
+	out += ' ' + std::to_string(count) + '\n';
+	for (auto b = bs; b != NULL; b = b->next) {
+		int nattr = 0;
+
+		for (auto a = b->attribs; a != NULL; a = a->next)
+			nattr++;
+		out += "O ";
+		put_str(out, b->name);
+		out += ' ';
+		put_str(out, b->text);
+		out += ' ' + std::to_string(nattr) + '\n';
+		for (auto a = b->attribs; a != NULL; a = a->next) {
+			out += "A ";
+			put_str(out, a->name);
+			out += ' ';
+			put_str(out, a->resource);
+			out += ' ';
+			put_str(out, a->value);
+			out += ' ' + std::to_string(static_cast<int>(a->op)) + '\n';
+		}
+	}
+}
+
+/**
+ * @brief	read a whole file into a string
+ *
+ * @return	bool
+ * @retval	true	the file was read
+ * @retval	false	the file could not be opened or read
+ */
+static bool
+read_file(const char *name, std::string &contents)
+{
+	FILE *fp;
+	char buf[8192];
+	size_t len;
+
+	if ((fp = fopen(name, "r")) == NULL)
+		return false;
+	contents.clear();
+	while ((len = fread(buf, 1, sizeof(buf), fp)) > 0)
+		contents.append(buf, len);
+	if (ferror(fp)) {
+		fclose(fp);
+		return false;
+	}
+	fclose(fp);
+	return true;
+}
+
+/**
+ * @brief	start capturing the cycle to CYCLE_CAPTURE_FILE if an admin
+ *		asked for it by creating CYCLE_CAPTURE_TOUCH
+ *
+ * @param[in]	cycle_time	-	the time the cycle is run at
+ *
+ * @return	void
+ */
+void
+capture_check_start(time_t cycle_time)
+{
+	std::string out;
+
+	if (rp.active || capture_fp != NULL || access(CYCLE_CAPTURE_TOUCH, F_OK) != 0)
+		return;
+
+	remove(CYCLE_CAPTURE_TOUCH);
+	if ((capture_fp = fopen(CYCLE_CAPTURE_FILE, "w")) == NULL) {
+		log_err(errno, __func__, "Can not open " CYCLE_CAPTURE_FILE);
+		return;
+	}
+
+	out = CAPTURE_MAGIC " " + std::to_string(CAPTURE_VERSION) + '\n';
+	out += "T " + std::to_string(static_cast<long>(cycle_time)) + '\n';
+	out += "S " + std::to_string(dflt_sched ? 1 : 0) + ' ';
+	put_str(out, sc_name);
+	out += '\n';
+	for (int i = 0; capture_files[i] != NULL; i++) {
+		std::string contents;
+
+		if (!read_file(capture_files[i], contents))
+			continue;
+		out += "F ";
+		put_str(out, capture_files[i]);
+		out += ' ';
+		put_str(out, contents);
+		out += '\n';
+	}
+	out += last_statsched;
+	out += last_statrsc;
+	fwrite(out.data(), 1, out.size(), capture_fp);
+
+	log_event(PBSEVENT_SCHED, PBS_EVENTCLASS_SCHED, LOG_NOTICE, __func__,
+		  "Capturing the input of this cycle to " CYCLE_CAPTURE_FILE);
+}
+
+/**
+ * @brief	finish the capture of the cycle
+ *
+ * @return	void
+ */
+void
+capture_end()
+{
+	int err;
+
+	if (capture_fp == NULL)
+		return;
+
+	fputs("E\n", capture_fp);
+	err = ferror(capture_fp);
+	if (fclose(capture_fp) != 0 || err)
+		log_err(errno, __func__, "Failed to write " CYCLE_CAPTURE_FILE);
+	else
+		log_event(PBSEVENT_SCHED, PBS_EVENTCLASS_SCHED, LOG_NOTICE, __func__,
+			  "The input of the cycle was captured to " CYCLE_CAPTURE_FILE);
+	capture_fp = NULL;
+}
+
+/**
+ * @brief	record a server query result if the cycle is being captured
+ *
+ * @param[in]	key	-	what the result is for (e.g., REPLAY_STATVNODE)
+ * @param[in]	bs	-	the result
+ *
+ * @return	struct batch_status *
+ * @retval	bs
+ */
+struct batch_status *
+capture_record(const std::string &key, struct batch_status *bs)
+{
+	if (key == REPLAY_STATSCHED) {
+		last_statsched.clear();
+		put_record(last_statsched, key, bs);
+	} else if (key == REPLAY_STATRSC) {
+		last_statrsc.clear();
+		put_record(last_statrsc, key, bs);
+	} else if (capture_fp != NULL) {
+		std::string out;
+
+		put_record(out, key, bs);
+		fwrite(out.data(), 1, out.size(), capture_fp);
+	}
+
+	return bs;
+}
+
+/**
+ * @brief	is the current cycle being captured?
+ */
+bool
+capture_active()
+{
+	return capture_fp != NULL;
+}
+
+/**
+ * @brief	are we replaying a capture?
+ */
+bool
+replay_active()
+{
+	return rp.active;
+}
+
+/**
+ * @brief	skip the white space at pos
+ */
+static void
+skip_space(const std::string &buf, size_t &pos)
+{
+	while (pos < buf.size() && isspace(static_cast<unsigned char>(buf[pos])))
+		pos++;
+}
+
+/**
+ * @brief	read a number at pos
+ */
+static bool
+get_long(const std::string &buf, size_t &pos, long &val)
+{
+	char *endp;
+
+	skip_space(buf, pos);
+	if (pos >= buf.size())
+		return false;
+	val = strtol(buf.c_str() + pos, &endp, 10);
+	if (endp == buf.c_str() + pos)
+		return false;
+	pos = endp - buf.c_str();
+	return true;
+}
+
+/**
+ * @brief	read a <length>:<bytes> string at pos
+ *
+ * @param[in]	buf	-	the capture
+ * @param[in,out]	pos	-	where to read, moved past the string
+ * @param[out]	str	-	the string, NULL for a NULL string.  Free with free().
+ *				If str is NULL itself, the string is only skipped.
+ *
+ * @return	bool
+ * @retval	true	success
+ * @retval	false	malformed capture
+ */
+static bool
+get_str(const std::string &buf, size_t &pos, char **str)
+{
+	long len;
+
+	if (!get_long(buf, pos, len) || pos >= buf.size() || buf[pos] != ':')
+		return false;
+	pos++;
+	if (len < 0) {
+		if (str != NULL)
+			*str = NULL;
+		return true;
+	}
+	if (static_cast<size_t>(len) > buf.size() - pos)
+		return false;
+	if (str != NULL) {
+		if ((*str = static_cast<char *>(malloc(len + 1))) == NULL)
+			return false;
+		memcpy(*str, buf.data() + pos, len);
+		(*str)[len] = '\0';
+	}
+	pos += len;
+	return true;
+}
+
+/**
+ * @brief	read a <length>:<bytes> string which may hold NUL bytes at pos
+ */
+static bool
+get_str(const std::string &buf, size_t &pos, std::string &str)
+{
+	long len;
+
+	if (!get_long(buf, pos, len) || pos >= buf.size() || buf[pos] != ':')
+		return false;
+	pos++;
+	if (len < 0 || static_cast<size_t>(len) > buf.size() - pos)
+		return false;
+	str.assign(buf, pos, len);
+	pos += len;
+	return true;
+}
+
+/**
+ * @brief	check that the next token at pos is tok and move past it
+ */
+static bool
+get_token(const std::string &buf, size_t &pos, const char *tok)
+{
+	size_t len = strlen(tok);
+
+	skip_space(buf, pos);
+	if (buf.compare(pos, len, tok) != 0)
+		return false;
+	pos += len;
+	return true;
+}
+
+/**
+ * @brief	read the objects of a query result
+ *
+ * @param[in]	buf	-	the capture
+ * @param[in,out]	pos	-	start of the result (after its key), moved past it
+ * @param[in]	build	-	build the batch_status list or just skip the result
+ * @param[out]	ok	-	false if the capture is malformed
+ *
+ * @return	struct batch_status *
+ * @retval	the result (free with pbs_statfree())
+ * @retval	NULL if the result was empty, not built or on error
+ */
+static struct batch_status *
+get_record(const std::string &buf, size_t &pos, bool build, bool &ok)
+{
+	struct batch_status *head = NULL;
+	struct batch_status **tail = &head;
+	long count;
+
+	ok = false;
+	if (!get_long(buf, pos, count))
+		return NULL;
+
+	for (long i = 0; i < count; i++) {
+		struct batch_status *bs = NULL;
+		struct attrl **atail = NULL;
+		long nattr;
+
+		if (build) {
+			if ((bs = static_cast<struct batch_status *>(calloc(1, sizeof(struct batch_status)))) == NULL)
+				goto err;
+			*tail = bs;
+			tail = &bs->next;
+			atail = &bs->attribs;
+		}
+		if (!get_token(buf, pos, "O") ||
+		    !get_str(buf, pos, build ? &bs->name : NULL) ||
+		    !get_str(buf, pos, build ? &bs->text : NULL) ||
+		    !get_long(buf, pos, nattr))
+			goto err;
+
+		for (long j = 0; j < nattr; j++) {
+			struct attrl *attr = NULL;
+			long op;
+
+			if (build) {
+				if ((attr = new_attrl()) == NULL)
+					goto err;
+				*atail = attr;
+				atail = &attr->next;
+			}
+			if (!get_token(buf, pos, "A") ||
+			    !get_str(buf, pos, build ? &attr->name : NULL) ||
+			    !get_str(buf, pos, build ? &attr->resource : NULL) ||
+			    !get_str(buf, pos, build ? &attr->value : NULL) ||
+			    !get_long(buf, pos, op))
+				goto err;
+			if (build)
+				attr->op = static_cast<enum batch_op>(op);
+		}
+	}
+
+	ok = true;
+	return head;
+
+err:
+	pbs_statfree(head);
+	return NULL;
+}
+
+/**
+ * @brief	load a capture for replay
+ *
+ * @param[in]	file	-	the capture file
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	the file can not be read or is not a capture
+ */
+int
+replay_load(const char *file)
+{
+	size_t pos = 0;
+	bool done = false;
+	long version;
+	long num;
+	char *str;
+
+	if (!read_file(file, rp.buf)) {
+		log_errf(errno, __func__, "Can not read %s", file);
+		return -1;
+	}
+
+	if (!get_token(rp.buf, pos, CAPTURE_MAGIC) || !get_long(rp.buf, pos, version) || version != CAPTURE_VERSION) {
+		log_errf(-1, __func__, "%s is not a version %d cycle capture", file, CAPTURE_VERSION);
+		return -1;
+	}
+
+	rp.files.clear();
+	rp.records.clear();
+	while (true) {
+		if (get_token(rp.buf, pos, "E")) {
+			done = true;
+			break;
+		}
+		if (get_token(rp.buf, pos, "T")) {
+			if (!get_long(rp.buf, pos, num))
+				break;
+			rp.cycle_time = num;
+		} else if (get_token(rp.buf, pos, "S")) {
+			if (!get_long(rp.buf, pos, num) || !get_str(rp.buf, pos, &str))
+				break;
+			rp.dflt_sched = num != 0;
+			rp.sched_name = str != NULL ? str : "";
+			free(str);
+		} else if (get_token(rp.buf, pos, "F")) {
+			std::string name;
+			std::string contents;
+
+			if (!get_str(rp.buf, pos, name) || !get_str(rp.buf, pos, contents))
+				break;
+			rp.files.emplace_back(name, contents);
+		} else if (get_token(rp.buf, pos, "R")) {
+			bool ok;
+
+			if (!get_str(rp.buf, pos, &str) || str == NULL)
+				break;
+			rp.records[str].push_back(pos);
+			free(str);
+			get_record(rp.buf, pos, false, ok);
+			if (!ok)
+				break;
+		} else
+			break;
+	}
+
+	if (!done) {
+		log_errf(-1, __func__, "%s is malformed at offset %lu", file, static_cast<unsigned long>(pos));
+		return -1;
+	}
+
+	rp.active = true;
+	return replay_rewind();
+}
+
+/**
+ * @brief	start the replay from the top and put the captured sched_priv
+ *		files back into the current directory
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	a file could not be written
+ */
+int
+replay_rewind()
+{
+	rp.cursor.clear();
+
+	for (const auto &f : rp.files) {
+		FILE *fp;
+
+		if ((fp = fopen(f.first.c_str(), "w")) == NULL) {
+			log_errf(errno, __func__, "Can not write %s", f.first.c_str());
+			return -1;
+		}
+		fwrite(f.second.data(), 1, f.second.size(), fp);
+		fclose(fp);
+	}
+
+	return 0;
+}
+
+/**
+ * @brief	return the next captured result of a query
+ *
+ * @par	The scheduler's comment, sched_priv and sched_log attributes are
+ *	changed to point to the replay's directory so a multisched capture
+ *	does not try to use the directories of the scheduler it came from.
+ *
+ * @param[in]	key	-	what the result is for (e.g., REPLAY_STATVNODE)
+ *
+ * @return	struct batch_status *
+ * @retval	the result, free with pbs_statfree()
+ * @retval	NULL if it was empty or there are no more results for the key
+ */
+struct batch_status *
+replay_next(const std::string &key)
+{
+	struct batch_status *bs;
+	bool ok;
+
+	pbs_errno = PBSE_NONE;
+
+	auto rit = rp.records.find(key);
+	if (rit == rp.records.end())
+		return NULL;
+
+	/* the scheduler and resource definitions are not queried every cycle,
+	 * the one captured is handed out every time they are asked for
+	 */
+	auto &cur = rp.cursor[key];
+	if (cur >= rit->second.size()) {
+		if (key != REPLAY_STATSCHED && key != REPLAY_STATRSC)
+			return NULL;
+		cur = rit->second.size() - 1;
+	}
+
+	size_t pos = rit->second[cur++];
+	bs = get_record(rp.buf, pos, true, ok);
+
+	if (key == REPLAY_STATSCHED) {
+		char cwd[MAXPATHLEN + 1];
+
+		if (getcwd(cwd, sizeof(cwd)) == NULL)
+			strcpy(cwd, ".");
+		for (auto b = bs; b != NULL; b = b->next) {
+			struct attrl **prev = &b->attribs;
+
+			while (*prev != NULL) {
+				struct attrl *attr = *prev;
+
+				if (!strcmp(attr->name, ATTR_comment)) {
+					*prev = attr->next;
+					attr->next = NULL;
+					free_attrl(attr);
+					continue;
+				}
+				if (!strcmp(attr->name, ATTR_sched_priv) || !strcmp(attr->name, ATTR_sched_log)) {
+					free(attr->value);
+					attr->value = strdup(cwd);
+				}
+				prev = &attr->next;
+			}
+		}
+	}
+
+	return bs;
+}
+
+/**
+ * @brief	the time the captured cycle ran at, 0 if not replaying
+ */
+time_t
+replay_time()
+{
+	return rp.active ? rp.cycle_time : 0;
+}
+
+/**
+ * @brief	name of the scheduler which made the capture
+ */
+const char *
+replay_sched_name()
+{
+	return rp.sched_name.c_str();
+}
+
+/**
+ * @brief	was the capture made by the default scheduler?
+ */
+bool
+replay_dflt_sched()
+{
+	return rp.dflt_sched;
+}
+
+/**
+ * @brief	write query results to a file in the record format of a capture.
+ *		Used to keep scheduler caches across restarts.  The file is
+ *		written under a temporary name and renamed, so a reader never
+ *		sees half of it.
+ *
+ * @param[in]	file	-	the file to write
+ * @param[in]	magic	-	first word of the file
+ * @param[in]	version	-	version of the file's contents
+ * @param[in]	records	-	key and result of each record
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	the file could not be written
+ */
+int
+write_status_file(const char *file, const char *magic, int version,
+		  const std::vector<std::pair<std::string, struct batch_status *>> &records)
+{
+	std::string tmp = std::string(file) + ".new";
+	std::string out;
+	FILE *fp;
+	int err;
+
+	if ((fp = fopen(tmp.c_str(), "w")) == NULL) {
+		log_errf(errno, __func__, "Can not open %s", tmp.c_str());
+		return -1;
+	}
+
+	out = std::string(magic) + ' ' + std::to_string(version) + '\n';
+	fwrite(out.data(), 1, out.size(), fp);
+	for (const auto &r : records) {
+		out.clear();
+		put_record(out, r.first, r.second);
+		fwrite(out.data(), 1, out.size(), fp);
+	}
+	fputs("E\n", fp);
+
+	err = ferror(fp);
+	if (fclose(fp) != 0 || err || rename(tmp.c_str(), file) != 0) {
+		log_errf(errno, __func__, "Failed to write %s", file);
+		unlink(tmp.c_str());
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief	read the records of a file written by write_status_file()
+ *
+ * @param[in]	file	-	the file to read
+ * @param[in]	magic	-	the file's expected first word
+ * @param[in]	version	-	the file's expected version
+ * @param[out]	records	-	key and result of each record, free the
+ *				results with pbs_statfree()
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	the file does not exist, is of another version or
+ *			is malformed
+ */
+int
+read_status_file(const char *file, const char *magic, int version,
+		 std::vector<std::pair<std::string, struct batch_status *>> &records)
+{
+	std::string buf;
+	size_t pos = 0;
+	long fversion;
+	bool ok = true;
+	char *key;
+
+	if (!read_file(file, buf))
+		return -1;
+
+	if (!get_token(buf, pos, magic) || !get_long(buf, pos, fversion) || fversion != version) {
+		log_eventf(PBSEVENT_SCHED, PBS_EVENTCLASS_FILE, LOG_NOTICE, file,
+			   "Not a version %d file, ignoring it", version);
+		return -1;
+	}
+
+	while (!get_token(buf, pos, "E")) {
+		struct batch_status *bs;
+
+		if (!get_token(buf, pos, "R") || !get_str(buf, pos, &key) || key == NULL) {
+			ok = false;
+			break;
+		}
+		bs = get_record(buf, pos, true, ok);
+		if (!ok) {
+			free(key);
+			break;
+		}
+		records.emplace_back(key, bs);
+		free(key);
+	}
+
+	if (!ok) {
+		log_eventf(PBSEVENT_SCHED, PBS_EVENTCLASS_FILE, LOG_NOTICE, file,
+			   "File is malformed at offset %lu, ignoring it", static_cast<unsigned long>(pos));
+		for (auto &r : records)
+			pbs_statfree(r.second);
+		records.clear();
+		return -1;
+	}
+
+	return 0;
+}
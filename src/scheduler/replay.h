@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+#ifndef _REPLAY_H
+#define _REPLAY_H
+
+#include <time.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "pbs_ifl.h"
+
+/* names the server query results are recorded under in a capture */
+#define REPLAY_STATSERVER "statserver"
+#define REPLAY_STATVNODE "statvnode"
+#define REPLAY_STATQUEUE "statqueue"
+#define REPLAY_STATRESV "statresv"
+#define REPLAY_STATSCHED "statsched"
+#define REPLAY_STATRSC "statrsc"
+#define REPLAY_JOBS "jobs "	/* followed by the queue name */
+
+/*
+ *	capture_check_start - start capturing the cycle if CYCLE_CAPTURE_TOUCH exists
+ */
+void capture_check_start(time_t cycle_time);
+
+/*
+ *	capture_end - finish the capture of the cycle, if one is being made
+ */
+void capture_end();
+
+/*
+ *	capture_record - record a server query result if the cycle is being captured
+ *
+ *	return bs
+ */
+struct batch_status *capture_record(const std::string &key, struct batch_status *bs);
+
+/*
+ *	capture_active - is the current cycle being captured?
+ */
+bool capture_active();
+
+/*
+ *	replay_active - are server queries answered from a capture?
+ */
+bool replay_active();
+
+/*
+ *	replay_load - load a capture and write its sched_priv files into
+ *		      the current directory
+ *
+ *	return 0 on success, -1 on error
+ */
+int replay_load(const char *file);
+
+/*
+ *	replay_rewind - start the replay of the captured cycle from the top and
+ *			put back the captured sched_priv files
+ *
+ *	return 0 on success, -1 on error
+ */
+int replay_rewind();
+
+/*
+ *	replay_next - return a copy of the next recorded result for key
+ *		      (free with pbs_statfree())
+ */
+struct batch_status *replay_next(const std::string &key);
+
+/*
+ *	replay_time - the time the captured cycle started, 0 if not replaying
+ */
+time_t replay_time();
+
+/*
+ *	replay_sched_name - name of the scheduler the capture was made by
+ */
+const char *replay_sched_name();
+
+/*
+ *	replay_dflt_sched - was the capture made by the default scheduler?
+ */
+bool replay_dflt_sched();
+
+/*
+ *	write_status_file - write query results to file in the record format
+ *			    of a capture (e.g., to keep a cache across restarts)
+ *
+ *	return 0 on success, -1 on error
+ */
+int write_status_file(const char *file, const char *magic, int version,
+		      const std::vector<std::pair<std::string, struct batch_status *>> &records);
+
+/*
+ *	read_status_file - read back the records of write_status_file()
+ *
+ *	return 0 on success, -1 if the file is missing, of another version or malformed
+ */
+int read_status_file(const char *file, const char *magic, int version,
+		     std::vector<std::pair<std::string, struct batch_status *>> &records);
+
+#endif /* _REPLAY_H */
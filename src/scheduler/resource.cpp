@@ -81,6 +81,9 @@
 #include "sort.h"
 #include "parse.h"
 #include "fifo.h"
+#include "formula.h"
+#include "node_info.h"
+#include "buckets.h"
 
 /**
  * @brief
@@ -97,6 +100,7 @@ query_resources(int pbs_sd)
 	struct batch_status *cur_bs; /* used to iterate over resources */
 	struct attrl *attrp;	     /* iterate over resource fields */
 	std::unordered_map<std::string, resdef *> tmpres;
+	int index = 0;
 
 	if ((bs = send_statrsc(pbs_sd, NULL, NULL, const_cast<char *>("p"))) == NULL) {
 		const char *errmsg = pbs_geterrmsg(pbs_sd);
@@ -122,7 +126,7 @@ query_resources(int pbs_sd)
 				flags = strtol(attrp->value, &endp, 10);
 			}
 		}
-		tmpres[cur_bs->name] = new resdef(cur_bs->name, flags, rtype);
+		tmpres[cur_bs->name] = new resdef(cur_bs->name, flags, rtype, index++);
 	}
 	pbs_statfree(bs);
 
@@ -394,6 +398,9 @@ update_resource_defs(int pbs_sd)
 		conf.resdef_to_check = resstr_to_resdef(conf.res_to_check);
 	}
 	update_sorting_defs();
+	clear_formula_cache();
+	clear_spec_cache();
+	clear_node_bucket_cache();
 
 	clear_limres();
 
@@ -47,6 +47,8 @@
  * 	free_resource_resv_array()
  * 	dup_resource_resv_array()
  * 	dup_resource_resv()
+ * 	share_selspec()
+ * 	free_selspec()
  * 	find_resource_resv()
  * 	find_resource_resv_by_indrank()
  * 	find_resource_resv_by_time()
@@ -100,6 +102,7 @@
 #include "resv_info.h"
 #include "node_info.h"
 #include "misc.h"
+#include "mem_pool.h"
 #include "node_partition.h"
 #include "constant.h"
 #include "globals.h"
@@ -237,19 +240,19 @@ free_resource_resv_array(resource_resv **resresv_arr)
 	int i;
 	int chunk_size;
 	th_data_free_resresv *tdata = NULL;
-	th_task_info *task = NULL;
+	th_task_info *tasks = NULL;
 	int num_tasks;
 	int num_jobs;
-	int tid;
 
 	if (resresv_arr == NULL)
 		return;
 
 	num_jobs = count_array(resresv_arr);
+	chunk_size = mt_chunk_size(num_jobs);
 
-	tid = *((int *) pthread_getspecific(th_id_key));
-	if (tid != 0 || num_threads <= 1) {
-		/* don't use multi-threading if I am a worker thread or num_threads is 1 */
+	if (num_threads <= 1 || num_jobs <= chunk_size ||
+	    (tasks = static_cast<th_task_info *>(calloc(num_jobs / chunk_size + 1, sizeof(th_task_info)))) == NULL) {
+		/* don't use multi-threading if num_threads is 1 or there is only one chunk */
 		tdata = alloc_tdata_free_rr_arr(resresv_arr, 0, num_jobs - 1);
 		if (tdata == NULL)
 			return;
@@ -260,36 +263,21 @@ free_resource_resv_array(resource_resv **resresv_arr)
 		return;
 	}
 
-	chunk_size = num_jobs / num_threads;
-	chunk_size = (chunk_size > MT_CHUNK_SIZE_MIN) ? chunk_size : MT_CHUNK_SIZE_MIN;
-	chunk_size = (chunk_size < MT_CHUNK_SIZE_MAX) ? chunk_size : MT_CHUNK_SIZE_MAX;
 	for (i = 0, num_tasks = 0; num_jobs > 0;
 	     num_tasks++, i += chunk_size, num_jobs -= chunk_size) {
 		tdata = alloc_tdata_free_rr_arr(resresv_arr, i, i + chunk_size - 1);
 		if (tdata == NULL)
 			break;
 
-		task = static_cast<th_task_info *>(malloc(sizeof(th_task_info)));
-		task->task_type = TS_FREE_RESRESV;
-		task->thread_data = (void *) tdata;
-
-		queue_work_for_threads(task);
+		tasks[num_tasks].task_type = TS_FREE_RESRESV;
+		tasks[num_tasks].thread_data = (void *) tdata;
 	}
 
-	/* Get results from worker threads */
-	for (i = 0; i < num_tasks;) {
-		pthread_mutex_lock(&result_lock);
-		while (ds_queue_is_empty(result_queue))
-			pthread_cond_wait(&result_cond, &result_lock);
-		while (!ds_queue_is_empty(result_queue)) {
-			task = static_cast<th_task_info *>(ds_dequeue(result_queue));
-			tdata = static_cast<th_data_free_resresv *>(task->thread_data);
-			free(tdata);
-			free(task);
-			i++;
-		}
-		pthread_mutex_unlock(&result_lock);
-	}
+	run_tasks(tasks, num_tasks);
+
+	for (i = 0; i < num_tasks; i++)
+		free(tasks[i].thread_data);
+	free(tasks);
 
 	free(resresv_arr);
 }
@@ -302,8 +290,8 @@ free_resource_resv_array(resource_resv **resresv_arr)
 resource_resv::~resource_resv()
 {
 	free(nodepart_name);
-	delete select;
-	delete execselect;
+	free_selspec(select);
+	free_selspec(execselect);
 	free_place(place_spec);
 	free_resource_req_list(resreq);
 	free(ninfo_arr);
@@ -420,11 +408,11 @@ dup_resource_resv_array(resource_resv **oresresv_arr,
 {
 	resource_resv **nresresv_arr;
 	th_data_dup_resresv *tdata = NULL;
-	th_task_info *task = NULL;
+	th_task_info *tasks = NULL;
 	int num_resresv;
 	int thread_job_ct_left;
 	int th_err = 0;
-	int tid;
+	int chunk_size;
 
 	if (oresresv_arr == NULL || nsinfo == NULL)
 		return NULL;
@@ -437,9 +425,9 @@ dup_resource_resv_array(resource_resv **oresresv_arr,
 	}
 	nresresv_arr[0] = NULL;
 
-	tid = *((int *) pthread_getspecific(th_id_key));
-	if (tid != 0 || num_threads <= 1) {
-		/* don't use multi-threading if I am a worker thread or num_threads is 1 */
+	chunk_size = mt_chunk_size(num_resresv);
+	if (num_threads <= 1 || num_resresv <= chunk_size) {
+		/* don't use multi-threading if num_threads is 1 or there is only one chunk */
 		tdata = alloc_tdata_dup_nodes(oresresv_arr, nresresv_arr, nsinfo, nqinfo, 0, num_resresv - 1);
 		if (tdata == NULL)
 			th_err = 1;
@@ -450,9 +438,13 @@ dup_resource_resv_array(resource_resv **oresresv_arr,
 		}
 	} else { /* We are multithreading */
 		int num_tasks = 0;
-		int chunk_size = num_resresv / num_threads;
-		chunk_size = (chunk_size > MT_CHUNK_SIZE_MIN) ? chunk_size : MT_CHUNK_SIZE_MIN;
-		chunk_size = (chunk_size < MT_CHUNK_SIZE_MAX) ? chunk_size : MT_CHUNK_SIZE_MAX;
+
+		tasks = static_cast<th_task_info *>(calloc(num_resresv / chunk_size + 1, sizeof(th_task_info)));
+		if (tasks == NULL) {
+			log_err(errno, __func__, MEM_ERR_MSG);
+			free(nresresv_arr);
+			return NULL;
+		}
 		for (int j = 0; thread_job_ct_left > 0;
 		     num_tasks++, j += chunk_size, thread_job_ct_left -= chunk_size) {
 			tdata = alloc_tdata_dup_nodes(oresresv_arr, nresresv_arr, nsinfo, nqinfo, j, j + chunk_size - 1);
@@ -460,29 +452,19 @@ dup_resource_resv_array(resource_resv **oresresv_arr,
 				th_err = 1;
 				break;
 			}
-			task = static_cast<th_task_info *>(malloc(sizeof(th_task_info)));
-			task->task_type = TS_DUP_RESRESV;
-			task->thread_data = (void *) tdata;
-
-			queue_work_for_threads(task);
+			tasks[num_tasks].task_type = TS_DUP_RESRESV;
+			tasks[num_tasks].thread_data = (void *) tdata;
 		}
 
-		/* Get results from worker threads */
-		for (int i = 0; i < num_tasks;) {
-			pthread_mutex_lock(&result_lock);
-			while (ds_queue_is_empty(result_queue))
-				pthread_cond_wait(&result_cond, &result_lock);
-			while (!ds_queue_is_empty(result_queue)) {
-				task = static_cast<th_task_info *>(ds_dequeue(result_queue));
-				tdata = static_cast<th_data_dup_resresv *>(task->thread_data);
-				if (tdata->error)
-					th_err = 1;
-				free(tdata);
-				free(task);
-				i++;
-			}
-			pthread_mutex_unlock(&result_lock);
+		run_tasks(tasks, num_tasks);
+
+		for (int i = 0; i < num_tasks; i++) {
+			tdata = static_cast<th_data_dup_resresv *>(tasks[i].thread_data);
+			if (tdata->error)
+				th_err = 1;
+			free(tdata);
 		}
+		free(tasks);
 	}
 
 	if (th_err) {
@@ -541,10 +523,11 @@ dup_resource_resv(resource_resv *oresresv, server_info *nsinfo, queue_info *nqin
 	nresresv->project = oresresv->project;
 
 	nresresv->nodepart_name = string_dup(oresresv->nodepart_name);
-	if (oresresv->select != NULL)
-		nresresv->select = new selspec(*oresresv->select); /* must come before calls to dup_nspecs() below */
-	if (oresresv->execselect != NULL)
-		nresresv->execselect = new selspec(*oresresv->execselect);
+	/* The select specs are never modified in place once queried, only replaced.
+	 * Share them with the original rather than deep copying every chunk.
+	 */
+	nresresv->select = share_selspec(oresresv->select); /* must come before calls to dup_nspecs() below */
+	nresresv->execselect = share_selspec(oresresv->execselect);
 
 	nresresv->is_invalid = oresresv->is_invalid;
 	nresresv->can_not_fit = oresresv->can_not_fit;
@@ -988,12 +971,12 @@ new_resource_req()
 {
 	resource_req *resreq;
 
-	if ((resreq = static_cast<resource_req *>(calloc(1, sizeof(resource_req)))) == NULL) {
+	if ((resreq = mem_pool<resource_req>::alloc()) == NULL) {
 		log_err(errno, __func__, MEM_ERR_MSG);
 		return NULL;
 	}
 
-	/* member type zero'd by calloc() */
+	/* member type zero'd by mem_pool */
 
 	resreq->name = NULL;
 	resreq->res_str = NULL;
@@ -1359,7 +1342,7 @@ free_resource_req(resource_req *req)
 	if (req->res_str != NULL)
 		free(req->res_str);
 
-	free(req);
+	mem_pool<resource_req>::release(req);
 }
 
 /**
@@ -1596,7 +1579,7 @@ update_resresv_on_end(resource_resv *resresv, const char *job_state)
 				free(resresv->nodepart_name);
 				resresv->nodepart_name = NULL;
 			}
-			delete resresv->execselect;
+			free_selspec(resresv->execselect);
 			resresv->execselect = NULL;
 		}
 		/* We need to correct our calendar */
@@ -2149,6 +2132,7 @@ selspec::selspec()
 	total_chunks = 0;
 	total_cpus = 0;
 	chunks = NULL;
+	refs = 1;
 }
 
 /**
@@ -2163,6 +2147,7 @@ selspec::selspec(const selspec &oldspec)
 	total_cpus = oldspec.total_cpus;
 	chunks = dup_chunk_array(oldspec.chunks);
 	defs = oldspec.defs;
+	refs = 1;
 }
 
 selspec &
@@ -2186,6 +2171,47 @@ selspec::~selspec()
 		free_chunk_array(chunks);
 }
 
+/**
+ * @brief
+ *		share_selspec - take another reference on a select spec.
+ *		Used when duplicating the universe so the copy and the original
+ *		can point at the same select spec.  A shared select spec must be
+ *		treated as read-only.  To change it, replace the pointer with a
+ *		new selspec after calling free_selspec() on the old one.
+ *
+ * @param[in]	spec	-	select spec to share
+ *
+ * @return	selspec *
+ * @retval	spec	: the same select spec
+ * @retval	NULL	: if spec is NULL
+ */
+selspec *
+share_selspec(selspec *spec)
+{
+	if (spec != NULL)
+		spec->refs++;
+	return spec;
+}
+
+/**
+ * @brief
+ *		free_selspec - drop a reference on a select spec.  The select spec
+ *		is freed once its last reference is dropped.
+ *
+ * @param[in]	spec	-	select spec to release
+ *
+ * @return	void
+ */
+void
+free_selspec(selspec *spec)
+{
+	if (spec == NULL)
+		return;
+
+	if (--spec->refs == 0)
+		delete spec;
+}
+
 /**
  * @brief
  *		compare_res_to_str - compare a resource structure of type string to
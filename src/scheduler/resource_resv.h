@@ -301,6 +301,16 @@ chunk *dup_chunk(const chunk *ochunk);
  */
 void free_chunk_array(chunk **chunk_arr);
 
+/*
+ *	share_selspec - take another reference on a read-only select spec
+ */
+selspec *share_selspec(selspec *spec);
+
+/*
+ *	free_selspec - drop a reference on a select spec, freeing it on the last one
+ */
+void free_selspec(selspec *spec);
+
 /*
  *	free_chunk - destructor for chunk
  */
@@ -45,6 +45,7 @@
  *
  * Functions included are:
  *	stat_resvs()
+ *	dup_resv_occurrences_chunk()
  *	query_reservations()
  *	query_resv()
  *	new_resv_info()
@@ -61,6 +62,9 @@
 #include <pbs_config.h>
 
 #include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <errno.h>
 #include <libutil.h>
@@ -78,6 +82,7 @@
 #include "job_info.h"
 #include "libpbs.h"
 #include "misc.h"
+#include "multi_threading.h"
 #include "node_info.h"
 #include "node_partition.h"
 #include "pbs_internal.h"
@@ -115,6 +120,222 @@ stat_resvs(int pbs_sd)
 	return resvs;
 }
 
+/* execvnode sequence of a standing reservation, kept until its occurrences
+ * have been duplicated
+ */
+struct unrolled_execvnodes {
+	char *seq;
+	char **execvnode_ptr;
+	char **tofree;
+};
+
+/**
+ * @brief
+ *		free the execvnode sequences kept for unrolling standing reservations
+ *
+ * @param[in]	unrolled	-	the sequences to free
+ *
+ * @return	void
+ */
+static void
+free_unrolled_execvnodes(std::vector<unrolled_execvnodes> &unrolled)
+{
+	for (auto &u : unrolled) {
+		free_execvnode_seq(u.tofree);
+		free(u.seq);
+		free(u.execvnode_ptr);
+	}
+	unrolled.clear();
+}
+
+/**
+ * @brief
+ *		free a reservation array which may have empty slots for occurrences
+ *		not yet duplicated
+ *
+ * @param[in]	resresv_arr	-	the array to free
+ * @param[in]	num		-	number of slots used in the array
+ *
+ * @return	void
+ */
+static void
+free_resv_slots(resource_resv **resresv_arr, int num)
+{
+	if (resresv_arr == NULL)
+		return;
+
+	for (int i = 0; i < num; i++)
+		delete resresv_arr[i];
+	free(resresv_arr);
+}
+
+/**
+ * @brief
+ *		duplicate an occurrence of a standing reservation from its parent
+ *
+ * @param[in]	occr	-	the occurrence
+ * @param[in]	sinfo	-	the server
+ *
+ * @par MT-safe: yes
+ *
+ * @return	resource_resv *
+ * @retval	the occurrence
+ * @retval	NULL	: on error
+ */
+static resource_resv *
+dup_resv_occurrence(resv_occurrence *occr, server_info *sinfo)
+{
+	resource_resv *resresv = occr->parent;
+	resource_resv *resresv_ocr;
+
+	resresv_ocr = dup_resource_resv(resresv, sinfo, NULL);
+	if (resresv_ocr == NULL) {
+		log_err(errno, __func__, "Error duplicating resource reservation");
+		return NULL;
+	}
+	if (resresv->resv->resv_state == RESV_RUNNING ||
+	    resresv->resv->resv_state == RESV_BEING_ALTERED ||
+	    resresv->resv->resv_state == RESV_DELETING_JOBS) {
+		/* Each occurrence will be added to the simulation framework and
+		 * should not be in running state. Their state should be
+		 * Confirmed instead of possibly inheriting the Running state
+		 * from the parent reservation.
+		 */
+		resresv_ocr->resv->resv_state = RESV_CONFIRMED;
+		resresv_ocr->resv->is_running = 0;
+	}
+	/* Duplication deep-copies node info array. This array gets
+	 * overwritten and needs to be freed. This is an alternative
+	 * to creating another duplication function that only duplicates
+	 * the required fields.
+	 */
+	release_nodes(resresv_ocr);
+
+	if (resresv_ocr->resv->select_standing != NULL) {
+		free_selspec(resresv_ocr->select);
+		resresv_ocr->select = new selspec(*resresv_ocr->resv->select_standing);
+	}
+
+	if (occr->execvnode != NULL)
+		resresv_ocr->resv->orig_nspec_arr = parse_execvnode(occr->execvnode, sinfo, resresv_ocr->select);
+	else
+		resresv_ocr->resv->orig_nspec_arr = {};
+
+	resresv_ocr->nspec_arr = combine_nspec_array(resresv_ocr->resv->orig_nspec_arr);
+	resresv_ocr->ninfo_arr = create_node_array_from_nspec(resresv_ocr->nspec_arr);
+	resresv_ocr->resv->resv_nodes = create_resv_nodes(resresv_ocr->nspec_arr, sinfo);
+
+	/* Set occurrence start and end time.  If it is not the first occurrence
+	 * then update the duration as req_duration_standing (if set). This is to
+	 * ensure that if the first occurrence has been changed, other future
+	 * occurrences are not affected.
+	 */
+	resresv_ocr->resv->req_start = occr->start;
+	if (resresv->resv->req_duration_standing != UNSPECIFIED)
+		resresv_ocr->hard_duration = resresv_ocr->duration = resresv->resv->req_duration_standing;
+	resresv_ocr->resv->req_end = occr->start + resresv_ocr->duration;
+	resresv_ocr->start = resresv_ocr->resv->req_start;
+	resresv_ocr->end = resresv_ocr->resv->req_end;
+	resresv_ocr->resv->resv_idx = occr->occr_idx;
+
+	return resresv_ocr;
+}
+
+/**
+ * @brief	pthread routine for duplicating a chunk of standing reservation
+ *		occurrences from their parents
+ *
+ * @param[in,out]	data - th_data_dup_resv_occr object for the duplication
+ *
+ * @return void
+ */
+void
+dup_resv_occurrences_chunk(th_data_dup_resv_occr *data)
+{
+	data->error = 0;
+	for (int i = data->sidx; i <= data->eidx; i++) {
+		resource_resv *ocr = dup_resv_occurrence(&data->occrs[i], data->sinfo);
+
+		if (ocr == NULL) {
+			data->error = 1;
+			return;
+		}
+		data->resresv_arr[data->occrs[i].slot] = ocr;
+	}
+}
+
+/**
+ * @brief
+ *		duplicate the occurrences of the standing reservations into their
+ *		slots of the reservation array, using the worker threads if there
+ *		are enough of them
+ *
+ * @param[in]		occrs		-	the occurrences to duplicate
+ * @param[in,out]	resresv_arr	-	the reservation array
+ * @param[in]		sinfo		-	the server
+ *
+ * @return	bool
+ * @retval	true	: all occurrences were duplicated
+ * @retval	false	: on error
+ */
+static bool
+dup_resv_occurrences(std::vector<resv_occurrence> &occrs, resource_resv **resresv_arr, server_info *sinfo)
+{
+	int num_occrs = occrs.size();
+	int chunk_size = mt_chunk_size(num_occrs);
+	int num_tasks = 0;
+	bool rc = true;
+	th_data_dup_resv_occr *tdata;
+	th_task_info *tasks;
+
+	if (num_threads <= 1 || num_occrs <= chunk_size) {
+		th_data_dup_resv_occr data;
+
+		data.occrs = occrs.data();
+		data.resresv_arr = resresv_arr;
+		data.sinfo = sinfo;
+		data.sidx = 0;
+		data.eidx = num_occrs - 1;
+		dup_resv_occurrences_chunk(&data);
+		return !data.error;
+	}
+
+	tasks = static_cast<th_task_info *>(calloc(num_occrs / chunk_size + 1, sizeof(th_task_info)));
+	if (tasks == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		return false;
+	}
+	for (int j = 0; j < num_occrs; num_tasks++, j += chunk_size) {
+		tdata = static_cast<th_data_dup_resv_occr *>(malloc(sizeof(th_data_dup_resv_occr)));
+		if (tdata == NULL) {
+			log_err(errno, __func__, MEM_ERR_MSG);
+			rc = false;
+			break;
+		}
+		tdata->error = 0;
+		tdata->occrs = occrs.data();
+		tdata->resresv_arr = resresv_arr;
+		tdata->sinfo = sinfo;
+		tdata->sidx = j;
+		tdata->eidx = std::min(j + chunk_size, num_occrs) - 1;
+		tasks[num_tasks].task_id = num_tasks;
+		tasks[num_tasks].task_type = TS_DUP_RESV_OCCR;
+		tasks[num_tasks].thread_data = (void *) tdata;
+	}
+
+	run_tasks(tasks, num_tasks);
+
+	for (int i = 0; i < num_tasks; i++) {
+		tdata = static_cast<th_data_dup_resv_occr *>(tasks[i].thread_data);
+		if (tdata->error)
+			rc = false;
+		free(tdata);
+	}
+	free(tasks);
+
+	return rc;
+}
+
 /**
  *
  * @brief
@@ -156,6 +377,10 @@ query_reservations(int pbs_sd, server_info *sinfo, struct batch_status *resvs)
 
 	schd_error *err;
 
+	/* occurrences of standing reservations to duplicate from their parents */
+	std::vector<resv_occurrence> occrs;
+	std::vector<unrolled_execvnodes> unrolled;
+
 	if (resvs == NULL)
 		return NULL;
 
@@ -197,7 +422,8 @@ query_reservations(int pbs_sd, server_info *sinfo, struct batch_status *resvs)
 
 		/* convert resv info from server batch_status into resv_info */
 		if ((resresv = query_resv(cur_resv, sinfo)) == NULL) {
-			free_resource_resv_array(resresv_arr);
+			free_resv_slots(resresv_arr, idx);
+			free_unrolled_execvnodes(unrolled);
 			free_schd_error(err);
 			return NULL;
 		}
@@ -267,8 +493,7 @@ query_reservations(int pbs_sd, server_info *sinfo, struct batch_status *resvs)
 		 */
 		if (resresv->resv->is_standing &&
 		    (resresv->resv->resv_state != RESV_UNCONFIRMED)) {
-			resource_resv *resresv_ocr = NULL; /* the occurrence's resource_resv */
-			char *execvnodes_seq = NULL;		   /* confirmed execvnodes sequence string */
+			char *execvnodes_seq = NULL; /* confirmed execvnodes sequence string */
 			char **execvnode_ptr = NULL;
 			char **tofree = NULL;
 			resource_resv **tmp = NULL;
@@ -280,6 +505,8 @@ query_reservations(int pbs_sd, server_info *sinfo, struct batch_status *resvs)
 			int occr_count;	  /* occurrences count as reported by execvnodes_seq */
 			int occr_idx;	  /* the occurrence index of a standing reservation */
 			int degraded_idx; /* index corrected to account for reconfirmation */
+			int num_occr;	  /* number of occurrences to add to the universe */
+			std::vector<time_t> occr_start;
 
 			/* occr_idx refers to the soonest occurrence to run or currently running
 			 * Note that resv_idx starts at 1 on the first occurrence and not 0.
@@ -331,11 +558,12 @@ query_reservations(int pbs_sd, server_info *sinfo, struct batch_status *resvs)
 			if ((tmp = static_cast<resource_resv **>(realloc(resresv_arr,
 									 sizeof(resource_resv *) * (sinfo->num_resvs + 1)))) == NULL) {
 				log_err(errno, __func__, MEM_ERR_MSG);
-				free_resource_resv_array(resresv_arr);
+				free_resv_slots(resresv_arr, idx);
 				delete resresv;
 				free_execvnode_seq(tofree);
 				free(execvnodes_seq);
 				free(execvnode_ptr);
+				free_unrolled_execvnodes(unrolled);
 				free_schd_error(err);
 				return NULL;
 			}
@@ -345,117 +573,82 @@ query_reservations(int pbs_sd, server_info *sinfo, struct batch_status *resvs)
 			dtstart = resresv->resv->req_start;
 			tz = resresv->resv->timezone;
 
-			/* Add each occurrence to the universe's view by duplicating the
-			 * parent reservation and resetting start and end times and the
-			 * execvnode on which the occurrence is confirmed to run.
+			/* Get the start time of each occurrence.  The server maintains state
+			 * of a single reservation object for which in the case of a standing
+			 * reservation, it updates start and end times and execvnodes.
+			 * The first occurrence is computed from the parent's start time.
+			 * If it is not the first occurrence then the start time is computed
+			 * from req_start_standing (if set).  This is to ensure that if the
+			 * first occurrence has been changed, other future occurrences are
+			 * not affected.
 			 */
-			for (j = 0; occr_idx <= count; occr_idx++, j++, degraded_idx++) {
-				/* If it is not the first occurrence then update the start time as
-				 * req_start_standing (if set). This is to ensure that if the first
-				 * occurrence has been changed, other future occurrences are not
-				 * affected.
-				 */
-				if (j == 1 && resresv_ocr->resv->req_start_standing != UNSPECIFIED)
-					dtstart = resresv_ocr->resv->req_start_standing;
-				/* Get the start time of the next occurrence computed from dtstart.
-				 * The server maintains state of a single reservation object for
-				 * which in the case of a standing reservation, it updates start
-				 * and end times and execvnodes.
-				 * The last argument (j+1) indicates the occurrence index from dtstart
-				 * starting at 1. Returns dtstart if it's an advance reservation.
-				 */
-				auto next = get_occurrence(rrule, dtstart, tz, j + 1);
+			num_occr = count - occr_idx + 1;
+			if (num_occr > 0) {
+				occr_start.resize(num_occr);
+				get_occurrences(rrule, dtstart, tz, 1, 1, &occr_start[0]);
+				if (resresv->resv->req_start_standing != UNSPECIFIED)
+					dtstart = resresv->resv->req_start_standing;
+				if (num_occr > 1)
+					get_occurrences(rrule, dtstart, tz, 2, num_occr - 1, &occr_start[1]);
+			}
 
-				/* Duplicate the "master" resv only for subsequent occurrences */
-				if (j == 0)
-					resresv_ocr = resresv;
-				else {
-					resresv_ocr = dup_resource_resv(resresv, sinfo, NULL);
-					if (resresv_ocr == NULL) {
-						log_err(errno, __func__, "Error duplicating resource reservation");
-						free_resource_resv_array(resresv_arr);
-						delete resresv;
-						free_execvnode_seq(tofree);
-						free(execvnodes_seq);
-						free(execvnode_ptr);
-						free_schd_error(err);
-						return NULL;
-					}
-					if (resresv->resv->resv_state == RESV_RUNNING ||
-					    resresv->resv->resv_state == RESV_BEING_ALTERED ||
-					    resresv->resv->resv_state == RESV_DELETING_JOBS) {
-						/* Each occurrence will be added to the simulation framework and
-						 * should not be in running state. Their state should be
-						 * Confirmed instead of possibly inheriting the Running state
-						 * from the parent reservation.
-						 */
-						resresv_ocr->resv->resv_state = RESV_CONFIRMED;
-						resresv_ocr->resv->is_running = 0;
-					}
-					/* Duplication deep-copies node info array. This array gets
-					 * overwritten and needs to be freed. This is an alternative
-					 * to creating another duplication function that only duplicates
-					 * the required fields.
+			/* Add each occurrence to the universe's view.  The parent reservation
+			 * is the first occurrence.  The others are duplicates of the parent
+			 * with their own start and end times and the execvnode on which the
+			 * occurrence is confirmed to run.  The duplicates are made once all
+			 * reservations have been queried (see dup_resv_occurrences()), so
+			 * only their place in the reservation array is kept here.
+			 */
+			for (j = 0; j < num_occr; occr_idx++, j++, degraded_idx++) {
+				time_t ocr_start;
+
+				if (j == 0) {
+					/* Set occurrence start and end time and nodes information. On the
+					 * first occurrence the start time may need to be reset to the time
+					 * specified by the recurrence rule. See description at the head of
+					 * this block.
 					 */
-					release_nodes(resresv_ocr);
-
-					if (resresv_ocr->resv->select_standing != NULL) {
-						delete resresv_ocr->select;
-						resresv_ocr->select = new selspec(*resresv_ocr->resv->select_standing);
-					}
+					resresv->resv->req_start = occr_start[j];
+					resresv->resv->req_end = occr_start[j] + resresv->duration;
+					resresv->start = resresv->resv->req_start;
+					resresv->end = resresv->resv->req_end;
+					resresv->resv->resv_idx = occr_idx;
+					ocr_start = resresv->start;
+					resresv_arr[idx++] = resresv;
+				} else {
+					resv_occurrence occr;
 
+					occr.parent = resresv;
+					occr.start = occr_start[j];
+					occr.occr_idx = occr_idx;
+					occr.slot = idx;
 					if (degraded_idx >= 1 && degraded_idx <= occr_count)
-						resresv_ocr->resv->orig_nspec_arr = parse_execvnode(
-							execvnode_ptr[degraded_idx - 1], sinfo, resresv_ocr->select);
+						occr.execvnode = execvnode_ptr[degraded_idx - 1];
 					else {
-						resresv_ocr->resv->orig_nspec_arr = {};
+						occr.execvnode = NULL;
 						log_eventf(PBSEVENT_ERROR, PBS_EVENTCLASS_RESV,
 							   LOG_INFO, resresv->name,
 							   "%s: occurence %d has no execvnodes, proceeding without assigned resources",
 							   __func__, j + 1);
 					}
-
-					resresv_ocr->nspec_arr = combine_nspec_array(resresv_ocr->resv->orig_nspec_arr);
-					resresv_ocr->ninfo_arr = create_node_array_from_nspec(resresv_ocr->nspec_arr);
-					resresv_ocr->resv->resv_nodes = create_resv_nodes(
-						resresv_ocr->nspec_arr, sinfo);
+					occrs.push_back(occr);
+					ocr_start = occr.start;
+					resresv_arr[idx++] = NULL;
 				}
-
-				/* Set occurrence start and end time and nodes information. On the
-				 * first occurrence the start time may need to be reset to the time
-				 * specified by the recurrence rule. See description at the head of
-				 * this block.
-				 */
-				resresv_ocr->resv->req_start = next;
-				/* If it is not the first occurrence then update the duration as
-				 * req_duration_standing (if set). This is to ensure that if the first
-				 * occurrence has been changed, other future occurrences are not
-				 * affected.
-				 */
-				if (j != 0 && resresv->resv->req_duration_standing != UNSPECIFIED)
-					resresv_ocr->hard_duration = resresv_ocr->duration = resresv->resv->req_duration_standing;
-				resresv_ocr->resv->req_end = next + resresv_ocr->duration;
-				resresv_ocr->start = resresv_ocr->resv->req_start;
-				resresv_ocr->end = resresv_ocr->resv->req_end;
-				resresv_ocr->resv->resv_idx = occr_idx;
-
-				/* Add the occurrence to the global array of reservations */
-				resresv_arr[idx++] = resresv_ocr;
 				resresv_arr[idx] = NULL;
 
-				auto loc_time = localtime(&resresv_ocr->start);
+				auto loc_time = localtime(&ocr_start);
 				strftime(start_time, sizeof(start_time), "%Y%m%d-%H:%M:%S", loc_time);
 
 				log_eventf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_RESV, LOG_DEBUG, resresv->name,
 					   "Occurrence %d/%d,%s", occr_idx, count, start_time);
 			}
 			/* The parent reservation has already been added so move on to handling
-			 * the next reservation
+			 * the next reservation.  The execvnodes are kept until the occurrences
+			 * have been duplicated.
 			 */
 
-			free_execvnode_seq(tofree);
-			free(execvnodes_seq);
-			free(execvnode_ptr);
+			unrolled.push_back({execvnodes_seq, execvnode_ptr, tofree});
 
 			continue;
 		} else {
@@ -464,6 +657,14 @@ query_reservations(int pbs_sd, server_info *sinfo, struct batch_status *resvs)
 		}
 	}
 
+	if (!occrs.empty() && !dup_resv_occurrences(occrs, resresv_arr, sinfo)) {
+		free_resv_slots(resresv_arr, idx);
+		free_unrolled_execvnodes(unrolled);
+		free_schd_error(err);
+		return NULL;
+	}
+	free_unrolled_execvnodes(unrolled);
+
 	free_schd_error(err);
 
 	return resresv_arr;
@@ -884,6 +1085,148 @@ dup_resv_info(resv_info *rinfo, server_info *sinfo)
 	return nrinfo;
 }
 
+/**
+ * @brief	resources_assigned of a resource once the calendar has been
+ *		played up to some time.  See resv_may_fit()
+ *
+ * @param[in]	assigned	-	resources_assigned changed by the calendar
+ * @param[in]	res	-	the resource
+ *
+ * @return	amount assigned
+ */
+static sch_resource_t
+resv_fit_assigned(std::unordered_map<schd_resource *, sch_resource_t> &assigned, schd_resource *res)
+{
+	auto it = assigned.find(res);
+
+	return (it == assigned.end()) ? res->assigned : it->second;
+}
+
+/**
+ * @brief
+ * 		cheap check of whether a new reservation could possibly be
+ *		confirmed.  The amount of consumables free on each node at the
+ *		reservation's start is bounded from above by playing the calendar
+ *		up to then: everything which ends is released, but only
+ *		reservations are charged when they start.  If the reservation
+ *		does not fit in that, the simulation done by confirm_reservation()
+ *		could not find it a place either.
+ *
+ * @param[in]	sinfo	-	the server
+ * @param[in]	resv	-	the reservation
+ * @param[out]	err	-	why the reservation can't fit
+ *
+ * @return	bool
+ * @retval	false	: the reservation can not be confirmed
+ * @retval	true	: the reservation may be confirmed
+ */
+static bool
+resv_may_fit(server_info *sinfo, resource_resv *resv, schd_error *err)
+{
+	std::unordered_map<schd_resource *, sch_resource_t> assigned;
+	std::unordered_map<resdef *, std::pair<resource_req *, sch_resource_t>> need; /* amount requested by the whole select */
+	bool asap = resv->resv->req_start == PBS_RESV_FUTURE_SCH;
+
+	if (resv->select == NULL || resv->select->chunks == NULL || sinfo->nodes == NULL)
+		return true;
+
+	/* an ASAP reservation starts whenever it fits, so only what the nodes
+	 * have in total can rule it out
+	 */
+	if (!asap && sinfo->calendar != NULL) {
+		auto &tindex = sinfo->calendar->time_index;
+		for (auto it = tindex.begin(); it != tindex.upper_bound(resv->resv->req_start); it++) {
+			auto te = it->second;
+			if (te->disabled || !(te->event_type & (TIMED_RUN_EVENT | TIMED_END_EVENT)))
+				continue;
+
+			auto rr = static_cast<resource_resv *>(te->event_ptr);
+			/* jobs in reservations run on the reservation's nodes */
+			if (rr->is_job && rr->job != NULL && rr->job->resv != NULL)
+				continue;
+			/* the free amount can only be overestimated */
+			if (te->event_type == TIMED_RUN_EVENT && !rr->is_resv)
+				continue;
+
+			for (auto ns : rr->nspec_arr) {
+				auto node = find_node_by_indrank(sinfo->nodes, ns->ninfo->node_ind, ns->ninfo->rank);
+				if (node == NULL)
+					continue;
+				for (resource_req *req = ns->resreq; req != NULL; req = req->next) {
+					if (!req->type.is_consumable)
+						continue;
+					auto res = find_resource(node->res, req->def);
+					if (res == NULL)
+						continue;
+					if (res->indirect_res != NULL)
+						res = res->indirect_res;
+					auto a = assigned.emplace(res, res->assigned).first;
+					/* the same as update_node_on_run() and update_node_on_end() */
+					if (te->event_type == TIMED_END_EVENT) {
+						a->second -= req->amount;
+						if (a->second < 0)
+							a->second = 0;
+					} else
+						a->second += req->amount;
+				}
+			}
+		}
+	}
+
+	for (int c = 0; resv->select->chunks[c] != NULL; c++) {
+		chunk *chk = resv->select->chunks[c];
+		long long count = 0;
+
+		for (resource_req *req = chk->req; req != NULL; req = req->next)
+			if (req->type.is_consumable && req->amount > 0) {
+				auto &n = need.emplace(req->def, std::make_pair(req, 0)).first->second;
+				n.second += req->amount * chk->num_chunks;
+			}
+
+		for (int i = 0; sinfo->nodes[i] != NULL && count < chk->num_chunks; i++) {
+			long long fits = chk->num_chunks;
+			for (resource_req *req = chk->req; req != NULL && fits > 0; req = req->next) {
+				if (!req->type.is_consumable || req->amount <= 0)
+					continue;
+				auto res = find_check_resource(sinfo->nodes[i]->res, req, UNSET_RES_ZERO);
+				if (res == NULL || !res->type.is_consumable || res->avail == SCHD_INFINITY_RES)
+					continue;
+				auto a = asap ? 0 : resv_fit_assigned(assigned, res);
+				auto n = (res->avail - a <= 0) ? 0 : (res->avail - a) / req->amount;
+				if (n < fits)
+					fits = n;
+			}
+			count += fits;
+		}
+		if (count < chk->num_chunks) {
+			set_schd_error_codes(err, NOT_RUN, NO_NODE_RESOURCES);
+			return false;
+		}
+	}
+
+	/* chunks of different kinds may each fit on their own but not together */
+	for (auto &n : need) {
+		sch_resource_t f = 0;
+		for (int i = 0; sinfo->nodes[i] != NULL && f < n.second.second; i++) {
+			auto res = find_check_resource(sinfo->nodes[i]->res, n.second.first, UNSET_RES_ZERO);
+			if (res == NULL || !res->type.is_consumable || res->avail == SCHD_INFINITY_RES) {
+				f = SCHD_INFINITY_RES;
+				break;
+			}
+			auto a = asap ? 0 : resv_fit_assigned(assigned, res);
+			if (res->avail - a > 0)
+				f += res->avail - a;
+		}
+		if (f != SCHD_INFINITY_RES && f < n.second.second) {
+			set_schd_error_codes(err, NOT_RUN, INSUFFICIENT_RESOURCE);
+			err->rdef = n.first;
+			return false;
+		}
+	}
+
+	return true;
+}
+
 /**
  * @brief
  * 		check for new reservations and handle them
@@ -957,6 +1300,36 @@ check_new_reservations(status *policy, int pbs_sd, resource_resv **resvs, server
 		 * respectively confirmed and reconfirmed.
 		 */
 		if (will_confirm(sinfo->resvs[i], sinfo->server_time)) {
+			resource_resv *resv = sinfo->resvs[i];
+
+			/* Reject what can't fit before paying for a copy of the universe.
+			 * Reservations confirmed earlier in this loop are in the calendar.
+			 */
+			if (resv->resv->resv_state == RESV_UNCONFIRMED && resv->resv->resv_substate != RESV_DEGRADED &&
+			    resv->resv->resv_substate != RESV_IN_CONFLICT) {
+				clear_schd_error(err);
+				if (!resv_may_fit(sinfo, resv, err)) {
+					char logmsg[MAX_LOG_SIZE];
+
+					logmsg[0] = '\0';
+					(void) translate_fail_code(err, NULL, logmsg);
+					pbsrc = send_confirmresv(pbs_sd, resv, "null", 0, PBS_RESV_CONFIRM_FAIL);
+					if (pbsrc > 0) {
+						const char *errmsg = pbs_geterrmsg(pbs_sd);
+						if (errmsg == NULL)
+							errmsg = "";
+						log_eventf(PBSEVENT_RESV, PBS_EVENTCLASS_RESV, LOG_INFO, resv->name,
+							   "PBS Failed to confirm resv: %s (%d)", errmsg, pbs_errno);
+						free_schd_error(err);
+						return -1;
+					}
+					log_eventf(PBSEVENT_RESV, PBS_EVENTCLASS_RESV, LOG_INFO, resv->name,
+						   "PBS Failed to confirm resv: %s", logmsg);
+					pbsrc = RESV_CONFIRM_FAIL;
+					continue;
+				}
+			}
+
 			/* Clone the real universe for simulation scratch work. This universe
 			 * will be garbage collected after simulation completes.
 			 */
@@ -1072,7 +1445,7 @@ check_new_reservations(status *policy, int pbs_sd, resource_resv **resvs, server
 							if (nresv_copy == NULL)
 								break;
 							if (nresv_copy->resv->select_standing != NULL) {
-								delete nresv_copy->select;
+								free_selspec(nresv_copy->select);
 								nresv_copy->select = new selspec(*nresv_copy->resv->select_standing);
 							}
 						}
@@ -1321,6 +1694,14 @@ confirm_reservation(status *policy, int pbs_sd, resource_resv *unconf_resv, serv
 		return RESV_CONFIRM_FAIL;
 	}
 
+	/* Get the start time of each occurrence.
+	 * See call to same function in query_reservations for a more in-depth
+	 * description.
+	 */
+	std::vector<time_t> occr_times(std::max(occr_count, 0));
+	if (occr_count > 0)
+		get_occurrences(rrule, dtstart, tz, 1, occr_count, occr_times.data());
+
 	/* Each reservation attempts to confirm a set of nodes on which to run for
 	 * a given start and end time. When handling an advance reservation,
 	 * the current reservation is considered. For a standing reservation,
@@ -1341,11 +1722,7 @@ confirm_reservation(status *policy, int pbs_sd, resource_resv *unconf_resv, serv
 	cur_count = 0;
 	for (int j = 0; j < occr_count && rconf == RESV_CONFIRM_SUCCESS;
 	     j++, cur_count = j) {
-		/* Get the start time of the next occurrence.
-		 * See call to same function in query_reservations for a more in-depth
-		 * description.
-		 */
-		next = get_occurrence(rrule, dtstart, tz, j + 1);
+		next = occr_times[j];
 		/* keep track of each occurrence's start time */
 		occr_start_arr[j] = next;
 
@@ -1426,7 +1803,7 @@ confirm_reservation(status *policy, int pbs_sd, resource_resv *unconf_resv, serv
 				   nresv->resv->resv_state == RESV_BEING_ALTERED) {
 				if (nresv->resv->is_running) {
 					std::string sel;
-					delete nresv->execselect;
+					free_selspec(nresv->execselect);
 
 					sel = create_select_from_nspec(nresv->resv->orig_nspec_arr);
 					nresv->execselect = parse_selspec(sel);
@@ -1625,7 +2002,7 @@ confirm_reservation(status *policy, int pbs_sd, resource_resv *unconf_resv, serv
 			 * so we only care about the remaining ones
 			 */
 			for (; cur_count < occr_count; cur_count++) {
-				next = get_occurrence(rrule, dtstart, tz, cur_count + 1);
+				next = occr_times[cur_count];
 				occr_start_arr[cur_count] = next;
 			}
 		}
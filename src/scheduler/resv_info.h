@@ -54,6 +54,12 @@ struct batch_status *stat_resvs(int pbs_sd);
  */
 resource_resv **query_reservations(int pbs_sd, server_info *sinfo, struct batch_status *resvs);
 
+/*
+ *	dup_resv_occurrences_chunk - clone a chunk of standing reservation
+ *	occurrences from their parents
+ */
+void dup_resv_occurrences_chunk(th_data_dup_resv_occr *data);
+
 /*
  *	query_resv_info - convert the servers batch_statys structure into a
  */
@@ -40,20 +40,84 @@
 #include <pbs_config.h>
 
 #include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <atomic>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include <pbs_ifl.h>
 #include <libpbs.h>
+#include <pbs_error.h>
+#include <attribute.h>
+#include "cycle_stats.h"
 #include "data_types.h"
 #include "fifo.h"
 #include "globals.h"
 #include "job_info.h"
 #include "misc.h"
+#include "replay.h"
 #include "log.h"
 #include "server_info.h"
 #include "libutil.h"
 
+extern char *pbse_to_txt(int err);
+
+/* async run requests waiting to be sent to the server in one run job list */
+static std::vector<std::pair<std::string, std::string>> pending_runs;
+
+/* async attribute updates waiting to be sent in one modify job list */
+static std::vector<std::pair<std::string, struct attrl *>> pending_updates;
+static std::unordered_map<std::string, size_t> pending_update_idx;
+/* worker threads queue updates while they query jobs */
+static pthread_mutex_t pending_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* a status reply is being streamed; nothing else may be sent until it is read */
+static std::atomic<bool> requests_held(false);
+
+/* does the server know the list requests: -1 not asked yet, 0 no, 1 yes */
+static int server_list_reqs = -1;
+
+/**
+ * @brief	Does the server support the run job and modify job list requests?
+ *
+ * @par	The first call asks the server with an empty run job list.  An older
+ *	server rejects it as an unknown request and every request is then sent
+ *	one job at a time.
+ *
+ * @param[in]	sd	-	communication handle
+ *
+ * @return	bool
+ */
+static bool
+has_list_requests(int sd)
+{
+	if (server_list_reqs == -1) {
+		struct batch_deljob_status *failed;
+
+		failed = pbs_runjoblist(sd, NULL, NULL, 0, NULL);
+		pbs_delstatfree(failed);
+		if (pbs_errno == PBSE_NONE)
+			server_list_reqs = 1;
+		else if (pbs_errno == PBSE_UNKREQ) {
+			log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_SERVER, LOG_DEBUG, __func__,
+				  "Server does not support job lists, sending requests one job at a time");
+			server_list_reqs = 0;
+		} else
+			return false; /* try again next time */
+	}
+
+	return server_list_reqs == 1;
+}
+
 /**
  * @brief	Send the relevant runjob request to server
  *
+ * @par	Async run requests which do not need to be seen by a runjob hook
+ *	are queued and sent together by flush_run_jobs(), they were never
+ *	waited on anyway.
+ *
  * @param[in]	sd	-	communication handle
  * @param[in]	has_runjob_hook	- does server have a runjob hook?
  * @param[in]	jobid	-	id of the job to run
@@ -66,41 +130,167 @@
 int
 send_run_job(int sd, int has_runjob_hook, const std::string &jobid, char *execvnode)
 {
+	phase_timer timer(PHASE_RUN_JOB);
+	bool queued;
+
 	if (jobid.empty() || execvnode == NULL)
 		return 1;
 
-	if (sc_attrs.runjob_mode == RJ_EXECJOB_HOOK)
+	if (replay_active())
+		return 0;
+
+	/* updates queued for the job (e.g. its walltime) have to be sent before it runs */
+	pthread_mutex_lock(&pending_lock);
+	queued = pending_update_idx.find(jobid) != pending_update_idx.end();
+	pthread_mutex_unlock(&pending_lock);
+	if (queued)
+		flush_attr_updates(sd);
+
+	if (sc_attrs.runjob_mode == RJ_EXECJOB_HOOK) {
+		flush_pending_requests(sd);
 		return pbs_runjob(sd, const_cast<char *>(jobid.c_str()), execvnode, NULL);
-	else if (((sc_attrs.runjob_mode == RJ_RUNJOB_HOOK) && has_runjob_hook))
+	} else if (((sc_attrs.runjob_mode == RJ_RUNJOB_HOOK) && has_runjob_hook)) {
+		flush_pending_requests(sd);
 		return pbs_asyrunjob_ack(sd, const_cast<char *>(jobid.c_str()), execvnode, NULL);
-	else
+	} else if (has_runjob_hook || !has_list_requests(sd)) {
+		/* the server comments the jobs a hook rejects on an async run */
+		flush_pending_requests(sd);
 		return pbs_asyrunjob(sd, const_cast<char *>(jobid.c_str()), execvnode, NULL);
+	}
+
+	pending_runs.emplace_back(jobid, execvnode);
+	if (pending_runs.size() >= RUNJOB_BATCH_SIZE)
+		return flush_run_jobs(sd);
+
+	return 0;
 }
 
 /**
- * @brief
- * 		send delayed attributes to the server for a job
+ * @brief	Send the run requests queued by send_run_job() to the server
+ *		in a single run job list request and log the jobs it could not run.
+ *
+ * @par	This must be called before any other request is sent to the server
+ *	so the server sees the requests in the order the scheduler made them.
  *
  * @param[in]	sd	-	communication handle
- * @param[in]	resresv	-	resource_resv object for job
+ *
+ * @return	int
+ * @retval	0	the run job list was sent (or nothing was queued)
+ * @retval	!0	the request failed as a whole (pbs_errno)
+ */
+int
+flush_run_jobs(int sd)
+{
+	std::vector<char *> jobids;
+	std::vector<char *> execvnodes;
+	struct batch_deljob_status *failed;
+	int rc;
+
+	if (pending_runs.empty() || requests_held)
+		return 0;
+
+	phase_timer timer(PHASE_RUN_JOB);
+
+	for (auto &pr : pending_runs) {
+		jobids.push_back(const_cast<char *>(pr.first.c_str()));
+		execvnodes.push_back(const_cast<char *>(pr.second.c_str()));
+	}
+
+	failed = pbs_runjoblist(sd, jobids.data(), execvnodes.data(), jobids.size(), NULL);
+	rc = pbs_errno;
+	if (failed == NULL && rc != PBSE_NONE)
+		log_eventf(PBSEVENT_SCHED, PBS_EVENTCLASS_SCHED, LOG_WARNING, __func__,
+			   "Failed to send run requests for %d jobs: %s (%d)",
+			   static_cast<int>(pending_runs.size()), pbse_to_txt(rc), rc);
+
+	for (struct batch_deljob_status *f = failed; f != NULL; f = f->next)
+		log_eventf(PBSEVENT_SCHED, PBS_EVENTCLASS_JOB, LOG_WARNING, f->name,
+			   "Run request failed: %s (%d)", pbse_to_txt(f->code), f->code);
+	pbs_delstatfree(failed);
+
+	pending_runs.clear();
+	return rc;
+}
+
+/**
+ * @brief	Queue attribute updates for a job.  A later update of an
+ *		attribute (and resource) replaces the earlier one, so a job's
+ *		comment or estimated times go out once per flush.
+ *		The caller holds pending_lock.
+ *
+ * @param[in]	job_name	-	name of the job
+ * @param[in]	pattr	-	attributes to set (copied)
+ *
+ * @return	bool
+ * @retval	true	queued
+ * @retval	false	out of memory
+ */
+static bool
+queue_attr_updates(const std::string &job_name, struct attrl *pattr)
+{
+	auto it = pending_update_idx.find(job_name);
+
+	if (it == pending_update_idx.end()) {
+		struct attrl *dup = dup_attrl_list(pattr);
+
+		if (dup == NULL)
+			return false;
+		pending_update_idx[job_name] = pending_updates.size();
+		pending_updates.emplace_back(job_name, dup);
+		return true;
+	}
+
+	for (struct attrl *na = pattr; na != NULL; na = na->next) {
+		struct attrl *qa;
+		struct attrl *last = NULL;
+
+		for (qa = pending_updates[it->second].second; qa != NULL; last = qa, qa = qa->next) {
+			if (strcmp(qa->name, na->name) == 0 &&
+			    ((qa->resource == NULL && na->resource == NULL) ||
+			     (qa->resource != NULL && na->resource != NULL && strcmp(qa->resource, na->resource) == 0)))
+				break;
+		}
+		if (qa != NULL) {
+			char *value = string_dup(na->value);
+
+			if (value == NULL)
+				return false;
+			free(qa->value);
+			qa->value = value;
+			qa->op = na->op;
+		} else {
+			struct attrl *next = na->next;
+			struct attrl *dup;
+
+			/* duplicate only this attribute */
+			na->next = NULL;
+			dup = dup_attrl_list(na);
+			na->next = next;
+			if (dup == NULL)
+				return false;
+			last->next = dup;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief	Send attribute updates for one job with an async modify job
+ *		request and log a failure
+ *
+ * @param[in]	sd	-	communication handle
+ * @param[in]	job_name	-	name of the job
  * @param[in]	pattr	-	attrl list to update on the server
  *
  * @return	int
  * @retval	1	success
  * @retval	0	failure to update
  */
-int
-send_attr_updates(int sd, resource_resv *resresv, struct attrl *pattr)
+static int
+alter_job(int sd, const std::string &job_name, struct attrl *pattr)
 {
 	const char *errbuf;
 	int one_attr = 0;
-	const std::string &job_name = resresv->name;
-
-	if (job_name.empty() || pattr == NULL)
-		return 0;
-
-	if (sd == SIMULATE_SD)
-		return 1; /* simulation always successful */
 
 	if (pattr->next == NULL)
 		one_attr = 1;
@@ -136,6 +326,145 @@ send_attr_updates(int sd, resource_resv *resresv, struct attrl *pattr)
 	return 0;
 }
 
+/**
+ * @brief	Send the attribute updates queued by send_attr_updates() to the
+ *		server in one async modify job list request.
+ *
+ * @par	Queued run requests are sent first so both lists reach the server
+ *	in the order they were made for any one job.  Updates queued while a
+ *	status reply was read are sent one job at a time if the server does
+ *	not know the list request.
+ *
+ * @param[in]	sd	-	communication handle
+ *
+ * @return	int
+ * @retval	0	success (or nothing was queued)
+ * @retval	!0	error (pbs_errno)
+ */
+int
+flush_attr_updates(int sd)
+{
+	std::vector<std::pair<std::string, struct attrl *>> updates;
+	std::vector<char *> jobids;
+	std::vector<struct attrl *> attribs;
+	int rc = 0;
+
+	if (requests_held)
+		return 0;
+
+	flush_run_jobs(sd);
+
+	pthread_mutex_lock(&pending_lock);
+	updates.swap(pending_updates);
+	pending_update_idx.clear();
+	pthread_mutex_unlock(&pending_lock);
+
+	if (updates.empty())
+		return 0;
+
+	phase_timer timer(PHASE_ATTR_UPDATES);
+
+	if (has_list_requests(sd)) {
+		for (auto &pu : updates) {
+			jobids.push_back(const_cast<char *>(pu.first.c_str()));
+			attribs.push_back(pu.second);
+		}
+
+		rc = pbs_asyalterjoblist(sd, jobids.data(), attribs.data(), jobids.size(), NULL);
+		if (rc != 0)
+			log_eventf(PBSEVENT_SCHED, PBS_EVENTCLASS_SCHED, LOG_WARNING, __func__,
+				   "Failed to update attributes of %d jobs: %s (%d)",
+				   static_cast<int>(updates.size()), pbse_to_txt(pbs_errno), pbs_errno);
+		else
+			last_attr_updates = time(NULL);
+	} else {
+		for (auto &pu : updates)
+			if (alter_job(sd, pu.first, pu.second) == 0 && rc == 0)
+				rc = pbs_errno;
+	}
+
+	for (auto &pu : updates)
+		free_attrl_list(pu.second);
+
+	return rc;
+}
+
+/**
+ * @brief	Send everything queued by send_run_job() and send_attr_updates().
+ *		Call before any other request goes to the server.
+ *
+ * @param[in]	sd	-	communication handle
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	!0	error (pbs_errno)
+ */
+int
+flush_pending_requests(int sd)
+{
+	int rc;
+	int rc2;
+
+	rc = flush_run_jobs(sd);
+	rc2 = flush_attr_updates(sd);
+
+	return rc != 0 ? rc : rc2;
+}
+
+/**
+ * @brief
+ * 		send delayed attributes to the server for a job
+ *
+ * @par	When the server supports it, the updates are queued and sent
+ *	with the updates of other jobs by flush_attr_updates().
+ *
+ * @param[in]	sd	-	communication handle
+ * @param[in]	resresv	-	resource_resv object for job
+ * @param[in]	pattr	-	attrl list to update on the server
+ *
+ * @return	int
+ * @retval	1	success
+ * @retval	0	failure to update
+ */
+int
+send_attr_updates(int sd, resource_resv *resresv, struct attrl *pattr)
+{
+	const std::string &job_name = resresv->name;
+
+	if (job_name.empty() || pattr == NULL)
+		return 0;
+
+	if (sd == SIMULATE_SD || replay_active())
+		return 1; /* simulation always successful */
+
+	phase_timer timer(PHASE_ATTR_UPDATES);
+
+	/* while a status reply is being read the updates can only be queued */
+	if (requests_held || has_list_requests(sd)) {
+		size_t num_queued;
+		bool queued;
+
+		pthread_mutex_lock(&pending_lock);
+		queued = queue_attr_updates(job_name, pattr);
+		num_queued = pending_updates.size();
+		pthread_mutex_unlock(&pending_lock);
+
+		if (queued) {
+			if (num_queued >= ATTR_UPDATE_BATCH_SIZE)
+				flush_attr_updates(sd);
+			return 1;
+		}
+		if (requests_held) {
+			log_err(errno, __func__, MEM_ERR_MSG);
+			return 0;
+		}
+	}
+
+	flush_pending_requests(sd);
+
+	return alter_job(sd, job_name, pattr);
+}
+
 /**
  * @brief	Wrapper for pbs_preempt_jobs
  *
@@ -148,6 +477,9 @@ send_attr_updates(int sd, resource_resv *resresv, struct attrl *pattr)
 preempt_job_info *
 send_preempt_jobs(int sd, char **preempt_jobs_list)
 {
+	if (replay_active())
+		return NULL;
+	flush_pending_requests(sd);
 	return pbs_preempt_jobs(sd, preempt_jobs_list);
 }
 
@@ -165,6 +497,9 @@ send_preempt_jobs(int sd, char **preempt_jobs_list)
 int
 send_sigjob(int sd, resource_resv *resresv, const char *signal, char *extend)
 {
+	flush_pending_requests(sd);
+	if (replay_active())
+		return 0;
 	return pbs_sigjob(sd, const_cast<char *>(resresv->name.c_str()), const_cast<char *>(signal), extend);
 }
 
@@ -184,6 +519,9 @@ send_sigjob(int sd, resource_resv *resresv, const char *signal, char *extend)
 int
 send_confirmresv(int sd, resource_resv *resv, const char *location, unsigned long start, const char *extend)
 {
+	flush_pending_requests(sd);
+	if (replay_active())
+		return 0;
 	return pbs_confirmresv(sd, const_cast<char *>(resv->name.c_str()), const_cast<char *>(location), start, const_cast<char *>(extend));
 }
 
@@ -202,9 +540,96 @@ send_confirmresv(int sd, resource_resv *resv, const char *location, unsigned lon
 struct batch_status *
 send_selstat(int sd, struct attropl *attrib, struct attrl *rattrib, char *extend)
 {
+	flush_pending_requests(sd);
+	if (replay_active()) {
+		pbs_errno = PBSE_NONE;
+		return NULL;
+	}
 	return pbs_selstat(sd, attrib, rattrib, extend);
 }
 
+/**
+ * @brief	Wrapper for pbs_selstat_stream.  Nothing else is sent to the
+ *		server until the whole reply is read, attribute updates made by
+ *		cb are queued.
+ *
+ * @par	A replayed cycle has to use send_selstat() and a captured cycle
+ *	should, so the jobs are recorded.
+ *
+ * @param[in] sd - communication handle
+ * @param[in] attrib - pointer to attropl structure(selection criteria)
+ * @param[in] rattrib - list of attributes to return
+ * @param[in] extend - extend string to encode req
+ * @param[in] cb - called with each job as it is read
+ * @param[in] arg - passed to cb
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	!0	error (pbs_errno)
+ */
+int
+send_selstat_stream(int sd, struct attropl *attrib, struct attrl *rattrib, char *extend, pbs_status_cb cb, void *arg)
+{
+	int rc;
+
+	flush_pending_requests(sd);
+	if (replay_active()) {
+		pbs_errno = PBSE_NONE;
+		return 0;
+	}
+
+	requests_held = true;
+	rc = pbs_selstat_stream(sd, attrib, rattrib, extend, cb, arg);
+	requests_held = false;
+
+	return rc;
+}
+
+/**
+ * @brief	Wrapper for pbs_selectjob
+ *
+ * @param[in] sd - communication handle
+ * @param[in] attrib - pointer to attropl structure(selection criteria)
+ * @param[in] extend - extend string to encode req
+ *
+ * @return	char **
+ * @retval	NULL terminated array of job ids (free with free())
+ * @retval	NULL for error or no jobs
+ */
+char **
+send_selectjob(int sd, struct attropl *attrib, char *extend)
+{
+	flush_pending_requests(sd);
+	if (replay_active()) {
+		pbs_errno = PBSE_NONE;
+		return NULL;
+	}
+	return pbs_selectjob(sd, attrib, extend);
+}
+
+/**
+ * @brief	Wrapper for pbs_statjob
+ *
+ * @param[in] sd - communication handle
+ * @param[in] id - job id or comma separated list of job ids
+ * @param[in] attrib - pointer to attribute list
+ * @param[in] extend - extend string for encoding req
+ *
+ * @return	struct batch_status *
+ * @retval	list of queried jobs
+ * @retval	NULL for error
+ */
+struct batch_status *
+send_statjob(int sd, char *id, struct attrl *attrib, char *extend)
+{
+	flush_pending_requests(sd);
+	if (replay_active()) {
+		pbs_errno = PBSE_NONE;
+		return NULL;
+	}
+	return pbs_statjob(sd, id, attrib, extend);
+}
+
 /**
  * @brief	Wrapper for pbs_statvnode
  *
@@ -220,7 +645,57 @@ send_selstat(int sd, struct attropl *attrib, struct attrl *rattrib, char *extend
 struct batch_status *
 send_statvnode(int sd, char *id, struct attrl *attrib, char *extend)
 {
-	return pbs_statvnode(sd, id, attrib, extend);
+	flush_pending_requests(sd);
+	if (replay_active())
+		return replay_next(REPLAY_STATVNODE);
+	return capture_record(REPLAY_STATVNODE, pbs_statvnode(sd, id, attrib, extend));
+}
+
+/**
+ * @brief	Wrapper for pbs_statvnode_stream.  Nothing else is sent to the
+ *		server until the whole reply is read.
+ *
+ * @par	A replayed or captured cycle gets the whole list from
+ *	send_statvnode() and hands it to cb a vnode at a time.
+ *
+ * @param[in] sd - communication handle
+ * @param[in] id - object id
+ * @param[in] attrib - pointer to attribute list
+ * @param[in] extend - extend string for encoding req
+ * @param[in] cb - called with each vnode as it is read
+ * @param[in] arg - passed to cb
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	!0	error (pbs_errno)
+ */
+int
+send_statvnode_stream(int sd, char *id, struct attrl *attrib, char *extend, pbs_status_cb cb, void *arg)
+{
+	int rc;
+
+	flush_pending_requests(sd);
+	if (replay_active() || capture_active()) {
+		struct batch_status *bs;
+		struct batch_status *next;
+
+		pbs_errno = PBSE_NONE;
+		bs = send_statvnode(sd, id, attrib, extend);
+		if (bs == NULL)
+			return replay_active() ? PBSE_NONE : pbs_errno;
+		for (; bs != NULL; bs = next) {
+			next = bs->next;
+			bs->next = NULL;
+			cb(bs, arg);
+		}
+		return 0;
+	}
+
+	requests_held = true;
+	rc = pbs_statvnode_stream(sd, id, attrib, extend, cb, arg);
+	requests_held = false;
+
+	return rc;
 }
 
 /**
@@ -237,7 +712,10 @@ send_statvnode(int sd, char *id, struct attrl *attrib, char *extend)
 struct batch_status *
 send_statsched(int sd, struct attrl *attrib, char *extend)
 {
-	return pbs_statsched(sd, attrib, extend);
+	flush_pending_requests(sd);
+	if (replay_active())
+		return replay_next(REPLAY_STATSCHED);
+	return capture_record(REPLAY_STATSCHED, pbs_statsched(sd, attrib, extend));
 }
 
 /**
@@ -255,7 +733,10 @@ send_statsched(int sd, struct attrl *attrib, char *extend)
 struct batch_status *
 send_statqueue(int sd, char *id, struct attrl *attrib, char *extend)
 {
-	return pbs_statque(sd, id, attrib, extend);
+	flush_pending_requests(sd);
+	if (replay_active())
+		return replay_next(REPLAY_STATQUEUE);
+	return capture_record(REPLAY_STATQUEUE, pbs_statque(sd, id, attrib, extend));
 }
 
 /**
@@ -272,7 +753,10 @@ send_statqueue(int sd, char *id, struct attrl *attrib, char *extend)
 struct batch_status *
 send_statserver(int sd, struct attrl *attrib, char *extend)
 {
-	return pbs_statserver(sd, attrib, extend);
+	flush_pending_requests(sd);
+	if (replay_active())
+		return replay_next(REPLAY_STATSERVER);
+	return capture_record(REPLAY_STATSERVER, pbs_statserver(sd, attrib, extend));
 }
 
 /**
@@ -290,7 +774,10 @@ send_statserver(int sd, struct attrl *attrib, char *extend)
 struct batch_status *
 send_statrsc(int sd, char *id, struct attrl *attrib, char *extend)
 {
-	return pbs_statrsc(sd, id, attrib, extend);
+	flush_pending_requests(sd);
+	if (replay_active())
+		return replay_next(REPLAY_STATRSC);
+	return capture_record(REPLAY_STATRSC, pbs_statrsc(sd, id, attrib, extend));
 }
 
 /**
@@ -308,5 +795,8 @@ send_statrsc(int sd, char *id, struct attrl *attrib, char *extend)
 struct batch_status *
 send_statresv(int sd, char *id, struct attrl *attrib, char *extend)
 {
-	return pbs_statresv(sd, id, attrib, extend);
+	flush_pending_requests(sd);
+	if (replay_active())
+		return replay_next(REPLAY_STATRESV);
+	return capture_record(REPLAY_STATRESV, pbs_statresv(sd, id, attrib, extend));
 }
@@ -51,6 +51,7 @@
  * 	find_alloc_resource_by_str()
  * 	find_resource_by_str()
  * 	find_resource()
+ * 	index_resource_list()
  * 	free_server_info()
  * 	free_resource_list()
  * 	free_resource()
@@ -92,6 +93,7 @@
  * 	create_total_counts()
  * 	update_total_counts()
  * 	update_total_counts_on_end()
+ * 	calc_limits_gen()
  * 	get_sched_rank()
  * 	add_queue_to_list()
  * 	find_queue_list_by_priority()
@@ -108,8 +110,11 @@
 #include <ctype.h>
 #include <signal.h>
 #include <sys/wait.h>
+#include <poll.h>
 #include <algorithm>
 #include <exception>
+#include <functional>
+#include <unordered_map>
 
 #include "pbs_entlim.h"
 #include "pbs_ifl.h"
@@ -123,6 +128,7 @@
 #include "queue_info.h"
 #include "job_info.h"
 #include "misc.h"
+#include "mem_pool.h"
 #include "node_info.h"
 #include "globals.h"
 #include "resv_info.h"
@@ -144,6 +150,7 @@
 #include "hook.h"
 #include "libpbs.h"
 #include "libutil.h"
+#include "cycle_stats.h"
 #ifdef NAS
 #include "site_code.h"
 #endif
@@ -174,6 +181,7 @@ extern char **environ;
 server_info *
 query_server(status *pol, int pbs_sd)
 {
+	phase_timer timer(PHASE_QUERY_SERVER);
 	struct batch_status *server;   /* info about the server */
 	struct batch_status *bs_resvs; /* batch status of the reservations */
 	server_info *sinfo;	       /* scheduler internal form of server info */
@@ -245,6 +253,31 @@ query_server(status *pol, int pbs_sd)
 		qsort(sinfo->nodes, sinfo->num_nodes, sizeof(node_info *),
 		      multi_node_sort);
 
+	/* index the node names so execvnodes can be resolved without scanning the nodes */
+	{
+		auto name_ind = std::make_shared<std::unordered_map<std::string, int>>();
+
+		name_ind->reserve(sinfo->num_nodes);
+		for (i = 0; i < sinfo->num_nodes; i++) {
+			sinfo->nodes[i]->node_ind = i;
+			name_ind->emplace(sinfo->nodes[i]->name, i);
+		}
+		sinfo->node_name_ind = name_ind;
+	}
+
+	/* does the sharing of the nodes make jobs exclusive wherever they run? */
+	sinfo->nodes_dflt_excl = 1;
+	sinfo->nodes_force_excl = 1;
+	for (i = 0; i < sinfo->num_nodes && sinfo->nodes_dflt_excl; i++) {
+		enum vnode_sharing sharing = sinfo->nodes[i]->sharing;
+
+		if (sharing != VNS_FORCE_EXCL && sharing != VNS_FORCE_EXCLHOST) {
+			sinfo->nodes_force_excl = 0;
+			if (sharing != VNS_DFLT_EXCL && sharing != VNS_DFLT_EXCLHOST)
+				sinfo->nodes_dflt_excl = 0;
+		}
+	}
+
 	/* get the queues */
 	sinfo->queues = query_queues(policy, pbs_sd, sinfo);
 	if (sinfo->queues.empty()) {
@@ -372,6 +405,7 @@ query_server(status *pol, int pbs_sd)
 		}
 		create_total_counts(sinfo, NULL, NULL, SERVER);
 	}
+	sinfo->limits_gen = calc_limits_gen(sinfo);
 	if (job_arrays_associated == FALSE) {
 		for (i = 0; sinfo->running_jobs[i] != NULL; i++) {
 			if ((sinfo->running_jobs[i]->job->is_subjob) &&
@@ -385,6 +419,7 @@ query_server(status *pol, int pbs_sd)
 
 	policy->equiv_class_resdef = create_resresv_sets_resdef(policy);
 	sinfo->equiv_classes = create_resresv_sets(policy, sinfo);
+	prune_ec_verdicts(sinfo);
 
 	/* To avoid duplicate accounting of jobs on nodes, we are only interested in
 	 * jobs that are bound to the server nodes and not those bound to reservation
@@ -438,6 +473,15 @@ query_server(status *pol, int pbs_sd)
 		int ct;
 		ct = count_array(sinfo->buckets);
 		qsort(sinfo->buckets, ct, sizeof(node_bucket *), multi_bkt_sort);
+
+		/* the nodes' bucket_ind were set before the sort */
+		for (i = 0; i < ct; i++) {
+			int k;
+
+			for (k = pbs_bitmap_first_on_bit(sinfo->buckets[i]->bkt_nodes); k >= 0;
+			     k = pbs_bitmap_next_on_bit(sinfo->buckets[i]->bkt_nodes, k))
+				sinfo->unordered_nodes[k]->bucket_ind = i;
+		}
 	}
 
 	pbs_statfree(server);
@@ -615,10 +659,269 @@ query_server_info(status *pol, struct batch_status *server)
 	return sinfo;
 }
 
+/* output of a server_dyn_res script, kept for conf.dyn_res_cache_ttl seconds */
+struct dyn_res_cached {
+	std::string output;
+	time_t fetched;
+};
+static std::unordered_map<std::string, dyn_res_cached> dyn_res_cache;
+
+/* one server_dyn_res script running this cycle */
+struct dyn_res_run {
+	const dyn_res *dr;
+	schd_resource *res;
+	pid_t pid;
+	int fd;
+	int pipe_err;
+	bool done;
+	size_t len;
+	char buf[256];
+};
+
+/**
+ * @brief
+ * 		fork a server_dyn_res script with its stdout connected to a pipe
+ *
+ * @param[in,out]	run	-	the script to start. On return run->pid and
+ *					run->fd are set, or run->pipe_err on error
+ *
+ * @return	void
+ */
+static void
+start_dyn_res(dyn_res_run *run)
+{
+	sigset_t allsigs;
+	int pdes[2];
+
+	errno = 0;
+	if (pipe(pdes) < 0) {
+		run->pipe_err = errno;
+		return;
+	}
+
+	switch (run->pid = fork()) {
+		case -1: /* error */
+			run->pid = 0;
+			close(pdes[0]);
+			close(pdes[1]);
+			run->pipe_err = errno;
+			return;
+		case 0: /* child */
+			close(pdes[0]);
+			if (pdes[1] != STDOUT_FILENO) {
+				dup2(pdes[1], STDOUT_FILENO);
+				close(pdes[1]);
+			}
+			setpgid(0, 0);
+			if (sigemptyset(&allsigs) == -1) {
+				log_err(errno, __func__, "sigemptyset failed");
+			}
+			if (sigprocmask(SIG_SETMASK, &allsigs, NULL) == -1) { /* unblock all signals */
+				log_err(errno, __func__, "sigprocmask(UNBLOCK)");
+			}
+
+			char *argv[4];
+			argv[0] = const_cast<char *>("/bin/sh");
+			argv[1] = const_cast<char *>("-c");
+			argv[2] = const_cast<char *>(run->dr->command_line.c_str());
+			argv[3] = NULL;
+
+			execve("/bin/sh", argv, environ);
+			_exit(127);
+	}
+
+	close(pdes[1]);
+	run->fd = pdes[0];
+}
+
+/**
+ * @brief
+ * 		read the first line of output of all running server_dyn_res scripts
+ *
+ * @par
+ *		All scripts are read at the same time, so the cycle waits for the
+ *		slowest script rather than for the sum of them.  A script which has
+ *		not written a full line within server_dyn_res_alarm seconds of being
+ *		started is timed out.
+ *
+ * @param[in,out]	runs	-	the running scripts
+ *
+ * @return	void
+ */
+static void
+collect_dyn_res(std::vector<dyn_res_run> &runs)
+{
+	time_t deadline = time(NULL) + sc_attrs.server_dyn_res_alarm;
+	std::vector<struct pollfd> pfds;
+	std::vector<dyn_res_run *> polled;
+
+	while (true) {
+		int timeout = -1;
+		int ret;
+
+		pfds.clear();
+		polled.clear();
+		for (auto &run : runs) {
+			if (run.fd < 0 || run.done)
+				continue;
+			struct pollfd pfd = {run.fd, POLLIN, 0};
+			pfds.push_back(pfd);
+			polled.push_back(&run);
+		}
+		if (pfds.empty())
+			break;
+
+		if (sc_attrs.server_dyn_res_alarm) {
+			time_t left = deadline - time(NULL);
+			if (left <= 0)
+				break;
+			timeout = left * 1000;
+		}
+
+		ret = poll(pfds.data(), pfds.size(), timeout);
+		if (ret == -1) {
+			if (errno == EINTR)
+				continue;
+			for (auto run : polled)
+				log_eventf(PBSEVENT_ERROR, PBS_EVENTCLASS_SERVER, LOG_DEBUG, "server_dyn_res",
+					   "Select() failed for script %s", run->dr->command_line.c_str());
+			return;
+		} else if (ret == 0)
+			break;
+
+		for (size_t i = 0; i < pfds.size(); i++) {
+			dyn_res_run *run = polled[i];
+			ssize_t n;
+
+			if (pfds[i].revents == 0)
+				continue;
+
+			n = read(run->fd, run->buf + run->len, sizeof(run->buf) - 1 - run->len);
+			if (n < 0) {
+				if (errno == EINTR || errno == EAGAIN)
+					continue;
+				run->pipe_err = errno;
+				run->done = true;
+			} else if (n == 0)
+				run->done = true;
+			else {
+				run->len += n;
+				run->buf[run->len] = '\0';
+				if (strchr(run->buf, '\n') != NULL || run->len == sizeof(run->buf) - 1)
+					run->done = true;
+			}
+		}
+	}
+
+	for (auto &run : runs) {
+		if (run.fd >= 0 && !run.done) {
+			log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_SERVER, LOG_DEBUG, "server_dyn_res",
+				   "Program %s timed out", run.dr->command_line.c_str());
+			run.len = 0;
+		}
+	}
+}
+
+/**
+ * @brief
+ * 		set a server_dyn_res resource from the output of its script
+ *
+ * @param[in]	dr	-	the server_dyn_res entry
+ * @param[in]	res	-	the resource to set
+ * @param[in]	buf	-	first line of output of the script (may be empty)
+ * @param[in]	pipe_err	-	errno of a failure to run the script or 0
+ *
+ * @return	bool
+ * @retval	true	: the resource was set from buf
+ * @retval	false	: the resource was set to 0
+ */
+static bool
+set_dyn_res(const dyn_res &dr, schd_resource *res, char *buf, int pipe_err)
+{
+	char res_zero[] = "0"; /* dynamic res failure implies resource <-0 */
+	int k = strlen(buf);
+	bool valid = false;
+
+	if (k > 0) {
+		/* chop \r or \n from buf so that is_num() doesn't think it's a str */
+		while (--k) {
+			if ((buf[k] != '\n') && (buf[k] != '\r'))
+				break;
+			buf[k] = '\0';
+		}
+		if (set_resource(res, buf, RF_AVAIL) == 0) {
+			log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_SERVER, LOG_DEBUG, "server_dyn_res",
+				   "Script %s returned bad output", dr.command_line.c_str());
+			(void) set_resource(res, res_zero, RF_AVAIL);
+		} else
+			valid = true;
+	} else {
+		if (pipe_err != 0)
+			log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_SERVER, LOG_DEBUG, "server_dyn_res",
+				   "Can't pipe to program %s: %s", dr.command_line.c_str(), strerror(pipe_err));
+		log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_SERVER, LOG_DEBUG, "server_dyn_res",
+			   "Setting resource %s to 0", res->name);
+		(void) set_resource(res, res_zero, RF_AVAIL);
+	}
+	if (res->type.is_non_consumable)
+		log_eventf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_SERVER, LOG_DEBUG, "server_dyn_res",
+			   "%s = %s", dr.command_line.c_str(), res_to_str(res, RF_AVAIL));
+	else
+		log_eventf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_SERVER, LOG_DEBUG, "server_dyn_res",
+			   "%s = %s (\"%s\")", dr.command_line.c_str(), res_to_str(res, RF_AVAIL), buf);
+
+	return valid;
+}
+
+/**
+ * @brief
+ * 		terminate the process groups of server_dyn_res scripts
+ *
+ * @par
+ *		All scripts are sent SIGTERM together and share one grace period
+ *		before the ones still running are sent SIGKILL.
+ *
+ * @param[in]	runs	-	the scripts started this cycle
+ *
+ * @return	void
+ */
+static void
+reap_dyn_res(std::vector<dyn_res_run> &runs)
+{
+	bool waiting = false;
+
+	for (auto &run : runs) {
+		if (run.fd >= 0)
+			close(run.fd);
+		if (run.pid > 0) {
+			kill(-run.pid, SIGTERM);
+			if (waitpid(run.pid, NULL, WNOHANG) == 0)
+				waiting = true;
+			else
+				run.pid = 0;
+		}
+	}
+	if (!waiting)
+		return;
+
+	usleep(250000);
+	for (auto &run : runs) {
+		if (run.pid > 0 && waitpid(run.pid, NULL, WNOHANG) == 0) {
+			kill(-run.pid, SIGKILL);
+			waitpid(run.pid, NULL, 0);
+		}
+	}
+}
+
 /**
  * @brief
  * 		execute all configured server_dyn_res scripts
  *
+ * @par
+ *		The scripts are run concurrently.  If server_dyn_res_cache_ttl is
+ *		set, the output of a script is reused for that many seconds
+ *		instead of running the script every cycle.
+ *
  * @param[in]	sinfo	-	server info
  *
  * @retval	0	: on success
@@ -627,155 +930,75 @@ query_server_info(status *pol, struct batch_status *server)
 int
 query_server_dyn_res(server_info *sinfo)
 {
-	int k;
-	int pipe_err;
 	char res_zero[] = "0"; /* dynamic res failure implies resource <-0 */
 	schd_resource *res;    /* used for updating node resources */
-	FILE *fp;	       /* for popen() for res_assn */
+	std::vector<dyn_res_run> runs;
+	time_t now = time(NULL);
 
+	runs.reserve(conf.dynamic_res.size());
 	for (const auto &dr : conf.dynamic_res) {
 		res = find_alloc_resource_by_str(sinfo->res, dr.res);
-		if (res != NULL) {
-			fd_set set;
-			sigset_t allsigs;
-			pid_t pid = 0; /* pid of child */
-			int pdes[2];
-			char buf[256]; /* buffer for reading from pipe */
-			k = 0;
-			buf[0] = '\0';
+		if (res == NULL)
+			continue;
 
-			if (sinfo->res == NULL)
-				sinfo->res = res;
+		if (sinfo->res == NULL)
+			sinfo->res = res;
 
-			pipe_err = errno = 0;
+		if (conf.dyn_res_cache_ttl > 0) {
+			auto it = dyn_res_cache.find(dr.command_line);
+			if (it != dyn_res_cache.end() && now - it->second.fetched < conf.dyn_res_cache_ttl) {
+				char buf[256];
 
-/* Make sure file does not have open permissions */
-#if !defined(DEBUG) && !defined(NO_SECURITY_CHECK)
-			int err;
-			err = tmp_file_sec_user(const_cast<char *>(dr.script_name.c_str()), 0, 1, S_IWGRP | S_IWOTH, 1, getuid());
-			if (err != 0) {
-				log_eventf(PBSEVENT_SECURITY, PBS_EVENTCLASS_SERVER, LOG_ERR, "server_dyn_res",
-					   "error: %s file has a non-secure file access, setting resource %s to 0, errno: %d",
-					   dr.script_name.c_str(), res->name, err);
-				set_resource(res, res_zero, RF_AVAIL);
+				pbs_strncpy(buf, it->second.output.c_str(), sizeof(buf));
+				set_dyn_res(dr, res, buf, 0);
 				continue;
 			}
+		}
+
+/* Make sure file does not have open permissions */
+#if !defined(DEBUG) && !defined(NO_SECURITY_CHECK)
+		int err;
+		err = tmp_file_sec_user(const_cast<char *>(dr.script_name.c_str()), 0, 1, S_IWGRP | S_IWOTH, 1, getuid());
+		if (err != 0) {
+			log_eventf(PBSEVENT_SECURITY, PBS_EVENTCLASS_SERVER, LOG_ERR, "server_dyn_res",
+				   "error: %s file has a non-secure file access, setting resource %s to 0, errno: %d",
+				   dr.script_name.c_str(), res->name, err);
+			set_resource(res, res_zero, RF_AVAIL);
+			continue;
+		}
 #endif
 
-			if (pipe(pdes) < 0) {
-				pipe_err = errno;
-			}
-			if (!pipe_err) {
-				switch (pid = fork()) {
-					case -1: /* error */
-						close(pdes[0]);
-						close(pdes[1]);
-						pipe_err = errno;
-						break;
-					case 0: /* child */
-						close(pdes[0]);
-						if (pdes[1] != STDOUT_FILENO) {
-							dup2(pdes[1], STDOUT_FILENO);
-							close(pdes[1]);
-						}
-						setpgid(0, 0);
-						if (sigemptyset(&allsigs) == -1) {
-							log_err(errno, __func__, "sigemptyset failed");
-						}
-						if (sigprocmask(SIG_SETMASK, &allsigs, NULL) == -1) { /* unblock all signals */
-							log_err(errno, __func__, "sigprocmask(UNBLOCK)");
-						}
+		runs.emplace_back();
+		dyn_res_run &run = runs.back();
+		run.dr = &dr;
+		run.res = res;
+		run.pid = 0;
+		run.fd = -1;
+		run.pipe_err = 0;
+		run.done = false;
+		run.len = 0;
+		run.buf[0] = '\0';
+		start_dyn_res(&run);
+	}
 
-						char *argv[4];
-						argv[0] = const_cast<char *>("/bin/sh");
-						argv[1] = const_cast<char *>("-c");
-						argv[2] = const_cast<char *>(dr.command_line.c_str());
-						argv[3] = NULL;
+	if (runs.empty())
+		return 0;
 
-						execve("/bin/sh", argv, environ);
-						_exit(127);
-				}
-			}
+	collect_dyn_res(runs);
 
-			k = 0;
-			if (!pipe_err) {
-				int ret;
-				FD_ZERO(&set);
-				FD_SET(pdes[0], &set);
-				if (sc_attrs.server_dyn_res_alarm) {
-					struct timeval timeout;
-					timeout.tv_sec = sc_attrs.server_dyn_res_alarm;
-					timeout.tv_usec = 0;
-					ret = select(FD_SETSIZE, &set, NULL, NULL, &timeout);
-				} else {
-					ret = select(FD_SETSIZE, &set, NULL, NULL, NULL);
-				}
-				if (ret == -1) {
-					log_eventf(PBSEVENT_ERROR, PBS_EVENTCLASS_SERVER, LOG_DEBUG, "server_dyn_res",
-						   "Select() failed for script %s", dr.command_line.c_str());
-				} else if (ret == 0) {
-					log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_SERVER, LOG_DEBUG, "server_dyn_res",
-						   "Program %s timed out", dr.command_line.c_str());
-				}
-				if (pid > 0) {
-					close(pdes[1]);
-					if (ret > 0) {
-						/* Parent; only open if child created and select showed sth to read,
-						* but assume fdopen can't fail
-						*/
-						fp = fdopen(pdes[0], "r");
-						if (fgets(buf, sizeof(buf), fp) == NULL) {
-							pipe_err = errno;
-						} else
-							k = strlen(buf);
-
-						fclose(fp);
-					} else
-						close(pdes[0]);
-				}
-			}
-
-			if (k > 0) {
-				buf[k] = '\0';
-				/* chop \r or \n from buf so that is_num() doesn't think it's a str */
-				while (--k) {
-					if ((buf[k] != '\n') && (buf[k] != '\r'))
-						break;
-					buf[k] = '\0';
-				}
-				if (set_resource(res, buf, RF_AVAIL) == 0) {
-					log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_SERVER, LOG_DEBUG, "server_dyn_res",
-						   "Script %s returned bad output", dr.command_line.c_str());
-					(void) set_resource(res, res_zero, RF_AVAIL);
-				}
-			} else {
-				if (pipe_err != 0)
-					log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_SERVER, LOG_DEBUG, "server_dyn_res",
-						   "Can't pipe to program %s: %s", dr.command_line.c_str(), strerror(pipe_err));
-				log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_SERVER, LOG_DEBUG, "server_dyn_res",
-					   "Setting resource %s to 0", res->name);
-				(void) set_resource(res, res_zero, RF_AVAIL);
-			}
-			if (res->type.is_non_consumable)
-				log_eventf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_SERVER, LOG_DEBUG, "server_dyn_res",
-					   "%s = %s", dr.command_line.c_str(), res_to_str(res, RF_AVAIL));
-			else
-				log_eventf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_SERVER, LOG_DEBUG, "server_dyn_res",
-					   "%s = %s (\"%s\")", dr.command_line.c_str(), res_to_str(res, RF_AVAIL), buf);
-
-			if (pid > 0) {
-				kill(-pid, SIGTERM);
-				if (waitpid(pid, NULL, WNOHANG) == 0) {
-					usleep(250000);
-					if (waitpid(pid, NULL, WNOHANG) == 0) {
-						kill(-pid, SIGKILL);
-						waitpid(pid, NULL, 0);
-					}
-				}
-			}
+	for (auto &run : runs) {
+		run.buf[run.len] = '\0';
+		if (run.len > 0 && conf.dyn_res_cache_ttl > 0) {
+			dyn_res_cached &cached = dyn_res_cache[run.dr->command_line];
+			cached.output = run.buf;
+			cached.fetched = now;
 		}
+		if (!set_dyn_res(*run.dr, run.res, run.buf, run.pipe_err))
+			dyn_res_cache.erase(run.dr->command_line);
 	}
 
+	reap_dyn_res(runs);
+
 	return 0;
 }
 
@@ -883,6 +1106,12 @@ find_resource_by_str(schd_resource *reslist, const char *name)
 	if (reslist == NULL || name == NULL)
 		return NULL;
 
+	if (reslist->def_index != NULL) {
+		resdef *def = find_resdef(name);
+		if (def != NULL)
+			return find_resource(reslist, def);
+	}
+
 	resp = reslist;
 
 	while (resp != NULL && strcmp(resp->name, name))
@@ -917,12 +1146,79 @@ find_resource(schd_resource *reslist, resdef *def)
 
 	resp = reslist;
 
+	if (reslist->def_index != NULL) {
+		if (def->index < reslist->def_index_size) {
+			resp = reslist->def_index[def->index];
+			if (resp != NULL && resp->def == def)
+				return resp;
+		}
+		/* resources added after the list was indexed are not in the index */
+		resp = reslist->def_index_tail->next;
+	}
+
 	while (resp != NULL && resp->def != def)
 		resp = resp->next;
 
 	return resp;
 }
 
+/**
+ * @brief
+ * 		index a resource list by resdef index so find_resource() on it
+ *		does not need to walk the list.  The index is kept on the head of
+ *		the list.  Resources appended to the list afterwards are still
+ *		found, but by walking from the end of the indexed part.
+ *
+ * @note
+ *		The list must not have resources removed from it while indexed.
+ *
+ * @param[in,out]	reslist	-	resource list to index
+ *
+ * @return	int
+ * @retval	1	: success
+ * @retval	0	: failure (the list is left unindexed)
+ *
+ * @par MT-Safe:	no
+ */
+int
+index_resource_list(schd_resource *reslist)
+{
+	schd_resource *resp;
+	schd_resource *tail = NULL;
+	int size = 0;
+
+	if (reslist == NULL)
+		return 0;
+
+	free(reslist->def_index);
+	reslist->def_index = NULL;
+	reslist->def_index_size = 0;
+
+	for (resp = reslist; resp != NULL; resp = resp->next) {
+		if (resp->def == NULL)
+			return 0;
+		if (resp->def->index >= size)
+			size = resp->def->index + 1;
+		tail = resp;
+	}
+
+	reslist->def_index = static_cast<schd_resource **>(calloc(size, sizeof(schd_resource *)));
+	if (reslist->def_index == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		return 0;
+	}
+
+	/* keep the first resource for a def, as walking the list would */
+	for (resp = reslist; resp != NULL; resp = resp->next)
+		if (reslist->def_index[resp->def->index] == NULL)
+			reslist->def_index[resp->def->index] = resp;
+
+	reslist->def_index_size = size;
+	reslist->def_index_tail = tail;
+
+	return 1;
+}
+
 /**
  * @brief	free the svr_to_psets map
  * 		Note: this won't be needed once we convert node_partition to a class
@@ -1087,7 +1383,10 @@ free_resource(schd_resource *resp)
 	if (resp->str_assigned != NULL)
 		free(resp->str_assigned);
 
-	free(resp);
+	if (resp->def_index != NULL)
+		free(resp->def_index);
+
+	mem_pool<schd_resource>::release(resp);
 }
 
 // Init function
@@ -1103,6 +1402,8 @@ server_info::init_server_info()
 	has_all_limit = false;
 	has_mult_express = false;
 	has_multi_vnode = false;
+	nodes_dflt_excl = false;
+	nodes_force_excl = false;
 	has_prime_queue = false;
 	has_nonprime_queue = false;
 	has_nodes_assoc_queue = false;
@@ -1114,6 +1415,7 @@ server_info::init_server_info()
 	power_provisioning = false;
 	use_hard_duration = false;
 	pset_metadata_stale = false;
+	limits_gen = 0;
 	num_parts = 0;
 	has_nonCPU_licenses = 0;
 	num_preempted = 0;
@@ -1179,12 +1481,12 @@ new_resource()
 {
 	schd_resource *resp; /* the new resource */
 
-	if ((resp = static_cast<schd_resource *>(calloc(1, sizeof(schd_resource)))) == NULL) {
+	if ((resp = mem_pool<schd_resource>::alloc()) == NULL) {
 		log_err(errno, __func__, MEM_ERR_MSG);
 		return NULL;
 	}
 
-	/* member type zero'd by calloc() */
+	/* member type zero'd by mem_pool */
 
 	resp->name = NULL;
 	resp->next = NULL;
@@ -1194,6 +1496,9 @@ new_resource()
 	resp->indirect_res = NULL;
 	resp->str_avail = NULL;
 	resp->str_assigned = NULL;
+	resp->def_index = NULL;
+	resp->def_index_size = 0;
+	resp->def_index_tail = NULL;
 	resp->assigned = RES_DEFAULT_ASSN;
 	resp->avail = RES_DEFAULT_AVAIL;
 
@@ -1585,16 +1890,13 @@ update_server_on_run(status *policy, server_info *sinfo,
 
 				resv_nodes = resresv->job->resv->resv->resv_nodes;
 				num_resv_nodes = count_array(resv_nodes);
-				qsort(resv_nodes, num_resv_nodes, sizeof(node_info *),
-				      multi_node_sort);
+				resort_array(resv_nodes, num_resv_nodes, multi_node_sort);
 			} else {
-				qsort(sinfo->nodes, sinfo->num_nodes, sizeof(node_info *),
-				      multi_node_sort);
+				resort_array(sinfo->nodes, sinfo->num_nodes, multi_node_sort);
 
 				if (sinfo->nodes != sinfo->unassoc_nodes) {
 					auto num_unassoc = count_array(sinfo->unassoc_nodes);
-					qsort(sinfo->unassoc_nodes, num_unassoc, sizeof(node_info *),
-					      multi_node_sort);
+					resort_array(sinfo->unassoc_nodes, num_unassoc, multi_node_sort);
 				}
 			}
 		}
@@ -1627,6 +1929,10 @@ update_server_on_run(status *policy, server_info *sinfo,
 			update_counts_on_run(allcts, resresv->resreq);
 		}
 	}
+
+	/* queue limits are counted even if the server has none */
+	if (resresv->is_job)
+		sinfo->limits_gen += lim_hash_running(resresv);
 }
 
 /**
@@ -1734,6 +2040,9 @@ update_server_on_end(status *policy, server_info *sinfo, queue_info *qinfo,
 				update_counts_on_end(cts, resresv->resreq);
 		}
 	}
+
+	if (resresv->is_job && resresv->job->is_running)
+		sinfo->limits_gen -= lim_hash_running(resresv);
 }
 /**
  * @brief
@@ -2004,6 +2313,8 @@ check_resv_running_on_node(resource_resv *resv, const void *arg)
 // Copy constructor
 server_info::server_info(const server_info &osinfo)
 {
+	phase_timer timer(PHASE_DUP_SERVER);
+
 	init_server_info();
 	if (osinfo.fstree != NULL)
 		fstree = new fairshare_head(*osinfo.fstree);
@@ -2015,6 +2326,8 @@ server_info::server_info(const server_info &osinfo)
 	has_grp_limit = osinfo.has_grp_limit;
 	has_proj_limit = osinfo.has_proj_limit;
 	has_multi_vnode = osinfo.has_multi_vnode;
+	nodes_dflt_excl = osinfo.nodes_dflt_excl;
+	nodes_force_excl = osinfo.nodes_force_excl;
 	has_prime_queue = osinfo.has_prime_queue;
 	has_nonprime_queue = osinfo.has_nonprime_queue;
 	has_ded_queue = osinfo.has_ded_queue;
@@ -2025,6 +2338,7 @@ server_info::server_info(const server_info &osinfo)
 	power_provisioning = osinfo.power_provisioning;
 	use_hard_duration = osinfo.use_hard_duration;
 	pset_metadata_stale = osinfo.pset_metadata_stale;
+	limits_gen = osinfo.limits_gen;
 	name = osinfo.name;
 	liminfo = lim_dup_liminfo(osinfo.liminfo);
 	server_time = osinfo.server_time;
@@ -2053,6 +2367,7 @@ server_info::server_info(const server_info &osinfo)
 		unassoc_nodes = nodes;
 
 	unordered_nodes = dup_unordered_nodes(osinfo.unordered_nodes, nodes);
+	node_name_ind = osinfo.node_name_ind;
 
 	/* dup the reservations */
 	resvs = dup_resource_resv_array(osinfo.resvs, this, NULL);
@@ -2074,7 +2389,6 @@ server_info::server_info(const server_info &osinfo)
 		for (unsigned int i = 0; i < queues.size(); i++) {
 			auto ret_val = add_queue_to_list(&queue_list, queues[i]);
 			if (ret_val == 0) {
-				fstree = NULL;
 				free_server_info();
 				throw sched_exception("Unable to add queue to queue_list", SCHD_ERROR);
 			}
@@ -2164,7 +2478,7 @@ server_info::server_info(const server_info &osinfo)
 		nodes[i]->np_arr =
 			copy_node_partition_ptr_array(osinfo.nodes[i]->np_arr, nodepart);
 		if (calendar != NULL)
-			nodes[i]->node_events = dup_te_lists(osinfo.nodes[i]->node_events, calendar->next_event);
+			nodes[i]->node_events = dup_te_lists(osinfo.nodes[i]->node_events, calendar);
 	}
 	buckets = dup_node_bucket_array(osinfo.buckets, this);
 	/* Now that all job information has been created, time to associate
@@ -2826,6 +3140,7 @@ update_universe_on_run_helper(status *policy, int pbs_sd, resource_resv *rr, uns
 					modify_resource_list(npar[j]->res, n->resreq, SCHD_INCR);
 					if (!n->ninfo->is_free)
 						npar[j]->free_nodes--;
+					npar[j]->resort = true;
 					sort_nodepart = true;
 					update_buckets_for_node(npar[j]->bkts, n->ninfo);
 				}
@@ -3432,6 +3747,41 @@ update_total_counts_on_end(server_info *si, queue_info *qi,
 	}
 }
 
+/**
+ * @brief
+ * 		calc_limits_gen - compute the generation of the inputs to the hard
+ *		limit checks: the server and queue hard limits and the running
+ *		jobs counted against them.  The running jobs' part is a sum, so
+ *		update_server_on_run() and update_server_on_end() keep it current.
+ *
+ * @param[in]	sinfo	-	the server
+ *
+ * @return	std::size_t
+ * @retval	the limits generation of the server
+ *
+ * @par MT-Safe:	no
+ */
+std::size_t
+calc_limits_gen(server_info *sinfo)
+{
+	std::hash<std::string> hash_str;
+	std::size_t gen;
+
+	if (sinfo == NULL)
+		return 0;
+
+	gen = lim_hash_hardlimits(sinfo->liminfo);
+	for (auto qinfo : sinfo->queues)
+		gen = (gen * 31 + hash_str(qinfo->name)) * 31 + lim_hash_hardlimits(qinfo->liminfo);
+
+	if (sinfo->running_jobs != NULL) {
+		for (int i = 0; sinfo->running_jobs[i] != NULL; i++)
+			gen += lim_hash_running(sinfo->running_jobs[i]);
+	}
+
+	return gen;
+}
+
 /**
  * @brief
  * 		get a unique rank to uniquely identify an object
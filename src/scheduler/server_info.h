@@ -88,6 +88,11 @@ schd_resource *find_resource_by_str(schd_resource *reslist, const std::string &n
  */
 schd_resource *find_resource(schd_resource *reslist, resdef *def);
 
+/*
+ *	index a resource list by resdef index for find_resource()
+ */
+int index_resource_list(schd_resource *reslist);
+
 /*
  *      free_resource - free a resource struct
  */
@@ -390,6 +395,11 @@ void
 update_total_counts_on_end(server_info *si, queue_info *qi,
 			   resource_resv *rr, int mode);
 
+/*
+ * compute the generation of the hard limits and the running jobs counted against them
+ */
+std::size_t calc_limits_gen(server_info *sinfo);
+
 /**
  * @brief - get a unique rank to uniquely identify an object
  * @return int
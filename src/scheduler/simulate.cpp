@@ -54,9 +54,13 @@
  * 	find_prev_timed_event()
  * 	set_timed_event_disabled()
  * 	find_timed_event()
+ * 	calendar_precedes()
+ * 	timed_event_matches()
  * 	perform_event()
  * 	exists_run_event()
  * 	calc_run_time()
+ * 	index_timed_event()
+ * 	calendar_index_events()
  * 	create_event_list()
  * 	create_events()
  * 	new_event_list()
@@ -83,6 +87,9 @@
  * 	generic_sim()
  *
  */
+#include <unordered_map>
+#include <vector>
+
 #include <pbs_config.h>
 
 #include <stdio.h>
@@ -561,6 +568,111 @@ find_timed_event(timed_event *te_list, time_t event_time)
 	return find_timed_event(te_list, "", 0, TIMED_NOEVENT, event_time);
 }
 
+/**
+ * @brief
+ * 		check if timed_event a comes before timed_event b in a calendar
+ *
+ * @param[in]	a	-	first event
+ * @param[in]	b	-	second event
+ *
+ * @return	bool
+ * @retval	true	: a is strictly before b
+ * @retval	false	: otherwise
+ */
+static bool
+calendar_precedes(timed_event *a, timed_event *b)
+{
+	timed_event *te;
+
+	if (a->event_time != b->event_time)
+		return a->event_time < b->event_time;
+
+	/* same time: only the events at that time need to be walked */
+	for (te = a->next; te != NULL && te->event_time == a->event_time; te = te->next)
+		if (te == b)
+			return true;
+
+	return false;
+}
+
+/**
+ * @brief
+ * 		check if a timed_event matches the search criteria of find_timed_event()
+ *
+ * @return	bool
+ */
+static bool
+timed_event_matches(timed_event *te, int ignore_disabled,
+		    enum timed_event_types event_type, time_t event_time)
+{
+	if (ignore_disabled && te->disabled)
+		return false;
+	if (event_type != TIMED_NOEVENT && event_type != te->event_type)
+		return false;
+	if (event_time != 0 && event_time != te->event_time)
+		return false;
+	return true;
+}
+
+/**
+ * @brief
+ * 		find a timed_event in a calendar.  This is the same search as
+ *		find_timed_event() on a timed_event list starting at 'from', but
+ *		uses the calendar's name and time indexes rather than walking
+ *		the whole list.
+ *
+ * @param[in]	calendar	- calendar to search in
+ * @param[in]	from		- event in calendar to start the search at
+ * @param[in] 	name    	- name of timed_event to search or "" to ignore
+ * @param[in] 	ignore_disabled - ignore disabled events
+ * @param[in] 	event_type 	- event_type or TIMED_NOEVENT to ignore
+ * @param[in] 	event_time 	- time or 0 to ignore
+ *
+ * @return	found timed_event
+ * @retval	NULL	: not found or on error
+ */
+timed_event *
+find_timed_event(event_list *calendar, timed_event *from, const std::string &name, int ignore_disabled,
+		 enum timed_event_types event_type, time_t event_time)
+{
+	timed_event *te;
+	timed_event *found = NULL;
+
+	if (calendar == NULL || from == NULL)
+		return NULL;
+
+	if (!name.empty()) {
+		auto range = calendar->name_index.equal_range(name);
+		for (auto it = range.first; it != range.second; it++) {
+			te = it->second;
+			if (!timed_event_matches(te, ignore_disabled, event_type, event_time))
+				continue;
+			if (te != from && calendar_precedes(te, from))
+				continue;
+			if (found == NULL || calendar_precedes(te, found))
+				found = te;
+		}
+		return found;
+	}
+
+	if (event_time != 0) {
+		if (from->event_time > event_time)
+			return NULL;
+		if (from->event_time < event_time) {
+			auto it = calendar->time_index.lower_bound(event_time);
+			if (it == calendar->time_index.end())
+				return NULL;
+			from = it->second;
+		}
+		for (te = from; te != NULL && te->event_time == event_time; te = te->next)
+			if (timed_event_matches(te, ignore_disabled, event_type, event_time))
+				return te;
+		return NULL;
+	}
+
+	return find_timed_event(from, name, ignore_disabled, event_type, event_time);
+}
+
 /**
  * @brief
  * 		takes a timed_event and performs any actions
@@ -693,6 +805,489 @@ exists_resv_event(event_list *calendar, time_t end)
 	return 0;
 }
 
+/* a consumable requested by a job and how much of it the nodes have free */
+struct start_bound_total {
+	resdef *def;
+	sch_resource_t need; /* amount requested by the whole select */
+	sch_resource_t free;
+};
+
+/* a chunk of a job and how many of it fit on the nodes */
+struct start_bound_chunk {
+	chunk *chk;
+	long long count;	       /* number of chunks all nodes can fit */
+	std::vector<long long> fits; /* number of chunks each node can fit */
+};
+
+/* an event in the calendar which touches a node */
+struct start_bound_event {
+	size_t seq; /* position of the event in start_bound::events */
+	nspec *ns;  /* the part of the event on the node */
+};
+
+/* the free resources of the nodes as the calendar plays out, as far as
+ * a job's request is concerned.  See earliest_start_bound()
+ */
+struct start_bound {
+	server_info *sinfo;
+	resource_resv *resresv;
+	bool per_node;	  /* a chunk has to fit on one node */
+	time_t duration;  /* shortest the job could run for */
+	std::vector<start_bound_total> totals;
+	std::vector<start_bound_chunk> chunks;
+	std::vector<timed_event *> events;			      /* calendar from now on */
+	size_t done;						      /* number of events which have happened */
+	std::vector<int> node_pos;				      /* node_ind to position in sinfo->nodes */
+	std::vector<std::vector<start_bound_event>> node_events;      /* events by node */
+	std::vector<size_t> node_next;				      /* first event of a node yet to happen */
+	std::unordered_map<schd_resource *, sch_resource_t> assigned; /* resources_assigned once events happen */
+	std::unordered_map<schd_resource *, std::vector<int>> users;  /* nodes drawing on a resource */
+};
+
+/**
+ * @brief	amount of a resource free
+ *
+ * @param[in]	avail	-	resources_available
+ * @param[in]	assigned	-	resources_assigned
+ *
+ * @return	amount free or SCHD_INFINITY_RES
+ */
+static sch_resource_t
+start_bound_avail(sch_resource_t avail, sch_resource_t assigned)
+{
+	if (avail == SCHD_INFINITY_RES)
+		return SCHD_INFINITY_RES;
+	if (avail - assigned <= 0)
+		return 0;
+	return avail - assigned;
+}
+
+/**
+ * @brief	resources_assigned of a resource at the current point of the walk
+ *
+ * @param[in]	sb	-	the walk
+ * @param[in]	res	-	the resource
+ *
+ * @return	amount assigned
+ */
+static sch_resource_t
+start_bound_assigned(start_bound &sb, schd_resource *res)
+{
+	auto it = sb.assigned.find(res);
+
+	return (it == sb.assigned.end()) ? res->assigned : it->second;
+}
+
+/**
+ * @brief	number of chunks which a node has the consumables for
+ *
+ * @param[in]	sb	-	the walk
+ * @param[in]	node	-	the node
+ * @param[in]	chk	-	the chunk
+ *
+ * @return	number of chunks, at most the number requested
+ */
+static long long
+start_bound_fits(start_bound &sb, node_info *node, chunk *chk)
+{
+	long long fits = chk->num_chunks;
+
+	for (resource_req *req = chk->req; req != NULL && fits > 0; req = req->next) {
+		if (!req->type.is_consumable || req->amount <= 0)
+			continue;
+
+		auto res = find_check_resource(node->res, req, UNSET_RES_ZERO);
+		if (res == NULL || !res->type.is_consumable)
+			continue;
+
+		auto free = start_bound_avail(res->avail, start_bound_assigned(sb, res));
+		if (free == SCHD_INFINITY_RES)
+			continue;
+		if (free / req->amount < fits)
+			fits = free / req->amount;
+	}
+
+	return fits;
+}
+
+/**
+ * @brief
+ * 		number of chunks which a node has the consumables for over the
+ *		whole time the job would run.  Like check_resources_for_node(),
+ *		look at the events on the node happening while the job runs.
+ *
+ * @param[in]	sb	-	the walk
+ * @param[in]	i	-	position of the node in sinfo->nodes
+ * @param[in]	sc	-	the chunk
+ * @param[in]	start	-	time the job would start
+ *
+ * @return	number of chunks, at most the number requested
+ */
+static long long
+start_bound_fits_duration(start_bound &sb, int i, start_bound_chunk &sc, time_t start)
+{
+	node_info *node = sb.sinfo->nodes[i];
+	auto &nevents = sb.node_events[i];
+	auto fits = sc.fits[i];
+	std::vector<std::pair<resource_req *, sch_resource_t>> assigned;
+
+	if (fits == 0)
+		return 0;
+
+	auto &next = sb.node_next[i];
+	while (next < nevents.size() && nevents[next].seq < sb.done)
+		next++;
+	if (next == nevents.size())
+		return fits;
+
+	for (resource_req *req = sc.chk->req; req != NULL; req = req->next) {
+		if (!req->type.is_consumable || req->amount <= 0)
+			continue;
+		auto res = find_resource(node->res, req->def);
+		/* too hard to follow, stay on the safe side */
+		if (res != NULL && res->indirect_res != NULL)
+			return fits;
+		if (res != NULL && res->type.is_consumable && res->avail != SCHD_INFINITY_RES)
+			assigned.push_back({req, start_bound_assigned(sb, res)});
+	}
+
+	auto job_excl = is_excl(sb.resresv->place_spec, node->sharing);
+	for (size_t j = next; j < nevents.size(); j++) {
+		auto te = sb.events[nevents[j].seq];
+		auto rr = static_cast<resource_resv *>(te->event_ptr);
+
+		if (te->event_time < start)
+			continue;
+		if (te->event_time >= start + sb.duration)
+			break;
+		if (job_excl || is_excl(rr->place_spec, node->sharing))
+			return 0;
+
+		for (auto &a : assigned) {
+			auto req = find_resource_req(nevents[j].ns->resreq, a.first->def);
+			if (req != NULL)
+				a.second += (te->event_type == TIMED_RUN_EVENT) ? req->amount : -req->amount;
+		}
+		if (te->event_type != TIMED_RUN_EVENT)
+			continue;
+		for (auto &a : assigned) {
+			auto res = find_resource(node->res, a.first->def);
+			auto n = start_bound_avail(res->avail, a.second) / a.first->amount;
+			if (n < fits)
+				fits = n;
+		}
+		if (fits == 0)
+			return 0;
+	}
+
+	return fits;
+}
+
+/**
+ * @brief	have an event consume or release some of a resource
+ *
+ * @param[in,out]	sb	-	the walk
+ * @param[in]	res	-	the resource
+ * @param[in]	amount	-	amount consumed or released
+ * @param[in]	release	-	true if the amount is released
+ *
+ * @return	void
+ */
+static void
+start_bound_update(start_bound &sb, schd_resource *res, sch_resource_t amount, bool release)
+{
+	auto before = start_bound_avail(res->avail, start_bound_assigned(sb, res));
+	auto it = sb.assigned.emplace(res, res->assigned).first;
+
+	/* the same as update_node_on_run() and update_node_on_end() */
+	if (release) {
+		it->second -= amount;
+		if (it->second < 0)
+			it->second = 0;
+	} else
+		it->second += amount;
+
+	if (before == SCHD_INFINITY_RES)
+		return;
+
+	auto after = start_bound_avail(res->avail, it->second);
+	for (auto &tot : sb.totals)
+		if (tot.def == res->def)
+			tot.free += after - before;
+
+	auto users = sb.users.find(res);
+	if (users == sb.users.end())
+		return;
+	for (auto &sc : sb.chunks) {
+		for (auto i : users->second) {
+			auto fits = start_bound_fits(sb, sb.sinfo->nodes[i], sc.chk);
+			sc.count += fits - sc.fits[i];
+			sc.fits[i] = fits;
+		}
+	}
+}
+
+/**
+ * @brief	could the job's request fit at the current point of the walk
+ *
+ * @param[in]	sb	-	the walk
+ * @param[in]	now	-	time of the current point of the walk
+ *
+ * @return	bool
+ */
+static bool
+start_bound_may_fit(start_bound &sb, time_t now)
+{
+	for (const auto &tot : sb.totals)
+		if (tot.free < tot.need)
+			return false;
+
+	for (const auto &sc : sb.chunks)
+		if (sc.count < sc.chk->num_chunks)
+			return false;
+
+	/* enough is free now, but is it for long enough? */
+	if (sb.duration > 0) {
+		for (auto &sc : sb.chunks) {
+			long long count = 0;
+			for (int i = 0; sb.sinfo->nodes[i] != NULL && count < sc.chk->num_chunks; i++)
+				count += start_bound_fits_duration(sb, i, sc, now);
+			if (count < sc.chk->num_chunks)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief	have the next event in the calendar happen
+ *
+ * @param[in,out]	sb	-	the walk
+ *
+ * @return	void
+ */
+static void
+start_bound_event_happens(start_bound &sb)
+{
+	auto te = sb.events[sb.done];
+
+	sb.done++;
+	if (!(te->event_type & (TIMED_RUN_EVENT | TIMED_END_EVENT)))
+		return;
+
+	auto rr = static_cast<resource_resv *>(te->event_ptr);
+	/* jobs in reservations run on the reservation's nodes */
+	if (rr->is_job && rr->job != NULL && rr->job->resv != NULL)
+		return;
+
+	for (auto ns : rr->nspec_arr) {
+		if (sb.node_pos[ns->ninfo->node_ind] == -1)
+			continue;
+
+		for (resource_req *req = ns->resreq; req != NULL; req = req->next) {
+			if (!req->type.is_consumable ||
+			    sb.resresv->select->defs.find(req->def) == sb.resresv->select->defs.end())
+				continue;
+
+			auto res = find_resource(ns->ninfo->res, req->def);
+			if (res == NULL)
+				continue;
+			if (res->indirect_res != NULL)
+				res = res->indirect_res;
+			start_bound_update(sb, res, req->amount, te->event_type == TIMED_END_EVENT);
+		}
+	}
+}
+
+/**
+ * @brief
+ * 		find the earliest time a job could possibly start.  Play the
+ *		calendar forward keeping track of how much of the consumables
+ *		each node has free and stop once the job's chunks fit for as
+ *		long as the job would run.  Only consumables are looked at, so
+ *		the job may still start later, but it can't start any earlier.
+ *
+ * @param[in]	sinfo	-	the server to look at
+ * @param[in]	resresv	-	the job
+ *
+ * @return	time_t
+ * @retval	earliest time the job could start
+ * @retval	sinfo->server_time if it could start now or we can't tell
+ */
+static time_t
+earliest_start_bound(server_info *sinfo, resource_resv *resresv)
+{
+	start_bound sb;
+	timed_event *te;
+	time_t state_time;     /* time of the last event */
+	time_t window_end = 0; /* end of the window of events state_time is in */
+	bool in_window = false;
+	long fuzzy = 0; /* window size, 0 for each event on its own */
+
+	/* jobs in reservations run on the reservation's nodes */
+	if (!resresv->is_job || resresv->job->resv != NULL || resresv->select == NULL || sinfo->calendar == NULL)
+		return sinfo->server_time;
+
+	sb.sinfo = sinfo;
+	sb.resresv = resresv;
+	/* chunks can be broken across the vnodes of a multi-vnoded host */
+	sb.per_node = !sinfo->has_multi_vnode;
+	sb.done = 0;
+
+	sb.duration = resresv->duration;
+	if (resresv->hard_duration != UNSPECIFIED && resresv->hard_duration < sb.duration)
+		sb.duration = resresv->hard_duration;
+	if (resresv->min_duration != UNSPECIFIED && resresv->min_duration < sb.duration)
+		sb.duration = resresv->min_duration;
+	if (!sb.per_node)
+		sb.duration = 0;
+
+	for (int i = 0; resresv->select->chunks[i] != NULL; i++) {
+		chunk *chk = resresv->select->chunks[i];
+
+		for (resource_req *req = chk->req; req != NULL; req = req->next) {
+			size_t j;
+
+			if (!req->type.is_consumable || req->amount <= 0)
+				continue;
+			for (j = 0; j < sb.totals.size() && sb.totals[j].def != req->def; j++)
+				;
+			if (j == sb.totals.size())
+				sb.totals.push_back({req->def, 0, 0});
+			sb.totals[j].need += req->amount * chk->num_chunks;
+		}
+		if (sb.per_node)
+			sb.chunks.push_back({chk, 0, std::vector<long long>(sinfo->num_nodes, 0)});
+	}
+
+	sb.node_pos.assign(sinfo->num_nodes, -1);
+	sb.node_events.resize(sinfo->num_nodes);
+	sb.node_next.assign(sinfo->num_nodes, 0);
+	for (int i = 0; sinfo->nodes[i] != NULL; i++) {
+		node_info *node = sinfo->nodes[i];
+
+		sb.node_pos[node->node_ind] = i;
+
+		for (size_t j = 0; j < sb.totals.size();) {
+			auto res = find_resource(node->res, sb.totals[j].def);
+
+			if (res == NULL && conf.ignore_res.find(sb.totals[j].def->name) != conf.ignore_res.end()) {
+				/* unset means infinite: nothing to say about this resource */
+				sb.totals.erase(sb.totals.begin() + j);
+				continue;
+			}
+			/* indirect resources are counted on the node they point to */
+			if (res != NULL && res->indirect_res == NULL) {
+				if (res->avail == SCHD_INFINITY_RES) {
+					sb.totals.erase(sb.totals.begin() + j);
+					continue;
+				}
+				sb.totals[j].free += start_bound_avail(res->avail, res->assigned);
+			}
+			j++;
+		}
+
+		for (auto &sc : sb.chunks) {
+			sc.fits[i] = start_bound_fits(sb, node, sc.chk);
+			sc.count += sc.fits[i];
+			for (resource_req *req = sc.chk->req; req != NULL; req = req->next) {
+				if (!req->type.is_consumable)
+					continue;
+				auto res = find_check_resource(node->res, req, UNSET_RES_ZERO);
+				if (res == NULL)
+					continue;
+				auto &users = sb.users[res];
+				if (users.empty() || users.back() != i)
+					users.push_back(i);
+			}
+		}
+	}
+
+	/* Lay out the calendar by node.  Like check_resources_for_node(), only
+	 * the first part of an event on a node counts while the job would run.
+	 */
+	te = find_init_timed_event(get_next_event(sinfo->calendar), IGNORE_DISABLED_EVENTS, ALL_MASK);
+	for (; te != NULL; te = find_next_timed_event(te, IGNORE_DISABLED_EVENTS, ALL_MASK)) {
+		sb.events.push_back(te);
+		if (!(te->event_type & (TIMED_RUN_EVENT | TIMED_END_EVENT)))
+			continue;
+
+		auto rr = static_cast<resource_resv *>(te->event_ptr);
+		if (rr->is_job && rr->job != NULL && rr->job->resv != NULL)
+			continue;
+
+		for (auto ns : rr->nspec_arr) {
+			node_info *node = ns->ninfo;
+
+			if (node == NULL || node->node_ind < 0 || node->node_ind >= sinfo->num_nodes ||
+			    sinfo->unordered_nodes[node->node_ind] != node) {
+				/* not one of our nodes: we can't follow this event */
+				sb.events.pop_back();
+				goto events_done;
+			}
+
+			auto &nevents = sb.node_events[sb.node_pos[node->node_ind]];
+			if (nevents.empty() || nevents.back().seq != sb.events.size() - 1)
+				nevents.push_back({sb.events.size() - 1, ns});
+		}
+	}
+events_done:
+	/* te is only set here if we stopped early */
+	if (start_bound_may_fit(sb, sinfo->server_time))
+		return sinfo->server_time;
+
+	/* The simulation looks at the job once per opt_backfill_fuzzy window of
+	 * events (see simulate_events()), so we only need to check where it does.
+	 * Prime time events are made up on the fly and move the windows, so with
+	 * them around we check after every event instead.
+	 */
+	if (sinfo->policy->prime_status_end == SCHD_INFINITY)
+		fuzzy = sc_attrs.opt_backfill_fuzzy ? sc_attrs.opt_backfill_fuzzy : 1;
+
+	state_time = sinfo->server_time;
+	while (sb.done < sb.events.size()) {
+		auto nte = sb.events[sb.done];
+
+		if (in_window && nte->event_time > window_end) {
+			if (start_bound_may_fit(sb, state_time))
+				return state_time;
+			in_window = false;
+		}
+		if (!in_window) {
+			window_end = fuzzy ? (nte->event_time + fuzzy) / fuzzy * fuzzy : nte->event_time;
+			in_window = true;
+		}
+		state_time = nte->event_time;
+
+		/* we don't know how much a node coming up brings */
+		if (nte->event_type == TIMED_NODE_UP_EVENT)
+			return state_time;
+
+		/* provisioning adds events we can't see coming */
+		if (nte->event_type == TIMED_RUN_EVENT) {
+			for (auto ns : static_cast<resource_resv *>(nte->event_ptr)->nspec_arr) {
+				if (ns->go_provision) {
+					fuzzy = 0;
+					window_end = state_time;
+				}
+			}
+		}
+
+		start_bound_event_happens(sb);
+	}
+
+	/* the rest of the calendar is beyond us */
+	if (te != NULL)
+		return state_time;
+
+	if (start_bound_may_fit(sb, state_time))
+		return state_time;
+
+	/* even after everything, there isn't room: let the simulation report it */
+	return sinfo->server_time;
+}
+
 /**
  * @brief
  * 		calculate the run time of a resresv through simulation of
@@ -749,13 +1344,18 @@ calc_run_time(const std::string &name, server_info *sinfo, int flags)
 	if (err == NULL)
 		return (time_t) 0;
 
+	/* Until the nodes have room for the job, there is no point in asking
+	 * if it can run.  We still simulate every event on the way there.
+	 */
+	auto bound = earliest_start_bound(sinfo, resresv);
+
 	do {
 		/* policy is used from sinfo instead of being passed into calc_run_time()
 		 * because it's being simulated/updated in simulate_events()
 		 */
 
 		auto desc = describe_simret(ret);
-		if (desc > 0 || (desc == 0 && policy_change_info(sinfo, resresv))) {
+		if (event_time >= bound && (desc > 0 || (desc == 0 && policy_change_info(sinfo, resresv)))) {
 			clear_schd_error(err);
 			nspec_arr = is_ok_to_run(sinfo->policy, sinfo, qinfo, resresv, ok_flags, err);
 		}
@@ -824,6 +1424,57 @@ calc_run_time(const std::string &name, server_info *sinfo, int flags)
 	return event_time;
 }
 
+/**
+ * @brief
+ * 		add a timed_event to a time index in calendar order.
+ *
+ * @note
+ *		Like add_timed_event(), if multiple events are at the same time,
+ *		end events come first.
+ *
+ * @param[in,out]	time_index	-	index to add to
+ * @param[in]		te		-	event to add
+ *
+ * @return	position of te in the index
+ */
+static std::multimap<time_t, timed_event *>::iterator
+index_timed_event(std::multimap<time_t, timed_event *> &time_index, timed_event *te)
+{
+	std::multimap<time_t, timed_event *>::iterator hint;
+
+	if (te->event_type == TIMED_END_EVENT)
+		hint = time_index.lower_bound(te->event_time);
+	else
+		hint = time_index.upper_bound(te->event_time);
+
+	return time_index.emplace_hint(hint, te->event_time, te);
+}
+
+/**
+ * @brief
+ * 		(re)build the time and name indexes of a calendar from its
+ *		event list.  The event list is already in calendar order.
+ *
+ * @param[in,out]	calendar	-	calendar to index
+ *
+ * @return	void
+ */
+void
+calendar_index_events(event_list *calendar)
+{
+	timed_event *te;
+
+	if (calendar == NULL)
+		return;
+
+	calendar->time_index.clear();
+	calendar->name_index.clear();
+	for (te = calendar->events; te != NULL; te = te->next) {
+		calendar->time_index.emplace_hint(calendar->time_index.end(), te->event_time, te);
+		calendar->name_index.emplace(te->name, te);
+	}
+}
+
 /**
  * @brief
  * 		create an event_list from running jobs and confirmed resvs
@@ -843,6 +1494,7 @@ create_event_list(server_info *sinfo)
 		return NULL;
 
 	elist->events = create_events(sinfo);
+	calendar_index_events(elist);
 
 	elist->next_event = elist->events;
 	elist->first_run_event = find_timed_event(elist->events, TIMED_RUN_EVENT);
@@ -867,6 +1519,8 @@ create_events(server_info *sinfo)
 {
 	timed_event *events = NULL;
 	timed_event *te = NULL;
+	timed_event *prev = NULL;
+	std::multimap<time_t, timed_event *> time_index;
 	resource_resv **all = NULL;
 	int errflag = 0;
 	int i = 0;
@@ -900,7 +1554,7 @@ create_events(server_info *sinfo)
 				errflag++;
 				break;
 			}
-			events = add_timed_event(events, te);
+			index_timed_event(time_index, te);
 		}
 
 		if (sinfo->use_hard_duration)
@@ -912,7 +1566,7 @@ create_events(server_info *sinfo)
 			errflag++;
 			break;
 		}
-		events = add_timed_event(events, te);
+		index_timed_event(time_index, te);
 	}
 
 	/* for nodes that are in state=sleep add a timed event */
@@ -925,10 +1579,21 @@ create_events(server_info *sinfo)
 				errflag++;
 				break;
 			}
-			events = add_timed_event(events, te);
+			index_timed_event(time_index, te);
 		}
 	}
 
+	/* link the events in calendar order */
+	for (auto &ti : time_index) {
+		te = ti.second;
+		te->prev = prev;
+		if (prev != NULL)
+			prev->next = te;
+		else
+			events = te;
+		prev = te;
+	}
+
 	/* A malloc error was encountered, free all allocated memory and return */
 	if (errflag > 0) {
 		free_timed_event_list(events);
@@ -952,7 +1617,7 @@ new_event_list()
 {
 	event_list *elist;
 
-	if ((elist = static_cast<event_list *>(malloc(sizeof(event_list)))) == NULL) {
+	if ((elist = new event_list()) == NULL) {
 		log_err(errno, __func__, MEM_ERR_MSG);
 		return NULL;
 	}
@@ -998,10 +1663,11 @@ dup_event_list(event_list *oelist, server_info *nsinfo)
 			free_event_list(nelist);
 			return NULL;
 		}
+		calendar_index_events(nelist);
 	}
 
 	if (oelist->next_event != NULL) {
-		nelist->next_event = find_timed_event(nelist->events, oelist->next_event->name,
+		nelist->next_event = find_timed_event(nelist, nelist->events, oelist->next_event->name, 0,
 						      oelist->next_event->event_type,
 						      oelist->next_event->event_time);
 		if (nelist->next_event == NULL) {
@@ -1014,7 +1680,7 @@ dup_event_list(event_list *oelist, server_info *nsinfo)
 
 	if (oelist->first_run_event != NULL) {
 		nelist->first_run_event =
-			find_timed_event(nelist->events, oelist->first_run_event->name, TIMED_RUN_EVENT,
+			find_timed_event(nelist, nelist->events, oelist->first_run_event->name, 0, TIMED_RUN_EVENT,
 					 oelist->first_run_event->event_time);
 		if (nelist->first_run_event == NULL) {
 			log_event(PBSEVENT_SCHED, PBS_EVENTCLASS_SCHED, LOG_WARNING, oelist->first_run_event->name,
@@ -1040,7 +1706,7 @@ free_event_list(event_list *elist)
 		return;
 
 	free_timed_event_list(elist->events);
-	free(elist);
+	delete elist;
 }
 
 /**
@@ -1146,23 +1812,24 @@ free_te_list(te_list *tel)
 /*
  * @brief te_list copy constructor
  * @param[in] ote - te_list to copy
- * @param[in] new_timed_even_list - new timed events
+ * @param[in] calendar - new calendar whose events are searched from its next event
  *
  * @return copied te_list
  */
 te_list *
-dup_te_list(te_list *ote, timed_event *new_timed_event_list)
+dup_te_list(te_list *ote, event_list *calendar)
 {
 	te_list *nte;
 
-	if (ote == NULL || new_timed_event_list == NULL)
+	if (ote == NULL || calendar == NULL || calendar->next_event == NULL)
 		return NULL;
 
 	nte = new_te_list();
 	if (nte == NULL)
 		return NULL;
 
-	nte->event = find_timed_event(new_timed_event_list, ote->event->name, ote->event->event_type, ote->event->event_time);
+	nte->event = find_timed_event(calendar, calendar->next_event, ote->event->name, 0,
+				      ote->event->event_type, ote->event->event_time);
 
 	return nte;
 }
@@ -1170,24 +1837,24 @@ dup_te_list(te_list *ote, timed_event *new_timed_event_list)
 /*
  * @brief copy constructor for a list of te_list structures
  * @param[in] ote - te_list to copy
- * @param[in] new_timed_even_list - new timed events
+ * @param[in] calendar - new calendar whose events are searched from its next event
  *
  * @return copied te_list list
  */
 
 te_list *
-dup_te_lists(te_list *ote, timed_event *new_timed_event_list)
+dup_te_lists(te_list *ote, event_list *calendar)
 {
 	te_list *nte;
 	te_list *end_te = NULL;
 	te_list *cur;
 	te_list *nte_head = NULL;
 
-	if (ote == NULL || new_timed_event_list == NULL)
+	if (ote == NULL || calendar == NULL || calendar->next_event == NULL)
 		return NULL;
 
 	for (cur = ote; cur != NULL; cur = cur->next) {
-		nte = dup_te_list(cur, new_timed_event_list);
+		nte = dup_te_list(cur, calendar);
 		if (nte == NULL) {
 			free_te_list(nte_head);
 			return NULL;
@@ -1320,8 +1987,8 @@ find_event_ptr(timed_event *ote, server_info *nsinfo)
 			break;
 		case TIMED_NODE_DOWN_EVENT:
 		case TIMED_NODE_UP_EVENT:
-			event_ptr = find_node_info(nsinfo->nodes,
-						   static_cast<node_info *>(ote->event_ptr)->name);
+			event_ptr = find_node_by_name(nsinfo,
+						      static_cast<node_info *>(ote->event_ptr)->name);
 			break;
 		default:
 			log_eventf(PBSEVENT_SCHED, PBS_EVENTCLASS_SCHED, LOG_WARNING, __func__,
@@ -1431,6 +2098,8 @@ add_event(event_list *calendar, timed_event *te)
 {
 	time_t current_time;
 	int events_is_null = 0;
+	timed_event *prev = NULL;
+	timed_event *next = NULL;
 
 	if (calendar == NULL || calendar->current_time == NULL || te == NULL)
 		return 0;
@@ -1440,7 +2109,22 @@ add_event(event_list *calendar, timed_event *te)
 	if (calendar->events == NULL)
 		events_is_null = 1;
 
-	calendar->events = add_timed_event(calendar->events, te);
+	/* the time index gives us te's neighbors in the event list */
+	auto it = index_timed_event(calendar->time_index, te);
+	if (it != calendar->time_index.begin())
+		prev = std::prev(it)->second;
+	if (std::next(it) != calendar->time_index.end())
+		next = std::next(it)->second;
+
+	te->prev = prev;
+	te->next = next;
+	if (prev != NULL)
+		prev->next = te;
+	else
+		calendar->events = te;
+	if (next != NULL)
+		next->prev = te;
+	calendar->name_index.emplace(te->name, te);
 
 	/* empty event list - the new event is the only event */
 	if (events_is_null)
@@ -1454,7 +2138,7 @@ add_event(event_list *calendar, timed_event *te)
 				calendar->next_event = te;
 			else if (te->event_time == calendar->next_event->event_time) {
 				calendar->next_event =
-					find_timed_event(calendar->events, te->event_time);
+					calendar->time_index.lower_bound(te->event_time)->second;
 			}
 		}
 	}
@@ -1550,8 +2234,24 @@ delete_event(server_info *sinfo, timed_event *e)
 	if (calendar->next_event == e)
 		calendar->next_event = e->next;
 
+	/* first_run_event is the earliest run event, so the next one follows it */
 	if (calendar->first_run_event == e)
-		calendar->first_run_event = find_timed_event(calendar->events, TIMED_RUN_EVENT);
+		calendar->first_run_event = find_init_timed_event(e->next, 0, TIMED_RUN_EVENT);
+
+	auto range = calendar->time_index.equal_range(e->event_time);
+	for (auto it = range.first; it != range.second; it++) {
+		if (it->second == e) {
+			calendar->time_index.erase(it);
+			break;
+		}
+	}
+	auto nrange = calendar->name_index.equal_range(e->name);
+	for (auto it = nrange.first; it != nrange.second; it++) {
+		if (it->second == e) {
+			calendar->name_index.erase(it);
+			break;
+		}
+	}
 
 	if (e->prev == NULL)
 		calendar->events = e->next;
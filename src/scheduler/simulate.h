@@ -139,6 +139,19 @@ timed_event *find_timed_event(timed_event *te_list, enum timed_event_types event
 timed_event *find_timed_event(timed_event *te_list, const std::string &name, enum timed_event_types event_type, time_t event_time);
 timed_event *find_timed_event(timed_event *te_list, time_t event_time);
 
+/*
+ *	find_timed_event - find a timed_event in a calendar at or after 'from'
+ *			   using the calendar's time and name indexes
+ *
+ *	return found timed_event or NULL
+ */
+timed_event *
+find_timed_event(event_list *calendar, timed_event *from, const std::string &name, int ignore_disabled,
+		 enum timed_event_types event_type, time_t event_time);
+
+/* index all the events of a calendar's event list */
+void calendar_index_events(event_list *calendar);
+
 /*
  *      next_event - move an event_list to the next event and return it
  *
@@ -442,8 +455,8 @@ generic_sim(event_list *calendar, unsigned int event_mask, time_t end, int defau
 
 te_list *new_te_list();
 
-te_list *dup_te_list(te_list *ote, timed_event *new_timed_event_list);
-te_list *dup_te_lists(te_list *ote, timed_event *new_timed_event_list);
+te_list *dup_te_list(te_list *ote, event_list *calendar);
+te_list *dup_te_lists(te_list *ote, event_list *calendar);
 
 void free_te_list(te_list *tel);
 
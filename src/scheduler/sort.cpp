@@ -67,6 +67,8 @@
  * 	cmp_node_host()
  * 	cmp_aoe()
  * 	cmp_job_preemption_time_asc()
+ * 	cmp_job_sort_key()
+ * 	sort_job_array()
  * 	sort_jobs()
  * 	swapfunc()
  * 	med3()
@@ -77,6 +79,7 @@
 
 #include "check.h"
 #include "constant.h"
+#include "cycle_stats.h"
 #include "data_types.h"
 #include "fairshare.h"
 #include "fifo.h"
@@ -87,11 +90,13 @@
 #include "resource_resv.h"
 #include "server_info.h"
 #include "sort.h"
+#include <algorithm>
 #include <errno.h>
 #include <log.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <vector>
 
 #ifdef NAS
 #include "site_code.h"
@@ -1116,6 +1121,149 @@ cmp_resv_state(const void *r1, const void *r2)
 		return 0;
 }
 
+/*
+ * the cmp_sort() keys of a job, computed once per sort by sort_job_array()
+ * so the comparisons do not have to look them up again
+ */
+struct job_sort_key {
+	resource_resv *resresv;
+	bool runnable;
+	int preempt;
+	time_t time_preempted;
+	double formula_value;
+	const sch_resource_t *res_keys; /* the job's multi_sort() keys, one per sort_by entry */
+};
+
+/**
+ * @brief
+ * 		cmp_job_sort_key - compare two jobs by their precomputed keys.
+ *		This is the same order as cmp_sort() for two jobs.
+ *
+ * @param[in]	k1	-	keys of job 1
+ * @param[in]	k2	-	keys of job 2
+ *
+ * @return	int
+ * @retval -1, 0, 1 : standard qsort() cmp
+ */
+static int
+cmp_job_sort_key(const job_sort_key &k1, const job_sort_key &k2)
+{
+	if (k1.runnable != k2.runnable)
+		return k1.runnable ? -1 : 1;
+
+	/* higher preemption priority first */
+	if (k1.preempt != k2.preempt)
+		return k1.preempt > k2.preempt ? -1 : 1;
+
+	/* preempted jobs first, the earliest preempted first */
+	if (k1.time_preempted != k2.time_preempted) {
+		if (k1.time_preempted == UNSPECIFIED)
+			return 1;
+		if (k2.time_preempted == UNSPECIFIED)
+			return -1;
+		return k1.time_preempted < k2.time_preempted ? -1 : 1;
+	}
+
+	/* higher job_sort_formula value first */
+	if (k1.formula_value != k2.formula_value)
+		return k1.formula_value > k2.formula_value ? -1 : 1;
+
+	auto r1 = k1.resresv;
+	auto r2 = k2.resresv;
+#ifndef NAS /* localmod 041 */
+	if (r1->server->policy->fair_share) {
+		int cmp = cmp_fairshare(&r1, &r2);
+		if (cmp != 0)
+			return cmp;
+	}
+#endif /* localmod 041 */
+
+	int i = 0;
+	for (const auto &si : *cstat.sort_by) {
+		auto v1 = k1.res_keys[i];
+		auto v2 = k2.res_keys[i];
+		i++;
+
+		if (v1 == v2)
+			continue;
+		if (si.order == ASC)
+			return v1 < v2 ? -1 : 1;
+		else
+			return v1 < v2 ? 1 : -1;
+	}
+
+	/* stabilize the sort */
+	if (r1->qrank != r2->qrank)
+		return r1->qrank < r2->qrank ? -1 : 1;
+	if (r1->rank != r2->rank)
+		return r1->rank < r2->rank ? -1 : 1;
+
+	return 0;
+}
+
+/**
+ * @brief
+ * 		sort_job_array - sort an array of jobs into cmp_sort() order.
+ *		The keys of each job are computed once up front.  Jobs that are
+ *		still in order from the last sort are kept in place, and only
+ *		the jobs that moved are sorted and merged back in.  When a sort
+ *		is repeated after a job runs, only a few jobs move.
+ *
+ * @param[in,out]	jobs	-	the jobs to sort
+ * @param[in]		num_jobs	-	the number of jobs in the array
+ *
+ * @return	void
+ */
+static void
+sort_job_array(resource_resv **jobs, int num_jobs)
+{
+	auto less = [](const job_sort_key &k1, const job_sort_key &k2) {
+		return cmp_job_sort_key(k1, k2) < 0;
+	};
+
+	if (jobs == NULL || num_jobs < 2)
+		return;
+
+	auto num_res_keys = cstat.sort_by->size();
+	std::vector<sch_resource_t> res_keys(num_jobs * num_res_keys);
+	std::vector<job_sort_key> keys(num_jobs);
+
+	for (int i = 0; i < num_jobs; i++) {
+		auto r = jobs[i];
+		auto &k = keys[i];
+		auto rk = res_keys.data() + i * num_res_keys;
+
+		k.resresv = r;
+		k.runnable = in_runnable_state(r);
+		k.preempt = r->job->preempt;
+		k.time_preempted = r->job->time_preempted;
+		k.formula_value = r->job->formula_value;
+		k.res_keys = rk;
+		for (const auto &si : *cstat.sort_by)
+			*rk++ = find_resresv_amount(r, si.res_name, si.def);
+	}
+
+	if (std::is_sorted(keys.begin(), keys.end(), less))
+		return;
+
+	/* keep the longest in order run from the front, pull out the rest */
+	std::vector<job_sort_key> in_order;
+	std::vector<job_sort_key> moved;
+	in_order.reserve(num_jobs);
+	for (const auto &k : keys) {
+		if (in_order.empty() || !less(k, in_order.back()))
+			in_order.push_back(k);
+		else
+			moved.push_back(k);
+	}
+
+	std::sort(moved.begin(), moved.end(), less);
+	std::merge(in_order.begin(), in_order.end(), moved.begin(), moved.end(), keys.begin(), less);
+
+	for (int i = 0; i < num_jobs; i++)
+		jobs[i] = keys[i].resresv;
+}
+
 /**
  * @brief
  * 		sort_jobs - This function sorts all jobs according to their preemption
@@ -1132,6 +1280,7 @@ cmp_resv_state(const void *r1, const void *r2)
 void
 sort_jobs(status *policy, server_info *sinfo)
 {
+	phase_timer timer(PHASE_SORT);
 	/** sort jobs in such a way that Higher Priority jobs come on top
 	 * followed by preempted jobs and then normal jobs
 	 */
@@ -1146,8 +1295,7 @@ sort_jobs(status *policy, server_info *sinfo)
 			 */
 			for (auto qinfo : sinfo->queues) {
 				if (qinfo->sc.total > 0) {
-					qsort(qinfo->jobs, qinfo->sc.total,
-					      sizeof(resource_resv *), cmp_sort);
+					sort_job_array(qinfo->jobs, qinfo->sc.total);
 				}
 			}
 			for (auto qinfo : sinfo->queues) {
@@ -1160,24 +1308,23 @@ sort_jobs(status *policy, server_info *sinfo)
 		}
 		/** Sort on entire complex **/
 		else if (!policy->by_queue && !policy->round_robin) {
-			qsort(sinfo->jobs, count_array(sinfo->jobs), sizeof(resource_resv *), cmp_sort);
+			sort_job_array(sinfo->jobs, count_array(sinfo->jobs));
 		}
 	} else if (policy->by_queue) {
 		for (auto qinfo : sinfo->queues) {
-			qsort(qinfo->jobs, count_array(qinfo->jobs), sizeof(resource_resv *), cmp_sort);
+			sort_job_array(qinfo->jobs, count_array(qinfo->jobs));
 		}
-		qsort(sinfo->jobs, count_array(sinfo->jobs), sizeof(resource_resv *), cmp_sort);
+		sort_job_array(sinfo->jobs, count_array(sinfo->jobs));
 	} else if (policy->round_robin) {
 		if (sinfo->queue_list != NULL) {
 			int queue_list_size = count_array(sinfo->queue_list);
 			for (int i = 0; i < queue_list_size; i++) {
 				int queue_index_size = count_array(sinfo->queue_list[i]);
 				for (int j = 0; j < queue_index_size; j++) {
-					qsort(sinfo->queue_list[i][j]->jobs, count_array(sinfo->queue_list[i][j]->jobs),
-					      sizeof(resource_resv *), cmp_sort);
+					sort_job_array(sinfo->queue_list[i][j]->jobs, count_array(sinfo->queue_list[i][j]->jobs));
 				}
 			}
 		}
 	} else
-		qsort(sinfo->jobs, count_array(sinfo->jobs), sizeof(resource_resv *), cmp_sort);
+		sort_job_array(sinfo->jobs, count_array(sinfo->jobs));
 }
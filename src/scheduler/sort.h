@@ -40,6 +40,9 @@
 #ifndef _SORT_H
 #define _SORT_H
 
+#include <algorithm>
+#include <vector>
+
 /*
  *	compare two new numerical resource numbers
  *
@@ -189,4 +192,54 @@ int cmp_resv_state(const void *r1, const void *r2);
  */
 void sort_jobs(status *policy, server_info *sinfo);
 
+/*
+ *	resort_array - re-sort an array which was sorted with cmp before the
+ *		       sort keys of a few of its elements changed
+ *
+ *	A running job only changes the nodes it runs on, so most of the array
+ *	is still in order.  The elements which are out of order are taken out,
+ *	sorted on their own and merged back in.  This is O(N) when few elements
+ *	moved instead of O(N log N).  cmp must be a total order (e.g., tie
+ *	broken by rank) so the result is the same as qsort().
+ */
+template <typename T>
+void
+resort_array(T **arr, int num, int (*cmp)(const void *, const void *))
+{
+	std::vector<T *> kept;
+	std::vector<T *> moved;
+
+	if (arr == NULL || num < 2)
+		return;
+
+	kept.reserve(num);
+	for (int i = 0; i < num; i++) {
+		if (!kept.empty() && cmp(&kept.back(), &arr[i]) > 0) {
+			moved.push_back(arr[i]);
+			continue;
+		}
+		/* arr[i] is out of order with a next element which is in order
+		 * with what was kept: arr[i] is the one which moved
+		 */
+		if (i + 1 < num && cmp(&arr[i], &arr[i + 1]) > 0 &&
+		    (kept.empty() || cmp(&kept.back(), &arr[i + 1]) <= 0)) {
+			moved.push_back(arr[i]);
+			continue;
+		}
+		kept.push_back(arr[i]);
+	}
+
+	if (moved.empty())
+		return;
+
+	if (moved.size() > kept.size()) {
+		qsort(arr, num, sizeof(T *), cmp);
+		return;
+	}
+
+	auto less = [cmp](T *a, T *b) { return cmp(&a, &b) < 0; };
+	std::sort(moved.begin(), moved.end(), less);
+	std::merge(kept.begin(), kept.end(), moved.begin(), moved.end(), arr, less);
+}
+
 #endif /* _SORT_H */
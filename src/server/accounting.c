@@ -83,6 +83,11 @@ static int acct_auto_switch = 0;
 static char *acct_buf = 0;
 static int acct_bufsize = PBS_ACCT_MAX_RCD;
 static const char *do_not_emit_alter[] = {ATTR_estimated, ATTR_used, NULL};
+static char *acct_pend = NULL; /* records not yet written, see acct_flush() */
+static size_t acct_pend_len = 0;
+static size_t acct_pend_size = 0;
+
+#define ACCT_PEND_FLUSH_SIZE (64 * 1024) /* write out once this much is pending */
 
 /* Global Data */
 
@@ -967,16 +972,48 @@ acct_open(char *filename)
 void
 acct_close()
 {
+	acct_flush();
 	if (acct_opened == 1) {
 		(void) fclose(acctfile);
 		acct_opened = 0;
 	}
 }
 
+/**
+ * @brief
+ * acct_flush - write out the accounting records queued by
+ *	write_account_record()
+ *
+ * @par
+ *	Records are gathered in memory and written with one write per main
+ *	loop iteration instead of one per record, which matters when many
+ *	jobs end at once.  A private buffer is used rather than stdio's so
+ *	that forked children, which exit through exit(), never write out a
+ *	copy of what the server still has pending.
+ *
+ * @return	void
+ */
+void
+acct_flush(void)
+{
+	if (acct_pend_len == 0)
+		return;
+
+	if (acct_opened == 1) {
+		if ((fwrite(acct_pend, 1, acct_pend_len, acctfile) != acct_pend_len) ||
+		    (fflush(acctfile) != 0))
+			log_err(errno, __func__, "failed to write accounting records");
+	}
+	acct_pend_len = 0;
+}
+
 /**
  * @brief
  * write_account_record - write basic accounting record
  *
+ * @par
+ *	The record is queued and written out by acct_flush().
+ *
  * @param[in]	acctype - accounting record type
  * @param[in]	id - accounting record id
  * @param[in,out]	text - text to log, may be null
@@ -987,6 +1024,8 @@ void
 write_account_record(int acctype, const char *id, char *text)
 {
 	struct tm *ptm;
+	size_t need;
+	int len;
 
 	if (acct_opened == 0)
 		return; /* file not open, don't bother */
@@ -1002,11 +1041,38 @@ write_account_record(int acctype, const char *id, char *text)
 	if (text == NULL)
 		text = "";
 
-	(void) fprintf(acctfile,
+	/* "MM/DD/YYYY hh:mm:ss;t;" is 22 characters, plus ';', '\n' and '\0' */
+	need = acct_pend_len + strlen(id) + strlen(text) + 32;
+	if (need > acct_pend_size) {
+		char *tmp;
+		size_t newsz = acct_pend_size ? acct_pend_size : ACCT_PEND_FLUSH_SIZE;
+
+		while (newsz < need)
+			newsz *= 2;
+		if ((tmp = realloc(acct_pend, newsz)) == NULL) {
+			/* write straight through rather than lose the record */
+			acct_flush();
+			(void) fprintf(acctfile,
+				       "%02d/%02d/%04d %02d:%02d:%02d;%c;%s;%s\n",
+				       ptm->tm_mon + 1, ptm->tm_mday, ptm->tm_year + 1900,
+				       ptm->tm_hour, ptm->tm_min, ptm->tm_sec,
+				       (char) acctype, id, text);
+			return;
+		}
+		acct_pend = tmp;
+		acct_pend_size = newsz;
+	}
+
+	len = snprintf(acct_pend + acct_pend_len, acct_pend_size - acct_pend_len,
 		       "%02d/%02d/%04d %02d:%02d:%02d;%c;%s;%s\n",
 		       ptm->tm_mon + 1, ptm->tm_mday, ptm->tm_year + 1900,
 		       ptm->tm_hour, ptm->tm_min, ptm->tm_sec,
 		       (char) acctype, id, text);
+	if (len > 0)
+		acct_pend_len += len;
+
+	if (acct_pend_len >= ACCT_PEND_FLUSH_SIZE)
+		acct_flush();
 }
 
 /**
@@ -1219,6 +1285,22 @@ account_jobend(job *pjob, char *used, int type)
 		len -= i;
 	}
 
+	/* how long mother superior took to start the job, if reported */
+
+	if (is_jattr_set(pjob, JOB_ATR_startup_latency)) {
+		i = 18 + strlen(get_jattr_str(pjob, JOB_ATR_startup_latency));
+		if (i > len)
+			if (grow_acct_buf(&pb, &len, i) == -1)
+				goto writeit;
+
+		(void) sprintf(pb, " startup_latency=%s",
+			       get_jattr_str(pjob, JOB_ATR_startup_latency));
+
+		i = strlen(pb);
+		pb += i;
+		len -= i;
+	}
+
 	/* add the execution ended time */
 	i = 18;
 	if (i > len)
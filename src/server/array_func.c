@@ -238,7 +238,7 @@ find_arrayparent(char *subjobid)
 static void
 update_array_indices_remaining_attr(job *parent)
 {
-	char *pnewstr = range_to_str(parent->ji_ajinfo->trm_quelist);
+	char *pnewstr = range_set_to_str(parent->ji_ajinfo->trm_quelist);
 
 	if (pnewstr == NULL || *pnewstr == '\0')
 		pnewstr = "-";
@@ -284,9 +284,12 @@ update_sj_parent(job *parent, job *sj, char *sjid, char oldstate, char newstate)
 	ptbl->tkm_subjsct[nstatenum]++;
 
 	if (oldstate == JOB_STATE_LTR_QUEUED)
-		range_remove_value(&ptbl->trm_quelist, idx);
-	if (newstate == JOB_STATE_LTR_QUEUED)
-		range_add_value(&ptbl->trm_quelist, idx, ptbl->tkm_step);
+		range_set_remove_value(ptbl->trm_quelist, idx);
+	if (newstate == JOB_STATE_LTR_QUEUED) {
+		range_set_add_value(ptbl->trm_quelist, idx);
+		range_set_remove_value(ptbl->trm_failedlist, idx);
+		range_set_remove_value(ptbl->trm_termlist, idx);
+	}
 	update_array_indices_remaining_attr(parent);
 
 	if (sj && newstate != JOB_STATE_LTR_QUEUED) {
@@ -316,6 +319,54 @@ update_sj_parent(job *parent, job *sj, char *sjid, char oldstate, char newstate)
 	job_save_db(parent);
 }
 
+/**
+ * @brief
+ * 		record_sj_final - remember how a subjob ended before its job
+ *		structure is purged, so the parent can keep reporting it from
+ *		its compact range sets instead of holding the subjob itself.
+ *
+ * @param[in,out]	parent - pointer to parent job.
+ * @param[in]	sj - pointer to the subjob about to be purged.
+ *
+ * @return	void
+ */
+void
+record_sj_final(job *parent, job *sj)
+{
+	ajinfo_t *ptbl;
+	int idx;
+
+	if (parent == NULL || sj == NULL || (ptbl = parent->ji_ajinfo) == NULL)
+		return;
+	if ((idx = get_index_from_jid(sj->ji_qs.ji_jobid)) == -1)
+		return;
+
+	if (sj->ji_terminated || check_job_substate(sj, JOB_SUBSTATE_TERMINATED))
+		range_set_add_value(ptbl->trm_termlist, idx);
+	else if (check_job_substate(sj, JOB_SUBSTATE_FAILED) ||
+		 (is_jattr_set(sj, JOB_ATR_exit_status) && get_jattr_long(sj, JOB_ATR_exit_status) != 0))
+		range_set_add_value(ptbl->trm_failedlist, idx);
+}
+
+/**
+ * @brief
+ * 		free_ajinfo - free an array job tracking table and its range sets
+ *
+ * @param[in]	ptbl - pointer to the table, may be NULL
+ *
+ * @return	void
+ */
+void
+free_ajinfo(ajinfo_t *ptbl)
+{
+	if (ptbl == NULL)
+		return;
+	free_range_set(ptbl->trm_quelist);
+	free_range_set(ptbl->trm_failedlist);
+	free_range_set(ptbl->trm_termlist);
+	free(ptbl);
+}
+
 /**
  * @brief
  * 		chk_array_doneness - check if all subjobs are expired and if so,
@@ -423,7 +474,7 @@ get_subjob_and_state(job *parent, int sjidx, char *state, int *substate)
 
 	sj = find_job(create_subjob_id(parent->ji_qs.ji_jobid, sjidx));
 	if (sj == NULL) {
-		if (range_contains(parent->ji_ajinfo->trm_quelist, sjidx)) {
+		if (range_set_contains(parent->ji_ajinfo->trm_quelist, sjidx)) {
 			if (state)
 				*state = JOB_STATE_LTR_QUEUED;
 			if (substate)
@@ -436,8 +487,14 @@ get_subjob_and_state(job *parent, int sjidx, char *state, int *substate)
 				else
 					*state = JOB_STATE_LTR_EXPIRED;
 			}
-			if (substate)
-				*substate = JOB_SUBSTATE_FINISHED;
+			if (substate) {
+				if (range_set_contains(parent->ji_ajinfo->trm_termlist, sjidx))
+					*substate = JOB_SUBSTATE_TERMINATED;
+				else if (range_set_contains(parent->ji_ajinfo->trm_failedlist, sjidx))
+					*substate = JOB_SUBSTATE_FAILED;
+				else
+					*substate = JOB_SUBSTATE_FINISHED;
+			}
 		}
 		return NULL;
 	}
@@ -538,10 +595,7 @@ setup_ajinfo(job *pjob, int mode)
 	char *range;
 	ajinfo_t *trktbl;
 
-	if (pjob->ji_ajinfo) {
-		free_range_list(pjob->ji_ajinfo->trm_quelist);
-		free(pjob->ji_ajinfo);
-	}
+	free_ajinfo(pjob->ji_ajinfo);
 	pjob->ji_ajinfo = NULL;
 	range = get_jattr_str(pjob, JOB_ATR_array_indices_submitted);
 	if (range == NULL)
@@ -565,14 +619,16 @@ setup_ajinfo(job *pjob, int mode)
 		return PBSE_SYSTEM;
 	for (i = 0; i < PBS_NUMJOBSTATE; i++)
 		trktbl->tkm_subjsct[i] = 0;
-	if (mode == ATR_ACTION_RECOV || mode == ATR_ACTION_ALTER)
-		trktbl->trm_quelist = NULL;
-	else {
-		trktbl->trm_quelist = new_range(start, end, step, count, NULL);
-		if (trktbl->trm_quelist == NULL) {
-			free(trktbl);
-			return PBSE_SYSTEM;
-		}
+	trktbl->trm_quelist = new_range_set(start, end, step);
+	trktbl->trm_failedlist = new_range_set(start, end, step);
+	trktbl->trm_termlist = new_range_set(start, end, step);
+	if (trktbl->trm_quelist == NULL || trktbl->trm_failedlist == NULL || trktbl->trm_termlist == NULL) {
+		free_ajinfo(trktbl);
+		return PBSE_SYSTEM;
+	}
+	/* on recovery or alter the queued set is filled in by fixup_arrayindicies */
+	if (mode != ATR_ACTION_RECOV && mode != ATR_ACTION_ALTER) {
+		range_set_fill(trktbl->trm_quelist);
 		trktbl->tkm_subjsct[JOB_STATE_QUEUED] = count;
 	}
 	trktbl->tkm_dsubjsct = 0;
@@ -648,6 +704,7 @@ int
 fixup_arrayindicies(attribute *pattr, void *pobj, int mode)
 {
 	job *pjob = pobj;
+	range *r;
 	char *range;
 	int qcount;
 
@@ -657,12 +714,12 @@ fixup_arrayindicies(attribute *pattr, void *pobj, int mode)
 	if (mode == ATR_ACTION_NEW && (pjob->ji_qs.ji_svrflags & JOB_SVFLG_HERE))
 		return PBSE_NONE;
 
-	if (pjob->ji_ajinfo->trm_quelist != NULL)
+	if (range_set_count(pjob->ji_ajinfo->trm_quelist) != 0)
 		return PBSE_BADATVAL;
 
 	range = get_jattr_str(pjob, JOB_ATR_array_indices_remaining);
-	pjob->ji_ajinfo->trm_quelist = range_parse(range);
-	if (pjob->ji_ajinfo->trm_quelist == NULL) {
+	r = range_parse(range);
+	if (r == NULL) {
 		if (range && range[0] == '-') {
 			pjob->ji_ajinfo->tkm_subjsct[JOB_STATE_QUEUED] = 0;
 			pjob->ji_ajinfo->tkm_subjsct[JOB_STATE_EXPIRED] = pjob->ji_ajinfo->tkm_ct;
@@ -672,7 +729,10 @@ fixup_arrayindicies(attribute *pattr, void *pobj, int mode)
 		return PBSE_BADATVAL;
 	}
 
-	qcount = range_count(pjob->ji_ajinfo->trm_quelist);
+	range_set_add_list(pjob->ji_ajinfo->trm_quelist, r);
+	free_range_list(r);
+
+	qcount = range_set_count(pjob->ji_ajinfo->trm_quelist);
 	pjob->ji_ajinfo->tkm_subjsct[JOB_STATE_QUEUED] = qcount;
 	pjob->ji_ajinfo->tkm_subjsct[JOB_STATE_EXPIRED] = pjob->ji_ajinfo->tkm_ct - qcount;
 	update_subjob_state_ct(pjob);
@@ -515,6 +515,19 @@ dis_request_read(int sfds, struct batch_request *request)
 			rc = decode_DIS_DelJobList(sfds, request);
 			break;
 
+		case PBS_BATCH_RunJobList:
+			rc = decode_DIS_RunJobList(sfds, request);
+			break;
+
+		case PBS_BATCH_Subscribe:
+			rc = decode_DIS_Subscribe(sfds, request);
+			break;
+
+		case PBS_BATCH_ModifyJobList:
+		case PBS_BATCH_ModifyJobList_Async:
+			rc = decode_DIS_ModifyJobList(sfds, request);
+			break;
+
 		case PBS_BATCH_DeleteJob:
 		case PBS_BATCH_DeleteResv:
 		case PBS_BATCH_ResvOccurEnd:
@@ -607,6 +620,23 @@ dis_request_read(int sfds, struct batch_request *request)
 						 &request->rq_ind.rq_select.rq_rtnattr);
 			break;
 
+		case PBS_BATCH_SelAct:
+			CLEAR_HEAD(request->rq_ind.rq_selact.rq_sel.rq_selattr);
+			CLEAR_HEAD(request->rq_ind.rq_selact.rq_sel.rq_rtnattr);
+			CLEAR_HEAD(request->rq_ind.rq_selact.rq_args);
+			request->rq_ind.rq_selact.rq_pending = NULL;
+			request->rq_ind.rq_selact.rq_acted = 0;
+			request->rq_ind.rq_selact.rq_action = disrui(sfds, &rc);
+			if (rc)
+				break;
+			rc = decode_DIS_svrattrl(sfds,
+						 &request->rq_ind.rq_selact.rq_sel.rq_selattr);
+			if (rc)
+				break;
+			rc = decode_DIS_svrattrl(sfds,
+						 &request->rq_ind.rq_selact.rq_args);
+			break;
+
 		case PBS_BATCH_StatusNode:
 		case PBS_BATCH_StatusResv:
 		case PBS_BATCH_StatusQue:
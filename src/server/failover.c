@@ -74,6 +74,7 @@
 #include <time.h>
 #include <unistd.h>
 #include <sys/wait.h>
+#include <ftw.h>
 #include "server_limits.h"
 #include "credential.h"
 #include "attribute.h"
@@ -126,6 +127,9 @@ static time_t hd_time;
 static int goidle_ack = 0;
 static char msg_takeover[] = "received takeover message from primary, going inactive";
 static char msg_regfailed[] = "Primary rejected attempt to register as Secondary";
+static time_t prewarm_since;	/* mtime cutoff of the current warming pass */
+static time_t prewarm_last;	/* when the last warming pass was made */
+static long prewarm_files;	/* files hinted in the current warming pass */
 
 /**
  * @brief
@@ -957,6 +961,74 @@ takeover_from_secondary()
 	return 1;
 }
 
+/**
+ * @brief
+ *		prewarm_file - nftw() callback for prewarm_standby(), asks the
+ *		kernel to read a file changed since the last pass into the page cache
+ *
+ * @param[in] path - path of the file
+ * @param[in] sb - stat of the file
+ * @param[in] flag - nftw type flag
+ * @param[in] ftw - nftw level information (unused)
+ *
+ * @return	int
+ * @retval	0	- always, keep walking
+ */
+static int
+prewarm_file(const char *path, const struct stat *sb, int flag, struct FTW *ftw)
+{
+	int fd;
+
+	if ((flag != FTW_F) || !S_ISREG(sb->st_mode) || (sb->st_size == 0))
+		return 0;
+	if (sb->st_mtime < prewarm_since)
+		return 0;
+	if ((fd = open(path, O_RDONLY | O_NOFOLLOW)) == -1)
+		return 0;
+#ifdef POSIX_FADV_WILLNEED
+	(void) posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+#endif
+	close(fd);
+	prewarm_files++;
+	return 0;
+}
+
+/**
+ * @brief
+ *		prewarm_standby - while the primary is up, keep the dataservice files
+ *		and server_priv of an inactive secondary in the page cache so that
+ *		starting the dataservice and recovering the server at takeover do not
+ *		wait on cold storage.  The first pass hints every file, later passes
+ *		only the files changed since the previous pass.
+ *
+ * @see
+ *		be_secondary
+ */
+static void
+prewarm_standby(void)
+{
+	char datastore[MAXPATHLEN + 1];
+
+	if ((pbs_conf.pbs_secondary_prewarm == 0) ||
+	    (time_now < prewarm_last + (time_t) pbs_conf.pbs_secondary_prewarm))
+		return;
+
+	/* one second of overlap so files written during the last pass are not missed */
+	prewarm_since = (prewarm_last == 0) ? 0 : prewarm_last - 1;
+	prewarm_last = time_now;
+	prewarm_files = 0;
+
+	snprintf(datastore, sizeof(datastore), "%s/datastore", pbs_conf.pbs_home_path);
+	(void) nftw(datastore, prewarm_file, 16, FTW_PHYS);
+	(void) nftw(path_priv, prewarm_file, 16, FTW_PHYS);
+
+	if (prewarm_files > 0) {
+		sprintf(log_buffer, "Secondary prewarmed %ld changed files", prewarm_files);
+		log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SERVER, LOG_DEBUG,
+			  msg_daemonname, log_buffer);
+	}
+}
+
 /**
  * @brief
  * 		be_secondary - detect if primary is up
@@ -1111,7 +1183,8 @@ be_secondary(time_t delay)
 					sprintf(log_buffer, "Secondary has not received handshake in %ld seconds", time_now - hd_time);
 					log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER,
 						  LOG_WARNING, msg_daemonname, log_buffer);
-				}
+				} else
+					prewarm_standby();
 				break;
 
 			case SECONDARY_STATE_nohsk:
@@ -103,7 +103,10 @@
 #include <dirent.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <sys/wait.h>
+#include <sys/socket.h>
+#include <poll.h>
 #include <ctype.h>
 #include <errno.h>
 #include <assert.h>
@@ -166,6 +169,17 @@ static int g_hook_replies_recvd = 0;	    /* used only in TPP mode */
 static time_t g_sync_hook_time = 0;	    /* time when mom hook files were last sent */
 static long long int g_sync_hook_tid = 0LL; /* identifies the latest group of hook updates to send out */
 static unsigned long hook_rescdef_checksum = 0;
+static int hook_executor_fd = -1;	    /* server's end of the hook executor socket */
+static long hook_executor_runid = 0;	    /* id of the last periodic run handed to it */
+
+/* a periodic hook run handed to the hook executor */
+struct hook_executor_run {
+	hook *phook;
+	long runid;  /* event id of the task marking the run in progress */
+	pid_t pid;   /* process running the hook, 0 until the executor says */
+	char infile[MAXPATHLEN + 1];
+	char outfile[MAXPATHLEN + 1];
+};
 
 /* mom hook action(s) to keep track */
 
@@ -185,6 +199,7 @@ extern char *path_hooks_tracking;
 
 extern char path_log[];
 extern char *log_file;
+extern char **environ;
 extern pbs_net_t pbs_server_addr;
 
 extern char *msg_badexit;
@@ -481,7 +496,9 @@ send_rescdef(int force)
 				 path_rescdef, path_hooks_rescdef, st);
 			log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_SERVER,
 				  LOG_ERR, __func__, log_buffer);
-		} else {
+		} else if (force || (hook_rescdef_checksum == 0) ||
+			   (crc_file(path_hooks_rescdef) != hook_rescdef_checksum)) {
+			/* only push it out if the contents actually changed */
 			add_pending_mom_hook_action(NULL, PBS_RESCDEF,
 						    MOM_HOOK_ACTION_SEND_RESCDEF);
 			do_sync_mom_hookfiles = 1;
@@ -1117,6 +1134,7 @@ mgr_hook_import(struct batch_request *preq)
 	int overwrite;
 	struct python_script *py_test_script = NULL;
 	int rc;
+	unsigned long old_checksum;
 	int hook_obj;
 
 	hook_obj = preq->rq_ind.rq_manager.rq_objtype;
@@ -1343,9 +1361,12 @@ mgr_hook_import(struct batch_request *preq)
 		} else {
 			reply_ack(preq);
 		}
+		old_checksum = phook->hook_config_checksum;
 		phook->hook_config_checksum = crc_file(output_path);
 
-		if (phook->event & MOM_EVENTS)
+		/* moms already have identical contents, nothing to send */
+		if ((phook->event & MOM_EVENTS) &&
+		    ((old_checksum == 0) || (old_checksum != phook->hook_config_checksum)))
 			add_pending_mom_hook_action(NULL, phook->hook_name,
 						    MOM_HOOK_ACTION_SEND_CONFIG);
 
@@ -1422,12 +1443,15 @@ mgr_hook_import(struct batch_request *preq)
 		goto mgr_hook_import_error;
 	}
 
+	old_checksum = phook->hook_script_checksum;
 	phook->hook_script_checksum = crc_file(output_path);
 
 	if (phook->event & HOOK_EVENT_PROVISION)
 		set_srv_prov_attributes(); /* check and set prov attributes */
 
-	if (phook->event & MOM_EVENTS)
+	/* moms already have identical contents, nothing to send */
+	if ((phook->event & MOM_EVENTS) &&
+	    ((old_checksum == 0) || (old_checksum != phook->hook_script_checksum)))
 		add_pending_mom_hook_action(NULL, phook->hook_name,
 					    MOM_HOOK_ACTION_SEND_SCRIPT);
 
@@ -2356,6 +2380,19 @@ status_hook(hook *phook, struct batch_request *preq, pbs_list_head *pstathd, cha
 				strcpy(val_str, hook_debug_as_string(phook->debug));
 			} else if (strcmp(pal->al_name, HOOKATT_FAIL_ACTION) == 0) {
 				strcpy(val_str, hook_fail_action_as_string(phook->fail_action));
+			} else if (strcmp(pal->al_name, HOOKATT_PERF_STATS) == 0) {
+				/* may not fit in val_str, add it directly */
+				char *perf_str;
+				int perf_rc;
+
+				if ((perf_str = hook_perf_as_json(phook)) == NULL)
+					return (PBSE_SYSTEM);
+				perf_rc = attrlist_add(&pstat->brp_attr, pal->al_name, perf_str);
+				free(perf_str);
+				if (perf_rc != 0)
+					return (PBSE_INTERNAL);
+				pal = (svrattrl *) GET_NEXT(pal->al_link);
+				continue;
 			} else {
 				snprintf(hook_msg, msg_len - 1,
 					 "unknown hook attribute %s", pal->al_name);
@@ -3774,7 +3811,7 @@ get_vnode_list(void)
 	for (i = 0; i < svr_totnodes; i++) {
 		pnode = pbsndlist[i];
 		for (index = 0; index < ND_ATR_LAST; index++) {
-			if ((padef + index)->at_flags & ATR_VFLAG_SET) {
+			if (((padef + index)->at_flags & ATR_VFLAG_SET) && is_nattr_set(pnode, index)) {
 				strncpy(name_str_buf, pnode->nd_name, STRBUF);
 				strcat(name_str_buf, ".");
 				strncat(name_str_buf, (padef + index)->at_name, (STRBUF - strlen(name_str_buf)));
@@ -4117,6 +4154,12 @@ server_process_hooks(int rq_type, char *rq_user, char *rq_host, hook *phook,
 	pbs_list_head event_vnode;
 	pbs_list_head event_resv;
 	char perf_label[MAXBUFLEN];
+	struct timeval tv_start;
+	struct timeval tv_run;
+	struct timeval tv_end;
+	int code_rc = 0;
+	int code_ran = 0;
+	enum hook_perf_outcome outcome;
 
 	if (phook == NULL) {
 		log_event(PBSEVENT_DEBUG3,
@@ -4141,6 +4184,8 @@ server_process_hooks(int rq_type, char *rq_user, char *rq_host, hook *phook,
 		snprintf(perf_label, sizeof(perf_label), "hook_%s_%s_%d", hook_event_as_string(hook_event), phook->hook_name, mypid);
 
 	hook_perf_stat_start(perf_label, "server_process_hooks", 1);
+	gettimeofday(&tv_start, NULL);
+	tv_run = tv_start;
 
 	if (suffix_sz == 0)
 		suffix_sz = strlen(HOOK_SCRIPT_SUFFIX);
@@ -4468,9 +4513,12 @@ server_process_hooks(int rq_type, char *rq_user, char *rq_host, hook *phook,
 
 	/* let rc pass through */
 	if (rc == 0) {
+		gettimeofday(&tv_run, NULL);
 		hook_perf_stat_start(perf_label, "run_code", 0);
 		rc = pbs_python_run_code_in_namespace(&svr_interp_data, phook->script, 0);
 		hook_perf_stat_stop(perf_label, "run_code", 0);
+		code_rc = rc;
+		code_ran = 1;
 	}
 
 	if (fp_debug != NULL) {
@@ -4832,6 +4880,22 @@ server_process_hooks(int rq_type, char *rq_user, char *rq_host, hook *phook,
 	rc = 1;
 server_process_hooks_exit:
 	hook_perf_stat_stop(perf_label, "server_process_hooks", 1);
+
+	gettimeofday(&tv_end, NULL);
+	if (!code_ran)
+		outcome = HOOK_PERF_ERROR;
+	else if (code_rc == -3)
+		outcome = HOOK_PERF_ALARM;
+	else if (rc == 1)
+		outcome = HOOK_PERF_ACCEPT;
+	else if (rc == 0)
+		outcome = HOOK_PERF_REJECT;
+	else
+		outcome = HOOK_PERF_ERROR;
+	hook_perf_record(phook, hook_event,
+			 (tv_end.tv_sec - tv_start.tv_sec) + (tv_end.tv_usec - tv_start.tv_usec) / 1e6,
+			 (tv_run.tv_sec - tv_start.tv_sec) + (tv_run.tv_usec - tv_start.tv_usec) / 1e6,
+			 outcome);
 	return (rc);
 }
 
@@ -6932,6 +6996,76 @@ get_hook_results_end:
 	return (rc);
 }
 
+/**
+ * @brief
+ *		Process the results of a server periodic hook run, and log
+ *		when the hook runs next.
+ *
+ * @param[in]	phook	- the periodic hook
+ * @param[in]	hook_error_flag	- 1 if the run failed and its results are not to be used
+ * @param[in]	hook_outfile	- hook results file
+ *
+ * @return	void
+ */
+static void
+periodic_hook_results(hook *phook, int hook_error_flag, char *hook_outfile)
+{
+	char reject_msg[HOOK_MSG_SIZE + 1] = {'\0'};
+	char *next_time_str;
+	time_t next_time;
+	int accept_flag = 1;
+	int reject_flag = 0;
+
+	if (hook_error_flag == 0) {
+		/* hook exited normally, get results from file  */
+		if (get_server_hook_results(hook_outfile, &accept_flag, &reject_flag,
+					    reject_msg, sizeof(reject_msg), NULL, phook, NULL) != 0) {
+			log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_HOOK,
+				  LOG_ERR, phook->hook_name,
+				  "Failed getting hook results");
+			/* error getting results, do not accept results */
+			hook_error_flag = 1;
+		}
+	}
+
+	if ((hook_error_flag == 1) || (accept_flag == 0)) {
+		snprintf(log_buffer, sizeof(log_buffer),
+			 "%s request rejected by '%s'",
+			 "periodic", phook->hook_name);
+		log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_HOOK,
+			  LOG_ERR, phook->hook_name, log_buffer);
+		if (reject_msg[0] != '\0') {
+			snprintf(log_buffer, sizeof(log_buffer), "%s",
+				 reject_msg);
+			/* log also the custom reject message */
+			log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_HOOK,
+				  LOG_ERR, phook->hook_name, log_buffer);
+		}
+	}
+
+	if (hook_error_flag == 0) {
+		/* No hook error means data is communicated to */
+		/* the server and actions are done to jobs.    */
+		log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_HOOK,
+			  LOG_INFO, phook->hook_name, "periodic hook accepted");
+
+		/* remove the processed results file, note that if  */
+		/* there was an error, it is left for debugging use */
+		if (!phook->debug)
+			(void) unlink(hook_outfile); /* remove file */
+	}
+
+	next_time = time_now + phook->freq;
+	next_time_str = ctime(&next_time);
+	if ((next_time_str != NULL) && (next_time_str[0] != '\0')) {
+		next_time_str[strlen(next_time_str) - 1] = '\0'; /* remove newline */
+		snprintf(log_buffer, sizeof(log_buffer), "will run on %s",
+			 next_time_str);
+		log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_HOOK,
+			  LOG_ERR, phook->hook_name, log_buffer);
+	}
+}
+
 /**
  * @brief
  *		Callback function for reaping server periodic hook child.
@@ -6947,9 +7081,6 @@ post_server_periodic_hook(struct work_task *ptask)
 	hook *phook;
 	pid_t mypid;
 	char hook_outfile[MAXPATHLEN + 1];
-	time_t next_time;
-	int accept_flag = 1;
-	int reject_flag = 0;
 	stat = ptask->wt_aux;
 	phook = (hook *) ptask->wt_parm1;
 	mypid = ptask->wt_event;
@@ -6959,8 +7090,6 @@ post_server_periodic_hook(struct work_task *ptask)
 		return;
 	}
 	if (WIFEXITED(stat)) {
-		char reject_msg[HOOK_MSG_SIZE + 1] = {'\0'};
-		char *next_time_str;
 		int hook_error_flag = 0;
 
 		/* Check hook exit status */
@@ -6977,54 +7106,7 @@ post_server_periodic_hook(struct work_task *ptask)
 			 path_hooks_workdir, HOOKSTR_PERIODIC,
 			 phook->hook_name, mypid);
 
-		if (hook_error_flag == 0) {
-			/* hook exited normally, get results from file  */
-			if (get_server_hook_results(hook_outfile, &accept_flag, &reject_flag,
-						    reject_msg, sizeof(reject_msg), NULL, phook, NULL) != 0) {
-				log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_HOOK,
-					  LOG_ERR, phook->hook_name,
-					  "Failed getting hook results");
-				/* error getting results, do not accept results */
-				hook_error_flag = 1;
-			}
-		}
-
-		if ((hook_error_flag == 1) || (accept_flag == 0)) {
-			snprintf(log_buffer, sizeof(log_buffer),
-				 "%s request rejected by '%s'",
-				 "periodic", phook->hook_name);
-			log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_HOOK,
-				  LOG_ERR, phook->hook_name, log_buffer);
-			if ((reject_msg != NULL) && (reject_msg[0] != '\0')) {
-				snprintf(log_buffer, sizeof(log_buffer), "%s",
-					 reject_msg);
-				/* log also the custom reject message */
-				log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_HOOK,
-					  LOG_ERR, phook->hook_name, log_buffer);
-			}
-		}
-
-		if (hook_error_flag == 0) {
-			/* No hook error means data is communicated to */
-			/* the server and actions are done to jobs.    */
-			log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_HOOK,
-				  LOG_INFO, phook->hook_name, "periodic hook accepted");
-
-			/* remove the processed results file, note that if  */
-			/* there was an error, it is left for debugging use */
-			if (!phook->debug)
-				(void) unlink(hook_outfile); /* remove file */
-		}
-
-		next_time = time_now + phook->freq;
-		next_time_str = ctime(&next_time);
-		if ((next_time_str != NULL) && (next_time_str[0] != '\0')) {
-			next_time_str[strlen(next_time_str) - 1] = '\0'; /* remove newline */
-			snprintf(log_buffer, sizeof(log_buffer), "will run on %s",
-				 next_time_str);
-			log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_HOOK,
-				  LOG_ERR, phook->hook_name, log_buffer);
-		}
+		periodic_hook_results(phook, hook_error_flag, hook_outfile);
 
 		sprintf(log_buffer, "Server periodic hook ran successfully");
 	} else
@@ -7036,6 +7118,458 @@ post_server_periodic_hook(struct work_task *ptask)
 	return;
 }
 
+/**
+ * @brief
+ *	Close the server's end of the hook executor socket.  The executor
+ *	exits once the hooks it is running are done.
+ */
+static void
+hook_executor_stop(void)
+{
+	if (hook_executor_fd != -1) {
+		close(hook_executor_fd);
+		hook_executor_fd = -1;
+		log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_HOOK, LOG_INFO, __func__, "hook executor stopped");
+	}
+}
+
+/**
+ * @brief
+ *	Start the hook executor, "pbs_python --hook-server", which keeps a
+ *	started interpreter and forks a small process for each periodic
+ *	hook run the server hands it, so the server itself is not forked.
+ *
+ * @param[in]	pypath - path of pbs_python
+ * @param[in]	rescdef - resourcedef file to load, or NULL
+ *
+ * @return void
+ */
+static void
+hook_executor_start(char *pypath, char *rescdef)
+{
+	int sv[2];
+	pid_t pid;
+	char fdstr[32];
+	char *arg[6];
+
+	if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) == -1) {
+		log_err(errno, __func__, "socketpair");
+		return;
+	}
+	pid = fork();
+	if (pid == -1) {
+		log_err(errno, __func__, "fork failed");
+		close(sv[0]);
+		close(sv[1]);
+		return;
+	}
+	if (pid == 0) {
+		net_close(-1);
+		tpp_terminate();
+		daemon_protect(0, PBS_DAEMON_PROTECT_OFF);
+		setsid();
+		close(sv[0]);
+
+		if (chdir(path_hooks_workdir) != 0)
+			log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_HOOK, LOG_WARNING, __func__, "unable to go to hooks tmp directory");
+		if (pbs_conf.pbs_conf_file != NULL)
+			(void) setenv("PBS_CONF_FILE", pbs_conf.pbs_conf_file, 1);
+		(void) unsetenv(PBS_HOOK_CONFIG_FILE);
+
+		snprintf(fdstr, sizeof(fdstr), "%d", sv[1]);
+		arg[0] = pypath;
+		arg[1] = HOOK_SERVER_MODE;
+		arg[2] = fdstr;
+		if (rescdef != NULL) {
+			arg[3] = "-r";
+			arg[4] = rescdef;
+			arg[5] = NULL;
+		} else
+			arg[3] = NULL;
+		execve(pypath, arg, environ);
+		log_err(errno, __func__, "execv of hook executor");
+		exit(1);
+	}
+	close(sv[1]);
+	(void) fcntl(sv[0], F_SETFD, FD_CLOEXEC);
+	hook_executor_fd = sv[0];
+	log_eventf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_HOOK, LOG_INFO, __func__, "hook executor started, pid %d", pid);
+}
+
+/**
+ * @brief
+ *	Check whether a periodic hook can be handed to the hook executor,
+ *	(re)starting the executor as needed.  The executor is restarted
+ *	when it has gone away or when the hooks resourcedef file it loaded
+ *	has changed.
+ *
+ * @param[in]	pypath - path of pbs_python
+ *
+ * @return int
+ * @retval 1	use the hook executor
+ * @retval 0	fork the server to run the hook
+ */
+static int
+hook_executor_ready(char *pypath)
+{
+	static struct stat loaded_rescdef;
+	struct stat sbuf;
+	struct pollfd pfd;
+
+	if (!pbs_conf.pbs_hook_executor) {
+		hook_executor_stop();
+		return 0;
+	}
+
+	if (stat(path_hooks_rescdef, &sbuf) != 0)
+		memset(&sbuf, 0, sizeof(sbuf));
+
+	if (hook_executor_fd != -1) {
+		pfd.fd = hook_executor_fd;
+		pfd.events = 0;
+		pfd.revents = 0;
+		if ((poll(&pfd, 1, 0) > 0) && (pfd.revents & (POLLHUP | POLLERR | POLLNVAL)))
+			hook_executor_stop();
+		else if ((sbuf.st_ino != loaded_rescdef.st_ino) ||
+			 (sbuf.st_size != loaded_rescdef.st_size) ||
+			 (sbuf.st_mtime != loaded_rescdef.st_mtime))
+			hook_executor_stop();
+	}
+	if (hook_executor_fd == -1) {
+		hook_executor_start(pypath, (sbuf.st_ino != 0) ? path_hooks_rescdef : NULL);
+		loaded_rescdef = sbuf;
+	}
+	return (hook_executor_fd != -1);
+}
+
+/**
+ * @brief
+ *	Write the <name>.<attr> svrattrl list 'phead' to a hook input file
+ *	as <head_str>["<name>"].<attr>[<resc>]=<value> lines.
+ *
+ * @param[in]	fp - hook input file
+ * @param[in]	head_str - the event list object, e.g. EVENT_VNODELIST_OBJECT
+ * @param[in]	phead - list from get_vnode_list() or get_resv_list()
+ * @param[in]	external - write values in the form pbs_python reads back
+ *			   with return_internal_value()
+ *
+ * @return void
+ */
+static void
+fprint_periodic_hook_list(FILE *fp, char *head_str, pbs_list_head *phead, int external)
+{
+	svrattrl *plist;
+	char *p;
+	char *val;
+	char *q;
+
+	for (plist = (svrattrl *) GET_NEXT(*phead); plist != NULL;
+	     plist = (svrattrl *) GET_NEXT(plist->al_link)) {
+		/* last dot, as vnode and reservation names may have dots */
+		if ((p = strrchr(plist->al_name, '.')) == NULL)
+			continue;
+		*p = '\0';
+		val = (plist->al_value != NULL) ? plist->al_value : "";
+		if (external)
+			val = return_external_value(p + 1, val);
+		q = (strchr(val, '\n') != NULL) ? "\"\"\"" : "";
+
+		fprintf(fp, "%s[\"%s\"].%s", head_str, plist->al_name, p + 1);
+		if (plist->al_resc != NULL)
+			/* drop the ",<type>" the hook encoding appends */
+			fprintf(fp, "[%.*s]", (int) strcspn(plist->al_resc, ","), plist->al_resc);
+		fprintf(fp, "=%s%s%s\n", q, val, q);
+		*p = '.';
+	}
+}
+
+/**
+ * @brief
+ *	Write the input file of a periodic hook run handed to the hook
+ *	executor: the event, and the vnode and reservation lists the forked
+ *	server would have handed the hook.  Anything else the hook asks
+ *	for through pbs.server() is queried from the server when it asks.
+ *
+ * @param[in]	run - the run
+ *
+ * @return int
+ * @retval 0	success
+ * @retval -1	error
+ */
+static int
+write_periodic_hook_input(struct hook_executor_run *run)
+{
+	FILE *fp;
+	hook *phook = run->phook;
+	pbs_list_head *phead;
+	int rc;
+
+	if ((fp = fopen(run->infile, "w")) == NULL) {
+		log_err(errno, __func__, run->infile);
+		return -1;
+	}
+	fprintf(fp, "%s.%s=%s\n", PBS_OBJ, GET_NODE_NAME_FUNC, (char *) server_host);
+	fprintf(fp, "%s.%s=%s\n", EVENT_OBJECT, PY_EVENT_TYPE, hook_event_as_string(HOOK_EVENT_PERIODIC));
+	fprintf(fp, "%s.%s=%s\n", EVENT_OBJECT, PY_EVENT_HOOK_NAME, phook->hook_name);
+	fprintf(fp, "%s.%s=%s\n", EVENT_OBJECT, PY_EVENT_HOOK_TYPE, hook_type_as_string(phook->type));
+	fprintf(fp, "%s.%s=%s\n", EVENT_OBJECT, "user", hook_user_as_string(phook->user));
+	fprintf(fp, "%s.%s=%d\n", EVENT_OBJECT, "alarm", phook->alarm);
+	fprintf(fp, "%s.%s=%d\n", EVENT_OBJECT, "freq", phook->freq);
+
+	phead = get_vnode_list();
+	fprint_periodic_hook_list(fp, EVENT_VNODELIST_OBJECT, phead, 1);
+	free_attrlist(phead);
+	phead = get_resv_list();
+	fprint_periodic_hook_list(fp, EVENT_RESVLIST_OBJECT, phead, 0);
+	free_attrlist(phead);
+
+	rc = ferror(fp);
+	if ((fclose(fp) != 0) || rc) {
+		log_err(errno, __func__, run->infile);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *	Clean up after a periodic hook run handed to the hook executor.
+ *
+ * @param[in]	sd - reply socket of the run
+ * @param[in]	status - wait status of the process that ran the hook,
+ *			 or -1 if the executor went away without one
+ *
+ * @return void
+ */
+static void
+periodic_hook_executor_done(int sd, int status)
+{
+	struct hook_executor_run *run = (struct hook_executor_run *) get_conn_data(sd);
+	struct work_task *ptask;
+
+	close_conn(sd);
+	if (run == NULL)
+		return;
+
+	/* the task marking the run is gone if the hook was deleted meanwhile */
+	ptask = find_work_task(WORK_Deferred_Other, run->phook, NULL);
+	if ((ptask != NULL) && (ptask->wt_type == WORK_Deferred_Other) &&
+	    (ptask->wt_event == run->runid)) {
+		hook *phook = run->phook;
+
+		delete_task(ptask);
+		if (status == -1)
+			log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_HOOK, LOG_ERR,
+				  phook->hook_name, "hook executor went away during hook run");
+		else if (WIFEXITED(status) && (WEXITSTATUS(status) != 0))
+			log_eventf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_HOOK, LOG_ERR,
+				   phook->hook_name, "hook exited with %d", WEXITSTATUS(status));
+		/* a hook exit value is not a verdict, the results file has it */
+		periodic_hook_results(phook, !((status != -1) && WIFEXITED(status)), run->outfile);
+		if ((status != -1) && WIFEXITED(status))
+			sprintf(log_buffer, "Server periodic hook ran successfully");
+		else
+			sprintf(log_buffer, "Server periodic hook encountered errors: %d", status);
+		log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SERVER, LOG_INFO,
+			  __func__, log_buffer);
+		if (!phook->debug)
+			(void) unlink(run->infile);
+	} else {
+		(void) unlink(run->infile);
+		(void) unlink(run->outfile);
+	}
+	free(run);
+}
+
+/**
+ * @brief
+ *	Read the hook executor's reply about a periodic hook run: first
+ *	the pid of the process it started for the run, then the wait
+ *	status of that process.
+ *
+ * @param[in]	sd - reply socket of the run
+ *
+ * @return void
+ */
+static void
+periodic_hook_executor_reply(int sd)
+{
+	struct hook_executor_run *run = (struct hook_executor_run *) get_conn_data(sd);
+	int val;
+	ssize_t n;
+
+	n = read(sd, &val, sizeof(val));
+	if ((n == -1) && ((errno == EINTR) || (errno == EAGAIN)))
+		return;
+	if (n != sizeof(val)) {
+		periodic_hook_executor_done(sd, -1);
+		return;
+	}
+	if ((run != NULL) && (run->pid == 0)) {
+		run->pid = val;
+		log_eventf(PBSEVENT_DEBUG3, PBS_EVENTCLASS_HOOK, LOG_INFO, run->phook->hook_name,
+			   "periodic hook run by hook executor in pid=%d", val);
+		return;
+	}
+	periodic_hook_executor_done(sd, val);
+}
+
+/**
+ * @brief
+ *	Hand a run of periodic hook 'phook' to the hook executor, instead
+ *	of forking the server for it.  A task with 'phook' as its parm1 is
+ *	kept while the run is in progress, as for a forked run, so runs of
+ *	the hook do not overlap.
+ *
+ * @param[in]	phook - the periodic hook
+ *
+ * @return int
+ * @retval 0	the executor took the run
+ * @retval -1	fork the server to run the hook
+ */
+static int
+run_periodic_hook_in_executor(hook *phook)
+{
+	char pypath[MAXPATHLEN + 1];
+	char hook_config_path[MAXPATHLEN + 1] = {'\0'};
+	char logmask[32];
+	char msg[HOOK_SERVER_MSG_SIZE];
+	char *arg[14];
+	union {
+		struct cmsghdr cm;
+		char buf[CMSG_SPACE(sizeof(int))];
+	} cbuf;
+	struct msghdr mh;
+	struct iovec iov;
+	struct cmsghdr *cm;
+	struct stat sbuf;
+	struct hook_executor_run *run;
+	struct work_task *ptask;
+	struct python_script *py_script = phook->script;
+	size_t len = 0;
+	size_t l;
+	char *p;
+	int sv[2];
+	int i = 0;
+
+	if ((py_script == NULL) || (py_script->path == NULL))
+		return -1;
+	snprintf(pypath, sizeof(pypath), "%s/bin/%s", pbs_conf.pbs_exec_path, PBS_PYTHON_PROGRAM);
+	if (!hook_executor_ready(pypath))
+		return -1;
+
+	if ((run = calloc(1, sizeof(struct hook_executor_run))) == NULL) {
+		log_err(errno, __func__, msg_err_malloc);
+		return -1;
+	}
+	run->phook = phook;
+	run->runid = ++hook_executor_runid;
+	snprintf(run->infile, sizeof(run->infile), FMT_HOOK_INFILE,
+		 path_hooks_workdir, HOOKSTR_PERIODIC, phook->hook_name, (int) run->runid);
+	snprintf(run->outfile, sizeof(run->outfile), FMT_HOOK_OUTFILE,
+		 path_hooks_workdir, HOOKSTR_PERIODIC, phook->hook_name, (int) run->runid);
+	if (write_periodic_hook_input(run) != 0) {
+		(void) unlink(run->infile);
+		free(run);
+		return -1;
+	}
+
+	strncpy(hook_config_path, py_script->path, sizeof(hook_config_path) - 1);
+	if ((p = strstr(hook_config_path, HOOK_SCRIPT_SUFFIX)) != NULL) {
+		size_t left = sizeof(hook_config_path) - (p - hook_config_path);
+
+		if (snprintf(p, left, "%s", HOOK_CONFIG_SUFFIX) >= (int) left)
+			p = NULL;
+	}
+	if ((p == NULL) || (stat(hook_config_path, &sbuf) != 0))
+		hook_config_path[0] = '\0';
+
+	arg[i++] = pypath;
+	arg[i++] = "--hook";
+	arg[i++] = "-i";
+	arg[i++] = run->infile;
+	arg[i++] = "-o";
+	arg[i++] = run->outfile;
+	if ((log_file == NULL) || (log_file[0] == '\0')) {
+		arg[i++] = "-L";
+		arg[i++] = path_log;
+	} else {
+		arg[i++] = "-l";
+		arg[i++] = log_file;
+	}
+	arg[i++] = "-e";
+	snprintf(logmask, sizeof(logmask), "%ld", *log_event_mask);
+	arg[i++] = logmask;
+	if (stat(path_hooks_rescdef, &sbuf) == 0) {
+		arg[i++] = "-r";
+		arg[i++] = path_hooks_rescdef;
+	}
+	arg[i++] = py_script->path;
+	arg[i] = NULL;
+
+	/* cwd\\0 hook config file\\0 argv... */
+	for (i = -2; (i < 0) || (arg[i] != NULL); i++) {
+		char *str = (i == -2) ? path_hooks_workdir : ((i == -1) ? hook_config_path : arg[i]);
+
+		l = strlen(str) + 1;
+		if (len + l > sizeof(msg)) {
+			(void) unlink(run->infile);
+			free(run);
+			return -1;
+		}
+		memcpy(msg + len, str, l);
+		len += l;
+	}
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1) {
+		log_err(errno, __func__, "socketpair");
+		(void) unlink(run->infile);
+		free(run);
+		return -1;
+	}
+
+	memset(&mh, 0, sizeof(mh));
+	memset(&cbuf, 0, sizeof(cbuf));
+	iov.iov_base = msg;
+	iov.iov_len = len;
+	mh.msg_iov = &iov;
+	mh.msg_iovlen = 1;
+	mh.msg_control = cbuf.buf;
+	mh.msg_controllen = sizeof(cbuf.buf);
+	cm = CMSG_FIRSTHDR(&mh);
+	cm->cmsg_level = SOL_SOCKET;
+	cm->cmsg_type = SCM_RIGHTS;
+	cm->cmsg_len = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(cm), &sv[1], sizeof(int));
+
+	if (sendmsg(hook_executor_fd, &mh, MSG_NOSIGNAL | MSG_DONTWAIT) != (ssize_t) len) {
+		log_err(errno, __func__, "hook executor did not take the hook");
+		hook_executor_stop();
+		close(sv[0]);
+		close(sv[1]);
+		(void) unlink(run->infile);
+		free(run);
+		return -1;
+	}
+	close(sv[1]);
+	(void) fcntl(sv[0], F_SETFD, FD_CLOEXEC);
+
+	ptask = set_task(WORK_Deferred_Other, run->runid, NULL, phook);
+	if ((ptask == NULL) ||
+	    (add_conn(sv[0], ChildPipe, (pbs_net_t) 0, 0, NULL, periodic_hook_executor_reply) == NULL)) {
+		log_err(errno, __func__, msg_err_malloc);
+		if (ptask != NULL)
+			delete_task(ptask);
+		/* closing the reply socket has the executor kill the run */
+		close(sv[0]);
+		(void) unlink(run->infile);
+		free(run);
+		return -1;
+	}
+	add_conn_data(sv[0], run);
+	return 0;
+}
+
 /**
  * @brief
  *		Callback function for Timed work tasks to run periodic hooks
@@ -7076,6 +7610,13 @@ run_periodic_hook(struct work_task *ptask)
 		return;
 	}
 
+	if (pbs_conf.pbs_hook_executor && (run_periodic_hook_in_executor(phook) == 0)) {
+		/* Set a timed task for next occurance of this hook */
+		(void) set_task(WORK_Timed, time_now + phook->freq,
+				run_periodic_hook, phook);
+		return;
+	}
+
 	pid = fork();
 
 	if (pid == -1) { /* Error on fork */
@@ -7100,6 +7641,8 @@ run_periodic_hook(struct work_task *ptask)
 		/* Close all server connections */
 		net_close(-1);
 		tpp_terminate();
+		if (hook_executor_fd != -1)
+			close(hook_executor_fd);
 		/* Unprotect child from being killed by kernel */
 		daemon_protect(0, PBS_DAEMON_PROTECT_OFF);
 
@@ -7137,3 +7680,101 @@ run_periodic_hook(struct work_task *ptask)
 	}
 	return;
 }
+
+/**
+ * @brief
+ *		Callback function for reaping the child that ran the resv_end
+ *		hooks on behalf of an internal PBS_BATCH_ResvOccurEnd request.
+ *
+ * @param[in]	ptask	- work task pointer, wt_parm1 is the reservation id
+ *
+ * @return	void
+ */
+static void
+post_resv_end_hooks(struct work_task *ptask)
+{
+	char *resvid = (char *) ptask->wt_parm1;
+	int stat = ptask->wt_aux;
+
+	if (WIFEXITED(stat) && (WEXITSTATUS(stat) == 0))
+		log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_HOOK, LOG_ERR,
+			  resvid ? resvid : __func__, "resv_end event: rejected by hook");
+	else if (!WIFEXITED(stat))
+		log_eventf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_HOOK, LOG_ERR,
+			   resvid ? resvid : __func__,
+			   "resv_end hooks encountered errors: %d", stat);
+	else
+		log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_HOOK, LOG_INFO,
+			  resvid ? resvid : __func__, "resv_end hooks ran successfully");
+	free(resvid);
+}
+
+/**
+ * @brief
+ *		Run the resv_end hooks for a request in a forked child so that
+ *		a slow hook does not stall the main loop.
+ *
+ * @par
+ *		Only used for requests the server issued to itself; resv_end
+ *		hooks are read-only and nobody waits on the outcome, so the
+ *		request is acknowledged right away and the child's exit status
+ *		is picked up later by post_resv_end_hooks().
+ *
+ * @param[in]	preq	- the PBS_BATCH_ResvOccurEnd request
+ *
+ * @return	int
+ * @retval	0	- hooks handed off to a child, request was replied to
+ * @retval	-1	- not handed off, caller must run the hooks itself
+ */
+int
+run_resv_end_hooks_async(struct batch_request *preq)
+{
+	hook *phook;
+	pid_t pid;
+	char *resvid;
+
+	if (preq->rq_conn != PBS_LOCAL_CONNECTION)
+		return (-1);
+
+	for (phook = (hook *) GET_NEXT(svr_resv_end_hooks); phook != NULL;
+	     phook = (hook *) GET_NEXT(phook->hi_resv_end_hooks)) {
+		if (phook->enabled && phook->script != NULL)
+			break;
+	}
+	if (phook == NULL)
+		return (-1); /* nothing to run, stay synchronous */
+
+	if ((resvid = strdup(preq->rq_ind.rq_manager.rq_objname)) == NULL)
+		return (-1);
+
+	pid = fork();
+	if (pid == -1) {
+		log_err(errno, __func__, "fork failed");
+		free(resvid);
+		return (-1);
+	}
+
+	if (pid != 0) { /* The parent (main server) */
+		if (set_task(WORK_Deferred_Child, (long) pid, post_resv_end_hooks, resvid) == NULL) {
+			log_err(errno, __func__, msg_err_malloc);
+			free(resvid);
+		}
+		reply_ack(preq);
+		return (0);
+	} else {
+		char hook_msg[HOOK_MSG_SIZE] = {'\0'};
+		int ret;
+
+		/* Close all server connections */
+		net_close(-1);
+		tpp_terminate();
+		/* Unprotect child from being killed by kernel */
+		daemon_protect(0, PBS_DAEMON_PROTECT_OFF);
+
+		ret = process_hooks(preq, hook_msg, sizeof(hook_msg), pbs_python_set_interrupt);
+		if (ret == 0)
+			log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_HOOK, LOG_ERR, __func__, hook_msg);
+		exit(ret == 0 ? 0 : 1);
+	}
+	return (0);
+}
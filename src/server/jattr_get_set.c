@@ -510,7 +510,7 @@ void
 mark_jattr_set(job *pjob, int attr_idx)
 {
 	if (pjob != NULL)
-		(get_jattr(pjob, attr_idx))->at_flags |= ATR_VFLAG_SET;
+		post_attr_set(get_jattr(pjob, attr_idx));
 }
 
 /**
@@ -524,6 +524,9 @@ mark_jattr_set(job *pjob, int attr_idx)
 void
 free_jattr(job *pjob, int attr_idx)
 {
-	if (pjob != NULL)
+	if (pjob != NULL) {
 		free_attr(job_attr_def, get_jattr(pjob, attr_idx), attr_idx);
+		/* so the next save drops it from the database */
+		(get_jattr(pjob, attr_idx))->at_flags |= ATR_MOD_MCACHE;
+	}
 }
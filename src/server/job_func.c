@@ -314,6 +314,7 @@ job_alloc(void)
 	CLEAR_HEAD(pj->ji_tasks);
 	CLEAR_HEAD(pj->ji_failed_node_list);
 	CLEAR_HEAD(pj->ji_node_list);
+	CLEAR_HEAD(pj->ji_ruu_sent);
 	pj->ji_taskid = TM_INIT_TASK;
 	pj->ji_numnodes = 0;
 	pj->ji_numrescs = 0;
@@ -340,6 +341,7 @@ job_alloc(void)
 	pj->ji_hook_running_bg_on = BG_NONE;
 	pj->ji_bg_hook_task = NULL;
 	pj->ji_report_task = NULL;
+	pj->ji_walltime_task = NULL;
 	pj->ji_env.v_envp = NULL;
 #ifdef WIN32
 	pj->ji_hJob = NULL;
@@ -359,11 +361,15 @@ job_alloc(void)
 	pj->ji_prunreq = NULL;
 	pj->ji_pmt_preq = NULL;
 	CLEAR_HEAD(pj->ji_svrtask);
+	CLEAR_LINK(pj->ji_dbsavelink);
+	CLEAR_LINK(pj->ji_statelink);
+	pj->ji_hist_ix = -1;
 	CLEAR_HEAD(pj->ji_rejectdest);
 	pj->ji_terminated = 0;
 	pj->ji_deletehistory = 0;
 	pj->ji_script = NULL;
 	pj->ji_prov_startjob_task = NULL;
+	pj->ji_prov_done_idx = 0;
 #endif
 	pj->ji_qs.ji_jsversion = JSVERSION;
 	pj->ji_momhandle = -1;		/* mark mom connection invalid */
@@ -444,6 +450,43 @@ free_job_work_tasks(job *pj)
 }
 #endif
 
+#ifndef PBS_MOM
+/**
+ * @brief
+ * 		job_compact_hist - release the memory a history job no longer needs
+ *
+ * @par
+ *		Drops the cached stat encodings of every attribute (they are
+ *		rebuilt on demand by the next status request) and the list of
+ *		rejected routing destinations, which is only consulted while a
+ *		job can still be routed.
+ *
+ * @param[in]	pj - pointer to job structure
+ *
+ * @return	void
+ */
+void
+job_compact_hist(job *pj)
+{
+	int i;
+	badplace *bp;
+
+	for (i = 0; i < (int) JOB_ATR_LAST; i++) {
+		attribute *pattr = get_jattr(pj, i);
+
+		if (pattr->at_user_encoded != NULL || pattr->at_priv_encoded != NULL)
+			free_svrcache(pattr);
+	}
+
+	bp = (badplace *) GET_NEXT(pj->ji_rejectdest);
+	while (bp) {
+		delete_link(&bp->bp_link);
+		free(bp);
+		bp = (badplace *) GET_NEXT(pj->ji_rejectdest);
+	}
+}
+#endif
+
 /**
  * @brief
  * 		job_free - free job structure and its various sub-structures
@@ -498,6 +541,10 @@ job_free(job *pj)
 		/* Server only */
 		badplace *bp;
 
+		/* drop any deferred database save of the job */
+		delete_link(&pj->ji_dbsavelink);
+		svr_unlink_jobstate(pj);
+
 		free_job_work_tasks(pj);
 
 		/* free any bad destination structs */
@@ -510,8 +557,7 @@ job_free(job *pj)
 		}
 	}
 	if (pj->ji_ajinfo) {
-		free_range_list(pj->ji_ajinfo->trm_quelist);
-		free(pj->ji_ajinfo);
+		free_ajinfo(pj->ji_ajinfo);
 		pj->ji_ajinfo = NULL;
 	}
 	pj->ji_parentaj = NULL;
@@ -530,6 +576,8 @@ job_free(job *pj)
 
 	if (pj->ji_grpcache)
 		(void) free(pj->ji_grpcache);
+	free(pj->ji_samples);
+	free_attrlist(&pj->ji_ruu_sent);
 
 	assert(pj->ji_preq == NULL);
 	nodes_free(pj);
@@ -566,6 +614,9 @@ job_free(job *pj)
 	if (pj->ji_report_task)
 		delete_task(pj->ji_report_task);
 
+	if (pj->ji_walltime_task)
+		delete_task(pj->ji_walltime_task);
+
 	/*
 	 ** This gets rid of any dependent job structure(s) from ji_setup.
 	 */
@@ -997,11 +1048,6 @@ job_purge(job *pjob)
 	pid_t pid = -1;
 	int child_process = 0;
 
-#else
-	extern char *msg_err_purgejob_db;
-	pbs_db_obj_info_t obj;
-	pbs_db_job_info_t dbjob;
-	void *conn = (void *) svr_db_conn;
 #endif /* PBS_MOM */
 
 	if (pjob->ji_rerun_preq != NULL) {
@@ -1089,6 +1135,10 @@ job_purge(job *pjob)
 #else  /* not PBS_MOM */
 	if ((!check_job_substate(pjob, JOB_SUBSTATE_TRANSIN)) &&
 	    (!check_job_substate(pjob, JOB_SUBSTATE_TRANSICM))) {
+		if ((pjob->ji_qs.ji_svrflags & JOB_SVFLG_SubJob) &&
+		    (!check_job_substate(pjob, JOB_SUBSTATE_RERUN3)) &&
+		    (!check_job_substate(pjob, JOB_SUBSTATE_QUEUED)))
+			record_sj_final(pjob->ji_parentaj, pjob);
 		if ((pjob->ji_qs.ji_svrflags & JOB_SVFLG_SubJob) && (!check_job_state(pjob, JOB_STATE_LTR_FINISHED))) {
 			if ((check_job_substate(pjob, JOB_SUBSTATE_RERUN3)) || (check_job_substate(pjob, JOB_SUBSTATE_QUEUED)))
 				update_sj_parent(pjob->ji_parentaj, pjob, pjob->ji_qs.ji_jobid, get_job_state(pjob), JOB_STATE_LTR_QUEUED);
@@ -1114,21 +1164,36 @@ job_purge(job *pjob)
 	 */
 	if (pjob->ji_qs.ji_un.ji_momt.ji_exitstat == JOB_EXEC_OK) {
 		/* rename the taskdir path to avoid race condition when job
-		 * reruns. It will be removed later in the child process.
+		 * reruns. It will be removed later in the child process
+		 * or by the cleanup worker.
 		 */
 		taskdir_path = rename_taskdir(pjob);
-		pid = fork();
-		if (pid > 0) {
+#ifndef WIN32
+		/* a renamed taskdir can go to the cleanup worker, leaving */
+		/* only the small files to remove here, without a fork; the */
+		/* taskdir is then already gone from under its job name */
+		if ((taskdir_path != NULL) &&
+		    (strlen(taskdir_path) > strlen(JOB_DEL_SUFFIX)) &&
+		    (strcmp(taskdir_path + strlen(taskdir_path) - strlen(JOB_DEL_SUFFIX), JOB_DEL_SUFFIX) == 0) &&
+		    (cleanup_worker_send(taskdir_path) == 0)) {
+			free(taskdir_path);
+			taskdir_path = NULL;
+		} else
+#endif
+		{
+			pid = fork();
+			if (pid > 0) {
 #if defined(PBS_SECURITY) && (PBS_SECURITY == KRB5)
-			delete_cred(pjob->ji_qs.ji_jobid);
+				delete_cred(pjob->ji_qs.ji_jobid);
 #endif
-			/* parent mom */
-			job_free(pjob);
-			free(taskdir_path);
-			return;
+				/* parent mom */
+				job_free(pjob);
+				free(taskdir_path);
+				return;
+			}
+			if (!pid)
+				child_process = 1;
 		}
-		if (!pid)
-			child_process = 1;
 	}
 	/* Parent Mom process will continue the job cleanup itself, if call to fork is failed */
 	/* delete script file */
@@ -1186,6 +1251,7 @@ job_purge(job *pjob)
 #ifdef PBS_MOM
 	/* delete job file */
 	del_job_related_file(pjob, JOB_FILE_SUFFIX);
+	job_journal_purge(pjob);
 
 #if defined(PBS_SECURITY) && (PBS_SECURITY == KRB5)
 	delete_cred(pjob->ji_qs.ji_jobid);
@@ -1193,13 +1259,7 @@ job_purge(job *pjob)
 
 #else
 	/* delete job and dependants from database */
-	obj.pbs_db_obj_type = PBS_DB_JOB;
-	obj.pbs_db_un.pbs_db_job = &dbjob;
-	strcpy(dbjob.ji_jobid, pjob->ji_qs.ji_jobid);
-	if (pbs_db_delete_obj(conn, &obj) == -1) {
-		log_joberr(-1, __func__, msg_err_purgejob_db,
-			   pjob->ji_qs.ji_jobid);
-	}
+	job_delete_db(pjob);
 
 	if (pjob->ji_qs.ji_svrflags & JOB_SVFLG_HasNodes)
 		free_nodes(pjob);
@@ -64,10 +64,12 @@
 #include <memory.h>
 #include "libutil.h"
 #include "pbs_db.h"
+#include "pbs_usdt.h"
 
 #define MAX_SAVE_TRIES 3
 
 extern void *svr_db_conn;
+extern pbs_list_head svr_dbsave_jobs;
 extern int server_init_type;
 extern pbs_list_head svr_allresvs;
 #define BACKTRACE_BUF_SIZE 50
@@ -76,6 +78,11 @@ void print_backtrace(char *);
 /* global data items */
 extern time_t time_now;
 
+/* ids of purged jobs whose database delete is deferred */
+static char **dbdel_jobs = NULL;
+static int dbdel_jobs_ct = 0;
+static int dbdel_jobs_sz = 0;
+
 job *recov_job_cb(pbs_db_obj_info_t *dbobj, int *refreshed);
 resc_resv *recov_resv_cb(pbs_db_obj_info_t *dbobj, int *refreshed);
 
@@ -84,7 +91,7 @@ resc_resv *recov_resv_cb(pbs_db_obj_info_t *dbobj, int *refreshed);
  *		convert job structure to DB format
  *
  * @see
- * 		job_save_db
+ * 		job_save_db_now
  *
  * @param[in]	pjob - Address of the job in the server
  * @param[out]	dbjob - Address of the database job object
@@ -97,12 +104,33 @@ job_to_db(job *pjob, pbs_db_job_info_t *dbjob)
 {
 	int savetype = 0;
 	int save_all_attrs = 0;
+	int i;
 
 	strcpy(dbjob->ji_jobid, pjob->ji_qs.ji_jobid);
 
 	if (check_job_state(pjob, JOB_STATE_LTR_FINISHED))
 		save_all_attrs = 1;
 
+	/*
+	 * Name every attribute changed since the last save, set or not, so the
+	 * update drops its old keys before writing what is left of it.  The
+	 * unknown attribute's entries carry their own names and just overwrite.
+	 */
+	CLEAR_HEAD(dbjob->db_attr_dirty_list.attrs);
+	dbjob->db_attr_dirty_list.attr_count = 0;
+	for (i = 0; !pjob->newobj && i < JOB_ATR_LAST; i++) {
+		svrattrl *pal;
+
+		if (i == JOB_ATR_UNKN || !(get_jattr(pjob, i)->at_flags & ATR_VFLAG_MODIFY))
+			continue;
+		if ((job_attr_def[i].at_flags & ATR_DFLAG_NOSAVM) && !save_all_attrs)
+			continue;
+		if ((pal = make_attr(job_attr_def[i].at_name, NULL, NULL, 0)) == NULL)
+			return -1;
+		append_link(&dbjob->db_attr_dirty_list.attrs, &pal->al_link, pal);
+		dbjob->db_attr_dirty_list.attr_count++;
+	}
+
 	if ((encode_attr_db(job_attr_def, pjob->ji_wattr, JOB_ATR_LAST, &dbjob->db_attr_list, save_all_attrs)) != 0)
 		return -1;
 
@@ -216,7 +244,7 @@ db_to_job(job *pjob, pbs_db_job_info_t *dbjob)
 
 /**
  * @brief
- *		Save job to database
+ *		Write a job to the database now
  *
  * @param[in]	pjob - The job to save
  *
@@ -226,8 +254,8 @@ db_to_job(job *pjob, pbs_db_job_info_t *dbjob)
  * @retval	 1 - Jobid clash, retry with new jobid
  *
  */
-int
-job_save_db(job *pjob)
+static int
+job_save_db_now(job *pjob)
 {
 	pbs_db_job_info_t dbjob = {{0}};
 	pbs_db_obj_info_t obj;
@@ -237,6 +265,8 @@ job_save_db(job *pjob)
 	int old_mtime, old_flags;
 	char *conn_db_err = NULL;
 
+	PBS_PROBE1(job__save__start, pjob->ji_qs.ji_jobid);
+
 	old_mtime = get_jattr_long(pjob, JOB_ATR_mtime);
 	old_flags = (get_jattr(pjob, JOB_ATR_mtime))->at_flags;
 
@@ -253,6 +283,7 @@ job_save_db(job *pjob)
 
 done:
 	free_db_attr_list(&dbjob.db_attr_list);
+	free_db_attr_list(&dbjob.db_attr_dirty_list);
 
 	if (rc != 0) {
 		/* revert mtime, flags update */
@@ -271,9 +302,157 @@ done:
 			panic_stop_db();
 	}
 
+	PBS_PROBE2(job__save__done, pjob->ji_qs.ji_jobid, rc);
 	return (rc);
 }
 
+/**
+ * @brief
+ *		Delete a job and its dependants from the database
+ *
+ * @param[in]	jobid - id of the job to delete
+ *
+ * @return	void
+ */
+static void
+job_delete_db_now(char *jobid)
+{
+	pbs_db_obj_info_t obj;
+	pbs_db_job_info_t dbjob;
+	extern char *msg_err_purgejob_db;
+
+	obj.pbs_db_obj_type = PBS_DB_JOB;
+	obj.pbs_db_un.pbs_db_job = &dbjob;
+	pbs_strncpy(dbjob.ji_jobid, jobid, sizeof(dbjob.ji_jobid));
+	if (pbs_db_delete_obj(svr_db_conn, &obj) == -1)
+		log_joberr(-1, __func__, msg_err_purgejob_db, jobid);
+}
+
+/**
+ * @brief
+ *		Delete a purged job from the database
+ *
+ * @par
+ *		Like other job saves, the delete is deferred to
+ *		job_save_db_flush() so that purging many jobs at once, e.g.
+ *		for a qdel of a large list, commits in a single transaction.
+ *
+ * @param[in]	pjob - The job being purged
+ *
+ * @return	void
+ */
+void
+job_delete_db(job *pjob)
+{
+	char **tmp;
+
+	if (dbdel_jobs_ct == dbdel_jobs_sz) {
+		int newsz = dbdel_jobs_sz ? (dbdel_jobs_sz * 2) : 64;
+
+		tmp = realloc(dbdel_jobs, newsz * sizeof(char *));
+		if (tmp == NULL) {
+			job_delete_db_now(pjob->ji_qs.ji_jobid);
+			return;
+		}
+		dbdel_jobs = tmp;
+		dbdel_jobs_sz = newsz;
+	}
+	if ((dbdel_jobs[dbdel_jobs_ct] = strdup(pjob->ji_qs.ji_jobid)) == NULL) {
+		job_delete_db_now(pjob->ji_qs.ji_jobid);
+		return;
+	}
+	dbdel_jobs_ct++;
+}
+
+/**
+ * @brief
+ *		Save job to database
+ *
+ * @par
+ *		A new job is written immediately, so a jobid clash is reported
+ *		before qsub is acknowledged.  Other saves are deferred to
+ *		job_save_db_flush(), which the main loop calls before it waits
+ *		for the next request, so that several saves of the same job
+ *		coalesce into one and all of them are committed in a single
+ *		transaction.
+ *
+ * @param[in]	pjob - The job to save
+ *
+ * @return      Error code
+ * @retval	 0 - Success
+ * @retval	-1 - Failure
+ * @retval	 1 - Jobid clash, retry with new jobid
+ *
+ */
+int
+job_save_db(job *pjob)
+{
+	if (pjob->newobj) {
+		/* make sure a purged job of the same id is gone first */
+		if (dbdel_jobs_ct > 0)
+			job_save_db_flush();
+		return job_save_db_now(pjob);
+	}
+
+	if (pjob->ji_dbsavelink.ll_next == &pjob->ji_dbsavelink)
+		append_link(&svr_dbsave_jobs, &pjob->ji_dbsavelink, pjob);
+
+	return 0;
+}
+
+/**
+ * @brief
+ *		Write all deferred job saves and deletes to the database in one
+ *		transaction
+ *
+ * @par
+ *		Also called wherever a job leaves the server's control, e.g.
+ *		before it is sent to a MoM or another server, so the database
+ *		is never behind what the other side has been told.
+ *
+ * @return	void
+ */
+void
+job_save_db_flush(void)
+{
+	job *pjob;
+	int trx;
+	int pipe;
+	int i;
+
+	if ((GET_NEXT(svr_dbsave_jobs) == NULL) && (dbdel_jobs_ct == 0))
+		return;
+
+	trx = (pbs_db_begin_trx(svr_db_conn) == 0);
+	/* send all the statements in one go rather than one round trip each */
+	pipe = trx && (pbs_db_begin_pipeline(svr_db_conn) == 0);
+	for (i = 0; i < dbdel_jobs_ct; i++) {
+		job_delete_db_now(dbdel_jobs[i]);
+		free(dbdel_jobs[i]);
+	}
+	dbdel_jobs_ct = 0;
+	while ((pjob = (job *) GET_NEXT(svr_dbsave_jobs)) != NULL) {
+		delete_link(&pjob->ji_dbsavelink);
+		job_save_db_now(pjob);
+	}
+	if (pipe && pbs_db_end_pipeline(svr_db_conn) != 0) {
+		char *conn_db_err = NULL;
+
+		pbs_db_get_errmsg(PBS_DB_ERR, &conn_db_err);
+		log_errf(PBSE_INTERNAL, __func__, "Failed to save jobs %s", conn_db_err ? conn_db_err : "");
+		free(conn_db_err);
+		panic_stop_db();
+	}
+	if (trx && pbs_db_end_trx(svr_db_conn, PBS_DB_COMMIT) != 0) {
+		char *conn_db_err = NULL;
+
+		pbs_db_get_errmsg(PBS_DB_ERR, &conn_db_err);
+		log_errf(PBSE_INTERNAL, __func__, "Failed to commit job saves %s", conn_db_err ? conn_db_err : "");
+		free(conn_db_err);
+		panic_stop_db();
+	}
+}
+
 /**
  * @brief
  *	Utility function called inside job_recov_db
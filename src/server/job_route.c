@@ -330,6 +330,14 @@ job_route(job *jobp)
  *
  *		look for any job in the queue whose route retry time has
  *		passed.
+ *
+ *		A pass that routes nothing remembers when the next job's retry
+ *		time or route lifetime comes up in qu_route_next, and the queue
+ *		is not walked again before then.  Jobs which wait on a state
+ *		change (held, waiting, max_running reached, queue stopped) are
+ *		picked up again when a job of the queue changes state, a job is
+ *		enqueued or the queue's attributes change, all of which reset
+ *		qu_route_next.
 
  *		If the queue is "started" and if the number of jobs in the
  *		Transiting state is less than the max_running limit, then
@@ -349,16 +357,52 @@ queue_route(pbs_queue *pque)
 	job *nxjb;
 	job *pjob;
 	int rc;
+	time_t next = 0;
+	long life = 0;
+
+	if (pque->qu_route_next > time_now)
+		return; /* nothing can have changed */
+
+	/* a site router may have reasons of its own to route a job */
+	if (get_qattr_long(pque, QR_ATR_AltRouter) == 0 && is_qattr_set(pque, QR_ATR_RouteLifeTime))
+		life = get_qattr_long(pque, QR_ATR_RouteLifeTime);
 
 	pjob = (job *) GET_NEXT(pque->qu_jobs);
 	while (pjob) {
+		time_t retry;
+
 		nxjb = (job *) GET_NEXT(pjob->ji_jobque);
 		if (pjob->ji_qs.ji_un.ji_routet.ji_rteretry <= time_now) {
-			if ((rc = job_route(pjob)) == PBSE_ROUTEREJ)
+			if ((rc = job_route(pjob)) == PBSE_ROUTEREJ) {
 				job_abt(pjob, msg_routebad);
-			else if (rc == PBSE_ROUTEEXPD)
+				pjob = nxjb;
+				continue;
+			} else if (rc == PBSE_ROUTEEXPD) {
 				job_abt(pjob, msg_routexceed);
+				pjob = nxjb;
+				continue;
+			}
+			if (pjob->ji_qhdr != pque || check_job_state(pjob, JOB_STATE_LTR_TRANSIT)) {
+				next = time_now; /* something moved, look again */
+				pjob = nxjb;
+				continue;
+			}
 		}
+
+		/* when could this job be routed next */
+		retry = pjob->ji_qs.ji_un.ji_routet.ji_rteretry;
+		if (retry > time_now && (next == 0 || retry < next))
+			next = retry;
+		if (life && (next == 0 || pjob->ji_qs.ji_un.ji_routet.ji_quetime + life < next))
+			next = pjob->ji_qs.ji_un.ji_routet.ji_quetime + life;
 		pjob = nxjb;
 	}
+
+	if (get_qattr_long(pque, QR_ATR_AltRouter) != 0)
+		next = 0;
+	else if (next == 0)
+		next = time_now + PBS_NET_RETRY_TIME; /* every job waits on a state change */
+	else if (next <= time_now)
+		next = 0;
+	pque->qu_route_next = next;
 }
@@ -106,6 +106,8 @@ extern int check_sign(pbsnode *, attribute *);
 extern void license_one_node(pbsnode *);
 extern int process_topology_info(void **, char *);
 extern void release_lic_for_cray(struct pbsnode *);
+extern void svrcached(attribute *, pbs_list_head *, attribute_def *);
+extern int resc_access_perm;
 static void remove_node_topology(char *);
 
 /**
@@ -163,6 +165,40 @@ find_nodebyaddr(pbs_net_t addr)
 	return NULL;
 }
 
+/**
+ * @brief
+ * 		add the status of a single node-attribute to the status reply.
+ *		The jobs and reservations on a node are built from the node
+ *		itself rather than the attribute value, so they are encoded on
+ *		every request; all other node-attributes use the encoded value
+ *		cached on the attribute.
+ *
+ * @param[in]	pnode	-	node being statused
+ * @param[in]	index	-	index of the node-attribute
+ * @param[in]	phead	-	list to append the encoded svrattrl to
+ *
+ * @return	int
+ * @retval	0	- success
+ * @retval	!= 0	- PBSE error code
+ */
+
+static int
+status_one_nodeattrib(struct pbsnode *pnode, int index, pbs_list_head *phead)
+{
+	attribute_def *pdef = node_attr_def + index;
+	int rc;
+
+	if (pdef->at_encode == encode_jobs || pdef->at_encode == encode_resvs) {
+		rc = pdef->at_encode(get_nattr(pnode, index), phead, pdef->at_name, NULL, ATR_ENCODE_CLIENT, NULL);
+		if (rc < 0)
+			return -rc;
+		return 0;
+	}
+
+	svrcached(get_nattr(pnode, index), phead, pdef);
+	return 0;
+}
+
 /**
  * @brief
  * 	 	add status of each requested (or all) node-attribute to the status reply.
@@ -193,6 +229,7 @@ status_nodeattrib(svrattrl *pal, struct pbsnode *pnode, int limit, int priv, pbs
 	attribute_def *padef = node_attr_def;
 
 	priv &= ATR_DFLAG_RDACC; /* user-client privilege      */
+	resc_access_perm = priv; /* pass privilege to encode_resc() */
 
 	if (pal) { /*caller has requested status on specific node-attributes*/
 		nth = 0;
@@ -205,12 +242,9 @@ status_nodeattrib(svrattrl *pal, struct pbsnode *pnode, int limit, int priv, pbs
 				break;
 			}
 			if ((padef + index)->at_flags & priv) {
-				rc = (padef + index)->at_encode(get_nattr(pnode, index), phead, (padef + index)->at_name, NULL, ATR_ENCODE_CLIENT, NULL);
-				if (rc < 0) {
-					rc = -rc;
+				rc = status_one_nodeattrib(pnode, index, phead);
+				if (rc != 0)
 					break;
-				}
-				rc = 0;
 			}
 			pal = (svrattrl *) GET_NEXT(pal->al_link);
 		}
@@ -222,12 +256,9 @@ status_nodeattrib(svrattrl *pal, struct pbsnode *pnode, int limit, int priv, pbs
 		 */
 		for (index = 0; index < limit; index++) {
 			if ((padef + index)->at_flags & priv) {
-				rc = (padef + index)->at_encode(get_nattr(pnode, index), phead, (padef + index)->at_name, NULL, ATR_ENCODE_CLIENT, NULL);
-				if (rc < 0) {
-					rc = -rc;
+				rc = status_one_nodeattrib(pnode, index, phead);
+				if (rc != 0)
 					break;
-				}
-				rc = 0;
 			}
 		}
 	}
@@ -291,6 +322,7 @@ initialize_pbsnode(struct pbsnode *pnode, char *pname, int ntype)
 	pnode->nd_svrflags = 0;
 	pnode->nd_ncpus = 1;
 	pnode->nd_psn = NULL;
+	pnode->nd_psn_next = NULL;
 	pnode->nd_hostname = NULL;
 	pnode->nd_state = INUSE_UNKNOWN | INUSE_DOWN;
 	pnode->nd_resvp = NULL;
@@ -588,21 +620,24 @@ effective_node_delete(struct pbsnode *pnode)
 
 /**
  * @brief
- *	setup_notification -  Sets up the  mechanism for notifying
- *	other members of the server's node pool that a new node was added
- *	manually via qmgr.
- *	The IS_CLUSTER_ADDRS message is only sent to the existing Moms.
- * @see
- * 		mgr_node_create
+ *	notify_cluster_addrs - work task which marks every node as needing
+ *	the cluster address list and then sends IS_CLUSTER_ADDRS.
+ *
+ * @par
+ *	The marking is done here, once per batch of node creations, rather
+ *	than in setup_notification for each node created.  Creating many
+ *	nodes back to back through qmgr thus walks the node list once
+ *	instead of once per node.
+ *
+ * @param[in]	ptask	- work task, wt_aux holds the message to send
  *
  * @return	void
  */
-void
-setup_notification()
+static void
+notify_cluster_addrs(struct work_task *ptask)
 {
 	int i;
 	int nmom;
-	static time_t addr_send_tm = 0;
 
 	for (i = 0; i < svr_totnodes; i++) {
 		if (pbsndlist[i]->nd_state & INUSE_DELETED)
@@ -615,10 +650,31 @@ setup_notification()
 		}
 	}
 
+	mcast_msg(ptask);
+}
+
+/**
+ * @brief
+ *	setup_notification -  Sets up the  mechanism for notifying
+ *	other members of the server's node pool that a new node was added
+ *	manually via qmgr.
+ *	The IS_CLUSTER_ADDRS message is only sent to the existing Moms.
+ *	Nodes created within MCAST_WAIT_TM of each other share a single
+ *	notification.
+ * @see
+ * 		mgr_node_create
+ *
+ * @return	void
+ */
+void
+setup_notification()
+{
+	static time_t addr_send_tm = 0;
+
 	/* send IS_CLUSTERADDR2 to happen in next 2 seconds */
 	if (addr_send_tm <= time_now) {
 		addr_send_tm = time_now + MCAST_WAIT_TM;
-		struct work_task *ptask = set_task(WORK_Timed, addr_send_tm, mcast_msg, NULL);
+		struct work_task *ptask = set_task(WORK_Timed, addr_send_tm, notify_cluster_addrs, NULL);
 		ptask->wt_aux = IS_CLUSTER_ADDRS;
 	}
 }
@@ -794,6 +850,7 @@ save_nodes_db(int changemodtime, void *p)
 	resource_def *rscdef;
 	int i;
 	mominfo_t *pmom = (mominfo_t *) p;
+	mom_svrinfo_t *psvrm = pmom ? (mom_svrinfo_t *) pmom->mi_data : NULL;
 	char *conn_db_err = NULL;
 
 	DBPRT(("%s: entered\n", __func__))
@@ -836,7 +893,8 @@ save_nodes_db(int changemodtime, void *p)
 	/*
 	 * Clear the ATR_VFLAG_MODIFY bit on each node attribute
 	 * and on the node_group_key resource, for those nodes
-	 * that possess a node_group_key resource
+	 * that possess a node_group_key resource.  When only one
+	 * Mom was saved, only her vnodes are visited.
 	 */
 
 	if (is_sattr_set(SVR_ATR_NodeGroupKey))
@@ -849,9 +907,9 @@ save_nodes_db(int changemodtime, void *p)
 	else
 		rscdef = NULL;
 
-	for (i = 0; i < svr_totnodes; i++) {
-		np = pbsndlist[i];
-		if (np->nd_state & INUSE_DELETED)
+	for (i = 0; i < (pmom ? psvrm->msr_numvnds : svr_totnodes); i++) {
+		np = pmom ? psvrm->msr_children[i] : pbsndlist[i];
+		if (np == NULL || (np->nd_state & INUSE_DELETED))
 			continue;
 
 		for (num = 0; num < ND_ATR_LAST; num++) {
@@ -1017,6 +1075,7 @@ delete_a_subnode(struct pbsnode *pnode)
 	struct pbssubn *pprior = 0;
 
 	psubn = pnode->nd_psn;
+	pnode->nd_psn_next = NULL;
 
 	while (psubn->next) {
 		pprior = psubn;
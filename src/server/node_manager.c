@@ -91,6 +91,7 @@
 #include "provision.h"
 #include "pbs_sched.h"
 #include "svrfunc.h"
+#include "pbs_metrics.h"
 
 #if !defined(H_ERRNO_DECLARED)
 extern int h_errno;
@@ -151,6 +152,7 @@ extern void propagate_licenses_to_vnodes(mominfo_t *pmom);
 #define STR_TIME_SZ 20
 
 #define MAX_NODE_WAIT 600
+#define NODE_DOWN_REQUEUE_SLICE 1 /* secs of node_down_requeue() work per pass */
 
 /*
  * Tree search generalized from Knuth (6.2.2) Algorithm T just like
@@ -659,6 +661,17 @@ node_down_requeue(struct work_task *pwt)
 	if ((mp->mi_dmn_info->dmn_state & INUSE_DOWN) == 0)
 		return;
 
+	/*
+	 * When many Moms go down together, all their requeue tasks come due
+	 * in the same pass.  Once this pass has run long enough, push the
+	 * rest behind the pending requests instead of handling them all now.
+	 */
+	if ((time(NULL) - time_now) >= NODE_DOWN_REQUEUE_SLICE) {
+		svmp->msr_wktask = set_task(WORK_Interleave, 0, node_down_requeue, (void *) mp);
+		if (svmp->msr_wktask != NULL)
+			return;
+	}
+
 	DBPRT(("node_down_requeue node still down\n"))
 
 	for (nchild = 0; nchild < svmp->msr_numvnds; ++nchild) {
@@ -671,12 +684,14 @@ node_down_requeue(struct work_task *pwt)
 				for (pjinfo = psn->jobs; pjinfo; pjinfo = pjinfo_nxt) {
 					pj = find_job(pjinfo->jobid);
 					pjinfo_nxt = pjinfo->next;
-					while (pjinfo_nxt && !strcmp(pjinfo_nxt->jobid, pj->ji_qs.ji_jobid)) {
+					while (pjinfo_nxt && !strcmp(pjinfo_nxt->jobid, pjinfo->jobid)) {
 						/* skip over next occurrence of same job in list*/
 						/* if it is deleted in discard_job(), we would	*/
 						/* have a pointer to nothingness		*/
 						pjinfo_nxt = pjinfo_nxt->next;
 					}
+					if (pj == NULL)
+						continue;
 
 					nname = parse_servername(
 						get_jattr_str(pj, JOB_ATR_exec_vnode), NULL);
@@ -1138,6 +1153,7 @@ shallow_vnode_dup(struct pbsnode *vnode)
 	vnode_dup->nd_arr_index = vnode->nd_arr_index;
 	vnode_dup->nd_hostname = vnode->nd_hostname;
 	vnode_dup->nd_psn = vnode->nd_psn;
+	vnode_dup->nd_psn_next = vnode->nd_psn_next;
 	vnode_dup->nd_resvp = vnode->nd_resvp;
 	vnode_dup->nd_nsn = vnode->nd_nsn;
 	vnode_dup->nd_nsnfree = vnode->nd_nsnfree;
@@ -1248,6 +1264,8 @@ set_vnode_state(struct pbsnode *pnode, unsigned long state_bits, enum vnode_stat
 		   	"state_bits=0x%lx state_bit_op_type_str=%s state_bit_op_type_enum=%d",
 		   	pnode->nd_state, vnode_o->nd_state, time_int_val, last_time_int,
 		   	state_bits, get_vnode_state_op(type), type);
+
+		subscribe_notify_node(pnode);
 	}
 
 	if (pnode->nd_state & INUSE_PROV) {
@@ -2093,6 +2111,44 @@ decode_stat_update(int stream, ruu *prused)
 	return rc;
 }
 
+/**
+ * @brief
+ *		Compute a digest (FNV-1a) of the attribute list of a status
+ *		update from Mom, used by stat_update() to recognize an update
+ *		identical to the last one it applied to the job.
+ *
+ * @param[in] plist - first entry of the update's attribute list
+ * @param[in] hop - run version the update is for
+ *
+ * @return	unsigned long
+ * @retval	the digest, never 0 so that 0 can mean "nothing applied yet"
+ */
+static unsigned long
+stat_update_digest(svrattrl *plist, int hop)
+{
+	unsigned long h = 2166136261UL;
+	const char *strs[3];
+	const unsigned char *p;
+	int i;
+
+	for (; plist != NULL; plist = (svrattrl *) GET_NEXT(plist->al_link)) {
+		strs[0] = plist->al_name;
+		strs[1] = plist->al_resc;
+		strs[2] = plist->al_value;
+		for (i = 0; i < 3; i++) {
+			if (strs[i] != NULL) {
+				for (p = (const unsigned char *) strs[i]; *p; p++)
+					h = (h ^ *p) * 16777619UL;
+			}
+			h = (h ^ 0xff) * 16777619UL; /* field separator */
+		}
+		h = (h ^ (unsigned char) plist->al_op) * 16777619UL;
+	}
+	h = (h ^ (unsigned long) hop) * 16777619UL;
+
+	return (h ? h : 1);
+}
+
 /**
  * @brief
  *		Update job resource usage based on information sent from Mom.
@@ -2121,6 +2177,8 @@ stat_update(int stream)
 	ruu rused = {0};
 	svrattrl *sattrl;
 	mominfo_t *mp;
+	unsigned long digest;
+	int seq;
 
 	njobs = disrui(stream, &rc); /* number of jobs in update */
 	if (rc)
@@ -2233,9 +2291,36 @@ stat_update(int stream)
 			}
 			if (is_jattr_set(pjob, JOB_ATR_session_id))
 				old_sid = get_jattr_long(pjob, JOB_ATR_session_id);
-			/* update all the attributes sent from Mom */
+
+			/*
+			 * Moms send only the resources that changed, see RUU_SEQ_FULL;
+			 * set_resc() leaves the others as they are.  A gap in the
+			 * sequence is repaired by the next full update.
+			 */
+			seq = rused.ru_status & RUU_SEQ_MASK;
+			if (seq != 0) {
+				if (!(rused.ru_status & RUU_SEQ_FULL) && (pjob->ji_ruu_seq != 0) &&
+				    (seq != (pjob->ji_ruu_seq % RUU_SEQ_MASK) + 1))
+					log_eventf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB, LOG_DEBUG, pjob->ji_qs.ji_jobid,
+						   "update %d from Mom does not follow %d", seq, pjob->ji_ruu_seq);
+				pjob->ji_ruu_seq = seq;
+			}
+
+			/*
+			 * Moms resend the same values every job_update_period while
+			 * nothing changes.  Don't decode, apply and save them again.
+			 */
 			sattrl = (svrattrl *) GET_NEXT(rused.ru_attr);
+			digest = stat_update_digest(sattrl, rused.ru_hop);
+			if ((sattrl != NULL) && (digest == pjob->ji_stat_digest) && is_jattr_set(pjob, JOB_ATR_session_id)) {
+				log_event(PBSEVENT_DEBUG4, PBS_EVENTCLASS_JOB, LOG_DEBUG, pjob->ji_qs.ji_jobid,
+					  "update from Mom unchanged, skipped");
+				goto next_update;
+			}
+
+			/* update all the attributes sent from Mom */
 			if (sattrl != NULL) {
+				pjob->ji_stat_digest = digest;
 				if (modify_job_attr(pjob, sattrl,
 						    ATR_DFLAG_MGWR | ATR_DFLAG_SvWR, &bad) != 0) {
 					if ((mp = tfind2((u_long) stream, 0, &streams)) != NULL) {
@@ -2245,6 +2330,7 @@ stat_update(int stream)
 						log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_NODE,
 							  LOG_NOTICE, mp->mi_host, log_buffer);
 					}
+					pjob->ji_stat_digest = 0; /* apply it again next time */
 				}
 			}
 
@@ -2290,6 +2376,7 @@ stat_update(int stream)
 				job_save_db(pjob);
 			}
 		}
+	next_update:
 		(void) free(rused.ru_comment);
 		rused.ru_comment = NULL;
 		(void) free(rused.ru_pjobid);
@@ -2731,6 +2818,7 @@ deallocate_job_from_node(char *jobid, struct pbsnode *pnode)
 		}
 		if (np->jobs == NULL) {
 			np->inuse &= ~(INUSE_JOB | INUSE_JOBEXCL);
+			pnode->nd_psn_next = NULL;
 		}
 	}
 	if (still_has_jobs) {
@@ -2781,6 +2869,8 @@ delete_from_exec_vnode(char *execvnode, char *vnodelist, char *err_msg,
 {
 	char *exec_vnode = NULL;
 	char *new_exec_vnode = NULL;
+	char *nev_end = NULL;
+	void *del_idx = NULL;
 	char *chunk = NULL;
 	char *last = NULL;
 	int hasprn = 0;
@@ -2812,6 +2902,16 @@ delete_from_exec_vnode(char *execvnode, char *vnodelist, char *err_msg,
 	}
 
 	new_exec_vnode[0] = '\0';
+	nev_end = new_exec_vnode;
+
+	if (vnodelist != NULL) {
+		del_idx = string_list_idx_create(vnodelist, '+');
+		if (del_idx == NULL) {
+			snprintf(err_msg, err_msg_sz, "vnodelist index error");
+			goto delete_from_exec_vnode_exit;
+		}
+	}
+
 	entry = 0; /* exec_vnode entries */
 	paren = 0;
 	for (chunk = parse_plus_spec_r(exec_vnode, &last, &hasprn);
@@ -2820,39 +2920,39 @@ delete_from_exec_vnode(char *execvnode, char *vnodelist, char *err_msg,
 		paren += hasprn;
 		if (parse_node_resc(chunk, &noden, &nelem, &pkvp) == 0) {
 			if ((vnodelist != NULL) &&
-			    !in_string_list(noden, '+', vnodelist)) {
+			    !in_string_list_idx(noden, del_idx)) {
 
 				/* there's something put in previously */
 				if (entry > 0) {
-					strcat(new_exec_vnode, "+");
+					nev_end = pbs_strcpy(nev_end, "+");
 				}
 
 				if (((hasprn > 0) && (paren > 0)) ||
 				    ((hasprn == 0) && (paren == 0))) {
 					/* at the beginning of chunk for current host */
 					if (!parend) {
-						strcat(new_exec_vnode, "(");
+						nev_end = pbs_strcpy(nev_end, "(");
 						parend = 1;
 					}
 				}
 				if (!parend) {
-					strcat(new_exec_vnode, "(");
+					nev_end = pbs_strcpy(nev_end, "(");
 					parend = 1;
 				}
-				strcat(new_exec_vnode, noden);
+				nev_end = pbs_strcpy(nev_end, noden);
 				entry++;
 
 				for (j = 0; j < nelem; ++j) {
 					snprintf(buf, sizeof(buf), ":%s=%s",
 						 pkvp[j].kv_keyw, pkvp[j].kv_val);
-					strcat(new_exec_vnode, buf);
+					nev_end = pbs_strcpy(nev_end, buf);
 				}
 
 				/* have all chunks for current host */
 				if (paren == 0) {
 
 					if (parend) {
-						strcat(new_exec_vnode, ")");
+						nev_end = pbs_strcpy(nev_end, ")");
 						parend = 0;
 					}
 				}
@@ -2862,7 +2962,7 @@ delete_from_exec_vnode(char *execvnode, char *vnodelist, char *err_msg,
 					/* matched ')' in chunk, so need to */
 					/* balance the parenthesis */
 					if (parend) {
-						strcat(new_exec_vnode, ")");
+						nev_end = pbs_strcpy(nev_end, ")");
 						parend = 0;
 					}
 				}
@@ -2878,10 +2978,14 @@ delete_from_exec_vnode(char *execvnode, char *vnodelist, char *err_msg,
 	if ((entry >= 0) && (new_exec_vnode[entry] == '+'))
 		new_exec_vnode[entry] = '\0';
 
+	if (del_idx != NULL)
+		pbs_idx_destroy(del_idx);
 	free(exec_vnode);
 	return (new_exec_vnode);
 
 delete_from_exec_vnode_exit:
+	if (del_idx != NULL)
+		pbs_idx_destroy(del_idx);
 	free(exec_vnode);
 	free(new_exec_vnode);
 	return NULL;
@@ -3377,59 +3481,58 @@ cross_link_mom_vnode(struct pbsnode *pnode, mominfo_t *pmom)
 			break;
 	}
 
-	if (i == pnode->nd_nummoms) {
-		/* need to add this parent Mom in the node's array */
-		if (pnode->nd_nummoms == pnode->nd_nummslots) {
+	/*
+	 * The Mom -> node and node -> Mom links are always added and removed
+	 * together, so whether the node lists this Mom also tells whether the
+	 * Mom lists the node.  Not scanning the Mom's children keeps an
+	 * UPDATE2 from a Mom with thousands of vnodes linear.
+	 */
+	if (i < pnode->nd_nummoms)
+		return 0;
 
-			/* need to expand the array to make room */
-			mominfo_t **tmpim;
+	/* need to add this parent Mom in the node's array */
+	if (pnode->nd_nummoms == pnode->nd_nummslots) {
 
-			n = pnode->nd_nummslots;
-			if (n == 0)
-				n = 1;
-			else
-				n *= 2;
-			tmpim = (mominfo_t **) realloc(pnode->nd_moms,
-						       n * sizeof(mominfo_t *));
-			if (tmpim == NULL)
-				return (PBSE_SYSTEM);
-			pnode->nd_moms = tmpim;
-			pnode->nd_nummslots = n;
-		}
-		pnode->nd_moms[pnode->nd_nummoms++] = pmom;
+		/* need to expand the array to make room */
+		mominfo_t **tmpim;
 
-		/* also add Mom's name to this vnode's Mom attribute */
-		set_nattr_generic(pnode, ND_ATR_Mom, pmom->mi_host, NULL, INCR);
+		n = pnode->nd_nummslots;
+		if (n == 0)
+			n = 1;
+		else
+			n *= 2;
+		tmpim = (mominfo_t **) realloc(pnode->nd_moms,
+					       n * sizeof(mominfo_t *));
+		if (tmpim == NULL)
+			return (PBSE_SYSTEM);
+		pnode->nd_moms = tmpim;
+		pnode->nd_nummslots = n;
 	}
+	pnode->nd_moms[pnode->nd_nummoms++] = pmom;
+
+	/* also add Mom's name to this vnode's Mom attribute */
+	set_nattr_generic(pnode, ND_ATR_Mom, pmom->mi_host, NULL, INCR);
 
 	/* Now set reverse linkage Mom -> node */
 
 	prmomsvr = pmom->mi_data;
-	for (i = 0; i < prmomsvr->msr_numvnds; ++i) {
-		if (prmomsvr->msr_children[i] == pnode)
-			break;
-	}
-	if (i == prmomsvr->msr_numvnds) {
+	if (prmomsvr->msr_numvnds == prmomsvr->msr_numvslots) {
+		/* need to expand the array (double it) */
+		struct pbsnode **tmpn;
 
-		/* need to add this node to array of Mom's children */
-		if (prmomsvr->msr_numvnds == prmomsvr->msr_numvslots) {
-			/* need to expand the array (double it) */
-			struct pbsnode **tmpn;
-
-			n = prmomsvr->msr_numvslots;
-			if (n == 0)
-				n = 1;
-			else
-				n *= 2;
-			tmpn = (struct pbsnode **) realloc(prmomsvr->msr_children,
-							   n * sizeof(struct pbsnode *));
-			if (tmpn == NULL)
-				return (PBSE_SYSTEM);
-			prmomsvr->msr_children = tmpn;
-			prmomsvr->msr_numvslots = n;
-		}
-		prmomsvr->msr_children[prmomsvr->msr_numvnds++] = pnode;
+		n = prmomsvr->msr_numvslots;
+		if (n == 0)
+			n = 1;
+		else
+			n *= 2;
+		tmpn = (struct pbsnode **) realloc(prmomsvr->msr_children,
+						   n * sizeof(struct pbsnode *));
+		if (tmpn == NULL)
+			return (PBSE_SYSTEM);
+		prmomsvr->msr_children = tmpn;
+		prmomsvr->msr_numvslots = n;
 	}
+	prmomsvr->msr_children[prmomsvr->msr_numvnds++] = pnode;
 	return 0;
 }
 
@@ -3766,6 +3869,7 @@ update2_to_vnode(vnal_t *pvnal, int new, mominfo_t *pmom, int *madenew, int from
 								prs->rs_defin->rs_free(&prs->rs_value);
 								delete_link(&prs->rs_link);
 								free(prs);
+								pRA->at_flags |= ATR_MOD_MCACHE;
 							}
 						} else
 							prs->rs_value.at_flags |= ATR_VFLAG_DEFLT;
@@ -4293,11 +4397,12 @@ err:
  *
  * @param[in] stream  - TPP stream on which the request is arriving
  * @param[in] version - Version of protocol, not to be changed lightly as it makes everything incompatable.
+ * @param[out] pcommand - the IS message type, once read
  *
  * @return none
  */
-void
-is_request(int stream, int version)
+static void
+process_is_request(int stream, int version, int *pcommand)
 {
 	int check_other_moms_time = 0;
 	int command = 0;
@@ -4359,6 +4464,7 @@ is_request(int stream, int version)
 		badconstr = "disrsi:command";
 		goto badcon;
 	}
+	*pcommand = command;
 
 	if (command == IS_HELLOSVR) {
 		port = disrui(stream, &ret);
@@ -5328,6 +5434,26 @@ err:
 	return;
 }
 
+/**
+ * @brief
+ * 		Handle an Inter-Server request from a MOM, recording the time it
+ * 		took per message type in the server metrics.
+ *
+ * @param[in] stream  - TPP stream on which the request is arriving
+ * @param[in] version - Version of protocol
+ *
+ * @return none
+ */
+void
+is_request(int stream, int version)
+{
+	int command = -1;
+	unsigned long long start = pbs_metrics_now_us();
+
+	process_is_request(stream, version, &command);
+	svr_metrics_is(command, start);
+}
+
 /**
  * @brief
  * 		free list of prop structures created by proplist()
@@ -6352,10 +6478,16 @@ assign_jobs_on_subnode(struct pbsnode *pnode, int hw_ncpus, char *jobid, int svr
 			rc = PBSE_SYSTEM;
 
 	} else {
-		struct pbssubn *lst_sn;
 		int ncpus;
 
-		lst_sn = NULL;
+		/*
+		 * While recovering, jobs fill the subnodes in order, so carry on
+		 * from where the last job stopped instead of walking past every
+		 * busy subnode again for each job on the node.
+		 */
+		if ((svr_init == TRUE) && (pnode->nd_psn_next != NULL))
+			snp = pnode->nd_psn_next;
+
 		for (ncpus = 0; ncpus < hw_ncpus; ncpus++) {
 
 			while (snp->inuse != INUSE_FREE) {
@@ -6369,7 +6501,7 @@ assign_jobs_on_subnode(struct pbsnode *pnode, int hw_ncpus, char *jobid, int svr
 						* subnodes as needed to hold all of the job chunks
 						* which were allocated to the node.
 						*/
-					if ((snp = create_subnode(pnode, lst_sn)) == NULL) {
+					if ((snp = create_subnode(pnode, snp)) == NULL) {
 						return PBSE_SYSTEM;
 					}
 					break;
@@ -6383,12 +6515,8 @@ assign_jobs_on_subnode(struct pbsnode *pnode, int hw_ncpus, char *jobid, int svr
 				snp->inuse |= INUSE_JOB;
 
 			pnode->nd_nsnfree--;
-			/*
-			* Store the last subnode of parent node list.
-			* This removes the need to find the last node of
-			* parent node's list, in create_subnode().
-			*/
-			lst_sn = snp;
+			if (svr_init == TRUE)
+				pnode->nd_psn_next = snp;
 			if (pnode->nd_nsnfree < 0) {
 				log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_NODE,
 					  LOG_ALERT, pnode->nd_name,
@@ -7293,14 +7421,15 @@ check_for_negative_resource(resource_def *prdef, resource *presc, char *noden)
  * 		adjust the resources_assigned on a node.
  *
  * @par
- *		Called with the node name, the node ordinal (0 for first node),
- *		the +/- operator, the resource name, and the resource value.
+ *		Called with the node, the node ordinal flag (0 for first node),
+ *		the +/- operator, the resource definition, and the already
+ *		decoded resource value.
  *
- * @param[out]	noden	- node name
+ * @param[in]	pnode	- node to adjust
  * @param[in]	aflag	- node ordinal (0 for first node)
  * @param[in]	batch_op	- operator of type enum batch_op.
  * @param[in]	prdef	- resource structure which stores resource name
- * @param[in]	val	- resource value
+ * @param[in]	pval	- decoded resource value
  * @param[in]	hop	- always called with 0, this values checks for the level of indirectness.
  *
  * @return	int
@@ -7308,13 +7437,11 @@ check_for_negative_resource(resource_def *prdef, resource *presc, char *noden)
  * @retval	!=0	- failure code
  */
 static int
-adj_resc_on_node(char *noden, int aflag, enum batch_op op, resource_def *prdef, char *val, int hop)
+adj_resc_on_node(pbsnode *pnode, int aflag, enum batch_op op, resource_def *prdef, attribute *pval, int hop)
 {
-	pbsnode *pnode;
 	resource *presc;
 	attribute *pattr;
 	int rc;
-	attribute tmpattr;
 
 	/* make sure there isn't multiple levels of indirectness */
 	/* resource->resource->resource */
@@ -7324,7 +7451,7 @@ adj_resc_on_node(char *noden, int aflag, enum batch_op op, resource_def *prdef,
 			 "multiple level of indirectness for resource %s",
 			 prdef->rs_name);
 		log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_NODE,
-			  LOG_ALERT, noden, log_buffer);
+			  LOG_ALERT, pnode->nd_name, log_buffer);
 		return (PBSE_INDIRECTHOP);
 	}
 
@@ -7333,12 +7460,6 @@ adj_resc_on_node(char *noden, int aflag, enum batch_op op, resource_def *prdef,
 	if ((prdef->rs_flags & aflag) == 0)
 		return 0;
 
-	/* find the node */
-
-	pnode = find_nodebyname(noden);
-	if (pnode == NULL)
-		return PBSE_UNKNODE;
-
 	/* find the resources_assigned resource for the node */
 
 	pattr = get_nattr(pnode, ND_ATR_ResourceAssn);
@@ -7349,23 +7470,21 @@ adj_resc_on_node(char *noden, int aflag, enum batch_op op, resource_def *prdef,
 	}
 	if ((presc->rs_value.at_flags & ATR_VFLAG_INDIRECT) &&
 	    (*presc->rs_value.at_val.at_str == '@')) {
+		pbsnode *ptarget;
 
 		/* indirect reference to another vnode, recurse w/ that node */
 
-		noden = presc->rs_value.at_val.at_str + 1;
-		return (adj_resc_on_node(noden, aflag, op, prdef, val, ++hop));
+		ptarget = find_nodebyname(presc->rs_value.at_val.at_str + 1);
+		if (ptarget == NULL)
+			return PBSE_UNKNODE;
+		return (adj_resc_on_node(ptarget, aflag, op, prdef, pval, ++hop));
 	}
 
-	/* decode the resource value and +/- it to the attribute */
+	/* +/- the value to the attribute */
 
-	memset((void *) &tmpattr, 0, sizeof(attribute));
-	rc = 0;
-
-	if ((rc = prdef->rs_decode(&tmpattr, ATTR_rescassn, prdef->rs_name, val)) != 0)
-		return rc;
-	rc = prdef->rs_set(&presc->rs_value, &tmpattr, op);
+	rc = prdef->rs_set(&presc->rs_value, pval, op);
 	if (op == DECR) {
-		check_for_negative_resource(prdef, presc, noden);
+		check_for_negative_resource(prdef, presc, pnode->nd_name);
 	}
 	return rc;
 }
@@ -7407,6 +7526,8 @@ update_job_node_rassn(job *pjob, attribute *pexech, enum batch_op op)
 	resource *pr = NULL;
 	attribute tmpattr;
 	int nchunk = 0;
+	pbsnode *pnode;
+	int node_looked_up;
 
 	/* Parse the exec_vnode string */
 
@@ -7437,6 +7558,9 @@ update_job_node_rassn(job *pjob, attribute *pexech, enum batch_op op)
 		return;
 	while (chunk) {
 		if (parse_node_resc(chunk, &noden, &nelem, &pkvp) == 0) {
+			/* look the vnode up once per chunk, not once per resource */
+			pnode = NULL;
+			node_looked_up = 0;
 			for (j = 0; j < nelem; ++j) {
 				prdef = find_resc_def(svr_resc_def, pkvp[j].kv_keyw);
 				if (prdef == NULL)
@@ -7447,18 +7571,24 @@ update_job_node_rassn(job *pjob, attribute *pexech, enum batch_op op)
 					continue;
 				}
 
-				rc = adj_resc_on_node(noden, asgn, op, prdef, pkvp[j].kv_val, 0);
-				if (rc && rc != PBSE_UNKNODE)
+				/* decode once, the same value goes to the vnode, server and queue */
+				memset((void *) &tmpattr, 0, sizeof(attribute));
+				if ((rc = prdef->rs_decode(&tmpattr, ATTR_rescassn, prdef->rs_name,
+							   pkvp[j].kv_val)) != 0)
 					return;
 
-				/* update system attribute of resources assigned */
-
-				if (sysru || queru) {
-					if ((rc = prdef->rs_decode(&tmpattr, ATTR_rescassn, pkvp[j].kv_keyw,
-								   pkvp[j].kv_val)) != 0)
+				if (!node_looked_up) {
+					pnode = find_nodebyname(noden);
+					node_looked_up = 1;
+				}
+				if (pnode != NULL) {
+					rc = adj_resc_on_node(pnode, asgn, op, prdef, &tmpattr, 0);
+					if (rc && rc != PBSE_UNKNODE)
 						return;
 				}
 
+				/* update system attribute of resources assigned */
+
 				if (sysru) {
 					pr = find_resc_entry(sysru, prdef);
 					if (pr == NULL) {
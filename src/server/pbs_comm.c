@@ -371,6 +371,7 @@ main(int argc, char **argv)
 	set_log_conf(pbs_conf.pbs_leaf_name, pbs_conf.pbs_mom_node_name,
 		     pbs_conf.locallog, pbs_conf.syslogfac,
 		     pbs_conf.syslogsvr, pbs_conf.pbs_log_highres_timestamp);
+	set_log_journal(pbs_conf.pbs_log_journal);
 
 	umask(022);
 
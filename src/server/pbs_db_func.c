@@ -106,6 +106,8 @@
 
 #define MAX_DB_RETRIES 5
 #define MAX_DB_LOOP_DELAY 10
+#define DB_START_POLL_USECS 250000 /* first retry delay after starting the dataservice */
+#define DB_BACKGROUND_SECS 4	   /* time spent retrying before going to background */
 #define IPV4_STR_LEN 15
 static int db_oper_failed_times = 0;
 static int last_rc = -1; /* we need to reset db_oper_failed_times for each state change of the db */
@@ -118,7 +120,7 @@ void *svr_db_conn = NULL;		  /* server's global database connection pointer */
 void *conn = NULL;			  /* pointer to work out a valid connection - later assigned to svr_db_conn */
 extern int pbs_decrypt_pwd(char *, int, size_t, char **, const unsigned char *, const unsigned char *);
 extern pid_t go_to_background();
-void *setup_db_connection(char *, int, int);
+void *setup_db_connection(char *, int, int, int);
 static void *get_db_connect_information();
 static int touch_db_stop_file(void);
 static int start_db();
@@ -158,7 +160,7 @@ start_db()
 			return PBS_DB_DOWN;
 	}
 
-	sleep(1); /* give time for database to atleast establish the ports */
+	/* connect_to_db() polls briefly until the database takes connections */
 	return PBS_DB_STARTING;
 }
 
@@ -235,6 +237,8 @@ panic_stop_db()
  * @param[in]	host	- The host to connect to
  * @param[in]	port	- The port to connect to
  * @param[in]	timeout	- The connection timeout
+ * @param[in]	running	- caller just saw the database running locally,
+ *			  so it need not be checked again
  *
  * @return	Initialized connection handle.
  * @retval  !NULL - Connection Established.
@@ -242,7 +246,7 @@ panic_stop_db()
  *
  */
 void *
-setup_db_connection(char *host, int port, int timeout)
+setup_db_connection(char *host, int port, int timeout, int running)
 {
 	int failcode = 0;
 	int rc = 0;
@@ -251,7 +255,8 @@ setup_db_connection(char *host, int port, int timeout)
 
 	/* Make sure we have the database instance up and running */
 	/* If the services are down, retry will attempt to start_db() */
-	rc = pbs_status_db(host, port);
+	if (!running)
+		rc = pbs_status_db(host, port);
 	if (rc == 1)
 		return NULL;
 	else if (rc == -1)
@@ -410,9 +415,12 @@ get_db_connect_information()
 	}
 	if (rc == 1)
 		conn_db_state = start_db();
+	else if (rc == 0)
+		conn_db_state = PBS_DB_STARTED; /* up already, connect rather than start it */
 
 	if (conn_db_state == PBS_DB_STARTING || conn_db_state == PBS_DB_STARTED)
-		lconn = setup_db_connection(conn_db_host, pbs_conf.pbs_data_service_port, conn_timeout);
+		lconn = setup_db_connection(conn_db_host, pbs_conf.pbs_data_service_port, conn_timeout,
+					    (rc == 0) && !pbs_conf.pbs_data_service_host);
 	return lconn;
 }
 
@@ -452,7 +460,6 @@ touch_db_stop_file(void)
 int
 connect_to_db(int background)
 {
-	int try_db = 0;
 	int db_stop_counts = 0;
 	int db_stop_email_sent = 0;
 	int conn_state;
@@ -460,11 +467,14 @@ connect_to_db(int background)
 	pid_t sid = -1;
 #endif
 	int db_delay = 0;
+	useconds_t poll_delay;
+	time_t started = time(NULL);
 try_db_again:
 	fprintf(stdout, "Connecting to PBS dataservice.");
 
 	conn_state = PBS_DB_CONNECT_STATE_NOT_CONNECTED;
 	db_oper_failed_times = 0;
+	poll_delay = DB_START_POLL_USECS;
 
 	while (1) {
 #ifndef DEBUG
@@ -504,19 +514,27 @@ try_db_again:
 			else
 				conn_state = PBS_DB_CONNECT_STATE_CONNECTED;
 		}
-		db_delay = (int) (1 + db_oper_failed_times * 1.5);
-		if (db_delay > MAX_DB_LOOP_DELAY)
-			db_delay = MAX_DB_LOOP_DELAY; /* limit to MAX_DB_LOOP_DELAY secs */
-		sleep(db_delay);		      /* dont burn the CPU looping too fast */
-		update_svrlive();		      /* indicate we are alive */
+		if (conn_state == PBS_DB_CONNECT_STATE_CONNECTED)
+			continue; /* nothing to wait for */
+
+		if (conn_db_state == PBS_DB_STARTING && poll_delay < 1000000) {
+			/* a freshly started database is usually up in well under a second */
+			usleep(poll_delay);
+			poll_delay *= 2;
+		} else {
+			db_delay = (int) (1 + db_oper_failed_times * 1.5);
+			if (db_delay > MAX_DB_LOOP_DELAY)
+				db_delay = MAX_DB_LOOP_DELAY; /* limit to MAX_DB_LOOP_DELAY secs */
+			sleep(db_delay);		      /* dont burn the CPU looping too fast */
+		}
+		update_svrlive(); /* indicate we are alive */
 #ifndef DEBUG
-		if (background && try_db >= 4) {
+		if (background && (time(NULL) - started >= DB_BACKGROUND_SECS)) {
 			fprintf(stdout, "continuing in background.\n");
 			if ((sid = go_to_background()) == -1)
 				return (2);
 		}
 #endif /* DEBUG is defined */
-		try_db++;
 	}
 
 	if (!pbs_conf.pbs_data_service_host) {
@@ -153,6 +153,7 @@ extern int max_concurrent_prov;
 extern void *svr_db_conn;
 
 extern pbs_list_head svr_allhooks;
+extern volatile sig_atomic_t svr_mem_dump_pending;
 
 /* External Functions Called */
 
@@ -179,6 +180,7 @@ static void need_y_response(int, char *);
 static int pbsd_init_reque(job *job, int change_state);
 static void resume_net_move(struct work_task *);
 static void stop_me(int);
+static void request_memory_dump(int);
 static int Rmv_if_resv_not_possible(job *);
 static int attach_queue_to_reservation(resc_resv *);
 static void call_log_license(struct work_task *);
@@ -303,6 +305,7 @@ pbsd_init(int type)
 	hook *phook, *phook_current;
 	char *psuffix;
 	int rc;
+	int trx;
 	struct stat statbuf;
 	char hook_msg[HOOK_MSG_SIZE];
 	char *conn_db_err = NULL;
@@ -449,15 +452,17 @@ pbsd_init(int type)
 		return (2);
 	}
 
+	act.sa_handler = request_memory_dump;
+	if (sigaction(SIGUSR1, &act, &oact) != 0) {
+		log_err(errno, __func__, "sigaction for USR1");
+		return (2);
+	}
+
 	act.sa_handler = SIG_IGN;
 	if (sigaction(SIGPIPE, &act, &oact) != 0) {
 		log_err(errno, __func__, "sigaction for PIPE");
 		return (2);
 	}
-	if (sigaction(SIGUSR1, &act, &oact) != 0) {
-		log_err(errno, __func__, "sigaction for USR1");
-		return (2);
-	}
 	if (sigaction(SIGUSR2, &act, &oact) != 0) {
 		log_err(errno, __func__, "sigaction for USR2");
 		return (2);
@@ -708,10 +713,22 @@ pbsd_init(int type)
 
 	server.sv_qs.sv_numjobs = 0;
 
-	/* get jobs from DB */
+	/*
+	 * get jobs from DB; the rows come back from one query, and the
+	 * purges and saves done while requeuing them are committed as a
+	 * single transaction instead of one per job
+	 */
 	obj.pbs_db_obj_type = PBS_DB_JOB;
 	obj.pbs_db_un.pbs_db_job = &dbjob;
+	trx = (pbs_db_begin_trx(conn) == 0);
 	rc = pbs_db_search(conn, &obj, NULL, (query_cb_t) &recov_job_cb);
+	if (trx && pbs_db_end_trx(conn, (rc == -1) ? PBS_DB_ROLLBACK : PBS_DB_COMMIT) != 0) {
+		pbs_db_get_errmsg(PBS_DB_ERR, &conn_db_err);
+		log_errf(-1, __func__, "Failed to commit job recovery %s", conn_db_err ? conn_db_err : "");
+		free(conn_db_err);
+		return (-1);
+	}
+	job_save_db_flush();
 	if (rc == -1) {
 		pbs_db_get_errmsg(PBS_DB_ERR, &conn_db_err);
 		if (conn_db_err != NULL) {
@@ -910,6 +927,23 @@ pbsd_init(int type)
 	(void) set_task(WORK_Timed, (long) (time_now + PBS_SAVE_TRACK_TM),
 			track_save, 0);
 
+	/* set work task to periodically publish the status snapshots */
+
+	if (pbs_conf.pbs_status_snapshot > 0)
+		(void) set_task(WORK_Timed, (long) (time_now + pbs_conf.pbs_status_snapshot),
+				status_snapshot, 0);
+
+	/* set work task to periodically dump the server metrics */
+
+	if (pbs_conf.pbs_server_metrics > 0)
+		(void) set_task(WORK_Timed, (long) (time_now + pbs_conf.pbs_server_metrics),
+				server_metrics_dump, 0);
+
+	/* publish the first metrics snapshot, re-armed every PBS_METRICS_EXPORT */
+
+	if (pbs_conf.pbs_metrics_export > 0)
+		server_metrics_export(NULL);
+
 	fd = open(path_prov_track, O_RDONLY | O_CREAT, 0600);
 	if (fd < 0) {
 		log_err(errno, __func__, "unable to open prov_tracking file");
@@ -1694,6 +1728,24 @@ stop_me(int sig)
 {
 	set_sattr_l_slim(SVR_ATR_State, SV_STATE_SHUTSIG, SET);
 }
+
+/**
+ * @brief
+ * 		request_memory_dump - signal handler for SIGUSR1
+ *
+ *		Record the request, the main loop writes the memory accounting
+ *		with server_memory_dump() outside of the handler.
+ *
+ * @param[in]	sig	- not used in fun.
+ *
+ * @return	void
+ */
+/*ARGSUSED*/
+static void
+request_memory_dump(int sig)
+{
+	svr_mem_dump_pending = 1;
+}
 /**
  * @brief
  * 		chk_save_file - check whether data can be saved into file.
@@ -101,6 +101,7 @@
 #include "pbs_ecl.h"
 #include "provision.h"
 #include "pbs_db.h"
+#include "pbs_metrics.h"
 #include "pbs_sched.h"
 #include "pbs_share.h"
 #include <pbs_python.h> /* for python interpreter */
@@ -123,6 +124,7 @@ extern int chk_and_update_db_svrhost();
 
 /* External data items */
 extern pbs_list_head svr_requests;
+extern volatile sig_atomic_t svr_mem_dump_pending;
 extern char *msg_err_malloc;
 extern int pbs_failover_active;
 
@@ -170,6 +172,8 @@ long new_log_event_mask = 0;
 int server_init_type = RECOV_WARM;
 pbs_list_head svr_deferred_req;
 pbs_list_head svr_newjobs; /* list of incomming new jobs       */
+pbs_list_head svr_dbsave_jobs; /* jobs with a deferred database save */
+pbs_list_head svr_jobs_by_state[PBS_NUMJOBSTATE]; /* server jobs indexed by state */
 pbs_list_head svr_allscheds;
 extern pbs_list_head svr_creds_cache; /* all credentials available to send */
 struct batch_request *saved_takeover_req;
@@ -602,6 +606,8 @@ main(int argc, char **argv)
 	pid_t sid = -1;
 	long state;
 	time_t waittime;
+	unsigned long long loop_start;
+	unsigned long long tasks_start;
 #ifdef _POSIX_MEMLOCK
 	int do_mlockall = 0;
 #endif /* _POSIX_MEMLOCK */
@@ -669,6 +675,7 @@ main(int argc, char **argv)
 	set_log_conf(pbs_conf.pbs_leaf_name, pbs_conf.pbs_mom_node_name,
 		     pbs_conf.locallog, pbs_conf.syslogfac,
 		     pbs_conf.syslogsvr, pbs_conf.pbs_log_highres_timestamp);
+	set_log_journal(pbs_conf.pbs_log_journal);
 
 	/* find out who we are (hostname) */
 	server_host[0] = '\0';
@@ -861,6 +868,9 @@ main(int argc, char **argv)
 	CLEAR_HEAD(svr_queues);
 	CLEAR_HEAD(svr_alljobs);
 	CLEAR_HEAD(svr_newjobs);
+	CLEAR_HEAD(svr_dbsave_jobs);
+	for (i = 0; i < PBS_NUMJOBSTATE; i++)
+		CLEAR_HEAD(svr_jobs_by_state[i]);
 	CLEAR_HEAD(svr_allresvs);
 	CLEAR_HEAD(svr_deferred_req);
 	CLEAR_HEAD(svr_allhooks);
@@ -1116,6 +1126,7 @@ main(int argc, char **argv)
 	sigaddset(&allsigs, SIGINT);  /* during critical sections */
 	sigaddset(&allsigs, SIGTERM); /* so we don't get confused */
 	sigaddset(&allsigs, SIGCHLD);
+	sigaddset(&allsigs, SIGUSR1);
 	/* block signals while we do things */
 	if (sigprocmask(SIG_BLOCK, &allsigs, NULL) == -1)
 		log_err(errno, msg_daemonname, "sigprocmask(BLOCK)");
@@ -1191,6 +1202,9 @@ main(int argc, char **argv)
 	}
 
 	(void) add_conn(tppfd, TppComm, (pbs_net_t) 0, 0, NULL, tpp_request);
+	/* mom traffic is serviced ahead of, and in between, client requests */
+	if (!set_conn_as_priority(get_conn(tppfd)))
+		log_err(-1, msg_daemonname, "Failed to set TPP connection as priority connection");
 
 	tfree2(&ipaddrs);
 	tfree2(&streams);
@@ -1310,6 +1324,8 @@ main(int argc, char **argv)
 	 */
 	while ((state = get_sattr_long(SVR_ATR_State)) != SV_STATE_DOWN && state != SV_STATE_SECIDLE) {
 
+		loop_start = pbs_metrics_now_us();
+
 		/*
 		 * double check that if we are an active Secondary Server, that
 		 * that the Primary has not come back alive; if it did it will
@@ -1326,7 +1342,14 @@ main(int argc, char **argv)
 		}
 
 		/* first process any task whose time delay has expired */
+		tasks_start = pbs_metrics_now_us();
 		waittime = next_task();
+		svr_metrics_tasks(tasks_start);
+
+		if (svr_mem_dump_pending) {
+			svr_mem_dump_pending = 0;
+			(void) server_memory_dump();
+		}
 
 		if ((state = get_sattr_long(SVR_ATR_State)) == SV_STATE_RUN) { /* In normal Run State */
 
@@ -1362,6 +1385,15 @@ main(int argc, char **argv)
 					 * If svr_unsent_qrun_req is not set then do the existing checking and do
 					 * scheduling only if server scheduling is turned on.
 					 */
+					time_t allowed;
+
+					/* coalesce ordinary triggers, qrun requests go out right away */
+					if (!svr_unsent_qrun_req && psched->svr_do_schedule != SCH_SCHEDULE_AJOB &&
+					    (allowed = sched_cycle_allowed_at(psched)) > time_now) {
+						if (waittime > allowed - time_now)
+							waittime = allowed - time_now;
+						continue;
+					}
 
 					psched->sch_next_schedule = time_now + get_sched_attr_long(psched, SCHED_ATR_schediteration);
 					if (schedule_jobs(psched) == 0 && svr_unsent_qrun_req)
@@ -1400,6 +1432,12 @@ main(int argc, char **argv)
 		if (reap_child_flag)
 			reap_child();
 
+		/* commit the job saves deferred since the last wait */
+		job_save_db_flush();
+		acct_flush();
+
+		svr_metrics_loop(loop_start);
+
 		/* wait for a request and process it */
 		if (wait_request(waittime, priority_context) != 0) {
 			log_err(-1, msg_daemonname, "wait_requst failed");
@@ -1427,10 +1465,13 @@ main(int argc, char **argv)
 	}
 	DBPRT(("Server out of main loop, state is %ld\n", state))
 
+	job_save_db_flush();
+
 	/* set the current seq id to the last id before final save */
 	server.sv_qs.sv_lastid = server.sv_qs.sv_jobidnumber;
 	svr_save_db(&server); /* final recording of server */
 	track_save(NULL);     /* save tracking data	     */
+	prov_track_save();    /* and provisioning records   */
 
 	/* if brought up the Secondary Scheduler, take it down */
 
@@ -54,6 +54,7 @@
  * Functions included are:
  *	pbs_crypt_des()
  *	get_credential()
+ *	timed_dispatch_request()
  *	process_request()
  *	set_to_non_blocking()
  *	clear_non_blocking()
@@ -108,6 +109,8 @@
 #include "svrfunc.h"
 #include <libutil.h>
 #include "pbs_sched.h"
+#include "pbs_metrics.h"
+#include "pbs_usdt.h"
 #include "auth.h"
 
 /* global data items */
@@ -131,8 +134,21 @@ extern void req_stat_hook(struct batch_request *);
 
 static void freebr_manage(struct rq_manage *);
 static void freebr_cpyfile(struct rq_cpyfile *);
+#ifndef PBS_MOM
+static void freebr_selact(struct rq_selact *);
+#endif
 static void freebr_cpyfile_cred(struct rq_cpyfile_cred *);
 static void close_quejob(int sfds);
+static struct batch_request *br_get(void);
+static void br_put(struct batch_request *);
+
+/*
+ * batch_request structures freed by free_br() are kept for reuse by
+ * alloc_br() and copy_br() instead of going back to malloc each time
+ */
+#define BR_POOL_MAX 256
+static struct batch_request *br_pool = NULL; /* chained by rq_parentbr */
+static int br_pool_len = 0;
 
 /**
  * @brief
@@ -401,6 +417,31 @@ rerr:
 }
 #endif
 
+/**
+ * @brief
+ * 		Dispatch a request between the dispatch__start and dispatch__done
+ * 		probes, and in the server record the time its handler took in the
+ * 		server metrics.
+ *
+ * @param[in]	sfds	- socket connection
+ * @param[in]	request - the request, may be freed by the time this returns
+ */
+static void
+timed_dispatch_request(int sfds, struct batch_request *request)
+{
+	int rq_type = request->rq_type;
+#ifndef PBS_MOM
+	unsigned long long start = pbs_metrics_now_us();
+#endif
+
+	PBS_PROBE2(dispatch__start, rq_type, sfds);
+	dispatch_request(sfds, request);
+	PBS_PROBE2(dispatch__done, rq_type, sfds);
+#ifndef PBS_MOM
+	svr_metrics_request(rq_type, start);
+#endif
+}
+
 /*
 * @brief
  * 		process_request - process an request from the network:
@@ -490,6 +531,7 @@ process_request(int sfds)
 	}
 
 #ifndef PBS_MOM
+	request->rq_recv_us = pbs_metrics_now_us();
 	strcpy(conn->cn_physhost, request->rq_host);
 	if (conn->cn_username[0] == '\0')
 		strcpy(conn->cn_username, request->rq_user);
@@ -719,6 +761,7 @@ process_request(int sfds)
 		switch (request->rq_type) {
 			case PBS_BATCH_AsyrunJob:
 			case PBS_BATCH_AsyrunJob_ack:
+			case PBS_BATCH_RunJobList:
 			case PBS_BATCH_JobCred:
 			case PBS_BATCH_UserCred:
 			case PBS_BATCH_MoveJob:
@@ -759,7 +802,7 @@ process_request(int sfds)
 	 * the request struture.
 	 */
 
-	dispatch_request(sfds, request);
+	timed_dispatch_request(sfds, request);
 	return;
 }
 
@@ -989,6 +1032,11 @@ dispatch_request(int sfds, struct batch_request *request)
 			req_rerunjob(request);
 			break;
 #ifndef PBS_MOM
+		case PBS_BATCH_ModifyJobList:
+		case PBS_BATCH_ModifyJobList_Async:
+			req_modifyjoblist(request);
+			break;
+
 		case PBS_BATCH_MoveJob:
 			req_movejob(request);
 			break;
@@ -1021,6 +1069,10 @@ dispatch_request(int sfds, struct batch_request *request)
 			req_runjob(request);
 			break;
 
+		case PBS_BATCH_RunJobList:
+			req_runjoblist(request);
+			break;
+
 		case PBS_BATCH_DefSchReply:
 			req_defschedreply(request);
 			break;
@@ -1034,6 +1086,20 @@ dispatch_request(int sfds, struct batch_request *request)
 			req_selectjobs(request);
 			break;
 
+		case PBS_BATCH_SelAct:
+			/* progress replies go back while the jobs are acted on */
+			if (sfds != PBS_LOCAL_CONNECTION && prot == PROT_TCP)
+				conn->cn_authen |= PBS_NET_CONN_NOTIMEOUT;
+			req_selectjobs(request);
+			break;
+
+		case PBS_BATCH_Subscribe:
+			/* events are pushed on this connection from now on */
+			if (sfds != PBS_LOCAL_CONNECTION && prot == PROT_TCP)
+				conn->cn_authen |= PBS_NET_CONN_NOTIMEOUT;
+			req_subscribe(request);
+			break;
+
 #endif /* !PBS_MOM */
 
 		case PBS_BATCH_Shutdown:
@@ -1267,7 +1333,10 @@ process_IS_CMD(int stream)
 		   msg_request, request->rq_type, request->rq_user,
 		   request->rq_host, stream);
 
-	dispatch_request(stream, request);
+#ifndef PBS_MOM
+	request->rq_recv_us = pbs_metrics_now_us();
+#endif
+	timed_dispatch_request(stream, request);
 }
 
 /**
@@ -1294,6 +1363,48 @@ close_client(int sfds)
 	}
 }
 
+/**
+ * @brief
+ * 		get a cleared batch_request structure, from the pool if it has one
+ *
+ * @return	batch_request *
+ * @retval	NULL	- error
+ */
+static struct batch_request *
+br_get(void)
+{
+	struct batch_request *req;
+
+	if (br_pool != NULL) {
+		req = br_pool;
+		br_pool = req->rq_parentbr;
+		br_pool_len--;
+	} else if ((req = (struct batch_request *) malloc(sizeof(struct batch_request))) == NULL)
+		return NULL;
+
+	memset((void *) req, (int) 0, sizeof(struct batch_request));
+	return req;
+}
+
+/**
+ * @brief
+ * 		give a batch_request structure back to the pool, or free it
+ *		if the pool is full
+ *
+ * @param[in]	preq	- the request, its sub-structures already freed
+ */
+static void
+br_put(struct batch_request *preq)
+{
+	if (br_pool_len >= BR_POOL_MAX) {
+		free(preq);
+		return;
+	}
+	preq->rq_parentbr = br_pool;
+	br_pool = preq;
+	br_pool_len++;
+}
+
 /**
  * @brief
  * 		alloc_br - allocate and clear a batch_request structure
@@ -1309,11 +1420,10 @@ alloc_br(int type)
 {
 	struct batch_request *req;
 
-	req = (struct batch_request *) malloc(sizeof(struct batch_request));
+	req = br_get();
 	if (req == NULL)
 		log_err(errno, "alloc_br", msg_err_malloc);
 	else {
-		memset((void *) req, (int) 0, sizeof(struct batch_request));
 		req->rq_type = type;
 		CLEAR_LINK(req->rq_link);
 		req->rq_conn = -1;    /* indicate not connected */
@@ -1347,7 +1457,7 @@ copy_br(struct batch_request *src)
 	if (!src)
 		return NULL;
 
-	req = calloc(sizeof(struct batch_request), 1);
+	req = br_get();
 	if (req == NULL) {
 		log_err(errno, __func__, msg_err_malloc);
 		return NULL;
@@ -1594,6 +1704,10 @@ decode_DIS_RelnodesJob(int sock, struct batch_request *preq)
 void
 free_br(struct batch_request *preq)
 {
+#ifndef PBS_MOM
+	if (preq->rq_recv_us != 0)
+		svr_metrics_request_done(preq->rq_type, preq->rq_recv_us);
+#endif
 	delete_link(&preq->rq_link);
 	reply_free(&preq->rq_reply);
 
@@ -1604,6 +1718,16 @@ free_br(struct batch_request *preq)
 		 * decrement the reference count in the parent and when it
 		 * goes to zero,  reply_send() it
 		 */
+		if (preq->rq_parentbr->rq_type == PBS_BATCH_ModifyJobList) {
+			/* the attribute list was moved out of the parent, see req_modifyjoblist() */
+			freebr_manage(&preq->rq_ind.rq_modify);
+		} else if (preq->rq_parentbr->rq_type == PBS_BATCH_SelAct) {
+			/* each job got its own copy of the action's attributes, see selact_job() */
+			if (preq->rq_type == PBS_BATCH_HoldJob || preq->rq_type == PBS_BATCH_ReleaseJob)
+				freebr_manage(&preq->rq_ind.rq_hold.rq_orig);
+			else
+				freebr_manage(&preq->rq_ind.rq_manager);
+		}
 		if (preq->rq_parentbr->rq_refct > 0) {
 			if (--preq->rq_parentbr->rq_refct == 0) {
 #ifndef PBS_MOM /* Server Only */
@@ -1620,7 +1744,7 @@ free_br(struct batch_request *preq)
 		if (preq->rq_type == PBS_BATCH_DeleteJobList)
 			if (preq->rq_ind.rq_deletejoblist.rq_jobslist)
 				free_string_array(preq->rq_ind.rq_deletejoblist.rq_jobslist);
-		free(preq);
+		br_put(preq);
 		return;
 	}
 
@@ -1699,6 +1823,22 @@ free_br(struct batch_request *preq)
 			if (preq->rq_ind.rq_deletejoblist.rq_jobslist)
 				free_string_array(preq->rq_ind.rq_deletejoblist.rq_jobslist);
 			break;
+		case PBS_BATCH_ModifyJobList:
+		case PBS_BATCH_ModifyJobList_Async:
+			if (preq->rq_ind.rq_modifyjoblist.rq_mods) {
+				int i;
+
+				for (i = 0; i < preq->rq_ind.rq_modifyjoblist.rq_count; i++)
+					freebr_manage(&preq->rq_ind.rq_modifyjoblist.rq_mods[i]);
+				free(preq->rq_ind.rq_modifyjoblist.rq_mods);
+			}
+			break;
+		case PBS_BATCH_RunJobList:
+			if (preq->rq_ind.rq_runjoblist.rq_jobslist)
+				free_string_array(preq->rq_ind.rq_runjoblist.rq_jobslist);
+			if (preq->rq_ind.rq_runjoblist.rq_destinlist)
+				free_string_array(preq->rq_ind.rq_runjoblist.rq_destinlist);
+			break;
 		case PBS_BATCH_CopyFiles:
 		case PBS_BATCH_DelFiles:
 			freebr_cpyfile(&preq->rq_ind.rq_cpyfile);
@@ -1743,6 +1883,9 @@ free_br(struct batch_request *preq)
 			free_attrlist(&preq->rq_ind.rq_select.rq_selattr);
 			free_attrlist(&preq->rq_ind.rq_select.rq_rtnattr);
 			break;
+		case PBS_BATCH_SelAct:
+			freebr_selact(&preq->rq_ind.rq_selact);
+			break;
 		case PBS_BATCH_PreemptJobs:
 			free(preq->rq_ind.rq_preempt.ppj_list);
 			free(preq->rq_reply.brp_un.brp_preempt_jobs.ppj_list);
@@ -1751,7 +1894,7 @@ free_br(struct batch_request *preq)
 	}
 	if (preq->tppcmd_msgid)
 		free(preq->tppcmd_msgid);
-	(void) free(preq);
+	br_put(preq);
 }
 /**
  * @brief
@@ -1764,6 +1907,29 @@ freebr_manage(struct rq_manage *pmgr)
 {
 	free_attrlist(&pmgr->rq_attr);
 }
+
+#ifndef PBS_MOM
+/**
+ * @brief
+ * 		Free the selection, the action's attributes and the jobs not
+ *		acted on yet of a Select Action request.
+ *
+ * @param[in]	psa - rq_selact structure to free.
+ */
+static void
+freebr_selact(struct rq_selact *psa)
+{
+	struct brp_select *psel;
+
+	free_attrlist(&psa->rq_sel.rq_selattr);
+	free_attrlist(&psa->rq_sel.rq_rtnattr);
+	free_attrlist(&psa->rq_args);
+	while ((psel = psa->rq_pending) != NULL) {
+		psa->rq_pending = psel->brp_next;
+		free(psel);
+	}
+}
+#endif /* PBS_MOM */
 /**
  * @brief
  * 		remove all the rqfpair and free their memory
@@ -267,6 +267,69 @@ reply_send_status_part(struct batch_request *preq)
 	return rc;
 }
 
+/**
+ * @brief
+ * 		Send the job errors collected so far in a Delete choice reply as a
+ *		partial reply, then start collecting afresh.  The auxcode of the
+ *		reply goes along as it is.
+ *
+ * @param[in,out]	preq	- request whose reply is sent
+ *
+ * @return	error code
+ * @retval	PBSE_NONE	- success
+ * @retval	!=PBSE_NONE	- failure, no client to send to or write error
+ */
+int
+reply_send_delete_part(struct batch_request *preq)
+{
+	int rc = PBSE_SYSTEM;
+	if (preq->rq_conn >= 0) {
+		struct batch_reply *preply = &preq->rq_reply;
+		preply->brp_is_part = 1;
+		rc = dis_reply_write(preq->rq_conn, preq);
+		if (rc != PBSE_NONE)
+			return rc;
+		reply_free(&preq->rq_reply);
+		preply->brp_choice = BATCH_REPLY_CHOICE_Delete;
+		preply->brp_un.brp_deletejoblist.brp_delstatc = NULL;
+		preply->brp_count = 0;
+	}
+	return rc;
+}
+
+/**
+ * @brief
+ * 		Record the reply of a child request whose parent is a Run Job List,
+ *		Modify Job List or Select Action request.  Each job of those has its
+ *		own status in the parent's reply.
+ *
+ * @param[in]	request	- child request
+ *
+ * @return	int
+ * @retval	1	- the reply was recorded in the parent's list
+ * @retval	0	- the parent is not a list request
+ */
+static int
+reply_to_list_parent(struct batch_request *request)
+{
+#ifndef PBS_MOM
+	struct batch_request *parent = request->rq_parentbr;
+
+	switch (parent->rq_type) {
+		case PBS_BATCH_RunJobList:
+			update_runjoblist_rply(parent, request->rq_ind.rq_run.rq_jid, request->rq_reply.brp_code);
+			return 1;
+		case PBS_BATCH_ModifyJobList:
+			update_runjoblist_rply(parent, request->rq_ind.rq_modify.rq_objname, request->rq_reply.brp_code);
+			return 1;
+		case PBS_BATCH_SelAct:
+			update_runjoblist_rply(parent, request->rq_ind.rq_manager.rq_objname, request->rq_reply.brp_code);
+			return 1;
+	}
+#endif /* PBS_MOM */
+	return 0;
+}
+
 /**
  * @brief
  * 		Send a reply to a batch request, reply either goes to a
@@ -302,7 +365,7 @@ reply_send(struct batch_request *request)
 	sfds = request->rq_conn;
 	rq_type = request->rq_type;
 
-	if (rq_type == PBS_BATCH_ModifyJob_Async || rq_type == PBS_BATCH_AsyrunJob) {
+	if (rq_type == PBS_BATCH_ModifyJob_Async || rq_type == PBS_BATCH_ModifyJobList_Async || rq_type == PBS_BATCH_AsyrunJob) {
 		free_br(request);
 		return 0;
 	}
@@ -311,7 +374,7 @@ reply_send(struct batch_request *request)
 
 	/* if this is a child request, just move the error to the parent */
 	if (request->rq_parentbr) {
-		if (((request->rq_parentbr->rq_reply.brp_choice == BATCH_REPLY_CHOICE_NULL) || (request->rq_parentbr->rq_reply.brp_choice == BATCH_REPLY_CHOICE_Delete)) && (request->rq_parentbr->rq_reply.brp_code == 0)) {
+		if (!reply_to_list_parent(request) && (((request->rq_parentbr->rq_reply.brp_choice == BATCH_REPLY_CHOICE_NULL) || (request->rq_parentbr->rq_reply.brp_choice == BATCH_REPLY_CHOICE_Delete)) && (request->rq_parentbr->rq_reply.brp_code == 0))) {
 			request->rq_parentbr->rq_reply.brp_code = request->rq_reply.brp_code;
 			request->rq_parentbr->rq_reply.brp_auxcode = request->rq_reply.brp_auxcode;
 			if (request->rq_type == PBS_BATCH_DeleteJobList) {
@@ -389,7 +452,7 @@ reply_ack(struct batch_request *preq)
 		return;
 
 	rq_type = preq->rq_type;
-	if (rq_type == PBS_BATCH_ModifyJob_Async || rq_type == PBS_BATCH_AsyrunJob) {
+	if (rq_type == PBS_BATCH_ModifyJob_Async || rq_type == PBS_BATCH_ModifyJobList_Async || rq_type == PBS_BATCH_AsyrunJob) {
 		free_br(preq);
 		return;
 	}
@@ -495,7 +558,7 @@ req_reject(int code, int aux, struct batch_request *preq)
 		return;
 
 	rq_type = preq->rq_type;
-	if (rq_type == PBS_BATCH_ModifyJob_Async || rq_type == PBS_BATCH_AsyrunJob) {
+	if (rq_type == PBS_BATCH_ModifyJob_Async || rq_type == PBS_BATCH_ModifyJobList_Async || rq_type == PBS_BATCH_AsyrunJob) {
 		free_br(preq);
 		return;
 	}
@@ -558,7 +621,7 @@ reply_badattr(int code, int aux, svrattrl *pal,
 	if (preq == NULL)
 		return;
 
-	if (preq->rq_type == PBS_BATCH_ModifyJob_Async) {
+	if (preq->rq_type == PBS_BATCH_ModifyJob_Async || preq->rq_type == PBS_BATCH_ModifyJobList_Async) {
 		free_br(preq);
 		return;
 	}
@@ -616,7 +679,7 @@ reply_text(struct batch_request *preq, int code, char *text)
 	if (preq == NULL)
 		return 0;
 
-	if (preq->rq_type == PBS_BATCH_ModifyJob_Async) {
+	if (preq->rq_type == PBS_BATCH_ModifyJob_Async || preq->rq_type == PBS_BATCH_ModifyJobList_Async) {
 		free_br(preq);
 		return 0;
 	}
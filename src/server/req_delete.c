@@ -78,6 +78,7 @@
 #include "log.h"
 #include "pbs_nodes.h"
 #include "svrfunc.h"
+#include "hook_func.h"
 
 #define QDEL_BREAKER_SECS 5
 
@@ -1241,6 +1242,10 @@ req_reservationOccurrenceEnd(struct batch_request *preq)
 {
 	char hook_msg[HOOK_MSG_SIZE] = {0};
 
+	/* internal request, let the hooks run without holding up the server */
+	if (run_resv_end_hooks_async(preq) == 0)
+		return;
+
 	switch (process_hooks(preq, hook_msg, sizeof(hook_msg), pbs_python_set_interrupt)) {
 		case 0: /* explicit reject */
 			reply_text(preq, PBSE_HOOKERROR, hook_msg);
@@ -97,6 +97,9 @@ pntPBS_IP_LIST pbs_iplist = NULL;
 void *node_idx = NULL;
 static void *hostaddr_idx = NULL;
 
+#define PBSNDLIST_INIT_SLOTS 64
+static int pbsndlist_slots = 0; /* allocated length of pbsndlist */
+
 /* Global Data Items: */
 
 extern void unset_license_location(void);
@@ -1609,6 +1612,7 @@ mgr_sched_set(struct batch_request *preq)
 	int rc;
 	pbs_sched *psched;
 	int only_scheduling = 1;
+	int only_cycle_stats = 1; /* the scheduler reporting on its last cycle */
 
 	psched = find_sched(preq->rq_ind.rq_manager.rq_objname);
 	if (!psched) {
@@ -1621,9 +1625,12 @@ mgr_sched_set(struct batch_request *preq)
 
 	plist = (svrattrl *) GET_NEXT(preq->rq_ind.rq_manager.rq_attr);
 	while (plist) {
-		if (strcmp(plist->al_atopl.name, ATTR_scheduling)) {
+		if (strcmp(plist->al_atopl.name, ATTR_scheduling) &&
+		    strcmp(plist->al_atopl.name, ATTR_sched_cycle_stats)) {
 			only_scheduling = 0;
 		}
+		if (strcmp(plist->al_atopl.name, ATTR_sched_cycle_stats))
+			only_cycle_stats = 0;
 		/*
 		 * We do not overwrite/update the entire record in the database. Therefore, to
 		 * unset attributes, we will need to find out the ones with a 0 or NULL value set.
@@ -1673,6 +1680,14 @@ mgr_sched_set(struct batch_request *preq)
 	if (only_scheduling != 1)
 		set_scheduler_flag(SCH_CONFIGURE, psched);
 
+	/* the cycle stats are replaced every cycle, don't save or log them */
+	if (only_cycle_stats) {
+		free_attrlist(&setlist);
+		free_attrlist(&unsetlist);
+		reply_ack(preq);
+		return;
+	}
+
 	sched_save_db(psched);
 
 done:
@@ -1838,6 +1853,7 @@ mgr_queue_set(struct batch_request *preq)
 				free_attrlist(&unsetlist);
 				return;
 			} else {
+				pque->qu_route_next = 0;
 				que_save_db(pque);
 				mgr_log_attr(msg_man_set, GET_NEXT(preq->rq_ind.rq_manager.rq_attr), PBS_EVENTCLASS_QUEUE, pque->qu_qs.qu_name, NULL);
 			}
@@ -1927,6 +1943,7 @@ mgr_queue_unset(struct batch_request *preq)
 			attribute *attr;
 			if ((attr = get_qattr(pque, QE_ATR_DefaultChunk))->at_flags & ATR_VFLAG_MODIFY)
 				(void) deflt_chunk_action(attr, (void *) pque, ATR_ACTION_ALTER);
+			pque->qu_route_next = 0;
 			que_save_db(pque);
 			mgr_log_attr(msg_man_uns, plist, PBS_EVENTCLASS_QUEUE, pque->qu_qs.qu_name, NULL);
 			if (is_qattr_set(pque, QA_ATR_QType) == 0)
@@ -2770,9 +2787,19 @@ create_pbs_node2(char *objname, svrattrl *plist, int perms, int *bad, struct pbs
 			return (PBSE_SYSTEM);
 		}
 
-		/* expand pbsndlist array exactly svr_totnodes long*/
-		tmpndlist = (struct pbsnode **) realloc(pbsndlist,
-							sizeof(struct pbsnode *) * (svr_totnodes + 1));
+		/*
+		 * expand pbsndlist array geometrically so that a Mom reporting
+		 * thousands of vnodes does not cost a realloc per vnode
+		 */
+		tmpndlist = pbsndlist;
+		if (svr_totnodes >= pbsndlist_slots) {
+			int nslots = pbsndlist_slots ? pbsndlist_slots * 2 : PBSNDLIST_INIT_SLOTS;
+
+			tmpndlist = (struct pbsnode **) realloc(pbsndlist,
+								sizeof(struct pbsnode *) * nslots);
+			if (tmpndlist != NULL)
+				pbsndlist_slots = nslots;
+		}
 
 		if (tmpndlist != NULL) {
 			/*add in the new entry etc*/
@@ -3375,6 +3402,7 @@ mgr_node_create(struct batch_request *preq)
 	long vn_pool;
 	struct pbsnode *pnode;
 	mominfo_t *mymom;
+	int cross_linked = 0;
 	struct sockaddr_in check_ip;
 	int is_node_ip;
 	char *nodename;
@@ -3456,6 +3484,7 @@ mgr_node_create(struct batch_request *preq)
 				for (i = 1; i < ppoolm->msr_numvnds; ++i) {
 					cross_link_mom_vnode(ppoolm->msr_children[i], mymom);
 				}
+				cross_linked = 1;
 			}
 		}
 	}
@@ -3464,7 +3493,11 @@ mgr_node_create(struct batch_request *preq)
 	setup_notification(); /*set mechanism for notifying */
 	/*other nodes of new member   */
 
-	save_nodes_db(1, NULL);
+	/*
+	 * Only the new Mom's vnodes changed unless vnodes of another
+	 * Mom in the pool were cross linked to her, in which case save all.
+	 */
+	save_nodes_db(1, cross_linked ? NULL : mymom);
 
 	reply_ack(preq); /*create completely successful*/
 }
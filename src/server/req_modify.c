@@ -385,6 +385,84 @@ req_modifyjob(struct batch_request *preq)
 	reply_ack(preq);
 }
 
+/**
+ * @brief
+ * 		Service the Modify Job List Requests, async from the scheduler or
+ *		sync from qalter.
+ *
+ * @par	Functionality:
+ *		Each job of the list is handed to req_modifyjob() as its own Modify
+ *		Job request, which takes over the job's attribute list.  Like any
+ *		async request, nothing is sent back for the async form.  For the
+ *		sync form the jobs are child requests of the list: a failed job is
+ *		recorded in the list's reply by update_runjoblist_rply() and the
+ *		reply goes back once every child is done, including those relayed
+ *		to MoM for running jobs.
+ *
+ * @param[in] preq - pointer to batch request from client
+ */
+void
+req_modifyjoblist(struct batch_request *preq)
+{
+	int i;
+	int sync = (preq->rq_type == PBS_BATCH_ModifyJobList);
+	struct rq_manage *pmod;
+	struct batch_request *cpreq;
+	svrattrl *plist;
+
+	if (sync) {
+		preq->rq_reply.brp_choice = BATCH_REPLY_CHOICE_Delete;
+		preq->rq_reply.brp_count = 0;
+		preq->rq_reply.brp_un.brp_deletejoblist.brp_delstatc = NULL;
+
+		/* hold a reference so the reply is not sent before the last child is issued */
+		++preq->rq_refct;
+	}
+
+	for (i = 0; i < preq->rq_ind.rq_modifyjoblist.rq_count; i++) {
+		pmod = &preq->rq_ind.rq_modifyjoblist.rq_mods[i];
+
+		cpreq = alloc_br(sync ? PBS_BATCH_ModifyJob : PBS_BATCH_ModifyJob_Async);
+		if (cpreq == NULL) {
+			if (sync)
+				update_runjoblist_rply(preq, pmod->rq_objname, PBSE_SYSTEM);
+			continue;
+		}
+		cpreq->rq_perm = preq->rq_perm;
+		cpreq->rq_fromsvr = preq->rq_fromsvr;
+		cpreq->rq_conn = preq->rq_conn;
+		cpreq->rq_orgconn = preq->rq_orgconn;
+		cpreq->rq_time = preq->rq_time;
+		strcpy(cpreq->rq_user, preq->rq_user);
+		strcpy(cpreq->rq_host, preq->rq_host);
+		if (sync)
+			cpreq->rq_extend = preq->rq_extend; /* borrowed, the parent frees it */
+		else if (preq->rq_extend != NULL)
+			cpreq->rq_extend = strdup(preq->rq_extend);
+
+		cpreq->rq_ind.rq_modify.rq_cmd = pmod->rq_cmd;
+		cpreq->rq_ind.rq_modify.rq_objtype = pmod->rq_objtype;
+		strcpy(cpreq->rq_ind.rq_modify.rq_objname, pmod->rq_objname);
+		CLEAR_HEAD(cpreq->rq_ind.rq_modify.rq_attr);
+		while ((plist = (svrattrl *) GET_NEXT(pmod->rq_attr)) != NULL) {
+			delete_link(&plist->al_link);
+			append_link(&cpreq->rq_ind.rq_modify.rq_attr, &plist->al_link, plist);
+		}
+
+		if (sync) {
+			cpreq->rq_parentbr = preq;
+			preq->rq_refct++;
+		}
+
+		req_modifyjob(cpreq);
+	}
+
+	if (!sync)
+		free_br(preq);
+	else if (--preq->rq_refct == 0)
+		reply_send(preq);
+}
+
 /**
  * @brief
  * 		Returns the svrattrl entry matching attribute 'name', or NULL if not found.
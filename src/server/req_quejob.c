@@ -1389,6 +1389,15 @@ req_jobscript(struct batch_request *preq)
 	pj->ji_qs.ji_svrflags = (pj->ji_qs.ji_svrflags & ~JOB_SVFLG_CHKPT) |
 				JOB_SVFLG_SCRIPT; /* has a script file */
 
+#ifndef PBS_MOM
+	/* the last chunk may ask for an implicit commit, as for req_quejob */
+	if ((preq->rq_extend) && (strstr(preq->rq_extend, EXTEND_OPT_IMPLICIT_COMMIT)) &&
+	    ((is_jattr_set(pj, JOB_ATR_block)) == 0)) {
+		req_commit_now(preq, pj);
+		return;
+	}
+#endif
+
 	reply_ack(preq);
 }
 
@@ -2982,6 +2991,7 @@ act_resv_add_owner(attribute *pattr, void *pobj, int amode)
 	dumarst.as_bufsize = strlen(ps) + len;
 	dumarst.as_buf = ps;
 	dumarst.as_next = ps + len;
+	dumarst.as_acl = NULL;
 	dumarst.as_string[0] = ps;
 
 	/*"at_set" function returns 0 on success and NZ on failure*/
@@ -115,6 +115,7 @@ static int build_depend(attribute *, char *);
 static void clear_depend(struct depend *, int type, int exists);
 static void del_depend(struct depend *);
 static void update_depend(job *, char *, char *, int, int);
+static int release_before_dep(job *, int, char *);
 
 /* External Global Data Items */
 
@@ -419,31 +420,7 @@ req_register(struct batch_request *preq)
 				case JOB_DEPEND_TYPE_BEFOREOK:
 				case JOB_DEPEND_TYPE_BEFORENOTOK:
 
-					/* predecessor sent release-reduce "on", */
-					/* see if this job can now run 		 */
-					type ^= (JOB_DEPEND_TYPE_BEFORESTART -
-						 JOB_DEPEND_TYPE_AFTERSTART);
-					if ((pdep = find_depend(type, pattr)) != NULL) {
-						pdj = find_dependjob(pdep,
-								     preq->rq_ind.rq_register.rq_child);
-						if (pdj) {
-							del_depend_job(pdj);
-							pattr->at_flags |= ATR_MOD_MCACHE;
-							(void) sprintf(log_buffer, msg_registerrel,
-								       preq->rq_ind.rq_register.rq_child);
-							log_event(PBSEVENT_JOB, PBS_EVENTCLASS_JOB,
-								  LOG_INFO,
-								  pjob->ji_qs.ji_jobid, log_buffer);
-
-							if (GET_NEXT(pdep->dp_jobs) == 0) {
-								/* no more dependencies of this type */
-								del_depend(pdep);
-								set_depend_hold(pjob, pattr);
-							}
-							break;
-						}
-					}
-					rc = PBSE_IVALREQ;
+					rc = release_before_dep(pjob, type, preq->rq_ind.rq_register.rq_child);
 					break;
 				case JOB_DEPEND_TYPE_RUNONE:
 					pdep = find_depend(JOB_DEPEND_TYPE_RUNONE, pattr);
@@ -512,6 +489,93 @@ req_register(struct batch_request *preq)
 	return;
 }
 
+/**
+ * @brief
+ * 		release_before_dep - a predecessor with a before... dependency on
+ *		this job has released it, drop the predecessor from the matching
+ *		after... dependency and lift the hold once none remain.
+ *
+ * @param[in,out]	pjob	-	job being released
+ * @param[in]	type	-	before... dependency type sent by predecessor
+ * @param[in]	childid	-	job id of the predecessor
+ *
+ * @return	error code
+ * @retval	0	: success
+ * @retval	PBSE_IVALREQ	: predecessor not found in the job's dependencies
+ */
+
+static int
+release_before_dep(job *pjob, int type, char *childid)
+{
+	attribute *pattr;
+	struct depend *pdep;
+	struct depend_job *pdj;
+
+	pattr = get_jattr(pjob, JOB_ATR_depend);
+
+	/* predecessor sent release-reduce "on", */
+	/* see if this job can now run 		 */
+	type ^= (JOB_DEPEND_TYPE_BEFORESTART - JOB_DEPEND_TYPE_AFTERSTART);
+	if (((pdep = find_depend(type, pattr)) == NULL) ||
+	    ((pdj = find_dependjob(pdep, childid)) == NULL))
+		return (PBSE_IVALREQ);
+
+	del_depend_job(pdj);
+	pattr->at_flags |= ATR_MOD_MCACHE;
+	log_eventf(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, LOG_INFO,
+		   pjob->ji_qs.ji_jobid, msg_registerrel, childid);
+
+	if (GET_NEXT(pdep->dp_jobs) == 0) {
+		/* no more dependencies of this type */
+		del_depend(pdep);
+		set_depend_hold(pjob, pattr);
+	}
+	return (0);
+}
+
+/**
+ * @brief
+ * 		release_local_dep - release a dependent job owned by this server
+ *		directly, without building a Register Dependent request and
+ *		routing it back to ourself.
+ *
+ * @param[in]	pjob	-	job which has terminated
+ * @param[in]	pparent	-	dependent job entry
+ * @param[in]	type	-	dependency type
+ *
+ * @return	int
+ * @retval	1	: dependent job was local and has been handled
+ * @retval	0	: not local, caller must send a request
+ */
+
+static int
+release_local_dep(job *pjob, struct depend_job *pparent, int type)
+{
+	job *pdjob;
+
+	switch (type) {
+		case JOB_DEPEND_TYPE_BEFORESTART:
+		case JOB_DEPEND_TYPE_BEFOREANY:
+		case JOB_DEPEND_TYPE_BEFOREOK:
+		case JOB_DEPEND_TYPE_BEFORENOTOK:
+			break;
+		default:
+			return 0;
+	}
+	if ((strcasecmp(pparent->dc_svr, server_name) != 0) &&
+	    (strcasecmp(pparent->dc_svr, pbs_server_name) != 0))
+		return 0;
+	if ((pdjob = find_job(pparent->dc_child)) == NULL)
+		return 0;
+	if (check_job_state(pdjob, JOB_STATE_LTR_MOVED) ||
+	    check_job_state(pdjob, JOB_STATE_LTR_FINISHED))
+		return 0;
+
+	if (release_before_dep(pdjob, type, pjob->ji_qs.ji_jobid) == 0)
+		job_save_db(pdjob);
+	return 1;
+}
+
 /**
  * @brief
  * 		post_doq (que not dog) - post request/reply processing for depend_on_que
@@ -1073,10 +1137,12 @@ depend_on_term(job *pjob)
 			pparent = (struct depend_job *) GET_NEXT(pdep->dp_jobs);
 			while (pparent) {
 				/* "release" the job to execute */
-				rc = send_depend_req(pjob, pparent, type, op,
-						     SYNC_SCHED_HINT_NULL, release_req);
-				if (rc)
-					return rc;
+				if ((op != JOB_DEPEND_OP_RELEASE) || !release_local_dep(pjob, pparent, type)) {
+					rc = send_depend_req(pjob, pparent, type, op,
+							     SYNC_SCHED_HINT_NULL, release_req);
+					if (rc)
+						return rc;
+				}
 				pparent = (struct depend_job *) GET_NEXT(pparent->dc_link);
 			}
 		}
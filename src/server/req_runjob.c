@@ -47,6 +47,8 @@
  *	check_and_provision_job()
  *	clear_from_defr()
  *	req_runjob()
+ *	req_runjoblist()
+ *	update_runjoblist_rply()
  *	req_runjob2()
  *	clear_exec_on_run_fail()
  *	req_stagein()
@@ -619,6 +621,115 @@ req_runjob(struct batch_request *preq)
 		reply_send(preq);
 	return;
 }
+
+/**
+ * @brief
+ * 		req_runjoblist - service the Run Job List Request
+ *
+ * @par	Functionality:
+ *		Each (job, destination) pair of the list is run through req_runjob()
+ *		as a child Async Run Job (ack) request of the list.  The children
+ *		borrow the job id and destination strings from the parent.  Children
+ *		which fail record their error in the parent's reply via
+ *		update_runjoblist_rply(); the reply goes back once every child is
+ *		done, which for async-ack runs is before the jobs are sent to MoM.
+ *
+ * @param[in,out]	preq	-	Run Job List Request
+ */
+void
+req_runjoblist(struct batch_request *preq)
+{
+	int i;
+	int count;
+	struct batch_request *cpreq;
+
+	if ((preq->rq_perm & (ATR_DFLAG_MGWR | ATR_DFLAG_OPWR)) == 0) {
+		req_reject(PBSE_PERM, 0, preq);
+		return;
+	}
+
+	count = preq->rq_ind.rq_runjoblist.rq_count;
+	preq->rq_reply.brp_choice = BATCH_REPLY_CHOICE_Delete;
+	preq->rq_reply.brp_count = 0;
+	preq->rq_reply.brp_un.brp_deletejoblist.brp_delstatc = NULL;
+
+	/* hold a reference so the reply is not sent before the last child is issued */
+	++preq->rq_refct;
+
+	for (i = 0; i < count; i++) {
+		char *jid = preq->rq_ind.rq_runjoblist.rq_jobslist[i];
+		char *destin = preq->rq_ind.rq_runjoblist.rq_destinlist[i];
+
+		/* unlike a single run request, a list is never deferred to the scheduler */
+		if ((strlen(jid) > PBS_MAXSVRJOBID) || (destin == NULL) || (*destin == '\0')) {
+			update_runjoblist_rply(preq, jid, PBSE_IVALREQ);
+			continue;
+		}
+
+		cpreq = alloc_br(PBS_BATCH_AsyrunJob_ack);
+		if (cpreq == NULL) {
+			update_runjoblist_rply(preq, jid, PBSE_SYSTEM);
+			continue;
+		}
+		cpreq->rq_perm = preq->rq_perm;
+		cpreq->rq_fromsvr = preq->rq_fromsvr;
+		cpreq->rq_conn = preq->rq_conn;
+		cpreq->rq_orgconn = preq->rq_orgconn;
+		cpreq->rq_time = preq->rq_time;
+		strcpy(cpreq->rq_user, preq->rq_user);
+		strcpy(cpreq->rq_host, preq->rq_host);
+		cpreq->rq_extend = preq->rq_extend;
+		strcpy(cpreq->rq_ind.rq_run.rq_jid, jid);
+		cpreq->rq_ind.rq_run.rq_destin = destin;
+		cpreq->rq_ind.rq_run.rq_resch = 0;
+
+		cpreq->rq_parentbr = preq;
+		preq->rq_refct++;
+
+		req_runjob(cpreq);
+	}
+
+	if (--preq->rq_refct == 0)
+		reply_send(preq);
+}
+
+/**
+ * @brief
+ * 		update_runjoblist_rply - record the error of one job of a Run Job List,
+ *		Modify Job List or Select Action request in the request's reply.
+ *
+ * @param[in,out]	preq	-	Run Job List, Modify Job List or Select Action Request
+ * @param[in]	jid	-	id of the job which could not be run, modified or acted on
+ * @param[in]	errcode	-	error of the job's request
+ */
+void
+update_runjoblist_rply(struct batch_request *preq, char *jid, int errcode)
+{
+	struct batch_deljob_status *pstat;
+
+	if ((preq->rq_type != PBS_BATCH_RunJobList &&
+	     preq->rq_type != PBS_BATCH_ModifyJobList &&
+	     preq->rq_type != PBS_BATCH_SelAct) ||
+	    errcode == PBSE_NONE)
+		return;
+
+	pstat = (struct batch_deljob_status *) malloc(sizeof(struct batch_deljob_status));
+	if (pstat == NULL) {
+		log_err(PBSE_SYSTEM, __func__, "Failed to allocate memory");
+		return;
+	}
+	pstat->name = strdup(jid);
+	if (pstat->name == NULL) {
+		log_err(PBSE_SYSTEM, __func__, "Failed to allocate memory");
+		free(pstat);
+		return;
+	}
+	pstat->code = errcode;
+	pstat->next = preq->rq_reply.brp_un.brp_deletejoblist.brp_delstatc;
+	preq->rq_reply.brp_un.brp_deletejoblist.brp_delstatc = pstat;
+	preq->rq_reply.brp_count++;
+}
+
 /**
  * @brief
  * 		req_runjob - service the Run Job and Asyc Run Job Requests
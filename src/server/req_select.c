@@ -40,8 +40,8 @@
 /**
  *
  * @brief
- * 		Functions relating to the Select Job Batch Request and the Select-Status
- * 		(SelStat) Batch Request.
+ * 		Functions relating to the Select Job Batch Request, the Select-Status
+ * 		(SelStat) Batch Request and the Select Action (SelAct) Batch Request.
  *
  */
 
@@ -63,6 +63,7 @@
 #include "job.h"
 #include "reservation.h"
 #include "queue.h"
+#include "work_task.h"
 #include "pbs_error.h"
 #include "log.h"
 #include "pbs_nodes.h"
@@ -71,6 +72,8 @@
 
 /* Private Data */
 
+#define SELACT_SLICE 500 /* jobs a Select Action acts on before other work may run */
+
 /* Global Data Items  */
 
 extern int resc_access_perm;
@@ -89,6 +92,9 @@ static void free_sellist(struct select_list *pslist);
 static int sel_attr(attribute *, struct select_list *);
 static int select_job(job *, struct select_list *, int, int);
 static int select_subjob(char, struct select_list *);
+static int sel_vnode_member(char *, char *);
+static void selact_slice(struct batch_request *);
+static void selact_start(struct batch_request *);
 
 /**
  * @brief
@@ -302,15 +308,189 @@ add_select_array_entries(job *pjob, int dosub, char *statelist,
 
 /**
  * @brief
- * 	Service both the Select Job Request and the (special for the scheduler)
- * 	Select-status Job Request
+ * 	Service to act on the next slice of the jobs selected by a Select
+ * 	Action request - this is called from a work_interleave task
+ *
+ * @param[in] ptask - pointer to task structure
+ *
+ * @return void
+ */
+static void
+resume_selact(struct work_task *ptask)
+{
+	struct batch_request *preq = (struct batch_request *) ptask->wt_parm1;
+
+	if (preq != NULL)
+		selact_slice(preq);
+}
+
+/**
+ * @brief
+ * 	Apply the action of a Select Action request to one job.  The job gets
+ * 	a child request of the type of the action, with its own copy of the
+ * 	action's attributes, which is handed to the usual request handler so
+ * 	permissions, hooks and logging are those of the single job request.
+ * 	A job the action fails on is recorded in the parent's reply by
+ * 	update_runjoblist_rply() when the child's reply is sent.
+ *
+ * @param[in,out] preq - Select Action request
+ * @param[in] jid - id of the job to act on
+ *
+ * @return void
+ */
+static void
+selact_job(struct batch_request *preq, char *jid)
+{
+	struct rq_selact *psa = &preq->rq_ind.rq_selact;
+	struct batch_request *cpreq;
+	struct rq_manage *pmgr;
+	int type;
+
+	switch (psa->rq_action) {
+		case SELACT_DELETE:
+			type = PBS_BATCH_DeleteJob;
+			break;
+		case SELACT_HOLD:
+			type = PBS_BATCH_HoldJob;
+			break;
+		case SELACT_RELEASE:
+			type = PBS_BATCH_ReleaseJob;
+			break;
+		default:
+			type = PBS_BATCH_ModifyJob;
+			break;
+	}
+
+	cpreq = alloc_br(type);
+	if (cpreq == NULL) {
+		update_runjoblist_rply(preq, jid, PBSE_SYSTEM);
+		return;
+	}
+	cpreq->rq_perm = preq->rq_perm;
+	cpreq->rq_fromsvr = preq->rq_fromsvr;
+	cpreq->rq_conn = preq->rq_conn;
+	cpreq->rq_orgconn = preq->rq_orgconn;
+	cpreq->rq_time = preq->rq_time;
+	strcpy(cpreq->rq_user, preq->rq_user);
+	strcpy(cpreq->rq_host, preq->rq_host);
+
+	if (type == PBS_BATCH_HoldJob || type == PBS_BATCH_ReleaseJob)
+		pmgr = &cpreq->rq_ind.rq_hold.rq_orig;
+	else
+		pmgr = &cpreq->rq_ind.rq_manager;
+	pmgr->rq_cmd = MGR_CMD_SET;
+	pmgr->rq_objtype = MGR_OBJ_JOB;
+	snprintf(pmgr->rq_objname, sizeof(pmgr->rq_objname), "%s", jid);
+	if (copy_svrattrl_list(&psa->rq_args, &pmgr->rq_attr) == -1) {
+		free_br(cpreq);
+		update_runjoblist_rply(preq, jid, PBSE_SYSTEM);
+		return;
+	}
+
+	cpreq->rq_extend = preq->rq_extend; /* borrowed, the parent frees it */
+	cpreq->rq_parentbr = preq;
+	preq->rq_refct++;
+
+	switch (type) {
+		case PBS_BATCH_DeleteJob:
+			req_deletejob(cpreq);
+			break;
+		case PBS_BATCH_HoldJob:
+			req_holdjob(cpreq);
+			break;
+		case PBS_BATCH_ReleaseJob:
+			req_releasejob(cpreq);
+			break;
+		default:
+			req_modifyjob(cpreq);
+			break;
+	}
+}
+
+/**
+ * @brief
+ * 	Act on the next SELACT_SLICE jobs selected by a Select Action request.
+ * 	While jobs remain, the errors so far go back in a partial reply whose
+ * 	auxcode is the number of jobs acted on, and the next slice is left for
+ * 	a work_interleave task so other requests are served in between.  The
+ * 	final reply is sent once the last slice is done and every child
+ * 	request has replied.
+ *
+ * @param[in,out] preq - Select Action request
+ *
+ * @return void
+ */
+static void
+selact_slice(struct batch_request *preq)
+{
+	struct rq_selact *psa = &preq->rq_ind.rq_selact;
+	struct brp_select *psel;
+	int n;
+
+	for (n = 0; n < SELACT_SLICE && (psel = psa->rq_pending) != NULL; n++) {
+		psa->rq_pending = psel->brp_next;
+		selact_job(preq, psel->brp_jobid);
+		free(psel);
+		psa->rq_acted++;
+	}
+	preq->rq_reply.brp_auxcode = psa->rq_acted;
+
+	if (psa->rq_pending != NULL) {
+		(void) reply_send_delete_part(preq);
+		if (set_task(WORK_Interleave, 0, resume_selact, preq) != NULL)
+			return;
+		while ((psel = psa->rq_pending) != NULL) {
+			psa->rq_pending = psel->brp_next;
+			update_runjoblist_rply(preq, psel->brp_jobid, PBSE_SYSTEM);
+			free(psel);
+		}
+	}
+
+	if (--preq->rq_refct == 0)
+		reply_send(preq);
+}
+
+/**
+ * @brief
+ * 	Start acting on the jobs selected for a Select Action request.  The
+ * 	selected job ids are moved out of the reply, which from now on collects
+ * 	the jobs the action failed on, as for a Delete Job List request.
+ *
+ * @param[in,out] preq - Select Action request
+ *
+ * @return void
+ */
+static void
+selact_start(struct batch_request *preq)
+{
+	struct rq_selact *psa = &preq->rq_ind.rq_selact;
+	struct batch_reply *preply = &preq->rq_reply;
+
+	psa->rq_pending = preply->brp_un.brp_select;
+	psa->rq_acted = 0;
+	preply->brp_choice = BATCH_REPLY_CHOICE_Delete;
+	preply->brp_un.brp_deletejoblist.undeleted_job_idx = NULL;
+	preply->brp_un.brp_deletejoblist.brp_delstatc = NULL;
+	preply->brp_count = 0;
+
+	/* hold a reference so the reply is not sent before the last slice is done */
+	++preq->rq_refct;
+	selact_slice(preq);
+}
+
+/**
+ * @brief
+ * 	Service the Select Job Request, the (special for the scheduler)
+ * 	Select-status Job Request and the Select Action Request
  *
  *	This request selects jobs based on a supplied criteria and returns
  *	Select   - a list of the job identifiers which meet the criteria
  *	Sel_stat - a list of the status of the jobs that meet the criteria
  *	             and only the list of specified attributes if specified
+ *	Sel_act  - the jobs which meet the criteria are deleted, held,
+ *		     released or altered, see selact_start()
  *
- * @param[in,out] preq - Select Job Request or Select-status Job Request
+ * @param[in,out] preq - Select Job, Select-status Job or Select Action Request
  *
  * @return void
  *
@@ -331,6 +511,16 @@ req_selectjobs(struct batch_request *preq)
 	int rc;
 	struct select_list *selistp;
 	pbs_sched *psched;
+	int selonly = (preq->rq_type != PBS_BATCH_SelStat); /* reply is a list of job ids */
+
+	if (preq->rq_type == PBS_BATCH_SelAct) {
+		i = preq->rq_ind.rq_selact.rq_action;
+		if (i < SELACT_DELETE || i > SELACT_ALTER ||
+		    (i != SELACT_DELETE && GET_NEXT(preq->rq_ind.rq_selact.rq_args) == NULL)) {
+			req_reject(PBSE_IVALREQ, 0, preq);
+			return;
+		}
+	}
 
 	if (preq->rq_extend != NULL) {
 		/*
@@ -380,7 +570,7 @@ req_selectjobs(struct batch_request *preq)
 
 	/* setup the appropriate return */
 	preply = &preq->rq_reply;
-	if (preq->rq_type == PBS_BATCH_SelectJobs) {
+	if (selonly) {
 		preply->brp_choice = BATCH_REPLY_CHOICE_Select;
 		preply->brp_un.brp_select = NULL;
 	} else {
@@ -396,7 +586,9 @@ req_selectjobs(struct batch_request *preq)
 	else
 		pjob = (job *) GET_NEXT(svr_alljobs);
 	while (pjob) {
-		if (get_sattr_long(SVR_ATR_query_others) || svr_authorize_jobreq(preq, pjob) == 0) {
+		/* query_others lets one see other users' jobs, not act on them */
+		if ((get_sattr_long(SVR_ATR_query_others) && preq->rq_type != PBS_BATCH_SelAct) ||
+		    svr_authorize_jobreq(preq, pjob) == 0) {
 
 			/*
 			 * either job owner or has special permission to see job
@@ -410,7 +602,7 @@ req_selectjobs(struct batch_request *preq)
 			if (select_job(pjob, selistp, dosubjobs, dohistjobs)) {
 
 				/* job is selected, include in reply */
-				if (preq->rq_type == PBS_BATCH_SelectJobs) {
+				if (selonly) {
 
 					/* Select Jobs Reply */
 
@@ -453,7 +645,7 @@ req_selectjobs(struct batch_request *preq)
 			pjob = (job *) GET_NEXT(pjob->ji_jobque);
 		else
 			pjob = (job *) GET_NEXT(pjob->ji_alljobs);
-		if (preq->rq_type != PBS_BATCH_SelectJobs && preply->brp_count >= MAX_JOBS_PER_REPLY && pjob) {
+		if (!selonly && preply->brp_count >= MAX_JOBS_PER_REPLY && pjob) {
 			rc = reply_send_status_part(preq);
 			if (rc != PBSE_NONE)
 				return;
@@ -463,6 +655,8 @@ out:
 	free_sellist(selistp);
 	if (rc)
 		req_reject(rc, 0, preq);
+	else if (preq->rq_type == PBS_BATCH_SelAct)
+		selact_start(preq);
 	else
 		reply_send(preq);
 }
@@ -568,6 +762,14 @@ sel_attr(attribute *jobat, struct select_list *pselst)
 		else /* not one in job,  force to .lt. */
 			rc = -1;
 
+	} else if (pselst->sl_atindx == (int) JOB_ATR_exec_vnode &&
+		   (pselst->sl_op == EQ || pselst->sl_op == NE) &&
+		   strchr(get_attr_str(&pselst->sl_attr), '(') == NULL) {
+		/* vnode membership: a '+' separated list of vnode names */
+
+		rc = is_attr_set(jobat) && sel_vnode_member(get_attr_str(jobat), get_attr_str(&pselst->sl_attr));
+		return (pselst->sl_op == EQ ? rc : !rc);
+
 	} else {
 		/* "normal" attribute */
 
@@ -595,6 +797,54 @@ sel_attr(attribute *jobat, struct select_list *pselst)
 	return (0);
 }
 
+/**
+ * @brief
+ * 		sel_vnode_member - determine if a job's exec_vnode uses any of
+ *		a list of vnodes
+ *
+ * @param[in]	execvnode	-	the job's exec_vnode
+ * @param[in]	vnodes	-	'+' separated list of vnode names
+ *
+ * @return	int
+ * @retval	0	: none of the vnodes are in exec_vnode
+ * @retval	1	: at least one of the vnodes is in exec_vnode
+ *
+ */
+
+static int
+sel_vnode_member(char *execvnode, char *vnodes)
+{
+	char *name;
+	char *p;
+	size_t nlen;
+	size_t len;
+
+	if (execvnode == NULL || vnodes == NULL)
+		return (0);
+
+	for (name = vnodes; *name != '\0'; name += nlen) {
+		if (*name == '+') {
+			nlen = 1;
+			continue;
+		}
+		nlen = strcspn(name, "+");
+
+		/* exec_vnode is of the form (vn1:res=val+vn2:res=val)+(vn3:res=val) */
+		for (p = execvnode; *p != '\0';) {
+			if (*p == '(' || *p == '+') {
+				p++;
+				continue;
+			}
+			len = strcspn(p, ":+)");
+			if (len == nlen && strncmp(p, name, nlen) == 0)
+				return (1);
+			p += len;
+			p += strcspn(p, "+(");
+		}
+	}
+	return (0);
+}
+
 /**
  * @brief
  * 		Free a select_list list created by build_selist()
@@ -164,8 +164,13 @@ do_stat_of_a_job(struct batch_request *preq, job *pjob, int dohistjobs, int dosu
 		rc = status_job(pjob, preq, pal, &preply->brp_un.brp_status, &bad, dosubjobs);
 		if (dosubjobs && (pjob->ji_qs.ji_svrflags & JOB_SVFLG_ArrayJob) && (rc == PBSE_NONE || rc != PBSE_PERM) && pjob->ji_ajinfo != NULL && pjob->ji_ajinfo->tkm_ct != pjob->ji_ajinfo->tkm_subjsct[JOB_STATE_QUEUED]) {
 			for (i = pjob->ji_ajinfo->tkm_start; i <= pjob->ji_ajinfo->tkm_end; i += pjob->ji_ajinfo->tkm_step) {
-				if (range_contains(pjob->ji_ajinfo->trm_quelist, i))
+				if (range_set_contains(pjob->ji_ajinfo->trm_quelist, i))
 					continue;
+				if (preply->brp_count >= MAX_JOBS_PER_REPLY) {
+					rc = reply_send_status_part(preq);
+					if (rc != PBSE_NONE)
+						return rc;
+				}
 				rc = status_subjob(pjob, preq, pal, i, &preply->brp_un.brp_status, &bad, 1);
 				if (rc && rc != PBSE_PERM)
 					break;
@@ -372,6 +377,11 @@ req_stat_job(struct batch_request *preq)
 		 */
 		pnxtjid = name;
 		while ((name = parse_comma_string_r(&pnxtjid)) != NULL) {
+			if (preply->brp_count >= MAX_JOBS_PER_REPLY) {
+				rc = reply_send_status_part(preq);
+				if (rc != PBSE_NONE)
+					return;
+			}
 			if ((rc = stat_a_jobidname(preq, name, dohistjobs, dosubjobs)) == PBSE_NONE)
 				at_least_one_success = 1;
 		}
@@ -536,6 +546,165 @@ status_que(pbs_queue *pque, struct batch_request *preq, pbs_list_head *pstathd)
 	return rc;
 }
 
+#define NODE_FILTER_MAX_RESC 8
+
+/* selection decoded from the extend string of a Status Node request */
+struct node_filter {
+	int nf_active;		 /* any term given */
+	int nf_free;		 /* "free" was listed among the states */
+	unsigned long nf_states; /* match nodes in any of these states */
+	char *nf_partition;	 /* and in this partition, "" for none */
+	int nf_nresc;
+	struct {
+		resource_def *nf_rdef;
+		attribute nf_value;
+	} nf_resc[NODE_FILTER_MAX_RESC]; /* and with these resources_available */
+};
+
+/**
+ * @brief
+ *		free the resource values of a node filter
+ *
+ * @param[in,out]	nf	-	the filter
+ */
+static void
+free_node_filter(struct node_filter *nf)
+{
+	int i;
+
+	for (i = 0; i < nf->nf_nresc; i++)
+		nf->nf_resc[i].nf_rdef->rs_free(&nf->nf_resc[i].nf_value);
+	nf->nf_nresc = 0;
+	free(nf->nf_partition);
+	nf->nf_partition = NULL;
+}
+
+/**
+ * @brief
+ *		decode the node filter terms of a Status Node request's extend string
+ *
+ *		Terms are separated by white space.  "state=s1,s2,..." selects nodes
+ *		in any of the listed states, "resources_available.R=value" the
+ *		nodes whose R equals value and "partition=P" the nodes in partition
+ *		P, or in no partition if P is empty; all terms must match.  Other words are
+ *		ignored, as the extend string was before.
+ *
+ * @param[in]	extend	-	the request's extend string, may be NULL
+ * @param[out]	nf	-	the decoded filter
+ *
+ * @return	int
+ * @retval	0	: success, nf->nf_active set if there is anything to filter on
+ * @retval	!0	: PBSE error code
+ */
+static int
+decode_node_filter(char *extend, struct node_filter *nf)
+{
+	char *work;
+	char *term;
+	char *val;
+	char *st;
+	char *save1;
+	char *save2;
+	unsigned long bit;
+	resource_def *prdef;
+	int rc = 0;
+	size_t rlen = strlen(ATTR_rescavail);
+
+	memset(nf, 0, sizeof(*nf));
+	if ((extend == NULL) || (strchr(extend, '=') == NULL))
+		return 0;
+	if ((work = strdup(extend)) == NULL)
+		return PBSE_SYSTEM;
+
+	for (term = strtok_r(work, " \t", &save1); term && !rc; term = strtok_r(NULL, " \t", &save1)) {
+		if (strncmp(term, NODE_FILTER_STATE, strlen(NODE_FILTER_STATE)) == 0) {
+			val = term + strlen(NODE_FILTER_STATE);
+			for (st = strtok_r(val, ",", &save2); st; st = strtok_r(NULL, ",", &save2)) {
+				if (strcmp(st, ND_free) == 0) {
+					nf->nf_free = 1;
+					continue;
+				}
+				if ((bit = str_to_vnode_state(st)) == 0) {
+					rc = PBSE_BADNDATVAL;
+					break;
+				}
+				nf->nf_states |= bit;
+			}
+			/* a node offlined by its mom is shown as offline */
+			if (nf->nf_states & INUSE_OFFLINE)
+				nf->nf_states |= INUSE_OFFLINE_BY_MOM;
+			nf->nf_active = 1;
+		} else if ((strncmp(term, ATTR_rescavail, rlen) == 0) && (term[rlen] == '.') &&
+			   ((val = strchr(term, '=')) != NULL)) {
+			*val++ = '\0';
+			if ((prdef = find_resc_def(svr_resc_def, term + rlen + 1)) == NULL) {
+				rc = PBSE_UNKRESC;
+				break;
+			}
+			if (nf->nf_nresc == NODE_FILTER_MAX_RESC) {
+				rc = PBSE_BADATVAL;
+				break;
+			}
+			memset(&nf->nf_resc[nf->nf_nresc].nf_value, 0, sizeof(attribute));
+			if (prdef->rs_decode(&nf->nf_resc[nf->nf_nresc].nf_value, ATTR_rescavail,
+					     prdef->rs_name, val) != 0) {
+				rc = PBSE_BADATVAL;
+				break;
+			}
+			nf->nf_resc[nf->nf_nresc++].nf_rdef = prdef;
+			nf->nf_active = 1;
+		} else if (strncmp(term, NODE_FILTER_PARTITION, strlen(NODE_FILTER_PARTITION)) == 0) {
+			free(nf->nf_partition);
+			if ((nf->nf_partition = strdup(term + strlen(NODE_FILTER_PARTITION))) == NULL) {
+				rc = PBSE_SYSTEM;
+				break;
+			}
+			nf->nf_active = 1;
+		}
+	}
+	free(work);
+	if (rc)
+		free_node_filter(nf);
+	return rc;
+}
+
+/**
+ * @brief
+ *		check a node against a decoded node filter
+ *
+ * @param[in]	pnode	-	the node
+ * @param[in]	nf	-	the filter
+ *
+ * @return	int
+ * @retval	1	: the node is selected
+ * @retval	0	: it is not
+ */
+static int
+match_node_filter(struct pbsnode *pnode, struct node_filter *nf)
+{
+	resource *prs;
+	int i;
+
+	if (nf->nf_free || nf->nf_states) {
+		if (!((nf->nf_free && (pnode->nd_state == 0)) || (pnode->nd_state & nf->nf_states)))
+			return 0;
+	}
+	if (nf->nf_partition != NULL) {
+		if (is_nattr_set(pnode, ND_ATR_partition)) {
+			if (strcmp(get_nattr_str(pnode, ND_ATR_partition), nf->nf_partition) != 0)
+				return 0;
+		} else if (nf->nf_partition[0] != '\0')
+			return 0;
+	}
+	for (i = 0; i < nf->nf_nresc; i++) {
+		prs = find_resc_entry(get_nattr(pnode, ND_ATR_ResourceAvail), nf->nf_resc[i].nf_rdef);
+		if ((prs == NULL) || !is_attr_set(&prs->rs_value) ||
+		    (nf->nf_resc[i].nf_rdef->rs_comp(&prs->rs_value, &nf->nf_resc[i].nf_value) != 0))
+			return 0;
+	}
+	return 1;
+}
+
 /**
  * @brief
  * 		req_stat_node - service the Status Node Request
@@ -556,6 +725,7 @@ req_stat_node(struct batch_request *preq)
 	int rc = 0;
 	int type = 0;
 	int i;
+	struct node_filter filter;
 
 	/*
 	 * first, check that the server indeed has a list of nodes
@@ -591,16 +761,23 @@ req_stat_node(struct batch_request *preq)
 	if (type == 0) { /* get status of the named node */
 		rc = status_node(pnode, preq, &preply->brp_un.brp_status);
 
-	} else { /* get status of all nodes */
+	} else { /* get status of all nodes, or those the filter selects */
 
+		if ((rc = decode_node_filter(preq->rq_extend, &filter)) != 0) {
+			req_reject(rc, 0, preq);
+			return;
+		}
 		for (i = 0; i < svr_totnodes; i++) {
 			pnode = pbsndlist[i];
 
+			if (filter.nf_active && !match_node_filter(pnode, &filter))
+				continue;
 			rc = status_node(pnode, preq,
 					 &preply->brp_un.brp_status);
 			if (rc)
 				break;
 		}
+		free_node_filter(&filter);
 	}
 
 	if (!rc) {
@@ -744,13 +921,14 @@ req_stat_svr(struct batch_request *preq)
 	update_state_ct(get_sattr(SVR_ATR_JobsByState), server.sv_jobstates, &svr_attr_def[SVR_ATR_JobsByState]);
 
 	update_license_ct();
+	update_server_metrics();
 
 	conn = get_conn(preq->rq_conn);
-	if (!conn) {
+	if (!conn && !preq->rq_fromsvr) {
 		req_reject(PBSE_SYSTEM, 0, preq);
 		return;
 	}
-	if (conn->cn_origin == CONN_SCHED_PRIMARY) {
+	if (conn && conn->cn_origin == CONN_SCHED_PRIMARY) {
 		/* Request is from sched so update "has_runjob_hook" */
 		update_isrunhook(get_sattr(SVR_ATR_has_runjob_hook));
 	}
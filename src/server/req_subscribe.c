@@ -0,0 +1,520 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file	req_subscribe.c
+ *
+ * @brief
+ * 		Functions relating to the Subscribe Batch Request: a client asks to
+ * 		be told about job or vnode state changes instead of polling status.
+ *
+ * 	After the request is acknowledged, the server pushes a status reply on
+ * 	the connection whenever subscribed objects change state. Each reply
+ * 	lists only the changed objects and their new state. Changes are queued
+ * 	as they happen and sent from a work task, so a state change never
+ * 	writes to a socket in the middle of other request processing. Pushes
+ * 	never wait on a subscriber: one whose socket buffer is full is dropped.
+ *
+ * Functions included are:
+ * 	req_subscribe()
+ * 	subscribe_notify_job()
+ * 	subscribe_notify_node()
+ *
+ */
+#include <pbs_config.h> /* the master config generated by configure */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include "libpbs.h"
+#include "dis.h"
+#include "server_limits.h"
+#include "list_link.h"
+#include "attribute.h"
+#include "server.h"
+#include "batch_request.h"
+#include "job.h"
+#include "work_task.h"
+#include "pbs_error.h"
+#include "pbs_nodes.h"
+#include "svrfunc.h"
+#include "net_connect.h"
+#include "log.h"
+
+#define SUB_JOBS 0x1  /* subscribed to job state changes */
+#define SUB_NODES 0x2 /* subscribed to vnode state changes */
+
+/* one per subscribed connection */
+typedef struct subscriber {
+	pbs_list_link sb_link;
+	int sb_sock;
+	int sb_flags;			 /* SUB_JOBS | SUB_NODES */
+	char sb_owner[PBS_MAXUSER + 1]; /* job owner to report, "" for all */
+} subscriber;
+
+/* a state change waiting to be sent */
+typedef struct sub_event {
+	pbs_list_link se_link;
+	int se_objtype;			 /* MGR_OBJ_JOB or MGR_OBJ_NODE */
+	char *se_name;			 /* job id or vnode name */
+	char se_owner[PBS_MAXUSER + 1]; /* job owner, jobs only */
+	char *se_state;
+	long se_substate; /* jobs only */
+} sub_event;
+
+extern char *msg_err_malloc;
+
+static pbs_list_head subscribers;
+static pbs_list_head sub_events;
+static int sub_lists_init = 0;
+static int sub_flush_pending = 0;
+
+/**
+ * @brief
+ * 		init_sub_lists - set up the list heads on first use.
+ */
+static void
+init_sub_lists(void)
+{
+	if (!sub_lists_init) {
+		CLEAR_HEAD(subscribers);
+		CLEAR_HEAD(sub_events);
+		sub_lists_init = 1;
+	}
+}
+
+/**
+ * @brief
+ * 		find_subscriber - find the subscriber record of a connection.
+ *
+ * @param[in]	sock	- connection socket
+ *
+ * @return	subscriber *
+ * @retval	NULL	- connection has not subscribed
+ */
+static subscriber *
+find_subscriber(int sock)
+{
+	subscriber *psub;
+
+	init_sub_lists();
+	for (psub = (subscriber *) GET_NEXT(subscribers); psub;
+	     psub = (subscriber *) GET_NEXT(psub->sb_link)) {
+		if (psub->sb_sock == sock)
+			return psub;
+	}
+	return NULL;
+}
+
+/**
+ * @brief
+ * 		subscriber_close - connection close callback, drops the subscriber.
+ *
+ * @param[in]	sock	- connection socket being closed
+ */
+static void
+subscriber_close(int sock)
+{
+	subscriber *psub;
+
+	if ((psub = find_subscriber(sock)) != NULL) {
+		delete_link(&psub->sb_link);
+		free(psub);
+	}
+}
+
+/**
+ * @brief
+ * 		free_sub_event - free a queued state change.
+ *
+ * @param[in]	pev	- event to free
+ */
+static void
+free_sub_event(sub_event *pev)
+{
+	delete_link(&pev->se_link);
+	free(pev->se_name);
+	free(pev->se_state);
+	free(pev);
+}
+
+/**
+ * @brief
+ * 		add_event_attr - append an attribute with a string value to a
+ * 		status entry.
+ *
+ * @param[in,out]	pstat	- status entry
+ * @param[in]	name	- attribute name
+ * @param[in]	val	- attribute value
+ *
+ * @return	int
+ * @retval	0	- success
+ * @retval	-1	- out of memory
+ */
+static int
+add_event_attr(struct brp_status *pstat, char *name, char *val)
+{
+	svrattrl *pal;
+
+	pal = attrlist_create(name, NULL, (int) strlen(val) + 1);
+	if (pal == NULL)
+		return (-1);
+	strcpy(pal->al_value, val);
+	pal->al_flags = ATR_VFLAG_SET;
+	append_link(&pstat->brp_attr, &pal->al_link, pal);
+	return (0);
+}
+
+/**
+ * @brief
+ * 		push_reply - write a pushed reply to a subscriber without blocking.
+ *
+ * 		The write is done on a non-blocking socket with no DIS write
+ * 		timeout, so it fails at once if the subscriber's socket buffer is
+ * 		full. The subscriber is then dropped, as part of the reply may have
+ * 		gone out already.
+ *
+ * @param[in]	sock	- subscriber's connection socket
+ * @param[in]	preply	- reply to push
+ *
+ * @return	int
+ * @retval	0	- success
+ * @retval	-1	- the reply could not be sent, the connection is closed
+ */
+static int
+push_reply(int sock, struct batch_reply *preply)
+{
+	time_t old_tcp_timeout = pbs_tcp_timeout;
+	int flg;
+	int rc;
+
+	if (((flg = fcntl(sock, F_GETFL)) == -1) ||
+	    (fcntl(sock, F_SETFL, flg | O_NONBLOCK) == -1)) {
+		log_err(errno, __func__, "Unable to set subscriber socket non-blocking");
+		close_client(sock);
+		return (-1);
+	}
+
+	pbs_tcp_timeout = 0;
+	pbs_tcp_errno = 0;
+	DIS_tcp_funcs();
+	rc = encode_DIS_reply(sock, preply);
+	if (rc == 0)
+		rc = dis_flush(sock);
+	pbs_tcp_timeout = old_tcp_timeout;
+
+	if (rc != 0) {
+		log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_REQUEST, LOG_NOTICE, __func__,
+			   "Dropping subscriber on socket %d, %s", sock,
+			   pbs_tcp_errno == EAGAIN ? "it is not reading its events" : "write failed");
+		close_client(sock);
+		return (-1);
+	}
+	(void) fcntl(sock, F_SETFL, flg);
+	return (0);
+}
+
+/**
+ * @brief
+ * 		send_sub_events - send a subscriber the queued events it asked for.
+ *
+ * @param[in]	psub	- subscriber
+ *
+ * @return	int
+ * @retval	0	- success or nothing to send
+ * @retval	!0	- the reply could not be sent, the connection is closed
+ */
+static int
+send_sub_events(subscriber *psub)
+{
+	struct batch_request *preq;
+	struct batch_reply *preply;
+	struct brp_status *pstat;
+	sub_event *pev;
+	char buf[32];
+	int rc;
+
+	preq = alloc_br(PBS_BATCH_Subscribe);
+	if (preq == NULL)
+		return (PBSE_SYSTEM);
+	preply = &preq->rq_reply;
+	preply->brp_choice = BATCH_REPLY_CHOICE_Status;
+	CLEAR_HEAD(preply->brp_un.brp_status);
+	preply->brp_count = 0;
+
+	for (pev = (sub_event *) GET_NEXT(sub_events); pev;
+	     pev = (sub_event *) GET_NEXT(pev->se_link)) {
+		if (pev->se_objtype == MGR_OBJ_JOB) {
+			if (!(psub->sb_flags & SUB_JOBS))
+				continue;
+			if (psub->sb_owner[0] != '\0' && strcmp(psub->sb_owner, pev->se_owner) != 0)
+				continue;
+		} else if (!(psub->sb_flags & SUB_NODES))
+			continue;
+
+		pstat = (struct brp_status *) malloc(sizeof(struct brp_status));
+		if (pstat == NULL)
+			break;
+		CLEAR_LINK(pstat->brp_stlink);
+		CLEAR_HEAD(pstat->brp_attr);
+		pstat->brp_objtype = pev->se_objtype;
+		pbs_strncpy(pstat->brp_objname, pev->se_name, sizeof(pstat->brp_objname));
+		append_link(&preply->brp_un.brp_status, &pstat->brp_stlink, pstat);
+		preply->brp_count++;
+
+		if (pev->se_objtype == MGR_OBJ_JOB) {
+			snprintf(buf, sizeof(buf), "%ld", pev->se_substate);
+			if (add_event_attr(pstat, ATTR_state, pev->se_state) ||
+			    add_event_attr(pstat, ATTR_substate, buf))
+				break;
+		} else if (add_event_attr(pstat, ATTR_NODE_state, pev->se_state))
+			break;
+	}
+
+	rc = 0;
+	if (preply->brp_count > 0)
+		rc = push_reply(psub->sb_sock, preply);
+	free_br(preq);
+	return (rc);
+}
+
+/**
+ * @brief
+ * 		flush_sub_events - work task to push the queued state changes to
+ * 		the subscribers.
+ *
+ * @param[in]	ptask	- work task, unused
+ */
+static void
+flush_sub_events(struct work_task *ptask)
+{
+	subscriber *psub;
+	subscriber *pnext;
+	sub_event *pev;
+
+	sub_flush_pending = 0;
+
+	for (psub = (subscriber *) GET_NEXT(subscribers); psub; psub = pnext) {
+		/* a failed send closes the connection and frees psub */
+		pnext = (subscriber *) GET_NEXT(psub->sb_link);
+		(void) send_sub_events(psub);
+	}
+
+	while ((pev = (sub_event *) GET_NEXT(sub_events)) != NULL)
+		free_sub_event(pev);
+}
+
+/**
+ * @brief
+ * 		queue_sub_event - queue a state change and make sure a flush is
+ * 		scheduled.
+ *
+ * @param[in]	pev	- event to queue
+ */
+static void
+queue_sub_event(sub_event *pev)
+{
+	append_link(&sub_events, &pev->se_link, pev);
+	if (!sub_flush_pending) {
+		if (set_task(WORK_Immed, 0, flush_sub_events, NULL) == NULL) {
+			log_err(errno, __func__, msg_err_malloc);
+			return;
+		}
+		sub_flush_pending = 1;
+	}
+}
+
+/**
+ * @brief
+ * 		new_sub_event - allocate a state change event.
+ *
+ * @param[in]	objtype	- MGR_OBJ_JOB or MGR_OBJ_NODE
+ * @param[in]	name	- object name
+ * @param[in]	state	- new state
+ *
+ * @return	sub_event *
+ * @retval	NULL	- out of memory
+ */
+static sub_event *
+new_sub_event(int objtype, char *name, char *state)
+{
+	sub_event *pev;
+
+	pev = (sub_event *) calloc(1, sizeof(sub_event));
+	if (pev == NULL)
+		return NULL;
+	CLEAR_LINK(pev->se_link);
+	pev->se_objtype = objtype;
+	pev->se_name = strdup(name);
+	pev->se_state = strdup(state);
+	if (pev->se_name == NULL || pev->se_state == NULL) {
+		free(pev->se_name);
+		free(pev->se_state);
+		free(pev);
+		log_err(errno, __func__, msg_err_malloc);
+		return NULL;
+	}
+	return pev;
+}
+
+/**
+ * @brief
+ * 		subscribe_notify_job - record a job state change for the
+ * 		subscribers, called from svr_setjobstate().
+ *
+ * @param[in]	pjob	- job whose state changed
+ */
+void
+subscribe_notify_job(job *pjob)
+{
+	sub_event *pev;
+	char state[2];
+	char *owner;
+	char *at;
+
+	if (!sub_lists_init || GET_NEXT(subscribers) == NULL)
+		return;
+
+	state[0] = get_job_state(pjob);
+	state[1] = '\0';
+	if ((pev = new_sub_event(MGR_OBJ_JOB, pjob->ji_qs.ji_jobid, state)) == NULL)
+		return;
+	pev->se_substate = get_job_substate(pjob);
+	if ((owner = get_jattr_str(pjob, JOB_ATR_job_owner)) != NULL) {
+		pbs_strncpy(pev->se_owner, owner, sizeof(pev->se_owner));
+		if ((at = strchr(pev->se_owner, '@')) != NULL)
+			*at = '\0';
+	}
+	queue_sub_event(pev);
+}
+
+/**
+ * @brief
+ * 		subscribe_notify_node - record a vnode state change for the
+ * 		subscribers, called from set_vnode_state().
+ *
+ * @param[in]	pnode	- vnode whose state changed
+ */
+void
+subscribe_notify_node(struct pbsnode *pnode)
+{
+	sub_event *pev;
+	pbs_list_head head;
+	svrattrl *pal = NULL;
+
+	if (!sub_lists_init || GET_NEXT(subscribers) == NULL)
+		return;
+
+	/* use the same state names as a status reply */
+	CLEAR_HEAD(head);
+	if (node_attr_def[ND_ATR_state].at_encode(get_nattr(pnode, ND_ATR_state), &head,
+						  ATTR_NODE_state, NULL, ATR_ENCODE_CLIENT, &pal) <= 0 ||
+	    pal == NULL) {
+		free_attrlist(&head);
+		return;
+	}
+	if ((pev = new_sub_event(MGR_OBJ_NODE, pnode->nd_name, pal->al_value)) != NULL)
+		queue_sub_event(pev);
+	free_attrlist(&head);
+}
+
+/**
+ * @brief
+ * 		req_subscribe - service the Subscribe request.
+ *
+ * 		A connection may subscribe to job and to vnode state changes, a
+ * 		second request for jobs replaces the owner filter. Users without
+ * 		operator or manager privilege only hear about their own jobs
+ * 		unless query_other_jobs is set.
+ *
+ * @param[in,out]	preq	- Subscribe request
+ *
+ * @return	void
+ */
+void
+req_subscribe(struct batch_request *preq)
+{
+	struct rq_subscribe *prq = &preq->rq_ind.rq_subscribe;
+	subscriber *psub;
+	int flag;
+
+	if (prq->rq_objtype == MGR_OBJ_JOB)
+		flag = SUB_JOBS;
+	else if (prq->rq_objtype == MGR_OBJ_NODE)
+		flag = SUB_NODES;
+	else {
+		req_reject(PBSE_IVALREQ, 0, preq);
+		return;
+	}
+
+	if (get_conn(preq->rq_conn) == NULL || preq->prot != PROT_TCP) {
+		req_reject(PBSE_NOSUP, 0, preq);
+		return;
+	}
+
+	if (flag == SUB_JOBS && (preq->rq_perm & (ATR_DFLAG_MGRD | ATR_DFLAG_OPRD)) == 0 &&
+	    !get_sattr_long(SVR_ATR_query_others)) {
+		if (prq->rq_filter[0] == '\0')
+			pbs_strncpy(prq->rq_filter, preq->rq_user, sizeof(prq->rq_filter));
+		else if (strcmp(prq->rq_filter, preq->rq_user) != 0) {
+			req_reject(PBSE_PERM, 0, preq);
+			return;
+		}
+	}
+
+	if ((psub = find_subscriber(preq->rq_conn)) == NULL) {
+		psub = (subscriber *) calloc(1, sizeof(subscriber));
+		if (psub == NULL) {
+			req_reject(PBSE_SYSTEM, 0, preq);
+			return;
+		}
+		CLEAR_LINK(psub->sb_link);
+		psub->sb_sock = preq->rq_conn;
+		append_link(&subscribers, &psub->sb_link, psub);
+		net_add_close_func(preq->rq_conn, subscriber_close);
+	}
+	psub->sb_flags |= flag;
+	if (flag == SUB_JOBS)
+		pbs_strncpy(psub->sb_owner, prq->rq_filter, sizeof(psub->sb_owner));
+
+	reply_ack(preq);
+}
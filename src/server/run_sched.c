@@ -48,6 +48,7 @@ extern struct server server;
 extern char server_name[];
 extern char *msg_sched_called;
 extern pbs_list_head svr_deferred_req;
+extern time_t time_now;
 
 int scheduler_jobs_stat = 0; /* set to 1 once scheduler queried jobs in a cycle*/
 extern int svr_unsent_qrun_req;
@@ -101,8 +102,13 @@ send_sched_cmd(pbs_sched *sched, int cmd, char *jobid)
 		goto err;
 
 	log_eventf(PBSEVENT_SCHED, PBS_EVENTCLASS_SERVER, LOG_INFO, server_name, msg_sched_called, cmd);
+	if (sched->sc_triggers > 1)
+		log_eventf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_SCHED, LOG_DEBUG, sched->sc_name,
+			   "%d scheduling triggers coalesced into one cycle", sched->sc_triggers);
 
 	sched->sc_cycle_started = 1;
+	sched->sc_cycle_start = time_now;
+	sched->sc_triggers = 0;
 
 	return 1;
 
@@ -256,6 +262,7 @@ recv_sched_cycle_end(int sock)
 	DIS_tcp_funcs();
 	(void) disrsi(sock, &rc); /* read end cycle marker and ignore as we don't need its value */
 	psched->sc_cycle_started = 0;
+	psched->sc_cycle_end = time_now;
 
 	if (rc != 0)
 		state = SC_DOWN;
@@ -510,13 +517,51 @@ set_scheduler_flag(int flag, pbs_sched *psched)
 				return; /* keep only SCH_QUIT */
 
 			psched->svr_do_sched_high = flag;
-		} else
+		} else {
 			psched->svr_do_schedule = flag;
+			psched->sc_triggers++;
+		}
 		if (single_sched)
 			break;
 	}
 }
 
+/**
+ * @brief
+ * 	find the earliest time the next ordinary cycle may be started at.
+ *	Triggers which come in before then (job submits, job ends, ...) are
+ *	coalesced into that cycle.  The scheduler waits for as long as its last
+ *	cycle took, but no longer than its min_cycle_interval: short cycles are
+ *	cheap to repeat while long ones are worth batching more triggers into.
+ *
+ * @param[in]	psched	-	the scheduler
+ *
+ * @return	time_t
+ * @retval	time the next cycle may be started at
+ * @retval	0 if it may be started now
+ */
+time_t
+sched_cycle_allowed_at(pbs_sched *psched)
+{
+	long gap;
+	time_t len;
+
+	if (psched == NULL || psched->sc_cycle_end == 0)
+		return 0;
+
+	if (!is_sched_attr_set(psched, SCHED_ATR_min_cycle_interval) ||
+	    (gap = get_sched_attr_long(psched, SCHED_ATR_min_cycle_interval)) <= 0)
+		return 0;
+
+	len = psched->sc_cycle_end - psched->sc_cycle_start;
+	if (len > gap)
+		len = gap;
+	if (len <= 0)
+		return 0;
+
+	return psched->sc_cycle_end + len;
+}
+
 /**
  * @brief
  * 	Handles deferred requests during scheduling cycle closure
@@ -97,14 +97,20 @@ extern time_t time_now;
  * @note
  *	If an attribute has the ATR_DFLAG_HIDDEN flag set, then no
  *	need to obtain and cache new svrattrl values.
+ *
+ * @note
+ *	Resources are often updated in place without touching their parent
+ *	attribute, so a resource type attribute is also out of date if any
+ *	of its resources was modified since it was cached.
  */
 
-static void
+void
 svrcached(attribute *pat, pbs_list_head *phead, attribute_def *pdef)
 {
 	svrattrl *working = NULL;
 	svrattrl *wcopy;
 	svrattrl *encoded;
+	resource *presc;
 
 	if (pdef == NULL)
 		return;
@@ -113,6 +119,14 @@ svrcached(attribute *pat, pbs_list_head *phead, attribute_def *pdef)
 	    (get_sattr_long(SVR_ATR_show_hidden_attribs) == 0)) {
 		return;
 	}
+	if (pat->at_type == ATR_TYPE_RESC && is_attr_set(pat)) {
+		for (presc = (resource *) GET_NEXT(pat->at_val.at_list); presc; presc = (resource *) GET_NEXT(presc->rs_link)) {
+			if (presc->rs_value.at_flags & ATR_VFLAG_MODCACHE) {
+				presc->rs_value.at_flags &= ~ATR_VFLAG_MODCACHE;
+				pat->at_flags |= ATR_VFLAG_MODCACHE;
+			}
+		}
+	}
 	if (pat->at_flags & ATR_VFLAG_MODCACHE) {
 		/* free old cache value if the value has changed */
 		free_svrcache(pat);
@@ -311,6 +325,15 @@ status_job(job *pjob, struct batch_request *preq, svrattrl *pal, pbs_list_head *
 	if (status_attrib(pal, job_attr_idx, job_attr_def, pjob->ji_wattr, JOB_ATR_LAST, preq->rq_perm, &pstat->brp_attr, bad))
 		return (PBSE_NOATTR);
 
+	/*
+	 * History jobs are rarely queried twice, so do not keep the encodings
+	 * cached on them; the reply holds its own reference.
+	 */
+	if (check_job_state(pjob, JOB_STATE_LTR_FINISHED) ||
+	    check_job_state(pjob, JOB_STATE_LTR_MOVED) ||
+	    check_job_state(pjob, JOB_STATE_LTR_EXPIRED))
+		job_compact_hist(pjob);
+
 	/* reset eligible time, it was calctd on the fly, real calctn only when accrue_type changes */
 
 	if (get_sattr_long(SVR_ATR_EligibleTimeEnable) != 0) {
@@ -0,0 +1,250 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file	status_snapshot.c
+ *
+ * @brief
+ * 		Periodically publish the status of the server, queues, nodes and
+ * 		jobs to files under server_priv so that local read-mostly clients
+ * 		can read them without sending a status request to the server.
+ *
+ * 	Each snapshot file holds a small header (format version and the time
+ * 	the snapshot was taken) followed by the ordinary DIS encoded status
+ * 	reply, exactly as it would be sent over a connection. The files are
+ * 	written by a forked child, so the server does not block on encoding,
+ * 	and each one is renamed into place so a reader never sees a partial
+ * 	snapshot.
+ *
+ * Functions included are:
+ * 	status_snapshot()
+ *
+ */
+#include <pbs_config.h> /* the master config generated by configure */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include "libpbs.h"
+#include "dis.h"
+#include "list_link.h"
+#include "attribute.h"
+#include "server_limits.h"
+#include "server.h"
+#include "batch_request.h"
+#include "work_task.h"
+#include "svrfunc.h"
+#include "log.h"
+#include "tpp.h"
+#include "net_connect.h"
+#include "pbs_internal.h"
+
+extern char *path_priv;
+extern char *msg_err_malloc;
+extern time_t time_now;
+
+static pid_t snapshot_pid = 0; /* pid of the child writing snapshots, 0 if none */
+
+/**
+ * @brief
+ * 		write_snapshot - write the status of one kind of object to its
+ * 		snapshot file.
+ *
+ * @param[in]	suffix	- suffix of the snapshot file name
+ * @param[in]	rq_type	- status request type to run
+ * @param[in]	func	- status request handler
+ *
+ * @return	int
+ * @retval	0	- success
+ * @retval	-1	- failure, the previous snapshot is left in place
+ */
+static int
+write_snapshot(char *suffix, int rq_type, void (*func)(struct batch_request *))
+{
+	char path[MAXPATHLEN + 1];
+	char newpath[MAXPATHLEN + 1];
+	struct batch_request *preq;
+	int fd;
+	int rc;
+
+	if ((snprintf(path, sizeof(path), "%s/%s%s", path_priv, PBS_SNAPSHOT_PREFIX, suffix) >= (int) sizeof(path)) ||
+	    (snprintf(newpath, sizeof(newpath), "%s.new", path) >= (int) sizeof(newpath))) {
+		log_err(ENAMETOOLONG, __func__, path);
+		return (-1);
+	}
+
+	fd = open(newpath, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	if (fd == -1) {
+		log_err(errno, __func__, newpath);
+		return (-1);
+	}
+
+	DIS_tcp_funcs();
+	rc = diswui(fd, PBS_SNAPSHOT_VERSION);
+	if (rc == DIS_SUCCESS)
+		rc = diswul(fd, (unsigned long) time_now);
+	if (rc == DIS_SUCCESS)
+		rc = dis_flush(fd);
+	if (rc != DIS_SUCCESS)
+		goto err;
+
+	preq = alloc_br(rq_type);
+	if (preq == NULL)
+		goto err;
+	preq->rq_conn = fd;
+	preq->rq_fromsvr = 1;
+	preq->rq_perm = ATR_DFLAG_MGRD | ATR_DFLAG_MGWR | ATR_DFLAG_OPRD | ATR_DFLAG_OPWR;
+	pbs_strncpy(preq->rq_user, pbs_current_user, sizeof(preq->rq_user));
+	pbs_strncpy(preq->rq_host, server_host, sizeof(preq->rq_host));
+	CLEAR_HEAD(preq->rq_ind.rq_status.rq_attr);
+	preq->rq_ind.rq_status.rq_id = strdup("");
+	if (preq->rq_ind.rq_status.rq_id == NULL) {
+		free_br(preq);
+		goto err;
+	}
+
+	/* the handler sends the reply to fd and frees the request */
+	pbs_tcp_errno = 0;
+	func(preq);
+	dis_destroy_chan(fd);
+	destroy_connection(fd);
+	if (pbs_tcp_errno != 0 || fsync(fd) == -1) {
+		log_err(pbs_tcp_errno ? pbs_tcp_errno : errno, __func__, newpath);
+		(void) close(fd);
+		(void) unlink(newpath);
+		return (-1);
+	}
+	if (close(fd) == -1 || rename(newpath, path) == -1) {
+		log_err(errno, __func__, path);
+		(void) unlink(newpath);
+		return (-1);
+	}
+	return (0);
+
+err:
+	log_err(-1, __func__, newpath);
+	dis_destroy_chan(fd);
+	destroy_connection(fd);
+	(void) close(fd);
+	(void) unlink(newpath);
+	return (-1);
+}
+
+/**
+ * @brief
+ * 		post_status_snapshot - called when the child writing the snapshots
+ * 		has exited.
+ *
+ * @param[in]	ptask	- work task of the child
+ *
+ * @return	void
+ */
+static void
+post_status_snapshot(struct work_task *ptask)
+{
+	if (ptask->wt_aux != 0)
+		log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_SERVER, LOG_NOTICE, __func__,
+			   "status snapshot child exited with status %d", ptask->wt_aux);
+	snapshot_pid = 0;
+}
+
+/**
+ * @brief
+ * 		status_snapshot - work task to refresh the status snapshot files,
+ * 		re-arms itself every PBS_STATUS_SNAPSHOT seconds.
+ *
+ * @par
+ * 		The snapshots are written by a forked child working on a copy of
+ * 		the server's memory. If the previous child is still running the
+ * 		refresh is skipped rather than stacking up children.
+ *
+ * @param[in]	ptask	- work task, unused
+ *
+ * @return	void
+ */
+void
+status_snapshot(struct work_task *ptask)
+{
+	pid_t pid;
+	int ret = 0;
+
+	if (pbs_conf.pbs_status_snapshot == 0)
+		return;
+
+	(void) set_task(WORK_Timed, time_now + pbs_conf.pbs_status_snapshot,
+			status_snapshot, NULL);
+
+	if (snapshot_pid != 0)
+		return;
+
+	pid = fork();
+	if (pid == -1) {
+		log_err(errno, __func__, "fork failed");
+		return;
+	}
+
+	if (pid != 0) { /* The parent (main server) */
+		if (set_task(WORK_Deferred_Child, (long) pid, post_status_snapshot, NULL) == NULL) {
+			log_err(errno, __func__, msg_err_malloc);
+			return;
+		}
+		snapshot_pid = pid;
+		return;
+	}
+
+	/* Close all server connections */
+	net_close(-1);
+	tpp_terminate();
+	/* Unprotect child from being killed by kernel */
+	daemon_protect(0, PBS_DAEMON_PROTECT_OFF);
+
+	if (write_snapshot("server", PBS_BATCH_StatusSvr, req_stat_svr) != 0)
+		ret = 1;
+	if (write_snapshot("queue", PBS_BATCH_StatusQue, req_stat_que) != 0)
+		ret = 1;
+	if (write_snapshot("node", PBS_BATCH_StatusNode, req_stat_node) != 0)
+		ret = 1;
+	if (write_snapshot("job", PBS_BATCH_StatusJob, req_stat_job) != 0)
+		ret = 1;
+	exit(ret);
+}
@@ -129,6 +129,8 @@ extern void set_srv_prov_attributes();
 static void del_prov_vnode_entry(job *);
 extern int resize_prov_table(int);
 static void prov_startjob(struct work_task *ptask);
+static void prov_track_save_later(void);
+static struct work_task *prov_track_save_task = NULL; /* pending coalesced save */
 extern enum failover_state are_we_primary(void);
 
 /*
@@ -1858,29 +1860,21 @@ extern char statechars[];
 static int
 check_single_entity_ct(enum lim_keytypes kt, char *ename, attribute *patr, int subjobs, job *pjob)
 {
-	char *kstr;
+	entlim_key_t key;
 	void *ctx;
-	svr_entlim_leaf_t *plf;
+	svr_entlim_leaf_t *plf = NULL;
 	int count = subjobs;
 
-	kstr = entlim_mk_runkey(kt, ename);
-	if (kstr == NULL) {
-		log_event(PBSEVENT_ADMIN, PBS_EVENTCLASS_SERVER,
-			  LOG_ALERT, msg_daemonname,
-			  "rejecting job,  unable to make entity limit key, no memory");
-		ET_LIM_DBG("exiting, ret %d [kstr is NULL]", __func__, LIM_OVERALL)
-		return LIM_OVERALL;
-	}
-	ET_LIM_DBG("kstr %s, %d", __func__, kstr, subjobs)
+	ET_LIM_DBG("kt %d, entity %s, %d", __func__, kt, ename, subjobs)
 	ctx = patr->at_val.at_enty.ae_tree;
-	plf = (svr_entlim_leaf_t *) entlim_get(kstr, ctx);
+	if (entlim_mk_key(&key, kt, ename, NULL) == 0)
+		plf = (svr_entlim_leaf_t *) entlim_get_key(&key, ctx);
 
 	if (plf) {
 		count += plf->slf_sum.at_val.at_long;
-		ET_LIM_DBG("ct usage for %s is %ld", __func__, kstr, plf->slf_sum.at_val.at_long)
-		ET_LIM_DBG("ct specific limit for %s is %ld", __func__, kstr, plf->slf_limit.at_val.at_long)
+		ET_LIM_DBG("ct usage for %s is %ld", __func__, ename, plf->slf_sum.at_val.at_long)
+		ET_LIM_DBG("ct specific limit for %s is %ld", __func__, ename, plf->slf_limit.at_val.at_long)
 	}
-	free(kstr);
 
 	ET_LIM_DBG("count is %d", __func__, count)
 	if (plf && (is_attr_set(&plf->slf_limit))) {
@@ -1893,15 +1887,13 @@ check_single_entity_ct(enum lim_keytypes kt, char *ename, attribute *patr, int s
 		}
 	} else if (kt != LIM_OVERALL) {
 		/* compare against generic limit if one */
-		kstr = entlim_mk_runkey(kt, PBS_GENERIC_ENTITY);
-		if (kstr == NULL) {
+		if (entlim_mk_key(&key, kt, PBS_GENERIC_ENTITY, NULL) != 0) {
 			ET_LIM_DBG("exiting, ret No_Limit [generic limit]", __func__)
 			return No_Limit;
 		}
-		plf = (svr_entlim_leaf_t *) entlim_get(kstr, ctx);
+		plf = (svr_entlim_leaf_t *) entlim_get_key(&key, ctx);
 		if (plf && (is_attr_set(&plf->slf_limit))) {
-			ET_LIM_DBG("ct generic limit for %s is %ld", __func__, kstr, plf->slf_limit.at_val.at_long)
-			free(kstr);
+			ET_LIM_DBG("ct generic limit for %s is %ld", __func__, ename, plf->slf_limit.at_val.at_long)
 			if (count > plf->slf_limit.at_val.at_long) {
 				ET_LIM_DBG("exiting, ret Exceeds_Generic [generic limit]", __func__)
 				return Exceeds_Generic;
@@ -1910,7 +1902,6 @@ check_single_entity_ct(enum lim_keytypes kt, char *ename, attribute *patr, int s
 				return Within_Limit;
 			}
 		}
-		free(kstr);
 	}
 	ET_LIM_DBG("exiting, ret No_Limit [all ok]", __func__)
 	return No_Limit;
@@ -1941,24 +1932,18 @@ check_single_entity_res(enum lim_keytypes kt, char *ename,
 			int subjobs,
 			job *pjob)
 {
-	char *kstr;
+	char *rescn = newr->rs_defin->rs_name;
+	entlim_key_t key;
 	void *ctx;
-	svr_entlim_leaf_t *plf;
+	svr_entlim_leaf_t *plf = NULL;
 	int rc;
 	int i;
 	attribute tmpval = {0};
 
-	kstr = entlim_mk_reskey(kt, ename, newr->rs_defin->rs_name);
-	if (kstr == NULL) {
-		log_event(PBSEVENT_ADMIN, PBS_EVENTCLASS_SERVER,
-			  LOG_ALERT, msg_daemonname,
-			  "rejecting job,  unable to make entity limit key, no memory");
-		ET_LIM_DBG("exiting, ret %d [kstr is NULL]", __func__, LIM_OVERALL)
-		return LIM_OVERALL;
-	}
-	ET_LIM_DBG("kstr %s, %d, oldr %p", __func__, kstr, subjobs, oldr)
+	ET_LIM_DBG("kt %d, entity %s, res %s, %d, oldr %p", __func__, kt, ename, rescn, subjobs, oldr)
 	ctx = patr->at_val.at_enty.ae_tree;
-	plf = (svr_entlim_leaf_t *) entlim_get(kstr, ctx);
+	if (entlim_mk_key(&key, kt, ename, rescn) == 0)
+		plf = (svr_entlim_leaf_t *) entlim_get_key(&key, ctx);
 
 	if (plf) {
 		tmpval = plf->slf_sum;
@@ -1981,13 +1966,12 @@ check_single_entity_res(enum lim_keytypes kt, char *ename,
 				limit_val = limit->al_value;
 			} else
 				limit_val = "(not_set)";
-			ET_LIM_DBG("res usage for %s is %s", __func__, kstr, sum_val)
-			ET_LIM_DBG("res specific limit for %s is %s", __func__, kstr, limit_val)
+			ET_LIM_DBG("res usage for %s;%s is %s", __func__, ename, rescn, sum_val)
+			ET_LIM_DBG("res specific limit for %s;%s is %s", __func__, ename, rescn, limit_val)
 			free(sum);
 			free(limit);
 		}
 	}
-	free(kstr);
 	if (plf && (is_attr_set(&plf->slf_limit))) {
 		/* check the specific user's limit */
 		rc = plf->slf_rescd->rs_comp(&tmpval, &plf->slf_limit);
@@ -1999,12 +1983,11 @@ check_single_entity_res(enum lim_keytypes kt, char *ename,
 		return Within_Limit;
 	} else if (kt != LIM_OVERALL) {
 		/* check against the generic limit if one */
-		kstr = entlim_mk_reskey(kt, PBS_GENERIC_ENTITY, newr->rs_defin->rs_name);
-		if (kstr == NULL) {
+		if (entlim_mk_key(&key, kt, PBS_GENERIC_ENTITY, rescn) != 0) {
 			ET_LIM_DBG("exiting, ret No_Limit [generic limit]", __func__)
 			return No_Limit;
 		}
-		plf = (svr_entlim_leaf_t *) entlim_get(kstr, ctx);
+		plf = (svr_entlim_leaf_t *) entlim_get_key(&key, ctx);
 		if (plf && (is_attr_set(&plf->slf_limit))) {
 			if (!(is_attr_set(&tmpval))) { /* for no recorded usage for entity */
 				plf->slf_rescd->rs_set(&tmpval, &newr->rs_value, SET);
@@ -2014,13 +1997,12 @@ check_single_entity_res(enum lim_keytypes kt, char *ename,
 				if (will_log_event(PBSEVENT_DEBUG4) && (is_attr_set(&tmpval))) {
 					svrattrl *count;
 					plf->slf_rescd->rs_encode(&tmpval, NULL, "tmpval", NULL, ATR_ENCODE_CLIENT, &count);
-					ET_LIM_DBG("res generic limit for %s is %s", __func__, kstr, count->al_value)
+					ET_LIM_DBG("res generic limit for %s;%s is %s", __func__, ename, rescn, count->al_value)
 					free(count);
 				} else
-					ET_LIM_DBG("res generic limit for %s is (not_set)", __func__, kstr)
+					ET_LIM_DBG("res generic limit for %s;%s is (not_set)", __func__, ename, rescn)
 			}
 			rc = plf->slf_rescd->rs_comp(&tmpval, &plf->slf_limit);
-			free(kstr);
 			if (rc > 0) {
 				ET_LIM_DBG("exiting, ret Exceeds_Generic, rc=%d [generic limit]", __func__, rc)
 				return Exceeds_Generic;
@@ -2028,7 +2010,6 @@ check_single_entity_res(enum lim_keytypes kt, char *ename,
 			ET_LIM_DBG("exiting, ret Within_Limit, rc=%d [generic limit]", __func__, rc)
 			return Within_Limit;
 		}
-		free(kstr);
 	}
 	ET_LIM_DBG("exiting, ret No_Limit [all ok]", __func__)
 	return No_Limit;
@@ -2928,21 +2909,23 @@ static int
 set_single_entity_ct(enum lim_keytypes kt, char *ename, attribute *patr, job *pjob, int subjobs, enum batch_op op)
 {
 	char *kstr;
+	entlim_key_t key;
 	void *ctx;
-	svr_entlim_leaf_t *plf;
+	svr_entlim_leaf_t *plf = NULL;
 	int rc;
 
-	kstr = entlim_mk_runkey(kt, ename);
-	if (kstr == NULL) {
-		ET_LIM_DBG("exiting, ret %d [kstr is NULL]", __func__, PBSE_SYSTEM)
-		return (PBSE_SYSTEM);
-	}
-	ET_LIM_DBG("kstr %s, %d, %s", __func__, kstr, subjobs, (op == INCR) ? "INCR" : "DECR")
+	ET_LIM_DBG("kt %d, entity %s, %d, %s", __func__, kt, ename, subjobs, (op == INCR) ? "INCR" : "DECR")
 	ctx = patr->at_val.at_enty.ae_tree;
-	plf = (svr_entlim_leaf_t *) entlim_get(kstr, ctx);
+	if (entlim_mk_key(&key, kt, ename, NULL) == 0)
+		plf = (svr_entlim_leaf_t *) entlim_get_key(&key, ctx);
 	if (op == INCR) {
 		if (plf == NULL) {
 			/* add leaf for this entity-limit */
+			kstr = entlim_mk_runkey(kt, ename);
+			if (kstr == NULL) {
+				ET_LIM_DBG("exiting, ret %d [kstr is NULL]", __func__, PBSE_SYSTEM)
+				return (PBSE_SYSTEM);
+			}
 			if ((rc = alloc_svrleaf(NULL, &plf)) != PBSE_NONE) {
 				free(kstr);
 				ET_LIM_DBG("exiting, ret %d [alloc_svrleaf failed]", __func__, rc)
@@ -2954,13 +2937,13 @@ set_single_entity_ct(enum lim_keytypes kt, char *ename, attribute *patr, job *pj
 				ET_LIM_DBG("exiting, ret %d [entlim_add failed]", __func__, PBSE_SYSTEM)
 				return (PBSE_SYSTEM);
 			}
+			free(kstr);
 		}
 		plf->slf_sum.at_val.at_long += subjobs;
 		mark_attr_set(&plf->slf_sum);
 		ET_LIM_DBG("usage INCR to %ld, by %d", __func__, plf->slf_sum.at_val.at_long, subjobs)
 	} else {
 		if (plf == NULL) {
-			free(kstr);
 			/* Do not decrement what isn't there */
 			ET_LIM_DBG("exiting, ret %d [plf is NULL]", __func__, PBSE_INTERNAL)
 			return (PBSE_INTERNAL);
@@ -2972,11 +2955,10 @@ set_single_entity_ct(enum lim_keytypes kt, char *ename, attribute *patr, job *pj
 		if (plf->slf_sum.at_val.at_long < 0L) {
 			ET_LIM_DBG("zeroing usage, was %ld, by %d", __func__, plf->slf_sum.at_val.at_long, subjobs)
 			plf->slf_sum.at_val.at_long = 0L;
-			snprintf(log_buffer, LOG_BUF_SIZE - 1, "set_single_entity_ct zeroing negative usage for %s", kstr);
+			snprintf(log_buffer, LOG_BUF_SIZE - 1, "set_single_entity_ct zeroing negative usage for %s", ename);
 			log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_SERVER, LOG_WARNING, msg_daemonname, log_buffer);
 		}
 	}
-	free(kstr);
 	ET_LIM_DBG("exiting, ret 0 [all ok]", __func__)
 	return PBSE_NONE;
 }
@@ -3007,27 +2989,21 @@ set_single_entity_res(enum lim_keytypes kt, char *ename,
 {
 	char *rescn = newval->rs_defin->rs_name;
 	char *kstr;
+	entlim_key_t key;
 	void *ctx;
-	svr_entlim_leaf_t *plf;
+	svr_entlim_leaf_t *plf = NULL;
 	int rc;
 	int i;
 	attribute tmpval = newval->rs_value;
 
-	kstr = entlim_mk_reskey(kt, ename, rescn);
-	if (kstr == NULL) {
-		snprintf(log_buffer, LOG_BUF_SIZE - 1, "Error in entlim_mk_reskey for rescn %s", rescn);
-		log_err(-1, __func__, log_buffer);
-		ET_LIM_DBG("exiting, ret %d [kstr is NULL]", __func__, PBSE_SYSTEM)
-		return (PBSE_SYSTEM);
-	}
-	ET_LIM_DBG("kstr %s, %d, %s, res %s, %p", __func__, kstr,
+	ET_LIM_DBG("kt %d, entity %s, %d, %s, res %s, %p", __func__, kt, ename,
 		   subjobs, (op == INCR) ? "INCR" : "DECR", rescn, oldval)
 	ctx = patr->at_val.at_enty.ae_tree;
-	plf = (svr_entlim_leaf_t *) entlim_get(kstr, ctx);
+	if (entlim_mk_key(&key, kt, ename, rescn) == 0)
+		plf = (svr_entlim_leaf_t *) entlim_get_key(&key, ctx);
 
 	if (oldval && plf) {
 		if (!(plf->slf_rescd->rs_comp(&tmpval, &oldval->rs_value))) {
-			free(kstr);
 			ET_LIM_DBG("exiting, ret 0 [newval == oldval]", __func__)
 			return PBSE_NONE;
 		}
@@ -3063,6 +3039,13 @@ set_single_entity_res(enum lim_keytypes kt, char *ename,
 		/* increment resource by newval, subtracting oldval if there */
 		if (plf == NULL) {
 			/* add leaf for this entity-limit */
+			kstr = entlim_mk_reskey(kt, ename, rescn);
+			if (kstr == NULL) {
+				snprintf(log_buffer, LOG_BUF_SIZE - 1, "Error in entlim_mk_reskey for rescn %s", rescn);
+				log_err(-1, __func__, log_buffer);
+				ET_LIM_DBG("exiting, ret %d [kstr is NULL]", __func__, PBSE_SYSTEM)
+				return (PBSE_SYSTEM);
+			}
 			if ((rc = alloc_svrleaf(rescn, &plf)) != PBSE_NONE) {
 				free(kstr);
 				ET_LIM_DBG("exiting, ret %d [alloc_svrleaf failed]", __func__, rc)
@@ -3076,6 +3059,7 @@ set_single_entity_res(enum lim_keytypes kt, char *ename,
 				ET_LIM_DBG("exiting, ret %d [entlim_add failed]", __func__, PBSE_SYSTEM)
 				return (PBSE_SYSTEM);
 			}
+			free(kstr);
 		}
 
 		for (i = 0; i < subjobs; i++) {
@@ -3096,9 +3080,8 @@ set_single_entity_res(enum lim_keytypes kt, char *ename,
 		/* decrement resource by newval, adding oldval if there */
 		if (plf == NULL) {
 			/* Do not decrement what isn't there */
-			snprintf(log_buffer, LOG_BUF_SIZE - 1, "decrementing resource for reskey %s: isn't found in attribute tree", kstr);
+			snprintf(log_buffer, LOG_BUF_SIZE - 1, "decrementing resource %s for entity %s: isn't found in attribute tree", rescn, ename);
 			log_err(-1, __func__, log_buffer);
-			free(kstr);
 			ET_LIM_DBG("exiting, ret %d [plf is NULL]", __func__, PBSE_INTERNAL)
 			return (PBSE_INTERNAL);
 		}
@@ -3120,12 +3103,11 @@ set_single_entity_res(enum lim_keytypes kt, char *ename,
 		if (plf->slf_rescd->rs_comp(&plf->slf_sum, &tmpval) < 0) {
 			ET_LIM_DBG("zeroing res usage", __func__)
 			plf->slf_sum = tmpval;
-			snprintf(log_buffer, LOG_BUF_SIZE - 1, "set_single_entity_res zeroing negative usage for %s-%s", plf->slf_rescd->rs_name, kstr);
+			snprintf(log_buffer, LOG_BUF_SIZE - 1, "set_single_entity_res zeroing negative usage for %s-%s", plf->slf_rescd->rs_name, ename);
 			log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_SERVER, LOG_WARNING, msg_daemonname, log_buffer);
 		}
 	}
 
-	free(kstr);
 	ET_LIM_DBG("exiting, ret 0 [all ok]", __func__)
 	return PBSE_NONE;
 }
@@ -4119,6 +4101,45 @@ prov_track_save()
 	server.sv_provtrackmodifed = 0;
 }
 
+/**
+ * @brief
+ *		Work task for prov_track_save_later().
+ *
+ * @param[in]	ptask	-	pointer to work_task
+ *
+ * @return	void
+ */
+static void
+prov_track_save_timed(struct work_task *ptask)
+{
+	prov_track_save_task = NULL;
+	prov_track_save();
+}
+
+/**
+ * @brief
+ *		Save the provisioning records within a second.
+ *
+ * @par Functionality:
+ *      Used when records are removed as vnodes finish provisioning, so that a
+ *		large provisioning batch rewrites the tracking file about once a second
+ *		and not once per vnode.  A removal that is lost in a crash only makes
+ *		the restarted server offline a vnode that had finished provisioning.
+ *		New records are still saved right away by do_provisioning().
+ *
+ * @return	void
+ */
+static void
+prov_track_save_later(void)
+{
+	if (prov_track_save_task != NULL)
+		return;
+	prov_track_save_task = set_task(WORK_Timed, time_now + 1,
+					prov_track_save_timed, NULL);
+	if (prov_track_save_task == NULL)
+		prov_track_save();
+}
+
 /**
  * @brief
  *		Looks up a provisioning vnode record by a vnode name.
@@ -4750,6 +4771,7 @@ is_runnable(job *ptr, struct prov_vnode_info *pvnfo)
 	job *pjob;
 	char *aoe_req = NULL;
 	char *current_aoe;
+	int start;
 
 	if (!ptr) {
 		DBPRT(("%s: ptr is NULL\n", __func__))
@@ -4780,7 +4802,17 @@ is_runnable(job *ptr, struct prov_vnode_info *pvnfo)
 		goto label1;
 	}
 
-	for (i = 0; i < num_of_prov_vnodes; i++) {
+	/*
+	 * Every vnode of a job calls here as it finishes provisioning.  Resume
+	 * the scan where the last call found a vnode still provisioning instead
+	 * of walking the whole list each time; once the end is reached the
+	 * earlier vnodes are checked again, since they may have gone offline.
+	 */
+	start = pjob->ji_prov_done_idx;
+	if (start < 0 || start >= num_of_prov_vnodes)
+		start = 0;
+rescan:
+	for (i = start; i < num_of_prov_vnodes; i++) {
 
 		np = find_nodebyname(prov_vnode_list[i]);
 		if (np == NULL) {
@@ -4804,6 +4836,7 @@ is_runnable(job *ptr, struct prov_vnode_info *pvnfo)
 			   (np->nd_state & INUSE_WAIT_PROV)) {
 			/* Check any vnode is provisioning */
 			eflag = -1;
+			pjob->ji_prov_done_idx = i;
 			DBPRT(("%s: Some nodes still provisioning\n", __func__))
 			break;
 		} else {
@@ -4821,6 +4854,10 @@ is_runnable(job *ptr, struct prov_vnode_info *pvnfo)
 			}
 		}
 	}
+	if (eflag == 0 && start > 0) {
+		start = 0;
+		goto rescan;
+	}
 label1:
 
 	if (num_of_prov_vnodes > 0)
@@ -5295,7 +5332,7 @@ is_vnode_prov_done(char *vnode)
 
 	/* Remove record from prov tracking table */
 	remove_prov_record(pnode->nd_name);
-	prov_track_save(); /* save tracking table since its modified now */
+	prov_track_save_later();
 
 	free_pvnfo(prov_vnode_info);
 
@@ -5570,7 +5607,7 @@ prov_request_deferred(struct work_task *wtask)
 
 	/* Remove record from prov tracking table */
 	remove_prov_record(pnode->nd_name);
-	prov_track_save(); /* save tracking table since its modified now */
+	prov_track_save_later();
 
 	/* Any other exit code */
 	/* Failure, move all jobs to be run_err
@@ -5666,7 +5703,7 @@ prov_request_timed(struct work_task *wtask)
 
 	/* remove prov record */
 	remove_prov_record(prov_vnode_info->pvnfo_vnode);
-	prov_track_save();
+	prov_track_save_later();
 
 	/* Move jobs on this node to the failed state */
 	fail_vnode(prov_vnode_info, 1);
@@ -5901,6 +5938,7 @@ execute_python_prov_script(hook *phook,
  *		check_and_enqueue_provisioning
  *
  * @param[in]	prov_vnode_info	-	pointer to prov_vnode_info entry in server
+ * @param[in]	phook	-	compiled provisioning hook, NULL if there is none
  *
  * @return	int
  * @retval	PBSE_NONE	: success if provisioning started for a vnode
@@ -5914,7 +5952,7 @@ execute_python_prov_script(hook *phook,
  */
 
 static int
-start_vnode_provisioning(struct prov_vnode_info *prov_vnode_info)
+start_vnode_provisioning(struct prov_vnode_info *prov_vnode_info, hook *phook)
 {
 	prov_pid pid;
 	struct work_task *ptask_defer;
@@ -5923,7 +5961,6 @@ start_vnode_provisioning(struct prov_vnode_info *prov_vnode_info)
 	job *pjob;
 	int rc = -1;
 	struct sigaction act;
-	hook *phook;
 
 	DBPRT(("%s: Provisioning vnode: %s with aoe: %s\n", __func__,
 	       prov_vnode_info->pvnfo_vnode, prov_vnode_info->pvnfo_aoe_req))
@@ -5935,21 +5972,8 @@ start_vnode_provisioning(struct prov_vnode_info *prov_vnode_info)
 		return (PBSE_SYSTEM);
 	}
 
-	phook = find_hookbyevent(HOOK_EVENT_PROVISION);
-	if (!phook) {
-		DBPRT(("%s: Provisioning hook not found\n", __func__))
-		log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, LOG_INFO,
-			  msg_daemonname, "Provisioning hook not found");
+	if (!phook)
 		return rc;
-	}
-
-	if ((rc = pbs_python_check_and_compile_script(&svr_interp_data,
-						      phook->script)) != 0) {
-		DBPRT(("%s: Recompilation failed\n", __func__))
-		log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_SERVER, LOG_INFO,
-			  msg_daemonname, "Provisioning script recompilation failed");
-		return rc;
-	}
 
 	/* Create child process to run TOP-LEVEL provisioning script */
 	pid = fork();
@@ -6112,6 +6136,7 @@ check_and_enqueue_provisioning(job *pjob, int *need_prov)
 	}
 
 	*need_prov = 0;
+	pjob->ji_prov_done_idx = 0;
 
 	/* prov_vnode_list is of type exec_vnode_listtype.
 	 * This is an array of "pointers to arrays[PBS_MAXCLTJOBID]"
@@ -6246,9 +6271,30 @@ do_provisioning(struct work_task *wtask)
 	struct prov_vnode_info *prov_vnode_info;
 	struct pbsnode *pnode;
 	int rc;
+	hook *phook = NULL;
 
 	prov_vnode_info = GET_NEXT(prov_allvnodes);
 
+	/*
+	 * Look up and compile the hook once for every vnode started in
+	 * this pass; a large job queues many vnodes with the same AOE.
+	 */
+	if (prov_vnode_info &&
+	    (server.sv_cur_prov_records < max_concurrent_prov)) {
+		phook = find_hookbyevent(HOOK_EVENT_PROVISION);
+		if (!phook) {
+			DBPRT(("%s: Provisioning hook not found\n", __func__))
+			log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, LOG_INFO,
+				  msg_daemonname, "Provisioning hook not found");
+		} else if (pbs_python_check_and_compile_script(&svr_interp_data,
+							       phook->script) != 0) {
+			DBPRT(("%s: Recompilation failed\n", __func__))
+			log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_SERVER, LOG_INFO,
+				  msg_daemonname, "Provisioning script recompilation failed");
+			phook = NULL;
+		}
+	}
+
 	/*
 	 * check number of provisionings needed to be done,
 	 * should not cross max limit
@@ -6276,7 +6322,7 @@ do_provisioning(struct work_task *wtask)
 			continue;
 		}
 
-		rc = start_vnode_provisioning(prov_vnode_info);
+		rc = start_vnode_provisioning(prov_vnode_info, phook);
 
 		if (rc != 0) {
 			/* we want to fail jobs/resv but not the node */
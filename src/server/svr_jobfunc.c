@@ -90,6 +90,7 @@
 #include "libsec.h"
 #include "pbs_license.h"
 #include "pbs_reliable.h"
+#include "pbs_db.h"
 #include <sys/wait.h>
 
 #define MIN_WALLTIME_LIMIT 0
@@ -117,6 +118,7 @@ extern char *msg_mombadmodify;
 extern struct server server;
 extern int pbs_mom_port;
 extern pbs_list_head svr_alljobs;
+extern pbs_list_head svr_jobs_by_state[];
 extern char *msg_badwait; /* error message */
 extern char *msg_daemonname;
 extern char *msg_also_deleted_job_history;
@@ -143,6 +145,22 @@ extern void free_job_work_tasks(job *);
 
 /* Private Functions */
 
+static void link_jobstate(job *, int);
+static void hist_expiry_set(job *);
+static void hist_expiry_remove(job *);
+
+/*
+ * History jobs keyed on their history timestamp in a binary min-heap,
+ * so svr_clean_job_history only looks at those that may have expired
+ */
+struct hist_expiry {
+	long he_time; /* history timestamp, 0 if not yet known */
+	job *he_job;
+};
+static struct hist_expiry *hist_heap = NULL;
+static int hist_heap_ct = 0;
+static int hist_heap_sz = 0;
+
 #ifndef NDEBUG
 static void correct_ct(pbs_queue *);
 #endif /* NDEBUG */
@@ -168,6 +186,121 @@ clear_default_resc(job *pjob)
 	}
 }
 
+/**
+ * @brief
+ * 		link_jobstate - move the job onto the server list of jobs in
+ *		the given state; kept in step with server.sv_jobstates
+ *
+ * @param[in]	pjob	-	the job
+ * @param[in]	state_num	-	state index, -1 to just unlink the job
+ */
+static void
+link_jobstate(job *pjob, int state_num)
+{
+	delete_link(&pjob->ji_statelink);
+	if (state_num >= 0 && state_num < PBS_NUMJOBSTATE)
+		append_link(&svr_jobs_by_state[state_num], &pjob->ji_statelink, pjob);
+	if (state_num == JOB_STATE_MOVED || state_num == JOB_STATE_FINISHED || state_num == JOB_STATE_EXPIRED)
+		hist_expiry_set(pjob);
+	else
+		hist_expiry_remove(pjob);
+}
+
+/**
+ * @brief
+ * 		svr_unlink_jobstate - take the job out of the per state job
+ *		lists and the history expiry heap
+ *
+ * @param[in]	pjob	-	the job
+ */
+void
+svr_unlink_jobstate(job *pjob)
+{
+	link_jobstate(pjob, -1);
+}
+
+/**
+ * @brief
+ * 		hist_heap_sift - restore the heap order around one slot
+ *
+ * @param[in]	ix	-	slot whose key was changed
+ */
+static void
+hist_heap_sift(int ix)
+{
+	struct hist_expiry ent = hist_heap[ix];
+	int parent;
+	int child;
+
+	while (ix > 0 && hist_heap[parent = (ix - 1) / 2].he_time > ent.he_time) {
+		hist_heap[ix] = hist_heap[parent];
+		hist_heap[ix].he_job->ji_hist_ix = ix;
+		ix = parent;
+	}
+	while ((child = 2 * ix + 1) < hist_heap_ct) {
+		if (child + 1 < hist_heap_ct && hist_heap[child + 1].he_time < hist_heap[child].he_time)
+			child++;
+		if (hist_heap[child].he_time >= ent.he_time)
+			break;
+		hist_heap[ix] = hist_heap[child];
+		hist_heap[ix].he_job->ji_hist_ix = ix;
+		ix = child;
+	}
+	hist_heap[ix] = ent;
+	ent.he_job->ji_hist_ix = ix;
+}
+
+/**
+ * @brief
+ * 		hist_expiry_set - add a history job to the expiry heap, or re-key
+ *		it if already there, on its current history timestamp
+ *
+ * @param[in]	pjob	-	the job
+ */
+static void
+hist_expiry_set(job *pjob)
+{
+	int ix = pjob->ji_hist_ix;
+
+	if (ix < 0) {
+		if (hist_heap_ct == hist_heap_sz) {
+			int newsz = hist_heap_sz ? hist_heap_sz * 2 : 1024;
+			struct hist_expiry *tmp = realloc(hist_heap, newsz * sizeof(struct hist_expiry));
+
+			if (tmp == NULL) {
+				log_err(errno, __func__, "Unable to grow history expiry heap");
+				return;
+			}
+			hist_heap = tmp;
+			hist_heap_sz = newsz;
+		}
+		ix = hist_heap_ct++;
+	}
+	hist_heap[ix].he_time = is_jattr_set(pjob, JOB_ATR_history_timestamp) ? get_jattr_long(pjob, JOB_ATR_history_timestamp) : 0;
+	hist_heap[ix].he_job = pjob;
+	hist_heap_sift(ix);
+}
+
+/**
+ * @brief
+ * 		hist_expiry_remove - take a job out of the history expiry heap
+ *
+ * @param[in]	pjob	-	the job
+ */
+static void
+hist_expiry_remove(job *pjob)
+{
+	int ix = pjob->ji_hist_ix;
+
+	if (ix < 0)
+		return;
+	pjob->ji_hist_ix = -1;
+	if (--hist_heap_ct > ix) {
+		hist_heap[ix] = hist_heap[hist_heap_ct];
+		hist_heap_sift(ix);
+	}
+}
+
 /**
  * @brief
  * 		tickle_for_reply ()
@@ -238,6 +371,7 @@ svr_enquejob(job *pjob, char *selectspec)
 			server.sv_qs.sv_numjobs++;
 			if (state_num != -1)
 				server.sv_jobstates[state_num]++;
+			link_jobstate(pjob, state_num);
 			return (0);
 		} else {
 			return (PBSE_UNKQUE);
@@ -278,6 +412,7 @@ svr_enquejob(job *pjob, char *selectspec)
 	server.sv_qs.sv_numjobs++;
 	if (state_num != -1)
 		server.sv_jobstates[state_num]++;
+	link_jobstate(pjob, state_num);
 
 	/* place into queue in order of queue rank starting at end */
 
@@ -304,6 +439,7 @@ svr_enquejob(job *pjob, char *selectspec)
 	pque->qu_numjobs++;
 	if (state_num != -1)
 		pque->qu_njstate[state_num]++;
+	pque->qu_route_next = 0; /* a new job to route */
 
 	if ((check_job_state(pjob, JOB_STATE_LTR_MOVED)) || (check_job_state(pjob, JOB_STATE_LTR_FINISHED))) {
 		return (0);
@@ -470,6 +606,7 @@ svr_dequejob(job *pjob)
 		state_num = get_job_state_num(pjob);
 		if (state_num != -1 && --server.sv_jobstates[state_num] < 0)
 			bad_ct = 1;
+		link_jobstate(pjob, -1);
 	}
 
 	if ((pque = pjob->ji_qhdr) != NULL) {
@@ -542,6 +679,10 @@ svr_setjobstate(job *pjob, char newstate, int newsubstate)
 	 * take care of that, also req_commit() will see that the job is saved.
 	 */
 
+	/* the job may now be routable, or make room for another in transit */
+	if (pque != NULL)
+		pque->qu_route_next = 0;
+
 	if (!check_job_substate(pjob, JOB_SUBSTATE_TRANSICM)) {
 		char oldstate = get_job_state(pjob);
 
@@ -557,6 +698,8 @@ svr_setjobstate(job *pjob, char newstate, int newsubstate)
 				server.sv_jobstates[oldstatenum]--;
 			if (newstatenum != -1)
 				server.sv_jobstates[newstatenum]++;
+			if (pjob->ji_statelink.ll_next != &pjob->ji_statelink)
+				link_jobstate(pjob, newstatenum);
 			if (pque != NULL) {
 				if (oldstatenum != -1)
 					pque->qu_njstate[oldstatenum]--;
@@ -600,6 +743,7 @@ svr_setjobstate(job *pjob, char newstate, int newsubstate)
 	/* set the states accordingly */
 	set_job_state(pjob, newstate);
 	set_job_substate(pjob, newsubstate);
+	subscribe_notify_job(pjob);
 
 	/* eligible_time_enable */
 	if (get_sattr_long(SVR_ATR_EligibleTimeEnable) == 1) {
@@ -2323,6 +2467,7 @@ correct_ct(pbs_queue *pqj)
 		server.sv_qs.sv_numjobs++;
 		if (state_num != -1)
 			server.sv_jobstates[state_num]++;
+		link_jobstate(pjob, state_num);
 		if (pjob->ji_qhdr) {
 			(pjob->ji_qhdr)->qu_numjobs++;
 			if (state_num != -1)
@@ -4679,6 +4824,7 @@ svr_saveorpurge_finjobhist(job *pjob)
 	}
 	set_idle_delete_task(presv);
 }
+
 /**
  * @brief
  *		Function name: svr_clean_job_history
@@ -4695,7 +4841,6 @@ void
 svr_clean_job_history(struct work_task *pwt)
 {
 	job *pjob;
-	job *nxpjob = NULL;
 	int walltime_used = 0;
 
 	/*
@@ -4716,16 +4861,13 @@ svr_clean_job_history(struct work_task *pwt)
 	end_time = begin_time;
 
 	/*
-	 * Traverse through the SERVER job list and find the history
-	 * jobs (job with state JOB_STATE_LTR_MOVED and JOB_STATE_LTR_FINISHED)
-	 * which exceed the configured job_history_duration value and
-	 * purge them immediately.
+	 * Take the SERVER history jobs (jobs with state JOB_STATE_LTR_MOVED,
+	 * JOB_STATE_LTR_FINISHED and JOB_STATE_LTR_EXPIRED) off the expiry
+	 * heap for as long as the earliest one exceeds the configured
+	 * job_history_duration value, and purge them immediately.
 	 */
-	pjob = (job *) GET_NEXT(svr_alljobs);
-
-	while (pjob != NULL) {
-		/* save the next job */
-		nxpjob = (job *) GET_NEXT(pjob->ji_alljobs);
+	while (hist_heap_ct > 0 && time_now >= (hist_heap[0].he_time + svr_history_duration)) {
+		pjob = hist_heap[0].he_job;
 
 		if ((check_job_state(pjob, JOB_STATE_LTR_MOVED) && check_job_substate(pjob, JOB_SUBSTATE_FINISHED)) ||
 		    (check_job_state(pjob, JOB_STATE_LTR_FINISHED)) ||
@@ -4739,7 +4881,9 @@ svr_clean_job_history(struct work_task *pwt)
 					    !(is_jattr_set(pjob, JOB_ATR_stime))) {
 						log_err(-1, "svr_clean_job_history",
 							"Finished job missing start-time/walltime used, cannot clean history");
-						pjob = nxpjob;
+						/* look at it again one history duration from now */
+						hist_heap[0].he_time = time_now + 1;
+						hist_heap_sift(0);
 						continue;
 					}
 					set_jattr_l_slim(pjob, JOB_ATR_history_timestamp,
@@ -4750,11 +4894,18 @@ svr_clean_job_history(struct work_task *pwt)
 
 			if (time_now >= (get_jattr_long(pjob, JOB_ATR_history_timestamp) + svr_history_duration)) {
 				job_purge(pjob);
-				pjob = NULL;
-			}
+				if (hist_heap_ct > 0 && hist_heap[0].he_job == pjob) {
+					/* job was kept, do not spin on it */
+					hist_heap[0].he_time = time_now + 1;
+					hist_heap_sift(0);
+				}
+			} else
+				hist_expiry_set(pjob); /* re-key on the real timestamp */
+		} else {
+			/* a history job that is not purged, e.g. moved to another server */
+			hist_heap[0].he_time = time_now + 1;
+			hist_heap_sift(0);
 		}
-		/* restore the saved next in pjob */
-		pjob = nxpjob;
 
 		/* check if we spent too long hogging the pbs_server process here */
 		end_time = time(NULL);
@@ -4782,11 +4933,12 @@ svr_clean_job_history(struct work_task *pwt)
 				/* on error to set task
 					 * just continue purging the history
 					 */
-			} else
+			} else {
 				/* but if we managed to set a task in near future, return;
 				 * that task will continue where we left off
 				 */
 				return;
+			}
 		}
 	} /* end of while loop through jobs */
 
@@ -4847,6 +4999,8 @@ svr_histjob_update(job *pjob, char newstate, int newsubstate)
 			server.sv_jobstates[oldstatenum]--;
 		if (newstatenum != -1)
 			server.sv_jobstates[newstatenum]++;
+		if (pjob->ji_statelink.ll_next != &pjob->ji_statelink)
+			link_jobstate(pjob, newstatenum);
 		if (pque != NULL) {
 			if (oldstatenum != -1)
 				pque->qu_njstate[oldstatenum]--;
@@ -5130,6 +5284,9 @@ svr_setjob_histinfo(job *pjob, histjob_type type)
 	 * history info which is dangerous, so better delete them.
 	 */
 	free_job_work_tasks(pjob);
+
+	/* history jobs are read-only, keep only what qstat -x needs */
+	job_compact_hist(pjob);
 }
 
 /**
@@ -44,6 +44,12 @@
  * 		svr_mail.c - send mail to mail list or owner of job on
  *		job begin, job end, and/or job abort
  *
+ * 	Mail is handed to a long lived mail helper process over a pipe, so the
+ *	server does not fork for every message.  The helper runs the mailer
+ *	for each message, or once per recipient for a digest of the messages
+ *	received within PBS_MAIL_DIGEST seconds.  If the helper can not take a
+ *	message right away, the server falls back to forking a child for it.
+ *
  * 	Included public functions are:
  *		create_socket_and_connect()
  *		read_smtp_reply()
@@ -63,7 +69,14 @@
 #include <string.h>
 #include <unistd.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <time.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include "pbs_ifl.h"
 #include "list_link.h"
 #include "attribute.h"
@@ -74,6 +87,7 @@
 #include "reservation.h"
 #include "server.h"
 #include "tpp.h"
+#include "libutil.h"
 
 /* External Functions Called */
 
@@ -91,7 +105,24 @@ extern char *msg_resv_end;
 extern char *msg_resv_confirm;
 extern char *msg_job_stageinfail;
 
+extern char **environ;
+
 #define MAIL_ADDR_BUF_LEN 1024
+#define MAIL_FIELDS 5 /* mailer, from, to, subject and body of a message */
+
+/* one message waiting in the mail helper */
+struct held_mail {
+	char *buf;		   /* the message as read from the server */
+	char *field[MAIL_FIELDS];  /* the fields, pointing into buf */
+	int sent;		   /* went out, possibly in a digest */
+	struct held_mail *next;
+};
+
+/* messages going through the same mailer from the same sender to the same recipient */
+#define SAME_MAIL_ROUTE(a, b) (!(a)->sent && !strcmp((a)->field[0], (b)->field[0]) && \
+			       !strcmp((a)->field[1], (b)->field[1]) && !strcmp((a)->field[2], (b)->field[2]))
+
+static int mail_helper_fd = -1; /* write end of the pipe to the mail helper */
 
 /**
  * @brief
@@ -151,13 +182,383 @@ svr_exec_mailer(char *mailer, char *mailfrom, char *mailto)
 	return (fdopen(mfds[1], "w"));
 }
 
+/**
+ * @brief
+ * 		Run the mailer for one message from the mail helper.  The mailer is
+ *		spawned rather than forked: the helper is a copy of the server and
+ *		copying its page tables for every message is what it is avoiding.
+ *
+ * @param[in]	mailer - path to sendmail/mailer
+ * @param[in]	mailfrom - the sender of the email
+ * @param[in]	mailto - the recipient of the email
+ * @param[in]	subject - subject of the email
+ * @param[in]	body - body of the email
+ *
+ * @return	void
+ */
+static void
+mail_helper_spawn(char *mailer, char *mailfrom, char *mailto, char *subject, char *body)
+{
+	char *margs[5];
+	int mfds[2];
+	pid_t mcpid;
+	posix_spawn_file_actions_t fa;
+	FILE *outmail;
+	int rc;
+
+	margs[0] = mailer;
+	margs[1] = "-f";
+	margs[2] = mailfrom;
+	margs[3] = mailto;
+	margs[4] = NULL;
+
+	if (pipe(mfds) == -1) {
+		log_err(errno, __func__, "pipe failed");
+		return;
+	}
+
+	posix_spawn_file_actions_init(&fa);
+	posix_spawn_file_actions_adddup2(&fa, mfds[0], 0);
+	posix_spawn_file_actions_addclose(&fa, mfds[1]);
+	posix_spawn_file_actions_addopen(&fa, 1, "/dev/null", O_WRONLY, 0);
+	posix_spawn_file_actions_adddup2(&fa, 1, 2);
+	rc = posix_spawn(&mcpid, mailer, &fa, NULL, margs, environ);
+	posix_spawn_file_actions_destroy(&fa);
+	(void) close(mfds[0]);
+	if (rc != 0) {
+		log_err(rc, __func__, "spawning the mailer failed");
+		(void) close(mfds[1]);
+		return;
+	}
+
+	if ((outmail = fdopen(mfds[1], "w")) == NULL) {
+		(void) close(mfds[1]);
+		return;
+	}
+	fprintf(outmail, "To: %s\n", mailto);
+	fprintf(outmail, "Subject: %s\n\n", subject);
+	fputs(body, outmail);
+	fclose(outmail);
+}
+
+/**
+ * @brief
+ * 		Send the messages held by the mail helper.  With digests on, the
+ *		messages to the same recipient go out as one message.
+ *
+ * @param[in,out]	held - the held messages, emptied
+ *
+ * @return	void
+ */
+static void
+mail_helper_flush(struct held_mail **held)
+{
+	struct held_mail *pm;
+	struct held_mail *po;
+
+	for (pm = *held; pm != NULL; pm = pm->next) {
+		char *body = NULL;
+		char *subject = NULL;
+		int count = 0;
+
+		if (pm->sent)
+			continue;
+
+		/* combine the messages from the same mailer and sender to the same recipient */
+		if (pbs_conf.pbs_mail_digest > 0) {
+			for (po = pm->next; po != NULL; po = po->next)
+				if (SAME_MAIL_ROUTE(po, pm))
+					count++;
+		}
+		if (count > 0) {
+			for (po = pm; po != NULL; po = po->next) {
+				char *tmp = NULL;
+
+				if (po != pm && !SAME_MAIL_ROUTE(po, pm))
+					continue;
+				if (pbs_asprintf(&tmp, "%s%s----- %s -----\n%s", body != NULL ? body : "",
+						 body != NULL ? "\n" : "", po->field[3], po->field[4]) == -1)
+					break;
+				free(body);
+				body = tmp;
+				po->sent = 1;
+				count = po == pm ? 1 : count + 1;
+			}
+			if (body != NULL && pbs_asprintf(&subject, "PBS: %d notifications", count) != -1)
+				mail_helper_spawn(pm->field[0], pm->field[1], pm->field[2], subject, body);
+			free(subject);
+			free(body);
+		} else {
+			mail_helper_spawn(pm->field[0], pm->field[1], pm->field[2], pm->field[3], pm->field[4]);
+			pm->sent = 1;
+		}
+	}
+
+	while ((pm = *held) != NULL) {
+		*held = pm->next;
+		free(pm->buf);
+		free(pm);
+	}
+}
+
+/**
+ * @brief
+ * 		Main loop of the mail helper.  Messages come from the server as a
+ *		length followed by MAIL_FIELDS NUL terminated strings.  The helper
+ *		exits once the server closes its end of the pipe or goes away.
+ *
+ * @param[in]	rfd - read end of the pipe from the server
+ *
+ * @return	does not return
+ */
+static void
+mail_helper_main(int rfd)
+{
+	struct held_mail *held = NULL;
+	struct held_mail **tail = &held;
+	time_t first_held = 0;
+	char *buf = NULL;
+	size_t len = 0;
+	size_t size = 0;
+	int eof = 0;
+
+	signal(SIGTERM, SIG_DFL);
+	signal(SIGINT, SIG_DFL);
+	signal(SIGHUP, SIG_IGN);
+	signal(SIGCHLD, SIG_DFL);
+	signal(SIGPIPE, SIG_IGN);
+
+	while (!eof) {
+		struct pollfd pfd;
+		int timeout = 1000;
+		time_t now;
+
+		/* reap the mailers which are done */
+		while (waitpid(-1, NULL, WNOHANG) > 0)
+			;
+
+		now = time(NULL);
+		if (held != NULL) {
+			if (pbs_conf.pbs_mail_digest == 0 || now >= first_held + (time_t) pbs_conf.pbs_mail_digest)
+				timeout = 0;
+			else if ((first_held + (time_t) pbs_conf.pbs_mail_digest - now) * 1000 < timeout)
+				timeout = (first_held + pbs_conf.pbs_mail_digest - now) * 1000;
+		}
+
+		pfd.fd = rfd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		if (poll(&pfd, 1, timeout) > 0) {
+			ssize_t n;
+
+			if (size - len < PIPE_BUF) {
+				char *tmp = realloc(buf, size + 2 * PIPE_BUF);
+				if (tmp == NULL)
+					exit(1);
+				buf = tmp;
+				size += 2 * PIPE_BUF;
+			}
+			n = read(rfd, buf + len, size - len);
+			if (n > 0)
+				len += n;
+			else if (n == 0 || (errno != EINTR && errno != EAGAIN))
+				eof = 1;
+		}
+
+		/* pull the complete messages out of the buffer */
+		while (len >= sizeof(unsigned int)) {
+			unsigned int mlen;
+			struct held_mail *pm;
+			char *p;
+			int i;
+
+			memcpy(&mlen, buf, sizeof(mlen));
+			if (len < sizeof(mlen) + mlen)
+				break;
+			if ((pm = calloc(1, sizeof(struct held_mail))) == NULL ||
+			    (pm->buf = malloc(mlen + 1)) == NULL)
+				exit(1);
+			memcpy(pm->buf, buf + sizeof(mlen), mlen);
+			pm->buf[mlen] = '\0';
+			for (i = 0, p = pm->buf; i < MAIL_FIELDS; i++) {
+				pm->field[i] = p;
+				if (p < pm->buf + mlen)
+					p += strlen(p) + 1;
+			}
+			len -= sizeof(mlen) + mlen;
+			memmove(buf, buf + sizeof(mlen) + mlen, len);
+
+			if (held == NULL)
+				first_held = time(NULL);
+			*tail = pm;
+			tail = &pm->next;
+		}
+
+		if (getppid() == 1)
+			eof = 1;
+
+		now = time(NULL);
+		if (held != NULL && (eof || pbs_conf.pbs_mail_digest == 0 ||
+				     now >= first_held + (time_t) pbs_conf.pbs_mail_digest)) {
+			mail_helper_flush(&held);
+			tail = &held;
+		}
+	}
+
+	while (waitpid(-1, NULL, WNOHANG) > 0)
+		;
+	exit(0);
+}
+
+/**
+ * @brief
+ * 		Start the mail helper process.
+ *
+ * @return	int
+ * @retval	0  : the helper is running
+ * @retval	-1 : it could not be started
+ */
+static int
+mail_helper_start(void)
+{
+	int mfds[2];
+	pid_t pid;
+
+	if (pipe(mfds) == -1) {
+		log_err(errno, __func__, "pipe failed");
+		return -1;
+	}
+
+	pid = fork();
+	if (pid == -1) {
+		log_err(errno, __func__, "fork failed");
+		(void) close(mfds[0]);
+		(void) close(mfds[1]);
+		return -1;
+	}
+	if (pid == 0) {
+		/* the helper: fix up file descriptors like any other child of the server */
+		(void) close(mfds[1]);
+		net_close(-1);
+		tpp_terminate();
+		daemon_protect(0, PBS_DAEMON_PROTECT_OFF);
+		mail_helper_main(mfds[0]);
+	}
+
+	(void) close(mfds[0]);
+	(void) fcntl(mfds[1], F_SETFD, FD_CLOEXEC);
+	(void) fcntl(mfds[1], F_SETFL, O_NONBLOCK);
+	mail_helper_fd = mfds[1];
+	log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_SERVER, LOG_DEBUG, __func__,
+		   "started mail helper, pid %d", (int) pid);
+	return 0;
+}
+
+/**
+ * @brief
+ * 		Hand a message to the mail helper.  Messages are at most PIPE_BUF
+ *		long so each one is written whole or not at all.
+ *
+ * @return	int
+ * @retval	0  : the helper took the message
+ * @retval	-1 : it did not, send the message some other way
+ */
+static int
+mail_helper_send(char *mailer, char *mailfrom, char *mailto, char *subject, char *body)
+{
+	char *field[MAIL_FIELDS];
+	char msg[PIPE_BUF];
+	unsigned int mlen = 0;
+	int retry;
+	int i;
+
+	field[0] = mailer;
+	field[1] = mailfrom;
+	field[2] = mailto;
+	field[3] = subject;
+	field[4] = body;
+	for (i = 0; i < MAIL_FIELDS; i++) {
+		size_t flen = strlen(field[i]) + 1;
+
+		if (sizeof(mlen) + mlen + flen > sizeof(msg))
+			return -1;
+		memcpy(msg + sizeof(mlen) + mlen, field[i], flen);
+		mlen += flen;
+	}
+	memcpy(msg, &mlen, sizeof(mlen));
+
+	for (retry = 0; retry < 2; retry++) {
+		if (mail_helper_fd == -1 && mail_helper_start() != 0)
+			return -1;
+		if (write(mail_helper_fd, msg, sizeof(mlen) + mlen) == (ssize_t) (sizeof(mlen) + mlen))
+			return 0;
+		if (errno != EPIPE)
+			return -1; /* the helper is busy */
+		/* the helper went away, start another one */
+		(void) close(mail_helper_fd);
+		mail_helper_fd = -1;
+	}
+	return -1;
+}
+
+/**
+ * @brief
+ * 		Send a message, through the mail helper if it can take it and by
+ *		forking a child to run the mailer otherwise.
+ *
+ * @param[in]	mailer - path to sendmail/mailer
+ * @param[in]	mailfrom - the sender of the email
+ * @param[in]	mailto - the recipient of the email
+ * @param[in]	subject - subject of the email
+ * @param[in]	body - body of the email
+ *
+ * @return	void
+ */
+static void
+svr_send_mail(char *mailer, char *mailfrom, char *mailto, char *subject, char *body)
+{
+	FILE *outmail;
+	pid_t mcpid;
+
+	if (mail_helper_send(mailer, mailfrom, mailto, subject, body) == 0)
+		return;
+
+	mcpid = fork();
+	if (mcpid == -1) { /* Error on fork */
+		log_err(errno, __func__, "fork failed\n");
+		return;
+	}
+	if (mcpid > 0)
+		return; /* its all up to the child now */
+
+	/*
+	 * From here on, we are a child process of the server.
+	 * Fix up file descriptors and signal handlers.
+	 */
+	net_close(-1);
+	tpp_terminate();
+
+	/* Unprotect child from being killed by kernel */
+	daemon_protect(0, PBS_DAEMON_PROTECT_OFF);
+
+	if ((outmail = svr_exec_mailer(mailer, mailfrom, mailto)) == NULL)
+		exit(1);
+
+	fprintf(outmail, "To: %s\n", mailto);
+	fprintf(outmail, "Subject: %s\n\n", subject);
+	fputs(body, outmail);
+	fclose(outmail);
+
+	exit(0);
+}
+
 /**
  * @brief
  * 		Send mail to owner of a job when an event happens that
  *		requires mail, such as the job starts, ends or is aborted.
  *		The event is matched against those requested by the user.
- *		For Unix/Linux, a child is forked to not hold up the Server.  This child
- *		will fork/exec sendmail and pipe the To, Subject and body to it.
+ *		The message is handed to the mail helper, which runs sendmail and
+ *		pipes the To, Subject and body to it, to not hold up the Server.
  *
  * @param[in]	jid	-	the Job ID (string)
  * @param[in]	pjob	-	pointer to the job structure
@@ -179,9 +580,8 @@ svr_mailowner_id(char *jid, job *pjob, int mailpoint, int force, char *text)
 	struct array_strings *pas;
 	char *stdmessage = NULL;
 	char *pat;
-
-	FILE *outmail;
-	pid_t mcpid;
+	char subject[MAIL_ADDR_BUF_LEN];
+	char *body = NULL;
 
 	/* if force is true, force the mail out regardless of mailpoint */
 
@@ -212,29 +612,6 @@ svr_mailowner_id(char *jid, job *pjob, int mailpoint, int force, char *text)
 		}
 	}
 
-	/*
-	 * ok, now we will fork a process to do the mailing to not
-	 * hold up the server's other work.
-	 */
-
-	mcpid = fork();
-	if (mcpid == -1) { /* Error on fork */
-		log_err(errno, __func__, "fork failed\n");
-		return;
-	}
-	if (mcpid > 0)
-		return; /* its all up to the child now */
-
-	/*
-	 * From here on, we are a child process of the server.
-	 * Fix up file descriptors and signal handlers.
-	 */
-	net_close(-1);
-	tpp_terminate();
-
-	/* Unprotect child from being killed by kernel */
-	daemon_protect(0, PBS_DAEMON_PROTECT_OFF);
-
 	if (is_sattr_set(SVR_ATR_mailer))
 		mailer = get_sattr_str(SVR_ATR_mailer);
 	else
@@ -314,19 +691,14 @@ svr_mailowner_id(char *jid, job *pjob, int mailpoint, int force, char *text)
 		strcpy(mailto, mailfrom);
 	}
 
-	if ((outmail = svr_exec_mailer(mailer, mailfrom, mailto)) == NULL)
-		exit(1);
-
-	/* Pipe in mail headers: To: and Subject: */
-
-	fprintf(outmail, "To: %s\n", mailto);
+	/* the mail headers: To: and Subject: */
 
 	if (pjob)
-		fprintf(outmail, "Subject: PBS JOB %s\n\n", jid);
+		snprintf(subject, sizeof(subject), "PBS JOB %s", jid);
 	else
-		fprintf(outmail, "Subject: PBS Server on %s\n\n", server_host);
+		snprintf(subject, sizeof(subject), "PBS Server on %s", server_host);
 
-	/* Now pipe in "standard" message */
+	/* Now the "standard" message */
 
 	switch (mailpoint) {
 
@@ -348,25 +720,28 @@ svr_mailowner_id(char *jid, job *pjob, int mailpoint, int force, char *text)
 	}
 
 	if (pjob) {
-		fprintf(outmail, "PBS Job Id: %s\n", jid);
-		fprintf(outmail, "Job Name:   %s\n",
-			get_jattr_str(pjob, JOB_ATR_jobname));
-	}
-	if (stdmessage)
-		fprintf(outmail, "%s\n", stdmessage);
-	if (text != NULL)
-		fprintf(outmail, "%s\n", text);
-	fclose(outmail);
+		char *jobname = get_jattr_str(pjob, JOB_ATR_jobname);
 
-	exit(0);
+		if (pbs_asprintf(&body, "PBS Job Id: %s\nJob Name:   %s\n%s%s%s%s", jid,
+				 jobname != NULL ? jobname : "",
+				 stdmessage ? stdmessage : "", stdmessage ? "\n" : "",
+				 text != NULL ? text : "", text != NULL ? "\n" : "") == -1)
+			return;
+	} else if (pbs_asprintf(&body, "%s%s%s%s",
+				stdmessage ? stdmessage : "", stdmessage ? "\n" : "",
+				text != NULL ? text : "", text != NULL ? "\n" : "") == -1)
+		return;
+
+	svr_send_mail(mailer, mailfrom, mailto, subject, body);
+	free(body);
 }
 /**
  * @brief
  * 		svr_mailowner - Send mail to owner of a job when an event happens that
  *		requires mail, such as the job starts, ends or is aborted.
  *		The event is matched against those requested by the user.
- *		For Unix/Linux, a child is forked to not hold up the Server.  This child
- *		will fork/exec sendmail and pipe the To, Subject and body to it.
+ *		The message is handed to the mail helper, which runs sendmail and
+ *		pipes the To, Subject and body to it, to not hold up the Server.
  *
  * @param[in]	pjob	-	ptr to job (null for server based mail)
  * @param[in]	mailpoint	-	note, single character
@@ -384,8 +759,8 @@ svr_mailowner(job *pjob, int mailpoint, int force, char *text)
  * 		Send mail to owner of a reservation when an event happens that
  *		requires mail, such as the reservation starts, ends or is aborted.
  *		The event is matched against those requested by the user.
- *		For Unix/Linux, a child is forked to not hold up the Server.  This child
- *		will fork/exec sendmail and pipe the To, Subject and body to it.
+ *		The message is handed to the mail helper, which runs sendmail and
+ *		pipes the To, Subject and body to it, to not hold up the Server.
  *
  * @param[in]	presv	-	pointer to the reservation structure
  * @param[in]	mailpoint	-	which mail event is triggering the send
@@ -406,9 +781,9 @@ svr_mailownerResv(resc_resv *presv, int mailpoint, int force, char *text)
 	struct array_strings *pas;
 	char *pat;
 	char *stdmessage = NULL;
-
-	FILE *outmail;
-	pid_t mcpid;
+	char subject[MAIL_ADDR_BUF_LEN];
+	char *resvname;
+	char *body = NULL;
 
 	if (force != MAIL_FORCE) {
 		/*Not forcing out mail regardless of mailpoint */
@@ -432,30 +807,6 @@ svr_mailownerResv(resc_resv *presv, int mailpoint, int force, char *text)
 			return;
 	}
 
-	/*
-	 * ok, now we will fork a process to do the mailing to not
-	 * hold up the server's other work.
-	 */
-
-	mcpid = fork();
-	if (mcpid == -1) { /* Error on fork */
-		log_err(errno, __func__, "fork failed\n");
-		return;
-	}
-	if (mcpid > 0)
-		return; /* its all up to the child now */
-
-	/*
-	 * From here on, we are a child process of the server.
-	 * Fix up file descriptors and signal handlers.
-	 */
-
-	net_close(-1);
-	tpp_terminate();
-
-	/* Unprotect child from being killed by kernel */
-	daemon_protect(0, PBS_DAEMON_PROTECT_OFF);
-
 	if (is_sattr_set(SVR_ATR_mailer))
 		mailer = get_sattr_str(SVR_ATR_mailer);
 	else
@@ -526,15 +877,11 @@ svr_mailownerResv(resc_resv *presv, int mailpoint, int force, char *text)
 		}
 	}
 
-	if ((outmail = svr_exec_mailer(mailer, mailfrom, mailto)) == NULL)
-		exit(1);
-
-	/* Pipe in mail headers: To: and Subject: */
+	/* the mail headers: To: and Subject: */
 
-	fprintf(outmail, "To: %s\n", mailto);
-	fprintf(outmail, "Subject: PBS RESERVATION %s\n\n", presv->ri_qs.ri_resvID);
+	snprintf(subject, sizeof(subject), "PBS RESERVATION %s", presv->ri_qs.ri_resvID);
 
-	/* Now pipe in "standard" message */
+	/* Now the "standard" message */
 
 	switch (mailpoint) {
 
@@ -559,13 +906,13 @@ svr_mailownerResv(resc_resv *presv, int mailpoint, int force, char *text)
 			break;
 	}
 
-	fprintf(outmail, "PBS Reservation Id: %s\n", presv->ri_qs.ri_resvID);
-	fprintf(outmail, "Reservation Name:   %s\n", get_rattr_str(presv, RESV_ATR_resv_name));
-	if (stdmessage)
-		fprintf(outmail, "%s\n", stdmessage);
-	if (text != NULL)
-		fprintf(outmail, "%s\n", text);
-	fclose(outmail);
+	resvname = get_rattr_str(presv, RESV_ATR_resv_name);
+	if (pbs_asprintf(&body, "PBS Reservation Id: %s\nReservation Name:   %s\n%s%s%s%s",
+			 presv->ri_qs.ri_resvID, resvname != NULL ? resvname : "",
+			 stdmessage ? stdmessage : "", stdmessage ? "\n" : "",
+			 text != NULL ? text : "", text != NULL ? "\n" : "") == -1)
+		return;
 
-	exit(0);
+	svr_send_mail(mailer, mailfrom, mailto, subject, body);
+	free(body);
 }
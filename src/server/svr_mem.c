@@ -0,0 +1,391 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+
+/**
+ * @file	svr_mem.c
+ *
+ * @brief
+ * 		Accounting of the memory the server holds, by object type.
+ *
+ * 	The objects are counted, and the memory they hold estimated, by walking
+ * 	the server's lists: jobs, reservations, nodes and queues with the values
+ * 	of their attributes, split into plain attribute values, resource lists
+ * 	and the cached encoded forms of attributes, plus pending work tasks,
+ * 	batch requests and the DIS channel buffers.  The walk is only made on
+ * 	demand and its result is reused for SVR_MEM_REFRESH seconds.
+ *
+ * 	On SIGUSR1 the server writes the accounting and the SVR_MEM_TOP largest
+ * 	jobs, reservations and nodes to server_priv/server_memory.txt.
+ *
+ * Functions included are:
+ * 	svr_mem_summary()
+ * 	svr_mem_print_json()
+ * 	svr_mem_print_prom()
+ * 	server_memory_dump()
+ *
+ */
+#include <pbs_config.h> /* the master config generated by configure */
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "libpbs.h"
+#include "list_link.h"
+#include "attribute.h"
+#include "server_limits.h"
+#include "server.h"
+#include "job.h"
+#include "reservation.h"
+#include "queue.h"
+#include "pbs_nodes.h"
+#include "batch_request.h"
+#include "work_task.h"
+#include "dis.h"
+#include "svrfunc.h"
+#include "log.h"
+#include "libutil.h"
+
+#define SVR_MEM_REFRESH 30 /* seconds an accounting walk is reused */
+#define SVR_MEM_TOP 20	   /* largest objects in the dump */
+#define SVR_MEM_FILE "server_memory.txt"
+
+enum svr_mem_type {
+	SVR_MEM_JOB,
+	SVR_MEM_RESV,
+	SVR_MEM_NODE,
+	SVR_MEM_QUEUE,
+	SVR_MEM_ATTR,
+	SVR_MEM_RESC,
+	SVR_MEM_ATTR_CACHE,
+	SVR_MEM_TASK,
+	SVR_MEM_REQUEST,
+	SVR_MEM_DIS,
+	SVR_MEM_NUM_TYPES
+};
+
+static char *svr_mem_names[SVR_MEM_NUM_TYPES] = {"jobs", "resvs", "nodes", "queues",
+						 "attrs", "resources", "attr_cache",
+						 "tasks", "requests", "dis_buffers"};
+
+struct svr_mem_count {
+	long objects;
+	long bytes;
+};
+
+/* one of the largest objects */
+struct svr_mem_obj {
+	long bytes;
+	const char *kind;
+	char name[PBS_MAXSVRJOBID + 1];
+	const char *big_attr; /* its largest attribute */
+	long big_bytes;
+};
+
+extern char *path_priv;
+extern time_t time_now;
+extern pbs_list_head svr_queues;
+extern pbs_list_head svr_requests;
+
+volatile sig_atomic_t svr_mem_dump_pending = 0;
+
+static struct svr_mem_count svr_mem[SVR_MEM_NUM_TYPES];
+static time_t svr_mem_time = 0; /* when svr_mem was last walked */
+static struct svr_mem_obj svr_mem_top[SVR_MEM_TOP];
+static int svr_mem_ntop;
+
+/**
+ * @brief
+ * 		Add the values of an array of attributes to the accounting
+ *
+ * @param[in]	attrs	- the attributes
+ * @param[in]	defs	- their definitions
+ * @param[in]	n	- number of attributes
+ * @param[out]	obj	- if not NULL, gets the largest attribute
+ *
+ * @return	long
+ * @retval	bytes held by the attribute values
+ */
+static long
+account_attrs(attribute *attrs, attribute_def *defs, int n, struct svr_mem_obj *obj)
+{
+	resource *presc;
+	long total = 0;
+	long size;
+	int i;
+
+	for (i = 0; i < n; i++) {
+		attribute *pattr = &attrs[i];
+
+		if (pattr->at_user_encoded || pattr->at_priv_encoded) {
+			size = attr_cache_mem_size(pattr);
+			svr_mem[SVR_MEM_ATTR_CACHE].objects++;
+			svr_mem[SVR_MEM_ATTR_CACHE].bytes += size;
+			total += size;
+		}
+		if (!(pattr->at_flags & ATR_VFLAG_SET))
+			continue;
+
+		size = attr_mem_size(pattr);
+		if (pattr->at_type == ATR_TYPE_RESC) {
+			for (presc = (resource *) GET_NEXT(pattr->at_val.at_list); presc;
+			     presc = (resource *) GET_NEXT(presc->rs_link))
+				svr_mem[SVR_MEM_RESC].objects++;
+			svr_mem[SVR_MEM_RESC].bytes += size;
+		} else {
+			svr_mem[SVR_MEM_ATTR].objects++;
+			svr_mem[SVR_MEM_ATTR].bytes += size;
+		}
+		total += size;
+		if (obj && size > obj->big_bytes) {
+			obj->big_bytes = size;
+			obj->big_attr = defs[i].at_name;
+		}
+	}
+	return total;
+}
+
+/**
+ * @brief
+ * 		Keep an object among the SVR_MEM_TOP largest, largest first
+ */
+static void
+account_top(struct svr_mem_obj *obj)
+{
+	int k;
+
+	if (svr_mem_ntop == SVR_MEM_TOP && obj->bytes <= svr_mem_top[SVR_MEM_TOP - 1].bytes)
+		return;
+	k = (svr_mem_ntop < SVR_MEM_TOP) ? svr_mem_ntop++ : SVR_MEM_TOP - 1;
+	for (; k > 0 && svr_mem_top[k - 1].bytes < obj->bytes; k--)
+		svr_mem_top[k] = svr_mem_top[k - 1];
+	svr_mem_top[k] = *obj;
+}
+
+/**
+ * @brief
+ * 		Walk the server's objects and recount the memory they hold
+ *
+ * @param[in]	force	- walk even if the last walk is recent
+ */
+static void
+svr_mem_walk(int force)
+{
+	struct svr_mem_obj obj;
+	struct batch_request *preq;
+	resc_resv *presv;
+	pbs_queue *pque;
+	job *pjob;
+	int i;
+
+	if (!force && svr_mem_time != 0 && time_now - svr_mem_time < SVR_MEM_REFRESH)
+		return;
+
+	memset(svr_mem, 0, sizeof(svr_mem));
+	svr_mem_ntop = 0;
+
+	for (pjob = (job *) GET_NEXT(svr_alljobs); pjob;
+	     pjob = (job *) GET_NEXT(pjob->ji_alljobs)) {
+		memset(&obj, 0, sizeof(obj));
+		obj.kind = "job";
+		pbs_strncpy(obj.name, pjob->ji_qs.ji_jobid, sizeof(obj.name));
+		obj.bytes = sizeof(job) + account_attrs(pjob->ji_wattr, job_attr_def, JOB_ATR_LAST, &obj);
+		svr_mem[SVR_MEM_JOB].objects++;
+		svr_mem[SVR_MEM_JOB].bytes += sizeof(job);
+		account_top(&obj);
+	}
+
+	for (presv = (resc_resv *) GET_NEXT(svr_allresvs); presv;
+	     presv = (resc_resv *) GET_NEXT(presv->ri_allresvs)) {
+		memset(&obj, 0, sizeof(obj));
+		obj.kind = "resv";
+		pbs_strncpy(obj.name, presv->ri_qs.ri_resvID, sizeof(obj.name));
+		obj.bytes = sizeof(resc_resv) + account_attrs(presv->ri_wattr, resv_attr_def, RESV_ATR_LAST, &obj);
+		svr_mem[SVR_MEM_RESV].objects++;
+		svr_mem[SVR_MEM_RESV].bytes += sizeof(resc_resv);
+		account_top(&obj);
+	}
+
+	for (i = 0; i < svr_totnodes; i++) {
+		struct pbsnode *pnode = pbsndlist[i];
+
+		if (pnode == NULL)
+			continue;
+		memset(&obj, 0, sizeof(obj));
+		obj.kind = "node";
+		pbs_strncpy(obj.name, pnode->nd_name, sizeof(obj.name));
+		obj.bytes = sizeof(struct pbsnode) + account_attrs(pnode->nd_attr, node_attr_def, ND_ATR_LAST, &obj);
+		svr_mem[SVR_MEM_NODE].objects++;
+		svr_mem[SVR_MEM_NODE].bytes += sizeof(struct pbsnode);
+		account_top(&obj);
+	}
+
+	for (pque = (pbs_queue *) GET_NEXT(svr_queues); pque;
+	     pque = (pbs_queue *) GET_NEXT(pque->qu_link)) {
+		(void) account_attrs(pque->qu_attr, que_attr_def, QA_ATR_LAST, NULL);
+		svr_mem[SVR_MEM_QUEUE].objects++;
+		svr_mem[SVR_MEM_QUEUE].bytes += sizeof(pbs_queue);
+	}
+
+	(void) account_attrs(server.sv_attr, svr_attr_def, SVR_ATR_LAST, NULL);
+
+	svr_mem[SVR_MEM_TASK].objects = work_task_backlog();
+	svr_mem[SVR_MEM_TASK].bytes = work_task_backlog() * sizeof(struct work_task);
+
+	for (preq = (struct batch_request *) GET_NEXT(svr_requests); preq;
+	     preq = (struct batch_request *) GET_NEXT(preq->rq_link)) {
+		svr_mem[SVR_MEM_REQUEST].objects++;
+		svr_mem[SVR_MEM_REQUEST].bytes += sizeof(struct batch_request);
+	}
+
+	svr_mem[SVR_MEM_DIS].bytes = dis_buf_mem();
+
+	svr_mem_time = time_now;
+}
+
+/**
+ * @brief
+ * 		svr_mem_summary - append "mem_<type>:<objects>/<bytes> " for each
+ * 		object type to a buffer, for the server_metrics attribute
+ *
+ * @param[in,out]	buf	- buffer appended to
+ * @param[in]		len	- size of buf
+ */
+void
+svr_mem_summary(char *buf, size_t len)
+{
+	size_t used;
+	int i;
+
+	svr_mem_walk(0);
+	for (i = 0; i < SVR_MEM_NUM_TYPES; i++) {
+		used = strlen(buf);
+		if (used + 1 >= len)
+			return;
+		snprintf(buf + used, len - used, "mem_%s:%ld/%ld ", svr_mem_names[i],
+			 svr_mem[i].objects, svr_mem[i].bytes);
+	}
+}
+
+/**
+ * @brief
+ * 		svr_mem_print_json - write the accounting as a JSON object keyed
+ * 		by object type
+ *
+ * @param[in]	fp	- stream to write to
+ */
+void
+svr_mem_print_json(FILE *fp)
+{
+	int i;
+
+	svr_mem_walk(0);
+	fprintf(fp, "{");
+	for (i = 0; i < SVR_MEM_NUM_TYPES; i++)
+		fprintf(fp, "%s\n    \"%s\": {\"objects\": %ld, \"bytes\": %ld}", i ? "," : "",
+			svr_mem_names[i], svr_mem[i].objects, svr_mem[i].bytes);
+	fprintf(fp, "\n  }");
+}
+
+/**
+ * @brief
+ * 		svr_mem_print_prom - write the accounting in the Prometheus text
+ * 		format
+ *
+ * @param[in]	fp	- stream to write to
+ */
+void
+svr_mem_print_prom(FILE *fp)
+{
+	int i;
+
+	svr_mem_walk(0);
+	fprintf(fp, "# TYPE pbs_server_mem_objects gauge\n");
+	for (i = 0; i < SVR_MEM_NUM_TYPES; i++)
+		fprintf(fp, "pbs_server_mem_objects{type=\"%s\"} %ld\n", svr_mem_names[i], svr_mem[i].objects);
+	fprintf(fp, "# TYPE pbs_server_mem_bytes gauge\n");
+	for (i = 0; i < SVR_MEM_NUM_TYPES; i++)
+		fprintf(fp, "pbs_server_mem_bytes{type=\"%s\"} %ld\n", svr_mem_names[i], svr_mem[i].bytes);
+}
+
+/**
+ * @brief
+ * 		server_memory_dump - write the accounting and the largest objects
+ * 		to server_priv/server_memory.txt, on SIGUSR1
+ *
+ * @return	int
+ * @retval	0	- success
+ * @retval	-1	- failure
+ */
+int
+server_memory_dump(void)
+{
+	char path[MAXPATHLEN + 1];
+	FILE *fp;
+	int i;
+
+	svr_mem_walk(1);
+
+	snprintf(path, sizeof(path), "%s/%s", path_priv, SVR_MEM_FILE);
+	if ((fp = fopen(path, "w")) == NULL) {
+		log_err(errno, __func__, path);
+		return (-1);
+	}
+
+	fprintf(fp, "%-12s %12s %16s\n", "type", "objects", "bytes");
+	for (i = 0; i < SVR_MEM_NUM_TYPES; i++)
+		fprintf(fp, "%-12s %12ld %16ld\n", svr_mem_names[i], svr_mem[i].objects, svr_mem[i].bytes);
+
+	fprintf(fp, "\nlargest objects\n%-5s %-32s %12s  %s\n", "kind", "name", "bytes", "largest attribute");
+	for (i = 0; i < svr_mem_ntop; i++)
+		fprintf(fp, "%-5s %-32s %12ld  %s %ld\n", svr_mem_top[i].kind, svr_mem_top[i].name,
+			svr_mem_top[i].bytes, svr_mem_top[i].big_attr ? svr_mem_top[i].big_attr : "-",
+			svr_mem_top[i].big_bytes);
+
+	if (fclose(fp) != 0) {
+		log_err(errno, __func__, path);
+		return (-1);
+	}
+	log_eventf(PBSEVENT_ADMIN, PBS_EVENTCLASS_SERVER, LOG_INFO, __func__,
+		   "memory accounting written to %s", path);
+	return (0);
+}
@@ -0,0 +1,486 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+
+/**
+ * @file	svr_metrics.c
+ *
+ * @brief
+ * 		Always-on latency histograms of the server: service time and
+ * 		total time of each batch request type, handling time of each
+ * 		inter-server (IS) message type from the moms, the main loop and
+ * 		its work tasks, and the database calls.
+ *
+ * 	A summary is kept in the read-only server attribute server_metrics,
+ * 	refreshed whenever the server is statused, and when PBS_SERVER_METRICS
+ * 	is set in pbs.conf the full histograms are dumped every so many
+ * 	seconds to server_priv/server_metrics.json.  When PBS_METRICS_EXPORT
+ * 	is set they are also served with the job counts and TPP backlogs in
+ * 	the Prometheus text format on server_priv/metrics.sock.
+ *
+ * Functions included are:
+ * 	svr_metrics_request()
+ * 	svr_metrics_request_done()
+ * 	svr_metrics_is()
+ * 	svr_metrics_loop()
+ * 	svr_metrics_tasks()
+ * 	update_server_metrics()
+ * 	server_metrics_dump()
+ * 	server_metrics_export()
+ *
+ */
+#include <pbs_config.h> /* the master config generated by configure */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "libpbs.h"
+#include "list_link.h"
+#include "attribute.h"
+#include "server_limits.h"
+#include "server.h"
+#include "batch_request.h"
+#include "work_task.h"
+#include "net_connect.h"
+#include "svrfunc.h"
+#include "log.h"
+#include "pbs_db.h"
+#include "pbs_metrics.h"
+#include "pbs_internal.h"
+#include "tpp.h"
+
+#define SVR_METRICS_NREQ (PBS_BATCH_SelAct + 1) /* batch request types */
+#define SVR_METRICS_NIS (IS_HELLOSVR + 1)	    /* IS message types */
+#define SVR_METRICS_TOP 5			    /* request types in the attribute */
+#define SVR_METRICS_FILE "server_metrics.json"
+#define SVR_METRICS_SOCK "metrics.sock"
+
+extern char *path_priv;
+extern time_t time_now;
+extern int svr_totnodes;
+
+static struct {
+	pbs_hist_t req_svc[SVR_METRICS_NREQ];	/* time in the request handler */
+	pbs_hist_t req_total[SVR_METRICS_NREQ]; /* time from receipt to reply */
+	pbs_hist_t is_msg[SVR_METRICS_NIS];	/* time handling IS messages */
+	pbs_hist_t loop;			/* main loop pass, outside the wait */
+	pbs_hist_t tasks;			/* running due work tasks */
+	time_t since;				/* when the server started recording */
+} svr_metrics;
+
+static char *db_op_names[PBS_DB_NUM_OPS] = {"save", "load", "delete", "search", "commit", "pipeline"};
+
+/**
+ * @brief
+ * 		Record the time a batch request handler took
+ *
+ * @param[in]	rq_type	- request type
+ * @param[in]	start	- pbs_metrics_now_us() when the handler was called
+ */
+void
+svr_metrics_request(int rq_type, unsigned long long start)
+{
+	if (rq_type >= 0 && rq_type < SVR_METRICS_NREQ)
+		pbs_hist_since(&svr_metrics.req_svc[rq_type], start);
+}
+
+/**
+ * @brief
+ * 		Record the time from receipt of a batch request to freeing it
+ * 		once it was replied to, including any time it was deferred
+ * 		waiting on a mom, a hook or the scheduler
+ *
+ * @param[in]	rq_type	- request type
+ * @param[in]	recv	- pbs_metrics_now_us() when the request was read
+ */
+void
+svr_metrics_request_done(int rq_type, unsigned long long recv)
+{
+	if (rq_type >= 0 && rq_type < SVR_METRICS_NREQ)
+		pbs_hist_since(&svr_metrics.req_total[rq_type], recv);
+}
+
+/**
+ * @brief
+ * 		Record the time handling an IS message from a mom took
+ *
+ * @param[in]	command	- IS message type, -1 if it could not be read
+ * @param[in]	start	- pbs_metrics_now_us() when the message was read
+ */
+void
+svr_metrics_is(int command, unsigned long long start)
+{
+	if (command >= 0 && command < SVR_METRICS_NIS)
+		pbs_hist_since(&svr_metrics.is_msg[command], start);
+}
+
+/**
+ * @brief
+ * 		Record the time a pass of the main loop took before it got back to
+ * 		waiting for requests, i.e. how long new requests could be kept
+ * 		waiting on everything else the loop does
+ *
+ * @param[in]	start	- pbs_metrics_now_us() at the top of the pass
+ */
+void
+svr_metrics_loop(unsigned long long start)
+{
+	if (svr_metrics.since == 0)
+		svr_metrics.since = time_now;
+	pbs_hist_since(&svr_metrics.loop, start);
+}
+
+/**
+ * @brief
+ * 		Record the time the main loop spent running due work tasks
+ *
+ * @param[in]	start	- pbs_metrics_now_us() before next_task()
+ */
+void
+svr_metrics_tasks(unsigned long long start)
+{
+	pbs_hist_since(&svr_metrics.tasks, start);
+}
+
+/**
+ * @brief
+ * 		Append "<name>:<summary> " of a histogram to a buffer
+ */
+static void
+append_summary(char *buf, size_t len, const char *name, const pbs_hist_t *h)
+{
+	size_t used = strlen(buf);
+
+	if (used + 1 >= len)
+		return;
+	snprintf(buf + used, len - used, "%s:", name);
+	used = strlen(buf);
+	if (used + 1 >= len)
+		return;
+	pbs_hist_summary(buf + used, len - used, h);
+	used = strlen(buf);
+	if (used + 1 < len)
+		strcat(buf, " ");
+}
+
+/**
+ * @brief
+ * 		update_server_metrics - refresh the server_metrics attribute from
+ * 		the histograms.
+ *
+ * @par
+ * 		Each histogram is shown as <count>/<mean>/<p50>/<p99>/<max>, times in
+ * 		microseconds: the main loop, work tasks, lateness of timed tasks,
+ * 		the database calls, and the SVR_METRICS_TOP request types the
+ * 		server spent most time on, as req<type>.  The number of pending
+ * 		work tasks is shown as task_backlog, and the objects and bytes
+ * 		held by each object type as mem_<type>, see svr_mem.c.
+ */
+void
+update_server_metrics(void)
+{
+	char buf[4096];
+	char name[32];
+	int top[SVR_METRICS_TOP];
+	const pbs_hist_t *h;
+	size_t used;
+	int i;
+	int j;
+	int k;
+
+	buf[0] = '\0';
+	append_summary(buf, sizeof(buf), "loop", &svr_metrics.loop);
+	append_summary(buf, sizeof(buf), "tasks", &svr_metrics.tasks);
+	append_summary(buf, sizeof(buf), "task_lag", work_task_lag());
+	used = strlen(buf);
+	snprintf(buf + used, sizeof(buf) - used, "task_backlog:%ld ", work_task_backlog());
+	for (i = 0; i < PBS_DB_NUM_OPS; i++) {
+		if ((h = pbs_db_latency(i)) == NULL || h->count == 0)
+			continue;
+		snprintf(name, sizeof(name), "db_%s", db_op_names[i]);
+		append_summary(buf, sizeof(buf), name, h);
+	}
+
+	/* the request types with the most time in their handlers */
+	for (k = 0; k < SVR_METRICS_TOP; k++)
+		top[k] = -1;
+	for (i = 0; i < SVR_METRICS_NREQ; i++) {
+		if (svr_metrics.req_svc[i].count == 0)
+			continue;
+		for (k = 0; k < SVR_METRICS_TOP; k++) {
+			if (top[k] == -1 || svr_metrics.req_svc[i].sum_us > svr_metrics.req_svc[top[k]].sum_us)
+				break;
+		}
+		if (k == SVR_METRICS_TOP)
+			continue;
+		for (j = SVR_METRICS_TOP - 1; j > k; j--)
+			top[j] = top[j - 1];
+		top[k] = i;
+	}
+	for (k = 0; k < SVR_METRICS_TOP && top[k] != -1; k++) {
+		snprintf(name, sizeof(name), "req%d", top[k]);
+		append_summary(buf, sizeof(buf), name, &svr_metrics.req_svc[top[k]]);
+	}
+
+	svr_mem_summary(buf, sizeof(buf));
+
+	used = strlen(buf);
+	if (used > 0 && buf[used - 1] == ' ')
+		buf[used - 1] = '\0';
+	set_sattr_str_slim(SVR_ATR_server_metrics, buf, NULL);
+}
+
+/**
+ * @brief
+ * 		Write a JSON object of the non-empty histograms of an array,
+ * 		keyed by their index
+ */
+static void
+print_hist_array(FILE *fp, const char *name, const pbs_hist_t *h, int n)
+{
+	int i;
+	int first = 1;
+
+	fprintf(fp, ",\n  \"%s\": {", name);
+	for (i = 0; i < n; i++) {
+		if (h[i].count == 0)
+			continue;
+		fprintf(fp, "%s\n    \"%d\": ", first ? "" : ",", i);
+		pbs_hist_print_json(fp, &h[i]);
+		first = 0;
+	}
+	fprintf(fp, "\n  }");
+}
+
+/**
+ * @brief
+ * 		write_server_metrics - write all the histograms as JSON to
+ * 		server_priv/server_metrics.json, through a temporary file renamed
+ * 		into place so a reader never sees a partial dump.
+ *
+ * @return	int
+ * @retval	0	- success
+ * @retval	-1	- failure, the previous dump is left in place
+ */
+static int
+write_server_metrics(void)
+{
+	char path[MAXPATHLEN + 1];
+	char newpath[MAXPATHLEN + 1];
+	const pbs_hist_t *h;
+	FILE *fp;
+	int i;
+
+	if ((snprintf(path, sizeof(path), "%s/%s", path_priv, SVR_METRICS_FILE) >= (int) sizeof(path)) ||
+	    (snprintf(newpath, sizeof(newpath), "%s.new", path) >= (int) sizeof(newpath))) {
+		log_err(ENAMETOOLONG, __func__, path);
+		return (-1);
+	}
+
+	if ((fp = fopen(newpath, "w")) == NULL) {
+		log_err(errno, __func__, newpath);
+		return (-1);
+	}
+
+	fprintf(fp, "{\n  \"time\": %ld,\n  \"since\": %ld,\n  \"task_backlog\": %ld",
+		(long) time_now, (long) svr_metrics.since, work_task_backlog());
+	fprintf(fp, ",\n  \"loop\": ");
+	pbs_hist_print_json(fp, &svr_metrics.loop);
+	fprintf(fp, ",\n  \"tasks\": ");
+	pbs_hist_print_json(fp, &svr_metrics.tasks);
+	fprintf(fp, ",\n  \"task_lag\": ");
+	pbs_hist_print_json(fp, work_task_lag());
+	fprintf(fp, ",\n  \"db\": {");
+	for (i = 0; i < PBS_DB_NUM_OPS; i++) {
+		if ((h = pbs_db_latency(i)) == NULL)
+			continue;
+		fprintf(fp, "%s\n    \"%s\": ", i ? "," : "", db_op_names[i]);
+		pbs_hist_print_json(fp, h);
+	}
+	fprintf(fp, "\n  }");
+	print_hist_array(fp, "request_service", svr_metrics.req_svc, SVR_METRICS_NREQ);
+	print_hist_array(fp, "request_total", svr_metrics.req_total, SVR_METRICS_NREQ);
+	print_hist_array(fp, "is_message", svr_metrics.is_msg, SVR_METRICS_NIS);
+	fprintf(fp, ",\n  \"memory\": ");
+	svr_mem_print_json(fp);
+	fprintf(fp, "\n}\n");
+
+	if (ferror(fp) || fflush(fp) != 0) {
+		log_err(errno, __func__, newpath);
+		(void) fclose(fp);
+		(void) unlink(newpath);
+		return (-1);
+	}
+	if (fclose(fp) != 0 || rename(newpath, path) == -1) {
+		log_err(errno, __func__, path);
+		(void) unlink(newpath);
+		return (-1);
+	}
+	return (0);
+}
+
+/**
+ * @brief
+ * 		server_metrics_dump - work task to dump the histograms, re-arms
+ * 		itself every PBS_SERVER_METRICS seconds.
+ *
+ * @param[in]	ptask	- work task, unused
+ *
+ * @return	void
+ */
+void
+server_metrics_dump(struct work_task *ptask)
+{
+	if (pbs_conf.pbs_server_metrics == 0)
+		return;
+
+	(void) set_task(WORK_Timed, time_now + pbs_conf.pbs_server_metrics,
+			server_metrics_dump, NULL);
+
+	(void) write_server_metrics();
+}
+
+/**
+ * @brief
+ * 		Write the non-empty histograms of an array as one Prometheus
+ * 		histogram family, labelled by their index
+ */
+static void
+print_prom_array(FILE *fp, const char *name, const char *label, const pbs_hist_t *h, int n)
+{
+	char labels[64];
+	int i;
+
+	fprintf(fp, "# TYPE %s histogram\n", name);
+	for (i = 0; i < n; i++) {
+		if (h[i].count == 0)
+			continue;
+		snprintf(labels, sizeof(labels), "%s=\"%d\"", label, i);
+		pbs_hist_print_prom(fp, name, labels, &h[i]);
+	}
+}
+
+/**
+ * @brief
+ * 		server_metrics_export - work task to publish a snapshot of the
+ * 		server metrics to the metrics socket, re-arms itself every
+ * 		PBS_METRICS_EXPORT seconds.  The first call starts the thread
+ * 		serving the socket.
+ *
+ * @param[in]	ptask	- work task, unused
+ *
+ * @return	void
+ */
+void
+server_metrics_export(struct work_task *ptask)
+{
+	static int started = 0;
+	static char *statename[] = {"Transit", "Queued", "Held", "Waiting",
+				    "Running", "Exiting", "Expired", "Begun",
+				    "Moved", "Finished"};
+	char path[MAXPATHLEN + 1];
+	char labels[64];
+	char *text = NULL;
+	size_t len = 0;
+	const pbs_hist_t *h;
+	FILE *fp;
+	int i;
+
+	if (pbs_conf.pbs_metrics_export == 0)
+		return;
+
+	(void) set_task(WORK_Timed, time_now + pbs_conf.pbs_metrics_export,
+			server_metrics_export, NULL);
+
+	if (!started) {
+		snprintf(path, sizeof(path), "%s/%s", path_priv, SVR_METRICS_SOCK);
+		if (pbs_metrics_export_start(path) != 0) {
+			log_err(errno, __func__, path);
+			return;
+		}
+		started = 1;
+	}
+
+	if ((fp = open_memstream(&text, &len)) == NULL) {
+		log_err(errno, __func__, "open_memstream");
+		return;
+	}
+
+	fprintf(fp, "# TYPE pbs_server_jobs gauge\n");
+	for (i = 0; i < PBS_NUMJOBSTATE; i++)
+		fprintf(fp, "pbs_server_jobs{state=\"%s\"} %d\n", statename[i],
+			server.sv_jobstates[i]);
+	fprintf(fp, "# TYPE pbs_server_nodes gauge\npbs_server_nodes %d\n", svr_totnodes);
+	fprintf(fp, "# TYPE pbs_server_task_backlog gauge\npbs_server_task_backlog %ld\n",
+		work_task_backlog());
+	fprintf(fp, "# TYPE pbs_server_tpp_app_backlog_bytes gauge\n"
+		    "pbs_server_tpp_app_backlog_bytes %d\n",
+		tpp_app_backlog());
+	fprintf(fp, "# TYPE pbs_server_tpp_send_backlog_bytes gauge\n"
+		    "pbs_server_tpp_send_backlog_bytes %d\n",
+		tpp_transport_backlog());
+
+	fprintf(fp, "# TYPE pbs_server_loop_seconds histogram\n");
+	pbs_hist_print_prom(fp, "pbs_server_loop_seconds", NULL, &svr_metrics.loop);
+	fprintf(fp, "# TYPE pbs_server_tasks_seconds histogram\n");
+	pbs_hist_print_prom(fp, "pbs_server_tasks_seconds", NULL, &svr_metrics.tasks);
+	fprintf(fp, "# TYPE pbs_server_task_lag_seconds histogram\n");
+	pbs_hist_print_prom(fp, "pbs_server_task_lag_seconds", NULL, work_task_lag());
+	fprintf(fp, "# TYPE pbs_server_db_seconds histogram\n");
+	for (i = 0; i < PBS_DB_NUM_OPS; i++) {
+		if ((h = pbs_db_latency(i)) == NULL)
+			continue;
+		snprintf(labels, sizeof(labels), "op=\"%s\"", db_op_names[i]);
+		pbs_hist_print_prom(fp, "pbs_server_db_seconds", labels, h);
+	}
+	print_prom_array(fp, "pbs_server_request_seconds", "type", svr_metrics.req_svc, SVR_METRICS_NREQ);
+	print_prom_array(fp, "pbs_server_request_total_seconds", "type", svr_metrics.req_total, SVR_METRICS_NREQ);
+	print_prom_array(fp, "pbs_server_is_message_seconds", "type", svr_metrics.is_msg, SVR_METRICS_NIS);
+	svr_mem_print_prom(fp);
+
+	if (ferror(fp)) {
+		(void) fclose(fp);
+		free(text);
+		return;
+	}
+	(void) fclose(fp);
+	pbs_metrics_export_publish(text);
+}
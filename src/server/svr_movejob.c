@@ -83,6 +83,7 @@
 #include "hook.h"
 #include "pbs_sched.h"
 #include "acct.h"
+#include "pbs_usdt.h"
 
 #define RETRY 3 /* number of times to retry network move */
 
@@ -704,6 +705,11 @@ send_job(job *jobp, pbs_net_t hostaddr, int port, int move_type,
 	struct in_addr addr;
 	long tempval;
 
+	PBS_PROBE3(send__job, jobp->ji_qs.ji_jobid, (long) hostaddr, move_type);
+
+	/* the receiving side must not get ahead of the database */
+	job_save_db_flush();
+
 	/* if job has a script read it from database */
 	if (jobp->ji_qs.ji_svrflags & JOB_SVFLG_SCRIPT) {
 		if (svr_load_jobscript(jobp) == NULL) {
@@ -1131,22 +1137,29 @@ cnvrt_local_move(job *jobp, struct batch_request *req)
  * @brief
  * 		check size of job files
  * @par
- * 		Checks the size of the job-script/output/error/checkpoint files for a job.
- * 		If the job is not being rerun, simply returns 1.
+ * 		Checks the size of the job-script/output/error/checkpoint files for a job
+ *		against the most we send to a mom over TPP (PBS_JOB_FILE_TPP_MAX
+ *		megabytes, 2MB by default).  Jobs with larger files are sent by a
+ *		forked child over TCP.  If the job is not being rerun, only the
+ *		script is checked.
  *
  * @return	int
- * @retval	0	: at least one file is larger than 2MB.
- * @retval	1	: all job files are smaller than 2MB.
+ * @retval	0	: at least one file is larger than the limit.
+ * @retval	1	: all job files fit within the limit.
  */
 static int
 small_job_files(job *pjob)
 {
-	int max_bytes_over_tpp = 2 * 1024 * 1024;
-	char path[MAXPATHLEN + 1] = {0};
+	off_t max_bytes_over_tpp = (off_t) 2 * 1024 * 1024;
+	static const char *suffixes[] = {JOB_STDOUT_SUFFIX, JOB_STDERR_SUFFIX, JOB_CKPT_SUFFIX};
+	char path[MAXPATHLEN + 1];
 	struct stat sb;
-	int have_file_prefix = 0;
+	int i;
 
-	if (pjob->ji_script && (strlen(pjob->ji_script) > max_bytes_over_tpp))
+	if (pbs_conf.pbs_job_file_tpp_max > 0)
+		max_bytes_over_tpp = (off_t) pbs_conf.pbs_job_file_tpp_max * 1024 * 1024;
+
+	if (pjob->ji_script && ((off_t) strlen(pjob->ji_script) > max_bytes_over_tpp))
 		return 0;
 
 	/*
@@ -1156,34 +1169,13 @@ small_job_files(job *pjob)
 	if (!(pjob->ji_qs.ji_svrflags & JOB_SVFLG_HASRUN))
 		return 1;
 
-	if (*pjob->ji_qs.ji_fileprefix != '\0')
-		have_file_prefix = 1;
-
-	if (have_file_prefix)
-		snprintf(path, MAXPATHLEN, "%s%s%s", path_spool, pjob->ji_qs.ji_fileprefix, JOB_STDOUT_SUFFIX);
-	else
-		snprintf(path, MAXPATHLEN, "%s%s%s", path_spool, pjob->ji_qs.ji_jobid, JOB_STDOUT_SUFFIX);
-	if ((access(path, F_OK) == 0) && !stat(path, &sb))
-		if (sb.st_size > max_bytes_over_tpp)
-			return 0;
-
-	memset(path, 0, sizeof(path));
-	if (have_file_prefix)
-		snprintf(path, MAXPATHLEN, "%s%s%s", path_spool, pjob->ji_qs.ji_fileprefix, JOB_STDERR_SUFFIX);
-	else
-		snprintf(path, MAXPATHLEN, "%s%s%s", path_spool, pjob->ji_qs.ji_jobid, JOB_STDERR_SUFFIX);
-	if ((access(path, F_OK) == 0) && !stat(path, &sb))
-		if (sb.st_size > max_bytes_over_tpp)
-			return 0;
-
-	memset(path, 0, sizeof(path));
-	if (have_file_prefix)
-		snprintf(path, MAXPATHLEN, "%s%s%s", path_spool, pjob->ji_qs.ji_fileprefix, JOB_CKPT_SUFFIX);
-	else
-		snprintf(path, MAXPATHLEN, "%s%s%s", path_spool, pjob->ji_qs.ji_jobid, JOB_CKPT_SUFFIX);
-	if ((access(path, F_OK) == 0) && !stat(path, &sb))
-		if (sb.st_size > max_bytes_over_tpp)
+	for (i = 0; i < (int) (sizeof(suffixes) / sizeof(suffixes[0])); i++) {
+		snprintf(path, sizeof(path), "%s%s%s", path_spool,
+			 *pjob->ji_qs.ji_fileprefix != '\0' ? pjob->ji_qs.ji_fileprefix : pjob->ji_qs.ji_jobid,
+			 suffixes[i]);
+		if (stat(path, &sb) == 0 && sb.st_size > max_bytes_over_tpp)
 			return 0;
+	}
 
 	return 1;
 }
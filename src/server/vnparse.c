@@ -69,6 +69,7 @@
 static vnal_t *vnal_alloc(vnal_t **);
 static vnal_t *id2vnrl(vnl_t *, char *);
 static vna_t *attr2vnr(vnal_t *, char *);
+static int strcat_grow(char **, char **, size_t *, char *);
 
 static const char iddelim = ':';
 static const char attrdelim = '=';
@@ -1592,7 +1593,15 @@ pbs_release_nodes_given_nodelist(relnodes_input_t *r_input, relnodes_input_vnode
 	char buf[LOG_BUF_SIZE] = {0};
 	struct pbsnode *pnode = NULL;
 	int rc = 1;
-	int ns_malloced = 0;
+	size_t ns_size = 0;
+	char *ns_cur = NULL;
+	char *nev_end = NULL;
+	char *neh_end = NULL;
+	char *neh2_end = NULL;
+	char *dev_end = NULL;
+	void *rel_idx = NULL;
+	void *freed_idx = NULL;
+	int releasing;
 	char *buf_sum = NULL;
 	int paren = 0;
 	int found_paren = 0;
@@ -1662,6 +1671,7 @@ pbs_release_nodes_given_nodelist(relnodes_input_t *r_input, relnodes_input_vnode
 		goto release_nodeslist_exit;
 	}
 	new_exec_vnode[0] = '\0';
+	nev_end = new_exec_vnode;
 
 	chunk_buf_sz = strlen(exec_vnode) + 1;
 	chunk_buf = (char *) calloc(1, chunk_buf_sz);
@@ -1676,6 +1686,25 @@ pbs_release_nodes_given_nodelist(relnodes_input_t *r_input, relnodes_input_vnode
 		log_err(-1, __func__, "deallocated_execvnode calloc error");
 		goto release_nodeslist_exit;
 	}
+	dev_end = deallocated_execvnode;
+
+	ns_size = strlen(sched_select) + 1;
+	new_select = (char *) calloc(1, ns_size);
+	if (new_select == NULL) {
+		log_err(-1, __func__, "new_select calloc error");
+		goto release_nodeslist_exit;
+	}
+	ns_cur = new_select;
+
+	/* releasing thousands of vnodes at once must not rescan the list */
+	if (r_input2->vnodelist != NULL) {
+		rel_idx = string_list_idx_create(r_input2->vnodelist, '+');
+		freed_idx = pbs_idx_create(0, 0);
+		if ((rel_idx == NULL) || (freed_idx == NULL)) {
+			log_err(-1, __func__, "failed to index vnodelist");
+			goto release_nodeslist_exit;
+		}
+	}
 
 	if (exec_host != NULL) {
 		new_exec_host = (char *) calloc(1, strlen(exec_host) + 1);
@@ -1684,6 +1713,7 @@ pbs_release_nodes_given_nodelist(relnodes_input_t *r_input, relnodes_input_vnode
 			goto release_nodeslist_exit;
 		}
 		new_exec_host[0] = '\0';
+		neh_end = new_exec_host;
 	}
 
 	if (exec_host2 != NULL) {
@@ -1693,6 +1723,7 @@ pbs_release_nodes_given_nodelist(relnodes_input_t *r_input, relnodes_input_vnode
 			goto release_nodeslist_exit;
 		}
 		new_exec_host2[0] = '\0';
+		neh2_end = new_exec_host2;
 	}
 
 	prdefvntype = &svr_resc_def[RESC_VNTYPE];
@@ -1780,9 +1811,10 @@ pbs_release_nodes_given_nodelist(relnodes_input_t *r_input, relnodes_input_vnode
 			}
 #endif
 
+			releasing = in_string_list_idx(noden, rel_idx);
+
 			if (is_parent_host_of_node(pnode, parent_mom, ms_fullhost, ms_port) &&
-			    (r_input2->vnodelist != NULL) &&
-			    in_string_list(noden, '+', r_input2->vnodelist)) {
+			    releasing) {
 				if ((err_msg != NULL) && (err_msg_sz > 0)) {
 					snprintf(err_msg, err_msg_sz,
 						 "Can't free '%s' since it's on a primary execution host", noden);
@@ -1791,8 +1823,7 @@ pbs_release_nodes_given_nodelist(relnodes_input_t *r_input, relnodes_input_vnode
 				goto release_nodeslist_exit;
 			}
 
-			if ((r_input2->vnodelist != NULL) &&
-			    in_string_list(noden, '+', r_input2->vnodelist) && (pnode != NULL) &&
+			if (releasing && (pnode != NULL) &&
 			    (is_nattr_set(pnode, ND_ATR_ResourceAvail) != 0)) {
 				for (prs = (resource *) GET_NEXT(get_nattr_list(pnode, ND_ATR_ResourceAvail)); prs != NULL; prs = (resource *) GET_NEXT(prs->rs_link)) {
 					if ((prdefvntype != NULL) &&
@@ -1815,53 +1846,53 @@ pbs_release_nodes_given_nodelist(relnodes_input_t *r_input, relnodes_input_vnode
 			}
 
 			if (is_parent_host_of_node(pnode, parent_mom, ms_fullhost, ms_port) ||
-			    ((r_input2->vnodelist != NULL) && !in_string_list(noden, '+', r_input2->vnodelist))) {
+			    ((r_input2->vnodelist != NULL) && !releasing)) {
 
 				if (entry > 0) /* there's something put in previously */
-					strcat(new_exec_vnode, "+");
+					nev_end = pbs_strcpy(nev_end, "+");
 
 				if (((hasprn > 0) && (paren > 0)) ||
 				    ((hasprn == 0) && (paren == 0))) {
 					/* at the beginning of chunk for current host */
 					if (!found_paren) {
-						strcat(new_exec_vnode, "(");
+						nev_end = pbs_strcpy(nev_end, "(");
 						found_paren = 1;
 
 						if (h_entry > 0) {
 							/* there's already previous exec_host entry */
 							if (new_exec_host != NULL)
-								strcat(new_exec_host, "+");
+								neh_end = pbs_strcpy(neh_end, "+");
 							if (new_exec_host2 != NULL)
-								strcat(new_exec_host2, "+");
+								neh2_end = pbs_strcpy(neh2_end, "+");
 						}
 
 						if (new_exec_host != NULL)
-							strcat(new_exec_host, chunk1);
+							neh_end = pbs_strcpy(neh_end, chunk1);
 						if (new_exec_host2 != NULL)
-							strcat(new_exec_host2, chunk2);
+							neh2_end = pbs_strcpy(neh2_end, chunk2);
 						h_entry++;
 					}
 				}
 
 				if (!found_paren) {
-					strcat(new_exec_vnode, "(");
+					nev_end = pbs_strcpy(nev_end, "(");
 					found_paren = 1;
 
 					if (h_entry > 0) {
 						/* there's already previous exec_host entry */
 						if (new_exec_host != NULL)
-							strcat(new_exec_host, "+");
+							neh_end = pbs_strcpy(neh_end, "+");
 						if (new_exec_host2 != NULL)
-							strcat(new_exec_host2, "+");
+							neh2_end = pbs_strcpy(neh2_end, "+");
 					}
 
 					if (new_exec_host != NULL)
-						strcat(new_exec_host, chunk1);
+						neh_end = pbs_strcpy(neh_end, chunk1);
 					if (new_exec_host2 != NULL)
-						strcat(new_exec_host2, chunk2);
+						neh2_end = pbs_strcpy(neh2_end, chunk2);
 					h_entry++;
 				}
-				strcat(new_exec_vnode, noden);
+				nev_end = pbs_strcpy(nev_end, noden);
 				entry++;
 
 				for (j = 0; j < nelem; ++j) {
@@ -1880,18 +1911,18 @@ pbs_release_nodes_given_nodelist(relnodes_input_t *r_input, relnodes_input_vnode
 
 					snprintf(buf, sizeof(buf),
 						 ":%s=%s", pkvp[j].kv_keyw, pkvp[j].kv_val);
-					strcat(new_exec_vnode, buf);
+					nev_end = pbs_strcpy(nev_end, buf);
 				}
 
 				if (paren == 0) { /* have all chunks for current host */
 
 					if (found_paren) {
-						strcat(new_exec_vnode, ")");
+						nev_end = pbs_strcpy(nev_end, ")");
 						found_paren = 0;
 					}
 
 					if (found_paren_dealloc) {
-						strcat(deallocated_execvnode, ")");
+						dev_end = pbs_strcpy(dev_end, ")");
 						found_paren_dealloc = 0;
 					}
 
@@ -1908,31 +1939,29 @@ pbs_release_nodes_given_nodelist(relnodes_input_t *r_input, relnodes_input_vnode
 						extra_res = return_missing_resources(chunk3,
 										     res_in_exec_vnode);
 
+						ns_cur += strlen(ns_cur);
 						if (sel_entry > 0) {
 							/* there's already previous select/schedselect entry */
-							if (pbs_strcat(
-								    &new_select,
-								    &ns_malloced,
-								    "+") == NULL) {
-								log_err(-1, __func__, "pbs_strcat failed");
+							if (strcat_grow(&new_select, &ns_cur, &ns_size, "+") == -1) {
+								log_err(-1, __func__, "strcat_grow failed");
 								goto release_nodeslist_exit;
 							}
 						}
-						if (pbs_strcat(&new_select, &ns_malloced, "1") == NULL) {
-							log_err(-1, __func__, "pbs_strcat failed");
+						if (strcat_grow(&new_select, &ns_cur, &ns_size, "1") == -1) {
+							log_err(-1, __func__, "strcat_grow failed");
 							goto release_nodeslist_exit;
 						}
-						if (pbs_strcat(&new_select, &ns_malloced, buf_sum) == NULL) {
-							log_err(-1, __func__, "pbs_strcat failed");
+						if (strcat_grow(&new_select, &ns_cur, &ns_size, buf_sum) == -1) {
+							log_err(-1, __func__, "strcat_grow failed");
 							goto release_nodeslist_exit;
 						}
 						if ((extra_res != NULL) && (extra_res[0] != '\0')) {
-							if (pbs_strcat(&new_select, &ns_malloced, ":") == NULL) {
-								log_err(-1, __func__, "pbs_strcat failed");
+							if (strcat_grow(&new_select, &ns_cur, &ns_size, ":") == -1) {
+								log_err(-1, __func__, "strcat_grow failed");
 								goto release_nodeslist_exit;
 							}
-							if (pbs_strcat(&new_select, &ns_malloced, extra_res) == NULL) {
-								log_err(-1, __func__, "pbs_strcat failed");
+							if (strcat_grow(&new_select, &ns_cur, &ns_size, extra_res) == -1) {
+								log_err(-1, __func__, "strcat_grow failed");
 								goto release_nodeslist_exit;
 							}
 						}
@@ -1942,33 +1971,35 @@ pbs_release_nodes_given_nodelist(relnodes_input_t *r_input, relnodes_input_vnode
 			} else {
 				if (!is_parent_host_of_node(pnode, parent_mom, ms_fullhost, ms_port)) {
 					if (f_entry > 0) { /* there's something put in previously */
-						strcat(deallocated_execvnode, "+");
+						dev_end = pbs_strcpy(dev_end, "+");
 					}
 
 					if (((hasprn > 0) && (paren > 0)) || ((hasprn == 0) && (paren == 0))) {
 						/* at the beginning of chunk for current host */
 						if (!found_paren_dealloc) {
-							strcat(deallocated_execvnode, "(");
+							dev_end = pbs_strcpy(dev_end, "(");
 							found_paren_dealloc = 1;
 						}
 					}
 
 					if (!found_paren_dealloc) {
-						strcat(deallocated_execvnode, "(");
+						dev_end = pbs_strcpy(dev_end, "(");
 						found_paren_dealloc = 1;
 					}
-					strcat(deallocated_execvnode, chunk_buf);
+					dev_end = pbs_strcpy(dev_end, chunk_buf);
 					f_entry++;
+					if (freed_idx != NULL)
+						(void) pbs_idx_insert(freed_idx, noden, freed_idx);
 
 					if (paren == 0) { /* have all chunks for current host */
 
 						if (found_paren) {
-							strcat(new_exec_vnode, ")");
+							nev_end = pbs_strcpy(nev_end, ")");
 							found_paren = 0;
 						}
 
 						if (found_paren_dealloc) {
-							strcat(deallocated_execvnode, ")");
+							dev_end = pbs_strcpy(dev_end, ")");
 							found_paren_dealloc = 0;
 						}
 					}
@@ -1977,11 +2008,11 @@ pbs_release_nodes_given_nodelist(relnodes_input_t *r_input, relnodes_input_vnode
 				if (hasprn < 0) {
 					/* matched ')' in chunk, so need to balance the parenthesis */
 					if (found_paren) {
-						strcat(new_exec_vnode, ")");
+						nev_end = pbs_strcpy(nev_end, ")");
 						found_paren = 0;
 					}
 					if (found_paren_dealloc) {
-						strcat(deallocated_execvnode, ")");
+						dev_end = pbs_strcpy(dev_end, ")");
 						found_paren_dealloc = 0;
 					}
 
@@ -1998,28 +2029,29 @@ pbs_release_nodes_given_nodelist(relnodes_input_t *r_input, relnodes_input_vnode
 						extra_res = return_missing_resources(chunk3,
 										     res_in_exec_vnode);
 
+						ns_cur += strlen(ns_cur);
 						if (sel_entry > 0) {
 							/* there's already previous select/schedselect entry */
-							if (pbs_strcat(&new_select, &ns_malloced, "+") == NULL) {
-								log_err(-1, __func__, "pbs_strcat failed");
+							if (strcat_grow(&new_select, &ns_cur, &ns_size, "+") == -1) {
+								log_err(-1, __func__, "strcat_grow failed");
 								goto release_nodeslist_exit;
 							}
 						}
-						if (pbs_strcat(&new_select, &ns_malloced, "1") == NULL) {
-							log_err(-1, __func__, "pbs_strcat failed");
+						if (strcat_grow(&new_select, &ns_cur, &ns_size, "1") == -1) {
+							log_err(-1, __func__, "strcat_grow failed");
 							goto release_nodeslist_exit;
 						}
-						if (pbs_strcat(&new_select, &ns_malloced, buf_sum) == NULL) {
-							log_err(-1, __func__, "pbs_strcat failed");
+						if (strcat_grow(&new_select, &ns_cur, &ns_size, buf_sum) == -1) {
+							log_err(-1, __func__, "strcat_grow failed");
 							goto release_nodeslist_exit;
 						}
 						if ((extra_res != NULL) && (extra_res[0] != '\0')) {
-							if (pbs_strcat(&new_select, &ns_malloced, ":") == NULL) {
-								log_err(-1, __func__, "pbs_strcat failed");
+							if (strcat_grow(&new_select, &ns_cur, &ns_size, ":") == -1) {
+								log_err(-1, __func__, "strcat_grow failed");
 								goto release_nodeslist_exit;
 							}
-							if (pbs_strcat(&new_select, &ns_malloced, extra_res) == NULL) {
-								log_err(-1, __func__, "pbs_strcat failed");
+							if (strcat_grow(&new_select, &ns_cur, &ns_size, extra_res) == -1) {
+								log_err(-1, __func__, "strcat_grow failed");
 								goto release_nodeslist_exit;
 							}
 						}
@@ -2089,8 +2121,8 @@ pbs_release_nodes_given_nodelist(relnodes_input_t *r_input, relnodes_input_vnode
 	    (err_msg_sz > 0)) {
 		char *tmpbuf;
 		char *tmpbuf2;
+		char *tmpbuf2_end;
 		char *pc = NULL;
-		char *pc1 = NULL;
 		char *save_ptr; /* posn for strtok_r() */
 
 		tmpbuf = strdup(r_input2->vnodelist);
@@ -2099,22 +2131,15 @@ pbs_release_nodes_given_nodelist(relnodes_input_t *r_input, relnodes_input_vnode
 		if ((tmpbuf != NULL) && (tmpbuf2 != NULL)) {
 
 			tmpbuf2[0] = '\0';
+			tmpbuf2_end = tmpbuf2;
 
 			pc = strtok_r(tmpbuf, "+", &save_ptr);
 			while (pc != NULL) {
-				/* trying to match '(<vnode_name>:'
-				 *  or '+<vnode_name>:'
-				 */
-				snprintf(chunk_buf, chunk_buf_sz, "(%s:", pc);
-				pc1 = strstr(deallocated_execvnode, chunk_buf);
-				if (pc1 == NULL) {
-					snprintf(chunk_buf, chunk_buf_sz, "+%s:", pc);
-					pc1 = strstr(deallocated_execvnode, chunk_buf);
-				}
-				if (pc1 == NULL) {
+				/* freed_idx has the vnodes put in deallocated_execvnode */
+				if (!in_string_list_idx(pc, freed_idx)) {
 					if (tmpbuf2[0] != '\0')
-						strcat(tmpbuf2, " ");
-					strcat(tmpbuf2, pc);
+						tmpbuf2_end = pbs_strcpy(tmpbuf2_end, " ");
+					tmpbuf2_end = pbs_strcpy(tmpbuf2_end, pc);
 				}
 				pc = strtok_r(NULL, "+", &save_ptr);
 			}
@@ -2169,6 +2194,10 @@ pbs_release_nodes_given_nodelist(relnodes_input_t *r_input, relnodes_input_vnode
 	rc = 0;
 
 release_nodeslist_exit:
+	if (rel_idx != NULL)
+		pbs_idx_destroy(rel_idx);
+	if (freed_idx != NULL)
+		pbs_idx_destroy(freed_idx);
 	free(ms_fullhost);
 	free(res_in_exec_vnode);
 	free(chunk_buf);
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file
+ *		pbs_journal2json.c
+ *
+ * @brief
+ *		Convert binary log journals, written next to the daemon logs when
+ *		PBS_LOG_JOURNAL is set, into a JSON array of records.
+ *
+ * Functions included are:
+ * 	journal_to_json()
+ * 	main()
+ *
+ */
+#include <pbs_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "pbs_version.h"
+#include "log.h"
+#include "pbs_json.h"
+
+/**
+ * @brief
+ *		journal_to_json - print each record of one journal as a JSON object
+ *
+ * @param[in]	fp	-	the journal, positioned at its start
+ * @param[in]	name	-	name of the journal, for error messages
+ * @param[in,out] first	-	set while no record has been printed yet
+ *
+ * @return	int
+ * @retval	0	: the whole journal was converted
+ * @retval	1	: the journal is bad or truncated
+ */
+static int
+journal_to_json(FILE *fp, const char *name, int *first)
+{
+	log_journal_rec rec;
+	json_data *obj;
+	int rc;
+
+	if (log_journal_read_header(fp) != 0) {
+		fprintf(stderr, "pbs_journal2json: %s is not a log journal\n", name);
+		return 1;
+	}
+
+	while ((rc = log_journal_read(fp, &rec)) == 1) {
+		if ((obj = pbs_json_create_object()) == NULL) {
+			log_journal_free_rec(&rec);
+			rc = -1;
+			break;
+		}
+		if (pbs_json_insert_number(obj, "time", (double) (rec.lj_time / 1000000)) ||
+		    pbs_json_insert_number(obj, "usec", (double) (rec.lj_time % 1000000)) ||
+		    pbs_json_insert_number(obj, "event", rec.lj_eventtype) ||
+		    pbs_json_insert_string(obj, "class", (char *) log_class_name(rec.lj_objclass)) ||
+		    pbs_json_insert_number(obj, "severity", rec.lj_sev) ||
+		    pbs_json_insert_string(obj, "object", rec.lj_objname) ||
+		    pbs_json_insert_string(obj, "message", rec.lj_text)) {
+			pbs_json_delete(obj);
+			log_journal_free_rec(&rec);
+			rc = -1;
+			break;
+		}
+		if (!*first)
+			printf(",\n");
+		*first = 0;
+		(void) pbs_json_print(obj, stdout);
+		pbs_json_delete(obj);
+		log_journal_free_rec(&rec);
+	}
+
+	if (rc < 0) {
+		fprintf(stderr, "pbs_journal2json: bad or truncated record in %s\n", name);
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *		main - convert the journals named on the command line, or stdin
+ *
+ * @return	int
+ * @retval	0	: success
+ * @retval	1	: a journal could not be read or converted
+ */
+int
+main(int argc, char *argv[])
+{
+	FILE *fp;
+	int first = 1;
+	int rc = 0;
+	int i;
+
+	PRINT_VERSION_AND_EXIT(argc, argv);
+
+	printf("[\n");
+	if (argc < 2)
+		rc = journal_to_json(stdin, "stdin", &first);
+	for (i = 1; i < argc; i++) {
+		if ((fp = fopen(argv[i], "rb")) == NULL) {
+			perror(argv[i]);
+			rc = 1;
+			continue;
+		}
+		if (journal_to_json(fp, argv[i], &first) != 0)
+			rc = 1;
+		fclose(fp);
+	}
+	printf("]\n");
+
+	return rc;
+}
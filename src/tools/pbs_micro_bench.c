@@ -0,0 +1,550 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file pbs_micro_bench.c
+ *
+ * @brief
+ *	pbs_micro_bench - Time the core primitives the daemons are built on.
+ *
+ * @par Functionality
+ *	Runs tight loops over the attribute decode/encode routines of Libattr
+ *	(string, array of strings and resource list), DIS encode/decode of a
+ *	large svrattrl list over an in-memory transport, pbs_idx insert, find,
+ *	iterate and delete, range and range_set operations, and log_record().
+ *	Each result is printed as one element of a JSON array giving the
+ *	number of operations, nanoseconds per operation and operations per
+ *	second, so that runs can be compared across builds.
+ *
+ * Functions included are:
+ * 	main()
+ * 	now_nsec()
+ * 	report()
+ * 	bench_attr_str()
+ * 	bench_attr_arst()
+ * 	bench_attr_resc()
+ * 	bench_dis()
+ * 	bench_idx()
+ * 	bench_range()
+ * 	bench_log()
+ * 	mem_get_chan()
+ * 	mem_set_chan()
+ * 	mem_send()
+ * 	mem_recv()
+ */
+#include <pbs_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include "pbs_ifl.h"
+#include "pbs_internal.h"
+#include "list_link.h"
+#include "attribute.h"
+#include "resource.h"
+#include "batch_request.h"
+#include "libpbs.h"
+#include "dis.h"
+#include "pbs_idx.h"
+#include "range.h"
+#include "log.h"
+
+#define BENCH_DEF_ITER 100000
+#define BENCH_DEF_KEYS 1000000
+#define BENCH_DEF_ATTRS 1000
+#define BENCH_MEM_FD 0 /* fd handed to DIS for the in-memory transport */
+
+extern int resc_access_perm;
+
+/*
+ * Resource definitions used by decode_resc()/encode_resc().  The tool
+ * supplies its own small table rather than the generated svr_resc_def,
+ * whose action routines live in the server.
+ */
+static resource_def bench_resc_def[] = {
+	{"ncpus", decode_l, encode_l, set_l, comp_l, free_null, NULL_FUNC_RESC, READ_WRITE, ATR_TYPE_LONG},
+	{"mem", decode_size, encode_size, set_size, comp_size, free_null, NULL_FUNC_RESC, READ_WRITE, ATR_TYPE_SIZE},
+	{"walltime", decode_time, encode_time, set_l, comp_l, free_null, NULL_FUNC_RESC, READ_WRITE, ATR_TYPE_LONG},
+	{"arch", decode_str, encode_str, set_str, comp_str, free_str, NULL_FUNC_RESC, READ_WRITE, ATR_TYPE_STR},
+	{"software", decode_str, encode_str, set_str, comp_str, free_str, NULL_FUNC_RESC, READ_WRITE, ATR_TYPE_STR},
+	{"host", decode_str, encode_str, set_str, comp_str, free_str, NULL_FUNC_RESC, READ_WRITE, ATR_TYPE_STR}};
+
+resource_def *svr_resc_def = bench_resc_def;
+int svr_resc_size = sizeof(bench_resc_def) / sizeof(bench_resc_def[0]);
+
+static int nreported = 0;
+
+/* in-memory DIS transport, everything sent is queued for the next recv */
+static pbs_tcp_chan_t *mem_chan = NULL;
+static char *mem_data = NULL;
+static size_t mem_size = 0;
+static size_t mem_len = 0;
+static size_t mem_off = 0;
+
+/**
+ * @brief
+ *	Current monotonic time in nanoseconds
+ */
+static long long
+now_nsec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((long long) ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
+
+/**
+ * @brief
+ *	Print the result of one benchmark as a JSON object
+ *
+ * @param[in] name - benchmark name
+ * @param[in] ops  - number of operations timed
+ * @param[in] ns   - time (nsec) the operations took
+ */
+static void
+report(const char *name, long ops, long long ns)
+{
+	if (ns <= 0)
+		ns = 1;
+	printf("%s\n  {\"name\": \"%s\", \"ops\": %ld, \"ns_per_op\": %.1f, \"ops_per_sec\": %.0f}",
+	       nreported++ ? "," : "", name, ops, (double) ns / ops, ops * 1e9 / ns);
+	fflush(stdout);
+}
+
+static pbs_tcp_chan_t *
+mem_get_chan(int fd)
+{
+	errno = 0;
+	return mem_chan;
+}
+
+static int
+mem_set_chan(int fd, pbs_tcp_chan_t *chan)
+{
+	mem_chan = chan;
+	return 0;
+}
+
+static int
+mem_send(int fd, void *data, int len)
+{
+	if (mem_len + len > mem_size) {
+		size_t nsize = (mem_len + len) * 2;
+		char *p = realloc(mem_data, nsize);
+
+		if (p == NULL)
+			return -1;
+		mem_data = p;
+		mem_size = nsize;
+	}
+	memcpy(mem_data + mem_len, data, len);
+	mem_len += len;
+	return len;
+}
+
+static int
+mem_recv(int fd, void *data, int len)
+{
+	if (mem_off + len > mem_len)
+		return 0;
+	memcpy(data, mem_data + mem_off, len);
+	mem_off += len;
+	return len;
+}
+
+/**
+ * @brief
+ *	decode_str/encode_str/free_str round trips
+ */
+static void
+bench_attr_str(long iter)
+{
+	attribute attr;
+	pbs_list_head head;
+	svrattrl *pal;
+	long i;
+	long long start;
+
+	CLEAR_HEAD(head);
+	memset(&attr, 0, sizeof(attr));
+	start = now_nsec();
+	for (i = 0; i < iter; i++) {
+		decode_str(&attr, ATTR_N, NULL, "a_fairly_typical_job_name_of_some_length_0123456789");
+		encode_str(&attr, &head, ATTR_N, NULL, ATR_ENCODE_CLIENT, &pal);
+		free_attrlist(&head);
+		free_str(&attr);
+	}
+	report("attr_str_decode_encode", iter, now_nsec() - start);
+}
+
+/**
+ * @brief
+ *	decode_arst/encode_arst/free_arst round trips of a 32 element list
+ */
+static void
+bench_attr_arst(long iter)
+{
+	attribute attr;
+	pbs_list_head head;
+	svrattrl *pal;
+	char val[32 * 24];
+	char *p = val;
+	long i;
+	long long start;
+
+	for (i = 0; i < 32; i++)
+		p += sprintf(p, "%sVARIABLE_%02ld=value%ld", i ? "," : "", i, i);
+
+	CLEAR_HEAD(head);
+	memset(&attr, 0, sizeof(attr));
+	start = now_nsec();
+	for (i = 0; i < iter; i++) {
+		decode_arst(&attr, ATTR_v, NULL, val);
+		encode_arst(&attr, &head, ATTR_v, NULL, ATR_ENCODE_CLIENT, &pal);
+		free_attrlist(&head);
+		free_arst(&attr);
+	}
+	report("attr_arst_decode_encode", iter, now_nsec() - start);
+}
+
+/**
+ * @brief
+ *	decode_resc/encode_resc/free_resc round trips of a resource list
+ */
+static void
+bench_attr_resc(long iter)
+{
+	static char *rescs[][2] = {{"ncpus", "8"}, {"mem", "16gb"}, {"walltime", "01:00:00"},
+				   {"arch", "linux"}, {"software", "app_v2"}, {"host", "node0001"}};
+	attribute attr;
+	pbs_list_head head;
+	svrattrl *pal;
+	long i;
+	int j;
+	long long start;
+
+	resc_access_perm = ATR_DFLAG_ACCESS;
+	CLEAR_HEAD(head);
+	memset(&attr, 0, sizeof(attr));
+	start = now_nsec();
+	for (i = 0; i < iter; i++) {
+		for (j = 0; j < (int) (sizeof(rescs) / sizeof(rescs[0])); j++)
+			decode_resc(&attr, ATTR_l, rescs[j][0], rescs[j][1]);
+		encode_resc(&attr, &head, ATTR_l, NULL, ATR_ENCODE_CLIENT, &pal);
+		free_attrlist(&head);
+		free_resc(&attr);
+	}
+	report("attr_resc_decode_encode", iter, now_nsec() - start);
+}
+
+/**
+ * @brief
+ *	DIS encode and decode of a large svrattrl list, as in a job status
+ *	reply or a job move
+ */
+static void
+bench_dis(long iter, int nattrs)
+{
+	pbs_list_head head;
+	pbs_list_head rhead;
+	svrattrl *pal;
+	char name[32];
+	long i;
+	long long start;
+	long long enc = 0;
+	long long dec = 0;
+	long bytes = 0;
+
+	pfn_transport_get_chan = mem_get_chan;
+	pfn_transport_set_chan = mem_set_chan;
+	pfn_transport_send = mem_send;
+	pfn_transport_recv = mem_recv;
+	dis_setup_chan(BENCH_MEM_FD, mem_get_chan);
+
+	CLEAR_HEAD(head);
+	for (i = 0; i < nattrs; i++) {
+		snprintf(name, sizeof(name), "attribute_%ld", i);
+		pal = attrlist_create(name, (i % 4) ? NULL : "resource", 33);
+		snprintf(pal->al_value, 33, "value_%026ld", i);
+		append_link(&head, &pal->al_link, pal);
+	}
+
+	iter = iter / nattrs + 1;
+	for (i = 0; i < iter; i++) {
+		mem_len = mem_off = 0;
+		start = now_nsec();
+		if (encode_DIS_svrattrl(BENCH_MEM_FD, (svrattrl *) GET_NEXT(head)) != 0 ||
+		    dis_flush(BENCH_MEM_FD) != 0) {
+			fprintf(stderr, "DIS encode failed\n");
+			return;
+		}
+		enc += now_nsec() - start;
+		bytes = mem_len;
+
+		CLEAR_HEAD(rhead);
+		start = now_nsec();
+		if (decode_DIS_svrattrl(BENCH_MEM_FD, &rhead) != 0) {
+			fprintf(stderr, "DIS decode failed\n");
+			return;
+		}
+		dec += now_nsec() - start;
+		free_attrlist(&rhead);
+	}
+	free_attrlist(&head);
+	dis_destroy_chan(BENCH_MEM_FD);
+	free(mem_data);
+	mem_data = NULL;
+	mem_size = 0;
+
+	report("dis_svrattrl_encode", iter * nattrs, enc);
+	report("dis_svrattrl_decode", iter * nattrs, dec);
+	printf(",\n  {\"name\": \"dis_svrattrl_bytes\", \"attrs\": %d, \"bytes\": %ld}", nattrs, bytes);
+}
+
+/**
+ * @brief
+ *	pbs_idx insert, find, iterate and delete over nkeys string keys
+ */
+static void
+bench_idx(long nkeys)
+{
+	void *idx;
+	void *ctx = NULL;
+	void *data;
+	char *keys;
+	char *key;
+	long i;
+	long n;
+	long long start;
+
+	if ((keys = malloc(nkeys * 16)) == NULL || (idx = pbs_idx_create(0, 0)) == NULL) {
+		fprintf(stderr, "out of memory\n");
+		free(keys);
+		return;
+	}
+	/* keys are scattered so that inserts do not arrive in order */
+	for (i = 0; i < nkeys; i++)
+		snprintf(keys + i * 16, 16, "%ld.svr", (i * 2654435761UL) % 1000000007UL);
+
+	start = now_nsec();
+	for (i = 0; i < nkeys; i++)
+		pbs_idx_insert(idx, keys + i * 16, keys + i * 16);
+	report("idx_insert", nkeys, now_nsec() - start);
+
+	start = now_nsec();
+	for (i = 0; i < nkeys; i++) {
+		key = keys + ((i * 7919) % nkeys) * 16;
+		pbs_idx_find(idx, (void **) &key, &data, NULL);
+	}
+	report("idx_find", nkeys, now_nsec() - start);
+
+	n = 0;
+	start = now_nsec();
+	while (pbs_idx_find(idx, NULL, &data, &ctx) == PBS_IDX_RET_OK)
+		n++;
+	pbs_idx_free_ctx(ctx);
+	report("idx_iterate", n, now_nsec() - start);
+
+	start = now_nsec();
+	for (i = 0; i < nkeys; i++)
+		pbs_idx_delete(idx, keys + i * 16);
+	report("idx_delete", nkeys, now_nsec() - start);
+
+	pbs_idx_destroy(idx);
+	free(keys);
+}
+
+/**
+ * @brief
+ *	range and range_set operations of the kind used for array subjob
+ *	tracking
+ */
+static void
+bench_range(long iter)
+{
+	range *r;
+	range_set *rs;
+	long i;
+	long hits = 0;
+	long long start;
+
+	start = now_nsec();
+	for (i = 0; i < iter; i++) {
+		r = range_parse("1-10000,20000-30000:2,40000,50000-60000");
+		free_range_list(r);
+	}
+	report("range_parse", iter, now_nsec() - start);
+
+	r = range_parse("1-100000");
+	start = now_nsec();
+	for (i = 0; i < iter; i++)
+		range_remove_value(&r, (i * 7919) % 100000 + 1);
+	report("range_remove_value", iter, now_nsec() - start);
+
+	start = now_nsec();
+	for (i = 0; i < iter; i++)
+		hits += range_contains(r, (i * 104729) % 100000 + 1);
+	report("range_contains", iter, now_nsec() - start);
+
+	start = now_nsec();
+	for (i = 0; i < iter; i++)
+		range_add_value(&r, (i * 7919) % 100000 + 1, 1);
+	report("range_add_value", iter, now_nsec() - start);
+	free_range_list(r);
+
+	/* a fragmented list, as left by subjobs finishing out of order */
+	r = range_parse("1-30000");
+	for (i = 3; i <= 30000; i += 3)
+		range_remove_value(&r, (int) i);
+	start = now_nsec();
+	for (i = 0; i < iter / 100 + 1; i++)
+		hits += strlen(range_to_str(r));
+	report("range_to_str", iter / 100 + 1, now_nsec() - start);
+	free_range_list(r);
+
+	rs = new_range_set(1, 100000, 1);
+	start = now_nsec();
+	for (i = 0; i < iter; i++)
+		range_set_add_value(rs, (i * 7919) % 100000 + 1);
+	for (i = 0; i < iter; i++)
+		hits += range_set_contains(rs, (i * 104729) % 100000 + 1);
+	for (i = 0; i < iter; i++)
+		range_set_remove_value(rs, (i * 7919) % 100000 + 1);
+	report("range_set_add_contains_remove", iter * 3, now_nsec() - start);
+
+	free_range_set(rs);
+
+	if (hits < 0) /* keep the lookups from being optimized away */
+		printf("%ld", hits);
+}
+
+/**
+ * @brief
+ *	log_record() throughput into a scratch log file
+ */
+static void
+bench_log(long iter, char *dir)
+{
+	char path[MAXPATHLEN + 1];
+	long i;
+	long long start;
+
+	snprintf(path, sizeof(path), "%s/pbs_micro_bench.%d.log", dir, (int) getpid());
+	if (log_open(path, dir) != 0) {
+		fprintf(stderr, "cannot open log %s\n", path);
+		return;
+	}
+	start = now_nsec();
+	for (i = 0; i < iter; i++)
+		log_record(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, LOG_INFO, "123456.server",
+			   "Job Run at request of Scheduler@server on exec_vnode (node0001:ncpus=8)");
+	log_close(0);
+	report("log_record", iter, now_nsec() - start);
+	unlink(path);
+}
+
+/**
+ * @brief
+ *	This is main function of pbs_micro_bench.
+ */
+int
+main(int argc, char *argv[])
+{
+	int c;
+	int errflg = 0;
+	long iter = BENCH_DEF_ITER;
+	long nkeys = BENCH_DEF_KEYS;
+	int nattrs = BENCH_DEF_ATTRS;
+	char *which = "attr,dis,idx,range,log";
+	char *logdir = "/tmp";
+
+	while ((c = getopt(argc, argv, "i:k:a:b:L:")) != EOF) {
+		switch (c) {
+			case 'i':
+				iter = atol(optarg);
+				break;
+			case 'k':
+				nkeys = atol(optarg);
+				break;
+			case 'a':
+				nattrs = atoi(optarg);
+				break;
+			case 'b':
+				which = optarg;
+				break;
+			case 'L':
+				logdir = optarg;
+				break;
+			default:
+				errflg++;
+		}
+	}
+	if (errflg || optind != argc || iter < 1 || nkeys < 1 || nattrs < 1) {
+		fprintf(stderr, "usage: %s [-i iterations] [-k idx_keys] [-a dis_attrs]\n"
+				"\t[-b attr,dis,idx,range,log] [-L log_dir]\n",
+			argv[0]);
+		return 1;
+	}
+
+	if (cr_rescdef_idx(svr_resc_def, svr_resc_size) != 0) {
+		fprintf(stderr, "Failed creating resc definition search index\n");
+		return 1;
+	}
+
+	printf("[");
+	if (strstr(which, "attr") != NULL) {
+		bench_attr_str(iter);
+		bench_attr_arst(iter);
+		bench_attr_resc(iter);
+	}
+	if (strstr(which, "dis") != NULL)
+		bench_dis(iter * 10, nattrs);
+	if (strstr(which, "idx") != NULL)
+		bench_idx(nkeys);
+	if (strstr(which, "range") != NULL)
+		bench_range(iter);
+	if (strstr(which, "log") != NULL)
+		bench_log(iter, logdir);
+	printf("\n]\n");
+	return 0;
+}
@@ -59,6 +59,9 @@
  * 	fprint_svrattrl_list()
  * 	fprint_str_array()
  * 	argv_list_to_str()
+ * 	hook_server_sigchld()
+ * 	hook_server_request()
+ * 	hook_server()
  * 	main()
  */
 #include <pbs_config.h>
@@ -100,6 +103,11 @@
 #include "svrfunc.h"
 #include "pbs_sched.h"
 #include "portability.h"
+#ifndef WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#endif
 
 #define PBS_V1_COMMON_MODULE_DEFINE_STUB_FUNCS 1
 #include "pbs_v1_module_common.i"
@@ -110,6 +118,8 @@
 
 #define HOOK_MODE "--hook"
 
+static int hook_server_warm = 0; /* a worker forked by the hook server */
+
 extern char *vnode_state_to_str(int state_bit);
 extern char *vnode_sharing_to_str(enum vnode_sharing vns);
 extern char *vnode_ntype_to_str(int type);
@@ -143,6 +153,8 @@ extern enum vnode_sharing str_to_vnode_sharing(char *sharing_str);
  *
  * @param[in]	event_jobs_svrattrl	-	gets <attribute_name>=EVENT_JOBLIST_OBJECT data
  * 			            				Caution: svrattrl values stored in sorted order
+ * @param[in]	event_resvs_svrattrl	-	gets <attribute_name>=EVENT_RESVLIST_OBJECT data
+ * 			            				Caution: svrattrl values stored in sorted order
  * @param[in]	perf_label - passed on to hook_perf_stat* call.
  * @param[in]	perf_action - passed on to hook_perf_stat* call.
  *
@@ -170,6 +182,7 @@ pbs_python_populate_svrattrl_from_file(char *input_file,
 				       pbs_list_head *job_succeeded_mom_list_svrattrl,
 				       pbs_list_head *event_src_queue_svrattrl, pbs_list_head *event_aoe_svrattrl,
 				       pbs_list_head *event_argv_svrattrl, pbs_list_head *event_jobs_svrattrl,
+				       pbs_list_head *event_resvs_svrattrl,
 				       char *perf_label, char *perf_action)
 {
 
@@ -192,6 +205,7 @@ pbs_python_populate_svrattrl_from_file(char *input_file,
 	int vn_obj_len = strlen(EVENT_VNODELIST_OBJECT);
 	int vn_fail_obj_len = strlen(EVENT_VNODELIST_FAIL_OBJECT);
 	int job_obj_len = strlen(EVENT_JOBLIST_OBJECT);
+	int resv_obj_len = strlen(EVENT_RESVLIST_OBJECT);
 	int b_triple_quotes = 0;
 	int e_triple_quotes = 0;
 	char buf_data[STRBUF];
@@ -589,6 +603,48 @@ pbs_python_populate_svrattrl_from_file(char *input_file,
 				}
 				rc = add_to_svrattrl_list_sorted(event_jobs_svrattrl,
 								 name_str, resc_str, val_str, 0, NULL);
+			} else if (event_resvs_svrattrl && (strncmp(obj_name, EVENT_RESVLIST_OBJECT, resv_obj_len) == 0)) {
+
+				/* pbs.event().resv_list[<resvid>]\0<attribute name>\0<resource name>\0<value>
+				 * where obj_name = pbs.event().resv_list[<resvid>]
+				 *	  name_str = <attribute name>
+				 */
+				if (((pc1 = strchr(obj_name, '[')) != NULL) &&
+				    ((pc2 = strrchr(obj_name, ']')) != NULL) &&
+				    (pc2 > pc1)) {
+					pc1++; /* <resvid> part */
+
+					*pc2 = '.'; /* pbs.event().resv_list[<resvid>. */
+					pc2++;
+
+					pc3 = strchr(pc1, '"');
+					if (pc3 != NULL)
+						pc4 = strchr(pc3 + 1, '"');
+					else
+						pc4 = NULL;
+
+					if (pc3 && pc4 && (pc4 > pc3)) {
+						pc3++;
+						*pc4 = '.';
+						pc4++;
+						strncpy(name_str_buf, name_str, sizeof(name_str_buf) - 1);
+						strcpy(pc4, name_str_buf); /* <resvid>.<attr name> */
+						name_str = pc3;
+					} else {
+						strncpy(name_str_buf, name_str, sizeof(name_str_buf) - 1);
+						strcpy(pc2, name_str_buf); /* <resvid>.<attr name> */
+						name_str = pc1;
+					}
+				} else {
+					snprintf(log_buffer, sizeof(log_buffer),
+						 "object '%s' does not have a reservation name!", obj_name);
+					log_err(-1, __func__, log_buffer);
+					/* process a new line */
+					in_data[0] = '\0';
+					continue;
+				}
+				rc = add_to_svrattrl_list_sorted(event_resvs_svrattrl,
+								 name_str, resc_str, val_str, 0, NULL);
 			} else if (event_src_queue_svrattrl && (strcmp(obj_name, EVENT_SRC_QUEUE_OBJECT) == 0)) {
 				rc = add_to_svrattrl_list(event_src_queue_svrattrl,
 							  name_str, resc_str, val_str, 0, NULL);
@@ -1390,6 +1446,332 @@ argv_list_to_str(pbs_list_head *argv_list)
 	return (ret_string);
 }
 
+#ifndef WIN32
+/**
+ * @brief
+ *		A hook run the hook server forked off, with the socket back to
+ *		the Mom child that asked for it (-1 once that one is gone).
+ */
+struct hook_worker {
+	pid_t hw_pid;
+	int hw_fd;
+};
+
+static int hook_server_sigpipe[2] = {-1, -1}; /* SIGCHLD self-pipe */
+
+/**
+ * @brief
+ *		SIGCHLD handler of the hook server: wake up its poll() loop.
+ *
+ * @param[in]	sig	-	signal number
+ */
+static void
+hook_server_sigchld(int sig)
+{
+	int save_errno = errno;
+
+	(void) write(hook_server_sigpipe[1], "", 1);
+	errno = save_errno;
+}
+
+/**
+ * @brief
+ *		Take one hook run request off the hook server socket and fork
+ *		the worker that runs it.
+ *
+ * @par
+ *		A second descriptor passed with the reply socket is the hook input,
+ *		kept by Mom in memory: the worker reads it in place of the -i file.
+ *
+ * @param[in]	ctlfd	-	the hook server socket
+ * @param[in,out]	workers	-	array of running workers
+ * @param[in,out]	nworkers	-	number of entries used in 'workers'
+ * @param[in,out]	nalloc	-	number of entries allocated in 'workers'
+ * @param[out]	pargc	-	in the worker, argc of the hook command line
+ * @param[out]	pargv	-	in the worker, argv of the hook command line
+ *
+ * @return	int
+ * @retval	1	: returning in the worker, which is to run the hook
+ * @retval	0	: request handled or dropped, in the server
+ * @retval	-1	: the socket was closed, Mom is going away
+ */
+static int
+hook_server_request(int ctlfd, struct hook_worker **workers, int *nworkers,
+		    int *nalloc, int *pargc, char ***pargv)
+{
+	static char msg[HOOK_SERVER_MSG_SIZE + 1];
+	static char inpath[MAXPATHLEN + 1];
+	union {
+		struct cmsghdr cm;
+		char buf[CMSG_SPACE(2 * sizeof(int))];
+	} cbuf;
+	struct msghdr mh;
+	struct iovec iov;
+	struct cmsghdr *cm;
+	struct hook_worker *hw;
+	ssize_t n;
+	int fd = -1;
+	int infd = -1;
+	int nstr;
+	int i;
+	char *p;
+	char *cwd;
+	char *cfg;
+	char *args;
+	char **av;
+	pid_t pid;
+
+	memset(&mh, 0, sizeof(mh));
+	iov.iov_base = msg;
+	iov.iov_len = HOOK_SERVER_MSG_SIZE;
+	mh.msg_iov = &iov;
+	mh.msg_iovlen = 1;
+	mh.msg_control = cbuf.buf;
+	mh.msg_controllen = sizeof(cbuf.buf);
+	n = recvmsg(ctlfd, &mh, 0);
+	if (n == 0)
+		return -1;
+	if (n < 0)
+		return ((errno == EINTR) || (errno == EAGAIN)) ? 0 : -1;
+
+	cm = CMSG_FIRSTHDR(&mh);
+	if ((cm != NULL) && (cm->cmsg_level == SOL_SOCKET) && (cm->cmsg_type == SCM_RIGHTS)) {
+		memcpy(&fd, CMSG_DATA(cm), sizeof(int));
+		if (cm->cmsg_len >= CMSG_LEN(2 * sizeof(int)))
+			memcpy(&infd, CMSG_DATA(cm) + sizeof(int), sizeof(int));
+	}
+	if (fd == -1) {
+		if (infd != -1)
+			close(infd);
+		return 0;
+	}
+
+	/* the requester runs pbs_python itself if it gets no pid back */
+	nstr = 0;
+	if ((msg[n - 1] == '\0') && !(mh.msg_flags & (MSG_TRUNC | MSG_CTRUNC)))
+		for (p = msg; p < msg + n; p += strlen(p) + 1)
+			nstr++;
+	msg[n] = '\0';
+	cwd = msg;
+	cfg = cwd + strlen(cwd) + 1;
+	args = cfg + strlen(cfg) + 1;
+	if ((nstr < 4) || (strcmp(args + strlen(args) + 1, HOOK_MODE) != 0)) {
+		close(fd);
+		if (infd != -1)
+			close(infd);
+		return 0;
+	}
+	if (*nworkers == *nalloc) {
+		hw = realloc(*workers, (*nalloc + 16) * sizeof(struct hook_worker));
+		if (hw == NULL) {
+			close(fd);
+			if (infd != -1)
+				close(infd);
+			return 0;
+		}
+		*workers = hw;
+		*nalloc += 16;
+	}
+
+	PyOS_BeforeFork();
+	pid = fork();
+	if (pid == 0) {
+		PyOS_AfterFork_Child();
+		close(ctlfd);
+		close(hook_server_sigpipe[0]);
+		close(hook_server_sigpipe[1]);
+		for (i = 0; i < *nworkers; i++)
+			if ((*workers)[i].hw_fd != -1)
+				close((*workers)[i].hw_fd);
+		close(fd);
+		(void) signal(SIGCHLD, SIG_DFL);
+		setsid();
+
+		av = (char **) malloc((nstr - 1) * sizeof(char *));
+		if (av == NULL)
+			exit(1);
+		for (i = 0, p = args; i < nstr - 2; i++, p += strlen(p) + 1) {
+			av[i] = p;
+			if ((infd != -1) && (i > 0) && (strcmp(av[i - 1], "-i") == 0)) {
+				snprintf(inpath, sizeof(inpath), "/dev/fd/%d", infd);
+				av[i] = inpath;
+			}
+		}
+		av[i] = NULL;
+
+		if (chdir(cwd) != 0)
+			fprintf(stderr, "pbs_python: unable to chdir to %s\n", cwd);
+		if (*cfg != '\0')
+			(void) setenv(PBS_HOOK_CONFIG_FILE, cfg, 1);
+		else
+			(void) unsetenv(PBS_HOOK_CONFIG_FILE);
+
+		hook_server_warm = 1;
+		*pargc = nstr - 2;
+		*pargv = av;
+		return 1;
+	}
+	PyOS_AfterFork_Parent();
+
+	if (infd != -1)
+		close(infd);
+	if (pid == -1) {
+		close(fd);
+		return 0;
+	}
+	if (send(fd, &pid, sizeof(pid), MSG_NOSIGNAL) != sizeof(pid)) {
+		/* requester already gone */
+		kill(pid, SIGKILL);
+		close(fd);
+		fd = -1;
+	}
+	(*workers)[*nworkers].hw_pid = pid;
+	(*workers)[*nworkers].hw_fd = fd;
+	(*nworkers)++;
+	return 0;
+}
+
+/**
+ * @brief
+ *		Run as Mom's hook server: "pbs_python --hook-server <fd> [-r <resourcedef>]".
+ *
+ * @par
+ *		Starting the interpreter and loading the PBS Python types is done
+ *		once here instead of for every hook run.  Each hook run still gets
+ *		a process of its own, a fresh fork of this one, so hooks do not see
+ *		what earlier ones did.  The server stays up until Mom closes <fd>
+ *		and its last worker has ended.
+ *
+ * @param[in]	argc	-	argument count
+ * @param[in]	argv	-	argument vector
+ * @param[out]	pargc	-	in a worker, argc of the hook command line
+ * @param[out]	pargv	-	in a worker, argv of the hook command line
+ *
+ * @return	int
+ * @retval	0	: returning in a worker, which is to run the hook
+ * @retval	1	: the server could not be set up
+ */
+static int
+hook_server(int argc, char *argv[], int *pargc, char ***pargv)
+{
+	struct hook_worker *workers = NULL;
+	struct pollfd *pfds = NULL;
+	struct pollfd *npfds;
+	int nworkers = 0;
+	int nalloc = 0;
+	int npoll;
+	int ctlfd;
+	int ctl_open = 1;
+	int status;
+	int i, j, rc;
+	char *endp;
+	char buf[64];
+	pid_t pid;
+	extern void pbs_python_svr_initialize_interpreter_data(struct python_interpreter_data * interp_data);
+	extern void pbs_python_svr_destroy_interpreter_data(struct python_interpreter_data * interp_data);
+
+	if ((argc != 3) && !((argc == 5) && (strcmp(argv[3], "-r") == 0))) {
+		fprintf(stderr, "%s %s <fd> [-r <resourcedef>]\n", argv[0], HOOK_SERVER_MODE);
+		return 1;
+	}
+	ctlfd = (int) strtol(argv[2], &endp, 10);
+	if ((*endp != '\0') || (ctlfd < 0)) {
+		fprintf(stderr, "pbs_python: bad %s fd %s\n", HOOK_SERVER_MODE, argv[2]);
+		return 1;
+	}
+	if (argc == 5) {
+		path_rescdef = strdup(argv[4]);
+		if ((path_rescdef == NULL) || (setup_resc(1) == -1)) {
+			fprintf(stderr, "setup_resc() of %s failed!", argv[4]);
+			return 1;
+		}
+	}
+	if ((pipe(hook_server_sigpipe) == -1) ||
+	    (fcntl(hook_server_sigpipe[0], F_SETFL, O_NONBLOCK) == -1) ||
+	    (fcntl(hook_server_sigpipe[1], F_SETFL, O_NONBLOCK) == -1)) {
+		fprintf(stderr, "pbs_python: errno %d setting up %s\n", errno, HOOK_SERVER_MODE);
+		return 1;
+	}
+	(void) signal(SIGCHLD, hook_server_sigchld);
+
+	svr_interp_data.data_initialized = 0;
+	svr_interp_data.init_interpreter_data = pbs_python_svr_initialize_interpreter_data;
+	svr_interp_data.destroy_interpreter_data = pbs_python_svr_destroy_interpreter_data;
+	svr_interp_data.daemon_name = strdup(PBS_PYTHON_PROGRAM);
+	if ((svr_interp_data.daemon_name == NULL) ||
+	    (pbs_python_ext_start_interpreter(&svr_interp_data) != 0)) {
+		fprintf(stderr, "Failed to start Python interpreter");
+		return 1;
+	}
+
+	for (;;) {
+		if (!ctl_open && (nworkers == 0))
+			exit(0);
+
+		npoll = nworkers + 2;
+		npfds = (struct pollfd *) realloc(pfds, npoll * sizeof(struct pollfd));
+		if (npfds == NULL)
+			exit(1);
+		pfds = npfds;
+		pfds[0].fd = ctl_open ? ctlfd : -1;
+		pfds[0].events = POLLIN;
+		pfds[0].revents = 0;
+		pfds[1].fd = hook_server_sigpipe[0];
+		pfds[1].events = POLLIN;
+		pfds[1].revents = 0;
+		for (i = 0; i < nworkers; i++) {
+			pfds[i + 2].fd = workers[i].hw_fd;
+			pfds[i + 2].events = POLLIN;
+			pfds[i + 2].revents = 0;
+		}
+		rc = poll(pfds, npoll, -1);
+		if (rc == -1) {
+			if (errno == EINTR)
+				continue;
+			exit(1);
+		}
+
+		/* a requester that went away (e.g. hook alarm) takes its worker along */
+		for (i = 0; i < nworkers; i++) {
+			if ((pfds[i + 2].fd != -1) && (pfds[i + 2].revents != 0)) {
+				kill(-workers[i].hw_pid, SIGKILL);
+				kill(workers[i].hw_pid, SIGKILL);
+				close(workers[i].hw_fd);
+				workers[i].hw_fd = -1;
+			}
+		}
+
+		if (pfds[1].revents != 0)
+			while (read(hook_server_sigpipe[0], buf, sizeof(buf)) > 0)
+				;
+		while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+			for (j = 0; j < nworkers; j++) {
+				if (workers[j].hw_pid != pid)
+					continue;
+				if (workers[j].hw_fd != -1) {
+					(void) send(workers[j].hw_fd, &status, sizeof(status), MSG_NOSIGNAL);
+					close(workers[j].hw_fd);
+				}
+				workers[j] = workers[--nworkers];
+				break;
+			}
+		}
+
+		if (ctl_open && (pfds[0].revents != 0)) {
+			rc = hook_server_request(ctlfd, &workers, &nworkers, &nalloc, pargc, pargv);
+			if (rc == 1) {
+				free(workers);
+				free(pfds);
+				return 0;
+			} else if (rc == -1) {
+				close(ctlfd);
+				ctl_open = 0;
+			}
+		}
+	}
+}
+#endif /* !WIN32 */
+
 /**
  *
  * @brief
@@ -1493,6 +1875,14 @@ main(int argc, char *argv[], char *envp[])
 		svr_resc_def[i].rs_next = &svr_resc_def[i + 1];
 	/* last entry is left with null pointer */
 
+#ifndef WIN32
+	/* the hook server returns here only in the worker for a hook run */
+	if ((argv[1] != NULL) && (strcmp(argv[1], HOOK_SERVER_MODE) == 0)) {
+		if (hook_server(argc, argv, &argc, &argv) != 0)
+			return 1;
+	}
+#endif
+
 	if ((argv[1] == NULL) || (strcmp(argv[1], HOOK_MODE) != 0)) {
 		char *python_path = NULL;
 		if (get_py_progname(&python_path)) {
@@ -1627,7 +2017,7 @@ main(int argc, char *argv[], char *envp[])
 		struct python_script *py_script = NULL;
 		pbs_list_head default_list, event, event_job, event_job_o,
 			event_resv, event_vnode, event_src_queue, event_vnode_fail,
-			event_aoe, event_argv, event_jobs,
+			event_aoe, event_argv, event_jobs, event_resvs,
 			server, server_jobs, server_jobs_ids,
 			server_queues, server_queues_names,
 			server_resvs, server_resvs_resvids,
@@ -1810,7 +2200,8 @@ main(int argc, char *argv[], char *envp[])
 			exit(2);
 		}
 
-		if (path_rescdef != NULL) {
+		/* a hook server worker has the resourcedef loaded already */
+		if ((path_rescdef != NULL) && !hook_server_warm) {
 			if (setup_resc(1) == -1) {
 				fprintf(stderr, "setup_resc() of %s failed!",
 					path_rescdef);
@@ -1851,6 +2242,7 @@ main(int argc, char *argv[], char *envp[])
 		CLEAR_HEAD(event_aoe);
 		CLEAR_HEAD(event_argv);
 		CLEAR_HEAD(event_jobs);
+		CLEAR_HEAD(event_resvs);
 
 		rc = pbs_python_populate_svrattrl_from_file(the_input,
 							    &default_list,
@@ -1858,7 +2250,7 @@ main(int argc, char *argv[], char *envp[])
 							    &event_vnode, &event_vnode_fail, &job_failed_mom_list,
 							    &job_succeeded_mom_list, &event_src_queue,
 							    &event_aoe, &event_argv, &event_jobs,
-							    perf_label, HOOK_PERF_LOAD_INPUT);
+							    &event_resvs, perf_label, HOOK_PERF_LOAD_INPUT);
 		if (rc == -1) {
 			fprintf(stderr, "%s: failed to populate svrattrl \n", argv[0]);
 			exit(2);
@@ -1989,16 +2381,18 @@ main(int argc, char *argv[], char *envp[])
 			snprintf(logname, sizeof(logname), "%s", full_logname);
 		}
 
-		/* set python interp data */
-		svr_interp_data.data_initialized = 0;
-		svr_interp_data.init_interpreter_data = pbs_python_svr_initialize_interpreter_data;
-		svr_interp_data.destroy_interpreter_data = pbs_python_svr_destroy_interpreter_data;
+		/* set python interp data, unless the hook server started it */
+		if (!hook_server_warm) {
+			svr_interp_data.data_initialized = 0;
+			svr_interp_data.init_interpreter_data = pbs_python_svr_initialize_interpreter_data;
+			svr_interp_data.destroy_interpreter_data = pbs_python_svr_destroy_interpreter_data;
 
-		svr_interp_data.daemon_name = strdup(PBS_PYTHON_PROGRAM);
+			svr_interp_data.daemon_name = strdup(PBS_PYTHON_PROGRAM);
 
-		if (svr_interp_data.daemon_name == NULL) { /* should not happen */
-			fprintf(stderr, "strdup failed");
-			exit(1);
+			if (svr_interp_data.daemon_name == NULL) { /* should not happen */
+				fprintf(stderr, "strdup failed");
+				exit(1);
+			}
 		}
 
 		(void) pbs_python_ext_alloc_python_script(hook_script,
@@ -2302,6 +2696,19 @@ main(int argc, char *argv[], char *envp[])
 				}
 				rc = pbs_python_event_set(hook_event, req_user, req_host, &req_params, perf_label);
 
+				if (rc == -1) { /* internal server code failure */
+					log_event(PBSEVENT_DEBUG,
+						  PBS_EVENTCLASS_HOOK, LOG_ERR,
+						  hook_name,
+						  "Encountered an error while setting event");
+				}
+				break;
+			case HOOK_EVENT_PERIODIC:
+				/* server periodic hook handed over by the server's hook executor */
+				req_params.vns_list = &event_vnode;
+				req_params.resv_list = &event_resvs;
+				rc = pbs_python_event_set(hook_event, req_user, req_host, &req_params, perf_label);
+
 				if (rc == -1) { /* internal server code failure */
 					log_event(PBSEVENT_DEBUG,
 						  PBS_EVENTCLASS_HOOK, LOG_ERR,
@@ -2719,6 +3126,7 @@ main(int argc, char *argv[], char *envp[])
 				break;
 			case HOOK_EVENT_EXECHOST_PERIODIC:
 			case HOOK_EVENT_EXECHOST_STARTUP:
+			case HOOK_EVENT_PERIODIC:
 				if (pbs_python_event_get_accept_flag() == FALSE) {
 					rej_msg = pbs_python_event_get_reject_msg();
 					fprintf(fp_out, "%s=True\n", EVENT_REJECT_OBJECT);
@@ -2810,6 +3218,8 @@ main(int argc, char *argv[], char *envp[])
 		CLEAR_HEAD(event_argv);
 		free_attrlist(&event_jobs);
 		CLEAR_HEAD(event_jobs);
+		free_attrlist(&event_resvs);
+		CLEAR_HEAD(event_resvs);
 		if (progname != NULL)
 			free(progname);
 		if (env_str != NULL)
@@ -0,0 +1,491 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file pbs_tpp_bench.c
+ *
+ * @brief
+ *	pbs_tpp_bench - Measure TPP performance through running pbs_comm(s).
+ *
+ * @par Functionality
+ *	Forks a number of responder leaves, each a separate TPP leaf on its
+ *	own port, and drives them from a leaf in the parent process through
+ *	the given pbs_comm(s). It measures round trip latency, pipelined
+ *	throughput and multicast fan-out time, and prints the results as a
+ *	single JSON object so that runs can be compared across builds.
+ *
+ * Functions included are:
+ * 	main()
+ * 	now_usec()
+ * 	init_leaf()
+ * 	read_msg()
+ * 	send_msg()
+ * 	next_msg()
+ * 	responder()
+ * 	cmp_long()
+ */
+#include <pbs_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include "pbs_internal.h"
+#include "auth.h"
+#include "dis.h"
+#include "tpp.h"
+
+#define BENCH_QUIT 0	   /* seq telling a responder to exit */
+#define BENCH_TIMEOUT 30   /* seconds to wait for any single reply */
+#define BENCH_DEF_PORT 15100
+
+static int app_fd = -1; /* tpp fd of this process */
+
+/**
+ * @brief
+ *	Current time in microseconds
+ */
+static long long
+now_usec(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return ((long long) tv.tv_sec * 1000000 + tv.tv_usec);
+}
+
+/**
+ * @brief
+ *	Initialize TPP in this process as a leaf
+ *
+ * @param[in] host    - host name of the leaf
+ * @param[in] port    - port identifying the leaf
+ * @param[in] routers - comma separated list of pbs_comm(s)
+ *
+ * @return int
+ * @retval  0 : success
+ * @retval -1 : failure
+ */
+static int
+init_leaf(char *host, int port, char *routers)
+{
+	static struct tpp_config tpp_conf;
+
+	if (set_tpp_config(&pbs_conf, &tpp_conf, host, port, routers) == -1) {
+		fprintf(stderr, "Error setting TPP config for %s:%d\n", host, port);
+		return -1;
+	}
+	if ((app_fd = tpp_init(&tpp_conf)) == -1) {
+		fprintf(stderr, "tpp_init failed for %s:%d\n", host, port);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *	Read one benchmark message (sequence number and payload) off a stream
+ *
+ * @param[in]  stream - stream with data
+ * @param[out] seq    - sequence number of the message
+ * @param[out] data   - payload, if not NULL (caller frees), else discarded
+ * @param[out] len    - payload length, if data is not NULL
+ *
+ * @return int
+ * @retval DIS_SUCCESS : a message was read
+ * @retval !DIS_SUCCESS : the stream was closed, or garbage was read
+ */
+static int
+read_msg(int stream, unsigned int *seq, char **data, size_t *len)
+{
+	int rc;
+	char *p;
+	size_t n;
+
+	*seq = disrui(stream, &rc);
+	if (rc == DIS_SUCCESS) {
+		p = disrcs(stream, &n, &rc);
+		if (rc == DIS_SUCCESS && data != NULL) {
+			*data = p;
+			*len = n;
+		} else
+			free(p);
+	}
+	tpp_eom(stream);
+	return rc;
+}
+
+/**
+ * @brief
+ *	Send one benchmark message on a stream (or mcast channel)
+ *
+ * @return int
+ * @retval  0 : success
+ * @retval -1 : failure
+ */
+static int
+send_msg(int stream, unsigned int seq, char *data, size_t len)
+{
+	if (diswui(stream, seq) != DIS_SUCCESS || diswcs(stream, data, len) != DIS_SUCCESS)
+		return -1;
+	if (dis_flush(stream) == -1)
+		return -1;
+	return 0;
+}
+
+/**
+ * @brief
+ *	Wait for the next benchmark message to arrive on any stream
+ *
+ * @param[out] stream   - stream the message arrived on
+ * @param[out] seq      - sequence number of the message
+ * @param[out] data     - payload (see read_msg)
+ * @param[out] len      - payload length
+ * @param[in]  deadline - time (usec) to give up at, 0 for never
+ *
+ * @return int
+ * @retval  0 : a message was read
+ * @retval -1 : timed out or TPP failed
+ */
+static int
+next_msg(int *stream, unsigned int *seq, char **data, size_t *len, long long deadline)
+{
+	struct pollfd pfd;
+	long long left;
+	int s;
+
+	for (;;) {
+		while ((s = tpp_poll()) >= 0) {
+			if (read_msg(s, seq, data, len) == DIS_SUCCESS) {
+				*stream = s;
+				return 0;
+			}
+			tpp_close(s);
+		}
+		if (s == -1)
+			return -1;
+
+		left = 1000000;
+		if (deadline != 0) {
+			left = deadline - now_usec();
+			if (left <= 0)
+				return -1;
+		}
+		pfd.fd = app_fd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		if (poll(&pfd, 1, (int) (left / 1000) + 1) == -1 && errno != EINTR)
+			return -1;
+		if (deadline == 0 && getppid() == 1)
+			return -1; /* a responder whose driver went away */
+	}
+}
+
+/**
+ * @brief
+ *	Body of a responder leaf, echo each message back until told to quit
+ */
+static void
+responder(char *host, int port, char *routers)
+{
+	int stream;
+	unsigned int seq;
+	char *data;
+	size_t len;
+
+	if (init_leaf(host, port, routers) != 0)
+		exit(1);
+
+	while (next_msg(&stream, &seq, &data, &len, 0) == 0) {
+		if (seq == BENCH_QUIT) {
+			free(data);
+			break;
+		}
+		if (send_msg(stream, seq, data, len) != 0)
+			tpp_close(stream);
+		free(data);
+	}
+	tpp_shutdown();
+	exit(0);
+}
+
+static int
+cmp_long(const void *a, const void *b)
+{
+	long long x = *(const long long *) a;
+	long long y = *(const long long *) b;
+
+	return (x > y) - (x < y);
+}
+
+/**
+ * @brief
+ *	This is main function of pbs_tpp_bench.
+ *
+ * @return	int
+ * @retval	0	: success
+ * @retval	1	: failure
+ *
+ */
+int
+main(int argc, char *argv[])
+{
+	int c;
+	int i;
+	int errflg = 0;
+	int nleaves = 4;
+	int count = 10000;
+	int size = 1024;
+	int window = 256;
+	int rounds = 100;
+	int join_wait = 3;
+	int port = BENCH_DEF_PORT;
+	char host[PBS_MAXHOSTNAME + 1];
+	char *routers = NULL;
+	char *payload;
+	int *streams;
+	pid_t *pids;
+	long long *lat;
+	long long t0, t1, tput_usec, mcast_sum = 0, mcast_max = 0;
+	long long lat_sum = 0;
+	int stream;
+	unsigned int seq;
+	int sent, outstanding;
+	int got;
+	int rc = 1;
+
+	if (gethostname(host, sizeof(host)) == -1)
+		strcpy(host, "localhost");
+
+	while ((c = getopt(argc, argv, "r:H:p:l:n:s:w:m:j:")) != EOF) {
+		switch (c) {
+			case 'r':
+				routers = optarg;
+				break;
+			case 'H':
+				snprintf(host, sizeof(host), "%s", optarg);
+				break;
+			case 'p':
+				port = atoi(optarg);
+				break;
+			case 'l':
+				nleaves = atoi(optarg);
+				break;
+			case 'n':
+				count = atoi(optarg);
+				break;
+			case 's':
+				size = atoi(optarg);
+				break;
+			case 'w':
+				window = atoi(optarg);
+				break;
+			case 'm':
+				rounds = atoi(optarg);
+				break;
+			case 'j':
+				join_wait = atoi(optarg);
+				break;
+			default:
+				errflg++;
+		}
+	}
+	if (errflg || optind != argc || nleaves < 1 || count < 1 || size < 0 || window < 1 || rounds < 0) {
+		fprintf(stderr, "usage: %s [-r pbs_comm[:port][,...]] [-H host] [-p base_port] [-l leaves]\n"
+				"\t[-n messages] [-s size] [-w window] [-m mcast_rounds] [-j join_wait]\n",
+			argv[0]);
+		return 1;
+	}
+
+	if (pbs_loadconf(0) == 0) {
+		fprintf(stderr, "%s: Could not load pbs configuration\n", argv[0]);
+		return 1;
+	}
+	if (routers == NULL)
+		routers = pbs_conf.pbs_leaf_routers;
+	if (routers == NULL)
+		routers = pbs_conf.pbs_server_name;
+	if (load_auths(AUTH_SERVER)) {
+		fprintf(stderr, "%s: Failed to load auth lib\n", argv[0]);
+		return 1;
+	}
+	DIS_tpp_funcs();
+
+	payload = malloc(size + 1);
+	streams = calloc(nleaves, sizeof(int));
+	pids = calloc(nleaves, sizeof(pid_t));
+	lat = calloc(count, sizeof(long long));
+	if (payload == NULL || streams == NULL || pids == NULL || lat == NULL) {
+		fprintf(stderr, "%s: Out of memory\n", argv[0]);
+		return 1;
+	}
+	memset(payload, 'x', size);
+	payload[size] = '\0';
+	for (i = 0; i < nleaves; i++)
+		streams[i] = -1;
+
+	/* fork the responders before this process starts its own TPP threads */
+	for (i = 0; i < nleaves; i++) {
+		if ((pids[i] = fork()) == -1) {
+			perror("fork");
+			goto done;
+		}
+		if (pids[i] == 0)
+			responder(host, port + 1 + i, routers);
+	}
+
+	if (init_leaf(host, port, routers) != 0)
+		goto done;
+	sleep(join_wait); /* let all the leaves join the pbs_comm(s) */
+
+	/* make sure every responder is reachable */
+	for (i = 0; i < nleaves; i++) {
+		if ((streams[i] = tpp_open(host, port + 1 + i)) < 0 || send_msg(streams[i], 1, payload, 0) != 0) {
+			fprintf(stderr, "%s: Could not open stream to %s:%d\n", argv[0], host, port + 1 + i);
+			goto done;
+		}
+	}
+	for (got = 0; got < nleaves; got++) {
+		if (next_msg(&stream, &seq, NULL, NULL, now_usec() + BENCH_TIMEOUT * 1000000LL) != 0) {
+			fprintf(stderr, "%s: Only %d of %d leaves responded, are they joined?\n", argv[0], got, nleaves);
+			goto done;
+		}
+	}
+
+	/* round trip latency, one message outstanding at a time */
+	for (i = 0; i < count; i++) {
+		t0 = now_usec();
+		if (send_msg(streams[i % nleaves], i + 2, payload, size) != 0 ||
+		    next_msg(&stream, &seq, NULL, NULL, t0 + BENCH_TIMEOUT * 1000000LL) != 0) {
+			fprintf(stderr, "%s: Latency run failed at message %d\n", argv[0], i);
+			goto done;
+		}
+		lat[i] = now_usec() - t0;
+		lat_sum += lat[i];
+	}
+	qsort(lat, count, sizeof(long long), cmp_long);
+
+	/* pipelined throughput, up to window messages in flight */
+	t0 = now_usec();
+	sent = outstanding = 0;
+	while (sent < count || outstanding > 0) {
+		while (sent < count && outstanding < window) {
+			if (send_msg(streams[sent % nleaves], sent + 2, payload, size) != 0) {
+				fprintf(stderr, "%s: Throughput run failed at message %d\n", argv[0], sent);
+				goto done;
+			}
+			sent++;
+			outstanding++;
+		}
+		if (next_msg(&stream, &seq, NULL, NULL, now_usec() + BENCH_TIMEOUT * 1000000LL) != 0) {
+			fprintf(stderr, "%s: Throughput run timed out with %d replies outstanding\n", argv[0], outstanding);
+			goto done;
+		}
+		outstanding--;
+	}
+	tput_usec = now_usec() - t0;
+	if (tput_usec == 0)
+		tput_usec = 1;
+
+	/* mcast fan-out, time until every leaf has answered */
+	for (i = 0; i < rounds; i++) {
+		int mtfd;
+		int j;
+
+		t0 = now_usec();
+		if ((mtfd = tpp_mcast_open()) == -1) {
+			fprintf(stderr, "%s: tpp_mcast_open failed\n", argv[0]);
+			goto done;
+		}
+		for (j = 0; j < nleaves; j++) {
+			if (tpp_mcast_add_strm(mtfd, streams[j], FALSE) == -1) {
+				fprintf(stderr, "%s: tpp_mcast_add_strm failed\n", argv[0]);
+				tpp_mcast_close(mtfd);
+				goto done;
+			}
+		}
+		if (send_msg(mtfd, count + 2 + i, payload, size) != 0) {
+			fprintf(stderr, "%s: mcast send failed\n", argv[0]);
+			tpp_mcast_close(mtfd);
+			goto done;
+		}
+		tpp_mcast_close(mtfd);
+		for (got = 0; got < nleaves; got++) {
+			if (next_msg(&stream, &seq, NULL, NULL, t0 + BENCH_TIMEOUT * 1000000LL) != 0) {
+				fprintf(stderr, "%s: mcast round %d got %d of %d replies\n", argv[0], i, got, nleaves);
+				goto done;
+			}
+		}
+		t1 = now_usec() - t0;
+		mcast_sum += t1;
+		if (t1 > mcast_max)
+			mcast_max = t1;
+	}
+
+	printf("{\"leaves\": %d, \"routers\": \"%s\", \"msg_size\": %d, \"messages\": %d,\n", nleaves, routers, size, count);
+	printf(" \"latency_usec\": {\"min\": %lld, \"avg\": %lld, \"p50\": %lld, \"p99\": %lld, \"max\": %lld},\n",
+	       lat[0], lat_sum / count, lat[count / 2], lat[(int) (count * 0.99)], lat[count - 1]);
+	printf(" \"throughput\": {\"window\": %d, \"secs\": %.3f, \"msgs_per_sec\": %.1f, \"bytes_per_sec\": %.1f},\n",
+	       window, tput_usec / 1e6, count * 1e6 / tput_usec, (double) count * size * 1e6 / tput_usec);
+	printf(" \"mcast\": {\"rounds\": %d, \"avg_usec\": %lld, \"max_usec\": %lld}}\n",
+	       rounds, rounds ? mcast_sum / rounds : 0, mcast_max);
+	rc = 0;
+
+done:
+	for (i = 0; i < nleaves; i++) {
+		if (streams[i] >= 0)
+			send_msg(streams[i], BENCH_QUIT, payload, 0);
+	}
+	if (app_fd != -1) {
+		sleep(1); /* let the quit messages out */
+		tpp_shutdown();
+	}
+	for (i = 0; i < nleaves; i++) {
+		if (pids[i] > 0) {
+			kill(pids[i], SIGTERM);
+			waitpid(pids[i], NULL, 0);
+		}
+	}
+	return rc;
+}
@@ -54,6 +54,8 @@
  * 	check_job_file()
  * 	upgrade_job_file()
  * 	upgrade_task_file()
+ * 	upgrade_job()
+ * 	upgrade_job_dir()
  * 	main()
  */
 
@@ -64,6 +66,9 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#ifndef WIN32
+#include <sys/wait.h>
+#endif
 #include <unistd.h>
 #include <fcntl.h>
 #include <dirent.h>
@@ -228,6 +233,9 @@ typedef struct taskfix_PRE19 {
 #define BUFSZ 4096
 char buf[BUFSZ];
 
+/* most job files upgraded at once by -d, the work is mostly disk bound */
+#define UPGRADE_MAX_WORKERS 8
+
 svrattrl *read_all_attrs_from_jbfile(int fd, char **state, char **substate, char **errbuf);
 
 /**
@@ -241,6 +249,7 @@ print_usage(void)
 {
 	fprintf(stderr, "Invalid parameter specified. Usage:\n");
 	fprintf(stderr, "pbs_upgrade_job [-c] -f file.JB\n");
+	fprintf(stderr, "pbs_upgrade_job -d jobs_directory\n");
 }
 
 /**
@@ -792,56 +801,29 @@ upgrade_task_file(char *taskfile)
 }
 /**
  * @brief
- *      This is main function of pbs_upgrade_job process.
+ *		Upgrade one job file and its task files.
+ *
+ * @param[in]	jobfile	-	path of the .JB file
+ * @param[in]	check_flag -	only print the format version of the file
+ *
+ * @return	int
+ * @retval	0	: success
+ * @retval	1	: failure
  */
-int
-main(int argc, char *argv[])
+static int
+upgrade_job(char *jobfile, int check_flag)
 {
 	DIR *dir;
 	struct stat statbuf;
 	struct dirent *dirent;
 	char taskdir[MAXPATHLEN + 1] = {'\0'};
 	char namebuf[MAXPATHLEN + 1] = {'\0'};
-	char *jobfile = NULL;
 	char *p;
 	char *task_start;
 	int fd = -1;
 	int flags = 0;
-	int err = 0;
-	int check_flag = 0;
-	int i;
 	int ret;
 
-	errno = 0;
-
-	/* Print pbs_version and exit if --version specified */
-	PRINT_VERSION_AND_EXIT(argc, argv);
-
-	/* Parse the command line parameters */
-	while (!err && ((i = getopt(argc, argv, "cf:")) != EOF)) {
-		switch (i) {
-			case 'c':
-				check_flag = 1;
-				break;
-			case 'f':
-				if (jobfile) {
-					err = 1;
-					break;
-				}
-				jobfile = optarg;
-				break;
-			default:
-				err = 1;
-				break;
-		}
-	}
-	if (!jobfile)
-		err = 1;
-	if (err) {
-		print_usage();
-		return 1;
-	}
-
 	/* Ensure the tasks directory exists */
 	snprintf(namebuf, sizeof(namebuf), "%s", jobfile);
 	p = strrchr(namebuf, '.');
@@ -951,3 +933,183 @@ main(int argc, char *argv[])
 	closedir(dir);
 	return 0;
 }
+
+/**
+ * @brief
+ *		Upgrade every job file in a directory, up to UPGRADE_MAX_WORKERS
+ *		of them at a time, each in its own child process.
+ *
+ * @par
+ *		Each child runs upgrade_job() on one file, so a job file that
+ *		fails to upgrade does not affect the others.  A summary line is
+ *		printed once all of them have been handled.
+ *
+ * @param[in]	jobdir	-	directory holding the .JB files, normally
+ *				$PBS_HOME/mom_priv/jobs
+ *
+ * @return	int
+ * @retval	0	: every job file was upgraded
+ * @retval	1	: at least one could not be upgraded
+ */
+static int
+upgrade_job_dir(char *jobdir)
+{
+	DIR *dir;
+	struct dirent *dirent;
+	char jobfile[MAXPATHLEN + 1];
+	size_t len;
+	size_t sfxlen = strlen(JOB_FILE_SUFFIX);
+	int total = 0;
+	int upgraded = 0;
+#ifndef WIN32
+	struct {
+		pid_t pid;
+		char file[MAXPATHLEN + 1];
+	} workers[UPGRADE_MAX_WORKERS];
+	int nworkers = 0;
+	int maxworkers;
+	long ncpus;
+	int status;
+	pid_t pid;
+	int i;
+
+	ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	maxworkers = (ncpus > 0 && ncpus < UPGRADE_MAX_WORKERS) ? (int) ncpus : UPGRADE_MAX_WORKERS;
+#endif
+
+	dir = opendir(jobdir);
+	if (!dir) {
+		fprintf(stderr, "Failed to open the job directory %s [%s]\n",
+			jobdir, errno ? strerror(errno) : "No error");
+		return 1;
+	}
+	(void) fflush(stdout);
+	(void) fflush(stderr);
+
+	while ((dirent = readdir(dir)) != NULL) {
+		len = strlen(dirent->d_name);
+		if (len <= sfxlen || strcmp(dirent->d_name + len - sfxlen, JOB_FILE_SUFFIX) != 0)
+			continue;
+		snprintf(jobfile, sizeof(jobfile), "%s/%s", jobdir, dirent->d_name);
+		total++;
+#ifdef WIN32
+		if (upgrade_job(jobfile, 0) == 0)
+			upgraded++;
+		else
+			fprintf(stderr, "Failed to upgrade %s\n", jobfile);
+#else
+		/* wait for a free worker slot */
+		while (nworkers >= maxworkers) {
+			if ((pid = wait(&status)) < 0)
+				break;
+			for (i = 0; i < nworkers; i++) {
+				if (workers[i].pid != pid)
+					continue;
+				if (WIFEXITED(status) && WEXITSTATUS(status) == 0)
+					upgraded++;
+				else
+					fprintf(stderr, "Failed to upgrade %s\n", workers[i].file);
+				workers[i] = workers[--nworkers];
+				break;
+			}
+		}
+
+		pid = fork();
+		if (pid == 0) {
+			closedir(dir);
+			exit(upgrade_job(jobfile, 0));
+		} else if (pid < 0) {
+			/* could not fork, do this one here */
+			if (upgrade_job(jobfile, 0) == 0)
+				upgraded++;
+			else
+				fprintf(stderr, "Failed to upgrade %s\n", jobfile);
+		} else {
+			workers[nworkers].pid = pid;
+			snprintf(workers[nworkers].file, sizeof(workers[nworkers].file), "%s", jobfile);
+			nworkers++;
+		}
+#endif
+	}
+	closedir(dir);
+
+#ifndef WIN32
+	while (nworkers > 0 && (pid = wait(&status)) > 0) {
+		for (i = 0; i < nworkers; i++) {
+			if (workers[i].pid != pid)
+				continue;
+			if (WIFEXITED(status) && WEXITSTATUS(status) == 0)
+				upgraded++;
+			else
+				fprintf(stderr, "Failed to upgrade %s\n", workers[i].file);
+			workers[i] = workers[--nworkers];
+			break;
+		}
+	}
+#endif
+
+	if (total > 0)
+		printf("Upgraded %d of %d job files.\n", upgraded, total);
+	return (upgraded == total) ? 0 : 1;
+}
+
+/**
+ * @brief
+ *		Main function of pbs_upgrade_job.
+ *
+ * @return	int
+ * @retval	0	: success
+ * @retval	1	: failure
+ */
+int
+main(int argc, char *argv[])
+{
+	char *jobfile = NULL;
+	char *jobdir = NULL;
+	int err = 0;
+	int check_flag = 0;
+	int i;
+
+	errno = 0;
+
+	/* Print pbs_version and exit if --version specified */
+	PRINT_VERSION_AND_EXIT(argc, argv);
+
+	/* Parse the command line parameters */
+	while (!err && ((i = getopt(argc, argv, "cd:f:")) != EOF)) {
+		switch (i) {
+			case 'c':
+				check_flag = 1;
+				break;
+			case 'd':
+				if (jobdir) {
+					err = 1;
+					break;
+				}
+				jobdir = optarg;
+				break;
+			case 'f':
+				if (jobfile) {
+					err = 1;
+					break;
+				}
+				jobfile = optarg;
+				break;
+			default:
+				err = 1;
+				break;
+		}
+	}
+	if ((jobfile == NULL) == (jobdir == NULL))
+		err = 1;
+	if (jobdir && check_flag)
+		err = 1;
+	if (err) {
+		print_usage();
+		return 1;
+	}
+
+	if (jobdir)
+		return upgrade_job_dir(jobdir);
+	return upgrade_job(jobfile, check_flag);
+}
@@ -46,6 +46,8 @@
  * Functions included are:
  * 	get_cols()
  * 	main()
+ * 	parse_log_line()
+ * 	parse_log_mapped()
  * 	parse_log()
  * 	sort_by_date()
  * 	sort_by_message()
@@ -69,6 +71,10 @@
 #if defined(HAVE_SYS_IOCTL_H)
 #include <sys/ioctl.h>
 #endif
+#include <sys/stat.h>
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
 #include "cmds.h"
 #include "pbs_version.h"
 #include "pbs_ifl.h"
@@ -368,6 +374,257 @@ main(int argc, char *argv[])
 	return 0;
 }
 
+/**
+ * @brief
+ *		parse_log_line - parse one log record and, if it belongs to the job,
+ *		    append it to the log_entry array
+ *
+ * @param[in]	buf	-	the record, without its newline; tokenized in place
+ * @param[in]	job_buf	-	the name of the job
+ * @param[in]	ind	-	which log file - index in enum index
+ * @param[in]	lineno	-	line number of the record in its file
+ *
+ *	@return	nothing
+ *	@note
+ *		modifies global variables: loglines, ll_cur_amm, ll_max_amm
+ *
+ * @par MT-safe: No
+ */
+static void
+parse_log_line(char *buf, char *job_buf, int ind, int lineno)
+{
+	struct log_entry tmp; /* temporary log entry */
+	char *p;	      /* pointer to use for strtok */
+	int field_count;      /* which field in log entry */
+	struct tm tms;	      /* used to convert date to unix date */
+	int slen;
+	char *pdot;
+
+	tms.tm_isdst = -1; /* mktime() will attempt to figure it out */
+
+	p = strtok(buf, ";");
+	field_count = 0;
+	memset(&tmp, 0, sizeof(struct log_entry));
+
+	for (field_count = 0; field_count < 6 && p != NULL; field_count++) {
+		switch (field_count) {
+			case FLD_DATE:
+				tmp.date = p;
+				if (ind == IND_ACCT)
+					field_count = 2;
+				break;
+
+			case FLD_EVENT:
+				tmp.event = p;
+				break;
+
+			case FLD_OBJ:
+				tmp.obj = p;
+				break;
+
+			case FLD_TYPE:
+				tmp.type = p;
+				break;
+
+			case FLD_NAME:
+				tmp.name = p;
+				break;
+
+			case FLD_MSG:
+				tmp.msg = p;
+				break;
+
+			default:
+				printf("Field count too big!\n");
+				printf("%s\n", p);
+		}
+
+		p = strtok(NULL, ";");
+	}
+
+	pdot = strchr(job_buf, (int) '.');
+	if (pdot == NULL && tmp.name != NULL) {
+		int tlen = strlen(job_buf);
+
+		slen = strcspn(tmp.name, ".");
+		if (tlen > slen)
+			slen = tlen;
+	} else
+		slen = strlen(job_buf);
+
+	if (tmp.name != NULL && strncmp(job_buf, tmp.name, slen) == 0) {
+		if (ll_cur_amm >= ll_max_amm)
+			alloc_more_space();
+
+		free_log_entry(&log_lines[ll_cur_amm]);
+
+		if (tmp.date != NULL) {
+			/*
+			 * We need to parse the time string.
+			 * The string will either have high res logging or not.
+			 * The high res logging is after the dot after the seconds field.
+			 */
+			log_lines[ll_cur_amm].date = strdup(tmp.date);
+			if ((ind != IND_ACCT) && (strchr(tmp.date, '.'))) {
+				/* Parse time string looking for high res logging.  If we don't parse 7 fields, we have a invalid log time. */
+				if (sscanf(tmp.date, "%d/%d/%d %d:%d:%d.%ld", &tms.tm_mon,
+					   &tms.tm_mday, &tms.tm_year, &tms.tm_hour, &tms.tm_min,
+					   &tms.tm_sec, &(log_lines[ll_cur_amm].highres)) != 7) {
+					log_lines[ll_cur_amm].date_time = -1; /* error in date field */
+					log_lines[ll_cur_amm].highres = NO_HIGH_RES_TIMESTAMP;
+				} else { /* We found all 7 fields, correctly formed time string */
+					has_high_res_timestamp = 1;
+					if (tms.tm_year > 1900)
+						tms.tm_year -= 1900;
+					/* The number of months since January,
+ 						 * in the range 0 to 11 for mktime()
+ 						 */
+					tms.tm_mon--;
+					log_lines[ll_cur_amm].date_time = mktime(&tms);
+				}
+			} else { /* Normal time string */
+				if (sscanf(tmp.date, "%d/%d/%d %d:%d:%d", &tms.tm_mon, &tms.tm_mday,
+					   &tms.tm_year, &tms.tm_hour, &tms.tm_min, &tms.tm_sec) != 6) {
+					log_lines[ll_cur_amm].date_time = -1; /* error in date field */
+				} else {				      /* We found all 6 fields, correctly formed time string */
+					if (tms.tm_year > 1900)
+						tms.tm_year -= 1900;
+					tms.tm_mon--; /* The number of months since January, in the range 0 to 11 for mktime */
+					log_lines[ll_cur_amm].date_time = mktime(&tms);
+				}
+				log_lines[ll_cur_amm].highres = NO_HIGH_RES_TIMESTAMP;
+			}
+		}
+		if (tmp.event != NULL)
+			log_lines[ll_cur_amm].event = strdup(tmp.event);
+		else
+			log_lines[ll_cur_amm].event = none;
+		if (tmp.obj != NULL)
+			log_lines[ll_cur_amm].obj = strdup(tmp.obj);
+		else
+			log_lines[ll_cur_amm].obj = none;
+		if (tmp.type != NULL)
+			log_lines[ll_cur_amm].type = strdup(tmp.type);
+		else
+			log_lines[ll_cur_amm].type = none;
+		if (tmp.name != NULL)
+			log_lines[ll_cur_amm].name = strdup(tmp.name);
+		else
+			log_lines[ll_cur_amm].name = none;
+		if (tmp.msg != NULL)
+			log_lines[ll_cur_amm].msg = strdup(tmp.msg);
+		else
+			log_lines[ll_cur_amm].msg = none;
+		switch (ind) {
+			case IND_SERVER:
+				log_lines[ll_cur_amm].log_file = 'S';
+				break;
+
+			case IND_SCHED:
+				log_lines[ll_cur_amm].log_file = 'L';
+				break;
+
+			case IND_ACCT:
+				log_lines[ll_cur_amm].log_file = 'A';
+				break;
+
+			case IND_MOM:
+				log_lines[ll_cur_amm].log_file = 'M';
+				break;
+			default:
+				log_lines[ll_cur_amm].log_file = 'U'; /* undefined */
+		}
+		log_lines[ll_cur_amm].lineno = lineno;
+		ll_cur_amm++;
+	}
+}
+
+#ifdef HAVE_MMAP
+/**
+ * @brief
+ *		parse_log_mapped - parse a log file through a read only mapping,
+ *		    tokenizing only the records that mention the job
+ *
+ * @par
+ *		The job name is never the first field of a record, so any record
+ *		for the job contains ";<job>".  Searching the mapping for that
+ *		string skips every other record without copying or tokenizing it,
+ *		which is nearly all of a busy server log.
+ *
+ * @param[in]	fp	-	the log file
+ * @param[in]	job_buf	-	the name of the job
+ * @param[in]	ind	-	which log file - index in enum index
+ *
+ * @return	int
+ * @retval	0	: the file was parsed
+ * @retval	-1	: the file could not be mapped, caller should read it
+ */
+static int
+parse_log_mapped(FILE *fp, char *job_buf, int ind)
+{
+	struct stat sb;
+	char *map;
+	char *end;
+	char *cur;	      /* start of the first line not yet counted */
+	char *hit;
+	char *bol;
+	char *eol;
+	char needle[130];     /* ";" followed by the jobid */
+	size_t nlen;
+	size_t len;
+	char *buf = NULL;
+	size_t buf_size = 0;
+	int lineno = 0;
+
+	if (fstat(fileno(fp), &sb) == -1 || !S_ISREG(sb.st_mode) || sb.st_size <= 0)
+		return -1;
+	map = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+	if (map == MAP_FAILED)
+		return -1;
+	(void) madvise(map, sb.st_size, MADV_SEQUENTIAL);
+
+	needle[0] = ';';
+	pbs_strncpy(needle + 1, job_buf, sizeof(needle) - 1);
+	nlen = strlen(needle);
+
+	end = map + sb.st_size;
+	cur = map;
+	while (cur < end &&
+	       (hit = memmem(cur, end - cur, needle, nlen)) != NULL) {
+		bol = hit;
+		while (bol > cur && bol[-1] != '\n')
+			bol--;
+		/* count the lines skipped over, to keep lineno exact */
+		while ((cur = memchr(cur, '\n', bol - cur)) != NULL) {
+			cur++;
+			lineno++;
+		}
+		lineno++;
+		if ((eol = memchr(hit, '\n', end - hit)) == NULL)
+			eol = end;
+
+		len = eol - bol;
+		if (len + 1 > buf_size) {
+			char *tbuf;
+
+			buf_size = len + 1;
+			if ((tbuf = realloc(buf, buf_size)) == NULL)
+				break;
+			buf = tbuf;
+		}
+		memcpy(buf, bol, len);
+		buf[len] = '\0';
+		parse_log_line(buf, job_buf, ind, lineno);
+
+		cur = (eol < end) ? eol + 1 : end;
+	}
+
+	free(buf);
+	(void) munmap(map, sb.st_size);
+	return 0;
+}
+#endif
+
 /**
  * @brief
  *		parse_log - parse out entires of a log file for a specific job
@@ -386,28 +643,24 @@ main(int argc, char *argv[])
 void
 parse_log(FILE *fp, char *job, int ind)
 {
-	struct log_entry tmp; /* temporary log entry */
 	char *buf;	      /* buffer to read in from file */
 	char *tbuf;	      /* temporarily hold realloc's for main buffer */
 	char job_buf[128];    /* hold the jobid and the . */
-	char *p;	      /* pointer to use for strtok */
-	int field_count;      /* which field in log entry */
-	int j = 0;
-	struct tm tms; /* used to convert date to unix date */
 	int lineno = 0;
-	int slen;
-	char *pdot;
 	int buf_size = 16384; /* initial buffer size */
 	int break_fl = 0;
 
+	pbs_strncpy(job_buf, job, sizeof(job_buf));
+
+#ifdef HAVE_MMAP
+	if (parse_log_mapped(fp, job_buf, ind) == 0)
+		return;
+#endif
+
 	buf = (char *) calloc(buf_size, sizeof(char));
 	if (!buf)
 		return;
 
-	tms.tm_isdst = -1; /* mktime() will attempt to figure it out */
-
-	strcpy(job_buf, job);
-
 	while (fgets(buf, buf_size, fp) != NULL) {
 		while (buf_size == (strlen(buf) + 1)) {
 			buf_size *= 2;
@@ -425,143 +678,8 @@ parse_log(FILE *fp, char *job, int ind)
 		if (break_fl)
 			break;
 		lineno++;
-		j++;
-		buf[strlen(buf) - 1] = '\0';
-		p = strtok(buf, ";");
-		field_count = 0;
-		memset(&tmp, 0, sizeof(struct log_entry));
-
-		for (field_count = 0; field_count < 6 && p != NULL; field_count++) {
-			switch (field_count) {
-				case FLD_DATE:
-					tmp.date = p;
-					if (ind == IND_ACCT)
-						field_count = 2;
-					break;
-
-				case FLD_EVENT:
-					tmp.event = p;
-					break;
-
-				case FLD_OBJ:
-					tmp.obj = p;
-					break;
-
-				case FLD_TYPE:
-					tmp.type = p;
-					break;
-
-				case FLD_NAME:
-					tmp.name = p;
-					break;
-
-				case FLD_MSG:
-					tmp.msg = p;
-					break;
-
-				default:
-					printf("Field count too big!\n");
-					printf("%s\n", p);
-			}
-
-			p = strtok(NULL, ";");
-		}
-
-		pdot = strchr(job_buf, (int) '.');
-		if (pdot == NULL && tmp.name != NULL) {
-			int tlen = strlen(job_buf);
-
-			slen = strcspn(tmp.name, ".");
-			if (tlen > slen)
-				slen = tlen;
-		} else
-			slen = strlen(job_buf);
-
-		if (tmp.name != NULL && strncmp(job_buf, tmp.name, slen) == 0) {
-			if (ll_cur_amm >= ll_max_amm)
-				alloc_more_space();
-
-			free_log_entry(&log_lines[ll_cur_amm]);
-
-			if (tmp.date != NULL) {
-				/*
-				 * We need to parse the time string.
-				 * The string will either have high res logging or not.
-				 * The high res logging is after the dot after the seconds field.
-				 */
-				log_lines[ll_cur_amm].date = strdup(tmp.date);
-				if ((ind != IND_ACCT) && (strchr(tmp.date, '.'))) {
-					/* Parse time string looking for high res logging.  If we don't parse 7 fields, we have a invalid log time. */
-					if (sscanf(tmp.date, "%d/%d/%d %d:%d:%d.%ld", &tms.tm_mon,
-						   &tms.tm_mday, &tms.tm_year, &tms.tm_hour, &tms.tm_min,
-						   &tms.tm_sec, &(log_lines[ll_cur_amm].highres)) != 7) {
-						log_lines[ll_cur_amm].date_time = -1; /* error in date field */
-						log_lines[ll_cur_amm].highres = NO_HIGH_RES_TIMESTAMP;
-					} else { /* We found all 7 fields, correctly formed time string */
-						has_high_res_timestamp = 1;
-						if (tms.tm_year > 1900)
-							tms.tm_year -= 1900;
-						/* The number of months since January,
- 						 * in the range 0 to 11 for mktime()
- 						 */
-						tms.tm_mon--;
-						log_lines[ll_cur_amm].date_time = mktime(&tms);
-					}
-				} else { /* Normal time string */
-					if (sscanf(tmp.date, "%d/%d/%d %d:%d:%d", &tms.tm_mon, &tms.tm_mday,
-						   &tms.tm_year, &tms.tm_hour, &tms.tm_min, &tms.tm_sec) != 6) {
-						log_lines[ll_cur_amm].date_time = -1; /* error in date field */
-					} else {				      /* We found all 6 fields, correctly formed time string */
-						if (tms.tm_year > 1900)
-							tms.tm_year -= 1900;
-						tms.tm_mon--; /* The number of months since January, in the range 0 to 11 for mktime */
-						log_lines[ll_cur_amm].date_time = mktime(&tms);
-					}
-					log_lines[ll_cur_amm].highres = NO_HIGH_RES_TIMESTAMP;
-				}
-			}
-			if (tmp.event != NULL)
-				log_lines[ll_cur_amm].event = strdup(tmp.event);
-			else
-				log_lines[ll_cur_amm].event = none;
-			if (tmp.obj != NULL)
-				log_lines[ll_cur_amm].obj = strdup(tmp.obj);
-			else
-				log_lines[ll_cur_amm].obj = none;
-			if (tmp.type != NULL)
-				log_lines[ll_cur_amm].type = strdup(tmp.type);
-			else
-				log_lines[ll_cur_amm].type = none;
-			if (tmp.name != NULL)
-				log_lines[ll_cur_amm].name = strdup(tmp.name);
-			else
-				log_lines[ll_cur_amm].name = none;
-			if (tmp.msg != NULL)
-				log_lines[ll_cur_amm].msg = strdup(tmp.msg);
-			else
-				log_lines[ll_cur_amm].msg = none;
-			switch (ind) {
-				case IND_SERVER:
-					log_lines[ll_cur_amm].log_file = 'S';
-					break;
-
-				case IND_SCHED:
-					log_lines[ll_cur_amm].log_file = 'L';
-					break;
-
-				case IND_ACCT:
-					log_lines[ll_cur_amm].log_file = 'A';
-					break;
-
-				case IND_MOM:
-					log_lines[ll_cur_amm].log_file = 'M';
-					break;
-				default:
-					log_lines[ll_cur_amm].log_file = 'U'; /* undefined */
-			}
-			log_lines[ll_cur_amm].lineno = lineno;
-			ll_cur_amm++;
-		}
+		buf[strcspn(buf, "\n")] = '\0';
+		parse_log_line(buf, job_buf, ind, lineno);
 	}
 	free(buf);
 }
@@ -1817,7 +1817,7 @@ class Server(Wrappers):
     def create_moms(self, name=None, attrib=None, num=1, delall=True,
                     createnode=True, conf_prefix='pbs.conf_m',
                     home_prefix='pbs_m', momhosts=None, init_port=15011,
-                    step_port=2):
+                    step_port=2, mock=False, mock_vnodes=None):
         """
         Create MoM configurations and optionall add them to the
         server. Unique ``pbs.conf`` files are defined and created
@@ -1851,6 +1851,17 @@ class Server(Wrappers):
         :param step_port: The increments at which ports are
                           allocated. Defaults to 2.
         :type step_port: int
+        :param mock: Whether to start the MoMs in mock run mode, where
+                     jobs are not executed but run for their walltime.
+                     Each MoM is given its node name as ``$momname``.
+                     Defaults to False.
+        :type mock: bool
+        :param mock_vnodes: With mock, the vnodes each MoM reports, as
+                            ``(count, ncpus, mem)``, see ``$mock_vnodes``
+                            in pbs_mom(8B). Many mock MoMs with many
+                            vnodes each emulate a large cluster on a
+                            few hosts.
+        :type mock_vnodes: tuple or None
         .. note:: Since PBS requires that
                   PBS_MANAGER_SERVICE_PORT = PBS_MOM_SERVICE_PORT+1
                   The step number must be greater or equal to 2.
@@ -1903,7 +1914,13 @@ class Server(Wrappers):
             _np_conf['PBS_START_SCHED'] = '0'
             _np_conf['PBS_START_COMM'] = '0'
             _np_conf['PBS_START_MOM'] = '1'
+            if name is None:
+                name = hostname.split('.')[0]
             for i in range(0, num * step_port, step_port):
+                if momnum == 1:
+                    _n = name + '-' + str(i)
+                else:
+                    _n = name + str(momnum) + '-' + str(i)
                 _np = os.path.join(_hp, home_prefix + str(i))
                 _n_pbsconf = os.path.join('/etc', conf_prefix + str(i))
                 _np_conf['PBS_HOME'] = _np
@@ -1916,8 +1933,16 @@ class Server(Wrappers):
                 m = MoM(self, hostname, pbsconf_file=_n_pbsconf)
                 if m.isUp():
                     m.stop()
+                margs = None
+                if mock:
+                    mconf = {'$momname': _n}
+                    if mock_vnodes is not None:
+                        mconf['$mock_vnodes'] = ' '.join(
+                            [str(v) for v in mock_vnodes])
+                    m.add_config(mconf, hup=False)
+                    margs = ['-m']
                 try:
-                    m.start()
+                    m.start(args=margs)
                 except PbsServiceError:
                     # The service failed to start
                     self.logger.error("Service failed to start using port " +
@@ -1927,12 +1952,6 @@ class Server(Wrappers):
                 if createnode:
                     attrib['Mom'] = hostname
                     attrib['port'] = port
-                    if name is None:
-                        name = hostname.split('.')[0]
-                    if momnum == 1:
-                        _n = name + '-' + str(i)
-                    else:
-                        _n = name + str(momnum) + '-' + str(i)
                     rc = self.manager(MGR_CMD_CREATE, NODE, attrib, id=_n)
                     if rc != 0:
                         self.logger.error("error creating node " + _n)
@@ -0,0 +1,105 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2022 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+
+
+
+from tests.functional import *
+
+hook_body = """
+import pbs
+
+e = pbs.event()
+s = pbs.server()
+user = e.requestor
+
+nq = 0
+for j in s.jobs(state="Q", owner=user, attrs=["job_state"]):
+    nq += 1
+pbs.logmsg(pbs.LOG_DEBUG, "queued jobs of %s=%d" % (user, nq))
+
+nh = len([j for j in s.jobs(state="H", attrs="job_state")])
+pbs.logmsg(pbs.LOG_DEBUG, "held jobs=%d" % (nh))
+
+nw = len([j for j in s.queue("workq").jobs(state="QH")])
+pbs.logmsg(pbs.LOG_DEBUG, "workq jobs=%d" % (nw))
+
+for j in s.jobs(attrs=["job_state"]):
+    if j.Job_Name is not None:
+        pbs.logmsg(pbs.LOG_DEBUG, "projection ignored for %s" % (j.id))
+    break
+
+try:
+    s.jobs(attrs=["no_such_attribute"])
+except ValueError:
+    pbs.logmsg(pbs.LOG_DEBUG, "bad projection rejected")
+e.accept()
+"""
+
+
+@tags('hooks')
+class TestHookServerIter(TestFunctional):
+    """
+    Test the filtering and attribute projection arguments of the
+    pbs.server().jobs() iterator
+    """
+
+    def test_jobs_filters(self):
+        """
+        Verify that state, owner and queue filters and attrs projection
+        restrict what a hook sees while iterating over the server jobs
+        """
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+
+        jids = []
+        for _ in range(3):
+            jids.append(self.server.submit(Job(TEST_USER)))
+        self.server.holdjob(jids[0])
+        self.server.expect(JOB, {'job_state': 'H'}, id=jids[0])
+
+        attr = {'event': 'queuejob', 'enabled': 'True'}
+        self.server.create_import_hook("iter_hook", attr, hook_body)
+
+        self.server.submit(Job(TEST_USER))
+        self.server.log_match("queued jobs of %s=2" % (TEST_USER))
+        self.server.log_match("held jobs=1")
+        self.server.log_match("workq jobs=3")
+        self.server.log_match("bad projection rejected")
+        self.server.log_match("projection ignored", existence=False,
+                              max_attempts=2)
@@ -0,0 +1,133 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2021 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+
+
+from tests.functional import *
+
+
+class TestModifyJobList(TestFunctional):
+    """
+    Test suite for the Modify Job List request, which qalter sends when
+    it is given several jobs of the same server
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        self.qalter = os.path.join(self.server.pbs_conf['PBS_EXEC'],
+                                   'bin', 'qalter')
+
+    def submit_jobs(self, user, count):
+        """
+        Submit count jobs as user
+        """
+        jids = []
+        for _ in range(count):
+            j = Job(user)
+            j.set_sleep_time(1000)
+            jids.append(self.server.submit(j))
+        return jids
+
+    def test_alter_list(self):
+        """
+        Test that qalter of several jobs alters all of them with one
+        modify job list request
+        """
+        jids = self.submit_jobs(TEST_USER, 4)
+        t = time.time()
+        ret = self.du.run_cmd(cmd=[self.qalter, '-N', 'altered'] + jids,
+                              runas=TEST_USER)
+        self.assertEqual(ret['rc'], 0, ret['err'])
+        self.server.log_match('Type 104 request received', starttime=t)
+        for jid in jids:
+            self.server.expect(JOB, {ATTR_N: 'altered'}, id=jid)
+
+    def test_alter_list_job_failure(self):
+        """
+        Test that a job which cannot be altered is reported with the
+        server's error, as for a single job, and does not stop the others
+        """
+        self.server.manager(MGR_CMD_SET, NODE,
+                            {'resources_available.ncpus': 2},
+                            id=self.mom.shortname)
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'True'})
+        j = Job(TEST_USER, attrs={'Resource_List.ncpus': 2})
+        j.set_sleep_time(1000)
+        running = self.server.submit(j)
+        self.server.expect(JOB, {'job_state': 'R'}, id=running)
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        queued = []
+        for _ in range(2):
+            j = Job(TEST_USER, attrs={'Resource_List.ncpus': 2})
+            j.set_sleep_time(1000)
+            queued.append(self.server.submit(j))
+
+        # the first job goes alone, the running job is in the list
+        ret = self.du.run_cmd(cmd=[self.qalter, '-l', 'ncpus=1',
+                                   queued[0], running, queued[1]],
+                              runas=TEST_USER, logerr=False)
+        self.assertNotEqual(ret['rc'], 0)
+        errs = [e for e in ret['err'] if running in e]
+        self.assertEqual(len(errs), 1, ret['err'])
+        self.assertIn('qalter: Cannot modify attribute while job running',
+                      errs[0])
+        self.server.expect(JOB, {'Resource_List.ncpus': 2}, id=running)
+        for jid in queued:
+            self.server.expect(JOB, {'Resource_List.ncpus': 1}, id=jid)
+
+    def test_alter_list_permission(self):
+        """
+        Test that a user's jobs in the list are altered while another
+        user's job is refused
+        """
+        mine = self.submit_jobs(TEST_USER, 2)
+        theirs = self.submit_jobs(TEST_USER1, 1)[0]
+        t = time.time()
+        ret = self.du.run_cmd(cmd=[self.qalter, '-N', 'altered', mine[0],
+                                   theirs, mine[1]],
+                              runas=TEST_USER, logerr=False)
+        self.assertNotEqual(ret['rc'], 0)
+        self.server.log_match('Type 104 request received', starttime=t)
+        errs = [e for e in ret['err'] if theirs in e]
+        self.assertEqual(len(errs), 1, ret['err'])
+        self.assertIn('qalter: Unauthorized Request', errs[0])
+        for jid in mine:
+            self.server.expect(JOB, {ATTR_N: 'altered'}, id=jid)
+        self.server.expect(JOB, {ATTR_N: 'altered'}, op=NE, id=theirs)
@@ -0,0 +1,237 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2021 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+
+
+import json
+import sys
+
+from tests.functional import *
+
+# Calls pbs_runjoblist() through ctypes, it has no command of its own.
+# The request comes in argv[1] as JSON and the result goes to stdout as
+# JSON.
+RUNJOBLIST_SCRIPT = """
+import ctypes
+import json
+import sys
+
+
+class deljob_status(ctypes.Structure):
+    pass
+
+
+deljob_status._fields_ = [('next', ctypes.POINTER(deljob_status)),
+                          ('name', ctypes.c_char_p),
+                          ('code', ctypes.c_int)]
+
+req = json.loads(sys.argv[1])
+pbs = ctypes.CDLL(req['lib'])
+pbs.__pbs_errno_location.restype = ctypes.POINTER(ctypes.c_int)
+pbs.pbs_connect.argtypes = [ctypes.c_char_p]
+pbs.pbs_runjoblist.argtypes = [ctypes.c_int,
+                               ctypes.POINTER(ctypes.c_char_p),
+                               ctypes.POINTER(ctypes.c_char_p),
+                               ctypes.c_int, ctypes.c_char_p]
+pbs.pbs_runjoblist.restype = ctypes.POINTER(deljob_status)
+pbs.pbs_delstatfree.argtypes = [ctypes.POINTER(deljob_status)]
+result = {'failed': {}}
+
+c = pbs.pbs_connect(None)
+if c <= 0:
+    result['rc'] = pbs.__pbs_errno_location()[0]
+else:
+    n = req.get('count', len(req['jobs']))
+    jobids = (ctypes.c_char_p * (n + 1))()
+    execvnodes = (ctypes.c_char_p * (n + 1))()
+    for i, (jid, execvnode) in enumerate(req['jobs']):
+        jobids[i] = jid.encode()
+        execvnodes[i] = execvnode.encode()
+    failed = pbs.pbs_runjoblist(c, jobids, execvnodes, n, None)
+    result['rc'] = pbs.__pbs_errno_location()[0]
+    f = failed
+    while f:
+        result['failed'][f.contents.name.decode()] = f.contents.code
+        f = f.contents.next
+    pbs.pbs_delstatfree(failed)
+    pbs.pbs_disconnect(c)
+print(json.dumps(result))
+"""
+
+
+class TestRunJobList(TestFunctional):
+    """
+    Test suite for the Run Job List request, pbs_runjoblist(), with
+    which the scheduler sends the jobs it runs without waiting on them
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        self.server.manager(MGR_CMD_SET, NODE,
+                            {'resources_available.ncpus': 4},
+                            id=self.mom.shortname)
+        self.execvnode = '(%s:ncpus=1)' % self.mom.shortname
+
+    def runjoblist(self, user, jobs, count=None):
+        """
+        Run pbs_runjoblist() as user and return what it reported
+
+        :param user: user to run the request as
+        :param jobs: list of (job id, execvnode)
+        :param count: number of jobs to pass, defaults to len(jobs)
+        :returns: dictionary with pbs_errno 'rc' and the error code of
+                  each job which could not be run 'failed'
+        """
+        fn = self.du.create_temp_file(body=RUNJOBLIST_SCRIPT, suffix='.py',
+                                      asuser=user)
+        req = {'lib': os.path.join(self.server.pbs_conf['PBS_EXEC'],
+                                   'lib', 'libpbs.so'),
+               'jobs': jobs}
+        if count is not None:
+            req['count'] = count
+        ret = self.du.run_cmd(cmd=[sys.executable, fn, json.dumps(req)],
+                              runas=user)
+        self.assertEqual(ret['rc'], 0, ret['err'])
+        return json.loads(ret['out'][-1])
+
+    def submit_jobs(self, count):
+        """
+        Submit count jobs as TEST_USER
+        """
+        jids = []
+        for _ in range(count):
+            j = Job(TEST_USER)
+            j.set_sleep_time(1000)
+            jids.append(self.server.submit(j))
+        return jids
+
+    def test_runjoblist_mixed(self):
+        """
+        Test that the good jobs of a list are run while an unknown job
+        and a job without an execvnode are each reported with their
+        error, in one request
+        """
+        good1, empty, good2 = self.submit_jobs(3)
+        unknown = '999999.' + self.server.hostname
+        t = time.time()
+        res = self.runjoblist(ROOT_USER, [(good1, self.execvnode),
+                                          (unknown, self.execvnode),
+                                          (empty, ''),
+                                          (good2, self.execvnode)])
+        self.assertEqual(res['rc'], PBSE_NONE)
+        self.assertEqual(res['failed'], {unknown: PBSE_UNKJOBID,
+                                         empty: PBSE_IVALREQ})
+        self.server.log_match('Type 101 request received', starttime=t)
+        self.server.expect(JOB, {'job_state': 'R'}, id=good1)
+        self.server.expect(JOB, {'job_state': 'R'}, id=good2)
+        self.server.expect(JOB, {'job_state': 'Q'}, id=empty)
+
+    def test_runjoblist_reply_after_last_child(self):
+        """
+        Test that the reply to the list waits for its last child: the
+        failure of a job the server only finds out about while running
+        it, last in the list, is in the reply
+        """
+        running, good1, good2 = self.submit_jobs(3)
+        res = self.runjoblist(ROOT_USER, [(running, self.execvnode)])
+        self.assertEqual(res['rc'], PBSE_NONE)
+        self.assertEqual(res['failed'], {})
+        self.server.expect(JOB, {'job_state': 'R'}, id=running)
+
+        res = self.runjoblist(ROOT_USER, [(good1, self.execvnode),
+                                          (good2, self.execvnode),
+                                          (running, self.execvnode)])
+        self.assertEqual(res['rc'], PBSE_NONE)
+        self.assertEqual(res['failed'], {running: PBSE_BADSTATE})
+        self.server.expect(JOB, {'job_state': 'R'}, id=good1)
+        self.server.expect(JOB, {'job_state': 'R'}, id=good2)
+
+    def test_runjoblist_limits(self):
+        """
+        Test that a user who is not an operator or manager is refused,
+        that an empty list succeeds, and that a list longer than a
+        request may carry is refused before it is sent
+        """
+        jid = self.submit_jobs(1)[0]
+        res = self.runjoblist(TEST_USER, [(jid, self.execvnode)])
+        self.assertEqual(res['rc'], PBSE_PERM)
+        self.assertEqual(res['failed'], {})
+        self.server.expect(JOB, {'job_state': 'Q'}, id=jid)
+
+        # the scheduler asks with an empty list whether the server
+        # knows the request
+        res = self.runjoblist(ROOT_USER, [])
+        self.assertEqual(res['rc'], PBSE_NONE)
+        self.assertEqual(res['failed'], {})
+
+        res = self.runjoblist(ROOT_USER, [(jid, self.execvnode)],
+                              count=10001)
+        self.assertEqual(res['rc'], PBSE_IVALREQ)
+        self.server.expect(JOB, {'job_state': 'Q'}, id=jid)
+
+    def test_sched_runs_jobs_by_list(self):
+        """
+        Test that the scheduler finds that the server knows the list
+        request and runs its jobs with it, and that it sends them one
+        at a time when a runjob hook must see each job
+        """
+        self.scheduler.restart()
+        jids = self.submit_jobs(2)
+        t = time.time()
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'True'})
+        for jid in jids:
+            self.server.expect(JOB, {'job_state': 'R'}, id=jid)
+        self.server.log_match('Type 101 request received', starttime=t)
+        self.scheduler.log_match('Server does not support job lists',
+                                 starttime=t, existence=False,
+                                 max_attempts=1)
+
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        hook_body = "import pbs\npbs.event().accept()\n"
+        self.server.create_import_hook('rj', {'event': 'runjob',
+                                              'enabled': 'True'}, hook_body)
+        jids = self.submit_jobs(2)
+        t = time.time()
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'True'})
+        for jid in jids:
+            self.server.expect(JOB, {'job_state': 'R'}, id=jid)
+        self.server.log_match('Type 23 request received', starttime=t)
+        self.server.log_match('Type 101 request received', starttime=t,
+                              existence=False, max_attempts=1)
@@ -0,0 +1,98 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2021 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+
+
+from tests.functional import *
+
+
+class TestSchedParallelPsets(TestFunctional):
+    """
+    Tests for the scheduler's parallel_placement_set_eval option
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        self.server.add_resource('foo', 'string', 'h')
+        a = {'resources_available.ncpus': 2}
+        self.mom.create_vnodes(a, 6, attrfunc=self.cust_attr)
+        self.vn = ['%s[%d]' % (self.mom.shortname, i) for i in range(6)]
+        a = {'node_group_key': 'foo', 'node_group_enable': 'True'}
+        self.server.manager(MGR_CMD_SET, SERVER, a)
+        self.scheduler.set_sched_config(
+            {'parallel_placement_set_eval': 'True'})
+
+    def cust_attr(self, name, totnodes, numnode, attrib):
+        # Placement set A has 1 vnode, B has 2 and C has 3
+        if numnode == 0:
+            val = 'A'
+        elif numnode < 3:
+            val = 'B'
+        else:
+            val = 'C'
+        return {**attrib, 'resources_available.foo': val}
+
+    def test_smallest_set_picked(self):
+        """
+        Test that the job is placed in the first placement set which fits
+        the job in sort order, just like evaluating the sets serially
+        """
+        a = {'Resource_List.select': '2:ncpus=2',
+             'Resource_List.place': 'vscatter'}
+        j = Job(TEST_USER, attrs=a)
+        jid = self.server.submit(j)
+        self.server.expect(JOB, {'job_state': 'R'}, id=jid)
+        self.server.expect(JOB, 'exec_vnode', id=jid, op=SET)
+        nodes = j.get_vnodes(j.exec_vnode)
+        self.assertEqual(sorted(nodes), sorted(self.vn[1:3]))
+
+    def test_no_set_fits(self):
+        """
+        Test that a job which doesn't fit in any placement set gets the
+        same comment as when evaluating the sets serially
+        """
+        self.server.manager(MGR_CMD_SET, SCHED, {'do_not_span_psets': 'True'},
+                            id='default')
+        a = {'Resource_List.select': '4:ncpus=2',
+             'Resource_List.place': 'vscatter'}
+        j = Job(TEST_USER, attrs=a)
+        jid = self.server.submit(j)
+        msg = "Can Never Run: can't fit in the largest placement set, " \
+              "and can't span psets"
+        self.server.expect(JOB, {'job_state': 'Q', 'comment': msg}, id=jid)
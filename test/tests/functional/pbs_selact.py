@@ -0,0 +1,254 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2021 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+
+
+import json
+import sys
+
+from tests.functional import *
+
+# Calls pbs_selact() through ctypes, since the callback cannot be passed
+# through the swig wrappers.  The request comes in argv[1] as JSON and the
+# result goes to stdout as JSON.
+SELACT_SCRIPT = """
+import ctypes
+import json
+import sys
+
+
+class attrl(ctypes.Structure):
+    pass
+
+
+attrl._fields_ = [('next', ctypes.POINTER(attrl)),
+                  ('name', ctypes.c_char_p),
+                  ('resource', ctypes.c_char_p),
+                  ('value', ctypes.c_char_p),
+                  ('op', ctypes.c_int)]
+
+
+class deljob_status(ctypes.Structure):
+    pass
+
+
+deljob_status._fields_ = [('next', ctypes.POINTER(deljob_status)),
+                          ('name', ctypes.c_char_p),
+                          ('code', ctypes.c_int)]
+
+selact_cb = ctypes.CFUNCTYPE(None, ctypes.c_int,
+                             ctypes.POINTER(deljob_status), ctypes.c_void_p)
+
+
+def make_list(items, keep):
+    head = None
+    for name, resc, value, op in reversed(items):
+        a = attrl()
+        a.next = head
+        a.name = name.encode()
+        a.resource = resc.encode() if resc else None
+        a.value = value.encode()
+        a.op = op
+        keep.append(a)
+        head = ctypes.pointer(a)
+    return head
+
+
+req = json.loads(sys.argv[1])
+pbs = ctypes.CDLL(req['lib'])
+pbs.__pbs_errno_location.restype = ctypes.POINTER(ctypes.c_int)
+pbs.pbs_connect.argtypes = [ctypes.c_char_p]
+pbs.pbs_selact.argtypes = [ctypes.c_int, ctypes.POINTER(attrl), ctypes.c_int,
+                           ctypes.POINTER(attrl), ctypes.c_char_p,
+                           selact_cb, ctypes.c_void_p]
+result = {'acted': 0, 'failed': {}}
+
+
+def progress(acted, failed, arg):
+    result['acted'] = acted
+    while failed:
+        result['failed'][failed.contents.name.decode()] = failed.contents.code
+        failed = failed.contents.next
+
+
+keep = []
+c = pbs.pbs_connect(None)
+if c <= 0:
+    result['rc'] = pbs.__pbs_errno_location()[0]
+else:
+    cb = selact_cb(progress)
+    result['rc'] = pbs.pbs_selact(c, make_list(req['criteria'], keep),
+                                  req['action'], make_list(req['args'], keep),
+                                  None, cb, None)
+    pbs.pbs_disconnect(c)
+print(json.dumps(result))
+"""
+
+
+class TestSelectAction(TestFunctional):
+    """
+    Test suite for the Select Action request, pbs_selact()
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+
+    def selact(self, user, criteria, action, args=None):
+        """
+        Run pbs_selact() as user and return what it reported
+
+        :param user: user to run the request as
+        :param criteria: selection, list of (name, resource, value, op)
+        :param action: SELACT_DELETE, SELACT_HOLD, SELACT_RELEASE or
+                       SELACT_ALTER
+        :param args: attributes of the action, list of
+                     (name, resource, value, op)
+        :returns: dictionary with the return code 'rc', the number of
+                  jobs acted on 'acted' and the error code of each job
+                  the action failed on 'failed'
+        """
+        fn = self.du.create_temp_file(body=SELACT_SCRIPT, suffix='.py',
+                                      asuser=user)
+        req = {'lib': os.path.join(self.server.pbs_conf['PBS_EXEC'],
+                                   'lib', 'libpbs.so'),
+               'criteria': criteria,
+               'action': action,
+               'args': args or []}
+        ret = self.du.run_cmd(cmd=[sys.executable, fn, json.dumps(req)],
+                              runas=user)
+        self.assertEqual(ret['rc'], 0, ret['err'])
+        return json.loads(ret['out'][-1])
+
+    def submit_named(self, user, name, count=1):
+        """
+        Submit count jobs called name as user
+        """
+        jids = []
+        for _ in range(count):
+            j = Job(user, attrs={ATTR_N: name})
+            j.set_sleep_time(1000)
+            jids.append(self.server.submit(j))
+        return jids
+
+    def test_selact_hold_release(self):
+        """
+        Test that the action is applied to every selected job, and only
+        to those
+        """
+        jids = self.submit_named(TEST_USER, 'sa', 3)
+        other = self.submit_named(TEST_USER, 'other')[0]
+        t = time.time()
+        sel = [(ATTR_N, None, 'sa', EQ)]
+        res = self.selact(ROOT_USER, sel, SELACT_HOLD,
+                          [(ATTR_h, None, 'u', SET)])
+        self.assertEqual(res['rc'], 0)
+        self.assertEqual(res['acted'], 3)
+        self.assertEqual(res['failed'], {})
+        self.server.log_match('Type 105 request received', starttime=t)
+        for jid in jids:
+            self.server.expect(JOB, {'job_state': 'H',
+                                     ATTR_h: 'u'}, id=jid)
+        self.server.expect(JOB, {'job_state': 'Q'}, id=other)
+
+        res = self.selact(ROOT_USER, sel, SELACT_RELEASE,
+                          [(ATTR_h, None, 'u', SET)])
+        self.assertEqual(res['rc'], 0)
+        self.assertEqual(res['acted'], 3)
+        self.assertEqual(res['failed'], {})
+        for jid in jids:
+            self.server.expect(JOB, {'job_state': 'Q'}, id=jid)
+
+    def test_selact_partial_failure(self):
+        """
+        Test that a job the action fails on is reported with its error
+        while the other selected jobs are still acted on
+        """
+        self.server.manager(MGR_CMD_SET, NODE,
+                            {'resources_available.ncpus': 2},
+                            id=self.mom.shortname)
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'True'})
+        j = Job(TEST_USER, attrs={ATTR_N: 'sa', 'Resource_List.ncpus': 2})
+        j.set_sleep_time(1000)
+        running = self.server.submit(j)
+        self.server.expect(JOB, {'job_state': 'R'}, id=running)
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        queued = []
+        for _ in range(2):
+            j = Job(TEST_USER, attrs={ATTR_N: 'sa',
+                                      'Resource_List.ncpus': 2})
+            j.set_sleep_time(1000)
+            queued.append(self.server.submit(j))
+
+        res = self.selact(ROOT_USER, [(ATTR_N, None, 'sa', EQ)],
+                          SELACT_ALTER,
+                          [(ATTR_l, 'ncpus', '1', SET)])
+        self.assertEqual(res['rc'], 0)
+        self.assertEqual(res['acted'], 3)
+        self.assertEqual(res['failed'], {running: PBSE_MODATRRUN})
+        self.server.expect(JOB, {'Resource_List.ncpus': 2}, id=running)
+        for jid in queued:
+            self.server.expect(JOB, {'Resource_List.ncpus': 1}, id=jid)
+
+    def test_selact_non_manager(self):
+        """
+        Test that a user who is not a manager only acts on their own
+        jobs, and is refused an action that needs privilege
+        """
+        mine = self.submit_named(TEST_USER, 'sa')[0]
+        theirs = self.submit_named(TEST_USER1, 'sa')[0]
+        sel = [(ATTR_N, None, 'sa', EQ)]
+
+        # a system hold needs operator or manager privilege
+        res = self.selact(TEST_USER, sel, SELACT_HOLD,
+                          [(ATTR_h, None, 's', SET)])
+        self.assertEqual(res['rc'], 0)
+        self.assertEqual(res['acted'], 1)
+        self.assertEqual(res['failed'], {mine: PBSE_PERM})
+        self.server.expect(JOB, {'job_state': 'Q'}, id=mine)
+
+        # query_other_jobs lets one see other users' jobs, not act on them
+        self.server.manager(MGR_CMD_SET, SERVER,
+                            {'query_other_jobs': 'True'})
+        res = self.selact(TEST_USER, sel, SELACT_DELETE)
+        self.assertEqual(res['rc'], 0)
+        self.assertEqual(res['acted'], 1)
+        self.assertEqual(res['failed'], {})
+        self.server.expect(JOB, 'queue', op=UNSET, id=mine)
+        self.server.expect(JOB, {'job_state': 'Q'}, id=theirs)
@@ -0,0 +1,198 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2021 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+
+
+import json
+import sys
+
+from tests.functional import *
+
+# Sends the status requests in 'requests' back to back with
+# pbs_stat_submit() through ctypes, then reads one more reply than was
+# requested with pbs_stat_collect().  The request comes in argv[1] as
+# JSON and each reply's object names, or its error, go to stdout as JSON.
+STAT_PIPELINE_SCRIPT = """
+import ctypes
+import json
+import sys
+
+
+class batch_status(ctypes.Structure):
+    pass
+
+
+batch_status._fields_ = [('next', ctypes.POINTER(batch_status)),
+                         ('name', ctypes.c_char_p),
+                         ('attribs', ctypes.c_void_p),
+                         ('text', ctypes.c_char_p)]
+
+req = json.loads(sys.argv[1])
+pbs = ctypes.CDLL(req['lib'])
+pbs.__pbs_errno_location.restype = ctypes.POINTER(ctypes.c_int)
+pbs.pbs_connect.argtypes = [ctypes.c_char_p]
+pbs.pbs_stat_submit.argtypes = [ctypes.c_int, ctypes.c_int, ctypes.c_char_p,
+                                ctypes.c_void_p, ctypes.c_char_p]
+pbs.pbs_stat_collect.restype = ctypes.POINTER(batch_status)
+pbs.pbs_statfree.argtypes = [ctypes.POINTER(batch_status)]
+result = {'rc': 0, 'replies': []}
+
+c = pbs.pbs_connect(None)
+if c <= 0:
+    result['rc'] = pbs.__pbs_errno_location()[0]
+else:
+    for objtype, oid in req['requests']:
+        result['rc'] = pbs.pbs_stat_submit(c, objtype, oid.encode(),
+                                           None, None)
+        if result['rc'] != 0:
+            break
+    for _ in range(len(req['requests']) + 1):
+        if result['rc'] != 0:
+            break
+        pbs.__pbs_errno_location()[0] = 0
+        bs = pbs.pbs_stat_collect(c)
+        names = []
+        p = bs
+        while p:
+            names.append(p.contents.name.decode())
+            p = p.contents.next
+        result['replies'].append({'names': names,
+                                  'errno': pbs.__pbs_errno_location()[0]})
+        pbs.pbs_statfree(bs)
+    pbs.pbs_disconnect(c)
+print(json.dumps(result))
+"""
+
+
+class TestStatPipeline(TestFunctional):
+    """
+    Test suite for pipelined status requests, pbs_stat_submit() and
+    pbs_stat_collect()
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+
+    def stat_pipeline(self, user, requests):
+        """
+        Send the status requests as user on one connection, then
+        collect their replies
+
+        :param user: user to send the requests as
+        :param requests: list of (object type, object id)
+        :returns: dictionary with the return code 'rc' and, for each
+                  reply collected, the object names 'names' and the error
+                  'errno'; the last one is for a collect with nothing
+                  pending
+        """
+        fn = self.du.create_temp_file(body=STAT_PIPELINE_SCRIPT,
+                                      suffix='.py', asuser=user)
+        req = {'lib': os.path.join(self.server.pbs_conf['PBS_EXEC'],
+                                   'lib', 'libpbs.so'),
+               'requests': requests}
+        ret = self.du.run_cmd(cmd=[sys.executable, fn, json.dumps(req)],
+                              runas=user)
+        self.assertEqual(ret['rc'], 0, ret['err'])
+        return json.loads(ret['out'][-1])
+
+    def submit_job(self, user):
+        """
+        Submit a job as user
+        """
+        j = Job(user)
+        j.set_sleep_time(1000)
+        return self.server.submit(j)
+
+    def test_stat_pipeline(self):
+        """
+        Test that the replies to pipelined status requests come back in
+        the order the requests were sent
+        """
+        jid1 = self.submit_job(TEST_USER)
+        jid2 = self.submit_job(TEST_USER)
+        res = self.stat_pipeline(TEST_USER, [(MGR_OBJ_JOB, jid2),
+                                             (MGR_OBJ_QUEUE, 'workq'),
+                                             (MGR_OBJ_JOB, jid1),
+                                             (MGR_OBJ_SERVER, '')])
+        self.assertEqual(res['rc'], 0)
+        self.assertEqual(len(res['replies']), 5)
+        self.assertEqual(res['replies'][0], {'names': [jid2], 'errno': 0})
+        self.assertEqual(res['replies'][1], {'names': ['workq'],
+                                             'errno': 0})
+        self.assertEqual(res['replies'][2], {'names': [jid1], 'errno': 0})
+        self.assertEqual(len(res['replies'][3]['names']), 1)
+        self.assertEqual(res['replies'][3]['errno'], 0)
+        # nothing is left to collect
+        self.assertEqual(res['replies'][4], {'names': [],
+                                             'errno': PBSE_IVALREQ})
+
+    def test_stat_pipeline_error(self):
+        """
+        Test that a failed status request is reported on its own reply
+        and the replies after it are still read
+        """
+        jid1 = self.submit_job(TEST_USER)
+        gone = self.submit_job(TEST_USER)
+        self.server.delete(gone, wait=True)
+        jid2 = self.submit_job(TEST_USER)
+        res = self.stat_pipeline(TEST_USER, [(MGR_OBJ_JOB, jid1),
+                                             (MGR_OBJ_JOB, gone),
+                                             (MGR_OBJ_JOB, jid2)])
+        self.assertEqual(res['rc'], 0)
+        self.assertEqual(res['replies'][0], {'names': [jid1], 'errno': 0})
+        self.assertEqual(res['replies'][1], {'names': [],
+                                             'errno': PBSE_UNKJOBID})
+        self.assertEqual(res['replies'][2], {'names': [jid2], 'errno': 0})
+
+    def test_stat_pipeline_permission(self):
+        """
+        Test that without query_other_jobs a pipelined status of another
+        user's job is refused without affecting the requests around it
+        """
+        self.server.manager(MGR_CMD_SET, SERVER,
+                            {'query_other_jobs': 'False'})
+        theirs = self.submit_job(TEST_USER1)
+        mine = self.submit_job(TEST_USER)
+        res = self.stat_pipeline(TEST_USER, [(MGR_OBJ_JOB, theirs),
+                                             (MGR_OBJ_JOB, mine)])
+        self.assertEqual(res['rc'], 0)
+        self.assertEqual(res['replies'][0], {'names': [],
+                                             'errno': PBSE_PERM})
+        self.assertEqual(res['replies'][1], {'names': [mine], 'errno': 0})
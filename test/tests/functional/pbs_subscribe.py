@@ -0,0 +1,262 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2021 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+
+
+import json
+import sys
+import threading
+
+from tests.functional import *
+
+# Subscribes through ctypes and reads the pushed events until each object
+# in 'until' has had one, or 'wait' seconds have passed.  The request
+# comes in argv[1] as JSON, the 'ready' file is created once the
+# subscription is in place and the result goes to stdout as JSON.
+SUBSCRIBE_SCRIPT = """
+import ctypes
+import json
+import os
+import sys
+import threading
+
+
+class attrl(ctypes.Structure):
+    pass
+
+
+attrl._fields_ = [('next', ctypes.POINTER(attrl)),
+                  ('name', ctypes.c_char_p),
+                  ('resource', ctypes.c_char_p),
+                  ('value', ctypes.c_char_p),
+                  ('op', ctypes.c_int)]
+
+
+class batch_status(ctypes.Structure):
+    pass
+
+
+batch_status._fields_ = [('next', ctypes.POINTER(batch_status)),
+                         ('name', ctypes.c_char_p),
+                         ('attribs', ctypes.POINTER(attrl)),
+                         ('text', ctypes.c_char_p)]
+
+req = json.loads(sys.argv[1])
+pbs = ctypes.CDLL(req['lib'])
+pbs.__pbs_errno_location.restype = ctypes.POINTER(ctypes.c_int)
+pbs.pbs_connect.argtypes = [ctypes.c_char_p]
+pbs.pbs_subscribe.argtypes = [ctypes.c_int, ctypes.c_int, ctypes.c_char_p]
+pbs.pbs_subscribe_next.restype = ctypes.POINTER(batch_status)
+pbs.pbs_statfree.argtypes = [ctypes.POINTER(batch_status)]
+result = {'rc': 0, 'events': []}
+lock = threading.Lock()
+
+
+def finish():
+    with lock:
+        print(json.dumps(result))
+        sys.stdout.flush()
+        os._exit(0)
+
+
+# pbs_subscribe_next() blocks in the library, give up from another thread
+threading.Timer(req['wait'], finish).start()
+
+c = pbs.pbs_connect(None)
+if c <= 0:
+    result['rc'] = pbs.__pbs_errno_location()[0]
+else:
+    for objtype, owner in req['subscribe']:
+        result['rc'] = pbs.pbs_subscribe(c, objtype,
+                                         owner.encode() if owner else None)
+        if result['rc'] != 0:
+            break
+open(req['ready'], 'w').close()
+
+want = set(req['until'])
+while result['rc'] == 0 and want:
+    bs = pbs.pbs_subscribe_next(c)
+    if not bs:
+        result['rc'] = pbs.__pbs_errno_location()[0]
+        break
+    with lock:
+        p = bs
+        while p:
+            attrs = {}
+            a = p.contents.attribs
+            while a:
+                attrs[a.contents.name.decode()] = a.contents.value.decode()
+                a = a.contents.next
+            name = p.contents.name.decode()
+            result['events'].append([name, attrs])
+            want.discard(name)
+            p = p.contents.next
+    pbs.pbs_statfree(bs)
+finish()
+"""
+
+
+class TestSubscribe(TestFunctional):
+    """
+    Test suite for the Subscribe request, pbs_subscribe() and
+    pbs_subscribe_next()
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+
+    def subscribe(self, user, subs, until, action=None, wait=60):
+        """
+        Subscribe as user, run action and collect the events pushed
+
+        :param user: user to subscribe as
+        :param subs: list of (object type, owner filter) to subscribe to
+        :param until: names of the objects to wait for an event of
+        :param action: called once the subscription is in place
+        :param wait: seconds to wait for the events at most
+        :returns: dictionary with the return code 'rc' and the events
+                  'events' as a list of [object name, attributes]
+        """
+        fn = self.du.create_temp_file(body=SUBSCRIBE_SCRIPT, suffix='.py',
+                                      asuser=user)
+        ready = fn + '.ready'
+        req = {'lib': os.path.join(self.server.pbs_conf['PBS_EXEC'],
+                                   'lib', 'libpbs.so'),
+               'subscribe': subs,
+               'until': until,
+               'ready': ready,
+               'wait': wait}
+        ret = {}
+
+        def run():
+            ret.update(self.du.run_cmd(cmd=[sys.executable, fn,
+                                            json.dumps(req)],
+                                       runas=user))
+
+        th = threading.Thread(target=run)
+        th.start()
+        for _ in range(60):
+            if os.path.exists(ready) or not th.is_alive():
+                break
+            time.sleep(1)
+        self.assertTrue(os.path.exists(ready), 'subscription did not start')
+        if action is not None:
+            action()
+        th.join(wait + 30)
+        self.du.rm(path=ready, sudo=True, force=True)
+        self.assertEqual(ret.get('rc'), 0, ret.get('err'))
+        return json.loads(ret['out'][-1])
+
+    def events_of(self, res, name):
+        """
+        Return the attributes of each event of object name
+        """
+        return [attrs for (oname, attrs) in res['events'] if oname == name]
+
+    def test_subscribe_job_and_node(self):
+        """
+        Test that job and vnode state changes are pushed to a subscriber
+        """
+        j = Job(TEST_USER)
+        j.set_sleep_time(1000)
+        jid = self.server.submit(j)
+        vnode = self.mom.shortname
+
+        def action():
+            self.server.holdjob(jid, USER_HOLD)
+            self.server.manager(MGR_CMD_SET, NODE, {'state': 'offline'},
+                                id=vnode)
+
+        res = self.subscribe(TEST_USER, [(MGR_OBJ_JOB, ''),
+                                         (MGR_OBJ_NODE, '')],
+                             [jid, vnode], action)
+        self.server.manager(MGR_CMD_SET, NODE, {'state': 'free'}, id=vnode)
+        self.assertEqual(res['rc'], 0)
+        self.assertIn({ATTR_state: 'H', ATTR_substate: '20'},
+                      self.events_of(res, jid))
+        self.assertTrue([a for a in self.events_of(res, vnode)
+                         if 'offline' in a[ATTR_NODE_state]], res)
+
+    def test_subscribe_bad_type(self):
+        """
+        Test that a subscription to objects other than jobs and vnodes
+        is refused
+        """
+        res = self.subscribe(TEST_USER, [(MGR_OBJ_QUEUE, '')], [])
+        self.assertEqual(res['rc'], PBSE_IVALREQ)
+        self.assertEqual(res['events'], [])
+
+    def test_subscribe_permission(self):
+        """
+        Test that without privilege and query_other_jobs a user only
+        hears about their own jobs, while a manager may follow any user
+        """
+        self.server.manager(MGR_CMD_SET, SERVER,
+                            {'query_other_jobs': 'False'})
+        j = Job(TEST_USER)
+        j.set_sleep_time(1000)
+        mine = self.server.submit(j)
+        j = Job(TEST_USER1)
+        j.set_sleep_time(1000)
+        theirs = self.server.submit(j)
+
+        res = self.subscribe(TEST_USER, [(MGR_OBJ_JOB, str(TEST_USER1))],
+                             [])
+        self.assertEqual(res['rc'], PBSE_PERM)
+
+        # their change goes out before mine, so it would have been seen
+        def hold_both():
+            self.server.holdjob(theirs, USER_HOLD)
+            self.server.holdjob(mine, USER_HOLD)
+
+        res = self.subscribe(TEST_USER, [(MGR_OBJ_JOB, '')], [mine],
+                             hold_both)
+        self.assertEqual(res['rc'], 0)
+        self.assertNotEqual(self.events_of(res, mine), [])
+        self.assertEqual(self.events_of(res, theirs), [])
+
+        def release_theirs():
+            self.server.rlsjob(theirs, USER_HOLD)
+
+        res = self.subscribe(ROOT_USER, [(MGR_OBJ_JOB, str(TEST_USER1))],
+                             [theirs], release_theirs)
+        self.assertEqual(res['rc'], 0)
+        self.assertIn({ATTR_state: 'Q', ATTR_substate: '10'},
+                      self.events_of(res, theirs))
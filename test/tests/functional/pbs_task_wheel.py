@@ -0,0 +1,134 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2021 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+
+
+from tests.functional import *
+
+
+class TestTaskWheel(TestFunctional):
+    """
+    Test the server's timed work tasks, which run off a timer wheel
+    covering the next 1024 seconds and a list of tasks further out.
+    A job's execution time (qsub -a) is such a task: when it is reached
+    the job leaves the W state.
+    """
+
+    wheel_size = 1024
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        # keep jobs in Q once their execution time is reached
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+
+    def submit_at(self, when):
+        """
+        Submit a job with an execution time of when (seconds since the
+        epoch) and check that it waits for it.
+        """
+        a = {ATTR_a: BatchUtils().convert_seconds_to_datetime(when)}
+        jid = self.server.submit(Job(TEST_USER, a))
+        self.server.expect(JOB, {ATTR_state: 'W'}, id=jid)
+        return jid
+
+    def check_released_at(self, jid, when):
+        """
+        Check that a job is still waiting a second before when and is
+        released soon after it.
+        """
+        early = when - 1 - time.time()
+        if early > 0:
+            time.sleep(early)
+        self.server.expect(JOB, {ATTR_state: 'W'}, id=jid, max_attempts=1)
+        self.server.expect(JOB, {ATTR_state: 'Q'}, id=jid,
+                           offset=max(when - time.time(), 0), interval=1,
+                           max_attempts=10)
+
+    def test_tasks_on_wheel(self):
+        """
+        Test that timed tasks within the reach of the wheel run at their
+        time and in order, including two in the same second.
+        """
+        now = int(time.time())
+        jid1 = self.submit_at(now + 20)
+        jid2 = self.submit_at(now + 10)
+        jid3 = self.submit_at(now + 20)
+        self.check_released_at(jid2, now + 10)
+        self.server.expect(JOB, {ATTR_state: 'W'}, id=jid1, max_attempts=1)
+        self.check_released_at(jid1, now + 20)
+        self.server.expect(JOB, {ATTR_state: 'Q'}, id=jid3)
+
+    def test_task_moved_onto_wheel(self):
+        """
+        Test that a task beyond the reach of the wheel can be found and
+        replaced by a nearer one, and that deleting a task beyond the
+        wheel's reach leaves the others alone.
+        """
+        now = int(time.time())
+        far = now + self.wheel_size + 300
+        jid1 = self.submit_at(far)
+        jid2 = self.submit_at(far)
+        self.server.alterjob(jid1,
+                             {ATTR_a: BatchUtils().convert_seconds_to_datetime(
+                                 now + 15)})
+        self.server.delete(jid2, wait=True)
+        self.check_released_at(jid1, now + 15)
+
+        # and back out again
+        jid3 = self.submit_at(now + 15 + 10)
+        self.server.alterjob(jid3,
+                             {ATTR_a: BatchUtils().convert_seconds_to_datetime(
+                                 far)})
+        self.server.expect(JOB, {ATTR_state: 'W'}, id=jid3, offset=15)
+
+    @timeout(1500)
+    def test_task_beyond_wheel(self):
+        """
+        Test that tasks set further out than the wheel reaches are moved
+        onto it as its turns begin and run at their time, whether or not
+        the server was restarted in between.
+        """
+        now = int(time.time())
+        when = now + self.wheel_size + 60
+        jid1 = self.submit_at(when)
+        jid2 = self.submit_at(when + 5)
+        self.server.restart()
+        self.server.expect(JOB, {ATTR_state: 'W'}, id=jid2)
+        self.check_released_at(jid1, when)
+        self.check_released_at(jid2, when + 5)
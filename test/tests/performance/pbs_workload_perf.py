@@ -0,0 +1,314 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2021 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+
+
+
+import os
+import json
+import random
+import subprocess
+import threading
+from tests.performance import *
+from ptl.utils.pbs_logutils import PBSLogAnalyzer
+
+
+class TestWorkloadPerf(TestPerformance):
+    """
+    End-to-end throughput benchmark driven by a synthetic workload.
+
+    Jobs are submitted at a fixed rate against a cluster of mock run
+    MoMs, with a configurable mix of walltimes, job arrays, dependency
+    chains and background qstat polling.  Once the workload drains the
+    test records the job start rate, submit-to-start latency
+    percentiles, scheduler cycle times and server CPU usage.  Every
+    knob below can be overridden from the benchpress configuration.
+    """
+
+    def setUp(self):
+        TestPerformance.setUp(self)
+
+    def set_test_config(self, config):
+        """
+        Sets test level configuration
+        """
+        testconfig = {}
+        for key, value in config.items():
+            if isinstance(value, bool):
+                testconfig[key] = str(self.conf[key]).lower() in \
+                    ('1', 'true', 'yes') if key in self.conf else value
+            elif isinstance(value, int):
+                testconfig[key] = int(
+                    self.conf[key]) if key in self.conf else value
+            elif isinstance(value, float):
+                testconfig[key] = float(
+                    self.conf[key]) if key in self.conf else value
+            else:
+                testconfig[key] = self.conf[key] if key in self.conf else value
+        self.set_test_measurements({"test_config": testconfig})
+        return testconfig
+
+    @staticmethod
+    def walltime(dist, rng):
+        """
+        Draw a job walltime in seconds from a distribution spec:
+        ``fixed:<s>``, ``uniform:<min>:<max>`` or ``exp:<mean>``
+        """
+        parts = dist.split(':')
+        if parts[0] == 'fixed':
+            return max(1, int(float(parts[1])))
+        if parts[0] == 'uniform':
+            return rng.randint(int(parts[1]), int(parts[2]))
+        if parts[0] == 'exp':
+            return max(1, int(rng.expovariate(1.0 / float(parts[1]))))
+        raise ValueError("unknown walltime distribution " + dist)
+
+    @staticmethod
+    def percentile(vals, pct):
+        """
+        Nearest rank percentile of a sorted list
+        """
+        if not vals:
+            return 0
+        k = int(round(pct / 100.0 * (len(vals) - 1)))
+        return vals[k]
+
+    def server_cpu(self):
+        """
+        Return user plus system CPU seconds consumed by the server
+        """
+        pid = self.server._get_pid()
+        if pid is None:
+            return 0.0
+        ret = self.du.cat(self.server.hostname, '/proc/%s/stat' % pid,
+                          sudo=True, logerr=False)
+        if ret['rc'] != 0 or not ret['out']:
+            return 0.0
+        # Fields after the parenthesised command name; utime and stime
+        # are fields 14 and 15 of the full line
+        fields = ret['out'][0].rsplit(')', 1)[1].split()
+        return (int(fields[11]) + int(fields[12])) / \
+            float(os.sysconf('SC_CLK_TCK'))
+
+    def poll_qstat(self, rate, stop):
+        """
+        Run qstat at the given rate until stop is set, like users
+        and portals watching the queue
+        """
+        qstat = os.path.join(self.server.pbs_conf['PBS_EXEC'], 'bin',
+                             'qstat')
+        interval = 1.0 / rate
+        with open(os.devnull, 'w') as devnull:
+            while not stop.wait(interval):
+                subprocess.call([qstat], stdout=devnull, stderr=devnull)
+
+    def submit_workload(self, config):
+        """
+        Submit the synthetic workload at the configured rate.
+        Return the ids of the jobs submitted and of those that
+        depend on another job.
+        """
+        rng = random.Random(config['seed'])
+        interval = 1.0 / config['submit_rate']
+        ncpus = config['ncpus_per_job']
+        jids = []
+        dependents = set()
+        chain = []
+        start = time.time()
+        end = start + config['duration']
+        i = 0
+        while True:
+            due = start + i * interval
+            if due >= end:
+                break
+            now = time.time()
+            if due > now:
+                time.sleep(due - now)
+            a = {'Resource_List.select': '1:ncpus=%d' % ncpus,
+                 'Resource_List.walltime':
+                 self.walltime(config['walltime_dist'], rng)}
+            if rng.random() < config['array_fraction']:
+                a[ATTR_J] = '1-%d' % config['array_size']
+            elif chain and rng.random() < config['dep_fraction']:
+                a[ATTR_depend] = 'afterany:' + chain[-1]
+            j = Job(TEST_USER, attrs=a)
+            jid = self.server.submit(j)
+            jids.append(jid)
+            if ATTR_depend in a:
+                dependents.add(jid)
+                chain.append(jid)
+                if len(chain) >= config['dep_chain']:
+                    chain = []
+            elif ATTR_J not in a:
+                chain = [jid]
+            i += 1
+        return jids, dependents
+
+    def job_times(self, dependents):
+        """
+        Return sorted submit-to-start latencies of the jobs and
+        subjobs that were free to run on submission, and the start
+        times of all jobs and subjobs that ran
+        """
+        latencies = []
+        starts = []
+        jobs = self.server.status(JOB, ['qtime', 'stime', 'array'],
+                                  extend='xt')
+        for job in jobs:
+            if job.get('array') == 'True' or 'stime' not in job:
+                continue
+            stime = self.server.utils.convert_time(job['stime'])
+            qtime = self.server.utils.convert_time(job['qtime'])
+            starts.append(int(stime))
+            if job['id'] in dependents:
+                continue
+            latencies.append(int(stime) - int(qtime))
+        return sorted(latencies), sorted(starts)
+
+    @timeout(7200)
+    def test_workload_throughput(self):
+        """
+        Drive a mixed synthetic workload through mock MoMs and record
+        the end-to-end scheduling throughput.
+        Test Params: 'num_moms': 20,
+                     'vnodes_per_mom': 50,
+                     'ncpus_per_vnode': 8,
+                     'vnode_mem': '32gb',
+                     'duration': 600,
+                     'submit_rate': 20.0,
+                     'walltime_dist': 'exp:120',
+                     'ncpus_per_job': 1,
+                     'array_fraction': 0.05,
+                     'array_size': 100,
+                     'dep_fraction': 0.1,
+                     'dep_chain': 5,
+                     'qstat_rate': 1.0,
+                     'svr_log_level': 511,
+                     'seed': 1,
+                     'report_file': ''
+        """
+        testconfig = {'num_moms': 20,
+                      'vnodes_per_mom': 50,
+                      'ncpus_per_vnode': 8,
+                      'vnode_mem': '32gb',
+                      'duration': 600,
+                      'submit_rate': 20.0,
+                      'walltime_dist': 'exp:120',
+                      'ncpus_per_job': 1,
+                      'array_fraction': 0.05,
+                      'array_size': 100,
+                      'dep_fraction': 0.1,
+                      'dep_chain': 5,
+                      'qstat_rate': 1.0,
+                      'svr_log_level': 511,
+                      'seed': 1,
+                      'report_file': ''}
+        config = self.set_test_config(testconfig)
+
+        self.server.create_moms(
+            num=config['num_moms'], mock=True,
+            mock_vnodes=(config['vnodes_per_mom'],
+                         config['ncpus_per_vnode'], config['vnode_mem']))
+        a = {'log_events': config['svr_log_level'],
+             'job_history_enable': 'True'}
+        self.server.manager(MGR_CMD_SET, SERVER, a)
+
+        stop = threading.Event()
+        poller = None
+        if config['qstat_rate'] > 0:
+            poller = threading.Thread(target=self.poll_qstat,
+                                      args=(config['qstat_rate'], stop))
+            poller.daemon = True
+            poller.start()
+
+        start = int(time.time())
+        cpu_start = self.server_cpu()
+        try:
+            jids, dependents = self.submit_workload(config)
+            self.server.expect(JOB, {'job_state=F': len(jids)}, extend='x',
+                               interval=20, max_attempts=360,
+                               trigger_sched_cycle=False)
+        finally:
+            stop.set()
+            if poller is not None:
+                poller.join()
+        end = int(time.time())
+        cpu = self.server_cpu() - cpu_start
+
+        latencies, starts = self.job_times(dependents)
+        span = max(starts[-1] - starts[0], 1) if starts else 1
+        start_rate = len(starts) / float(span)
+
+        sclg = PBSLogAnalyzer()
+        sclg.analyze_scheduler_log(filename=self.scheduler.logfile,
+                                   start=start, end=end, summarize=False)
+        cycles = sorted(c.duration for c in sclg.scheduler.cycles)
+
+        report = {
+            'jobs_submitted': len(jids),
+            'jobs_started': len(starts),
+            'jobs_started_per_sec': round(start_rate, 2),
+            'submit_to_start_sec': {
+                'p50': self.percentile(latencies, 50),
+                'p90': self.percentile(latencies, 90),
+                'p99': self.percentile(latencies, 99),
+                'max': latencies[-1] if latencies else 0},
+            'sched_cycles': len(cycles),
+            'sched_cycle_sec': {
+                'p50': self.percentile(cycles, 50),
+                'p90': self.percentile(cycles, 90),
+                'max': cycles[-1] if cycles else 0},
+            'server_cpu_sec': round(cpu, 2),
+            'server_cpu_pct': round(100.0 * cpu / max(end - start, 1), 2),
+            'elapsed_sec': end - start}
+        self.logger.info('workload report: ' + json.dumps(report))
+        self.set_test_measurements({'workload_report': report})
+        if config['report_file']:
+            with open(config['report_file'], 'w') as f:
+                json.dump({'test_config': config, 'report': report}, f,
+                          indent=4)
+
+        self.perf_test_result(start_rate, 'jobs_started_rate', 'jobs/sec')
+        self.perf_test_result(report['submit_to_start_sec']['p50'],
+                              'submit_to_start_p50', 'sec')
+        self.perf_test_result(report['submit_to_start_sec']['p99'],
+                              'submit_to_start_p99', 'sec')
+        if cycles:
+            self.perf_test_result(cycles, 'sched_cycle_duration', 'sec')
+        self.perf_test_result(cpu, 'server_cpu_time', 'sec')